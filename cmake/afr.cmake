@@ -64,3 +64,4 @@ endif()
 include("${CMAKE_CURRENT_LIST_DIR}/afr_utils.cmake")
 include("${CMAKE_CURRENT_LIST_DIR}/afr_module.cmake")
 include("${CMAKE_CURRENT_LIST_DIR}/afr_metadata.cmake")
+include("${CMAKE_CURRENT_LIST_DIR}/afr_static_objects.cmake")
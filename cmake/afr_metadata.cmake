@@ -348,6 +348,7 @@ afr_define_metadata(BOARD SUPPORTED_IDE "Supported IDE." INHERITED)
 afr_define_metadata(BOARD IS_ACTIVE "Is the board Active to be displayed on Amazon FreeRTOS Console")
 afr_define_metadata(BOARD DEMO_COMMON_LOCATION "Location of vendor's commons in demos")
 afr_define_metadata(BOARD THIRD_PARTY_LIB_LOCATION "Location of third party library files")
+afr_define_metadata(BOARD SOFTWARE_AES "TRUE if the MCU has no AES acceleration.")
 
 afr_define_metadata(LIB ID "Library name.")
 afr_define_metadata(LIB DISPLAY_NAME "Library name displayed on the Amazon FreeRTOS Console.")
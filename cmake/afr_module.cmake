@@ -22,6 +22,8 @@ set(AFR_MODULES_ENABLED_DEPS  "" CACHE INTERNAL "List of Amazon FreeRTOS modules
 set(AFR_DEMOS_ENABLED         "" CACHE INTERNAL "List of supported demos for Amazon FreeRTOS.")
 set(AFR_TESTS_ENABLED         "" CACHE INTERNAL "List of supported tests for Amazon FreeRTOS.")
 set(3RDPARTY_MODULES_ENABLED  "" CACHE INTERNAL "List of 3rdparty libraries enabled due to dependencies.")
+set(AFR_HOT_TEXT_INPUTS       "" CACHE INTERNAL "Linker input patterns of source files placed with hot code.")
+set(AFR_HOT_SECTIONS_CONFIG   "" CACHE INTERNAL "Memory regions and budgets for hot code and data, set by the board.")
 
 # Global setting for whether enable all modules by default or not.
 if(NOT AFR_ENABLE_ALL_MODULES)
@@ -481,3 +483,95 @@ function(afr_mcu_port arg_module)
         INTERFACE ${ARG_DEPENDS}
     )
 endfunction()
+
+# -------------------------------------------------------------------------------------------------
+# Hot path placement
+# -------------------------------------------------------------------------------------------------
+# Functions marked portHOT_FUNCTION go to the .afr_hot_text section and data marked portHOT_DATA
+# to .afr_hot_bss, when the port defines those macros. A board with fast memory, such as the TCM
+# of a Cortex-M7, calls afr_hot_sections() to have a GNU ld script fragment generated that places
+# them there, then INCLUDEs ${CMAKE_BINARY_DIR}/afr_hot_sections.ld from the SECTIONS command of
+# its linker script, before the output section that collects *(.text*). The link fails if the
+# code or data is larger than the budget given.
+#
+# The startup code of the board must copy .afr_hot_text from __afr_hot_text_load__ to
+# __afr_hot_text_start__ up to __afr_hot_text_end__, and zero __afr_hot_bss_start__ up to
+# __afr_hot_bss_end__, before main() runs.
+#
+# afr_hot_sections(TEXT_REGION <region> TEXT_BUDGET <bytes> LOAD_REGION <region>
+#                  DATA_REGION <region> DATA_BUDGET <bytes>)
+function(afr_hot_sections)
+    cmake_parse_arguments(
+        PARSE_ARGV 0
+        "ARG"                                                               # Prefix of parsed results.
+        ""                                                                  # Option arguments.
+        "TEXT_REGION;TEXT_BUDGET;LOAD_REGION;DATA_REGION;DATA_BUDGET"       # One value arguments.
+        ""                                                                  # Multi value arguments.
+    )
+
+    foreach(arg IN ITEMS TEXT_REGION TEXT_BUDGET LOAD_REGION DATA_REGION DATA_BUDGET)
+        if(NOT DEFINED ARG_${arg})
+            message(FATAL_ERROR "afr_hot_sections() requires ${arg}.")
+        endif()
+    endforeach()
+
+    set(AFR_HOT_SECTIONS_CONFIG
+        "${ARG_TEXT_REGION};${ARG_TEXT_BUDGET};${ARG_LOAD_REGION};${ARG_DATA_REGION};${ARG_DATA_BUDGET}"
+        CACHE INTERNAL ""
+    )
+endfunction()
+
+# Place all the code of some source files of a static library with the hot code. This is for code
+# that cannot be marked with portHOT_FUNCTION, such as 3rdparty libraries.
+# afr_hot_sources(<library_target> <source_file>...)
+function(afr_hot_sources arg_library)
+    set(archive "${CMAKE_STATIC_LIBRARY_PREFIX}${arg_library}${CMAKE_STATIC_LIBRARY_SUFFIX}")
+    foreach(src IN LISTS ARGN)
+        get_filename_component(src_name "${src}" NAME)
+        afr_cache_append(AFR_HOT_TEXT_INPUTS "*${archive}:${src_name}.*(.text .text.*)")
+    endforeach()
+endfunction()
+
+# Write the linker script fragment, if the board called afr_hot_sections(). Called once all
+# modules are defined.
+function(afr_write_hot_sections)
+    if(NOT AFR_HOT_SECTIONS_CONFIG)
+        return()
+    endif()
+
+    list(GET AFR_HOT_SECTIONS_CONFIG 0 text_region)
+    list(GET AFR_HOT_SECTIONS_CONFIG 1 text_budget)
+    list(GET AFR_HOT_SECTIONS_CONFIG 2 load_region)
+    list(GET AFR_HOT_SECTIONS_CONFIG 3 data_region)
+    list(GET AFR_HOT_SECTIONS_CONFIG 4 data_budget)
+
+    set(text_inputs "")
+    foreach(input IN LISTS AFR_HOT_TEXT_INPUTS)
+        string(APPEND text_inputs "        ${input}\n")
+    endforeach()
+
+    file(WRITE "${CMAKE_BINARY_DIR}/afr_hot_sections.ld"
+"/* Generated by afr_write_hot_sections(), do not edit. */
+    .afr_hot_text :
+    {
+        . = ALIGN(8);
+        __afr_hot_text_start__ = .;
+        *(.afr_hot_text .afr_hot_text.*)
+${text_inputs}        . = ALIGN(8);
+        __afr_hot_text_end__ = .;
+    } > ${text_region} AT > ${load_region}
+    __afr_hot_text_load__ = LOADADDR(.afr_hot_text);
+    ASSERT(SIZEOF(.afr_hot_text) <= ${text_budget}, \"Hot code is larger than the ${text_region} budget of the board.\")
+
+    .afr_hot_bss (NOLOAD) :
+    {
+        . = ALIGN(8);
+        __afr_hot_bss_start__ = .;
+        *(.afr_hot_bss .afr_hot_bss.*)
+        . = ALIGN(8);
+        __afr_hot_bss_end__ = .;
+    } > ${data_region}
+    ASSERT(SIZEOF(.afr_hot_bss) <= ${data_budget}, \"Hot data is larger than the ${data_region} budget of the board.\")
+"
+    )
+endfunction()
@@ -0,0 +1,288 @@
+# -------------------------------------------------------------------------------------------------
+# Static kernel objects
+# -------------------------------------------------------------------------------------------------
+# Describe the tasks, queues and software timers of an application in CMake, and have the storage
+# of each declared statically and created with xTaskCreateStatic(), xQueueCreateStatic() and
+# xTimerCreateStatic(). All of their RAM is then in .bss, so it is known at link time, and the
+# creation cannot fail for lack of heap. The kernel still initializes the objects at run time,
+# as it links them into its lists and builds the initial stack frame of each task.
+#
+# Objects are added to a named group, then afr_write_static_objects() generates
+# <group>_static_objects.c and <group>_static_objects.h in the build folder and adds them to a
+# target. The header declares a handle for each object and <GROUP>_CreateStaticObjects(), which
+# creates the queues and timers first, then the tasks, and returns pdPASS or pdFAIL.
+#
+# afr_static_task(<group> NAME <name> FUNCTION <function> STACK_DEPTH <words> PRIORITY <priority>
+#                 [PARAMETER <expression>])
+#     Declares TaskHandle_t x<name>Task. FUNCTION must not be static, and PARAMETER, which is NULL
+#     by default, is cast to void *.
+# afr_static_queue(<group> NAME <name> LENGTH <items> ITEM_SIZE <bytes>)
+#     Declares QueueHandle_t x<name>Queue. ITEM_SIZE can be a sizeof() expression of a type from
+#     one of the INCLUDES of the group.
+# afr_static_timer(<group> NAME <name> FUNCTION <callback> PERIOD_MS <ms> [AUTO_RELOAD]
+#                  [ID <expression>])
+#     Declares TimerHandle_t x<name>Timer. The timer is created dormant, start it with
+#     xTimerStart(). Requires configUSE_TIMERS.
+# afr_write_static_objects(<group> TARGET <target> [INCLUDES <header>...])
+#     Called once the whole group is described. The generated source includes the INCLUDES.
+#
+# All the objects need configSUPPORT_STATIC_ALLOCATION set to 1 in FreeRTOSConfig.h.
+
+function(__afr_static_object_add arg_group arg_kind arg_name)
+    if(NOT arg_name MATCHES "^[A-Za-z][A-Za-z0-9_]*$")
+        message(FATAL_ERROR "Static ${arg_kind} name \"${arg_name}\" is not a C identifier.")
+    endif()
+
+    get_property(names GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${arg_kind}S)
+    if("${arg_name}" IN_LIST names)
+        message(FATAL_ERROR "Static ${arg_kind} ${arg_name} is already in group ${arg_group}.")
+    endif()
+
+    set_property(GLOBAL APPEND PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${arg_kind}S "${arg_name}")
+    foreach(prop IN LISTS ARGN)
+        set_property(GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${arg_name}_${prop} "${ARG_${prop}}")
+    endforeach()
+endfunction()
+
+function(afr_static_task arg_group)
+    cmake_parse_arguments(
+        PARSE_ARGV 1
+        "ARG"                                               # Prefix of parsed results.
+        ""                                                  # Option arguments.
+        "NAME;FUNCTION;STACK_DEPTH;PRIORITY;PARAMETER"      # One value arguments.
+        ""                                                  # Multi value arguments.
+    )
+
+    foreach(arg IN ITEMS NAME FUNCTION STACK_DEPTH PRIORITY)
+        if(NOT DEFINED ARG_${arg})
+            message(FATAL_ERROR "afr_static_task() requires ${arg}.")
+        endif()
+    endforeach()
+
+    if(NOT DEFINED ARG_PARAMETER)
+        set(ARG_PARAMETER "NULL")
+    endif()
+
+    __afr_static_object_add(${arg_group} TASK ${ARG_NAME} FUNCTION STACK_DEPTH PRIORITY PARAMETER)
+endfunction()
+
+function(afr_static_queue arg_group)
+    cmake_parse_arguments(
+        PARSE_ARGV 1
+        "ARG"                                               # Prefix of parsed results.
+        ""                                                  # Option arguments.
+        "NAME;LENGTH;ITEM_SIZE"                             # One value arguments.
+        ""                                                  # Multi value arguments.
+    )
+
+    foreach(arg IN ITEMS NAME LENGTH ITEM_SIZE)
+        if(NOT DEFINED ARG_${arg})
+            message(FATAL_ERROR "afr_static_queue() requires ${arg}.")
+        endif()
+    endforeach()
+
+    __afr_static_object_add(${arg_group} QUEUE ${ARG_NAME} LENGTH ITEM_SIZE)
+endfunction()
+
+function(afr_static_timer arg_group)
+    cmake_parse_arguments(
+        PARSE_ARGV 1
+        "ARG"                                               # Prefix of parsed results.
+        "AUTO_RELOAD"                                       # Option arguments.
+        "NAME;FUNCTION;PERIOD_MS;ID"                        # One value arguments.
+        ""                                                  # Multi value arguments.
+    )
+
+    foreach(arg IN ITEMS NAME FUNCTION PERIOD_MS)
+        if(NOT DEFINED ARG_${arg})
+            message(FATAL_ERROR "afr_static_timer() requires ${arg}.")
+        endif()
+    endforeach()
+
+    if(NOT DEFINED ARG_ID)
+        set(ARG_ID "NULL")
+    endif()
+    if(ARG_AUTO_RELOAD)
+        set(ARG_AUTO_RELOAD "pdTRUE")
+    else()
+        set(ARG_AUTO_RELOAD "pdFALSE")
+    endif()
+
+    __afr_static_object_add(${arg_group} TIMER ${ARG_NAME} FUNCTION PERIOD_MS AUTO_RELOAD ID)
+endfunction()
+
+function(afr_write_static_objects arg_group)
+    cmake_parse_arguments(
+        PARSE_ARGV 1
+        "ARG"                                               # Prefix of parsed results.
+        ""                                                  # Option arguments.
+        "TARGET"                                            # One value arguments.
+        "INCLUDES"                                          # Multi value arguments.
+    )
+
+    if(NOT DEFINED ARG_TARGET)
+        message(FATAL_ERROR "afr_write_static_objects() requires TARGET.")
+    endif()
+
+    get_property(tasks GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_TASKS)
+    get_property(queues GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_QUEUES)
+    get_property(timers GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_TIMERS)
+    if(NOT (tasks OR queues OR timers))
+        message(FATAL_ERROR "Static object group ${arg_group} is empty.")
+    endif()
+
+    string(TOUPPER "${arg_group}" group_upper)
+    set(header_name "${arg_group}_static_objects.h")
+    set(out_dir "${CMAKE_BINARY_DIR}/afr_static_objects")
+
+    # Each object contributes a handle, its storage and declarations, and the call creating it.
+    set(handles "")
+    set(externs "")
+    set(storage "")
+    set(creates "")
+
+    foreach(name IN LISTS queues)
+        get_property(length GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_LENGTH)
+        get_property(item_size GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_ITEM_SIZE)
+        string(APPEND handles "extern QueueHandle_t x${name}Queue;\n")
+        string(APPEND storage
+"QueueHandle_t x${name}Queue = NULL;
+static StaticQueue_t x${name}QueueBuffer;
+static uint8_t uc${name}QueueStorage[ ( ${length} ) * ( ${item_size} ) ];
+
+"
+        )
+        string(APPEND creates
+"    x${name}Queue = xQueueCreateStatic( ( UBaseType_t ) ( ${length} ), ( UBaseType_t ) ( ${item_size} ),
+            uc${name}QueueStorage, &( x${name}QueueBuffer ) );
+
+    if( x${name}Queue == NULL )
+    {
+        xResult = pdFAIL;
+    }
+
+"
+        )
+    endforeach()
+
+    foreach(name IN LISTS timers)
+        get_property(function GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_FUNCTION)
+        get_property(period GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_PERIOD_MS)
+        get_property(auto_reload GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_AUTO_RELOAD)
+        get_property(id GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_ID)
+        string(APPEND handles "extern TimerHandle_t x${name}Timer;\n")
+        string(APPEND externs "extern void ${function}( TimerHandle_t xTimer );\n")
+        string(APPEND storage
+"TimerHandle_t x${name}Timer = NULL;
+static StaticTimer_t x${name}TimerBuffer;
+
+"
+        )
+        string(APPEND creates
+"    x${name}Timer = xTimerCreateStatic( \"${name}\", pdMS_TO_TICKS( ${period} ), ${auto_reload},
+            ( void * ) ( ${id} ), ${function}, &( x${name}TimerBuffer ) );
+
+    if( x${name}Timer == NULL )
+    {
+        xResult = pdFAIL;
+    }
+
+"
+        )
+    endforeach()
+
+    foreach(name IN LISTS tasks)
+        get_property(function GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_FUNCTION)
+        get_property(stack_depth GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_STACK_DEPTH)
+        get_property(priority GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_PRIORITY)
+        get_property(parameter GLOBAL PROPERTY AFR_STATIC_OBJECTS_${arg_group}_${name}_PARAMETER)
+        string(APPEND handles "extern TaskHandle_t x${name}Task;\n")
+        string(APPEND externs "extern void ${function}( void * pvParameters );\n")
+        string(APPEND storage
+"TaskHandle_t x${name}Task = NULL;
+static StaticTask_t x${name}TaskBuffer;
+static StackType_t x${name}TaskStack[ ${stack_depth} ];
+
+"
+        )
+        string(APPEND creates
+"    if( xResult == pdPASS )
+    {
+        x${name}Task = xTaskCreateStatic( ${function}, \"${name}\", ( uint32_t ) ( ${stack_depth} ),
+                ( void * ) ( ${parameter} ), ( UBaseType_t ) ( ${priority} ),
+                x${name}TaskStack, &( x${name}TaskBuffer ) );
+
+        if( x${name}Task == NULL )
+        {
+            xResult = pdFAIL;
+        }
+    }
+
+"
+        )
+    endforeach()
+
+    set(includes "")
+    foreach(include IN LISTS ARG_INCLUDES)
+        string(APPEND includes "#include \"${include}\"\n")
+    endforeach()
+
+    set(timers_include "")
+    if(timers)
+        set(timers_include "#include \"timers.h\"\n")
+    endif()
+
+    set(header_content
+"/* Generated by afr_write_static_objects() for the ${arg_group} group, do not edit. */
+
+#ifndef _${group_upper}_STATIC_OBJECTS_H_
+#define _${group_upper}_STATIC_OBJECTS_H_
+
+#include \"FreeRTOS.h\"
+#include \"task.h\"
+#include \"queue.h\"
+${timers_include}
+${handles}
+/**
+ * @brief Creates the ${arg_group} queues and timers, then its tasks.
+ *
+ * @return pdPASS if all the objects were created, pdFAIL otherwise.
+ */
+BaseType_t ${group_upper}_CreateStaticObjects( void );
+
+#endif /* _${group_upper}_STATIC_OBJECTS_H_ */
+"
+    )
+
+    set(source_content
+"/* Generated by afr_write_static_objects() for the ${arg_group} group, do not edit. */
+
+#include \"${header_name}\"
+${includes}
+#if ( configSUPPORT_STATIC_ALLOCATION != 1 )
+    #error The static objects of the ${arg_group} group need configSUPPORT_STATIC_ALLOCATION set to 1.
+#endif
+
+${externs}
+${storage}BaseType_t ${group_upper}_CreateStaticObjects( void )
+{
+    BaseType_t xResult = pdPASS;
+
+${creates}    return xResult;
+}
+"
+    )
+
+    # Only replace the files when they change, so that reconfiguring does not rebuild them.
+    foreach(file IN ITEMS "${header_name}" "${arg_group}_static_objects.c")
+        if(file MATCHES "\\.h$")
+            file(WRITE "${out_dir}/${file}.tmp" "${header_content}")
+        else()
+            file(WRITE "${out_dir}/${file}.tmp" "${source_content}")
+        endif()
+        configure_file("${out_dir}/${file}.tmp" "${out_dir}/${file}" COPYONLY)
+    endforeach()
+
+    target_sources(${ARG_TARGET} PRIVATE "${out_dir}/${arg_group}_static_objects.c")
+    target_include_directories(${ARG_TARGET} PRIVATE "${out_dir}")
+endfunction()
@@ -45,6 +45,7 @@ extern void vStartMQTTEchoDemo( void );
 /* extern void vStartSubpubDemoTasks( void ); */
 /* extern void vStartTCPEchoClientTasks_SeparateTasks( void ); */
 /* extern void vStartTCPEchoClientTasks_SingleTasks( void ); */
+/* extern void vStartTCPLoadGeneratorTasks( void ); */
 
 /*-----------------------------------------------------------*/
 
@@ -62,4 +63,5 @@ void DEMO_RUNNER_RunDemos( void )
     /* vStartSubpubDemoTasks(); */
     /* vStartTCPEchoClientTasks_SeparateTasks(); */
     /* vStartTCPEchoClientTasks_SingleTasks(); */
+    /* vStartTCPLoadGeneratorTasks(); */
 }
@@ -32,7 +32,8 @@
 
 /*
  * Called once to create the logging task and queue.  Must be called before any
- * calls to vLoggingPrintf().
+ * calls to vLoggingPrintf().  When configLOGGING_DEFERRED is 1 uxQueueLength
+ * is instead the number of log records that can wait to be formatted.
  */
 BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
                                    UBaseType_t uxPriority,
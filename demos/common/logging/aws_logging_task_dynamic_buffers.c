@@ -53,9 +53,34 @@
     #error configLOGGING_INCLUDE_TIME_AND_TASK_NAME must be defined in FreeRTOSConfig.h to use this logging file.  Set configLOGGING_INCLUDE_TIME_AND_TASK_NAME to 1 to prepend a time stamp, message number and the name of the calling task to each logged message.  Otherwise set to 0.
 #endif
 
+/* Set configLOGGING_DEFERRED to 1 to have vLoggingPrintf() record the format
+ * string and its arguments, leaving the formatting to the logging task.  The
+ * format string passed to vLoggingPrintf() must then remain valid until it is
+ * output, which string literals always do. */
+#ifndef configLOGGING_DEFERRED
+    #define configLOGGING_DEFERRED    0
+#endif
+
+/* The most arguments, including '*' widths and precisions, recorded for one
+ * deferred log message.  Output stops at the conversion that needs more. */
+#ifndef configLOGGING_DEFERRED_MAX_ARGS
+    #define configLOGGING_DEFERRED_MAX_ARGS    6
+#endif
+
+/* The bytes available to copy the %s arguments of one deferred log message
+ * into, as the strings may not outlive the call.  Longer strings are
+ * truncated. */
+#ifndef configLOGGING_DEFERRED_STRING_SPACE
+    #define configLOGGING_DEFERRED_STRING_SPACE    32
+#endif
+
 /* A block time of 0 just means don't block. */
 #define loggingDONT_BLOCK    0
 
+/* The longest single conversion specification, such as "%-08.3lu", the
+ * deferred logging task can format. */
+#define loggingMAX_SPEC_LENGTH    24
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -69,186 +94,922 @@
  * the actual output.  The macro is port specific, so implemented outside of
  * this file.  This version uses dynamic memory, so the buffer that contained
  * the log message is freed after it has been output.
+ *
+ * With configLOGGING_DEFERRED set to 1 the task instead waits for a
+ * notification that records were added to the ring of log records, then
+ * formats and outputs each of them in turn.
  */
 static void prvLoggingTask( void * pvParameters );
 
 /*-----------------------------------------------------------*/
 
-/*
- * The queue used to pass pointers to log messages from the task that created
- * the message to the task that will performs the output.
- */
-static QueueHandle_t xQueue = NULL;
+#if ( configLOGGING_DEFERRED == 1 )
+
+    /* The type of the argument a conversion specification consumes. */
+    typedef enum
+    {
+        eLoggingArgNone = 0, /* %% consumes no argument. */
+        eLoggingArgInt,
+        eLoggingArgLong,
+        eLoggingArgLongLong,
+        eLoggingArgSize,
+        eLoggingArgDouble,
+        eLoggingArgPointer,
+        eLoggingArgString,
+        eLoggingArgUnsupported /* Such as %n, %Lf or %jd. */
+    } LoggingArgType_t;
+
+    /* One conversion specification of a format string. */
+    typedef struct LoggingConversion
+    {
+        const char * pcEnd;      /* The character after the conversion specification. */
+        UBaseType_t uxStarCount; /* The number of int arguments consumed by '*' widths and precisions. */
+        LoggingArgType_t eType;  /* The type of the argument being converted. */
+    } LoggingConversion_t;
+
+    /* A recorded argument.  The format string says which member is valid. */
+    typedef union LoggingArg
+    {
+        int iValue;
+        long lValue;
+        long long llValue;
+        size_t xValue;
+        double dValue;
+        const void * pvValue;
+        const char * pcValue; /* Points into cStrings of the same record. */
+    } LoggingArg_t;
+
+    /* A log message that has not been formatted yet. */
+    typedef struct LoggingRecord
+    {
+        volatile BaseType_t xCommitted; /* Set once the writer has filled in the record. */
+        const char * pcFormat;          /* The format string, or NULL to output pvAllocated as is. */
+        void * pvAllocated;             /* Freed once the record has been output, or NULL. */
+        BaseType_t xAddPrefix;          /* pdTRUE to prepend the message number, time and task name. */
+        uint32_t ulMessageNumber;
+        TickType_t xTickCount;
+        char cTaskName[ configMAX_TASK_NAME_LEN ];
+        UBaseType_t uxArgCount;
+        LoggingArg_t xArgs[ configLOGGING_DEFERRED_MAX_ARGS ];
+        char cStrings[ configLOGGING_DEFERRED_STRING_SPACE ];
+    } LoggingRecord_t;
+
+    /*
+     * Parses the conversion specification that starts with the '%' pointed to by
+     * pcConversion.
+     */
+    static void prvParseConversion( const char * pcConversion,
+                                    LoggingConversion_t * pxConversion );
+
+    /*
+     * Reads the arguments of pxRecord->pcFormat from xArgs into pxRecord.
+     */
+    static void prvRecordArguments( LoggingRecord_t * pxRecord,
+                                    va_list xArgs );
+
+    /*
+     * Writes the formatted log message of pxRecord to pcBuffer.
+     */
+    static void prvFormatRecord( const LoggingRecord_t * pxRecord,
+                                 char * pcBuffer,
+                                 size_t xBufferLength );
+
+    /*
+     * Claims the next free record in the ring, or returns NULL if the ring is
+     * full.  prvCommitRecord() hands the record to the logging task once it has
+     * been filled in.
+     */
+    static LoggingRecord_t * prvReserveRecord( void );
+    static void prvCommitRecord( LoggingRecord_t * pxRecord );
+
+/*-----------------------------------------------------------*/
+
+    /* The ring of log records and the task that empties it. */
+    static LoggingRecord_t * pxRecords = NULL;
+    static UBaseType_t uxRecordCount = 0;
+    static UBaseType_t uxRecordsUsed = 0;
+    static UBaseType_t uxNextRecordToWrite = 0;
+    static UBaseType_t uxNextRecordToOutput = 0;
+    static uint32_t ulNextMessageNumber = 0;
+    static uint32_t ulMessagesDropped = 0;
+    static TaskHandle_t xLoggingTask = NULL;
+
+    /* Output by the logging task only, so a single buffer is enough. */
+    static char cOutputBuffer[ configLOGGING_MAX_MESSAGE_LENGTH ];
 
 /*-----------------------------------------------------------*/
 
-BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
-                                   UBaseType_t uxPriority,
-                                   UBaseType_t uxQueueLength )
-{
-    BaseType_t xReturn = pdFAIL;
+    BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
+                                       UBaseType_t uxPriority,
+                                       UBaseType_t uxQueueLength )
+    {
+        BaseType_t xReturn = pdFAIL;
+
+        /* Ensure the logging task has not been created already. */
+        if( pxRecords == NULL )
+        {
+            /* The ring holds as many records as the queue would have held
+             * strings. */
+            pxRecords = pvPortMalloc( uxQueueLength * sizeof( LoggingRecord_t ) );
+
+            if( pxRecords != NULL )
+            {
+                memset( pxRecords, 0x00, uxQueueLength * sizeof( LoggingRecord_t ) );
+                uxRecordCount = uxQueueLength;
+
+                if( xTaskCreate( prvLoggingTask, "Logging", usStackSize, NULL, uxPriority, &xLoggingTask ) == pdPASS )
+                {
+                    xReturn = pdPASS;
+                }
+                else
+                {
+                    /* Could not create the task, so free the ring again. */
+                    vPortFree( pxRecords );
+                    pxRecords = NULL;
+                }
+            }
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvLoggingTask( void * pvParameters )
+    {
+        LoggingRecord_t * pxRecord;
+        uint32_t ulDropped, ulDroppedReported = 0;
+
+        for( ; ; )
+        {
+            /* Block to wait for the writers to commit records. */
+            ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+            /* Records are output in the order they were reserved, so stop at
+             * one whose writer has not finished with it yet.  That writer
+             * notifies this task again once it has. */
+            pxRecord = &( pxRecords[ uxNextRecordToOutput ] );
+
+            while( pxRecord->xCommitted != pdFALSE )
+            {
+                if( pxRecord->pcFormat == NULL )
+                {
+                    configPRINT_STRING( ( char * ) pxRecord->pvAllocated );
+                }
+                else
+                {
+                    prvFormatRecord( pxRecord, cOutputBuffer, sizeof( cOutputBuffer ) );
+
+                    if( cOutputBuffer[ 0 ] != '\0' )
+                    {
+                        configPRINT_STRING( cOutputBuffer );
+                    }
+                }
+
+                if( pxRecord->pvAllocated != NULL )
+                {
+                    vPortFree( pxRecord->pvAllocated );
+                    pxRecord->pvAllocated = NULL;
+                }
+
+                taskENTER_CRITICAL();
+                {
+                    pxRecord->xCommitted = pdFALSE;
+                    uxRecordsUsed--;
+                    uxNextRecordToOutput++;
+
+                    if( uxNextRecordToOutput == uxRecordCount )
+                    {
+                        uxNextRecordToOutput = 0;
+                    }
+                }
+                taskEXIT_CRITICAL();
 
-    /* Ensure the logging task has not been created already. */
-    if( xQueue == NULL )
+                pxRecord = &( pxRecords[ uxNextRecordToOutput ] );
+            }
+
+            ulDropped = ulMessagesDropped;
+
+            if( ulDropped != ulDroppedReported )
+            {
+                ( void ) snprintf( cOutputBuffer, sizeof( cOutputBuffer ), "[%lu log messages dropped]\r\n", ( unsigned long ) ( ulDropped - ulDroppedReported ) );
+                configPRINT_STRING( cOutputBuffer );
+                ulDroppedReported = ulDropped;
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static LoggingRecord_t * prvReserveRecord( void )
     {
-        /* Create the queue used to pass pointers to strings to the logging task. */
-        xQueue = xQueueCreate( uxQueueLength, sizeof( char ** ) );
+        LoggingRecord_t * pxRecord = NULL;
 
-        if( xQueue != NULL )
+        taskENTER_CRITICAL();
         {
-            if( xTaskCreate( prvLoggingTask, "Logging", usStackSize, NULL, uxPriority, NULL ) == pdPASS )
+            if( uxRecordsUsed < uxRecordCount )
             {
-                xReturn = pdPASS;
+                pxRecord = &( pxRecords[ uxNextRecordToWrite ] );
+                pxRecord->ulMessageNumber = ulNextMessageNumber++;
+                uxRecordsUsed++;
+                uxNextRecordToWrite++;
+
+                if( uxNextRecordToWrite == uxRecordCount )
+                {
+                    uxNextRecordToWrite = 0;
+                }
             }
             else
             {
-                /* Could not create the task, so delete the queue again. */
-                vQueueDelete( xQueue );
+                ulMessagesDropped++;
             }
         }
+        taskEXIT_CRITICAL();
+
+        return pxRecord;
     }
+/*-----------------------------------------------------------*/
 
-    return xReturn;
-}
+    static void prvCommitRecord( LoggingRecord_t * pxRecord )
+    {
+        /* The critical section also stops the compiler moving the writes
+         * that filled in the record past the flag. */
+        taskENTER_CRITICAL();
+        {
+            pxRecord->xCommitted = pdTRUE;
+        }
+        taskEXIT_CRITICAL();
+
+        xTaskNotifyGive( xLoggingTask );
+    }
 /*-----------------------------------------------------------*/
 
-static void prvLoggingTask( void * pvParameters )
-{
-    char * pcReceivedString = NULL;
+    static void prvParseConversion( const char * pcConversion,
+                                    LoggingConversion_t * pxConversion )
+    {
+        const char * pc = pcConversion + 1;
+        UBaseType_t uxLongCount = 0;
+        BaseType_t xIsSize = pdFALSE;
 
-    for( ; ; )
+        pxConversion->uxStarCount = 0;
+        pxConversion->eType = eLoggingArgUnsupported;
+
+        if( *pc == '%' )
+        {
+            pxConversion->eType = eLoggingArgNone;
+            pc++;
+        }
+        else
+        {
+            /* Flags. */
+            while( ( *pc != '\0' ) && ( strchr( "-+ #0", *pc ) != NULL ) )
+            {
+                pc++;
+            }
+
+            /* Width. */
+            if( *pc == '*' )
+            {
+                pxConversion->uxStarCount++;
+                pc++;
+            }
+            else
+            {
+                while( ( *pc >= '0' ) && ( *pc <= '9' ) )
+                {
+                    pc++;
+                }
+            }
+
+            /* Precision. */
+            if( *pc == '.' )
+            {
+                pc++;
+
+                if( *pc == '*' )
+                {
+                    pxConversion->uxStarCount++;
+                    pc++;
+                }
+                else
+                {
+                    while( ( *pc >= '0' ) && ( *pc <= '9' ) )
+                    {
+                        pc++;
+                    }
+                }
+            }
+
+            /* Length modifier.  Anything shorter than an int is promoted to an
+             * int when passed through the variable argument list. */
+            while( *pc == 'h' )
+            {
+                pc++;
+            }
+
+            while( ( *pc == 'l' ) && ( uxLongCount < 2 ) )
+            {
+                uxLongCount++;
+                pc++;
+            }
+
+            if( *pc == 'z' )
+            {
+                xIsSize = pdTRUE;
+                pc++;
+            }
+
+            switch( *pc )
+            {
+                case 'd':
+                case 'i':
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+
+                    if( xIsSize == pdTRUE )
+                    {
+                        pxConversion->eType = eLoggingArgSize;
+                    }
+                    else if( uxLongCount == 2 )
+                    {
+                        pxConversion->eType = eLoggingArgLongLong;
+                    }
+                    else if( uxLongCount == 1 )
+                    {
+                        pxConversion->eType = eLoggingArgLong;
+                    }
+                    else
+                    {
+                        pxConversion->eType = eLoggingArgInt;
+                    }
+
+                    break;
+
+                case 'c':
+                    pxConversion->eType = eLoggingArgInt;
+                    break;
+
+                case 'p':
+                    pxConversion->eType = eLoggingArgPointer;
+                    break;
+
+                case 's':
+
+                    if( uxLongCount == 0 )
+                    {
+                        pxConversion->eType = eLoggingArgString;
+                    }
+
+                    break;
+
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    pxConversion->eType = eLoggingArgDouble;
+                    break;
+
+                default:
+                    /* Left as eLoggingArgUnsupported. */
+                    break;
+            }
+
+            if( *pc != '\0' )
+            {
+                pc++;
+            }
+        }
+
+        pxConversion->pcEnd = pc;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvRecordArguments( LoggingRecord_t * pxRecord,
+                                    va_list xArgs )
     {
-        /* Block to wait for the next string to print. */
-        if( xQueueReceive( xQueue, &pcReceivedString, portMAX_DELAY ) == pdPASS )
+        const char * pc = pxRecord->pcFormat;
+        const char * pcString;
+        LoggingConversion_t xConversion;
+        UBaseType_t uxArg = 0, uxNeeded, x;
+        size_t xStringsUsed = 0;
+        char * pcCopy;
+
+        while( ( pc = strchr( pc, '%' ) ) != NULL )
         {
-            configPRINT_STRING( pcReceivedString );
-            vPortFree( ( void * ) pcReceivedString );
+            prvParseConversion( pc, &xConversion );
+            pc = xConversion.pcEnd;
+
+            uxNeeded = xConversion.uxStarCount + ( ( xConversion.eType != eLoggingArgNone ) ? 1 : 0 );
+
+            /* prvFormatRecord() stops at the same conversion. */
+            if( ( xConversion.eType == eLoggingArgUnsupported ) ||
+                ( ( uxArg + uxNeeded ) > configLOGGING_DEFERRED_MAX_ARGS ) )
+            {
+                break;
+            }
+
+            for( x = 0; x < xConversion.uxStarCount; x++ )
+            {
+                pxRecord->xArgs[ uxArg++ ].iValue = va_arg( xArgs, int );
+            }
+
+            switch( xConversion.eType )
+            {
+                case eLoggingArgInt:
+                    pxRecord->xArgs[ uxArg++ ].iValue = va_arg( xArgs, int );
+                    break;
+
+                case eLoggingArgLong:
+                    pxRecord->xArgs[ uxArg++ ].lValue = va_arg( xArgs, long );
+                    break;
+
+                case eLoggingArgLongLong:
+                    pxRecord->xArgs[ uxArg++ ].llValue = va_arg( xArgs, long long );
+                    break;
+
+                case eLoggingArgSize:
+                    pxRecord->xArgs[ uxArg++ ].xValue = va_arg( xArgs, size_t );
+                    break;
+
+                case eLoggingArgDouble:
+                    pxRecord->xArgs[ uxArg++ ].dValue = va_arg( xArgs, double );
+                    break;
+
+                case eLoggingArgPointer:
+                    pxRecord->xArgs[ uxArg++ ].pvValue = va_arg( xArgs, void * );
+                    break;
+
+                case eLoggingArgString:
+
+                    /* The string may be on the caller's stack, so copy as
+                     * much of it as fits. */
+                    pcString = va_arg( xArgs, const char * );
+
+                    if( pcString == NULL )
+                    {
+                        pcString = "(null)";
+                    }
+
+                    if( xStringsUsed < sizeof( pxRecord->cStrings ) )
+                    {
+                        pcCopy = &( pxRecord->cStrings[ xStringsUsed ] );
+                        pxRecord->xArgs[ uxArg++ ].pcValue = pcCopy;
+
+                        while( ( *pcString != '\0' ) && ( xStringsUsed < ( sizeof( pxRecord->cStrings ) - 1 ) ) )
+                        {
+                            pxRecord->cStrings[ xStringsUsed++ ] = *pcString++;
+                        }
+
+                        pxRecord->cStrings[ xStringsUsed++ ] = '\0';
+                    }
+                    else
+                    {
+                        pxRecord->xArgs[ uxArg++ ].pcValue = "";
+                    }
+
+                    break;
+
+                default:
+                    /* %% consumes no argument. */
+                    break;
+            }
         }
+
+        pxRecord->uxArgCount = uxArg;
     }
-}
 /*-----------------------------------------------------------*/
 
-/*!
- * \brief Formats a string to be printed and sends it
- * to the print queue.
- *
- * Appends the message number, time (in ticks), and task
- * that called vLoggingPrintf to the beginning of each
- * print statement.
- *
- */
-void vLoggingPrintf( const char * pcFormat,
-                     ... )
-{
-    size_t xLength = 0;
-    int32_t xLength2 = 0;
-    va_list args;
-    char * pcPrintString = NULL;
+    static void prvFormatRecord( const LoggingRecord_t * pxRecord,
+                                 char * pcBuffer,
+                                 size_t xBufferLength )
+    {
+        const char * pc = pxRecord->pcFormat;
+        const char * pcPercent;
+        const char * pcSpec;
+        const LoggingArg_t * pxArg = pxRecord->xArgs;
+        LoggingConversion_t xConversion;
+        char cSpec[ loggingMAX_SPEC_LENGTH ];
+        size_t xLength = 0, xSpecLength, xCopy;
+        UBaseType_t uxArg = 0, uxNeeded;
+        int32_t lWritten;
+        BaseType_t xVerbatim = pdFALSE;
+
+        pcBuffer[ 0 ] = '\0';
+
+        #if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 )
+            {
+                if( pxRecord->xAddPrefix == pdTRUE )
+                {
+                    lWritten = snprintf( pcBuffer, xBufferLength, "%lu %lu [%s] ",
+                                         ( unsigned long ) pxRecord->ulMessageNumber,
+                                         ( unsigned long ) pxRecord->xTickCount,
+                                         pxRecord->cTaskName );
+
+                    if( lWritten > 0 )
+                    {
+                        xLength = ( ( size_t ) lWritten < xBufferLength ) ? ( size_t ) lWritten : ( xBufferLength - 1 );
+                    }
+                }
+            }
+        #endif /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
+
+        while( ( *pc != '\0' ) && ( xLength < ( xBufferLength - 1 ) ) )
+        {
+            /* Copy the text up to the next conversion. */
+            pcPercent = strchr( pc, '%' );
+            xCopy = ( pcPercent != NULL ) ? ( size_t ) ( pcPercent - pc ) : strlen( pc );
+
+            if( xCopy > ( xBufferLength - 1 - xLength ) )
+            {
+                xCopy = xBufferLength - 1 - xLength;
+            }
+
+            memcpy( &( pcBuffer[ xLength ] ), pc, xCopy );
+            xLength += xCopy;
+            pcBuffer[ xLength ] = '\0';
+
+            if( ( pcPercent == NULL ) || ( xLength == ( xBufferLength - 1 ) ) )
+            {
+                break;
+            }
+
+            prvParseConversion( pcPercent, &xConversion );
+            pc = xConversion.pcEnd;
+
+            /* Stop where prvRecordArguments() stopped recording, and output
+             * the rest of the format string as it is. */
+            uxNeeded = xConversion.uxStarCount + ( ( xConversion.eType != eLoggingArgNone ) ? 1 : 0 );
+
+            if( ( xConversion.eType == eLoggingArgUnsupported ) ||
+                ( ( uxArg + uxNeeded ) > pxRecord->uxArgCount ) )
+            {
+                xVerbatim = pdTRUE;
+                break;
+            }
+
+            /* Rebuild the conversion specification with any '*' replaced by
+             * the recorded value, so it can be passed to snprintf() with the
+             * single argument being converted. */
+            xSpecLength = 0;
+
+            for( pcSpec = pcPercent; ( pcSpec < pc ) && ( xSpecLength < ( sizeof( cSpec ) - 1 ) ); pcSpec++ )
+            {
+                if( *pcSpec == '*' )
+                {
+                    lWritten = snprintf( &( cSpec[ xSpecLength ] ), sizeof( cSpec ) - xSpecLength, "%d", pxArg[ uxArg++ ].iValue );
+
+                    if( lWritten > 0 )
+                    {
+                        xSpecLength += ( size_t ) lWritten;
+                    }
+                }
+                else
+                {
+                    cSpec[ xSpecLength++ ] = *pcSpec;
+                }
+            }
+
+            if( xSpecLength >= ( sizeof( cSpec ) - 1 ) )
+            {
+                /* Too long to be a sensible conversion specification. */
+                xVerbatim = pdTRUE;
+                break;
+            }
 
-    /* The queue is created by xLoggingTaskInitialize().  Check
-     * xLoggingTaskInitialize() has been called. */
-    configASSERT( xQueue );
+            cSpec[ xSpecLength ] = '\0';
 
-    /* Allocate a buffer to hold the log message. */
-    pcPrintString = pvPortMalloc( configLOGGING_MAX_MESSAGE_LENGTH );
+            switch( xConversion.eType )
+            {
+                case eLoggingArgInt:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].iValue );
+                    break;
+
+                case eLoggingArgLong:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].lValue );
+                    break;
+
+                case eLoggingArgLongLong:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].llValue );
+                    break;
+
+                case eLoggingArgSize:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].xValue );
+                    break;
+
+                case eLoggingArgDouble:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].dValue );
+                    break;
+
+                case eLoggingArgPointer:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].pvValue );
+                    break;
+
+                case eLoggingArgString:
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, cSpec, pxArg[ uxArg++ ].pcValue );
+                    break;
+
+                default:
+                    /* %% */
+                    lWritten = snprintf( &( pcBuffer[ xLength ] ), xBufferLength - xLength, "%%" );
+                    break;
+            }
+
+            if( lWritten > 0 )
+            {
+                xLength += ( size_t ) lWritten;
 
-    if( pcPrintString != NULL )
+                if( xLength >= xBufferLength )
+                {
+                    /* snprintf() truncated the output. */
+                    xLength = xBufferLength - 1;
+                }
+            }
+        }
+
+        if( xVerbatim == pdTRUE )
+        {
+            xCopy = strlen( pcPercent );
+
+            if( xCopy > ( xBufferLength - 1 - xLength ) )
+            {
+                xCopy = xBufferLength - 1 - xLength;
+            }
+
+            memcpy( &( pcBuffer[ xLength ] ), pcPercent, xCopy );
+            pcBuffer[ xLength + xCopy ] = '\0';
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    /*!
+     * \brief Records a log message for the logging task to format.
+     *
+     * Only the format string pointer, the arguments, and the message number, time
+     * and task name are recorded, so the caller does not pay for formatting the
+     * message or for a buffer to format it into.
+     */
+    void vLoggingPrintf( const char * pcFormat,
+                         ... )
     {
-        /* There are a variable number of parameters. */
-        va_start( args, pcFormat );
+        va_list args;
+        LoggingRecord_t * pxRecord;
+
+        /* The ring is created by xLoggingTaskInitialize().  Check
+         * xLoggingTaskInitialize() has been called. */
+        configASSERT( pxRecords );
 
-        if( strcmp( pcFormat, "\n" ) != 0 )
+        pxRecord = prvReserveRecord();
+
+        if( pxRecord != NULL )
         {
+            pxRecord->pcFormat = pcFormat;
+            pxRecord->pvAllocated = NULL;
+            pxRecord->xAddPrefix = ( strcmp( pcFormat, "\n" ) != 0 ) ? pdTRUE : pdFALSE;
+
             #if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 )
                 {
-                    const char * pcTaskName;
-                    const char * pcNoTask = "None";
-                    static BaseType_t xMessageNumber = 0;
+                    pxRecord->xTickCount = xTaskGetTickCount();
 
-                    /* Add a time stamp and the name of the calling task to the
-                     * start of the log. */
                     if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
                     {
-                        pcTaskName = pcTaskGetName( NULL );
+                        strncpy( pxRecord->cTaskName, pcTaskGetName( NULL ), sizeof( pxRecord->cTaskName ) );
+                        pxRecord->cTaskName[ sizeof( pxRecord->cTaskName ) - 1 ] = '\0';
                     }
                     else
                     {
-                        pcTaskName = pcNoTask;
+                        strcpy( pxRecord->cTaskName, "None" );
                     }
-
-                    xLength = snprintf( pcPrintString, configLOGGING_MAX_MESSAGE_LENGTH, "%lu %lu [%s] ",
-                                        xMessageNumber++,
-                                        ( unsigned long ) xTaskGetTickCount(),
-                                        pcTaskName );
-                }
-            #else /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
-                {
-                    xLength = 0;
                 }
             #endif /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
+
+            /* There are a variable number of parameters. */
+            va_start( args, pcFormat );
+            prvRecordArguments( pxRecord, args );
+            va_end( args );
+
+            prvCommitRecord( pxRecord );
         }
+    }
+/*-----------------------------------------------------------*/
 
-        xLength2 = vsnprintf( pcPrintString + xLength, configLOGGING_MAX_MESSAGE_LENGTH - xLength, pcFormat, args );
+    void vLoggingPrint( const char * pcMessage )
+    {
+        char * pcPrintString = NULL;
+        size_t xLength = 0;
+        LoggingRecord_t * pxRecord;
+
+        /* The ring is created by xLoggingTaskInitialize().  Check
+         * xLoggingTaskInitialize() has been called. */
+        configASSERT( pxRecords );
+
+        /* The message has no format to defer, and can be longer than a record,
+         * so it is copied as before. */
+        xLength = strlen( pcMessage ) + 1;
+        pcPrintString = pvPortMalloc( xLength );
 
-        if( xLength2 < 0 )
+        if( pcPrintString != NULL )
         {
-            /* vsnprintf() failed. Restore the terminating NULL
-             * character of the first part. Note that the first
-             * part of the buffer may be empty if the value of
-             * configLOGGING_INCLUDE_TIME_AND_TASK_NAME is not
-             * 1 and as a result, the whole buffer may be empty.
-             * That's the reason we have a check for xLength > 0
-             * before sending the buffer to the logging task.
-             */
-            xLength2 = 0;
-            pcPrintString[ xLength ] = '\0';
+            strncpy( pcPrintString, pcMessage, xLength );
+
+            pxRecord = prvReserveRecord();
+
+            if( pxRecord != NULL )
+            {
+                pxRecord->pcFormat = NULL;
+                pxRecord->pvAllocated = pcPrintString;
+                prvCommitRecord( pxRecord );
+            }
+            else
+            {
+                /* The ring is full so the buffer must be freed again. */
+                vPortFree( ( void * ) pcPrintString );
+            }
         }
+    }
+
+#else /* if ( configLOGGING_DEFERRED == 1 ) */
 
-        xLength += ( size_t ) xLength2;
-        va_end( args );
+    /*
+     * The queue used to pass pointers to log messages from the task that created
+     * the message to the task that will performs the output.
+     */
+    static QueueHandle_t xQueue = NULL;
+
+/*-----------------------------------------------------------*/
 
-        /* Only send the buffer to the logging task if it is
-         * not empty. */
-        if( xLength > 0 )
+    BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
+                                       UBaseType_t uxPriority,
+                                       UBaseType_t uxQueueLength )
+    {
+        BaseType_t xReturn = pdFAIL;
+
+        /* Ensure the logging task has not been created already. */
+        if( xQueue == NULL )
         {
-            /* Send the string to the logging task for IO. */
-            if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+            /* Create the queue used to pass pointers to strings to the logging task. */
+            xQueue = xQueueCreate( uxQueueLength, sizeof( char ** ) );
+
+            if( xQueue != NULL )
             {
-                /* The buffer was not sent so must be freed again. */
-                vPortFree( ( void * ) pcPrintString );
+                if( xTaskCreate( prvLoggingTask, "Logging", usStackSize, NULL, uxPriority, NULL ) == pdPASS )
+                {
+                    xReturn = pdPASS;
+                }
+                else
+                {
+                    /* Could not create the task, so delete the queue again. */
+                    vQueueDelete( xQueue );
+                }
             }
         }
-        else
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvLoggingTask( void * pvParameters )
+    {
+        char * pcReceivedString = NULL;
+
+        for( ; ; )
         {
-            /* The buffer was not sent, so it must be
-             * freed. */
-            vPortFree( ( void * ) pcPrintString );
+            /* Block to wait for the next string to print. */
+            if( xQueueReceive( xQueue, &pcReceivedString, portMAX_DELAY ) == pdPASS )
+            {
+                configPRINT_STRING( pcReceivedString );
+                vPortFree( ( void * ) pcReceivedString );
+            }
         }
     }
-}
 /*-----------------------------------------------------------*/
 
-void vLoggingPrint( const char * pcMessage )
-{
-    char * pcPrintString = NULL;
-    size_t xLength = 0;
+    /*!
+     * \brief Formats a string to be printed and sends it
+     * to the print queue.
+     *
+     * Appends the message number, time (in ticks), and task
+     * that called vLoggingPrintf to the beginning of each
+     * print statement.
+     *
+     */
+    void vLoggingPrintf( const char * pcFormat,
+                         ... )
+    {
+        size_t xLength = 0;
+        int32_t xLength2 = 0;
+        va_list args;
+        char * pcPrintString = NULL;
+
+        /* The queue is created by xLoggingTaskInitialize().  Check
+         * xLoggingTaskInitialize() has been called. */
+        configASSERT( xQueue );
 
-    /* The queue is created by xLoggingTaskInitialize().  Check
-     * xLoggingTaskInitialize() has been called. */
-    configASSERT( xQueue );
+        /* Allocate a buffer to hold the log message. */
+        pcPrintString = pvPortMalloc( configLOGGING_MAX_MESSAGE_LENGTH );
+
+        if( pcPrintString != NULL )
+        {
+            /* There are a variable number of parameters. */
+            va_start( args, pcFormat );
 
-    xLength = strlen( pcMessage ) + 1;
-    pcPrintString = pvPortMalloc( xLength );
+            if( strcmp( pcFormat, "\n" ) != 0 )
+            {
+                #if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 )
+                    {
+                        const char * pcTaskName;
+                        const char * pcNoTask = "None";
+                        static BaseType_t xMessageNumber = 0;
+
+                        /* Add a time stamp and the name of the calling task to the
+                         * start of the log. */
+                        if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
+                        {
+                            pcTaskName = pcTaskGetName( NULL );
+                        }
+                        else
+                        {
+                            pcTaskName = pcNoTask;
+                        }
+
+                        xLength = snprintf( pcPrintString, configLOGGING_MAX_MESSAGE_LENGTH, "%lu %lu [%s] ",
+                                            xMessageNumber++,
+                                            ( unsigned long ) xTaskGetTickCount(),
+                                            pcTaskName );
+                    }
+                #else /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
+                    {
+                        xLength = 0;
+                    }
+                #endif /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
+            }
+
+            xLength2 = vsnprintf( pcPrintString + xLength, configLOGGING_MAX_MESSAGE_LENGTH - xLength, pcFormat, args );
+
+            if( xLength2 < 0 )
+            {
+                /* vsnprintf() failed. Restore the terminating NULL
+                 * character of the first part. Note that the first
+                 * part of the buffer may be empty if the value of
+                 * configLOGGING_INCLUDE_TIME_AND_TASK_NAME is not
+                 * 1 and as a result, the whole buffer may be empty.
+                 * That's the reason we have a check for xLength > 0
+                 * before sending the buffer to the logging task.
+                 */
+                xLength2 = 0;
+                pcPrintString[ xLength ] = '\0';
+            }
+
+            xLength += ( size_t ) xLength2;
+            va_end( args );
+
+            /* Only send the buffer to the logging task if it is
+             * not empty. */
+            if( xLength > 0 )
+            {
+                /* Send the string to the logging task for IO. */
+                if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+                {
+                    /* The buffer was not sent so must be freed again. */
+                    vPortFree( ( void * ) pcPrintString );
+                }
+            }
+            else
+            {
+                /* The buffer was not sent, so it must be
+                 * freed. */
+                vPortFree( ( void * ) pcPrintString );
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
 
-    if( pcPrintString != NULL )
+    void vLoggingPrint( const char * pcMessage )
     {
-        strncpy( pcPrintString, pcMessage, xLength );
+        char * pcPrintString = NULL;
+        size_t xLength = 0;
+
+        /* The queue is created by xLoggingTaskInitialize().  Check
+         * xLoggingTaskInitialize() has been called. */
+        configASSERT( xQueue );
 
-        /* Send the string to the logging task for IO. */
-        if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+        xLength = strlen( pcMessage ) + 1;
+        pcPrintString = pvPortMalloc( xLength );
+
+        if( pcPrintString != NULL )
         {
-            /* The buffer was not sent so must be freed again. */
-            vPortFree( ( void * ) pcPrintString );
+            strncpy( pcPrintString, pcMessage, xLength );
+
+            /* Send the string to the logging task for IO. */
+            if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+            {
+                /* The buffer was not sent so must be freed again. */
+                vPortFree( ( void * ) pcPrintString );
+            }
         }
     }
-}
+
+#endif /* if ( configLOGGING_DEFERRED == 1 ) */
@@ -0,0 +1,577 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A load generator for the FreeRTOS+TCP stack, intended to be run on the
+ * Windows simulator against the echo server found in tools/echo_server.  A
+ * configurable number of TCP flows and UDP flows run concurrently for a fixed
+ * duration, each in its own task.  A TCP flow writes a buffer to its socket
+ * and reads the echo back before sending the next one, a UDP flow sends a
+ * datagram and waits for its echo.
+ *
+ * At the end of every run a line is printed per flow and one line with the
+ * totals, all in comma separated form so the log can be compared between two
+ * builds of the stack:
+ *
+ *   LOAD,tcp|udp,<flow>,<bytes>,<ms>,<kbit/s>,<errors>
+ *   LOAD,total,<flows>,<bytes>,<ms>,<kbit/s>,<retransmits>,<ip-task permille>
+ *
+ * 'errors' counts failed connects and sends for a TCP flow, and datagrams for
+ * which no echo was received in time for a UDP flow.  The retransmits are
+ * only counted when ipconfigTCP_CONNECTION_STATS is not zero, otherwise 0 is
+ * printed.  The IP-task CPU usage requires configUSE_TRACE_FACILITY and
+ * configGENERATE_RUN_TIME_STATS, it is the share of the run time stats clock
+ * that was spent in the IP-task during the run.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Demo configuration */
+#include "aws_demo_config.h"
+
+/* The number of concurrent TCP flows. */
+#ifndef democonfigTCP_LOAD_NUM_TCP_FLOWS
+    #define democonfigTCP_LOAD_NUM_TCP_FLOWS    ( 4 )
+#endif
+
+/* The number of concurrent UDP flows. */
+#ifndef democonfigTCP_LOAD_NUM_UDP_FLOWS
+    #define democonfigTCP_LOAD_NUM_UDP_FLOWS    ( 1 )
+#endif
+
+/* The duration of a single run. */
+#ifndef democonfigTCP_LOAD_RUN_DURATION
+    #define democonfigTCP_LOAD_RUN_DURATION     pdMS_TO_TICKS( 10000 )
+#endif
+
+/* The pause between two runs, during which the results are printed. */
+#ifndef democonfigTCP_LOAD_RUN_INTERVAL
+    #define democonfigTCP_LOAD_RUN_INTERVAL     pdMS_TO_TICKS( 5000 )
+#endif
+
+/* The port on which tools/echo_server listens, for both TCP and UDP. */
+#ifndef democonfigTCP_LOAD_ECHO_PORT
+    #define democonfigTCP_LOAD_ECHO_PORT        ( 9001 )
+#endif
+
+/* The number of bytes a TCP flow writes before it reads the echo back. */
+#ifndef democonfigTCP_LOAD_TCP_BUFFER_SIZE
+    #define democonfigTCP_LOAD_TCP_BUFFER_SIZE  ( 4 * ipconfigTCP_MSS )
+#endif
+
+/* The payload size of the datagrams sent by a UDP flow. */
+#ifndef democonfigTCP_LOAD_UDP_PAYLOAD_SIZE
+    #define democonfigTCP_LOAD_UDP_PAYLOAD_SIZE ( 512 )
+#endif
+
+/* Stack size and priority of the flow tasks and of the controlling task. */
+#ifndef democonfigTCP_LOAD_TASK_STACK_SIZE
+    #define democonfigTCP_LOAD_TASK_STACK_SIZE  ( configMINIMAL_STACK_SIZE * 4 )
+#endif
+
+#ifndef democonfigTCP_LOAD_TASK_PRIORITY
+    #define democonfigTCP_LOAD_TASK_PRIORITY    ( tskIDLE_PRIORITY )
+#endif
+
+#define loadNUM_FLOWS                           ( democonfigTCP_LOAD_NUM_TCP_FLOWS + democonfigTCP_LOAD_NUM_UDP_FLOWS )
+
+/* The time a flow waits for the echo server to close the connection. */
+#define loadSHUTDOWN_TIMEOUT                    pdMS_TO_TICKS( 2000 )
+
+/* The name FreeRTOS_IPInit() gives to the IP-task. */
+#define loadIP_TASK_NAME                        "IP-task"
+
+/*-----------------------------------------------------------*/
+
+/* The state of a single flow.  The counters are written by the flow task
+ * during a run, and only read by the controlling task after the run. */
+typedef struct LoadFlow
+{
+    TaskHandle_t xTask;
+    BaseType_t xIndex;
+    BaseType_t xIsUDP;
+    uint32_t ulBytesEchoed;
+    uint32_t ulErrors;
+    TickType_t xElapsed;
+} LoadFlow_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Creates the flow tasks then starts a new run every
+ * democonfigTCP_LOAD_RUN_INTERVAL ticks, and prints its results.
+ */
+static void prvLoadControlTask( void * pvParameters );
+
+/*
+ * Waits for the controlling task to start a run, then drives a TCP or a UDP
+ * flow until democonfigTCP_LOAD_RUN_DURATION ticks have passed.
+ */
+static void prvLoadFlowTask( void * pvParameters );
+
+/*
+ * The body of a single run of a TCP flow and of a UDP flow.
+ */
+static void prvRunTCPFlow( LoadFlow_t * pxFlow,
+                           uint8_t * pucBuffer );
+static void prvRunUDPFlow( LoadFlow_t * pxFlow,
+                           uint8_t * pucBuffer );
+
+/*
+ * Returns pdTRUE until the current run has ended.
+ */
+static BaseType_t prvRunIsActive( void );
+
+/*
+ * Returns the value of the run time counter of the IP-task, and sets
+ * *pulTotalRunTime to the run time stats clock.  Returns 0 when the run time
+ * stats are not available.
+ */
+static uint32_t prvGetIPTaskRunTime( uint32_t * pulTotalRunTime );
+
+/*
+ * Returns the number of TCP segments retransmitted so far by all sockets.
+ */
+static uint32_t prvGetRetransmitCount( void );
+
+/*
+ * Converts a number of bytes transferred in xTicks to kbit/s.
+ */
+static uint32_t prvKbitPerSecond( uint32_t ulBytes,
+                                  TickType_t xTicks );
+
+/*-----------------------------------------------------------*/
+
+/* Rx and Tx time outs of the flow sockets. */
+static const TickType_t xReceiveTimeOut = pdMS_TO_TICKS( 1000 );
+static const TickType_t xSendTimeOut = pdMS_TO_TICKS( 2000 );
+
+static LoadFlow_t xFlows[ loadNUM_FLOWS ];
+
+/* Given by each flow task at the end of a run. */
+static SemaphoreHandle_t xRunDoneSemaphore = NULL;
+
+/* The tick count at which the current run ends. */
+static TickType_t xRunEnd;
+
+/* The address of the echo server, for all flows. */
+static struct freertos_sockaddr xEchoServerAddress;
+
+/*-----------------------------------------------------------*/
+
+void vStartTCPLoadGeneratorTasks( void )
+{
+    xRunDoneSemaphore = xSemaphoreCreateCounting( loadNUM_FLOWS, 0 );
+    configASSERT( xRunDoneSemaphore );
+
+    xTaskCreate( prvLoadControlTask,                  /* The function that implements the task. */
+                 "LoadCtrl",                          /* Just a text name for the task to aid debugging. */
+                 democonfigTCP_LOAD_TASK_STACK_SIZE,  /* The stack size is defined in aws_demo_config.h. */
+                 NULL,                                /* The task parameter, not used in this case. */
+                 democonfigTCP_LOAD_TASK_PRIORITY,    /* The priority assigned to the task is defined in aws_demo_config.h. */
+                 NULL );                              /* The task handle is not used. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoadControlTask( void * pvParameters )
+{
+    BaseType_t xIndex;
+    char cName[ configMAX_TASK_NAME_LEN ];
+    uint32_t ulIPRunTimeStart, ulIPRunTimeEnd, ulTotalRunTimeStart = 0, ulTotalRunTimeEnd = 0;
+    uint32_t ulRetransmitsStart, ulBytes, ulPermille;
+    TickType_t xRunStart, xRunTicks;
+
+    ( void ) pvParameters;
+
+    /* The echo server address is configured by the constants
+     * configECHO_SERVER_ADDR0 to configECHO_SERVER_ADDR3 in
+     * FreeRTOSConfig.h. */
+    xEchoServerAddress.sin_port = FreeRTOS_htons( democonfigTCP_LOAD_ECHO_PORT );
+    xEchoServerAddress.sin_addr = FreeRTOS_inet_addr_quick( configECHO_SERVER_ADDR0,
+                                                            configECHO_SERVER_ADDR1,
+                                                            configECHO_SERVER_ADDR2,
+                                                            configECHO_SERVER_ADDR3 );
+
+    for( xIndex = 0; xIndex < loadNUM_FLOWS; xIndex++ )
+    {
+        xFlows[ xIndex ].xIsUDP = ( xIndex >= democonfigTCP_LOAD_NUM_TCP_FLOWS ) ? pdTRUE : pdFALSE;
+        xFlows[ xIndex ].xIndex = xFlows[ xIndex ].xIsUDP ? ( xIndex - democonfigTCP_LOAD_NUM_TCP_FLOWS ) : xIndex;
+        snprintf( cName, sizeof( cName ), "Load%s%d", xFlows[ xIndex ].xIsUDP ? "Udp" : "Tcp", ( int ) xFlows[ xIndex ].xIndex );
+
+        if( xTaskCreate( prvLoadFlowTask, cName, democonfigTCP_LOAD_TASK_STACK_SIZE, &( xFlows[ xIndex ] ),
+                         democonfigTCP_LOAD_TASK_PRIORITY, &( xFlows[ xIndex ].xTask ) ) != pdPASS )
+        {
+            configPRINTF( ( "Load generator failed to create flow %d.\r\n", ( int ) xIndex ) );
+            vTaskDelete( NULL );
+        }
+    }
+
+    for( ; ; )
+    {
+        /* Wait until the network is up. */
+        while( FreeRTOS_IsNetworkUp() == pdFALSE )
+        {
+            vTaskDelay( democonfigTCP_LOAD_RUN_INTERVAL );
+        }
+
+        configPRINTF( ( "Load generator starting %d TCP and %d UDP flows to %d.%d.%d.%d:%d.\r\n",
+                        democonfigTCP_LOAD_NUM_TCP_FLOWS,
+                        democonfigTCP_LOAD_NUM_UDP_FLOWS,
+                        configECHO_SERVER_ADDR0,
+                        configECHO_SERVER_ADDR1,
+                        configECHO_SERVER_ADDR2,
+                        configECHO_SERVER_ADDR3,
+                        democonfigTCP_LOAD_ECHO_PORT ) );
+
+        ulRetransmitsStart = prvGetRetransmitCount();
+        ulIPRunTimeStart = prvGetIPTaskRunTime( &ulTotalRunTimeStart );
+        xRunStart = xTaskGetTickCount();
+        xRunEnd = xRunStart + democonfigTCP_LOAD_RUN_DURATION;
+
+        for( xIndex = 0; xIndex < loadNUM_FLOWS; xIndex++ )
+        {
+            xTaskNotifyGive( xFlows[ xIndex ].xTask );
+        }
+
+        for( xIndex = 0; xIndex < loadNUM_FLOWS; xIndex++ )
+        {
+            ( void ) xSemaphoreTake( xRunDoneSemaphore, portMAX_DELAY );
+        }
+
+        ulIPRunTimeEnd = prvGetIPTaskRunTime( &ulTotalRunTimeEnd );
+        xRunTicks = xTaskGetTickCount() - xRunStart;
+        ulBytes = 0UL;
+
+        for( xIndex = 0; xIndex < loadNUM_FLOWS; xIndex++ )
+        {
+            configPRINTF( ( "LOAD,%s,%d,%lu,%lu,%lu,%lu\r\n",
+                            xFlows[ xIndex ].xIsUDP ? "udp" : "tcp",
+                            ( int ) xFlows[ xIndex ].xIndex,
+                            ( unsigned long ) xFlows[ xIndex ].ulBytesEchoed,
+                            ( unsigned long ) ( xFlows[ xIndex ].xElapsed * portTICK_PERIOD_MS ),
+                            ( unsigned long ) prvKbitPerSecond( xFlows[ xIndex ].ulBytesEchoed, xFlows[ xIndex ].xElapsed ),
+                            ( unsigned long ) xFlows[ xIndex ].ulErrors ) );
+            ulBytes += xFlows[ xIndex ].ulBytesEchoed;
+        }
+
+        ulPermille = 0UL;
+
+        if( ulTotalRunTimeEnd != ulTotalRunTimeStart )
+        {
+            ulPermille = ( uint32_t ) ( ( ( uint64_t ) ( ulIPRunTimeEnd - ulIPRunTimeStart ) * 1000ULL ) /
+                                        ( uint64_t ) ( ulTotalRunTimeEnd - ulTotalRunTimeStart ) );
+        }
+
+        configPRINTF( ( "LOAD,total,%d,%lu,%lu,%lu,%lu,%lu\r\n",
+                        ( int ) loadNUM_FLOWS,
+                        ( unsigned long ) ulBytes,
+                        ( unsigned long ) ( xRunTicks * portTICK_PERIOD_MS ),
+                        ( unsigned long ) prvKbitPerSecond( ulBytes, xRunTicks ),
+                        ( unsigned long ) ( prvGetRetransmitCount() - ulRetransmitsStart ),
+                        ( unsigned long ) ulPermille ) );
+
+        vTaskDelay( democonfigTCP_LOAD_RUN_INTERVAL );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoadFlowTask( void * pvParameters )
+{
+    LoadFlow_t * pxFlow = ( LoadFlow_t * ) pvParameters;
+    uint8_t * pucBuffer;
+    size_t xBufferSize;
+    size_t xByte;
+    TickType_t xStart;
+
+    xBufferSize = pxFlow->xIsUDP ? democonfigTCP_LOAD_UDP_PAYLOAD_SIZE : democonfigTCP_LOAD_TCP_BUFFER_SIZE;
+
+    /* Twice the size, the second half receives the echo. */
+    pucBuffer = ( uint8_t * ) pvPortMalloc( 2 * xBufferSize );
+    configASSERT( pucBuffer );
+
+    for( xByte = 0; xByte < xBufferSize; xByte++ )
+    {
+        pucBuffer[ xByte ] = ( uint8_t ) ( '0' + ( xByte % 64 ) );
+    }
+
+    for( ; ; )
+    {
+        /* Wait for the controlling task to start a run. */
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+        pxFlow->ulBytesEchoed = 0UL;
+        pxFlow->ulErrors = 0UL;
+        xStart = xTaskGetTickCount();
+
+        if( pxFlow->xIsUDP != pdFALSE )
+        {
+            prvRunUDPFlow( pxFlow, pucBuffer );
+        }
+        else
+        {
+            prvRunTCPFlow( pxFlow, pucBuffer );
+        }
+
+        pxFlow->xElapsed = xTaskGetTickCount() - xStart;
+        ( void ) xSemaphoreGive( xRunDoneSemaphore );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTCPFlow( LoadFlow_t * pxFlow,
+                           uint8_t * pucBuffer )
+{
+    Socket_t xSocket;
+    BaseType_t xReturned, xTransferred;
+    TickType_t xShutdownStart;
+    uint8_t * pucEcho = pucBuffer + democonfigTCP_LOAD_TCP_BUFFER_SIZE;
+
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+        WinProperties_t xWinProps;
+
+        /* Fill in the required buffer and window sizes. */
+        xWinProps.lTxBufSize = 6 * ipconfigTCP_MSS;
+        xWinProps.lTxWinSize = 3;
+        xWinProps.lRxBufSize = 6 * ipconfigTCP_MSS;
+        xWinProps.lRxWinSize = 3;
+    #endif
+
+    /* A connection that fails is retried until the run ends, every failure
+     * is counted as an error. */
+    while( prvRunIsActive() != pdFALSE )
+    {
+        xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+        if( xSocket == FREERTOS_INVALID_SOCKET )
+        {
+            pxFlow->ulErrors++;
+            vTaskDelay( xReceiveTimeOut );
+            continue;
+        }
+
+        FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xReceiveTimeOut, sizeof( xReceiveTimeOut ) );
+        FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xSendTimeOut, sizeof( xSendTimeOut ) );
+
+        #if ( ipconfigUSE_TCP_WIN == 1 )
+            FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) &xWinProps, sizeof( xWinProps ) );
+        #endif
+
+        if( FreeRTOS_connect( xSocket, &xEchoServerAddress, sizeof( xEchoServerAddress ) ) != 0 )
+        {
+            pxFlow->ulErrors++;
+            FreeRTOS_closesocket( xSocket );
+            continue;
+        }
+
+        xReturned = 0;
+
+        while( ( prvRunIsActive() != pdFALSE ) && ( xReturned >= 0 ) )
+        {
+            /* FreeRTOS_send() blocks until the whole buffer is queued, or the
+             * send time out expires. */
+            xReturned = FreeRTOS_send( xSocket, pucBuffer, democonfigTCP_LOAD_TCP_BUFFER_SIZE, 0 );
+
+            if( xReturned != ( BaseType_t ) democonfigTCP_LOAD_TCP_BUFFER_SIZE )
+            {
+                pxFlow->ulErrors++;
+                break;
+            }
+
+            for( xTransferred = 0; xTransferred < ( BaseType_t ) democonfigTCP_LOAD_TCP_BUFFER_SIZE; xTransferred += xReturned )
+            {
+                xReturned = FreeRTOS_recv( xSocket, &( pucEcho[ xTransferred ] ), democonfigTCP_LOAD_TCP_BUFFER_SIZE - xTransferred, 0 );
+
+                if( xReturned <= 0 )
+                {
+                    /* Time out or connection lost. */
+                    pxFlow->ulErrors++;
+                    xReturned = -1;
+                    break;
+                }
+            }
+
+            if( xReturned >= 0 )
+            {
+                pxFlow->ulBytesEchoed += ( uint32_t ) xTransferred;
+            }
+        }
+
+        /* Initiate a graceful shut down and wait for the peer to close its
+         * side of the connection. */
+        FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+        xShutdownStart = xTaskGetTickCount();
+
+        while( ( xTaskGetTickCount() - xShutdownStart ) < loadSHUTDOWN_TIMEOUT )
+        {
+            if( FreeRTOS_recv( xSocket, pucEcho, democonfigTCP_LOAD_TCP_BUFFER_SIZE, 0 ) < 0 )
+            {
+                break;
+            }
+        }
+
+        FreeRTOS_closesocket( xSocket );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunUDPFlow( LoadFlow_t * pxFlow,
+                           uint8_t * pucBuffer )
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xFrom;
+    uint32_t ulFromLength = sizeof( xFrom );
+    int32_t lReturned;
+    uint8_t * pucEcho = pucBuffer + democonfigTCP_LOAD_UDP_PAYLOAD_SIZE;
+
+    xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+    if( xSocket == FREERTOS_INVALID_SOCKET )
+    {
+        pxFlow->ulErrors++;
+        return;
+    }
+
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xReceiveTimeOut, sizeof( xReceiveTimeOut ) );
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xSendTimeOut, sizeof( xSendTimeOut ) );
+
+    /* The socket is bound to an ephemeral port by FreeRTOS_sendto(). */
+    while( prvRunIsActive() != pdFALSE )
+    {
+        lReturned = FreeRTOS_sendto( xSocket, pucBuffer, democonfigTCP_LOAD_UDP_PAYLOAD_SIZE, 0, &xEchoServerAddress, sizeof( xEchoServerAddress ) );
+
+        if( lReturned != ( int32_t ) democonfigTCP_LOAD_UDP_PAYLOAD_SIZE )
+        {
+            /* No network buffer was available in time. */
+            pxFlow->ulErrors++;
+            continue;
+        }
+
+        lReturned = FreeRTOS_recvfrom( xSocket, pucEcho, democonfigTCP_LOAD_UDP_PAYLOAD_SIZE, 0, &xFrom, &ulFromLength );
+
+        if( lReturned > 0 )
+        {
+            pxFlow->ulBytesEchoed += ( uint32_t ) lReturned;
+        }
+        else
+        {
+            /* The datagram or its echo was lost. */
+            pxFlow->ulErrors++;
+        }
+    }
+
+    FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunIsActive( void )
+{
+    /* The subtraction also gives the right answer when the tick count
+     * wraps during the run. */
+    return ( ( TickType_t ) ( xRunEnd - xTaskGetTickCount() ) <= democonfigTCP_LOAD_RUN_DURATION ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetIPTaskRunTime( uint32_t * pulTotalRunTime )
+{
+    uint32_t ulReturn = 0UL;
+
+    #if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configGENERATE_RUN_TIME_STATS == 1 ) )
+        {
+            TaskStatus_t * pxTaskStatusArray;
+            UBaseType_t uxArraySize, uxIndex;
+
+            /* Leave some room for tasks that are created in the meantime. */
+            uxArraySize = uxTaskGetNumberOfTasks() + 4;
+            pxTaskStatusArray = ( TaskStatus_t * ) pvPortMalloc( uxArraySize * sizeof( TaskStatus_t ) );
+
+            if( pxTaskStatusArray != NULL )
+            {
+                uxArraySize = uxTaskGetSystemState( pxTaskStatusArray, uxArraySize, pulTotalRunTime );
+
+                for( uxIndex = 0; uxIndex < uxArraySize; uxIndex++ )
+                {
+                    if( strcmp( pxTaskStatusArray[ uxIndex ].pcTaskName, loadIP_TASK_NAME ) == 0 )
+                    {
+                        ulReturn = pxTaskStatusArray[ uxIndex ].ulRunTimeCounter;
+                        break;
+                    }
+                }
+
+                vPortFree( pxTaskStatusArray );
+            }
+        }
+    #else /* if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configGENERATE_RUN_TIME_STATS == 1 ) ) */
+        {
+            *pulTotalRunTime = 0UL;
+        }
+    #endif /* if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configGENERATE_RUN_TIME_STATS == 1 ) ) */
+
+    return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetRetransmitCount( void )
+{
+    uint32_t ulReturn = 0UL;
+
+    #if ( ipconfigTCP_CONNECTION_STATS != 0 )
+        {
+            TCPStackStats_t xTotals;
+
+            ( void ) FreeRTOS_TCPSnapshot( NULL, 0, &xTotals );
+            ulReturn = xTotals.ulRetransmitCount;
+        }
+    #endif
+
+    return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvKbitPerSecond( uint32_t ulBytes,
+                                  TickType_t xTicks )
+{
+    uint32_t ulReturn = 0UL;
+
+    if( xTicks != 0 )
+    {
+        ulReturn = ( uint32_t ) ( ( ( uint64_t ) ulBytes * 8ULL * ( uint64_t ) configTICK_RATE_HZ ) /
+                                  ( ( uint64_t ) xTicks * 1000ULL ) );
+    }
+
+    return ulReturn;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,67 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mbedtls/entropy.h"
+
+/*-----------------------------------------------------------*/
+
+int mbedtls_hardware_poll( void * data,
+                           unsigned char * output,
+                           size_t len,
+                           size_t * olen )
+{
+    int lStatus = MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+    FILE * pxRandom;
+
+    /* Unferenced parameter. */
+    ( void ) data;
+
+    /*
+     * This is port-specific for the Linux simulator, so just use the kernel
+     * random number generator.  The scheduler is suspended so the calling
+     * task cannot be switched out while it holds a C library lock.
+     */
+    vTaskSuspendAll();
+    {
+        pxRandom = fopen( "/dev/urandom", "rb" );
+
+        if( pxRandom != NULL )
+        {
+            if( fread( output, 1, len, pxRandom ) == len )
+            {
+                lStatus = 0;
+                *olen = len;
+            }
+
+            fclose( pxRandom );
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return lStatus;
+}
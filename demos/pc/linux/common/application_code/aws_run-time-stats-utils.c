@@ -0,0 +1,72 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/*
+ * Utility functions required to gather run time statistics.  See:
+ * http://www.freertos.org/rtos-run-time-stats.html
+ *
+ * The counter is taken from the host monotonic clock in units of 1/100th of a
+ * millisecond, the same units as the Windows simulator, so the statistics are
+ * in real time rather than in simulated time.
+ *
+ * Also note that it is assumed this demo is going to be used for short periods
+ * of time only, and therefore timer overflows are not handled.
+ */
+
+/* Standard includes. */
+#include <time.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+
+/* The time at which the run time stats time base was started.  Run time stats
+ * record how much time each task spends in the Running state. */
+static struct timespec xInitialRunTimeCounterValue;
+
+/*-----------------------------------------------------------*/
+
+void vConfigureTimerForRunTimeStats( void )
+{
+    clock_gettime( CLOCK_MONOTONIC, &xInitialRunTimeCounterValue );
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulGetRunTimeCounterValue( void )
+{
+    struct timespec xCurrentCount;
+    long long llHundredthsOfAMillisecond;
+
+    clock_gettime( CLOCK_MONOTONIC, &xCurrentCount );
+
+    /* Subtract the reading taken when the application started to get a count
+     * from that reference point, then scale to 1/100ths of a millisecond. */
+    llHundredthsOfAMillisecond =
+        ( ( long long ) ( xCurrentCount.tv_sec - xInitialRunTimeCounterValue.tv_sec ) * 100000LL ) +
+        ( ( long long ) ( xCurrentCount.tv_nsec - xInitialRunTimeCounterValue.tv_nsec ) / 10000LL );
+
+    return ( unsigned long ) llHundredthsOfAMillisecond;
+}
+/*-----------------------------------------------------------*/
@@ -228,6 +228,10 @@ extern uint32_t ulRand();
 /* USE_WIN: Let TCP use windowing mechanism. */
 #define ipconfigUSE_TCP_WIN                            ( 1 )
 
+/* Count the bytes and retransmissions of each TCP socket, so the load
+ * generator demo can report them. */
+#define ipconfigTCP_CONNECTION_STATS                   ( 1 )
+
 /* The MTU is the maximum number of bytes the payload of a network frame can
  * contain.  For normal Ethernet V2 frames the maximum MTU is 1500.  Setting a
  * lower value can save RAM, depending on the buffer management scheme used.  If
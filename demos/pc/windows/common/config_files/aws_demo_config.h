@@ -63,6 +63,14 @@
 #define democonfigTCP_ECHO_TASKS_SEPARATE_TASK_STACK_SIZE    ( configMINIMAL_STACK_SIZE * 4 )
 #define democonfigTCP_ECHO_TASKS_SEPARATE_TASK_PRIORITY      ( tskIDLE_PRIORITY )
 
+/* TCP/IP load generator parameters, see aws_tcp_load_generator.c. */
+#define democonfigTCP_LOAD_NUM_TCP_FLOWS                     ( 4 )
+#define democonfigTCP_LOAD_NUM_UDP_FLOWS                     ( 1 )
+#define democonfigTCP_LOAD_RUN_DURATION                      pdMS_TO_TICKS( 10000 )
+#define democonfigTCP_LOAD_ECHO_PORT                         ( 9001 )
+#define democonfigTCP_LOAD_TASK_STACK_SIZE                   ( configMINIMAL_STACK_SIZE * 4 )
+#define democonfigTCP_LOAD_TASK_PRIORITY                     ( tskIDLE_PRIORITY )
+
 /* MQTT echo task example parameters. */
 #define democonfigMQTT_ECHO_TASK_STACK_SIZE                  ( configMINIMAL_STACK_SIZE * 2 )
 #define democonfigMQTT_ECHO_TASK_PRIORITY                    ( tskIDLE_PRIORITY )
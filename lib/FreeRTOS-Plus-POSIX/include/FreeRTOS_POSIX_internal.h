@@ -72,15 +72,26 @@
 #endif
 
 #if posixconfigENABLE_PTHREAD_COND_T == 1
+    /**
+     * @brief A thread blocked in pthread_cond_wait.
+     *
+     * Waiters live on the stack of the waiting thread and are linked into the
+     * condition variable while the thread is blocked on its task notification.
+     */
+    typedef struct pthread_cond_waiter
+    {
+        TaskHandle_t xTask;                        /**< The waiting thread. */
+        UBaseType_t uxPriority;                    /**< Priority of the waiting thread when it started waiting. */
+        volatile BaseType_t xSignaled;             /**< Set to pdTRUE when the waiter is removed by a signal or broadcast. */
+        struct pthread_cond_waiter * pxNext;       /**< Next waiter, in order of decreasing priority. */
+    } pthread_cond_waiter_t;
+
     /**
      * @brief Condition variable.
      */
     typedef struct pthread_cond_internal
     {
-        BaseType_t xIsInitialized;            /**< Set to pdTRUE if this condition variable is initialized, pdFALSE otherwise. */
-        StaticSemaphore_t xCondMutex;         /**< Prevents concurrent accesses to iWaitingThreads. */
-        StaticSemaphore_t xCondWaitSemaphore; /**< Threads block on this semaphore in pthread_cond_wait. */
-        int iWaitingThreads;                  /**< The number of threads currently waiting on this condition variable. */
+        pthread_cond_waiter_t * volatile pxWaiters; /**< Threads currently waiting on this condition variable. */
     } pthread_cond_internal_t;
 
     /**
@@ -89,10 +100,7 @@
     #define FREERTOS_POSIX_COND_INITIALIZER \
         ( ( ( pthread_cond_internal_t )     \
         {                                   \
-            .xIsInitialized = pdFALSE,      \
-            .xCondMutex = { { 0 } },        \
-            .xCondWaitSemaphore = { { 0 } },\
-            .iWaitingThreads = 0            \
+            .pxWaiters = NULL               \
         }                                   \
           )                                 \
         )
@@ -114,11 +122,10 @@
      */
     typedef struct pthread_barrier_internal
     {
-        unsigned uThreadCount;                   /**< Current number of threads that have entered barrier. */
-        unsigned uThreshold;                     /**< The count argument of pthread_barrier_init. */
-        StaticSemaphore_t xThreadCountMutex;     /**< Guards access to uThreadCount. */
-        StaticSemaphore_t xThreadCountSemaphore; /**< Prevents more than uThreshold threads from exiting pthread_barrier_wait at once. */
-        StaticEventGroup_t xBarrierEventGroup;   /**< FreeRTOS event group that blocks to wait on threads entering barrier. */
+        unsigned uThreadCount;                 /**< Number of threads that have entered the barrier in the current phase. */
+        unsigned uThreshold;                   /**< The count argument of pthread_barrier_init. */
+        unsigned uPhase;                       /**< The current phase, 0 or 1; flipped each time the barrier opens. */
+        StaticEventGroup_t xBarrierEventGroup; /**< FreeRTOS event group whose phase bits release the waiting threads. */
     } pthread_barrier_internal_t;
 #endif
 
@@ -38,6 +38,28 @@
     #define posixconfigPTHREAD_TASK_NAME    "pthread"
 #endif
 
+/**
+ * @brief The number of finished pthreads whose tasks are kept for reuse.
+ *
+ * pthread_create reuses a kept task with the requested stack size instead of
+ * creating a new one. 0 deletes every task when its pthread ends.
+ */
+#ifndef posixconfigPTHREAD_POOL_SIZE
+    #define posixconfigPTHREAD_POOL_SIZE    0
+#endif
+
+/**
+ * @brief The task notification index used to wake threads waiting on a
+ * condition variable, and pooled pthread tasks waiting for work.
+ *
+ * Set it to an index below configTASK_NOTIFICATION_ARRAY_ENTRIES other than
+ * tskDEFAULT_INDEX_TO_NOTIFY to keep these wakeups apart from notifications
+ * the application sends to its threads.
+ */
+#ifndef posixconfigNOTIFICATION_INDEX
+    #define posixconfigNOTIFICATION_INDEX    tskDEFAULT_INDEX_TO_NOTIFY
+#endif
+
 /**
  * @brief the FreeRTOS timer name given to POSIX timers.
  */
@@ -45,6 +67,31 @@
     #define posixconfigTIMER_NAME    "timer"
 #endif
 
+/**
+ * @brief Set to 1 if the port provides a clock with a finer resolution than
+ * the tick.
+ *
+ * clock_gettime and clock_getres then use it for both CLOCK_REALTIME and
+ * CLOCK_MONOTONIC. The port must define posixconfigHIGH_RESOLUTION_CLOCK_NS()
+ * to return the nanoseconds elapsed since an arbitrary point as a uint64_t,
+ * without ever going backwards (for example from a free-running counter such
+ * as the Cortex-M DWT cycle counter extended to 64 bits), and
+ * posixconfigHIGH_RESOLUTION_CLOCK_RESOLUTION_NS to the nanoseconds between
+ * two of its values.
+ */
+#ifndef posixconfigUSE_HIGH_RESOLUTION_CLOCK
+    #define posixconfigUSE_HIGH_RESOLUTION_CLOCK    0
+#endif
+
+#if ( posixconfigUSE_HIGH_RESOLUTION_CLOCK == 1 )
+    #ifndef posixconfigHIGH_RESOLUTION_CLOCK_NS
+        #error "posixconfigHIGH_RESOLUTION_CLOCK_NS() must be defined when posixconfigUSE_HIGH_RESOLUTION_CLOCK is 1"
+    #endif
+    #ifndef posixconfigHIGH_RESOLUTION_CLOCK_RESOLUTION_NS
+        #error "posixconfigHIGH_RESOLUTION_CLOCK_RESOLUTION_NS must be defined when posixconfigUSE_HIGH_RESOLUTION_CLOCK is 1"
+    #endif
+#endif
+
 /**
  * @defgroup Defaults for POSIX message queue implementation.
  */
@@ -56,6 +103,10 @@
 #ifndef posixconfigMQ_MAX_SIZE
     #define posixconfigMQ_MAX_SIZE    128 /**< Maximum size (in bytes) of each message. */
 #endif
+
+#ifndef posixconfigMQ_HASH_BUCKETS
+    #define posixconfigMQ_HASH_BUCKETS    1 /**< Number of buckets used to look up mqs by name and by descriptor. */
+#endif
 /**@} */
 
 /**
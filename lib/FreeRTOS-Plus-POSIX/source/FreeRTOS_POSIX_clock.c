@@ -82,7 +82,12 @@ int clock_getres( clockid_t clock_id,
     if( res != NULL )
     {
         res->tv_sec = 0;
-        res->tv_nsec = NANOSECONDS_PER_TICK;
+
+        #if ( posixconfigUSE_HIGH_RESOLUTION_CLOCK == 1 )
+            res->tv_nsec = posixconfigHIGH_RESOLUTION_CLOCK_RESOLUTION_NS;
+        #else
+            res->tv_nsec = NANOSECONDS_PER_TICK;
+        #endif
     }
 
     return 0;
@@ -93,13 +98,16 @@ int clock_getres( clockid_t clock_id,
 int clock_gettime( clockid_t clock_id,
                    struct timespec * tp )
 {
-    TimeOut_t xCurrentTime = { 0 };
     int iStatus = 0;
 
-    /* Intermediate variable used to convert TimeOut_t to struct timespec.
-     * Also used to detect overflow issues. It must be unsigned because the
-     * behavior of signed integer overflow is undefined. */
-    uint64_t ullTickCount = 0ULL;
+    #if ( posixconfigUSE_HIGH_RESOLUTION_CLOCK == 0 )
+        TimeOut_t xCurrentTime = { 0 };
+
+        /* Intermediate variable used to convert TimeOut_t to struct timespec.
+         * Also used to detect overflow issues. It must be unsigned because the
+         * behavior of signed integer overflow is undefined. */
+        uint64_t ullTickCount = 0ULL;
+    #endif
 
     /* Silence warnings about unused parameters. */
     ( void ) clock_id;
@@ -112,22 +120,32 @@ int clock_gettime( clockid_t clock_id,
         iStatus = -1;
     }
 
-    if( iStatus == 0 )
-    {
-        /* Get the current tick count and overflow count. vTaskSetTimeOutState()
-         * is used to get these values because they are both static in tasks.c. */
-        vTaskSetTimeOutState( &xCurrentTime );
+    #if ( posixconfigUSE_HIGH_RESOLUTION_CLOCK == 1 )
+        if( iStatus == 0 )
+        {
+            /* The port's clock replaces the tick count. Deltas between its
+             * values are still converted to ticks for blocking calls, so it
+             * must run at the same rate as the tick. */
+            UTILS_NanosecondsToTimespec( ( int64_t ) posixconfigHIGH_RESOLUTION_CLOCK_NS(), tp );
+        }
+    #else
+        if( iStatus == 0 )
+        {
+            /* Get the current tick count and overflow count. vTaskSetTimeOutState()
+             * is used to get these values because they are both static in tasks.c. */
+            vTaskSetTimeOutState( &xCurrentTime );
 
-        /* Adjust the tick count for the number of times a TickType_t has overflowed.
-         * portMAX_DELAY should be the maximum value of a TickType_t. */
-        ullTickCount = ( uint64_t ) ( xCurrentTime.xOverflowCount ) << ( sizeof( TickType_t ) * 8 );
+            /* Adjust the tick count for the number of times a TickType_t has overflowed.
+             * portMAX_DELAY should be the maximum value of a TickType_t. */
+            ullTickCount = ( uint64_t ) ( xCurrentTime.xOverflowCount ) << ( sizeof( TickType_t ) * 8 );
 
-        /* Add the current tick count. */
-        ullTickCount += xCurrentTime.xTimeOnEntering;
+            /* Add the current tick count. */
+            ullTickCount += xCurrentTime.xTimeOnEntering;
 
-        /* Convert ullTickCount to timespec. */
-        UTILS_NanosecondsToTimespec( ( int64_t ) ullTickCount * NANOSECONDS_PER_TICK, tp );
-    }
+            /* Convert ullTickCount to timespec. */
+            UTILS_NanosecondsToTimespec( ( int64_t ) ullTickCount * NANOSECONDS_PER_TICK, tp );
+        }
+    #endif /* posixconfigUSE_HIGH_RESOLUTION_CLOCK */
 
     return iStatus;
 }
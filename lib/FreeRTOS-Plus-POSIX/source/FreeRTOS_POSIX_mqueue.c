@@ -51,11 +51,15 @@ typedef struct QueueElement
  * @brief Data structure of an mq.
  *
  * FreeRTOS isn't guaranteed to have a file-like abstraction, so message
- * queues in this implementation are stored as a linked list (in RAM).
+ * queues in this implementation are stored in linked lists (in RAM). Each
+ * queue is in one of posixconfigMQ_HASH_BUCKETS lists chosen by its name, and
+ * in one chosen by its descriptor, so that a lookup only walks the queues that
+ * share a bucket.
  */
 typedef struct QueueListElement
 {
-    Link_t xLink;              /**< Pointer to the next element in the list. */
+    Link_t xLink;              /**< Pointer to the next element in the name bucket. */
+    Link_t xDescriptorLink;    /**< Pointer to the next element in the descriptor bucket. */
     QueueHandle_t xQueue;      /**< FreeRTOS queue handle. */
     size_t xOpenDescriptors;   /**< Number of threads that have opened this queue. */
     char * pcName;             /**< Null-terminated queue name. */
@@ -104,6 +108,42 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
  */
 static void prvDeleteMessageQueue( const QueueListElement_t * const pxMessageQueue );
 
+/**
+ * @brief Add a queue to the buckets for its name and its descriptor.
+ *
+ * @param[in] pxMessageQueue The queue to add.
+ *
+ * @return nothing
+ */
+static void prvAddQueueToList( QueueListElement_t * const pxMessageQueue );
+
+/**
+ * @brief Remove a queue from the buckets for its name and its descriptor.
+ *
+ * @param[in] pxMessageQueue The queue to remove.
+ *
+ * @return nothing
+ */
+static void prvRemoveQueueFromList( QueueListElement_t * const pxMessageQueue );
+
+/**
+ * @brief Select the bucket for a queue name.
+ *
+ * @param[in] pcName The queue name.
+ *
+ * @return The head of the list of queues whose names share the bucket.
+ */
+static Link_t * prvNameBucket( const char * pcName );
+
+/**
+ * @brief Select the bucket for a queue descriptor.
+ *
+ * @param[in] xMessageQueueDescriptor The queue descriptor.
+ *
+ * @return The head of the list of queues whose descriptors share the bucket.
+ */
+static Link_t * prvDescriptorBucket( mqd_t xMessageQueueDescriptor );
+
 /**
  * @brief Attempt to find the queue identified by pcName or xMqId in the queue list.
  *
@@ -145,9 +185,14 @@ static BaseType_t prvValidateQueueName( const char * const pcName,
 static StaticSemaphore_t xQueueListMutex = { { 0 }, .u = { 0 } };
 
 /**
- * @brief Head of the linked list of queues.
+ * @brief Heads of the linked lists of queues, bucketed by name.
+ */
+static Link_t xQueueListHead[ posixconfigMQ_HASH_BUCKETS ] = { { 0 } };
+
+/**
+ * @brief Heads of the linked lists of queues, bucketed by descriptor.
  */
-static Link_t xQueueListHead = { 0 };
+static Link_t xQueueDescriptorListHead[ posixconfigMQ_HASH_BUCKETS ] = { { 0 } };
 
 /*-----------------------------------------------------------*/
 
@@ -262,7 +307,7 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
         ( *ppxMessageQueue )->xPendingUnlink = pdFALSE;
 
         /* Add the new queue to the list. */
-        listADD( &xQueueListHead, &( *ppxMessageQueue )->xLink );
+        prvAddQueueToList( *ppxMessageQueue );
     }
 
     return xStatus;
@@ -291,6 +336,49 @@ static void prvDeleteMessageQueue( const QueueListElement_t * const pxMessageQue
 
 /*-----------------------------------------------------------*/
 
+static void prvAddQueueToList( QueueListElement_t * const pxMessageQueue )
+{
+    listADD( prvNameBucket( pxMessageQueue->pcName ), &pxMessageQueue->xLink );
+    listADD( prvDescriptorBucket( ( mqd_t ) pxMessageQueue ), &pxMessageQueue->xDescriptorLink );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvRemoveQueueFromList( QueueListElement_t * const pxMessageQueue )
+{
+    listREMOVE( &pxMessageQueue->xLink );
+    listREMOVE( &pxMessageQueue->xDescriptorLink );
+}
+
+/*-----------------------------------------------------------*/
+
+static Link_t * prvNameBucket( const char * pcName )
+{
+    uint32_t ulHash = 2166136261UL;
+
+    /* FNV-1a. */
+    while( *pcName != '\0' )
+    {
+        ulHash = ( ulHash ^ ( uint8_t ) *pcName ) * 16777619UL;
+        pcName++;
+    }
+
+    return &xQueueListHead[ ulHash % posixconfigMQ_HASH_BUCKETS ];
+}
+
+/*-----------------------------------------------------------*/
+
+static Link_t * prvDescriptorBucket( mqd_t xMessageQueueDescriptor )
+{
+    /* Descriptors are the addresses of heap blocks, so the low bits carry no
+     * information. */
+    size_t xHash = ( size_t ) xMessageQueueDescriptor / sizeof( void * );
+
+    return &xQueueDescriptorListHead[ xHash % posixconfigMQ_HASH_BUCKETS ];
+}
+
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListElement,
                                       const char * const pcName,
                                       mqd_t xMessageQueueDescriptor )
@@ -299,20 +387,27 @@ static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListEl
     QueueListElement_t * pxMessageQueue = NULL;
     BaseType_t xQueueFound = pdFALSE;
 
-    /* Iterate through the list of queues. */
-    listFOR_EACH( pxQueueListLink, &xQueueListHead )
+    /* Match by name if provided. */
+    if( pcName != NULL )
     {
-        pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xLink );
-
-        /* Match by name first if provided. */
-        if( ( pcName != NULL ) && ( strcmp( pxMessageQueue->pcName, pcName ) == 0 ) )
+        listFOR_EACH( pxQueueListLink, prvNameBucket( pcName ) )
         {
-            xQueueFound = pdTRUE;
-            break;
+            pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xLink );
+
+            if( strcmp( pxMessageQueue->pcName, pcName ) == 0 )
+            {
+                xQueueFound = pdTRUE;
+                break;
+            }
         }
-        /* If name doesn't match, match by descriptor. */
-        else
+    }
+    /* Otherwise, match by descriptor. */
+    else
+    {
+        listFOR_EACH( pxQueueListLink, prvDescriptorBucket( xMessageQueueDescriptor ) )
         {
+            pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xDescriptorLink );
+
             if( ( mqd_t ) pxMessageQueue == xMessageQueueDescriptor )
             {
                 xQueueFound = pdTRUE;
@@ -349,9 +444,17 @@ static void prvInitializeQueueList( void )
          * section. */
         if( xQueueListInitialized == pdFALSE )
         {
-            /* Initialize the queue list mutex and list head. */
+            size_t xBucket = 0;
+
+            /* Initialize the queue list mutex and list heads. */
             ( void ) xSemaphoreCreateMutexStatic( &xQueueListMutex );
-            listINIT_HEAD( &xQueueListHead );
+
+            for( xBucket = 0; xBucket < posixconfigMQ_HASH_BUCKETS; xBucket++ )
+            {
+                listINIT_HEAD( &xQueueListHead[ xBucket ] );
+                listINIT_HEAD( &xQueueDescriptorListHead[ xBucket ] );
+            }
+
             xQueueListInitialized = pdTRUE;
         }
 
@@ -424,7 +527,7 @@ int mq_close( mqd_t mqdes )
              * remove the queue. */
             if( pxMessageQueue->xPendingUnlink == pdTRUE )
             {
-                listREMOVE( &pxMessageQueue->xLink );
+                prvRemoveQueueFromList( pxMessageQueue );
 
                 /* Set the flag to delete the queue. Deleting the queue is deferred
                  * until xQueueListMutex is released. */
@@ -857,7 +960,7 @@ int mq_unlink( const char * name )
              * remove it from the list. */
             if( pxMessageQueue->xOpenDescriptors == 0 )
             {
-                listREMOVE( &pxMessageQueue->xLink );
+                prvRemoveQueueFromList( pxMessageQueue );
 
                 /* Set the flag to delete the queue. Deleting the queue is deferred
                  * until xQueueListMutex is released. */
@@ -63,6 +63,10 @@ typedef struct pthread_internal
     StaticSemaphore_t xJoinBarrier;       /**< Synchronizes the two callers of pthread_join. */
     StaticSemaphore_t xJoinMutex;         /**< Ensures that only one other thread may join this thread. */
     void * xReturn;                       /**< Return value of pvStartRoutine. */
+    #if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+        BaseType_t xReusable;             /**< pdTRUE if the task returned from pvStartRoutine and can run another pthread. */
+        struct pthread_internal * pxNextIdle; /**< Next pthread in the pool of idle pthreads. */
+    #endif
 } pthread_internal_t;
 
 /**
@@ -71,9 +75,61 @@ typedef struct pthread_internal
  * For joinable threads, this function waits for pthread_join. Otherwise,
  * it deletes the thread and frees up resources used by the thread.
  *
- * @return This function does not return.
+ * @param[in] xReusable pdTRUE if the thread returned from its start routine,
+ * in which case its task may be kept in the pool of idle threads.
+ *
+ * @return This function only returns if the task was kept and has been given
+ * another start routine to run.
+ */
+static void prvExitThread( BaseType_t xReusable );
+
+#if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+
+/**
+ * @brief Adds a finished thread to the pool of idle threads, if there is room.
+ *
+ * @param[in] pxThread The finished thread.
+ *
+ * @return pdTRUE if the thread was added; pdFALSE otherwise.
  */
-static void prvExitThread( void );
+    static BaseType_t prvPoolThread( pthread_internal_t * pxThread );
+
+/**
+ * @brief Removes an idle thread with the given stack size from the pool.
+ *
+ * @param[in] usStackSize The stack size required.
+ *
+ * @return The thread, or NULL if there is none.
+ */
+    static pthread_internal_t * prvTakeIdleThread( uint16_t usStackSize );
+
+/**
+ * @brief Blocks a finished thread until pthread_create gives it a new start
+ * routine.
+ *
+ * @param[in] pxThread The calling thread.
+ *
+ * @return nothing
+ */
+    static void prvWaitForStartRoutine( const pthread_internal_t * pxThread );
+
+/**
+ * @brief Starts a new thread on the task of an idle thread.
+ *
+ * @param[in] pxThread The idle thread, removed from the pool.
+ * @param[out] thread Set to the new thread.
+ * @param[in] attr Attributes of the new thread, or NULL.
+ * @param[in] startroutine Start routine of the new thread.
+ * @param[in] arg Argument of startroutine.
+ *
+ * @return nothing
+ */
+    static void prvReuseThread( pthread_internal_t * pxThread,
+                                pthread_t * thread,
+                                const pthread_attr_t * attr,
+                                void *( *startroutine )( void * ),
+                                void * arg );
+#endif
 
 /**
  * @brief Wrapper function for the user's thread routine.
@@ -94,23 +150,165 @@ static const pthread_attr_internal_t xDefaultThreadAttributes =
     .usSchedPriorityDetachState = ( ( uint16_t ) tskIDLE_PRIORITY & pthreadSCHED_PRIORITY_MASK) | ( PTHREAD_CREATE_JOINABLE << pthreadDETACH_STATE_SHIFT ),
 };
 
+#if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+
+/**
+ * @brief Idle threads that pthread_create can reuse.
+ */
+    static pthread_internal_t * pxIdleThreads = NULL;
+
+/**
+ * @brief The number of threads in pxIdleThreads.
+ */
+    static UBaseType_t uxIdleThreadCount = 0;
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+
+    static BaseType_t prvPoolThread( pthread_internal_t * pxThread )
+    {
+        BaseType_t xPooled = pdFALSE;
+
+        vTaskSuspendAll();
+
+        if( uxIdleThreadCount < posixconfigPTHREAD_POOL_SIZE )
+        {
+            /* The task waits for a new start routine to be set. */
+            pxThread->pvStartRoutine = NULL;
+            pxThread->pxNextIdle = pxIdleThreads;
+            pxIdleThreads = pxThread;
+            uxIdleThreadCount++;
+            xPooled = pdTRUE;
+        }
+
+        ( void ) xTaskResumeAll();
+
+        return xPooled;
+    }
+
 /*-----------------------------------------------------------*/
 
-static void prvExitThread( void )
+    static pthread_internal_t * prvTakeIdleThread( uint16_t usStackSize )
+    {
+        pthread_internal_t * pxThread = NULL;
+        pthread_internal_t ** ppxLink = &pxIdleThreads;
+
+        vTaskSuspendAll();
+
+        while( *ppxLink != NULL )
+        {
+            if( ( *ppxLink )->xAttr.usStackSize == usStackSize )
+            {
+                pxThread = *ppxLink;
+                *ppxLink = pxThread->pxNextIdle;
+                uxIdleThreadCount--;
+                break;
+            }
+
+            ppxLink = &( ( *ppxLink )->pxNextIdle );
+        }
+
+        ( void ) xTaskResumeAll();
+
+        return pxThread;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void prvWaitForStartRoutine( const pthread_internal_t * pxThread )
+    {
+        /* pthread_create sets the start routine before notifying the task, so
+         * a notification left over from before the thread finished is
+         * ignored. */
+        while( pxThread->pvStartRoutine == NULL )
+        {
+            ( void ) ulTaskNotifyTakeIndexed( posixconfigNOTIFICATION_INDEX, pdTRUE, portMAX_DELAY );
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void prvReuseThread( pthread_internal_t * pxThread,
+                                pthread_t * thread,
+                                const pthread_attr_t * attr,
+                                void *( *startroutine )( void * ),
+                                void * arg )
+    {
+        /* The stack size already matches; only the other attributes change. */
+        pxThread->xAttr = ( attr == NULL ) ? xDefaultThreadAttributes : *( ( pthread_attr_internal_t * ) ( attr ) );
+        pxThread->xTaskArg = arg;
+
+        if( pthreadIS_JOINABLE( pxThread->xAttr.usSchedPriorityDetachState ) )
+        {
+            /* These calls will not fail when their arguments aren't NULL. */
+            ( void ) xSemaphoreCreateMutexStatic( &pxThread->xJoinMutex );
+            ( void ) xSemaphoreCreateBinaryStatic( &pxThread->xJoinBarrier );
+        }
+
+        vTaskPrioritySet( pxThread->xTaskHandle,
+                          ( UBaseType_t ) pthreadGET_SCHED_PRIORITY( pxThread->xAttr.usSchedPriorityDetachState ) );
+
+        *thread = ( pthread_t ) pxThread;
+
+        /* Setting the start routine last releases the idle task. */
+        pxThread->pvStartRoutine = startroutine;
+        ( void ) xTaskNotifyGiveIndexed( pxThread->xTaskHandle, posixconfigNOTIFICATION_INDEX );
+    }
+
+/*-----------------------------------------------------------*/
+
+#endif /* posixconfigPTHREAD_POOL_SIZE > 0 */
+
+static void prvExitThread( BaseType_t xReusable )
 {
     pthread_internal_t * pxThread = ( pthread_internal_t * ) pthread_self();
 
+    #if ( posixconfigPTHREAD_POOL_SIZE == 0 )
+        ( void ) xReusable;
+    #endif
+
     /* If this thread is joinable, wait for a call to pthread_join. */
     if( pthreadIS_JOINABLE( pxThread->xAttr.usSchedPriorityDetachState ) )
     {
+        #if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+            /* Tell pthread_join whether it may pool this thread. */
+            pxThread->xReusable = xReusable;
+
+            if( xReusable == pdTRUE )
+            {
+                pxThread->pvStartRoutine = NULL;
+            }
+        #endif
+
         ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxThread->xJoinBarrier );
 
         /* Suspend until the call to pthread_join. The caller of pthread_join
-         * will perform cleanup. */
+         * will perform cleanup. A reusable task is instead told by
+         * pthread_create when it has been given another start routine. */
+        #if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+            if( xReusable == pdTRUE )
+            {
+                prvWaitForStartRoutine( pxThread );
+
+                return;
+            }
+        #endif
+
         vTaskSuspend( NULL );
     }
     else
     {
+        #if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+            if( ( xReusable == pdTRUE ) && ( prvPoolThread( pxThread ) == pdTRUE ) )
+            {
+                prvWaitForStartRoutine( pxThread );
+
+                return;
+            }
+        #endif
+
         /* For a detached thread, perform cleanup of thread object. */
         vPortFree( pxThread );
         vTaskDelete( NULL );
@@ -123,11 +321,15 @@ static void prvRunThread( void * pxArg )
 {
     pthread_internal_t * pxThread = ( pthread_internal_t * ) pxArg;
 
-    /* Run the thread routine. */
-    pxThread->xReturn = pxThread->pvStartRoutine( ( void * ) pxThread->xTaskArg );
+    for( ; ; )
+    {
+        /* Run the thread routine. */
+        pxThread->xReturn = pxThread->pvStartRoutine( ( void * ) pxThread->xTaskArg );
 
-    /* Exit once finished. This function does not return. */
-    prvExitThread();
+        /* Exit once finished. This function only returns if this task has been
+         * reused for another thread. */
+        prvExitThread( pdTRUE );
+    }
 }
 
 /*-----------------------------------------------------------*/
@@ -293,17 +495,32 @@ int pthread_create( pthread_t * thread,
     int iStatus = 0;
     pthread_internal_t * pxThread = NULL;
     struct sched_param xSchedParam  = { .sched_priority = tskIDLE_PRIORITY };
+    BaseType_t xReused = pdFALSE;
 
-    /* Allocate memory for new thread object. */
-    pxThread = ( pthread_internal_t * ) pvPortMalloc( sizeof( pthread_internal_t ) );
+    #if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+        /* Reuse an idle thread with the same stack size, if there is one. */
+        pxThread = prvTakeIdleThread( ( attr == NULL ) ? xDefaultThreadAttributes.usStackSize :
+                                      ( ( pthread_attr_internal_t * ) ( attr ) )->usStackSize );
 
-    if( pxThread == NULL )
+        if( pxThread != NULL )
+        {
+            prvReuseThread( pxThread, thread, attr, startroutine, arg );
+            xReused = pdTRUE;
+        }
+        else
+    #endif
     {
-        /* No memory. */
-        iStatus = EAGAIN;
+        /* Allocate memory for new thread object. */
+        pxThread = ( pthread_internal_t * ) pvPortMalloc( sizeof( pthread_internal_t ) );
+
+        if( pxThread == NULL )
+        {
+            /* No memory. */
+            iStatus = EAGAIN;
+        }
     }
 
-    if( iStatus == 0 )
+    if( ( iStatus == 0 ) && ( xReused == pdFALSE ) )
     {
         /* No attributes given, use default attributes. */
         if( attr == NULL )
@@ -334,7 +551,7 @@ int pthread_create( pthread_t * thread,
         }
     }
 
-    if( iStatus == 0 )
+    if( ( iStatus == 0 ) && ( xReused == pdFALSE ) )
     {
         /* Suspend all tasks to create a critical section. This ensures that
          * the new thread doesn't exit before a tag is assigned. */
@@ -408,8 +625,9 @@ void pthread_exit( void * value_ptr )
     /* Set the return value. */
     pxThread->xReturn = value_ptr;
 
-    /* Exit this thread. */
-    prvExitThread();
+    /* Exit this thread. The task can't be reused, as the stack of the start
+     * routine can't be unwound. */
+    prvExitThread( pdFALSE );
 }
 
 /*-----------------------------------------------------------*/
@@ -465,17 +683,26 @@ int pthread_join( pthread_t pthread,
         ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxThread->xJoinMutex );
         vSemaphoreDelete( ( SemaphoreHandle_t ) &pxThread->xJoinMutex );
 
-        /* Delete the FreeRTOS task that ran the thread. */
-        vTaskDelete( pxThread->xTaskHandle );
-
         /* Set the return value. */
         if( retval != NULL )
         {
             *retval = pxThread->xReturn;
         }
 
-        /* Free the thread object. */
-        vPortFree( pxThread );
+        #if ( posixconfigPTHREAD_POOL_SIZE > 0 )
+            if( ( pxThread->xReusable == pdTRUE ) && ( prvPoolThread( pxThread ) == pdTRUE ) )
+            {
+                /* The task is kept, waiting for pthread_create. */
+            }
+            else
+        #endif
+        {
+            /* Delete the FreeRTOS task that ran the thread. */
+            vTaskDelete( pxThread->xTaskHandle );
+
+            /* Free the thread object. */
+            vPortFree( pxThread );
+        }
 
         /* End the critical section. */
         xTaskResumeAll();
@@ -37,25 +37,96 @@
 #include "FreeRTOS_POSIX/pthread.h"
 
 /*
- * Barriers are implemented on FreeRTOS event groups, of which 8 bits are usable
- * when configUSE_16_BIT_TICKS is 1. Otherwise, 24 bits are usable.
+ * Barriers are sense-reversing: each thread that enters adds one to an
+ * arrival counter, and the thread that completes the count opens the barrier
+ * for the current phase with a single event group operation that releases
+ * every waiter at once. The phase then flips so the barrier can be reused
+ * straight away. Only two event group bits are used, one per phase, so the
+ * number of threads is not limited by the width of the event group.
  */
-#if ( configUSE_16_BIT_TICKS == 1 )
-    #define posixPTHREAD_BARRIER_MAX_COUNT        ( 8 )
+#define posixPTHREAD_BARRIER_PHASE_BIT( uPhase )    ( ( EventBits_t ) 1 << ( uPhase ) )
+
+/*
+ * Use the compiler's atomics where they are lock-free on the target.
+ * Otherwise a critical section covers the arrival.
+ */
+#if defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+    #define posixPTHREAD_BARRIER_LOAD( puValue ) \
+    __atomic_load_n( ( puValue ), __ATOMIC_ACQUIRE )
+    #define posixPTHREAD_BARRIER_STORE( puValue, uValue ) \
+    __atomic_store_n( ( puValue ), ( uValue ), __ATOMIC_RELEASE )
+    #define posixPTHREAD_BARRIER_INCREMENT( puValue ) \
+    __atomic_add_fetch( ( puValue ), 1U, __ATOMIC_ACQ_REL )
 #else
-    #define posixPTHREAD_BARRIER_MAX_COUNT        ( 24 )
+    #define posixPTHREAD_BARRIER_LOAD( puValue )             prvBarrierLoad( puValue )
+    #define posixPTHREAD_BARRIER_STORE( puValue, uValue )    prvBarrierStore( ( puValue ), ( uValue ) )
+    #define posixPTHREAD_BARRIER_INCREMENT( puValue )        prvBarrierIncrement( puValue )
 #endif
 
 /*-----------------------------------------------------------*/
 
+#if !defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+
+/**
+ * @brief Read a barrier member that other threads may be changing.
+ */
+    static unsigned prvBarrierLoad( unsigned * puValue )
+    {
+        unsigned uValue = 0;
+
+        taskENTER_CRITICAL();
+        {
+            uValue = *puValue;
+        }
+        taskEXIT_CRITICAL();
+
+        return uValue;
+    }
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a barrier member that other threads may be reading.
+ */
+    static void prvBarrierStore( unsigned * puValue,
+                                 unsigned uValue )
+    {
+        taskENTER_CRITICAL();
+        {
+            *puValue = uValue;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add one to a barrier member and return its new value.
+ */
+    static unsigned prvBarrierIncrement( unsigned * puValue )
+    {
+        unsigned uValue = 0;
+
+        taskENTER_CRITICAL();
+        {
+            ( *puValue )++;
+            uValue = *puValue;
+        }
+        taskEXIT_CRITICAL();
+
+        return uValue;
+    }
+
+#endif /* if !defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 ) */
+
+/*-----------------------------------------------------------*/
+
 int pthread_barrier_destroy( pthread_barrier_t * barrier )
 {
     pthread_barrier_internal_t * pxBarrier = ( pthread_barrier_internal_t * ) ( barrier );
 
     /* Free all resources used by the barrier. */
     ( void ) vEventGroupDelete( ( EventGroupHandle_t ) &pxBarrier->xBarrierEventGroup );
-    ( void ) vSemaphoreDelete( ( SemaphoreHandle_t ) &pxBarrier->xThreadCountMutex );
-    ( void ) vSemaphoreDelete( ( SemaphoreHandle_t ) &pxBarrier->xThreadCountSemaphore );
 
     return 0;
 }
@@ -78,37 +149,16 @@ int pthread_barrier_init( pthread_barrier_t * barrier,
         iStatus = EINVAL;
     }
 
-    /* Ensure that count will fit in a FreeRTOS event group. */
     if( iStatus == 0 )
     {
-        if( count > posixPTHREAD_BARRIER_MAX_COUNT )
-        {
-            /* No memory exists in the event group for more than
-             * posixPTHREAD_BARRIER_MAX_COUNT threads. */
-            iStatus = ENOMEM;
-        }
-    }
-
-    if( iStatus == 0 )
-    {
-        /* Set the current thread count and threshold. */
+        /* Set the current thread count, threshold and phase. */
         pxNewBarrier->uThreadCount = 0;
         pxNewBarrier->uThreshold = count;
+        pxNewBarrier->uPhase = 0;
 
         /* Create the FreeRTOS event group. This call will not fail when its
-         * argument isn't NULL. */
+         * argument isn't NULL. Both phase bits start clear. */
         ( void ) xEventGroupCreateStatic( &pxNewBarrier->xBarrierEventGroup );
-
-        /* Create the mutex that guards access to uThreadCount. This call
-         * will not fail when its argument isn't NULL. */
-        ( void ) xSemaphoreCreateMutexStatic( &pxNewBarrier->xThreadCountMutex );
-
-        /* Create the semaphore that prevents more than count threads from being
-         * unblocked by a single successful pthread_barrier_wait. This semaphore
-         * counts down from count and cannot decrement below 0. */
-        ( void ) xSemaphoreCreateCountingStatic( ( UBaseType_t ) count, /* Max count. */
-                                                 ( UBaseType_t ) count, /* Initial count. */
-                                                 &pxNewBarrier->xThreadCountSemaphore );
     }
 
     return iStatus;
@@ -119,56 +169,49 @@ int pthread_barrier_init( pthread_barrier_t * barrier,
 int pthread_barrier_wait( pthread_barrier_t * barrier )
 {
     int iStatus = 0;
-    unsigned i = 0; /* Loop iterator. */
     pthread_barrier_internal_t * pxBarrier = ( pthread_barrier_internal_t * ) ( barrier );
+    unsigned uPhase = 0;
     unsigned uThreadNumber = 0;
 
-    /* Decrement the number of threads waiting on this barrier. This will prevent more
-     * than pxBarrier->uThreshold threads from being unblocked by a single successful
-     * pthread_barrier_wait call.
-     *
-     * This call will never fail because it blocks forever.
-     */
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &pxBarrier->xThreadCountSemaphore, portMAX_DELAY );
-
-    /* Lock the mutex so that this thread can change uThreadCount. This call will
-     * never fail because it blocks forever.*/
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &pxBarrier->xThreadCountMutex, portMAX_DELAY );
+    /* Read the phase before arriving. It cannot flip until this thread has
+     * arrived, because the barrier only opens once uThreshold threads have. */
+    uPhase = posixPTHREAD_BARRIER_LOAD( &pxBarrier->uPhase );
 
     /* Increment thread count. This is the order that this thread entered the
      * barrier, i.e. uThreadNumber-1 threads entered the barrier before this one. */
-    pxBarrier->uThreadCount++;
-    uThreadNumber = pxBarrier->uThreadCount;
+    uThreadNumber = posixPTHREAD_BARRIER_INCREMENT( &pxBarrier->uThreadCount );
     configASSERT( uThreadNumber > 0 );
 
-    /* Unlock the thread count mutex to allow other threads to change thread count.
-     * This call will never fail because xThreadCountMutex is owned by this thread. */
-    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxBarrier->xThreadCountMutex );
-
-    /* Set the bit in the event group representing this thread, then wait for the other
-     * threads to set their bit. This call should wait forever until all threads have set
-     * their bit, so the return value is ignored. */
-    ( void ) xEventGroupSync( ( EventGroupHandle_t ) &pxBarrier->xBarrierEventGroup,
-                              1 << ( uThreadNumber - 1 ),         /* Which bit in the event group to set. */
-                              ( 1 << pxBarrier->uThreshold ) - 1, /* Wait for all threads to set their bits. */
-                              portMAX_DELAY );
-
-    /* The first thread to enter the barrier gets PTHREAD_BARRIER_SERIAL_THREAD as its
-     * return value and resets xThreadCountSemaphore. */
-    if( uThreadNumber == 1 )
+    /* The last thread to enter the barrier gets PTHREAD_BARRIER_SERIAL_THREAD as
+     * its return value and opens the barrier. */
+    if( uThreadNumber == pxBarrier->uThreshold )
     {
         iStatus = PTHREAD_BARRIER_SERIAL_THREAD;
 
-        /* uThreadCount can be safely changed without locking xThreadCountMutex
-         * because xThreadCountSemaphore is currently 0. */
-        pxBarrier->uThreadCount = 0;
-
-        /* Reset xThreadCountSemaphore. This allows more threads to enter the
-         * barrier, starting a new cycle. */
-        for( i = 0; i < pxBarrier->uThreshold; i++ )
-        {
-            xSemaphoreGive( ( SemaphoreHandle_t ) &pxBarrier->xThreadCountSemaphore );
-        }
+        /* Prepare the next phase before publishing it. No thread can enter the
+         * next phase yet, as every other thread is still waiting on this one.
+         * The bit of the next phase was set when that phase last opened; every
+         * thread released then has entered this phase since, so none still
+         * needs it. */
+        posixPTHREAD_BARRIER_STORE( &pxBarrier->uThreadCount, 0U );
+        ( void ) xEventGroupClearBits( ( EventGroupHandle_t ) &pxBarrier->xBarrierEventGroup,
+                                       posixPTHREAD_BARRIER_PHASE_BIT( uPhase ^ 1U ) );
+        posixPTHREAD_BARRIER_STORE( &pxBarrier->uPhase, uPhase ^ 1U );
+
+        /* Release all the threads waiting on this phase at once. */
+        ( void ) xEventGroupSetBits( ( EventGroupHandle_t ) &pxBarrier->xBarrierEventGroup,
+                                     posixPTHREAD_BARRIER_PHASE_BIT( uPhase ) );
+    }
+    else
+    {
+        /* Wait for the last thread of this phase to open the barrier. The bit
+         * is not cleared on exit so that every waiter sees it. This call waits
+         * forever, so the return value is ignored. */
+        ( void ) xEventGroupWaitBits( ( EventGroupHandle_t ) &pxBarrier->xBarrierEventGroup,
+                                      posixPTHREAD_BARRIER_PHASE_BIT( uPhase ),
+                                      pdFALSE, /* Leave the bit set for the other waiters. */
+                                      pdTRUE,
+                                      portMAX_DELAY );
     }
 
     return iStatus;
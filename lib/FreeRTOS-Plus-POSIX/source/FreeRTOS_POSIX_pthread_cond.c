@@ -28,81 +28,129 @@
  * @brief Implementation of condition variable functions in pthread.h
  */
 
-/* C standard library includes. */
-#include <limits.h>
-
 /* FreeRTOS+POSIX includes. */
 #include "FreeRTOS_POSIX.h"
 #include "FreeRTOS_POSIX/errno.h"
 #include "FreeRTOS_POSIX/pthread.h"
 #include "FreeRTOS_POSIX/utils.h"
 
+/* Waiting threads are woken with direct to task notifications. */
+#if ( configUSE_TASK_NOTIFICATIONS != 1 )
+    #error FreeRTOS+POSIX condition variables require configUSE_TASK_NOTIFICATIONS to be 1.
+#endif
+
+/**
+ * @brief Add a waiter to a cond.
+ *
+ * Waiters are kept in order of decreasing priority, and in order of arrival
+ * among waiters of equal priority, so signals wake threads in the same order
+ * a FreeRTOS semaphore would. Must be called in a critical section.
+ * @param[in] pxCond The cond to wait on.
+ * @param[in] pxWaiter The waiter to add.
+ *
+ * @return nothing
+ */
+static void prvAddWaiter( pthread_cond_internal_t * pxCond,
+                          pthread_cond_waiter_t * pxWaiter );
+
+/**
+ * @brief Remove a waiter that timed out from a cond.
+ *
+ * Must be called in a critical section.
+ * @param[in] pxCond The cond the waiter was waiting on.
+ * @param[in] pxWaiter The waiter to remove.
+ *
+ * @return nothing
+ */
+static void prvRemoveWaiter( pthread_cond_internal_t * pxCond,
+                             pthread_cond_waiter_t * pxWaiter );
+
 /**
- * @brief Initialize a PTHREAD_COND_INITIALIZER cond.
+ * @brief Unblock a waiter that was removed from a cond.
  *
- * PTHREAD_COND_INITIALIZER sets a flag for a cond to be initialized later.
- * This function performs the initialization.
- * @param[in] pxCond The cond to initialize.
+ * Must be called in a critical section. The waiter must not be accessed
+ * afterwards, as it lives on the stack of the thread being woken.
+ * @param[in] pxWaiter The waiter to wake.
  *
  * @return nothing
  */
-static void prvInitializeStaticCond( pthread_cond_internal_t * pxCond );
+static void prvWakeWaiter( pthread_cond_waiter_t * pxWaiter );
 
 /*-----------------------------------------------------------*/
 
-static void prvInitializeStaticCond( pthread_cond_internal_t * pxCond )
+static void prvAddWaiter( pthread_cond_internal_t * pxCond,
+                          pthread_cond_waiter_t * pxWaiter )
 {
-    /* Check if the condition variable needs to be initialized. */
-    if( pxCond->xIsInitialized == pdFALSE )
+    pthread_cond_waiter_t * volatile * ppxLink = &pxCond->pxWaiters;
+
+    /* Skip all waiters of higher or equal priority. */
+    while( ( *ppxLink != NULL ) && ( ( *ppxLink )->uxPriority >= pxWaiter->uxPriority ) )
     {
-        /* Cond initialization must be in a critical section to prevent two threads
-         * from initializing it at the same time. */
-        taskENTER_CRITICAL();
+        ppxLink = &( *ppxLink )->pxNext;
+    }
 
-        /* Check again that the cond is still uninitialized, i.e. it wasn't
-         * initialized while this function was waiting to enter the critical
-         * section. */
-        if( pxCond->xIsInitialized == pdFALSE )
-        {
-            /* Set the members of the cond. The semaphore create calls will never fail
-             * when their arguments aren't NULL. */
-            pxCond->xIsInitialized = pdTRUE;
-            ( void ) xSemaphoreCreateMutexStatic( &pxCond->xCondMutex );
-            ( void ) xSemaphoreCreateCountingStatic( INT_MAX, 0U, &pxCond->xCondWaitSemaphore );
-            pxCond->iWaitingThreads = 0;
-        }
+    pxWaiter->pxNext = *ppxLink;
+    *ppxLink = pxWaiter;
+}
 
-        /* Exit the critical section. */
-        taskEXIT_CRITICAL();
+/*-----------------------------------------------------------*/
+
+static void prvRemoveWaiter( pthread_cond_internal_t * pxCond,
+                             pthread_cond_waiter_t * pxWaiter )
+{
+    pthread_cond_waiter_t * volatile * ppxLink = &pxCond->pxWaiters;
+
+    while( ( *ppxLink != NULL ) && ( *ppxLink != pxWaiter ) )
+    {
+        ppxLink = &( *ppxLink )->pxNext;
+    }
+
+    if( *ppxLink != NULL )
+    {
+        *ppxLink = pxWaiter->pxNext;
     }
 }
 
 /*-----------------------------------------------------------*/
 
-int pthread_cond_broadcast( pthread_cond_t * cond )
+static void prvWakeWaiter( pthread_cond_waiter_t * pxWaiter )
 {
-    int i = 0;
-    pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
+    TaskHandle_t xTask = pxWaiter->xTask;
 
-    /* If the cond is uninitialized, perform initialization. */
-    prvInitializeStaticCond( pxCond );
+    /* Once xSignaled is set, the waiter no longer touches the cond. It cannot
+     * return before this critical section exits, so notifying it is safe. */
+    pxWaiter->xSignaled = pdTRUE;
+    ( void ) xTaskNotifyGiveIndexed( xTask, posixconfigNOTIFICATION_INDEX );
+}
 
-    /* Lock xCondMutex to protect access to iWaitingThreads.
-     * This call will never fail because it blocks forever. */
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &pxCond->xCondMutex, portMAX_DELAY );
+/*-----------------------------------------------------------*/
 
-    /* Unblock all threads waiting on this condition variable. */
-    for( i = 0; i < pxCond->iWaitingThreads; i++ )
+int pthread_cond_broadcast( pthread_cond_t * cond )
+{
+    pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
+    pthread_cond_waiter_t * pxWaiter = NULL;
+    pthread_cond_waiter_t * pxNext = NULL;
+
+    /* Nothing to do if no thread is waiting. */
+    if( pxCond->pxWaiters != NULL )
     {
-        ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore );
+        /* Detach the whole list of waiters and unblock every thread on it in
+         * a single critical section. */
+        taskENTER_CRITICAL();
+        {
+            pxWaiter = pxCond->pxWaiters;
+            pxCond->pxWaiters = NULL;
+
+            while( pxWaiter != NULL )
+            {
+                pxNext = pxWaiter->pxNext;
+                prvWakeWaiter( pxWaiter );
+                pxWaiter = pxNext;
+            }
+        }
+        taskEXIT_CRITICAL();
     }
 
-    /* All threads were unblocked, set waiting threads to 0. */
-    pxCond->iWaitingThreads = 0;
-
-    /* Release xCondMutex. */
-    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondMutex );
-
     return 0;
 }
 
@@ -110,11 +158,8 @@ int pthread_cond_broadcast( pthread_cond_t * cond )
 
 int pthread_cond_destroy( pthread_cond_t * cond )
 {
-    pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
-
-    /* Free all resources in use by the cond. */
-    vSemaphoreDelete( ( SemaphoreHandle_t ) &pxCond->xCondMutex );
-    vSemaphoreDelete( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore );
+    /* A cond holds no kernel resources. */
+    ( void ) cond;
 
     return 0;
 }
@@ -137,12 +182,8 @@ int pthread_cond_init( pthread_cond_t * cond,
 
     if( iStatus == 0 )
     {
-        /* Set the members of the cond. The semaphore create calls will never fail
-         * when their arguments aren't NULL. */
-        pxCond->xIsInitialized = pdTRUE;
-        ( void ) xSemaphoreCreateMutexStatic( &pxCond->xCondMutex );
-        ( void ) xSemaphoreCreateCountingStatic( INT_MAX, 0U, &pxCond->xCondWaitSemaphore );
-        pxCond->iWaitingThreads = 0;
+        /* A cond with no waiters needs no other state. */
+        pxCond->pxWaiters = NULL;
     }
 
     return iStatus;
@@ -153,29 +194,24 @@ int pthread_cond_init( pthread_cond_t * cond,
 int pthread_cond_signal( pthread_cond_t * cond )
 {
     pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
-
-    /* If the cond is uninitialized, perform initialization. */
-    prvInitializeStaticCond( pxCond );
+    pthread_cond_waiter_t * pxWaiter = NULL;
 
     /* Check that at least one thread is waiting for a signal. */
-    if( pxCond->iWaitingThreads > 0 )
+    if( pxCond->pxWaiters != NULL )
     {
-        /* Lock xCondMutex to protect access to iWaitingThreads.
-         * This call will never fail because it blocks forever. */
-        ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &pxCond->xCondMutex, portMAX_DELAY );
-
-        /* Check again that at least one thread is waiting for a signal after
-         * taking xCondMutex. If so, unblock it. */
-        if( pxCond->iWaitingThreads > 0 )
+        taskENTER_CRITICAL();
         {
-            ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore );
-
-            /* Decrease the number of waiting threads. */
-            pxCond->iWaitingThreads--;
+            /* Check again that at least one thread is waiting for a signal
+             * after entering the critical section. If so, unblock it. */
+            pxWaiter = pxCond->pxWaiters;
+
+            if( pxWaiter != NULL )
+            {
+                pxCond->pxWaiters = pxWaiter->pxNext;
+                prvWakeWaiter( pxWaiter );
+            }
         }
-
-        /* Release xCondMutex. */
-        ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondMutex );
+        taskEXIT_CRITICAL();
     }
 
     return 0;
@@ -189,10 +225,9 @@ int pthread_cond_timedwait( pthread_cond_t * cond,
 {
     int iStatus = 0;
     pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
+    pthread_cond_waiter_t xWaiter = { 0 };
     TickType_t xDelay = portMAX_DELAY;
-
-    /* If the cond is uninitialized, perform initialization. */
-    prvInitializeStaticCond( pxCond );
+    TimeOut_t xTimeOut = { 0 };
 
     /* Convert abstime to a delay in TickType_t if provided. */
     if( abstime != NULL )
@@ -210,35 +245,74 @@ int pthread_cond_timedwait( pthread_cond_t * cond,
         }
     }
 
-    /* Increase the counter of threads blocking on condition variable, then
-     * unlock mutex. */
+    /* Add this thread to the waiters of the condition variable, then unlock
+     * mutex. */
     if( iStatus == 0 )
     {
-        ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &pxCond->xCondMutex, portMAX_DELAY );
-        pxCond->iWaitingThreads++;
-        ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondMutex );
+        xWaiter.xTask = xTaskGetCurrentTaskHandle();
+        xWaiter.uxPriority = uxTaskPriorityGet( NULL );
+        xWaiter.xSignaled = pdFALSE;
+
+        /* Discard any notification left over from an earlier wait. */
+        ( void ) ulTaskNotifyTakeIndexed( posixconfigNOTIFICATION_INDEX, pdTRUE, 0 );
+
+        taskENTER_CRITICAL();
+        {
+            prvAddWaiter( pxCond, &xWaiter );
+        }
+        taskEXIT_CRITICAL();
 
         iStatus = pthread_mutex_unlock( mutex );
+
+        if( iStatus != 0 )
+        {
+            taskENTER_CRITICAL();
+            {
+                prvRemoveWaiter( pxCond, &xWaiter );
+            }
+            taskEXIT_CRITICAL();
+        }
     }
 
     /* Wait on the condition variable. */
     if( iStatus == 0 )
     {
-        if( xSemaphoreTake( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore,
-                            xDelay ) == pdPASS )
+        vTaskSetTimeOutState( &xTimeOut );
+
+        while( xWaiter.xSignaled == pdFALSE )
+        {
+            ( void ) ulTaskNotifyTakeIndexed( posixconfigNOTIFICATION_INDEX, pdTRUE, xDelay );
+
+            /* Stop waiting once the timeout expires. A notification from
+             * another source only restarts the wait for the time remaining. */
+            if( ( xWaiter.xSignaled == pdFALSE ) &&
+                ( xTaskCheckForTimeOut( &xTimeOut, &xDelay ) == pdTRUE ) )
+            {
+                break;
+            }
+        }
+
+        /* A waiter that was signaled has already been removed from the list.
+         * Checking both in the same critical section ensures a signal that
+         * races with the timeout is never lost. */
+        taskENTER_CRITICAL();
+        {
+            if( xWaiter.xSignaled == pdFALSE )
+            {
+                prvRemoveWaiter( pxCond, &xWaiter );
+                iStatus = ETIMEDOUT;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        /* Relock mutex. */
+        if( iStatus == 0 )
         {
-            /* When successful, relock mutex. */
             iStatus = pthread_mutex_lock( mutex );
         }
         else
         {
-            /* Timeout. Relock mutex and decrement number of waiting threads. */
-            iStatus = ETIMEDOUT;
             ( void ) pthread_mutex_lock( mutex );
-
-            ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &pxCond->xCondMutex, portMAX_DELAY );
-            pxCond->iWaitingThreads--;
-            ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondMutex );
         }
     }
 
@@ -143,6 +143,191 @@ from the FreeRTOSIPConfig.h configuration header file. */
 		#define	ipconfigTCP_WIN_SEG_COUNT		( 256 )
 	#endif
 
+	/* When non-zero, and ipconfigUSE_TCP_WIN is 1, each TCP connection keeps
+	a congestion window (slow start, congestion avoidance and loss recovery)
+	which limits the amount of outstanding data.  The algorithm is pluggable:
+	NewReno is used unless FREERTOS_SO_TCP_CONGESTION_CONTROL selects another
+	one.  When zero, only the transmission window set with
+	FREERTOS_SO_WIN_PROPERTIES limits the outstanding data. */
+	#ifndef ipconfigUSE_TCP_CONGESTION_CONTROL
+		#define ipconfigUSE_TCP_CONGESTION_CONTROL	( 0 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_CONGESTION_CONTROL requires ipconfigUSE_TCP_WIN
+	#endif
+
+	/* When non-zero, the CUBIC algorithm ( RFC 8312 ) is included as well, as
+	xTCPCongestionCubic.  It grows the window faster than NewReno on links with
+	a high bandwidth-delay product. */
+	#ifndef ipconfigTCP_CONGESTION_CUBIC
+		#define ipconfigTCP_CONGESTION_CUBIC		( 0 )
+	#endif
+
+	/* When non-zero, received TCP data that must be acknowledged right away
+	(e.g. because little space is left in the reception buffer) is not
+	acknowledged packet by packet.  The ACK is sent once the IP-task has
+	processed all packets that are waiting in its queue, or all packets of the
+	chain passed by the driver (ipconfigUSE_LINKED_RX_MESSAGES).  The socket
+	owner is woken up at that moment as well.  Packets carrying data or SACK
+	options in the opposite direction are still sent immediately. */
+	#ifndef ipconfigUSE_TCP_RX_BATCHING
+		#define ipconfigUSE_TCP_RX_BATCHING		( 0 )
+	#endif
+
+	/* When non-zero, received TCP packets are not handled as soon as they
+	have passed the IP checks, but are put aside in order of arrival.  The
+	IP-task handles them once its event queue is empty, at most this many at a
+	time before looking at the queue and the timers again.  ARP, DHCP, UDP and
+	socket API events are then no longer held up by a bulk TCP transfer.
+	Zero handles every TCP packet at once. */
+	#ifndef ipconfigTCP_DEFERRED_RX_BATCH
+		#define ipconfigTCP_DEFERRED_RX_BATCH	( 0 )
+	#endif
+
+	/* When non-zero, every TCP socket has an ACK policy that determines how
+	long the acknowledgement of received data may be delayed.  It can be
+	changed per socket with FREERTOS_SO_TCP_ACK_POLICY.  The defaults below
+	reproduce the behaviour without a policy. */
+	#ifndef ipconfigUSE_TCP_ACK_POLICY
+		#define ipconfigUSE_TCP_ACK_POLICY		( 0 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_ACK_POLICY != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_ACK_POLICY requires ipconfigUSE_TCP_WIN
+	#endif
+
+	/* Send an ACK after at most this many full-size segments have been
+	received.  Zero means that only the delay limits the number of segments
+	acknowledged by a single ACK ('stretch ACKs'). */
+	#ifndef ipconfigTCP_ACK_EVERY_SEGMENTS
+		#define ipconfigTCP_ACK_EVERY_SEGMENTS	( 0 )
+	#endif
+
+	/* The longest time that the ACK of a full-size segment may be delayed.
+	Zero disables delayed ACKs. */
+	#ifndef ipconfigTCP_ACK_MAX_DELAY_MS
+		#define ipconfigTCP_ACK_MAX_DELAY_MS	( 20 )
+	#endif
+
+	/* When non-zero, a segment with the PSH flag is acknowledged immediately. */
+	#ifndef ipconfigTCP_ACK_ON_PUSH
+		#define ipconfigTCP_ACK_ON_PUSH			( 0 )
+	#endif
+
+	/* When non-zero, the stream buffers of TCP sockets are sized at run-time.
+	Once per round-trip time the IP-task compares the amount of data delivered
+	with the size of the stream.  A stream that was (nearly) filled will be
+	doubled, up to ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH bytes, and a stream
+	that was idle for ipconfigTCP_AUTOTUNE_IDLE_MS is set back to its configured
+	size.  The new size is applied by the socket owner, within FreeRTOS_recv()
+	or FreeRTOS_send(), at a moment that the stream is empty: the stream is
+	released and re-created when data is exchanged again.  That is only safe
+	when the owner has a lower priority than the IP-task.  Sockets that are
+	configured with FREERTOS_SO_RCVBUF, FREERTOS_SO_SNDBUF,
+	FREERTOS_SO_WIN_PROPERTIES or FREERTOS_SO_SET_LOW_HIGH_WATER keep their
+	sizes. */
+	#ifndef ipconfigUSE_TCP_AUTOTUNING
+		#define ipconfigUSE_TCP_AUTOTUNING		( 0 )
+	#endif
+
+	/* When non-zero, every TCP socket counts the bytes that it received and
+	the bytes that were acknowledged by the peer, and its window counts the
+	segments that were retransmitted.  FreeRTOS_TCPSnapshot() returns these
+	counters for all bound sockets, together with the totals of the sockets
+	that were closed already, without asking the IP-task for help.  The
+	IP-task suspends the scheduler while it adds or removes a TCP socket. */
+	#ifndef ipconfigTCP_CONNECTION_STATS
+		#define ipconfigTCP_CONNECTION_STATS	( 0 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_AUTOTUNING != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_AUTOTUNING requires ipconfigUSE_TCP_WIN
+	#endif
+
+	/* The largest size, in bytes, of an automatically sized stream. */
+	#ifndef ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH
+		#define ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH	( 16u * ipconfigTCP_MSS )
+	#endif
+
+	/* The number of bytes that all streams together may use on top of their
+	configured sizes. */
+	#ifndef ipconfigTCP_AUTOTUNE_MEMORY_CAP
+		#define ipconfigTCP_AUTOTUNE_MEMORY_CAP	( 4u * ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH )
+	#endif
+
+	/* A socket that has not delivered any data for this time is considered
+	idle. */
+	#ifndef ipconfigTCP_AUTOTUNE_IDLE_MS
+		#define ipconfigTCP_AUTOTUNE_IDLE_MS	( 5000u )
+	#endif
+
+	/* When non-zero, the time-outs of TCP sockets (retransmission, keep-alive,
+	delayed ACK, TIME_WAIT) are kept in a hierarchical timer wheel.  When a
+	timer expires, only the sockets concerned are checked, and the IP-task
+	sleeps until the first time-out, instead of waking up every
+	ipTCP_TIMER_PERIOD_MS to check all sockets.  All sockets are still visited
+	after TCP packets have been processed, or after a socket owner asked for
+	attention, in order to wake up the socket owners. */
+	#ifndef ipconfigUSE_TCP_TIMER_WHEEL
+		#define ipconfigUSE_TCP_TIMER_WHEEL		( 0 )
+	#endif
+
+	/* When non-zero, a listening socket keeps its connected child sockets in
+	a FIFO, so that FreeRTOS_accept() takes the next child from the queue
+	instead of having the IP-task search all bound TCP sockets. */
+	#ifndef ipconfigTCP_ACCEPT_QUEUE
+		#define ipconfigTCP_ACCEPT_QUEUE		( 0 )
+	#endif
+
+	/* When non-zero, the streams of a TCP socket whose connection has ended
+	are freed before FreeRTOS_closesocket() is called: the transmission stream
+	when FreeRTOS_send() finds the socket not connected, the reception stream
+	when FreeRTOS_recv() has delivered all data and finds the socket not
+	connected.  The window segments return to the pool once both streams are
+	gone.  Requires INCLUDE_uxTaskPriorityGet, the socket owner must have a
+	lower priority than the IP-task. */
+	#ifndef ipconfigTCP_RELEASE_CLOSED_BUFFERS
+		#define ipconfigTCP_RELEASE_CLOSED_BUFFERS	( 0 )
+	#endif
+
+	/* When non-zero, and the stack calculates the TX checksums itself, the
+	one's complement sum of the data of each transmission segment is kept in
+	the segment.  When the segment is sent again, or sent with a changed
+	sequence, acknowledge or window field, only the headers are summed and the
+	stored sum is added to them, so the data is never summed twice. */
+	#ifndef ipconfigTCP_INCREMENTAL_CHECKSUM
+		#define ipconfigTCP_INCREMENTAL_CHECKSUM	( 0 )
+	#endif
+
+	/* When non-zero, a listening socket answers a SYN with a SYN+ACK whose
+	sequence number is a cookie: a keyed hash of the connection, a coarse
+	time stamp and the MSS.  The child socket is only created when the final
+	ACK of the handshake returns a valid cookie, so a burst of SYN's or a port
+	scan does not take any sockets or window buffers.  These connections do
+	not use window scaling nor SACK.  Sockets that have FREERTOS_SO_REUSE_LISTEN_SOCKET
+	set are not affected.  The secret is taken from ipconfigRAND32(), which
+	must then return unpredictable numbers. */
+	#ifndef ipconfigTCP_SYN_COOKIES
+		#define ipconfigTCP_SYN_COOKIES			( 0 )
+	#endif
+
+	/* When non-zero, a client socket that has the option FREERTOS_SO_TCP_FASTOPEN
+	set uses TCP Fast Open (RFC 7413): its first SYN asks the server for a
+	cookie, and once a cookie is known, the next SYN to the same server carries
+	it along with the data that was passed to FreeRTOS_send() before
+	FreeRTOS_connect().  The server may then deliver that data one round-trip
+	earlier. */
+	#ifndef ipconfigTCP_FAST_OPEN
+		#define ipconfigTCP_FAST_OPEN			( 0 )
+	#endif
+
+	/* The number of servers for which a Fast Open cookie is remembered.  The
+	oldest entry is replaced when the cache is full. */
+	#ifndef ipconfigTCP_FAST_OPEN_CACHE_SIZE
+		#define ipconfigTCP_FAST_OPEN_CACHE_SIZE	( 4 )
+	#endif
+
 	#ifndef ipconfigIGNORE_UNKNOWN_PACKETS
 		/* When non-zero, TCP will not send RST packets in reply to
 		TCP packets which are unknown, or out-of-order. */
@@ -289,6 +474,40 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define	ipconfigUSE_ARP_REMOVE_ENTRY		0
 #endif
 
+/* When ipconfigARP_CACHE_HASH_SIZE is non-zero, the ARP cache is indexed by
+hash tables of this many buckets on both the IP- and the MAC-address, and
+entries are replaced in least-recently-used order.  Lookups then no longer
+scan all ipconfigARP_CACHE_ENTRIES entries.  When used, the value must be a
+power of 2. */
+#ifndef ipconfigARP_CACHE_HASH_SIZE
+	#define ipconfigARP_CACHE_HASH_SIZE			0
+#endif
+
+/* When ipconfigARP_PENDING_PACKETS is non-zero, up to this many outgoing UDP
+packets are held while the MAC address of their destination (or gateway) is
+being resolved, and sent as soon as the ARP reply arrives.  When zero, the
+packet that causes an ARP request is dropped, and the buffer is used to send
+the request.  At most ipconfigARP_PENDING_PACKETS_PER_ADDRESS of the held
+packets wait for the same address.  Connecting TCP sockets that wait for an
+ARP reply are also retried as soon as the reply arrives. */
+#ifndef ipconfigARP_PENDING_PACKETS
+	#define ipconfigARP_PENDING_PACKETS			0
+#endif
+
+#ifndef ipconfigARP_PENDING_PACKETS_PER_ADDRESS
+	#define ipconfigARP_PENDING_PACKETS_PER_ADDRESS	2
+#endif
+
+/* When ipconfigUSE_LOOPBACK is set to 1, packets sent to the device's own IP
+address, or to any address in 127.0.0.0/8, do not go through the network
+driver.  The buffer is passed back to the IP-task as a received frame, and
+no checksums are calculated or verified for it.  Addresses in 127.0.0.0/8 are
+replaced by the own IP address when a packet is sent or a TCP connection is
+made, so the peer sees the own IP address as the source. */
+#ifndef ipconfigUSE_LOOPBACK
+	#define ipconfigUSE_LOOPBACK				0
+#endif
+
 #ifndef ipconfigINCLUDE_FULL_INET_ADDR
 	#define ipconfigINCLUDE_FULL_INET_ADDR	1
 #endif
@@ -321,6 +540,16 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUDP_MAX_RX_PACKETS		0u
 #endif
 
+#ifndef ipconfigUDP_CONNECTED_SOCKETS
+	/* When non-zero, a UDP socket can be given a fixed peer with the socket
+	 * option FREERTOS_SO_UDP_PEER.  Such a socket keeps a copy of the Ethernet,
+	 * IP and UDP headers of the last packet sent, and FreeRTOS_sendto() will
+	 * reuse it for as long as the ARP cache has not changed, leaving only the
+	 * lengths and checksums to be filled in.
+	 */
+	#define ipconfigUDP_CONNECTED_SOCKETS	0
+#endif
+
 #ifndef ipconfigUSE_DHCP
 	#define ipconfigUSE_DHCP				1
 #endif
@@ -329,6 +558,36 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUSE_DHCP_HOOK		0
 #endif
 
+#ifndef ipconfigDHCP_USE_LEASE_STORE
+	/*
+	 * When set to 1, the application provides xApplicationDHCPLoadLease() and
+	 * vApplicationDHCPStoreLease().  A lease stored during a previous run is
+	 * confirmed with a single request (INIT-REBOOT), instead of a full
+	 * discover/offer/request/ack exchange.
+	 */
+	#define ipconfigDHCP_USE_LEASE_STORE		( 0 )
+#endif
+
+#ifndef ipconfigDHCP_USE_RAPID_COMMIT
+	/*
+	 * When set to 1, discover messages carry the Rapid Commit option (RFC 4039)
+	 * and an ACK received in reply is used at once.  Servers that do not
+	 * support it answer with a normal offer.
+	 */
+	#define ipconfigDHCP_USE_RAPID_COMMIT		( 0 )
+#endif
+
+#ifndef ipconfigALIGN_DEFERRABLE_DELAY
+	/*
+	 * Adjusts the delay, in ticks, before activity that may be postponed a
+	 * little, which is currently the DHCP lease renewal.  It may only make
+	 * the delay longer.  A power saving Wi-Fi port can use it to move that
+	 * activity into the radio's wake windows.  By default the delay is not
+	 * changed.
+	 */
+	#define ipconfigALIGN_DEFERRABLE_DELAY( xTicks )	( xTicks )
+#endif
+
 #ifndef ipconfigDHCP_FALL_BACK_AUTO_IP
 	/*
 	 * Only applicable when DHCP is in use:
@@ -397,6 +656,22 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#ifndef ipconfigDNS_CACHE_ENTRIES
 		#define ipconfigDNS_CACHE_ENTRIES			1
 	#endif
+
+	/* The number of seconds that a name is remembered as unresolvable, after
+	the DNS server answered that it does not exist or has no A record.  In
+	that time FreeRTOS_gethostbyname() returns 0 at once instead of sending
+	the query again.  0 disables negative caching. */
+	#ifndef ipconfigDNS_CACHE_NEGATIVE_TTL
+		#define ipconfigDNS_CACHE_NEGATIVE_TTL		0
+	#endif
+
+	/* When non-zero, a look-up that finds an entry in the last eighth of its
+	TTL also sends a single refresh query, without waiting for the reply.
+	The IP-task stores the answer, so popular names are renewed before they
+	expire instead of costing the next caller a blocking look-up. */
+	#ifndef ipconfigDNS_CACHE_PREFETCH
+		#define ipconfigDNS_CACHE_PREFETCH			0
+	#endif
 #endif /* ipconfigUSE_DNS_CACHE != 0 */
 
 #ifndef ipconfigCHECK_IP_QUEUE_SPACE
@@ -487,6 +762,34 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigZERO_COPY_RX_DRIVER		( 0 )
 #endif
 
+/* When non-zero, a driver may pass a chain of received packets, linked with
+'pxNextBuffer', to the IP-task in a single eNetworkRxEvent.  Drivers can use
+vNetworkRxChainAppend() and xNetworkRxChainSend() to build and pass chains. */
+#ifndef ipconfigUSE_LINKED_RX_MESSAGES
+	#define ipconfigUSE_LINKED_RX_MESSAGES	( 0 )
+#endif
+
+/* The maximum number of packets in a chain built by vNetworkRxChainAppend().
+A full chain is passed to the IP-task immediately, so that the IP-task can
+start working while the driver empties the rest of its DMA ring. */
+#ifndef ipconfigMAX_LINKED_RX_MESSAGES
+	#define ipconfigMAX_LINKED_RX_MESSAGES	( 16 )
+#endif
+
+/* A stream buffer has a single writer and a single reader, each of which only
+moves its own index (uxHead resp. uxTail).  No critical sections are needed,
+as long as the data is accessed before the index is moved.  This macro is
+placed between the data accesses and the index updates.  On a single core a
+compiler barrier is enough; multi-core systems must define a real memory
+barrier, e.g. __DMB() on ARM. */
+#ifndef ipconfigSTREAM_BUFFER_BARRIER
+	#ifdef portMEMORY_BARRIER
+		#define ipconfigSTREAM_BUFFER_BARRIER()	portMEMORY_BARRIER()
+	#else
+		#define ipconfigSTREAM_BUFFER_BARRIER()
+	#endif
+#endif
+
 #ifndef ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM
 	#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM 0
 #endif
@@ -495,6 +798,106 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM 0
 #endif
 
+/* Drivers of which the peripheral checks the checksums of only some of the
+received packets (e.g. not of fragmented or non-IPv4 packets) can leave
+ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM at 0 and define this macro instead.  It
+is called for each received IP packet and must return pdTRUE when the
+peripheral has verified both the IP-header and the protocol checksum of the
+packet.  The stack verifies the checksums of the other packets. */
+#ifndef ipconfigDRIVER_RX_CHECKSUM_VERIFIED
+	#define ipconfigDRIVER_RX_CHECKSUM_VERIFIED( pxNetworkBuffer )	( pdFALSE )
+#endif
+
+/* When non-zero, TCP may pass a 'super-segment' to xNetworkInterfaceOutput():
+a single frame with one set of headers, followed by up to
+ipconfigTCP_LARGE_SEND_MAX_SEGMENTS consecutive segments of new data.  The
+field 'usLargeSendMSS' of the network buffer is then non-zero, and the driver
+must cut the payload into pieces of at most that many bytes, give each piece a
+copy of the headers with an adapted sequence number, IP length and IP
+identification, set PSH/FIN on the last piece only, and calculate all
+checksums (segmentation offload).  When 'usLargeSendMSS' is zero, the frame
+must be sent as usual.  Super-segments are only built when the network
+buffers have a variable size (BufferAllocation_2.c). */
+#ifndef ipconfigUSE_TCP_LARGE_SEND
+	#define ipconfigUSE_TCP_LARGE_SEND	( 0 )
+#endif
+
+#ifndef ipconfigTCP_LARGE_SEND_MAX_SEGMENTS
+	#define ipconfigTCP_LARGE_SEND_MAX_SEGMENTS	( 4 )
+#endif
+
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	#if( ( ipconfigUSE_TCP == 0 ) || ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_LARGE_SEND requires ipconfigUSE_TCP and ipconfigUSE_TCP_WIN
+	#endif
+	#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+		#error ipconfigUSE_TCP_LARGE_SEND requires a driver that calculates the checksums ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM )
+	#endif
+#endif
+
+/* When ipconfigTX_PRIORITY_CLASSES is non-zero, outgoing frames that can not
+be passed to the driver at once are queued in this many traffic classes.
+Class 0 has strict priority: it is always sent first, e.g. for MQTT control
+packets.  The other classes share the link in deficit round robin order, each
+getting ipconfigTX_DRR_QUANTUM bytes per round.  A socket selects its class
+with FREERTOS_SO_PRIORITY, new sockets use ipconfigTX_DEFAULT_CLASS.  The
+driver tells the stack that it can take a frame through the macro
+ipconfigNETWORK_INTERFACE_TX_READY(), and calls FreeRTOS_NetworkTxReady() or
+FreeRTOS_NetworkTxReadyFromISR() when it has room again.  At most
+ipconfigTX_QUEUE_LENGTH frames are queued. */
+#ifndef ipconfigTX_PRIORITY_CLASSES
+	#define ipconfigTX_PRIORITY_CLASSES		0
+#endif
+
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	#ifndef ipconfigTX_DEFAULT_CLASS
+		#if( ipconfigTX_PRIORITY_CLASSES > 1 )
+			#define ipconfigTX_DEFAULT_CLASS	1
+		#else
+			#define ipconfigTX_DEFAULT_CLASS	0
+		#endif
+	#endif
+
+	#ifndef ipconfigTX_DRR_QUANTUM
+		#define ipconfigTX_DRR_QUANTUM		( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+	#endif
+
+	#ifndef ipconfigTX_QUEUE_LENGTH
+		#define ipconfigTX_QUEUE_LENGTH		( ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 ) + 1 )
+	#endif
+
+	#ifndef ipconfigNETWORK_INTERFACE_TX_READY
+		#define ipconfigNETWORK_INTERFACE_TX_READY()	( pdTRUE )
+	#endif
+
+	#if( ipconfigTX_DEFAULT_CLASS >= ipconfigTX_PRIORITY_CLASSES )
+		#error ipconfigTX_DEFAULT_CLASS must be lower than ipconfigTX_PRIORITY_CLASSES
+	#endif
+	#if( ipconfigTX_PRIORITY_CLASSES > 8 )
+		#error ipconfigTX_PRIORITY_CLASSES can be at most 8
+	#endif
+#endif /* ipconfigTX_PRIORITY_CLASSES */
+
+/* The implementation that usGenerateChecksum() uses to sum the bulk of the
+data, 16 bytes at a time:
+  ipCHECKSUM_PORTABLE_32: portable, 32-bit additions counting the carries.
+  ipCHECKSUM_PORTABLE_64: portable, a 64-bit accumulator.  Faster on CPUs
+	that have 64-bit additions, or that can add with carry and whose compiler
+	uses that for 64-bit arithmetic (e.g. GCC on Cortex-M).
+  ipCHECKSUM_ARM_ADC: add-with-carry chains in inline assembly, for GCC on
+	ARMv7-M and ARMv7E-M (Cortex-M3/M4/M7).
+  ipCHECKSUM_APPLICATION: the application provides
+	uint32_t ulApplicationChecksumAddBlocks( uint32_t ulSum,
+		const uint32_t *pulSource, size_t uxBlockCount ), see usGenerateChecksum(). */
+#define ipCHECKSUM_PORTABLE_32		0
+#define ipCHECKSUM_PORTABLE_64		1
+#define ipCHECKSUM_ARM_ADC			2
+#define ipCHECKSUM_APPLICATION		3
+
+#ifndef ipconfigCHECKSUM_METHOD
+	#define ipconfigCHECKSUM_METHOD		ipCHECKSUM_PORTABLE_32
+#endif
+
 #ifndef ipconfigDHCP_REGISTER_HOSTNAME
 	#define ipconfigDHCP_REGISTER_HOSTNAME 0
 #endif
@@ -523,6 +926,12 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigSUPPORT_SIGNALS				0
 #endif
 
+/* Set to 1 to include FreeRTOS_recvmmsg() and FreeRTOS_sendmmsg(), which
+receive or send several UDP datagrams in one call. */
+#ifndef ipconfigSUPPORT_MMSG_FUNCTIONS
+	#define ipconfigSUPPORT_MMSG_FUNCTIONS		0
+#endif
+
 #ifndef ipconfigUSE_NBNS
 	#define ipconfigUSE_NBNS 0
 #endif
@@ -557,4 +966,67 @@ connections, hang protection can help reduce the impact of SYN floods. */
 	#define ipconfigPACKET_FILLER_SIZE 2
 #endif
 
+/* When ipconfigSOCKET_LOOKUP_TABLE_SIZE is non-zero, pxUDPSocketLookup() and
+pxTCPSocketLookup() first look in an open-addressed hash table, keyed on the
+protocol, the local port and the remote IP-address and port, before walking
+the lists of bound sockets.  Sockets found by walking the lists are added to
+the table, entries are removed when the socket is closed.  When used, the
+value must be a power of 2 and should be larger than the number of sockets
+that are expected to receive traffic at the same time. */
+#ifndef ipconfigSOCKET_LOOKUP_TABLE_SIZE
+	#define ipconfigSOCKET_LOOKUP_TABLE_SIZE 0
+#endif
+
+/* Only used by BufferAllocation_2.c: when ipconfigUSE_NETWORK_BUFFER_CLASSES
+is non-zero, the storage for network buffers is taken from three pools of
+fixed-size slabs (small, medium and full-MTU) which are carved from a single
+dedicated region, in stead of calling pvPortMalloc() for every packet.  A
+request is served from the smallest class that it fits in, or from a larger
+class when that one is exhausted.  Getting and releasing a slab is O(1) and
+may also be done from an ISR, see pxNetworkBufferGetFromISR().  The sizes
+are the usable number of bytes, not including ipBUFFER_PADDING. */
+#ifndef ipconfigUSE_NETWORK_BUFFER_CLASSES
+	#define ipconfigUSE_NETWORK_BUFFER_CLASSES	0
+#endif
+
+#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+	/* Large enough for ARP packets and TCP segments without payload. */
+	#ifndef ipconfigNETWORK_BUFFER_SMALL_SIZE
+		#define ipconfigNETWORK_BUFFER_SMALL_SIZE	128u
+	#endif
+
+	#ifndef ipconfigNETWORK_BUFFER_SMALL_COUNT
+		#define ipconfigNETWORK_BUFFER_SMALL_COUNT	16u
+	#endif
+
+	/* Large enough for DNS and DHCP messages. */
+	#ifndef ipconfigNETWORK_BUFFER_MEDIUM_SIZE
+		#define ipconfigNETWORK_BUFFER_MEDIUM_SIZE	640u
+	#endif
+
+	#ifndef ipconfigNETWORK_BUFFER_MEDIUM_COUNT
+		#define ipconfigNETWORK_BUFFER_MEDIUM_COUNT	8u
+	#endif
+
+	/* A full frame: the MTU plus the Ethernet header, the 2 bytes that
+	BufferAllocation_2.c adds and the rounding up to a multiple of 8. */
+	#ifndef ipconfigNETWORK_BUFFER_LARGE_SIZE
+		#define ipconfigNETWORK_BUFFER_LARGE_SIZE	( ipconfigNETWORK_MTU + 24u )
+	#endif
+
+	#ifndef ipconfigNETWORK_BUFFER_LARGE_COUNT
+		#define ipconfigNETWORK_BUFFER_LARGE_COUNT	12u
+	#endif
+
+	/* When non-zero, a task that can not be served from any of the classes
+	will fall back to pvPortMalloc().  An ISR never uses the heap. */
+	#ifndef ipconfigNETWORK_BUFFER_HEAP_FALLBACK
+		#define ipconfigNETWORK_BUFFER_HEAP_FALLBACK	1
+	#endif
+
+	#if( ( ipconfigNETWORK_BUFFER_SMALL_SIZE > ipconfigNETWORK_BUFFER_MEDIUM_SIZE ) || ( ipconfigNETWORK_BUFFER_MEDIUM_SIZE > ipconfigNETWORK_BUFFER_LARGE_SIZE ) )
+		#error The network buffer classes must be sorted from small to large
+	#endif
+#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+
 #endif /* FREERTOS_DEFAULT_IP_CONFIG_H */
@@ -47,6 +47,12 @@ typedef struct xARP_CACHE_TABLE_ROW
     uint8_t ucValid;			/* pdTRUE: xMACAddress is valid, pdFALSE: waiting for ARP reply */
 } ARPCacheRow_t;
 
+typedef struct xARP_CACHE_STATISTICS
+{
+	uint32_t ulHits;			/* The number of lookups that found a valid entry. */
+	uint32_t ulMisses;			/* The number of lookups that found no entry, or one still waiting for an ARP reply. */
+} ARPCacheStatistics_t;
+
 typedef enum
 {
 	eARPCacheMiss = 0,			/* 0 An ARP table lookup did not find a valid entry. */
@@ -102,6 +108,12 @@ eARPLookupResult_t eARPGetCacheEntry( uint32_t *pulIPAddress, MACAddress_t * con
 	eARPLookupResult_t eARPGetCacheEntryByMac( MACAddress_t * const pxMACAddress, uint32_t *pulIPAddress );
 
 #endif
+/*
+ * Obtain the number of ARP cache hits and misses counted since the ARP cache
+ * was last cleared.
+ */
+void vARPGetCacheStatistics( ARPCacheStatistics_t *pxStatistics );
+
 /*
  * Reduce the age count in each entry within the ARP cache.  An entry is no
  * longer considered valid and is deleted if its age reaches zero.
@@ -121,6 +133,21 @@ void vARPGenerateRequestPacket( NetworkBufferDescriptor_t * const pxNetworkBuffe
  */
 void vARPSendGratuitous( void );
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+
+	/*
+	 * Hold the outgoing UDP packet in pxNetworkBuffer until the MAC address of
+	 * ulIPAddress is known, then pass it to vProcessGeneratedUDPPacket() again.
+	 * ulIPAddress is the address being resolved, so the gateway's address if
+	 * the destination is not on the local network.  Returns pdPASS when the
+	 * packet is held, and the buffer is then owned by the ARP module.  Returns
+	 * pdFAIL when too many packets are held already.  Packets still held after
+	 * two ARP timer periods are dropped.
+	 */
+	BaseType_t xARPHoldPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulIPAddress );
+
+#endif /* ipconfigARP_PENDING_PACKETS */
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
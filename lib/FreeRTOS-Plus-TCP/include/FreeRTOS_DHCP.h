@@ -52,6 +52,16 @@ typedef enum eDHCP_ANSWERS
 	eDHCPStopNoChanges,		/* Stop DHCP and continue with current settings. */
 } eDHCPCallbackAnswer_t;
 
+/* The lease passed to the lease store hooks if ipconfigDHCP_USE_LEASE_STORE is
+set to 1.  All addresses are in network byte order. */
+typedef struct xDHCP_LEASE
+{
+	uint32_t ulIPAddress;			/* The address that was assigned. */
+	uint32_t ulNetMask;
+	uint32_t ulGatewayAddress;
+	uint32_t ulDNSServerAddress;
+} DHCPLease_t;
+
 /*
  * NOT A PUBLIC API FUNCTION.
  */
@@ -67,6 +77,15 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Configuration.htm
 */
 eDHCPCallbackAnswer_t xApplicationDHCPHook( eDHCPCallbackPhase_t eDHCPPhase, uint32_t ulIPAddress );
 
+/* Prototypes of the hooks that must be provided by the application if
+ipconfigDHCP_USE_LEASE_STORE is set to 1.  vApplicationDHCPStoreLease() is
+called from the IP-task each time a lease is acknowledged, and should save it
+in memory that survives a reset or deep sleep.  xApplicationDHCPLoadLease() is
+called when DHCP starts; it returns pdTRUE after filling in the stored lease,
+whose address will then be confirmed without going through a discover. */
+void vApplicationDHCPStoreLease( const DHCPLease_t *pxLease );
+BaseType_t xApplicationDHCPLoadLease( DHCPLease_t *pxLease );
+
 #ifdef __cplusplus
 }	/* extern "C" */
 #endif
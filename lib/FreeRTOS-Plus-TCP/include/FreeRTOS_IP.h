@@ -97,6 +97,12 @@ typedef struct xNETWORK_BUFFER
 	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 		struct xNETWORK_BUFFER *pxNextBuffer; /* Possible optimisation for expert users - requires network driver support. */
 	#endif
+	#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+		uint16_t usLargeSendMSS;		/* When non-zero, a TCP super-segment which the driver must cut into segments of this size. */
+	#endif
+	#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		uint8_t ucTxClass;				/* The traffic class in which the frame waits to be sent, 0 is the highest priority. */
+	#endif
 } NetworkBufferDescriptor_t;
 
 #include "pack_struct_start.h"
@@ -254,6 +254,8 @@ typedef enum
 	eSocketCloseEvent,		/* 9: Send a message to the IP-task to close a socket. */
 	eSocketSelectEvent,		/*10: Send a message to the IP-task for select(). */
 	eSocketSignalEvent,		/*11: A socket must be signalled. */
+	eNetworkTxEvent,		/*12: The network interface can take frames again. */
+	eStackTxReadyEvent,		/*13: A UDP packet with complete headers is waiting to be transmitted. */
 } eIPEvent_t;
 
 typedef struct IP_TASK_COMMANDS
@@ -335,6 +337,12 @@ extern UDPPacketHeader_t xDefaultPartUDPPacketHeader;
 /* Structure that stores the netmask, gateway address and DNS server addresses. */
 extern NetworkAddressingParameters_t xNetworkAddressing;
 
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	/* Incremented whenever an entry of the ARP cache changes or disappears.
+	It is never zero. */
+	extern volatile uint32_t ulARPCacheGeneration;
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+
 /* Structure that stores the defaults for netmask, gateway address and DNS.
 These values will be copied to 'xNetworkAddressing' in case DHCP is not used,
 and also in case DHCP does not lead to a confirmed request. */
@@ -418,6 +426,18 @@ BaseType_t FreeRTOS_ReleaseFreeNetworkBufferFromISR( void );
 void FreeRTOS_NetworkDown( void );
 BaseType_t FreeRTOS_NetworkDownFromISR( void );
 
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	/*
+	 * Called by the network interface driver when it has room for new frames,
+	 * after ipconfigNETWORK_INTERFACE_TX_READY() returned pdFALSE.  The
+	 * IP-task will then pass the queued frames to xNetworkInterfaceOutput().
+	 * If FreeRTOS_NetworkTxReadyFromISR() returns a non-zero value then a
+	 * context switch should be performed before the interrupt is exited.
+	 */
+	void FreeRTOS_NetworkTxReady( void );
+	BaseType_t FreeRTOS_NetworkTxReadyFromISR( void );
+#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 /*
  * Processes incoming ARP packets.
  */
@@ -435,6 +455,15 @@ eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucE
  */
 uint16_t usGenerateChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes );
 
+#if( ipconfigCHECKSUM_METHOD == ipCHECKSUM_APPLICATION )
+	/*
+	 * Provided by the application: add uxBlockCount blocks of 16 bytes, starting
+	 * at the 32-bit aligned pulSource, to the one's complement sum ulSum.  The
+	 * result must be below 0x10000000 and will be folded by usGenerateChecksum().
+	 */
+	uint32_t ulApplicationChecksumAddBlocks( uint32_t ulSum, const uint32_t *pulSource, size_t uxBlockCount );
+#endif
+
 /* Socket related private functions. */
 
 /* 
@@ -530,6 +559,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 				bFinAcked : 1,		/* Our FIN packet has been acked */
 				bFinLast : 1,		/* The last ACK (after FIN and FIN+ACK) has been sent or will be sent by the peer */
 				bRxStopped : 1,		/* Application asked to temporarily stop reception */
+				#if( ipconfigTCP_FAST_OPEN != 0 )
+					bFastOpen : 1,		/* Connecting socket: use TCP Fast Open */
+				#endif /* ipconfigTCP_FAST_OPEN */
 				bMallocError : 1,	/* There was an error allocating a stream */
 				bWinScaling : 1;	/* A TCP-Window Scaling option was offered and accepted in the SYN phase. */
 		} bits;
@@ -561,6 +593,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
 		#endif /* ipconfigUSE_TCP_WIN */
+		#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+			const uint8_t *pucChecksumPacket;	/* The packet that prvTCPPrepareSend() filled with the data of 'xTCPWindow.pxLastTxSegment' */
+		#endif /* ipconfigTCP_INCREMENTAL_CHECKSUM */
 		/* Buffer space to store the last TCP header received. */
 		LastTCPPacket_t xPacket;
 		uint8_t tcpflags;		/* TCP flags */
@@ -579,6 +614,42 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		uint32_t ulWindowSize;		/* Current Window size advertised by peer */
 		size_t uxRxWinSize;	/* Fixed value: size of the TCP reception window */
 		size_t uxTxWinSize;	/* Fixed value: size of the TCP transmit window */
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+			const TCPCongestionOps_t *pxCongestionOps;	/* The congestion control algorithm, NULL for the default (NewReno) */
+		#endif
+		#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+			uint16_t usAckDelayMs;	/* The longest time an ACK may be delayed */
+			uint8_t ucAckEvery;		/* Acknowledge at least every X full-size segments, 0 for no limit */
+			uint8_t ucAckOnPush;	/* Non-zero: acknowledge a segment with the PSH flag immediately */
+			uint8_t ucAckPending;	/* The number of full-size segments received since the last ACK */
+		#endif
+		#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+			uint8_t ucAutotune;			/* Non-zero when the stream sizes are tuned automatically */
+			uint32_t ulAutoRxBytes;		/* Bytes received in the current measuring interval */
+			uint32_t ulAutoTxBytes;		/* Bytes acknowledged in the current measuring interval */
+			TickType_t xAutoIntervalStart;
+			TickType_t xAutoLastActive;	/* The last time that data was exchanged */
+			size_t uxRxStreamTarget;	/* Stream sizes as desired by the IP-task */
+			size_t uxTxStreamTarget;
+			size_t uxRxStreamBase;		/* Stream sizes before tuning */
+			size_t uxTxStreamBase;
+		#endif
+		#if( ipconfigTCP_CONNECTION_STATS != 0 )
+			uint32_t ulBytesReceived;	/* Bytes stored in rxStream since the socket was created */
+			uint32_t ulBytesAcked;		/* Bytes from txStream that were acknowledged by the peer */
+		#endif
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+			ListItem_t xTimerListItem;	/* Item in the timer wheel, the item value is the expiry time */
+			uint16_t usTimerArmed;		/* The value of 'usTimeout' for which the timer was set */
+		#endif
+		#if( ipconfigTCP_FAST_OPEN != 0 )
+			uint16_t usFastOpenLength;	/* The number of data bytes sent along with the SYN */
+		#endif
+		#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
+			List_t xAcceptQueue;		/* Listening socket: connected children that were not yet passed by accept() */
+			ListItem_t xAcceptListItem;	/* Child socket: item in the accept queue of its parent */
+		#endif
+
 
 		TCPWindow_t xTCPWindow;
 	} IPTCPSocket_t;
@@ -598,6 +669,12 @@ typedef struct UDPSOCKET
 											 */
 		FOnUDPSent_t pxHandleSent;
 	#endif /* ipconfigUSE_CALLBACKS */
+	#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+		uint32_t ulPeerIPAddress;	/* Peer set with FREERTOS_SO_UDP_PEER, zero when there is none */
+		uint16_t usPeerPort;		/* Port of the peer, network-byte-order */
+		volatile uint32_t ulTemplateGeneration;	/* Value of ulARPCacheGeneration when the template was made, zero while it is being written */
+		uint8_t ucHeaderTemplate[ ipUDP_PAYLOAD_OFFSET_IPv4 ];	/* Ethernet, IP and UDP headers of a packet to the peer */
+	#endif /* ipconfigUDP_CONNECTED_SOCKETS */
 } IPUDPSocket_t;
 
 typedef enum eSOCKET_EVENT {
@@ -623,6 +700,12 @@ typedef struct XSOCKET
 	uint16_t usLocalPort;		/* Local port on this machine */
 	uint8_t ucSocketOptions;
 	uint8_t ucProtocol; /* choice of FREERTOS_IPPROTO_UDP/TCP */
+	#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		uint8_t ucTxClass; /* Transmit traffic class, see FREERTOS_SO_PRIORITY */
+	#endif /* ipconfigTX_PRIORITY_CLASSES */
+	#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+		uint16_t usLookupSlot; /* Index of the socket in the socket lookup table, 0xffff when it is not in the table. */
+	#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 		SemaphoreHandle_t pxUserSemaphore;
 	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
@@ -637,6 +720,8 @@ typedef struct XSOCKET
 		/* These bits indicate the events which have actually occurred.
 		They are maintained by the IP-task */
 		EventBits_t xSocketBits;
+		/* Links the socket into the ready list of its socket set. */
+		ListItem_t xSelectListItem;
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 	/* TCP/UDP specific fields: */
 	/* Before accessing any member of this structure, it should be confirmed */
@@ -673,6 +758,14 @@ FreeRTOS_Socket_t *pxUDPSocketLookup( UBaseType_t uxLocalPort );
  */
 void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
 
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	/*
+	 * Called when FreeRTOS_sendto() has built the complete headers of a UDP
+	 * packet from the template of a connected socket.
+	 */
+	void vProcessPrebuiltUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+
 /*
  * Calculate the upper-layer checksum
  * Works both for UDP, ICMP and TCP packages
@@ -733,8 +826,68 @@ static portINLINE uint16_t usChar2u16 (const uint8_t *apChr)
 /* Check a single socket for retransmissions and timeouts */
 BaseType_t xTCPSocketCheck( FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	/*
+	 * Called by the IP-task: let xTCPSocketCheck() be called for the socket
+	 * after xTicks clock ticks.  A time of zero stops the timer.
+	 */
+	void vTCPSocketTimerSet( FreeRTOS_Socket_t *pxSocket, TickType_t xTicks );
+
+	/*
+	 * Check the sockets of which the timer has expired.  When xCheckAll is
+	 * true, all sockets are visited, as xTCPTimerCheck() does.  Returns the
+	 * number of clock ticks until the next time-out.
+	 */
+	TickType_t xTCPTimerWheelCheck( BaseType_t xWillSleep, BaseType_t xCheckAll );
+#else
+	#define vTCPSocketTimerSet( pxSocket, xTicks )	do { ( pxSocket )->u.xTCP.usTimeout = ( uint16_t ) ( xTicks ); } while( 0 )
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	/*
+	 * Called by the IP-task when an ARP reply resolved an outstanding request:
+	 * connecting sockets that wait for a MAC address retry at the next tick,
+	 * instead of after their 500 ms ARP poll.
+	 */
+	void vTCPARPResolved( void );
+#endif /* ipconfigARP_PENDING_PACKETS */
+
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	/* Defined in FreeRTOS_IP.c
+	 * Pass a frame to xNetworkInterfaceOutput(), or queue it in its traffic
+	 * class when the driver has no room for it, or when frames are waiting
+	 * already.
+	 */
+	BaseType_t xTxSchedulerOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+	#define ipDRIVER_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xTxSchedulerOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#else
+	#define ipDRIVER_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xNetworkInterfaceOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif /* ipconfigTX_PRIORITY_CLASSES */
+
+#if( ipconfigUSE_LOOPBACK != 0 )
+	/* Is ulIPAddress (network byte order) part of 127.0.0.0/8 ? */
+	#define ipIS_LOOPBACK_NETWORK( ulIPAddress )	( ( ( ulIPAddress ) & FreeRTOS_htonl( 0xff000000UL ) ) == FreeRTOS_htonl( 0x7f000000UL ) )
+
+	/* Is the Ethernet frame sent from and to the own MAC address, i.e. does
+	it travel over the loopback path? */
+	#define ipIS_LOOPBACK_FRAME( pxNetworkBuffer ) \
+		( ( memcmp( ( ( const EthernetHeader_t * ) ( pxNetworkBuffer )->pucEthernetBuffer )->xDestinationAddress.ucBytes, ipLOCAL_MAC_ADDRESS, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 ) && \
+		  ( memcmp( ( ( const EthernetHeader_t * ) ( pxNetworkBuffer )->pucEthernetBuffer )->xSourceAddress.ucBytes, ipLOCAL_MAC_ADDRESS, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 ) )
+
+	/* Defined in FreeRTOS_IP.c
+	 * Pass a frame that is addressed to the own MAC address back to the
+	 * IP-task as a received packet.  Other frames are passed to
+	 * ipDRIVER_OUTPUT().
+	 */
+	BaseType_t xLoopbackOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xLoopbackOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#else
+	#define ipIS_LOOPBACK_FRAME( pxNetworkBuffer )	( pdFALSE )
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	ipDRIVER_OUTPUT( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif /* ipconfigUSE_LOOPBACK */
+
 /* Defined in FreeRTOS_Sockets.c
  * Close a socket
  */
@@ -754,13 +907,54 @@ BaseType_t xSendEventToIPTask( eIPEvent_t eEvent );
  */
 BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout );
 
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/*
+	 * A chain of received packets that a network interface collects before
+	 * passing them to the IP-task in one eNetworkRxEvent.  Initialise it with
+	 * zero's.
+	 */
+	typedef struct xNETWORK_RX_CHAIN
+	{
+		NetworkBufferDescriptor_t *pxHead;
+		NetworkBufferDescriptor_t *pxTail;
+		UBaseType_t uxCount;
+	} NetworkRxChain_t;
+
+	/*
+	 * Add a received packet to the tail of pxChain.  When the chain holds
+	 * ipconfigMAX_LINKED_RX_MESSAGES packets, it is passed to the IP-task.
+	 */
+	void vNetworkRxChainAppend( NetworkRxChain_t *pxChain, NetworkBufferDescriptor_t *pxBuffer, TickType_t xTimeout );
+
+	/*
+	 * Pass all packets in pxChain to the IP-task with a single event.  If that
+	 * fails, the packets are released.  The chain is empty afterwards.  Returns
+	 * pdFAIL only when the event could not be sent, an empty chain is not sent.
+	 */
+	BaseType_t xNetworkRxChainSend( NetworkRxChain_t *pxChain, TickType_t xTimeout );
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+/*
+ * For network interfaces with a ring of DMA RX descriptors: take the frame of
+ * xLength bytes that the DMA has written into *ppucDMABuffer, and return it in
+ * a network buffer, or NULL when the frame must be dropped.
+ * With ipconfigZERO_COPY_RX_DRIVER, *ppucDMABuffer must be the
+ * 'pucEthernetBuffer' of a network buffer.  That buffer is returned, and
+ * *ppucDMABuffer is replaced with a new network buffer of xRefillSize bytes,
+ * which the driver gives to the descriptor.  Otherwise the frame is copied
+ * into a new network buffer and *ppucDMABuffer is not changed.  Nothing is
+ * allocated while uxMinimumFree or fewer network buffers are free, and the
+ * DMA buffer keeps its place when the frame is dropped.
+ */
+NetworkBufferDescriptor_t *pxNetworkRxTakeBuffer( uint8_t **ppucDMABuffer, size_t xLength, size_t xRefillSize, UBaseType_t uxMinimumFree, TickType_t xBlockTime );
+
 /*
  * Returns a pointer to the original NetworkBuffer from a pointer to a UDP
  * payload buffer.
  */
 NetworkBufferDescriptor_t *pxUDPPayloadBuffer_to_NetworkBuffer( void *pvBuffer );
 
-#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+#if( ipconfigZERO_COPY_TX_DRIVER != 0 ) || ( ipconfigZERO_COPY_RX_DRIVER != 0 )
 	/*
 	 * For the case where the network driver passes a buffer directly to a DMA
 	 * descriptor, this function can be used to translate a 'network buffer' to
@@ -790,10 +984,18 @@ typedef struct xSOCKET_SET
 	EventGroupHandle_t xSelectGroup;
 	BaseType_t bApiCalled;	/* True if the API was calling  the private vSocketSelect */
 	FreeRTOS_Socket_t *pxSocket;
+	/* The members that may have events: those that had an event since the
+	last vSocketSelect() and those that were found ready by it.  Only these
+	are checked by vSocketSelect(). */
+	List_t xReadyList;
 } SocketSelect_t;
 
 extern void vSocketSelect( SocketSelect_t *pxSocketSelect );
 
+/* Put a socket on the ready list of its socket set, to have it checked by the
+next vSocketSelect(). */
+void vSocketSelectReady( FreeRTOS_Socket_t *pxSocket );
+
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 
 void vIPSetDHCPTimerEnableState( BaseType_t xEnableState );
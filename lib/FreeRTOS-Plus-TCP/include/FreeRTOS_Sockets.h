@@ -132,8 +132,29 @@ FreeRTOS_setsockopt(). */
 
 #define FREERTOS_SO_SET_LOW_HIGH_WATER	( 18 )
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	#define FREERTOS_SO_TCP_CONGESTION_CONTROL	( 19 )	/* Select the congestion control algorithm of a TCP socket. Supply a pointer to 'TCPCongestionOps_t', e.g. &xTCPCongestionCubic */
+#endif
+
+#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+	#define FREERTOS_SO_TCP_ACK_POLICY	( 20 )	/* Determine when received data is acknowledged, parameter is pointer to AckPolicy_t */
+#endif
+
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	#define FREERTOS_SO_PRIORITY		( 21 )	/* Select the transmit traffic class of a socket, 0 being the highest priority. Parameter is pointer to BaseType_t */
+#endif
+
+#if( ipconfigTCP_FAST_OPEN != 0 )
+	#define FREERTOS_SO_TCP_FASTOPEN	( 22 )	/* Connect using TCP Fast Open, data sent to a bound socket before connecting may go along with the SYN. Parameter is pointer to BaseType_t */
+#endif
+
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	#define FREERTOS_SO_UDP_PEER		( 23 )	/* Give a UDP socket a fixed peer, FreeRTOS_sendto() may then be called with a NULL address. Parameter is pointer to 'struct freertos_sockaddr', NULL to remove the peer */
+#endif
+
 #define FREERTOS_NOT_LAST_IN_FRAGMENTED_PACKET 	( 0x80 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 #define FREERTOS_FRAGMENTED_PACKET				( 0x40 )  /* For internal use only, but also part of an 8-bit bitwise value. */
+#define FREERTOS_UDP_TEMPLATE_REQUEST			( 0x20 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 
 /* Values for flag for FreeRTOS_shutdown(). */
 #define FREERTOS_SHUT_RD				( 0 )		/* Not really at this moment, just for compatibility of the interface */
@@ -162,6 +183,13 @@ typedef struct xLOW_HIGH_WATER {
 	size_t uxEnoughSpace;	/* Send a GO when buffer space grows above X bytes */
 } LowHighWater_t;
 
+typedef struct xACK_POLICY {
+	/* Structure to pass for the 'FREERTOS_SO_TCP_ACK_POLICY' option */
+	UBaseType_t uxAckEvery;		/* Send an ACK after at most X full-size segments, 0 for no limit ( max 255 ) */
+	UBaseType_t uxMaxDelayMs;	/* Delay an ACK at most X ms, 0 to acknowledge every segment immediately ( max 500 ) */
+	BaseType_t xAckOnPush;		/* pdTRUE: acknowledge a segment with the PSH flag immediately */
+} AckPolicy_t;
+
 /* For compatibility with the expected Berkeley sockets naming. */
 #define socklen_t uint32_t
 
@@ -212,6 +240,17 @@ struct freertos_sockaddr
 
 #endif /* ipconfigBYTE_ORDER */
 
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS != 0 )
+	/* One datagram passed to FreeRTOS_recvmmsg() or FreeRTOS_sendmmsg(). */
+	struct freertos_mmsghdr
+	{
+		void *pvBuffer;		/* The payload.  Set by FreeRTOS_recvmmsg() when FREERTOS_ZERO_COPY is used. */
+		size_t xBufferLength;	/* The size of pvBuffer, or the number of bytes to send. */
+		struct freertos_sockaddr xAddress;	/* The source or the destination of the datagram. */
+		int32_t lLength;	/* Set to the number of bytes received or sent. */
+	};
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+
 /* The socket type itself. */
 typedef void *Socket_t;
 
@@ -229,6 +268,21 @@ int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLengt
 int32_t FreeRTOS_sendto( Socket_t xSocket, const void *pvBuffer, size_t xTotalDataLength, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress, socklen_t xDestinationAddressLength );
 BaseType_t FreeRTOS_bind( Socket_t xSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength );
 
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS != 0 )
+	/* Receive up to uxMessageCount datagrams from a UDP socket, taking them
+	from the socket in a single critical section.  Blocks like
+	FreeRTOS_recvfrom() until at least one datagram is available, and returns
+	the number of entries filled in, or a negative errno value.  With
+	FREERTOS_ZERO_COPY, each returned pvBuffer must be released with
+	FreeRTOS_ReleaseUDPPayloadBuffer().  FREERTOS_MSG_PEEK is not supported. */
+	int32_t FreeRTOS_recvmmsg( Socket_t xSocket, struct freertos_mmsghdr *pxMessages, size_t uxMessageCount, BaseType_t xFlags );
+
+	/* Send uxMessageCount datagrams with FreeRTOS_sendto() semantics.  Returns
+	the number of datagrams queued for sending; it stops at the first one that
+	could not be queued. */
+	int32_t FreeRTOS_sendmmsg( Socket_t xSocket, struct freertos_mmsghdr *pxMessages, size_t uxMessageCount, BaseType_t xFlags );
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+
 /* function to get the local address and IP port */
 size_t FreeRTOS_GetLocalAddress( Socket_t xSocket, struct freertos_sockaddr *pxAddress );
 
@@ -294,6 +348,56 @@ FreeRTOS_rx_size(). */
  */
 uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength );
 
+/*
+ * For advanced applications only:
+ * Send 'uxDataLength' bytes that were written at the location returned by
+ * FreeRTOS_get_tx_head(), without copying them.  Returns the number of bytes
+ * passed, or a negative error code.
+ */
+BaseType_t FreeRTOS_commit_tx( Socket_t xSocket, size_t uxDataLength );
+
+/*
+ * For advanced applications only:
+ * Get direct pointers to all data in the circular receive buffer, so that it
+ * can be parsed in place.  Data that wraps around the end of the buffer is
+ * returned in a second part, '*ppucSecond' is NULL when there is none.
+ * Returns the total number of bytes.  Call FreeRTOS_recv( xSocket, NULL, xCount, 0 )
+ * to release the first 'xCount' bytes after use.
+ */
+BaseType_t FreeRTOS_get_rx_regions( Socket_t xSocket, uint8_t **ppucFirst, size_t *puxFirstLength, uint8_t **ppucSecond, size_t *puxSecondLength );
+
+#if( ipconfigTCP_CONNECTION_STATS != 0 )
+
+	typedef struct xTCP_SOCKET_STATS {
+		/* Structure filled in by FreeRTOS_TCPSnapshot(), one per TCP socket */
+		uint32_t ulRemoteIP;		/* IP address of the peer, host-endian, 0 for a listening socket */
+		uint16_t usLocalPort;		/* Port on this machine, host-endian */
+		uint16_t usRemotePort;		/* Port on the peer, host-endian */
+		uint8_t ucTCPState;			/* One of eIPTCPState_t, see FreeRTOS_GetTCPStateName() */
+		uint32_t ulBytesReceived;	/* Bytes received from the peer */
+		uint32_t ulBytesAcked;		/* Bytes sent and acknowledged by the peer */
+		uint32_t ulRetransmitCount;	/* Segments that were sent more than once */
+	} TCPSocketStats_t;
+
+	typedef struct xTCP_STACK_STATS {
+		/* Totals of all TCP sockets, including the ones that were closed */
+		uint32_t ulBytesReceived;
+		uint32_t ulBytesAcked;
+		uint32_t ulRetransmitCount;
+		uint32_t ulEstablishedCount;	/* Bound sockets that are in the eESTABLISHED state */
+	} TCPStackStats_t;
+
+	/*
+	 * Copy the counters of at most 'xMaxCount' bound TCP sockets to 'pxStats',
+	 * and the totals to 'pxTotals'.  Either pointer may be NULL.  The
+	 * scheduler is suspended while the list of sockets is read, the IP-task
+	 * is not involved.  Returns the number of bound TCP sockets, which may be
+	 * larger than 'xMaxCount'.
+	 */
+	BaseType_t FreeRTOS_TCPSnapshot( TCPSocketStats_t *pxStats, BaseType_t xMaxCount, TCPStackStats_t *pxTotals );
+
+#endif /* ipconfigTCP_CONNECTION_STATS */
+
 #endif /* ipconfigUSE_TCP */
 
 /*
@@ -30,6 +30,8 @@
  *	An implementation of a circular buffer without a length field
  *	If LENGTH defines the size of the buffer, a maximum of (LENGT-1) bytes can be stored
  *	In order to add or read data from the buffer, memcpy() will be called at most 2 times
+ *	There is one writer, which moves uxHead and uxFront, and one reader, which
+ *	moves uxTail, so there is no need for critical sections.
  */
 
 #ifndef FREERTOS_STREAM_BUFFER_H
@@ -226,6 +228,28 @@ size_t uxSize = uxStreamBufferGetSize( pxBuffer );
 
 	return FreeRTOS_min_uint32( uxSize, pxBuffer->LENGTH - uxNextTail );
 }
+/*-----------------------------------------------------------*/
+
+static portINLINE size_t uxStreamBufferGetRegions( StreamBuffer_t *pxBuffer, uint8_t **ppucFirst, size_t *puxFirstLength, uint8_t **ppucSecond, size_t *puxSecondLength );
+static portINLINE size_t uxStreamBufferGetRegions( StreamBuffer_t *pxBuffer, uint8_t **ppucFirst, size_t *puxFirstLength, uint8_t **ppucSecond, size_t *puxSecondLength )
+{
+/* Returns pointers to all available items, which may consist of two parts
+when they wrap around the end of ucArray[].  The items can be inspected in
+place and released afterwards by calling uxStreamBufferGet() with pucData
+equal to NULL. */
+size_t uxNextTail = pxBuffer->uxTail;
+size_t uxSize = uxStreamBufferGetSize( pxBuffer );
+
+	/* Do not read the items before uxHead has been read. */
+	ipconfigSTREAM_BUFFER_BARRIER();
+
+	*ppucFirst = pxBuffer->ucArray + uxNextTail;
+	*puxFirstLength = FreeRTOS_min_uint32( uxSize, pxBuffer->LENGTH - uxNextTail );
+	*puxSecondLength = uxSize - *puxFirstLength;
+	*ppucSecond = ( *puxSecondLength != 0u ) ? pxBuffer->ucArray : NULL;
+
+	return uxSize;
+}
 
 /*
  * Add bytes to a stream buffer.
@@ -55,13 +55,20 @@ typedef struct xTCP_SEGMENT
 		{
 			uint32_t
 				ucTransmitCount : 8,/* Number of times the segment has been transmitted, used to calculate the RTT */
-				ucDupAckCount : 8,	/* Counts the number of times that a higher segment was ACK'd. After 3 times a Fast Retransmission takes place */
+				ucDupAckCount : 8,	/* Set to 3 when a Fast Retransmission takes place, because 3 higher segments were ACK'd.  Cleared by a normal retransmission */
 				bOutstanding : 1,	/* It the peer's turn, we're just waiting for an ACK */
 				bAcked : 1,			/* This segment has been acknowledged */
 				bIsForRx : 1;		/* pdTRUE if segment is used for reception */
+		#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+			uint32_t
+				bChecksumKnown : 1;	/* usDataChecksum holds the sum of the data of this segment */
+		#endif
 		} bits;
 		uint32_t ulFlags;
 	} u;
+#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+	uint16_t usDataChecksum;		/* TX only: one's complement sum of the data, as returned by usGenerateChecksum() */
+#endif
 #if( ipconfigUSE_TCP_WIN != 0 )
 	struct xLIST_ITEM xQueueItem;	/* TX only: segments can be linked in one of three queues: xPriorityQueue, xTxQueue, and xWaitQueue */
 	struct xLIST_ITEM xListItem;	/* With this item the segment can be connected to a list, depending on who is owning it */
@@ -85,6 +92,45 @@ typedef struct xTCP_WINSIZE
 	#define ipSIZE_TCP_OPTIONS   12u
 #endif
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	/*
+	 *	The state of the congestion control of a TCP connection.  All windows
+	 *	are expressed in bytes.
+	 */
+	typedef struct xTCP_CONGESTION
+	{
+		uint32_t ulWindow;					/* cwnd: the number of bytes that may be outstanding */
+		uint32_t ulSlowStartThreshold;		/* ssthresh: slow start is used as long as ulWindow is below this value */
+		uint32_t ulBytesAcked;				/* Bytes ACK'd in congestion avoidance, not yet accounted for in ulWindow */
+		uint32_t ulRecoverSequenceNumber;	/* The highest sequence number sent when loss recovery started */
+		BaseType_t xInRecovery;				/* pdTRUE from a fast retransmission until ulRecoverSequenceNumber gets ACK'd */
+	#if( ipconfigTCP_CONGESTION_CUBIC != 0 )
+		uint32_t ulCubicMaxWindow;			/* W_max: the window before the last reduction */
+		uint32_t ulCubicLastMaxWindow;		/* The previous W_max, used for fast convergence */
+		uint32_t ulCubicOrigin;				/* The window which the cubic function aims at */
+		uint32_t ulCubicK;					/* The time (ms) after which the cubic function reaches ulCubicOrigin */
+		uint32_t ulCubicEstimate;			/* W_est: the window that NewReno would have had */
+		TCPTimer_t xCubicEpoch;				/* The start of the current congestion avoidance period */
+		BaseType_t xCubicEpochStarted;		/* pdFALSE when the next ACK starts a new period */
+	#endif /* ipconfigTCP_CONGESTION_CUBIC */
+	} TCPCongestion_t;
+
+	struct xTCP_WINDOW;
+
+	/*
+	 *	A congestion control algorithm.  The functions are called from the IP-task
+	 *	and update pxWindow->xCongestion.
+	 */
+	typedef struct xTCP_CONGESTION_OPS
+	{
+		const char *pcName;
+		void ( *vInit )( struct xTCP_WINDOW *pxWindow );							/* A connection has been established */
+		void ( *vOnAck )( struct xTCP_WINDOW *pxWindow, uint32_t ulBytesAcked );	/* New data was ACK'd, outside loss recovery */
+		void ( *vOnLoss )( struct xTCP_WINDOW *pxWindow );							/* A fast retransmission starts loss recovery */
+		void ( *vOnTimeout )( struct xTCP_WINDOW *pxWindow );						/* The retransmission timer has expired */
+	} TCPCongestionOps_t;
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 /*
  *	Every TCP connection owns a TCP window for the administration of all packets
  *	It owns two sets of segment descriptors, incoming and outgoing
@@ -134,6 +180,16 @@ typedef struct xTCP_WINDOW
 	uint16_t usPeerPortNumber;			/* debugging/logging: the peer's TCP port number */
 	uint16_t usMSS;						/* Current accepted MSS */
 	uint16_t usMSSInit;					/* MSS as configured by the socket owner */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	const TCPCongestionOps_t *pxCongestionOps;	/* The congestion control algorithm in use */
+	TCPCongestion_t xCongestion;
+#endif
+#if( ipconfigTCP_CONNECTION_STATS != 0 )
+	uint32_t ulRetransmitCount;			/* Number of segments that were sent more than once */
+#endif
+#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+	TCPSegment_t *pxLastTxSegment;		/* The segment returned by the last call to ulTCPWindowTxGet() */
+#endif
 } TCPWindow_t;
 
 
@@ -199,12 +255,33 @@ BaseType_t xTCPWindowTxDone( TCPWindow_t *pxWindow );
  * apPos will point to a location with the circular data buffer: txStream */
 uint32_t ulTCPWindowTxGet( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition );
 
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	/* Like ulTCPWindowTxGet(), but when new data is to be sent, it fetches as
+	 * many consecutive segments as fit in ulMaxLength bytes, to be sent as a
+	 * single super-segment */
+	uint32_t ulTCPWindowTxGetLarge( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition, uint32_t ulMaxLength );
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
 /* Receive a normal ACK */
 uint32_t ulTCPWindowTxAck( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 
 /* Receive a SACK option */
 uint32_t ulTCPWindowTxSack( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast );
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	/* The number of bytes that have been sent but not yet acknowledged, the
+	 * 'flight size' used by the congestion control algorithms */
+	uint32_t ulTCPWindowTxOutstanding( const TCPWindow_t *pxWindow );
+
+	/* The available congestion control algorithms, see
+	 * FREERTOS_SO_TCP_CONGESTION_CONTROL */
+	extern const TCPCongestionOps_t xTCPCongestionNewReno;
+
+	#if( ipconfigTCP_CONGESTION_CUBIC != 0 )
+		extern const TCPCongestionOps_t xTCPCongestionCubic;
+	#endif
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 
 #ifdef __cplusplus
 }	/* extern "C" */
@@ -78,6 +78,22 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptracePACKET_DROPPED_TO_GENERATE_ARP( ulIPAddress )
 #endif
 
+#ifndef iptracePACKET_HELD_FOR_ARP
+	#define iptracePACKET_HELD_FOR_ARP( ulIPAddress )
+#endif
+
+#ifndef iptraceHELD_PACKET_DROPPED
+	#define iptraceHELD_PACKET_DROPPED( ulIPAddress )
+#endif
+
+#ifndef iptraceLOOPBACK_PACKET_SENT
+	#define iptraceLOOPBACK_PACKET_SENT( pxNetworkBuffer )
+#endif
+
+#ifndef iptraceTX_FRAME_DROPPED
+	#define iptraceTX_FRAME_DROPPED( pxNetworkBuffer )
+#endif
+
 #ifndef iptraceICMP_PACKET_RECEIVED
 	#define iptraceICMP_PACKET_RECEIVED()
 #endif
@@ -122,6 +138,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceNETWORK_EVENT_RECEIVED( eEvent )
 #endif
 
+#ifndef iptraceNETWORK_EVENT_PROCESSED
+	#define iptraceNETWORK_EVENT_PROCESSED( eEvent )
+#endif
+
 #ifndef iptraceBIND_FAILED
 	#define iptraceBIND_FAILED( xSocket, usPort )
 #endif
@@ -45,6 +45,20 @@ UBaseType_t uxGetNumberOfFreeNetworkBuffers( void );
 /* Get the lowest number of free network buffers. */
 UBaseType_t uxGetMinimumFreeNetworkBuffers( void );
 
+#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+	/* The size classes of BufferAllocation_2.c. */
+	#define ipNETWORK_BUFFER_CLASS_SMALL	( 0u )
+	#define ipNETWORK_BUFFER_CLASS_MEDIUM	( 1u )
+	#define ipNETWORK_BUFFER_CLASS_LARGE	( 2u )
+	#define ipNETWORK_BUFFER_CLASS_COUNT	( 3u )
+
+	/* Get the current number of free slabs in a size class. */
+	UBaseType_t uxGetNumberOfFreeNetworkBuffersOfClass( UBaseType_t uxClass );
+
+	/* Get the lowest number of free slabs in a size class. */
+	UBaseType_t uxGetMinimumFreeNetworkBuffersOfClass( UBaseType_t uxClass );
+#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+
 /* Copy a network buffer into a bigger buffer. */
 NetworkBufferDescriptor_t *pxDuplicateNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer,
 	BaseType_t xNewLength);
@@ -57,6 +57,35 @@ entry is still valid and can therefore be refreshed. */
 	#define arpGRATUITOUS_ARP_PERIOD					( pdMS_TO_TICKS( 20000 ) )
 #endif
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	/* The number of times vARPAgeCache() is called before a packet that is
+	still waiting for an ARP reply is dropped. */
+	#define arpMAX_HELD_PACKET_AGE						( 2u )
+#endif
+
+#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+	#if( ( ipconfigARP_CACHE_HASH_SIZE & ( ipconfigARP_CACHE_HASH_SIZE - 1 ) ) != 0 )
+		#error ipconfigARP_CACHE_HASH_SIZE must be a power of 2
+	#endif
+
+	#if( ipconfigARP_CACHE_ENTRIES > 0xfffe )
+		#error ipconfigARP_CACHE_ENTRIES is too large for the hashed ARP cache
+	#endif
+
+	/* Entries of xARPCache[] are referred to by their index plus one, so that
+	zero can mean 'no entry' and the zero-initialised links are all empty. */
+	#define arpNO_ENTRY						( ( uint16_t ) 0u )
+	#define arpENTRY_REF( x )				( ( uint16_t ) ( ( x ) + 1 ) )
+	#define arpENTRY_INDEX( usRef )			( ( BaseType_t ) ( usRef ) - 1 )
+
+	#define arpHASH_MASK					( ( UBaseType_t ) ipconfigARP_CACHE_HASH_SIZE - 1u )
+
+	/* Bits of ucFlags: which bucket lists the entry is on. */
+	#define arpLINKED_IP					( ( uint8_t ) 0x01u )
+	#define arpLINKED_MAC					( ( uint8_t ) 0x02u )
+	#define arpLINKED_LRU					( ( uint8_t ) 0x04u )
+#endif /* ipconfigARP_CACHE_HASH_SIZE */
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -64,15 +93,122 @@ entry is still valid and can therefore be refreshed. */
  */
 static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress );
 
+#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+	/*
+	 * Return the bucket of an IP-address or of a MAC-address.
+	 */
+	static UBaseType_t prvARPHashIP( uint32_t ulIPAddress );
+	static UBaseType_t prvARPHashMAC( const MACAddress_t * const pxMACAddress );
+
+	/*
+	 * Return the index of the entry holding ulIPAddress, or -1.
+	 */
+	static BaseType_t prvARPFindByIP( uint32_t ulIPAddress );
+
+	/*
+	 * Return the index of the valid entry holding pxMACAddress, or -1.
+	 */
+	static BaseType_t prvARPFindByMAC( const MACAddress_t * const pxMACAddress );
+
+	/*
+	 * Add entry x to the hash buckets of its IP- and MAC-address, as the most
+	 * recently used entry.  Only valid entries are indexed by MAC-address.
+	 */
+	static void prvARPLink( BaseType_t x );
+
+	/*
+	 * Remove entry x from the hash buckets and from the LRU list.
+	 */
+	static void prvARPUnlink( BaseType_t x );
+
+	/*
+	 * Return the index of an entry that can be (re-)used: a free entry if
+	 * there is one, otherwise the least recently used entry.  The entry is
+	 * unlinked.
+	 */
+	static BaseType_t prvARPAllocate( void );
+
+	/*
+	 * Unlink and clear entry x, and add it to the free entries.
+	 */
+	static void prvARPRelease( BaseType_t x );
+#endif /* ipconfigARP_CACHE_HASH_SIZE */
+
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	/*
+	 * Send the held packets that were waiting for the MAC address of
+	 * ulIPAddress.
+	 */
+	static void prvARPSendHeldPackets( uint32_t ulIPAddress );
+
+	/*
+	 * Remove the held packet at uxIndex, keeping the others in order.
+	 */
+	static void prvARPRemoveHeldPacket( UBaseType_t uxIndex );
+#endif /* ipconfigARP_PENDING_PACKETS */
+
 /*-----------------------------------------------------------*/
 
 /* The ARP cache. */
-static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
+portHOT_DATA static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
+
+/* The number of ARP cache lookups that did or did not find a valid entry. */
+static ARPCacheStatistics_t xARPCacheStatistics;
+
+#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+	/* The links of xARPCache[ x ] are in xARPLinks[ x ]. */
+	typedef struct xARP_CACHE_LINKS
+	{
+		uint16_t usNextIP;			/* Next entry in the same IP bucket, or the next free entry. */
+		uint16_t usNextMAC;			/* Next entry in the same MAC bucket. */
+		uint16_t usOlder;			/* Next less recently used entry. */
+		uint16_t usNewer;			/* Next more recently used entry. */
+		uint8_t ucFlags;			/* arpLINKED_IP, arpLINKED_MAC and arpLINKED_LRU. */
+	} ARPCacheLinks_t;
+
+	static ARPCacheLinks_t xARPLinks[ ipconfigARP_CACHE_ENTRIES ];
+
+	/* The first entry of each bucket. */
+	static uint16_t usARPIPBuckets[ ipconfigARP_CACHE_HASH_SIZE ];
+	static uint16_t usARPMACBuckets[ ipconfigARP_CACHE_HASH_SIZE ];
+
+	/* Both ends of the LRU list, which contains all the entries in use. */
+	static uint16_t usARPNewestEntry, usARPOldestEntry;
+
+	/* Entries that were released, and the number of entries ever taken into
+	use.  The entries from usARPEntriesTaken onward have never been used. */
+	static uint16_t usARPFreeEntry, usARPEntriesTaken;
+#endif /* ipconfigARP_CACHE_HASH_SIZE */
+
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	/* An outgoing packet that waits for an ARP reply. */
+	typedef struct xARP_HELD_PACKET
+	{
+		NetworkBufferDescriptor_t *pxNetworkBuffer;
+		uint32_t ulIPAddress;		/* The address being resolved. */
+		uint8_t ucAge;				/* Calls to vARPAgeCache() left before the packet is dropped. */
+	} ARPHeldPacket_t;
+
+	/* The held packets, oldest first, and their number. */
+	static ARPHeldPacket_t xARPHeldPackets[ ipconfigARP_PENDING_PACKETS ];
+	static UBaseType_t uxARPHeldCount = 0u;
+#endif /* ipconfigARP_PENDING_PACKETS */
 
 /* The time at which the last gratuitous ARP was sent.  Gratuitous ARPs are used
 to ensure ARP tables are up to date and to detect IP address conflicts. */
 static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
 
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	/* Connected UDP sockets compare this number with the one stored along with
+	their header template, see FreeRTOS_sendto(). */
+	volatile uint32_t ulARPCacheGeneration = 1UL;
+
+	static void prvARPCacheChanged( void );
+	#define arpCACHE_CHANGED()		prvARPCacheChanged()
+#else
+	#define arpCACHE_CHANGED()
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+
 /*
  * IP-clash detection is currently only used internally. When DHCP doesn't respond, the
  * driver can try out a random LinkLayer IP address (169.254.x.x).  It will send out a
@@ -192,16 +328,32 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 	BaseType_t x;
 	uint32_t lResult = 0;
 
-		/* For each entry in the ARP cache table. */
-		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+		#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
 		{
-			if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+			x = prvARPFindByMAC( pxMACAddress );
+
+			if( x >= 0 )
 			{
 				lResult = xARPCache[ x ].ulIPAddress;
-				memset( &xARPCache[ x ], '\0', sizeof( xARPCache[ x ] ) );
-				break;
+				prvARPRelease( x );
+				arpCACHE_CHANGED();
+			}
+		}
+		#else
+		{
+			/* For each entry in the ARP cache table. */
+			for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+			{
+				if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+				{
+					lResult = xARPCache[ x ].ulIPAddress;
+					memset( &xARPCache[ x ], '\0', sizeof( xARPCache[ x ] ) );
+					arpCACHE_CHANGED();
+					break;
+				}
 			}
 		}
+		#endif /* ipconfigARP_CACHE_HASH_SIZE */
 
 		return lResult;
 	}
@@ -211,11 +363,16 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 
 void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress, const uint32_t ulIPAddress )
 {
-BaseType_t x = 0;
 BaseType_t xIpEntry = -1;
 BaseType_t xMacEntry = -1;
 BaseType_t xUseEntry = 0;
-uint8_t ucMinAgeFound = 0U;
+#if( ipconfigARP_CACHE_HASH_SIZE == 0 )
+	BaseType_t x = 0;
+	uint8_t ucMinAgeFound = 0U;
+#endif
+#if( ( ipconfigARP_PENDING_PACKETS > 0 ) && ( ipconfigUSE_TCP == 1 ) )
+	BaseType_t xWasOutstanding = pdFALSE;
+#endif
 
 	#if( ipconfigARP_STORES_REMOTE_ADDRESSES == 0 )
 		/* Only process the IP address if it is on the local network.
@@ -233,6 +390,106 @@ uint8_t ucMinAgeFound = 0U;
 		if( pdTRUE )
 	#endif
 	{
+	#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+		xIpEntry = prvARPFindByIP( ulIPAddress );
+
+		if( ( xIpEntry >= 0 ) && ( pxMACAddress == NULL ) )
+		{
+			/* An entry already exists, or an ARP request is already
+			outstanding. */
+		}
+		else if( ( xIpEntry >= 0 ) &&
+				 ( xARPCache[ xIpEntry ].ucValid != ( uint8_t ) pdFALSE ) &&
+				 ( memcmp( xARPCache[ xIpEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+		{
+			/* The most common path: the entry is known and still correct. */
+			xARPCache[ xIpEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+			prvARPUnlink( xIpEntry );
+			prvARPLink( xIpEntry );
+		}
+		else
+		{
+			#if( ( ipconfigARP_PENDING_PACKETS > 0 ) && ( ipconfigUSE_TCP == 1 ) )
+			{
+				if( ( xIpEntry >= 0 ) && ( xARPCache[ xIpEntry ].ucValid == ( uint8_t ) pdFALSE ) )
+				{
+					xWasOutstanding = pdTRUE;
+				}
+			}
+			#endif
+
+			if( pxMACAddress != NULL )
+			{
+				/* Is the MAC-address known under a different IP-address? */
+				xMacEntry = prvARPFindByMAC( pxMACAddress );
+
+				#if( ipconfigARP_STORES_REMOTE_ADDRESSES != 0 )
+				{
+					/* The MAC address of the gateway should not be overwritten
+					by the addresses outside the network it is used for. */
+					if( xMacEntry >= 0 )
+					{
+					BaseType_t bIsLocal[ 2 ];
+
+						bIsLocal[ 0 ] = ( ( xARPCache[ xMacEntry ].ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) );
+						bIsLocal[ 1 ] = ( ( ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) );
+						if( bIsLocal[ 0 ] != bIsLocal[ 1 ] )
+						{
+							xMacEntry = -1;
+						}
+					}
+				}
+				#endif /* ipconfigARP_STORES_REMOTE_ADDRESSES */
+			}
+
+			if( xMacEntry >= 0 )
+			{
+				xUseEntry = xMacEntry;
+
+				if( xIpEntry >= 0 )
+				{
+					/* Both the MAC address as well as the IP address were
+					found in different entries: clear the entry which matches
+					the IP-address. */
+					prvARPRelease( xIpEntry );
+				}
+				prvARPUnlink( xUseEntry );
+			}
+			else if( xIpEntry >= 0 )
+			{
+				/* An entry containing the IP-address was found, but it had a
+				different MAC address, or it was waiting for an ARP reply. */
+				xUseEntry = xIpEntry;
+				prvARPUnlink( xUseEntry );
+			}
+			else
+			{
+				/* Use a free entry or else the least recently used one. */
+				xUseEntry = prvARPAllocate();
+			}
+
+			xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+			arpCACHE_CHANGED();
+
+			if( pxMACAddress != NULL )
+			{
+				memcpy( xARPCache[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) );
+
+				iptraceARP_TABLE_ENTRY_CREATED( ulIPAddress, (*pxMACAddress) );
+				/* And this entry does not need immediate attention */
+				xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+				xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdTRUE;
+			}
+			else
+			{
+				memset( xARPCache[ xUseEntry ].xMACAddress.ucBytes, '\0', sizeof( xARPCache[ xUseEntry ].xMACAddress.ucBytes ) );
+				xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_RETRANSMISSIONS;
+				xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdFALSE;
+			}
+
+			prvARPLink( xUseEntry );
+		}
+	#else
 		/* Start with the maximum possible number. */
 		ucMinAgeFound--;
 
@@ -304,6 +561,15 @@ uint8_t ucMinAgeFound = 0U;
 			}
 		}
 
+		#if( ( ipconfigARP_PENDING_PACKETS > 0 ) && ( ipconfigUSE_TCP == 1 ) )
+		{
+			if( ( xIpEntry >= 0 ) && ( xARPCache[ xIpEntry ].ucValid == ( uint8_t ) pdFALSE ) )
+			{
+				xWasOutstanding = pdTRUE;
+			}
+		}
+		#endif
+
 		if( xMacEntry >= 0 )
 		{
 			xUseEntry = xMacEntry;
@@ -324,6 +590,7 @@ uint8_t ucMinAgeFound = 0U;
 
 		/* If the entry was not found, we use the oldest entry and set the IPaddress */
 		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+		arpCACHE_CHANGED();
 
 		if( pxMACAddress != NULL )
 		{
@@ -339,6 +606,29 @@ uint8_t ucMinAgeFound = 0U;
 			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_RETRANSMISSIONS;
 			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdFALSE;
 		}
+	#endif /* ipconfigARP_CACHE_HASH_SIZE */
+
+		#if( ipconfigARP_PENDING_PACKETS > 0 )
+		{
+			if( pxMACAddress != NULL )
+			{
+				/* The MAC address of ulIPAddress is known now. */
+				if( uxARPHeldCount != 0u )
+				{
+					prvARPSendHeldPackets( ulIPAddress );
+				}
+
+				#if( ipconfigUSE_TCP == 1 )
+				{
+					if( xWasOutstanding != pdFALSE )
+					{
+						vTCPARPResolved();
+					}
+				}
+				#endif /* ipconfigUSE_TCP */
+			}
+		}
+		#endif /* ipconfigARP_PENDING_PACKETS */
 	}
 }
 /*-----------------------------------------------------------*/
@@ -349,18 +639,32 @@ uint8_t ucMinAgeFound = 0U;
 	BaseType_t x;
 	eARPLookupResult_t eReturn = eARPCacheMiss;
 
-		/* Loop through each entry in the ARP cache. */
-		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+		#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
 		{
-			/* Does this row in the ARP cache table hold an entry for the MAC
-			address being searched? */
-			if( memcmp( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+			x = prvARPFindByMAC( pxMACAddress );
+
+			if( x >= 0 )
 			{
 				*pulIPAddress = xARPCache[ x ].ulIPAddress;
 				eReturn = eARPCacheHit;
-				break;
 			}
 		}
+		#else
+		{
+			/* Loop through each entry in the ARP cache. */
+			for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+			{
+				/* Does this row in the ARP cache table hold an entry for the MAC
+				address being searched? */
+				if( memcmp( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+				{
+					*pulIPAddress = xARPCache[ x ].ulIPAddress;
+					eReturn = eARPCacheHit;
+					break;
+				}
+			}
+		}
+		#endif /* ipconfigARP_CACHE_HASH_SIZE */
 
 		return eReturn;
 	}
@@ -395,6 +699,14 @@ uint32_t ulAddressToLookup;
 		can be done. */
 		eReturn = eCantSendPacket;
 	}
+#if( ipconfigUSE_LOOPBACK != 0 )
+	else if( ( *pulIPAddress == *ipLOCAL_IP_ADDRESS_POINTER ) || ( ipIS_LOOPBACK_NETWORK( *pulIPAddress ) ) )
+	{
+		/* The packet is sent to this node, it will take the loopback path. */
+		memcpy( pxMACAddress->ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+		eReturn = eARPCacheHit;
+	}
+#endif /* ipconfigUSE_LOOPBACK */
 	else
 	{
 		eReturn = eARPCacheMiss;
@@ -463,14 +775,12 @@ static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress
 BaseType_t x;
 eARPLookupResult_t eReturn = eARPCacheMiss;
 
-	/* Loop through each entry in the ARP cache. */
-	for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+	#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
 	{
-		/* Does this row in the ARP cache table hold an entry for the IP address
-		being queried? */
-		if( xARPCache[ x ].ulIPAddress == ulAddressToLookup )
+		x = prvARPFindByIP( ulAddressToLookup );
+
+		if( x >= 0 )
 		{
-			/* A matching valid entry was found. */
 			if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
 			{
 				/* This entry is waiting an ARP reply, so is not valid. */
@@ -478,13 +788,50 @@ eARPLookupResult_t eReturn = eARPCacheMiss;
 			}
 			else
 			{
-				/* A valid entry was found. */
+				/* A valid entry was found, which is now the most recently
+				used one. */
 				memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
 				eReturn = eARPCacheHit;
+				prvARPUnlink( x );
+				prvARPLink( x );
+			}
+		}
+	}
+	#else
+	{
+		/* Loop through each entry in the ARP cache. */
+		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+		{
+			/* Does this row in the ARP cache table hold an entry for the IP address
+			being queried? */
+			if( xARPCache[ x ].ulIPAddress == ulAddressToLookup )
+			{
+				/* A matching valid entry was found. */
+				if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
+				{
+					/* This entry is waiting an ARP reply, so is not valid. */
+					eReturn = eCantSendPacket;
+				}
+				else
+				{
+					/* A valid entry was found. */
+					memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+					eReturn = eARPCacheHit;
+				}
+				break;
 			}
-			break;
 		}
 	}
+	#endif /* ipconfigARP_CACHE_HASH_SIZE */
+
+	if( eReturn == eARPCacheHit )
+	{
+		xARPCacheStatistics.ulHits++;
+	}
+	else
+	{
+		xARPCacheStatistics.ulMisses++;
+	}
 
 	return eReturn;
 }
@@ -527,11 +874,43 @@ TickType_t xTimeNow;
 			{
 				/* The entry is no longer valid.  Wipe it out. */
 				iptraceARP_TABLE_ENTRY_EXPIRED( xARPCache[ x ].ulIPAddress );
-				xARPCache[ x ].ulIPAddress = 0UL;
+				#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+				{
+					prvARPRelease( x );
+				}
+				#else
+				{
+					xARPCache[ x ].ulIPAddress = 0UL;
+				}
+				#endif /* ipconfigARP_CACHE_HASH_SIZE */
+				arpCACHE_CHANGED();
 			}
 		}
 	}
 
+	#if( ipconfigARP_PENDING_PACKETS > 0 )
+	{
+	UBaseType_t uxIndex = 0u;
+
+		/* Drop the packets that have waited too long for an ARP reply. */
+		while( uxIndex < uxARPHeldCount )
+		{
+			( xARPHeldPackets[ uxIndex ].ucAge )--;
+
+			if( xARPHeldPackets[ uxIndex ].ucAge == 0u )
+			{
+				iptraceHELD_PACKET_DROPPED( xARPHeldPackets[ uxIndex ].ulIPAddress );
+				vReleaseNetworkBufferAndDescriptor( xARPHeldPackets[ uxIndex ].pxNetworkBuffer );
+				prvARPRemoveHeldPacket( uxIndex );
+			}
+			else
+			{
+				uxIndex++;
+			}
+		}
+	}
+	#endif /* ipconfigARP_PENDING_PACKETS */
+
 	xTimeNow = xTaskGetTickCount ();
 
 	if( ( xLastGratuitousARPTime == ( TickType_t ) 0 ) || ( ( xTimeNow - xLastGratuitousARPTime ) > ( TickType_t ) arpGRATUITOUS_ARP_PERIOD ) )
@@ -581,7 +960,13 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		}
 		#endif
 
-		xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+		#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		{
+			pxNetworkBuffer->ucTxClass = 0u;
+		}
+		#endif /* ipconfigTX_PRIORITY_CLASSES */
+
+		ipDRIVER_OUTPUT( pxNetworkBuffer, pdTRUE );
 	}
 }
 
@@ -618,9 +1003,324 @@ ARPPacket_t *pxARPPacket;
 void FreeRTOS_ClearARP( void )
 {
 	memset( xARPCache, '\0', sizeof( xARPCache ) );
+	memset( &xARPCacheStatistics, '\0', sizeof( xARPCacheStatistics ) );
+	arpCACHE_CHANGED();
+
+	#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+	{
+		memset( xARPLinks, '\0', sizeof( xARPLinks ) );
+		memset( usARPIPBuckets, '\0', sizeof( usARPIPBuckets ) );
+		memset( usARPMACBuckets, '\0', sizeof( usARPMACBuckets ) );
+		usARPNewestEntry = arpNO_ENTRY;
+		usARPOldestEntry = arpNO_ENTRY;
+		usARPFreeEntry = arpNO_ENTRY;
+		usARPEntriesTaken = 0u;
+	}
+	#endif /* ipconfigARP_CACHE_HASH_SIZE */
+
+	#if( ipconfigARP_PENDING_PACKETS > 0 )
+	{
+		while( uxARPHeldCount != 0u )
+		{
+			vReleaseNetworkBufferAndDescriptor( xARPHeldPackets[ 0 ].pxNetworkBuffer );
+			prvARPRemoveHeldPacket( 0u );
+		}
+	}
+	#endif /* ipconfigARP_PENDING_PACKETS */
 }
 /*-----------------------------------------------------------*/
 
+void vARPGetCacheStatistics( ARPCacheStatistics_t *pxStatistics )
+{
+	/* The counters are only written by the IP-task. */
+	taskENTER_CRITICAL();
+	{
+		*pxStatistics = xARPCacheStatistics;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_CACHE_HASH_SIZE > 0 )
+
+	static UBaseType_t prvARPHashIP( uint32_t ulIPAddress )
+	{
+	uint32_t ulHash = ulIPAddress * 0x9E3779B1ul;
+
+		return ( UBaseType_t ) ( ulHash >> 16 ) & arpHASH_MASK;
+	}
+	/*-----------------------------------------------------------*/
+
+	static UBaseType_t prvARPHashMAC( const MACAddress_t * const pxMACAddress )
+	{
+	uint32_t ulHash;
+
+		/* The last bytes of a MAC-address differ most between devices. */
+		ulHash = ( ( uint32_t ) pxMACAddress->ucBytes[ 2 ] << 24 ) |
+				 ( ( uint32_t ) pxMACAddress->ucBytes[ 3 ] << 16 ) |
+				 ( ( uint32_t ) pxMACAddress->ucBytes[ 4 ] << 8 ) |
+				 ( uint32_t ) pxMACAddress->ucBytes[ 5 ];
+		ulHash ^= ( ( uint32_t ) pxMACAddress->ucBytes[ 0 ] << 8 ) | ( uint32_t ) pxMACAddress->ucBytes[ 1 ];
+		ulHash *= 0x9E3779B1ul;
+
+		return ( UBaseType_t ) ( ulHash >> 16 ) & arpHASH_MASK;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPFindByIP( uint32_t ulIPAddress )
+	{
+	uint16_t usEntry = usARPIPBuckets[ prvARPHashIP( ulIPAddress ) ];
+
+		while( ( usEntry != arpNO_ENTRY ) && ( xARPCache[ arpENTRY_INDEX( usEntry ) ].ulIPAddress != ulIPAddress ) )
+		{
+			usEntry = xARPLinks[ arpENTRY_INDEX( usEntry ) ].usNextIP;
+		}
+
+		return arpENTRY_INDEX( usEntry );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPFindByMAC( const MACAddress_t * const pxMACAddress )
+	{
+	uint16_t usEntry = usARPMACBuckets[ prvARPHashMAC( pxMACAddress ) ];
+
+		while( ( usEntry != arpNO_ENTRY ) &&
+			   ( memcmp( xARPCache[ arpENTRY_INDEX( usEntry ) ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) != 0 ) )
+		{
+			usEntry = xARPLinks[ arpENTRY_INDEX( usEntry ) ].usNextMAC;
+		}
+
+		return arpENTRY_INDEX( usEntry );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPLink( BaseType_t x )
+	{
+	ARPCacheLinks_t *pxLinks = &( xARPLinks[ x ] );
+	uint16_t *pusBucket;
+
+		configASSERT( pxLinks->ucFlags == 0u );
+
+		if( xARPCache[ x ].ulIPAddress != 0ul )
+		{
+			pusBucket = &( usARPIPBuckets[ prvARPHashIP( xARPCache[ x ].ulIPAddress ) ] );
+			pxLinks->usNextIP = *pusBucket;
+			*pusBucket = arpENTRY_REF( x );
+			pxLinks->ucFlags |= arpLINKED_IP;
+		}
+
+		if( xARPCache[ x ].ucValid != ( uint8_t ) pdFALSE )
+		{
+			pusBucket = &( usARPMACBuckets[ prvARPHashMAC( &( xARPCache[ x ].xMACAddress ) ) ] );
+			pxLinks->usNextMAC = *pusBucket;
+			*pusBucket = arpENTRY_REF( x );
+			pxLinks->ucFlags |= arpLINKED_MAC;
+		}
+
+		/* Insert as the most recently used entry. */
+		pxLinks->usNewer = arpNO_ENTRY;
+		pxLinks->usOlder = usARPNewestEntry;
+
+		if( usARPNewestEntry != arpNO_ENTRY )
+		{
+			xARPLinks[ arpENTRY_INDEX( usARPNewestEntry ) ].usNewer = arpENTRY_REF( x );
+		}
+		else
+		{
+			usARPOldestEntry = arpENTRY_REF( x );
+		}
+
+		usARPNewestEntry = arpENTRY_REF( x );
+		pxLinks->ucFlags |= arpLINKED_LRU;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPUnlink( BaseType_t x )
+	{
+	ARPCacheLinks_t *pxLinks = &( xARPLinks[ x ] );
+	uint16_t *pusLink;
+
+		if( ( pxLinks->ucFlags & arpLINKED_IP ) != 0u )
+		{
+			pusLink = &( usARPIPBuckets[ prvARPHashIP( xARPCache[ x ].ulIPAddress ) ] );
+
+			while( *pusLink != arpENTRY_REF( x ) )
+			{
+				configASSERT( *pusLink != arpNO_ENTRY );
+				pusLink = &( xARPLinks[ arpENTRY_INDEX( *pusLink ) ].usNextIP );
+			}
+
+			*pusLink = pxLinks->usNextIP;
+		}
+
+		if( ( pxLinks->ucFlags & arpLINKED_MAC ) != 0u )
+		{
+			pusLink = &( usARPMACBuckets[ prvARPHashMAC( &( xARPCache[ x ].xMACAddress ) ) ] );
+
+			while( *pusLink != arpENTRY_REF( x ) )
+			{
+				configASSERT( *pusLink != arpNO_ENTRY );
+				pusLink = &( xARPLinks[ arpENTRY_INDEX( *pusLink ) ].usNextMAC );
+			}
+
+			*pusLink = pxLinks->usNextMAC;
+		}
+
+		if( ( pxLinks->ucFlags & arpLINKED_LRU ) != 0u )
+		{
+			if( pxLinks->usNewer != arpNO_ENTRY )
+			{
+				xARPLinks[ arpENTRY_INDEX( pxLinks->usNewer ) ].usOlder = pxLinks->usOlder;
+			}
+			else
+			{
+				usARPNewestEntry = pxLinks->usOlder;
+			}
+
+			if( pxLinks->usOlder != arpNO_ENTRY )
+			{
+				xARPLinks[ arpENTRY_INDEX( pxLinks->usOlder ) ].usNewer = pxLinks->usNewer;
+			}
+			else
+			{
+				usARPOldestEntry = pxLinks->usNewer;
+			}
+		}
+
+		memset( pxLinks, '\0', sizeof( *pxLinks ) );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPAllocate( void )
+	{
+	BaseType_t x;
+
+		if( usARPFreeEntry != arpNO_ENTRY )
+		{
+			x = arpENTRY_INDEX( usARPFreeEntry );
+			usARPFreeEntry = xARPLinks[ x ].usNextIP;
+			xARPLinks[ x ].usNextIP = arpNO_ENTRY;
+		}
+		else if( usARPEntriesTaken < ( uint16_t ) ipconfigARP_CACHE_ENTRIES )
+		{
+			x = ( BaseType_t ) usARPEntriesTaken;
+			usARPEntriesTaken++;
+		}
+		else
+		{
+			/* All the entries are in use, replace the least recently used. */
+			x = arpENTRY_INDEX( usARPOldestEntry );
+			prvARPUnlink( x );
+		}
+
+		return x;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPRelease( BaseType_t x )
+	{
+		prvARPUnlink( x );
+		memset( &( xARPCache[ x ] ), '\0', sizeof( xARPCache[ x ] ) );
+
+		/* A free entry is on none of the bucket lists, so usNextIP can be used
+		to link the free entries. */
+		xARPLinks[ x ].usNextIP = usARPFreeEntry;
+		usARPFreeEntry = arpENTRY_REF( x );
+	}
+
+#endif /* ipconfigARP_CACHE_HASH_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+
+	static void prvARPCacheChanged( void )
+	{
+		/* Only the IP-task writes the counter.  Zero is skipped, it marks a
+		header template that is not valid. */
+		ulARPCacheGeneration++;
+
+		if( ulARPCacheGeneration == 0UL )
+		{
+			ulARPCacheGeneration = 1UL;
+		}
+	}
+
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+
+	BaseType_t xARPHoldPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulIPAddress )
+	{
+	UBaseType_t uxIndex, uxForAddress = 0u;
+	BaseType_t xReturn = pdFAIL;
+
+		for( uxIndex = 0u; uxIndex < uxARPHeldCount; uxIndex++ )
+		{
+			if( xARPHeldPackets[ uxIndex ].ulIPAddress == ulIPAddress )
+			{
+				uxForAddress++;
+			}
+		}
+
+		if( ( uxARPHeldCount < ( UBaseType_t ) ipconfigARP_PENDING_PACKETS ) &&
+			( uxForAddress < ( UBaseType_t ) ipconfigARP_PENDING_PACKETS_PER_ADDRESS ) )
+		{
+			iptracePACKET_HELD_FOR_ARP( ulIPAddress );
+			xARPHeldPackets[ uxARPHeldCount ].pxNetworkBuffer = pxNetworkBuffer;
+			xARPHeldPackets[ uxARPHeldCount ].ulIPAddress = ulIPAddress;
+			xARPHeldPackets[ uxARPHeldCount ].ucAge = ( uint8_t ) arpMAX_HELD_PACKET_AGE;
+			uxARPHeldCount++;
+			xReturn = pdPASS;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPSendHeldPackets( uint32_t ulIPAddress )
+	{
+	NetworkBufferDescriptor_t *pxToSend[ ipconfigARP_PENDING_PACKETS_PER_ADDRESS ];
+	UBaseType_t uxIndex = 0u, uxCount = 0u;
+
+		/* Take the packets out first: sending one may hold it again, if the
+		address turns out to be unusable after all. */
+		while( uxIndex < uxARPHeldCount )
+		{
+			if( ( xARPHeldPackets[ uxIndex ].ulIPAddress == ulIPAddress ) &&
+				( uxCount < ( UBaseType_t ) ipconfigARP_PENDING_PACKETS_PER_ADDRESS ) )
+			{
+				pxToSend[ uxCount ] = xARPHeldPackets[ uxIndex ].pxNetworkBuffer;
+				uxCount++;
+				prvARPRemoveHeldPacket( uxIndex );
+			}
+			else
+			{
+				uxIndex++;
+			}
+		}
+
+		/* Send them in the order in which they were held. */
+		for( uxIndex = 0u; uxIndex < uxCount; uxIndex++ )
+		{
+			vProcessGeneratedUDPPacket( pxToSend[ uxIndex ] );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPRemoveHeldPacket( UBaseType_t uxIndex )
+	{
+		uxARPHeldCount--;
+
+		if( uxIndex < uxARPHeldCount )
+		{
+			memmove( &( xARPHeldPackets[ uxIndex ] ), &( xARPHeldPackets[ uxIndex + 1u ] ), ( uxARPHeldCount - uxIndex ) * sizeof( xARPHeldPackets[ 0 ] ) );
+		}
+	}
+
+#endif /* ipconfigARP_PENDING_PACKETS */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigHAS_PRINTF != 0 ) || ( ipconfigHAS_DEBUG_PRINTF != 0 )
 
 	void FreeRTOS_PrintARPCache( void )
@@ -56,9 +56,15 @@
 #define dhcpSERVER_HOST_NAME_LENGTH				64
 #define dhcpBOOT_FILE_NAME_LENGTH 				128
 
-/* Timer parameters */
-#ifndef dhcpINITIAL_DHCP_TX_PERIOD
+/* Timer parameters.  dhcpINITIAL_TIMER_PERIOD is the interval at which the
+state machine polls for replies, dhcpINITIAL_DHCP_TX_PERIOD the time before the
+first retransmission, which doubles after each attempt up to
+ipconfigMAXIMUM_DISCOVER_TX_PERIOD.  Both can be defined in FreeRTOSIPConfig.h. */
+#ifndef dhcpINITIAL_TIMER_PERIOD
 	#define dhcpINITIAL_TIMER_PERIOD			( pdMS_TO_TICKS( 250 ) )
+#endif
+
+#ifndef dhcpINITIAL_DHCP_TX_PERIOD
 	#define dhcpINITIAL_DHCP_TX_PERIOD			( pdMS_TO_TICKS( 5000 ) )
 #endif
 
@@ -74,6 +80,7 @@
 #define dhcpSERVER_IP_ADDRESS_OPTION_CODE		( 54u )
 #define dhcpPARAMETER_REQUEST_OPTION_CODE		( 55u )
 #define dhcpCLIENT_IDENTIFIER_OPTION_CODE		( 61u )
+#define dhcpRAPID_COMMIT_OPTION_CODE			( 80u )
 
 /* The four DHCP message types of interest. */
 #define dhcpMESSAGE_TYPE_DISCOVER				( 1 )
@@ -173,6 +180,14 @@ struct xDHCP_DATA
 	eDHCPState_t eDHCPState;
 	/* The UDP socket used for all incoming and outgoing DHCP traffic. */
 	Socket_t xDHCPSocket;
+	#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+		/* Set while a stored address is being confirmed (INIT-REBOOT). */
+		BaseType_t xInitReboot;
+	#endif
+	#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+		/* Set when the reply to a discover was a Rapid Commit ACK. */
+		BaseType_t xRapidCommitAck;
+	#endif
 };
 
 typedef struct xDHCP_DATA DHCPData_t;
@@ -205,6 +220,21 @@ static BaseType_t prvProcessDHCPReplies( BaseType_t xExpectedMessageType );
  */
 static void prvSendDHCPRequest( void );
 
+/*
+ * Start using the address that was acknowledged by the DHCP server, and set
+ * the timer to renew the lease.
+ */
+static void prvUseLeasedAddress( void );
+
+/*
+ * Try to confirm the address of a lease that the application stored during a
+ * previous run, by sending a request without a preceding discover.  Returns
+ * pdTRUE when such a request was sent.
+ */
+#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+	static BaseType_t prvSendStoredLeaseRequest( void );
+#endif
+
 /*
  * Prepare to start a DHCP transaction.  This initialises some state variables
  * and creates the DHCP socket if necessary.
@@ -271,6 +301,15 @@ BaseType_t xGivingUp = pdFALSE;
 	switch( xDHCPData.eDHCPState )
 	{
 		case eWaitingSendFirstDiscover :
+		#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+			/* After a (re)start, first try to confirm the address obtained
+			during a previous run.  If that fails, a discover is sent. */
+			if( ( xReset != pdFALSE ) && ( prvSendStoredLeaseRequest() != pdFALSE ) )
+			{
+				break;
+			}
+		#endif /* ipconfigDHCP_USE_LEASE_STORE */
+
 			/* Ask the user if a DHCP discovery is required. */
 		#if( ipconfigUSE_DHCP_HOOK != 0 )
 			eAnswer = xApplicationDHCPHook( eDHCPPhasePreDiscover, xNetworkAddressing.ulDefaultIPAddress );
@@ -326,6 +365,18 @@ BaseType_t xGivingUp = pdFALSE;
 				if( eAnswer == eDHCPContinue )
 			#endif	/* ipconfigUSE_DHCP_HOOK */
 				{
+					#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+					{
+						if( xDHCPData.xRapidCommitAck != pdFALSE )
+						{
+							/* The server has committed the address already,
+							no request is needed. */
+							prvUseLeasedAddress();
+							break;
+						}
+					}
+					#endif /* ipconfigDHCP_USE_RAPID_COMMIT */
+
 					/* An offer has been made, the user wants to continue,
 					generate the request. */
 					xDHCPData.xDHCPTxTime = xTaskGetTickCount();
@@ -398,50 +449,24 @@ BaseType_t xGivingUp = pdFALSE;
 			/* Look for acks coming in. */
 			if( prvProcessDHCPReplies( dhcpMESSAGE_TYPE_ACK ) == pdPASS )
 			{
-				FreeRTOS_debug_printf( ( "vDHCPProcess: acked %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
-
-				/* DHCP completed.  The IP address can now be used, and the
-				timer set to the lease timeout time. */
-				*ipLOCAL_IP_ADDRESS_POINTER = xDHCPData.ulOfferedIPAddress;
-
-				/* Setting the 'local' broadcast address, something like
-				'192.168.1.255'. */
-				xNetworkAddressing.ulBroadcastAddress = ( xDHCPData.ulOfferedIPAddress & xNetworkAddressing.ulNetMask ) |  ~xNetworkAddressing.ulNetMask;
-				xDHCPData.eDHCPState = eLeasedAddress;
-
-				iptraceDHCP_SUCCEDEED( xDHCPData.ulOfferedIPAddress );
-
-				/* DHCP failed, the default configured IP-address will be used
-				Now call vIPNetworkUpCalls() to send the network-up event and
-				start the ARP timer. */
-				vIPNetworkUpCalls( );
-
-				/* Close socket to ensure packets don't queue on it. */
-				vSocketClose( xDHCPData.xDHCPSocket );
-				xDHCPData.xDHCPSocket = NULL;
-
-				if( xDHCPData.ulLeaseTime == 0UL )
-				{
-					xDHCPData.ulLeaseTime = dhcpDEFAULT_LEASE_TIME;
-				}
-				else if( xDHCPData.ulLeaseTime < dhcpMINIMUM_LEASE_TIME )
-				{
-					xDHCPData.ulLeaseTime = dhcpMINIMUM_LEASE_TIME;
-				}
-				else
-				{
-					/* The lease time is already valid. */
-				}
-
-				/* Check for clashes. */
-				vARPSendGratuitous();
-				vIPReloadDHCPTimer( xDHCPData.ulLeaseTime );
+				prvUseLeasedAddress();
 			}
 			else
 			{
 				/* Is it time to send another Discover? */
 				if( ( xTaskGetTickCount() - xDHCPData.xDHCPTxTime ) > xDHCPData.xDHCPTxPeriod )
 				{
+				#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+					if( xDHCPData.xInitReboot != pdFALSE )
+					{
+						/* The stored address was not confirmed in time, do not
+						keep retrying it but fall back to a discover. */
+						xDHCPData.xInitReboot = pdFALSE;
+						xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
+						break;
+					}
+				#endif /* ipconfigDHCP_USE_LEASE_STORE */
+
 					/* Increase the time period, and if it has not got to the
 					point of giving up - send another request. */
 					xDHCPData.xDHCPTxPeriod <<= 1;
@@ -547,6 +572,110 @@ BaseType_t xGivingUp = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
+static void prvUseLeasedAddress( void )
+{
+	FreeRTOS_debug_printf( ( "vDHCPProcess: acked %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
+
+	/* DHCP completed.  The IP address can now be used, and the
+	timer set to the lease timeout time. */
+	*ipLOCAL_IP_ADDRESS_POINTER = xDHCPData.ulOfferedIPAddress;
+
+	/* Setting the 'local' broadcast address, something like
+	'192.168.1.255'. */
+	xNetworkAddressing.ulBroadcastAddress = ( xDHCPData.ulOfferedIPAddress & xNetworkAddressing.ulNetMask ) |  ~xNetworkAddressing.ulNetMask;
+	xDHCPData.eDHCPState = eLeasedAddress;
+
+	iptraceDHCP_SUCCEDEED( xDHCPData.ulOfferedIPAddress );
+
+	#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+	{
+	DHCPLease_t xLease;
+
+		xDHCPData.xInitReboot = pdFALSE;
+
+		/* Let the application remember the lease, so the next start-up can
+		skip the discover. */
+		xLease.ulIPAddress = xDHCPData.ulOfferedIPAddress;
+		xLease.ulNetMask = xNetworkAddressing.ulNetMask;
+		xLease.ulGatewayAddress = xNetworkAddressing.ulGatewayAddress;
+		xLease.ulDNSServerAddress = xNetworkAddressing.ulDNSServerAddress;
+		vApplicationDHCPStoreLease( &xLease );
+	}
+	#endif /* ipconfigDHCP_USE_LEASE_STORE */
+
+	/* DHCP failed, the default configured IP-address will be used
+	Now call vIPNetworkUpCalls() to send the network-up event and
+	start the ARP timer. */
+	vIPNetworkUpCalls( );
+
+	/* Close socket to ensure packets don't queue on it. */
+	vSocketClose( xDHCPData.xDHCPSocket );
+	xDHCPData.xDHCPSocket = NULL;
+
+	if( xDHCPData.ulLeaseTime == 0UL )
+	{
+		xDHCPData.ulLeaseTime = dhcpDEFAULT_LEASE_TIME;
+	}
+	else if( xDHCPData.ulLeaseTime < dhcpMINIMUM_LEASE_TIME )
+	{
+		xDHCPData.ulLeaseTime = dhcpMINIMUM_LEASE_TIME;
+	}
+	else
+	{
+		/* The lease time is already valid. */
+	}
+
+	/* Check for clashes. */
+	vARPSendGratuitous();
+	vIPReloadDHCPTimer( ipconfigALIGN_DEFERRABLE_DELAY( xDHCPData.ulLeaseTime ) );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+
+	static BaseType_t prvSendStoredLeaseRequest( void )
+	{
+	DHCPLease_t xLease;
+	BaseType_t xReturn = pdFALSE;
+
+		memset( &xLease, '\0', sizeof( xLease ) );
+
+		if( ( xApplicationDHCPLoadLease( &xLease ) != pdFALSE ) && ( xLease.ulIPAddress != 0UL ) )
+		{
+			prvInitialiseDHCP();
+
+			if( xDHCPData.xDHCPSocket != NULL )
+			{
+				*ipLOCAL_IP_ADDRESS_POINTER = 0UL;
+
+				/* Restore the settings of the previous lease, the ACK will
+				update them if the server sends other values. */
+				xNetworkAddressing.ulNetMask = xLease.ulNetMask;
+				xNetworkAddressing.ulGatewayAddress = xLease.ulGatewayAddress;
+				xNetworkAddressing.ulDNSServerAddress = xLease.ulDNSServerAddress;
+
+				/* RFC 2131 section 4.3.2: in the INIT-REBOOT state the
+				request carries the address but no server identifier.  A
+				zero server address makes prvSendDHCPRequest() leave it out,
+				and lets any server acknowledge the request. */
+				xDHCPData.ulOfferedIPAddress = xLease.ulIPAddress;
+				xDHCPData.ulDHCPServerAddress = 0UL;
+				xDHCPData.xInitReboot = pdTRUE;
+
+				FreeRTOS_debug_printf( ( "vDHCPProcess: confirm stored lease %lxip\n", FreeRTOS_ntohl( xLease.ulIPAddress ) ) );
+				xDHCPData.xDHCPTxTime = xTaskGetTickCount();
+				prvSendDHCPRequest( );
+				xDHCPData.eDHCPState = eWaitingAcknowledge;
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigDHCP_USE_LEASE_STORE */
+/*-----------------------------------------------------------*/
+
 static void prvCreateDHCPSocket( void )
 {
 struct freertos_sockaddr xAddress;
@@ -598,6 +727,11 @@ static void prvInitialiseDHCP( void )
 		xDHCPData.ulOfferedIPAddress = 0UL;
 		xDHCPData.ulDHCPServerAddress = 0UL;
 		xDHCPData.xDHCPTxPeriod = dhcpINITIAL_DHCP_TX_PERIOD;
+		#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+		{
+			xDHCPData.xInitReboot = pdFALSE;
+		}
+		#endif
 
 		/* Create the DHCP socket if it has not already been created. */
 		prvCreateDHCPSocket();
@@ -618,6 +752,11 @@ uint8_t *pucByte, ucOptionCode, ucLength;
 uint32_t ulProcessed, ulParameter;
 BaseType_t xReturn = pdFALSE;
 const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct DHCP message type must be present in the options. */
+#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+	BaseType_t xIsAck = pdFALSE, xHasRapidCommit = pdFALSE;
+
+	xDHCPData.xRapidCommitAck = pdFALSE;
+#endif
 
 	lBytes = FreeRTOS_recvfrom( xDHCPData.xDHCPSocket, ( void * ) &pucUDPPayload, 0ul, FREERTOS_ZERO_COPY, &xClient, &xClientLength );
 
@@ -711,6 +850,15 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 									xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
 								}
 							}
+						#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+							else if( ( *pucByte == ( uint8_t ) dhcpMESSAGE_TYPE_ACK ) &&
+									 ( xExpectedMessageType == ( BaseType_t ) dhcpMESSAGE_TYPE_OFFER ) )
+							{
+								/* An ACK in reply to a discover is only valid
+								with the Rapid Commit option, see below. */
+								xIsAck = pdTRUE;
+							}
+						#endif /* ipconfigDHCP_USE_RAPID_COMMIT */
 							else
 							{
 								/* Don't process other message types. */
@@ -747,9 +895,12 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 
 							if( ucLength == sizeof( uint32_t ) )
 							{
-								if( xExpectedMessageType == ( BaseType_t ) dhcpMESSAGE_TYPE_OFFER )
+								if( ( xExpectedMessageType == ( BaseType_t ) dhcpMESSAGE_TYPE_OFFER ) ||
+									( xDHCPData.ulDHCPServerAddress == 0UL ) )
 								{
-									/* Offers state the replying server. */
+									/* Offers state the replying server.  So
+									does the ACK to a request that was sent
+									without a server identifier. */
 									ulProcessed++;
 									xDHCPData.ulDHCPServerAddress = ulParameter;
 								}
@@ -785,6 +936,14 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 							}
 							break;
 
+					#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+						case dhcpRAPID_COMMIT_OPTION_CODE :
+
+							/* RFC 4039: the option has no data. */
+							xHasRapidCommit = pdTRUE;
+							break;
+					#endif /* ipconfigDHCP_USE_RAPID_COMMIT */
+
 						default :
 
 							/* Not interested in this field. */
@@ -795,6 +954,15 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 					/* Jump over the data to find the next option code. */
 					if( ucLength == 0u )
 					{
+					#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+						/* The Rapid Commit option is the only zero-length
+						option expected, the code and length bytes have been
+						skipped already. */
+						if( ucOptionCode == dhcpRAPID_COMMIT_OPTION_CODE )
+						{
+							continue;
+						}
+					#endif /* ipconfigDHCP_USE_RAPID_COMMIT */
 						break;
 					}
 					else
@@ -803,6 +971,17 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 					}
 				}
 
+				#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+				{
+					if( ( xIsAck != pdFALSE ) && ( xHasRapidCommit != pdFALSE ) )
+					{
+						/* The ACK takes the place of the offer. */
+						ulProcessed++;
+						xDHCPData.xRapidCommitAck = pdTRUE;
+					}
+				}
+				#endif /* ipconfigDHCP_USE_RAPID_COMMIT */
+
 				/* Were all the mandatory options received? */
 				if( ulProcessed >= ulMandatoryOptions )
 				{
@@ -910,16 +1089,37 @@ static const uint8_t ucDHCPRequestOptions[] =
 	dhcpOPTION_END_BYTE
 };
 size_t xOptionsLength = sizeof( ucDHCPRequestOptions );
-
-	pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPRequestOptions, &xOptionsLength );
+#if( ipconfigDHCP_USE_LEASE_STORE != 0 )
+	static const uint8_t ucDHCPRebootOptions[] =
+	{
+		/* The same as ucDHCPRequestOptions[], without the server identifier. */
+		dhcpMESSAGE_TYPE_OPTION_CODE, 1, dhcpMESSAGE_TYPE_REQUEST,		/* Message type option. */
+		dhcpCLIENT_IDENTIFIER_OPTION_CODE, 6, 0, 0, 0, 0, 0, 0,			/* Client identifier. */
+		dhcpREQUEST_IP_ADDRESS_OPTION_CODE, 4, 0, 0, 0, 0,				/* The IP address being requested. */
+		dhcpOPTION_END_BYTE
+	};
+
+	if( xDHCPData.ulDHCPServerAddress == 0UL )
+	{
+		xOptionsLength = sizeof( ucDHCPRebootOptions );
+		pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPRebootOptions, &xOptionsLength );
+	}
+	else
+#endif /* ipconfigDHCP_USE_LEASE_STORE */
+	{
+		pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPRequestOptions, &xOptionsLength );
+	}
 
 	/* Copy in the IP address being requested. */
 	memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpREQUESTED_IP_ADDRESS_OFFSET ] ),
 		( void * ) &( xDHCPData.ulOfferedIPAddress ), sizeof( xDHCPData.ulOfferedIPAddress ) );
 
 	/* Copy in the address of the DHCP server being used. */
-	memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpDHCP_SERVER_IP_ADDRESS_OFFSET ] ),
-		( void * ) &( xDHCPData.ulDHCPServerAddress ), sizeof( xDHCPData.ulDHCPServerAddress ) );
+	if( xDHCPData.ulDHCPServerAddress != 0UL )
+	{
+		memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpDHCP_SERVER_IP_ADDRESS_OFFSET ] ),
+			( void * ) &( xDHCPData.ulDHCPServerAddress ), sizeof( xDHCPData.ulDHCPServerAddress ) );
+	}
 
 	FreeRTOS_debug_printf( ( "vDHCPProcess: reply %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
 	iptraceSENDING_DHCP_REQUEST();
@@ -944,6 +1144,9 @@ static const uint8_t ucDHCPDiscoverOptions[] =
 	dhcpMESSAGE_TYPE_OPTION_CODE, 1, dhcpMESSAGE_TYPE_DISCOVER,					/* Message type option. */
 	dhcpCLIENT_IDENTIFIER_OPTION_CODE, 6, 0, 0, 0, 0, 0, 0,						/* Client identifier. */
 	dhcpPARAMETER_REQUEST_OPTION_CODE, 3, dhcpSUBNET_MASK_OPTION_CODE, dhcpGATEWAY_OPTION_CODE, dhcpDNS_SERVER_OPTIONS_CODE,	/* Parameter request option. */
+#if( ipconfigDHCP_USE_RAPID_COMMIT != 0 )
+	dhcpRAPID_COMMIT_OPTION_CODE, 0,											/* Ask for a two-message exchange (RFC 4039). */
+#endif
 	dhcpOPTION_END_BYTE
 };
 size_t xOptionsLength = sizeof( ucDHCPDiscoverOptions );
@@ -52,12 +52,16 @@
 	#define dnsOUTGOING_FLAGS				0x0001 /* Standard query. */
 	#define dnsRX_FLAGS_MASK				0x0f80 /* The bits of interest in the flags field of incoming DNS messages. */
 	#define dnsEXPECTED_RX_FLAGS			0x0080 /* Should be a response, without any errors. */
+	#define dnsNXDOMAIN_RX_FLAGS			0x0380 /* A response saying that the name does not exist. */
+	#define dnsRX_FLAGS_TRUNCATED			0x0002 /* The response did not fit in a UDP message. */
 #else
 	#define dnsDNS_PORT						0x0035
 	#define dnsONE_QUESTION					0x0001
 	#define dnsOUTGOING_FLAGS				0x0100 /* Standard query. */
 	#define dnsRX_FLAGS_MASK				0x800f /* The bits of interest in the flags field of incoming DNS messages. */
 	#define dnsEXPECTED_RX_FLAGS			0x8000 /* Should be a response, without any errors. */
+	#define dnsNXDOMAIN_RX_FLAGS			0x8003 /* A response saying that the name does not exist. */
+	#define dnsRX_FLAGS_TRUNCATED			0x0200 /* The response did not fit in a UDP message. */
 
 #endif /* ipconfigBYTE_ORDER */
 
@@ -100,6 +104,11 @@ the query will be responded to with these flags: */
 type. */
 #define dnsPARSE_ERROR					  0UL
 
+/* Results of a look-up in the DNS cache. */
+#define dnsCACHE_MISS					0	/* Not found, or the entry has expired. */
+#define dnsCACHE_HIT					1	/* Found; the address is 0 for a name that does not resolve. */
+#define dnsCACHE_HIT_REFRESH			2	/* Found, and the entry should be refreshed now. */
+
 /*
  * Create a socket and bind it to the standard DNS port number.  Return the
  * the created socket - or NULL if the socket could not be created or bound.
@@ -125,7 +134,7 @@ static uint32_t prvParseDNSReply( uint8_t *pucUDPPayloadBuffer, size_t xBufferLe
  * Prepare and send a message to a DNS server.  'xReadTimeOut_ms' will be passed as
  * zero, in case the user has supplied a call-back function.
  */
-static uint32_t prvGetHostByName( const char *pcHostName, TickType_t xIdentifier, TickType_t xReadTimeOut_ms );
+static uint32_t prvGetHostByName( const char *pcHostName, TickType_t xIdentifier, TickType_t xReadTimeOut_ms, BaseType_t xAttempts );
 
 /*
  * The NBNS and the LLMNR protocol share this reply function.
@@ -140,14 +149,19 @@ static uint32_t prvGetHostByName( const char *pcHostName, TickType_t xIdentifier
 
 #if( ipconfigUSE_DNS_CACHE == 1 )
 	static uint8_t *prvReadNameField( uint8_t *pucByte, size_t xSourceLen, char *pcName, size_t xLen );
-	static void prvProcessDNSCache( const char *pcName, uint32_t *pulIP, uint32_t ulTTL, BaseType_t xLookUp );
+	static BaseType_t prvProcessDNSCache( const char *pcName, uint32_t *pulIP, uint32_t ulTTL, BaseType_t xLookUp );
+	static uint32_t prvDNSNameHash( const char *pcName );
 
 	typedef struct xDNS_CACHE_TABLE_ROW
 	{
-		uint32_t ulIPAddress;		/* The IP address of an ARP cache entry. */
+		uint32_t ulIPAddress;		/* The IP address of an ARP cache entry, 0 for a name that does not resolve. */
+		uint32_t ulNameHash;		/* Hash of pcName, compared before the name itself. */
 		char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ];  /* The name of the host */
 		uint32_t ulTTL; /* Time-to-Live (in seconds) from the DNS server. */
 		uint32_t ulTimeWhenAddedInSeconds;
+		#if( ipconfigDNS_CACHE_PREFETCH != 0 )
+			BaseType_t xRefreshSent;	/* A refresh query was sent for this entry. */
+		#endif
 	} DNSCacheRow_t;
 
 	static DNSCacheRow_t xDNSCache[ ipconfigDNS_CACHE_ENTRIES ];
@@ -156,6 +170,10 @@ static uint32_t prvGetHostByName( const char *pcHostName, TickType_t xIdentifier
     {
         memset( xDNSCache, 0x0, sizeof( xDNSCache ) );
     }
+
+	#if( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 )
+		static void prvCacheNegativeReply( const char *pcName, TickType_t xIdentifier );
+	#endif
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
 
 #if( ipconfigUSE_LLMNR == 1 )
@@ -261,7 +279,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 	uint32_t FreeRTOS_dnslookup( const char *pcHostName )
 	{
 	uint32_t ulIPAddress = 0UL;
-		prvProcessDNSCache( pcHostName, &ulIPAddress, 0, pdTRUE );
+		( void ) prvProcessDNSCache( pcHostName, &ulIPAddress, 0, pdTRUE );
 		return ulIPAddress;
 	}
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
@@ -420,6 +438,7 @@ uint32_t FreeRTOS_gethostbyname_a( const char *pcHostName, FOnDNSEvent pCallback
 uint32_t ulIPAddress = 0UL;
 TickType_t xReadTimeOut_ms = ipconfigSOCK_DEFAULT_RECEIVE_BLOCK_TIME;
 TickType_t xIdentifier = 0;
+BaseType_t xCacheResult = dnsCACHE_MISS;
 
 	/* If the supplied hostname is IP address, convert it to uint32_t
 	and return. */
@@ -435,21 +454,36 @@ TickType_t xIdentifier = 0;
 	{
 		if( ulIPAddress == 0UL )
 		{
-			ulIPAddress = FreeRTOS_dnslookup( pcHostName );
+			xCacheResult = prvProcessDNSCache( pcHostName, &ulIPAddress, 0, pdTRUE );
 			if( ulIPAddress != 0 )
 			{
 				FreeRTOS_debug_printf( ( "FreeRTOS_gethostbyname: found '%s' in cache: %lxip\n", pcHostName, ulIPAddress ) );
 			}
+			else if( xCacheResult != dnsCACHE_MISS )
+			{
+				FreeRTOS_debug_printf( ( "FreeRTOS_gethostbyname: '%s' is cached as unresolvable\n", pcHostName ) );
+			}
 			else
 			{
 				/* prvGetHostByName will be called to start a DNS lookup */
 			}
 		}
+
+		#if( ipconfigDNS_CACHE_PREFETCH != 0 )
+		{
+			if( xCacheResult == dnsCACHE_HIT_REFRESH )
+			{
+				/* Send one query and do not wait: the IP-task will store the
+				answer when it arrives. */
+				( void ) prvGetHostByName( pcHostName, ( TickType_t ) ipconfigRAND32( ), 0, 1 );
+			}
+		}
+		#endif /* ipconfigDNS_CACHE_PREFETCH */
 	}
 	#endif /* ipconfigUSE_DNS_CACHE == 1 */
 
-	/* Generate a unique identifier. */
-	if( 0 == ulIPAddress )
+	/* Generate a unique identifier, unless the answer is already known. */
+	if( ( 0 == ulIPAddress ) && ( xCacheResult == dnsCACHE_MISS ) )
 	{
 		xIdentifier = ( TickType_t )ipconfigRAND32( );
 	}
@@ -458,18 +492,16 @@ TickType_t xIdentifier = 0;
 	{
 		if( pCallback != NULL )
 		{
-			if( ulIPAddress == 0UL )
+			if( ( ulIPAddress == 0UL ) && ( 0 != xIdentifier ) )
 			{
 				/* The user has provided a callback function, so do not block on recvfrom() */
-				if( 0 != xIdentifier )
-				{
-					xReadTimeOut_ms = 0;
-					vDNSSetCallBack( pcHostName, pvSearchID, pCallback, xTimeout, ( TickType_t )xIdentifier );
-				}
+				xReadTimeOut_ms = 0;
+				vDNSSetCallBack( pcHostName, pvSearchID, pCallback, xTimeout, ( TickType_t )xIdentifier );
 			}
 			else
 			{
-				/* The IP address is known, do the call-back now. */
+				/* The IP address is known, or the name is known not to
+				resolve, do the call-back now. */
 				pCallback( pcHostName, pvSearchID, ulIPAddress );
 			}
 		}
@@ -478,14 +510,14 @@ TickType_t xIdentifier = 0;
 
 	if( ( ulIPAddress == 0UL ) && ( 0 != xIdentifier ) )
 	{
-		ulIPAddress = prvGetHostByName( pcHostName, xIdentifier, xReadTimeOut_ms );
+		ulIPAddress = prvGetHostByName( pcHostName, xIdentifier, xReadTimeOut_ms, ipconfigDNS_REQUEST_ATTEMPTS );
 	}
 
 	return ulIPAddress;
 }
 /*-----------------------------------------------------------*/
 
-static uint32_t prvGetHostByName( const char *pcHostName, TickType_t xIdentifier, TickType_t xReadTimeOut_ms )
+static uint32_t prvGetHostByName( const char *pcHostName, TickType_t xIdentifier, TickType_t xReadTimeOut_ms, BaseType_t xAttempts )
 {
 struct freertos_sockaddr xAddress;
 Socket_t xDNSSocket;
@@ -528,7 +560,7 @@ TickType_t xWriteTimeOut_ms = ipconfigSOCK_DEFAULT_SEND_BLOCK_TIME;
 		FreeRTOS_setsockopt( xDNSSocket, 0, FREERTOS_SO_SNDTIMEO, ( void * ) &xWriteTimeOut_ms, sizeof( TickType_t ) );
 		FreeRTOS_setsockopt( xDNSSocket, 0, FREERTOS_SO_RCVTIMEO, ( void * ) &xReadTimeOut_ms,  sizeof( TickType_t ) );
 
-		for( xAttempt = 0; xAttempt < ipconfigDNS_REQUEST_ATTEMPTS; xAttempt++ )
+		for( xAttempt = 0; xAttempt < xAttempts; xAttempt++ )
 		{
 			/* Get a buffer.  This uses a maximum delay, but the delay will be
 			capped to ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS so the return value
@@ -584,6 +616,17 @@ TickType_t xWriteTimeOut_ms = ipconfigSOCK_DEFAULT_SEND_BLOCK_TIME;
 							/* All done. */
 							break;
 						}
+
+						#if( ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 ) )
+						{
+							/* If the server said that the name does not
+							resolve, asking again will not change that. */
+							if( prvProcessDNSCache( pcHostName, &ulIPAddress, 0, pdTRUE ) != dnsCACHE_MISS )
+							{
+								break;
+							}
+						}
+						#endif
 					}
 				}
 				else
@@ -1036,7 +1079,25 @@ uint16_t x, usDataLength, usQuestions;
 					}
 				}
 			}
+
+			#if( ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 ) )
+			{
+				/* A complete answer without any records: the name exists,
+				but has no IPv4 address. */
+				if( ( pxDNSMessageHeader->usAnswers == 0 ) &&
+					( ( pxDNSMessageHeader->usFlags & dnsRX_FLAGS_TRUNCATED ) == 0 ) )
+				{
+					prvCacheNegativeReply( pcName, ( TickType_t ) pxDNSMessageHeader->usIdentifier );
+				}
+			}
+			#endif
+		}
+#if( ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 ) )
+		else if( ( pxDNSMessageHeader->usFlags & dnsRX_FLAGS_MASK ) == dnsNXDOMAIN_RX_FLAGS )
+		{
+			prvCacheNegativeReply( pcName, ( TickType_t ) pxDNSMessageHeader->usIdentifier );
 		}
+#endif
 #if( ipconfigUSE_LLMNR == 1 )
 		else if( usQuestions && ( usType == dnsTYPE_A_HOST ) && ( usClass == dnsCLASS_IN ) )
 		{
@@ -1332,11 +1393,32 @@ TickType_t xTimeoutTime = pdMS_TO_TICKS( 200 );
 
 #if( ipconfigUSE_DNS_CACHE == 1 )
 
-	static void prvProcessDNSCache( const char *pcName, uint32_t *pulIP, uint32_t ulTTL, BaseType_t xLookUp )
+	/* FNV-1a hash of a host name, so that most rows of the cache can be
+	skipped without comparing strings. */
+	static uint32_t prvDNSNameHash( const char *pcName )
+	{
+	uint32_t ulHash = 2166136261UL;
+
+		while( *pcName != '\0' )
+		{
+			ulHash ^= ( uint32_t ) ( uint8_t ) *pcName;
+			ulHash *= 16777619UL;
+			pcName++;
+		}
+
+		return ulHash;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvProcessDNSCache( const char *pcName, uint32_t *pulIP, uint32_t ulTTL, BaseType_t xLookUp )
 	{
 	BaseType_t x;
 	BaseType_t xFound = pdFALSE;
+	BaseType_t xResult = dnsCACHE_MISS;
+	BaseType_t xEmptyEntry = -1;
 	uint32_t ulCurrentTimeSeconds = ( xTaskGetTickCount() / portTICK_PERIOD_MS ) / 1000;
+	uint32_t ulNameHash = prvDNSNameHash( pcName );
+	uint32_t ulAge, ulTTLSeconds;
 	static BaseType_t xFreeEntry = 0;
 
 		/* For each entry in the DNS cache table. */
@@ -1344,18 +1426,41 @@ TickType_t xTimeoutTime = pdMS_TO_TICKS( 200 );
 		{
 			if( xDNSCache[ x ].pcName[ 0 ] == 0 )
 			{
+				if( xEmptyEntry < 0 )
+				{
+					xEmptyEntry = x;
+				}
 				continue;
 			}
 
-			if( 0 == strcmp( xDNSCache[ x ].pcName, pcName ) )
+			if( ( xDNSCache[ x ].ulNameHash == ulNameHash ) &&
+				( 0 == strcmp( xDNSCache[ x ].pcName, pcName ) ) )
 			{
 				/* Is this function called for a lookup or to add/update an IP address? */
 				if( xLookUp != pdFALSE )
 				{
+					ulAge = ulCurrentTimeSeconds - xDNSCache[ x ].ulTimeWhenAddedInSeconds;
+					ulTTLSeconds = FreeRTOS_ntohl( xDNSCache[ x ].ulTTL );
+
 					/* Confirm that the record is still fresh. */
-					if( ulCurrentTimeSeconds < ( xDNSCache[ x ].ulTimeWhenAddedInSeconds + FreeRTOS_ntohl( xDNSCache[ x ].ulTTL ) ) )
+					if( ulAge < ulTTLSeconds )
 					{
 						*pulIP = xDNSCache[ x ].ulIPAddress;
+						xResult = dnsCACHE_HIT;
+
+						#if( ipconfigDNS_CACHE_PREFETCH != 0 )
+						{
+							/* Ask for a refresh once, in the last eighth of
+							the TTL of a positive entry. */
+							if( ( xDNSCache[ x ].ulIPAddress != 0UL ) &&
+								( xDNSCache[ x ].xRefreshSent == pdFALSE ) &&
+								( ulAge >= ( ulTTLSeconds - ( ulTTLSeconds / 8u ) ) ) )
+							{
+								xDNSCache[ x ].xRefreshSent = pdTRUE;
+								xResult = dnsCACHE_HIT_REFRESH;
+							}
+						}
+						#endif /* ipconfigDNS_CACHE_PREFETCH */
 					}
 					else
 					{
@@ -1368,6 +1473,11 @@ TickType_t xTimeoutTime = pdMS_TO_TICKS( 200 );
 					xDNSCache[ x ].ulIPAddress = *pulIP;
 					xDNSCache[ x ].ulTTL = ulTTL;
 					xDNSCache[ x ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					#if( ipconfigDNS_CACHE_PREFETCH != 0 )
+					{
+						xDNSCache[ x ].xRefreshSent = pdFALSE;
+					}
+					#endif
 				}
 
 				xFound = pdTRUE;
@@ -1383,20 +1493,32 @@ TickType_t xTimeoutTime = pdMS_TO_TICKS( 200 );
 			}
 			else
 			{
-				/* Add or update the item. */
+				/* Add or update the item.  Use a free row if there is one,
+				otherwise replace the rows in turn. */
 				if( strlen( pcName ) < ipconfigDNS_CACHE_NAME_LENGTH )
 				{
-					strcpy( xDNSCache[ xFreeEntry ].pcName, pcName );
+					if( xEmptyEntry < 0 )
+					{
+						xEmptyEntry = xFreeEntry;
+
+						xFreeEntry++;
+						if( xFreeEntry == ipconfigDNS_CACHE_ENTRIES )
+						{
+							xFreeEntry = 0;
+						}
+					}
 
-					xDNSCache[ xFreeEntry ].ulIPAddress = *pulIP;
-					xDNSCache[ xFreeEntry ].ulTTL = ulTTL;
-					xDNSCache[ xFreeEntry ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					strcpy( xDNSCache[ xEmptyEntry ].pcName, pcName );
 
-					xFreeEntry++;
-					if( xFreeEntry == ipconfigDNS_CACHE_ENTRIES )
+					xDNSCache[ xEmptyEntry ].ulNameHash = ulNameHash;
+					xDNSCache[ xEmptyEntry ].ulIPAddress = *pulIP;
+					xDNSCache[ xEmptyEntry ].ulTTL = ulTTL;
+					xDNSCache[ xEmptyEntry ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					#if( ipconfigDNS_CACHE_PREFETCH != 0 )
 					{
-						xFreeEntry = 0;
+						xDNSCache[ xEmptyEntry ].xRefreshSent = pdFALSE;
 					}
+					#endif
 				}
 			}
 		}
@@ -1405,7 +1527,37 @@ TickType_t xTimeoutTime = pdMS_TO_TICKS( 200 );
 		{
 			FreeRTOS_debug_printf( ( "prvProcessDNSCache: %s: '%s' @ %lxip\n", xLookUp ? "look-up" : "add", pcName, FreeRTOS_ntohl( *pulIP ) ) );
 		}
+
+		return xResult;
 	}
+	/*-----------------------------------------------------------*/
+
+	#if( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 )
+
+		/* The DNS server answered that pcName has no IPv4 address.  Remember
+		that for a while, and tell an asynchronous caller now rather than when
+		its request times out. */
+		static void prvCacheNegativeReply( const char *pcName, TickType_t xIdentifier )
+		{
+		uint32_t ulIPAddress = 0UL;
+
+			if( pcName[ 0 ] != '\0' )
+			{
+				prvProcessDNSCache( pcName, &ulIPAddress, FreeRTOS_htonl( ( uint32_t ) ipconfigDNS_CACHE_NEGATIVE_TTL ), pdFALSE );
+
+				#if( ipconfigDNS_USE_CALLBACKS != 0 )
+				{
+					vDNSDoCallback( xIdentifier, pcName, 0UL );
+				}
+				#else
+				{
+					( void ) xIdentifier;
+				}
+				#endif
+			}
+		}
+
+	#endif /* ipconfigDNS_CACHE_NEGATIVE_TTL */
 
 #endif /* ipconfigUSE_DNS_CACHE */
 
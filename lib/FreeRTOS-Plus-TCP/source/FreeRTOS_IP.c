@@ -242,6 +242,44 @@ static void prvIPTimerReload( IPTimer_t *pxTimer, TickType_t xTime );
 static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPPacket,
 	NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength );
 
+/*
+ * Process at most ipconfigTCP_DEFERRED_RX_BATCH of the TCP packets that were
+ * put aside by prvProcessIPPacket().  Returns pdTRUE if more are waiting.
+ */
+#if( ( ipconfigUSE_TCP != 0 ) && ( ipconfigTCP_DEFERRED_RX_BATCH != 0 ) )
+	static BaseType_t prvProcessDeferredTCPPackets( void );
+#endif
+
+/*
+ * Add uxBlockCount blocks of 16 bytes, starting at the 32-bit aligned
+ * pulSource, to the checksum ulSum.  The implementation is selected with
+ * ipconfigCHECKSUM_METHOD.
+ */
+#if( ipconfigCHECKSUM_METHOD == ipCHECKSUM_APPLICATION )
+	#define prvChecksumAddBlocks( ulSum, pulSource, uxBlockCount )	ulApplicationChecksumAddBlocks( ulSum, pulSource, uxBlockCount )
+#else
+	static uint32_t prvChecksumAddBlocks( uint32_t ulSum, const uint32_t *pulSource, size_t uxBlockCount );
+#endif
+
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	/*
+	 * Pass queued frames to xNetworkInterfaceOutput() for as long as the
+	 * driver has room for them, the highest priority first.
+	 */
+	static void prvTxSchedulerDrain( void );
+
+	/*
+	 * Take the next frame to be sent out of its queue: class 0 when it has
+	 * frames waiting, otherwise the other classes in deficit round robin order.
+	 */
+	static NetworkBufferDescriptor_t *prvTxSchedulerNext( void );
+
+	/*
+	 * Release all queued frames, e.g. when the network goes down.
+	 */
+	static void prvTxSchedulerFlush( void );
+#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 /*-----------------------------------------------------------*/
 
 /* The queue used to pass events into the IP-task for processing. */
@@ -278,6 +316,12 @@ static TaskHandle_t xIPTaskHandle = NULL;
 	static BaseType_t xProcessedTCPMessage;
 #endif
 
+#if( ( ipconfigUSE_TCP != 0 ) && ( ipconfigTCP_DEFERRED_RX_BATCH != 0 ) )
+	/* Received TCP packets that have passed the IP checks, in order of
+	arrival, waiting until the event queue has been emptied. */
+	static List_t xTCPDeferredRxList;
+#endif
+
 /* Simple set to pdTRUE or pdFALSE depending on whether the network is up or
 down (connected, not connected) respectively. */
 static BaseType_t xNetworkUp = pdFALSE;
@@ -309,6 +353,22 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
 	static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
 #endif
 
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	/* Frames waiting until the driver has room for them, one FIFO per traffic
+	class.  Only the IP-task accesses these. */
+	static List_t xTxClassQueues[ ipconfigTX_PRIORITY_CLASSES ];
+
+	/* The number of frames in all of xTxClassQueues[]. */
+	static UBaseType_t uxTxQueuedCount = 0u;
+
+	/* Deficit round robin state of the classes 1 and higher: the number of
+	bytes each class may still send, the class whose turn it is, and whether
+	that class has got its quantum for the current turn already. */
+	static uint32_t ulTxDeficit[ ipconfigTX_PRIORITY_CLASSES ];
+	static UBaseType_t uxTxDRRClass = 1u;
+	static BaseType_t xTxQuantumGiven = pdFALSE;
+#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 /*-----------------------------------------------------------*/
 
 static void prvIPTask( void *pvParameters )
@@ -337,6 +397,23 @@ struct freertos_sockaddr xAddress;
 	}
 	#endif
 
+	#if( ( ipconfigUSE_TCP != 0 ) && ( ipconfigTCP_DEFERRED_RX_BATCH != 0 ) )
+	{
+		vListInitialise( &xTCPDeferredRxList );
+	}
+	#endif
+
+	#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	{
+	UBaseType_t uxClass;
+
+		for( uxClass = 0u; uxClass < ( UBaseType_t ) ipconfigTX_PRIORITY_CLASSES; uxClass++ )
+		{
+			vListInitialise( &( xTxClassQueues[ uxClass ] ) );
+		}
+	}
+	#endif
+
 	/* Initialisation is complete and events can now be processed. */
 	xIPTaskInitialised = pdTRUE;
 
@@ -347,6 +424,21 @@ struct freertos_sockaddr xAddress;
 	{
 		ipconfigWATCHDOG_TIMER();
 
+		/* The IP task holds no floating point values here, so a float it
+		formatted while logging must not make every context switch save the
+		FPU registers. */
+		portTASK_USES_NO_FPU();
+
+		#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		{
+			/* Send the frames that the driver couldn't take before. */
+			if( uxTxQueuedCount != 0u )
+			{
+				prvTxSchedulerDrain();
+			}
+		}
+		#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 		/* Check the ARP, DHCP and TCP timers to see if there is any periodic
 		or timeout processing to perform. */
 		prvCheckNetworkTimers();
@@ -354,6 +446,34 @@ struct freertos_sockaddr xAddress;
 		/* Calculate the acceptable maximum sleep time. */
 		xNextIPSleep = prvCalculateSleepTime();
 
+		#if( ( ipconfigUSE_TCP != 0 ) && ( ipconfigTCP_DEFERRED_RX_BATCH != 0 ) )
+		{
+			/* TCP packets are handled when no other event is waiting, so that
+			a bulk transfer does not hold up ARP, DHCP, UDP or socket API
+			events.  Do not block while TCP packets are waiting. */
+			if( listCURRENT_LIST_LENGTH( &xTCPDeferredRxList ) > 0U )
+			{
+				if( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0u )
+				{
+					if( prvProcessDeferredTCPPackets() != pdFALSE )
+					{
+						/* More TCP packets are waiting, check the timers
+						and the queue first. */
+						continue;
+					}
+
+					/* Let the timers see the packets just processed. */
+					prvCheckNetworkTimers();
+					xNextIPSleep = prvCalculateSleepTime();
+				}
+				else
+				{
+					xNextIPSleep = ( TickType_t ) 0;
+				}
+			}
+		}
+		#endif /* ipconfigTCP_DEFERRED_RX_BATCH */
+
 		/* Wait until there is something to do. If the following call exits
 		 * due to a time out rather than a message being received, set a
 		 * 'NoEvent' value. */
@@ -433,6 +553,16 @@ struct freertos_sockaddr xAddress;
 				vProcessGeneratedUDPPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
 				break;
 
+			case eStackTxReadyEvent :
+				/* FreeRTOS_sendto() has copied the headers from the template
+				of a connected UDP socket, the packet can go out as it is. */
+				#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+				{
+					vProcessPrebuiltUDPPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				}
+				#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+				break;
+
 			case eDHCPEvent:
 				/* The DHCP state machine needs processing. */
 				#if( ipconfigUSE_DHCP == 1 )
@@ -463,6 +593,11 @@ struct freertos_sockaddr xAddress;
 				#endif /* ipconfigSUPPORT_SIGNALS */
 				break;
 
+			case eNetworkTxEvent :
+				/* The driver has room for frames again.  The queued frames
+				are sent at the start of the next loop. */
+				break;
+
 			case eTCPTimerEvent :
 				#if( ipconfigUSE_TCP == 1 )
 				{
@@ -505,6 +640,8 @@ struct freertos_sockaddr xAddress;
 				break;
 		}
 
+		iptraceNETWORK_EVENT_PROCESSED( xReceivedEvent.eEventType );
+
 		if( xNetworkDownEventPending != pdFALSE )
 		{
 			/* A network down event could not be posted to the network event
@@ -515,6 +652,39 @@ struct freertos_sockaddr xAddress;
 }
 /*-----------------------------------------------------------*/
 
+#if( ( ipconfigUSE_TCP != 0 ) && ( ipconfigTCP_DEFERRED_RX_BATCH != 0 ) )
+
+	static BaseType_t prvProcessDeferredTCPPackets( void )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	UBaseType_t uxCount;
+
+		for( uxCount = 0u; uxCount < ( UBaseType_t ) ipconfigTCP_DEFERRED_RX_BATCH; uxCount++ )
+		{
+			if( listCURRENT_LIST_LENGTH( &xTCPDeferredRxList ) == 0U )
+			{
+				break;
+			}
+
+			pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xTCPDeferredRxList );
+			uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+
+			if( xProcessReceivedTCPPacket( pxNetworkBuffer ) != pdPASS )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			}
+
+			/* Setting this variable will cause xTCPTimerCheck()
+			to be called just before the IP-task blocks. */
+			xProcessedTCPMessage++;
+		}
+
+		return ( listCURRENT_LIST_LENGTH( &xTCPDeferredRxList ) > 0U ) ? pdTRUE : pdFALSE;
+	}
+
+#endif /* ipconfigTCP_DEFERRED_RX_BATCH */
+/*-----------------------------------------------------------*/
+
 BaseType_t xIsCallingFromIPTask( void )
 {
 BaseType_t xReturn;
@@ -667,8 +837,28 @@ static void prvCheckNetworkTimers( void )
 			xWillSleep = pdFALSE;
 		}
 
-		/* Sockets need to be checked if the TCP timer has expired. */
-		xCheckTCPSockets = prvIPTimerCheck( &xTCPTimer );
+		#if( ipconfigTCP_DEFERRED_RX_BATCH != 0 )
+		{
+			if( listCURRENT_LIST_LENGTH( &xTCPDeferredRxList ) > 0U )
+			{
+				xWillSleep = pdFALSE;
+			}
+		}
+		#endif
+
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+		{
+			/* The TCP timer is restarted every time with the time until the
+			next socket time-out, so when it is marked as expired, a socket
+			owner has sent an eTCPTimerEvent. */
+			xCheckTCPSockets = ( xTCPTimer.bExpired != pdFALSE_UNSIGNED ) ? pdTRUE : pdFALSE;
+		}
+		#else
+		{
+			/* Sockets need to be checked if the TCP timer has expired. */
+			xCheckTCPSockets = prvIPTimerCheck( &xTCPTimer );
+		}
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 
 		/* Sockets will also be checked if there are TCP messages but the
 		message queue is empty (indicated by xWillSleep being true). */
@@ -677,14 +867,29 @@ static void prvCheckNetworkTimers( void )
 			xCheckTCPSockets = pdTRUE;
 		}
 
-		if( xCheckTCPSockets != pdFALSE )
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
 		{
-			/* Attend to the sockets, returning the period after which the
-			check must be repeated. */
-			xNextTime = xTCPTimerCheck( xWillSleep );
+			/* Only the sockets of which the time-out has expired are checked,
+			unless xCheckTCPSockets is true. */
+			xNextTime = xTCPTimerWheelCheck( xWillSleep, xCheckTCPSockets );
 			prvIPTimerStart( &xTCPTimer, xNextTime );
-			xProcessedTCPMessage = 0;
+			if( xCheckTCPSockets != pdFALSE )
+			{
+				xProcessedTCPMessage = 0;
+			}
+		}
+		#else
+		{
+			if( xCheckTCPSockets != pdFALSE )
+			{
+				/* Attend to the sockets, returning the period after which the
+				check must be repeated. */
+				xNextTime = xTCPTimerCheck( xWillSleep );
+				prvIPTimerStart( &xTCPTimer, xNextTime );
+				xProcessedTCPMessage = 0;
+			}
 		}
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 	}
 	#endif /* ipconfigUSE_TCP == 1 */
 }
@@ -786,6 +991,199 @@ BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+
+	void FreeRTOS_NetworkTxReady( void )
+	{
+		/* A lost event is not a problem: the queued frames will also be sent
+		at the next event. */
+		( void ) xSendEventToIPTask( eNetworkTxEvent );
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t FreeRTOS_NetworkTxReadyFromISR( void )
+	{
+	static const IPStackEvent_t xNetworkTxEvent = { eNetworkTxEvent, NULL };
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+		( void ) xQueueSendToBackFromISR( xNetworkEventQueue, &xNetworkTxEvent, &xHigherPriorityTaskWoken );
+
+		return xHigherPriorityTaskWoken;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xTxSchedulerOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+	{
+	NetworkBufferDescriptor_t *pxQueuedBuffer;
+	NetworkBufferDescriptor_t *pxDropBuffer = NULL;
+	UBaseType_t uxClass = ( UBaseType_t ) pxNetworkBuffer->ucTxClass;
+	UBaseType_t uxLowest;
+	BaseType_t xReturn = pdFAIL;
+
+		if( ( uxTxQueuedCount == 0u ) && ( ipconfigNETWORK_INTERFACE_TX_READY() != pdFALSE ) )
+		{
+			/* Nothing is waiting, the frame doesn't need to be scheduled. */
+			xReturn = xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		}
+		else
+		{
+			if( uxClass >= ( UBaseType_t ) ipconfigTX_PRIORITY_CLASSES )
+			{
+				uxClass = ( UBaseType_t ) ipconfigTX_PRIORITY_CLASSES - 1u;
+			}
+
+			if( uxTxQueuedCount >= ( UBaseType_t ) ipconfigTX_QUEUE_LENGTH )
+			{
+				/* Make room by dropping the last frame of the lowest class
+				that has a lower priority than this frame. */
+				for( uxLowest = ( UBaseType_t ) ipconfigTX_PRIORITY_CLASSES - 1u; uxLowest > uxClass; uxLowest-- )
+				{
+					if( listLIST_IS_EMPTY( &( xTxClassQueues[ uxLowest ] ) ) == pdFALSE )
+					{
+						pxDropBuffer = ( NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( listGET_END_MARKER( &( xTxClassQueues[ uxLowest ] ) )->pxPrevious );
+						break;
+					}
+				}
+
+				if( pxDropBuffer != NULL )
+				{
+					( void ) uxListRemove( &( pxDropBuffer->xBufferListItem ) );
+					uxTxQueuedCount--;
+					iptraceTX_FRAME_DROPPED( pxDropBuffer );
+					vReleaseNetworkBufferAndDescriptor( pxDropBuffer );
+				}
+			}
+
+			if( uxTxQueuedCount >= ( UBaseType_t ) ipconfigTX_QUEUE_LENGTH )
+			{
+				/* All queued frames have the same or a higher priority. */
+				pxQueuedBuffer = NULL;
+			}
+			else if( xReleaseAfterSend != pdFALSE )
+			{
+				pxQueuedBuffer = pxNetworkBuffer;
+			}
+			else
+			{
+				/* The caller keeps its buffer, so a copy must wait. */
+				pxQueuedBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, ( BaseType_t ) pxNetworkBuffer->xDataLength );
+			}
+
+			if( pxQueuedBuffer != NULL )
+			{
+				pxQueuedBuffer->ucTxClass = ( uint8_t ) uxClass;
+				vListInsertEnd( &( xTxClassQueues[ uxClass ] ), &( pxQueuedBuffer->xBufferListItem ) );
+				uxTxQueuedCount++;
+				xReturn = pdPASS;
+
+				/* The driver may have room again by now. */
+				prvTxSchedulerDrain();
+			}
+			else
+			{
+				iptraceTX_FRAME_DROPPED( pxNetworkBuffer );
+
+				if( xReleaseAfterSend != pdFALSE )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static NetworkBufferDescriptor_t *prvTxSchedulerNext( void )
+	{
+	NetworkBufferDescriptor_t *pxBuffer = NULL;
+	List_t *pxList;
+
+		if( listLIST_IS_EMPTY( &( xTxClassQueues[ 0 ] ) ) == pdFALSE )
+		{
+			/* Class 0 has strict priority. */
+			pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( xTxClassQueues[ 0 ] ) );
+		}
+		else
+		{
+			/* At least one of the other classes has a frame waiting.  Each
+			turn adds a quantum to the deficit of a class, so this loop ends
+			even when a frame is larger than the quantum. */
+			for( ;; )
+			{
+				pxList = &( xTxClassQueues[ uxTxDRRClass ] );
+
+				if( listLIST_IS_EMPTY( pxList ) == pdFALSE )
+				{
+					if( xTxQuantumGiven == pdFALSE )
+					{
+						ulTxDeficit[ uxTxDRRClass ] += ( uint32_t ) ipconfigTX_DRR_QUANTUM;
+						xTxQuantumGiven = pdTRUE;
+					}
+
+					pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxList );
+
+					if( ( uint32_t ) pxBuffer->xDataLength <= ulTxDeficit[ uxTxDRRClass ] )
+					{
+						ulTxDeficit[ uxTxDRRClass ] -= ( uint32_t ) pxBuffer->xDataLength;
+						break;
+					}
+				}
+				else
+				{
+					/* An idle class does not save up credit. */
+					ulTxDeficit[ uxTxDRRClass ] = 0u;
+				}
+
+				/* Give the next class its turn. */
+				uxTxDRRClass++;
+				if( uxTxDRRClass >= ( UBaseType_t ) ipconfigTX_PRIORITY_CLASSES )
+				{
+					uxTxDRRClass = 1u;
+				}
+				xTxQuantumGiven = pdFALSE;
+			}
+		}
+
+		( void ) uxListRemove( &( pxBuffer->xBufferListItem ) );
+		uxTxQueuedCount--;
+
+		return pxBuffer;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTxSchedulerDrain( void )
+	{
+		while( ( uxTxQueuedCount != 0u ) && ( ipconfigNETWORK_INTERFACE_TX_READY() != pdFALSE ) )
+		{
+			( void ) xNetworkInterfaceOutput( prvTxSchedulerNext(), pdTRUE );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTxSchedulerFlush( void )
+	{
+	NetworkBufferDescriptor_t *pxBuffer;
+	UBaseType_t uxClass;
+
+		for( uxClass = 0u; uxClass < ( UBaseType_t ) ipconfigTX_PRIORITY_CLASSES; uxClass++ )
+		{
+			while( listLIST_IS_EMPTY( &( xTxClassQueues[ uxClass ] ) ) == pdFALSE )
+			{
+				pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( xTxClassQueues[ uxClass ] ) );
+				( void ) uxListRemove( &( pxBuffer->xBufferListItem ) );
+				vReleaseNetworkBufferAndDescriptor( pxBuffer );
+			}
+
+			ulTxDeficit[ uxClass ] = 0u;
+		}
+
+		uxTxQueuedCount = 0u;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 void *FreeRTOS_GetUDPPayloadBuffer( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
 {
 NetworkBufferDescriptor_t *pxNetworkBuffer;
@@ -839,6 +1237,16 @@ NetworkBufferDescriptor_t * pxNewBuffer;
 		pxNewBuffer->ulIPAddress = pxNetworkBuffer->ulIPAddress;
 		pxNewBuffer->usPort = pxNetworkBuffer->usPort;
 		pxNewBuffer->usBoundPort = pxNetworkBuffer->usBoundPort;
+		#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+		{
+			pxNewBuffer->usLargeSendMSS = pxNetworkBuffer->usLargeSendMSS;
+		}
+		#endif /* ipconfigUSE_TCP_LARGE_SEND */
+		#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		{
+			pxNewBuffer->ucTxClass = pxNetworkBuffer->ucTxClass;
+		}
+		#endif /* ipconfigTX_PRIORITY_CLASSES */
 		memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
 	}
 
@@ -1214,6 +1622,119 @@ BaseType_t xReturn, xSendMessage;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+
+	void vNetworkRxChainAppend( NetworkRxChain_t *pxChain, NetworkBufferDescriptor_t *pxBuffer, TickType_t xTimeout )
+	{
+		pxBuffer->pxNextBuffer = NULL;
+
+		if( pxChain->pxHead == NULL )
+		{
+			/* Becomes the first message. */
+			pxChain->pxHead = pxBuffer;
+		}
+		else
+		{
+			/* Add to the tail. */
+			pxChain->pxTail->pxNextBuffer = pxBuffer;
+		}
+
+		pxChain->pxTail = pxBuffer;
+		pxChain->uxCount++;
+
+		if( pxChain->uxCount >= ( UBaseType_t ) ipconfigMAX_LINKED_RX_MESSAGES )
+		{
+			( void ) xNetworkRxChainSend( pxChain, xTimeout );
+		}
+	}
+
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+
+	BaseType_t xNetworkRxChainSend( NetworkRxChain_t *pxChain, TickType_t xTimeout )
+	{
+	IPStackEvent_t xRxEvent;
+	NetworkBufferDescriptor_t *pxBuffer, *pxNextBuffer;
+	BaseType_t xReturn = pdPASS;
+
+		if( pxChain->pxHead != NULL )
+		{
+			xRxEvent.eEventType = eNetworkRxEvent;
+			xRxEvent.pvData = ( void * ) pxChain->pxHead;
+
+			if( xSendEventStructToIPTask( &xRxEvent, xTimeout ) == pdFAIL )
+			{
+				/* The chain could not be sent to the stack so all of its
+				buffers must be released again. */
+				for( pxBuffer = pxChain->pxHead; pxBuffer != NULL; pxBuffer = pxNextBuffer )
+				{
+					pxNextBuffer = pxBuffer->pxNextBuffer;
+					vReleaseNetworkBufferAndDescriptor( pxBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+
+				xReturn = pdFAIL;
+			}
+
+			pxChain->pxHead = NULL;
+			pxChain->pxTail = NULL;
+			pxChain->uxCount = 0u;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxNetworkRxTakeBuffer( uint8_t **ppucDMABuffer, size_t xLength, size_t xRefillSize, UBaseType_t uxMinimumFree, TickType_t xBlockTime )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+	NetworkBufferDescriptor_t *pxNewBuffer;
+#endif
+
+	if( ( uxMinimumFree == 0u ) || ( uxGetNumberOfFreeNetworkBuffers() > uxMinimumFree ) )
+	{
+		#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+		{
+			/* Only hand out the DMA buffer when the descriptor can get a
+			replacement, so that every descriptor always owns a buffer. */
+			pxNewBuffer = pxGetNetworkBufferWithDescriptor( xRefillSize, xBlockTime );
+
+			if( pxNewBuffer != NULL )
+			{
+				pxReturn = pxPacketBuffer_to_NetworkBuffer( *ppucDMABuffer );
+				configASSERT( pxReturn != NULL );
+				*ppucDMABuffer = pxNewBuffer->pucEthernetBuffer;
+			}
+		}
+		#else
+		{
+			( void ) xRefillSize;
+
+			/* Create a buffer of exactly the required length. */
+			pxReturn = pxGetNetworkBufferWithDescriptor( xLength, xBlockTime );
+
+			if( pxReturn != NULL )
+			{
+				memcpy( ( void * ) pxReturn->pucEthernetBuffer, ( void * ) *ppucDMABuffer, xLength );
+			}
+		}
+		#endif /* ipconfigZERO_COPY_RX_DRIVER */
+
+		if( pxReturn != NULL )
+		{
+			pxReturn->xDataLength = xLength;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
 eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
 {
 eFrameProcessingResult_t eReturn;
@@ -1293,6 +1814,13 @@ static void prvProcessNetworkDownEvent( void )
 	interface. */
 	FreeRTOS_ClearARP( );
 
+	#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	{
+		/* Frames that wait for the driver are dropped as well. */
+		prvTxSchedulerFlush();
+	}
+	#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 	/* The network has been disconnected (or is being initialised for the first
 	time).  Perform whatever hardware processing is necessary to bring it up
 	again, or wait for it to be available again.  This is hardware dependent. */
@@ -1482,7 +2010,18 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 	{
 		/* Some drivers of NIC's with checksum-offloading will enable the above
 		define, so that the checksum won't be checked again here */
-		if (eReturn == eProcessBuffer )
+		if( ( eReturn == eProcessBuffer ) && ( ipconfigDRIVER_RX_CHECKSUM_VERIFIED( pxNetworkBuffer ) != pdFALSE ) )
+		{
+			/* The peripheral has already verified the checksums of this
+			packet. */
+		}
+		else if( ( eReturn == eProcessBuffer ) && ( ipIS_LOOPBACK_FRAME( pxNetworkBuffer ) != pdFALSE ) &&
+			( pxIPHeader->ulSourceIPAddress == *ipLOCAL_IP_ADDRESS_POINTER ) )
+		{
+			/* The packet was looped back by xLoopbackOutput(), no checksums
+			were calculated for it. */
+		}
+		else if (eReturn == eProcessBuffer )
 		{
 			/* Is the IP header checksum correct? */
 			if( ( pxIPHeader->ucProtocol != ( uint8_t ) ipPROTOCOL_ICMP ) &&
@@ -1643,6 +2182,16 @@ uint8_t ucProtocol;
 
 #if ipconfigUSE_TCP == 1
 			case ipPROTOCOL_TCP :
+				#if( ipconfigTCP_DEFERRED_RX_BATCH != 0 )
+				{
+					/* Put the packet aside, prvIPTask() will pass it to
+					xProcessReceivedTCPPacket() once the event queue is empty.
+					All TCP packets go through the same list, so their order
+					is kept. */
+					vListInsertEnd( &xTCPDeferredRxList, &( pxNetworkBuffer->xBufferListItem ) );
+					eReturn = eFrameConsumed;
+				}
+				#else
 				{
 
 					if( xProcessReceivedTCPPacket( pxNetworkBuffer ) == pdPASS )
@@ -1654,6 +2203,7 @@ uint8_t ucProtocol;
 					to be called just before the IP-task blocks. */
 					xProcessedTCPMessage++;
 				}
+				#endif /* ipconfigTCP_DEFERRED_RX_BATCH */
 				break;
 #endif
 			default	:
@@ -1997,6 +2547,121 @@ uint8_t ucProtocol;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigCHECKSUM_METHOD == ipCHECKSUM_PORTABLE_32 )
+
+	static uint32_t prvChecksumAddBlocks( uint32_t ulSum, const uint32_t *pulSource, size_t uxBlockCount )
+	{
+	xUnion32 xSum, xSum2;
+	uint32_t ulCarry = 0ul;
+	size_t uxIndex;
+
+		xSum.u32 = ulSum;
+
+		/* In this loop, four 32-bit additions will be done, in total 16 bytes.
+		Indexing with constants (0,1,2,3) gives faster code than using
+		post-increments. */
+		for( uxIndex = 0u; uxIndex < uxBlockCount; uxIndex++ )
+		{
+			/* Use a secondary Sum2, just to see if the addition produced an
+			overflow. */
+			xSum2.u32 = xSum.u32 + pulSource[ 0 ];
+			if( xSum2.u32 < xSum.u32 )
+			{
+				ulCarry++;
+			}
+
+			/* Now add the secondary sum to the major sum, and remember if there was
+			a carry. */
+			xSum.u32 = xSum2.u32 + pulSource[ 1 ];
+			if( xSum2.u32 > xSum.u32 )
+			{
+				ulCarry++;
+			}
+
+			/* And do the same trick once again for indexes 2 and 3 */
+			xSum2.u32 = xSum.u32 + pulSource[ 2 ];
+			if( xSum2.u32 < xSum.u32 )
+			{
+				ulCarry++;
+			}
+
+			xSum.u32 = xSum2.u32 + pulSource[ 3 ];
+
+			if( xSum2.u32 > xSum.u32 )
+			{
+				ulCarry++;
+			}
+
+			/* And finally advance the pointer 4 * 4 = 16 bytes. */
+			pulSource += 4;
+		}
+
+		/* Now add all carries. */
+		return ( uint32_t ) xSum.u16[ 0 ] + xSum.u16[ 1 ] + ulCarry;
+	}
+
+#elif( ipconfigCHECKSUM_METHOD == ipCHECKSUM_PORTABLE_64 )
+
+	static uint32_t prvChecksumAddBlocks( uint32_t ulSum, const uint32_t *pulSource, size_t uxBlockCount )
+	{
+	uint64_t ullSum = ( uint64_t ) ulSum;
+	size_t uxIndex;
+
+		/* The carries out of the low 32 bits pile up in the high 32 bits,
+		which can not overflow for any packet that fits in memory. */
+		for( uxIndex = 0u; uxIndex < uxBlockCount; uxIndex++ )
+		{
+			ullSum += ( uint64_t ) pulSource[ 0 ] + pulSource[ 1 ];
+			ullSum += ( uint64_t ) pulSource[ 2 ] + pulSource[ 3 ];
+			pulSource += 4;
+		}
+
+		/* Fold the 64-bit sum to 32 bits, twice because the first addition
+		might carry. */
+		ullSum = ( ullSum & 0xffffffffull ) + ( ullSum >> 32 );
+		ullSum = ( ullSum & 0xffffffffull ) + ( ullSum >> 32 );
+
+		/* And fold it to 17 bits, like the portable 32-bit version. */
+		return ( uint32_t ) ( ( ullSum & 0xffffull ) + ( ( ullSum >> 16 ) & 0xffffull ) );
+	}
+
+#elif( ipconfigCHECKSUM_METHOD == ipCHECKSUM_ARM_ADC )
+
+	#if !defined( __GNUC__ ) || !( defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ ) )
+		#error ipCHECKSUM_ARM_ADC requires GCC and an ARMv7-M or ARMv7E-M target
+	#endif
+
+	static uint32_t prvChecksumAddBlocks( uint32_t ulSum, const uint32_t *pulSource, size_t uxBlockCount )
+	{
+	size_t uxIndex;
+
+		/* A one's complement sum can be calculated 32 bits at a time, as long
+		as the carry out of bit 31 is added back in ("end-around carry").  The
+		carry flag does exactly that, without a compare per word. */
+		for( uxIndex = 0u; uxIndex < uxBlockCount; uxIndex++ )
+		{
+			__asm volatile
+			(
+				"adds	%0, %0, %1	\n"
+				"adcs	%0, %0, %2	\n"
+				"adcs	%0, %0, %3	\n"
+				"adcs	%0, %0, %4	\n"
+				"adc	%0, %0, #0	\n"
+				: "+r" ( ulSum )
+				: "r" ( pulSource[ 0 ] ), "r" ( pulSource[ 1 ] ), "r" ( pulSource[ 2 ] ), "r" ( pulSource[ 3 ] )
+				: "cc"
+			);
+			pulSource += 4;
+		}
+
+		return ( ulSum & 0xffffu ) + ( ulSum >> 16 );
+	}
+
+#elif( ipconfigCHECKSUM_METHOD != ipCHECKSUM_APPLICATION )
+	#error Unknown value for ipconfigCHECKSUM_METHOD
+#endif /* ipconfigCHECKSUM_METHOD */
+/*-----------------------------------------------------------*/
+
 /**
  * This method generates a checksum for a given IPv4 header, per RFC791 (page 14).
  * The checksum algorithm is decribed as:
@@ -2030,16 +2695,16 @@ uint8_t ucProtocol;
  *   uxDataLengthBytes: This argument contains the number of bytes that this method
  *	 should process.
  */
-uint16_t usGenerateChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes )
+portHOT_FUNCTION uint16_t usGenerateChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes )
 {
-xUnion32 xSum2, xSum, xTerm;
+xUnion32 xSum, xTerm;
 xUnionPtr xSource;		/* Points to first byte */
 xUnionPtr xLastSource;	/* Points to last byte plus one */
-uint32_t ulAlignBits, ulCarry = 0ul;
+uint32_t ulAlignBits;
 
 	/* Small MCUs often spend up to 30% of the time doing checksum calculations
-	This function is optimised for 32-bit CPUs; Each time it will try to fetch
-	32-bits, sums it with an accumulator and counts the number of carries. */
+	This function is optimised for 32-bit CPUs; the aligned bulk of the data is
+	summed by prvChecksumAddBlocks(), see ipconfigCHECKSUM_METHOD. */
 
 	/* Swap the input (little endian platform only). */
 	xSum.u32 = FreeRTOS_ntohs( ulSum );
@@ -2066,50 +2731,9 @@ uint32_t ulAlignBits, ulCarry = 0ul;
 		/* Now xSource is word (32-bit) aligned. */
 	}
 
-	/* Word (32-bit) aligned, do the most part. */
-	xLastSource.u32ptr = ( xSource.u32ptr + ( uxDataLengthBytes / 4u ) ) - 3u;
-
-	/* In this loop, four 32-bit additions will be done, in total 16 bytes.
-	Indexing with constants (0,1,2,3) gives faster code than using
-	post-increments. */
-	while( xSource.u32ptr < xLastSource.u32ptr )
-	{
-		/* Use a secondary Sum2, just to see if the addition produced an
-		overflow. */
-		xSum2.u32 = xSum.u32 + xSource.u32ptr[ 0 ];
-		if( xSum2.u32 < xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		/* Now add the secondary sum to the major sum, and remember if there was
-		a carry. */
-		xSum.u32 = xSum2.u32 + xSource.u32ptr[ 1 ];
-		if( xSum2.u32 > xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		/* And do the same trick once again for indexes 2 and 3 */
-		xSum2.u32 = xSum.u32 + xSource.u32ptr[ 2 ];
-		if( xSum2.u32 < xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		xSum.u32 = xSum2.u32 + xSource.u32ptr[ 3 ];
-
-		if( xSum2.u32 > xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		/* And finally advance the pointer 4 * 4 = 16 bytes. */
-		xSource.u32ptr += 4;
-	}
-
-	/* Now add all carries. */
-	xSum.u32 = ( uint32_t )xSum.u16[ 0 ] + xSum.u16[ 1 ] + ulCarry;
+	/* Word (32-bit) aligned, do the most part, 16 bytes at a time. */
+	xSum.u32 = prvChecksumAddBlocks( xSum.u32, xSource.u32ptr, uxDataLengthBytes / 16u );
+	xSource.u32ptr += ( uxDataLengthBytes / 16u ) * 4u;
 
 	uxDataLengthBytes %= 16u;
 	xLastSource.u8ptr = ( uint8_t * ) ( xSource.u8ptr + ( uxDataLengthBytes & ~( ( size_t ) 1 ) ) );
@@ -2184,16 +2808,83 @@ EthernetHeader_t *pxEthernetHeader;
 	{
 		pxEthernetHeader = ( EthernetHeader_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
 
+		#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		{
+			/* Replies to ARP, ICMP, LLMNR and NBNS requests are control
+			traffic. */
+			pxNetworkBuffer->ucTxClass = 0u;
+		}
+		#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 		/* Swap source and destination MAC addresses. */
 		memcpy( ( void * ) &( pxEthernetHeader->xDestinationAddress ), ( void * ) &( pxEthernetHeader->xSourceAddress ), sizeof( pxEthernetHeader->xDestinationAddress ) );
 		memcpy( ( void * ) &( pxEthernetHeader->xSourceAddress) , ( void * ) ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
 		/* Send! */
-		xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
 	}
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_LOOPBACK != 0 )
+
+	BaseType_t xLoopbackOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+	{
+	NetworkBufferDescriptor_t *pxLoopBuffer;
+	IPStackEvent_t xRxEvent;
+	BaseType_t xReturn = pdFAIL;
+
+		if( ipIS_LOOPBACK_FRAME( pxNetworkBuffer ) == pdFALSE )
+		{
+			xReturn = ipDRIVER_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
+		}
+		else
+		{
+			if( xReleaseAfterSend != pdFALSE )
+			{
+				pxLoopBuffer = pxNetworkBuffer;
+			}
+			else
+			{
+				/* The caller keeps its buffer, e.g. the packet header of a TCP
+				socket. */
+				pxLoopBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, ( BaseType_t ) pxNetworkBuffer->xDataLength );
+			}
+
+			if( pxLoopBuffer != NULL )
+			{
+				#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+				{
+					pxLoopBuffer->pxNextBuffer = NULL;
+				}
+				#endif
+
+				/* The frame is not handled here, but posted to the event queue
+				of the IP-task, like a frame from the network driver.  Handling
+				it at once would re-enter the protocol code which is sending
+				it. */
+				xRxEvent.eEventType = eNetworkRxEvent;
+				xRxEvent.pvData = ( void * ) pxLoopBuffer;
+
+				if( xSendEventStructToIPTask( &xRxEvent, 0u ) == pdPASS )
+				{
+					iptraceLOOPBACK_PACKET_SENT( pxLoopBuffer );
+					xReturn = pdPASS;
+				}
+				else
+				{
+					vReleaseNetworkBufferAndDescriptor( pxLoopBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_LOOPBACK */
+/*-----------------------------------------------------------*/
+
 uint32_t FreeRTOS_GetIPAddress( void )
 {
 	/* Returns the IP address of the NIC. */
@@ -50,6 +50,15 @@ port number. */
 xBoundUDPSocketsList or xBoundTCPSocketsList */
 #define socketSOCKET_IS_BOUND( pxSocket )	  ( listLIST_ITEM_CONTAINER( & ( pxSocket )->xBoundSocketListItem ) != NULL )
 
+/* Test if a TCP socket may store data that will be sent along with a Fast Open
+SYN, i.e. it has not been connected yet. */
+#if( ipconfigTCP_FAST_OPEN != 0 )
+	#define socketTCP_FAST_OPEN_PENDING( pxSocket ) \
+		( ( ( pxSocket )->u.xTCP.ucTCPState == ( uint8_t ) eCLOSED ) && ( ( pxSocket )->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED ) )
+#else
+	#define socketTCP_FAST_OPEN_PENDING( pxSocket )	( pdFALSE )
+#endif
+
 /* If FreeRTOS_sendto() is called on a socket that is not bound to a port
 number then, depending on the FreeRTOSIPConfig.h settings, it might be that a
 port number is automatically generated for the socket.  Automatically generated
@@ -94,6 +103,42 @@ respectively. */
 #define sock80_PERCENT						80
 #define sock100_PERCENT						100
 
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 ) && ( INCLUDE_uxTaskPriorityGet != 1 )
+	#error ipconfigUSE_TCP_AUTOTUNING requires INCLUDE_uxTaskPriorityGet
+#endif
+
+#if( ipconfigTCP_RELEASE_CLOSED_BUFFERS != 0 ) && ( INCLUDE_uxTaskPriorityGet != 1 )
+	#error ipconfigTCP_RELEASE_CLOSED_BUFFERS requires INCLUDE_uxTaskPriorityGet
+#endif
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	#if( configUSE_16_BIT_TICKS == 1 )
+		#error ipconfigUSE_TCP_TIMER_WHEEL requires 32-bit clock ticks
+	#endif
+
+	/* The timer wheel has three levels of 64 slots.  A slot of level 0 covers
+	one clock tick, a slot of level 1 covers 64 ticks and a slot of level 2
+	covers 4096 ticks, so time-outs up to 2^18 ticks can be stored.  That is
+	more than the 0xffff ticks that fit in 'usTimeout'. */
+	#define socketWHEEL_BITS				( 6u )
+	#define socketWHEEL_SLOTS				( 1u << socketWHEEL_BITS )
+	#define socketWHEEL_MASK				( ( TickType_t ) socketWHEEL_SLOTS - 1u )
+	#define socketWHEEL_LEVELS				( 3u )
+
+	/* True when time 'xA' comes before time 'xB'. */
+	#define socketTIME_BEFORE( xA, xB )		( ( TickType_t ) ( ( xA ) - ( xB ) ) > ( portMAX_DELAY >> 1 ) )
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+	#if( ( ipconfigSOCKET_LOOKUP_TABLE_SIZE & ( ipconfigSOCKET_LOOKUP_TABLE_SIZE - 1 ) ) != 0 ) || ( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0x8000 )
+		#error ipconfigSOCKET_LOOKUP_TABLE_SIZE must be a power of 2, not larger than 0x8000
+	#endif
+
+	/* The value of usLookupSlot for a socket which is not in the lookup table. */
+	#define socketLOOKUP_SLOT_NONE			( ( uint16_t ) 0xffffu )
+
+	#define socketLOOKUP_TABLE_MASK			( ( UBaseType_t ) ipconfigSOCKET_LOOKUP_TABLE_SIZE - 1u )
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 
 /*-----------------------------------------------------------*/
 
@@ -110,6 +155,30 @@ static uint16_t prvGetPrivatePortNumber( BaseType_t xProtocol );
  */
 static const ListItem_t * pxListFindListItemWithValue( const List_t *pxList, TickType_t xWantedItemValue );
 
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+	/*
+	 * Return the home slot in the socket lookup table of the given key.
+	 */
+	static UBaseType_t prvSocketLookupHash( uint8_t ucProtocol, uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort );
+
+	/*
+	 * Find the socket stored under the given key in the socket lookup table.
+	 * Returns NULL if the key is not in the table.
+	 */
+	static FreeRTOS_Socket_t *prvSocketLookupFind( uint8_t ucProtocol, uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort );
+
+	/*
+	 * Store pxSocket under the given key in the socket lookup table, replacing
+	 * the entry it might already have.  Nothing is stored if the table is full.
+	 */
+	static void prvSocketLookupInsert( FreeRTOS_Socket_t *pxSocket, uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort );
+
+	/*
+	 * Remove pxSocket from the socket lookup table, if it is stored in it.
+	 */
+	static void prvSocketLookupRemove( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+
 /*
  * Return pdTRUE only if pxSocket is valid and bound, as far as can be
  * determined.
@@ -122,6 +191,23 @@ static BaseType_t prvValidSocket( FreeRTOS_Socket_t *pxSocket, BaseType_t xProto
  */
 static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType, BaseType_t xProtocol, size_t *pxSocketSize );
 
+/*
+ * Called from FreeRTOS_recvfrom() and FreeRTOS_recvmmsg(): wait, within the
+ * socket's receive timeout, until a UDP packet is waiting.  Returns the number
+ * of waiting packets; when that is zero, the event bits that ended the wait are
+ * in *pxEventBits.
+ */
+static BaseType_t prvRecvFromWaitForPackets( FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits );
+
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	/*
+	 * Fill in the headers of a packet to the peer of a connected UDP socket
+	 * from the socket's header template.  Returns pdFALSE when the template is
+	 * not valid, the IP-task must then build the headers.
+	 */
+	static BaseType_t prvUDPUseTemplate( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Create a txStream or a rxStream, depending on the parameter 'xIsInputStream'
@@ -137,6 +223,45 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength );
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+	/*
+	 * Called by the socket owner: apply the stream size that the IP-task has
+	 * chosen, if the stream is empty.  The stream is released, it will be
+	 * created again with the new size when it is needed.
+	 */
+	static void prvTCPAutotuneApply( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
+
+	/*
+	 * Stop tuning the streams of a socket and return the memory it got to the
+	 * global budget.
+	 */
+	static void prvTCPAutotuneStop( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
+#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_RELEASE_CLOSED_BUFFERS != 0 ) )
+	/*
+	 * Called by the socket owner once the connection has ended: free an empty
+	 * stream that will not be used any more, and the window segments when both
+	 * streams are gone.
+	 */
+	static void prvTCPReleaseClosedStream( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
+#endif /* ipconfigTCP_RELEASE_CLOSED_BUFFERS */
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	/*
+	 * Store the timer of pxSocket in the wheel, its expiry time must be set in
+	 * the item value already.
+	 */
+	static void prvTCPWheelInsert( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Find the first moment, at or after xTCPWheelTime, that the wheel needs
+	 * attention: a time-out in level 0, or a slot of a higher level that must
+	 * be spread over the lower level.
+	 */
+	static void prvTCPWheelFindNextEvent( void );
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * When a child socket gets closed, make sure to update the child-count of the parent
@@ -157,6 +282,9 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	/* Executed by the IP-task, it will check all sockets belonging to a set */
 	static FreeRTOS_Socket_t *prvFindSelectedSocket( SocketSelect_t *pxSocketSet );
 
+	/* Take a socket off the ready list of its socket set. */
+	static void prvSelectReadyRemove( FreeRTOS_Socket_t *pxSocket );
+
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
 /*-----------------------------------------------------------*/
 
@@ -168,6 +296,47 @@ List_t xBoundUDPSocketsList;
 	List_t xBoundTCPSocketsList;
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+	/* The number of bytes that tuned streams use on top of their configured
+	sizes, limited by ipconfigTCP_AUTOTUNE_MEMORY_CAP. */
+	static size_t uxAutotuneBytesInUse = 0u;
+#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
+#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_CONNECTION_STATS != 0 ) )
+	/* The counters of the TCP sockets that have been closed.  Only changed by
+	the IP-task, while the scheduler is suspended. */
+	static TCPStackStats_t xTCPClosedTotals;
+#endif /* ipconfigUSE_TCP && ipconfigTCP_CONNECTION_STATS */
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	/* The TCP timer wheel, only accessed by the IP-task. */
+	static List_t xTCPTimerWheel[ socketWHEEL_LEVELS ][ socketWHEEL_SLOTS ];
+	/* All clock ticks before this time have been processed. */
+	static TickType_t xTCPWheelTime;
+	/* The next time that the wheel needs attention. */
+	static TickType_t xTCPWheelNextEvent;
+	/* The number of timers that are stored in the wheel. */
+	static UBaseType_t uxTCPWheelCount = 0u;
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+	/* An entry in the socket lookup table.  The key is kept in the entry, so
+	that probing the table does not need to access the sockets.  The table is
+	only accessed from the IP-task. */
+	typedef struct xSOCKET_LOOKUP_ENTRY
+	{
+		FreeRTOS_Socket_t *pxSocket;	/* NULL for an empty slot. */
+		uint32_t ulRemoteIP;			/* Remote IP-address in host-endian notation, 0 for UDP. */
+		uint16_t usLocalPort;			/* Local port number in host-endian notation. */
+		uint16_t usRemotePort;			/* Remote port number in host-endian notation, 0 for UDP. */
+		uint8_t ucProtocol;				/* FREERTOS_IPPROTO_UDP or FREERTOS_IPPROTO_TCP. */
+	} SocketLookupEntry_t;
+
+	/* Open-addressed, linear probing.  As entries are removed by shifting the
+	following entries back, a probe can stop at the first empty slot. */
+	static SocketLookupEntry_t xSocketLookupTable[ ipconfigSOCKET_LOOKUP_TABLE_SIZE ];
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+
 /*-----------------------------------------------------------*/
 
 static BaseType_t prvValidSocket( FreeRTOS_Socket_t *pxSocket, BaseType_t xProtocol, BaseType_t xIsBound )
@@ -203,6 +372,21 @@ BaseType_t vNetworkSocketsInit( void )
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
 
+	#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	{
+	UBaseType_t uxLevel, uxSlot;
+
+		for( uxLevel = 0u; uxLevel < socketWHEEL_LEVELS; uxLevel++ )
+		{
+			for( uxSlot = 0u; uxSlot < socketWHEEL_SLOTS; uxSlot++ )
+			{
+				vListInitialise( &( xTCPTimerWheel[ uxLevel ][ uxSlot ] ) );
+			}
+		}
+		xTCPWheelTime = xTaskGetTickCount();
+	}
+	#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 	return pdTRUE;
 }
 /*-----------------------------------------------------------*/
@@ -321,10 +505,28 @@ Socket_t xReturn;
 			vListInitialiseItem( &( pxSocket->xBoundSocketListItem ) );
 			listSET_LIST_ITEM_OWNER( &( pxSocket->xBoundSocketListItem ), ( void * ) pxSocket );
 
+			#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+			{
+				vListInitialiseItem( &( pxSocket->xSelectListItem ) );
+				listSET_LIST_ITEM_OWNER( &( pxSocket->xSelectListItem ), ( void * ) pxSocket );
+			}
+			#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+
 			pxSocket->xReceiveBlockTime = ipconfigSOCK_DEFAULT_RECEIVE_BLOCK_TIME;
 			pxSocket->xSendBlockTime	= ipconfigSOCK_DEFAULT_SEND_BLOCK_TIME;
 			pxSocket->ucSocketOptions   = ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT;
 			pxSocket->ucProtocol		= ( uint8_t ) xProtocol; /* protocol: UDP or TCP */
+			#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+			{
+				pxSocket->ucTxClass = ( uint8_t ) ipconfigTX_DEFAULT_CLASS;
+			}
+			#endif /* ipconfigTX_PRIORITY_CLASSES */
+
+			#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+			{
+				pxSocket->usLookupSlot = socketLOOKUP_SLOT_NONE;
+			}
+			#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 
 			#if( ipconfigUSE_TCP == 1 )
 			{
@@ -333,6 +535,13 @@ Socket_t xReturn;
 					/* StreamSize is expressed in number of bytes */
 					/* Round up buffer sizes to nearest multiple of MSS */
 					pxSocket->u.xTCP.usInitMSS	= pxSocket->u.xTCP.usCurMSS = ipconfigTCP_MSS;
+					#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+					{
+						pxSocket->u.xTCP.ucAckEvery = ( uint8_t ) ipconfigTCP_ACK_EVERY_SEGMENTS;
+						pxSocket->u.xTCP.usAckDelayMs = ( uint16_t ) ipconfigTCP_ACK_MAX_DELAY_MS;
+						pxSocket->u.xTCP.ucAckOnPush = ( uint8_t ) ( ipconfigTCP_ACK_ON_PUSH != 0 );
+					}
+					#endif /* ipconfigUSE_TCP_ACK_POLICY */
 					pxSocket->u.xTCP.uxRxStreamSize = ( size_t ) ipconfigTCP_RX_BUFFER_LENGTH;
 					pxSocket->u.xTCP.uxTxStreamSize = ( size_t ) FreeRTOS_round_up( ipconfigTCP_TX_BUFFER_LENGTH, ipconfigTCP_MSS );
 					/* Use half of the buffer size of the TCP windows */
@@ -347,6 +556,27 @@ Socket_t xReturn;
 						pxSocket->u.xTCP.uxTxWinSize  = 1u;
 					}
 					#endif
+					#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+					{
+						vListInitialiseItem( &( pxSocket->u.xTCP.xTimerListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xTimerListItem ), ( void * ) pxSocket );
+					}
+					#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+					#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
+					{
+						vListInitialise( &( pxSocket->u.xTCP.xAcceptQueue ) );
+						vListInitialiseItem( &( pxSocket->u.xTCP.xAcceptListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xAcceptListItem ), ( void * ) pxSocket );
+					}
+					#endif /* ipconfigTCP_ACCEPT_QUEUE */
+					#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+					{
+						pxSocket->u.xTCP.ucAutotune = pdTRUE;
+						pxSocket->u.xTCP.uxRxStreamBase = pxSocket->u.xTCP.uxRxStreamTarget = pxSocket->u.xTCP.uxRxStreamSize;
+						pxSocket->u.xTCP.uxTxStreamBase = pxSocket->u.xTCP.uxTxStreamTarget = pxSocket->u.xTCP.uxTxStreamSize;
+						pxSocket->u.xTCP.xAutoIntervalStart = pxSocket->u.xTCP.xAutoLastActive = xTaskGetTickCount();
+					}
+					#endif /* ipconfigUSE_TCP_AUTOTUNING */
 					/* The above values are just defaults, and can be overridden by
 					calling FreeRTOS_setsockopt().  No buffers will be allocated until a
 					socket is connected and data is exchanged. */
@@ -376,6 +606,7 @@ Socket_t xReturn;
 		if( pxSocketSet != NULL )
 		{
 			memset( pxSocketSet, '\0', sizeof( *pxSocketSet ) );
+			vListInitialise( &( pxSocketSet->xReadyList ) );
 			pxSocketSet->xSelectGroup = xEventGroupCreate();
 
 			if( pxSocketSet->xSelectGroup == NULL )
@@ -397,6 +628,16 @@ Socket_t xReturn;
 	{
 		SocketSelect_t *pxSocketSet = ( SocketSelect_t*) xSocketSet;
 
+		/* The sockets must not refer to the freed list. */
+		vTaskSuspendAll();
+		{
+			while( listLIST_IS_EMPTY( &( pxSocketSet->xReadyList ) ) == pdFALSE )
+			{
+				( void ) uxListRemove( listGET_HEAD_ENTRY( &( pxSocketSet->xReadyList ) ) );
+			}
+		}
+		xTaskResumeAll();
+
 		vEventGroupDelete( pxSocketSet->xSelectGroup );
 		vPortFree( ( void* ) pxSocketSet );
 	}
@@ -423,6 +664,7 @@ Socket_t xReturn;
 		{
 			/* Adding a socket to a socket set. */
 			pxSocket->pxSocketSet = ( SocketSelect_t * ) xSocketSet;
+			vSocketSelectReady( pxSocket );
 
 			/* Now have the IP-task call vSocketSelect() to see if the set contains
 			any sockets which are 'ready' and set the proper bits.
@@ -450,10 +692,14 @@ Socket_t xReturn;
 		if( ( pxSocket->xSelectBits & eSELECT_ALL ) != 0 )
 		{
 			pxSocket->pxSocketSet = ( SocketSelect_t *)xSocketSet;
+
+			/* Have the bits that are no longer wanted cleared. */
+			vSocketSelectReady( pxSocket );
 		}
 		else
 		{
 			/* disconnect it from the socket set */
+			prvSelectReadyRemove( pxSocket );
 			pxSocket->pxSocketSet = ( SocketSelect_t *)NULL;
 		}
 	}
@@ -594,28 +840,16 @@ Socket_t xReturn;
  * In this library, the function can only be used with connectionsless sockets
  * (UDP)
  */
-int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+static BaseType_t prvRecvFromWaitForPackets( FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits )
 {
-BaseType_t lPacketCount = 0;
-NetworkBufferDescriptor_t *pxNetworkBuffer;
-FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+BaseType_t lPacketCount;
 TickType_t xRemainingTime = ( TickType_t ) 0; /* Obsolete assignment, but some compilers output a warning if its not done. */
 BaseType_t xTimed = pdFALSE;
 TimeOut_t xTimeOut;
-int32_t lReturn;
 EventBits_t xEventBits = ( EventBits_t ) 0;
 
-	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE )
-	{
-		return -pdFREERTOS_ERRNO_EINVAL;
-	}
-
 	lPacketCount = ( BaseType_t ) listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
 
-	/* The function prototype is designed to maintain the expected Berkeley
-	sockets standard, but this implementation does not use all the parameters. */
-	( void ) pxSourceAddressLength;
-
 	while( lPacketCount == 0 )
 	{
 		if( xTimed == pdFALSE )
@@ -686,6 +920,31 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 		}
 	} /* while( lPacketCount == 0 ) */
 
+	*pxEventBits = xEventBits;
+
+	return lPacketCount;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+{
+BaseType_t lPacketCount;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+int32_t lReturn;
+EventBits_t xEventBits = ( EventBits_t ) 0;
+
+	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE )
+	{
+		return -pdFREERTOS_ERRNO_EINVAL;
+	}
+
+	/* The function prototype is designed to maintain the expected Berkeley
+	sockets standard, but this implementation does not use all the parameters. */
+	( void ) pxSourceAddressLength;
+
+	lPacketCount = prvRecvFromWaitForPackets( pxSocket, xFlags, &xEventBits );
+
 	if( lPacketCount != 0 )
 	{
 		taskENTER_CRITICAL();
@@ -758,6 +1017,100 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS != 0 )
+
+	int32_t FreeRTOS_recvmmsg( Socket_t xSocket, struct freertos_mmsghdr *pxMessages, size_t uxMessageCount, BaseType_t xFlags )
+	{
+	BaseType_t lPacketCount;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	struct freertos_mmsghdr *pxMessage;
+	List_t xReceivedList;
+	int32_t lReturn;
+	int32_t lLength;
+	EventBits_t xEventBits = ( EventBits_t ) 0;
+
+		if( ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE ) ||
+			( pxMessages == NULL ) || ( uxMessageCount == 0u ) ||
+			( ( xFlags & FREERTOS_MSG_PEEK ) != 0 ) )
+		{
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		lPacketCount = prvRecvFromWaitForPackets( pxSocket, xFlags, &xEventBits );
+
+		if( lPacketCount != 0 )
+		{
+			vListInitialise( &xReceivedList );
+
+			/* Take all the packets that fit in pxMessages[] from the socket in
+			one go, on a private list which the IP-task does not access. */
+			taskENTER_CRITICAL();
+			{
+				while( ( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0U ) &&
+					   ( listCURRENT_LIST_LENGTH( &xReceivedList ) < ( UBaseType_t ) uxMessageCount ) )
+				{
+					pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+					uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+					vListInsertEnd( &xReceivedList, &( pxNetworkBuffer->xBufferListItem ) );
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			/* Hand out the packets, in the order of arrival. */
+			for( pxMessage = pxMessages; listCURRENT_LIST_LENGTH( &xReceivedList ) > 0U; pxMessage++ )
+			{
+				pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xReceivedList );
+				uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+
+				lLength = ( int32_t ) pxNetworkBuffer->xDataLength;
+				pxMessage->xAddress.sin_port = pxNetworkBuffer->usPort;
+				pxMessage->xAddress.sin_addr = pxNetworkBuffer->ulIPAddress;
+
+				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+				{
+					/* Truncate the length if it won't fit in the buffer of this
+					message. */
+					if( lLength > ( int32_t ) pxMessage->xBufferLength )
+					{
+						iptraceRECVFROM_DISCARDING_BYTES( ( pxMessage->xBufferLength - lLength ) );
+						lLength = ( int32_t ) pxMessage->xBufferLength;
+					}
+
+					memcpy( pxMessage->pvBuffer, ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ), ( size_t ) lLength );
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+				else
+				{
+					/* As in FreeRTOS_recvfrom(), the caller must pass each of
+					these to FreeRTOS_ReleaseUDPPayloadBuffer(). */
+					pxMessage->pvBuffer = ( void * ) ( &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ) );
+				}
+
+				pxMessage->lLength = lLength;
+			}
+
+			lReturn = ( int32_t ) ( pxMessage - pxMessages );
+		}
+	#if( ipconfigSUPPORT_SIGNALS != 0 )
+		else if( ( xEventBits & eSOCKET_INTR ) != 0 )
+		{
+			lReturn = -pdFREERTOS_ERRNO_EINTR;
+			iptraceRECVFROM_INTERRUPTED();
+		}
+	#endif /* ipconfigSUPPORT_SIGNALS */
+		else
+		{
+			lReturn = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+			iptraceRECVFROM_TIMEOUT();
+		}
+
+		return lReturn;
+	}
+
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+/*-----------------------------------------------------------*/
+
 int32_t FreeRTOS_sendto( Socket_t xSocket, const void *pvBuffer, size_t xTotalDataLength, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress, socklen_t xDestinationAddressLength )
 {
 NetworkBufferDescriptor_t *pxNetworkBuffer;
@@ -766,6 +1119,9 @@ TimeOut_t xTimeOut;
 TickType_t xTicksToWait;
 int32_t lReturn = 0;
 FreeRTOS_Socket_t *pxSocket;
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	struct freertos_sockaddr xPeerAddress;
+#endif
 
 	pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 
@@ -775,6 +1131,18 @@ FreeRTOS_Socket_t *pxSocket;
 	( void ) xDestinationAddressLength;
 	configASSERT( pvBuffer );
 
+	#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	{
+		/* A socket with a peer may be used without giving an address. */
+		if( ( pxDestinationAddress == NULL ) && ( pxSocket->u.xUDP.ulPeerIPAddress != 0UL ) )
+		{
+			xPeerAddress.sin_addr = pxSocket->u.xUDP.ulPeerIPAddress;
+			xPeerAddress.sin_port = pxSocket->u.xUDP.usPeerPort;
+			pxDestinationAddress = &xPeerAddress;
+		}
+	}
+	#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+
 	if( xTotalDataLength <= ( size_t ) ipMAX_UDP_PAYLOAD_LENGTH )
 	{
 		/* If the socket is not already bound to an address, bind it now.
@@ -841,6 +1209,33 @@ FreeRTOS_Socket_t *pxSocket;
 				/* The socket options are passed to the IP layer in the
 				space that will eventually get used by the Ethernet header. */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+				#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+				{
+					pxNetworkBuffer->ucTxClass = pxSocket->ucTxClass;
+				}
+				#endif /* ipconfigTX_PRIORITY_CLASSES */
+
+				#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+				{
+					if( ( pxSocket->u.xUDP.ulPeerIPAddress != 0UL ) &&
+						( pxNetworkBuffer->ulIPAddress == pxSocket->u.xUDP.ulPeerIPAddress ) &&
+						( pxNetworkBuffer->usPort == pxSocket->u.xUDP.usPeerPort ) )
+					{
+						if( prvUDPUseTemplate( pxSocket, pxNetworkBuffer ) != pdFALSE )
+						{
+							/* The headers are complete, the IP-task only has
+							to pass the packet to the driver. */
+							xStackTxEvent.eEventType = eStackTxReadyEvent;
+						}
+						else
+						{
+							/* Let the IP-task build the headers and keep a
+							copy of them. */
+							pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] |= ( uint8_t ) FREERTOS_UDP_TEMPLATE_REQUEST;
+						}
+					}
+				}
+				#endif /* ipconfigUDP_CONNECTED_SOCKETS */
 
 				/* Tell the networking task that the packet needs sending. */
 				xStackTxEvent.pvData = pxNetworkBuffer;
@@ -894,6 +1289,96 @@ FreeRTOS_Socket_t *pxSocket;
 } /* Tested */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS != 0 )
+
+	int32_t FreeRTOS_sendmmsg( Socket_t xSocket, struct freertos_mmsghdr *pxMessages, size_t uxMessageCount, BaseType_t xFlags )
+	{
+	size_t uxIndex;
+	int32_t lReturn = 0;
+
+		/* Each datagram is passed to the IP-task as a separate eStackTxEvent,
+		because vProcessGeneratedUDPPacket() resolves the destination of every
+		packet on its own.  Stop at the first datagram that could not be
+		queued, so the return value tells how many have been sent. */
+		for( uxIndex = 0u; uxIndex < uxMessageCount; uxIndex++ )
+		{
+			pxMessages[ uxIndex ].lLength = FreeRTOS_sendto( xSocket, pxMessages[ uxIndex ].pvBuffer, pxMessages[ uxIndex ].xBufferLength, xFlags,
+				&( pxMessages[ uxIndex ].xAddress ), sizeof( pxMessages[ uxIndex ].xAddress ) );
+
+			if( pxMessages[ uxIndex ].lLength == 0 )
+			{
+				break;
+			}
+
+			lReturn++;
+		}
+
+		return lReturn;
+	}
+
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+
+	static BaseType_t prvUDPUseTemplate( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	IPUDPSocket_t *pxUDP = &( pxSocket->u.xUDP );
+	UDPPacket_t *pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+	uint32_t ulGeneration = pxUDP->ulTemplateGeneration;
+	BaseType_t xReturn = pdFALSE;
+
+		/* The template is only valid as long as the ARP cache has not changed
+		since it was made. */
+		if( ( ulGeneration != 0UL ) && ( ulGeneration == ulARPCacheGeneration ) )
+		{
+			memcpy( ( void * ) pxUDPPacket, ( void * ) pxUDP->ucHeaderTemplate, sizeof( pxUDP->ucHeaderTemplate ) );
+
+			/* The IP-task clears the generation while it rewrites the
+			template, see if that happened during the copy.  Also check that
+			the template belongs to the current peer and IP address. */
+			if( ( pxUDP->ulTemplateGeneration == ulGeneration ) &&
+				( pxUDPPacket->xIPHeader.ulDestinationIPAddress == pxNetworkBuffer->ulIPAddress ) &&
+				( pxUDPPacket->xUDPHeader.usDestinationPort == pxNetworkBuffer->usPort ) &&
+				( pxUDPPacket->xIPHeader.ulSourceIPAddress == *ipLOCAL_IP_ADDRESS_POINTER ) )
+			{
+				pxUDPPacket->xUDPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( pxNetworkBuffer->xDataLength + sizeof( UDPHeader_t ) ) );
+				pxUDPPacket->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( pxNetworkBuffer->xDataLength + sizeof( IPHeader_t ) + sizeof( UDPHeader_t ) ) );
+
+				/* The total transmit size adds on all headers. */
+				pxNetworkBuffer->xDataLength += ipUDP_PAYLOAD_OFFSET_IPv4;
+
+				#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+				{
+					/* The checksums of a looped-back packet are not verified. */
+					if( ipIS_LOOPBACK_FRAME( pxNetworkBuffer ) == pdFALSE )
+					{
+						pxUDPPacket->xIPHeader.usHeaderChecksum = 0u;
+						pxUDPPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxUDPPacket->xIPHeader.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+						pxUDPPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxUDPPacket->xIPHeader.usHeaderChecksum );
+
+						if( ( pxSocket->ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0u )
+						{
+							usGenerateProtocolChecksum( ( uint8_t * ) pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+						}
+						else
+						{
+							pxUDPPacket->xUDPHeader.usChecksum = 0u;
+						}
+					}
+				}
+				#endif /* ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM */
+
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+/*-----------------------------------------------------------*/
+
 /*
  * FreeRTOS_bind() : binds a sockt to a local port number.  If port 0 is
  * provided, a system provided port number will be assigned.  This function can
@@ -1049,21 +1534,23 @@ List_t *pxSocketList;
 			{
 				/* If the network driver can iterate through 'xBoundUDPSocketsList',
 				by calling xPortHasUDPSocket() then the IP-task must temporarily
-				suspend the scheduler to keep the list in a consistent state. */
-				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+				suspend the scheduler to keep the list in a consistent state.
+				The same holds for 'xBoundTCPSocketsList' when other tasks may
+				call FreeRTOS_TCPSnapshot(). */
+				#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigTCP_CONNECTION_STATS != 0 ) )
 				{
 					vTaskSuspendAll();
 				}
-				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS || ipconfigTCP_CONNECTION_STATS */
 
 				/* Add the socket to 'xBoundUDPSocketsList' or 'xBoundTCPSocketsList' */
 				vListInsertEnd( pxSocketList, &( pxSocket->xBoundSocketListItem ) );
 
-				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+				#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigTCP_CONNECTION_STATS != 0 ) )
 				{
 					xTaskResumeAll();
 				}
-				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS || ipconfigTCP_CONNECTION_STATS */
 			}
 		}
 	}
@@ -1143,6 +1630,12 @@ void *vSocketClose( FreeRTOS_Socket_t *pxSocket )
 {
 NetworkBufferDescriptor_t *pxNetworkBuffer;
 
+	#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+	{
+		prvSelectReadyRemove( pxSocket );
+	}
+	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+
 	#if( ipconfigUSE_TCP == 1 )
 	{
 		/* For TCP: clean up a little more. */
@@ -1170,6 +1663,35 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 				vPortFreeLarge( pxSocket->u.xTCP.txStream );
 			}
 
+			#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+			{
+				prvTCPAutotuneStop( pxSocket );
+			}
+			#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
+			#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+			{
+				/* Take the socket out of the timer wheel. */
+				vTCPSocketTimerSet( pxSocket, 0u );
+			}
+			#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
+			#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
+			{
+				/* A child leaves the accept queue of its parent, and the
+				children of a listening socket leave its queue. */
+				if( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xAcceptListItem ) ) != NULL )
+				{
+					( void ) uxListRemove( &( pxSocket->u.xTCP.xAcceptListItem ) );
+				}
+
+				while( listLIST_IS_EMPTY( &( pxSocket->u.xTCP.xAcceptQueue ) ) == pdFALSE )
+				{
+					( void ) uxListRemove( listGET_HEAD_ENTRY( &( pxSocket->u.xTCP.xAcceptQueue ) ) );
+				}
+			}
+			#endif /* ipconfigTCP_ACCEPT_QUEUE */
+
 			/* In case this is a child socket, make sure the child-count of the
 			parent socket is decreased. */
 			prvTCPSetSocketCount( pxSocket );
@@ -1183,21 +1705,41 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 	{
 		/* If the network driver can iterate through 'xBoundUDPSocketsList',
 		by calling xPortHasUDPSocket(), then the IP-task must temporarily
-		suspend the scheduler to keep the list in a consistent state. */
-		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+		suspend the scheduler to keep the list in a consistent state.  The
+		same holds for 'xBoundTCPSocketsList' and FreeRTOS_TCPSnapshot(). */
+		#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigTCP_CONNECTION_STATS != 0 ) )
 		{
 			vTaskSuspendAll();
 		}
-		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS || ipconfigTCP_CONNECTION_STATS */
 
 		uxListRemove( &( pxSocket->xBoundSocketListItem ) );
 
-		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+		#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_CONNECTION_STATS != 0 ) )
+		{
+			if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+			{
+				/* Keep the counters of this socket in the totals. */
+				xTCPClosedTotals.ulBytesReceived += pxSocket->u.xTCP.ulBytesReceived;
+				xTCPClosedTotals.ulBytesAcked += pxSocket->u.xTCP.ulBytesAcked;
+				xTCPClosedTotals.ulRetransmitCount += pxSocket->u.xTCP.xTCPWindow.ulRetransmitCount;
+			}
+		}
+		#endif /* ipconfigUSE_TCP && ipconfigTCP_CONNECTION_STATS */
+
+		#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigTCP_CONNECTION_STATS != 0 ) )
 		{
 			xTaskResumeAll();
 		}
-		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS || ipconfigTCP_CONNECTION_STATS */
+	}
+
+	#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+	{
+		/* The table must not refer to the socket once it has been freed. */
+		prvSocketLookupRemove( pxSocket );
 	}
+	#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 
 	/* Now the socket is not bound the list of waiting packets can be
 	drained. */
@@ -1332,21 +1874,62 @@ FreeRTOS_Socket_t *pxSocket;
 				break;
 		#endif /* ipconfigUDP_MAX_RX_PACKETS */
 
-		case FREERTOS_SO_UDPCKSUM_OUT :
-			/* Turn calculating of the UDP checksum on/off for this socket. */
-			lOptionValue = ( BaseType_t ) pvOptionValue;
+		#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+			case FREERTOS_SO_UDP_PEER:	/* Set or remove the peer of a UDP socket */
+				{
+				const struct freertos_sockaddr *pxPeer = ( const struct freertos_sockaddr * ) pvOptionValue;
 
-			if( lOptionValue == 0 )
-			{
-				pxSocket->ucSocketOptions &= ( uint8_t ) ~FREERTOS_SO_UDPCKSUM_OUT;
-			}
-			else
-			{
-				pxSocket->ucSocketOptions |= ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT;
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_UDP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					/* The template of the previous peer can not be used. */
+					pxSocket->u.xUDP.ulTemplateGeneration = 0UL;
+					if( pxPeer != NULL )
+					{
+						pxSocket->u.xUDP.ulPeerIPAddress = pxPeer->sin_addr;
+						pxSocket->u.xUDP.usPeerPort = pxPeer->sin_port;
+					}
+					else
+					{
+						pxSocket->u.xUDP.ulPeerIPAddress = 0UL;
+						pxSocket->u.xUDP.usPeerPort = 0u;
+					}
+					xReturn = 0;
+				}
+				break;
+		#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+
+		case FREERTOS_SO_UDPCKSUM_OUT :
+			/* Turn calculating of the UDP checksum on/off for this socket. */
+			lOptionValue = ( BaseType_t ) pvOptionValue;
+
+			if( lOptionValue == 0 )
+			{
+				pxSocket->ucSocketOptions &= ( uint8_t ) ~FREERTOS_SO_UDPCKSUM_OUT;
+			}
+			else
+			{
+				pxSocket->ucSocketOptions |= ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT;
 			}
 			xReturn = 0;
 			break;
 
+		#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+			case FREERTOS_SO_PRIORITY:	/* Select the transmit traffic class */
+				{
+				BaseType_t xClass = *( ( const BaseType_t * ) pvOptionValue );
+
+					if( ( xClass < 0 ) || ( xClass >= ( BaseType_t ) ipconfigTX_PRIORITY_CLASSES ) )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					pxSocket->ucTxClass = ( uint8_t ) xClass;
+					xReturn = 0;
+				}
+				break;
+		#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 		#if( ipconfigUSE_CALLBACKS == 1 )
 			#if( ipconfigUSE_TCP == 1 )
 				case FREERTOS_SO_TCP_CONN_HANDLER:	/* Set a callback for (dis)connection events */
@@ -1450,6 +2033,13 @@ FreeRTOS_Socket_t *pxSocket;
 						FreeRTOS_debug_printf( ( "FREERTOS_SO_SET_LOW_HIGH_WATER: bad values\n" ) );
 						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
 					}
+					#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+					{
+						/* The limits would not be valid any more after the
+						reception stream has been resized. */
+						prvTCPAutotuneStop( pxSocket );
+					}
+					#endif /* ipconfigUSE_TCP_AUTOTUNING */
 					/* Send a STOP when buffer space drops below 'uxLittleSpace' bytes. */
 					pxSocket->u.xTCP.uxLittleSpace = pxLowHighWater->uxLittleSpace;
 					/* Send a GO when buffer space grows above 'uxEnoughSpace' bytes. */
@@ -1480,6 +2070,13 @@ FreeRTOS_Socket_t *pxSocket;
 
 					ulNewValue = *( ( uint32_t * ) pvOptionValue );
 
+					#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+					{
+						/* A size chosen by the user is respected. */
+						prvTCPAutotuneStop( pxSocket );
+					}
+					#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
 					if( lOptionName == FREERTOS_SO_SNDBUF )
 					{
 						/* Round up to nearest MSS size */
@@ -1564,6 +2161,27 @@ FreeRTOS_Socket_t *pxSocket;
 				xReturn = 0;
 				break;
 
+		#if( ipconfigTCP_FAST_OPEN != 0 )
+			case FREERTOS_SO_TCP_FASTOPEN:		/* Connect using TCP Fast Open */
+				{
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+					{
+						pxSocket->u.xTCP.bits.bFastOpen = pdTRUE_UNSIGNED;
+					}
+					else
+					{
+						pxSocket->u.xTCP.bits.bFastOpen = pdFALSE_UNSIGNED;
+					}
+				}
+				xReturn = 0;
+				break;
+		#endif /* ipconfigTCP_FAST_OPEN */
+
 			case FREERTOS_SO_CLOSE_AFTER_SEND:		/* As soon as the last byte has been transmitted, finalise the connection */
 				{
 					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
@@ -1610,6 +2228,55 @@ FreeRTOS_Socket_t *pxSocket;
 				xReturn = 0;
 				break;
 
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+				case FREERTOS_SO_TCP_CONGESTION_CONTROL:	/* Select the congestion control algorithm */
+					{
+					const TCPCongestionOps_t *pxOps = ( const TCPCongestionOps_t * ) pvOptionValue;
+
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						if( ( pxOps == NULL ) || ( pxOps->vInit == NULL ) || ( pxOps->vOnAck == NULL ) ||
+							( pxOps->vOnLoss == NULL ) || ( pxOps->vOnTimeout == NULL ) )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						/* The algorithm takes effect when the connection gets
+						established. */
+						pxSocket->u.xTCP.pxCongestionOps = pxOps;
+						xReturn = 0;
+					}
+					break;
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+			#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+				case FREERTOS_SO_TCP_ACK_POLICY:	/* Determine when received data is acknowledged */
+					{
+					const AckPolicy_t *pxAckPolicy = ( const AckPolicy_t * ) pvOptionValue;
+
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						/* RFC 1122 does not allow to delay an ACK for more
+						than 500 ms. */
+						if( ( pxAckPolicy->uxAckEvery > 0xffu ) || ( pxAckPolicy->uxMaxDelayMs > 500u ) )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						pxSocket->u.xTCP.ucAckEvery = ( uint8_t ) pxAckPolicy->uxAckEvery;
+						pxSocket->u.xTCP.usAckDelayMs = ( uint16_t ) pxAckPolicy->uxMaxDelayMs;
+						pxSocket->u.xTCP.ucAckOnPush = ( uint8_t ) ( pxAckPolicy->xAckOnPush != pdFALSE );
+						xReturn = 0;
+					}
+					break;
+			#endif /* ipconfigUSE_TCP_ACK_POLICY */
+
 			case FREERTOS_SO_STOP_RX:		/* Refuse to receive more packts */
 				{
 					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
@@ -1746,22 +2413,191 @@ const ListItem_t * pxResult = NULL;
 
 /*-----------------------------------------------------------*/
 
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+
+	static UBaseType_t prvSocketLookupHash( uint8_t ucProtocol, uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort )
+	{
+	uint32_t ulHash;
+
+		/* Fold the key into 32 bits and let a multiplicative hash (Knuth)
+		spread it over the upper bits, which are then used as the index. */
+		ulHash = ulRemoteIP ^ ( ( ( uint32_t ) usRemotePort ) << 16 ) ^ ( uint32_t ) usLocalPort ^ ( ( uint32_t ) ucProtocol << 8 );
+		ulHash *= 0x9E3779B1ul;
+
+		return ( UBaseType_t ) ( ulHash >> 16 ) & socketLOOKUP_TABLE_MASK;
+	}
+
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+
+	static FreeRTOS_Socket_t *prvSocketLookupFind( uint8_t ucProtocol, uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort )
+	{
+	UBaseType_t uxSlot = prvSocketLookupHash( ucProtocol, usLocalPort, ulRemoteIP, usRemotePort );
+	const SocketLookupEntry_t *pxEntry;
+	FreeRTOS_Socket_t *pxResult = NULL;
+
+		/* There is always at least one empty slot, as the table is never
+		filled completely. */
+		for( ;; )
+		{
+			pxEntry = &( xSocketLookupTable[ uxSlot ] );
+
+			if( pxEntry->pxSocket == NULL )
+			{
+				break;
+			}
+
+			if( ( pxEntry->usLocalPort == usLocalPort ) &&
+				( pxEntry->ulRemoteIP == ulRemoteIP ) &&
+				( pxEntry->usRemotePort == usRemotePort ) &&
+				( pxEntry->ucProtocol == ucProtocol ) )
+			{
+				pxResult = pxEntry->pxSocket;
+
+				#if( ipconfigUSE_TCP == 1 )
+				{
+					/* A TCP socket may have been reconnected to another peer
+					or be listening again since it was stored. */
+					if( ( ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ) &&
+						( ( pxResult->u.xTCP.ucTCPState == eTCP_LISTEN ) ||
+						  ( pxResult->u.xTCP.ulRemoteIP != ulRemoteIP ) ||
+						  ( pxResult->u.xTCP.usRemotePort != usRemotePort ) ) )
+					{
+						prvSocketLookupRemove( pxResult );
+						pxResult = NULL;
+					}
+				}
+				#endif /* ipconfigUSE_TCP */
+
+				break;
+			}
+
+			uxSlot = ( uxSlot + 1u ) & socketLOOKUP_TABLE_MASK;
+		}
+
+		return pxResult;
+	}
+
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+
+	static void prvSocketLookupInsert( FreeRTOS_Socket_t *pxSocket, uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort )
+	{
+	UBaseType_t uxSlot, uxCount;
+	SocketLookupEntry_t *pxEntry;
+
+		/* A socket is stored at most once. */
+		prvSocketLookupRemove( pxSocket );
+
+		uxSlot = prvSocketLookupHash( pxSocket->ucProtocol, usLocalPort, ulRemoteIP, usRemotePort );
+
+		/* Leave at least one slot empty, so that every probe terminates. */
+		for( uxCount = 1u; uxCount < ( UBaseType_t ) ipconfigSOCKET_LOOKUP_TABLE_SIZE; uxCount++ )
+		{
+			pxEntry = &( xSocketLookupTable[ uxSlot ] );
+
+			if( pxEntry->pxSocket == NULL )
+			{
+				pxEntry->pxSocket = pxSocket;
+				pxEntry->ulRemoteIP = ulRemoteIP;
+				pxEntry->usLocalPort = usLocalPort;
+				pxEntry->usRemotePort = usRemotePort;
+				pxEntry->ucProtocol = pxSocket->ucProtocol;
+				pxSocket->usLookupSlot = ( uint16_t ) uxSlot;
+				break;
+			}
+
+			uxSlot = ( uxSlot + 1u ) & socketLOOKUP_TABLE_MASK;
+		}
+	}
+
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+
+	static void prvSocketLookupRemove( FreeRTOS_Socket_t *pxSocket )
+	{
+	UBaseType_t uxHole, uxSlot, uxHome;
+	SocketLookupEntry_t *pxEntry;
+
+		if( pxSocket->usLookupSlot != socketLOOKUP_SLOT_NONE )
+		{
+			uxHole = ( UBaseType_t ) pxSocket->usLookupSlot;
+			configASSERT( xSocketLookupTable[ uxHole ].pxSocket == pxSocket );
+
+			xSocketLookupTable[ uxHole ].pxSocket = NULL;
+			pxSocket->usLookupSlot = socketLOOKUP_SLOT_NONE;
+
+			/* Move back the entries following the hole which can not be found
+			anymore now that the probe would stop at the hole.  That is the case
+			for every entry whose home slot does not lie between the hole and
+			the entry itself. */
+			uxSlot = uxHole;
+
+			for( ;; )
+			{
+				uxSlot = ( uxSlot + 1u ) & socketLOOKUP_TABLE_MASK;
+				pxEntry = &( xSocketLookupTable[ uxSlot ] );
+
+				if( pxEntry->pxSocket == NULL )
+				{
+					break;
+				}
+
+				uxHome = prvSocketLookupHash( pxEntry->ucProtocol, pxEntry->usLocalPort, pxEntry->ulRemoteIP, pxEntry->usRemotePort );
+
+				if( ( ( uxSlot - uxHome ) & socketLOOKUP_TABLE_MASK ) >= ( ( uxSlot - uxHole ) & socketLOOKUP_TABLE_MASK ) )
+				{
+					xSocketLookupTable[ uxHole ] = *pxEntry;
+					xSocketLookupTable[ uxHole ].pxSocket->usLookupSlot = ( uint16_t ) uxHole;
+					pxEntry->pxSocket = NULL;
+					uxHole = uxSlot;
+				}
+			}
+		}
+	}
+
+#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+/*-----------------------------------------------------------*/
+
 FreeRTOS_Socket_t *pxUDPSocketLookup( UBaseType_t uxLocalPort )
 {
 const ListItem_t *pxListItem;
 FreeRTOS_Socket_t *pxSocket = NULL;
 
-	/* Looking up a socket is quite simple, find a match with the local port.
-
-	See if there is a list item associated with the port number on the
-	list of bound sockets. */
-	pxListItem = pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) uxLocalPort );
+	#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+	{
+		/* 'uxLocalPort' is in network-byte-order, the table uses host-byte-
+		order like the 'usLocalPort' field of the socket. */
+		pxSocket = prvSocketLookupFind( ( uint8_t ) FREERTOS_IPPROTO_UDP, FreeRTOS_ntohs( ( uint16_t ) uxLocalPort ), 0ul, 0u );
+	}
+	#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 
-	if( pxListItem != NULL )
+	if( pxSocket == NULL )
 	{
-		/* The owner of the list item is the socket itself. */
-		pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxListItem );
-		configASSERT( pxSocket != NULL );
+		/* Looking up a socket is quite simple, find a match with the local port.
+
+		See if there is a list item associated with the port number on the
+		list of bound sockets. */
+		pxListItem = pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) uxLocalPort );
+
+		if( pxListItem != NULL )
+		{
+			/* The owner of the list item is the socket itself. */
+			pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxListItem );
+			configASSERT( pxSocket != NULL );
+
+			#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+			{
+				prvSocketLookupInsert( pxSocket, pxSocket->usLocalPort, 0ul, 0u );
+			}
+			#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
+		}
 	}
 	return pxSocket;
 }
@@ -1901,6 +2737,10 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		if( pxSocket->pxSocketSet != NULL )
 		{
 			EventBits_t xSelectBits = ( pxSocket->xEventBits >> SOCKET_EVENT_BIT_COUNT ) & eSELECT_ALL;
+
+			/* Any event may have made the socket ready. */
+			vSocketSelectReady( pxSocket );
+
 			if( xSelectBits != 0ul )
 			{
 				pxSocket->xSocketBits |= xSelectBits;
@@ -2011,6 +2851,17 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				/* IP address of remote machine. */
 				pxSocket->u.xTCP.ulRemoteIP = FreeRTOS_ntohl( pxAddress->sin_addr );
 
+				#if( ipconfigUSE_LOOPBACK != 0 )
+				{
+					/* A connection to 127.0.0.0/8 is made to the own IP address,
+					which the peer will see as the source address. */
+					if( ipIS_LOOPBACK_NETWORK( pxAddress->sin_addr ) )
+					{
+						pxSocket->u.xTCP.ulRemoteIP = FreeRTOS_ntohl( *ipLOCAL_IP_ADDRESS_POINTER );
+					}
+				}
+				#endif /* ipconfigUSE_LOOPBACK */
+
 				/* (client) internal state: socket wants to send a connect. */
 				vTCPStateChange( pxSocket, eCONNECT_SYN );
 
@@ -2167,6 +3018,14 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 				if( pxClientSocket != NULL )
 				{
+					#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+					{
+						/* Data that arrived before the socket was accepted
+						can now be selected. */
+						vSocketSelectReady( pxClientSocket );
+					}
+					#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+
 					if( pxAddress != NULL )
 					{
 						/* IP address of remote machine. */
@@ -2255,6 +3114,12 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+			{
+				prvTCPAutotuneApply( pxSocket, pdTRUE );
+			}
+			#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
 			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
 				xByteCount = ( BaseType_t )uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
@@ -2281,6 +3146,14 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					{
 						xByteCount = -pdFREERTOS_ERRNO_ENOTCONN;
 					}
+
+					#if( ipconfigTCP_RELEASE_CLOSED_BUFFERS != 0 )
+					{
+						/* No more data will come in. */
+						prvTCPReleaseClosedStream( pxSocket, pdTRUE );
+					}
+					#endif /* ipconfigTCP_RELEASE_CLOSED_BUFFERS */
+
 					/* Call continue to break out of the switch and also the while
 					loop. */
 					continue;
@@ -2412,9 +3285,10 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		{
 			xResult = -pdFREERTOS_ERRNO_ENOMEM;
 		}
-		else if( pxSocket->u.xTCP.ucTCPState == eCLOSED ||
-                 pxSocket->u.xTCP.ucTCPState == eCLOSE_WAIT ||
-                 pxSocket->u.xTCP.ucTCPState == eCLOSING )
+		else if( ( pxSocket->u.xTCP.ucTCPState == eCLOSED ||
+                   pxSocket->u.xTCP.ucTCPState == eCLOSE_WAIT ||
+                   pxSocket->u.xTCP.ucTCPState == eCLOSING ) &&
+				 ( socketTCP_FAST_OPEN_PENDING( pxSocket ) == pdFALSE ) )
 		{
 			xResult = -pdFREERTOS_ERRNO_ENOTCONN;
 		}
@@ -2430,14 +3304,23 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			/* send() is being called to send zero bytes */
 			xResult = 0;
 		}
-		else if( pxSocket->u.xTCP.txStream == NULL )
+		else
 		{
-			/* Create the outgoing stream only when it is needed */
-			prvTCPCreateStream( pxSocket, pdFALSE );
+			#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+			{
+				prvTCPAutotuneApply( pxSocket, pdFALSE );
+			}
+			#endif /* ipconfigUSE_TCP_AUTOTUNING */
 
 			if( pxSocket->u.xTCP.txStream == NULL )
 			{
-				xResult = -pdFREERTOS_ERRNO_ENOMEM;
+				/* Create the outgoing stream only when it is needed */
+				prvTCPCreateStream( pxSocket, pdFALSE );
+
+				if( pxSocket->u.xTCP.txStream == NULL )
+				{
+					xResult = -pdFREERTOS_ERRNO_ENOMEM;
+				}
 			}
 		}
 
@@ -2463,6 +3346,13 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
         member pointers. */
         if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdTRUE )
         {
+            if( pxSocket->u.xTCP.txStream == NULL )
+            {
+                /* Create the outgoing stream now, so that it can be written
+                to directly before anything has been sent. */
+                ( void ) prvTCPSendCheck( pxSocket, 1u );
+            }
+
             pxBuffer = pxSocket->u.xTCP.txStream;
             if( pxBuffer != NULL )
             {
@@ -2479,6 +3369,42 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	/* Get direct pointers to the data in the circular receive buffer, which
+	may consist of two parts. */
+	BaseType_t FreeRTOS_get_rx_regions( Socket_t xSocket, uint8_t **ppucFirst, size_t *puxFirstLength, uint8_t **ppucSecond, size_t *puxSecondLength )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xReturn = 0;
+
+		*ppucFirst = NULL;
+		*ppucSecond = NULL;
+		*puxFirstLength = 0u;
+		*puxSecondLength = 0u;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdFALSE )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else if( pxSocket->u.xTCP.rxStream != NULL )
+		{
+			/* Only the owner of the socket reads from the stream, and the
+			IP-task only appends data, so the regions stay valid until they are
+			released with FreeRTOS_recv(). */
+			xReturn = ( BaseType_t ) uxStreamBufferGetRegions( pxSocket->u.xTCP.rxStream, ppucFirst, puxFirstLength, ppucSecond, puxSecondLength );
+		}
+		else
+		{
+			/* No data has been received yet. */
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Send data using a TCP socket.  It is not necessary to have the socket
@@ -2501,6 +3427,16 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 		xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
 
+		#if( ipconfigTCP_RELEASE_CLOSED_BUFFERS != 0 )
+		{
+			if( xByteCount == -pdFREERTOS_ERRNO_ENOTCONN )
+			{
+				/* Nothing will be sent any more. */
+				prvTCPReleaseClosedStream( pxSocket, pdFALSE );
+			}
+		}
+		#endif /* ipconfigTCP_RELEASE_CLOSED_BUFFERS */
+
 		if( xByteCount > 0 )
 		{
 			/* xBytesLeft is number of bytes to send, will count to zero. */
@@ -2581,6 +3517,13 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					pvBuffer = ( void * ) ( ( ( const uint8_t * ) pvBuffer) + xByteCount );
 				}
 
+				if( socketTCP_FAST_OPEN_PENDING( pxSocket ) != pdFALSE )
+				{
+					/* The stream won't drain before the socket connects, so
+					don't wait for space. */
+					break;
+				}
+
 				/* Not all bytes have been sent. In case the socket is marked as
 				blocking sleep for a while. */
 				if( xTimed == pdFALSE )
@@ -2666,39 +3609,95 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
-	 * Request to put a socket in listen mode
+	 * Pass data that the application has written directly into the circular
+	 * transmit buffer, at the location returned by FreeRTOS_get_tx_head().
+	 * The data will be sent as if it was passed to FreeRTOS_send(), but without
+	 * copying it.  This function does not block.
 	 */
-	BaseType_t FreeRTOS_listen( Socket_t xSocket, BaseType_t xBacklog )
+	BaseType_t FreeRTOS_commit_tx( Socket_t xSocket, size_t uxDataLength )
 	{
-	FreeRTOS_Socket_t *pxSocket;
-	BaseType_t xResult = 0;
+	BaseType_t xByteCount;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 
-		pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+		xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
 
-		/* listen() is allowed for a valid TCP socket in Closed state and already
-		bound. */
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
-		{
-			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
-		}
-		else if( ( pxSocket->u.xTCP.ucTCPState != eCLOSED ) && ( pxSocket->u.xTCP.ucTCPState != eCLOSE_WAIT ) )
-		{
-			/* Socket is in a wrong state. */
-			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
-		}
-		else
+		if( xByteCount > 0 )
 		{
-			/* Backlog is interpreted here as "the maximum number of child
-			sockets. */
-			pxSocket->u.xTCP.usBacklog = ( uint16_t )FreeRTOS_min_int32( ( int32_t ) 0xffff, ( int32_t ) xBacklog );
-
-			/* This cleaning is necessary only if a listening socket is being
-			reused as it might have had a previous connection. */
-			if( pxSocket->u.xTCP.bits.bReuseSocket )
+			if( uxDataLength > uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream ) )
 			{
-				if( pxSocket->u.xTCP.rxStream != NULL )
+				/* More data than FreeRTOS_get_tx_head() can have offered. */
+				xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+			}
+			else
+			{
+				if( pxSocket->u.xTCP.bits.bCloseAfterSend != pdFALSE_UNSIGNED )
 				{
-					vStreamBufferClear( pxSocket->u.xTCP.rxStream );
+					/* Same as in FreeRTOS_send(): the IP-task must see the new
+					data and the close request at the same time. */
+					vTaskSuspendAll();
+					pxSocket->u.xTCP.bits.bCloseRequested = pdTRUE_UNSIGNED;
+				}
+
+				/* Only advance uxHead, the data is in place already. */
+				xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, NULL, uxDataLength );
+
+				if( pxSocket->u.xTCP.bits.bCloseAfterSend != pdFALSE_UNSIGNED )
+				{
+					xTaskResumeAll();
+				}
+
+				/* Let the IP-task work on this socket. */
+				pxSocket->u.xTCP.usTimeout = 1u;
+
+				if( xIsCallingFromIPTask() == pdFALSE )
+				{
+					xSendEventToIPTask( eTCPTimerEvent );
+				}
+			}
+		}
+
+		return xByteCount;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	/*
+	 * Request to put a socket in listen mode
+	 */
+	BaseType_t FreeRTOS_listen( Socket_t xSocket, BaseType_t xBacklog )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	BaseType_t xResult = 0;
+
+		pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+
+		/* listen() is allowed for a valid TCP socket in Closed state and already
+		bound. */
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		{
+			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+		}
+		else if( ( pxSocket->u.xTCP.ucTCPState != eCLOSED ) && ( pxSocket->u.xTCP.ucTCPState != eCLOSE_WAIT ) )
+		{
+			/* Socket is in a wrong state. */
+			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+		}
+		else
+		{
+			/* Backlog is interpreted here as "the maximum number of child
+			sockets. */
+			pxSocket->u.xTCP.usBacklog = ( uint16_t )FreeRTOS_min_int32( ( int32_t ) 0xffff, ( int32_t ) xBacklog );
+
+			/* This cleaning is necessary only if a listening socket is being
+			reused as it might have had a previous connection. */
+			if( pxSocket->u.xTCP.bits.bReuseSocket )
+			{
+				if( pxSocket->u.xTCP.rxStream != NULL )
+				{
+					vStreamBufferClear( pxSocket->u.xTCP.rxStream );
 				}
 
 				if( pxSocket->u.xTCP.txStream != NULL )
@@ -2849,6 +3848,317 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigARP_PENDING_PACKETS > 0 ) )
+
+	void vTCPARPResolved( void )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	const ListItem_t *pxEnd = ( const ListItem_t * ) listGET_END_MARKER( &xBoundTCPSocketsList );
+	const ListItem_t *pxIterator;
+	BaseType_t xFound = pdFALSE;
+
+		for( pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+			 pxIterator != pxEnd;
+			 pxIterator = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+			/* A connecting socket that has not been prepared yet is still
+			waiting for the MAC address of its peer or of the gateway. */
+			if( ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCONNECT_SYN ) &&
+				( pxSocket->u.xTCP.bits.bConnPrepared == pdFALSE_UNSIGNED ) )
+			{
+				vTCPSocketTimerSet( pxSocket, 1u );
+				xFound = pdTRUE;
+			}
+		}
+
+		if( xFound != pdFALSE )
+		{
+			/* Make sure the IP-task checks the TCP timers soon. */
+			( void ) xSendEventToIPTask( eTCPTimerEvent );
+		}
+	}
+
+#endif /* ipconfigUSE_TCP && ipconfigARP_PENDING_PACKETS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+
+	static void prvTCPWheelInsert( FreeRTOS_Socket_t *pxSocket )
+	{
+	ListItem_t *pxItem = &( pxSocket->u.xTCP.xTimerListItem );
+	TickType_t xExpiry = listGET_LIST_ITEM_VALUE( pxItem );
+	TickType_t xEvent;
+	List_t *pxSlot;
+
+		if( socketTIME_BEFORE( xExpiry, xTCPWheelTime ) )
+		{
+			/* The time has passed already, expire in the first tick that will
+			be processed. */
+			xExpiry = xTCPWheelTime;
+			listSET_LIST_ITEM_VALUE( pxItem, xExpiry );
+		}
+
+		if( ( xExpiry - xTCPWheelTime ) < ( ( TickType_t ) 1u << socketWHEEL_BITS ) )
+		{
+			pxSlot = &( xTCPTimerWheel[ 0 ][ xExpiry & socketWHEEL_MASK ] );
+			xEvent = xExpiry;
+		}
+		else if( ( xExpiry - xTCPWheelTime ) < ( ( TickType_t ) 1u << ( 2u * socketWHEEL_BITS ) ) )
+		{
+			pxSlot = &( xTCPTimerWheel[ 1 ][ ( xExpiry >> socketWHEEL_BITS ) & socketWHEEL_MASK ] );
+			xEvent = xExpiry & ~socketWHEEL_MASK;
+		}
+		else
+		{
+			pxSlot = &( xTCPTimerWheel[ 2 ][ ( xExpiry >> ( 2u * socketWHEEL_BITS ) ) & socketWHEEL_MASK ] );
+			xEvent = xExpiry & ~( ( ( TickType_t ) 1u << ( 2u * socketWHEEL_BITS ) ) - 1u );
+		}
+
+		vListInsertEnd( pxSlot, pxItem );
+
+		if( ( uxTCPWheelCount == 0u ) || socketTIME_BEFORE( xEvent, xTCPWheelNextEvent ) )
+		{
+			xTCPWheelNextEvent = xEvent;
+		}
+		uxTCPWheelCount++;
+	}
+
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+
+	static void prvTCPWheelFindNextEvent( void )
+	{
+	TickType_t xTime, xEvent, xBest = xTCPWheelTime;
+	UBaseType_t uxLevel, uxIndex, uxFirst, uxLast;
+	BaseType_t xFound = pdFALSE;
+
+		for( uxLevel = 0u; uxLevel < socketWHEEL_LEVELS; uxLevel++ )
+		{
+			/* Slot 'xTime + uxIndex' of this level starts at time
+			'( xTime + uxIndex ) << ( uxLevel * socketWHEEL_BITS )'. */
+			xTime = xTCPWheelTime >> ( uxLevel * socketWHEEL_BITS );
+			if( ( uxLevel == 0u ) ||
+				( ( xTCPWheelTime & ( ( ( TickType_t ) 1u << ( uxLevel * socketWHEEL_BITS ) ) - 1u ) ) == 0u ) )
+			{
+				/* Level 0, or a slot of a higher level that starts now and has
+				not been spread yet. */
+				uxFirst = 0u;
+				uxLast = socketWHEEL_SLOTS - 1u;
+			}
+			else
+			{
+				/* The current slot has been spread already, it can only contain
+				timers that are one round further. */
+				uxFirst = 1u;
+				uxLast = socketWHEEL_SLOTS;
+			}
+
+			for( uxIndex = uxFirst; uxIndex <= uxLast; uxIndex++ )
+			{
+				if( listLIST_IS_EMPTY( &( xTCPTimerWheel[ uxLevel ][ ( xTime + uxIndex ) & socketWHEEL_MASK ] ) ) == pdFALSE )
+				{
+					xEvent = ( xTime + uxIndex ) << ( uxLevel * socketWHEEL_BITS );
+					if( ( xFound == pdFALSE ) || socketTIME_BEFORE( xEvent, xBest ) )
+					{
+						xBest = xEvent;
+						xFound = pdTRUE;
+					}
+					break;
+				}
+			}
+		}
+
+		xTCPWheelNextEvent = xBest;
+	}
+
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+
+	void vTCPSocketTimerSet( FreeRTOS_Socket_t *pxSocket, TickType_t xTicks )
+	{
+	ListItem_t *pxItem = &( pxSocket->u.xTCP.xTimerListItem );
+	TickType_t xNow, xTime;
+
+		if( listLIST_ITEM_CONTAINER( pxItem ) != NULL )
+		{
+			( void ) uxListRemove( pxItem );
+			uxTCPWheelCount--;
+		}
+
+		pxSocket->u.xTCP.usTimeout = ( uint16_t ) xTicks;
+		pxSocket->u.xTCP.usTimerArmed = ( uint16_t ) xTicks;
+
+		if( xTicks != 0u )
+		{
+			xNow = xTaskGetTickCount();
+
+			/* Nothing happens in the wheel before its next event, so the time
+			until then doesn't have to be processed.  That keeps the distance
+			between xTCPWheelTime and the expiry time within the wheel. */
+			if( uxTCPWheelCount == 0u )
+			{
+				xTCPWheelTime = xNow;
+			}
+			else
+			{
+				xTime = socketTIME_BEFORE( xTCPWheelNextEvent, xNow ) ? xTCPWheelNextEvent : xNow;
+				if( socketTIME_BEFORE( xTCPWheelTime, xTime ) )
+				{
+					xTCPWheelTime = xTime;
+				}
+			}
+
+			listSET_LIST_ITEM_VALUE( pxItem, xNow + xTicks );
+			prvTCPWheelInsert( pxSocket );
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+
+	TickType_t xTCPTimerWheelCheck( BaseType_t xWillSleep, BaseType_t xCheckAll )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xTime, xShortest = portMAX_DELAY;
+	BaseType_t xWakeUpLater = pdFALSE;
+	UBaseType_t uxLevel;
+	List_t *pxSlot;
+	ListItem_t *pxEnd, *pxIterator;
+
+		if( xCheckAll != pdFALSE )
+		{
+			/* Socket owners set 'usTimeout' to ask the IP-task for attention,
+			and event bits must be passed to the socket owners. */
+			pxEnd = ( ListItem_t * ) listGET_END_MARKER( &xBoundTCPSocketsList );
+			pxIterator = ( ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+
+			while( pxIterator != pxEnd )
+			{
+				pxSocket = ( FreeRTOS_Socket_t * )listGET_LIST_ITEM_OWNER( pxIterator );
+				pxIterator = ( ListItem_t * ) listGET_NEXT( pxIterator );
+
+				if( ( pxSocket->u.xTCP.usTimeout != 0u ) &&
+					( ( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xTimerListItem ) ) == NULL ) ||
+					  ( pxSocket->u.xTCP.usTimeout != pxSocket->u.xTCP.usTimerArmed ) ) )
+				{
+					if( pxSocket->u.xTCP.usTimeout > 1u )
+					{
+						vTCPSocketTimerSet( pxSocket, ( TickType_t ) pxSocket->u.xTCP.usTimeout );
+					}
+					else
+					{
+						vTCPSocketTimerSet( pxSocket, 0u );
+						if( xTCPSocketCheck( pxSocket ) < 0 )
+						{
+							/* Continue because the socket was deleted. */
+							continue;
+						}
+					}
+				}
+
+				if( pxSocket->xEventBits != 0u )
+				{
+					if( xWillSleep != pdFALSE )
+					{
+						vSocketWakeUpUser( pxSocket );
+					}
+					else
+					{
+						xWakeUpLater = pdTRUE;
+					}
+				}
+			}
+		}
+
+		/* Process the clock ticks that have passed, jumping over the ticks in
+		which nothing happens. */
+		while( ( uxTCPWheelCount != 0u ) && ( socketTIME_BEFORE( xNow, xTCPWheelNextEvent ) == pdFALSE ) )
+		{
+			xTime = xTCPWheelNextEvent;
+			xTCPWheelTime = xTime;
+
+			/* At the start of a slot of a higher level, spread its timers over
+			the lower levels. */
+			for( uxLevel = socketWHEEL_LEVELS - 1u; uxLevel > 0u; uxLevel-- )
+			{
+				if( ( xTime & ( ( ( TickType_t ) 1u << ( uxLevel * socketWHEEL_BITS ) ) - 1u ) ) == 0u )
+				{
+					pxSlot = &( xTCPTimerWheel[ uxLevel ][ ( xTime >> ( uxLevel * socketWHEEL_BITS ) ) & socketWHEEL_MASK ] );
+					while( listLIST_IS_EMPTY( pxSlot ) == pdFALSE )
+					{
+						pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot );
+						( void ) uxListRemove( &( pxSocket->u.xTCP.xTimerListItem ) );
+						uxTCPWheelCount--;
+						prvTCPWheelInsert( pxSocket );
+					}
+				}
+			}
+
+			/* Timers that are set while checking the sockets will be stored
+			after this tick. */
+			xTCPWheelTime = xTime + 1u;
+
+			/* A timer that is set to expire 64 ticks from now will be added to
+			the end of this slot, the loop stops there. */
+			pxSlot = &( xTCPTimerWheel[ 0 ][ xTime & socketWHEEL_MASK ] );
+			while( ( listLIST_IS_EMPTY( pxSlot ) == pdFALSE ) &&
+				   ( listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxSlot ) == xTime ) )
+			{
+				pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot );
+				vTCPSocketTimerSet( pxSocket, 0u );
+
+				/* The socket might want to send a delayed ack or send out data
+				or whatever it needs to do. */
+				if( xTCPSocketCheck( pxSocket ) < 0 )
+				{
+					/* The socket was deleted. */
+					continue;
+				}
+
+				if( pxSocket->xEventBits != 0u )
+				{
+					if( xWillSleep != pdFALSE )
+					{
+						vSocketWakeUpUser( pxSocket );
+					}
+					else
+					{
+						xWakeUpLater = pdTRUE;
+					}
+				}
+			}
+
+			prvTCPWheelFindNextEvent();
+		}
+
+		if( uxTCPWheelCount != 0u )
+		{
+			/* Sleep until the wheel needs attention again. */
+			xShortest = xTCPWheelNextEvent - xNow;
+		}
+
+		if( xWakeUpLater != pdFALSE )
+		{
+			/* Make sure this will be called again to wake-up the sockets'
+			owners. */
+			xShortest = ( TickType_t ) 0;
+		}
+
+		return xShortest;
+	}
+
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -2866,34 +4176,54 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		/* Parameter not yet supported. */
 		( void ) ulLocalIP;
 
-		for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( ListItem_t * ) pxEnd;
-			 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
+		#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
 		{
-			FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			/* Only connected sockets are stored in the table.  A listening
+			socket may only be returned when no connected socket matches, which
+			can not be concluded from a miss in the table. */
+			pxResult = prvSocketLookupFind( ( uint8_t ) FREERTOS_IPPROTO_TCP, ( uint16_t ) uxLocalPort, ulRemoteIP, ( uint16_t ) uxRemotePort );
+		}
+		#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 
-			if( pxSocket->usLocalPort == ( uint16_t ) uxLocalPort )
+		if( pxResult == NULL )
+		{
+			for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( ListItem_t * ) pxEnd;
+				 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
 			{
-				if( pxSocket->u.xTCP.ucTCPState == eTCP_LISTEN )
+				FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+				if( pxSocket->usLocalPort == ( uint16_t ) uxLocalPort )
 				{
-					/* If this is a socket listening to uxLocalPort, remember it
-					in case there is no perfect match. */
-					pxListenSocket = pxSocket;
+					if( pxSocket->u.xTCP.ucTCPState == eTCP_LISTEN )
+					{
+						/* If this is a socket listening to uxLocalPort, remember it
+						in case there is no perfect match. */
+						pxListenSocket = pxSocket;
+					}
+					else if( ( pxSocket->u.xTCP.usRemotePort == ( uint16_t ) uxRemotePort ) && ( pxSocket->u.xTCP.ulRemoteIP == ulRemoteIP ) )
+					{
+						/* For sockets not in listening mode, find a match with
+						xLocalPort, ulRemoteIP AND xRemotePort. */
+						pxResult = pxSocket;
+						break;
+					}
 				}
-				else if( ( pxSocket->u.xTCP.usRemotePort == ( uint16_t ) uxRemotePort ) && ( pxSocket->u.xTCP.ulRemoteIP == ulRemoteIP ) )
+			}
+
+			if( pxResult == NULL )
+			{
+				/* An exact match was not found, maybe a listening socket was
+				found. */
+				pxResult = pxListenSocket;
+			}
+			#if( ipconfigSOCKET_LOOKUP_TABLE_SIZE > 0 )
+				else
 				{
-					/* For sockets not in listening mode, find a match with
-					xLocalPort, ulRemoteIP AND xRemotePort. */
-					pxResult = pxSocket;
-					break;
+					/* Next time this connection will be found in the table. */
+					prvSocketLookupInsert( pxResult, ( uint16_t ) uxLocalPort, ulRemoteIP, ( uint16_t ) uxRemotePort );
 				}
-			}
-		}
-		if( pxResult == NULL )
-		{
-			/* An exact match was not found, maybe a listening socket was
-			found. */
-			pxResult = pxListenSocket;
+			#endif /* ipconfigSOCKET_LOOKUP_TABLE_SIZE */
 		}
 
 		return pxResult;
@@ -2994,6 +4324,212 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+
+	static void prvTCPAutotuneApply( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream )
+	{
+	TCPWindow_t *pxWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	StreamBuffer_t *pxStream;
+	BaseType_t xIsEmpty;
+	size_t uxCurrent, uxTarget, uxBase, uxRoom;
+	int32_t lPromised;
+
+		/* The stream may only be replaced when the IP-task is not in the middle
+		of using it, which is guaranteed when it has a higher priority than the
+		caller. */
+		if( ( pxSocket->u.xTCP.ucAutotune != 0u ) &&
+			( xIsCallingFromIPTask() == pdFALSE ) &&
+			( uxTaskPriorityGet( NULL ) < ( UBaseType_t ) ipconfigIP_TASK_PRIORITY ) )
+		{
+			vTaskSuspendAll();
+			{
+				if( xIsInputStream != pdFALSE )
+				{
+					pxStream = pxSocket->u.xTCP.rxStream;
+					uxCurrent = pxSocket->u.xTCP.uxRxStreamSize;
+					uxTarget = pxSocket->u.xTCP.uxRxStreamTarget;
+					uxBase = pxSocket->u.xTCP.uxRxStreamBase;
+					xIsEmpty = ( ( pxStream == NULL ) ||
+						( ( uxStreamBufferGetSize( pxStream ) == 0u ) && ( pxStream->uxFront == pxStream->uxHead ) ) ) &&
+						( xTCPWindowRxEmpty( pxWindow ) != pdFALSE );
+				}
+				else
+				{
+					pxStream = pxSocket->u.xTCP.txStream;
+					uxCurrent = pxSocket->u.xTCP.uxTxStreamSize;
+					uxTarget = pxSocket->u.xTCP.uxTxStreamTarget;
+					uxBase = pxSocket->u.xTCP.uxTxStreamBase;
+					xIsEmpty = ( ( pxStream == NULL ) ||
+						( ( uxStreamBufferGetSize( pxStream ) == 0u ) && ( pxStream->uxMid == pxStream->uxHead ) ) ) &&
+						( xTCPWindowTxDone( pxWindow ) != pdFALSE );
+				}
+
+				if( ( xTaskGetTickCount() - pxSocket->u.xTCP.xAutoLastActive ) >= pdMS_TO_TICKS( ipconfigTCP_AUTOTUNE_IDLE_MS ) )
+				{
+					/* An idle socket goes back to its configured size. */
+					uxTarget = uxBase;
+				}
+
+				if( uxTarget > uxCurrent )
+				{
+					/* Take no more than what is left in the budget. */
+					uxRoom = ( uxAutotuneBytesInUse < ( size_t ) ipconfigTCP_AUTOTUNE_MEMORY_CAP ) ?
+						( ( size_t ) ipconfigTCP_AUTOTUNE_MEMORY_CAP - uxAutotuneBytesInUse ) : 0u;
+					if( ( uxTarget - uxCurrent ) > uxRoom )
+					{
+						uxTarget = uxCurrent + uxRoom;
+					}
+				}
+
+				if( xIsInputStream != pdFALSE )
+				{
+					/* Never offer less space than what has been advertised to
+					the peer already. */
+					lPromised = ( int32_t ) ( pxSocket->u.xTCP.ulHighestRxAllowed - pxWindow->rx.ulCurrentSequenceNumber );
+					if( ( lPromised > 0 ) && ( uxTarget < ( size_t ) lPromised ) )
+					{
+						uxTarget = ( size_t ) lPromised;
+					}
+				}
+				else
+				{
+					/* The transmission stream is a multiple of MSS. */
+					uxTarget -= uxTarget % ( size_t ) pxSocket->u.xTCP.usInitMSS;
+				}
+
+				if( ( xIsEmpty != pdFALSE ) && ( uxTarget != uxCurrent ) && ( uxTarget >= uxBase ) )
+				{
+					if( pxStream != NULL )
+					{
+						vPortFreeLarge( pxStream );
+					}
+
+					uxAutotuneBytesInUse = ( uxAutotuneBytesInUse + uxTarget ) - uxCurrent;
+
+					if( xIsInputStream != pdFALSE )
+					{
+						pxSocket->u.xTCP.rxStream = NULL;
+						pxSocket->u.xTCP.uxRxStreamSize = uxTarget;
+						pxSocket->u.xTCP.uxLittleSpace = ( sock20_PERCENT * uxTarget ) / sock100_PERCENT;
+						pxSocket->u.xTCP.uxEnoughSpace = ( sock80_PERCENT * uxTarget ) / sock100_PERCENT;
+						pxSocket->u.xTCP.uxRxWinSize = FreeRTOS_max_uint32( 1UL, ( uint32_t ) ( uxTarget / 2u ) / pxSocket->u.xTCP.usInitMSS );
+						pxWindow->xSize.ulRxWindowLength = pxSocket->u.xTCP.uxRxWinSize * pxSocket->u.xTCP.usInitMSS;
+					}
+					else
+					{
+						pxSocket->u.xTCP.txStream = NULL;
+						pxSocket->u.xTCP.uxTxStreamSize = uxTarget;
+						pxSocket->u.xTCP.uxTxWinSize = FreeRTOS_max_uint32( 1UL, ( uint32_t ) ( uxTarget / 2u ) / pxSocket->u.xTCP.usInitMSS );
+						pxWindow->xSize.ulTxWindowLength = pxSocket->u.xTCP.uxTxWinSize * pxSocket->u.xTCP.usInitMSS;
+					}
+
+					if( xTCPWindowLoggingLevel != 0 )
+					{
+						FreeRTOS_debug_printf( ( "prvTCPAutotuneApply: %cxStream %lu -> %lu bytes (in use %lu)\n",
+							xIsInputStream ? 'R' : 'T', uxCurrent, uxTarget, uxAutotuneBytesInUse ) );
+					}
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_AUTOTUNING */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+
+	static void prvTCPAutotuneStop( FreeRTOS_Socket_t *pxSocket )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( pxSocket->u.xTCP.ucAutotune != 0u )
+			{
+				uxAutotuneBytesInUse -= ( pxSocket->u.xTCP.uxRxStreamSize - pxSocket->u.xTCP.uxRxStreamBase ) +
+					( pxSocket->u.xTCP.uxTxStreamSize - pxSocket->u.xTCP.uxTxStreamBase );
+				pxSocket->u.xTCP.ucAutotune = pdFALSE;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* ipconfigUSE_TCP_AUTOTUNING */
+/*-----------------------------------------------------------*/
+
+#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_RELEASE_CLOSED_BUFFERS != 0 ) )
+
+	static void prvTCPReleaseClosedStream( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream )
+	{
+	StreamBuffer_t *pxStream = NULL;
+	BaseType_t xIsClosed;
+
+		/* As in prvTCPAutotuneApply(), the IP-task is not in the middle of using
+		the stream or the window when it has a higher priority than the caller.
+		Each direction is only released by the function that uses it, so that a
+		reading and a writing task can share the socket. */
+		if( ( xIsCallingFromIPTask() == pdFALSE ) &&
+			( uxTaskPriorityGet( NULL ) < ( UBaseType_t ) ipconfigIP_TASK_PRIORITY ) )
+		{
+			vTaskSuspendAll();
+			{
+				xIsClosed = ( ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCLOSED ) ||
+							  ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCLOSE_WAIT ) ||
+							  ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCLOSING ) ) &&
+							( socketTCP_FAST_OPEN_PENDING( pxSocket ) == pdFALSE );
+
+				if( xIsClosed == pdFALSE )
+				{
+					/* The socket got connected again. */
+				}
+				else if( xIsInputStream != pdFALSE )
+				{
+					/* Keep the stream as long as there is data to be read. */
+					if( ( pxSocket->u.xTCP.rxStream != NULL ) &&
+						( uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) == 0u ) &&
+						( pxSocket->u.xTCP.rxStream->uxFront == pxSocket->u.xTCP.rxStream->uxHead ) )
+					{
+						pxStream = pxSocket->u.xTCP.rxStream;
+						pxSocket->u.xTCP.rxStream = NULL;
+					}
+				}
+				else
+				{
+					pxStream = pxSocket->u.xTCP.txStream;
+					pxSocket->u.xTCP.txStream = NULL;
+				}
+
+				if( pxStream != NULL )
+				{
+					#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+					{
+						prvTCPAutotuneStop( pxSocket );
+					}
+					#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
+					vPortFreeLarge( pxStream );
+
+					#if( ipconfigUSE_TCP_WIN == 1 )
+					{
+						if( ( pxSocket->u.xTCP.rxStream == NULL ) && ( pxSocket->u.xTCP.txStream == NULL ) )
+						{
+							/* No data will be sent nor received: the segments
+							go back to the pool. */
+							vTCPWindowDestroy( &pxSocket->u.xTCP.xTCPWindow );
+						}
+					}
+					#endif /* ipconfigUSE_TCP_WIN */
+
+					FreeRTOS_debug_printf( ( "prvTCPReleaseClosedStream: port %u: %cxStream released\n",
+						pxSocket->usLocalPort, ( xIsInputStream != pdFALSE ) ? 'R' : 'T' ) );
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+	}
+
+#endif /* ipconfigTCP_RELEASE_CLOSED_BUFFERS */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -3377,6 +4913,65 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_CONNECTION_STATS != 0 ) )
+
+	BaseType_t FreeRTOS_TCPSnapshot( TCPSocketStats_t *pxStats, BaseType_t xMaxCount, TCPStackStats_t *pxTotals )
+	{
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd = ( const ListItem_t * ) listGET_END_MARKER( &xBoundTCPSocketsList );
+	BaseType_t xCount = 0;
+	TCPStackStats_t xTotals;
+
+		configASSERT( listLIST_IS_INITIALISED( &xBoundTCPSocketsList ) );
+
+		/* The IP-task suspends the scheduler while it adds or removes a TCP
+		socket, so the list can be read safely without sending a message. */
+		vTaskSuspendAll();
+		{
+			xTotals = xTCPClosedTotals;
+
+			for( pxIterator  = ( const ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+				 pxIterator != pxEnd;
+				 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+			const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+				xTotals.ulBytesReceived += pxSocket->u.xTCP.ulBytesReceived;
+				xTotals.ulBytesAcked += pxSocket->u.xTCP.ulBytesAcked;
+				xTotals.ulRetransmitCount += pxSocket->u.xTCP.xTCPWindow.ulRetransmitCount;
+
+				if( pxSocket->u.xTCP.ucTCPState == eESTABLISHED )
+				{
+					xTotals.ulEstablishedCount++;
+				}
+
+				if( ( pxStats != NULL ) && ( xCount < xMaxCount ) )
+				{
+					pxStats[ xCount ].ulRemoteIP = pxSocket->u.xTCP.ulRemoteIP;
+					pxStats[ xCount ].usLocalPort = pxSocket->usLocalPort;
+					pxStats[ xCount ].usRemotePort = pxSocket->u.xTCP.usRemotePort;
+					pxStats[ xCount ].ucTCPState = pxSocket->u.xTCP.ucTCPState;
+					pxStats[ xCount ].ulBytesReceived = pxSocket->u.xTCP.ulBytesReceived;
+					pxStats[ xCount ].ulBytesAcked = pxSocket->u.xTCP.ulBytesAcked;
+					pxStats[ xCount ].ulRetransmitCount = pxSocket->u.xTCP.xTCPWindow.ulRetransmitCount;
+				}
+
+				xCount++;
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		if( pxTotals != NULL )
+		{
+			*pxTotals = xTotals;
+		}
+
+		return xCount;
+	}
+
+#endif /* ipconfigUSE_TCP && ipconfigTCP_CONNECTION_STATS */
+/*-----------------------------------------------------------*/
+
 #if( ( ipconfigHAS_PRINTF != 0 ) && ( ipconfigUSE_TCP == 1 ) )
 
 	void vTCPNetStat( void )
@@ -3457,40 +5052,31 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 	void vSocketSelect( SocketSelect_t *pxSocketSet )
 	{
-	BaseType_t xRound;
 	EventBits_t xSocketBits, xBitsToClear;
-	#if ipconfigUSE_TCP == 1
-		BaseType_t xLastRound = 1;
-	#else
-		BaseType_t xLastRound = 0;
-	#endif
+	ListItem_t *pxIterator, *pxNext;
+	const MiniListItem_t *pxEnd;
 
 		/* These flags will be switched on after checking the socket status. */
 		EventBits_t xGroupBits = 0;
 		pxSocketSet->pxSocket = NULL;
 
-		for( xRound = 0; xRound <= xLastRound; xRound++ )
+		/* A member that is not on the ready list had no event since it was
+		last found not to be ready, so only the ready list is checked.  The
+		user may change the set from another task, so keep it from running
+		while the list is walked. */
+		vTaskSuspendAll();
 		{
-			const ListItem_t *pxIterator;
-			const MiniListItem_t *pxEnd;
-			if( xRound == 0 )
-			{
-				pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &xBoundUDPSocketsList );
-			}
-		#if ipconfigUSE_TCP == 1
-			else
-			{
-				pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &xBoundTCPSocketsList );
-			}
-		#endif /* ipconfigUSE_TCP == 1 */
-			for( pxIterator = ( const ListItem_t * ) ( listGET_NEXT( pxEnd ) );
+			pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &( pxSocketSet->xReadyList ) );
+			for( pxIterator = ( ListItem_t * ) ( listGET_NEXT( pxEnd ) );
 				 pxIterator != ( const ListItem_t * ) pxEnd;
-				 pxIterator = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+				 pxIterator = pxNext )
 			{
 				FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+				pxNext = ( ListItem_t * ) listGET_NEXT( pxIterator );
 				if( pxSocket->pxSocketSet != pxSocketSet )
 				{
 					/* Socket does not belong to this select group. */
+					( void ) uxListRemove( pxIterator );
 					continue;
 				}
 				xSocketBits = 0;
@@ -3591,8 +5177,14 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				group. */
 				xGroupBits |= xSocketBits;
 
+				if( xSocketBits == 0 )
+				{
+					/* Not ready, it will be put back by its next event. */
+					( void ) uxListRemove( pxIterator );
+				}
 			}	/* for( pxIterator ... ) */
-		}	/* for( xRound = 0; xRound <= xLastRound; xRound++ ) */
+		}
+		xTaskResumeAll();
 
 		xBitsToClear = xEventGroupGetBits( pxSocketSet->xSelectGroup );
 
@@ -3620,6 +5212,51 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+
+	void vSocketSelectReady( FreeRTOS_Socket_t *pxSocket )
+	{
+	SocketSelect_t *pxSocketSet;
+
+		vTaskSuspendAll();
+		{
+			pxSocketSet = pxSocket->pxSocketSet;
+
+			if( ( pxSocketSet != NULL ) &&
+				( listLIST_ITEM_CONTAINER( &( pxSocket->xSelectListItem ) ) != &( pxSocketSet->xReadyList ) ) )
+			{
+				/* The socket may have moved from another set. */
+				if( listLIST_ITEM_CONTAINER( &( pxSocket->xSelectListItem ) ) != NULL )
+				{
+					( void ) uxListRemove( &( pxSocket->xSelectListItem ) );
+				}
+
+				vListInsertEnd( &( pxSocketSet->xReadyList ), &( pxSocket->xSelectListItem ) );
+			}
+		}
+		xTaskResumeAll();
+	}
+
+#endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+
+	static void prvSelectReadyRemove( FreeRTOS_Socket_t *pxSocket )
+	{
+		vTaskSuspendAll();
+		{
+			if( listLIST_ITEM_CONTAINER( &( pxSocket->xSelectListItem ) ) != NULL )
+			{
+				( void ) uxListRemove( &( pxSocket->xSelectListItem ) );
+			}
+		}
+		xTaskResumeAll();
+	}
+
+#endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigSUPPORT_SIGNALS != 0 )
 
 	/* Send a signal to the task which reads from this socket. */
@@ -66,6 +66,9 @@ size_t uxSpace, uxNextHead, uxFirst;
 
 	if( uxCount != 0u )
 	{
+		/* Do not overwrite the space before the reader has released it. */
+		ipconfigSTREAM_BUFFER_BARRIER();
+
 		uxNextHead = pxBuffer->uxHead;
 
 		if( uxOffset != 0u )
@@ -106,6 +109,9 @@ size_t uxSpace, uxNextHead, uxFirst;
 			{
 				uxNextHead -= pxBuffer->LENGTH;
 			}
+
+			/* The data must be visible to the reader before uxHead is. */
+			ipconfigSTREAM_BUFFER_BARRIER();
 			pxBuffer->uxHead = uxNextHead;
 		}
 
@@ -148,6 +154,9 @@ size_t uxSize, uxCount, uxFirst, uxNextTail;
 
 	if( uxCount > 0u )
 	{
+		/* Do not read the data before uxHead has been read. */
+		ipconfigSTREAM_BUFFER_BARRIER();
+
 		uxNextTail = pxBuffer->uxTail;
 
 		if( uxOffset != 0u )
@@ -190,6 +199,9 @@ size_t uxSize, uxCount, uxFirst, uxNextTail;
 				uxNextTail -= pxBuffer->LENGTH;
 			}
 
+			/* The data must have been read before the writer may reuse the
+			space. */
+			ipconfigSTREAM_BUFFER_BARRIER();
 			pxBuffer->uxTail = uxNextTail;
 		}
 	}
@@ -94,12 +94,17 @@ the defined MTU size can contain at least a complete TCP packet. */
 #define TCP_OPT_SACK_P			4u   /* Advertize that SACK is permitted */
 #define TCP_OPT_SACK_A			5u   /* SACK option with first/last */
 #define TCP_OPT_TIMESTAMP		8u   /* Time-stamp option */
+#define TCP_OPT_FAST_OPEN		34u  /* TCP Fast Open cookie (RFC 7413) */
 
 #define TCP_OPT_MSS_LEN			4u   /* Length of TCP MSS option. */
 #define TCP_OPT_WSOPT_LEN		3u   /* Length of TCP WSOPT option. */
 
 #define TCP_OPT_TIMESTAMP_LEN	10	/* fixed length of the time-stamp option */
 
+#define TCP_FAST_OPEN_COOKIE_MIN	4u	/* A Fast Open cookie has 4 to 16 bytes */
+#define TCP_FAST_OPEN_COOKIE_MAX	16u
+#define TCP_FAST_OPEN_SYN_OPTIONS	32u	/* Room for the SYN options plus the largest Fast Open option */
+
 #ifndef ipconfigTCP_ACK_EARLIER_PACKET
 	#define ipconfigTCP_ACK_EARLIER_PACKET		1
 #endif
@@ -144,6 +149,23 @@ the defined MTU size can contain at least a complete TCP packet. */
 #define TCP_OFFSET_LENGTH_BITS			( 0xf0u )
 #define TCP_OFFSET_STANDARD_LENGTH		( 0x50u )
 
+/*
+ * A SYN cookie is built as: 5 bits of a counter that increments every 64
+ * seconds, 3 bits MSS index and a 24-bit keyed hash.  A cookie is accepted
+ * during at most 2 periods.
+ */
+#define tcpSYN_COOKIE_PERIOD_MS			( 64000UL )
+#define tcpSYN_COOKIE_MAX_AGE			( 1UL )
+#define tcpSYN_COOKIE_COUNTER_SHIFT		( 27 )
+#define tcpSYN_COOKIE_MSS_SHIFT			( 24 )
+#define tcpSYN_COOKIE_HASH_MASK			( 0x00ffffffUL )
+
+/*
+ * The sums stored in the transmission segments are only of use when the stack
+ * calculates the TX checksums itself.
+ */
+#define tcpUSE_SEGMENT_CHECKSUM			( ( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+
 /*
  * Each TCP socket is checked regularly to see if it can send data packets.
  * By default, the maximum number of packets sent during one check is limited to 8.
@@ -204,6 +226,15 @@ static int32_t prvTCPSendRepeated( FreeRTOS_Socket_t *pxSocket, NetworkBufferDes
 static void prvTCPReturnPacket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer,
 	uint32_t ulLen, BaseType_t xReleaseAfterSend );
 
+#if( tcpUSE_SEGMENT_CHECKSUM )
+	/*
+	 * Set the TCP checksum of a packet that carries the data of pxSegment.  Only
+	 * the pseudo header and the TCP header are summed, the sum of the data is
+	 * taken from the segment, or stored in it when it is sent for the first time.
+	 */
+	static void prvTCPSegmentChecksum( TCPPacket_t *pxTCPPacket, uint32_t ulLen, TCPSegment_t *pxSegment );
+#endif /* tcpUSE_SEGMENT_CHECKSUM */
+
 /*
  * Initialise the data structures which keep track of the TCP windowing system.
  */
@@ -234,6 +265,26 @@ static void prvCheckOptions( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescripto
  */
 static UBaseType_t prvSetSynAckOptions( FreeRTOS_Socket_t *pxSocket, TCPPacket_t * pxTCPPacket );
 
+#if( ipconfigTCP_FAST_OPEN != 0 )
+	/*
+	 * Send a SYN with the Fast Open option from a network buffer.  If a cookie
+	 * is known for the server, it is sent along with the data that is waiting
+	 * in the TX stream.  Returns 0 when no network buffer was available.
+	 */
+	static int32_t prvTCPSendFastOpenSyn( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Remember a Fast Open cookie received in a SYN+ACK.
+	 */
+	static void prvTCPFastOpenStoreCookie( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucCookie, UBaseType_t uxLength );
+
+	/*
+	 * When the SYN+ACK acknowledges data that was sent along with the SYN,
+	 * remove that data from the TX stream.
+	 */
+	static void prvTCPFastOpenAcked( FreeRTOS_Socket_t *pxSocket, uint32_t ulAckNumber );
+#endif /* ipconfigTCP_FAST_OPEN */
+
 /*
  * For anti-hang protection and TCP keep-alive messages.  Called in two places:
  * after receiving a packet and after a state change.  The socket's alive timer
@@ -296,10 +347,11 @@ static BaseType_t prvHandleEstablished( FreeRTOS_Socket_t *pxSocket, NetworkBuff
 /*
  * Called from prvTCPHandleState().  There is data to be sent.
  * If ipconfigUSE_TCP_WIN is defined, and if only an ACK must be sent, it will
- * be checked if it would better be postponed for efficiency.
+ * be checked if it would better be postponed for efficiency, unless xAckNow
+ * is true.
  */
 static BaseType_t prvSendData( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer,
-	uint32_t ulReceiveLength, BaseType_t xSendLength );
+	uint32_t ulReceiveLength, BaseType_t xSendLength, BaseType_t xAckNow );
 
 /*
  * The heart of all: check incoming packet for valid data and acks and do what
@@ -337,12 +389,33 @@ static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket );
  */
 static FreeRTOS_Socket_t *prvHandleListen( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
 
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+	/*
+	 * Reply to a SYN with a SYN+ACK that carries a cookie as its sequence
+	 * number, without creating a socket.
+	 */
+	static void prvTCPSendSynCookie( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Check if an ACK to a listening socket returns a valid cookie.  If so,
+	 * return a new child socket in the state eSYN_RECEIVED.
+	 */
+	static FreeRTOS_Socket_t *prvHandleSynCookieAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigTCP_SYN_COOKIES */
+
 /*
  * After a listening socket receives a new connection, it may duplicate itself.
  * The copying takes place in prvTCPSocketCopy.
  */
 static BaseType_t prvTCPSocketCopy( FreeRTOS_Socket_t *pxNewSocket, FreeRTOS_Socket_t *pxSocket );
 
+/*
+ * Append a new child socket to the accept queue of its listening socket.
+ */
+#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
+	static void prvTCPAcceptQueueAdd( FreeRTOS_Socket_t *pxParent, FreeRTOS_Socket_t *pxChild );
+#endif
+
 /*
  * prvTCPStatusAgeCheck() will see if the socket has been in a non-connected
  * state for too long.  If so, the socket will be closed, and -1 will be
@@ -363,6 +436,14 @@ static NetworkBufferDescriptor_t *prvTCPBufferResize( FreeRTOS_Socket_t *pxSocke
 	static uint8_t prvWinScaleFactor( FreeRTOS_Socket_t *pxSocket );
 #endif
 
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+	/*
+	 * Count the bytes received and acknowledged, and once per round-trip time
+	 * decide whether the streams of the socket should grow.
+	 */
+	static void prvTCPAutotuneSample( FreeRTOS_Socket_t *pxSocket, uint32_t ulRxCount, uint32_t ulTxCount );
+#endif
+
 /*
  * Generate a randomized TCP Initial Sequence Number per RFC.
  */
@@ -611,30 +692,43 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			now, proceed to send the packet with the SYN flag.
 			prvTCPPrepareConnect() prepares 'xPacket' and returns pdTRUE if
 			the Ethernet address of the peer or the gateway is found. */
-			pxTCPPacket = ( TCPPacket_t * )pxSocket->u.xTCP.xPacket.u.ucLastPacket;
+			#if( ipconfigTCP_FAST_OPEN != 0 )
+			{
+				if( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED )
+				{
+					/* The Fast Open option doesn't fit in 'xPacket'. */
+					lResult = prvTCPSendFastOpenSyn( pxSocket );
+				}
+			}
+			#endif /* ipconfigTCP_FAST_OPEN */
 
-			/* About to send a SYN packet.  Call prvSetSynAckOptions() to set
-			the proper options: The size of MSS and whether SACK's are
-			allowed. */
-			uxOptionsLength = prvSetSynAckOptions( pxSocket, pxTCPPacket );
+			if( lResult == 0 )
+			{
+				pxTCPPacket = ( TCPPacket_t * )pxSocket->u.xTCP.xPacket.u.ucLastPacket;
 
-			/* Return the number of bytes to be sent. */
-			lResult = ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
+				/* About to send a SYN packet.  Call prvSetSynAckOptions() to set
+				the proper options: The size of MSS and whether SACK's are
+				allowed. */
+				uxOptionsLength = prvSetSynAckOptions( pxSocket, pxTCPPacket );
 
-			/* Set the TCP offset field:  ipSIZE_OF_TCP_HEADER equals 20 and
-			uxOptionsLength is always a multiple of 4.  The complete expression
-			would be:
-			ucTCPOffset = ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) / 4 ) << 4 */
-			pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+				/* Return the number of bytes to be sent. */
+				lResult = ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
 
-			/* Repeat Count is used for a connecting socket, to limit the number
-			of tries. */
-			pxSocket->u.xTCP.ucRepCount++;
+				/* Set the TCP offset field:  ipSIZE_OF_TCP_HEADER equals 20 and
+				uxOptionsLength is always a multiple of 4.  The complete expression
+				would be:
+				ucTCPOffset = ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) / 4 ) << 4 */
+				pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
 
-			/* Send the SYN message to make a connection.  The messages is
-			stored in the socket field 'xPacket'.  It will be wrapped in a
-			pseudo network buffer descriptor before it will be sent. */
-			prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) lResult, pdFALSE );
+				/* Repeat Count is used for a connecting socket, to limit the number
+				of tries. */
+				pxSocket->u.xTCP.ucRepCount++;
+
+				/* Send the SYN message to make a connection.  The messages is
+				stored in the socket field 'xPacket'.  It will be wrapped in a
+				pseudo network buffer descriptor before it will be sent. */
+				prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) lResult, pdFALSE );
+			}
 		}
 	}
 
@@ -695,6 +789,9 @@ EthernetHeader_t *pxEthernetHeader;
 uint32_t ulFrontSpace, ulSpace, ulSourceAddress, ulWinSize;
 TCPWindow_t *pxTCPWindow;
 NetworkBufferDescriptor_t xTempBuffer;
+#if( tcpUSE_SEGMENT_CHECKSUM )
+	TCPSegment_t *pxChecksumSegment = NULL;
+#endif
 /* For sending, a pseudo network buffer will be used, as explained above. */
 
 	if( pxNetworkBuffer == NULL )
@@ -859,6 +956,33 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 			/* Tell which sequence number is expected next time */
 			pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( pxTCPWindow->rx.ulCurrentSequenceNumber );
+
+			#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+			{
+				/* All data received so far gets acknowledged now. */
+				pxSocket->u.xTCP.ucAckPending = 0u;
+			}
+			#endif /* ipconfigUSE_TCP_ACK_POLICY */
+
+			#if( tcpUSE_SEGMENT_CHECKSUM )
+			{
+				/* Only the packet that prvTCPPrepareSend() has just filled with
+				the data of a segment may use the sum stored in that segment.
+				A keep-alive message has a different sequence number. */
+				if( pxSocket->u.xTCP.pucChecksumPacket == pxNetworkBuffer->pucEthernetBuffer )
+				{
+				TCPSegment_t *pxSegment = pxTCPWindow->pxLastTxSegment;
+				uint32_t ulHeaderLength = ipSIZE_OF_IPv4_HEADER + ( ( uint32_t ) ( pxTCPPacket->xTCPHeader.ucTCPOffset & VALID_BITS_IN_TCP_OFFSET_BYTE ) >> 2 );
+
+					if( ( FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) == pxSegment->ulSequenceNumber ) &&
+						( ulLen == ulHeaderLength + ( uint32_t ) pxSegment->lDataLength ) )
+					{
+						pxChecksumSegment = pxSegment;
+					}
+				}
+				pxSocket->u.xTCP.pucChecksumPacket = NULL;
+			}
+			#endif /* tcpUSE_SEGMENT_CHECKSUM */
 		}
 		else
 		{
@@ -892,19 +1016,34 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 		#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 		{
-			/* calculate the IP header checksum, in case the driver won't do that. */
-			pxIPHeader->usHeaderChecksum = 0x00u;
-			pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
-			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
-
-			/* calculate the TCP checksum for an outgoing packet. */
-			usGenerateProtocolChecksum( (uint8_t*)pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
-
-			/* A calculated checksum of 0 must be inverted as 0 means the checksum
-			is disabled. */
-			if( pxTCPPacket->xTCPHeader.usChecksum == 0x00u )
+		#if( ipconfigUSE_LOOPBACK != 0 )
+			/* The checksums of a looped-back packet are not verified. */
+			if( pxIPHeader->ulDestinationIPAddress != *ipLOCAL_IP_ADDRESS_POINTER )
+		#endif /* ipconfigUSE_LOOPBACK */
 			{
-				pxTCPPacket->xTCPHeader.usChecksum = 0xffffU;
+				/* calculate the IP header checksum, in case the driver won't do that. */
+				pxIPHeader->usHeaderChecksum = 0x00u;
+				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+				/* calculate the TCP checksum for an outgoing packet. */
+				#if( tcpUSE_SEGMENT_CHECKSUM )
+				if( pxChecksumSegment != NULL )
+				{
+					prvTCPSegmentChecksum( pxTCPPacket, ulLen, pxChecksumSegment );
+				}
+				else
+				#endif /* tcpUSE_SEGMENT_CHECKSUM */
+				{
+					usGenerateProtocolChecksum( (uint8_t*)pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+				}
+
+				/* A calculated checksum of 0 must be inverted as 0 means the checksum
+				is disabled. */
+				if( pxTCPPacket->xTCPHeader.usChecksum == 0x00u )
+				{
+					pxTCPPacket->xTCPHeader.usChecksum = 0xffffU;
+				}
 			}
 		}
 		#endif
@@ -913,6 +1052,23 @@ NetworkBufferDescriptor_t xTempBuffer;
 		pxNetworkBuffer->pxNextBuffer = NULL;
 	#endif
 
+		#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+		{
+		uint32_t ulHeaderLength = ipSIZE_OF_IPv4_HEADER + ( ( uint32_t ) ( pxTCPPacket->xTCPHeader.ucTCPOffset & 0xf0u ) >> 2 );
+
+			/* A packet carrying more than one MSS of data is a super-segment,
+			which the driver will cut in pieces of MSS bytes. */
+			if( ( pxSocket != NULL ) && ( ulLen > ulHeaderLength + ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) )
+			{
+				pxNetworkBuffer->usLargeSendMSS = pxSocket->u.xTCP.usCurMSS;
+			}
+			else
+			{
+				pxNetworkBuffer->usLargeSendMSS = 0u;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
 		/* Important: tell NIC driver how many bytes must be sent. */
 		pxNetworkBuffer->xDataLength = ulLen + ipSIZE_OF_ETH_HEADER;
 
@@ -938,8 +1094,16 @@ NetworkBufferDescriptor_t xTempBuffer;
 		}
 		#endif
 
+		#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+		{
+			/* A reset that is not sent on behalf of a socket is control
+			traffic. */
+			pxNetworkBuffer->ucTxClass = ( pxSocket != NULL ) ? pxSocket->ucTxClass : 0u;
+		}
+		#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 		/* Send! */
-		xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
 
 		if( xReleaseAfterSend == pdFALSE )
 		{
@@ -957,6 +1121,41 @@ NetworkBufferDescriptor_t xTempBuffer;
 }
 /*-----------------------------------------------------------*/
 
+#if( tcpUSE_SEGMENT_CHECKSUM )
+
+	static void prvTCPSegmentChecksum( TCPPacket_t *pxTCPPacket, uint32_t ulLen, TCPSegment_t *pxSegment )
+	{
+	size_t uxHeaderLength = ( size_t ) ( ( pxTCPPacket->xTCPHeader.ucTCPOffset & VALID_BITS_IN_TCP_OFFSET_BYTE ) >> 2 );
+	uint32_t ulSum;
+	uint16_t usChecksum;
+
+		if( pxSegment->u.bits.bChecksumKnown == pdFALSE_UNSIGNED )
+		{
+			/* The data starts at an even offset from the pseudo header, so its
+			sum can be added to the sum of the headers as it is.  The data of a
+			segment does not change once it has been sent. */
+			pxSegment->usDataChecksum = usGenerateChecksum( 0UL,
+				( ( uint8_t * ) &( pxTCPPacket->xTCPHeader ) ) + uxHeaderLength, ( size_t ) pxSegment->lDataLength );
+			pxSegment->u.bits.bChecksumKnown = pdTRUE_UNSIGNED;
+		}
+
+		/* The pseudo header: IP protocol and TCP length, plus the data, folded
+		to 16 bits as usGenerateChecksum() takes a 16-bit start value. */
+		ulSum = ( ulLen - ipSIZE_OF_IPv4_HEADER ) + ( uint32_t ) ipPROTOCOL_TCP + ( uint32_t ) pxSegment->usDataChecksum;
+		ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+		ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+
+		/* Continue at the IPv4 source and destination addresses and the TCP
+		header, up to the data. */
+		pxTCPPacket->xTCPHeader.usChecksum = 0u;
+		usChecksum = ( uint16_t ) ~usGenerateChecksum( ulSum, ( uint8_t * ) &( pxTCPPacket->xIPHeader.ulSourceIPAddress ),
+			2u * sizeof( pxTCPPacket->xIPHeader.ulSourceIPAddress ) + uxHeaderLength );
+		pxTCPPacket->xTCPHeader.usChecksum = FreeRTOS_htons( usChecksum );
+	}
+
+#endif /* tcpUSE_SEGMENT_CHECKSUM */
+/*-----------------------------------------------------------*/
+
 /*
  * The SYN event is very important: the sequence numbers, which have a kind of
  * random starting value, are being synchronised.  The sliding window manager
@@ -971,6 +1170,15 @@ static void prvTCPCreateWindow( FreeRTOS_Socket_t *pxSocket )
 			pxSocket->u.xTCP.uxLittleSpace ,
 			pxSocket->u.xTCP.uxEnoughSpace,
 			pxSocket->u.xTCP.uxRxStreamSize ) );
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		/* vTCPWindowCreate() will initialise the congestion control, NULL
+		selects the default algorithm. */
+		pxSocket->u.xTCP.xTCPWindow.pxCongestionOps = pxSocket->u.xTCP.pxCongestionOps;
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 	vTCPWindowCreate(
 		&pxSocket->u.xTCP.xTCPWindow,
 		ipconfigTCP_MSS * pxSocket->u.xTCP.uxRxWinSize,
@@ -1106,6 +1314,12 @@ uint32_t ulInitialSequenceNumber = 0;
 		/* Set the values of usInitMSS / usCurMSS for this socket. */
 		prvSocketSetMSS( pxSocket );
 
+		#if( ipconfigTCP_FAST_OPEN != 0 )
+		{
+			pxSocket->u.xTCP.usFastOpenLength = 0u;
+		}
+		#endif /* ipconfigTCP_FAST_OPEN */
+
 		/* The initial sequence numbers at our side are known.  Later
 		vTCPWindowInit() will be called to fill in the peer's sequence numbers, but
 		first wait for a SYN+ACK reply. */
@@ -1247,11 +1461,12 @@ UBaseType_t uxNewMSS;
 				pxSocket->u.xTCP.usCurMSS = ( uint16_t ) uxNewMSS;
 			}
 
-			#if( ipconfigUSE_TCP_WIN != 1 )
+			#if( ( ipconfigUSE_TCP_WIN != 1 ) && ( ipconfigTCP_FAST_OPEN == 0 ) )
 				/* Without scaled windows, MSS is the only interesting option. */
 				break;
 			#else
-				/* Or else we continue to check another option: selective ACK. */
+				/* Or else we continue to check another option: selective ACK
+				or a Fast Open cookie. */
 				pucPtr += TCP_OPT_MSS_LEN;
 			#endif	/* ipconfigUSE_TCP_WIN != 1 */
 		}
@@ -1267,6 +1482,15 @@ UBaseType_t uxNewMSS;
 				break;
 			}
 
+			#if( ipconfigTCP_FAST_OPEN != 0 )
+			{
+				if( pucPtr[ 0 ] == TCP_OPT_FAST_OPEN )
+				{
+					prvTCPFastOpenStoreCookie( pxSocket, pucPtr + 2, ( UBaseType_t ) len - 2u );
+				}
+			}
+			#endif /* ipconfigTCP_FAST_OPEN */
+
 			#if( ipconfigUSE_TCP_WIN == 1 )
 			{
 				/* Selective ACK: the peer has received a packet but it is missing earlier
@@ -1282,6 +1506,11 @@ UBaseType_t uxNewMSS;
 					uint32_t ulFirst = ulChar2u32( pucPtr );
 					uint32_t ulLast  = ulChar2u32( pucPtr + 4 );
 					uint32_t ulCount = ulTCPWindowTxSack( &pxSocket->u.xTCP.xTCPWindow, ulFirst, ulLast );
+						#if( ipconfigTCP_CONNECTION_STATS != 0 )
+						{
+							pxSocket->u.xTCP.ulBytesAcked += ulCount;
+						}
+						#endif /* ipconfigTCP_CONNECTION_STATS */
 						/* ulTCPWindowTxSack( ) returns the number of bytes which have been acked
 						starting from the head position.
 						Advance the tail pointer in txStream. */
@@ -1336,6 +1565,16 @@ UBaseType_t uxNewMSS;
 
 		/* 'xTCP.uxRxWinSize' is the size of the reception window in units of MSS. */
 		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) pxSocket->u.xTCP.usInitMSS;
+		#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+		{
+			/* The reception window may grow after the connection has been
+			established, but the scale factor can only be sent now. */
+			if( ( pxSocket->u.xTCP.ucAutotune != 0u ) && ( uxWinSize < ( size_t ) ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH ) )
+			{
+				uxWinSize = ( size_t ) ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_AUTOTUNING */
 		ucFactor = 0u;
 		while( uxWinSize > 0xfffful )
 		{
@@ -1355,6 +1594,66 @@ UBaseType_t uxNewMSS;
 #endif
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+
+	static void prvTCPAutotuneSample( FreeRTOS_Socket_t *pxSocket, uint32_t ulRxCount, uint32_t ulTxCount )
+	{
+	TCPWindow_t *pxWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xInterval;
+	size_t uxMaxLength;
+
+		if( pxSocket->u.xTCP.ucAutotune != 0u )
+		{
+			pxSocket->u.xTCP.ulAutoRxBytes += ulRxCount;
+			pxSocket->u.xTCP.ulAutoTxBytes += ulTxCount;
+
+			if( ( ulRxCount != 0u ) || ( ulTxCount != 0u ) )
+			{
+				pxSocket->u.xTCP.xAutoLastActive = xNow;
+			}
+
+			/* Measure during at least 10 ms, RTT's on a LAN are too short to be
+			representative. */
+			xInterval = pdMS_TO_TICKS( ( uint32_t ) FreeRTOS_max_int32( pxWindow->lSRTT, 10 ) );
+			if( xInterval == 0u )
+			{
+				xInterval = 1u;
+			}
+
+			if( ( xNow - pxSocket->u.xTCP.xAutoIntervalStart ) >= xInterval )
+			{
+				/* When 3/4 of a window has been delivered within one RTT, the
+				window is what limits the throughput: ask for a stream that is
+				twice as big.  The actual window is half the size of the
+				stream. */
+				if( ( pxSocket->u.xTCP.ulAutoRxBytes != 0u ) &&
+					( pxSocket->u.xTCP.ulAutoRxBytes >= ( ( pxWindow->xSize.ulRxWindowLength / 4u ) * 3u ) ) )
+				{
+					uxMaxLength = FreeRTOS_max_uint32( ( uint32_t ) ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH, ( uint32_t ) pxSocket->u.xTCP.uxRxStreamBase );
+					pxSocket->u.xTCP.uxRxStreamTarget = FreeRTOS_min_uint32( ( uint32_t ) ( 2u * pxSocket->u.xTCP.uxRxStreamSize ), ( uint32_t ) uxMaxLength );
+				}
+
+				/* For transmission, the peer's window must be larger than our
+				own window, otherwise a bigger stream won't help. */
+				if( ( pxSocket->u.xTCP.ulAutoTxBytes != 0u ) &&
+					( pxSocket->u.xTCP.ulAutoTxBytes >= ( ( pxWindow->xSize.ulTxWindowLength / 4u ) * 3u ) ) &&
+					( pxSocket->u.xTCP.ulWindowSize > pxWindow->xSize.ulTxWindowLength ) )
+				{
+					uxMaxLength = FreeRTOS_max_uint32( ( uint32_t ) ipconfigTCP_AUTOTUNE_MAX_BUFFER_LENGTH, ( uint32_t ) pxSocket->u.xTCP.uxTxStreamBase );
+					pxSocket->u.xTCP.uxTxStreamTarget = FreeRTOS_min_uint32( ( uint32_t ) ( 2u * pxSocket->u.xTCP.uxTxStreamSize ), ( uint32_t ) uxMaxLength );
+				}
+
+				pxSocket->u.xTCP.ulAutoRxBytes = 0u;
+				pxSocket->u.xTCP.ulAutoTxBytes = 0u;
+				pxSocket->u.xTCP.xAutoIntervalStart = xNow;
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_AUTOTUNING */
+/*-----------------------------------------------------------*/
+
 /*
  * When opening a TCP connection, while SYN's are being sent, the  parties may
  * communicate what MSS (Maximum Segment Size) they intend to use.   MSS is the
@@ -1406,6 +1705,186 @@ UBaseType_t uxOptionsLength;
 	#endif	/* ipconfigUSE_TCP_WIN == 0 */
 }
 
+#if( ipconfigTCP_FAST_OPEN != 0 )
+
+	typedef struct xTCP_FAST_OPEN_COOKIE
+	{
+		uint32_t ulIPAddress;	/* The server, in host-endian notation */
+		uint8_t ucLength;		/* 0 for an unused entry */
+		uint8_t ucCookie[ TCP_FAST_OPEN_COOKIE_MAX ];
+	} TCPFastOpenCookie_t;
+
+	/* The cookie cache is only accessed by the IP-task. */
+	static TCPFastOpenCookie_t xFastOpenCookies[ ipconfigTCP_FAST_OPEN_CACHE_SIZE ];
+	static BaseType_t xFastOpenNextEntry = 0;
+
+	static TCPFastOpenCookie_t *prvTCPFastOpenLookup( uint32_t ulIPAddress )
+	{
+	TCPFastOpenCookie_t *pxReturn = NULL;
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigTCP_FAST_OPEN_CACHE_SIZE; xIndex++ )
+		{
+			if( ( xFastOpenCookies[ xIndex ].ucLength != 0u ) && ( xFastOpenCookies[ xIndex ].ulIPAddress == ulIPAddress ) )
+			{
+				pxReturn = &( xFastOpenCookies[ xIndex ] );
+				break;
+			}
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPFastOpenStoreCookie( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucCookie, UBaseType_t uxLength )
+	{
+	TCPFastOpenCookie_t *pxEntry;
+
+		/* A cookie is only expected in a SYN+ACK, in reply to a Fast Open
+		SYN. */
+		if( ( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN ) &&
+			( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED ) &&
+			( uxLength >= TCP_FAST_OPEN_COOKIE_MIN ) &&
+			( uxLength <= TCP_FAST_OPEN_COOKIE_MAX ) )
+		{
+			pxEntry = prvTCPFastOpenLookup( pxSocket->u.xTCP.ulRemoteIP );
+			if( pxEntry == NULL )
+			{
+				/* Replace the oldest entry. */
+				pxEntry = &( xFastOpenCookies[ xFastOpenNextEntry ] );
+				xFastOpenNextEntry = ( xFastOpenNextEntry + 1 ) % ( BaseType_t ) ipconfigTCP_FAST_OPEN_CACHE_SIZE;
+				pxEntry->ulIPAddress = pxSocket->u.xTCP.ulRemoteIP;
+			}
+
+			memcpy( pxEntry->ucCookie, pucCookie, ( size_t ) uxLength );
+			pxEntry->ucLength = ( uint8_t ) uxLength;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static int32_t prvTCPSendFastOpenSyn( FreeRTOS_Socket_t *pxSocket )
+	{
+	const TCPFastOpenCookie_t *pxCookie = prvTCPFastOpenLookup( pxSocket->u.xTCP.ulRemoteIP );
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	TCPPacket_t *pxTCPPacket;
+	uint8_t *pucOptions;
+	UBaseType_t uxOptionsLength;
+	UBaseType_t uxCookieLength = 0u;
+	size_t uxDataLength = 0u;
+	int32_t lResult = 0;
+
+		if( pxCookie != NULL )
+		{
+			uxCookieLength = ( UBaseType_t ) pxCookie->ucLength;
+
+			/* Only the first SYN carries data: a repeated SYN might have been
+			dropped because of it. */
+			if( ( pxSocket->u.xTCP.ucRepCount == 0u ) &&
+				( pxSocket->u.xTCP.txStream != NULL ) &&
+				( pxSocket->u.xTCP.usInitMSS > TCP_FAST_OPEN_SYN_OPTIONS ) )
+			{
+				uxDataLength = ( size_t ) FreeRTOS_min_uint32( ( uint32_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.txStream ),
+					( uint32_t ) pxSocket->u.xTCP.usInitMSS - TCP_FAST_OPEN_SYN_OPTIONS );
+			}
+		}
+
+		pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + TCP_FAST_OPEN_SYN_OPTIONS + uxDataLength, 0u );
+
+		if( pxNetworkBuffer != NULL )
+		{
+			/* Start with the headers that were prepared in 'xPacket'. */
+			memcpy( pxNetworkBuffer->pucEthernetBuffer, pxSocket->u.xTCP.xPacket.u.ucLastPacket, ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER );
+			pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+			pucOptions = pxNetworkBuffer->pucEthernetBuffer + ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+
+			uxOptionsLength = prvSetSynAckOptions( pxSocket, pxTCPPacket );
+
+			/* Add the Fast Open option: either a cookie, or an empty option to
+			request one.  Insert NOP's to keep the length a multiple of 4. */
+			while( ( ( uxOptionsLength + 2u + uxCookieLength ) & 3u ) != 0u )
+			{
+				pucOptions[ uxOptionsLength++ ] = TCP_OPT_NOOP;
+			}
+			pucOptions[ uxOptionsLength ] = ( uint8_t ) TCP_OPT_FAST_OPEN;
+			pucOptions[ uxOptionsLength + 1u ] = ( uint8_t ) ( 2u + uxCookieLength );
+			if( pxCookie != NULL )
+			{
+				memcpy( pucOptions + uxOptionsLength + 2u, pxCookie->ucCookie, ( size_t ) uxCookieLength );
+			}
+			uxOptionsLength += 2u + uxCookieLength;
+
+			if( uxDataLength != 0u )
+			{
+				/* Peek: the data stays in the stream until the SYN+ACK
+				acknowledges it. */
+				( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, pucOptions + uxOptionsLength, uxDataLength, pdTRUE );
+				pxSocket->u.xTCP.usFastOpenLength = ( uint16_t ) uxDataLength;
+			}
+
+			pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+
+			lResult = ( int32_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength + uxDataLength );
+			pxNetworkBuffer->xDataLength = ipSIZE_OF_ETH_HEADER + ( size_t ) lResult;
+
+			/* Repeat Count is used for a connecting socket, to limit the number
+			of tries. */
+			pxSocket->u.xTCP.ucRepCount++;
+
+			prvTCPReturnPacket( pxSocket, pxNetworkBuffer, ( uint32_t ) lResult, pdTRUE );
+		}
+
+		return lResult;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPFastOpenAcked( FreeRTOS_Socket_t *pxSocket, uint32_t ulAckNumber )
+	{
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	uint32_t ulCount = ulAckNumber - ( pxTCPWindow->tx.ulFirstSequenceNumber + 1UL );
+
+		if( ( ulCount != 0UL ) &&
+			( ulCount <= ( uint32_t ) pxSocket->u.xTCP.usFastOpenLength ) &&
+			( pxSocket->u.xTCP.txStream != NULL ) )
+		{
+			/* The server has accepted the data in the SYN.  It was never
+			passed to the sliding window, so skip it in the stream and in the
+			sequence numbers. */
+			vStreamBufferMoveMid( pxSocket->u.xTCP.txStream, ( size_t ) ulCount );
+			( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, NULL, ( size_t ) ulCount, pdFALSE );
+
+			pxTCPWindow->tx.ulCurrentSequenceNumber += ulCount;
+			pxTCPWindow->ulNextTxSequenceNumber += ulCount;
+			pxTCPWindow->ulOurSequenceNumber += ulCount;
+
+			#if( ipconfigTCP_CONNECTION_STATS != 0 )
+			{
+				pxSocket->u.xTCP.ulBytesAcked += ulCount;
+			}
+			#endif /* ipconfigTCP_CONNECTION_STATS */
+
+			pxSocket->xEventBits |= eSOCKET_SEND;
+
+			#if ipconfigSUPPORT_SELECT_FUNCTION == 1
+			{
+				if( pxSocket->xSelectBits & eSELECT_WRITE )
+				{
+					pxSocket->xEventBits |= ( eSELECT_WRITE << SOCKET_EVENT_BIT_COUNT );
+				}
+			}
+			#endif
+		}
+
+		FreeRTOS_debug_printf( ( "TCP: Fast Open %lxip:%u: %lu of %u SYN bytes acknowledged\n",
+			pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort,
+			( ulCount <= ( uint32_t ) pxSocket->u.xTCP.usFastOpenLength ) ? ulCount : 0UL,
+			pxSocket->u.xTCP.usFastOpenLength ) );
+
+		pxSocket->u.xTCP.usFastOpenLength = 0u;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigTCP_FAST_OPEN */
+
 /*
  * For anti-hanging protection and TCP keep-alive messages.  Called in two
  * places: after receiving a packet and after a state change.  The socket's
@@ -1471,6 +1950,13 @@ BaseType_t bAfter  = ( BaseType_t ) NOW_CONNECTED( eTCPState );						/* Is it co
 				}
 				if( xParent != NULL )
 				{
+				#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
+					if( xParent != pxSocket )
+					{
+						prvTCPAcceptQueueAdd( xParent, pxSocket );
+					}
+					else
+				#endif /* ipconfigTCP_ACCEPT_QUEUE */
 					if( xParent->u.xTCP.pxPeerSocket == NULL )
 					{
 						xParent->u.xTCP.pxPeerSocket = pxSocket;
@@ -1555,7 +2041,7 @@ BaseType_t bAfter  = ( BaseType_t ) NOW_CONNECTED( eTCPState );						/* Is it co
 			won't need further attention of the IP-task.
 			Setting time-out to zero means that the socket won't get checked during
 			timer events. */
-			pxSocket->u.xTCP.usTimeout = 0u;
+			vTCPSocketTimerSet( pxSocket, 0u );
 		}
 	}
 	else
@@ -1710,6 +2196,12 @@ int32_t lStreamPos;
 	lStreamPos = 0;
 	pxTCPPacket->xTCPHeader.ucTCPFlags |= ipTCP_FLAG_ACK;
 
+	#if( tcpUSE_SEGMENT_CHECKSUM )
+	{
+		pxSocket->u.xTCP.pucChecksumPacket = NULL;
+	}
+	#endif /* tcpUSE_SEGMENT_CHECKSUM */
+
 	if( pxSocket->u.xTCP.txStream != NULL )
 	{
 		/* ulTCPWindowTxGet will return the amount of data which may be sent
@@ -1718,7 +2210,26 @@ int32_t lStreamPos;
 		Because some TCP-stacks (like uIP) use it for flow-control. */
 		if( pxSocket->u.xTCP.usCurMSS > 1u )
 		{
-			lDataLen = ( int32_t ) ulTCPWindowTxGet( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos );
+			#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+			{
+			uint32_t ulMaxLength = ( uint32_t ) pxSocket->u.xTCP.usCurMSS;
+
+				/* Fixed-size network buffers can not hold more than one
+				segment. */
+				if( xBufferAllocFixedSize == pdFALSE )
+				{
+					ulMaxLength *= ( uint32_t ) ipconfigTCP_LARGE_SEND_MAX_SEGMENTS;
+					ulMaxLength = FreeRTOS_min_uint32( ulMaxLength,
+						( uint32_t ) ( 0xffffUL - ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ) ) );
+				}
+
+				lDataLen = ( int32_t ) ulTCPWindowTxGetLarge( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos, ulMaxLength );
+			}
+			#else
+			{
+				lDataLen = ( int32_t ) ulTCPWindowTxGet( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos );
+			}
+			#endif /* ipconfigUSE_TCP_LARGE_SEND */
 		}
 
 		if( lDataLen > 0 )
@@ -1753,6 +2264,20 @@ int32_t lStreamPos;
 				}
 				#endif
 
+				#if( tcpUSE_SEGMENT_CHECKSUM )
+				{
+					/* The packet carries exactly the data of one segment, the
+					checksum may use the sum stored in that segment. */
+					if( ( ulDataGot == ( uint32_t ) lDataLen ) &&
+						( pxTCPWindow->pxLastTxSegment != NULL ) &&
+						( pxTCPWindow->pxLastTxSegment->ulSequenceNumber == pxTCPWindow->ulOurSequenceNumber ) &&
+						( pxTCPWindow->pxLastTxSegment->lDataLength == lDataLen ) )
+					{
+						pxSocket->u.xTCP.pucChecksumPacket = pucEthernetBuffer;
+					}
+				}
+				#endif /* tcpUSE_SEGMENT_CHECKSUM */
+
 				/* If the owner of the socket requests a closure, add the FIN
 				flag to the last packet. */
 				if( ( pxSocket->u.xTCP.bits.bCloseRequested != pdFALSE_UNSIGNED ) && ( pxSocket->u.xTCP.bits.bFinSent == pdFALSE_UNSIGNED ) )
@@ -1833,7 +2358,7 @@ int32_t lStreamPos;
 							pxSocket->u.xTCP.usRemotePort,
 							pxSocket->u.xTCP.ucKeepRepCount ) );
 					pxSocket->u.xTCP.bits.bSendKeepAlive = pdTRUE_UNSIGNED;
-					pxSocket->u.xTCP.usTimeout = ( ( uint16_t ) pdMS_TO_TICKS( 2500 ) );
+					vTCPSocketTimerSet( pxSocket, ( uint16_t ) pdMS_TO_TICKS( 2500 ) );
 					pxSocket->u.xTCP.ucKeepRepCount++;
 				}
 			}
@@ -1896,7 +2421,7 @@ TickType_t ulDelayMs = ( TickType_t ) tcpMAXIMUM_TCP_WAKEUP_TIME_MS;
 		FreeRTOS_debug_printf( ( "Connect[%lxip:%u]: next timeout %u: %lu ms\n",
 			pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort,
 			pxSocket->u.xTCP.ucRepCount, ulDelayMs ) );
-		pxSocket->u.xTCP.usTimeout = ( uint16_t )pdMS_TO_MIN_TICKS( ulDelayMs );
+		vTCPSocketTimerSet( pxSocket, ( uint16_t )pdMS_TO_MIN_TICKS( ulDelayMs ) );
 	}
 	else if( pxSocket->u.xTCP.usTimeout == 0u )
 	{
@@ -1917,7 +2442,7 @@ TickType_t ulDelayMs = ( TickType_t ) tcpMAXIMUM_TCP_WAKEUP_TIME_MS;
 		{
 			/* ulDelayMs contains the time to wait before a re-transmission. */
 		}
-		pxSocket->u.xTCP.usTimeout = ( uint16_t )pdMS_TO_MIN_TICKS( ulDelayMs );
+		vTCPSocketTimerSet( pxSocket, ( uint16_t )pdMS_TO_MIN_TICKS( ulDelayMs ) );
 	}
 	else
 	{
@@ -2181,6 +2706,20 @@ BaseType_t xResult = 0;
 				prvTCPSendReset( pxNetworkBuffer );
 				xResult = -1;
 			}
+			else
+			{
+				#if( ipconfigTCP_CONNECTION_STATS != 0 )
+				{
+					pxSocket->u.xTCP.ulBytesReceived += ulReceiveLength;
+				}
+				#endif /* ipconfigTCP_CONNECTION_STATS */
+
+				#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+				{
+					prvTCPAutotuneSample( pxSocket, ulReceiveLength, 0u );
+				}
+				#endif /* ipconfigUSE_TCP_AUTOTUNING */
+			}
 		}
 
 		/* After a missing packet has come in, higher packets may be passed to
@@ -2320,6 +2859,15 @@ BaseType_t xSendLength = 0;
 		1. */
 		pxTCPWindow->ulOurSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1u;
 
+		#if( ipconfigTCP_FAST_OPEN != 0 )
+		{
+			if( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN )
+			{
+				prvTCPFastOpenAcked( pxSocket, FreeRTOS_ntohl( pxTCPHeader->ulAckNr ) );
+			}
+		}
+		#endif /* ipconfigTCP_FAST_OPEN */
+
 		#if( ipconfigUSE_TCP_WIN == 1 )
 		{
 			FreeRTOS_debug_printf( ( "TCP: %s %d => %lxip:%d set ESTAB (scaling %u)\n",
@@ -2389,6 +2937,18 @@ int32_t lDistance, lSendResult;
 	{
 		ulCount = ulTCPWindowTxAck( pxTCPWindow, FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr ) );
 
+		#if( ipconfigTCP_CONNECTION_STATS != 0 )
+		{
+			pxSocket->u.xTCP.ulBytesAcked += ulCount;
+		}
+		#endif /* ipconfigTCP_CONNECTION_STATS */
+
+		#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+		{
+			prvTCPAutotuneSample( pxSocket, 0u, ulCount );
+		}
+		#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
 		/* ulTCPWindowTxAck() returns the number of bytes which have been acked,
 		starting at 'tx.ulCurrentSequenceNumber'.  Advance the tail pointer in
 		txStream. */
@@ -2526,7 +3086,7 @@ int32_t lDistance, lSendResult;
  * checked if it would better be postponed for efficiency.
  */
 static BaseType_t prvSendData( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer,
-	uint32_t ulReceiveLength, BaseType_t xSendLength )
+	uint32_t ulReceiveLength, BaseType_t xSendLength, BaseType_t xAckNow )
 {
 TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( (*ppxNetworkBuffer)->pucEthernetBuffer );
 TCPHeader_t *pxTCPHeader = &pxTCPPacket->xTCPHeader;
@@ -2554,9 +3114,12 @@ int32_t lRxSpace;
 		#endif /* ipconfigTCP_ACK_EARLIER_PACKET */
 
 		/* In case we're receiving data continuously, we might postpone sending
-		an ACK to gain performance. */
+		an ACK to gain performance.  With ipconfigUSE_TCP_RX_BATCHING, an ACK
+		that has to be sent soon is postponed as well, until all received
+		packets have been processed. */
 		if( ( ulReceiveLength > 0 ) &&							/* Data was sent to this socket. */
-			( lRxSpace >= lMinLength ) &&						/* There is Rx space for more data. */
+			( xAckNow == pdFALSE ) &&							/* The ACK policy allows a delay. */
+			( ( lRxSpace >= lMinLength ) || ( ipconfigUSE_TCP_RX_BATCHING != 0 ) ) &&	/* There is Rx space for more data. */
 			( pxSocket->u.xTCP.bits.bFinSent == pdFALSE_UNSIGNED ) &&	/* Not in a closure phase. */
 			( xSendLength == ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) ) && /* No Tx data or options to be sent. */
 			( pxSocket->u.xTCP.ucTCPState == eESTABLISHED ) &&	/* Connection established. */
@@ -2572,17 +3135,41 @@ int32_t lRxSpace;
 
 				pxSocket->u.xTCP.pxAckMessage = *ppxNetworkBuffer;
 			}
-			if( ( ulReceiveLength < ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) ||	/* Received a small message. */
+			if( lRxSpace < lMinLength )
+			{
+				/* Only with ipconfigUSE_TCP_RX_BATCHING.  A time-out of a
+				single tick expires when xTCPTimerCheck() is called just before
+				the IP-task blocks, so one ACK is sent for all packets that were
+				waiting in the queue. */
+				vTCPSocketTimerSet( pxSocket, 1u );
+			}
+			else if( ( ulReceiveLength < ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) ||	/* Received a small message. */
 				( lRxSpace < ( int32_t ) ( 2U * pxSocket->u.xTCP.usCurMSS ) ) )	/* There are less than 2 x MSS space in the Rx buffer. */
 			{
-				pxSocket->u.xTCP.usTimeout = ( uint16_t ) pdMS_TO_MIN_TICKS( DELAYED_ACK_SHORT_DELAY_MS );
+				#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+				{
+					vTCPSocketTimerSet( pxSocket, ( uint16_t ) pdMS_TO_MIN_TICKS( FreeRTOS_min_uint32( DELAYED_ACK_SHORT_DELAY_MS, pxSocket->u.xTCP.usAckDelayMs ) ) );
+				}
+				#else
+				{
+					vTCPSocketTimerSet( pxSocket, ( uint16_t ) pdMS_TO_MIN_TICKS( DELAYED_ACK_SHORT_DELAY_MS ) );
+				}
+				#endif /* ipconfigUSE_TCP_ACK_POLICY */
 			}
 			else
 			{
 				/* Normally a delayed ACK should wait 200 ms for a next incoming
 				packet.  Only wait 20 ms here to gain performance.  A slow ACK
 				for full-size message. */
-				pxSocket->u.xTCP.usTimeout = ( uint16_t ) pdMS_TO_MIN_TICKS( DELAYED_ACK_LONGER_DELAY_MS );
+				#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+				{
+					vTCPSocketTimerSet( pxSocket, ( uint16_t ) pdMS_TO_MIN_TICKS( pxSocket->u.xTCP.usAckDelayMs ) );
+				}
+				#else
+				{
+					vTCPSocketTimerSet( pxSocket, ( uint16_t ) pdMS_TO_MIN_TICKS( DELAYED_ACK_LONGER_DELAY_MS ) );
+				}
+				#endif /* ipconfigUSE_TCP_ACK_POLICY */
 			}
 
 			if( ( xTCPWindowLoggingLevel > 1 ) && ( ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) != pdFALSE ) )
@@ -2617,6 +3204,7 @@ int32_t lRxSpace;
 		( void ) ulReceiveLength;
 		( void ) pxTCPHeader;
 		( void ) lRxSpace;
+		( void ) xAckNow;
 	}
 	#endif /* ipconfigUSE_TCP_WIN */
 
@@ -2829,7 +3417,30 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 
 	if( xSendLength > 0 )
 	{
-		xSendLength = prvSendData( pxSocket, ppxNetworkBuffer, ulReceiveLength, xSendLength );
+	BaseType_t xAckNow = pdFALSE;
+
+		#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+		{
+			if( ulReceiveLength > 0u )
+			{
+				/* Count the full-size segments that the next ACK will
+				acknowledge, and see if the policy wants an ACK right now. */
+				if( ( ulReceiveLength >= ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) && ( pxSocket->u.xTCP.ucAckPending < 0xffu ) )
+				{
+					pxSocket->u.xTCP.ucAckPending++;
+				}
+
+				if( ( pxSocket->u.xTCP.usAckDelayMs == 0u ) ||
+					( ( pxSocket->u.xTCP.ucAckEvery != 0u ) && ( pxSocket->u.xTCP.ucAckPending >= pxSocket->u.xTCP.ucAckEvery ) ) ||
+					( ( pxSocket->u.xTCP.ucAckOnPush != 0u ) && ( ( ucTCPFlags & ipTCP_FLAG_PSH ) != 0u ) ) )
+				{
+					xAckNow = pdTRUE;
+				}
+			}
+		}
+		#endif /* ipconfigUSE_TCP_ACK_POLICY */
+
+		xSendLength = prvSendData( pxSocket, ppxNetworkBuffer, ulReceiveLength, xSendLength, xAckNow );
 	}
 
 	return xSendLength;
@@ -2979,12 +3590,34 @@ BaseType_t xResult = pdPASS;
 				}
 				#endif /* ipconfigHAS_DEBUG_PRINTF */
 
-				if( ( ucTCPFlags & ipTCP_FLAG_RST ) == 0u )
+				#if( ipconfigTCP_SYN_COOKIES != 0 )
+				FreeRTOS_Socket_t *pxChild = prvHandleSynCookieAck( pxSocket, pxNetworkBuffer );
+
+				if( pxChild != NULL )
 				{
-					prvTCPSendReset( pxNetworkBuffer );
+					/* The handshake was completed with a valid cookie, the new
+					child socket will handle the ACK. */
+					pxSocket = pxChild;
 				}
+				else
+				#endif /* ipconfigTCP_SYN_COOKIES */
+				{
+					if( ( ucTCPFlags & ipTCP_FLAG_RST ) == 0u )
+					{
+						prvTCPSendReset( pxNetworkBuffer );
+					}
+					xResult = pdFAIL;
+				}
+			}
+			#if( ipconfigTCP_SYN_COOKIES != 0 )
+			else if( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED )
+			{
+				/* Answer with a cookie, a socket will only be created when the
+				peer returns it. */
+				prvTCPSendSynCookie( pxSocket, pxNetworkBuffer );
 				xResult = pdFAIL;
 			}
+			#endif /* ipconfigTCP_SYN_COOKIES */
 			else
 			{
 				/* prvHandleListen() will either return a newly created socket
@@ -3198,6 +3831,243 @@ uint32_t ulInitialSequenceNumber;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	/* The MSS values that can be encoded in a cookie. */
+	static const uint16_t usSynCookieMSS[] = { 536u, 1200u, 1400u, 1460u };
+
+	static uint32_t ulSynCookieSecret[ 2 ];
+	static BaseType_t xSynCookieSecretSet = pdFALSE;
+
+	static uint32_t prvSynCookieHash( const TCPPacket_t *pxTCPPacket, uint32_t ulPeerSequence, uint32_t ulCounter, uint32_t ulMSSIndex )
+	{
+	uint32_t ulWords[ 4 ];
+	uint32_t ulHash, ulWord;
+	BaseType_t xIndex;
+
+		if( xSynCookieSecretSet == pdFALSE )
+		{
+			ulSynCookieSecret[ 0 ] = ( uint32_t ) ipconfigRAND32();
+			ulSynCookieSecret[ 1 ] = ( uint32_t ) ipconfigRAND32();
+			xSynCookieSecretSet = pdTRUE;
+		}
+
+		/* The addresses and ports are taken from the peer's packet, so the
+		SYN and the returning ACK give the same values. */
+		ulWords[ 0 ] = pxTCPPacket->xIPHeader.ulSourceIPAddress;
+		ulWords[ 1 ] = ( ( uint32_t ) pxTCPPacket->xTCPHeader.usSourcePort << 16 ) | ( uint32_t ) pxTCPPacket->xTCPHeader.usDestinationPort;
+		ulWords[ 2 ] = ulPeerSequence;
+		ulWords[ 3 ] = ( ulCounter << 3 ) | ulMSSIndex;
+
+		/* A keyed 32-bit murmur3 mix. */
+		ulHash = ulSynCookieSecret[ 0 ];
+		for( xIndex = 0; xIndex < ( BaseType_t ) ARRAY_SIZE( ulWords ); xIndex++ )
+		{
+			ulWord = ulWords[ xIndex ] * 0xcc9e2d51UL;
+			ulWord = ( ulWord << 15 ) | ( ulWord >> 17 );
+			ulWord *= 0x1b873593UL;
+			ulHash ^= ulWord;
+			ulHash = ( ulHash << 13 ) | ( ulHash >> 19 );
+			ulHash = ( ulHash * 5UL ) + 0xe6546b64UL;
+		}
+		ulHash ^= ulSynCookieSecret[ 1 ];
+		ulHash ^= ulHash >> 16;
+		ulHash *= 0x85ebca6bUL;
+		ulHash ^= ulHash >> 13;
+		ulHash *= 0xc2b2ae35UL;
+		ulHash ^= ulHash >> 16;
+
+		return ulHash & tcpSYN_COOKIE_HASH_MASK;
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvSynCookieCounter( void )
+	{
+		return ( uint32_t ) ( xTaskGetTickCount() / pdMS_TO_TICKS( tcpSYN_COOKIE_PERIOD_MS ) );
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvSynCookiePeerMSS( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const TCPHeader_t *pxTCPHeader = &( ( ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xTCPHeader );
+	const uint8_t *pucPtr = pxTCPHeader->ucOptdata;
+	const uint8_t *pucLast = pucPtr;
+	/* Without an MSS option, 536 bytes must be assumed. */
+	uint32_t ulMSS = 536UL;
+
+		if( ( pxTCPHeader->ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) > TCP_OFFSET_STANDARD_LENGTH )
+		{
+			pucLast = pucPtr + ( ( ( size_t ) ( pxTCPHeader->ucTCPOffset >> 4 ) - 5u ) << 2 );
+			if( pucLast > ( pxNetworkBuffer->pucEthernetBuffer + pxNetworkBuffer->xDataLength ) )
+			{
+				pucLast = pucPtr;
+			}
+		}
+
+		/* Only the MSS option is of interest, see prvCheckOptions() for a
+		complete parser. */
+		while( pucPtr < pucLast )
+		{
+			if( pucPtr[ 0 ] == TCP_OPT_END )
+			{
+				break;
+			}
+			if( pucPtr[ 0 ] == TCP_OPT_NOOP )
+			{
+				pucPtr++;
+				continue;
+			}
+			if( ( ( pucLast - pucPtr ) < 2 ) || ( pucPtr[ 1 ] < 2u ) || ( pucPtr[ 1 ] > ( pucLast - pucPtr ) ) )
+			{
+				break;
+			}
+			if( ( pucPtr[ 0 ] == TCP_OPT_MSS ) && ( pucPtr[ 1 ] == TCP_OPT_MSS_LEN ) )
+			{
+				ulMSS = ( uint32_t ) usChar2u16( pucPtr + 2 );
+				break;
+			}
+			pucPtr += pucPtr[ 1 ];
+		}
+
+		return ulMSS;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPSendSynCookie( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	TCPHeader_t *pxTCPHeader = &( pxTCPPacket->xTCPHeader );
+	uint32_t ulPeerSequence = FreeRTOS_ntohl( pxTCPHeader->ulSequenceNumber );
+	uint32_t ulMSS = ipconfigTCP_MSS;
+	uint32_t ulMSSIndex = 0UL;
+	uint32_t ulCounter, ulCookie, ulWinSize;
+	UBaseType_t uxOptionsLength = 0u;
+
+		/* Take the same MSS as prvSocketSetMSS() would, limited by the MSS of
+		the peer. */
+		if( ( ( pxTCPPacket->xIPHeader.ulSourceIPAddress ^ *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) != 0ul )
+		{
+			ulMSS = FreeRTOS_min_uint32( ( uint32_t ) REDUCED_MSS_THROUGH_INTERNET, ulMSS );
+		}
+		ulMSS = FreeRTOS_min_uint32( prvSynCookiePeerMSS( pxNetworkBuffer ), ulMSS );
+
+		while( ( ( ulMSSIndex + 1UL ) < ( uint32_t ) ARRAY_SIZE( usSynCookieMSS ) ) && ( usSynCookieMSS[ ulMSSIndex + 1UL ] <= ulMSS ) )
+		{
+			ulMSSIndex++;
+		}
+		ulMSS = FreeRTOS_min_uint32( ( uint32_t ) usSynCookieMSS[ ulMSSIndex ], ( uint32_t ) ipconfigTCP_MSS );
+
+		ulCounter = prvSynCookieCounter();
+		ulCookie = ( ( ulCounter & 0x1fUL ) << tcpSYN_COOKIE_COUNTER_SHIFT ) |
+			( ulMSSIndex << tcpSYN_COOKIE_MSS_SHIFT ) |
+			prvSynCookieHash( pxTCPPacket, ulPeerSequence, ulCounter, ulMSSIndex );
+
+		/* prvTCPReturnPacket() will swap the sequence and the ACK number. */
+		pxTCPHeader->ulSequenceNumber = FreeRTOS_htonl( ulPeerSequence + 1UL );
+		pxTCPHeader->ulAckNr = FreeRTOS_htonl( ulCookie );
+		pxTCPHeader->ucTCPFlags = ipTCP_FLAG_SYN | ipTCP_FLAG_ACK;
+
+		/* A SYN without options has no room for the MSS option, but then the
+		MSS is 536 bytes anyway. */
+		if( ( pxTCPHeader->ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) > TCP_OFFSET_STANDARD_LENGTH )
+		{
+			pxTCPHeader->ucOptdata[ 0 ] = ( uint8_t ) TCP_OPT_MSS;
+			pxTCPHeader->ucOptdata[ 1 ] = ( uint8_t ) TCP_OPT_MSS_LEN;
+			pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( ulMSS >> 8 );
+			pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( ulMSS & 0xffUL );
+			uxOptionsLength = 4u;
+		}
+		pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+
+		/* Without window scaling, advertise at most 64 KB. */
+		ulWinSize = FreeRTOS_min_uint32( ( uint32_t ) ( pxSocket->u.xTCP.uxRxWinSize * ipconfigTCP_MSS ), ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize );
+		ulWinSize = FreeRTOS_min_uint32( ulWinSize, 0xfffcUL );
+		pxTCPHeader->usWindow = FreeRTOS_htons( ( uint16_t ) ulWinSize );
+
+		prvTCPReturnPacket( NULL, pxNetworkBuffer, ( uint32_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ), pdFALSE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static FreeRTOS_Socket_t *prvHandleSynCookieAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	uint8_t ucTCPFlags = pxTCPPacket->xTCPHeader.ucTCPFlags;
+	uint32_t ulPeerSequence = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) - 1UL;
+	uint32_t ulCookie = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr ) - 1UL;
+	uint32_t ulCounter = prvSynCookieCounter();
+	uint32_t ulAge = ( ulCounter - ( ulCookie >> tcpSYN_COOKIE_COUNTER_SHIFT ) ) & 0x1fUL;
+	uint32_t ulMSSIndex = ( ulCookie >> tcpSYN_COOKIE_MSS_SHIFT ) & 0x07UL;
+	FreeRTOS_Socket_t *pxReturn = NULL;
+	FreeRTOS_Socket_t *pxNewSocket;
+	TCPWindow_t *pxTCPWindow;
+
+		if( ( pxSocket->u.xTCP.bits.bReuseSocket != pdFALSE_UNSIGNED ) ||
+			( ( ucTCPFlags & ( ipTCP_FLAG_SYN | ipTCP_FLAG_RST | ipTCP_FLAG_FIN | ipTCP_FLAG_ACK ) ) != ipTCP_FLAG_ACK ) )
+		{
+			/* Only the last step of a handshake can return a cookie. */
+		}
+		else if( ( ulAge > tcpSYN_COOKIE_MAX_AGE ) ||
+				 ( ulMSSIndex >= ( uint32_t ) ARRAY_SIZE( usSynCookieMSS ) ) ||
+				 ( ( ulCookie & tcpSYN_COOKIE_HASH_MASK ) != prvSynCookieHash( pxTCPPacket, ulPeerSequence, ulCounter - ulAge, ulMSSIndex ) ) )
+		{
+			FreeRTOS_debug_printf( ( "TCP: invalid cookie from %lxip:%u\n",
+				FreeRTOS_ntohl( pxTCPPacket->xIPHeader.ulSourceIPAddress ), FreeRTOS_ntohs( pxTCPPacket->xTCPHeader.usSourcePort ) ) );
+		}
+		else if( pxSocket->u.xTCP.usChildCount >= pxSocket->u.xTCP.usBacklog )
+		{
+			FreeRTOS_printf( ( "Check: Socket %u already has %u / %u child%s\n",
+				pxSocket->usLocalPort,
+				pxSocket->u.xTCP.usChildCount,
+				pxSocket->u.xTCP.usBacklog,
+				pxSocket->u.xTCP.usChildCount == 1 ? "" : "ren" ) );
+		}
+		else
+		{
+			pxNewSocket = ( FreeRTOS_Socket_t * ) FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+			if( ( pxNewSocket == NULL ) || ( pxNewSocket == FREERTOS_INVALID_SOCKET ) )
+			{
+				FreeRTOS_debug_printf( ( "TCP: Listen: new socket failed\n" ) );
+			}
+			else if( prvTCPSocketCopy( pxNewSocket, pxSocket ) != pdFALSE )
+			{
+				pxReturn = pxNewSocket;
+			}
+		}
+
+		if( pxReturn != NULL )
+		{
+			pxTCPWindow = &( pxReturn->u.xTCP.xTCPWindow );
+
+			pxReturn->u.xTCP.usRemotePort = FreeRTOS_htons( pxTCPPacket->xTCPHeader.usSourcePort );
+			pxReturn->u.xTCP.ulRemoteIP = FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+			pxTCPWindow->ulOurSequenceNumber = ulCookie;
+			pxTCPWindow->rx.ulCurrentSequenceNumber = ulPeerSequence;
+
+			/* The MSS options of the SYN are gone, the cookie remembers an
+			approximation. */
+			prvSocketSetMSS( pxReturn );
+			if( pxReturn->u.xTCP.usInitMSS > usSynCookieMSS[ ulMSSIndex ] )
+			{
+				pxReturn->u.xTCP.usInitMSS = pxReturn->u.xTCP.usCurMSS = usSynCookieMSS[ ulMSSIndex ];
+			}
+
+			prvTCPCreateWindow( pxReturn );
+
+			/* Continue as if the SYN+ACK had been sent by this socket. */
+			vTCPStateChange( pxReturn, eSYN_RECEIVED );
+			pxTCPWindow->rx.ulCurrentSequenceNumber = pxTCPWindow->rx.ulHighestSequenceNumber = ulPeerSequence + 1UL;
+			pxTCPWindow->tx.ulCurrentSequenceNumber = pxTCPWindow->ulNextTxSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1UL;
+
+			memcpy( pxReturn->u.xTCP.xPacket.u.ucLastPacket, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxReturn->u.xTCP.xPacket.u.ucLastPacket ) );
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+
 /*
  * Duplicates a socket after a listening socket receives a connection.
  */
@@ -3208,6 +4078,11 @@ struct freertos_sockaddr xAddress;
 	pxNewSocket->xReceiveBlockTime = pxSocket->xReceiveBlockTime;
 	pxNewSocket->xSendBlockTime = pxSocket->xSendBlockTime;
 	pxNewSocket->ucSocketOptions = pxSocket->ucSocketOptions;
+	#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+	{
+		pxNewSocket->ucTxClass = pxSocket->ucTxClass;
+	}
+	#endif /* ipconfigTX_PRIORITY_CLASSES */
 	pxNewSocket->u.xTCP.uxRxStreamSize = pxSocket->u.xTCP.uxRxStreamSize;
 	pxNewSocket->u.xTCP.uxTxStreamSize = pxSocket->u.xTCP.uxTxStreamSize;
 	pxNewSocket->u.xTCP.uxLittleSpace = pxSocket->u.xTCP.uxLittleSpace;
@@ -3215,6 +4090,32 @@ struct freertos_sockaddr xAddress;
 	pxNewSocket->u.xTCP.uxRxWinSize  = pxSocket->u.xTCP.uxRxWinSize;
 	pxNewSocket->u.xTCP.uxTxWinSize  = pxSocket->u.xTCP.uxTxWinSize;
 
+	#if( ipconfigUSE_TCP_AUTOTUNING != 0 )
+	{
+		/* A listening socket doesn't exchange data, so its stream sizes are
+		still the configured sizes. */
+		pxNewSocket->u.xTCP.ucAutotune = pxSocket->u.xTCP.ucAutotune;
+		pxNewSocket->u.xTCP.uxRxStreamBase = pxSocket->u.xTCP.uxRxStreamSize;
+		pxNewSocket->u.xTCP.uxTxStreamBase = pxSocket->u.xTCP.uxTxStreamSize;
+		pxNewSocket->u.xTCP.uxRxStreamTarget = pxSocket->u.xTCP.uxRxStreamSize;
+		pxNewSocket->u.xTCP.uxTxStreamTarget = pxSocket->u.xTCP.uxTxStreamSize;
+	}
+	#endif /* ipconfigUSE_TCP_AUTOTUNING */
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		pxNewSocket->u.xTCP.pxCongestionOps = pxSocket->u.xTCP.pxCongestionOps;
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+	#if( ipconfigUSE_TCP_ACK_POLICY != 0 )
+	{
+		pxNewSocket->u.xTCP.ucAckEvery = pxSocket->u.xTCP.ucAckEvery;
+		pxNewSocket->u.xTCP.usAckDelayMs = pxSocket->u.xTCP.usAckDelayMs;
+		pxNewSocket->u.xTCP.ucAckOnPush = pxSocket->u.xTCP.ucAckOnPush;
+	}
+	#endif /* ipconfigUSE_TCP_ACK_POLICY */
+
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 	{
 		pxNewSocket->pxUserSemaphore = pxSocket->pxUserSemaphore;
@@ -3265,10 +4166,18 @@ struct freertos_sockaddr xAddress;
 		/* When bPassAccept is pdTRUE_UNSIGNED this socket may be returned in a call to
 		accept(). */
 		pxNewSocket->u.xTCP.bits.bPassAccept = pdTRUE_UNSIGNED;
-		if(pxSocket->u.xTCP.pxPeerSocket == NULL )
+		#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
 		{
-			pxSocket->u.xTCP.pxPeerSocket = pxNewSocket;
+			prvTCPAcceptQueueAdd( pxSocket, pxNewSocket );
 		}
+		#else
+		{
+			if(pxSocket->u.xTCP.pxPeerSocket == NULL )
+			{
+				pxSocket->u.xTCP.pxPeerSocket = pxNewSocket;
+			}
+		}
+		#endif /* ipconfigTCP_ACCEPT_QUEUE */
 	}
 	#endif
 
@@ -3310,6 +4219,53 @@ struct freertos_sockaddr xAddress;
  * In the API accept(), the user asks is there is a new client?  As API's can
  * not walk through the xBoundTCPSocketsList the IP-task will do this.
  */
+#if( ipconfigTCP_ACCEPT_QUEUE != 0 )
+
+static void prvTCPAcceptQueueAdd( FreeRTOS_Socket_t *pxParent, FreeRTOS_Socket_t *pxChild )
+{
+	/* Children are passed to accept() in the order in which they connected:
+	'pxPeerSocket' of the parent holds the oldest one. */
+	vListInsertEnd( &( pxParent->u.xTCP.xAcceptQueue ), &( pxChild->u.xTCP.xAcceptListItem ) );
+
+	if( pxParent->u.xTCP.pxPeerSocket == NULL )
+	{
+		( void ) xTCPCheckNewClient( pxParent );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t *pxSocket )
+{
+ListItem_t *pxItem;
+FreeRTOS_Socket_t *pxFound;
+BaseType_t xResult = pdFALSE;
+
+	if( pxSocket->u.xTCP.pxPeerSocket != NULL )
+	{
+		/* A child is waiting already, accept() hasn't taken it. */
+		xResult = pdTRUE;
+	}
+
+	/* The accept queue is only accessed by the IP-task.  Take the oldest
+	child that is still waiting to be accepted. */
+	while( ( xResult == pdFALSE ) && ( listLIST_IS_EMPTY( &( pxSocket->u.xTCP.xAcceptQueue ) ) == pdFALSE ) )
+	{
+		pxItem = listGET_HEAD_ENTRY( &( pxSocket->u.xTCP.xAcceptQueue ) );
+		pxFound = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxItem );
+		( void ) uxListRemove( pxItem );
+
+		if( pxFound->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED )
+		{
+			pxSocket->u.xTCP.pxPeerSocket = pxFound;
+			FreeRTOS_debug_printf( ( "xTCPCheckNewClient[0]: client on port %u\n", pxSocket->usLocalPort ) );
+			xResult = pdTRUE;
+		}
+	}
+	return xResult;
+}
+
+#else
+
 BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t *pxSocket )
 {
 TickType_t xLocalPort = FreeRTOS_htons( pxSocket->usLocalPort );
@@ -3337,6 +4293,8 @@ BaseType_t xResult = pdFALSE;
 	}
 	return xResult;
 }
+
+#endif /* ipconfigTCP_ACCEPT_QUEUE */
 /*-----------------------------------------------------------*/
 
 #endif /* ipconfigUSE_TCP == 1 */
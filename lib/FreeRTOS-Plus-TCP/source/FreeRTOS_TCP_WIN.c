@@ -87,6 +87,17 @@
 	 */
 	#define MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW		( 4u )
 
+	/* CUBIC: the multiplicative decrease factor beta = 0.7 and the scaling
+	 * constant C = 0.4, expressed as fractions. */
+	#define winCUBIC_BETA_NUMERATOR						( 7u )
+	#define winCUBIC_BETA_DENOMINATOR					( 10u )
+	#define winCUBIC_C_NUMERATOR						( 4u )
+	#define winCUBIC_C_DENOMINATOR						( 10u )
+
+	/* CUBIC: never look further than 30 seconds ahead of or behind K, so
+	 * that the cube of the time can not overflow. */
+	#define winCUBIC_MAX_TIME_mS						( 30000u )
+
 #endif /* configUSE_TCP_WIN */
 /*-----------------------------------------------------------*/
 
@@ -181,6 +192,14 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static BaseType_t prvTCPWindowTxHasSpace( TCPWindow_t *pxWindow, uint32_t ulWindowSize );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Returns true if the next call to ulTCPWindowTxGet() would return a segment
+ * of new data, as opposed to a retransmission or nothing.
+ */
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	static BaseType_t prvTCPWindowTxNextIsNew( TCPWindow_t *pxWindow, uint32_t ulWindowSize );
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
 /*
  * An acknowledge was received.  See if some outstanding data may be removed
  * from the transmission queue(s).
@@ -190,13 +209,46 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
 /*
- * A higher Tx block has been acknowledged.  Now iterate through the xWaitQueue
- * to find a possible condition for a FAST retransmission.
+ * A higher Tx block has been acknowledged.  Use the SACK scoreboard, the
+ * 'bAcked' flags of the segments in xTxSegments, to find the outstanding
+ * segments that must have been lost, and queue them for a FAST retransmission.
  */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst );
+	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Pass the events that are relevant for congestion control to the algorithm
+ * of the connection, and keep track of loss recovery.
+ */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	static void prvTCPCongestionInit( TCPWindow_t *pxWindow );
+	static void prvTCPCongestionOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static void prvTCPCongestionOnLoss( TCPWindow_t *pxWindow );
+	static void prvTCPCongestionOnTimeout( TCPWindow_t *pxWindow );
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+/*
+ * The NewReno algorithm ( RFC 5681 and RFC 6582 ).
+ */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	static void prvNewRenoInit( TCPWindow_t *pxWindow );
+	static void prvNewRenoOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static void prvNewRenoOnLoss( TCPWindow_t *pxWindow );
+	static void prvNewRenoOnTimeout( TCPWindow_t *pxWindow );
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+/*
+ * The CUBIC algorithm ( RFC 8312 ).
+ */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+	static void prvCubicInit( TCPWindow_t *pxWindow );
+	static void prvCubicOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static void prvCubicOnLoss( TCPWindow_t *pxWindow );
+	static void prvCubicOnTimeout( TCPWindow_t *pxWindow );
+	static uint32_t prvCubicRoot( uint64_t ullValue );
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+
 /*-----------------------------------------------------------*/
 
 /* TCP segment pool. */
@@ -212,6 +264,28 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 /* Logging verbosity level. */
 BaseType_t xTCPWindowLoggingLevel = 0;
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	const TCPCongestionOps_t xTCPCongestionNewReno =
+	{
+		"newreno",
+		prvNewRenoInit,
+		prvNewRenoOnAck,
+		prvNewRenoOnLoss,
+		prvNewRenoOnTimeout
+	};
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+	const TCPCongestionOps_t xTCPCongestionCubic =
+	{
+		"cubic",
+		prvCubicInit,
+		prvCubicOnAck,
+		prvCubicOnLoss,
+		prvCubicOnTimeout
+	};
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 	/* Some 32-bit arithmetic: comparing sequence numbers */
 	static portINLINE BaseType_t xSequenceLessThanOrEqual( uint32_t a, uint32_t b );
@@ -646,6 +720,12 @@ const int32_t l500ms = 500;
 	}
 	#endif /* ipconfigUSE_TCP_WIN == 1 */
 
+	#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+	{
+		pxWindow->pxLastTxSegment = NULL;
+	}
+	#endif /* ipconfigTCP_INCREMENTAL_CHECKSUM */
+
 	/*Start with a timeout of 2 * 500 ms (1 sec). */
 	pxWindow->lSRTT = l500ms;
 
@@ -670,6 +750,12 @@ const int32_t l500ms = 500;
 	/* The right-hand side of the transmit window. */
 	pxWindow->tx.ulHighestSequenceNumber = ulSequenceNumber;
 	pxWindow->ulOurSequenceNumber = ulSequenceNumber;
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		prvTCPCongestionInit( pxWindow );
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 }
 /*-----------------------------------------------------------*/
 
@@ -1187,6 +1273,16 @@ const int32_t l500ms = 500;
 			{
 				xHasSpace = pdFALSE;
 			}
+
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+			{
+				/* The congestion window limits the outstanding data as well. */
+				if( ( ulTxOutstanding != 0UL ) && ( pxWindow->xCongestion.ulWindow < ulTxOutstanding + ( ( uint32_t ) pxSegment->lDataLength ) ) )
+				{
+					xHasSpace = pdFALSE;
+				}
+			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 		}
 
 		return xHasSpace;
@@ -1306,6 +1402,17 @@ const int32_t l500ms = 500;
 					pxSegment = xTCPWindowGetHead( &( pxWindow->xWaitQueue ) );
 					pxSegment->u.bits.ucDupAckCount = pdFALSE_UNSIGNED;
 
+					#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+					{
+						/* Only the time-out of the oldest outstanding segment
+						counts, the ones after it are part of the same loss. */
+						if( pxSegment->ulSequenceNumber == pxWindow->tx.ulCurrentSequenceNumber )
+						{
+							prvTCPCongestionOnTimeout( pxWindow );
+						}
+					}
+					#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 					/* Some detailed logging. */
 					if( ( xTCPWindowLoggingLevel != 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != 0 ) )
 					{
@@ -1406,10 +1513,20 @@ const int32_t l500ms = 500;
 
 			/* Administer the transmit count, needed for fast
 			retransmissions. */
+			#if( ipconfigTCP_CONNECTION_STATS != 0 )
+			{
+				if( pxSegment->u.bits.ucTransmitCount != 0u )
+				{
+					pxWindow->ulRetransmitCount++;
+				}
+			}
+			#endif /* ipconfigTCP_CONNECTION_STATS */
 			( pxSegment->u.bits.ucTransmitCount )++;
 
 			/* If there have been several retransmissions (4), decrease the
-			size of the transmission window to at most 2 times MSS. */
+			size of the transmission window to at most 2 times MSS.  With
+			congestion control, the congestion window takes care of this. */
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 0 )
 			if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
 			{
 				if( pxWindow->xSize.ulTxWindowLength > ( 2U * pxWindow->usMSS ) )
@@ -1420,12 +1537,19 @@ const int32_t l500ms = 500;
 					pxWindow->xSize.ulTxWindowLength = ( 2UL * pxWindow->usMSS );
 				}
 			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 0 */
 
 			/* Clear the transmit timer. */
 			vTCPTimerSet( &( pxSegment->xTransmitTimer ) );
 
 			pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
 
+			#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+			{
+				pxWindow->pxLastTxSegment = pxSegment;
+			}
+			#endif /* ipconfigTCP_INCREMENTAL_CHECKSUM */
+
 			/* Inform the caller where to find the data within the queue. */
 			*plPosition = pxSegment->lStreamPos;
 
@@ -1439,6 +1563,109 @@ const int32_t l500ms = 500;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+
+	static BaseType_t prvTCPWindowTxNextIsNew( TCPWindow_t *pxWindow, uint32_t ulWindowSize )
+	{
+	TCPSegment_t *pxSegment;
+	uint32_t ulMaxTime;
+	BaseType_t xReturn = pdFALSE;
+
+		/* The same order of checks as in ulTCPWindowTxGet(): priority
+		segments first, then expired segments, and then new data. */
+		if( listLIST_IS_EMPTY( &( pxWindow->xPriorityQueue ) ) != pdFALSE )
+		{
+			pxSegment = xTCPWindowPeekHead( &( pxWindow->xWaitQueue ) );
+
+			if( pxSegment != NULL )
+			{
+				ulMaxTime = ( 1u << pxSegment->u.bits.ucTransmitCount ) * ( ( uint32_t ) pxWindow->lSRTT );
+
+				if( ulTimerGetAge( &pxSegment->xTransmitTimer ) <= ulMaxTime )
+				{
+					pxSegment = NULL;
+				}
+			}
+
+			if( pxSegment == NULL )
+			{
+				pxSegment = xTCPWindowPeekHead( &( pxWindow->xTxQueue ) );
+
+				if( ( pxSegment != NULL ) &&
+					( ( pxWindow->u.bits.bSendFullSize == pdFALSE_UNSIGNED ) || ( pxSegment->lDataLength >= pxSegment->lMaxLength ) ) &&
+					( prvTCPWindowTxHasSpace( pxWindow, ulWindowSize ) != pdFALSE ) )
+				{
+					xReturn = pdTRUE;
+				}
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+
+	uint32_t ulTCPWindowTxGetLarge( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition, uint32_t ulMaxLength )
+	{
+	TCPSegment_t *pxSegment;
+	uint32_t ulReturn, ulFirstSequenceNumber, ulLength;
+	int32_t lPosition;
+
+		if( prvTCPWindowTxNextIsNew( pxWindow, ulWindowSize ) == pdFALSE )
+		{
+			/* A retransmission, or nothing at all: these are always sent as
+			single segments. */
+			ulReturn = ulTCPWindowTxGet( pxWindow, ulWindowSize, plPosition );
+		}
+		else
+		{
+			ulReturn = ulTCPWindowTxGet( pxWindow, ulWindowSize, plPosition );
+			ulFirstSequenceNumber = pxWindow->ulOurSequenceNumber;
+
+			/* Append the following segments as long as they are full-sized
+			and contiguous.  Each of them keeps its own timer and is
+			acknowledged on its own, as if it was sent separately. */
+			for( ;; )
+			{
+				pxSegment = xTCPWindowPeekHead( &( pxWindow->xTxQueue ) );
+
+				if( ( pxSegment == NULL ) ||
+					( pxSegment->ulSequenceNumber != ulFirstSequenceNumber + ulReturn ) ||
+					( ulReturn + ( uint32_t ) pxSegment->lDataLength > ulMaxLength ) ||
+					( prvTCPWindowTxNextIsNew( pxWindow, ulWindowSize ) == pdFALSE ) )
+				{
+					break;
+				}
+
+				ulLength = ulTCPWindowTxGet( pxWindow, ulWindowSize, &lPosition );
+
+				if( ulLength == 0UL )
+				{
+					break;
+				}
+
+				ulReturn += ulLength;
+
+				if( pxSegment->lDataLength < pxSegment->lMaxLength )
+				{
+					/* A partial segment is the last one in the queue. */
+					break;
+				}
+			}
+
+			/* The super-segment starts at the first sequence number. */
+			pxWindow->ulOurSequenceNumber = ulFirstSequenceNumber;
+		}
+
+		return ulReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
 	static uint32_t prvTCPWindowTxCheckAck( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast )
@@ -1592,44 +1819,73 @@ const int32_t l500ms = 500;
 
 #if( ipconfigUSE_TCP_WIN == 1 )
 
-	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst )
+	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow )
 	{
 	const ListItem_t *pxIterator;
 	const MiniListItem_t* pxEnd;
 	TCPSegment_t *pxSegment;
 	uint32_t ulCount = 0UL;
+	uint32_t ulSackedCount = 0UL, ulSackedBytes = 0UL;
 
-		/* A higher Tx block has been acknowledged.  Now iterate through the
-		 xWaitQueue to find a possible condition for a FAST retransmission. */
+		/* A higher Tx block has been acknowledged.  xTxSegments holds all
+		segments in a strict sequential order, the ones that have been
+		selectively ACK'd have 'bAcked' set.  First count them. */
+		pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &( pxWindow->xTxSegments ) );
 
-		pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &( pxWindow->xWaitQueue ) );
+		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+			if( pxSegment->u.bits.bAcked != pdFALSE_UNSIGNED )
+			{
+				ulSackedCount++;
+				ulSackedBytes += ( uint32_t ) pxSegment->lDataLength;
+			}
+		}
 
+		/* Now walk the segments again, while ulSackedCount and ulSackedBytes
+		hold the number of segments and bytes that were selectively ACK'd above
+		the current segment. */
 		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd; )
+			 ( pxIterator != ( const ListItem_t * ) pxEnd ) && ( ulSackedCount != 0UL );
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
 		{
-			/* Get the owner, which is a TCP segment. */
 			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
 
-			/* Hop to the next item before the current gets unlinked. */
-			pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator );
+			if( pxSegment->u.bits.bAcked != pdFALSE_UNSIGNED )
+			{
+				ulSackedCount--;
+				ulSackedBytes -= ( uint32_t ) pxSegment->lDataLength;
+				continue;
+			}
+
+			/* Only segments that are waiting for an ACK can be lost.  Each one
+			is fast-retransmitted at most once, until a normal retransmission
+			clears 'ucDupAckCount' again. */
+			if( ( listLIST_ITEM_CONTAINER( &( pxSegment->xQueueItem ) ) != &( pxWindow->xWaitQueue ) ) ||
+				( pxSegment->u.bits.ucDupAckCount >= DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
+			{
+				continue;
+			}
 
 			/* Fast retransmission:
-			When 3 packets with a higher sequence number have been acknowledged
-			by the peer, it is very unlikely a current packet will ever arrive.
-			It will be retransmitted far before the RTO. */
-			if( ( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED ) &&
-				( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) != pdFALSE ) &&
-				( ++( pxSegment->u.bits.ucDupAckCount ) == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
+			When 3 packets, or more than 2 * MSS bytes, with a higher sequence
+			number have been acknowledged by the peer, it is very unlikely a
+			current packet will ever arrive ( see IsLost() in RFC 6675 ).  It
+			will be retransmitted far before the RTO. */
+			if( ( ulSackedCount >= DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) ||
+				( ulSackedBytes > ( ( DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT - 1u ) * ( uint32_t ) pxWindow->usMSS ) ) )
 			{
 				pxSegment->u.bits.ucTransmitCount = pdFALSE_UNSIGNED;
+				pxSegment->u.bits.ucDupAckCount = DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT;
 
-				/* Not clearing 'ucDupAckCount' yet as more SACK's might come in
-				which might lead to a second fast rexmit. */
 				if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
 				{
-					FreeRTOS_debug_printf( ( "prvTCPWindowFastRetransmit: Requeue sequence number %lu < %lu\n",
+					FreeRTOS_debug_printf( ( "prvTCPWindowFastRetransmit: Requeue sequence number %lu (%lu segments SACK'd above)\n",
 						pxSegment->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber,
-						ulFirst - pxWindow->tx.ulFirstSequenceNumber ) );
+						ulSackedCount ) );
 					FreeRTOS_flush_logging( );
 				}
 
@@ -1643,6 +1899,15 @@ const int32_t l500ms = 500;
 			}
 		}
 
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+		{
+			if( ulCount != 0UL )
+			{
+				prvTCPCongestionOnLoss( pxWindow );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 		return ulCount;
 	}
 #endif /* ipconfigUSE_TCP_WIN == 1 */
@@ -1665,6 +1930,15 @@ const int32_t l500ms = 500;
 		else
 		{
 			ulReturn = prvTCPWindowTxCheckAck( pxWindow, ulFirstSequence, ulSequenceNumber );
+
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+			{
+				if( ulReturn != 0UL )
+				{
+					prvTCPCongestionOnAck( pxWindow, ulReturn );
+				}
+			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 		}
 
 		return ulReturn;
@@ -1682,7 +1956,18 @@ const int32_t l500ms = 500;
 
 		/* Receive a SACK option. */
 		ulAckCount = prvTCPWindowTxCheckAck( pxWindow, ulFirst, ulLast );
-		prvTCPWindowFastRetransmit( pxWindow, ulFirst );
+
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+		{
+			/* The left side of the window has advanced. */
+			if( ulAckCount != 0UL )
+			{
+				prvTCPCongestionOnAck( pxWindow, ulAckCount );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+		prvTCPWindowFastRetransmit( pxWindow );
 
 		if( ( xTCPWindowLoggingLevel >= 1 ) && ( xSequenceGreaterThan( ulFirst, ulCurrentSequenceNumber ) != pdFALSE ) )
 		{
@@ -1701,6 +1986,392 @@ const int32_t l500ms = 500;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	uint32_t ulTCPWindowTxOutstanding( const TCPWindow_t *pxWindow )
+	{
+	uint32_t ulTxOutstanding;
+
+		if( xSequenceGreaterThanOrEqual( pxWindow->tx.ulHighestSequenceNumber, pxWindow->tx.ulCurrentSequenceNumber ) != pdFALSE )
+		{
+			ulTxOutstanding = pxWindow->tx.ulHighestSequenceNumber - pxWindow->tx.ulCurrentSequenceNumber;
+		}
+		else
+		{
+			ulTxOutstanding = 0UL;
+		}
+
+		return ulTxOutstanding;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionInit( TCPWindow_t *pxWindow )
+	{
+		memset( &( pxWindow->xCongestion ), '\0', sizeof( pxWindow->xCongestion ) );
+
+		/* pxCongestionOps has been set by the socket, or it is NULL. */
+		if( pxWindow->pxCongestionOps == NULL )
+		{
+			pxWindow->pxCongestionOps = &xTCPCongestionNewReno;
+		}
+
+		pxWindow->pxCongestionOps->vInit( pxWindow );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+
+		if( pxCongestion->xInRecovery != pdFALSE )
+		{
+			/* A partial ACK does not let the window grow.  Once all data that
+			was outstanding at the moment of the loss has been ACK'd, the loss
+			recovery is over. */
+			if( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxCongestion->ulRecoverSequenceNumber ) != pdFALSE )
+			{
+				pxCongestion->xInRecovery = pdFALSE;
+			}
+		}
+		else
+		{
+			pxWindow->pxCongestionOps->vOnAck( pxWindow, ulBytesAcked );
+
+			/* There is no use in a congestion window which is bigger than the
+			transmission window. */
+			if( pxCongestion->ulWindow > pxWindow->xSize.ulTxWindowLength )
+			{
+				pxCongestion->ulWindow = pxWindow->xSize.ulTxWindowLength;
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionOnLoss( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+
+		/* The window is reduced only once per window of data, however many
+		segments of it have been lost. */
+		if( pxCongestion->xInRecovery == pdFALSE )
+		{
+			pxWindow->pxCongestionOps->vOnLoss( pxWindow );
+
+			pxCongestion->xInRecovery = pdTRUE;
+			pxCongestion->ulRecoverSequenceNumber = pxWindow->tx.ulHighestSequenceNumber;
+
+			if( ( xTCPWindowLoggingLevel >= 1 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPCongestionOnLoss[%u,%u]: %s cwnd %lu ssthresh %lu\n",
+					pxWindow->usPeerPortNumber,
+					pxWindow->usOurPortNumber,
+					pxWindow->pxCongestionOps->pcName,
+					pxCongestion->ulWindow,
+					pxCongestion->ulSlowStartThreshold ) );
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionOnTimeout( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+
+		pxWindow->pxCongestionOps->vOnTimeout( pxWindow );
+
+		/* The time-out ends a fast recovery, all outstanding segments will
+		be retransmitted when their timers expire. */
+		pxCongestion->xInRecovery = pdFALSE;
+
+		if( ( xTCPWindowLoggingLevel >= 1 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
+		{
+			FreeRTOS_debug_printf( ( "prvTCPCongestionOnTimeout[%u,%u]: %s cwnd %lu ssthresh %lu\n",
+				pxWindow->usPeerPortNumber,
+				pxWindow->usOurPortNumber,
+				pxWindow->pxCongestionOps->pcName,
+				pxCongestion->ulWindow,
+				pxCongestion->ulSlowStartThreshold ) );
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvNewRenoInit( TCPWindow_t *pxWindow )
+	{
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		/* The initial window of RFC 3390: min( 4 * MSS, max( 2 * MSS, 4380 ) ). */
+		pxWindow->xCongestion.ulWindow = FreeRTOS_min_uint32( 4UL * ulMSS, FreeRTOS_max_uint32( 2UL * ulMSS, 4380UL ) );
+
+		/* Start with an arbitrarily high slow start threshold. */
+		pxWindow->xCongestion.ulSlowStartThreshold = pxWindow->xSize.ulTxWindowLength;
+		pxWindow->xCongestion.ulBytesAcked = 0UL;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvNewRenoOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		if( pxCongestion->ulWindow < pxCongestion->ulSlowStartThreshold )
+		{
+			/* Slow start: grow with the number of bytes ACK'd, but with at
+			most one MSS per ACK ( RFC 3465 with L = 1 ). */
+			pxCongestion->ulWindow += FreeRTOS_min_uint32( ulBytesAcked, ulMSS );
+		}
+		else
+		{
+			/* Congestion avoidance: grow with one MSS for every window of
+			data that gets ACK'd, i.e. one MSS per round-trip. */
+			pxCongestion->ulBytesAcked += ulBytesAcked;
+
+			if( pxCongestion->ulBytesAcked >= pxCongestion->ulWindow )
+			{
+				pxCongestion->ulBytesAcked -= pxCongestion->ulWindow;
+				pxCongestion->ulWindow += ulMSS;
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvNewRenoOnLoss( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		/* ssthresh = max( FlightSize / 2, 2 * MSS ), and continue with
+		congestion avoidance from there. */
+		pxCongestion->ulSlowStartThreshold = FreeRTOS_max_uint32( ulTCPWindowTxOutstanding( pxWindow ) / 2UL, 2UL * ulMSS );
+		pxCongestion->ulWindow = pxCongestion->ulSlowStartThreshold;
+		pxCongestion->ulBytesAcked = 0UL;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvNewRenoOnTimeout( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		/* Like a loss, but restart with slow start from the loss window of
+		one MSS. */
+		pxCongestion->ulSlowStartThreshold = FreeRTOS_max_uint32( ulTCPWindowTxOutstanding( pxWindow ) / 2UL, 2UL * ulMSS );
+		pxCongestion->ulWindow = ulMSS;
+		pxCongestion->ulBytesAcked = 0UL;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+
+	static uint32_t prvCubicRoot( uint64_t ullValue )
+	{
+	uint64_t ullRoot = 0ULL, ullBit;
+	BaseType_t xShift;
+
+		/* Integer cube root, one bit of the result per iteration. */
+		for( xShift = 63; xShift >= 0; xShift -= 3 )
+		{
+			ullRoot <<= 1;
+			ullBit = ( 3ULL * ullRoot * ( ullRoot + 1ULL ) ) + 1ULL;
+
+			if( ( ullValue >> xShift ) >= ullBit )
+			{
+				ullValue -= ullBit << xShift;
+				ullRoot++;
+			}
+		}
+
+		return ( uint32_t ) ullRoot;
+	}
+
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+
+	static void prvCubicInit( TCPWindow_t *pxWindow )
+	{
+		/* Slow start is the same as for NewReno, the other fields have been
+		cleared by prvTCPCongestionInit(). */
+		prvNewRenoInit( pxWindow );
+	}
+
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+
+	static void prvCubicOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+	uint32_t ulTime, ulDelta, ulTarget;
+	uint64_t ullOffset;
+
+		if( pxCongestion->ulWindow < pxCongestion->ulSlowStartThreshold )
+		{
+			pxCongestion->ulWindow += FreeRTOS_min_uint32( ulBytesAcked, ulMSS );
+		}
+		else
+		{
+			if( pxCongestion->xCubicEpochStarted == pdFALSE )
+			{
+				/* The first ACK of a congestion avoidance period. */
+				pxCongestion->xCubicEpochStarted = pdTRUE;
+				vTCPTimerSet( &( pxCongestion->xCubicEpoch ) );
+				pxCongestion->ulBytesAcked = 0UL;
+				pxCongestion->ulCubicEstimate = pxCongestion->ulWindow;
+
+				if( pxCongestion->ulWindow < pxCongestion->ulCubicMaxWindow )
+				{
+					/* K = cbrt( ( W_max - cwnd ) / C ), with the windows in
+					units of MSS and K in ms. */
+					pxCongestion->ulCubicK = prvCubicRoot( ( ( uint64_t ) ( pxCongestion->ulCubicMaxWindow - pxCongestion->ulWindow ) *
+						( 1000000000ULL * winCUBIC_C_DENOMINATOR / winCUBIC_C_NUMERATOR ) ) / ulMSS );
+					pxCongestion->ulCubicOrigin = pxCongestion->ulCubicMaxWindow;
+				}
+				else
+				{
+					pxCongestion->ulCubicK = 0UL;
+					pxCongestion->ulCubicOrigin = pxCongestion->ulWindow;
+				}
+			}
+
+			/* W_cubic( t + RTT ) = C * ( t + RTT - K )^3 + W_max */
+			ulTime = ulTimerGetAge( &( pxCongestion->xCubicEpoch ) ) + ( uint32_t ) pxWindow->lSRTT;
+
+			if( ulTime >= pxCongestion->ulCubicK )
+			{
+				ulDelta = FreeRTOS_min_uint32( ulTime - pxCongestion->ulCubicK, winCUBIC_MAX_TIME_mS );
+			}
+			else
+			{
+				ulDelta = FreeRTOS_min_uint32( pxCongestion->ulCubicK - ulTime, winCUBIC_MAX_TIME_mS );
+			}
+
+			ullOffset = ( ( uint64_t ) ulDelta * ulDelta * ulDelta * ulMSS * winCUBIC_C_NUMERATOR ) / ( 1000000000ULL * winCUBIC_C_DENOMINATOR );
+
+			if( ulTime >= pxCongestion->ulCubicK )
+			{
+				ullOffset += pxCongestion->ulCubicOrigin;
+				ulTarget = ( ullOffset > 0xffffffffULL ) ? 0xffffffffUL : ( uint32_t ) ullOffset;
+			}
+			else if( ullOffset < pxCongestion->ulCubicOrigin )
+			{
+				ulTarget = pxCongestion->ulCubicOrigin - ( uint32_t ) ullOffset;
+			}
+			else
+			{
+				ulTarget = 0UL;
+			}
+
+			/* Do not grow faster than 1.5 times per round-trip. */
+			ulTarget = FreeRTOS_min_uint32( ulTarget, pxCongestion->ulWindow + ( pxCongestion->ulWindow / 2UL ) );
+
+			if( ulTarget > pxCongestion->ulWindow )
+			{
+				/* cwnd += ( target - cwnd ) / cwnd for every MSS ACK'd. */
+				pxCongestion->ulWindow += ( uint32_t ) ( ( ( uint64_t ) ( ulTarget - pxCongestion->ulWindow ) * ulBytesAcked ) / pxCongestion->ulWindow );
+			}
+
+			/* The TCP-friendly region: W_est grows like NewReno would, with
+			3 * ( 1 - beta ) / ( 1 + beta ) MSS per round-trip. */
+			pxCongestion->ulBytesAcked += ulBytesAcked;
+
+			if( pxCongestion->ulBytesAcked >= pxCongestion->ulCubicEstimate )
+			{
+				pxCongestion->ulBytesAcked -= pxCongestion->ulCubicEstimate;
+				pxCongestion->ulCubicEstimate += ( 3UL * ( winCUBIC_BETA_DENOMINATOR - winCUBIC_BETA_NUMERATOR ) * ulMSS ) /
+					( winCUBIC_BETA_DENOMINATOR + winCUBIC_BETA_NUMERATOR );
+			}
+
+			if( pxCongestion->ulCubicEstimate > pxCongestion->ulWindow )
+			{
+				pxCongestion->ulWindow = pxCongestion->ulCubicEstimate;
+			}
+		}
+	}
+
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+
+	static void prvCubicOnLoss( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulWindow = pxCongestion->ulWindow;
+
+		/* Fast convergence: when the window did not reach the previous W_max,
+		the available bandwidth has become smaller.  Release some more of it
+		by remembering a smaller W_max. */
+		if( ulWindow < pxCongestion->ulCubicLastMaxWindow )
+		{
+			pxCongestion->ulCubicMaxWindow = ( uint32_t ) ( ( ( uint64_t ) ulWindow * ( winCUBIC_BETA_DENOMINATOR + winCUBIC_BETA_NUMERATOR ) ) /
+				( 2u * winCUBIC_BETA_DENOMINATOR ) );
+		}
+		else
+		{
+			pxCongestion->ulCubicMaxWindow = ulWindow;
+		}
+		pxCongestion->ulCubicLastMaxWindow = ulWindow;
+
+		/* ssthresh = cwnd * beta */
+		pxCongestion->ulSlowStartThreshold = FreeRTOS_max_uint32( ( uint32_t ) ( ( ( uint64_t ) ulWindow * winCUBIC_BETA_NUMERATOR ) / winCUBIC_BETA_DENOMINATOR ),
+			2UL * ( uint32_t ) pxWindow->usMSS );
+		pxCongestion->ulWindow = pxCongestion->ulSlowStartThreshold;
+		pxCongestion->xCubicEpochStarted = pdFALSE;
+	}
+
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigTCP_CONGESTION_CUBIC != 0 )
+
+	static void prvCubicOnTimeout( TCPWindow_t *pxWindow )
+	{
+		/* Reduce like for a loss, and restart with slow start from the loss
+		window of one MSS. */
+		prvCubicOnLoss( pxWindow );
+		pxWindow->xCongestion.ulWindow = ( uint32_t ) pxWindow->usMSS;
+	}
+
+#endif /* ipconfigTCP_CONGESTION_CUBIC */
+/*-----------------------------------------------------------*/
+
 /*
 #####   #                      #####   ####  ######
 # # #   #                      # # #  #    #  #    #
@@ -1821,9 +2492,22 @@ const int32_t l500ms = 500;
 			if( ulLength != 0ul )
 			{
 				pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
+				#if( ipconfigTCP_CONNECTION_STATS != 0 )
+				{
+					if( pxSegment->u.bits.ucTransmitCount != 0u )
+					{
+						pxWindow->ulRetransmitCount++;
+					}
+				}
+				#endif /* ipconfigTCP_CONNECTION_STATS */
 				pxSegment->u.bits.ucTransmitCount++;
 				vTCPTimerSet (&pxSegment->xTransmitTimer);
 				pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
+				#if( ipconfigTCP_INCREMENTAL_CHECKSUM != 0 )
+				{
+					pxWindow->pxLastTxSegment = pxSegment;
+				}
+				#endif /* ipconfigTCP_INCREMENTAL_CHECKSUM */
 				*plPosition = pxSegment->lStreamPos;
 			}
 		}
@@ -72,16 +72,43 @@ UDPPacketHeader_t xDefaultPartUDPPacketHeader =
 };
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	/*
+	 * Store the headers of a packet that was just completed as the template of
+	 * the connected socket that sent it.
+	 */
+	static void prvUDPStoreTemplate( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+/*-----------------------------------------------------------*/
+
 void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 {
 UDPPacket_t *pxUDPPacket;
 IPHeader_t *pxIPHeader;
 eARPLookupResult_t eReturned;
 uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	BaseType_t xPacketHeld = pdFALSE;
+#endif
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+	uint8_t ucTemplateRequest;
+#endif
 
 	/* Map the UDP packet onto the start of the frame. */
 	pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
 
+	#if( ipconfigUSE_LOOPBACK != 0 )
+	{
+		/* Packets to 127.0.0.0/8 are sent to the own IP address, so that the
+		replies will come from the address that they were sent to. */
+		if( ( ipIS_LOOPBACK_NETWORK( ulIPAddress ) ) && ( *ipLOCAL_IP_ADDRESS_POINTER != 0UL ) )
+		{
+			pxNetworkBuffer->ulIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+			ulIPAddress = pxNetworkBuffer->ulIPAddress;
+		}
+	}
+	#endif /* ipconfigUSE_LOOPBACK */
+
 	/* Determine the ARP cache status for the requested IP address. */
 	eReturned = eARPGetCacheEntry( &( ulIPAddress ), &( pxUDPPacket->xEthernetHeader.xDestinationAddress ) );
 
@@ -132,6 +159,9 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 				ucSocketOptions = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ];
 			#endif
+			#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+				ucTemplateRequest = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] & ( uint8_t ) FREERTOS_UDP_TEMPLATE_REQUEST;
+			#endif
 			/*
 			 * Offset the memcpy by the size of a MAC address to start at the packet's
 			 * Ethernet header 'source' MAC address; the preceding 'destination' should not be altered.
@@ -170,20 +200,33 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 			{
-				pxIPHeader->usHeaderChecksum = 0u;
-				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
-				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
-
-				if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0u )
+				/* The checksums of a looped-back packet are not verified. */
+				if( ipIS_LOOPBACK_FRAME( pxNetworkBuffer ) == pdFALSE )
 				{
-					usGenerateProtocolChecksum( (uint8_t*)pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					pxIPHeader->usHeaderChecksum = 0u;
+					pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+					pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+					if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0u )
+					{
+						usGenerateProtocolChecksum( (uint8_t*)pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					}
+					else
+					{
+						pxUDPPacket->xUDPHeader.usChecksum = 0u;
+					}
 				}
-				else
+			}
+			#endif
+
+			#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+			{
+				if( ucTemplateRequest != 0u )
 				{
-					pxUDPPacket->xUDPHeader.usChecksum = 0u;
+					prvUDPStoreTemplate( pxNetworkBuffer );
 				}
 			}
-			#endif
+			#endif /* ipconfigUDP_CONNECTED_SOCKETS */
 		}
 		else if( eReturned == eARPCacheMiss )
 		{
@@ -192,19 +235,52 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 			outstanding, and perform retransmissions if necessary. */
 			vARPRefreshCacheEntry( NULL, ulIPAddress );
 
-			/* Generate an ARP for the required IP address. */
-			iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
-			pxNetworkBuffer->ulIPAddress = ulIPAddress;
-			vARPGenerateRequestPacket( pxNetworkBuffer );
+			#if( ipconfigARP_PENDING_PACKETS > 0 )
+			{
+				/* Rather than dropping the packet, hold it until the ARP reply
+				arrives, and send the request in a buffer of its own. */
+				if( xARPHoldPacket( pxNetworkBuffer, ulIPAddress ) != pdFAIL )
+				{
+					xPacketHeld = pdTRUE;
+					FreeRTOS_OutputARPRequest( ulIPAddress );
+				}
+			}
+			#endif /* ipconfigARP_PENDING_PACKETS */
+
+		#if( ipconfigARP_PENDING_PACKETS > 0 )
+			if( xPacketHeld == pdFALSE )
+		#endif /* ipconfigARP_PENDING_PACKETS */
+			{
+				/* Generate an ARP for the required IP address. */
+				iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
+				pxNetworkBuffer->ulIPAddress = ulIPAddress;
+				vARPGenerateRequestPacket( pxNetworkBuffer );
+			}
 		}
 		else
 		{
 			/* The lookup indicated that an ARP request has already been
 			sent out for the queried IP address. */
 			eReturned = eCantSendPacket;
+
+			#if( ipconfigARP_PENDING_PACKETS > 0 )
+			{
+				if( xARPHoldPacket( pxNetworkBuffer, ulIPAddress ) != pdFAIL )
+				{
+					xPacketHeld = pdTRUE;
+				}
+			}
+			#endif /* ipconfigARP_PENDING_PACKETS */
 		}
 	}
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	if( xPacketHeld != pdFALSE )
+	{
+		/* The buffer is owned by the ARP module now. */
+	}
+	else
+#endif /* ipconfigARP_PENDING_PACKETS */
 	if( eReturned != eCantSendPacket )
 	{
 		/* The network driver is responsible for freeing the network buffer
@@ -225,7 +301,7 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 		}
 		#endif
 
-		xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
 	}
 	else
 	{
@@ -236,6 +312,68 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+
+	static void prvUDPStoreTemplate( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	IPUDPSocket_t *pxUDP;
+	uint32_t ulGeneration = ulARPCacheGeneration;
+
+		/* Sockets are only closed by the IP-task, so the socket found here
+		can not disappear while the template is written. */
+		pxSocket = pxUDPSocketLookup( ( UBaseType_t ) pxNetworkBuffer->usBoundPort );
+
+		if( pxSocket != NULL )
+		{
+			pxUDP = &( pxSocket->u.xUDP );
+
+			/* Packets to a looped-back address are sent to the own IP address,
+			they do not match the peer and will always take the slow path. */
+			if( ( pxUDP->ulPeerIPAddress == pxNetworkBuffer->ulIPAddress ) &&
+				( pxUDP->usPeerPort == pxNetworkBuffer->usPort ) &&
+				( pxUDP->ulTemplateGeneration != ulGeneration ) )
+			{
+				/* FreeRTOS_sendto() may be reading the template in the mean
+				time.  It checks the generation before and after copying it,
+				and will see zero or a new number if it was changed. */
+				pxUDP->ulTemplateGeneration = 0UL;
+				memcpy( pxUDP->ucHeaderTemplate, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxUDP->ucHeaderTemplate ) );
+				pxUDP->ulTemplateGeneration = ulGeneration;
+			}
+		}
+	}
+
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUDP_CONNECTED_SOCKETS != 0 )
+
+	void vProcessPrebuiltUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+		iptraceSENDING_UDP_PACKET( pxNetworkBuffer->ulIPAddress );
+
+		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+		{
+			if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+			{
+			BaseType_t xIndex;
+
+				for( xIndex = ( BaseType_t ) pxNetworkBuffer->xDataLength; xIndex < ( BaseType_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES; xIndex++ )
+				{
+					pxNetworkBuffer->pucEthernetBuffer[ xIndex ] = 0u;
+				}
+				pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
+			}
+		}
+		#endif
+
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
+	}
+
+#endif /* ipconfigUDP_CONNECTED_SOCKETS */
+/*-----------------------------------------------------------*/
+
 BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort )
 {
 BaseType_t xReturn = pdPASS;
@@ -318,6 +456,7 @@ UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
 			{
 				if( ( pxSocket->pxSocketSet != NULL ) && ( ( pxSocket->xSelectBits & eSELECT_READ ) != 0 ) )
 				{
+					vSocketSelectReady( pxSocket );
 					xEventGroupSetBits( pxSocket->pxSocketSet->xSelectGroup, eSELECT_READ );
 				}
 			}
@@ -358,6 +497,17 @@ UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
 			else
 		#endif /* ipconfigUSE_LLMNR */
 
+		#if( ( ipconfigUSE_DNS == 1 ) && ( ( ipconfigDNS_USE_CALLBACKS != 0 ) || ( ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_PREFETCH != 0 ) ) ) )
+			/* A reply from the DNS server to an asynchronous look-up or a
+			cache refresh, whose socket has been closed already. */
+			if( ( pxUDPPacket->xUDPHeader.usSourcePort == FreeRTOS_ntohs( ipDNS_PORT ) ) &&
+				( pxUDPPacket->xIPHeader.ulSourceIPAddress == xNetworkAddressing.ulDNSServerAddress ) )
+			{
+				xReturn = ( BaseType_t )ulDNSHandlePacket( pxNetworkBuffer );
+			}
+			else
+		#endif /* ipconfigDNS_USE_CALLBACKS || ipconfigDNS_CACHE_PREFETCH */
+
 		#if( ipconfigUSE_NBNS == 1 )
 			/* a NetBIOS request, check for the destination port */
 			if( ( usPort == FreeRTOS_ntohs( ipNBNS_PORT ) ) ||
@@ -281,6 +281,19 @@ UBaseType_t uxCount;
 				}
 				#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 
+				#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+				{
+					/* A normal frame, not a TCP super-segment. */
+					pxReturn->usLargeSendMSS = 0u;
+				}
+				#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
+				#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+				{
+					pxReturn->ucTxClass = ( uint8_t ) ipconfigTX_DEFAULT_CLASS;
+				}
+				#endif /* ipconfigTX_PRIORITY_CLASSES */
+
 				if( xTCPWindowLoggingLevel > 3 )
 				{
 					FreeRTOS_debug_printf( ( "BUF_GET[%ld]: %p (%p)\n",
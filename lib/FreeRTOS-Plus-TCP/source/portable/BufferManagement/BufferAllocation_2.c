@@ -91,6 +91,272 @@ const BaseType_t xBufferAllocFixedSize = pdFALSE;
 /* The semaphore used to obtain network buffers. */
 static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
 
+#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+
+	/* The number of free descriptors that an ISR must leave for the tasks, as
+	in BufferAllocation_1.c. */
+	#define baINTERRUPT_BUFFER_GET_THRESHOLD	( 3 )
+
+	/* A slab holds ipBUFFER_PADDING bytes, followed by the usable space.  The
+	stride is rounded up to portBYTE_ALIGNMENT, so that every slab is aligned
+	like a block returned by pvPortMalloc(). */
+	#define baSLAB_STRIDE( xSize )	\
+		( ( ( xSize ) + ipBUFFER_PADDING + ( portBYTE_ALIGNMENT - 1u ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+	#define baREGION_SIZE	\
+		( ( ipconfigNETWORK_BUFFER_SMALL_COUNT * baSLAB_STRIDE( ipconfigNETWORK_BUFFER_SMALL_SIZE ) ) + \
+		  ( ipconfigNETWORK_BUFFER_MEDIUM_COUNT * baSLAB_STRIDE( ipconfigNETWORK_BUFFER_MEDIUM_SIZE ) ) + \
+		  ( ipconfigNETWORK_BUFFER_LARGE_COUNT * baSLAB_STRIDE( ipconfigNETWORK_BUFFER_LARGE_SIZE ) ) )
+
+	/* A pool of equally sized slabs.  A free slab has a pointer to the next
+	free slab stored in its first bytes, which is the space that holds the
+	pointer to the network descriptor while the slab is in use. */
+	typedef struct xNETWORK_BUFFER_CLASS
+	{
+		uint8_t *pucFirst;			/* The first slab of this class. */
+		uint8_t *pucLast;			/* Just beyond the last slab. */
+		uint8_t *pucFreeList;		/* The first free slab, or NULL. */
+		size_t uxSize;				/* The usable space of a slab. */
+		size_t uxStride;			/* The distance between two slabs. */
+		UBaseType_t uxFree;			/* The number of slabs in pucFreeList. */
+		UBaseType_t uxMinimumFree;	/* The lowest value of uxFree. */
+	} NetworkBufferClass_t;
+
+	static NetworkBufferClass_t xBufferClasses[ ipNETWORK_BUFFER_CLASS_COUNT ];
+
+	/* The dedicated region from which the slabs are carved.  It is aligned at
+	start-up, hence the extra portBYTE_ALIGNMENT bytes. */
+	static uint8_t ucBufferClassRegion[ baREGION_SIZE + portBYTE_ALIGNMENT ];
+
+	/*
+	 * Divide ucBufferClassRegion into slabs and put them in the free lists.
+	 */
+	static void prvBufferClassesInitialise( void );
+
+	/*
+	 * Take a slab from the smallest class that has one free and that can hold
+	 * 'xSize' bytes.  Must be called from within a critical section.
+	 * Returns NULL if all suitable classes are exhausted.
+	 */
+	static uint8_t *prvBufferClassTake( size_t xSize );
+
+	/*
+	 * Return the class that 'pucSlab' belongs to, or NULL if it doesn't belong
+	 * to the dedicated region (i.e. it was obtained from the heap).
+	 */
+	static NetworkBufferClass_t *prvBufferClassOf( const uint8_t *pucSlab );
+
+	/*
+	 * Put a slab back in the free list of its class.  Must be called from
+	 * within a critical section.
+	 */
+	static void prvBufferClassGive( NetworkBufferClass_t *pxClass, uint8_t *pucSlab );
+
+#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+
+/*
+ * Obtain storage for 'xSize' bytes plus ipBUFFER_PADDING, either from the
+ * size classes or from the heap.  The returned pointer points to the start of
+ * the padding.
+ */
+static uint8_t *prvBufferStorageAllocate( size_t xSize );
+
+/*
+ * Release storage obtained with prvBufferStorageAllocate().
+ */
+static void prvBufferStorageFree( uint8_t *pucStorage );
+
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+
+	static void prvBufferClassesInitialise( void )
+	{
+	const size_t uxSizes[ ipNETWORK_BUFFER_CLASS_COUNT ] =
+	{
+		ipconfigNETWORK_BUFFER_SMALL_SIZE,
+		ipconfigNETWORK_BUFFER_MEDIUM_SIZE,
+		ipconfigNETWORK_BUFFER_LARGE_SIZE
+	};
+	const UBaseType_t uxCounts[ ipNETWORK_BUFFER_CLASS_COUNT ] =
+	{
+		ipconfigNETWORK_BUFFER_SMALL_COUNT,
+		ipconfigNETWORK_BUFFER_MEDIUM_COUNT,
+		ipconfigNETWORK_BUFFER_LARGE_COUNT
+	};
+	uint8_t *pucSlab;
+	NetworkBufferClass_t *pxClass;
+	UBaseType_t uxClass, uxIndex;
+
+		/* Align the start of the region. */
+		pucSlab = ucBufferClassRegion;
+		if( ( ( ( size_t ) pucSlab ) & portBYTE_ALIGNMENT_MASK ) != 0u )
+		{
+			pucSlab += portBYTE_ALIGNMENT - ( ( ( size_t ) pucSlab ) & portBYTE_ALIGNMENT_MASK );
+		}
+
+		for( uxClass = 0u; uxClass < ipNETWORK_BUFFER_CLASS_COUNT; uxClass++ )
+		{
+			pxClass = &( xBufferClasses[ uxClass ] );
+			pxClass->uxSize = uxSizes[ uxClass ];
+			pxClass->uxStride = baSLAB_STRIDE( uxSizes[ uxClass ] );
+			pxClass->pucFirst = pucSlab;
+			pxClass->pucFreeList = NULL;
+			pxClass->uxFree = 0u;
+
+			for( uxIndex = 0u; uxIndex < uxCounts[ uxClass ]; uxIndex++ )
+			{
+				prvBufferClassGive( pxClass, pucSlab );
+				pucSlab += pxClass->uxStride;
+			}
+
+			pxClass->pucLast = pucSlab;
+			pxClass->uxMinimumFree = pxClass->uxFree;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint8_t *prvBufferClassTake( size_t xSize )
+	{
+	uint8_t *pucReturn = NULL;
+	NetworkBufferClass_t *pxClass;
+	UBaseType_t uxClass;
+
+		for( uxClass = 0u; uxClass < ipNETWORK_BUFFER_CLASS_COUNT; uxClass++ )
+		{
+			pxClass = &( xBufferClasses[ uxClass ] );
+
+			if( ( xSize <= pxClass->uxSize ) && ( pxClass->pucFreeList != NULL ) )
+			{
+				pucReturn = pxClass->pucFreeList;
+				pxClass->pucFreeList = *( ( uint8_t ** ) pucReturn );
+				pxClass->uxFree--;
+
+				if( pxClass->uxMinimumFree > pxClass->uxFree )
+				{
+					pxClass->uxMinimumFree = pxClass->uxFree;
+				}
+				break;
+			}
+		}
+
+		return pucReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static NetworkBufferClass_t *prvBufferClassOf( const uint8_t *pucSlab )
+	{
+	NetworkBufferClass_t *pxReturn = NULL;
+	UBaseType_t uxClass;
+
+		for( uxClass = 0u; uxClass < ipNETWORK_BUFFER_CLASS_COUNT; uxClass++ )
+		{
+			if( ( pucSlab >= xBufferClasses[ uxClass ].pucFirst ) && ( pucSlab < xBufferClasses[ uxClass ].pucLast ) )
+			{
+				pxReturn = &( xBufferClasses[ uxClass ] );
+				break;
+			}
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvBufferClassGive( NetworkBufferClass_t *pxClass, uint8_t *pucSlab )
+	{
+		/* A slab must be returned at its start. */
+		configASSERT( ( ( size_t ) ( pucSlab - pxClass->pucFirst ) % pxClass->uxStride ) == 0u );
+
+		*( ( uint8_t ** ) pucSlab ) = pxClass->pucFreeList;
+		pxClass->pucFreeList = pucSlab;
+		pxClass->uxFree++;
+	}
+	/*-----------------------------------------------------------*/
+
+	UBaseType_t uxGetNumberOfFreeNetworkBuffersOfClass( UBaseType_t uxClass )
+	{
+	UBaseType_t uxReturn = 0u;
+
+		if( uxClass < ipNETWORK_BUFFER_CLASS_COUNT )
+		{
+			uxReturn = xBufferClasses[ uxClass ].uxFree;
+		}
+
+		return uxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	UBaseType_t uxGetMinimumFreeNetworkBuffersOfClass( UBaseType_t uxClass )
+	{
+	UBaseType_t uxReturn = 0u;
+
+		if( uxClass < ipNETWORK_BUFFER_CLASS_COUNT )
+		{
+			uxReturn = xBufferClasses[ uxClass ].uxMinimumFree;
+		}
+
+		return uxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+
+static uint8_t *prvBufferStorageAllocate( size_t xSize )
+{
+uint8_t *pucReturn;
+
+	#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+	{
+		taskENTER_CRITICAL();
+		{
+			pucReturn = prvBufferClassTake( xSize );
+		}
+		taskEXIT_CRITICAL();
+
+		#if( ipconfigNETWORK_BUFFER_HEAP_FALLBACK != 0 )
+		{
+			if( pucReturn == NULL )
+			{
+				pucReturn = ( uint8_t * ) pvPortMallocWithCaps( xSize + ipBUFFER_PADDING, heapCAPS_DMA );
+			}
+		}
+		#endif /* ipconfigNETWORK_BUFFER_HEAP_FALLBACK */
+	}
+	#else
+	{
+		pucReturn = ( uint8_t * ) pvPortMallocWithCaps( xSize + ipBUFFER_PADDING, heapCAPS_DMA );
+	}
+	#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+
+	return pucReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBufferStorageFree( uint8_t *pucStorage )
+{
+	#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+	{
+	NetworkBufferClass_t *pxClass = prvBufferClassOf( pucStorage );
+
+		if( pxClass != NULL )
+		{
+			taskENTER_CRITICAL();
+			{
+				prvBufferClassGive( pxClass, pucStorage );
+			}
+			taskEXIT_CRITICAL();
+		}
+		else
+		{
+			vPortFree( ( void * ) pucStorage );
+		}
+	}
+	#else
+	{
+		vPortFree( ( void * ) pucStorage );
+	}
+	#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+}
 /*-----------------------------------------------------------*/
 
 BaseType_t xNetworkBuffersInitialise( void )
@@ -138,6 +404,12 @@ BaseType_t xReturn, x;
 			}
 
 			uxMinimumFreeNetworkBuffers = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+
+			#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+			{
+				prvBufferClassesInitialise();
+			}
+			#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
 		}
 	}
 
@@ -177,7 +449,7 @@ size_t xSize = *pxRequestedSizeBytes;
 	/* Allocate a buffer large enough to store the requested Ethernet frame size
 	and a pointer to a network buffer structure (hence the addition of
 	ipBUFFER_PADDING bytes). */
-	pucEthernetBuffer = ( uint8_t * ) pvPortMalloc( xSize + ipBUFFER_PADDING );
+	pucEthernetBuffer = prvBufferStorageAllocate( xSize );
 	configASSERT( pucEthernetBuffer );
 
 	if( pucEthernetBuffer != NULL )
@@ -200,7 +472,7 @@ void vReleaseNetworkBuffer( uint8_t *pucEthernetBuffer )
 	if( pucEthernetBuffer != NULL )
 	{
 		pucEthernetBuffer -= ipBUFFER_PADDING;
-		vPortFree( ( void * ) pucEthernetBuffer );
+		prvBufferStorageFree( pucEthernetBuffer );
 	}
 }
 /*-----------------------------------------------------------*/
@@ -250,7 +522,7 @@ size_t uxCount;
 		{
 			/* Extra space is obtained so a pointer to the network buffer can
 			be stored at the beginning of the buffer. */
-			pxReturn->pucEthernetBuffer = ( uint8_t * ) pvPortMalloc( xRequestedSizeBytes + ipBUFFER_PADDING );
+			pxReturn->pucEthernetBuffer = prvBufferStorageAllocate( xRequestedSizeBytes );
 
 			if( pxReturn->pucEthernetBuffer == NULL )
 			{
@@ -279,6 +551,19 @@ size_t uxCount;
 					pxReturn->pxNextBuffer = NULL;
 				}
 				#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+				#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+				{
+					/* A normal frame, not a TCP super-segment. */
+					pxReturn->usLargeSendMSS = 0u;
+				}
+				#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
+				#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+				{
+					pxReturn->ucTxClass = ( uint8_t ) ipconfigTX_DEFAULT_CLASS;
+				}
+				#endif /* ipconfigTX_PRIORITY_CLASSES */
 			}
 		}
 		else
@@ -342,6 +627,133 @@ BaseType_t xListItemAlreadyInFreeList;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_NETWORK_BUFFER_CLASSES != 0 )
+
+	NetworkBufferDescriptor_t *pxNetworkBufferGetFromISR( size_t xRequestedSizeBytes )
+	{
+	NetworkBufferDescriptor_t *pxReturn = NULL;
+	uint8_t *pucSlab = NULL;
+	UBaseType_t uxSavedInterruptStatus;
+
+		/* The same adjustments as in pxGetNetworkBufferWithDescriptor(). */
+		if( xRequestedSizeBytes < ( size_t ) baMINIMAL_BUFFER_SIZE )
+		{
+			xRequestedSizeBytes = baMINIMAL_BUFFER_SIZE;
+		}
+
+		xRequestedSizeBytes += 2u;
+		if( ( xRequestedSizeBytes & ( sizeof( size_t ) - 1u ) ) != 0u )
+		{
+			xRequestedSizeBytes = ( xRequestedSizeBytes | ( sizeof( size_t ) - 1u ) ) + 1u;
+		}
+
+		/* Only take a descriptor if at least baINTERRUPT_BUFFER_GET_THRESHOLD
+		descriptors remain, so that a rapidly executing interrupt can not
+		starve the tasks. */
+		if( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xNetworkBufferSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD )
+		{
+			if( xSemaphoreTakeFromISR( xNetworkBufferSemaphore, NULL ) == pdPASS )
+			{
+				uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();
+				{
+					/* The heap may not be used from an ISR, so only the size
+					classes can provide the storage. */
+					pucSlab = prvBufferClassTake( xRequestedSizeBytes );
+
+					if( pucSlab != NULL )
+					{
+						pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+						uxListRemove( &( pxReturn->xBufferListItem ) );
+					}
+				}
+				portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+				if( pxReturn == NULL )
+				{
+					/* No storage, give back the descriptor. */
+					xSemaphoreGiveFromISR( xNetworkBufferSemaphore, NULL );
+				}
+				else
+				{
+					if( uxMinimumFreeNetworkBuffers > listCURRENT_LIST_LENGTH( &xFreeBuffersList ) )
+					{
+						uxMinimumFreeNetworkBuffers = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+					}
+
+					*( ( NetworkBufferDescriptor_t ** ) pucSlab ) = pxReturn;
+					pxReturn->pucEthernetBuffer = pucSlab + ipBUFFER_PADDING;
+					pxReturn->xDataLength = xRequestedSizeBytes;
+
+					#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+					{
+						pxReturn->pxNextBuffer = NULL;
+					}
+					#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+					#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+					{
+						pxReturn->usLargeSendMSS = 0u;
+					}
+					#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
+					#if( ipconfigTX_PRIORITY_CLASSES != 0 )
+					{
+						pxReturn->ucTxClass = ( uint8_t ) ipconfigTX_DEFAULT_CLASS;
+					}
+					#endif /* ipconfigTX_PRIORITY_CLASSES */
+
+					iptraceNETWORK_BUFFER_OBTAINED_FROM_ISR( pxReturn );
+				}
+			}
+		}
+
+		if( pxReturn == NULL )
+		{
+			iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER_FROM_ISR();
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	NetworkBufferClass_t *pxClass = NULL;
+	uint8_t *pucSlab = NULL;
+	UBaseType_t uxSavedInterruptStatus;
+
+		if( pxNetworkBuffer->pucEthernetBuffer != NULL )
+		{
+			pucSlab = pxNetworkBuffer->pucEthernetBuffer - ipBUFFER_PADDING;
+			pxClass = prvBufferClassOf( pucSlab );
+
+			/* Storage that was obtained from the heap can not be released
+			from an ISR. */
+			configASSERT( pxClass != NULL );
+		}
+
+		uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			if( pxClass != NULL )
+			{
+				prvBufferClassGive( pxClass, pucSlab );
+				pxNetworkBuffer->pucEthernetBuffer = NULL;
+			}
+
+			vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+		xSemaphoreGiveFromISR( xNetworkBufferSemaphore, &xHigherPriorityTaskWoken );
+		iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+
+		return xHigherPriorityTaskWoken;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_NETWORK_BUFFER_CLASSES */
+
 /*
  * Returns the number of free network buffers
  */
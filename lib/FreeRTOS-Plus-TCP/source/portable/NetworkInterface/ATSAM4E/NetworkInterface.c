@@ -435,7 +435,13 @@ uint32_t ulReceiveCount, ulResult, ulReturnValue = 0;
 static NetworkBufferDescriptor_t *pxNextNetworkBufferDescriptor = NULL;
 const UBaseType_t xMinDescriptorsToLeave = 2UL;
 const TickType_t xBlockTime = pdMS_TO_TICKS( 100UL );
-static IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/* All packets read in this call are passed to the IP-task in as few
+	messages as possible. */
+	NetworkRxChain_t xRxChain = { NULL, NULL, 0u };
+#else
+	static IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
 
 	for( ;; )
 	{
@@ -477,17 +483,26 @@ static IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 
 		iptraceNETWORK_INTERFACE_RECEIVE();
 		pxNextNetworkBufferDescriptor->xDataLength = ( size_t ) ulReceiveCount;
-		xRxEvent.pvData = ( void * ) pxNextNetworkBufferDescriptor;
 
-		/* Send the descriptor to the IP task for processing. */
-		if( xSendEventStructToIPTask( &xRxEvent, xBlockTime ) != pdTRUE )
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 		{
-			/* The buffer could not be sent to the stack so must be released
-			again. */
-			vReleaseNetworkBufferAndDescriptor( pxNextNetworkBufferDescriptor );
-			iptraceETHERNET_RX_EVENT_LOST();
-			FreeRTOS_printf( ( "prvEMACRxPoll: Can not queue return packet!\n" ) );
+			vNetworkRxChainAppend( &xRxChain, pxNextNetworkBufferDescriptor, xBlockTime );
+		}
+		#else
+		{
+			xRxEvent.pvData = ( void * ) pxNextNetworkBufferDescriptor;
+
+			/* Send the descriptor to the IP task for processing. */
+			if( xSendEventStructToIPTask( &xRxEvent, xBlockTime ) != pdTRUE )
+			{
+				/* The buffer could not be sent to the stack so must be released
+				again. */
+				vReleaseNetworkBufferAndDescriptor( pxNextNetworkBufferDescriptor );
+				iptraceETHERNET_RX_EVENT_LOST();
+				FreeRTOS_printf( ( "prvEMACRxPoll: Can not queue return packet!\n" ) );
+			}
 		}
+		#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 
 		/* Now the buffer has either been passed to the IP-task,
 		or it has been released in the code above. */
@@ -495,6 +510,15 @@ static IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 		ulReturnValue++;
 	}
 
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		if( xNetworkRxChainSend( &xRxChain, xBlockTime ) == pdFAIL )
+		{
+			FreeRTOS_printf( ( "prvEMACRxPoll: Can not queue return packets!\n" ) );
+		}
+	}
+	#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
 	return ulReturnValue;
 }
 /*-----------------------------------------------------------*/
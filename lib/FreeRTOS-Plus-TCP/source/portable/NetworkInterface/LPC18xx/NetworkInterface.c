@@ -661,10 +661,8 @@ eFrameProcessingResult_t eResult;
 const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( 250 );
 const UBaseType_t uxMinimumBuffersRemaining = 3UL;
 uint16_t usLength;
+uint8_t *pucBuffer;
 NetworkBufferDescriptor_t *pxDescriptor;
-#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-	NetworkBufferDescriptor_t *pxNewDescriptor;
-#endif /* ipconfigZERO_COPY_RX_DRIVER */
 #if( ipconfigUSE_LINKED_RX_MESSAGES == 0 )
 	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 #endif
@@ -694,80 +692,40 @@ NetworkBufferDescriptor_t *pxDescriptor;
 					FreeRTOS_printf( ( "prvEMACHandlerTask: PHY LS now %d (message received)\n", ( ulPHYLinkStatus & PHY_LINK_CONNECTED ) != 0 ) );
 				}
 
-			#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-				if( uxGetNumberOfFreeNetworkBuffers() > uxMinimumBuffersRemaining )
-				{
-					pxNewDescriptor = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, xDescriptorWaitTime );
-				}
-				else
-				{
-					/* Too risky to allocate a new Network Buffer. */
-					pxNewDescriptor = NULL;
-				}
-				if( pxNewDescriptor != NULL )
-			#else
-				if( uxGetNumberOfFreeNetworkBuffers() > uxMinimumBuffersRemaining )
-			#endif /* ipconfigZERO_COPY_RX_DRIVER */
-				{
-			#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-				const uint8_t *pucBuffer;
-			#endif
+				/* Get the actual length. */
+				usLength = RDES_FLMSK( ulStatus );
 
-					/* Get the actual length. */
-					usLength = RDES_FLMSK( ulStatus );
+				/* This zero-copy driver makes sure that every 'xDMARxDescriptors'
+				contains a reference to a Network Buffer at any time.  In case it
+				runs out of Network Buffers, a DMA buffer won't be replaced, and the
+				received messages is dropped.  When copying, 'B1ADD' is not
+				changed. */
+				pucBuffer = ( uint8_t * ) ( xDMARxDescriptors[ ulNextRxDescriptorToProcess ].B1ADD );
+				pxDescriptor = pxNetworkRxTakeBuffer( &pucBuffer, ( size_t ) usLength, ipTOTAL_ETHERNET_FRAME_SIZE, uxMinimumBuffersRemaining, xDescriptorWaitTime );
+				xDMARxDescriptors[ ulNextRxDescriptorToProcess ].B1ADD = ( uint32_t ) pucBuffer;
 
-					#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+				if( pxDescriptor != NULL )
+				{
+					/* It is possible that more data was copied than
+					actually makes up the frame.  If this is the case
+					adjust the length to remove any trailing bytes. */
+					prvRemoveTrailingBytes( pxDescriptor );
+
+					/* Pass the data to the TCP/IP task for processing. */
+					xRxEvent.pvData = ( void * ) pxDescriptor;
+					if( xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime ) == pdFALSE )
 					{
-						/* Replace the character buffer 'B1ADD'. */
-						pucBuffer = ( const uint8_t * const ) ( xDMARxDescriptors[ ulNextRxDescriptorToProcess ].B1ADD );
-						xDMARxDescriptors[ ulNextRxDescriptorToProcess ].B1ADD = ( uint32_t ) pxNewDescriptor->pucEthernetBuffer;
-
-						/* 'B1ADD' contained the address of a 'pucEthernetBuffer' that
-						belongs to a Network Buffer.  Find the original Network Buffer. */
-						pxDescriptor = pxPacketBuffer_to_NetworkBuffer( pucBuffer );
-						/* This zero-copy driver makes sure that every 'xDMARxDescriptors' contains
-						a reference to a Network Buffer at any time.
-						In case it runs out of Network Buffers, a DMA buffer won't be replaced,
-						and the received messages is dropped. */
-						configASSERT( pxDescriptor != NULL );
+						/* Could not send the descriptor into the TCP/IP
+						stack, it must be released. */
+						vReleaseNetworkBufferAndDescriptor( pxDescriptor );
 					}
-					#else
+					else
 					{
-						/* Create a buffer of exactly the required length. */
-						pxDescriptor = pxGetNetworkBufferWithDescriptor( usLength, xDescriptorWaitTime );
-					}
-					#endif /* ipconfigZERO_COPY_RX_DRIVER */
+						iptraceNETWORK_INTERFACE_RECEIVE();
 
-					if( pxDescriptor != NULL )
-					{
-						pxDescriptor->xDataLength = ( size_t ) usLength;
-						#if( ipconfigZERO_COPY_RX_DRIVER == 0 )
-						{
-							/* Copy the data into the allocated buffer. */
-							memcpy( ( void * ) pxDescriptor->pucEthernetBuffer, ( void * ) xDMARxDescriptors[ ulNextRxDescriptorToProcess ].B1ADD, usLength );
-						}
-						#endif /* ipconfigZERO_COPY_RX_DRIVER */
-						/* It is possible that more data was copied than
-						actually makes up the frame.  If this is the case
-						adjust the length to remove any trailing bytes. */
-						prvRemoveTrailingBytes( pxDescriptor );
-
-						/* Pass the data to the TCP/IP task for processing. */
-						xRxEvent.pvData = ( void * ) pxDescriptor;
-						if( xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime ) == pdFALSE )
-						{
-							/* Could not send the descriptor into the TCP/IP
-							stack, it must be released. */
-							vReleaseNetworkBufferAndDescriptor( pxDescriptor );
-						}
-						else
-						{
-							iptraceNETWORK_INTERFACE_RECEIVE();
-
-							/* The data that was available at the top of this
-							loop has been sent, so is no longer available. */
-							ulDataAvailable = pdFALSE;
-						}
+						/* The data that was available at the top of this
+						loop has been sent, so is no longer available. */
+						ulDataAvailable = pdFALSE;
 					}
 				}
 			}
@@ -184,6 +184,24 @@ expansion. */
 	#endif
 #endif /* ipconfigETHERNET_AN_ENABLE == 0 */
 
+/*
+ * Adaptive interrupt moderation.  When a single sweep of the DMA ring finds at
+ * least this many packets, the RX interrupt is disabled and the ring is polled
+ * by prvEMACHandlerTask() every ipconfigETHERNET_RX_POLL_TICKS clock ticks,
+ * until a poll finds the ring empty.  The interrupt is then enabled again.
+ * Under a flood the CPU time taken by reception is bounded, and other tasks
+ * keep running.  While moderation is enabled, a sweep takes at most ETH_RXBUFNB
+ * packets, so the threshold should not be larger than that.  Zero disables the
+ * moderation.
+ */
+#if !defined( ipconfigETHERNET_RX_POLL_THRESHOLD )
+	#define ipconfigETHERNET_RX_POLL_THRESHOLD		0
+#endif
+
+#if !defined( ipconfigETHERNET_RX_POLL_TICKS )
+	#define ipconfigETHERNET_RX_POLL_TICKS			1
+#endif
+
 /* Default the size of the stack used by the EMAC deferred handler task to twice
 the size of the stack used by the idle task - but allow this to be overridden in
 FreeRTOSConfig.h as configMINIMAL_STACK_SIZE is a user definable constant. */
@@ -208,6 +226,12 @@ static void prvEthernetUpdateConfig( BaseType_t xForce );
  */
 static BaseType_t prvNetworkInterfaceInput( void );
 
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/* Packets received by prvNetworkInterfaceInput() are collected here, and
+	passed to the IP-task in a single message when the DMA ring is empty. */
+	static NetworkRxChain_t xRxChain;
+#endif
+
 #if( ipconfigUSE_LLMNR != 0 )
 	/*
 	 * For LLMNR, an extra MAC-address must be configured to
@@ -237,6 +261,14 @@ static void prvDMARxDescListInit( void );
 	static void vClearTXBuffers( void );
 #endif /* ipconfigZERO_COPY_TX_DRIVER */
 
+#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
+	/*
+	 * Switch between interrupt and polled reception, depending on the number
+	 * of packets found in the last sweep of the DMA ring.
+	 */
+	static void prvRxModerate( BaseType_t xPacketCount );
+#endif /* ipconfigETHERNET_RX_POLL_THRESHOLD */
+
 /*-----------------------------------------------------------*/
 
 typedef struct _PhyProperties_t
@@ -255,6 +287,18 @@ static volatile uint32_t ulISREvents;
 /* A copy of PHY register 1: 'PHY_REG_01_BMSR' */
 static uint32_t ulPHYLinkStatus = 0;
 
+#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
+	/* Set while the RX interrupt is disabled and the ring is polled. */
+	static BaseType_t xRxPolling = pdFALSE;
+
+	/* Reception counters, for inspection by the application or a debugger.
+	ulEMACRxInterrupts / ulEMACRxPackets gives the interrupts per packet. */
+	volatile uint32_t ulEMACRxInterrupts;	/* RX-complete interrupts. */
+	uint32_t ulEMACRxPackets;				/* Packets taken from the ring. */
+	uint32_t ulEMACRxPolls;					/* Sweeps done in polled mode. */
+	uint32_t ulEMACRxPollModeEntries;		/* Switches to polled mode. */
+#endif /* ipconfigETHERNET_RX_POLL_THRESHOLD */
+
 #if( ipconfigUSE_LLMNR == 1 )
 	static const uint8_t xLLMNR_MACAddress[] = { 0x01, 0x00, 0x5E, 0x00, 0x00, 0xFC };
 #endif
@@ -343,12 +387,17 @@ const PhyProperties_t xPHYProperties =
 
 /*-----------------------------------------------------------*/
 
-void HAL_ETH_RxCpltCallback( ETH_HandleTypeDef *heth )
+portHOT_FUNCTION void HAL_ETH_RxCpltCallback( ETH_HandleTypeDef *heth )
 {
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
 	/* Ethernet RX-Complete callback function, elsewhere declared as weak. */
     ulISREvents |= EMAC_IF_RX_EVENT;
+	#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
+	{
+		ulEMACRxInterrupts++;
+	}
+	#endif
 	/* Wakeup the prvEMACHandlerTask. */
 	if( xEMACTaskHandle != NULL )
 	{
@@ -359,7 +408,7 @@ BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 /*-----------------------------------------------------------*/
 
 #if( ipconfigZERO_COPY_TX_DRIVER != 0 )
-	void HAL_ETH_TxCpltCallback( ETH_HandleTypeDef *heth )
+	portHOT_FUNCTION void HAL_ETH_TxCpltCallback( ETH_HandleTypeDef *heth )
 	{
 	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
@@ -827,10 +876,11 @@ const ProtocolPacket_t *pxProtPacket = ( const ProtocolPacket_t * )pcBuffer;
 static BaseType_t prvNetworkInterfaceInput( void )
 {
 NetworkBufferDescriptor_t *pxCurDescriptor;
-NetworkBufferDescriptor_t *pxNewDescriptor = NULL;
 BaseType_t xReceivedLength, xAccepted;
 __IO ETH_DMADescTypeDef *pxDMARxDescriptor;
-xIPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#if( ipconfigUSE_LINKED_RX_MESSAGES == 0 )
+	xIPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
 const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( 250 );
 uint8_t *pucBuffer;
 
@@ -872,69 +922,51 @@ uint8_t *pucBuffer;
 
 		if( xAccepted != pdFALSE )
 		{
-			/* The packet wil be accepted, but check first if a new Network Buffer can
-			be obtained. If not, the packet will still be dropped. */
-			pxNewDescriptor = pxGetNetworkBufferWithDescriptor( ETH_RX_BUF_SIZE, xDescriptorWaitTime );
+			/* The packet wil be accepted, but check first if a Network Buffer can
+			be obtained. If not, the packet will still be dropped.  In zero-copy
+			mode, pucBuffer is replaced by the buffer for the next packet. */
+			pxCurDescriptor = pxNetworkRxTakeBuffer( &pucBuffer, ( size_t ) xReceivedLength, ETH_RX_BUF_SIZE, 0u, xDescriptorWaitTime );
 
-			if( pxNewDescriptor == NULL )
+			if( pxCurDescriptor == NULL )
 			{
 				/* A new descriptor can not be allocated now. This packet will be dropped. */
 				xAccepted = pdFALSE;
 			}
 		}
-		#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-		{
-			/* Find out which Network Buffer was originally passed to the descriptor. */
-			pxCurDescriptor = pxPacketBuffer_to_NetworkBuffer( pucBuffer );
-			configASSERT( pxCurDescriptor != NULL );
-		}
-		#else
-		{
-			/* In this mode, the two descriptors are the same. */
-			pxCurDescriptor = pxNewDescriptor;
-			if( pxNewDescriptor != NULL )
-			{
-				/* The packet is acepted and a new Network Buffer was created,
-				copy data to the Network Bufffer. */
-				memcpy( pxNewDescriptor->pucEthernetBuffer, pucBuffer, xReceivedLength );
-			}
-		}
-		#endif
 
 		if( xAccepted != pdFALSE )
 		{
-			pxCurDescriptor->xDataLength = xReceivedLength;
-			xRxEvent.pvData = ( void * ) pxCurDescriptor;
-
-			/* Pass the data to the TCP/IP task for processing. */
-			if( xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime ) == pdFALSE )
-			{
-				/* Could not send the descriptor into the TCP/IP stack, it
-				must be released. */
-				vReleaseNetworkBufferAndDescriptor( pxCurDescriptor );
-				iptraceETHERNET_RX_EVENT_LOST();
-			}
-			else
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 			{
+				/* The chain will be passed to the TCP/IP task when it is full
+				or when there are no more packets. */
 				iptraceNETWORK_INTERFACE_RECEIVE();
+				vNetworkRxChainAppend( &xRxChain, pxCurDescriptor, xDescriptorWaitTime );
 			}
-		}
-
-		/* Release descriptors to DMA */
-		#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-		{
-			/* Set Buffer1 address pointer */
-			if( pxNewDescriptor != NULL )
-			{
-				pxDMARxDescriptor->Buffer1Addr = (uint32_t)pxNewDescriptor->pucEthernetBuffer;
-			}
-			else
+			#else
 			{
-				/* The packet was dropped and the same Network
-				Buffer will be used to receive a new packet. */
+				xRxEvent.pvData = ( void * ) pxCurDescriptor;
+
+				/* Pass the data to the TCP/IP task for processing. */
+				if( xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime ) == pdFALSE )
+				{
+					/* Could not send the descriptor into the TCP/IP stack, it
+					must be released. */
+					vReleaseNetworkBufferAndDescriptor( pxCurDescriptor );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+				else
+				{
+					iptraceNETWORK_INTERFACE_RECEIVE();
+				}
 			}
+			#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 		}
-		#endif /* ipconfigZERO_COPY_RX_DRIVER */
+
+		/* Release descriptors to DMA.  Set Buffer1 address pointer: when the
+		packet was dropped, or when copying, the same buffer will be used to
+		receive a new packet. */
+		pxDMARxDescriptor->Buffer1Addr = ( uint32_t ) pucBuffer;
 
 		/* Set Buffer1 size and Second Address Chained bit */
 		pxDMARxDescriptor->ControlBufferSize = ETH_DMARXDESC_RCH | (uint32_t)ETH_RX_BUF_SIZE;  
@@ -1346,23 +1378,57 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 		}
 		#endif /* ipconfigCHECK_IP_QUEUE_SPACE */
 
+		#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
+		if( xRxPolling != pdFALSE )
+		{
+			/* The RX interrupt is disabled.  Leave the CPU to other tasks for
+			a while, TX events may still wake up this task earlier. */
+			ulTaskNotifyTake( pdFALSE, ( TickType_t ) ipconfigETHERNET_RX_POLL_TICKS );
+			ulEMACRxPolls++;
+		}
+		else
+		#endif /* ipconfigETHERNET_RX_POLL_THRESHOLD */
 		if( ( ulISREvents & EMAC_IF_ALL_EVENT ) == 0 )
 		{
 			/* No events to process now, wait for the next. */
 			ulTaskNotifyTake( pdFALSE, ulMaxBlockTime );
 		}
 
+		#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
+		if( ( ( ulISREvents & EMAC_IF_RX_EVENT ) != 0 ) || ( xRxPolling != pdFALSE ) )
+		#else
 		if( ( ulISREvents & EMAC_IF_RX_EVENT ) != 0 )
+		#endif
 		{
 			ulISREvents &= ~EMAC_IF_RX_EVENT;
 
-			xResult = prvNetworkInterfaceInput();
-			if( xResult > 0 )
+			#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
 			{
-			  	while( prvNetworkInterfaceInput() > 0 )
+				/* Take at most one ring's worth of packets per sweep, so that
+				a flood can not keep this task busy for ever. */
+				while( ( xResult < ( BaseType_t ) ETH_RXBUFNB ) && ( prvNetworkInterfaceInput() > 0 ) )
 				{
+					xResult++;
 				}
+
+				prvRxModerate( xResult );
+			}
+			#else
+			{
+				/* Empty the DMA ring, counting the packets. */
+				while( prvNetworkInterfaceInput() > 0 )
+				{
+					xResult++;
+				}
+			}
+			#endif /* ipconfigETHERNET_RX_POLL_THRESHOLD */
+
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* Pass the remaining packets to the TCP/IP task. */
+				( void ) xNetworkRxChainSend( &xRxChain, pdMS_TO_TICKS( 250 ) );
 			}
+			#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 		}
 
 		if( ( ulISREvents & EMAC_IF_TX_EVENT ) != 0 )
@@ -1415,7 +1481,49 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 }
 /*-----------------------------------------------------------*/
 
-void ETH_IRQHandler( void )
+#if( ipconfigETHERNET_RX_POLL_THRESHOLD != 0 )
+
+	static void prvRxModerate( BaseType_t xPacketCount )
+	{
+		ulEMACRxPackets += ( uint32_t ) xPacketCount;
+
+		if( xRxPolling == pdFALSE )
+		{
+			if( xPacketCount >= ( BaseType_t ) ipconfigETHERNET_RX_POLL_THRESHOLD )
+			{
+				/* High load: stop taking an interrupt for every packet, the
+				ring will be polled from now on. */
+				__HAL_ETH_DMA_DISABLE_IT( &xETH, ETH_DMA_IT_R );
+				xRxPolling = pdTRUE;
+				ulEMACRxPollModeEntries++;
+			}
+		}
+		else if( xPacketCount == 0 )
+		{
+			/* The ring has been drained.  Clear the receive status, which was
+			set by every packet received while polling, before enabling the
+			interrupt, so that only new packets will cause one. */
+			__HAL_ETH_DMA_CLEAR_IT( &xETH, ETH_DMA_IT_R );
+			__HAL_ETH_DMA_ENABLE_IT( &xETH, ETH_DMA_IT_R );
+			xRxPolling = pdFALSE;
+
+			/* A packet that completed just before the status was cleared
+			would not be announced, look at the ring once more. */
+			while( prvNetworkInterfaceInput() > 0 )
+			{
+				ulEMACRxPackets++;
+			}
+		}
+		else
+		{
+			/* Still busy, keep polling. */
+		}
+	}
+
+#endif /* ipconfigETHERNET_RX_POLL_THRESHOLD */
+/*-----------------------------------------------------------*/
+
+portHOT_FUNCTION void ETH_IRQHandler( void )
 {
 	HAL_ETH_IRQHandler( &xETH );
 }
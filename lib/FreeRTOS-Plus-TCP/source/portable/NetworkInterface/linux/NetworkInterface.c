@@ -0,0 +1,599 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * A network interface for the POSIX (Linux) simulator port.  Frames are
+ * exchanged with the host through a tap device, or through a raw packet
+ * socket that is bound to an existing host interface when
+ * configLINUX_NETWORK_USE_RAW_SOCKET is set to 1.  The tap device is the
+ * easiest to set up without touching the host network, for example:
+ *
+ *    sudo ip tuntap add dev tap0 mode tap user $USER
+ *    sudo ip addr add 192.168.2.1/24 dev tap0
+ *    sudo ip link set tap0 up
+ *
+ * As in the WinPCap interface, host threads that are outside of the control of
+ * the FreeRTOS simulator do the blocking reads and writes.  Received frames are
+ * passed to a FreeRTOS task through a thread safe circular buffer, and a
+ * simulated interrupt wakes the task, so no polling is involved.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* Thread-safe circular buffers are being used to pass data to and from the
+host threads. */
+#include "FreeRTOS_Stream_Buffer.h"
+
+/* The name of the tap device, or of the host interface the raw socket is
+bound to. */
+#ifndef configLINUX_NETWORK_INTERFACE
+	#define configLINUX_NETWORK_INTERFACE		"tap0"
+#endif
+
+/* Set to 1 to use a raw packet socket on an existing host interface instead
+of a tap device.  This requires the CAP_NET_RAW capability. */
+#ifndef configLINUX_NETWORK_USE_RAW_SOCKET
+	#define configLINUX_NETWORK_USE_RAW_SOCKET	0
+#endif
+
+/* The simulated interrupt raised when a frame was received.  Interrupts 0 and
+1 are used by the kernel itself. */
+#ifndef configLINUX_MAC_INTERRUPT_NUMBER
+	#define configLINUX_MAC_INTERRUPT_NUMBER	( 2UL )
+#endif
+
+/* The priority of the task that passes received frames to the IP-task. */
+#ifndef configMAC_ISR_SIMULATOR_PRIORITY
+	#define configMAC_ISR_SIMULATOR_PRIORITY	( configMAX_PRIORITIES - 1 )
+#endif
+
+/* Sizes of the thread safe circular buffers used to pass data to and from the
+host threads. */
+#define xSEND_BUFFER_SIZE  32768
+#define xRECV_BUFFER_SIZE  32768
+
+/* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
+driver will filter incoming packets and only pass the stack those packets it
+considers need processing. */
+#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Host threads that are outside of the control of the FreeRTOS simulator are
+ * used to read and write the file descriptor of the interface.
+ */
+static void *prvLinuxRecvThread( void *pvParam );
+static void *prvLinuxSendThread( void *pvParam );
+
+/*
+ * Open the tap device, or the raw socket, named by
+ * configLINUX_NETWORK_INTERFACE.  Returns the file descriptor, or -1.
+ */
+static int prvOpenInterface( const char *pcName );
+
+/*
+ * Create a host thread with all signals blocked, so it never receives the
+ * signals that simulate the interrupts of the FreeRTOS port.
+ */
+static BaseType_t prvCreateHostThread( void *( *pxFunction )( void * ) );
+
+/*
+ * The simulated interrupt raised by prvLinuxRecvThread(), wakes
+ * prvInterruptSimulatorTask().
+ */
+static uint32_t prvRxInterruptHandler( void );
+
+/*
+ * A task that passes the frames received by prvLinuxRecvThread() to the IP
+ * task.
+ */
+static void prvInterruptSimulatorTask( void *pvParameters );
+
+/*
+ * Create the buffers that are used to pass data between the FreeRTOS simulator
+ * and the host threads.
+ */
+static void prvCreateThreadSafeBuffers( void );
+
+/*-----------------------------------------------------------*/
+
+/* The file descriptor of the tap device or raw socket. */
+static int iInterfaceDescriptor = -1;
+
+/* Circular buffers used by the host threads.  Every buffer has one writer and
+one reader, the mutexes make the updates visible to the other thread. */
+static StreamBuffer_t *xSendBuffer = NULL;
+static StreamBuffer_t *xRecvBuffer = NULL;
+static pthread_mutex_t xSendBufferMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t xRecvBufferMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Used to wake up the host thread that sends data. */
+static sem_t xSendSemaphore;
+
+/* The task that runs prvInterruptSimulatorTask(). */
+static TaskHandle_t xRxTaskHandle = NULL;
+
+/* Logs the number of failures, for viewing in the debugger only. */
+static volatile uint32_t ulLinuxSendFailures = 0;
+static volatile uint32_t ulLinuxRecvDrops = 0;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+BaseType_t xReturn = pdPASS;
+
+	if( iInterfaceDescriptor < 0 )
+	{
+		iInterfaceDescriptor = prvOpenInterface( configLINUX_NETWORK_INTERFACE );
+
+		if( iInterfaceDescriptor < 0 )
+		{
+			xReturn = pdFAIL;
+		}
+		else
+		{
+			prvCreateThreadSafeBuffers();
+			sem_init( &xSendSemaphore, 0, 0 );
+
+			/* Create a task that simulates an interrupt in a real system.  It
+			blocks until the Rx thread raises the simulated interrupt, then
+			sends a message to the IP task for every frame received. */
+			xTaskCreate( prvInterruptSimulatorTask, "MAC_ISR", configMINIMAL_STACK_SIZE, NULL, configMAC_ISR_SIMULATOR_PRIORITY, &xRxTaskHandle );
+			vPortSetInterruptHandler( configLINUX_MAC_INTERRUPT_NUMBER, prvRxInterruptHandler );
+
+			if( ( prvCreateHostThread( prvLinuxRecvThread ) != pdPASS ) ||
+				( prvCreateHostThread( prvLinuxSendThread ) != pdPASS ) )
+			{
+				FreeRTOS_printf( ( "Failed to create the network interface threads\r\n" ) );
+				xReturn = pdFAIL;
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static int prvOpenInterface( const char *pcName )
+{
+int iDescriptor;
+struct ifreq xRequest;
+
+	memset( &xRequest, 0, sizeof( xRequest ) );
+	strncpy( xRequest.ifr_name, pcName, IFNAMSIZ - 1 );
+
+	/* The host calls can not be preempted by the FreeRTOS scheduler while it
+	is suspended, see the comments at the top of port.c. */
+	vTaskSuspendAll();
+	{
+		#if( configLINUX_NETWORK_USE_RAW_SOCKET == 0 )
+		{
+			iDescriptor = open( "/dev/net/tun", O_RDWR );
+
+			if( iDescriptor >= 0 )
+			{
+				/* A tap device without the extra packet information header, so
+				every read and write is exactly one Ethernet frame. */
+				xRequest.ifr_flags = IFF_TAP | IFF_NO_PI;
+
+				if( ioctl( iDescriptor, TUNSETIFF, &xRequest ) < 0 )
+				{
+					close( iDescriptor );
+					iDescriptor = -1;
+				}
+			}
+		}
+		#else
+		{
+		struct sockaddr_ll xAddress;
+
+			iDescriptor = socket( AF_PACKET, SOCK_RAW, htons( ETH_P_ALL ) );
+
+			if( iDescriptor >= 0 )
+			{
+				memset( &xAddress, 0, sizeof( xAddress ) );
+				xAddress.sll_family = AF_PACKET;
+				xAddress.sll_protocol = htons( ETH_P_ALL );
+				xAddress.sll_ifindex = ( int ) if_nametoindex( pcName );
+
+				if( ( xAddress.sll_ifindex == 0 ) ||
+					( bind( iDescriptor, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) ) < 0 ) )
+				{
+					close( iDescriptor );
+					iDescriptor = -1;
+				}
+			}
+		}
+		#endif /* configLINUX_NETWORK_USE_RAW_SOCKET */
+	}
+	( void ) xTaskResumeAll();
+
+	if( iDescriptor < 0 )
+	{
+		FreeRTOS_printf( ( "Failed to open the network interface %s, errno %d\r\n", pcName, errno ) );
+	}
+	else
+	{
+		FreeRTOS_printf( ( "Opened the network interface %s\r\n", pcName ) );
+	}
+
+	return iDescriptor;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCreateHostThread( void *( *pxFunction )( void * ) )
+{
+pthread_t xThread;
+sigset_t xAllSignals, xPreviousSignals;
+BaseType_t xReturn = pdPASS;
+
+	/* The new thread inherits the signal mask of this thread. */
+	sigfillset( &xAllSignals );
+
+	vTaskSuspendAll();
+	{
+		pthread_sigmask( SIG_SETMASK, &xAllSignals, &xPreviousSignals );
+
+		if( pthread_create( &xThread, NULL, pxFunction, NULL ) != 0 )
+		{
+			xReturn = pdFAIL;
+		}
+		else
+		{
+			pthread_detach( xThread );
+		}
+
+		pthread_sigmask( SIG_SETMASK, &xPreviousSignals, NULL );
+	}
+	( void ) xTaskResumeAll();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCreateThreadSafeBuffers( void )
+{
+	/* The buffer used to pass data to be transmitted from a FreeRTOS task to
+	the host thread that writes the frames. */
+	if( xSendBuffer == NULL)
+	{
+		xSendBuffer = ( StreamBuffer_t * ) pvPortMalloc( sizeof( *xSendBuffer ) - sizeof( xSendBuffer->ucArray ) + xSEND_BUFFER_SIZE + 1 );
+		configASSERT( xSendBuffer );
+		memset( xSendBuffer, '\0', sizeof( *xSendBuffer ) - sizeof( xSendBuffer->ucArray ) );
+		xSendBuffer->LENGTH = xSEND_BUFFER_SIZE + 1;
+	}
+
+	/* The buffer used to pass received data from the host thread that reads
+	the frames to the FreeRTOS task. */
+	if( xRecvBuffer == NULL)
+	{
+		xRecvBuffer = ( StreamBuffer_t * ) pvPortMalloc( sizeof( *xRecvBuffer ) - sizeof( xRecvBuffer->ucArray ) + xRECV_BUFFER_SIZE + 1 );
+		configASSERT( xRecvBuffer );
+		memset( xRecvBuffer, '\0', sizeof( *xRecvBuffer ) - sizeof( xRecvBuffer->ucArray ) );
+		xRecvBuffer->LENGTH = xRECV_BUFFER_SIZE + 1;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+size_t xSpace;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	/* Both the length of the data being sent and the actual data being sent
+	are placed in the thread safe buffer used to pass data between the FreeRTOS
+	tasks and the host thread that writes the frames.  Drop the packet if there
+	is insufficient space in the buffer to hold both.  The Tx thread never holds
+	the mutex for long, so it is safe to wait for it here. */
+	pthread_mutex_lock( &xSendBufferMutex );
+	{
+		xSpace = uxStreamBufferGetSpace( xSendBuffer );
+
+		if( ( pxNetworkBuffer->xDataLength <= ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) ) &&
+			( xSpace >= ( pxNetworkBuffer->xDataLength + sizeof( pxNetworkBuffer->xDataLength ) ) ) )
+		{
+			/* First write in the length of the data, then write in the data
+			itself. */
+			uxStreamBufferAdd( xSendBuffer, 0, ( const uint8_t * ) &( pxNetworkBuffer->xDataLength ), sizeof( pxNetworkBuffer->xDataLength ) );
+			uxStreamBufferAdd( xSendBuffer, 0, ( const uint8_t * ) pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+		}
+		else
+		{
+			ulLinuxSendFailures++;
+		}
+	}
+	pthread_mutex_unlock( &xSendBufferMutex );
+
+	/* Kick the Tx thread in either case in case it doesn't know the buffer is
+	full. */
+	sem_post( &xSendSemaphore );
+
+	/* The buffer has been sent so can be released. */
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvLinuxRecvThread( void *pvParam )
+{
+uint8_t ucBuffer[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
+ssize_t xReceived;
+size_t xLength;
+BaseType_t xStored;
+
+	/* THIS IS A HOST THREAD - DO NOT ATTEMPT ANY FREERTOS CALLS OR TO PRINT
+	OUT MESSAGES HERE. */
+	( void ) pvParam;
+
+	for( ;; )
+	{
+		#if( configLINUX_NETWORK_USE_RAW_SOCKET == 0 )
+		{
+			xReceived = read( iInterfaceDescriptor, ucBuffer, sizeof( ucBuffer ) );
+		}
+		#else
+		{
+		struct sockaddr_ll xFrom;
+		socklen_t xFromLength = sizeof( xFrom );
+
+			xReceived = recvfrom( iInterfaceDescriptor, ucBuffer, sizeof( ucBuffer ), MSG_TRUNC, ( struct sockaddr * ) &xFrom, &xFromLength );
+
+			/* A raw socket also sees the frames sent through it. */
+			if( ( xReceived > 0 ) && ( xFrom.sll_pkttype == PACKET_OUTGOING ) )
+			{
+				continue;
+			}
+		}
+		#endif /* configLINUX_NETWORK_USE_RAW_SOCKET */
+
+		if( xReceived <= 0 )
+		{
+			if( ( xReceived < 0 ) && ( errno != EINTR ) && ( errno != EAGAIN ) )
+			{
+				/* The interface was removed. */
+				break;
+			}
+
+			continue;
+		}
+
+		/* Frames that are larger than the buffer are truncated, drop them. */
+		if( ( size_t ) xReceived > sizeof( ucBuffer ) )
+		{
+			ulLinuxRecvDrops++;
+			continue;
+		}
+
+		xLength = ( size_t ) xReceived;
+		xStored = pdFALSE;
+
+		/* Pass data to the FreeRTOS simulator on a thread safe circular
+		buffer. */
+		pthread_mutex_lock( &xRecvBufferMutex );
+		{
+			if( uxStreamBufferGetSpace( xRecvBuffer ) >= ( xLength + sizeof( xLength ) ) )
+			{
+				uxStreamBufferAdd( xRecvBuffer, 0, ( const uint8_t * ) &xLength, sizeof( xLength ) );
+				uxStreamBufferAdd( xRecvBuffer, 0, ucBuffer, xLength );
+				xStored = pdTRUE;
+			}
+		}
+		pthread_mutex_unlock( &xRecvBufferMutex );
+
+		if( xStored != pdFALSE )
+		{
+			vPortGenerateSimulatedInterrupt( configLINUX_MAC_INTERRUPT_NUMBER );
+		}
+		else
+		{
+			ulLinuxRecvDrops++;
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvLinuxSendThread( void *pvParam )
+{
+size_t xLength;
+uint8_t ucBuffer[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
+BaseType_t xHaveFrame;
+
+	/* THIS IS A HOST THREAD - DO NOT ATTEMPT ANY FREERTOS CALLS OR TO PRINT
+	OUT MESSAGES HERE. */
+	( void ) pvParam;
+
+	for( ;; )
+	{
+		/* Wait until notified of something to send. */
+		while( sem_wait( &xSendSemaphore ) != 0 )
+		{
+		}
+
+		/* Is there more than the length value stored in the circular buffer
+		used to pass data from the FreeRTOS simulator into this thread?  The
+		mutex is not held during the write, so the IP-task never waits for the
+		host network. */
+		do
+		{
+			xHaveFrame = pdFALSE;
+
+			pthread_mutex_lock( &xSendBufferMutex );
+			{
+				if( uxStreamBufferGetSize( xSendBuffer ) > sizeof( xLength ) )
+				{
+					uxStreamBufferGet( xSendBuffer, 0, ( uint8_t * ) &xLength, sizeof( xLength ), pdFALSE );
+					uxStreamBufferGet( xSendBuffer, 0, ucBuffer, xLength, pdFALSE );
+					xHaveFrame = pdTRUE;
+				}
+			}
+			pthread_mutex_unlock( &xSendBufferMutex );
+
+			if( xHaveFrame != pdFALSE )
+			{
+				if( write( iInterfaceDescriptor, ucBuffer, xLength ) != ( ssize_t ) xLength )
+				{
+					ulLinuxSendFailures++;
+				}
+			}
+		} while( xHaveFrame != pdFALSE );
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRxInterruptHandler( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xRxTaskHandle != NULL )
+	{
+		vTaskNotifyGiveFromISR( xRxTaskHandle, &xHigherPriorityTaskWoken );
+	}
+
+	return ( uint32_t ) xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInterruptSimulatorTask( void *pvParameters )
+{
+size_t xLength;
+uint8_t ucRecvBuffer[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+eFrameProcessingResult_t eResult;
+BaseType_t xHaveFrame;
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		/* Wait for the simulated interrupt. */
+		( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		do
+		{
+			xHaveFrame = pdFALSE;
+
+			/* Does the circular buffer used to pass data from the host thread
+			into the FreeRTOS simulator contain another packet?  The Rx thread
+			never holds the mutex for long, so it is safe to wait for it in a
+			task. */
+			pthread_mutex_lock( &xRecvBufferMutex );
+			{
+				if( uxStreamBufferGetSize( xRecvBuffer ) > sizeof( xLength ) )
+				{
+					uxStreamBufferGet( xRecvBuffer, 0, ( uint8_t * ) &xLength, sizeof( xLength ), pdFALSE );
+					uxStreamBufferGet( xRecvBuffer, 0, ucRecvBuffer, xLength, pdFALSE );
+					xHaveFrame = pdTRUE;
+				}
+			}
+			pthread_mutex_unlock( &xRecvBufferMutex );
+
+			if( xHaveFrame == pdFALSE )
+			{
+				break;
+			}
+
+			iptraceNETWORK_INTERFACE_RECEIVE();
+
+			/* Check for minimal size. */
+			if( xLength >= sizeof( EthernetHeader_t ) )
+			{
+				eResult = ipCONSIDER_FRAME_FOR_PROCESSING( ucRecvBuffer );
+			}
+			else
+			{
+				eResult = eReleaseBuffer;
+			}
+
+			if( eResult == eProcessBuffer )
+			{
+				/* Obtain a buffer into which the data can be placed.  This is
+				only an interrupt simulator, not a real interrupt, so it is ok
+				to call the task level function here. */
+				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( xLength, 0 );
+
+				if( pxNetworkBuffer != NULL )
+				{
+					memcpy( pxNetworkBuffer->pucEthernetBuffer, ucRecvBuffer, xLength );
+					pxNetworkBuffer->xDataLength = xLength;
+					xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+					/* Data was received and stored.  Send a message to the IP
+					task to let it know. */
+					if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+					{
+						vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+						iptraceETHERNET_RX_EVENT_LOST();
+					}
+				}
+				else
+				{
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+		} while( xHaveFrame != pdFALSE );
+	}
+}
+/*-----------------------------------------------------------*/
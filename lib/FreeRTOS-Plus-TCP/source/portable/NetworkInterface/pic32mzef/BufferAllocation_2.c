@@ -499,6 +499,13 @@ NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedS
                         pxReturn->pxNextBuffer = NULL;
                     }
                 #endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+                #if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+                    {
+                        /* A normal frame, not a TCP super-segment. */
+                        pxReturn->usLargeSendMSS = 0u;
+                    }
+                #endif /* ipconfigUSE_TCP_LARGE_SEND */
             }
         }
         else
@@ -60,6 +60,16 @@ taskEVENT_LIST_ITEM_VALUE_IN_USE definition. */
 	#define eventEVENT_BITS_CONTROL_BYTES	0xff000000UL
 #endif
 
+#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+	#if( ( ( configUSE_16_BIT_TICKS == 1 ) && ( configEVENT_GROUP_INDEXED_BITS > 8 ) ) || ( configEVENT_GROUP_INDEXED_BITS > 24 ) )
+		#error configEVENT_GROUP_INDEXED_BITS cannot exceed the number of event bits in an EventBits_t
+	#endif
+
+	/* The event bits that have a list of their own for tasks that wait for
+	nothing but that bit. */
+	#define eventINDEXED_BITS_MASK ( ( ( EventBits_t ) 1 << configEVENT_GROUP_INDEXED_BITS ) - ( EventBits_t ) 1 )
+#endif
+
 typedef struct EventGroupDef_t
 {
 	EventBits_t uxEventBits;
@@ -72,6 +82,21 @@ typedef struct EventGroupDef_t
 	#if( ( configSUPPORT_STATIC_ALLOCATION == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
 		uint8_t ucStaticallyAllocated; /*< Set to pdTRUE if the event group is statically allocated to ensure no attempt is made to free the memory. */
 	#endif
+
+	#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		TaskHandle_t xReadyTask;		/*< The task to notify when any of uxReadyWatchBits is set, or NULL. */
+		uint32_t ulReadyBits;			/*< The bits set in the notification value of xReadyTask. */
+		EventBits_t uxReadyWatchBits;	/*< The event bits that cause xReadyTask to be notified. */
+	#endif
+
+	#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+		EventBits_t uxGeneralWaitBits;	/*< A superset of the bits waited for by the tasks in xTasksWaitingForBits. */
+		List_t xTasksWaitingForBit[ configEVENT_GROUP_INDEXED_BITS ]; /*< Lists of tasks waiting for nothing but bit n to be set, indexed by n. */
+	#endif
+
+	#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+		volatile uint8_t ucLockCount;	/*< Non-zero while a task is accessing the event lists, so an ISR must not. */
+	#endif
 } EventGroup_t;
 
 /*-----------------------------------------------------------*/
@@ -86,6 +111,57 @@ typedef struct EventGroupDef_t
  */
 static BaseType_t prvTestWaitCondition( const EventBits_t uxCurrentEventBits, const EventBits_t uxBitsToWaitFor, const BaseType_t xWaitForAllBits ) PRIVILEGED_FUNCTION;
 
+#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+
+	/*
+	 * Initialise the per bit waiting lists of a newly created event group.
+	 */
+	static void prvInitialiseBitIndex( EventGroup_t *pxEventBits ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Return the list a task waiting for uxBitsToWaitFor should be placed on.
+	 * A task waiting for a single indexed bit goes on the list of that bit, so
+	 * setting the bit unblocks it without searching through unrelated waiters.
+	 * Any other task goes on xTasksWaitingForBits, and its bits are added to
+	 * uxGeneralWaitBits.  Must be called with the scheduler suspended.
+	 */
+	static List_t * prvGetWaitList( EventGroup_t *pxEventBits, const EventBits_t uxBitsToWaitFor ) PRIVILEGED_FUNCTION;
+
+#else
+
+	#define prvGetWaitList( pxEventBits, uxBitsToWaitFor ) ( &( ( pxEventBits )->xTasksWaitingForBits ) )
+
+#endif /* configEVENT_GROUP_INDEXED_BITS */
+
+/*
+ * Macros to mark the event lists as being accessed by a task.  While the count
+ * is non-zero xEventGroupSetBitsFromISR() defers to the timer task instead of
+ * unblocking tasks directly.  Calls can nest, as xEventGroupSync() calls
+ * xEventGroupSetBits().
+ */
+#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+
+	#define prvLockEventGroup( pxEventBits )	\
+		taskENTER_CRITICAL();					\
+		{										\
+			( pxEventBits )->ucLockCount++;		\
+		}										\
+		taskEXIT_CRITICAL()
+
+	#define prvUnlockEventGroup( pxEventBits )	\
+		taskENTER_CRITICAL();					\
+		{										\
+			( pxEventBits )->ucLockCount--;		\
+		}										\
+		taskEXIT_CRITICAL()
+
+#else
+
+	#define prvLockEventGroup( pxEventBits )
+	#define prvUnlockEventGroup( pxEventBits )
+
+#endif /* configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT */
+
 /*-----------------------------------------------------------*/
 
 #if( configSUPPORT_STATIC_ALLOCATION == 1 )
@@ -115,6 +191,26 @@ static BaseType_t prvTestWaitCondition( const EventBits_t uxCurrentEventBits, co
 			pxEventBits->uxEventBits = 0;
 			vListInitialise( &( pxEventBits->xTasksWaitingForBits ) );
 
+			#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+			{
+				pxEventBits->xReadyTask = NULL;
+				pxEventBits->ulReadyBits = 0UL;
+				pxEventBits->uxReadyWatchBits = 0;
+			}
+			#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+
+			#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+			{
+				prvInitialiseBitIndex( pxEventBits );
+			}
+			#endif /* configEVENT_GROUP_INDEXED_BITS */
+
+			#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+			{
+				pxEventBits->ucLockCount = 0U;
+			}
+			#endif /* configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT */
+
 			#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 			{
 				/* Both static and dynamic allocation can be used, so note that
@@ -166,6 +262,26 @@ static BaseType_t prvTestWaitCondition( const EventBits_t uxCurrentEventBits, co
 			pxEventBits->uxEventBits = 0;
 			vListInitialise( &( pxEventBits->xTasksWaitingForBits ) );
 
+			#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+			{
+				pxEventBits->xReadyTask = NULL;
+				pxEventBits->ulReadyBits = 0UL;
+				pxEventBits->uxReadyWatchBits = 0;
+			}
+			#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+
+			#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+			{
+				prvInitialiseBitIndex( pxEventBits );
+			}
+			#endif /* configEVENT_GROUP_INDEXED_BITS */
+
+			#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+			{
+				pxEventBits->ucLockCount = 0U;
+			}
+			#endif /* configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT */
+
 			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
 			{
 				/* Both static and dynamic allocation can be used, so note this
@@ -204,6 +320,7 @@ BaseType_t xTimeoutOccurred = pdFALSE;
 	#endif
 
 	vTaskSuspendAll();
+	prvLockEventGroup( pxEventBits );
 	{
 		uxOriginalBitValue = pxEventBits->uxEventBits;
 
@@ -229,7 +346,7 @@ BaseType_t xTimeoutOccurred = pdFALSE;
 				/* Store the bits that the calling task is waiting for in the
 				task's event list item so the kernel knows when a match is
 				found.  Then enter the blocked state. */
-				vTaskPlaceOnUnorderedEventList( &( pxEventBits->xTasksWaitingForBits ), ( uxBitsToWaitFor | eventCLEAR_EVENTS_ON_EXIT_BIT | eventWAIT_FOR_ALL_BITS ), xTicksToWait );
+				vTaskPlaceOnUnorderedEventList( prvGetWaitList( pxEventBits, uxBitsToWaitFor ), ( uxBitsToWaitFor | eventCLEAR_EVENTS_ON_EXIT_BIT | eventWAIT_FOR_ALL_BITS ), xTicksToWait );
 
 				/* This assignment is obsolete as uxReturn will get set after
 				the task unblocks, but some compilers mistakenly generate a
@@ -246,6 +363,7 @@ BaseType_t xTimeoutOccurred = pdFALSE;
 			}
 		}
 	}
+	prvUnlockEventGroup( pxEventBits );
 	xAlreadyYielded = xTaskResumeAll();
 
 	if( xTicksToWait != ( TickType_t ) 0 )
@@ -327,6 +445,7 @@ BaseType_t xTimeoutOccurred = pdFALSE;
 	#endif
 
 	vTaskSuspendAll();
+	prvLockEventGroup( pxEventBits );
 	{
 		const EventBits_t uxCurrentEventBits = pxEventBits->uxEventBits;
 
@@ -384,7 +503,7 @@ BaseType_t xTimeoutOccurred = pdFALSE;
 			/* Store the bits that the calling task is waiting for in the
 			task's event list item so the kernel knows when a match is
 			found.  Then enter the blocked state. */
-			vTaskPlaceOnUnorderedEventList( &( pxEventBits->xTasksWaitingForBits ), ( uxBitsToWaitFor | uxControlBits ), xTicksToWait );
+			vTaskPlaceOnUnorderedEventList( prvGetWaitList( pxEventBits, uxBitsToWaitFor ), ( uxBitsToWaitFor | uxControlBits ), xTicksToWait );
 
 			/* This is obsolete as it will get set after the task unblocks, but
 			some compilers mistakenly generate a warning about the variable
@@ -394,6 +513,7 @@ BaseType_t xTimeoutOccurred = pdFALSE;
 			traceEVENT_GROUP_WAIT_BITS_BLOCK( xEventGroup, uxBitsToWaitFor );
 		}
 	}
+	prvUnlockEventGroup( pxEventBits );
 	xAlreadyYielded = xTaskResumeAll();
 
 	if( xTicksToWait != ( TickType_t ) 0 )
@@ -524,6 +644,15 @@ List_t const * pxList;
 EventBits_t uxBitsToClear = 0, uxBitsWaitedFor, uxControlBits;
 EventGroup_t *pxEventBits = xEventGroup;
 BaseType_t xMatchFound = pdFALSE;
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	TaskHandle_t xReadyTask = NULL;
+	uint32_t ulReadyBits = 0UL;
+#endif
+#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+	List_t const * pxBitList;
+	EventBits_t uxIndexedBits;
+	UBaseType_t uxBit;
+#endif
 
 	/* Check the user is not attempting to set the bits used by the kernel
 	itself. */
@@ -533,6 +662,7 @@ BaseType_t xMatchFound = pdFALSE;
 	pxList = &( pxEventBits->xTasksWaitingForBits );
 	pxListEnd = listGET_END_MARKER( pxList ); /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. */
 	vTaskSuspendAll();
+	prvLockEventGroup( pxEventBits );
 	{
 		traceEVENT_GROUP_SET_BITS( xEventGroup, uxBitsToSet );
 
@@ -541,6 +671,58 @@ BaseType_t xMatchFound = pdFALSE;
 		/* Set the bits. */
 		pxEventBits->uxEventBits |= uxBitsToSet;
 
+		#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+		{
+			/* Every task on the list of a bit that has just been set is waiting
+			for nothing but that bit, so all of them unblock.  Tasks only block
+			on a bit that is clear, so bits that were already set have empty
+			lists. */
+			uxIndexedBits = uxBitsToSet & eventINDEXED_BITS_MASK;
+
+			for( uxBit = 0; uxIndexedBits != ( EventBits_t ) 0; uxBit++ )
+			{
+				if( ( uxIndexedBits & ( EventBits_t ) 1 ) != ( EventBits_t ) 0 )
+				{
+					pxBitList = &( pxEventBits->xTasksWaitingForBit[ uxBit ] );
+
+					while( listCURRENT_LIST_LENGTH( pxBitList ) > ( UBaseType_t ) 0 )
+					{
+						pxNext = listGET_HEAD_ENTRY( pxBitList );
+
+						if( ( listGET_LIST_ITEM_VALUE( pxNext ) & eventCLEAR_EVENTS_ON_EXIT_BIT ) != ( EventBits_t ) 0 )
+						{
+							uxBitsToClear |= ( EventBits_t ) 1 << uxBit;
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+
+						vTaskRemoveFromUnorderedEventList( pxNext, pxEventBits->uxEventBits | eventUNBLOCKED_DUE_TO_BIT_SET );
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				uxIndexedBits >>= 1;
+			}
+
+			/* Only search the general list if one of its tasks could be
+			unblocked.  The bits still waited for are collected again during
+			the search below. */
+			if( ( uxBitsToSet & pxEventBits->uxGeneralWaitBits ) != ( EventBits_t ) 0 )
+			{
+				pxEventBits->uxGeneralWaitBits = 0;
+			}
+			else
+			{
+				pxListItem = ( ListItem_t * ) pxListEnd; /*lint !e9005 The end marker is only compared against, never written through. */
+			}
+		}
+		#endif /* configEVENT_GROUP_INDEXED_BITS */
+
 		/* See if the new bit value should unblock any tasks. */
 		while( pxListItem != pxListEnd )
 		{
@@ -593,6 +775,14 @@ BaseType_t xMatchFound = pdFALSE;
 				than because it timed out. */
 				vTaskRemoveFromUnorderedEventList( pxListItem, pxEventBits->uxEventBits | eventUNBLOCKED_DUE_TO_BIT_SET );
 			}
+			else
+			{
+				#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+				{
+					pxEventBits->uxGeneralWaitBits |= uxBitsWaitedFor;
+				}
+				#endif /* configEVENT_GROUP_INDEXED_BITS */
+			}
 
 			/* Move onto the next list item.  Note pxListItem->pxNext is not
 			used here as the list item may have been removed from the event list
@@ -603,19 +793,93 @@ BaseType_t xMatchFound = pdFALSE;
 		/* Clear any bits that matched when the eventCLEAR_EVENTS_ON_EXIT_BIT
 		bit was set in the control word. */
 		pxEventBits->uxEventBits &= ~uxBitsToClear;
+
+		#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		{
+			if( ( uxBitsToSet & pxEventBits->uxReadyWatchBits ) != ( EventBits_t ) 0 )
+			{
+				xReadyTask = pxEventBits->xReadyTask;
+				ulReadyBits = pxEventBits->ulReadyBits;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
 	}
+	prvUnlockEventGroup( pxEventBits );
 	( void ) xTaskResumeAll();
 
+	#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	{
+		/* The notification may yield, so is not sent until the scheduler has
+		been resumed. */
+		if( xReadyTask != NULL )
+		{
+			( void ) xTaskNotify( xReadyTask, ulReadyBits, eSetBits );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+
 	return pxEventBits->uxEventBits;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+
+	void vEventGroupSetReadyNotification( EventGroupHandle_t xEventGroup, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet, const EventBits_t uxBitsToWatch )
+	{
+	EventGroup_t *pxEventBits = xEventGroup;
+	BaseType_t xAlreadySet;
+
+		configASSERT( xEventGroup );
+		configASSERT( ( uxBitsToWatch & eventEVENT_BITS_CONTROL_BYTES ) == 0 );
+
+		vTaskSuspendAll();
+		{
+			pxEventBits->xReadyTask = xTaskToNotify;
+			pxEventBits->ulReadyBits = ulBitsToSet;
+			pxEventBits->uxReadyWatchBits = uxBitsToWatch;
+
+			/* Bits set before the registration would otherwise go unnoticed
+			until they are set again. */
+			xAlreadySet = ( ( pxEventBits->uxEventBits & uxBitsToWatch ) != ( EventBits_t ) 0 ) ? pdTRUE : pdFALSE;
+		}
+		( void ) xTaskResumeAll();
+
+		if( ( xTaskToNotify != NULL ) && ( xAlreadySet != pdFALSE ) )
+		{
+			( void ) xTaskNotify( xTaskToNotify, ulBitsToSet, eSetBits );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+/*-----------------------------------------------------------*/
+
 void vEventGroupDelete( EventGroupHandle_t xEventGroup )
 {
 EventGroup_t *pxEventBits = xEventGroup;
 const List_t *pxTasksWaitingForBits = &( pxEventBits->xTasksWaitingForBits );
 
+#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+	const List_t *pxBitList;
+	UBaseType_t uxBit;
+#endif
+
 	vTaskSuspendAll();
+
+	/* The event group is not unlocked again as it no longer exists once this
+	function returns. */
+	prvLockEventGroup( pxEventBits );
 	{
 		traceEVENT_GROUP_DELETE( xEventGroup );
 
@@ -627,6 +891,20 @@ const List_t *pxTasksWaitingForBits = &( pxEventBits->xTasksWaitingForBits );
 			vTaskRemoveFromUnorderedEventList( pxTasksWaitingForBits->xListEnd.pxNext, eventUNBLOCKED_DUE_TO_BIT_SET );
 		}
 
+		#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+		{
+			for( uxBit = 0; uxBit < ( UBaseType_t ) configEVENT_GROUP_INDEXED_BITS; uxBit++ )
+			{
+				pxBitList = &( pxEventBits->xTasksWaitingForBit[ uxBit ] );
+
+				while( listCURRENT_LIST_LENGTH( pxBitList ) > ( UBaseType_t ) 0 )
+				{
+					vTaskRemoveFromUnorderedEventList( listGET_HEAD_ENTRY( pxBitList ), eventUNBLOCKED_DUE_TO_BIT_SET );
+				}
+			}
+		}
+		#endif /* configEVENT_GROUP_INDEXED_BITS */
+
 		#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
 		{
 			/* The event group can only have been allocated dynamically - free
@@ -703,14 +981,188 @@ BaseType_t xWaitConditionMet = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
-#if ( ( configUSE_TRACE_FACILITY == 1 ) && ( INCLUDE_xTimerPendFunctionCall == 1 ) && ( configUSE_TIMERS == 1 ) )
+#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+
+	static void prvInitialiseBitIndex( EventGroup_t *pxEventBits )
+	{
+	UBaseType_t uxBit;
+
+		pxEventBits->uxGeneralWaitBits = 0;
+
+		for( uxBit = 0; uxBit < ( UBaseType_t ) configEVENT_GROUP_INDEXED_BITS; uxBit++ )
+		{
+			vListInitialise( &( pxEventBits->xTasksWaitingForBit[ uxBit ] ) );
+		}
+	}
+
+#endif /* configEVENT_GROUP_INDEXED_BITS */
+/*-----------------------------------------------------------*/
+
+#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+
+	static List_t * prvGetWaitList( EventGroup_t *pxEventBits, const EventBits_t uxBitsToWaitFor )
+	{
+	List_t *pxList;
+	UBaseType_t uxBit = 0;
+
+		if( ( ( uxBitsToWaitFor & ~eventINDEXED_BITS_MASK ) == ( EventBits_t ) 0 ) &&
+			( ( uxBitsToWaitFor & ( uxBitsToWaitFor - ( EventBits_t ) 1 ) ) == ( EventBits_t ) 0 ) )
+		{
+			/* A single indexed bit - find its number. */
+			while( ( uxBitsToWaitFor >> uxBit ) != ( EventBits_t ) 1 )
+			{
+				uxBit++;
+			}
+
+			pxList = &( pxEventBits->xTasksWaitingForBit[ uxBit ] );
+		}
+		else
+		{
+			/* The bits stay in uxGeneralWaitBits until xEventGroupSetBits()
+			next searches the general list, even if the task times out first.
+			That only costs an unnecessary search. */
+			pxEventBits->uxGeneralWaitBits |= uxBitsToWaitFor;
+			pxList = &( pxEventBits->xTasksWaitingForBits );
+		}
+
+		return pxList;
+	}
+
+#endif /* configEVENT_GROUP_INDEXED_BITS */
+/*-----------------------------------------------------------*/
+
+#if ( ( ( configUSE_TRACE_FACILITY == 1 ) || ( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 ) ) && ( INCLUDE_xTimerPendFunctionCall == 1 ) && ( configUSE_TIMERS == 1 ) )
 
 	BaseType_t xEventGroupSetBitsFromISR( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet, BaseType_t *pxHigherPriorityTaskWoken )
 	{
 	BaseType_t xReturn;
+	#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+		EventGroup_t *pxEventBits = xEventGroup;
+		UBaseType_t uxSavedInterruptStatus, uxBit;
+		EventBits_t uxIndexedBits, uxBitsToClear = 0;
+		List_t const * pxBitList;
+		ListItem_t *pxListItem;
+		BaseType_t xSetDirectly = pdFALSE;
+		#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+			TaskHandle_t xReadyTask = NULL;
+			uint32_t ulReadyBits = 0UL;
+		#endif
+	#endif
 
 		traceEVENT_GROUP_SET_BITS_FROM_ISR( xEventGroup, uxBitsToSet );
-		xReturn = xTimerPendFunctionCallFromISR( vEventGroupSetBitsCallback, ( void * ) xEventGroup, ( uint32_t ) uxBitsToSet, pxHigherPriorityTaskWoken ); /*lint !e9087 Can't avoid cast to void* as a generic callback function not specific to this use case. Callback casts back to original type so safe. */
+
+		#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+		{
+			configASSERT( xEventGroup );
+			configASSERT( ( uxBitsToSet & eventEVENT_BITS_CONTROL_BYTES ) == 0 );
+
+			uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+			{
+				/* The bits can be set here, rather than in the timer task, if no
+				task is accessing the event lists and none of the tasks on the
+				general list can be unblocked.  Only the lists of the indexed
+				bits being set are then affected, and every task on those is
+				unblocked without any searching. */
+				if( ( pxEventBits->ucLockCount == 0U ) && ( ( uxBitsToSet & pxEventBits->uxGeneralWaitBits ) == ( EventBits_t ) 0 ) )
+				{
+					xSetDirectly = pdTRUE;
+					pxEventBits->uxEventBits |= uxBitsToSet;
+					uxIndexedBits = uxBitsToSet & eventINDEXED_BITS_MASK;
+
+					for( uxBit = 0; uxIndexedBits != ( EventBits_t ) 0; uxBit++ )
+					{
+						if( ( uxIndexedBits & ( EventBits_t ) 1 ) != ( EventBits_t ) 0 )
+						{
+							pxBitList = &( pxEventBits->xTasksWaitingForBit[ uxBit ] );
+
+							while( listCURRENT_LIST_LENGTH( pxBitList ) > ( UBaseType_t ) 0 )
+							{
+								pxListItem = listGET_HEAD_ENTRY( pxBitList );
+
+								if( ( listGET_LIST_ITEM_VALUE( pxListItem ) & eventCLEAR_EVENTS_ON_EXIT_BIT ) != ( EventBits_t ) 0 )
+								{
+									uxBitsToClear |= ( EventBits_t ) 1 << uxBit;
+								}
+								else
+								{
+									mtCOVERAGE_TEST_MARKER();
+								}
+
+								if( xTaskRemoveFromUnorderedEventListFromISR( pxListItem, pxEventBits->uxEventBits | eventUNBLOCKED_DUE_TO_BIT_SET ) != pdFALSE )
+								{
+									if( pxHigherPriorityTaskWoken != NULL )
+									{
+										*pxHigherPriorityTaskWoken = pdTRUE;
+									}
+									else
+									{
+										mtCOVERAGE_TEST_MARKER();
+									}
+								}
+								else
+								{
+									mtCOVERAGE_TEST_MARKER();
+								}
+							}
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+
+						uxIndexedBits >>= 1;
+					}
+
+					pxEventBits->uxEventBits &= ~uxBitsToClear;
+
+					#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+					{
+						if( ( uxBitsToSet & pxEventBits->uxReadyWatchBits ) != ( EventBits_t ) 0 )
+						{
+							xReadyTask = pxEventBits->xReadyTask;
+							ulReadyBits = pxEventBits->ulReadyBits;
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+					#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+			#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+			{
+				if( xReadyTask != NULL )
+				{
+					( void ) xTaskNotifyFromISR( xReadyTask, ulReadyBits, eSetBits, pxHigherPriorityTaskWoken );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+
+			if( xSetDirectly != pdFALSE )
+			{
+				xReturn = pdPASS;
+			}
+			else
+			{
+				xReturn = xTimerPendFunctionCallFromISR( vEventGroupSetBitsCallback, ( void * ) xEventGroup, ( uint32_t ) uxBitsToSet, pxHigherPriorityTaskWoken ); /*lint !e9087 Can't avoid cast to void* as a generic callback function not specific to this use case. Callback casts back to original type so safe. */
+			}
+		}
+		#else
+		{
+			xReturn = xTimerPendFunctionCallFromISR( vEventGroupSetBitsCallback, ( void * ) xEventGroup, ( uint32_t ) uxBitsToSet, pxHigherPriorityTaskWoken ); /*lint !e9087 Can't avoid cast to void* as a generic callback function not specific to this use case. Callback casts back to original type so safe. */
+		}
+		#endif /* configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT */
 
 		return xReturn;
 	}
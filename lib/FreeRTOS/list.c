@@ -147,11 +147,46 @@ const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
 			   before vTaskStartScheduler() has been called?).
 		**********************************************************************/
 
-		for( pxIterator = ( ListItem_t * ) &( pxList->xListEnd ); pxIterator->pxNext->xItemValue <= xValueOfInsertion; pxIterator = pxIterator->pxNext ) /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. *//*lint !e440 The iterator moves to a different value, not xValueOfInsertion. */
+		#if( configLIST_INSERT_FROM_NEAREST_END == 1 )
 		{
-			/* There is nothing to do here, just iterating to the wanted
-			insertion position. */
+		const ListItem_t * const pxListEnd = ( ListItem_t * ) &( pxList->xListEnd ); /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. */
+		const TickType_t xHeadValue = pxListEnd->pxNext->xItemValue;
+		const TickType_t xTailValue = pxListEnd->pxPrevious->xItemValue;
+
+			/* Delayed task and timer lists are long, and a new item is often
+			due after most of the items already in them, so walk from the end
+			of the list that is closest in value.  The walk backwards stops
+			at the last item whose value is not greater than the new value,
+			so items with equal values keep the same order as in the walk
+			forwards.  An empty list has the end marker, portMAX_DELAY, at
+			both ends and is walked forwards. */
+			if( ( pxList->uxNumberOfItems != ( UBaseType_t ) 0 ) && ( xValueOfInsertion >= xHeadValue ) &&
+				( ( xValueOfInsertion >= xTailValue ) || ( ( xValueOfInsertion - xHeadValue ) > ( xTailValue - xValueOfInsertion ) ) ) )
+			{
+				for( pxIterator = pxListEnd->pxPrevious; ( pxIterator != pxListEnd ) && ( pxIterator->xItemValue > xValueOfInsertion ); pxIterator = pxIterator->pxPrevious )
+				{
+					/* There is nothing to do here, just iterating to the
+					wanted insertion position. */
+				}
+			}
+			else
+			{
+				for( pxIterator = ( ListItem_t * ) pxListEnd; pxIterator->pxNext->xItemValue <= xValueOfInsertion; pxIterator = pxIterator->pxNext ) /*lint !e440 The iterator moves to a different value, not xValueOfInsertion. */
+				{
+					/* There is nothing to do here, just iterating to the
+					wanted insertion position. */
+				}
+			}
 		}
+		#else /* configLIST_INSERT_FROM_NEAREST_END */
+		{
+			for( pxIterator = ( ListItem_t * ) &( pxList->xListEnd ); pxIterator->pxNext->xItemValue <= xValueOfInsertion; pxIterator = pxIterator->pxNext ) /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. *//*lint !e440 The iterator moves to a different value, not xValueOfInsertion. */
+			{
+				/* There is nothing to do here, just iterating to the wanted
+				insertion position. */
+			}
+		}
+		#endif /* configLIST_INSERT_FROM_NEAREST_END */
 	}
 
 	pxNewListItem->pxNext = pxIterator->pxNext;
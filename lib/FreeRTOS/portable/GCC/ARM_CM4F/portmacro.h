@@ -188,6 +188,40 @@ BaseType_t xReturn;
 
 /*-----------------------------------------------------------*/
 
+/* Declares that the calling task holds no floating point values, so that
+context switches stop saving and restoring its high FPU registers.  Clearing
+CONTROL.FPCA makes exceptions stack a basic frame, which xPortPendSVHandler()
+sees in EXC_RETURN, until the task next executes a floating point instruction
+and the core sets FPCA again.  This is for tasks that use the FPU only now and
+then, for example to format a float, and must only be called where no floating
+point value is live, such as at the top of the loop of a task.  The next
+floating point instruction starts from the default FPSCR in FPDSCR. */
+portFORCE_INLINE static void vPortTaskUsesNoFPU( void )
+{
+	__asm volatile
+	(
+		"	mrs r0, control		\n"
+		"	bic r0, r0, #4		\n"
+		"	msr control, r0		\n"
+		"	isb					\n"
+		::: "r0", "memory"
+	);
+}
+
+/* Returns pdTRUE if the calling task has an FPU context, so its high FPU
+registers are saved and restored on each context switch. */
+portFORCE_INLINE static BaseType_t xPortTaskUsesFPU( void )
+{
+uint32_t ulControl;
+
+	__asm volatile( "mrs %0, control" : "=r"( ulControl ) :: "memory" );
+
+	return ( ( ulControl & 0x04UL ) != 0UL ) ? pdTRUE : pdFALSE;
+}
+
+#define portTASK_USES_NO_FPU() vPortTaskUsesNoFPU()
+/*-----------------------------------------------------------*/
+
 portFORCE_INLINE static void vPortRaiseBASEPRI( void )
 {
 uint32_t ulNewBASEPRI;
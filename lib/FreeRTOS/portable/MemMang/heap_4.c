@@ -115,6 +115,19 @@ void *pvPortMalloc( size_t xWantedSize )
 BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
 void *pvReturn = NULL;
 
+	#if( configUSE_TASK_ARENAS == 1 )
+	{
+		/* A task that has an arena bound to it is served from that arena, the
+		heap is only used when the arena is full. */
+		pvReturn = pvTaskArenaMalloc( xWantedSize );
+
+		if( pvReturn != NULL )
+		{
+			return pvReturn;
+		}
+	}
+	#endif /* configUSE_TASK_ARENAS */
+
 	vTaskSuspendAll();
 	{
 		/* If this is the first call to malloc then the heap will require
@@ -265,6 +278,16 @@ void vPortFree( void *pv )
 uint8_t *puc = ( uint8_t * ) pv;
 BlockLink_t *pxLink;
 
+	#if( configUSE_TASK_ARENAS == 1 )
+	{
+		/* The blocks of an arena are released by vTaskArenaReset(). */
+		if( xTaskArenaFree( pv ) != pdFALSE )
+		{
+			pv = NULL;
+		}
+	}
+	#endif /* configUSE_TASK_ARENAS */
+
 	if( pv != NULL )
 	{
 		/* The memory being freed will have an BlockLink_t structure immediately
@@ -320,6 +343,40 @@ size_t xPortGetMinimumEverFreeHeapSize( void )
 }
 /*-----------------------------------------------------------*/
 
+size_t xPortGetLargestFreeBlockSize( void )
+{
+BlockLink_t *pxBlock;
+size_t xLargestBlock = 0;
+
+	vTaskSuspendAll();
+	{
+		/* The list of free blocks does not exist before the heap has been
+		initialised. */
+		if( pxEnd != NULL )
+		{
+			for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+			{
+				if( pxBlock->xBlockSize > xLargestBlock )
+				{
+					xLargestBlock = pxBlock->xBlockSize;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return xLargestBlock;
+}
+/*-----------------------------------------------------------*/
+
 void vPortInitialiseBlocks( void )
 {
 	/* This just exists to keep the linker quiet. */
@@ -55,7 +55,7 @@
  * low address to high address.  So the following is a valid example of how
  * to use the function.
  *
- * HeapRegion_t xHeapRegions[] =
+ * HeapRegion_t xHeapRegionStates[] =
  * {
  * 	{ ( uint8_t * ) 0x80000000UL, 0x10000 }, << Defines a block of 0x10000 bytes starting at address 0x80000000
  * 	{ ( uint8_t * ) 0x90000000UL, 0xa0000 }, << Defines a block of 0xa0000 bytes starting at address of 0x90000000
@@ -66,6 +66,12 @@
  *
  * Note 0x80000000 is the lower address so appears in the array first.
  *
+ * When configUSE_HEAP_CAPS is 1 HeapRegion_t also has a ulCaps member, set to
+ * the heapCAPS_ bits of the memory in the region, for example heapCAPS_FAST |
+ * heapCAPS_DMA for internal SRAM and heapCAPS_BULK for external PSRAM.
+ * pvPortMallocWithCaps() then places a block in a region with the requested
+ * capabilities, while pvPortMalloc() still uses the whole heap.
+ *
  */
 #include <stdlib.h>
 
@@ -107,6 +113,40 @@ typedef struct A_BLOCK_LINK
  */
 static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert );
 
+/*
+ * Returns xWantedSize increased to hold a BlockLink_t and rounded up to the
+ * alignment, or 0 if a block of that size cannot be allocated.
+ */
+static size_t prvBlockSize( size_t xWantedSize );
+
+/*
+ * Allocates a block of xWantedSize bytes from the free blocks that follow
+ * pxPreviousBlock in the list, stopping at the end marker pxLastBlock.
+ * Returns NULL if none is large enough.  Called with the scheduler suspended.
+ */
+static void *prvAllocateBlock( BlockLink_t *pxPreviousBlock, const BlockLink_t *pxLastBlock, size_t xWantedSize );
+
+#if( configUSE_HEAP_CAPS == 1 )
+
+	/* The state of one region passed to vPortDefineHeapRegions(). */
+	typedef struct HEAP_REGION_STATE
+	{
+		BlockLink_t *pxStart;					/*<< The link before the free blocks of the region - xStart or the end marker of the previous region. */
+		BlockLink_t *pxEnd;						/*<< The end marker of the region. */
+		size_t xSizeInBytes;
+		size_t xFreeBytesRemaining;
+		size_t xMinimumEverFreeBytesRemaining;
+		uint32_t ulCaps;
+		uint32_t ulAllocations;
+	} HeapRegionState_t;
+
+	/*
+	 * Returns the region an allocated or free block is in.
+	 */
+	static HeapRegionState_t *prvRegionOfBlock( const BlockLink_t *pxBlock );
+
+#endif /* configUSE_HEAP_CAPS */
+
 /*-----------------------------------------------------------*/
 
 /* The size of the structure placed at the beginning of each allocated memory
@@ -127,37 +167,120 @@ application.  When the bit is free the block is still part of the free heap
 space. */
 static size_t xBlockAllocatedBit = 0;
 
+#if( configUSE_HEAP_CAPS == 1 )
+
+	static HeapRegionState_t xHeapRegionStates[ configHEAP_MAX_REGIONS ];
+	static BaseType_t xHeapRegionCount = 0;
+
+	/* The capabilities of all the regions together. */
+	static uint32_t ulHeapRegionCaps = 0UL;
+
+#endif /* configUSE_HEAP_CAPS */
+
 /*-----------------------------------------------------------*/
 
 void *pvPortMalloc( size_t xWantedSize )
 {
-BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
 void *pvReturn = NULL;
 
+	#if( configUSE_TASK_ARENAS == 1 )
+	{
+		/* A task that has an arena bound to it is served from that arena, the
+		heap is only used when the arena is full. */
+		pvReturn = pvTaskArenaMalloc( xWantedSize );
+
+		if( pvReturn != NULL )
+		{
+			return pvReturn;
+		}
+	}
+	#endif /* configUSE_TASK_ARENAS */
+
 	/* The heap must be initialised before the first call to
 	prvPortMalloc(). */
 	configASSERT( pxEnd );
 
 	vTaskSuspendAll();
 	{
-		/* Check the requested block size is not so large that the top bit is
-		set.  The top bit of the block size member of the BlockLink_t structure
-		is used to determine who owns the block - the application or the
-		kernel, so it must be free. */
-		if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
+		xWantedSize = prvBlockSize( xWantedSize );
+
+		if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+		{
+			/* Search the whole heap, from the start (lowest address) block. */
+			pvReturn = prvAllocateBlock( &xStart, pxEnd, xWantedSize );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_HEAP_CAPS == 1 )
+
+	void *pvPortMallocWithCaps( size_t xWantedSize, uint32_t ulCaps )
+	{
+	void *pvReturn = NULL;
+	BaseType_t xRegion;
+
+		/* Task arenas are not used, as the caller wants the block in a
+		particular region. */
+		configASSERT( pxEnd );
+
+		vTaskSuspendAll();
 		{
-			/* The wanted size is increased so it can contain a BlockLink_t
-			structure in addition to the requested amount of bytes. */
-			if( xWantedSize > 0 )
+			xWantedSize = prvBlockSize( xWantedSize );
+
+			if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
 			{
-				xWantedSize += xHeapStructSize;
+				/* Each region has its own part of the free list, from the end
+				marker of the region before it to its own end marker, so only
+				the regions with the capabilities are searched. */
+				for( xRegion = 0; ( xRegion < xHeapRegionCount ) && ( pvReturn == NULL ); xRegion++ )
+				{
+					if( ( xHeapRegionStates[ xRegion ].ulCaps & ulCaps ) == ulCaps )
+					{
+						if( xWantedSize <= xHeapRegionStates[ xRegion ].xFreeBytesRemaining )
+						{
+							pvReturn = prvAllocateBlock( xHeapRegionStates[ xRegion ].pxStart, xHeapRegionStates[ xRegion ].pxEnd, xWantedSize );
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
 
-				/* Ensure that blocks are always aligned to the required number
-				of bytes. */
-				if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+				/* Only DMA capable memory will do for DMA, unless no region was
+				marked as being capable of it. */
+				if( ( pvReturn == NULL ) &&
+					( ( ( ulCaps & heapCAPS_DMA ) == 0UL ) || ( ( ulHeapRegionCaps & heapCAPS_DMA ) == 0UL ) ) )
 				{
-					/* Byte alignment required. */
-					xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+					pvReturn = prvAllocateBlock( &xStart, pxEnd, xWantedSize );
 				}
 				else
 				{
@@ -169,73 +292,52 @@ void *pvReturn = NULL;
 				mtCOVERAGE_TEST_MARKER();
 			}
 
-			if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
-			{
-				/* Traverse the list from the start	(lowest address) block until
-				one	of adequate size is found. */
-				pxPreviousBlock = &xStart;
-				pxBlock = xStart.pxNextFreeBlock;
-				while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
-				{
-					pxPreviousBlock = pxBlock;
-					pxBlock = pxBlock->pxNextFreeBlock;
-				}
+			traceMALLOC( pvReturn, xWantedSize );
+		}
+		( void ) xTaskResumeAll();
 
-				/* If the end marker was reached then a block of adequate size
-				was	not found. */
-				if( pxBlock != pxEnd )
-				{
-					/* Return the memory space pointed to - jumping over the
-					BlockLink_t structure at its start. */
-					pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+		#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+		{
+			if( pvReturn == NULL )
+			{
+				extern void vApplicationMallocFailedHook( void );
+				vApplicationMallocFailedHook();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif
 
-					/* This block is being returned for use so must be taken out
-					of the list of free blocks. */
-					pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+		return pvReturn;
+	}
 
-					/* If the block is larger than required it can be split into
-					two. */
-					if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
-					{
-						/* This block is to be split into two.  Create a new
-						block following the number of bytes requested. The void
-						cast is used to prevent byte alignment warnings from the
-						compiler. */
-						pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
-
-						/* Calculate the sizes of two blocks split from the
-						single block. */
-						pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
-						pxBlock->xBlockSize = xWantedSize;
-
-						/* Insert the new block into the list of free blocks. */
-						prvInsertBlockIntoFreeList( ( pxNewBlockLink ) );
-					}
-					else
-					{
-						mtCOVERAGE_TEST_MARKER();
-					}
+#endif /* configUSE_HEAP_CAPS */
+/*-----------------------------------------------------------*/
 
-					xFreeBytesRemaining -= pxBlock->xBlockSize;
+static size_t prvBlockSize( size_t xWantedSize )
+{
+size_t xBlockSize = 0;
 
-					if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
-					{
-						xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
-					}
-					else
-					{
-						mtCOVERAGE_TEST_MARKER();
-					}
+	/* Check the requested block size is not so large that the top bit is
+	set.  The top bit of the block size member of the BlockLink_t structure
+	is used to determine who owns the block - the application or the
+	kernel, so it must be free. */
+	if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
+	{
+		/* The wanted size is increased so it can contain a BlockLink_t
+		structure in addition to the requested amount of bytes. */
+		if( xWantedSize > 0 )
+		{
+			xBlockSize = xWantedSize + xHeapStructSize;
 
-					/* The block is being returned - it is allocated and owned
-					by the application and has no "next" block. */
-					pxBlock->xBlockSize |= xBlockAllocatedBit;
-					pxBlock->pxNextFreeBlock = NULL;
-				}
-				else
-				{
-					mtCOVERAGE_TEST_MARKER();
-				}
+			/* Ensure that blocks are always aligned to the required number
+			of bytes. */
+			if( ( xBlockSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+			{
+				/* Byte alignment required. */
+				xBlockSize += ( portBYTE_ALIGNMENT - ( xBlockSize & portBYTE_ALIGNMENT_MASK ) );
 			}
 			else
 			{
@@ -246,34 +348,143 @@ void *pvReturn = NULL;
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
 
-		traceMALLOC( pvReturn, xWantedSize );
+	return xBlockSize;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvAllocateBlock( BlockLink_t *pxPreviousBlock, const BlockLink_t *pxLastBlock, size_t xWantedSize )
+{
+BlockLink_t *pxBlock, *pxNewBlockLink;
+void *pvReturn = NULL;
+
+	/* Traverse the list from pxPreviousBlock until one of adequate size is
+	found. */
+	pxBlock = pxPreviousBlock->pxNextFreeBlock;
+	while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock != pxLastBlock ) )
+	{
+		pxPreviousBlock = pxBlock;
+		pxBlock = pxBlock->pxNextFreeBlock;
 	}
-	( void ) xTaskResumeAll();
 
-	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	/* If the end marker was reached then a block of adequate size was not
+	found. */
+	if( pxBlock != pxLastBlock )
 	{
-		if( pvReturn == NULL )
+		/* Return the memory space pointed to - jumping over the BlockLink_t
+		structure at its start. */
+		pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+
+		/* This block is being returned for use so must be taken out of the
+		list of free blocks. */
+		pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+		/* If the block is larger than required it can be split into two. */
+		if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
 		{
-			extern void vApplicationMallocFailedHook( void );
-			vApplicationMallocFailedHook();
+			/* This block is to be split into two.  Create a new block
+			following the number of bytes requested. The void cast is used to
+			prevent byte alignment warnings from the compiler. */
+			pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+
+			/* Calculate the sizes of two blocks split from the single
+			block. */
+			pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+			pxBlock->xBlockSize = xWantedSize;
+
+			/* Insert the new block into the list of free blocks. */
+			prvInsertBlockIntoFreeList( ( pxNewBlockLink ) );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+		if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+		{
+			xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
 		}
 		else
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
+
+		#if( configUSE_HEAP_CAPS == 1 )
+		{
+		HeapRegionState_t *pxRegion = prvRegionOfBlock( pxBlock );
+
+			pxRegion->xFreeBytesRemaining -= pxBlock->xBlockSize;
+			pxRegion->ulAllocations++;
+
+			if( pxRegion->xFreeBytesRemaining < pxRegion->xMinimumEverFreeBytesRemaining )
+			{
+				pxRegion->xMinimumEverFreeBytesRemaining = pxRegion->xFreeBytesRemaining;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_HEAP_CAPS */
+
+		/* The block is being returned - it is allocated and owned by the
+		application and has no "next" block. */
+		pxBlock->xBlockSize |= xBlockAllocatedBit;
+		pxBlock->pxNextFreeBlock = NULL;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
 	}
-	#endif
 
 	return pvReturn;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_HEAP_CAPS == 1 )
+
+	static HeapRegionState_t *prvRegionOfBlock( const BlockLink_t *pxBlock )
+	{
+	BaseType_t xRegion;
+
+		/* The regions are in address order, and a block is below the end
+		marker of its own region. */
+		for( xRegion = 0; xRegion < ( xHeapRegionCount - 1 ); xRegion++ )
+		{
+			if( pxBlock < xHeapRegionStates[ xRegion ].pxEnd )
+			{
+				break;
+			}
+		}
+
+		return &( xHeapRegionStates[ xRegion ] );
+	}
+
+#endif /* configUSE_HEAP_CAPS */
+/*-----------------------------------------------------------*/
+
 void vPortFree( void *pv )
 {
 uint8_t *puc = ( uint8_t * ) pv;
 BlockLink_t *pxLink;
 
+	#if( configUSE_TASK_ARENAS == 1 )
+	{
+		/* The blocks of an arena are released by vTaskArenaReset(). */
+		if( xTaskArenaFree( pv ) != pdFALSE )
+		{
+			pv = NULL;
+		}
+	}
+	#endif /* configUSE_TASK_ARENAS */
+
 	if( pv != NULL )
 	{
 		/* The memory being freed will have an BlockLink_t structure immediately
@@ -299,6 +510,13 @@ BlockLink_t *pxLink;
 				{
 					/* Add this block to the list of free blocks. */
 					xFreeBytesRemaining += pxLink->xBlockSize;
+
+					#if( configUSE_HEAP_CAPS == 1 )
+					{
+						prvRegionOfBlock( pxLink )->xFreeBytesRemaining += pxLink->xBlockSize;
+					}
+					#endif /* configUSE_HEAP_CAPS */
+
 					traceFREE( pv, pxLink->xBlockSize );
 					prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
 				}
@@ -329,6 +547,40 @@ size_t xPortGetMinimumEverFreeHeapSize( void )
 }
 /*-----------------------------------------------------------*/
 
+size_t xPortGetLargestFreeBlockSize( void )
+{
+BlockLink_t *pxBlock;
+size_t xLargestBlock = 0;
+
+	vTaskSuspendAll();
+	{
+		/* The list of free blocks does not exist before the heap has been
+		initialised. */
+		if( pxEnd != NULL )
+		{
+			for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+			{
+				if( pxBlock->xBlockSize > xLargestBlock )
+				{
+					xLargestBlock = pxBlock->xBlockSize;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return xLargestBlock;
+}
+/*-----------------------------------------------------------*/
+
 static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
 {
 BlockLink_t *pxIterator;
@@ -359,7 +611,9 @@ uint8_t *puc;
 	puc = ( uint8_t * ) pxBlockToInsert;
 	if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
 	{
-		if( pxIterator->pxNextFreeBlock != pxEnd )
+		/* The end marker of each region has a size of zero, and stays in the
+		list so the free blocks of each region can be found. */
+		if( pxIterator->pxNextFreeBlock->xBlockSize != ( size_t ) 0 )
 		{
 			/* Form one big block from the two blocks. */
 			pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
@@ -367,7 +621,7 @@ uint8_t *puc;
 		}
 		else
 		{
-			pxBlockToInsert->pxNextFreeBlock = pxEnd;
+			pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
 		}
 	}
 	else
@@ -468,6 +722,22 @@ const HeapRegion_t *pxHeapRegion;
 
 		xTotalHeapSize += pxFirstFreeBlockInRegion->xBlockSize;
 
+		#if( configUSE_HEAP_CAPS == 1 )
+		{
+			configASSERT( xDefinedRegions < ( BaseType_t ) configHEAP_MAX_REGIONS );
+
+			xHeapRegionStates[ xDefinedRegions ].pxStart = ( pxPreviousFreeBlock != NULL ) ? pxPreviousFreeBlock : &xStart;
+			xHeapRegionStates[ xDefinedRegions ].pxEnd = pxEnd;
+			xHeapRegionStates[ xDefinedRegions ].xSizeInBytes = pxFirstFreeBlockInRegion->xBlockSize;
+			xHeapRegionStates[ xDefinedRegions ].xFreeBytesRemaining = pxFirstFreeBlockInRegion->xBlockSize;
+			xHeapRegionStates[ xDefinedRegions ].xMinimumEverFreeBytesRemaining = pxFirstFreeBlockInRegion->xBlockSize;
+			xHeapRegionStates[ xDefinedRegions ].ulCaps = pxHeapRegion->ulCaps;
+			xHeapRegionStates[ xDefinedRegions ].ulAllocations = 0UL;
+			ulHeapRegionCaps |= pxHeapRegion->ulCaps;
+			xHeapRegionCount = xDefinedRegions + 1;
+		}
+		#endif /* configUSE_HEAP_CAPS */
+
 		/* Move onto the next HeapRegion_t structure. */
 		xDefinedRegions++;
 		pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
@@ -482,4 +752,54 @@ const HeapRegion_t *pxHeapRegion;
 	/* Work out the position of the top bit in a size_t variable. */
 	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
 }
+/*-----------------------------------------------------------*/
+
+#if( configUSE_HEAP_CAPS == 1 )
+
+	BaseType_t xPortGetHeapRegionStats( BaseType_t xRegion, HeapRegionStats_t *pxStats )
+	{
+	BaseType_t xReturn = pdFALSE;
+	const HeapRegionState_t *pxRegion;
+	BlockLink_t *pxBlock;
+
+		configASSERT( pxStats );
+
+		vTaskSuspendAll();
+		{
+			if( ( xRegion >= 0 ) && ( xRegion < xHeapRegionCount ) )
+			{
+				pxRegion = &( xHeapRegionStates[ xRegion ] );
+
+				pxStats->ulCaps = pxRegion->ulCaps;
+				pxStats->xSizeInBytes = pxRegion->xSizeInBytes;
+				pxStats->xFreeBytesRemaining = pxRegion->xFreeBytesRemaining;
+				pxStats->xMinimumEverFreeBytesRemaining = pxRegion->xMinimumEverFreeBytesRemaining;
+				pxStats->ulAllocations = pxRegion->ulAllocations;
+				pxStats->xLargestFreeBlockSize = 0;
+
+				for( pxBlock = pxRegion->pxStart->pxNextFreeBlock; pxBlock != pxRegion->pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+				{
+					if( pxBlock->xBlockSize > pxStats->xLargestFreeBlockSize )
+					{
+						pxStats->xLargestFreeBlockSize = pxBlock->xBlockSize;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+
+				xReturn = pdTRUE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		return xReturn;
+	}
+
+#endif /* configUSE_HEAP_CAPS */
 
@@ -0,0 +1,712 @@
+/*
+ * FreeRTOS Kernel V10.2.0
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A sample implementation of pvPortMalloc() and vPortFree() that execute in
+ * constant time, using a two-level segregated fit (TLSF) allocator.  Like
+ * heap_5.c, the heap can be defined across multiple non-contiguous blocks, and
+ * adjacent memory blocks are combined (coalesced) as they are freed.
+ *
+ * The free blocks are kept in an array of lists.  The first level index is
+ * the position of the highest set bit of the block size, the second level
+ * divides each power of two range into heapSL_INDEX_COUNT linear steps.  Two
+ * bitmaps record which lists hold blocks, so that a suitable free block is
+ * found with two find-first-set operations, in stead of walking a list of
+ * free blocks as heap_4.c and heap_5.c do.  A block has a pointer to the block
+ * that physically precedes it, so that a freed block is merged with both of
+ * its neighbours without walking a list either.
+ *
+ * The cost is a little extra memory: each block has an overhead of two
+ * pointers in stead of one pointer and a size, and a request may be served
+ * from a block that is up to 1 / heapSL_INDEX_COUNT larger than necessary.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of http://www.FreeRTOS.org
+ * for more information.
+ *
+ * Usage notes:
+ *
+ * vPortDefineHeapRegions() ***must*** be called before pvPortMalloc(), exactly
+ * as with heap_5.c.  The parameter is an array of HeapRegion_t structures,
+ * terminated by a NULL zero sized region definition:
+ *
+ * HeapRegion_t xHeapRegions[] =
+ * {
+ * 	{ ( uint8_t * ) 0x80000000UL, 0x10000 }, << Defines a block of 0x10000 bytes starting at address 0x80000000
+ * 	{ ( uint8_t * ) 0x90000000UL, 0xa0000 }, << Defines a block of 0xa0000 bytes starting at address of 0x90000000
+ * 	{ NULL, 0 }                << Terminates the array.
+ * };
+ *
+ * vPortDefineHeapRegions( xHeapRegions ); << Pass the array into vPortDefineHeapRegions().
+ *
+ * A single region must be smaller than heapMAX_BLOCK_SIZE (1 GB).
+ *
+ * The position of the highest set bit is found with __builtin_clz() when GCC
+ * is used.  Other compilers can define heapFIND_LAST_SET() in FreeRTOSConfig.h,
+ * for instance as ( 31 - __CLZ( x ) ) on ARM Cortex-M.  Otherwise a portable
+ * version is used, which takes 5 steps.
+ */
+#include <stdlib.h>
+#include <stddef.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* All block sizes and addresses are a multiple of heapGRANULE bytes.  The
+linear steps of the first level are this size as well. */
+#define heapGRANULE_LOG2		( 3 )
+#define heapGRANULE				( ( size_t ) 1 << heapGRANULE_LOG2 )
+#define heapGRANULE_MASK		( heapGRANULE - ( size_t ) 1 )
+
+#if( portBYTE_ALIGNMENT > 8 )
+	#error heap_6.c supports a portBYTE_ALIGNMENT of at most 8
+#endif
+
+/* Each power of two range is divided into 2 ^ heapSL_INDEX_COUNT_LOG2 lists. */
+#define heapSL_INDEX_COUNT_LOG2	( 4 )
+#define heapSL_INDEX_COUNT		( 1 << heapSL_INDEX_COUNT_LOG2 )
+
+/* Blocks smaller than heapSMALL_BLOCK_SIZE are all stored in the first level
+index 0, in lists that are heapGRANULE bytes apart. */
+#define heapFL_INDEX_SHIFT		( heapSL_INDEX_COUNT_LOG2 + heapGRANULE_LOG2 )
+#define heapSMALL_BLOCK_SIZE	( ( size_t ) 1 << heapFL_INDEX_SHIFT )
+
+/* Blocks can be at most 2 ^ heapFL_INDEX_MAX bytes. */
+#define heapFL_INDEX_MAX		( 30 )
+#define heapFL_INDEX_COUNT		( heapFL_INDEX_MAX - heapFL_INDEX_SHIFT + 1 )
+#define heapMAX_BLOCK_SIZE		( ( size_t ) 1 << heapFL_INDEX_MAX )
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE		( ( size_t ) 8 )
+
+#ifndef heapFIND_LAST_SET
+	#if defined( __GNUC__ )
+		#define heapFIND_LAST_SET( ulValue )	( 31 - ( BaseType_t ) __builtin_clz( ( unsigned int ) ( ulValue ) ) )
+	#else
+		#define heapFIND_LAST_SET( ulValue )	prvFindLastSet( ulValue )
+		#define heapUSE_PORTABLE_FIND_LAST_SET	1
+	#endif
+#endif
+
+#ifndef heapUSE_PORTABLE_FIND_LAST_SET
+	#define heapUSE_PORTABLE_FIND_LAST_SET	0
+#endif
+
+/* The lowest set bit is the highest set bit of the value with all other bits
+cleared. */
+#define heapFIND_FIRST_SET( ulValue )	heapFIND_LAST_SET( ( ulValue ) & ( ~( ulValue ) + 1u ) )
+
+/* The header of a block.  The first two fields are present in every block,
+the free list links are only used while the block is free; they overlap the
+memory that is handed to the application. */
+typedef struct A_BLOCK_LINK
+{
+	struct A_BLOCK_LINK *pxPreviousPhysicalBlock;	/*<< The block just below this one in memory, or NULL. */
+	size_t xBlockSize;								/*<< The size of the block, including this header. */
+	struct A_BLOCK_LINK *pxNextFreeBlock;			/*<< The next block in the same free list. */
+	struct A_BLOCK_LINK *pxPreviousFreeBlock;		/*<< The previous block in the same free list. */
+} BlockLink_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Find the lists in which a free block of the given size is stored.
+ */
+static void prvMappingInsert( size_t xSize, BaseType_t *pxFirstLevel, BaseType_t *pxSecondLevel );
+
+/*
+ * Find the first list in which every free block is at least 'xSize' bytes,
+ * and take a block from it, or from any list of larger blocks.  Returns NULL
+ * when there is no free block that is large enough.
+ */
+static BlockLink_t *prvTakeSuitableBlock( size_t xSize );
+
+/*
+ * Add a free block to, or remove a free block from its free list.
+ */
+static void prvInsertFreeBlock( BlockLink_t *pxBlock );
+static void prvRemoveFreeBlock( BlockLink_t *pxBlock );
+
+#if( heapUSE_PORTABLE_FIND_LAST_SET != 0 )
+	/*
+	 * Return the position of the highest set bit of a non-zero value.
+	 */
+	static BaseType_t prvFindLastSet( uint32_t ulValue );
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* The size of the part of the header that is present in allocated blocks.  It
+must be correctly byte aligned. */
+static const size_t xHeapStructSize	= ( offsetof( BlockLink_t, pxNextFreeBlock ) + heapGRANULE_MASK ) & ~heapGRANULE_MASK;
+
+/* A free block must be able to hold the complete header. */
+static const size_t xMinimumBlockSize = ( sizeof( BlockLink_t ) + heapGRANULE_MASK ) & ~heapGRANULE_MASK;
+
+/* The free lists and the bitmaps that record which lists are not empty. */
+static BlockLink_t *pxFreeLists[ heapFL_INDEX_COUNT ][ heapSL_INDEX_COUNT ];
+static uint32_t ulFirstLevelBitmap = 0U;
+static uint32_t ulSecondLevelBitmaps[ heapFL_INDEX_COUNT ];
+
+/* Keeps track of the number of free bytes remaining, but says nothing about
+fragmentation. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+
+/* Gets set to the top bit of an size_t type.  When this bit in the xBlockSize
+member of an BlockLink_t structure is set then the block belongs to the
+application, or it is the end marker of a region.  When the bit is free the
+block is still part of the free heap space. */
+static size_t xBlockAllocatedBit = 0;
+
+/*-----------------------------------------------------------*/
+
+#if( heapUSE_PORTABLE_FIND_LAST_SET != 0 )
+
+	static BaseType_t prvFindLastSet( uint32_t ulValue )
+	{
+	BaseType_t xBit = 31;
+
+		if( ( ulValue & 0xffff0000UL ) == 0UL )
+		{
+			ulValue <<= 16;
+			xBit -= 16;
+		}
+		if( ( ulValue & 0xff000000UL ) == 0UL )
+		{
+			ulValue <<= 8;
+			xBit -= 8;
+		}
+		if( ( ulValue & 0xf0000000UL ) == 0UL )
+		{
+			ulValue <<= 4;
+			xBit -= 4;
+		}
+		if( ( ulValue & 0xc0000000UL ) == 0UL )
+		{
+			ulValue <<= 2;
+			xBit -= 2;
+		}
+		if( ( ulValue & 0x80000000UL ) == 0UL )
+		{
+			xBit -= 1;
+		}
+
+		return xBit;
+	}
+
+#endif /* heapUSE_PORTABLE_FIND_LAST_SET */
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize, BaseType_t *pxFirstLevel, BaseType_t *pxSecondLevel )
+{
+BaseType_t xFirstLevel, xSecondLevel;
+
+	if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		xFirstLevel = 0;
+		xSecondLevel = ( BaseType_t ) ( xSize >> heapGRANULE_LOG2 );
+	}
+	else
+	{
+		xFirstLevel = heapFIND_LAST_SET( ( uint32_t ) xSize );
+		xSecondLevel = ( BaseType_t ) ( ( xSize >> ( xFirstLevel - heapSL_INDEX_COUNT_LOG2 ) ) ^ ( ( size_t ) 1 << heapSL_INDEX_COUNT_LOG2 ) );
+		xFirstLevel -= ( heapFL_INDEX_SHIFT - 1 );
+	}
+
+	*pxFirstLevel = xFirstLevel;
+	*pxSecondLevel = xSecondLevel;
+}
+/*-----------------------------------------------------------*/
+
+static BlockLink_t *prvTakeSuitableBlock( size_t xSize )
+{
+BaseType_t xFirstLevel, xSecondLevel;
+uint32_t ulMap;
+BlockLink_t *pxBlock = NULL;
+
+	/* Round the size up to the next list boundary, so that every block in the
+	list found is large enough.  Below heapSMALL_BLOCK_SIZE, each list holds
+	blocks of a single size. */
+	if( xSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xSize += ( ( size_t ) 1 << ( heapFIND_LAST_SET( ( uint32_t ) xSize ) - heapSL_INDEX_COUNT_LOG2 ) ) - 1u;
+	}
+
+	prvMappingInsert( xSize, &xFirstLevel, &xSecondLevel );
+
+	if( xFirstLevel < heapFL_INDEX_COUNT )
+	{
+		/* Look for a list in the same power of two range first. */
+		ulMap = ulSecondLevelBitmaps[ xFirstLevel ] & ( ~0UL << xSecondLevel );
+
+		if( ulMap == 0UL )
+		{
+			/* Take the smallest block of any larger range. */
+			ulMap = ulFirstLevelBitmap & ( ~0UL << ( xFirstLevel + 1 ) );
+
+			if( ulMap != 0UL )
+			{
+				xFirstLevel = heapFIND_FIRST_SET( ulMap );
+				ulMap = ulSecondLevelBitmaps[ xFirstLevel ];
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( ulMap != 0UL )
+		{
+			xSecondLevel = heapFIND_FIRST_SET( ulMap );
+			pxBlock = pxFreeLists[ xFirstLevel ][ xSecondLevel ];
+			prvRemoveFreeBlock( pxBlock );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( BlockLink_t *pxBlock )
+{
+BaseType_t xFirstLevel, xSecondLevel;
+
+	prvMappingInsert( pxBlock->xBlockSize, &xFirstLevel, &xSecondLevel );
+
+	pxBlock->pxPreviousFreeBlock = NULL;
+	pxBlock->pxNextFreeBlock = pxFreeLists[ xFirstLevel ][ xSecondLevel ];
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPreviousFreeBlock = pxBlock;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	pxFreeLists[ xFirstLevel ][ xSecondLevel ] = pxBlock;
+	ulFirstLevelBitmap |= ( 1UL << xFirstLevel );
+	ulSecondLevelBitmaps[ xFirstLevel ] |= ( 1UL << xSecondLevel );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( BlockLink_t *pxBlock )
+{
+BaseType_t xFirstLevel, xSecondLevel;
+
+	prvMappingInsert( pxBlock->xBlockSize, &xFirstLevel, &xSecondLevel );
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPreviousFreeBlock = pxBlock->pxPreviousFreeBlock;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	if( pxBlock->pxPreviousFreeBlock != NULL )
+	{
+		pxBlock->pxPreviousFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		/* The block was the head of its list. */
+		pxFreeLists[ xFirstLevel ][ xSecondLevel ] = pxBlock->pxNextFreeBlock;
+
+		if( pxBlock->pxNextFreeBlock == NULL )
+		{
+			ulSecondLevelBitmaps[ xFirstLevel ] &= ~( 1UL << xSecondLevel );
+
+			if( ulSecondLevelBitmaps[ xFirstLevel ] == 0UL )
+			{
+				ulFirstLevelBitmap &= ~( 1UL << xFirstLevel );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+	pxBlock->pxNextFreeBlock = NULL;
+	pxBlock->pxPreviousFreeBlock = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+BlockLink_t *pxBlock, *pxNewBlockLink, *pxNextBlock;
+void *pvReturn = NULL;
+
+	#if( configUSE_TASK_ARENAS == 1 )
+	{
+		/* A task that has an arena bound to it is served from that arena, the
+		heap is only used when the arena is full. */
+		pvReturn = pvTaskArenaMalloc( xWantedSize );
+
+		if( pvReturn != NULL )
+		{
+			return pvReturn;
+		}
+	}
+	#endif /* configUSE_TASK_ARENAS */
+
+	/* The heap must be initialised before the first call to
+	prvPortMalloc(). */
+	configASSERT( xBlockAllocatedBit );
+
+	vTaskSuspendAll();
+	{
+		/* Check the requested block size is not so large that it can not be
+		stored in any of the free lists. */
+		if( ( xWantedSize > 0 ) && ( xWantedSize < ( heapMAX_BLOCK_SIZE - xMinimumBlockSize ) ) )
+		{
+			/* The wanted size is increased so it can contain the header, and
+			it is rounded up to a whole number of granules. */
+			xWantedSize += xHeapStructSize;
+			xWantedSize = ( xWantedSize + heapGRANULE_MASK ) & ~heapGRANULE_MASK;
+
+			if( xWantedSize < xMinimumBlockSize )
+			{
+				xWantedSize = xMinimumBlockSize;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			if( xWantedSize <= xFreeBytesRemaining )
+			{
+				pxBlock = prvTakeSuitableBlock( xWantedSize );
+			}
+			else
+			{
+				pxBlock = NULL;
+			}
+
+			if( pxBlock != NULL )
+			{
+				/* If the block is larger than required it can be split into
+				two. */
+				if( ( pxBlock->xBlockSize - xWantedSize ) >= xMinimumBlockSize )
+				{
+					pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+					pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+					pxNewBlockLink->pxPreviousPhysicalBlock = pxBlock;
+					pxBlock->xBlockSize = xWantedSize;
+
+					/* The block beyond the new one now has a different
+					neighbour.  The end marker of a region has no size. */
+					pxNextBlock = ( void * ) ( ( ( uint8_t * ) pxNewBlockLink ) + pxNewBlockLink->xBlockSize );
+					pxNextBlock->pxPreviousPhysicalBlock = pxNewBlockLink;
+
+					prvInsertFreeBlock( pxNewBlockLink );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				/* The block is being returned - it is allocated and owned by
+				the application. */
+				pxBlock->xBlockSize |= xBlockAllocatedBit;
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+uint8_t *puc = ( uint8_t * ) pv;
+BlockLink_t *pxLink, *pxNeighbour;
+
+	#if( configUSE_TASK_ARENAS == 1 )
+	{
+		/* The blocks of an arena are released by vTaskArenaReset(). */
+		if( xTaskArenaFree( pv ) != pdFALSE )
+		{
+			pv = NULL;
+		}
+	}
+	#endif /* configUSE_TASK_ARENAS */
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have the header of its block immediately
+		before it. */
+		puc -= xHeapStructSize;
+
+		/* This casting is to keep the compiler from issuing warnings. */
+		pxLink = ( void * ) puc;
+
+		/* Check the block is actually allocated. */
+		configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
+
+		if( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 )
+		{
+			vTaskSuspendAll();
+			{
+				/* The block is being returned to the heap - it is no longer
+				allocated. */
+				pxLink->xBlockSize &= ~xBlockAllocatedBit;
+				xFreeBytesRemaining += pxLink->xBlockSize;
+				traceFREE( pv, pxLink->xBlockSize );
+
+				/* Merge with the block above, if it is free.  The end marker
+				of a region is never free. */
+				pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxLink ) + pxLink->xBlockSize );
+				if( ( pxNeighbour->xBlockSize & xBlockAllocatedBit ) == 0 )
+				{
+					prvRemoveFreeBlock( pxNeighbour );
+					pxLink->xBlockSize += pxNeighbour->xBlockSize;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				/* Merge with the block below, if there is one and it is
+				free. */
+				pxNeighbour = pxLink->pxPreviousPhysicalBlock;
+				if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & xBlockAllocatedBit ) == 0 ) )
+				{
+					prvRemoveFreeBlock( pxNeighbour );
+					pxNeighbour->xBlockSize += pxLink->xBlockSize;
+					pxLink = pxNeighbour;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				/* Let the block above point to the combined block. */
+				pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxLink ) + pxLink->xBlockSize );
+				pxNeighbour->pxPreviousPhysicalBlock = pxLink;
+
+				prvInsertFreeBlock( pxLink );
+			}
+			( void ) xTaskResumeAll();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetLargestFreeBlockSize( void )
+{
+BlockLink_t *pxBlock;
+BaseType_t xFirstLevel, xSecondLevel;
+size_t xLargestBlock = 0;
+
+	vTaskSuspendAll();
+	{
+		/* The largest block is in the highest list that is not empty.  The
+		blocks of a list are not sorted by size, so the list is searched. */
+		if( ulFirstLevelBitmap != 0UL )
+		{
+			xFirstLevel = heapFIND_LAST_SET( ulFirstLevelBitmap );
+			xSecondLevel = heapFIND_LAST_SET( ulSecondLevelBitmaps[ xFirstLevel ] );
+
+			for( pxBlock = pxFreeLists[ xFirstLevel ][ xSecondLevel ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+			{
+				if( pxBlock->xBlockSize > xLargestBlock )
+				{
+					xLargestBlock = pxBlock->xBlockSize;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return xLargestBlock;
+}
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+BlockLink_t *pxFirstFreeBlockInRegion, *pxEnd;
+size_t xAlignedHeap;
+size_t xTotalRegionSize, xTotalHeapSize = 0;
+BaseType_t xDefinedRegions = 0;
+size_t xAddress;
+const HeapRegion_t *pxHeapRegion;
+
+	/* Can only call once! */
+	configASSERT( xBlockAllocatedBit == 0 );
+
+	/* Work out the position of the top bit in a size_t variable. */
+	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
+
+	pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+
+	while( pxHeapRegion->xSizeInBytes > 0 )
+	{
+		xTotalRegionSize = pxHeapRegion->xSizeInBytes;
+
+		/* Ensure the heap region starts on a correctly aligned boundary. */
+		xAddress = ( size_t ) pxHeapRegion->pucStartAddress;
+		if( ( xAddress & heapGRANULE_MASK ) != 0 )
+		{
+			xAddress += heapGRANULE_MASK;
+			xAddress &= ~heapGRANULE_MASK;
+
+			/* Adjust the size for the bytes lost to alignment. */
+			xTotalRegionSize -= xAddress - ( size_t ) pxHeapRegion->pucStartAddress;
+		}
+
+		xAlignedHeap = xAddress;
+
+		/* The end marker is inserted at the end of the region space.  It
+		looks like an allocated block without size, so that the last block of
+		the region is never merged with anything beyond it. */
+		xAddress = xAlignedHeap + xTotalRegionSize;
+		xAddress -= xHeapStructSize;
+		xAddress &= ~heapGRANULE_MASK;
+		pxEnd = ( BlockLink_t * ) xAddress;
+
+		/* To start with there is a single free block in this region that is
+		sized to take up the entire heap region minus the space taken by the
+		end marker. */
+		pxFirstFreeBlockInRegion = ( BlockLink_t * ) xAlignedHeap;
+		pxFirstFreeBlockInRegion->pxPreviousPhysicalBlock = NULL;
+		pxFirstFreeBlockInRegion->xBlockSize = xAddress - xAlignedHeap;
+
+		/* Check the region can be stored in the free lists. */
+		configASSERT( pxFirstFreeBlockInRegion->xBlockSize >= xMinimumBlockSize );
+		configASSERT( pxFirstFreeBlockInRegion->xBlockSize < heapMAX_BLOCK_SIZE );
+
+		pxEnd->pxPreviousPhysicalBlock = pxFirstFreeBlockInRegion;
+		pxEnd->xBlockSize = xBlockAllocatedBit;
+
+		prvInsertFreeBlock( pxFirstFreeBlockInRegion );
+
+		xTotalHeapSize += pxFirstFreeBlockInRegion->xBlockSize;
+
+		/* Move onto the next HeapRegion_t structure. */
+		xDefinedRegions++;
+		pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+	}
+
+	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
+	xFreeBytesRemaining = xTotalHeapSize;
+
+	/* Check something was actually defined before it is accessed. */
+	configASSERT( xTotalHeapSize );
+}
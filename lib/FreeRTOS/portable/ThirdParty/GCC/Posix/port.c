@@ -0,0 +1,521 @@
+/*
+ * FreeRTOS Kernel V10.2.0
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A port that runs FreeRTOS as a Linux (or other POSIX) process, modeled on
+ * the MSVC-MingW Windows simulator port.  Every task executes in its own
+ * pthread, but only the thread of the task that is in the Running state is
+ * ever allowed to execute, all the other task threads wait on a semaphore.
+ *
+ * Simulated interrupts are delivered as signals.  The tick is generated by an
+ * interval timer that raises SIGALRM, and vPortGenerateSimulatedInterrupt()
+ * raises SIGUSR1.  Both signals are blocked in every thread except the thread
+ * of the running task, so the signal handler always executes in the context of
+ * the running task, exactly as an interrupt would.  Critical sections block
+ * the signals in the running thread.
+ *
+ * As with the Windows port, host library functions that take locks, such as
+ * printf() and malloc(), must not be called from several tasks unless the
+ * calls are protected by a critical section or by suspending the scheduler.
+ * A task that is switched out while it holds such a lock causes the next task
+ * that tries to take it to block the whole simulation.
+ */
+
+/* pthread_setname_np() is a GNU extension. */
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define portMAX_INTERRUPTS				( ( uint32_t ) sizeof( uint32_t ) * 8UL ) /* The number of bits in an uint32_t. */
+#define portNO_CRITICAL_NESTING 		( ( uint32_t ) 0 )
+
+/* The signals used to simulate the tick interrupt and all the other
+interrupts. */
+#define portTICK_SIGNAL					SIGALRM
+#define portINTERRUPT_SIGNAL			SIGUSR1
+
+/*-----------------------------------------------------------*/
+
+/* The POSIX simulator runs each task in a thread.  The context switching is
+managed by the threads, so the task stack does not have to be managed directly,
+although the task stack is still used to hold an xThreadState structure this is
+the only thing it will ever hold.  The structure indirectly maps the task handle
+to a thread handle. */
+typedef struct
+{
+	/* Handle of the thread that executes the task. */
+	pthread_t xThread;
+
+	/* Posted to let the thread run, the thread waits on it while its task is
+	not in the Running state. */
+	sem_t xWakeSemaphore;
+
+	/* Set by vPortDeleteThread() to make the thread exit when it wakes. */
+	volatile BaseType_t xDying;
+
+	/* The task function and its parameter. */
+	TaskFunction_t pxCode;
+	void *pvParameters;
+
+} xThreadState;
+
+/*
+ * The start routine of every task thread.  Waits until the task is selected
+ * to run for the first time, then enables the simulated interrupts and calls
+ * the task function.
+ */
+static void *prvTaskThread( void *pvParameters );
+
+/*
+ * Waits until the thread is allowed to run again, or exits the thread when its
+ * task was deleted.
+ */
+static void prvWaitToRun( xThreadState *pxThreadState );
+
+/*
+ * Lets the thread of the task now in pxCurrentTCB run, and stops the thread
+ * that called it until its own task is selected again.
+ */
+static void prvSwitchThread( void *pvOldCurrentTCB );
+
+/*
+ * The handler of both signals, processes all the simulated interrupts that are
+ * pending - each represented by a bit in ulPendingInterrupts variable.
+ */
+static void prvProcessSimulatedInterrupts( int iSignal );
+
+/*
+ * Interrupt handlers used by the kernel itself.  These are executed from the
+ * simulated interrupt handler.
+ */
+static uint32_t prvProcessYieldInterrupt( void );
+static uint32_t prvProcessTickInterrupt( void );
+
+/*-----------------------------------------------------------*/
+
+/* Simulated interrupts waiting to be processed.  This is a bit mask where each
+bit represents one interrupt, so a maximum of 32 interrupts can be simulated.
+It is written by host threads too, so it is only accessed atomically. */
+static volatile uint32_t ulPendingInterrupts = 0UL;
+
+/* The critical nesting count of the task that executes in the calling thread.
+Every task has its own thread, so a thread local variable keeps the count of
+every task separately.  Threads that are not running a task yet behave as if
+they were always in a critical section. */
+static __thread uint32_t ulCriticalNesting = 9999UL;
+
+/* The set that contains the two signals used by this port. */
+static sigset_t xSimulatedInterruptSignals;
+
+/* Handlers for all the simulated software interrupts.  The first two positions
+are used for the Yield and Tick interrupts so are handled slightly differently,
+all the other interrupts can be user defined. */
+static uint32_t (*ulIsrHandler[ portMAX_INTERRUPTS ])( void ) = { 0 };
+
+/* Pointer to the TCB of the currently executing task. */
+extern void *pxCurrentTCB;
+
+/* Used to ensure nothing is processed during the startup sequence. */
+static volatile BaseType_t xPortRunning = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+xThreadState *pxThreadState = NULL;
+int8_t *pcTopOfStack = ( int8_t * ) pxTopOfStack;
+sigset_t xAllSignals, xPreviousSignals;
+int iResult;
+
+	/* In this simulated case a stack is not initialised, but instead a thread
+	is created that will execute the task being created.  The thread handles
+	the context switching itself.  The xThreadState object is placed onto
+	the stack that was created for the task - so the stack buffer is still
+	used, just not in the conventional way.  It will not be used for anything
+	other than holding this structure. */
+	pxThreadState = ( xThreadState * ) ( ( size_t ) ( pcTopOfStack - sizeof( xThreadState ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) );
+	pxThreadState->xDying = pdFALSE;
+	pxThreadState->pxCode = pxCode;
+	pxThreadState->pvParameters = pvParameters;
+
+	iResult = sem_init( &( pxThreadState->xWakeSemaphore ), 0, 0 );
+	configASSERT( iResult == 0 );
+
+	/* The new thread inherits the signal mask of the calling thread, it must
+	not receive the simulated interrupts before its task runs. */
+	sigfillset( &xAllSignals );
+	pthread_sigmask( SIG_SETMASK, &xAllSignals, &xPreviousSignals );
+
+	/* Create the thread itself. */
+	iResult = pthread_create( &( pxThreadState->xThread ), NULL, prvTaskThread, pxThreadState );
+	configASSERT( iResult == 0 ); /* See comment where pthread_join() is called. */
+
+	pthread_sigmask( SIG_SETMASK, &xPreviousSignals, NULL );
+
+	( void ) iResult;
+
+	return ( StackType_t * ) pxThreadState;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvTaskThread( void *pvParameters )
+{
+xThreadState *pxThreadState = ( xThreadState * ) pvParameters;
+sigset_t xNoSignals;
+
+	/* The thread was created with all signals blocked, so it cannot receive
+	a simulated interrupt while it waits for its task to run.  Host signals
+	such as SIGINT are handled by the other threads meanwhile. */
+	prvWaitToRun( pxThreadState );
+
+	#if defined( __GLIBC__ )
+	{
+		/* Name the thread after its task, so host tools such as perf, gdb
+		and top show the task names. */
+		pthread_setname_np( pthread_self(), pcTaskGetName( NULL ) );
+	}
+	#endif
+
+	/* The task starts with interrupts enabled. */
+	ulCriticalNesting = portNO_CRITICAL_NESTING;
+	sigemptyset( &xNoSignals );
+	pthread_sigmask( SIG_SETMASK, &xNoSignals, NULL );
+
+	pxThreadState->pxCode( pxThreadState->pvParameters );
+
+	/* A task function must not return. */
+	configASSERT( pdFALSE );
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaitToRun( xThreadState *pxThreadState )
+{
+	while( sem_wait( &( pxThreadState->xWakeSemaphore ) ) != 0 )
+	{
+		/* Interrupted by a host signal, wait again. */
+		configASSERT( errno == EINTR );
+	}
+
+	if( pxThreadState->xDying != pdFALSE )
+	{
+		pthread_exit( NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchThread( void *pvOldCurrentTCB )
+{
+xThreadState *pxOldThreadState, *pxNewThreadState;
+
+	/* If the task selected to enter the running state is not the task that is
+	already in the running state. */
+	if( pvOldCurrentTCB != pxCurrentTCB )
+	{
+		pxOldThreadState = ( xThreadState * ) *( ( size_t * ) pvOldCurrentTCB );
+		pxNewThreadState = ( xThreadState * ) *( ( size_t * ) pxCurrentTCB );
+
+		/* Let the new thread run, then stop this one.  The semaphore is
+		counting, so it does not matter if the new thread switches back to
+		this one before it actually waits. */
+		sem_post( &( pxNewThreadState->xWakeSemaphore ) );
+		prvWaitToRun( pxOldThreadState );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+struct sigaction xAction;
+struct itimerval xTimer;
+xThreadState *pxThreadState = NULL;
+suseconds_t xTickPeriodMicroseconds;
+
+	sigemptyset( &xSimulatedInterruptSignals );
+	sigaddset( &xSimulatedInterruptSignals, portTICK_SIGNAL );
+	sigaddset( &xSimulatedInterruptSignals, portINTERRUPT_SIGNAL );
+
+	/* This thread only waits from now on, it must never receive a simulated
+	interrupt. */
+	pthread_sigmask( SIG_BLOCK, &xSimulatedInterruptSignals, NULL );
+
+	/* Install the interrupt handlers used by the scheduler itself. */
+	vPortSetInterruptHandler( portINTERRUPT_YIELD, prvProcessYieldInterrupt );
+	vPortSetInterruptHandler( portINTERRUPT_TICK, prvProcessTickInterrupt );
+
+	/* Both signals are blocked while either handler runs, so the simulated
+	interrupts do not nest. */
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvProcessSimulatedInterrupts;
+	xAction.sa_mask = xSimulatedInterruptSignals;
+	xAction.sa_flags = SA_RESTART;
+
+	if( ( sigaction( portTICK_SIGNAL, &xAction, NULL ) != 0 ) ||
+		( sigaction( portINTERRUPT_SIGNAL, &xAction, NULL ) != 0 ) )
+	{
+		printf( "sigaction() failed\r\n" );
+		return pdFAIL;
+	}
+
+	/* Start the interval timer that simulates the timer peripheral.  Timer
+	signals are not queued, so ticks are only lost when the host is too busy
+	to run the simulation at all. */
+	xTickPeriodMicroseconds = ( suseconds_t ) ( 1000000UL / configTICK_RATE_HZ );
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = xTickPeriodMicroseconds;
+	xTimer.it_value = xTimer.it_interval;
+
+	xPortRunning = pdTRUE;
+
+	if( setitimer( ITIMER_REAL, &xTimer, NULL ) != 0 )
+	{
+		printf( "setitimer() failed\r\n" );
+		return pdFAIL;
+	}
+
+	/* Start the highest priority task by obtaining its associated thread
+	state structure, in which is stored the thread handle. */
+	pxThreadState = ( xThreadState * ) *( ( size_t * ) pxCurrentTCB );
+	sem_post( &( pxThreadState->xWakeSemaphore ) );
+
+	/* The tasks run in their own threads, this thread has nothing left to do
+	until vPortEndScheduler() ends the process. */
+	for( ;; )
+	{
+		pause();
+	}
+
+	/* Would not expect to return from the loop above, so should not get
+	here. */
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvProcessYieldInterrupt( void )
+{
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvProcessTickInterrupt( void )
+{
+uint32_t ulSwitchRequired;
+
+	/* Process the tick itself. */
+	configASSERT( xPortRunning );
+	ulSwitchRequired = ( uint32_t ) xTaskIncrementTick();
+
+	return ulSwitchRequired;
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessSimulatedInterrupts( int iSignal )
+{
+uint32_t ulSwitchRequired, ulPending, i;
+int iSavedErrno = errno;
+
+	if( iSignal == portTICK_SIGNAL )
+	{
+		/* The timer has expired, generate the simulated tick event. */
+		__atomic_fetch_or( &ulPendingInterrupts, ( 1UL << portINTERRUPT_TICK ), __ATOMIC_SEQ_CST );
+	}
+
+	/* Take all the pending interrupts at once, host threads may raise new
+	ones at any time. */
+	ulPending = __atomic_exchange_n( &ulPendingInterrupts, 0UL, __ATOMIC_SEQ_CST );
+
+	/* Used to indicate whether the simulated interrupt processing has
+	necessitated a context switch to another task/thread. */
+	ulSwitchRequired = pdFALSE;
+
+	/* For each interrupt we are interested in processing, each of which is
+	represented by a bit in the 32bit ulPendingInterrupts variable. */
+	for( i = 0; i < portMAX_INTERRUPTS; i++ )
+	{
+		/* Is the simulated interrupt pending and is a handler installed? */
+		if( ( ( ulPending & ( 1UL << i ) ) != 0UL ) && ( ulIsrHandler[ i ] != NULL ) )
+		{
+			/* Run the actual handler. */
+			if( ulIsrHandler[ i ]() != pdFALSE )
+			{
+				ulSwitchRequired |= ( 1 << i );
+			}
+		}
+	}
+
+	if( ulSwitchRequired != pdFALSE )
+	{
+		void *pvOldCurrentTCB;
+
+		pvOldCurrentTCB = pxCurrentTCB;
+
+		/* Select the next task to run. */
+		vTaskSwitchContext();
+
+		/* The signal handler returns when the interrupted task runs again,
+		which restores its signal mask. */
+		prvSwitchThread( pvOldCurrentTCB );
+	}
+
+	errno = iSavedErrno;
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+void *pvOldCurrentTCB;
+
+	/* Same as the yield interrupt, but without raising a signal.  The
+	critical section stops a tick from switching tasks at the same time, and it
+	is restored when this task runs again. */
+	vPortEnterCritical();
+	{
+		pvOldCurrentTCB = pxCurrentTCB;
+		vTaskSwitchContext();
+		prvSwitchThread( pvOldCurrentTCB );
+	}
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDeleteThread( void *pvTaskToDelete )
+{
+xThreadState *pxThreadState;
+int iResult;
+
+	/* Find the handle of the thread being deleted. */
+	pxThreadState = ( xThreadState * ) ( *( size_t *) pvTaskToDelete );
+
+	/* The thread is waiting in prvWaitToRun(), either because a different
+	task is running or because the task deleted itself.  Wake the thread so it
+	exits, and wait for it to have exited before the stack that holds the
+	thread state is freed. */
+	pxThreadState->xDying = pdTRUE;
+	sem_post( &( pxThreadState->xWakeSemaphore ) );
+
+	iResult = pthread_join( pxThreadState->xThread, NULL );
+	configASSERT( iResult == 0 );
+
+	sem_destroy( &( pxThreadState->xWakeSemaphore ) );
+
+	( void ) iResult;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+struct itimerval xTimer;
+
+	/* Stop the simulated timer peripheral, then end the process so profilers
+	and coverage tools see a normal exit. */
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	exit( 0 );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGenerateSimulatedInterrupt( uint32_t ulInterruptNumber )
+{
+	configASSERT( xPortRunning );
+
+	if( ulInterruptNumber < portMAX_INTERRUPTS )
+	{
+		__atomic_fetch_or( &ulPendingInterrupts, ( 1UL << ulInterruptNumber ), __ATOMIC_SEQ_CST );
+
+		/* The signal is delivered to the thread of the running task, or held
+		pending until that thread leaves its critical section. */
+		kill( getpid(), portINTERRUPT_SIGNAL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetInterruptHandler( uint32_t ulInterruptNumber, uint32_t (*pvHandler)( void ) )
+{
+	if( ulInterruptNumber < portMAX_INTERRUPTS )
+	{
+		/* A pointer assignment is atomic on every host this port supports. */
+		ulIsrHandler[ ulInterruptNumber ] = pvHandler;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	pthread_sigmask( SIG_BLOCK, &xSimulatedInterruptSignals, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	pthread_sigmask( SIG_UNBLOCK, &xSimulatedInterruptSignals, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	if( ulCriticalNesting == portNO_CRITICAL_NESTING )
+	{
+		vPortDisableInterrupts();
+	}
+
+	ulCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	if( ulCriticalNesting > portNO_CRITICAL_NESTING )
+	{
+		ulCriticalNesting--;
+
+		/* Were any interrupts set to pending while interrupts were
+		(simulated) disabled?  The signals that are pending are delivered as
+		soon as they are unblocked. */
+		if( ulCriticalNesting == portNO_CRITICAL_NESTING )
+		{
+			vPortEnableInterrupts();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
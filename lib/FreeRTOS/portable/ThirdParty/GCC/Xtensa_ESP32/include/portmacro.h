@@ -307,6 +307,13 @@ void uxPortCompareSetExtram(volatile uint32_t *addr, uint32_t compare, uint32_t
 #define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
 #define portBYTE_ALIGNMENT			4
 #define portNOP()					XT_NOP()
+
+/* Hot code runs from IRAM, where the ESP-IDF linker script places IRAM_ATTR
+functions.  Data is always in internal DRAM, so portHOT_DATA is not needed. */
+#if( configUSE_HOT_SECTIONS == 1 )
+	#include "esp_attr.h"
+	#define portHOT_FUNCTION	IRAM_ATTR
+#endif
 /*-----------------------------------------------------------*/
 
 /* Fine resolution time */
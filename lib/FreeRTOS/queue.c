@@ -89,6 +89,75 @@ zero. */
 	#define queueYIELD_IF_USING_PREEMPTION() portYIELD_WITHIN_API()
 #endif
 
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	/* Tell the task registered with vQueueSetReadyNotification(), if any, that
+	an item was posted.  The bits are ORed into its notification value so any
+	number of posts to any number of objects result in a single wake up. */
+	#define queueNOTIFY_READY_TASK( pxQueue )																\
+		if( ( pxQueue )->xReadyTask != NULL )																\
+		{																									\
+			( void ) xTaskNotify( ( pxQueue )->xReadyTask, ( pxQueue )->ulReadyBits, eSetBits );			\
+		}
+	#define queueNOTIFY_READY_TASK_FROM_ISR( pxQueue, pxHigherPriorityTaskWoken )							\
+		if( ( pxQueue )->xReadyTask != NULL )																\
+		{																									\
+			( void ) xTaskNotifyFromISR( ( pxQueue )->xReadyTask, ( pxQueue )->ulReadyBits, eSetBits, ( pxHigherPriorityTaskWoken ) ); \
+		}
+#else
+	#define queueNOTIFY_READY_TASK( pxQueue )
+	#define queueNOTIFY_READY_TASK_FROM_ISR( pxQueue, pxHigherPriorityTaskWoken )
+#endif
+
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	/* Called with the scheduler suspended when a task is about to block on the
+	queue.  xHasBlocked and xBlockedSince are locals of the calling function, so
+	a call that blocks several times is counted once, and its blocked time runs
+	from the first time it blocked. */
+	#define queueSTATS_BLOCKING( pxQueue, uxCounter, xHasBlocked, xBlockedSince )							\
+		if( ( xHasBlocked ) == pdFALSE )																	\
+		{																									\
+			( ( pxQueue )->uxCounter )++;																	\
+			( xBlockedSince ) = xTaskGetTickCount();														\
+			( xHasBlocked ) = pdTRUE;																		\
+		}
+
+	/* Called when a call returns, whether it succeeded or not. */
+	#define queueSTATS_RETURNING( pxQueue, xTotalTime, xHasBlocked, xBlockedSince )							\
+		if( ( xHasBlocked ) != pdFALSE )																	\
+		{																									\
+			prvRecordBlockedTime( ( pxQueue ), &( ( pxQueue )->xTotalTime ), ( xBlockedSince ) );			\
+		}
+
+	/* Called each time the number of items in the queue goes up. */
+	#define queueSTATS_FILL_LEVEL( pxQueue )																\
+		if( ( pxQueue )->uxMessagesWaiting > ( pxQueue )->uxHighWaterMark )									\
+		{																									\
+			( pxQueue )->uxHighWaterMark = ( pxQueue )->uxMessagesWaiting;									\
+		}
+#else
+	#define queueSTATS_BLOCKING( pxQueue, uxCounter, xHasBlocked, xBlockedSince )
+	#define queueSTATS_RETURNING( pxQueue, xTotalTime, xHasBlocked, xBlockedSince )
+	#define queueSTATS_FILL_LEVEL( pxQueue )
+#endif
+
+/*
+ * Definition of a reader/writer lock.  Writers hold xGate for as long as they
+ * hold the lock, which gives them priority inheritance and stops new readers
+ * from coming in while a writer waits (writer preference).  Readers only hold
+ * xGate while they increment uxReaders.
+ */
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	typedef struct QueueRWLockDefinition
+	{
+		QueueHandle_t xGate;				/*< The mutex held by the writer. */
+		QueueHandle_t xNoReaders;			/*< Binary semaphore given by the last reader when a writer is waiting for the readers to leave. */
+		volatile UBaseType_t uxReaders;		/*< The number of tasks that hold the lock for reading. */
+		volatile BaseType_t xWriterWaiting;	/*< pdTRUE while a writer waits on xNoReaders. */
+	} RWLock_t;
+
+#endif /* configUSE_RW_LOCKS */
+
 /*
  * Definition of the queue used by the scheduler.
  * Items are queued by copy, not reference.  See the following link for the
@@ -128,6 +197,29 @@ typedef struct QueueDefinition 		/* The old naming convention is used to prevent
 		uint8_t ucQueueType;
 	#endif
 
+	#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+		struct QueueDefinition *pxFreeSlots;	/*< For a queue created by xQueueCreateZeroCopy(): the queue that holds the free slots, otherwise NULL. */
+	#endif
+
+	#if ( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+		UBaseType_t uxContentionCount;	/*< The number of times xQueueSemaphoreTake() found the semaphore unavailable. */
+	#endif
+
+	#if ( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		TaskHandle_t xReadyTask;		/*< The task to notify each time an item is posted to the queue, or NULL. */
+		uint32_t ulReadyBits;			/*< The bits set in the notification value of xReadyTask. */
+	#endif
+
+	#if ( configUSE_QUEUE_CONTENTION_STATS == 1 )
+		UBaseType_t uxBlockedSends;			/*< The number of send and give calls that blocked. */
+		UBaseType_t uxBlockedReceives;		/*< The number of receive, peek and take calls that blocked. */
+		UBaseType_t uxPriorityInheritances;	/*< The number of times a task blocking on the mutex raised the priority of the holder. */
+		UBaseType_t uxHighWaterMark;		/*< The largest number of items the queue has held. */
+		TickType_t xSendBlockedTime;		/*< The ticks send and give calls spent blocked. */
+		TickType_t xReceiveBlockedTime;		/*< The ticks receive, peek and take calls spent blocked. */
+		TickType_t xMaxBlockedTime;			/*< The longest time a single call spent blocked. */
+	#endif
+
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
@@ -163,6 +255,33 @@ typedef xQUEUE Queue_t;
 
 #endif /* configQUEUE_REGISTRY_SIZE */
 
+#if( ( configQUEUE_POOL_SIZE > 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	/* The memory of a deleted queue while it is kept in the queue pool. */
+	typedef struct QueuePoolBlock
+	{
+		struct QueuePoolBlock *pxNext;
+		size_t xSize;	/*< The size of the block, including the storage area. */
+	} QueuePoolBlock_t;
+
+	PRIVILEGED_DATA static QueuePoolBlock_t *pxQueuePool = NULL;
+	PRIVILEGED_DATA static UBaseType_t uxQueuePoolLength = ( UBaseType_t ) 0;
+	PRIVILEGED_DATA static ObjectPoolStats_t xQueuePoolStats;
+
+	/*
+	 * Takes a block of exactly xSize bytes from the queue pool, or allocates
+	 * one if the pool holds none.
+	 */
+	static void *prvQueuePoolTake( size_t xSize ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Keeps the xSize byte block of a deleted queue in the queue pool, or
+	 * frees it if the pool is full.
+	 */
+	static void prvQueuePoolGive( void *pvBlock, size_t xSize ) PRIVILEGED_FUNCTION;
+
+#endif /* ( configQUEUE_POOL_SIZE > 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+
 /*
  * Unlocks a queue locked by a call to prvLockQueue.  Locking a queue does not
  * prevent an ISR from adding or removing items to the queue, but does prevent
@@ -193,6 +312,14 @@ static BaseType_t prvIsQueueFull( const Queue_t *pxQueue ) PRIVILEGED_FUNCTION;
  */
 static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvItemToQueue, const BaseType_t xPosition ) PRIVILEGED_FUNCTION;
 
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	/*
+	 * Adds the time since xBlockedSince to *pxTotalTime, and to the longest
+	 * blocked time of the queue if it is longer.
+	 */
+	static void prvRecordBlockedTime( Queue_t * const pxQueue, TickType_t * const pxTotalTime, const TickType_t xBlockedSince ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Copies an item out of a queue.
  */
@@ -206,6 +333,14 @@ static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer
 	static BaseType_t prvNotifyQueueSetContainer( const Queue_t * const pxQueue, const BaseType_t xCopyPosition ) PRIVILEGED_FUNCTION;
 #endif
 
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	/*
+	 * Frees, or keeps in the queue pool, the memory of a dynamically
+	 * allocated queue.
+	 */
+	static void prvFreeQueue( Queue_t * const pxQueue ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Called after a Queue_t structure has been allocated either statically or
  * dynamically to fill in the structure's members.
@@ -394,7 +529,15 @@ Queue_t * const pxQueue = xQueue;
 		are greater than or equal to the pointer to char requirements the cast
 		is safe.  In other cases alignment requirements are not strict (one or
 		two bytes). */
-		pxNewQueue = ( Queue_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes ); /*lint !e9087 !e9079 see comment above. */
+		#if( configQUEUE_POOL_SIZE > 0 )
+		{
+			pxNewQueue = ( Queue_t * ) prvQueuePoolTake( sizeof( Queue_t ) + xQueueSizeInBytes ); /*lint !e9087 !e9079 see comment above. */
+		}
+		#else
+		{
+			pxNewQueue = ( Queue_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes ); /*lint !e9087 !e9079 see comment above. */
+		}
+		#endif /* configQUEUE_POOL_SIZE */
 
 		if( pxNewQueue != NULL )
 		{
@@ -426,6 +569,173 @@ Queue_t * const pxQueue = xQueue;
 #endif /* configSUPPORT_STATIC_ALLOCATION */
 /*-----------------------------------------------------------*/
 
+#if( ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	QueueHandle_t xQueueCreateZeroCopy( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize )
+	{
+	Queue_t *pxNewQueue, *pxFreeSlots;
+	size_t xSlotSize, xSlotsOffset;
+	uint8_t *pucQueueStorage, *pucSlot;
+	UBaseType_t uxSlot;
+
+		configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
+		configASSERT( uxItemSize > ( UBaseType_t ) 0 );
+
+		/* Every slot is aligned, so that it can hold any type of item. */
+		xSlotSize = ( size_t ) uxItemSize;
+		if( ( xSlotSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+		{
+			xSlotSize += ( portBYTE_ALIGNMENT - ( xSlotSize & portBYTE_ALIGNMENT_MASK ) );
+		}
+
+		/* A single allocation holds the queue of slot pointers, the queue of
+		free slot pointers, the storage areas of both queues and then the
+		slots themselves. */
+		xSlotsOffset = ( 2U * sizeof( Queue_t ) ) + ( 2U * ( size_t ) uxQueueLength * sizeof( void * ) );
+		if( ( xSlotsOffset & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+		{
+			xSlotsOffset += ( portBYTE_ALIGNMENT - ( xSlotsOffset & portBYTE_ALIGNMENT_MASK ) );
+		}
+
+		/* See the comments in xQueueGenericCreate() about the alignment of
+		the memory returned by pvPortMalloc(). */
+		pxNewQueue = ( Queue_t * ) pvPortMalloc( xSlotsOffset + ( ( size_t ) uxQueueLength * xSlotSize ) ); /*lint !e9087 !e9079 see comment above. */
+
+		if( pxNewQueue != NULL )
+		{
+			pxFreeSlots = &( pxNewQueue[ 1 ] );
+			pucQueueStorage = ( uint8_t * ) &( pxNewQueue[ 2 ] );
+
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+			{
+				/* The queue of free slots is part of the allocation of the
+				main queue, it must never be freed by itself. */
+				pxNewQueue->ucStaticallyAllocated = pdFALSE;
+				pxFreeSlots->ucStaticallyAllocated = pdTRUE;
+			}
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+			prvInitialiseNewQueue( uxQueueLength, ( UBaseType_t ) sizeof( void * ), pucQueueStorage, queueQUEUE_TYPE_BASE, pxNewQueue );
+			pucQueueStorage += ( size_t ) uxQueueLength * sizeof( void * );
+			prvInitialiseNewQueue( uxQueueLength, ( UBaseType_t ) sizeof( void * ), pucQueueStorage, queueQUEUE_TYPE_BASE, pxFreeSlots );
+
+			pxNewQueue->pxFreeSlots = pxFreeSlots;
+
+			/* All slots are free.  There are as many slots as there are
+			places in either queue, so neither queue can ever be full when a
+			pointer is posted to it. */
+			pucSlot = ( ( uint8_t * ) pxNewQueue ) + xSlotsOffset;
+			for( uxSlot = ( UBaseType_t ) 0; uxSlot < uxQueueLength; uxSlot++ )
+			{
+				( void ) xQueueGenericSend( pxFreeSlots, &pucSlot, ( TickType_t ) 0, queueSEND_TO_BACK );
+				pucSlot += xSlotSize;
+			}
+		}
+		else
+		{
+			traceQUEUE_CREATE_FAILED( queueQUEUE_TYPE_BASE );
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return pxNewQueue;
+	}
+
+#endif /* ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	void *pvQueueAcquireZeroCopy( QueueHandle_t xQueue, TickType_t xTicksToWait )
+	{
+	Queue_t * const pxQueue = xQueue;
+	void *pvSlot = NULL;
+
+		configASSERT( pxQueue );
+		configASSERT( pxQueue->pxFreeSlots );
+
+		if( xQueueReceive( pxQueue->pxFreeSlots, &pvSlot, xTicksToWait ) != pdPASS )
+		{
+			pvSlot = NULL;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return pvSlot;
+	}
+
+#endif /* ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	BaseType_t xQueueSendZeroCopy( QueueHandle_t xQueue, void *pvSlot )
+	{
+	Queue_t * const pxQueue = xQueue;
+	BaseType_t xReturn;
+
+		configASSERT( pxQueue );
+		configASSERT( pxQueue->pxFreeSlots );
+		configASSERT( pvSlot );
+
+		/* Only the pointer is copied.  There is always space, see
+		xQueueCreateZeroCopy(). */
+		xReturn = xQueueGenericSend( pxQueue, &pvSlot, ( TickType_t ) 0, queueSEND_TO_BACK );
+		configASSERT( xReturn == pdPASS );
+
+		return xReturn;
+	}
+
+#endif /* ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	void *pvQueueReceiveZeroCopy( QueueHandle_t xQueue, TickType_t xTicksToWait )
+	{
+	Queue_t * const pxQueue = xQueue;
+	void *pvSlot = NULL;
+
+		configASSERT( pxQueue );
+		configASSERT( pxQueue->pxFreeSlots );
+
+		if( xQueueReceive( pxQueue, &pvSlot, xTicksToWait ) != pdPASS )
+		{
+			pvSlot = NULL;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return pvSlot;
+	}
+
+#endif /* ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	void vQueueReleaseZeroCopy( QueueHandle_t xQueue, void *pvSlot )
+	{
+	Queue_t * const pxQueue = xQueue;
+	BaseType_t xResult;
+
+		configASSERT( pxQueue );
+		configASSERT( pxQueue->pxFreeSlots );
+		configASSERT( pvSlot );
+
+		/* A slot that is released twice would make the queue of free slots
+		overflow. */
+		xResult = xQueueGenericSend( pxQueue->pxFreeSlots, &pvSlot, ( TickType_t ) 0, queueSEND_TO_BACK );
+		configASSERT( xResult == pdPASS );
+		( void ) xResult;
+	}
+
+#endif /* ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
 static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, const uint8_t ucQueueType, Queue_t *pxNewQueue )
 {
 	/* Remove compiler warnings about unused parameters should
@@ -464,6 +774,37 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 	}
 	#endif /* configUSE_QUEUE_SETS */
 
+	#if( configUSE_QUEUE_ZERO_COPY == 1 )
+	{
+		pxNewQueue->pxFreeSlots = NULL;
+	}
+	#endif /* configUSE_QUEUE_ZERO_COPY */
+
+	#if( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+	{
+		pxNewQueue->uxContentionCount = ( UBaseType_t ) 0;
+	}
+	#endif /* configUSE_SEMAPHORE_CONTENTION_STATS */
+
+	#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	{
+		pxNewQueue->uxBlockedSends = ( UBaseType_t ) 0;
+		pxNewQueue->uxBlockedReceives = ( UBaseType_t ) 0;
+		pxNewQueue->uxPriorityInheritances = ( UBaseType_t ) 0;
+		pxNewQueue->uxHighWaterMark = ( UBaseType_t ) 0;
+		pxNewQueue->xSendBlockedTime = ( TickType_t ) 0;
+		pxNewQueue->xReceiveBlockedTime = ( TickType_t ) 0;
+		pxNewQueue->xMaxBlockedTime = ( TickType_t ) 0;
+	}
+	#endif /* configUSE_QUEUE_CONTENTION_STATS */
+
+	#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	{
+		pxNewQueue->xReadyTask = NULL;
+		pxNewQueue->ulReadyBits = 0UL;
+	}
+	#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+
 	traceQUEUE_CREATE( pxNewQueue );
 }
 /*-----------------------------------------------------------*/
@@ -534,6 +875,234 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 #endif /* configUSE_MUTEXES */
 /*-----------------------------------------------------------*/
 
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	QueueRWLockHandle_t xQueueCreateRWLock( void )
+	{
+	RWLock_t *pxRWLock;
+
+		pxRWLock = ( RWLock_t * ) pvPortMalloc( sizeof( RWLock_t ) ); /*lint !e9087 !e9079 see comment in xQueueGenericCreate(). */
+
+		if( pxRWLock != NULL )
+		{
+			pxRWLock->xGate = xQueueCreateMutex( queueQUEUE_TYPE_MUTEX );
+			pxRWLock->xNoReaders = xQueueGenericCreate( ( UBaseType_t ) 1, queueSEMAPHORE_QUEUE_ITEM_LENGTH, queueQUEUE_TYPE_BINARY_SEMAPHORE );
+			pxRWLock->uxReaders = ( UBaseType_t ) 0;
+			pxRWLock->xWriterWaiting = pdFALSE;
+
+			if( ( pxRWLock->xGate == NULL ) || ( pxRWLock->xNoReaders == NULL ) )
+			{
+				vQueueDeleteRWLock( pxRWLock );
+				pxRWLock = NULL;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return pxRWLock;
+	}
+
+#endif /* configUSE_RW_LOCKS */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	void vQueueDeleteRWLock( QueueRWLockHandle_t xRWLock )
+	{
+	RWLock_t * const pxRWLock = xRWLock;
+
+		configASSERT( pxRWLock );
+
+		if( pxRWLock->xGate != NULL )
+		{
+			vQueueDelete( pxRWLock->xGate );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( pxRWLock->xNoReaders != NULL )
+		{
+			vQueueDelete( pxRWLock->xNoReaders );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		vPortFree( pxRWLock );
+	}
+
+#endif /* configUSE_RW_LOCKS */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	BaseType_t xQueueRWLockTakeRead( QueueRWLockHandle_t xRWLock, TickType_t xTicksToWait )
+	{
+	RWLock_t * const pxRWLock = xRWLock;
+	BaseType_t xReturn;
+
+		configASSERT( pxRWLock );
+
+		/* The gate is only available when no writer holds it or waits for
+		the readers to leave. */
+		xReturn = xQueueSemaphoreTake( pxRWLock->xGate, xTicksToWait );
+
+		if( xReturn != pdFALSE )
+		{
+			taskENTER_CRITICAL();
+			{
+				( pxRWLock->uxReaders )++;
+			}
+			taskEXIT_CRITICAL();
+
+			( void ) xQueueGenericSend( pxRWLock->xGate, NULL, queueMUTEX_GIVE_BLOCK_TIME, queueSEND_TO_BACK );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_RW_LOCKS */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	void vQueueRWLockGiveRead( QueueRWLockHandle_t xRWLock )
+	{
+	RWLock_t * const pxRWLock = xRWLock;
+	BaseType_t xWakeWriter = pdFALSE;
+
+		configASSERT( pxRWLock );
+
+		taskENTER_CRITICAL();
+		{
+			configASSERT( pxRWLock->uxReaders > ( UBaseType_t ) 0 );
+			( pxRWLock->uxReaders )--;
+
+			if( ( pxRWLock->uxReaders == ( UBaseType_t ) 0 ) && ( pxRWLock->xWriterWaiting != pdFALSE ) )
+			{
+				pxRWLock->xWriterWaiting = pdFALSE;
+				xWakeWriter = pdTRUE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xWakeWriter != pdFALSE )
+		{
+			( void ) xQueueGenericSend( pxRWLock->xNoReaders, NULL, queueMUTEX_GIVE_BLOCK_TIME, queueSEND_TO_BACK );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configUSE_RW_LOCKS */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	BaseType_t xQueueRWLockTakeWrite( QueueRWLockHandle_t xRWLock, TickType_t xTicksToWait )
+	{
+	RWLock_t * const pxRWLock = xRWLock;
+	BaseType_t xReturn, xNoReaders = pdFALSE;
+	TimeOut_t xTimeOut;
+
+		configASSERT( pxRWLock );
+
+		vTaskSetTimeOutState( &xTimeOut );
+
+		/* Holding the gate keeps other writers and new readers out. */
+		xReturn = xQueueSemaphoreTake( pxRWLock->xGate, xTicksToWait );
+
+		if( xReturn != pdFALSE )
+		{
+			for( ;; )
+			{
+				taskENTER_CRITICAL();
+				{
+					if( pxRWLock->uxReaders == ( UBaseType_t ) 0 )
+					{
+						pxRWLock->xWriterWaiting = pdFALSE;
+						xNoReaders = pdTRUE;
+					}
+					else
+					{
+						pxRWLock->xWriterWaiting = pdTRUE;
+					}
+				}
+				taskEXIT_CRITICAL();
+
+				if( xNoReaders != pdFALSE )
+				{
+					break;
+				}
+				else if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+				{
+					/* The readers did not leave in time. */
+					taskENTER_CRITICAL();
+					{
+						pxRWLock->xWriterWaiting = pdFALSE;
+					}
+					taskEXIT_CRITICAL();
+
+					( void ) xQueueGenericSend( pxRWLock->xGate, NULL, queueMUTEX_GIVE_BLOCK_TIME, queueSEND_TO_BACK );
+					xReturn = pdFALSE;
+					break;
+				}
+				else
+				{
+					/* The semaphore may also hold a stale give from a reader
+					that left after an earlier writer timed out, so the
+					number of readers is checked again after waking. */
+					( void ) xQueueSemaphoreTake( pxRWLock->xNoReaders, xTicksToWait );
+				}
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_RW_LOCKS */
+/*-----------------------------------------------------------*/
+
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	BaseType_t xQueueRWLockGiveWrite( QueueRWLockHandle_t xRWLock )
+	{
+	RWLock_t * const pxRWLock = xRWLock;
+
+		configASSERT( pxRWLock );
+		configASSERT( pxRWLock->uxReaders == ( UBaseType_t ) 0 );
+
+		/* Giving the gate also disinherits any priority the writer
+		inherited while it held the lock. */
+		return xQueueGenericSend( pxRWLock->xGate, NULL, queueMUTEX_GIVE_BLOCK_TIME, queueSEND_TO_BACK );
+	}
+
+#endif /* configUSE_RW_LOCKS */
+/*-----------------------------------------------------------*/
+
 #if ( ( configUSE_MUTEXES == 1 ) && ( INCLUDE_xSemaphoreGetMutexHolder == 1 ) )
 
 	TaskHandle_t xQueueGetMutexHolder( QueueHandle_t xSemaphore )
@@ -744,12 +1313,17 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 #endif /* ( ( configUSE_COUNTING_SEMAPHORES == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) ) */
 /*-----------------------------------------------------------*/
 
-BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+portHOT_FUNCTION BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
 {
 BaseType_t xEntryTimeSet = pdFALSE, xYieldRequired;
 TimeOut_t xTimeOut;
 Queue_t * const pxQueue = xQueue;
 
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	BaseType_t xHasBlocked = pdFALSE;
+	TickType_t xBlockedSince = 0;
+#endif
+
 	configASSERT( pxQueue );
 	configASSERT( !( ( pvItemToQueue == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
 	configASSERT( !( ( xCopyPosition == queueOVERWRITE ) && ( pxQueue->uxLength != 1 ) ) );
@@ -871,6 +1445,9 @@ Queue_t * const pxQueue = xQueue;
 				}
 				#endif /* configUSE_QUEUE_SETS */
 
+				queueNOTIFY_READY_TASK( pxQueue );
+				queueSTATS_RETURNING( pxQueue, xSendBlockedTime, xHasBlocked, xBlockedSince );
+
 				taskEXIT_CRITICAL();
 				return pdPASS;
 			}
@@ -880,6 +1457,7 @@ Queue_t * const pxQueue = xQueue;
 				{
 					/* The queue was full and no block time is specified (or
 					the block time has expired) so leave now. */
+					queueSTATS_RETURNING( pxQueue, xSendBlockedTime, xHasBlocked, xBlockedSince );
 					taskEXIT_CRITICAL();
 
 					/* Return to the original privilege level before exiting
@@ -915,6 +1493,7 @@ Queue_t * const pxQueue = xQueue;
 			if( prvIsQueueFull( pxQueue ) != pdFALSE )
 			{
 				traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+				queueSTATS_BLOCKING( pxQueue, uxBlockedSends, xHasBlocked, xBlockedSince );
 				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
 
 				/* Unlocking the queue means queue events can effect the
@@ -947,6 +1526,7 @@ Queue_t * const pxQueue = xQueue;
 			prvUnlockQueue( pxQueue );
 			( void ) xTaskResumeAll();
 
+			queueSTATS_RETURNING( pxQueue, xSendBlockedTime, xHasBlocked, xBlockedSince );
 			traceQUEUE_SEND_FAILED( pxQueue );
 			return errQUEUE_FULL;
 		}
@@ -1000,6 +1580,10 @@ Queue_t * const pxQueue = xQueue;
 			the scheduler is suspended before accessing the ready lists. */
 			( void ) prvCopyDataToQueue( pxQueue, pvItemToQueue, xCopyPosition );
 
+			/* The ready task is not blocked on the queue's event lists, so it
+			can be notified even if the queue is locked. */
+			queueNOTIFY_READY_TASK_FROM_ISR( pxQueue, pxHigherPriorityTaskWoken );
+
 			/* The event list is not altered if the queue is locked.  This will
 			be done when the queue is unlocked later. */
 			if( cTxLock == queueUNLOCKED )
@@ -1164,6 +1748,9 @@ Queue_t * const pxQueue = xQueue;
 			priority disinheritance is needed.  Simply increase the count of
 			messages (semaphores) available. */
 			pxQueue->uxMessagesWaiting = uxMessagesWaiting + ( UBaseType_t ) 1;
+			queueSTATS_FILL_LEVEL( pxQueue );
+
+			queueNOTIFY_READY_TASK_FROM_ISR( pxQueue, pxHigherPriorityTaskWoken );
 
 			/* The event list is not altered if the queue is locked.  This will
 			be done when the queue is unlocked later. */
@@ -1276,6 +1863,11 @@ BaseType_t xEntryTimeSet = pdFALSE;
 TimeOut_t xTimeOut;
 Queue_t * const pxQueue = xQueue;
 
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	BaseType_t xHasBlocked = pdFALSE;
+	TickType_t xBlockedSince = 0;
+#endif
+
 	/* Check the pointer is not NULL. */
 	configASSERT( ( pxQueue ) );
 
@@ -1328,6 +1920,7 @@ Queue_t * const pxQueue = xQueue;
 					mtCOVERAGE_TEST_MARKER();
 				}
 
+				queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 				taskEXIT_CRITICAL();
 				return pdPASS;
 			}
@@ -1338,6 +1931,7 @@ Queue_t * const pxQueue = xQueue;
 					/* The queue was empty and no block time is specified (or
 					the block time has expired) so leave now. */
 					taskEXIT_CRITICAL();
+					queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 					traceQUEUE_RECEIVE_FAILED( pxQueue );
 					return errQUEUE_EMPTY;
 				}
@@ -1371,6 +1965,7 @@ Queue_t * const pxQueue = xQueue;
 			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
 			{
 				traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+				queueSTATS_BLOCKING( pxQueue, uxBlockedReceives, xHasBlocked, xBlockedSince );
 				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
 				prvUnlockQueue( pxQueue );
 				if( xTaskResumeAll() == pdFALSE )
@@ -1399,6 +1994,7 @@ Queue_t * const pxQueue = xQueue;
 
 			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
 			{
+				queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 				traceQUEUE_RECEIVE_FAILED( pxQueue );
 				return errQUEUE_EMPTY;
 			}
@@ -1417,6 +2013,11 @@ BaseType_t xEntryTimeSet = pdFALSE;
 TimeOut_t xTimeOut;
 Queue_t * const pxQueue = xQueue;
 
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	BaseType_t xHasBlocked = pdFALSE;
+	TickType_t xBlockedSince = 0;
+#endif
+
 #if( configUSE_MUTEXES == 1 )
 	BaseType_t xInheritanceOccurred = pdFALSE;
 #endif
@@ -1490,11 +2091,26 @@ Queue_t * const pxQueue = xQueue;
 					mtCOVERAGE_TEST_MARKER();
 				}
 
+				queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 				taskEXIT_CRITICAL();
 				return pdPASS;
 			}
 			else
 			{
+				#if( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+				{
+					/* Only count the first attempt of each call. */
+					if( xEntryTimeSet == pdFALSE )
+					{
+						( pxQueue->uxContentionCount )++;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#endif /* configUSE_SEMAPHORE_CONTENTION_STATS */
+
 				if( xTicksToWait == ( TickType_t ) 0 )
 				{
 					/* For inheritance to have occurred there must have been an
@@ -1509,6 +2125,7 @@ Queue_t * const pxQueue = xQueue;
 					/* The semaphore count was 0 and no block time is specified
 					(or the block time has expired) so exit now. */
 					taskEXIT_CRITICAL();
+					queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 					traceQUEUE_RECEIVE_FAILED( pxQueue );
 					return errQUEUE_EMPTY;
 				}
@@ -1544,6 +2161,7 @@ Queue_t * const pxQueue = xQueue;
 			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
 			{
 				traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+				queueSTATS_BLOCKING( pxQueue, uxBlockedReceives, xHasBlocked, xBlockedSince );
 
 				#if ( configUSE_MUTEXES == 1 )
 				{
@@ -1552,6 +2170,19 @@ Queue_t * const pxQueue = xQueue;
 						taskENTER_CRITICAL();
 						{
 							xInheritanceOccurred = xTaskPriorityInherit( pxQueue->u.xSemaphore.xMutexHolder );
+
+							#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+							{
+								if( xInheritanceOccurred != pdFALSE )
+								{
+									( pxQueue->uxPriorityInheritances )++;
+								}
+								else
+								{
+									mtCOVERAGE_TEST_MARKER();
+								}
+							}
+							#endif /* configUSE_QUEUE_CONTENTION_STATS */
 						}
 						taskEXIT_CRITICAL();
 					}
@@ -1617,6 +2248,7 @@ Queue_t * const pxQueue = xQueue;
 				}
 				#endif /* configUSE_MUTEXES */
 
+				queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 				traceQUEUE_RECEIVE_FAILED( pxQueue );
 				return errQUEUE_EMPTY;
 			}
@@ -1636,6 +2268,11 @@ TimeOut_t xTimeOut;
 int8_t *pcOriginalReadPosition;
 Queue_t * const pxQueue = xQueue;
 
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	BaseType_t xHasBlocked = pdFALSE;
+	TickType_t xBlockedSince = 0;
+#endif
+
 	/* Check the pointer is not NULL. */
 	configASSERT( ( pxQueue ) );
 
@@ -1694,6 +2331,7 @@ Queue_t * const pxQueue = xQueue;
 					mtCOVERAGE_TEST_MARKER();
 				}
 
+				queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 				taskEXIT_CRITICAL();
 				return pdPASS;
 			}
@@ -1704,6 +2342,7 @@ Queue_t * const pxQueue = xQueue;
 					/* The queue was empty and no block time is specified (or
 					the block time has expired) so leave now. */
 					taskEXIT_CRITICAL();
+					queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 					traceQUEUE_PEEK_FAILED( pxQueue );
 					return errQUEUE_EMPTY;
 				}
@@ -1738,6 +2377,7 @@ Queue_t * const pxQueue = xQueue;
 			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
 			{
 				traceBLOCKING_ON_QUEUE_PEEK( pxQueue );
+				queueSTATS_BLOCKING( pxQueue, uxBlockedReceives, xHasBlocked, xBlockedSince );
 				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
 				prvUnlockQueue( pxQueue );
 				if( xTaskResumeAll() == pdFALSE )
@@ -1766,6 +2406,7 @@ Queue_t * const pxQueue = xQueue;
 
 			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
 			{
+				queueSTATS_RETURNING( pxQueue, xReceiveBlockedTime, xHasBlocked, xBlockedSince );
 				traceQUEUE_PEEK_FAILED( pxQueue );
 				return errQUEUE_EMPTY;
 			}
@@ -1939,6 +2580,121 @@ UBaseType_t uxReturn;
 } /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
 /*-----------------------------------------------------------*/
 
+#if( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+
+	UBaseType_t uxQueueGetContentionCount( const QueueHandle_t xQueue )
+	{
+	const Queue_t * const pxQueue = xQueue;
+
+		configASSERT( pxQueue );
+
+		/* A single read of a base type is atomic. */
+		return pxQueue->uxContentionCount;
+	}
+
+#endif /* configUSE_SEMAPHORE_CONTENTION_STATS */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+
+	static void prvRecordBlockedTime( Queue_t * const pxQueue, TickType_t * const pxTotalTime, const TickType_t xBlockedSince )
+	{
+	const TickType_t xBlockedTime = xTaskGetTickCount() - xBlockedSince;
+
+		/* Other tasks returning from the same queue update the same totals.
+		This is also called from within critical sections, which nest. */
+		taskENTER_CRITICAL();
+		{
+			*pxTotalTime += xBlockedTime;
+
+			if( xBlockedTime > pxQueue->xMaxBlockedTime )
+			{
+				pxQueue->xMaxBlockedTime = xBlockedTime;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vQueueGetStats( const QueueHandle_t xQueue, QueueStats_t * const pxStats )
+	{
+	const Queue_t * const pxQueue = xQueue;
+
+		configASSERT( pxQueue );
+		configASSERT( pxStats );
+
+		taskENTER_CRITICAL();
+		{
+			pxStats->uxBlockedSends = pxQueue->uxBlockedSends;
+			pxStats->uxBlockedReceives = pxQueue->uxBlockedReceives;
+			pxStats->uxPriorityInheritances = pxQueue->uxPriorityInheritances;
+			pxStats->uxHighWaterMark = pxQueue->uxHighWaterMark;
+			pxStats->xSendBlockedTime = pxQueue->xSendBlockedTime;
+			pxStats->xReceiveBlockedTime = pxQueue->xReceiveBlockedTime;
+			pxStats->xMaxBlockedTime = pxQueue->xMaxBlockedTime;
+		}
+		taskEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vQueueResetStats( QueueHandle_t xQueue )
+	{
+	Queue_t * const pxQueue = xQueue;
+
+		configASSERT( pxQueue );
+
+		taskENTER_CRITICAL();
+		{
+			pxQueue->uxBlockedSends = ( UBaseType_t ) 0;
+			pxQueue->uxBlockedReceives = ( UBaseType_t ) 0;
+			pxQueue->uxPriorityInheritances = ( UBaseType_t ) 0;
+			pxQueue->xSendBlockedTime = ( TickType_t ) 0;
+			pxQueue->xReceiveBlockedTime = ( TickType_t ) 0;
+			pxQueue->xMaxBlockedTime = ( TickType_t ) 0;
+
+			/* The high water mark starts again from the current fill level. */
+			pxQueue->uxHighWaterMark = pxQueue->uxMessagesWaiting;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_QUEUE_CONTENTION_STATS */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+
+	void vQueueSetReadyNotification( QueueHandle_t xQueue, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet )
+	{
+	Queue_t * const pxQueue = xQueue;
+
+		configASSERT( pxQueue );
+
+		taskENTER_CRITICAL();
+		{
+			pxQueue->xReadyTask = xTaskToNotify;
+			pxQueue->ulReadyBits = ulBitsToSet;
+
+			/* Items posted before the registration would otherwise go
+			unnoticed until the next post. */
+			if( pxQueue->uxMessagesWaiting != ( UBaseType_t ) 0 )
+			{
+				queueNOTIFY_READY_TASK( pxQueue );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+/*-----------------------------------------------------------*/
+
 UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
 {
 UBaseType_t uxReturn;
@@ -1985,7 +2741,7 @@ Queue_t * const pxQueue = xQueue;
 	{
 		/* The queue can only have been allocated dynamically - free it
 		again. */
-		vPortFree( pxQueue );
+		prvFreeQueue( pxQueue );
 	}
 	#elif( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
 	{
@@ -1993,7 +2749,7 @@ Queue_t * const pxQueue = xQueue;
 		check before attempting to free the memory. */
 		if( pxQueue->ucStaticallyAllocated == ( uint8_t ) pdFALSE )
 		{
-			vPortFree( pxQueue );
+			prvFreeQueue( pxQueue );
 		}
 		else
 		{
@@ -2010,6 +2766,149 @@ Queue_t * const pxQueue = xQueue;
 }
 /*-----------------------------------------------------------*/
 
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	static void prvFreeQueue( Queue_t * const pxQueue )
+	{
+		#if( configQUEUE_POOL_SIZE > 0 )
+		{
+		size_t xSize = sizeof( Queue_t );
+		BaseType_t xPoolable = pdTRUE;
+
+			#if( configUSE_QUEUE_ZERO_COPY == 1 )
+			{
+				/* A zero copy queue is laid out differently, so is freed. */
+				if( pxQueue->pxFreeSlots != NULL )
+				{
+					xPoolable = pdFALSE;
+				}
+			}
+			#endif /* configUSE_QUEUE_ZERO_COPY */
+
+			if( xPoolable != pdFALSE )
+			{
+				/* Sized as by xQueueGenericCreate(). */
+				if( pxQueue->uxItemSize != ( UBaseType_t ) 0 )
+				{
+					xSize += ( size_t ) ( pxQueue->uxLength * pxQueue->uxItemSize ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+				}
+
+				prvQueuePoolGive( pxQueue, xSize );
+			}
+			else
+			{
+				vPortFree( pxQueue );
+			}
+		}
+		#else
+		{
+			vPortFree( pxQueue );
+		}
+		#endif /* configQUEUE_POOL_SIZE */
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( ( configQUEUE_POOL_SIZE > 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	static void *prvQueuePoolTake( size_t xSize )
+	{
+	QueuePoolBlock_t *pxBlock, *pxPrevious = NULL;
+
+		taskENTER_CRITICAL();
+		{
+			/* All semaphores and mutexes are the same size, as are queues
+			of the same length and item size, so only an exact fit is
+			reused. */
+			for( pxBlock = pxQueuePool; pxBlock != NULL; pxBlock = pxBlock->pxNext )
+			{
+				if( pxBlock->xSize == xSize )
+				{
+					if( pxPrevious == NULL )
+					{
+						pxQueuePool = pxBlock->pxNext;
+					}
+					else
+					{
+						pxPrevious->pxNext = pxBlock->pxNext;
+					}
+
+					uxQueuePoolLength--;
+					break;
+				}
+
+				pxPrevious = pxBlock;
+			}
+
+			if( pxBlock != NULL )
+			{
+				xQueuePoolStats.ulReused++;
+			}
+			else
+			{
+				xQueuePoolStats.ulAllocated++;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( pxBlock == NULL )
+		{
+			pxBlock = ( QueuePoolBlock_t * ) pvPortMalloc( xSize ); /*lint !e9087 !e9079 pvPortMalloc() returns memory aligned for any type. */
+		}
+
+		return pxBlock;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvQueuePoolGive( void *pvBlock, size_t xSize )
+	{
+	QueuePoolBlock_t * const pxBlock = ( QueuePoolBlock_t * ) pvBlock; /*lint !e9087 !e9079 The block held a Queue_t, which is larger and at least as aligned. */
+	BaseType_t xPooled = pdFALSE;
+
+		taskENTER_CRITICAL();
+		{
+			if( uxQueuePoolLength < ( UBaseType_t ) configQUEUE_POOL_SIZE )
+			{
+				pxBlock->xSize = xSize;
+				pxBlock->pxNext = pxQueuePool;
+				pxQueuePool = pxBlock;
+				uxQueuePoolLength++;
+				xPooled = pdTRUE;
+			}
+			else
+			{
+				xQueuePoolStats.ulFreed++;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xPooled == pdFALSE )
+		{
+			vPortFree( pvBlock );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	void vQueueGetPoolStats( ObjectPoolStats_t *pxStats )
+	{
+		configASSERT( pxStats );
+
+		taskENTER_CRITICAL();
+		{
+			*pxStats = xQueuePoolStats;
+			pxStats->uxPooled = uxQueuePoolLength;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* ( configQUEUE_POOL_SIZE > 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TRACE_FACILITY == 1 )
 
 	UBaseType_t uxQueueGetQueueNumber( QueueHandle_t xQueue )
@@ -2141,6 +3040,7 @@ UBaseType_t uxMessagesWaiting;
 	}
 
 	pxQueue->uxMessagesWaiting = uxMessagesWaiting + ( UBaseType_t ) 1;
+	queueSTATS_FILL_LEVEL( pxQueue );
 
 	return xReturn;
 }
@@ -2696,6 +3596,36 @@ Queue_t * const pxQueue = xQueue;
 #endif /* configQUEUE_REGISTRY_SIZE */
 /*-----------------------------------------------------------*/
 
+#if ( configQUEUE_REGISTRY_SIZE > 0 )
+
+	QueueHandle_t xQueueGetHandleFromName( const char *pcQueueName ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+	{
+	UBaseType_t ux;
+	QueueHandle_t xReturn = NULL;
+
+		configASSERT( pcQueueName );
+
+		/* As for pcQueueGetName(), nothing protects against another task
+		adding or removing entries from the registry while it is searched. */
+		for( ux = ( UBaseType_t ) 0U; ux < ( UBaseType_t ) configQUEUE_REGISTRY_SIZE; ux++ )
+		{
+			if( ( xQueueRegistry[ ux ].pcQueueName != NULL ) && ( strcmp( xQueueRegistry[ ux ].pcQueueName, pcQueueName ) == 0 ) )
+			{
+				xReturn = xQueueRegistry[ ux ].xHandle;
+				break;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* configQUEUE_REGISTRY_SIZE */
+/*-----------------------------------------------------------*/
+
 #if ( configQUEUE_REGISTRY_SIZE > 0 )
 
 	void vQueueUnregisterQueue( QueueHandle_t xQueue )
@@ -74,18 +74,21 @@ that uses task notifications. */
 	{																					\
 	UBaseType_t uxSavedInterruptStatus;													\
 																						\
-		uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();		\
+		if( ( pxStreamBuffer )->xTaskWaitingToSend != NULL )							\
 		{																				\
-			if( ( pxStreamBuffer )->xTaskWaitingToSend != NULL )						\
+			uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();	\
 			{																			\
-				( void ) xTaskNotifyFromISR( ( pxStreamBuffer )->xTaskWaitingToSend,	\
-											 ( uint32_t ) 0,							\
-											 eNoAction,									\
-											 pxHigherPriorityTaskWoken );				\
-				( pxStreamBuffer )->xTaskWaitingToSend = NULL;							\
+				if( ( pxStreamBuffer )->xTaskWaitingToSend != NULL )					\
+				{																		\
+					( void ) xTaskNotifyFromISR( ( pxStreamBuffer )->xTaskWaitingToSend,\
+												 ( uint32_t ) 0,						\
+												 eNoAction,								\
+												 pxHigherPriorityTaskWoken );			\
+					( pxStreamBuffer )->xTaskWaitingToSend = NULL;						\
+				}																		\
 			}																			\
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );				\
 		}																				\
-		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );					\
 	}
 #endif /* sbRECEIVE_COMPLETED_FROM_ISR */
 
@@ -112,20 +115,65 @@ that uses task notifications. */
 	{																					\
 	UBaseType_t uxSavedInterruptStatus;													\
 																						\
-		uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();		\
+		if( ( pxStreamBuffer )->xTaskWaitingToReceive != NULL )							\
 		{																				\
-			if( ( pxStreamBuffer )->xTaskWaitingToReceive != NULL )						\
+			uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();	\
 			{																			\
-				( void ) xTaskNotifyFromISR( ( pxStreamBuffer )->xTaskWaitingToReceive,	\
-											 ( uint32_t ) 0,							\
-											 eNoAction,									\
-											 pxHigherPriorityTaskWoken );				\
-				( pxStreamBuffer )->xTaskWaitingToReceive = NULL;						\
+				if( ( pxStreamBuffer )->xTaskWaitingToReceive != NULL )					\
+				{																		\
+					( void ) xTaskNotifyFromISR( ( pxStreamBuffer )->xTaskWaitingToReceive,\
+												 ( uint32_t ) 0,						\
+												 eNoAction,								\
+												 pxHigherPriorityTaskWoken );			\
+					( pxStreamBuffer )->xTaskWaitingToReceive = NULL;					\
+				}																		\
 			}																			\
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );				\
 		}																				\
-		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );					\
 	}
 #endif /* sbSEND_COMPLETE_FROM_ISR */
+
+/* The ISR versions of the notification macros above read the handle of the
+waiting task before masking interrupts, so an ISR that finds no task waiting
+never masks interrupts at all.  That is safe because a task only sets the
+handle from within a critical section in which it also checked the buffer, so
+an ISR either runs before the check (and the task then sees the data) or after
+the handle has been set. */
+
+/* Orders the accesses to the data in the buffer with respect to the update of
+xHead or xTail that publishes them, when the reserve/commit and peek/consume
+functions are used.  Ports on which the writer and the reader can run on cores
+that do not observe each other's stores in order must define it. */
+#ifndef sbMEMORY_BARRIER
+	#define sbMEMORY_BARRIER()
+#endif /* sbMEMORY_BARRIER */
+
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	/* Tell the task registered with vStreamBufferSetReadyNotification(), if
+	any, that the trigger level has been reached.  The handle is read once as it
+	can be changed by a task that does not suspend the scheduler. */
+	#define sbNOTIFY_READY_TASK( pxStreamBuffer )										\
+	{																					\
+	TaskHandle_t xReadyTask = ( pxStreamBuffer )->xReadyTask;							\
+																						\
+		if( xReadyTask != NULL )														\
+		{																				\
+			( void ) xTaskNotify( xReadyTask, ( pxStreamBuffer )->ulReadyBits, eSetBits );	\
+		}																				\
+	}
+	#define sbNOTIFY_READY_TASK_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken )	\
+	{																					\
+	TaskHandle_t xReadyTask = ( pxStreamBuffer )->xReadyTask;							\
+																						\
+		if( xReadyTask != NULL )														\
+		{																				\
+			( void ) xTaskNotifyFromISR( xReadyTask, ( pxStreamBuffer )->ulReadyBits, eSetBits, ( pxHigherPriorityTaskWoken ) );	\
+		}																				\
+	}
+#else
+	#define sbNOTIFY_READY_TASK( pxStreamBuffer )
+	#define sbNOTIFY_READY_TASK_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken )
+#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
 /*lint -restore (9026) */
 
 /* The number of bytes used to hold the length of a message in the buffer. */
@@ -152,6 +200,11 @@ typedef struct StreamBufferDef_t /*lint !e9058 Style convention uses tag. */
 	#if ( configUSE_TRACE_FACILITY == 1 )
 		UBaseType_t uxStreamBufferNumber;		/* Used for tracing purposes. */
 	#endif
+
+	#if ( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		volatile TaskHandle_t xReadyTask;		/* The task to notify each time the trigger level is reached, or NULL. */
+		uint32_t ulReadyBits;					/* The bits set in the notification value of xReadyTask. */
+	#endif
 } StreamBuffer_t;
 
 /*
@@ -202,6 +255,12 @@ static size_t prvReadBytesFromBuffer( StreamBuffer_t *pxStreamBuffer,
 									  size_t xMaxCount,
 									  size_t xBytesAvailable ) PRIVILEGED_FUNCTION;
 
+/*
+ * Move the index *pxIndex of the buffer forward by xCount bytes, wrapping
+ * round to the start of the buffer if necessary.
+ */
+static void prvAdvanceIndex( const StreamBuffer_t * const pxStreamBuffer, volatile size_t *pxIndex, size_t xCount ) PRIVILEGED_FUNCTION;
+
 /*
  * Called by both pxStreamBufferCreate() and pxStreamBufferCreateStatic() to
  * initialise the members of the newly created stream buffer structure.
@@ -398,6 +457,11 @@ BaseType_t xReturn = pdFAIL;
 	UBaseType_t uxStreamBufferNumber;
 #endif
 
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	TaskHandle_t xReadyTask;
+	uint32_t ulReadyBits;
+#endif
+
 	configASSERT( pxStreamBuffer );
 
 	#if( configUSE_TRACE_FACILITY == 1 )
@@ -408,6 +472,15 @@ BaseType_t xReturn = pdFAIL;
 	}
 	#endif
 
+	#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	{
+		/* Likewise the registration made by
+		vStreamBufferSetReadyNotification(). */
+		xReadyTask = pxStreamBuffer->xReadyTask;
+		ulReadyBits = pxStreamBuffer->ulReadyBits;
+	}
+	#endif
+
 	/* Can only reset a message buffer if there are no tasks blocked on it. */
 	taskENTER_CRITICAL();
 	{
@@ -428,6 +501,13 @@ BaseType_t xReturn = pdFAIL;
 				}
 				#endif
 
+				#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+				{
+					pxStreamBuffer->xReadyTask = xReadyTask;
+					pxStreamBuffer->ulReadyBits = ulReadyBits;
+				}
+				#endif
+
 				traceSTREAM_BUFFER_RESET( xStreamBuffer );
 			}
 		}
@@ -438,6 +518,36 @@ BaseType_t xReturn = pdFAIL;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+
+	void vStreamBufferSetReadyNotification( StreamBufferHandle_t xStreamBuffer, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet )
+	{
+	StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+		configASSERT( pxStreamBuffer );
+
+		taskENTER_CRITICAL();
+		{
+			pxStreamBuffer->ulReadyBits = ulBitsToSet;
+			pxStreamBuffer->xReadyTask = xTaskToNotify;
+
+			/* Data sent before the registration would otherwise go unnoticed
+			until the next send. */
+			if( ( xTaskToNotify != NULL ) && ( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes ) )
+			{
+				( void ) xTaskNotify( xTaskToNotify, ulBitsToSet, eSetBits );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_OBJECT_READY_NOTIFICATIONS */
+/*-----------------------------------------------------------*/
+
 BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel )
 {
 StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
@@ -591,6 +701,7 @@ TimeOut_t xTimeOut;
 		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
 		{
 			sbSEND_COMPLETED( pxStreamBuffer );
+			sbNOTIFY_READY_TASK( pxStreamBuffer );
 		}
 		else
 		{
@@ -641,6 +752,7 @@ size_t xRequiredSpace = xDataLengthBytes;
 		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
 		{
 			sbSEND_COMPLETE_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+			sbNOTIFY_READY_TASK_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
 		}
 		else
 		{
@@ -1025,6 +1137,210 @@ const StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
 }
 /*-----------------------------------------------------------*/
 
+size_t xStreamBufferReserve( StreamBufferHandle_t xStreamBuffer, uint8_t **ppucData )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xSpace;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( ppucData );
+
+	/* Messages need their length written in front of them, so only stream
+	buffers can be written in place. */
+	configASSERT( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 );
+
+	/* Only the writer moves xHead, so the space can only grow while the
+	caller is filling it in. */
+	xSpace = configMIN( xStreamBufferSpacesAvailable( pxStreamBuffer ), pxStreamBuffer->xLength - pxStreamBuffer->xHead );
+	*ppucData = &( pxStreamBuffer->pucBuffer[ pxStreamBuffer->xHead ] );
+
+	return xSpace;
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferCommit( StreamBufferHandle_t xStreamBuffer, size_t xCount )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( xCount <= xStreamBufferSpacesAvailable( pxStreamBuffer ) );
+
+	if( xCount > ( size_t ) 0 )
+	{
+		sbMEMORY_BARRIER();
+		prvAdvanceIndex( pxStreamBuffer, &( pxStreamBuffer->xHead ), xCount );
+
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			sbSEND_COMPLETED( pxStreamBuffer );
+			sbNOTIFY_READY_TASK( pxStreamBuffer );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceSTREAM_BUFFER_SEND( xStreamBuffer, xCount );
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferCommitFromISR( StreamBufferHandle_t xStreamBuffer, size_t xCount, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( xCount <= xStreamBufferSpacesAvailable( pxStreamBuffer ) );
+
+	if( xCount > ( size_t ) 0 )
+	{
+		sbMEMORY_BARRIER();
+		prvAdvanceIndex( pxStreamBuffer, &( pxStreamBuffer->xHead ), xCount );
+
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			sbSEND_COMPLETE_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+			sbNOTIFY_READY_TASK_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceSTREAM_BUFFER_SEND_FROM_ISR( xStreamBuffer, xCount );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferPeekContiguous( StreamBufferHandle_t xStreamBuffer, const uint8_t **ppucData, TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xCount;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( ppucData );
+	configASSERT( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 );
+
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		/* As in xStreamBufferReceive(), checking for data and clearing the
+		notification state must be performed atomically. */
+		taskENTER_CRITICAL();
+		{
+			xCount = prvBytesInBuffer( pxStreamBuffer );
+
+			if( xCount == ( size_t ) 0 )
+			{
+				( void ) xTaskNotifyStateClear( NULL );
+				configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+				pxStreamBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xCount == ( size_t ) 0 )
+		{
+			traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( xStreamBuffer );
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToReceive = NULL;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* Only the reader moves xTail, so the data can only grow while the
+	caller is looking at it. */
+	xCount = configMIN( prvBytesInBuffer( pxStreamBuffer ), pxStreamBuffer->xLength - pxStreamBuffer->xTail );
+	sbMEMORY_BARRIER();
+	*ppucData = &( pxStreamBuffer->pucBuffer[ pxStreamBuffer->xTail ] );
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferConsume( StreamBufferHandle_t xStreamBuffer, size_t xCount )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( xCount <= prvBytesInBuffer( pxStreamBuffer ) );
+
+	if( xCount > ( size_t ) 0 )
+	{
+		sbMEMORY_BARRIER();
+		prvAdvanceIndex( pxStreamBuffer, &( pxStreamBuffer->xTail ), xCount );
+		sbRECEIVE_COMPLETED( pxStreamBuffer );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xCount );
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferConsumeFromISR( StreamBufferHandle_t xStreamBuffer, size_t xCount, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( xCount <= prvBytesInBuffer( pxStreamBuffer ) );
+
+	if( xCount > ( size_t ) 0 )
+	{
+		sbMEMORY_BARRIER();
+		prvAdvanceIndex( pxStreamBuffer, &( pxStreamBuffer->xTail ), xCount );
+		sbRECEIVE_COMPLETED_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceSTREAM_BUFFER_RECEIVE_FROM_ISR( xStreamBuffer, xCount );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdvanceIndex( const StreamBuffer_t * const pxStreamBuffer, volatile size_t *pxIndex, size_t xCount )
+{
+size_t xNextIndex;
+
+	/* Calculate the new value in a local variable, so the shared index only
+	ever holds valid values. */
+	xNextIndex = *pxIndex + xCount;
+
+	if( xNextIndex >= pxStreamBuffer->xLength )
+	{
+		xNextIndex -= pxStreamBuffer->xLength;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	*pxIndex = xNextIndex;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xStreamBufferSendCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken )
 {
 StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
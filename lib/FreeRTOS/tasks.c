@@ -64,7 +64,8 @@ functions but without including stdio.h here. */
 	#define taskYIELD_IF_USING_PREEMPTION() portYIELD_WITHIN_API()
 #endif
 
-/* Values that can be assigned to the ucNotifyState member of the TCB. */
+/* Values that can be assigned to the entries of the ucNotifyState array of the
+TCB. */
 #define taskNOT_WAITING_NOTIFICATION	( ( uint8_t ) 0 )
 #define taskWAITING_NOTIFICATION		( ( uint8_t ) 1 )
 #define taskNOTIFICATION_RECEIVED		( ( uint8_t ) 2 )
@@ -305,8 +306,8 @@ typedef struct tskTaskControlBlock 			/* The old naming convention is used to pr
 	#endif
 
 	#if( configUSE_TASK_NOTIFICATIONS == 1 )
-		volatile uint32_t ulNotifiedValue;
-		volatile uint8_t ucNotifyState;
+		volatile uint32_t ulNotifiedValue[ configTASK_NOTIFICATION_ARRAY_ENTRIES ];
+		volatile uint8_t ucNotifyState[ configTASK_NOTIFICATION_ARRAY_ENTRIES ];
 	#endif
 
 	/* See the comments in FreeRTOS.h with the definition of
@@ -323,12 +324,52 @@ typedef struct tskTaskControlBlock 			/* The old naming convention is used to pr
 		int iTaskErrno;
 	#endif
 
+	#if( configUSE_TASK_ARENAS == 1 )
+		struct tskTaskArena *pxArena;	/*< The arena from which pvPortMalloc() serves this task, or NULL. */
+	#endif
+
+	#if( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+		uint32_t		ulSwitchInCount;	/*< The number of times the task has been switched in. */
+		uint32_t		ulPreemptionCount;	/*< The number of times the task has been switched out while it was still ready to run. */
+		uint32_t		ulLongestRunTime;	/*< The longest time the task has run without being switched out, in run time counter units. */
+	#endif
+
+	#if( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+		uint32_t		ulSleepLatencyTolerance;	/*< The longest wake up latency the task tolerates while it is blocked. */
+	#endif
+
+	#if( configTASK_POOL_SIZE > 0 )
+		uint32_t		ulStackDepth;		/*< The depth of the stack, so that a pooled task can be matched to a request. */
+	#endif
+
+	#if( configUSE_TASK_ITERATOR == 1 )
+		ListItem_t		xRegistryListItem;	/*< Used to reference the task from xTaskRegistry, in the order tasks were created. */
+	#endif
+
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
 below to enable the use of older kernel aware debuggers. */
 typedef tskTCB TCB_t;
 
+#if( configUSE_TASK_ARENAS == 1 )
+
+	/*
+	 * An arena, see xTaskArenaCreateStatic().  The memory between pucStart and
+	 * pucNext is in use, the memory between pucNext and pucEnd is free.
+	 */
+	typedef struct tskTaskArena
+	{
+		uint8_t *pucStart;					/*< The first byte of the arena, aligned. */
+		uint8_t *pucEnd;					/*< Just beyond the last byte of the arena. */
+		uint8_t *pucNext;					/*< The first free byte. */
+		uint8_t *pucLastBlock;				/*< The block handed out most recently, or NULL. */
+		struct tskTaskArena *pxNextArena;	/*< The next arena in pxArenaList. */
+		size_t xHighWaterMark;				/*< The highest number of bytes that was in use. */
+	} TaskArena_t;
+
+#endif /* configUSE_TASK_ARENAS */
+
 /*lint -save -e956 A manual analysis and inspection has been used to determine
 which static variables must be declared volatile. */
 PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
@@ -337,7 +378,7 @@ PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
 xDelayedTaskList1 and xDelayedTaskList2 could be move to function scople but
 doing so breaks some kernel aware debuggers and debuggers that rely on removing
 the static qualifier. */
-PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ];/*< Prioritised ready tasks. */
+PRIVILEGED_DATA portHOT_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ];/*< Prioritised ready tasks. */
 PRIVILEGED_DATA static List_t xDelayedTaskList1;						/*< Delayed tasks. */
 PRIVILEGED_DATA static List_t xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
 PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;				/*< Points to the delayed task list currently being used. */
@@ -351,6 +392,20 @@ PRIVILEGED_DATA static List_t xPendingReadyList;						/*< Tasks that have been r
 
 #endif
 
+#if( configUSE_TASK_ITERATOR == 1 )
+
+	PRIVILEGED_DATA static List_t xTaskRegistry;						/*< Every task that has not been deleted, in the order they were created. */
+	PRIVILEGED_DATA static UBaseType_t uxTaskRegistryGeneration = ( UBaseType_t ) 0U;	/*< Incremented each time a task leaves xTaskRegistry. */
+
+#endif
+
+#if( configTASK_POOL_SIZE > 0 )
+
+	PRIVILEGED_DATA static List_t xTaskPool;							/*< Deleted tasks kept for reuse, in order of increasing stack depth. */
+	PRIVILEGED_DATA static ObjectPoolStats_t xTaskPoolStats;
+
+#endif
+
 #if ( INCLUDE_vTaskSuspend == 1 )
 
 	PRIVILEGED_DATA static List_t xSuspendedTaskList;					/*< Tasks that are currently suspended. */
@@ -363,6 +418,11 @@ the errno of the currently running task. */
 	int FreeRTOS_errno = 0;
 #endif
 
+/* All arenas, so that vPortFree() can recognise their blocks. */
+#if ( configUSE_TASK_ARENAS == 1 )
+	PRIVILEGED_DATA static TaskArena_t * volatile pxArenaList = NULL;
+#endif
+
 /* Other file private variables. --------------------------------*/
 PRIVILEGED_DATA static volatile UBaseType_t uxCurrentNumberOfTasks 	= ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile TickType_t xTickCount 				= ( TickType_t ) configINITIAL_TICK_COUNT;
@@ -394,6 +454,23 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended	= ( UBaseType_t
 
 #endif
 
+#if ( configUSE_TICKLESS_IDLE_STATS == 1 )
+
+	PRIVILEGED_DATA static TicklessIdleStats_t xTicklessIdleStats;	/*< Only written by the idle task, or from a critical section. */
+
+#endif
+
+#if ( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+
+	PRIVILEGED_DATA static UBaseType_t uxSleepDepth = ( UBaseType_t ) 0U;	/*< The sleep depth of the current or last low power idle period. */
+	#define tskSLEEP_DEPTH()	( uxSleepDepth )
+
+#else
+
+	#define tskSLEEP_DEPTH()	( ( UBaseType_t ) 0U )
+
+#endif
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -460,6 +537,23 @@ static portTASK_FUNCTION_PROTO( prvIdleTask, pvParameters );
 
 	static void prvDeleteTCB( TCB_t *pxTCB ) PRIVILEGED_FUNCTION;
 
+	/*
+	 * Frees, or keeps in the task pool, the stack and TCB of a task whose
+	 * stack and TCB were both allocated dynamically.
+	 */
+	static void prvFreeStackAndTCB( TCB_t *pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif
+
+#if( configTASK_POOL_SIZE > 0 )
+
+	/*
+	 * Takes from the task pool the task with the smallest stack at least
+	 * *pulStackDepth deep, within configTASK_POOL_STACK_SLACK_PERCENT.  On
+	 * success *pulStackDepth is set to the depth of its stack.
+	 */
+	static TCB_t *prvTaskPoolTake( uint32_t *pulStackDepth ) PRIVILEGED_FUNCTION;
+
 #endif
 
 /*
@@ -489,6 +583,29 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait, const BaseT
 
 #endif
 
+/*
+ * Fills a TaskRunTimeStats_t structure for each task that is referenced from
+ * the pxList list, up to uxSpace structures.  Unlike
+ * prvListTasksWithinSingleList() it does not move the list's index, so the
+ * round robin order of the ready lists is unaffected.
+ */
+#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+
+	static UBaseType_t prvListRunTimeStatsWithinSingleList( TaskRunTimeStats_t *pxStatsArray, UBaseType_t uxSpace, const List_t *pxList ) PRIVILEGED_FUNCTION;
+
+#endif
+
+/*
+ * Return the smallest sleep latency tolerance of the tasks that are blocked or
+ * suspended.  Must be called with the scheduler suspended.
+ */
+#if ( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+
+	static uint32_t prvGetSleepLatencyTolerance( void ) PRIVILEGED_FUNCTION;
+	static uint32_t prvGetListSleepLatencyTolerance( const List_t *pxList, uint32_t ulTolerance ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * Searches pxList for a task with name pcNameToQuery - returning a handle to
  * the task if it is found, or NULL if the task is not found.
@@ -736,62 +853,80 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB ) PRIVILEGED_FUNCTION;
 	{
 	TCB_t *pxNewTCB;
 	BaseType_t xReturn;
+	uint32_t ulStackDepth = ( uint32_t ) usStackDepth;
 
-		/* If the stack grows down then allocate the stack then the TCB so the stack
-		does not grow into the TCB.  Likewise if the stack grows up then allocate
-		the TCB then the stack. */
-		#if( portSTACK_GROWTH > 0 )
+		#if( configTASK_POOL_SIZE > 0 )
 		{
-			/* Allocate space for the TCB.  Where the memory comes from depends on
-			the implementation of the port malloc function and whether or not static
-			allocation is being used. */
-			pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+			pxNewTCB = prvTaskPoolTake( &ulStackDepth );
+		}
+		#else
+		{
+			pxNewTCB = NULL;
+		}
+		#endif /* configTASK_POOL_SIZE */
 
-			if( pxNewTCB != NULL )
+		if( pxNewTCB == NULL )
+		{
+			/* If the stack grows down then allocate the stack then the TCB so the stack
+			does not grow into the TCB.  Likewise if the stack grows up then allocate
+			the TCB then the stack. */
+			#if( portSTACK_GROWTH > 0 )
 			{
-				/* Allocate space for the stack used by the task being created.
-				The base of the stack memory stored in the TCB so the task can
-				be deleted later if required. */
-				pxNewTCB->pxStack = ( StackType_t * ) pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+				/* Allocate space for the TCB.  Where the memory comes from depends on
+				the implementation of the port malloc function and whether or not static
+				allocation is being used. */
+				pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
 
-				if( pxNewTCB->pxStack == NULL )
+				if( pxNewTCB != NULL )
 				{
-					/* Could not allocate the stack.  Delete the allocated TCB. */
-					vPortFree( pxNewTCB );
-					pxNewTCB = NULL;
+					/* Allocate space for the stack used by the task being created.
+					The base of the stack memory stored in the TCB so the task can
+					be deleted later if required. */
+					pxNewTCB->pxStack = ( StackType_t * ) pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+					if( pxNewTCB->pxStack == NULL )
+					{
+						/* Could not allocate the stack.  Delete the allocated TCB. */
+						vPortFree( pxNewTCB );
+						pxNewTCB = NULL;
+					}
 				}
 			}
-		}
-		#else /* portSTACK_GROWTH */
-		{
-		StackType_t *pxStack;
-
-			/* Allocate space for the stack used by the task being created. */
-			pxStack = pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation is the stack. */
-
-			if( pxStack != NULL )
+			#else /* portSTACK_GROWTH */
 			{
-				/* Allocate space for the TCB. */
-				pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) ); /*lint !e9087 !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack, and the first member of TCB_t is always a pointer to the task's stack. */
+			StackType_t *pxStack;
 
-				if( pxNewTCB != NULL )
+				/* Allocate space for the stack used by the task being created. */
+				pxStack = pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation is the stack. */
+
+				if( pxStack != NULL )
 				{
-					/* Store the stack location in the TCB. */
-					pxNewTCB->pxStack = pxStack;
+					/* Allocate space for the TCB. */
+					pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) ); /*lint !e9087 !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack, and the first member of TCB_t is always a pointer to the task's stack. */
+
+					if( pxNewTCB != NULL )
+					{
+						/* Store the stack location in the TCB. */
+						pxNewTCB->pxStack = pxStack;
+					}
+					else
+					{
+						/* The stack cannot be used as the TCB was not created.  Free
+						it again. */
+						vPortFree( pxStack );
+					}
 				}
 				else
 				{
-					/* The stack cannot be used as the TCB was not created.  Free
-					it again. */
-					vPortFree( pxStack );
+					pxNewTCB = NULL;
 				}
 			}
-			else
-			{
-				pxNewTCB = NULL;
-			}
+			#endif /* portSTACK_GROWTH */
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
 		}
-		#endif /* portSTACK_GROWTH */
 
 		if( pxNewTCB != NULL )
 		{
@@ -803,7 +938,13 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB ) PRIVILEGED_FUNCTION;
 			}
 			#endif /* tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE */
 
-			prvInitialiseNewTask( pxTaskCode, pcName, ( uint32_t ) usStackDepth, pvParameters, uxPriority, pxCreatedTask, pxNewTCB, NULL );
+			#if( configTASK_POOL_SIZE > 0 )
+			{
+				pxNewTCB->ulStackDepth = ulStackDepth;
+			}
+			#endif /* configTASK_POOL_SIZE */
+
+			prvInitialiseNewTask( pxTaskCode, pcName, ulStackDepth, pvParameters, uxPriority, pxCreatedTask, pxNewTCB, NULL );
 			prvAddNewTaskToReadyList( pxNewTCB );
 			xReturn = pdPASS;
 		}
@@ -946,6 +1087,13 @@ UBaseType_t x;
 	listSET_LIST_ITEM_VALUE( &( pxNewTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) uxPriority ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 	listSET_LIST_ITEM_OWNER( &( pxNewTCB->xEventListItem ), pxNewTCB );
 
+	#if ( configUSE_TASK_ITERATOR == 1 )
+	{
+		vListInitialiseItem( &( pxNewTCB->xRegistryListItem ) );
+		listSET_LIST_ITEM_OWNER( &( pxNewTCB->xRegistryListItem ), pxNewTCB );
+	}
+	#endif /* configUSE_TASK_ITERATOR */
+
 	#if ( portCRITICAL_NESTING_IN_TCB == 1 )
 	{
 		pxNewTCB->uxCriticalNesting = ( UBaseType_t ) 0U;
@@ -964,6 +1112,20 @@ UBaseType_t x;
 	}
 	#endif /* configGENERATE_RUN_TIME_STATS */
 
+	#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+	{
+		pxNewTCB->ulSwitchInCount = 0UL;
+		pxNewTCB->ulPreemptionCount = 0UL;
+		pxNewTCB->ulLongestRunTime = 0UL;
+	}
+	#endif /* configUSE_EXTENDED_RUN_TIME_STATS */
+
+	#if ( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+	{
+		pxNewTCB->ulSleepLatencyTolerance = tskNO_LATENCY_CONSTRAINT;
+	}
+	#endif /* configUSE_SLEEP_LATENCY_TOLERANCE */
+
 	#if ( portUSING_MPU_WRAPPERS == 1 )
 	{
 		vPortStoreTaskMPUSettings( &( pxNewTCB->xMPUSettings ), xRegions, pxNewTCB->pxStack, ulStackDepth );
@@ -986,8 +1148,14 @@ UBaseType_t x;
 
 	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
 	{
-		pxNewTCB->ulNotifiedValue = 0;
-		pxNewTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+		memset( ( void * ) &( pxNewTCB->ulNotifiedValue[ 0 ] ), 0x00, sizeof( pxNewTCB->ulNotifiedValue ) );
+		memset( ( void * ) &( pxNewTCB->ucNotifyState[ 0 ] ), taskNOT_WAITING_NOTIFICATION, sizeof( pxNewTCB->ucNotifyState ) );
+	}
+	#endif
+
+	#if ( configUSE_TASK_ARENAS == 1 )
+	{
+		pxNewTCB->pxArena = NULL;
 	}
 	#endif
 
@@ -1124,6 +1292,13 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 			pxNewTCB->uxTCBNumber = uxTaskNumber;
 		}
 		#endif /* configUSE_TRACE_FACILITY */
+
+		#if ( configUSE_TASK_ITERATOR == 1 )
+		{
+			/* The registry stays in order of uxTCBNumber. */
+			vListInsertEnd( &xTaskRegistry, &( pxNewTCB->xRegistryListItem ) );
+		}
+		#endif /* configUSE_TASK_ITERATOR */
 		traceTASK_CREATE( pxNewTCB );
 
 		prvAddTaskToReadyList( pxNewTCB );
@@ -1184,6 +1359,15 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 				mtCOVERAGE_TEST_MARKER();
 			}
 
+			#if ( configUSE_TASK_ITERATOR == 1 )
+			{
+				/* An iterator that is to continue after this task has to find
+				its place again. */
+				( void ) uxListRemove( &( pxTCB->xRegistryListItem ) );
+				uxTaskRegistryGeneration++;
+			}
+			#endif /* configUSE_TASK_ITERATOR */
+
 			/* Increment the uxTaskNumber also so kernel aware debuggers can
 			detect that the task lists need re-generating.  This is done before
 			portPRE_TASK_DELETE_HOOK() as in the Windows port that macro will
@@ -1373,6 +1557,46 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 #endif /* INCLUDE_vTaskDelay */
 /*-----------------------------------------------------------*/
 
+#if( ( INCLUDE_vTaskDelay == 1 ) && ( configUSE_TIMER_SLACK == 1 ) )
+
+	void vTaskDelayWithSlack( const TickType_t xTicksToDelay, const TickType_t xSlack )
+	{
+	BaseType_t xAlreadyYielded = pdFALSE;
+
+		/* A delay time of zero just forces a reschedule. */
+		if( xTicksToDelay > ( TickType_t ) 0U )
+		{
+			configASSERT( uxSchedulerSuspended == 0 );
+			vTaskSuspendAll();
+			{
+				traceTASK_DELAY();
+
+				/* Wake up together with a task that is due within the slack,
+				or at the end of the slack so later delays can join this one. */
+				prvAddCurrentTaskToDelayedList( xTaskGetCoalescedDelay( xTicksToDelay, xSlack ), pdFALSE );
+			}
+			xAlreadyYielded = xTaskResumeAll();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		/* Force a reschedule if xTaskResumeAll has not already done so, we may
+		have put ourselves to sleep. */
+		if( xAlreadyYielded == pdFALSE )
+		{
+			portYIELD_WITHIN_API();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* INCLUDE_vTaskDelay && configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
 #if( ( INCLUDE_eTaskGetState == 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_xTaskAbortDelay == 1 ) )
 
 	eTaskState eTaskGetState( TaskHandle_t xTask )
@@ -1415,17 +1639,21 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 					{
 						#if( configUSE_TASK_NOTIFICATIONS == 1 )
 						{
+							BaseType_t x;
+
 							/* The task does not appear on the event list item of
 							and of the RTOS objects, but could still be in the
-							blocked state if it is waiting on its notification
-							rather than waiting on an object. */
-							if( pxTCB->ucNotifyState == taskWAITING_NOTIFICATION )
-							{
-								eReturn = eBlocked;
-							}
-							else
+							blocked state if it is waiting on one of its
+							notifications rather than waiting on an object. */
+							eReturn = eSuspended;
+
+							for( x = 0; x < ( BaseType_t ) configTASK_NOTIFICATION_ARRAY_ENTRIES; x++ )
 							{
-								eReturn = eSuspended;
+								if( pxTCB->ucNotifyState[ x ] == taskWAITING_NOTIFICATION )
+								{
+									eReturn = eBlocked;
+									break;
+								}
 							}
 						}
 						#else
@@ -1730,11 +1958,16 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 
 			#if( configUSE_TASK_NOTIFICATIONS == 1 )
 			{
-				if( pxTCB->ucNotifyState == taskWAITING_NOTIFICATION )
+			BaseType_t x;
+
+				for( x = 0; x < ( BaseType_t ) configTASK_NOTIFICATION_ARRAY_ENTRIES; x++ )
 				{
-					/* The task was blocked to wait for a notification, but is
-					now suspended, so no notification was received. */
-					pxTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+					if( pxTCB->ucNotifyState[ x ] == taskWAITING_NOTIFICATION )
+					{
+						/* The task was blocked to wait for a notification, but
+						is now suspended, so no notification was received. */
+						pxTCB->ucNotifyState[ x ] = taskNOT_WAITING_NOTIFICATION;
+					}
 				}
 			}
 			#endif
@@ -2553,104 +2786,275 @@ TCB_t *pxTCB;
 #endif /* configUSE_TRACE_FACILITY */
 /*----------------------------------------------------------*/
 
-#if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
+#if ( configUSE_TASK_ITERATOR == 1 )
 
-	TaskHandle_t xTaskGetIdleTaskHandle( void )
+	void vTaskIteratorInit( TaskIterator_t * const pxIterator )
 	{
-		/* If xTaskGetIdleTaskHandle() is called before the scheduler has been
-		started, then xIdleTaskHandle will be NULL. */
-		configASSERT( ( xIdleTaskHandle != NULL ) );
-		return xIdleTaskHandle;
-	}
-
-#endif /* INCLUDE_xTaskGetIdleTaskHandle */
-/*----------------------------------------------------------*/
-
-/* This conditional compilation should use inequality to 0, not equality to 1.
-This is to ensure vTaskStepTick() is available when user defined low power mode
-implementations require configUSE_TICKLESS_IDLE to be set to a value other than
-1. */
-#if ( configUSE_TICKLESS_IDLE != 0 )
+		configASSERT( pxIterator );
 
-	void vTaskStepTick( const TickType_t xTicksToJump )
-	{
-		/* Correct the tick count value after a period during which the tick
-		was suppressed.  Note this does *not* call the tick hook function for
-		each stepped tick. */
-		configASSERT( ( xTickCount + xTicksToJump ) <= xNextTaskUnblockTime );
-		xTickCount += xTicksToJump;
-		traceINCREASE_TICK_COUNT( xTicksToJump );
+		pxIterator->pvLastItem = NULL;
+		pxIterator->uxLastTaskNumber = ( UBaseType_t ) 0U;
+		pxIterator->uxGeneration = ( UBaseType_t ) 0U;
 	}
+	/*-----------------------------------------------------------*/
 
-#endif /* configUSE_TICKLESS_IDLE */
-/*----------------------------------------------------------*/
-
-#if ( INCLUDE_xTaskAbortDelay == 1 )
-
-	BaseType_t xTaskAbortDelay( TaskHandle_t xTask )
+	UBaseType_t uxTaskGetSystemStateIncremental( TaskIterator_t * const pxIterator, TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
 	{
-	TCB_t *pxTCB = xTask;
-	BaseType_t xReturn;
+	UBaseType_t uxTask = 0;
+	const ListItem_t *pxEndMarker;
+	ListItem_t *pxItem;
+	TCB_t *pxTCB;
 
-		configASSERT( pxTCB );
+		configASSERT( pxIterator );
+		configASSERT( pxTaskStatusArray );
 
 		vTaskSuspendAll();
 		{
-			/* A task can only be prematurely removed from the Blocked state if
-			it is actually in the Blocked state. */
-			if( eTaskGetState( xTask ) == eBlocked )
+			/* The registry is not initialised until the first task is
+			created, and then holds at least the idle task. */
+			if( listCURRENT_LIST_LENGTH( &xTaskRegistry ) > ( UBaseType_t ) 0 )
 			{
-				xReturn = pdPASS;
-
-				/* Remove the reference to the task from the blocked list.  An
-				interrupt won't touch the xStateListItem because the
-				scheduler is suspended. */
-				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+				pxEndMarker = listGET_END_MARKER( &xTaskRegistry );
 
-				/* Is the task waiting on an event also?  If so remove it from
-				the event list too.  Interrupts can touch the event list item,
-				even though the scheduler is suspended, so a critical section
-				is used. */
-				taskENTER_CRITICAL();
+				if( ( pxIterator->pvLastItem != NULL ) && ( pxIterator->uxGeneration == uxTaskRegistryGeneration ) )
 				{
-					if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
-					{
-						( void ) uxListRemove( &( pxTCB->xEventListItem ) );
-						pxTCB->ucDelayAborted = pdTRUE;
-					}
-					else
+					/* No task was deleted since the last call, so the task
+					reported last is still in the registry. */
+					pxItem = listGET_NEXT( ( ListItem_t * ) pxIterator->pvLastItem );
+				}
+				else
+				{
+					/* Find the first task created after the one reported last.
+					Only the task numbers are compared, which is quick
+					compared to inspecting a task. */
+					for( pxItem = listGET_HEAD_ENTRY( &xTaskRegistry ); pxItem != pxEndMarker; pxItem = listGET_NEXT( pxItem ) )
 					{
-						mtCOVERAGE_TEST_MARKER();
+						pxTCB = listGET_LIST_ITEM_OWNER( pxItem );
+
+						if( ( pxIterator->pvLastItem == NULL ) || ( pxTCB->uxTCBNumber > pxIterator->uxLastTaskNumber ) )
+						{
+							break;
+						}
 					}
 				}
-				taskEXIT_CRITICAL();
 
-				/* Place the unblocked task into the appropriate ready list. */
-				prvAddTaskToReadyList( pxTCB );
+				for( ; ( pxItem != pxEndMarker ) && ( uxTask < uxArraySize ); pxItem = listGET_NEXT( pxItem ) )
+				{
+					pxTCB = listGET_LIST_ITEM_OWNER( pxItem );
+					vTaskGetInfo( ( TaskHandle_t ) pxTCB, &( pxTaskStatusArray[ uxTask ] ), pdTRUE, eInvalid );
+					uxTask++;
 
-				/* A task being unblocked cannot cause an immediate context
-				switch if preemption is turned off. */
-				#if (  configUSE_PREEMPTION == 1 )
+					pxIterator->pvLastItem = ( void * ) pxItem;
+					pxIterator->uxLastTaskNumber = pxTCB->uxTCBNumber;
+					pxIterator->uxGeneration = uxTaskRegistryGeneration;
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			if( pulTotalRunTime != NULL )
+			{
+				#if ( configGENERATE_RUN_TIME_STATS == 1 )
 				{
-					/* Preemption is on, but a context switch should only be
-					performed if the unblocked task has a priority that is
-					equal to or higher than the currently executing task. */
-					if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
-					{
-						/* Pend the yield to be performed when the scheduler
-						is unsuspended. */
-						xYieldPending = pdTRUE;
-					}
-					else
-					{
-						mtCOVERAGE_TEST_MARKER();
-					}
+					#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+						portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
+					#else
+						*pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+					#endif
 				}
-				#endif /* configUSE_PREEMPTION */
+				#else
+				{
+					*pulTotalRunTime = 0;
+				}
+				#endif
 			}
 			else
 			{
-				xReturn = pdFAIL;
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		return uxTask;
+	}
+
+#endif /* configUSE_TASK_ITERATOR */
+/*----------------------------------------------------------*/
+
+#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+
+	UBaseType_t uxTaskGetRunTimeStatsSnapshot( TaskRunTimeStats_t * const pxStatsArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
+	{
+	UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
+
+		configASSERT( pxStatsArray );
+
+		/* Only the counters are copied, so the time the scheduler is
+		suspended is short and bounded by uxArraySize. */
+		vTaskSuspendAll();
+		{
+			do
+			{
+				uxQueue--;
+				uxTask += prvListRunTimeStatsWithinSingleList( &( pxStatsArray[ uxTask ] ), uxArraySize - uxTask, &( pxReadyTasksLists[ uxQueue ] ) );
+
+			} while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+			uxTask += prvListRunTimeStatsWithinSingleList( &( pxStatsArray[ uxTask ] ), uxArraySize - uxTask, pxDelayedTaskList );
+			uxTask += prvListRunTimeStatsWithinSingleList( &( pxStatsArray[ uxTask ] ), uxArraySize - uxTask, pxOverflowDelayedTaskList );
+
+			#if ( INCLUDE_vTaskSuspend == 1 )
+			{
+				uxTask += prvListRunTimeStatsWithinSingleList( &( pxStatsArray[ uxTask ] ), uxArraySize - uxTask, &xSuspendedTaskList );
+			}
+			#endif
+
+			if( pulTotalRunTime != NULL )
+			{
+				#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+					portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
+				#else
+					*pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+				#endif
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		return uxTask;
+	}
+
+#endif /* configUSE_EXTENDED_RUN_TIME_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+
+	static UBaseType_t prvListRunTimeStatsWithinSingleList( TaskRunTimeStats_t *pxStatsArray, UBaseType_t uxSpace, const List_t *pxList )
+	{
+	const ListItem_t *pxItem;
+	const TCB_t *pxTCB;
+	UBaseType_t uxTask = 0;
+
+		for( pxItem = listGET_HEAD_ENTRY( pxList ); ( pxItem != listGET_END_MARKER( pxList ) ) && ( uxTask < uxSpace ); pxItem = listGET_NEXT( pxItem ) )
+		{
+			pxTCB = ( const TCB_t * ) listGET_LIST_ITEM_OWNER( pxItem ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+			pxStatsArray[ uxTask ].xHandle = ( TaskHandle_t ) pxTCB;
+			pxStatsArray[ uxTask ].ulRunTimeCounter = pxTCB->ulRunTimeCounter;
+			pxStatsArray[ uxTask ].ulSwitchInCount = pxTCB->ulSwitchInCount;
+			pxStatsArray[ uxTask ].ulPreemptionCount = pxTCB->ulPreemptionCount;
+			pxStatsArray[ uxTask ].ulLongestRunTime = pxTCB->ulLongestRunTime;
+			uxTask++;
+		}
+
+		return uxTask;
+	}
+
+#endif /* configUSE_EXTENDED_RUN_TIME_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
+
+	TaskHandle_t xTaskGetIdleTaskHandle( void )
+	{
+		/* If xTaskGetIdleTaskHandle() is called before the scheduler has been
+		started, then xIdleTaskHandle will be NULL. */
+		configASSERT( ( xIdleTaskHandle != NULL ) );
+		return xIdleTaskHandle;
+	}
+
+#endif /* INCLUDE_xTaskGetIdleTaskHandle */
+/*----------------------------------------------------------*/
+
+/* This conditional compilation should use inequality to 0, not equality to 1.
+This is to ensure vTaskStepTick() is available when user defined low power mode
+implementations require configUSE_TICKLESS_IDLE to be set to a value other than
+1. */
+#if ( configUSE_TICKLESS_IDLE != 0 )
+
+	void vTaskStepTick( const TickType_t xTicksToJump )
+	{
+		/* Correct the tick count value after a period during which the tick
+		was suppressed.  Note this does *not* call the tick hook function for
+		each stepped tick. */
+		configASSERT( ( xTickCount + xTicksToJump ) <= xNextTaskUnblockTime );
+		xTickCount += xTicksToJump;
+		traceINCREASE_TICK_COUNT( xTicksToJump );
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*----------------------------------------------------------*/
+
+#if ( INCLUDE_xTaskAbortDelay == 1 )
+
+	BaseType_t xTaskAbortDelay( TaskHandle_t xTask )
+	{
+	TCB_t *pxTCB = xTask;
+	BaseType_t xReturn;
+
+		configASSERT( pxTCB );
+
+		vTaskSuspendAll();
+		{
+			/* A task can only be prematurely removed from the Blocked state if
+			it is actually in the Blocked state. */
+			if( eTaskGetState( xTask ) == eBlocked )
+			{
+				xReturn = pdPASS;
+
+				/* Remove the reference to the task from the blocked list.  An
+				interrupt won't touch the xStateListItem because the
+				scheduler is suspended. */
+				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+
+				/* Is the task waiting on an event also?  If so remove it from
+				the event list too.  Interrupts can touch the event list item,
+				even though the scheduler is suspended, so a critical section
+				is used. */
+				taskENTER_CRITICAL();
+				{
+					if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+					{
+						( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+						pxTCB->ucDelayAborted = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				taskEXIT_CRITICAL();
+
+				/* Place the unblocked task into the appropriate ready list. */
+				prvAddTaskToReadyList( pxTCB );
+
+				/* A task being unblocked cannot cause an immediate context
+				switch if preemption is turned off. */
+				#if (  configUSE_PREEMPTION == 1 )
+				{
+					/* Preemption is on, but a context switch should only be
+					performed if the unblocked task has a priority that is
+					equal to or higher than the currently executing task. */
+					if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+					{
+						/* Pend the yield to be performed when the scheduler
+						is unsuspended. */
+						xYieldPending = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#endif /* configUSE_PREEMPTION */
+			}
+			else
+			{
+				xReturn = pdFAIL;
 			}
 		}
 		( void ) xTaskResumeAll();
@@ -2943,7 +3347,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 #endif /* configUSE_APPLICATION_TASK_TAG */
 /*-----------------------------------------------------------*/
 
-void vTaskSwitchContext( void )
+portHOT_FUNCTION void vTaskSwitchContext( void )
 {
 	if( uxSchedulerSuspended != ( UBaseType_t ) pdFALSE )
 	{
@@ -2974,12 +3378,40 @@ void vTaskSwitchContext( void )
 			if( ulTotalRunTime > ulTaskSwitchedInTime )
 			{
 				pxCurrentTCB->ulRunTimeCounter += ( ulTotalRunTime - ulTaskSwitchedInTime );
+
+				#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+				{
+					if( ( ulTotalRunTime - ulTaskSwitchedInTime ) > pxCurrentTCB->ulLongestRunTime )
+					{
+						pxCurrentTCB->ulLongestRunTime = ulTotalRunTime - ulTaskSwitchedInTime;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#endif /* configUSE_EXTENDED_RUN_TIME_STATS */
 			}
 			else
 			{
 				mtCOVERAGE_TEST_MARKER();
 			}
 			ulTaskSwitchedInTime = ulTotalRunTime;
+
+			#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+			{
+				/* A task that is switched out while still in its ready list
+				was preempted, or yielded, rather than having blocked. */
+				if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ), &( pxCurrentTCB->xStateListItem ) ) != pdFALSE )
+				{
+					( pxCurrentTCB->ulPreemptionCount )++;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			#endif /* configUSE_EXTENDED_RUN_TIME_STATS */
 		}
 		#endif /* configGENERATE_RUN_TIME_STATS */
 
@@ -2998,6 +3430,12 @@ void vTaskSwitchContext( void )
 		taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
 		traceTASK_SWITCHED_IN();
 
+		#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+		{
+			( pxCurrentTCB->ulSwitchInCount )++;
+		}
+		#endif /* configUSE_EXTENDED_RUN_TIME_STATS */
+
 		/* After the new task is switched in, update the global errno. */
 		#if( configUSE_POSIX_ERRNO == 1 )
 		{
@@ -3090,6 +3528,59 @@ void vTaskPlaceOnUnorderedEventList( List_t * pxEventList, const TickType_t xIte
 #endif /* configUSE_TIMERS */
 /*-----------------------------------------------------------*/
 
+#if( configUSE_TIMER_SLACK == 1 )
+
+	TickType_t xTaskGetCoalescedDelay( const TickType_t xTicksToWait, TickType_t xSlack )
+	{
+	const TickType_t xConstTickCount = xTickCount;
+	const TickType_t xEarliest = xConstTickCount + xTicksToWait;
+	TickType_t xLatest, xWakeTime;
+	const ListItem_t *pxItem;
+	const ListItem_t *pxEnd;
+
+		/* The delayed list may only be inspected while the scheduler is
+		suspended. */
+		configASSERT( uxSchedulerSuspended != 0 );
+
+		if( xSlack > ( portMAX_DELAY - xTicksToWait ) )
+		{
+			xSlack = portMAX_DELAY - xTicksToWait;
+		}
+
+		xLatest = xEarliest + xSlack;
+		xWakeTime = xLatest;
+
+		/* Look for the first wake-up that is already planned within the
+		window.  The window is only inspected when it does not cross an
+		overflow of the tick count, so all of it is in the current delayed
+		list, which is sorted by wake time. */
+		if( ( xEarliest >= xConstTickCount ) && ( xLatest > xEarliest ) )
+		{
+			pxEnd = listGET_END_MARKER( pxDelayedTaskList );
+
+			for( pxItem = listGET_HEAD_ENTRY( pxDelayedTaskList ); pxItem != pxEnd; pxItem = listGET_NEXT( pxItem ) )
+			{
+				if( listGET_LIST_ITEM_VALUE( pxItem ) >= xEarliest )
+				{
+					if( listGET_LIST_ITEM_VALUE( pxItem ) < xLatest )
+					{
+						xWakeTime = listGET_LIST_ITEM_VALUE( pxItem );
+					}
+					break;
+				}
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return ( TickType_t ) ( xWakeTime - xConstTickCount );
+	}
+
+#endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
 BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
 {
 TCB_t *pxUnblockedTCB;
@@ -3192,6 +3683,56 @@ TCB_t *pxUnblockedTCB;
 }
 /*-----------------------------------------------------------*/
 
+#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+
+	BaseType_t xTaskRemoveFromUnorderedEventListFromISR( ListItem_t * pxEventListItem, const TickType_t xItemValue )
+	{
+	TCB_t *pxUnblockedTCB;
+	BaseType_t xReturn;
+
+		/* THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.  The caller
+		guarantees no task is accessing the event list at the same time. */
+		listSET_LIST_ITEM_VALUE( pxEventListItem, xItemValue | taskEVENT_LIST_ITEM_VALUE_IN_USE );
+
+		pxUnblockedTCB = listGET_LIST_ITEM_OWNER( pxEventListItem ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+		configASSERT( pxUnblockedTCB );
+		( void ) uxListRemove( pxEventListItem );
+
+		if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+		{
+			( void ) uxListRemove( &( pxUnblockedTCB->xStateListItem ) );
+			prvAddTaskToReadyList( pxUnblockedTCB );
+
+			#if( configUSE_TICKLESS_IDLE != 0 )
+			{
+				/* See the comment in xTaskRemoveFromEventList(). */
+				prvResetNextTaskUnblockTime();
+			}
+			#endif
+		}
+		else
+		{
+			/* The delayed and ready lists cannot be accessed, so hold this task
+			pending until the scheduler is resumed. */
+			vListInsertEnd( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
+		}
+
+		if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+		{
+			xReturn = pdTRUE;
+			xYieldPending = pdTRUE;
+		}
+		else
+		{
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT */
+/*-----------------------------------------------------------*/
+
 void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
 {
 	configASSERT( pxTimeOut );
@@ -3401,6 +3942,9 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 		#if ( configUSE_TICKLESS_IDLE != 0 )
 		{
 		TickType_t xExpectedIdleTime;
+		#if ( configUSE_TICKLESS_IDLE_STATS == 1 )
+			TickType_t xTicksBeforeSleep;
+		#endif
 
 			/* It is not desirable to suspend then resume the scheduler on
 			each iteration of the idle task.  Therefore, a preliminary
@@ -3426,9 +3970,37 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 
 					if( xExpectedIdleTime >= configEXPECTED_IDLE_TIME_BEFORE_SLEEP )
 					{
+						#if ( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+						{
+							/* Let the application pick the deepest sleep
+							mode that wakes up fast enough for every blocked
+							task. */
+							uxSleepDepth = configSELECT_SLEEP_DEPTH( xExpectedIdleTime, prvGetSleepLatencyTolerance() );
+							configASSERT( uxSleepDepth < ( UBaseType_t ) configTICKLESS_IDLE_SLEEP_DEPTHS );
+						}
+						#endif /* configUSE_SLEEP_LATENCY_TOLERANCE */
+
+						#if ( configUSE_TICKLESS_IDLE_STATS == 1 )
+						{
+							/* Ticks that occur while the scheduler is
+							suspended are pended, and the port steps the
+							tick count over the ticks it suppressed, so the
+							sum of both measures the time spent asleep. */
+							xTicksBeforeSleep = xTickCount + ( TickType_t ) uxPendedTicks;
+						}
+						#endif /* configUSE_TICKLESS_IDLE_STATS */
+
 						traceLOW_POWER_IDLE_BEGIN();
 						portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime );
 						traceLOW_POWER_IDLE_END();
+
+						#if ( configUSE_TICKLESS_IDLE_STATS == 1 )
+						{
+							xTicklessIdleStats.ulSleepEntries++;
+							xTicklessIdleStats.ulDepthEntries[ tskSLEEP_DEPTH() ]++;
+							xTicklessIdleStats.ulDepthResidency[ tskSLEEP_DEPTH() ] += ( uint32_t ) ( ( TickType_t ) ( xTickCount + ( TickType_t ) uxPendedTicks ) - xTicksBeforeSleep );
+						}
+						#endif /* configUSE_TICKLESS_IDLE_STATS */
 					}
 					else
 					{
@@ -3442,88 +4014,444 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 				mtCOVERAGE_TEST_MARKER();
 			}
 		}
-		#endif /* configUSE_TICKLESS_IDLE */
+		#endif /* configUSE_TICKLESS_IDLE */
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TICKLESS_IDLE != 0 )
+
+	eSleepModeStatus eTaskConfirmSleepModeStatus( void )
+	{
+	/* The idle task exists in addition to the application tasks. */
+	const UBaseType_t uxNonApplicationTasks = 1;
+	eSleepModeStatus eReturn = eStandardSleep;
+
+		if( listCURRENT_LIST_LENGTH( &xPendingReadyList ) != 0 )
+		{
+			/* A task was made ready while the scheduler was suspended. */
+			eReturn = eAbortSleep;
+		}
+		else if( xYieldPending != pdFALSE )
+		{
+			/* A yield was pended while the scheduler was suspended. */
+			eReturn = eAbortSleep;
+		}
+		else
+		{
+			/* If all the tasks are in the suspended list (which might mean they
+			have an infinite block time rather than actually being suspended)
+			then it is safe to turn all clocks off and just wait for external
+			interrupts. */
+			if( listCURRENT_LIST_LENGTH( &xSuspendedTaskList ) == ( uxCurrentNumberOfTasks - uxNonApplicationTasks ) )
+			{
+				eReturn = eNoTasksWaitingTimeout;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+
+		#if( configUSE_TICKLESS_IDLE_STATS == 1 )
+		{
+			if( eReturn == eAbortSleep )
+			{
+				xTicklessIdleStats.ulSleepAborts++;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_TICKLESS_IDLE_STATS */
+
+		return eReturn;
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TICKLESS_IDLE_STATS == 1 )
+
+	void vTaskGetTicklessIdleStats( TicklessIdleStats_t * const pxStats )
+	{
+		configASSERT( pxStats );
+
+		taskENTER_CRITICAL();
+		{
+			*pxStats = xTicklessIdleStats;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_TICKLESS_IDLE_STATS */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TICKLESS_IDLE_STATS == 1 )
+
+	void vTaskClearTicklessIdleStats( void )
+	{
+		taskENTER_CRITICAL();
+		{
+			( void ) memset( &xTicklessIdleStats, 0x00, sizeof( xTicklessIdleStats ) );
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_TICKLESS_IDLE_STATS */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+
+	void vTaskSetSleepLatencyTolerance( TaskHandle_t xTask, uint32_t ulLatencyTolerance )
+	{
+	TCB_t *pxTCB;
+
+		/* The idle task reads the tolerances of the blocked tasks each time
+		it is about to sleep, so nothing else needs updating here. */
+		taskENTER_CRITICAL();
+		{
+			pxTCB = prvGetTCBFromHandle( xTask );
+			pxTCB->ulSleepLatencyTolerance = ulLatencyTolerance;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_SLEEP_LATENCY_TOLERANCE */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+
+	UBaseType_t uxTaskGetSleepDepth( void )
+	{
+		return uxSleepDepth;
+	}
+
+#endif /* configUSE_SLEEP_LATENCY_TOLERANCE */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+
+	static uint32_t prvGetSleepLatencyTolerance( void )
+	{
+	uint32_t ulTolerance = tskNO_LATENCY_CONSTRAINT;
+
+		/* The idle task only sleeps when no other task is ready, so only the
+		blocked and suspended tasks need to be considered. */
+		ulTolerance = prvGetListSleepLatencyTolerance( pxDelayedTaskList, ulTolerance );
+		ulTolerance = prvGetListSleepLatencyTolerance( pxOverflowDelayedTaskList, ulTolerance );
+		ulTolerance = prvGetListSleepLatencyTolerance( &xSuspendedTaskList, ulTolerance );
+
+		return ulTolerance;
+	}
+
+	static uint32_t prvGetListSleepLatencyTolerance( const List_t *pxList, uint32_t ulTolerance )
+	{
+	const ListItem_t *pxItem;
+	const TCB_t *pxTCB;
+
+		for( pxItem = listGET_HEAD_ENTRY( pxList ); pxItem != listGET_END_MARKER( pxList ); pxItem = listGET_NEXT( pxItem ) )
+		{
+			pxTCB = ( const TCB_t * ) listGET_LIST_ITEM_OWNER( pxItem ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+
+			if( pxTCB->ulSleepLatencyTolerance < ulTolerance )
+			{
+				ulTolerance = pxTCB->ulSleepLatencyTolerance;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+
+		return ulTolerance;
+	}
+
+#endif /* configUSE_SLEEP_LATENCY_TOLERANCE */
+/*-----------------------------------------------------------*/
+
+#if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS != 0 )
+
+	void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTaskToSet, BaseType_t xIndex, void *pvValue )
+	{
+	TCB_t *pxTCB;
+
+		if( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+		{
+			pxTCB = prvGetTCBFromHandle( xTaskToSet );
+			pxTCB->pvThreadLocalStoragePointers[ xIndex ] = pvValue;
+		}
+	}
+
+#endif /* configNUM_THREAD_LOCAL_STORAGE_POINTERS */
+/*-----------------------------------------------------------*/
+
+#if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS != 0 )
+
+	void *pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTaskToQuery, BaseType_t xIndex )
+	{
+	void *pvReturn = NULL;
+	TCB_t *pxTCB;
+
+		if( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+		{
+			pxTCB = prvGetTCBFromHandle( xTaskToQuery );
+			pvReturn = pxTCB->pvThreadLocalStoragePointers[ xIndex ];
+		}
+		else
+		{
+			pvReturn = NULL;
+		}
+
+		return pvReturn;
+	}
+
+#endif /* configNUM_THREAD_LOCAL_STORAGE_POINTERS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_ARENAS == 1 )
+
+	TaskArenaHandle_t xTaskArenaCreateStatic( uint8_t *pucArenaStorage, size_t xArenaSizeBytes, StaticTaskArena_t *pxStaticArena )
+	{
+	TaskArena_t *pxArena = NULL;
+	uint8_t *pucStart;
+
+		#if( configASSERT_DEFINED == 1 )
+		{
+			/* Sanity check that the size of the structure used to declare a
+			variable of type StaticTaskArena_t equals the size of the real
+			arena structure. */
+			volatile size_t xSize = sizeof( StaticTaskArena_t );
+			configASSERT( xSize == sizeof( TaskArena_t ) );
+			( void ) xSize; /* Keeps lint quiet when configASSERT() is not defined. */
+		}
+		#endif /* configASSERT_DEFINED */
+
+		configASSERT( pucArenaStorage );
+		configASSERT( pxStaticArena );
+
+		if( ( pucArenaStorage != NULL ) && ( pxStaticArena != NULL ) )
+		{
+			/* The structures are designed to have the same alignment, and the
+			size is checked by an assert above, so this is safe. */
+			pxArena = ( TaskArena_t * ) pxStaticArena; /*lint !e740 !e9087 Unusual cast is ok as the structures are designed to have the same alignment, and the size is checked by an assert. */
+
+			/* Ensure the arena starts on a correctly aligned boundary. */
+			pucStart = pucArenaStorage;
+			if( ( ( ( portPOINTER_SIZE_TYPE ) pucStart ) & ( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) ) != 0UL )
+			{
+				pucStart += portBYTE_ALIGNMENT - ( ( ( portPOINTER_SIZE_TYPE ) pucStart ) & ( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			pxArena->pucStart = pucStart;
+			pxArena->pucEnd = pucArenaStorage + xArenaSizeBytes;
+			configASSERT( pxArena->pucEnd >= pxArena->pucStart );
+			pxArena->pucNext = pucStart;
+			pxArena->pucLastBlock = NULL;
+			pxArena->xHighWaterMark = 0U;
+
+			taskENTER_CRITICAL();
+			{
+				pxArena->pxNextArena = pxArenaList;
+				pxArenaList = pxArena;
+			}
+			taskEXIT_CRITICAL();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return pxArena;
+	}
+
+#endif /* configUSE_TASK_ARENAS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_ARENAS == 1 )
+
+	void vTaskArenaDelete( TaskArenaHandle_t xArena )
+	{
+	TaskArena_t **ppxIterator;
+
+		configASSERT( xArena );
+
+		taskENTER_CRITICAL();
+		{
+			for( ppxIterator = ( TaskArena_t ** ) &pxArenaList; *ppxIterator != NULL; ppxIterator = &( ( *ppxIterator )->pxNextArena ) )
+			{
+				if( *ppxIterator == xArena )
+				{
+					*ppxIterator = xArena->pxNextArena;
+					break;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
 	}
-}
+
+#endif /* configUSE_TASK_ARENAS */
 /*-----------------------------------------------------------*/
 
-#if( configUSE_TICKLESS_IDLE != 0 )
+#if ( configUSE_TASK_ARENAS == 1 )
 
-	eSleepModeStatus eTaskConfirmSleepModeStatus( void )
+	void *pvTaskArenaAllocate( TaskArenaHandle_t xArena, size_t xWantedSize )
 	{
-	/* The idle task exists in addition to the application tasks. */
-	const UBaseType_t uxNonApplicationTasks = 1;
-	eSleepModeStatus eReturn = eStandardSleep;
+	void *pvReturn = NULL;
+	size_t xUsed;
 
-		if( listCURRENT_LIST_LENGTH( &xPendingReadyList ) != 0 )
+		configASSERT( xArena );
+
+		/* Ensure that blocks are always aligned to the required number of
+		bytes. */
+		if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
 		{
-			/* A task was made ready while the scheduler was suspended. */
-			eReturn = eAbortSleep;
+			xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
 		}
-		else if( xYieldPending != pdFALSE )
+		else
 		{
-			/* A yield was pended while the scheduler was suspended. */
-			eReturn = eAbortSleep;
+			mtCOVERAGE_TEST_MARKER();
 		}
-		else
+
+		if( ( xWantedSize > 0U ) && ( xWantedSize <= ( size_t ) ( xArena->pucEnd - xArena->pucNext ) ) )
 		{
-			/* If all the tasks are in the suspended list (which might mean they
-			have an infinite block time rather than actually being suspended)
-			then it is safe to turn all clocks off and just wait for external
-			interrupts. */
-			if( listCURRENT_LIST_LENGTH( &xSuspendedTaskList ) == ( uxCurrentNumberOfTasks - uxNonApplicationTasks ) )
+			pvReturn = ( void * ) xArena->pucNext;
+			xArena->pucLastBlock = xArena->pucNext;
+			xArena->pucNext += xWantedSize;
+
+			xUsed = ( size_t ) ( xArena->pucNext - xArena->pucStart );
+			if( xArena->xHighWaterMark < xUsed )
 			{
-				eReturn = eNoTasksWaitingTimeout;
+				xArena->xHighWaterMark = xUsed;
 			}
 			else
 			{
 				mtCOVERAGE_TEST_MARKER();
 			}
 		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
 
-		return eReturn;
+		return pvReturn;
 	}
 
-#endif /* configUSE_TICKLESS_IDLE */
+#endif /* configUSE_TASK_ARENAS */
 /*-----------------------------------------------------------*/
 
-#if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS != 0 )
+#if ( configUSE_TASK_ARENAS == 1 )
 
-	void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTaskToSet, BaseType_t xIndex, void *pvValue )
+	void vTaskArenaReset( TaskArenaHandle_t xArena )
 	{
-	TCB_t *pxTCB;
+		configASSERT( xArena );
 
-		if( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS )
-		{
-			pxTCB = prvGetTCBFromHandle( xTaskToSet );
-			pxTCB->pvThreadLocalStoragePointers[ xIndex ] = pvValue;
-		}
+		xArena->pucNext = xArena->pucStart;
+		xArena->pucLastBlock = NULL;
 	}
 
-#endif /* configNUM_THREAD_LOCAL_STORAGE_POINTERS */
+#endif /* configUSE_TASK_ARENAS */
 /*-----------------------------------------------------------*/
 
-#if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS != 0 )
+#if ( configUSE_TASK_ARENAS == 1 )
 
-	void *pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTaskToQuery, BaseType_t xIndex )
+	size_t xTaskArenaGetHighWaterMark( TaskArenaHandle_t xArena )
+	{
+		configASSERT( xArena );
+
+		return xArena->xHighWaterMark;
+	}
+
+#endif /* configUSE_TASK_ARENAS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_ARENAS == 1 )
+
+	TaskArenaHandle_t xTaskArenaBind( TaskArenaHandle_t xArena )
+	{
+	TaskArena_t *pxPrevious;
+
+		/* Only the task itself accesses its arena field, so no critical
+		section is needed. */
+		pxPrevious = pxCurrentTCB->pxArena;
+		pxCurrentTCB->pxArena = xArena;
+
+		return pxPrevious;
+	}
+
+#endif /* configUSE_TASK_ARENAS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_ARENAS == 1 )
+
+	void *pvTaskArenaMalloc( size_t xWantedSize )
 	{
 	void *pvReturn = NULL;
-	TCB_t *pxTCB;
 
-		if( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+		if( ( pxCurrentTCB != NULL ) && ( pxCurrentTCB->pxArena != NULL ) )
 		{
-			pxTCB = prvGetTCBFromHandle( xTaskToQuery );
-			pvReturn = pxTCB->pvThreadLocalStoragePointers[ xIndex ];
+			pvReturn = pvTaskArenaAllocate( pxCurrentTCB->pxArena, xWantedSize );
 		}
 		else
 		{
-			pvReturn = NULL;
+			mtCOVERAGE_TEST_MARKER();
 		}
 
 		return pvReturn;
 	}
 
-#endif /* configNUM_THREAD_LOCAL_STORAGE_POINTERS */
+#endif /* configUSE_TASK_ARENAS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_ARENAS == 1 )
+
+	BaseType_t xTaskArenaFree( void *pv )
+	{
+	BaseType_t xReturn = pdFALSE;
+	TaskArena_t *pxArena;
+	uint8_t *puc = ( uint8_t * ) pv;
+
+		if( ( puc != NULL ) && ( pxArenaList != NULL ) )
+		{
+			taskENTER_CRITICAL();
+			{
+				for( pxArena = pxArenaList; pxArena != NULL; pxArena = pxArena->pxNextArena )
+				{
+					if( ( puc >= pxArena->pucStart ) && ( puc < pxArena->pucEnd ) )
+					{
+						/* The most recent block of the caller's own arena
+						can be given back. */
+						if( ( pxArena == pxCurrentTCB->pxArena ) && ( puc == pxArena->pucLastBlock ) )
+						{
+							pxArena->pucNext = puc;
+							pxArena->pucLastBlock = NULL;
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+
+						xReturn = pdTRUE;
+						break;
+					}
+				}
+			}
+			taskEXIT_CRITICAL();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_TASK_ARENAS */
 /*-----------------------------------------------------------*/
 
 #if ( portUSING_MPU_WRAPPERS == 1 )
@@ -3561,6 +4489,18 @@ UBaseType_t uxPriority;
 	}
 	#endif /* INCLUDE_vTaskDelete */
 
+	#if ( configTASK_POOL_SIZE > 0 )
+	{
+		vListInitialise( &xTaskPool );
+	}
+	#endif /* configTASK_POOL_SIZE */
+
+	#if ( configUSE_TASK_ITERATOR == 1 )
+	{
+		vListInitialise( &xTaskRegistry );
+	}
+	#endif /* configUSE_TASK_ITERATOR */
+
 	#if ( INCLUDE_vTaskSuspend == 1 )
 	{
 		vListInitialise( &xSuspendedTaskList );
@@ -3577,7 +4517,8 @@ UBaseType_t uxPriority;
 static void prvCheckTasksWaitingTermination( void )
 {
 
-	/** THIS FUNCTION IS CALLED FROM THE RTOS IDLE TASK **/
+	/** THIS FUNCTION IS CALLED FROM THE RTOS IDLE TASK, AND FROM
+	xTaskCreate() WHEN THE TASK POOL IS USED **/
 
 	#if ( INCLUDE_vTaskDelete == 1 )
 	{
@@ -3587,16 +4528,26 @@ static void prvCheckTasksWaitingTermination( void )
 		being called too often in the idle task. */
 		while( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
 		{
+			pxTCB = NULL;
+
 			taskENTER_CRITICAL();
 			{
-				pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
-				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
-				--uxCurrentNumberOfTasks;
-				--uxDeletedTasksWaitingCleanUp;
+				/* Check again, as with the task pool another task may have
+				cleaned up the list since it was checked above. */
+				if( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
+				{
+					pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+					( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+					--uxCurrentNumberOfTasks;
+					--uxDeletedTasksWaitingCleanUp;
+				}
 			}
 			taskEXIT_CRITICAL();
 
-			prvDeleteTCB( pxTCB );
+			if( pxTCB != NULL )
+			{
+				prvDeleteTCB( pxTCB );
+			}
 		}
 	}
 	#endif /* INCLUDE_vTaskDelete */
@@ -3841,8 +4792,7 @@ static void prvCheckTasksWaitingTermination( void )
 		{
 			/* The task can only have been allocated dynamically - free both
 			the stack and TCB. */
-			vPortFree( pxTCB->pxStack );
-			vPortFree( pxTCB );
+			prvFreeStackAndTCB( pxTCB );
 		}
 		#elif( tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE != 0 ) /*lint !e731 !e9029 Macro has been consolidated for readability reasons. */
 		{
@@ -3853,8 +4803,7 @@ static void prvCheckTasksWaitingTermination( void )
 			{
 				/* Both the stack and TCB were allocated dynamically, so both
 				must be freed. */
-				vPortFree( pxTCB->pxStack );
-				vPortFree( pxTCB );
+				prvFreeStackAndTCB( pxTCB );
 			}
 			else if( pxTCB->ucStaticallyAllocated == tskSTATICALLY_ALLOCATED_STACK_ONLY )
 			{
@@ -3876,6 +4825,123 @@ static void prvCheckTasksWaitingTermination( void )
 #endif /* INCLUDE_vTaskDelete */
 /*-----------------------------------------------------------*/
 
+#if( ( INCLUDE_vTaskDelete == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	static void prvFreeStackAndTCB( TCB_t *pxTCB )
+	{
+	BaseType_t xPooled = pdFALSE;
+
+		#if( configTASK_POOL_SIZE > 0 )
+		{
+			taskENTER_CRITICAL();
+			{
+				if( listCURRENT_LIST_LENGTH( &xTaskPool ) < ( UBaseType_t ) configTASK_POOL_SIZE )
+				{
+					/* The state list item is free now the task is deleted.
+					Its value orders the pool by stack depth. */
+					listSET_LIST_ITEM_VALUE( &( pxTCB->xStateListItem ), ( TickType_t ) pxTCB->ulStackDepth );
+					vListInsert( &xTaskPool, &( pxTCB->xStateListItem ) );
+					xPooled = pdTRUE;
+				}
+				else
+				{
+					xTaskPoolStats.ulFreed++;
+				}
+			}
+			taskEXIT_CRITICAL();
+		}
+		#endif /* configTASK_POOL_SIZE */
+
+		if( xPooled == pdFALSE )
+		{
+			vPortFree( pxTCB->pxStack );
+			vPortFree( pxTCB );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* ( INCLUDE_vTaskDelete == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( configTASK_POOL_SIZE > 0 )
+
+	static TCB_t *prvTaskPoolTake( uint32_t *pulStackDepth )
+	{
+	TCB_t *pxTCB = NULL;
+	ListItem_t const *pxEndMarker;
+	ListItem_t *pxItem;
+	uint32_t ulDepth;
+	const uint32_t ulLimit = *pulStackDepth + ( ( *pulStackDepth * ( uint32_t ) configTASK_POOL_STACK_SLACK_PERCENT ) / 100UL );
+
+		/* Tasks that deleted themselves are only pooled once cleaned up, which
+		would otherwise wait for the idle task to run. */
+		prvCheckTasksWaitingTermination();
+
+		taskENTER_CRITICAL();
+		{
+			/* The pool list is not initialised until the first task is
+			created, but its length reads as zero until then. */
+			if( listCURRENT_LIST_LENGTH( &xTaskPool ) > ( UBaseType_t ) 0 )
+			{
+				pxEndMarker = listGET_END_MARKER( &xTaskPool );
+
+				for( pxItem = listGET_HEAD_ENTRY( &xTaskPool ); pxItem != pxEndMarker; pxItem = listGET_NEXT( pxItem ) )
+				{
+					ulDepth = ( uint32_t ) listGET_LIST_ITEM_VALUE( pxItem );
+
+					if( ulDepth >= *pulStackDepth )
+					{
+						/* The pool is in order of depth, so this is the best
+						fit. */
+						if( ulDepth <= ulLimit )
+						{
+							pxTCB = listGET_LIST_ITEM_OWNER( pxItem );
+							( void ) uxListRemove( pxItem );
+							*pulStackDepth = ulDepth;
+						}
+
+						break;
+					}
+				}
+			}
+
+			if( pxTCB != NULL )
+			{
+				xTaskPoolStats.ulReused++;
+			}
+			else
+			{
+				xTaskPoolStats.ulAllocated++;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		return pxTCB;
+	}
+
+#endif /* configTASK_POOL_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( configTASK_POOL_SIZE > 0 )
+
+	void vTaskGetPoolStats( ObjectPoolStats_t *pxStats )
+	{
+		configASSERT( pxStats );
+
+		taskENTER_CRITICAL();
+		{
+			*pxStats = xTaskPoolStats;
+			pxStats->uxPooled = listCURRENT_LIST_LENGTH( &xTaskPool );
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configTASK_POOL_SIZE */
+/*-----------------------------------------------------------*/
+
 static void prvResetNextTaskUnblockTime( void )
 {
 TCB_t *pxTCB;
@@ -4308,8 +5374,11 @@ TCB_t *pxTCB;
 	void vTaskList( char * pcWriteBuffer )
 	{
 	TaskStatus_t *pxTaskStatusArray;
-	UBaseType_t uxArraySize, x;
+	UBaseType_t uxArraySize, uxTasks, x;
 	char cStatus;
+	#if ( configUSE_TASK_ITERATOR == 1 )
+		TaskIterator_t xIterator;
+	#endif
 
 		/*
 		 * PLEASE NOTE:
@@ -4339,54 +5408,70 @@ TCB_t *pxTCB;
 		/* Make sure the write buffer does not contain a string. */
 		*pcWriteBuffer = ( char ) 0x00;
 
-		/* Take a snapshot of the number of tasks in case it changes while this
-		function is executing. */
-		uxArraySize = uxCurrentNumberOfTasks;
+		#if ( configUSE_TASK_ITERATOR == 1 )
+		{
+			/* Only inspect a few tasks at a time, so the scheduler is not
+			suspended for long however many tasks there are. */
+			uxArraySize = configTASK_ITERATOR_CHUNK_SIZE;
+		}
+		#else
+		{
+			/* Take a snapshot of the number of tasks in case it changes while
+			this function is executing. */
+			uxArraySize = uxCurrentNumberOfTasks;
+		}
+		#endif /* configUSE_TASK_ITERATOR */
 
 		/* Allocate an array index for each task.  NOTE!  if
 		configSUPPORT_DYNAMIC_ALLOCATION is set to 0 then pvPortMalloc() will
 		equate to NULL. */
-		pxTaskStatusArray = pvPortMalloc( uxCurrentNumberOfTasks * sizeof( TaskStatus_t ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation allocates a struct that has the alignment requirements of a pointer. */
+		pxTaskStatusArray = pvPortMalloc( uxArraySize * sizeof( TaskStatus_t ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation allocates a struct that has the alignment requirements of a pointer. */
 
 		if( pxTaskStatusArray != NULL )
 		{
 			/* Generate the (binary) data. */
-			uxArraySize = uxTaskGetSystemState( pxTaskStatusArray, uxArraySize, NULL );
-
-			/* Create a human readable table from the binary data. */
-			for( x = 0; x < uxArraySize; x++ )
+			#if ( configUSE_TASK_ITERATOR == 1 )
+				vTaskIteratorInit( &xIterator );
+				while( ( uxTasks = uxTaskGetSystemStateIncremental( &xIterator, pxTaskStatusArray, uxArraySize, NULL ) ) > ( UBaseType_t ) 0 )
+			#else
+				uxTasks = uxTaskGetSystemState( pxTaskStatusArray, uxArraySize, NULL );
+			#endif /* configUSE_TASK_ITERATOR */
 			{
-				switch( pxTaskStatusArray[ x ].eCurrentState )
+				/* Create a human readable table from the binary data. */
+				for( x = 0; x < uxTasks; x++ )
 				{
-					case eRunning:		cStatus = tskRUNNING_CHAR;
-										break;
+					switch( pxTaskStatusArray[ x ].eCurrentState )
+					{
+						case eRunning:		cStatus = tskRUNNING_CHAR;
+											break;
 
-					case eReady:		cStatus = tskREADY_CHAR;
-										break;
+						case eReady:		cStatus = tskREADY_CHAR;
+											break;
 
-					case eBlocked:		cStatus = tskBLOCKED_CHAR;
-										break;
+						case eBlocked:		cStatus = tskBLOCKED_CHAR;
+											break;
 
-					case eSuspended:	cStatus = tskSUSPENDED_CHAR;
-										break;
+						case eSuspended:	cStatus = tskSUSPENDED_CHAR;
+											break;
 
-					case eDeleted:		cStatus = tskDELETED_CHAR;
-										break;
+						case eDeleted:		cStatus = tskDELETED_CHAR;
+											break;
 
-					case eInvalid:		/* Fall through. */
-					default:			/* Should not get here, but it is included
-										to prevent static checking errors. */
-										cStatus = ( char ) 0x00;
-										break;
-				}
+						case eInvalid:		/* Fall through. */
+						default:			/* Should not get here, but it is included
+											to prevent static checking errors. */
+											cStatus = ( char ) 0x00;
+											break;
+					}
 
-				/* Write the task name to the string, padding with spaces so it
-				can be printed in tabular form more easily. */
-				pcWriteBuffer = prvWriteNameToBuffer( pcWriteBuffer, pxTaskStatusArray[ x ].pcTaskName );
+					/* Write the task name to the string, padding with spaces so it
+					can be printed in tabular form more easily. */
+					pcWriteBuffer = prvWriteNameToBuffer( pcWriteBuffer, pxTaskStatusArray[ x ].pcTaskName );
 
-				/* Write the rest of the string. */
-				sprintf( pcWriteBuffer, "\t%c\t%u\t%u\t%u\r\n", cStatus, ( unsigned int ) pxTaskStatusArray[ x ].uxCurrentPriority, ( unsigned int ) pxTaskStatusArray[ x ].usStackHighWaterMark, ( unsigned int ) pxTaskStatusArray[ x ].xTaskNumber ); /*lint !e586 sprintf() allowed as this is compiled with many compilers and this is a utility function only - not part of the core kernel implementation. */
-				pcWriteBuffer += strlen( pcWriteBuffer ); /*lint !e9016 Pointer arithmetic ok on char pointers especially as in this case where it best denotes the intent of the code. */
+					/* Write the rest of the string. */
+					sprintf( pcWriteBuffer, "\t%c\t%u\t%u\t%u\r\n", cStatus, ( unsigned int ) pxTaskStatusArray[ x ].uxCurrentPriority, ( unsigned int ) pxTaskStatusArray[ x ].usStackHighWaterMark, ( unsigned int ) pxTaskStatusArray[ x ].xTaskNumber ); /*lint !e586 sprintf() allowed as this is compiled with many compilers and this is a utility function only - not part of the core kernel implementation. */
+					pcWriteBuffer += strlen( pcWriteBuffer ); /*lint !e9016 Pointer arithmetic ok on char pointers especially as in this case where it best denotes the intent of the code. */
+				}
 			}
 
 			/* Free the array again.  NOTE!  If configSUPPORT_DYNAMIC_ALLOCATION
@@ -4407,8 +5492,11 @@ TCB_t *pxTCB;
 	void vTaskGetRunTimeStats( char *pcWriteBuffer )
 	{
 	TaskStatus_t *pxTaskStatusArray;
-	UBaseType_t uxArraySize, x;
+	UBaseType_t uxArraySize, uxTasks, x;
 	uint32_t ulTotalTime, ulStatsAsPercentage;
+	#if ( configUSE_TASK_ITERATOR == 1 )
+		TaskIterator_t xIterator;
+	#endif
 
 		#if( configUSE_TRACE_FACILITY != 1 )
 		{
@@ -4444,76 +5532,94 @@ TCB_t *pxTCB;
 		/* Make sure the write buffer does not contain a string. */
 		*pcWriteBuffer = ( char ) 0x00;
 
-		/* Take a snapshot of the number of tasks in case it changes while this
-		function is executing. */
-		uxArraySize = uxCurrentNumberOfTasks;
+		#if ( configUSE_TASK_ITERATOR == 1 )
+		{
+			/* Only inspect a few tasks at a time, so the scheduler is not
+			suspended for long however many tasks there are. */
+			uxArraySize = configTASK_ITERATOR_CHUNK_SIZE;
+		}
+		#else
+		{
+			/* Take a snapshot of the number of tasks in case it changes while
+			this function is executing. */
+			uxArraySize = uxCurrentNumberOfTasks;
+		}
+		#endif /* configUSE_TASK_ITERATOR */
 
 		/* Allocate an array index for each task.  NOTE!  If
 		configSUPPORT_DYNAMIC_ALLOCATION is set to 0 then pvPortMalloc() will
 		equate to NULL. */
-		pxTaskStatusArray = pvPortMalloc( uxCurrentNumberOfTasks * sizeof( TaskStatus_t ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation allocates a struct that has the alignment requirements of a pointer. */
+		pxTaskStatusArray = pvPortMalloc( uxArraySize * sizeof( TaskStatus_t ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation allocates a struct that has the alignment requirements of a pointer. */
 
 		if( pxTaskStatusArray != NULL )
 		{
-			/* Generate the (binary) data. */
-			uxArraySize = uxTaskGetSystemState( pxTaskStatusArray, uxArraySize, &ulTotalTime );
-
-			/* For percentage calculations. */
-			ulTotalTime /= 100UL;
-
-			/* Avoid divide by zero errors. */
-			if( ulTotalTime > 0UL )
+			/* Generate the (binary) data.  With the iterator each chunk of
+			tasks comes with the total run time sampled at the same moment as
+			their own run time counters. */
+			#if ( configUSE_TASK_ITERATOR == 1 )
+				vTaskIteratorInit( &xIterator );
+				while( ( uxTasks = uxTaskGetSystemStateIncremental( &xIterator, pxTaskStatusArray, uxArraySize, &ulTotalTime ) ) > ( UBaseType_t ) 0 )
+			#else
+				uxTasks = uxTaskGetSystemState( pxTaskStatusArray, uxArraySize, &ulTotalTime );
+			#endif /* configUSE_TASK_ITERATOR */
 			{
-				/* Create a human readable table from the binary data. */
-				for( x = 0; x < uxArraySize; x++ )
-				{
-					/* What percentage of the total run time has the task used?
-					This will always be rounded down to the nearest integer.
-					ulTotalRunTimeDiv100 has already been divided by 100. */
-					ulStatsAsPercentage = pxTaskStatusArray[ x ].ulRunTimeCounter / ulTotalTime;
-
-					/* Write the task name to the string, padding with
-					spaces so it can be printed in tabular form more
-					easily. */
-					pcWriteBuffer = prvWriteNameToBuffer( pcWriteBuffer, pxTaskStatusArray[ x ].pcTaskName );
+				/* For percentage calculations. */
+				ulTotalTime /= 100UL;
 
-					if( ulStatsAsPercentage > 0UL )
-					{
-						#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
-						{
-							sprintf( pcWriteBuffer, "\t%lu\t\t%lu%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter, ulStatsAsPercentage );
-						}
-						#else
-						{
-							/* sizeof( int ) == sizeof( long ) so a smaller
-							printf() library can be used. */
-							sprintf( pcWriteBuffer, "\t%u\t\t%u%%\r\n", ( unsigned int ) pxTaskStatusArray[ x ].ulRunTimeCounter, ( unsigned int ) ulStatsAsPercentage ); /*lint !e586 sprintf() allowed as this is compiled with many compilers and this is a utility function only - not part of the core kernel implementation. */
-						}
-						#endif
-					}
-					else
+				/* Avoid divide by zero errors. */
+				if( ulTotalTime > 0UL )
+				{
+					/* Create a human readable table from the binary data. */
+					for( x = 0; x < uxTasks; x++ )
 					{
-						/* If the percentage is zero here then the task has
-						consumed less than 1% of the total run time. */
-						#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
+						/* What percentage of the total run time has the task used?
+						This will always be rounded down to the nearest integer.
+						ulTotalRunTimeDiv100 has already been divided by 100. */
+						ulStatsAsPercentage = pxTaskStatusArray[ x ].ulRunTimeCounter / ulTotalTime;
+
+						/* Write the task name to the string, padding with
+						spaces so it can be printed in tabular form more
+						easily. */
+						pcWriteBuffer = prvWriteNameToBuffer( pcWriteBuffer, pxTaskStatusArray[ x ].pcTaskName );
+
+						if( ulStatsAsPercentage > 0UL )
 						{
-							sprintf( pcWriteBuffer, "\t%lu\t\t<1%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter );
+							#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
+							{
+								sprintf( pcWriteBuffer, "\t%lu\t\t%lu%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter, ulStatsAsPercentage );
+							}
+							#else
+							{
+								/* sizeof( int ) == sizeof( long ) so a smaller
+								printf() library can be used. */
+								sprintf( pcWriteBuffer, "\t%u\t\t%u%%\r\n", ( unsigned int ) pxTaskStatusArray[ x ].ulRunTimeCounter, ( unsigned int ) ulStatsAsPercentage ); /*lint !e586 sprintf() allowed as this is compiled with many compilers and this is a utility function only - not part of the core kernel implementation. */
+							}
+							#endif
 						}
-						#else
+						else
 						{
-							/* sizeof( int ) == sizeof( long ) so a smaller
-							printf() library can be used. */
-							sprintf( pcWriteBuffer, "\t%u\t\t<1%%\r\n", ( unsigned int ) pxTaskStatusArray[ x ].ulRunTimeCounter ); /*lint !e586 sprintf() allowed as this is compiled with many compilers and this is a utility function only - not part of the core kernel implementation. */
+							/* If the percentage is zero here then the task has
+							consumed less than 1% of the total run time. */
+							#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
+							{
+								sprintf( pcWriteBuffer, "\t%lu\t\t<1%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter );
+							}
+							#else
+							{
+								/* sizeof( int ) == sizeof( long ) so a smaller
+								printf() library can be used. */
+								sprintf( pcWriteBuffer, "\t%u\t\t<1%%\r\n", ( unsigned int ) pxTaskStatusArray[ x ].ulRunTimeCounter ); /*lint !e586 sprintf() allowed as this is compiled with many compilers and this is a utility function only - not part of the core kernel implementation. */
+							}
+							#endif
 						}
-						#endif
-					}
 
-					pcWriteBuffer += strlen( pcWriteBuffer ); /*lint !e9016 Pointer arithmetic ok on char pointers especially as in this case where it best denotes the intent of the code. */
+						pcWriteBuffer += strlen( pcWriteBuffer ); /*lint !e9016 Pointer arithmetic ok on char pointers especially as in this case where it best denotes the intent of the code. */
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
 				}
-			}
-			else
-			{
-				mtCOVERAGE_TEST_MARKER();
 			}
 
 			/* Free the array again.  NOTE!  If configSUPPORT_DYNAMIC_ALLOCATION
@@ -4562,17 +5668,19 @@ TickType_t uxReturn;
 
 #if( configUSE_TASK_NOTIFICATIONS == 1 )
 
-	uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+	uint32_t ulTaskGenericNotifyTake( UBaseType_t uxIndexToWait, BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
 	{
 	uint32_t ulReturn;
 
+		configASSERT( uxIndexToWait < configTASK_NOTIFICATION_ARRAY_ENTRIES );
+
 		taskENTER_CRITICAL();
 		{
 			/* Only block if the notification count is not already non-zero. */
-			if( pxCurrentTCB->ulNotifiedValue == 0UL )
+			if( pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ] == 0UL )
 			{
 				/* Mark this task as waiting for a notification. */
-				pxCurrentTCB->ucNotifyState = taskWAITING_NOTIFICATION;
+				pxCurrentTCB->ucNotifyState[ uxIndexToWait ] = taskWAITING_NOTIFICATION;
 
 				if( xTicksToWait > ( TickType_t ) 0 )
 				{
@@ -4600,17 +5708,17 @@ TickType_t uxReturn;
 		taskENTER_CRITICAL();
 		{
 			traceTASK_NOTIFY_TAKE();
-			ulReturn = pxCurrentTCB->ulNotifiedValue;
+			ulReturn = pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ];
 
 			if( ulReturn != 0UL )
 			{
 				if( xClearCountOnExit != pdFALSE )
 				{
-					pxCurrentTCB->ulNotifiedValue = 0UL;
+					pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ] = 0UL;
 				}
 				else
 				{
-					pxCurrentTCB->ulNotifiedValue = ulReturn - ( uint32_t ) 1;
+					pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ] = ulReturn - ( uint32_t ) 1;
 				}
 			}
 			else
@@ -4618,7 +5726,7 @@ TickType_t uxReturn;
 				mtCOVERAGE_TEST_MARKER();
 			}
 
-			pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+			pxCurrentTCB->ucNotifyState[ uxIndexToWait ] = taskNOT_WAITING_NOTIFICATION;
 		}
 		taskEXIT_CRITICAL();
 
@@ -4630,22 +5738,24 @@ TickType_t uxReturn;
 
 #if( configUSE_TASK_NOTIFICATIONS == 1 )
 
-	BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait )
+	BaseType_t xTaskGenericNotifyWait( UBaseType_t uxIndexToWait, uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait )
 	{
 	BaseType_t xReturn;
 
+		configASSERT( uxIndexToWait < configTASK_NOTIFICATION_ARRAY_ENTRIES );
+
 		taskENTER_CRITICAL();
 		{
 			/* Only block if a notification is not already pending. */
-			if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+			if( pxCurrentTCB->ucNotifyState[ uxIndexToWait ] != taskNOTIFICATION_RECEIVED )
 			{
 				/* Clear bits in the task's notification value as bits may get
 				set	by the notifying task or interrupt.  This can be used to
 				clear the value to zero. */
-				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+				pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ] &= ~ulBitsToClearOnEntry;
 
 				/* Mark this task as waiting for a notification. */
-				pxCurrentTCB->ucNotifyState = taskWAITING_NOTIFICATION;
+				pxCurrentTCB->ucNotifyState[ uxIndexToWait ] = taskWAITING_NOTIFICATION;
 
 				if( xTicksToWait > ( TickType_t ) 0 )
 				{
@@ -4678,14 +5788,14 @@ TickType_t uxReturn;
 			{
 				/* Output the current notification value, which may or may not
 				have changed. */
-				*pulNotificationValue = pxCurrentTCB->ulNotifiedValue;
+				*pulNotificationValue = pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ];
 			}
 
 			/* If ucNotifyValue is set then either the task never entered the
 			blocked state (because a notification was already pending) or the
 			task unblocked because of a notification.  Otherwise the task
 			unblocked because of a timeout. */
-			if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+			if( pxCurrentTCB->ucNotifyState[ uxIndexToWait ] != taskNOTIFICATION_RECEIVED )
 			{
 				/* A notification was not received. */
 				xReturn = pdFALSE;
@@ -4694,11 +5804,11 @@ TickType_t uxReturn;
 			{
 				/* A notification was already pending or a notification was
 				received while the task was waiting. */
-				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnExit;
+				pxCurrentTCB->ulNotifiedValue[ uxIndexToWait ] &= ~ulBitsToClearOnExit;
 				xReturn = pdTRUE;
 			}
 
-			pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+			pxCurrentTCB->ucNotifyState[ uxIndexToWait ] = taskNOT_WAITING_NOTIFICATION;
 		}
 		taskEXIT_CRITICAL();
 
@@ -4710,12 +5820,13 @@ TickType_t uxReturn;
 
 #if( configUSE_TASK_NOTIFICATIONS == 1 )
 
-	BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue )
+	BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue )
 	{
 	TCB_t * pxTCB;
 	BaseType_t xReturn = pdPASS;
 	uint8_t ucOriginalNotifyState;
 
+		configASSERT( uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES );
 		configASSERT( xTaskToNotify );
 		pxTCB = xTaskToNotify;
 
@@ -4723,31 +5834,31 @@ TickType_t uxReturn;
 		{
 			if( pulPreviousNotificationValue != NULL )
 			{
-				*pulPreviousNotificationValue = pxTCB->ulNotifiedValue;
+				*pulPreviousNotificationValue = pxTCB->ulNotifiedValue[ uxIndexToNotify ];
 			}
 
-			ucOriginalNotifyState = pxTCB->ucNotifyState;
+			ucOriginalNotifyState = pxTCB->ucNotifyState[ uxIndexToNotify ];
 
-			pxTCB->ucNotifyState = taskNOTIFICATION_RECEIVED;
+			pxTCB->ucNotifyState[ uxIndexToNotify ] = taskNOTIFICATION_RECEIVED;
 
 			switch( eAction )
 			{
 				case eSetBits	:
-					pxTCB->ulNotifiedValue |= ulValue;
+					pxTCB->ulNotifiedValue[ uxIndexToNotify ] |= ulValue;
 					break;
 
 				case eIncrement	:
-					( pxTCB->ulNotifiedValue )++;
+					( pxTCB->ulNotifiedValue[ uxIndexToNotify ] )++;
 					break;
 
 				case eSetValueWithOverwrite	:
-					pxTCB->ulNotifiedValue = ulValue;
+					pxTCB->ulNotifiedValue[ uxIndexToNotify ] = ulValue;
 					break;
 
 				case eSetValueWithoutOverwrite :
 					if( ucOriginalNotifyState != taskNOTIFICATION_RECEIVED )
 					{
-						pxTCB->ulNotifiedValue = ulValue;
+						pxTCB->ulNotifiedValue[ uxIndexToNotify ] = ulValue;
 					}
 					else
 					{
@@ -4765,7 +5876,7 @@ TickType_t uxReturn;
 					/* Should not get here if all enums are handled.
 					Artificially force an assert by testing a value the
 					compiler can't assume is const. */
-					configASSERT( pxTCB->ulNotifiedValue == ~0UL );
+					configASSERT( pxTCB->ulNotifiedValue[ uxIndexToNotify ] == ~0UL );
 
 					break;
 			}
@@ -4824,7 +5935,7 @@ TickType_t uxReturn;
 
 #if( configUSE_TASK_NOTIFICATIONS == 1 )
 
-	BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken )
+	BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken )
 	{
 	TCB_t * pxTCB;
 	uint8_t ucOriginalNotifyState;
@@ -4832,6 +5943,7 @@ TickType_t uxReturn;
 	UBaseType_t uxSavedInterruptStatus;
 
 		configASSERT( xTaskToNotify );
+		configASSERT( uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES );
 
 		/* RTOS ports that support interrupt nesting have the concept of a
 		maximum	system call (or maximum API call) interrupt priority.
@@ -4857,30 +5969,30 @@ TickType_t uxReturn;
 		{
 			if( pulPreviousNotificationValue != NULL )
 			{
-				*pulPreviousNotificationValue = pxTCB->ulNotifiedValue;
+				*pulPreviousNotificationValue = pxTCB->ulNotifiedValue[ uxIndexToNotify ];
 			}
 
-			ucOriginalNotifyState = pxTCB->ucNotifyState;
-			pxTCB->ucNotifyState = taskNOTIFICATION_RECEIVED;
+			ucOriginalNotifyState = pxTCB->ucNotifyState[ uxIndexToNotify ];
+			pxTCB->ucNotifyState[ uxIndexToNotify ] = taskNOTIFICATION_RECEIVED;
 
 			switch( eAction )
 			{
 				case eSetBits	:
-					pxTCB->ulNotifiedValue |= ulValue;
+					pxTCB->ulNotifiedValue[ uxIndexToNotify ] |= ulValue;
 					break;
 
 				case eIncrement	:
-					( pxTCB->ulNotifiedValue )++;
+					( pxTCB->ulNotifiedValue[ uxIndexToNotify ] )++;
 					break;
 
 				case eSetValueWithOverwrite	:
-					pxTCB->ulNotifiedValue = ulValue;
+					pxTCB->ulNotifiedValue[ uxIndexToNotify ] = ulValue;
 					break;
 
 				case eSetValueWithoutOverwrite :
 					if( ucOriginalNotifyState != taskNOTIFICATION_RECEIVED )
 					{
-						pxTCB->ulNotifiedValue = ulValue;
+						pxTCB->ulNotifiedValue[ uxIndexToNotify ] = ulValue;
 					}
 					else
 					{
@@ -4898,7 +6010,7 @@ TickType_t uxReturn;
 					/* Should not get here if all enums are handled.
 					Artificially force an assert by testing a value the
 					compiler can't assume is const. */
-					configASSERT( pxTCB->ulNotifiedValue == ~0UL );
+					configASSERT( pxTCB->ulNotifiedValue[ uxIndexToNotify ] == ~0UL );
 					break;
 			}
 
@@ -4953,13 +6065,14 @@ TickType_t uxReturn;
 
 #if( configUSE_TASK_NOTIFICATIONS == 1 )
 
-	void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken )
+	void vTaskGenericNotifyGiveFromISR( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, BaseType_t *pxHigherPriorityTaskWoken )
 	{
 	TCB_t * pxTCB;
 	uint8_t ucOriginalNotifyState;
 	UBaseType_t uxSavedInterruptStatus;
 
 		configASSERT( xTaskToNotify );
+		configASSERT( uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES );
 
 		/* RTOS ports that support interrupt nesting have the concept of a
 		maximum	system call (or maximum API call) interrupt priority.
@@ -4983,12 +6096,12 @@ TickType_t uxReturn;
 
 		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
 		{
-			ucOriginalNotifyState = pxTCB->ucNotifyState;
-			pxTCB->ucNotifyState = taskNOTIFICATION_RECEIVED;
+			ucOriginalNotifyState = pxTCB->ucNotifyState[ uxIndexToNotify ];
+			pxTCB->ucNotifyState[ uxIndexToNotify ] = taskNOTIFICATION_RECEIVED;
 
 			/* 'Giving' is equivalent to incrementing a count in a counting
 			semaphore. */
-			( pxTCB->ulNotifiedValue )++;
+			( pxTCB->ulNotifiedValue[ uxIndexToNotify ] )++;
 
 			traceTASK_NOTIFY_GIVE_FROM_ISR();
 
@@ -5040,20 +6153,22 @@ TickType_t uxReturn;
 
 #if( configUSE_TASK_NOTIFICATIONS == 1 )
 
-	BaseType_t xTaskNotifyStateClear( TaskHandle_t xTask )
+	BaseType_t xTaskGenericNotifyStateClear( TaskHandle_t xTask, UBaseType_t uxIndexToClear )
 	{
 	TCB_t *pxTCB;
 	BaseType_t xReturn;
 
+		configASSERT( uxIndexToClear < configTASK_NOTIFICATION_ARRAY_ENTRIES );
+
 		/* If null is passed in here then it is the calling task that is having
 		its notification state cleared. */
 		pxTCB = prvGetTCBFromHandle( xTask );
 
 		taskENTER_CRITICAL();
 		{
-			if( pxTCB->ucNotifyState == taskNOTIFICATION_RECEIVED )
+			if( pxTCB->ucNotifyState[ uxIndexToClear ] == taskNOTIFICATION_RECEIVED )
 			{
-				pxTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+				pxTCB->ucNotifyState[ uxIndexToClear ] = taskNOT_WAITING_NOTIFICATION;
 				xReturn = pdPASS;
 			}
 			else
@@ -69,6 +69,21 @@ defining trmTIMER_SERVICE_TASK_NAME in FreeRTOSConfig.h. */
 #define tmrSTATUS_IS_STATICALLY_ALLOCATED	( ( uint8_t ) 0x02 )
 #define tmrSTATUS_IS_AUTORELOAD				( ( uint8_t ) 0x04 )
 
+/* Sent by the direct update functions to make the timer service task
+re-evaluate the time at which it should next unblock.  It carries no timer. */
+#define tmrCOMMAND_WAKE_DAEMON				( ( BaseType_t ) -3 )
+
+/* When timers can be updated directly from other tasks, the timer service
+task has to stop the other tasks from running while it changes the timer
+lists.  Otherwise it is the only task that accesses them. */
+#if( configUSE_TIMER_DIRECT_UPDATE == 1 )
+	#define tmrENTER_LIST_ACCESS()	vTaskSuspendAll()
+	#define tmrEXIT_LIST_ACCESS()	( void ) xTaskResumeAll()
+#else
+	#define tmrENTER_LIST_ACCESS()
+	#define tmrEXIT_LIST_ACCESS()
+#endif
+
 /* The definition of the timers themselves. */
 typedef struct tmrTimerControl /* The old naming convention is used to prevent breaking kernel aware debuggers. */
 {
@@ -80,6 +95,9 @@ typedef struct tmrTimerControl /* The old naming convention is used to prevent b
 	#if( configUSE_TRACE_FACILITY == 1 )
 		UBaseType_t			uxTimerNumber;		/*<< An ID assigned by trace tools such as FreeRTOS+Trace */
 	#endif
+	#if( configUSE_TIMER_SLACK == 1 )
+		TickType_t			xTimerSlack;		/*<< The number of ticks by which the expiry may be postponed to coincide with another wake up. */
+	#endif
 	uint8_t 				ucStatus;			/*<< Holds bits to say if the timer was statically allocated or not, and if it is active or not. */
 } xTIMER;
 
@@ -141,6 +159,10 @@ PRIVILEGED_DATA static List_t *pxOverflowTimerList;
 PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
 PRIVILEGED_DATA static TaskHandle_t xTimerTaskHandle = NULL;
 
+/* The tick count when the timer service task last sampled it, used to detect
+tick count overflows. */
+PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U;
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -212,6 +234,16 @@ static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) PRIV
  */
 static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty ) PRIVILEGED_FUNCTION;
 
+/*
+ * Returns the latest time the timer service task may sleep until, given the
+ * slack of the active timers.  That is the earliest expire time plus slack of
+ * the timers in the current list, but not earlier than xNextExpireTime.  Must
+ * be called with the scheduler suspended.
+ */
+#if( configUSE_TIMER_SLACK == 1 )
+	static TickType_t prvGetLatestExpireTime( const TickType_t xNextExpireTime ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Called after a Timer_t structure has been allocated either statically or
  * dynamically to fill in the structure's members.
@@ -368,6 +400,11 @@ static void prvInitialiseNewTimer(	const char * const pcTimerName,			/*lint !e97
 		pxNewTimer->xTimerPeriodInTicks = xTimerPeriodInTicks;
 		pxNewTimer->pvTimerID = pvTimerID;
 		pxNewTimer->pxCallbackFunction = pxCallbackFunction;
+		#if( configUSE_TIMER_SLACK == 1 )
+		{
+			pxNewTimer->xTimerSlack = ( TickType_t ) 0U;
+		}
+		#endif
 		vListInitialiseItem( &( pxNewTimer->xTimerListItem ) );
 		if( uxAutoReload != pdFALSE )
 		{
@@ -421,6 +458,111 @@ DaemonTaskMessage_t xMessage;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_TIMER_DIRECT_UPDATE == 1 )
+
+	BaseType_t xTimerGenericCommandDirect( TimerHandle_t xTimer, const BaseType_t xCommandID )
+	{
+	Timer_t * const pxTimer = xTimer;
+	BaseType_t xReturn = pdFAIL, xWakeDaemon = pdFALSE;
+	TickType_t xTimeNow;
+	DaemonTaskMessage_t xMessage;
+
+		configASSERT( pxTimer );
+		configASSERT( ( xCommandID == tmrCOMMAND_START ) || ( xCommandID == tmrCOMMAND_RESET ) || ( xCommandID == tmrCOMMAND_STOP ) );
+
+		/* The timer lists only exist once the timer service task has been
+		created, and the lists cannot be changed from here while the
+		scheduler is not running as the timer service task may be in the
+		middle of changing them. */
+		if( ( xTimerQueue != NULL ) && ( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING ) )
+		{
+			vTaskSuspendAll();
+			{
+				xTimeNow = xTaskGetTickCount();
+
+				/* If the tick count overflowed since the timer service task
+				last looked at it then the timer lists must be switched first.
+				As that calls the callbacks of expired timers, it is left to the
+				timer service task. */
+				if( xTimeNow >= xLastTime )
+				{
+					if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
+					{
+						( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+
+					if( xCommandID == tmrCOMMAND_STOP )
+					{
+						pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+					}
+					else
+					{
+						/* As the command time is the time now, and the period
+						cannot be zero, the timer cannot have expired already.
+						If it becomes the next timer to expire then the timer
+						service task must be woken to shorten its block time. */
+						pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+						( void ) prvInsertTimerInActiveList( pxTimer, xTimeNow + pxTimer->xTimerPeriodInTicks, xTimeNow, xTimeNow );
+
+						if( listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ) == pxTimer )
+						{
+							xWakeDaemon = pdTRUE;
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+
+					xReturn = pdPASS;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			( void ) xTaskResumeAll();
+
+			traceTIMER_COMMAND_SEND( xTimer, xCommandID, xTimeNow, xReturn );
+
+			if( xWakeDaemon != pdFALSE )
+			{
+				/* If the queue is full then the timer service task is going
+				to run anyway. */
+				xMessage.xMessageID = tmrCOMMAND_WAKE_DAEMON;
+				( void ) xQueueSendToBack( xTimerQueue, &xMessage, tmrNO_DELAY );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		/* Fall back to sending the command when the lists could not be
+		updated directly. */
+		if( xReturn == pdFAIL )
+		{
+			xReturn = xTimerGenericCommand( xTimer, xCommandID, xTaskGetTickCount(), NULL, tmrNO_DELAY );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_TIMER_DIRECT_UPDATE */
+/*-----------------------------------------------------------*/
+
 TaskHandle_t xTimerGetTimerDaemonTaskHandle( void )
 {
 	/* If xTimerGetTimerDaemonTaskHandle() is called before the scheduler has been
@@ -459,6 +601,39 @@ Timer_t * pxTimer =  xTimer;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_TIMER_SLACK == 1 )
+
+	void vTimerSetSlack( TimerHandle_t xTimer, const TickType_t xSlack )
+	{
+	Timer_t * pxTimer =  xTimer;
+
+		configASSERT( xTimer );
+
+		/* The timer service task reads the slack with the scheduler
+		suspended. */
+		vTaskSuspendAll();
+		{
+			pxTimer->xTimerSlack = xSlack;
+		}
+		( void ) xTaskResumeAll();
+	}
+
+#endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TIMER_SLACK == 1 )
+
+	TickType_t xTimerGetSlack( TimerHandle_t xTimer )
+	{
+	Timer_t *pxTimer = xTimer;
+
+		configASSERT( xTimer );
+		return pxTimer->xTimerSlack;
+	}
+
+#endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
 TickType_t xTimerGetExpiryTime( TimerHandle_t xTimer )
 {
 Timer_t * pxTimer =  xTimer;
@@ -481,26 +656,71 @@ Timer_t *pxTimer = xTimer;
 
 static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow )
 {
-BaseType_t xResult;
-Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+BaseType_t xResult, xProcessTimerNow = pdFALSE;
+Timer_t *pxTimer = NULL;
+TickType_t xExpireTime = xNextExpireTime;
 
-	/* Remove the timer from the list of active timers.  A check has already
-	been performed to ensure the list is not empty. */
-	( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
-	traceTIMER_EXPIRED( pxTimer );
+	tmrENTER_LIST_ACCESS();
+	{
+		#if( configUSE_TIMER_DIRECT_UPDATE == 1 )
+		{
+			/* Another task may have stopped or restarted timers since the list
+			was inspected.  Timers can only have been moved to a later time, so
+			if the head of the list has not expired now then nothing has. */
+			if( ( listLIST_IS_EMPTY( pxCurrentTimerList ) == pdFALSE ) && ( listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList ) <= xTimeNow ) )
+			{
+				pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+				xExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#else
+		{
+			/* A check has already been performed to ensure the list is not
+			empty. */
+			pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+		}
+		#endif /* configUSE_TIMER_DIRECT_UPDATE */
+
+		if( pxTimer != NULL )
+		{
+			/* Remove the timer from the list of active timers. */
+			( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+			traceTIMER_EXPIRED( pxTimer );
+
+			/* If the timer is an auto reload timer then calculate the next
+			expiry time and re-insert the timer in the list of active timers. */
+			if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+			{
+				/* The timer is inserted into a list using a time relative to
+				anything other than the current time.  It will therefore be
+				inserted into the correct list relative to the time this task
+				thinks it is now. */
+				xProcessTimerNow = prvInsertTimerInActiveList( pxTimer, ( xExpireTime + pxTimer->xTimerPeriodInTicks ), xTimeNow, xExpireTime );
+			}
+			else
+			{
+				pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	tmrEXIT_LIST_ACCESS();
 
-	/* If the timer is an auto reload timer then calculate the next
-	expiry time and re-insert the timer in the list of active timers. */
-	if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+	if( pxTimer != NULL )
 	{
-		/* The timer is inserted into a list using a time relative to anything
-		other than the current time.  It will therefore be inserted into the
-		correct list relative to the time this task thinks it is now. */
-		if( prvInsertTimerInActiveList( pxTimer, ( xNextExpireTime + pxTimer->xTimerPeriodInTicks ), xTimeNow, xNextExpireTime ) != pdFALSE )
+		if( xProcessTimerNow != pdFALSE )
 		{
 			/* The timer expired before it was added to the active timer
 			list.  Reload it now.  */
-			xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
+			xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xExpireTime, NULL, tmrNO_DELAY );
 			configASSERT( xResult );
 			( void ) xResult;
 		}
@@ -508,15 +728,14 @@ Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTi
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
+
+		/* Call the timer callback. */
+		pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
 	}
 	else
 	{
-		pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
 		mtCOVERAGE_TEST_MARKER();
 	}
-
-	/* Call the timer callback. */
-	pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
 }
 /*-----------------------------------------------------------*/
 
@@ -558,7 +777,7 @@ BaseType_t xListWasEmpty;
 
 static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty )
 {
-TickType_t xTimeNow;
+TickType_t xTimeNow, xTicksToWait;
 BaseType_t xTimerListsWereSwitched;
 
 	vTaskSuspendAll();
@@ -585,14 +804,26 @@ BaseType_t xTimerListsWereSwitched;
 				received - whichever comes first.  The following line cannot
 				be reached unless xNextExpireTime > xTimeNow, except in the
 				case when the current timer list is empty. */
+				xTicksToWait = xNextExpireTime - xTimeNow;
+
 				if( xListWasEmpty != pdFALSE )
 				{
 					/* The current timer list is empty - is the overflow list
 					also empty? */
 					xListWasEmpty = listLIST_IS_EMPTY( pxOverflowTimerList );
 				}
+				#if( configUSE_TIMER_SLACK == 1 )
+				else
+				{
+					/* Sleep until the end of the slack of the active timers,
+					or less when another task is due to wake up before that.
+					All timers that have expired by then are processed
+					together. */
+					xTicksToWait = xTaskGetCoalescedDelay( xTicksToWait, prvGetLatestExpireTime( xNextExpireTime ) - xNextExpireTime );
+				}
+				#endif /* configUSE_TIMER_SLACK */
 
-				vQueueWaitForMessageRestricted( xTimerQueue, ( xNextExpireTime - xTimeNow ), xListWasEmpty );
+				vQueueWaitForMessageRestricted( xTimerQueue, xTicksToWait, xListWasEmpty );
 
 				if( xTaskResumeAll() == pdFALSE )
 				{
@@ -642,10 +873,56 @@ TickType_t xNextExpireTime;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_TIMER_SLACK == 1 )
+
+	static TickType_t prvGetLatestExpireTime( const TickType_t xNextExpireTime )
+	{
+	TickType_t xLatestTime = portMAX_DELAY;
+	TickType_t xExpireTime, xDueTime;
+	const ListItem_t *pxItem;
+	const ListItem_t *pxEnd = listGET_END_MARKER( pxCurrentTimerList );
+	const Timer_t *pxTimer;
+
+		/* The timers are sorted by expire time, so once a timer expires after
+		the latest time found so far, none of the remaining ones can lower it. */
+		for( pxItem = listGET_HEAD_ENTRY( pxCurrentTimerList ); pxItem != pxEnd; pxItem = listGET_NEXT( pxItem ) )
+		{
+			xExpireTime = listGET_LIST_ITEM_VALUE( pxItem );
+			if( xExpireTime >= xLatestTime )
+			{
+				break;
+			}
+
+			pxTimer = ( const Timer_t * ) listGET_LIST_ITEM_OWNER( pxItem ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+			xDueTime = xExpireTime + pxTimer->xTimerSlack;
+			if( xDueTime < xExpireTime )
+			{
+				/* Don't wait past an overflow of the tick count. */
+				xDueTime = portMAX_DELAY;
+			}
+
+			if( xDueTime < xLatestTime )
+			{
+				xLatestTime = xDueTime;
+			}
+		}
+
+		/* Another task may have started or stopped timers since the time the
+		timer service task was going to sleep until was obtained. */
+		if( ( xLatestTime < xNextExpireTime ) || ( listLIST_IS_EMPTY( pxCurrentTimerList ) != pdFALSE ) )
+		{
+			xLatestTime = xNextExpireTime;
+		}
+
+		return xLatestTime;
+	}
+
+#endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
 static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched )
 {
 TickType_t xTimeNow;
-PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U; /*lint !e956 Variable is only accessible to one task. */
 
 	xTimeNow = xTaskGetTickCount();
 
@@ -719,7 +996,7 @@ TickType_t xTimeNow;
 		{
 			/* Negative commands are pended function calls rather than timer
 			commands. */
-			if( xMessage.xMessageID < ( BaseType_t ) 0 )
+			if( ( xMessage.xMessageID < ( BaseType_t ) 0 ) && ( xMessage.xMessageID != tmrCOMMAND_WAKE_DAEMON ) )
 			{
 				const CallbackParameters_t * const pxCallback = &( xMessage.u.xCallbackParameters );
 
@@ -745,6 +1022,8 @@ TickType_t xTimeNow;
 			software timer. */
 			pxTimer = xMessage.u.xTimerParameters.pxTimer;
 
+			tmrENTER_LIST_ACCESS();
+
 			if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
 			{
 				/* The timer is in a list, remove it. */
@@ -774,7 +1053,10 @@ TickType_t xTimeNow;
 				case tmrCOMMAND_START_DONT_TRACE :
 					/* Start or restart a timer. */
 					pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
-					if( prvInsertTimerInActiveList( pxTimer,  xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue ) != pdFALSE )
+					xResult = prvInsertTimerInActiveList( pxTimer,  xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue );
+					tmrEXIT_LIST_ACCESS();
+
+					if( xResult != pdFALSE )
 					{
 						/* The timer expired before it was added to the active
 						timer list.  Process it now. */
@@ -802,6 +1084,7 @@ TickType_t xTimeNow;
 				case tmrCOMMAND_STOP_FROM_ISR :
 					/* The timer has already been removed from the active list. */
 					pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+					tmrEXIT_LIST_ACCESS();
 					break;
 
 				case tmrCOMMAND_CHANGE_PERIOD :
@@ -817,9 +1100,12 @@ TickType_t xTimeNow;
 					meaning (unlike for the xTimerStart() case above) there is
 					no fail case that needs to be handled here. */
 					( void ) prvInsertTimerInActiveList( pxTimer, ( xTimeNow + pxTimer->xTimerPeriodInTicks ), xTimeNow, xTimeNow );
+					tmrEXIT_LIST_ACCESS();
 					break;
 
 				case tmrCOMMAND_DELETE :
+					tmrEXIT_LIST_ACCESS();
+
 					#if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 					{
 						/* The timer has already been removed from the active list,
@@ -847,6 +1133,7 @@ TickType_t xTimeNow;
 
 				default	:
 					/* Don't expect to get here. */
+					tmrEXIT_LIST_ACCESS();
 					break;
 			}
 		}
@@ -28,12 +28,33 @@
  * @file aws_bufferpool_static_thread_safe.c
  * @brief A thread safe implementation of the BufferPool interface.
  *
- * A pool of statically allocated buffers is maintained. The number
- * of buffers in the pool and the size of each buffer is controlled
- * via macros bufferpoolconfigNUM_BUFFERS and bufferpoolconfigBUFFER_SIZE
- * which must be defined in BufferPoolConfig.h.
+ * A pool of statically allocated buffers is maintained. The pool is divided
+ * into up to five size classes. The largest class is controlled via macros
+ * bufferpoolconfigNUM_BUFFERS and bufferpoolconfigBUFFER_SIZE which must be
+ * defined in BufferPoolConfig.h. The optional smaller classes are described in
+ * aws_bufferpool_config_defaults.h. A request is served from the smallest
+ * class that fits the requested length and has a free buffer.
+ *
+ * Free buffers of each class are kept on an intrusive LIFO free list which is
+ * threaded through the data portion of the free buffers themselves. Both
+ * getting and returning a buffer are therefore constant time operations, and
+ * the most recently returned (and so most likely cache-warm) buffer is handed
+ * out first.
+ *
+ * When bufferpoolconfigENABLE_BLOCKING_GET is 1, tasks can wait for a buffer
+ * to be returned. Returning a buffer only touches the event group the waiters
+ * block on while there are waiters.
+ *
+ * When bufferpoolconfigTASK_CACHE_DEPTH is non-zero, a task can keep a few free
+ * buffers of each class in a cache found through one of its thread local
+ * storage pointers. A buffer with a single user is returned to the cache of
+ * the returning task, and a request is served from the cache of the requesting
+ * task, without entering a critical section.
  */
 
+/* Standard includes. */
+#include <string.h>
+
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
@@ -41,6 +62,11 @@
 /* BufferPool includes. */
 #include "aws_bufferpool.h"
 #include "aws_bufferpool_config.h"
+#include "aws_bufferpool_config_defaults.h"
+
+#if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+    #include "event_groups.h"
+#endif
 
 /* Make sure that proper config options are defined. */
 #ifndef bufferpoolconfigNUM_BUFFERS
@@ -51,6 +77,44 @@
     #error bufferpoolconfigBUFFER_SIZE must be defined in BufferPoolConfig.h
 #endif
 
+#if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+    #if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS <= bufferpoolconfigTASK_CACHE_TLS_INDEX )
+        #error bufferpoolconfigTASK_CACHE_TLS_INDEX must be below configNUM_THREAD_LOCAL_STORAGE_POINTERS
+    #endif
+
+    #if ( ( INCLUDE_xTaskGetSchedulerState != 1 ) && ( configUSE_TIMERS != 1 ) )
+        #error Task buffer caches need xTaskGetSchedulerState
+    #endif
+
+    #if ( bufferpoolconfigTASK_CACHE_DEPTH > UINT8_MAX )
+        #error bufferpoolconfigTASK_CACHE_DEPTH must fit in a uint8_t
+    #endif
+#endif
+
+/**
+ * @brief Evaluates to 1 if the optional size class xSmaller is unused or holds
+ * smaller buffers than the size class xLarger, which is either another
+ * optional size class or the largest class (NUM_BUFFERS and BUFFER_SIZE).
+ *
+ * The best fit search serves a request from the first class that is large
+ * enough, so the classes must be configured in increasing order of size.
+ */
+#define bufferpoolstaticCLASS_BELOW( xSmaller, xLarger )                     \
+    ( ( bufferpoolconfigSIZE_CLASS_ ## xSmaller ## _NUM_BUFFERS == 0 ) ||        \
+      ( bufferpoolconfig ## xLarger ## NUM_BUFFERS == 0 ) ||                     \
+      ( bufferpoolconfigSIZE_CLASS_ ## xSmaller ## _BUFFER_SIZE < bufferpoolconfig ## xLarger ## BUFFER_SIZE ) )
+
+#if !( bufferpoolstaticCLASS_BELOW( 0, SIZE_CLASS_1_ ) && bufferpoolstaticCLASS_BELOW( 0, SIZE_CLASS_2_ ) && \
+       bufferpoolstaticCLASS_BELOW( 0, SIZE_CLASS_3_ ) && bufferpoolstaticCLASS_BELOW( 1, SIZE_CLASS_2_ ) && \
+       bufferpoolstaticCLASS_BELOW( 1, SIZE_CLASS_3_ ) && bufferpoolstaticCLASS_BELOW( 2, SIZE_CLASS_3_ ) )
+    #error bufferpoolconfigSIZE_CLASS_0..3_BUFFER_SIZE must be in increasing order of size
+#endif
+
+#if !( bufferpoolstaticCLASS_BELOW( 0, ) && bufferpoolstaticCLASS_BELOW( 1, ) && \
+       bufferpoolstaticCLASS_BELOW( 2, ) && bufferpoolstaticCLASS_BELOW( 3, ) )
+    #error bufferpoolconfigSIZE_CLASS_0..3_BUFFER_SIZE must be smaller than bufferpoolconfigBUFFER_SIZE
+#endif
+
 /**
  * @brief Moves the given pointer ahead by the number of bytes required to
  * properly align it as specified by portBYTE_ALIGNMENT.
@@ -76,20 +140,51 @@
 #define bufferpoolstaticDATA_LOCATION_IN_BUFFER( pucBuffer )                   ( ( uint8_t * ) ( bufferpoolstaticALIGN_POINTER( bufferpoolstaticRESERVE_METADATA_SPACE( pucBuffer ) ) ) )
 
 /**
- * @brief Given the data location in a buffer, extracts the buffer "in-use"
- * information from the metadata portion of the buffer.
+ * @brief Given the data location in a buffer, extracts the metadata portion
+ * of the buffer.
  *
  * @param[in] pucDataLocation The given data location in the buffer.
  */
-#define bufferpoolstaticBUFFER_IN_USE_FROM_DATA_LOCATION( pucDataLocation )    ( ( ( BufferMetadata_t * ) ( ( pucDataLocation ) - sizeof( BufferMetadata_t ) ) )->ucBufferInUse )
+#define bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucDataLocation )         ( ( BufferMetadata_t * ) ( ( pucDataLocation ) - sizeof( BufferMetadata_t ) ) )
 
 /**
- * @brief Extracts the buffer "in-use" information from the metadata portion
- * of the given buffer.
+ * @brief Given the data location in a free buffer, accesses the link to the
+ * next free buffer in the free list.
  *
- * @param[in] pucBuffer The given buffer.
+ * The link is only valid while the buffer is free and is stored in the data
+ * portion of the buffer which is not used by anyone else at that time. The
+ * data location is aligned as specified by portBYTE_ALIGNMENT and therefore
+ * can hold a pointer.
+ *
+ * @param[in] pucDataLocation The given data location in the free buffer.
+ */
+#define bufferpoolstaticNEXT_FREE_FROM_DATA_LOCATION( pucDataLocation )        ( *( ( uint8_t ** ) ( pucDataLocation ) ) )
+
+/**
+ * @brief The number of bytes a buffer of the given size occupies in the pool,
+ * including the metadata and the space required to ensure alignment.
+ *
+ * @param[in] ulBufferSize The size of the buffer as seen by the user.
+ */
+#define bufferpoolstaticBUFFER_STRIDE( ulBufferSize )                          ( sizeof( BufferMetadata_t ) + ( ulBufferSize ) + ( portBYTE_ALIGNMENT - 1 ) )
+
+/**
+ * @brief The number of bytes occupied by all the buffers of a size class.
+ *
+ * @param[in] ulBufferSize The size of each buffer in the class.
+ * @param[in] ulNumBuffers The number of buffers in the class.
  */
-#define bufferpoolstaticBUFFER_IN_USE( pucBuffer )                             bufferpoolstaticBUFFER_IN_USE_FROM_DATA_LOCATION( bufferpoolstaticDATA_LOCATION_IN_BUFFER( pucBuffer ) )
+#define bufferpoolstaticSIZE_CLASS_STORAGE( ulBufferSize, ulNumBuffers )       ( ( ulNumBuffers ) * bufferpoolstaticBUFFER_STRIDE( ulBufferSize ) )
+
+/**
+ * @brief The total number of bytes occupied by the buffer pool.
+ */
+#define bufferpoolstaticPOOL_STORAGE                                                                                                   \
+    ( bufferpoolstaticSIZE_CLASS_STORAGE( bufferpoolconfigSIZE_CLASS_0_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_0_NUM_BUFFERS ) + \
+      bufferpoolstaticSIZE_CLASS_STORAGE( bufferpoolconfigSIZE_CLASS_1_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_1_NUM_BUFFERS ) + \
+      bufferpoolstaticSIZE_CLASS_STORAGE( bufferpoolconfigSIZE_CLASS_2_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_2_NUM_BUFFERS ) + \
+      bufferpoolstaticSIZE_CLASS_STORAGE( bufferpoolconfigSIZE_CLASS_3_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_3_NUM_BUFFERS ) + \
+      bufferpoolstaticSIZE_CLASS_STORAGE( bufferpoolconfigBUFFER_SIZE, bufferpoolconfigNUM_BUFFERS ) )
 /*-----------------------------------------------------------*/
 
 /**
@@ -97,79 +192,256 @@
  */
 typedef struct BufferMetadata
 {
-    uint8_t ucBufferInUse; /**< Whether or not the buffer is in use. */
+    uint8_t ucReferenceCount; /**< The number of users of the buffer, zero if the buffer is free. */
+    uint8_t ucSizeClass;      /**< The size class the buffer belongs to. */
 } BufferMetadata_t;
+
+/**
+ * @brief Book keeping for one size class of the pool.
+ */
+typedef struct SizeClass
+{
+    const uint32_t ulBufferSize; /**< The size of each buffer in the class. */
+    const uint32_t ulNumBuffers; /**< The number of buffers in the class. */
+    uint8_t * pucFreeListHead;   /**< Data location of the first free buffer, NULL if none. */
+    uint32_t ulBuffersInUse;     /**< The number of buffers currently in use. */
+    uint32_t ulHighWaterMark;    /**< The maximum value ulBuffersInUse has reached. */
+    uint32_t ulFailedRequests;   /**< Requests best fitted by this class that found it empty. */
+} SizeClass_t;
 /*-----------------------------------------------------------*/
 
 /**
- * @brief The pool of statically allocated buffers.
+ * @brief The size classes in increasing order of buffer size.
+ *
+ * Must only be modified from within a critical section once the pool has
+ * been initialized.
+ */
+static SizeClass_t xSizeClasses[ bufferpoolNUM_SIZE_CLASSES ] =
+{
+    { bufferpoolconfigSIZE_CLASS_0_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_0_NUM_BUFFERS, NULL, 0, 0, 0 },
+    { bufferpoolconfigSIZE_CLASS_1_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_1_NUM_BUFFERS, NULL, 0, 0, 0 },
+    { bufferpoolconfigSIZE_CLASS_2_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_2_NUM_BUFFERS, NULL, 0, 0, 0 },
+    { bufferpoolconfigSIZE_CLASS_3_BUFFER_SIZE, bufferpoolconfigSIZE_CLASS_3_NUM_BUFFERS, NULL, 0, 0, 0 },
+    { bufferpoolconfigBUFFER_SIZE,              bufferpoolconfigNUM_BUFFERS,              NULL, 0, 0, 0 }
+};
+
+/**
+ * @brief The statically allocated storage for the buffers of all the size
+ * classes.
  *
- * The number of buffers in the pool and the size of each buffer is controlled
- * via macros bufferpoolconfigNUM_BUFFERS and bufferpoolconfigBUFFER_SIZE which
- * must be defined in BufferPoolConfig.h.
+ * The storage is carved into buffers by BUFFERPOOL_Init(), the buffers of the
+ * smallest class first.
  *
  * @note Each buffer in the buffer pool allocates additional the space required
  * to store the metadata and to ensure alignment.
  */
-static uint8_t ucBufferPool[ bufferpoolconfigNUM_BUFFERS ][ sizeof( BufferMetadata_t ) + bufferpoolconfigBUFFER_SIZE + ( portBYTE_ALIGNMENT - 1 ) ];
+static uint8_t ucBufferPool[ bufferpoolstaticPOOL_STORAGE ];
+
+#if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+
+/**
+ * @brief The bit set in xBufferReturnedEvent when a buffer is returned.
+ */
+    #define bufferpoolstaticBUFFER_RETURNED_BIT    ( ( EventBits_t ) 1 )
+
+/**
+ * @brief Event group on which tasks wait for a buffer to be returned.
+ *
+ * The bit is cleared by a waiter, in the same critical section in which it
+ * found no free buffer, so that no return can be missed.
+ */
+    static EventGroupHandle_t xBufferReturnedEvent = NULL;
+
+    #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+        static StaticEventGroup_t xBufferReturnedEventBuffer;
+    #endif
+
+/**
+ * @brief The number of tasks waiting for a buffer.
+ *
+ * Must only be accessed from within a critical section.
+ */
+    static UBaseType_t uxWaitingTasks = 0;
+#endif /* bufferpoolconfigENABLE_BLOCKING_GET */
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Pops a free buffer of the best fitting class.
+ *
+ * Must be called from within a critical section.
+ *
+ * @param[in, out] pulBufferLength As for BUFFERPOOL_GetFreeBuffer.
+ * @param[in] xRecordFailure Whether to count the request in the failed
+ * requests of the best fitting class if it is exhausted.
+ *
+ * @return The buffer, or NULL if no class can serve the request.
+ */
+static uint8_t * prvTakeFreeBuffer( uint32_t * pulBufferLength,
+                                    BaseType_t xRecordFailure );
+
+/**
+ * @brief Puts a buffer back on the free list of its class once its last user
+ * is done with it.
+ *
+ * @param[in] pucBuffer The buffer being returned.
+ */
+static void prvReturnToPool( uint8_t * const pucBuffer );
+
+#if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+
+/**
+ * @brief Gets the cache of the calling task.
+ *
+ * @return The cache, or NULL if the task has none or no task is running.
+ */
+    static BufferPoolTaskCache_t * prvGetTaskCache( void );
+
+/**
+ * @brief Pops a buffer from a task cache.
+ *
+ * @param[in] pxCache The cache of the calling task.
+ * @param[in, out] pulBufferLength As for BUFFERPOOL_GetFreeBuffer.
+ * @param[in] xBestFitOnly pdTRUE to only look at the smallest class large
+ * enough for the request, pdFALSE to look at every class large enough.
+ *
+ * @return The buffer, or NULL if the cache has no suitable buffer.
+ */
+    static uint8_t * prvTakeFromTaskCache( BufferPoolTaskCache_t * const pxCache,
+                                           uint32_t * pulBufferLength,
+                                           BaseType_t xBestFitOnly );
+
+/**
+ * @brief Moves free buffers of a class from the pool to a task cache.
+ *
+ * Must be called from within a critical section.
+ *
+ * @param[in] pxCache The cache to refill.
+ * @param[in] ucSizeClass The class to refill.
+ */
+    static void prvRefillTaskCache( BufferPoolTaskCache_t * const pxCache,
+                                    uint8_t ucSizeClass );
+
+/**
+ * @brief Moves buffers of a class from a task cache back to the pool.
+ *
+ * Must be called from within a critical section.
+ *
+ * @param[in] pxCache The cache to flush.
+ * @param[in] ucSizeClass The class to flush.
+ * @param[in] ucCount The number of buffers to move.
+ *
+ * @return pdTRUE if tasks waiting for a buffer must be woken up.
+ */
+    static BaseType_t prvFlushTaskCache( BufferPoolTaskCache_t * const pxCache,
+                                         uint8_t ucSizeClass,
+                                         uint8_t ucCount );
+#endif /* bufferpoolconfigTASK_CACHE_DEPTH */
 /*-----------------------------------------------------------*/
 
 BaseType_t BUFFERPOOL_Init( void )
 {
-    BaseType_t x = 0;
+    BaseType_t xClass = 0;
+    uint32_t ulBuffer = 0;
+    uint8_t * pucBuffer = ucBufferPool;
+    uint8_t * pucDataLocation = NULL;
+    SizeClass_t * pxClass = NULL;
 
     /* This function is supposed to be called exactly once
      * and hence no thread safety is ensured. */
-    for( x = 0; x < bufferpoolconfigNUM_BUFFERS; x++ )
+    for( xClass = 0; xClass < bufferpoolNUM_SIZE_CLASSES; xClass++ )
     {
-        /* Mark all the buffers as free. */
-        bufferpoolstaticBUFFER_IN_USE( ucBufferPool[ x ] ) = 0;
+        pxClass = &( xSizeClasses[ xClass ] );
+
+        /* The order of the size classes is checked at compile time. The free
+         * list link is stored in the data portion of a free buffer. */
+        configASSERT( ( pxClass->ulNumBuffers == 0 ) ||
+                      ( pxClass->ulBufferSize >= sizeof( uint8_t * ) ) );
+
+        pxClass->pucFreeListHead = NULL;
+        pxClass->ulBuffersInUse = 0;
+        pxClass->ulHighWaterMark = 0;
+        pxClass->ulFailedRequests = 0;
+
+        for( ulBuffer = 0; ulBuffer < pxClass->ulNumBuffers; ulBuffer++ )
+        {
+            pucDataLocation = bufferpoolstaticDATA_LOCATION_IN_BUFFER( pucBuffer );
+
+            /* Mark the buffer as free and add it to the free list of its
+             * class. */
+            bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucDataLocation )->ucReferenceCount = 0;
+            bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucDataLocation )->ucSizeClass = ( uint8_t ) xClass;
+            bufferpoolstaticNEXT_FREE_FROM_DATA_LOCATION( pucDataLocation ) = pxClass->pucFreeListHead;
+            pxClass->pucFreeListHead = pucDataLocation;
+
+            pucBuffer += bufferpoolstaticBUFFER_STRIDE( pxClass->ulBufferSize );
+        }
     }
 
+    #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+        #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+            xBufferReturnedEvent = xEventGroupCreateStatic( &xBufferReturnedEventBuffer );
+        #else
+            xBufferReturnedEvent = xEventGroupCreate();
+        #endif
+
+        if( xBufferReturnedEvent == NULL )
+        {
+            return pdFAIL;
+        }
+    #endif /* bufferpoolconfigENABLE_BLOCKING_GET */
+
     return pdPASS;
 }
 /*-----------------------------------------------------------*/
 
-uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength )
+static uint8_t * prvTakeFreeBuffer( uint32_t * pulBufferLength,
+                                    BaseType_t xRecordFailure )
 {
-    BaseType_t x = 0;
+    BaseType_t xClass = 0;
+    BaseType_t xBestFitFound = pdFALSE;
     uint8_t * pucFreeBuffer = NULL;
+    SizeClass_t * pxClass = NULL;
 
-    /* All the buffers in the pool are of size bufferpoolconfigBUFFER_SIZE,
-     * so we cannot provide any buffer larger than that. */
-    if( *pulBufferLength <= bufferpoolconfigBUFFER_SIZE )
+    /* Size classes are sorted by size, so the first class which is large
+     * enough and has a free buffer is the best fit available. Classes
+     * without buffers are skipped. */
+    for( xClass = 0; xClass < bufferpoolNUM_SIZE_CLASSES; xClass++ )
     {
-        /* Iterate over all the buffers to find a free buffer. */
-        for( x = 0; x < bufferpoolconfigNUM_BUFFERS; x++ )
+        pxClass = &( xSizeClasses[ xClass ] );
+
+        if( ( pxClass->ulNumBuffers > 0 ) && ( *pulBufferLength <= pxClass->ulBufferSize ) )
         {
-            /* Start critical section. */
-            taskENTER_CRITICAL();
+            /* Pop the first buffer from the free list, if any. */
+            pucFreeBuffer = pxClass->pucFreeListHead;
 
-            /* Check if the buffer is free. */
-            if( bufferpoolstaticBUFFER_IN_USE( ucBufferPool[ x ] ) == 0 )
+            if( pucFreeBuffer != NULL )
             {
-                /* Mark the buffer as "in-use". */
-                bufferpoolstaticBUFFER_IN_USE( ucBufferPool[ x ] ) = 1;
+                pxClass->pucFreeListHead = bufferpoolstaticNEXT_FREE_FROM_DATA_LOCATION( pucFreeBuffer );
 
-                /* End critical section. The further operations in this
-                 * if branch do not modify the buffer and hence the critical
-                 * section is not needed hereafter. */
-                taskEXIT_CRITICAL();
+                /* Mark the buffer as "in-use" by the caller. */
+                bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucFreeBuffer )->ucReferenceCount = 1;
 
-                /* Return the actual buffer size (as configured by the
-                 * bufferpoolconfigBUFFER_SIZE macro) to the user. */
-                *pulBufferLength = bufferpoolconfigBUFFER_SIZE;
+                pxClass->ulBuffersInUse++;
 
-                /* Return the data location to the user. */
-                pucFreeBuffer = bufferpoolstaticDATA_LOCATION_IN_BUFFER( ucBufferPool[ x ] );
+                if( pxClass->ulBuffersInUse > pxClass->ulHighWaterMark )
+                {
+                    pxClass->ulHighWaterMark = pxClass->ulBuffersInUse;
+                }
+
+                /* Return the actual buffer size of the class to the
+                 * user. */
+                *pulBufferLength = pxClass->ulBufferSize;
 
                 /* Stop as we have found a buffer. */
                 break;
             }
-            else
+            else if( ( xBestFitFound == pdFALSE ) && ( xRecordFailure == pdTRUE ) )
             {
-                /* End critical section. */
-                taskEXIT_CRITICAL();
+                /* The class best suited for this request is exhausted,
+                 * record it so that the class can be resized. The request
+                 * may still be served from a larger class. */
+                pxClass->ulFailedRequests++;
+                xBestFitFound = pdTRUE;
             }
         }
     }
@@ -178,17 +450,430 @@ uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength )
 }
 /*-----------------------------------------------------------*/
 
+uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength )
+{
+    uint8_t * pucFreeBuffer = NULL;
+
+    #if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+        BufferPoolTaskCache_t * pxCache = prvGetTaskCache();
+
+        if( pxCache != NULL )
+        {
+            pucFreeBuffer = prvTakeFromTaskCache( pxCache, pulBufferLength, pdTRUE );
+        }
+
+        if( pucFreeBuffer == NULL )
+    #endif /* bufferpoolconfigTASK_CACHE_DEPTH */
+    {
+        /* Start critical section. */
+        taskENTER_CRITICAL();
+
+        pucFreeBuffer = prvTakeFreeBuffer( pulBufferLength, pdTRUE );
+
+        #if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+            /* Take more buffers of the same class while in the critical
+             * section, so that the next requests need none. */
+            if( ( pucFreeBuffer != NULL ) && ( pxCache != NULL ) )
+            {
+                prvRefillTaskCache( pxCache, bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucFreeBuffer )->ucSizeClass );
+            }
+        #endif
+
+        /* End critical section. */
+        taskEXIT_CRITICAL();
+    }
+
+    #if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+        /* A larger buffer held by the cache is better than failing. */
+        if( ( pucFreeBuffer == NULL ) && ( pxCache != NULL ) )
+        {
+            pucFreeBuffer = prvTakeFromTaskCache( pxCache, pulBufferLength, pdFALSE );
+        }
+    #endif
+
+    return pucFreeBuffer;
+}
+/*-----------------------------------------------------------*/
+
+#if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+
+    uint8_t * BUFFERPOOL_GetFreeBufferWait( uint32_t * pulBufferLength,
+                                            TickType_t xTicksToWait )
+    {
+        uint8_t * pucFreeBuffer = NULL;
+        BaseType_t xTimedOut = pdFALSE;
+        TimeOut_t xTimeOut;
+
+        /* The first attempt also looks at the cache of the calling task and
+         * counts the request as failed if no buffer is free. */
+        pucFreeBuffer = BUFFERPOOL_GetFreeBuffer( pulBufferLength );
+
+        vTaskSetTimeOutState( &xTimeOut );
+
+        while( ( pucFreeBuffer == NULL ) && ( xTimedOut == pdFALSE ) )
+        {
+            taskENTER_CRITICAL();
+            {
+                pucFreeBuffer = prvTakeFreeBuffer( pulBufferLength, pdFALSE );
+
+                if( pucFreeBuffer == NULL )
+                {
+                    /* Any buffer returned from now on sets the bit again. */
+                    ( void ) xEventGroupClearBits( xBufferReturnedEvent, bufferpoolstaticBUFFER_RETURNED_BIT );
+                    uxWaitingTasks++;
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            if( pucFreeBuffer == NULL )
+            {
+                /* The returned buffer may be too small or taken by another
+                 * waiter, so wait for the remaining time and try again. */
+                xTimedOut = xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait );
+
+                if( xTimedOut == pdFALSE )
+                {
+                    ( void ) xEventGroupWaitBits( xBufferReturnedEvent, bufferpoolstaticBUFFER_RETURNED_BIT, pdFALSE, pdFALSE, xTicksToWait );
+                }
+
+                taskENTER_CRITICAL();
+                uxWaitingTasks--;
+                taskEXIT_CRITICAL();
+            }
+        }
+
+        return pucFreeBuffer;
+    }
+
+#endif /* bufferpoolconfigENABLE_BLOCKING_GET */
+/*-----------------------------------------------------------*/
+
 void BUFFERPOOL_ReturnBuffer( uint8_t * const pucBuffer )
 {
+    #if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+        BufferMetadata_t * pxMetadata = bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucBuffer );
+        BufferPoolTaskCache_t * pxCache = prvGetTaskCache();
+        BaseType_t xWakeWaitingTasks = pdFALSE;
+
+        /* No other task can add a user to a buffer the calling task is the
+         * only user of, so it can be freed without a critical section. */
+        if( ( pxCache != NULL ) && ( pxMetadata->ucReferenceCount == ( uint8_t ) 1 ) )
+        {
+            pxMetadata->ucReferenceCount = 0;
+
+            /* Make room by giving half of a full cache back to the pool. */
+            if( pxCache->ucCount[ pxMetadata->ucSizeClass ] == ( uint8_t ) bufferpoolconfigTASK_CACHE_DEPTH )
+            {
+                taskENTER_CRITICAL();
+                xWakeWaitingTasks = prvFlushTaskCache( pxCache, pxMetadata->ucSizeClass, ( uint8_t ) ( ( bufferpoolconfigTASK_CACHE_DEPTH + 1 ) / 2 ) );
+                taskEXIT_CRITICAL();
+            }
+
+            pxCache->pucBuffers[ pxMetadata->ucSizeClass ][ pxCache->ucCount[ pxMetadata->ucSizeClass ] ] = pucBuffer;
+            pxCache->ucCount[ pxMetadata->ucSizeClass ]++;
+
+            #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+                if( xWakeWaitingTasks == pdTRUE )
+                {
+                    ( void ) xEventGroupSetBits( xBufferReturnedEvent, bufferpoolstaticBUFFER_RETURNED_BIT );
+                }
+            #else
+                ( void ) xWakeWaitingTasks;
+            #endif
+        }
+        else
+        {
+            prvReturnToPool( pucBuffer );
+        }
+    #else /* bufferpoolconfigTASK_CACHE_DEPTH */
+        prvReturnToPool( pucBuffer );
+    #endif /* bufferpoolconfigTASK_CACHE_DEPTH */
+}
+/*-----------------------------------------------------------*/
+
+static void prvReturnToPool( uint8_t * const pucBuffer )
+{
+    BufferMetadata_t * pxMetadata = bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucBuffer );
+    SizeClass_t * pxClass = NULL;
+
+    #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+        BaseType_t xWakeWaitingTasks = pdFALSE;
+    #endif
+
+    /* Start critical section. */
+    taskENTER_CRITICAL();
+
+    /* The returned buffer is the data location in the actual buffer
+     * (because we gave the data location to the user). Guard against
+     * returning the same buffer more times than it was retained which
+     * would corrupt the free list. */
+    configASSERT( pxMetadata->ucReferenceCount > 0 );
+
+    if( pxMetadata->ucReferenceCount > 0 )
+    {
+        pxMetadata->ucReferenceCount--;
+
+        if( pxMetadata->ucReferenceCount == 0 )
+        {
+            pxClass = &( xSizeClasses[ pxMetadata->ucSizeClass ] );
+
+            /* The last user is done, so push the buffer on the front of
+             * the free list of its class so that it is the next one to be
+             * handed out. */
+            bufferpoolstaticNEXT_FREE_FROM_DATA_LOCATION( pucBuffer ) = pxClass->pucFreeListHead;
+            pxClass->pucFreeListHead = pucBuffer;
+            pxClass->ulBuffersInUse--;
+
+            #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+                xWakeWaitingTasks = ( uxWaitingTasks > ( UBaseType_t ) 0 ) ? pdTRUE : pdFALSE;
+            #endif
+        }
+    }
+
+    /* End critical section. */
+    taskEXIT_CRITICAL();
+
+    #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+        if( xWakeWaitingTasks == pdTRUE )
+        {
+            ( void ) xEventGroupSetBits( xBufferReturnedEvent, bufferpoolstaticBUFFER_RETURNED_BIT );
+        }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t BUFFERPOOL_RetainBuffer( uint8_t * const pucBuffer )
+{
+    BufferMetadata_t * pxMetadata = bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucBuffer );
+    BaseType_t xResult = pdFAIL;
+
     /* Start critical section. */
     taskENTER_CRITICAL();
 
-    /* Mark the buffer as free. The returned buffer is the data
-     * location in the actual buffer (because we gave the data location
-     * to the user). */
-    bufferpoolstaticBUFFER_IN_USE_FROM_DATA_LOCATION( pucBuffer ) = 0;
+    /* Only a buffer somebody holds can be shared. */
+    configASSERT( pxMetadata->ucReferenceCount > 0 );
+
+    if( ( pxMetadata->ucReferenceCount > 0 ) && ( pxMetadata->ucReferenceCount < UINT8_MAX ) )
+    {
+        pxMetadata->ucReferenceCount++;
+        xResult = pdPASS;
+    }
 
     /* End critical section. */
     taskEXIT_CRITICAL();
+
+    return xResult;
 }
 /*-----------------------------------------------------------*/
+
+uint32_t BUFFERPOOL_GetFreeBufferCount( void )
+{
+    BaseType_t xClass = 0;
+    uint32_t ulFreeBuffers = 0;
+
+    #if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+        BufferPoolTaskCache_t * pxCache = prvGetTaskCache();
+
+        /* The buffers in the cache of the calling task are as good as free
+         * to it. */
+        for( xClass = 0; ( xClass < bufferpoolNUM_SIZE_CLASSES ) && ( pxCache != NULL ); xClass++ )
+        {
+            ulFreeBuffers += ( uint32_t ) pxCache->ucCount[ xClass ];
+        }
+    #endif
+
+    taskENTER_CRITICAL();
+    {
+        for( xClass = 0; xClass < bufferpoolNUM_SIZE_CLASSES; xClass++ )
+        {
+            ulFreeBuffers += xSizeClasses[ xClass ].ulNumBuffers - xSizeClasses[ xClass ].ulBuffersInUse;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return ulFreeBuffers;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t BUFFERPOOL_GetStatistics( uint32_t ulSizeClass,
+                                     BufferPoolStatistics_t * const pxStatistics )
+{
+    BaseType_t xResult = pdFAIL;
+    SizeClass_t * pxClass = NULL;
+
+    if( ( ulSizeClass < bufferpoolNUM_SIZE_CLASSES ) && ( pxStatistics != NULL ) )
+    {
+        pxClass = &( xSizeClasses[ ulSizeClass ] );
+
+        /* Take a consistent snapshot of the counters. */
+        taskENTER_CRITICAL();
+        {
+            pxStatistics->ulBufferSize = pxClass->ulBufferSize;
+            pxStatistics->ulNumBuffers = pxClass->ulNumBuffers;
+            pxStatistics->ulBuffersInUse = pxClass->ulBuffersInUse;
+            pxStatistics->ulHighWaterMark = pxClass->ulHighWaterMark;
+            pxStatistics->ulFailedRequests = pxClass->ulFailedRequests;
+        }
+        taskEXIT_CRITICAL();
+
+        xResult = pdPASS;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+#if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+
+    void BUFFERPOOL_TaskCacheRegister( BufferPoolTaskCache_t * const pxCache )
+    {
+        memset( pxCache, 0x00, sizeof( BufferPoolTaskCache_t ) );
+
+        vTaskSetThreadLocalStoragePointer( NULL, bufferpoolconfigTASK_CACHE_TLS_INDEX, pxCache );
+    }
+/*-----------------------------------------------------------*/
+
+    void BUFFERPOOL_TaskCacheFlush( void )
+    {
+        BufferPoolTaskCache_t * pxCache = prvGetTaskCache();
+        BaseType_t xClass = 0;
+        BaseType_t xWakeWaitingTasks = pdFALSE;
+
+        if( pxCache != NULL )
+        {
+            taskENTER_CRITICAL();
+            {
+                for( xClass = 0; xClass < bufferpoolNUM_SIZE_CLASSES; xClass++ )
+                {
+                    if( prvFlushTaskCache( pxCache, ( uint8_t ) xClass, pxCache->ucCount[ xClass ] ) == pdTRUE )
+                    {
+                        xWakeWaitingTasks = pdTRUE;
+                    }
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            vTaskSetThreadLocalStoragePointer( NULL, bufferpoolconfigTASK_CACHE_TLS_INDEX, NULL );
+
+            #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+                if( xWakeWaitingTasks == pdTRUE )
+                {
+                    ( void ) xEventGroupSetBits( xBufferReturnedEvent, bufferpoolstaticBUFFER_RETURNED_BIT );
+                }
+            #endif
+        }
+
+        ( void ) xWakeWaitingTasks;
+    }
+/*-----------------------------------------------------------*/
+
+    static BufferPoolTaskCache_t * prvGetTaskCache( void )
+    {
+        BufferPoolTaskCache_t * pxCache = NULL;
+
+        /* There is no calling task to look at before the scheduler has
+         * started. */
+        if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
+        {
+            pxCache = ( BufferPoolTaskCache_t * ) pvTaskGetThreadLocalStoragePointer( NULL, bufferpoolconfigTASK_CACHE_TLS_INDEX );
+        }
+
+        return pxCache;
+    }
+/*-----------------------------------------------------------*/
+
+    static uint8_t * prvTakeFromTaskCache( BufferPoolTaskCache_t * const pxCache,
+                                           uint32_t * pulBufferLength,
+                                           BaseType_t xBestFitOnly )
+    {
+        BaseType_t xClass = 0;
+        uint8_t * pucFreeBuffer = NULL;
+        SizeClass_t * pxClass = NULL;
+
+        for( xClass = 0; xClass < bufferpoolNUM_SIZE_CLASSES; xClass++ )
+        {
+            pxClass = &( xSizeClasses[ xClass ] );
+
+            if( ( pxClass->ulNumBuffers > 0 ) && ( *pulBufferLength <= pxClass->ulBufferSize ) )
+            {
+                if( pxCache->ucCount[ xClass ] > ( uint8_t ) 0 )
+                {
+                    pxCache->ucCount[ xClass ]--;
+                    pucFreeBuffer = pxCache->pucBuffers[ xClass ][ pxCache->ucCount[ xClass ] ];
+
+                    /* The buffer is only known to this task, so it can be
+                     * marked as "in-use" without a critical section. */
+                    bufferpoolstaticMETADATA_FROM_DATA_LOCATION( pucFreeBuffer )->ucReferenceCount = 1;
+                    *pulBufferLength = pxClass->ulBufferSize;
+                    break;
+                }
+                else if( xBestFitOnly == pdTRUE )
+                {
+                    /* Let the pool serve the request from the same class. */
+                    break;
+                }
+                else
+                {
+                    /* Try the next larger class. */
+                }
+            }
+        }
+
+        return pucFreeBuffer;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvRefillTaskCache( BufferPoolTaskCache_t * const pxCache,
+                                    uint8_t ucSizeClass )
+    {
+        SizeClass_t * pxClass = &( xSizeClasses[ ucSizeClass ] );
+        uint8_t * pucFreeBuffer = NULL;
+
+        /* Fill the cache half way, leaving room for returned buffers. */
+        while( ( pxCache->ucCount[ ucSizeClass ] < ( uint8_t ) ( bufferpoolconfigTASK_CACHE_DEPTH / 2 ) ) &&
+               ( pxClass->pucFreeListHead != NULL ) )
+        {
+            pucFreeBuffer = pxClass->pucFreeListHead;
+            pxClass->pucFreeListHead = bufferpoolstaticNEXT_FREE_FROM_DATA_LOCATION( pucFreeBuffer );
+
+            /* Cached buffers count as in use, as no other task can get them. */
+            pxClass->ulBuffersInUse++;
+
+            if( pxClass->ulBuffersInUse > pxClass->ulHighWaterMark )
+            {
+                pxClass->ulHighWaterMark = pxClass->ulBuffersInUse;
+            }
+
+            pxCache->pucBuffers[ ucSizeClass ][ pxCache->ucCount[ ucSizeClass ] ] = pucFreeBuffer;
+            pxCache->ucCount[ ucSizeClass ]++;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvFlushTaskCache( BufferPoolTaskCache_t * const pxCache,
+                                         uint8_t ucSizeClass,
+                                         uint8_t ucCount )
+    {
+        SizeClass_t * pxClass = &( xSizeClasses[ ucSizeClass ] );
+        uint8_t * pucBuffer = NULL;
+        uint8_t x;
+
+        for( x = 0; x < ucCount; x++ )
+        {
+            pxCache->ucCount[ ucSizeClass ]--;
+            pucBuffer = pxCache->pucBuffers[ ucSizeClass ][ pxCache->ucCount[ ucSizeClass ] ];
+
+            bufferpoolstaticNEXT_FREE_FROM_DATA_LOCATION( pucBuffer ) = pxClass->pucFreeListHead;
+            pxClass->pucFreeListHead = pucBuffer;
+            pxClass->ulBuffersInUse--;
+        }
+
+        #if ( bufferpoolconfigENABLE_BLOCKING_GET == 1 )
+            return ( ( ucCount > ( uint8_t ) 0 ) && ( uxWaitingTasks > ( UBaseType_t ) 0 ) ) ? pdTRUE : pdFALSE;
+        #else
+            return pdFALSE;
+        #endif
+    }
+
+#endif /* bufferpoolconfigTASK_CACHE_DEPTH */
+/*-----------------------------------------------------------*/
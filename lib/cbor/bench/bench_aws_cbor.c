@@ -0,0 +1,427 @@
+/*
+ * Amazon FreeRTOS CBOR Library V1.0.2
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file bench_aws_cbor.c
+ * @brief Encode and decode throughput of the CBOR library
+ *
+ * Builds documents shaped like Defender reports and decodes documents shaped
+ * like OTA Get Stream responses, and reports for each case the time per
+ * operation and the calls made through pxCBOR_malloc and pxCBOR_realloc.
+ * The "random" cases draw key counts and string lengths from a fixed seed, so
+ * every run measures the same documents, and check that each value reads
+ * back.
+ *
+ * On a host, `make bench` builds and runs it.  On a target, build this file
+ * with __free_rtos__ and CBOR_BENCH_NO_MAIN defined and call CBOR_BenchRun()
+ * from a task; CBOR_BENCH_NOW_NS and CBOR_BENCH_PRINTF can be defined to use a
+ * finer clock or another output.
+ */
+
+#include "aws_cbor_internals.h"
+#include "aws_cbor_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __free_rtos__
+    #include "FreeRTOS.h"
+    #include "task.h"
+#else
+    #include <time.h>
+#endif
+
+#ifndef CBOR_BENCH_NOW_NS
+    #ifdef __free_rtos__
+        #define CBOR_BENCH_NOW_NS() \
+    ( ( uint64_t ) xTaskGetTickCount() * portTICK_PERIOD_MS * 1000000ULL )
+    #else
+        #define CBOR_BENCH_NOW_NS()    prvHostNowNs()
+    #endif
+#endif
+
+#ifndef CBOR_BENCH_PRINTF
+    #ifdef __free_rtos__
+        #define CBOR_BENCH_PRINTF( X )    configPRINTF( X )
+    #else
+        #define CBOR_BENCH_PRINTF( X )    printf X
+    #endif
+#endif
+
+/** @brief Repetitions of each case; more give steadier numbers */
+#ifndef CBOR_BENCH_ITERATIONS
+    #define CBOR_BENCH_ITERATIONS    ( 2000 )
+#endif
+
+/** @brief Seed of the random documents */
+#define CBOR_BENCH_SEED              ( 0x2545F491UL )
+
+/** @brief Largest OTA block payload measured */
+#define CBOR_BENCH_MAX_PAYLOAD       ( 4096 )
+
+/** @brief Calls and bytes counted by the allocation hooks */
+typedef struct
+{
+    uint32_t ulMallocs;
+    uint32_t ulReallocs;
+    uint32_t ulFrees;
+    uint64_t ullBytes;
+} BenchCounts_t;
+
+static BenchCounts_t xCounts;
+
+static void *( *pxBenchMalloc )( size_t );
+static void *( *pxBenchRealloc )( void *, size_t );
+static void ( * pxBenchFree )( void * );
+
+static cbor_byte_t pxOtaMessage[ CBOR_BENCH_MAX_PAYLOAD + 32 ];
+static cbor_ssize_t xOtaMessageLength;
+
+static uint32_t ulRandomState;
+
+#ifndef __free_rtos__
+    static uint64_t prvHostNowNs( void )
+    {
+        struct timespec xNow;
+
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+        return ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+    }
+#endif
+
+static void * prvCountingMalloc( size_t xSize )
+{
+    xCounts.ulMallocs++;
+    xCounts.ullBytes += xSize;
+
+    return pxBenchMalloc( xSize );
+}
+
+static void * prvCountingRealloc( void * pvOld,
+                                  size_t xSize )
+{
+    xCounts.ulReallocs++;
+    xCounts.ullBytes += xSize;
+
+    return pxBenchRealloc( pvOld, xSize );
+}
+
+static void prvCountingFree( void * pv )
+{
+    xCounts.ulFrees++;
+    pxBenchFree( pv );
+}
+
+/** @brief xorshift32, so that every platform draws the same documents */
+static uint32_t prvRandom( void )
+{
+    ulRandomState ^= ulRandomState << 13;
+    ulRandomState ^= ulRandomState >> 17;
+    ulRandomState ^= ulRandomState << 5;
+
+    return ulRandomState;
+}
+
+/**
+ * @brief Builds a report like aws_defender_report.c does
+ * @param lMetrics number of integer metrics in the metrics map
+ * @param xPresize size the buffers up front, as the Defender agent does
+ */
+static bool prvBuildReport( cbor_int_t lMetrics,
+                            bool xPresize )
+{
+    char pcKey[ 8 ];
+    CBORHandle_t xHeader = CBOR_New( xPresize ?
+                                     CBOR_EMPTY_MAP_SIZE +
+                                     CBOR_StringEncodedSize( "rid" ) + CBOR_IntEncodedSize( 1234 ) +
+                                     CBOR_StringEncodedSize( "v" ) + CBOR_StringEncodedSize( "1.0" ) : 0 );
+    CBORHandle_t xMetrics = CBOR_New( xPresize ?
+                                      CBOR_EMPTY_MAP_SIZE + lMetrics *
+                                      ( CBOR_StringEncodedSize( "m0000" ) +
+                                        CBOR_IntEncodedSize( UINT16_MAX ) ) : 0 );
+    CBORHandle_t xReport = NULL;
+
+    CBOR_AppendKeyWithInt( xHeader, "rid", 1234 );
+    CBOR_AppendKeyWithString( xHeader, "v", "1.0" );
+
+    for( cbor_int_t lI = 0; lI < lMetrics; lI++ )
+    {
+        snprintf( pcKey, sizeof( pcKey ), "m%04d", ( int ) lI );
+        CBOR_AppendKeyWithInt( xMetrics, pcKey, lI * 257 );
+    }
+
+    xReport = CBOR_New( xPresize ?
+                        CBOR_EMPTY_MAP_SIZE +
+                        CBOR_StringEncodedSize( "hed" ) + CBOR_GetBufferSize( xHeader ) +
+                        CBOR_StringEncodedSize( "met" ) + CBOR_GetBufferSize( xMetrics ) : 0 );
+
+    CBOR_AppendKeyWithMap( xReport, "hed", xHeader );
+    CBOR_AppendKeyWithMap( xReport, "met", xMetrics );
+
+    bool xOk = ( eCborErrNoError == CBOR_CheckError( xReport ) );
+
+    CBOR_Delete( &xHeader );
+    CBOR_Delete( &xMetrics );
+    CBOR_Delete( &xReport );
+
+    return xOk;
+}
+
+static bool prvReport8( void )
+{
+    return prvBuildReport( 8, false );
+}
+
+static bool prvReport64( void )
+{
+    return prvBuildReport( 64, false );
+}
+
+static bool prvReport64Presized( void )
+{
+    return prvBuildReport( 64, true );
+}
+
+/**
+ * @brief Builds a map of random string and integer values, then reads every
+ * key back
+ */
+static bool prvRandomMap( void )
+{
+    char pcKey[ 12 ];
+    char pcValue[ 300 ];
+    cbor_int_t lKeys = 1 + ( prvRandom() % 48 );
+    uint32_t ulSeed = ulRandomState;
+    CBORHandle_t xMap = CBOR_New( 0 );
+    bool xOk = true;
+
+    for( cbor_int_t lI = 0; lI < lKeys; lI++ )
+    {
+        uint32_t ulDraw = prvRandom();
+        snprintf( pcKey, sizeof( pcKey ), "k%d", ( int ) lI );
+
+        if( ulDraw & 1U )
+        {
+            size_t xLength = ( ulDraw >> 1 ) % ( sizeof( pcValue ) - 1 );
+            memset( pcValue, 'a' + ( int ) ( lI % 26 ), xLength );
+            pcValue[ xLength ] = 0;
+            CBOR_AppendKeyWithString( xMap, pcKey, pcValue );
+        }
+        else
+        {
+            CBOR_AppendKeyWithInt( xMap, pcKey, ( cbor_int_t ) ( ( ulDraw >> 1 ) % 100000 ) );
+        }
+    }
+
+    /* Draw the same values again to check them */
+    ulRandomState = ulSeed;
+
+    for( cbor_int_t lI = 0; xOk && lI < lKeys; lI++ )
+    {
+        uint32_t ulDraw = prvRandom();
+        snprintf( pcKey, sizeof( pcKey ), "k%d", ( int ) lI );
+
+        if( ulDraw & 1U )
+        {
+            char * pcRead = CBOR_FromKeyReadString( xMap, pcKey );
+            xOk = ( NULL != pcRead ) && ( ( ( ulDraw >> 1 ) % ( sizeof( pcValue ) - 1 ) ) == strlen( pcRead ) );
+            pxCBOR_free( pcRead );
+        }
+        else
+        {
+            xOk = ( ( cbor_int_t ) ( ( ulDraw >> 1 ) % 100000 ) == CBOR_FromKeyReadInt( xMap, pcKey ) );
+        }
+    }
+
+    xOk = xOk && ( eCborErrNoError == CBOR_CheckError( xMap ) );
+    CBOR_Delete( &xMap );
+
+    return xOk;
+}
+
+/**
+ * @brief Writes a Get Stream response as the OTA service sends it: an
+ * indefinite length map of file id, block id, block size and payload
+ */
+static void prvBuildOtaMessage( cbor_ssize_t xPayloadLength )
+{
+    cbor_byte_t * pxOut = pxOtaMessage;
+
+    *pxOut++ = 0xBF;
+    *pxOut++ = 0x61;
+    *pxOut++ = 'f';
+    *pxOut++ = 0x01;
+    *pxOut++ = 0x61;
+    *pxOut++ = 'i';
+    *pxOut++ = 0x18;
+    *pxOut++ = 0x2A;
+    *pxOut++ = 0x61;
+    *pxOut++ = 'l';
+    *pxOut++ = 0x19;
+    *pxOut++ = ( cbor_byte_t ) ( xPayloadLength >> 8 );
+    *pxOut++ = ( cbor_byte_t ) xPayloadLength;
+    *pxOut++ = 0x61;
+    *pxOut++ = 'p';
+    *pxOut++ = 0x59;
+    *pxOut++ = ( cbor_byte_t ) ( xPayloadLength >> 8 );
+    *pxOut++ = ( cbor_byte_t ) xPayloadLength;
+
+    for( cbor_ssize_t xI = 0; xI < xPayloadLength; xI++ )
+    {
+        *pxOut++ = ( cbor_byte_t ) xI;
+    }
+
+    *pxOut++ = 0xFF;
+    xOtaMessageLength = pxOut - pxOtaMessage;
+}
+
+/**
+ * @brief Decodes the OTA message in fragments of xFragment bytes and checks
+ * that the whole payload was seen
+ */
+static bool prvDecodeOtaMessage( cbor_ssize_t xFragment )
+{
+    CBORStreamDecoder_t xDecoder;
+    CBORStreamItem_t xItem;
+    cbor_ssize_t xOffset = 0;
+    uint64_t ullPayload = 0;
+    cborStreamStatus_t xStatus = eCborStreamNeedMoreData;
+
+    CBOR_StreamInit( &xDecoder );
+
+    while( eCborStreamNeedMoreData == xStatus && xOffset < xOtaMessageLength )
+    {
+        cbor_ssize_t xLength = xOtaMessageLength - xOffset;
+
+        if( xLength > xFragment )
+        {
+            xLength = xFragment;
+        }
+
+        CBOR_StreamFeed( &xDecoder, pxOtaMessage + xOffset, xLength );
+        xOffset += xLength;
+
+        while( eCborStreamItemReady == ( xStatus = CBOR_StreamNext( &xDecoder, &xItem ) ) )
+        {
+            if( eCborStreamByteString == xItem.xType )
+            {
+                ullPayload += xItem.xChunkLength;
+            }
+        }
+    }
+
+    return ( eCborStreamNeedMoreData == xStatus ) &&
+           ( ullPayload + 19 == ( uint64_t ) xOtaMessageLength );
+}
+
+static bool prvOtaWhole( void )
+{
+    return prvDecodeOtaMessage( xOtaMessageLength );
+}
+
+static bool prvOtaFragments64( void )
+{
+    return prvDecodeOtaMessage( 64 );
+}
+
+/**
+ * @brief Runs one case and prints a line for it
+ */
+static void prvRun( const char * pcName,
+                    bool ( * pxCase )( void ) )
+{
+    bool xOk = true;
+
+    memset( &xCounts, 0, sizeof( xCounts ) );
+    ulRandomState = CBOR_BENCH_SEED;
+
+    uint64_t ullStart = CBOR_BENCH_NOW_NS();
+
+    for( uint32_t ulI = 0; xOk && ulI < CBOR_BENCH_ITERATIONS; ulI++ )
+    {
+        xOk = pxCase();
+    }
+
+    uint64_t ullElapsed = CBOR_BENCH_NOW_NS() - ullStart;
+
+    /* Counts are printed in hundredths, as not every target prints floats */
+    uint32_t ulMallocs = ( uint32_t ) ( ( uint64_t ) xCounts.ulMallocs * 100 / CBOR_BENCH_ITERATIONS );
+    uint32_t ulReallocs = ( uint32_t ) ( ( uint64_t ) xCounts.ulReallocs * 100 / CBOR_BENCH_ITERATIONS );
+
+    CBOR_BENCH_PRINTF( ( "%-24s %10lu ns/op %4lu.%02lu malloc/op %4lu.%02lu realloc/op %9lu B/op %s\r\n",
+                         pcName,
+                         ( unsigned long ) ( ullElapsed / CBOR_BENCH_ITERATIONS ),
+                         ( unsigned long ) ( ulMallocs / 100 ), ( unsigned long ) ( ulMallocs % 100 ),
+                         ( unsigned long ) ( ulReallocs / 100 ), ( unsigned long ) ( ulReallocs % 100 ),
+                         ( unsigned long ) ( xCounts.ullBytes / CBOR_BENCH_ITERATIONS ),
+                         xOk ? "" : "FAILED" ) );
+}
+
+void CBOR_BenchRun( void )
+{
+    static const cbor_ssize_t pxPayloads[] = { 256, 1024, CBOR_BENCH_MAX_PAYLOAD };
+    char pcName[ 32 ];
+
+    /* Count every allocation the library makes */
+    pxBenchMalloc = pxCBOR_malloc;
+    pxBenchRealloc = pxCBOR_realloc;
+    pxBenchFree = pxCBOR_free;
+    pxCBOR_malloc = prvCountingMalloc;
+    pxCBOR_free = prvCountingFree;
+
+    /* CBOR_ReallocImpl is built on pxCBOR_malloc, which is already counted */
+    if( CBOR_ReallocImpl != pxBenchRealloc )
+    {
+        pxCBOR_realloc = prvCountingRealloc;
+    }
+
+    prvRun( "defender_report_8", prvReport8 );
+    prvRun( "defender_report_64", prvReport64 );
+    prvRun( "defender_report_64_sized", prvReport64Presized );
+    prvRun( "random_map", prvRandomMap );
+
+    for( size_t xI = 0; xI < sizeof( pxPayloads ) / sizeof( pxPayloads[ 0 ] ); xI++ )
+    {
+        prvBuildOtaMessage( pxPayloads[ xI ] );
+        snprintf( pcName, sizeof( pcName ), "ota_block_%d", ( int ) pxPayloads[ xI ] );
+        prvRun( pcName, prvOtaWhole );
+        snprintf( pcName, sizeof( pcName ), "ota_block_%d_frag64", ( int ) pxPayloads[ xI ] );
+        prvRun( pcName, prvOtaFragments64 );
+    }
+
+    pxCBOR_malloc = pxBenchMalloc;
+    pxCBOR_realloc = pxBenchRealloc;
+    pxCBOR_free = pxBenchFree;
+}
+
+#ifndef CBOR_BENCH_NO_MAIN
+    int main( void )
+    {
+        CBOR_BenchRun();
+
+        return 0;
+    }
+#endif
@@ -57,10 +57,52 @@ CBORHandle_t CBOR_New( cbor_ssize_t xSize )
     xNewCborData->pxCursor = pxNew_buffer;
     xNewCborData->pxBufferEnd = &pxNew_buffer[ xSize - 1 ];
     xNewCborData->pxMapEnd = &pxNew_buffer[ 1 ];
+    xNewCborData->xError = eCborErrNoError;
+    xNewCborData->xStaticBuffer = false;
+    CBOR_InvalidateKeyIndex( xNewCborData );
 
     return xNewCborData;
 }
 
+CBORHandle_t CBOR_NewStatic( cbor_byte_t * pxBuffer,
+                             cbor_ssize_t xSize )
+{
+    if( NULL == pxBuffer )
+    {
+        return NULL;
+    }
+
+    /* Align the handle, the buffer may come from a byte array */
+    cbor_ssize_t xPadding = ( sizeof( void * ) - ( ( uintptr_t ) pxBuffer % sizeof( void * ) ) ) %
+                            sizeof( void * );
+
+    if( xSize < ( cbor_ssize_t ) ( xPadding + sizeof( struct CborData_s ) ) + CBOR_EMPTY_MAP_SIZE )
+    {
+        return NULL;
+    }
+
+    CBORHandle_t xNewCborData = ( CBORHandle_t ) ( pxBuffer + xPadding );
+    cbor_byte_t * pxData = pxBuffer + xPadding + sizeof( struct CborData_s );
+    cbor_ssize_t xDataSize = xSize - xPadding - sizeof( struct CborData_s );
+
+    pxData[ 0 ] = CBOR_MAP_OPEN;
+    pxData[ 1 ] = CBOR_BREAK;
+    xNewCborData->pxBufferStart = pxData;
+    xNewCborData->pxCursor = pxData;
+    xNewCborData->pxBufferEnd = &pxData[ xDataSize - 1 ];
+    xNewCborData->pxMapEnd = &pxData[ 1 ];
+    xNewCborData->xError = eCborErrNoError;
+    xNewCborData->xStaticBuffer = true;
+    CBOR_InvalidateKeyIndex( xNewCborData );
+
+    return xNewCborData;
+}
+
+cbor_ssize_t CBOR_HandleSize( void )
+{
+    return sizeof( struct CborData_s );
+}
+
 void CBOR_Delete( CBORHandle_t * ppxHandle )
 {
     if( NULL == ppxHandle )
@@ -73,8 +115,13 @@ void CBOR_Delete( CBORHandle_t * ppxHandle )
         return;
     }
 
-    pxCBOR_free( ( *ppxHandle )->pxBufferStart );
-    pxCBOR_free( *ppxHandle );
+    /* The handle lives in a static buffer, so there is nothing to free */
+    if( !( *ppxHandle )->xStaticBuffer )
+    {
+        pxCBOR_free( ( *ppxHandle )->pxBufferStart );
+        pxCBOR_free( *ppxHandle );
+    }
+
     *ppxHandle = NULL;
 }
 
@@ -104,8 +151,14 @@ bool CBOR_FindKey( CBORHandle_t xCborData,
     }
 
     ( xCborData->pxCursor ) = ( xCborData->pxBufferStart );
-    CBOR_OpenMap( xCborData );
-    CBOR_SearchForKey( xCborData, pcKey );
+#if ( CBOR_KEY_INDEX_SIZE > 0 )
+    if( !CBOR_IndexedSearchForKey( xCborData, pcKey ) )
+#endif
+    {
+        CBOR_OpenMap( xCborData );
+        CBOR_SearchForKey( xCborData, pcKey );
+    }
+
     bool xFound = false;
 
     if( CBOR_KeyIsMatch( xCborData, pcKey ) )
@@ -326,12 +379,73 @@ void CBOR_AppendMap( CBORHandle_t xDest,
                      CBORHandle_t xSrc )
 {
     xSrc->pxCursor = xSrc->pxBufferStart + 1;
-    cbor_ssize_t xLength = xSrc->pxBufferEnd - xSrc->pxCursor;
+    /* Pairs and closing break of the source, not its unused space */
+    cbor_ssize_t xLength = xSrc->pxMapEnd - xSrc->pxCursor + 1;
     xDest->pxCursor = xDest->pxMapEnd;
     CBOR_MemCopy( xDest, xSrc->pxCursor, xLength );
     xDest->pxMapEnd = xDest->pxCursor - 1;
 }
 
+cbor_ssize_t CBOR_StringEncodedSize( const char * pcStr )
+{
+    if( NULL == pcStr )
+    {
+        return 0;
+    }
+
+    cbor_ssize_t xLength = strlen( pcStr );
+    cbor_ssize_t xSize = 0;
+
+    /* Mirrors CBOR_WriteString */
+    if( CBOR_IsSmallInt( xLength ) )
+    {
+        xSize = CBOR_SMALL_INT_SIZE + xLength;
+    }
+    else if( CBOR_Is8BitInt( xLength ) )
+    {
+        xSize = CBOR_INT8_SIZE + xLength;
+    }
+    else if( CBOR_Is16BitInt( xLength ) )
+    {
+        xSize = CBOR_INT16_SIZE + xLength;
+    }
+
+    return xSize;
+}
+
+cbor_ssize_t CBOR_IntEncodedSize( cbor_int_t xValue )
+{
+    cbor_ssize_t xSize = 0;
+
+#if ( CBOR_USE_TINYCBOR == 1 )
+    /* A negative integer is encoded as its magnitude less one */
+    if( 0 > xValue )
+    {
+        xValue = -1 - xValue;
+    }
+#endif
+
+    /* Mirrors CBOR_WriteInt */
+    if( CBOR_IsSmallInt( xValue ) )
+    {
+        xSize = CBOR_SMALL_INT_SIZE;
+    }
+    else if( CBOR_Is8BitInt( xValue ) )
+    {
+        xSize = CBOR_INT8_SIZE;
+    }
+    else if( CBOR_Is16BitInt( xValue ) )
+    {
+        xSize = CBOR_INT16_SIZE;
+    }
+    else if( CBOR_Is32BitInt( xValue ) )
+    {
+        xSize = CBOR_INT32_SIZE;
+    }
+
+    return xSize;
+}
+
 cborError_t CBOR_CheckError( CBORHandle_t xCborData )
 {
     if( NULL == xCborData )
@@ -123,6 +123,72 @@ void CBOR_ClearError( CBORHandle_t /*xCborData*/ );
  */
 CBORHandle_t CBOR_New( cbor_ssize_t /*size*/ );
 
+/**
+ * @brief Initializes a CBOR data structure in a caller provided buffer.
+ *
+ * The handle is placed at the front of the buffer and the rest holds the CBOR
+ * data, initialized with an empty map.  The buffer is never grown: a write
+ * that does not fit sets eCborErrInsufficentSpace.  Building a document then
+ * needs no allocation at all.  CBOR_Delete only clears the handle pointer; the
+ * buffer can be reused once the handle is no longer needed.
+ *
+ * @code
+ * static cbor_byte_t xReportBuffer[ 512 ];
+ * CBORHandle_t xReport = CBOR_NewStatic( xReportBuffer, sizeof( xReportBuffer ) );
+ * @endcode
+ *
+ * @param  buffer buffer owned by the caller
+ * @param  size   size of the buffer in bytes
+ * @return A pointer to the AWS CBOR data structure
+ * @return Returns NULL if the buffer cannot hold the handle and an empty map
+ *
+ * @see CBOR_STATIC_OVERHEAD
+ */
+CBORHandle_t CBOR_NewStatic( cbor_byte_t * /*buffer*/, cbor_ssize_t /*size*/ );
+
+/**
+ * @brief Bytes of a CBOR_NewStatic buffer that are not available for data.
+ *
+ * Includes the worst case padding to align the handle.
+ */
+#define CBOR_STATIC_OVERHEAD    ( ( cbor_ssize_t ) ( CBOR_HandleSize() + sizeof( void * ) - 1 ) )
+
+/**
+ * @brief Gets the size of the CBOR data structure placed by CBOR_NewStatic.
+ * @return size of the handle in bytes
+ */
+cbor_ssize_t CBOR_HandleSize( void );
+
+/**
+ * @brief Makes sure the CBOR buffer can hold the given number of bytes.
+ *
+ * Grows the buffer at most once, to exactly the requested size.  Writing a
+ * document whose size was computed beforehand, e.g. with
+ * CBOR_StringEncodedSize and CBOR_IntEncodedSize, then needs no further
+ * reallocation.  Sets eCborErrInsufficentSpace if the buffer cannot grow.
+ *
+ * @param CBORHandle_t Handle for the CBOR data struct.
+ * @param size         total size in bytes the buffer must hold
+ */
+void CBOR_Reserve( CBORHandle_t /*xCborData*/, cbor_ssize_t /*size*/ );
+
+/** @brief Size in bytes of an empty map */
+#define CBOR_EMPTY_MAP_SIZE    ( 2 )
+
+/**
+ * @brief Gets the encoded size of a string @glos{key} or @glos{value}
+ * @param  cbor_const_string_t zero terminated string
+ * @return cbor_ssize_t        size in bytes, or 0 if it cannot be encoded
+ */
+cbor_ssize_t CBOR_StringEncodedSize( cbor_const_string_t /*str*/ );
+
+/**
+ * @brief Gets the encoded size of an integer @glos{value}
+ * @param  cbor_int_t   integer
+ * @return cbor_ssize_t size in bytes
+ */
+cbor_ssize_t CBOR_IntEncodedSize( cbor_int_t /*value*/ );
+
 /**
  * @brief Frees memory allocated by CBOR_New(0)
  * Frees memory previosuly allocated and nulls out the CBORHandle_t pointer
@@ -28,6 +28,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#if ( CBOR_USE_TINYCBOR == 1 )
+    #include "cbor.h"
+#endif
+
 /**
  * @brief reads the specified byte from the number
  *
@@ -50,6 +54,30 @@ void CBOR_WriteInt( CBORHandle_t xCborData,
 
     cbor_int_t xNum = *( cbor_int_t * ) pvInput;
 
+#if ( CBOR_USE_TINYCBOR == 1 )
+    cbor_ssize_t xSize = CBOR_IntEncodedSize( xNum );
+    CborEncoder xEncoder;
+
+    CBOR_ValueResize( xCborData, xSize );
+
+    if( !CBOR_MakeRoom( xCborData, xSize ) )
+    {
+        return;
+    }
+
+    cbor_encoder_init( &xEncoder, xCborData->pxCursor, xSize, 0 );
+
+    if( CborNoError != cbor_encode_int( &xEncoder, xNum ) )
+    {
+        xCborData->xError = eCborErrUnsupportedWriteOperation;
+
+        return;
+    }
+
+    xCborData->pxCursor += xSize;
+    xCborData->xError = eCborErrNoError;
+    CBOR_InvalidateKeyIndex( xCborData );
+#else
     if( CBOR_IsSmallInt( xNum ) )
     {
         CBOR_ValueResize( xCborData, CBOR_SMALL_INT_SIZE );
@@ -70,6 +98,7 @@ void CBOR_WriteInt( CBORHandle_t xCborData,
         CBOR_ValueResize( xCborData, CBOR_INT32_SIZE );
         CBOR_WriteInt32( xCborData, ( uint32_t ) xNum );
     }
+#endif /* if ( CBOR_USE_TINYCBOR == 1 ) */
 }
 
 cbor_ssize_t CBOR_IntSize( const cbor_byte_t * pxPtr )
@@ -161,6 +190,26 @@ cbor_int_t CBOR_ReadInt( CBORHandle_t xCborData )
     }
 
     cbor_int_t xNum = 0;
+
+#if ( CBOR_USE_TINYCBOR == 1 )
+    CborParser xParser;
+    CborValue xValue;
+    uint64_t ullNum = 0;
+
+    if( ( CborNoError != cbor_parser_init( xCborData->pxCursor,
+                                           xCborData->pxBufferEnd - xCborData->pxCursor + 1,
+                                           0, &xParser, &xValue ) ) ||
+        !cbor_value_is_integer( &xValue ) )
+    {
+        xCborData->xError = eCborErrReadTypeMismatch;
+
+        return 0;
+    }
+
+    /* Like the fixed width readers, hand back the encoded magnitude */
+    ( void ) cbor_value_get_raw_integer( &xValue, &ullNum );
+    xNum = ( cbor_int_t ) ullNum;
+#else
     cbor_byte_t xAdditional_detail = xDataHead & CBOR_ADDITIONAL_DATA_MASK;
 
     switch( xAdditional_detail )
@@ -181,6 +230,7 @@ cbor_int_t CBOR_ReadInt( CBORHandle_t xCborData )
             xNum = xAdditional_detail;
             break;
     }
+#endif /* if ( CBOR_USE_TINYCBOR == 1 ) */
 
     return xNum;
 }
@@ -24,6 +24,7 @@
  */
 #include "aws_cbor_internals.h"
 #include <assert.h>
+#include <string.h>
 
 void CBOR_OpenMap( CBORHandle_t xCborData )
 {
@@ -69,6 +70,150 @@ void CBOR_SearchForKey( CBORHandle_t xCborData,
         CBOR_NextKey( xCborData );
     }
 }
+#if ( CBOR_KEY_INDEX_SIZE > 0 )
+
+/**
+ * @brief FNV-1a hash of a key
+ */
+static uint32_t CBOR_KeyHash( const cbor_byte_t * pxKey,
+                              cbor_ssize_t xLength )
+{
+    uint32_t ulHash = 2166136261UL;
+
+    for( cbor_ssize_t xI = 0; xI < xLength; xI++ )
+    {
+        ulHash ^= pxKey[ xI ];
+        ulHash *= 16777619UL;
+    }
+
+    return ulHash;
+}
+
+/**
+ * @brief Gets the hash of the key string at the pointer
+ */
+static uint32_t CBOR_KeyHashAtPtr( const cbor_byte_t * pxPtr )
+{
+    cbor_ssize_t xSize = CBOR_StringSize( pxPtr );
+    cbor_byte_t xAdditional_detail = *pxPtr & CBOR_ADDITIONAL_DATA_MASK;
+    cbor_ssize_t xHead_size = CBOR_SMALL_INT_SIZE;
+
+    if( CBOR_INT8_FOLLOWS == xAdditional_detail )
+    {
+        xHead_size = CBOR_INT8_SIZE;
+    }
+    else if( CBOR_INT16_FOLLOWS == xAdditional_detail )
+    {
+        xHead_size = CBOR_INT16_SIZE;
+    }
+
+    return CBOR_KeyHash( pxPtr + xHead_size, xSize - xHead_size );
+}
+
+/**
+ * @brief Records the offset of every top level key in one walk of the map
+ *
+ * Only the first of duplicate keys is recorded, as CBOR_SearchForKey would
+ * find it first.
+ */
+static void CBOR_BuildKeyIndex( CBORHandle_t xCborData )
+{
+    assert( NULL != xCborData );
+
+    cbor_byte_t * pxSaved_cursor = xCborData->pxCursor;
+    cbor_byte_t * pxPtr = xCborData->pxBufferStart;
+    cbor_ssize_t xKeys = 0;
+
+    memset( xCborData->xKeyIndex, 0, sizeof( xCborData->xKeyIndex ) );
+    xCborData->xKeyIndexState = CBOR_KEY_INDEX_READY;
+
+    if( CBOR_MAP_OPEN != *pxPtr )
+    {
+        xCborData->xKeyIndexState = CBOR_KEY_INDEX_UNUSABLE;
+    }
+    else
+    {
+        pxPtr++;
+    }
+
+    while( ( CBOR_KEY_INDEX_READY == xCborData->xKeyIndexState ) &&
+           ( CBOR_BREAK != *pxPtr ) )
+    {
+        /* Keep a free slot, so that a failed lookup ends its probe */
+        if( ( CBOR_STRING != ( *pxPtr & CBOR_MAJOR_TYPE_MASK ) ) ||
+            ( CBOR_KEY_INDEX_SIZE - 1 <= xKeys ) )
+        {
+            xCborData->xKeyIndexState = CBOR_KEY_INDEX_UNUSABLE;
+            break;
+        }
+
+        cbor_ssize_t xSlot = CBOR_KeyHashAtPtr( pxPtr ) % CBOR_KEY_INDEX_SIZE;
+        bool xDuplicate = false;
+
+        while( !xDuplicate && ( 0 != xCborData->xKeyIndex[ xSlot ] ) )
+        {
+            const cbor_byte_t * pxOther = xCborData->pxBufferStart + xCborData->xKeyIndex[ xSlot ];
+            cbor_ssize_t xSize = CBOR_StringSize( pxPtr );
+
+            xDuplicate = ( xSize == CBOR_StringSize( pxOther ) ) &&
+                         ( 0 == memcmp( pxPtr, pxOther, xSize ) );
+            xSlot = ( xSlot + 1 ) % CBOR_KEY_INDEX_SIZE;
+        }
+
+        if( !xDuplicate )
+        {
+            xCborData->xKeyIndex[ xSlot ] = pxPtr - xCborData->pxBufferStart;
+            xKeys++;
+        }
+
+        pxPtr = CBOR_NextKeyPtr( pxPtr );
+    }
+
+    xCborData->pxCursor = pxSaved_cursor;
+}
+
+bool CBOR_IndexedSearchForKey( CBORHandle_t xCborData,
+                               const char * pcKey )
+{
+    assert( NULL != xCborData );
+    assert( NULL != pcKey );
+
+    if( CBOR_KEY_INDEX_STALE == xCborData->xKeyIndexState )
+    {
+        CBOR_BuildKeyIndex( xCborData );
+    }
+
+    if( CBOR_KEY_INDEX_READY != xCborData->xKeyIndexState )
+    {
+        return false;
+    }
+
+    cbor_ssize_t xSlot = CBOR_KeyHash( ( const cbor_byte_t * ) pcKey, strlen( pcKey ) ) %
+                         CBOR_KEY_INDEX_SIZE;
+
+    /* Not found: leave the cursor where CBOR_SearchForKey would */
+    xCborData->pxCursor = xCborData->pxMapEnd;
+
+    while( 0 != xCborData->xKeyIndex[ xSlot ] )
+    {
+        cbor_byte_t * pxKey = xCborData->pxBufferStart + xCborData->xKeyIndex[ xSlot ];
+
+        xCborData->pxCursor = pxKey;
+
+        if( CBOR_KeyIsMatch( xCborData, pcKey ) )
+        {
+            break;
+        }
+
+        xCborData->pxCursor = xCborData->pxMapEnd;
+        xSlot = ( xSlot + 1 ) % CBOR_KEY_INDEX_SIZE;
+    }
+
+    return true;
+}
+
+#endif /* if ( CBOR_KEY_INDEX_SIZE > 0 ) */
+
 void CBOR_AppendKey( CBORHandle_t xCborData,
                      const char * pcKey,
                      write_function_t xWriteFunction,
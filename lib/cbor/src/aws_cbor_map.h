@@ -31,6 +31,7 @@
  */
 
 #include "aws_cbor.h"
+#include "aws_cbor_types.h"
 #include <stdint.h>
 
 /**
@@ -61,6 +62,28 @@ bool CBOR_KeyIsMatch( CBORHandle_t /*xCborData*/, const char * /*key*/ );
  */
 void CBOR_SearchForKey( CBORHandle_t /*xCborData*/, const char * /*key*/ );
 
+#if ( CBOR_KEY_INDEX_SIZE > 0 )
+
+/**
+ * @brief Searches for a top level key using the key index of the handle
+ *
+ * Builds the index first if the buffer changed since it was last built.  On
+ * success, the cursor points at the key, or at the break closing the map when
+ * the key is not in it.
+ *
+ * @param CBORHandle_t Handle for the CBOR data struct.
+ * @param "const char *" Key to search for
+ * @return false if the map cannot be indexed and must be searched linearly
+ */
+    bool CBOR_IndexedSearchForKey( CBORHandle_t /*xCborData*/, const char * /*key*/ );
+
+/** @brief Marks the key index stale after a write to the buffer */
+    #define CBOR_InvalidateKeyIndex( xCborData ) \
+    ( ( xCborData )->xKeyIndexState = CBOR_KEY_INDEX_STALE )
+#else
+    #define CBOR_InvalidateKeyIndex( xCborData )
+#endif
+
 /**
  * @brief Appends a key-value pair to a map
  * @warning CBOR_AppendKey() does not check for duplication
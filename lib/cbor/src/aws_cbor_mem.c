@@ -51,21 +51,66 @@
     ( ( xCborData )->pxBufferEnd - ( xCborData )->pxBufferStart + 1 )
 
 /**
- * @brief Doubles the size of the CBOR buffer
+ * @brief Moves the CBOR buffer to a new allocation of the given size
  *
- * Reallocates the CBOR buffer with double the size of the current buffer size.
- * Sets err if unable to reallocate the space.
+ * CBOR_ReallocImpl has to work out the old size from the new one, which only
+ * holds for 1.5x growth, so with it the old buffer is copied here instead.
+ * Returns NULL if unable to allocate the space.
  */
-static void CBOR_Reallocate( CBORHandle_t xCborData )
+static cbor_byte_t * CBOR_Grow( CBORHandle_t xCborData,
+                                cbor_ssize_t xNewSize )
 {
     assert( NULL != xCborData );
 
-    /* Multiply by 1.5, more efficient on some compilers than just doing *1.5 */
-    /* https://github.com/facebook/folly/blob/master/folly/docs/FBVector.md */
-    cbor_ssize_t xNewSize = BufferSize( xCborData ) * 3;
-    xNewSize /= 2;
+    cbor_byte_t * pxNew_start = NULL;
 
-    cbor_byte_t * pxNew_start = pxCBOR_realloc( xCborData->pxBufferStart, xNewSize );
+    if( CBOR_ReallocImpl == pxCBOR_realloc )
+    {
+        pxNew_start = pxCBOR_malloc( xNewSize );
+
+        if( NULL != pxNew_start )
+        {
+            memcpy( pxNew_start, xCborData->pxBufferStart, BufferSize( xCborData ) );
+            pxCBOR_free( xCborData->pxBufferStart );
+        }
+    }
+    else
+    {
+        pxNew_start = pxCBOR_realloc( xCborData->pxBufferStart, xNewSize );
+    }
+
+    return pxNew_start;
+}
+
+/**
+ * @brief Calculates 1.5 times the size of the CBOR buffer
+ *
+ * Multiply by 1.5, more efficient on some compilers than just doing *1.5
+ * https://github.com/facebook/folly/blob/master/folly/docs/FBVector.md
+ */
+#define GrownBufferSize( xCborData ) \
+    ( BufferSize( ( xCborData ) ) * 3 / 2 )
+
+/**
+ * @brief Resizes the CBOR buffer
+ *
+ * Reallocates the CBOR buffer with the given size.  Sets err if unable to
+ * reallocate the space, or if the buffer belongs to the caller.
+ */
+static void CBOR_Reallocate( CBORHandle_t xCborData,
+                             cbor_ssize_t xNewSize )
+{
+    assert( NULL != xCborData );
+
+    if( xCborData->xStaticBuffer )
+    {
+        xCborData->xError = eCborErrInsufficentSpace;
+
+        return;
+    }
+
+    cbor_ssize_t xMapEnd_index = xCborData->pxMapEnd - xCborData->pxBufferStart;
+    cbor_byte_t * pxNew_start = CBOR_Grow( xCborData, xNewSize );
 
     if( NULL == pxNew_start )
     {
@@ -79,6 +124,7 @@ static void CBOR_Reallocate( CBORHandle_t xCborData )
     xCborData->pxBufferStart = pxNew_start;
     xCborData->pxBufferEnd = xCborData->pxBufferStart + xNewSize - 1;
     xCborData->pxCursor = xCborData->pxBufferStart + xCursor_index;
+    xCborData->pxMapEnd = xCborData->pxBufferStart + xMapEnd_index;
 }
 
 /**
@@ -143,7 +189,7 @@ void CBOR_AssignAndIncrementCursor( CBORHandle_t xCborData,
 
     while( OverflowOccured( xCborData ) )
     {
-        CBOR_Reallocate( xCborData );
+        CBOR_Reallocate( xCborData, GrownBufferSize( xCborData ) );
 
         if( eCborErrNoError != xCborData->xError )
         {
@@ -153,6 +199,7 @@ void CBOR_AssignAndIncrementCursor( CBORHandle_t xCborData,
 
     *( xCborData->pxCursor )++ = xInput;
     ( xCborData->xError ) = eCborErrNoError;
+    CBOR_InvalidateKeyIndex( xCborData );
 }
 
 void CBOR_AssignAndDecrementCursor( CBORHandle_t xCborData,
@@ -163,7 +210,7 @@ void CBOR_AssignAndDecrementCursor( CBORHandle_t xCborData,
 
     while( OverflowOccured( xCborData ) )
     {
-        CBOR_Reallocate( xCborData );
+        CBOR_Reallocate( xCborData, GrownBufferSize( xCborData ) );
 
         if( eCborErrNoError != xCborData->xError )
         {
@@ -173,6 +220,35 @@ void CBOR_AssignAndDecrementCursor( CBORHandle_t xCborData,
 
     *( xCborData->pxCursor )-- = xInput;
     ( xCborData->xError ) = eCborErrNoError;
+    CBOR_InvalidateKeyIndex( xCborData );
+}
+
+bool CBOR_MakeRoom( CBORHandle_t xCborData,
+                    cbor_ssize_t xLength )
+{
+    assert( NULL != xCborData );
+    assert( 0 <= xLength );
+
+    /* Grow once for the whole write rather than byte by byte */
+    cbor_ssize_t xRequired = xCborData->pxCursor - xCborData->pxBufferStart + xLength;
+
+    if( xRequired > BufferSize( xCborData ) )
+    {
+        CBOR_Reallocate( xCborData,
+                         xRequired > GrownBufferSize( xCborData ) ?
+                         xRequired : GrownBufferSize( xCborData ) );
+
+        if( eCborErrNoError != xCborData->xError )
+        {
+            /* Leave the cursor past the end, as a byte by byte copy would,
+             * so that the writes that follow fail too */
+            xCborData->pxCursor = xCborData->pxBufferEnd + 1;
+
+            return false;
+        }
+    }
+
+    return true;
 }
 
 void CBOR_MemCopy( CBORHandle_t xCborData,
@@ -184,6 +260,19 @@ void CBOR_MemCopy( CBORHandle_t xCborData,
     assert( 0 <= xLength );
 
     const cbor_byte_t * pxSource = pvInput;
+    bool xSourceInBuffer = ( pxSource >= xCborData->pxBufferStart ) &&
+                           ( pxSource <= xCborData->pxBufferEnd );
+    cbor_ssize_t xSource_index = pxSource - xCborData->pxBufferStart;
+
+    if( !CBOR_MakeRoom( xCborData, xLength ) )
+    {
+        return;
+    }
+
+    if( xSourceInBuffer )
+    {
+        pxSource = xCborData->pxBufferStart + xSource_index;
+    }
 
     if( xCborData->pxCursor < pxSource )
     {
@@ -201,6 +290,20 @@ void CBOR_MemCopy( CBORHandle_t xCborData,
     }
 }
 
+void CBOR_Reserve( CBORHandle_t xCborData,
+                   cbor_ssize_t xSize )
+{
+    if( NULL == xCborData )
+    {
+        return;
+    }
+
+    if( xSize > BufferSize( xCborData ) )
+    {
+        CBOR_Reallocate( xCborData, xSize );
+    }
+}
+
 cbor_ssize_t xCborDataItemSize( CBORHandle_t xCborData )
 {
     assert( NULL != xCborData );
@@ -256,5 +359,7 @@ void CBOR_ValueResize( CBORHandle_t xCborData,
     xCborData->pxCursor = pxKey_position;
     CBOR_MemCopy( xCborData, pxNext_key, xRemaining_length );
     assert( eCborErrNoError == xCborData->xError );
-    xCborData->pxCursor = pxCurrent_place;
+    /* The copy may have moved the buffer, and the map end moved with the value */
+    xCborData->pxMapEnd = xCborData->pxCursor - 1;
+    xCborData->pxCursor = xCborData->pxCursor - xRemaining_length - xNewSize;
 }
@@ -65,6 +65,18 @@ void CBOR_AssignAndDecrementCursor(
 void CBOR_MemCopy( CBORHandle_t /*xCborData*/, const void * /*input*/,
                    cbor_ssize_t /*length*/ );
 
+/**
+ * @brief Grows the buffer so that length bytes fit at the cursor.
+ *
+ * On failure the error is set and the cursor is left past the end of the
+ * buffer, as a failed CBOR_MemCopy leaves it.
+ *
+ * @param  CBORHandle_t Handle for the CBOR data struct.
+ * @param  cbor_ssize_t Number of bytes that will be written at the cursor.
+ * @return bool         true if the bytes fit.
+ */
+bool CBOR_MakeRoom( CBORHandle_t /*xCborData*/, cbor_ssize_t /*length*/ );
+
 /**
  * @brief Gets size of the CBOR data item that the cursor points to.
  *
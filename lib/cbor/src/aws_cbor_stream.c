@@ -0,0 +1,250 @@
+/*
+ * Amazon FreeRTOS CBOR Library V1.0.2
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include "aws_cbor_internals.h"
+#include "aws_cbor_stream.h"
+#include <assert.h>
+#include <string.h>
+
+/** @brief Additional information of an 8 byte argument */
+#define CBOR_INT64_FOLLOWS          ( 0x1B )
+
+/** @brief Major type 7 additional information of a break */
+#define CBOR_STREAM_BREAK_DETAIL    ( 0x1F )
+
+/**
+ * @brief Gets the size of the head that starts with the given byte
+ * @return Size in bytes, or 0 if the additional information is reserved
+ */
+static cbor_ssize_t CBOR_StreamHeadSize( cbor_byte_t xInitialByte )
+{
+    cbor_byte_t xAdditional_detail = xInitialByte & CBOR_ADDITIONAL_DATA_MASK;
+    cbor_ssize_t xSize = 0;
+
+    if( CBOR_IsSmallInt( xAdditional_detail ) ||
+        ( CBOR_INDEFINITE_LENGTH == xAdditional_detail ) )
+    {
+        xSize = 1;
+    }
+    else if( CBOR_INT8_FOLLOWS == xAdditional_detail )
+    {
+        xSize = 2;
+    }
+    else if( CBOR_INT16_FOLLOWS == xAdditional_detail )
+    {
+        xSize = 3;
+    }
+    else if( CBOR_INT32_FOLLOWS == xAdditional_detail )
+    {
+        xSize = 5;
+    }
+    else if( CBOR_INT64_FOLLOWS == xAdditional_detail )
+    {
+        xSize = 9;
+    }
+
+    return xSize;
+}
+
+/**
+ * @brief Yields the next chunk of the string being decoded
+ */
+static cborStreamStatus_t CBOR_StreamNextChunk( CBORStreamDecoder_t * pxDecoder,
+                                                CBORStreamItem_t * pxItem )
+{
+    uint64_t ullRemaining = pxDecoder->ullStringLength - pxDecoder->ullStringOffset;
+    cbor_ssize_t xAvailable = pxDecoder->xFragmentLength - pxDecoder->xFragmentOffset;
+
+    if( ( 0 == xAvailable ) && ( 0 != ullRemaining ) )
+    {
+        return eCborStreamNeedMoreData;
+    }
+
+    cbor_ssize_t xChunk_length = ( ( uint64_t ) xAvailable < ullRemaining ) ?
+                                 xAvailable : ( cbor_ssize_t ) ullRemaining;
+
+    pxItem->xType = pxDecoder->xStringType;
+    pxItem->ullValue = pxDecoder->ullStringLength;
+    pxItem->pxChunk = pxDecoder->pxFragment + pxDecoder->xFragmentOffset;
+    pxItem->xChunkLength = xChunk_length;
+    pxItem->ullChunkOffset = pxDecoder->ullStringOffset;
+
+    pxDecoder->xFragmentOffset += xChunk_length;
+    pxDecoder->ullStringOffset += xChunk_length;
+    pxDecoder->xInString = pxDecoder->ullStringOffset < pxDecoder->ullStringLength;
+    pxItem->xLastChunk = !pxDecoder->xInString;
+
+    return eCborStreamItemReady;
+}
+
+void CBOR_StreamInit( CBORStreamDecoder_t * pxDecoder )
+{
+    assert( NULL != pxDecoder );
+
+    memset( pxDecoder, 0, sizeof( *pxDecoder ) );
+}
+
+void CBOR_StreamFeed( CBORStreamDecoder_t * pxDecoder,
+                      const cbor_byte_t * pxFragment,
+                      cbor_ssize_t xLength )
+{
+    assert( NULL != pxDecoder );
+    assert( ( NULL != pxFragment ) || ( 0 == xLength ) );
+    assert( 0 <= xLength );
+    assert( pxDecoder->xFragmentOffset == pxDecoder->xFragmentLength );
+
+    pxDecoder->pxFragment = pxFragment;
+    pxDecoder->xFragmentLength = xLength;
+    pxDecoder->xFragmentOffset = 0;
+}
+
+cborStreamStatus_t CBOR_StreamNext( CBORStreamDecoder_t * pxDecoder,
+                                    CBORStreamItem_t * pxItem )
+{
+    assert( NULL != pxDecoder );
+    assert( NULL != pxItem );
+
+    if( pxDecoder->xInString )
+    {
+        return CBOR_StreamNextChunk( pxDecoder, pxItem );
+    }
+
+    /* Gather the head, which may continue from the previous fragment */
+    if( 0 == pxDecoder->xHeadLength )
+    {
+        if( pxDecoder->xFragmentOffset == pxDecoder->xFragmentLength )
+        {
+            return eCborStreamNeedMoreData;
+        }
+
+        pxDecoder->xHead[ pxDecoder->xHeadLength++ ] =
+            pxDecoder->pxFragment[ pxDecoder->xFragmentOffset++ ];
+    }
+
+    cbor_ssize_t xHead_size = CBOR_StreamHeadSize( pxDecoder->xHead[ 0 ] );
+
+    if( 0 == xHead_size )
+    {
+        return eCborStreamMalformed;
+    }
+
+    while( pxDecoder->xHeadLength < xHead_size )
+    {
+        if( pxDecoder->xFragmentOffset == pxDecoder->xFragmentLength )
+        {
+            return eCborStreamNeedMoreData;
+        }
+
+        pxDecoder->xHead[ pxDecoder->xHeadLength++ ] =
+            pxDecoder->pxFragment[ pxDecoder->xFragmentOffset++ ];
+    }
+
+    pxDecoder->xHeadLength = 0;
+
+    cbor_byte_t xMajor_type = pxDecoder->xHead[ 0 ] & CBOR_MAJOR_TYPE_MASK;
+    cbor_byte_t xAdditional_detail = pxDecoder->xHead[ 0 ] & CBOR_ADDITIONAL_DATA_MASK;
+    uint64_t ullArgument = xAdditional_detail;
+
+    if( 1 < xHead_size )
+    {
+        ullArgument = 0;
+
+        for( cbor_ssize_t xI = 1; xI < xHead_size; xI++ )
+        {
+            ullArgument = ( ullArgument << CBOR_BYTE_WIDTH ) | pxDecoder->xHead[ xI ];
+        }
+    }
+    else if( CBOR_INDEFINITE_LENGTH == xAdditional_detail )
+    {
+        ullArgument = CBOR_STREAM_INDEFINITE_LENGTH;
+    }
+
+    memset( pxItem, 0, sizeof( *pxItem ) );
+    pxItem->ullValue = ullArgument;
+
+    cborStreamStatus_t xStatus = eCborStreamItemReady;
+    bool xIndefinite = CBOR_STREAM_INDEFINITE_LENGTH == ullArgument;
+
+    switch( xMajor_type )
+    {
+        case CBOR_POS_INT:
+        case CBOR_NEG_INT:
+        case CBOR_TAG:
+
+            if( xIndefinite )
+            {
+                xStatus = eCborStreamMalformed;
+            }
+
+            pxItem->xType = ( CBOR_POS_INT == xMajor_type ) ? eCborStreamUnsignedInt :
+                            ( CBOR_NEG_INT == xMajor_type ) ? eCborStreamNegativeInt :
+                            eCborStreamTag;
+            break;
+
+        case CBOR_BYTE_STRING:
+        case CBOR_STRING:
+
+            if( xIndefinite )
+            {
+                xStatus = eCborStreamUnsupported;
+            }
+            else
+            {
+                pxDecoder->xStringType = ( CBOR_STRING == xMajor_type ) ?
+                                         eCborStreamTextString : eCborStreamByteString;
+                pxDecoder->ullStringLength = ullArgument;
+                pxDecoder->ullStringOffset = 0;
+                pxDecoder->xInString = true;
+                /* An empty string is complete without more data */
+                xStatus = CBOR_StreamNextChunk( pxDecoder, pxItem );
+            }
+
+            break;
+
+        case CBOR_ARRAY:
+            pxItem->xType = eCborStreamArray;
+            break;
+
+        case CBOR_MAP:
+            pxItem->xType = eCborStreamMap;
+            break;
+
+        default:
+            /* Simple values, floats and break */
+            if( CBOR_STREAM_BREAK_DETAIL == xAdditional_detail )
+            {
+                pxItem->xType = eCborStreamBreak;
+                pxItem->ullValue = 0;
+            }
+            else
+            {
+                pxItem->xType = eCborStreamSimple;
+            }
+
+            break;
+    }
+
+    return xStatus;
+}
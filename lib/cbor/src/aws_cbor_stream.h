@@ -0,0 +1,182 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+#ifndef AWS_CBOR_STREAM_H /* Guards against multiple inclusion */
+#define AWS_CBOR_STREAM_H
+
+/**
+ * @file
+ * @brief Pull decoder for CBOR documents split across fragments
+ *
+ * The decoder is fed one fragment at a time, e.g. an MQTT buffer or a TLS
+ * record, and yields each data item as soon as its head is complete.  String
+ * contents are yielded as chunks that point into the fragment, so they can be
+ * passed straight to their destination without being staged in a buffer for
+ * the whole document.  Item heads split between fragments are reassembled in
+ * the decoder.  Nothing is allocated.
+ *
+ * @code
+ * CBORStreamDecoder_t xDecoder;
+ * CBORStreamItem_t xItem;
+ *
+ * CBOR_StreamInit( &xDecoder );
+ * CBOR_StreamFeed( &xDecoder, pucFirstFragment, xFirstLength );
+ *
+ * while( eCborStreamItemReady == CBOR_StreamNext( &xDecoder, &xItem ) )
+ * {
+ *     ...
+ * }
+ *
+ * CBOR_StreamFeed( &xDecoder, pucNextFragment, xNextLength );
+ * ...
+ * @endcode
+ */
+
+#include "aws_cbor.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Value of CBORStreamItem_t::ullValue for indefinite length items */
+#define CBOR_STREAM_INDEFINITE_LENGTH    ( UINT64_MAX )
+
+/**
+ * @brief Result of CBOR_StreamNext
+ */
+typedef enum
+{
+    /** An item was decoded */
+    eCborStreamItemReady = 0,
+
+    /** The fragment is used up; feed the next one */
+    eCborStreamNeedMoreData,
+
+    /** The data is not valid CBOR */
+    eCborStreamMalformed,
+
+    /** Valid CBOR that the decoder does not support, e.g. an indefinite
+     * length string */
+    eCborStreamUnsupported,
+} cborStreamStatus_t;
+
+/**
+ * @brief Types of the items yielded by CBOR_StreamNext
+ */
+typedef enum
+{
+    eCborStreamUnsignedInt = 0,
+    eCborStreamNegativeInt,
+    eCborStreamByteString,
+    eCborStreamTextString,
+    eCborStreamArray,
+    eCborStreamMap,
+    eCborStreamTag,
+    eCborStreamSimple,
+    eCborStreamBreak,
+} cborStreamItemType_t;
+
+/**
+ * @brief A decoded item
+ *
+ * A string is yielded as one or more chunks, each with the same type and
+ * length.  An empty string is yielded as a single empty chunk.
+ */
+typedef struct CBORStreamItem_s
+{
+    /** Type of the item */
+    cborStreamItemType_t xType;
+
+    /**
+     * Argument of the item: the value of an integer (-1 - value for a
+     * negative integer), the length of a string, the number of items of an
+     * array or pairs of a map (CBOR_STREAM_INDEFINITE_LENGTH when unknown),
+     * the number of a tag, or the simple value. */
+    uint64_t ullValue;
+
+    /** Chunk of string data, pointing into the fragment */
+    const cbor_byte_t * pxChunk;
+    /** Length of the chunk */
+    cbor_ssize_t xChunkLength;
+    /** Offset of the chunk in the string */
+    uint64_t ullChunkOffset;
+    /** True for the last chunk of the string */
+    bool xLastChunk;
+} CBORStreamItem_t;
+
+/**
+ * @brief State of a streaming decode
+ * @note Treat as opaque.
+ */
+typedef struct CBORStreamDecoder_s
+{
+    /** Fragment being decoded */
+    const cbor_byte_t * pxFragment;
+    /** Length of the fragment */
+    cbor_ssize_t xFragmentLength;
+    /** Bytes of the fragment already decoded */
+    cbor_ssize_t xFragmentOffset;
+    /** Head of the item being decoded, when it spans fragments */
+    cbor_byte_t xHead[ 9 ];
+    /** Bytes of xHead received so far */
+    cbor_ssize_t xHeadLength;
+    /** Type of the string whose data is being yielded */
+    cborStreamItemType_t xStringType;
+    /** Length of that string */
+    uint64_t ullStringLength;
+    /** Bytes of that string yielded so far */
+    uint64_t ullStringOffset;
+    /** True while the data of a string is being yielded */
+    bool xInString;
+} CBORStreamDecoder_t;
+
+/**
+ * @brief Initializes a decoder before the first fragment of a document
+ * @param "CBORStreamDecoder_t *" decoder to initialize
+ */
+void CBOR_StreamInit( CBORStreamDecoder_t * /*pxDecoder*/ );
+
+/**
+ * @brief Gives the decoder the next fragment of the document
+ *
+ * @pre CBOR_StreamNext returned eCborStreamNeedMoreData for the previous
+ * fragment, if any.  The fragment must stay valid until then, as the string
+ * chunks yielded point into it.
+ *
+ * @param "CBORStreamDecoder_t *" decoder
+ * @param "const cbor_byte_t *"   fragment
+ * @param cbor_ssize_t            length of the fragment in bytes
+ */
+void CBOR_StreamFeed( CBORStreamDecoder_t * /*pxDecoder*/,
+                      const cbor_byte_t * /*fragment*/, cbor_ssize_t /*length*/ );
+
+/**
+ * @brief Decodes the next item, or the next chunk of a string
+ *
+ * @param "CBORStreamDecoder_t *" decoder
+ * @param "CBORStreamItem_t *"    receives the item
+ * @return cborStreamStatus_t     eCborStreamItemReady if pxItem was filled
+ */
+cborStreamStatus_t CBOR_StreamNext( CBORStreamDecoder_t * /*pxDecoder*/,
+                                    CBORStreamItem_t * /*pxItem*/ );
+
+#endif /* ifndef AWS_CBOR_STREAM_H */
@@ -27,6 +27,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if ( CBOR_USE_TINYCBOR == 1 )
+    #include "cbor.h"
+#endif
+
 void CBOR_WriteShortString( CBORHandle_t xCborData,
                             const char * pcStr,
                             cbor_ssize_t xStringLength );
@@ -47,6 +51,39 @@ void CBOR_WriteString( CBORHandle_t xCborData,
 
     const char * pcStr = pvInput;
     cbor_int_t xStringLength = strlen( pcStr );
+
+#if ( CBOR_USE_TINYCBOR == 1 )
+    cbor_ssize_t xSize = CBOR_StringEncodedSize( pcStr );
+    CborEncoder xEncoder;
+
+    /* Lengths the readers here cannot skip are refused, as below */
+    if( 0 == xSize )
+    {
+        xCborData->xError = eCborErrUnsupportedWriteOperation;
+
+        return;
+    }
+
+    CBOR_ValueResize( xCborData, xSize );
+
+    if( !CBOR_MakeRoom( xCborData, xSize ) )
+    {
+        return;
+    }
+
+    cbor_encoder_init( &xEncoder, xCborData->pxCursor, xSize, 0 );
+
+    if( CborNoError != cbor_encode_text_string( &xEncoder, pcStr, xStringLength ) )
+    {
+        xCborData->xError = eCborErrUnsupportedWriteOperation;
+
+        return;
+    }
+
+    xCborData->pxCursor += xSize;
+    xCborData->xError = eCborErrNoError;
+    CBOR_InvalidateKeyIndex( xCborData );
+#else
     CBOR_ValueResize( xCborData, xStringLength + 1 );
 
     if( CBOR_IsSmallInt( xStringLength ) )
@@ -67,6 +104,7 @@ void CBOR_WriteString( CBORHandle_t xCborData,
 
         return;
     }
+#endif /* if ( CBOR_USE_TINYCBOR == 1 ) */
 }
 
 void CBOR_WriteShortString( CBORHandle_t xCborData,
@@ -159,6 +197,29 @@ static cbor_ssize_t CBOR_StringLengthAtPtr( CBORHandle_t xCborData,
     assert( NULL != ppxCursor );
     assert( NULL != *ppxCursor );
 
+#if ( CBOR_USE_TINYCBOR == 1 )
+    CborParser xParser;
+    CborValue xValue;
+    size_t xLength = 0;
+
+    /* The string data ends where the parser lands after skipping the string */
+    if( ( CborNoError != cbor_parser_init( *ppxCursor,
+                                           xCborData->pxBufferEnd - *ppxCursor + 1,
+                                           0, &xParser, &xValue ) ) ||
+        ( CborNoError != cbor_value_get_string_length( &xValue, &xLength ) ) ||
+        ( CborNoError != cbor_value_advance( &xValue ) ) )
+    {
+        xCborData->xError = eCborErrReadTypeMismatch;
+        xLength = 0;
+        *ppxCursor += 1;
+    }
+    else
+    {
+        *ppxCursor = ( cbor_byte_t * ) xValue.ptr - xLength;
+    }
+
+    return ( cbor_ssize_t ) xLength;
+#else
     cbor_byte_t * pxPtr = *ppxCursor;
     cbor_byte_t xAdditional_info = *( pxPtr++ ) & CBOR_ADDITIONAL_DATA_MASK;
     cbor_ssize_t xLength = 0;
@@ -180,6 +241,7 @@ static cbor_ssize_t CBOR_StringLengthAtPtr( CBORHandle_t xCborData,
     *ppxCursor = pxPtr;
 
     return xLength;
+#endif /* if ( CBOR_USE_TINYCBOR == 1 ) */
 }
 
 cbor_ssize_t CBOR_StringLength( CBORHandle_t xCborData )
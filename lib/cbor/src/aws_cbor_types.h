@@ -31,8 +31,43 @@
  */
 
 #include "aws_cbor.h"
+#include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * @brief Encode and decode integers and string heads with tinycbor.
+ *
+ * Images that link the OTA agent already carry tinycbor.  Setting this to 1
+ * makes CBOR_WriteInt, CBOR_WriteString, CBOR_ReadInt and the string length
+ * reads go through the tinycbor encoder and parser, so the fixed width
+ * writers and readers in this library are no longer referenced and the
+ * linker can drop them.  Map editing, key lookup and buffer management are
+ * unchanged.  tinycbor must be on the include path and linked.
+ */
+#ifndef CBOR_USE_TINYCBOR
+    #define CBOR_USE_TINYCBOR    ( 0 )
+#endif
+
+/**
+ * @brief Number of top level keys whose offsets a CBOR handle can index.
+ *
+ * When non-zero, the first CBOR_FindKey on a handle walks the map once and
+ * records where each key is in a small hash table, so the lookups that follow
+ * do not walk the map and compare every key again.  Any write to the buffer
+ * drops the index.  Maps with more keys are searched linearly.  0 disables the
+ * index and keeps the handle small.
+ */
+#ifndef CBOR_KEY_INDEX_SIZE
+    #define CBOR_KEY_INDEX_SIZE    ( 0 )
+#endif
+
+/** @brief The key index must be rebuilt before use */
+#define CBOR_KEY_INDEX_STALE       ( 0U )
+/** @brief The key index holds every top level key */
+#define CBOR_KEY_INDEX_READY       ( 1U )
+/** @brief The map cannot be indexed, search it linearly */
+#define CBOR_KEY_INDEX_UNUSABLE    ( 2U )
+
 /**
  * @brief Pointer to a CBOR Data Struct
  */
@@ -52,6 +87,14 @@ struct CborData_s
     cbor_byte_t * pxCursor;
     /** Current error code status */
     cborError_t xError;
+    /** Buffer belongs to the caller: it is never grown or freed */
+    bool xStaticBuffer;
+#if ( CBOR_KEY_INDEX_SIZE > 0 )
+    /** Offsets of the top level keys from pxBufferStart, 0 if the slot is free */
+    cbor_ssize_t xKeyIndex[ CBOR_KEY_INDEX_SIZE ];
+    /** One of CBOR_KEY_INDEX_STALE, _READY or _UNUSABLE */
+    cbor_byte_t xKeyIndexState;
+#endif
 };
 
 #endif /* ifndef AWS_CBOR_TYPES_H */
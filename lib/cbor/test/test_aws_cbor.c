@@ -54,6 +54,11 @@ TEST_GROUP_RUNNER( aws_cbor )
     RUN_TEST_CASE( aws_cbor, GetBuffer_returns_size_of_map_in_bytes );
     RUN_TEST_CASE( aws_cbor, ClearError_sets_err_to_CBOR_ERR_NO_ERROR );
     RUN_TEST_CASE( aws_cbor, AppendMap );
+    RUN_TEST_CASE( aws_cbor, NewStatic_initializes_buffer_with_empty_map );
+    RUN_TEST_CASE( aws_cbor, NewStatic_returns_null_when_buffer_is_too_small );
+    RUN_TEST_CASE( aws_cbor, NewStatic_sets_err_instead_of_growing );
+    RUN_TEST_CASE( aws_cbor, Reserve_grows_buffer_to_requested_size );
+    RUN_TEST_CASE( aws_cbor, EncodedSize_matches_written_document );
 }
 
 TEST( aws_cbor, New_returns_not_null )
@@ -164,3 +169,69 @@ TEST( aws_cbor, AppendMap )
     TEST_ASSERT_TRUE( xAnswerFound );
     TEST_ASSERT_TRUE( xQuestionFound );
 }
+
+TEST( aws_cbor, NewStatic_initializes_buffer_with_empty_map )
+{
+    cbor_byte_t xBuffer[ sizeof( struct CborData_s ) + sizeof( void * ) + 24 ];
+    CBORHandle_t xTestData = CBOR_NewStatic( xBuffer, sizeof( xBuffer ) );
+    cbor_byte_t xEmptyMap[] = { CBOR_MAP_OPEN, CBOR_BREAK };
+
+    TEST_ASSERT_NOT_NULL( xTestData );
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(
+        xEmptyMap, CBOR_GetRawBuffer( xTestData ), sizeof( xEmptyMap ) );
+    TEST_ASSERT_EQUAL( sizeof( xEmptyMap ), CBOR_GetBufferSize( xTestData ) );
+    CBOR_Delete( &xTestData );
+    TEST_ASSERT_NULL( xTestData );
+}
+
+TEST( aws_cbor, NewStatic_returns_null_when_buffer_is_too_small )
+{
+    cbor_byte_t xBuffer[ sizeof( struct CborData_s ) + sizeof( void * ) + 24 ];
+
+    TEST_ASSERT_NULL( CBOR_NewStatic( NULL, sizeof( xBuffer ) ) );
+    TEST_ASSERT_NULL( CBOR_NewStatic( xBuffer, CBOR_HandleSize() ) );
+}
+
+TEST( aws_cbor, NewStatic_sets_err_instead_of_growing )
+{
+    cbor_byte_t xBuffer[ sizeof( struct CborData_s ) + sizeof( void * ) + 24 ];
+    CBORHandle_t xTestData = CBOR_NewStatic( xBuffer, sizeof( xBuffer ) );
+
+    CBOR_AppendKeyWithString( xTestData, "key",
+                              "a value that is far too long for the buffer" );
+    TEST_ASSERT_EQUAL( eCborErrInsufficentSpace, CBOR_CheckError( xTestData ) );
+    TEST_ASSERT_TRUE( CBOR_GetRawBuffer( xTestData ) > xBuffer );
+    TEST_ASSERT_TRUE( CBOR_GetRawBuffer( xTestData ) < xBuffer + sizeof( xBuffer ) );
+}
+
+TEST( aws_cbor, Reserve_grows_buffer_to_requested_size )
+{
+    CBOR_AppendKeyWithInt( xCborData, "answer", 42 );
+    CBOR_Reserve( xCborData, 1000 );
+
+    TEST_ASSERT_EQUAL( eCborErrNoError, CBOR_CheckError( xCborData ) );
+    TEST_ASSERT_EQUAL( 1000, xCborData->pxBufferEnd - xCborData->pxBufferStart + 1 );
+    TEST_ASSERT_EQUAL( 42, CBOR_FromKeyReadInt( xCborData, "answer" ) );
+}
+
+TEST( aws_cbor, EncodedSize_matches_written_document )
+{
+    const char * pcLongValue =
+        "a string value which is longer than twenty three characters";
+    cbor_ssize_t xSize = CBOR_EMPTY_MAP_SIZE +
+                         CBOR_StringEncodedSize( "small" ) + CBOR_IntEncodedSize( 7 ) +
+                         CBOR_StringEncodedSize( "large" ) + CBOR_IntEncodedSize( 70000 ) +
+                         CBOR_StringEncodedSize( "text" ) + CBOR_StringEncodedSize( pcLongValue );
+    CBORHandle_t xTestData = CBOR_New( xSize );
+    cbor_byte_t const * pxBuffer = CBOR_GetRawBuffer( xTestData );
+
+    CBOR_AppendKeyWithInt( xTestData, "small", 7 );
+    CBOR_AppendKeyWithInt( xTestData, "large", 70000 );
+    CBOR_AppendKeyWithString( xTestData, "text", pcLongValue );
+
+    /* Written in place: the buffer was never moved */
+    TEST_ASSERT_EQUAL( eCborErrNoError, CBOR_CheckError( xTestData ) );
+    TEST_ASSERT_EQUAL_PTR( pxBuffer, CBOR_GetRawBuffer( xTestData ) );
+    TEST_ASSERT_EQUAL( xSize, CBOR_GetBufferSize( xTestData ) );
+    CBOR_Delete( &xTestData );
+}
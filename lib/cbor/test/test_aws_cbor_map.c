@@ -26,6 +26,8 @@
 #include "aws_cbor_internals.h"
 #include "unity_fixture.h"
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 CBORHandle_t xCborData;
@@ -55,6 +57,8 @@ TEST_GROUP_RUNNER( aws_cbor_map )
     RUN_TEST_CASE( aws_cbor_map, FindKey_read_int_at_longer_key );
     RUN_TEST_CASE( aws_cbor_map, FindKey_returns_true_when_key_is_found );
     RUN_TEST_CASE( aws_cbor_map, FindKey_returns_false_when_key_not_found );
+    RUN_TEST_CASE( aws_cbor_map, FindKey_finds_every_key_after_writes );
+    RUN_TEST_CASE( aws_cbor_map, FindKey_finds_keys_of_map_larger_than_index );
 
     RUN_TEST_CASE( aws_cbor_map, WriteMap );
 
@@ -328,6 +332,49 @@ TEST( aws_cbor_map, FindKey_returns_false_when_key_not_found )
     TEST_ASSERT_FALSE( xResult );
 }
 
+TEST( aws_cbor_map, FindKey_finds_every_key_after_writes )
+{
+    CBOR_AppendKeyWithInt( xCborData, "alpha", 1 );
+    CBOR_AppendKeyWithInt( xCborData, "beta", 2 );
+    CBOR_AppendKeyWithString( xCborData, "gamma", "three" );
+
+    TEST_ASSERT_EQUAL( 2, CBOR_FromKeyReadInt( xCborData, "beta" ) );
+    TEST_ASSERT_EQUAL( 1, CBOR_FromKeyReadInt( xCborData, "alpha" ) );
+    TEST_ASSERT_FALSE( CBOR_FindKey( xCborData, "delta" ) );
+
+    /* Moves "beta" and "gamma", so lookups must not use stale offsets */
+    CBOR_AssignKeyWithInt( xCborData, "alpha", 100000 );
+    CBOR_AppendKeyWithInt( xCborData, "delta", 4 );
+
+    TEST_ASSERT_EQUAL( 100000, CBOR_FromKeyReadInt( xCborData, "alpha" ) );
+    TEST_ASSERT_EQUAL( 2, CBOR_FromKeyReadInt( xCborData, "beta" ) );
+    TEST_ASSERT_EQUAL( 4, CBOR_FromKeyReadInt( xCborData, "delta" ) );
+    char * pcValue = CBOR_FromKeyReadString( xCborData, "gamma" );
+    TEST_ASSERT_EQUAL_STRING( "three", pcValue );
+    free( pcValue );
+    TEST_ASSERT_EQUAL( eCborErrNoError, CBOR_CheckError( xCborData ) );
+}
+
+TEST( aws_cbor_map, FindKey_finds_keys_of_map_larger_than_index )
+{
+    char cKey[ 8 ];
+    cbor_int_t xI;
+
+    for( xI = 0; xI < 40; xI++ )
+    {
+        snprintf( cKey, sizeof( cKey ), "k%d", xI );
+        CBOR_AppendKeyWithInt( xCborData, cKey, xI );
+    }
+
+    for( xI = 39; xI >= 0; xI-- )
+    {
+        snprintf( cKey, sizeof( cKey ), "k%d", xI );
+        TEST_ASSERT_EQUAL( xI, CBOR_FromKeyReadInt( xCborData, cKey ) );
+    }
+
+    TEST_ASSERT_FALSE( CBOR_FindKey( xCborData, "k40" ) );
+}
+
 TEST( aws_cbor_map, WriteMap )
 {
     uint8_t ucMapBuffer[] =
@@ -0,0 +1,168 @@
+/*
+ * Amazon FreeRTOS CBOR Library V1.0.2
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+#include "assert_override.h"
+#include "aws_cbor_internals.h"
+#include "aws_cbor_stream.h"
+#include "unity_fixture.h"
+#include <stdio.h>
+#include <string.h>
+
+static CBORStreamDecoder_t xDecoder;
+static CBORStreamItem_t xItem;
+
+TEST_GROUP( aws_cbor_stream );
+
+TEST_SETUP( aws_cbor_stream )
+{
+    CBOR_StreamInit( &xDecoder );
+}
+
+TEST_TEAR_DOWN( aws_cbor_stream )
+{
+}
+
+TEST_GROUP_RUNNER( aws_cbor_stream )
+{
+    RUN_TEST_CASE( aws_cbor_stream, Next_decodes_document_written_by_encoder );
+    RUN_TEST_CASE( aws_cbor_stream, Next_yields_same_items_when_fed_byte_by_byte );
+    RUN_TEST_CASE( aws_cbor_stream, Next_yields_string_chunks_in_place );
+    RUN_TEST_CASE( aws_cbor_stream, Next_reports_malformed_and_unsupported_items );
+}
+
+/**
+ * @brief Decodes what was fed, writing a summary of each item to pcOut
+ * @return status that ended the decode
+ */
+static cborStreamStatus_t prvDecodeToText( char * pcOut,
+                                           size_t xOutSize )
+{
+    cborStreamStatus_t xStatus;
+
+    while( eCborStreamItemReady == ( xStatus = CBOR_StreamNext( &xDecoder, &xItem ) ) )
+    {
+        size_t xUsed = strlen( pcOut );
+
+        if( ( eCborStreamTextString == xItem.xType ) || ( eCborStreamByteString == xItem.xType ) )
+        {
+            snprintf( pcOut + xUsed, xOutSize - xUsed, "%s%.*s%s",
+                      ( 0 == xItem.ullChunkOffset ) ? "<" : "",
+                      ( int ) xItem.xChunkLength, ( const char * ) xItem.pxChunk,
+                      xItem.xLastChunk ? ">" : "" );
+        }
+        else
+        {
+            snprintf( pcOut + xUsed, xOutSize - xUsed, "(%d:%llu)",
+                      ( int ) xItem.xType, ( unsigned long long ) xItem.ullValue );
+        }
+    }
+
+    return xStatus;
+}
+
+TEST( aws_cbor_stream, Next_decodes_document_written_by_encoder )
+{
+    CBORHandle_t xCborData = CBOR_New( 0 );
+    char cText[ 128 ] = { 0 };
+
+    CBOR_AppendKeyWithInt( xCborData, "a", 1000 );
+    CBOR_AppendKeyWithString( xCborData, "b", "hello" );
+    CBOR_StreamFeed( &xDecoder, CBOR_GetRawBuffer( xCborData ), CBOR_GetBufferSize( xCborData ) );
+
+    TEST_ASSERT_EQUAL( eCborStreamNeedMoreData, prvDecodeToText( cText, sizeof( cText ) ) );
+    TEST_ASSERT_EQUAL_STRING( "(5:18446744073709551615)<a>(0:1000)<b><hello>(8:0)", cText );
+    CBOR_Delete( &xCborData );
+}
+
+TEST( aws_cbor_stream, Next_yields_same_items_when_fed_byte_by_byte )
+{
+    CBORHandle_t xCborData = CBOR_New( 0 );
+    char cWhole[ 256 ] = { 0 };
+    char cBytes[ 256 ] = { 0 };
+
+    CBOR_AppendKeyWithInt( xCborData, "id", 70000 );
+    CBOR_AppendKeyWithString( xCborData, "name", "a name longer than one fragment" );
+    cbor_byte_t const * pxBuffer = CBOR_GetRawBuffer( xCborData );
+    cbor_ssize_t xSize = CBOR_GetBufferSize( xCborData );
+
+    CBOR_StreamFeed( &xDecoder, pxBuffer, xSize );
+    prvDecodeToText( cWhole, sizeof( cWhole ) );
+
+    CBOR_StreamInit( &xDecoder );
+
+    for( cbor_ssize_t xI = 0; xI < xSize; xI++ )
+    {
+        CBOR_StreamFeed( &xDecoder, &pxBuffer[ xI ], 1 );
+        TEST_ASSERT_EQUAL( eCborStreamNeedMoreData, prvDecodeToText( cBytes, sizeof( cBytes ) ) );
+    }
+
+    TEST_ASSERT_EQUAL_STRING( cWhole, cBytes );
+    CBOR_Delete( &xCborData );
+}
+
+TEST( aws_cbor_stream, Next_yields_string_chunks_in_place )
+{
+    cbor_byte_t xDocument[ 3 + 256 ] = { 0x59, 0x01, 0x00 };
+    cbor_ssize_t xSplits[] = { 2, 100, 200, sizeof( xDocument ) };
+    uint64_t ullReceived = 0;
+    cbor_ssize_t xStart = 0;
+
+    for( cbor_ssize_t xI = 0; xI < 256; xI++ )
+    {
+        xDocument[ 3 + xI ] = ( cbor_byte_t ) xI;
+    }
+
+    for( size_t xF = 0; xF < sizeof( xSplits ) / sizeof( xSplits[ 0 ] ); xF++ )
+    {
+        CBOR_StreamFeed( &xDecoder, &xDocument[ xStart ], xSplits[ xF ] - xStart );
+
+        while( eCborStreamItemReady == CBOR_StreamNext( &xDecoder, &xItem ) )
+        {
+            TEST_ASSERT_EQUAL( eCborStreamByteString, xItem.xType );
+            TEST_ASSERT_EQUAL( 256, xItem.ullValue );
+            TEST_ASSERT_EQUAL( ullReceived, xItem.ullChunkOffset );
+            /* Not copied: the chunk is in the fragment */
+            TEST_ASSERT_EQUAL_PTR( &xDocument[ 3 + ullReceived ], xItem.pxChunk );
+            ullReceived += xItem.xChunkLength;
+            TEST_ASSERT_EQUAL( 256 == ullReceived, xItem.xLastChunk );
+        }
+
+        xStart = xSplits[ xF ];
+    }
+
+    TEST_ASSERT_EQUAL( 256, ullReceived );
+}
+
+TEST( aws_cbor_stream, Next_reports_malformed_and_unsupported_items )
+{
+    cbor_byte_t xReserved[] = { 0x1C };
+    cbor_byte_t xIndefiniteString[] = { 0x5F, 0x41, 0x00, 0xFF };
+
+    CBOR_StreamFeed( &xDecoder, xReserved, sizeof( xReserved ) );
+    TEST_ASSERT_EQUAL( eCborStreamMalformed, CBOR_StreamNext( &xDecoder, &xItem ) );
+
+    CBOR_StreamInit( &xDecoder );
+    CBOR_StreamFeed( &xDecoder, xIndefiniteString, sizeof( xIndefiniteString ) );
+    TEST_ASSERT_EQUAL( eCborStreamUnsupported, CBOR_StreamNext( &xDecoder, &xItem ) );
+}
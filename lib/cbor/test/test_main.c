@@ -34,6 +34,7 @@ static void runAllTests()
     RUN_TEST_GROUP( aws_cbor_map );
     RUN_TEST_GROUP( aws_cbor_mem );
     RUN_TEST_GROUP( aws_cbor_print );
+    RUN_TEST_GROUP( aws_cbor_stream );
     RUN_TEST_GROUP( aws_cbor_string );
 }
 
@@ -27,6 +27,7 @@
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "FreeRTOSIPConfig.h"
+#include "task.h"
 #include "aws_crypto.h"
 
 /* mbedTLS includes. */
@@ -34,12 +35,50 @@
 #include "mbedtls/platform.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/sha1.h"
+#include "mbedtls/gcm.h"
 #include "mbedtls/pk.h"
 #include "mbedtls/x509_crt.h"
 
 /* C runtime includes. */
 #include <string.h>
 
+/**
+ * @brief Default shortest input, in bytes, passed to a registered engine.
+ */
+#ifndef cryptoconfigACCEL_MIN_LENGTH
+    #define cryptoconfigACCEL_MIN_LENGTH    256
+#endif
+
+/**
+ * @brief Time source of CRYPTO_CalibrateAccelerator().
+ *
+ * The tick count is too coarse to time short inputs; ports should map this to
+ * a cycle counter.
+ */
+#ifndef cryptoconfigACCEL_TIMESTAMP
+    #define cryptoconfigACCEL_TIMESTAMP()    ( ( uint32_t ) xTaskGetTickCount() )
+#endif
+
+/**
+ * @brief Longest input, in bytes, timed by CRYPTO_CalibrateAccelerator().
+ *
+ * The sizes timed are the powers of two from 64 up to this value, which must be
+ * a multiple of 64.  Twice this length is allocated while the benchmark runs.
+ */
+#ifndef cryptoconfigACCEL_CALIBRATION_MAX_LENGTH
+    #define cryptoconfigACCEL_CALIBRATION_MAX_LENGTH    4096
+#endif
+
+/**
+ * @brief Number of times each input size is processed when timing it.
+ */
+#ifndef cryptoconfigACCEL_CALIBRATION_ROUNDS
+    #define cryptoconfigACCEL_CALIBRATION_ROUNDS    32
+#endif
+
+#define cryptoSHA256_BLOCK_BYTES    64
+#define cryptoGCM_MAX_TAG_BYTES     16
+
 /**
  * @brief Internal signature verification context structure
  */
@@ -51,6 +90,54 @@ typedef struct SignatureVerificationState
     mbedtls_sha256_context xSHA256Context;
 } SignatureVerificationState_t, * SignatureVerificationStatePtr_t;
 
+/**
+ * @brief Registered hardware engine, or NULL for software only.
+ */
+static const CryptoAccelerator_t * pxAccelerator = NULL;
+
+/**
+ * @brief Shortest input passed to the engine, per operation.
+ */
+static size_t xAcceleratorThreshold[ cryptoACCEL_OPERATION_COUNT ] =
+{
+    cryptoconfigACCEL_MIN_LENGTH,
+    cryptoconfigACCEL_MIN_LENGTH
+};
+
+/*
+ * Target compression kernels
+ */
+
+#if defined( MBEDTLS_SHA256_PROCESS_ALT )
+
+/**
+ * @brief Replaces the portable SHA-256 compression function of mbedTLS with the
+ * kernel of the target.
+ */
+    int mbedtls_internal_sha256_process( mbedtls_sha256_context * ctx,
+                                         const unsigned char data[ 64 ] )
+    {
+        return ( pdTRUE == CRYPTO_SHA256ProcessBlocks( ctx->state, data, 1 ) ) ?
+               0 : MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED;
+    }
+
+#endif /* if defined( MBEDTLS_SHA256_PROCESS_ALT ) */
+
+#if defined( MBEDTLS_SHA1_PROCESS_ALT )
+
+/**
+ * @brief Replaces the portable SHA-1 compression function of mbedTLS with the
+ * kernel of the target.
+ */
+    int mbedtls_internal_sha1_process( mbedtls_sha1_context * ctx,
+                                       const unsigned char data[ 64 ] )
+    {
+        return ( pdTRUE == CRYPTO_SHA1ProcessBlocks( ctx->state, data, 1 ) ) ?
+               0 : MBEDTLS_ERR_SHA1_HW_ACCEL_FAILED;
+    }
+
+#endif /* if defined( MBEDTLS_SHA1_PROCESS_ALT ) */
+
 /*
  * Helper routines
  */
@@ -61,7 +148,9 @@ typedef struct SignatureVerificationState
 static void * prvCalloc( size_t xNmemb,
                          size_t xSize )
 {
-    void * pvNew = pvPortMalloc( xNmemb * xSize );
+    /* mbedTLS allocates the TLS record buffers and working state, which are
+     * used on every record, so prefer fast memory. */
+    void * pvNew = pvPortMallocWithCaps( xNmemb * xSize, heapCAPS_FAST );
 
     if( NULL != pvNew )
     {
@@ -134,6 +223,223 @@ static BaseType_t prvVerifySignature( char * pcSignerCertificate,
     return xResult;
 }
 
+/**
+ * @brief Adds data to a SHA-256 computation, running the whole blocks on the
+ * engine when there are enough of them.
+ */
+static int prvSHA256Update( mbedtls_sha256_context * pxCtx,
+                            const uint8_t * pucData,
+                            size_t xDataLength )
+{
+    int lResult = 0;
+
+    #if !defined( MBEDTLS_SHA256_ALT )
+        size_t xFill = 0;
+        size_t xBlockBytes = 0;
+
+        if( ( NULL != pxAccelerator ) &&
+            ( NULL != pxAccelerator->xSHA256Process ) &&
+            ( xDataLength >= xAcceleratorThreshold[ cryptoACCEL_OPERATION_SHA256 ] ) )
+        {
+            /* Complete a partly buffered block in software first. */
+            xFill = ( cryptoSHA256_BLOCK_BYTES - ( pxCtx->total[ 0 ] & ( cryptoSHA256_BLOCK_BYTES - 1U ) ) ) %
+                    cryptoSHA256_BLOCK_BYTES;
+
+            if( xDataLength >= ( xFill + cryptoSHA256_BLOCK_BYTES ) )
+            {
+                lResult = mbedtls_sha256_update_ret( pxCtx, pucData, xFill );
+                pucData += xFill;
+                xDataLength -= xFill;
+                xBlockBytes = xDataLength - ( xDataLength % cryptoSHA256_BLOCK_BYTES );
+            }
+
+            if( ( 0 == lResult ) &&
+                ( 0U != xBlockBytes ) &&
+                ( pdTRUE == pxAccelerator->xSHA256Process( pxCtx->state,
+                                                           pucData,
+                                                           xBlockBytes / cryptoSHA256_BLOCK_BYTES ) ) )
+            {
+                /* Account for the blocks as mbedtls_sha256_update_ret()
+                 * would. */
+                pxCtx->total[ 0 ] += ( uint32_t ) xBlockBytes;
+
+                if( pxCtx->total[ 0 ] < ( uint32_t ) xBlockBytes )
+                {
+                    pxCtx->total[ 1 ]++;
+                }
+
+                pucData += xBlockBytes;
+                xDataLength -= xBlockBytes;
+            }
+        }
+    #endif /* if !defined( MBEDTLS_SHA256_ALT ) */
+
+    /* The remainder, or everything the engine did not take, in software. The
+     * port's own SHA-256 is used when it replaces mbedTLS's. */
+    if( 0 == lResult )
+    {
+        lResult = mbedtls_sha256_update_ret( pxCtx, pucData, xDataLength );
+    }
+
+    return lResult;
+}
+
+/**
+ * @brief AES-GCM with mbedTLS.  The tag is computed over the ciphertext in
+ * both directions.
+ */
+static BaseType_t prvAESGCMSoftware( BaseType_t xEncrypt,
+                                     const uint8_t * pucKey,
+                                     size_t xKeyBits,
+                                     const uint8_t * pucIV,
+                                     size_t xIVLength,
+                                     const uint8_t * pucAAD,
+                                     size_t xAADLength,
+                                     const uint8_t * pucInput,
+                                     size_t xLength,
+                                     uint8_t * pucOutput,
+                                     uint8_t * pucTag,
+                                     size_t xTagLength )
+{
+    BaseType_t xResult = pdFALSE;
+    mbedtls_gcm_context xGCMCtx;
+
+    mbedtls_gcm_init( &xGCMCtx );
+
+    if( 0 == mbedtls_gcm_setkey( &xGCMCtx,
+                                 MBEDTLS_CIPHER_ID_AES,
+                                 pucKey,
+                                 ( unsigned int ) xKeyBits ) )
+    {
+        if( 0 == mbedtls_gcm_crypt_and_tag( &xGCMCtx,
+                                            ( pdTRUE == xEncrypt ) ? MBEDTLS_GCM_ENCRYPT : MBEDTLS_GCM_DECRYPT,
+                                            xLength,
+                                            pucIV,
+                                            xIVLength,
+                                            pucAAD,
+                                            xAADLength,
+                                            pucInput,
+                                            pucOutput,
+                                            xTagLength,
+                                            pucTag ) )
+        {
+            xResult = pdTRUE;
+        }
+    }
+
+    mbedtls_gcm_free( &xGCMCtx );
+
+    return xResult;
+}
+
+/**
+ * @brief AES-GCM on the engine for long enough messages, otherwise, or when
+ * the engine declines, in software.
+ */
+static BaseType_t prvAESGCMCrypt( BaseType_t xEncrypt,
+                                  const uint8_t * pucKey,
+                                  size_t xKeyBits,
+                                  const uint8_t * pucIV,
+                                  size_t xIVLength,
+                                  const uint8_t * pucAAD,
+                                  size_t xAADLength,
+                                  const uint8_t * pucInput,
+                                  size_t xLength,
+                                  uint8_t * pucOutput,
+                                  uint8_t * pucTag,
+                                  size_t xTagLength )
+{
+    BaseType_t xResult = pdFALSE;
+
+    if( ( NULL != pxAccelerator ) &&
+        ( NULL != pxAccelerator->xAESGCMCrypt ) &&
+        ( xLength >= xAcceleratorThreshold[ cryptoACCEL_OPERATION_AES_GCM ] ) )
+    {
+        xResult = pxAccelerator->xAESGCMCrypt( xEncrypt, pucKey, xKeyBits, pucIV, xIVLength,
+                                               pucAAD, xAADLength, pucInput, xLength,
+                                               pucOutput, pucTag, xTagLength );
+    }
+
+    if( pdTRUE != xResult )
+    {
+        xResult = prvAESGCMSoftware( xEncrypt, pucKey, xKeyBits, pucIV, xIVLength,
+                                     pucAAD, xAADLength, pucInput, xLength,
+                                     pucOutput, pucTag, xTagLength );
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Times xRounds runs of one operation on the engine (xEngine is pdTRUE)
+ * or in software.
+ *
+ * @return Elapsed time, or UINT32_MAX if the engine declined the input.
+ */
+static uint32_t prvTimeOperation( BaseType_t xOperation,
+                                  BaseType_t xEngine,
+                                  uint8_t * pucInput,
+                                  uint8_t * pucOutput,
+                                  size_t xLength )
+{
+    uint32_t ulStart = 0;
+    uint32_t ulRound = 0;
+    BaseType_t xResult = pdTRUE;
+    uint8_t ucTag[ cryptoGCM_MAX_TAG_BYTES ];
+
+    #if !defined( MBEDTLS_SHA256_ALT )
+        mbedtls_sha256_context xSHA256Context;
+        size_t xOffset = 0;
+
+        mbedtls_sha256_init( &xSHA256Context );
+        ( void ) mbedtls_sha256_starts_ret( &xSHA256Context, 0 );
+    #endif
+
+    ulStart = cryptoconfigACCEL_TIMESTAMP();
+
+    for( ulRound = 0; ( pdTRUE == xResult ) && ( ulRound < ( uint32_t ) cryptoconfigACCEL_CALIBRATION_ROUNDS ); ulRound++ )
+    {
+        if( cryptoACCEL_OPERATION_SHA256 == xOperation )
+        {
+            #if !defined( MBEDTLS_SHA256_ALT )
+                if( pdTRUE == xEngine )
+                {
+                    xResult = pxAccelerator->xSHA256Process( xSHA256Context.state,
+                                                             pucInput,
+                                                             xLength / cryptoSHA256_BLOCK_BYTES );
+                }
+                else
+                {
+                    for( xOffset = 0; xOffset < xLength; xOffset += cryptoSHA256_BLOCK_BYTES )
+                    {
+                        ( void ) mbedtls_internal_sha256_process( &xSHA256Context, &pucInput[ xOffset ] );
+                    }
+                }
+            #else
+                xResult = pdFALSE;
+            #endif
+        }
+        else if( pdTRUE == xEngine )
+        {
+            xResult = pxAccelerator->xAESGCMCrypt( pdTRUE, pucInput, 128, pucInput, 12,
+                                                   NULL, 0, pucInput, xLength,
+                                                   pucOutput, ucTag, sizeof( ucTag ) );
+        }
+        else
+        {
+            xResult = prvAESGCMSoftware( pdTRUE, pucInput, 128, pucInput, 12,
+                                         NULL, 0, pucInput, xLength,
+                                         pucOutput, ucTag, sizeof( ucTag ) );
+        }
+    }
+
+    #if !defined( MBEDTLS_SHA256_ALT )
+        mbedtls_sha256_free( &xSHA256Context );
+    #endif
+
+    return ( pdTRUE == xResult ) ? ( cryptoconfigACCEL_TIMESTAMP() - ulStart ) : UINT32_MAX;
+}
+
 /*
  * Interface routines
  */
@@ -215,7 +521,7 @@ void CRYPTO_SignatureVerificationUpdate( void * pvContext,
     }
     else
     {
-        ( void ) mbedtls_sha256_update_ret( &pxCtx->xSHA256Context, pucData, xDataLength );
+        ( void ) prvSHA256Update( &pxCtx->xSHA256Context, pucData, xDataLength );
     }
 }
 
@@ -282,3 +588,185 @@ BaseType_t CRYPTO_SignatureVerificationFinal( void * pvContext,
 
     return xResult;
 }
+
+/**
+ * @brief Registers the hardware crypto engine of the board.
+ */
+void CRYPTO_RegisterAccelerator( const CryptoAccelerator_t * pxNewAccelerator )
+{
+    BaseType_t xOperation;
+
+    pxAccelerator = pxNewAccelerator;
+
+    for( xOperation = 0; xOperation < cryptoACCEL_OPERATION_COUNT; xOperation++ )
+    {
+        xAcceleratorThreshold[ xOperation ] = cryptoconfigACCEL_MIN_LENGTH;
+    }
+}
+
+/**
+ * @brief Sets the shortest input passed to the engine.
+ */
+void CRYPTO_SetAcceleratorThreshold( BaseType_t xOperation,
+                                     size_t xMinLength )
+{
+    if( ( xOperation >= 0 ) && ( xOperation < cryptoACCEL_OPERATION_COUNT ) )
+    {
+        xAcceleratorThreshold[ xOperation ] = xMinLength;
+    }
+}
+
+/**
+ * @brief Gets the shortest input passed to the engine.
+ */
+size_t CRYPTO_GetAcceleratorThreshold( BaseType_t xOperation )
+{
+    size_t xMinLength = 0;
+
+    if( ( xOperation >= 0 ) && ( xOperation < cryptoACCEL_OPERATION_COUNT ) )
+    {
+        xMinLength = xAcceleratorThreshold[ xOperation ];
+    }
+
+    return xMinLength;
+}
+
+/**
+ * @brief Finds the input size from which the engine beats software.
+ */
+BaseType_t CRYPTO_CalibrateAccelerator( void )
+{
+    BaseType_t xResult = pdFALSE;
+    BaseType_t xOperation;
+    BaseType_t xSupported;
+    uint8_t * pucBuffer = NULL;
+    size_t xLength;
+    size_t xFasterFrom;
+    uint32_t ulEngineTime;
+    uint32_t ulSoftwareTime;
+
+    if( NULL != pxAccelerator )
+    {
+        pucBuffer = ( uint8_t * ) pvPortMalloc( 2U * cryptoconfigACCEL_CALIBRATION_MAX_LENGTH ); /*lint !e9079 Allow casting void* to other types. */
+    }
+
+    if( NULL != pucBuffer )
+    {
+        /* The first half is the input, the second the output; its start also
+         * serves as key and IV. */
+        memset( pucBuffer, 0xA5, 2U * cryptoconfigACCEL_CALIBRATION_MAX_LENGTH );
+        CRYPTO_ConfigureHeap();
+
+        for( xOperation = 0; xOperation < cryptoACCEL_OPERATION_COUNT; xOperation++ )
+        {
+            xSupported = ( cryptoACCEL_OPERATION_SHA256 == xOperation ) ?
+                         ( NULL != pxAccelerator->xSHA256Process ) :
+                         ( NULL != pxAccelerator->xAESGCMCrypt );
+
+            /* The engine must be faster at every size from the threshold up. */
+            xFasterFrom = SIZE_MAX;
+
+            for( xLength = cryptoSHA256_BLOCK_BYTES;
+                 ( pdTRUE == xSupported ) && ( xLength <= ( size_t ) cryptoconfigACCEL_CALIBRATION_MAX_LENGTH );
+                 xLength *= 2U )
+            {
+                ulEngineTime = prvTimeOperation( xOperation, pdTRUE, pucBuffer,
+                                                 &pucBuffer[ cryptoconfigACCEL_CALIBRATION_MAX_LENGTH ], xLength );
+                ulSoftwareTime = prvTimeOperation( xOperation, pdFALSE, pucBuffer,
+                                                   &pucBuffer[ cryptoconfigACCEL_CALIBRATION_MAX_LENGTH ], xLength );
+
+                if( ulEngineTime >= ulSoftwareTime )
+                {
+                    xFasterFrom = SIZE_MAX;
+                }
+                else if( SIZE_MAX == xFasterFrom )
+                {
+                    xFasterFrom = xLength;
+                }
+                else
+                {
+                    /* Still faster. */
+                }
+            }
+
+            xAcceleratorThreshold[ xOperation ] = xFasterFrom;
+        }
+
+        vPortFree( pucBuffer );
+        xResult = pdTRUE;
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Encrypts a message with AES-GCM.
+ */
+BaseType_t CRYPTO_AESGCMEncrypt( const uint8_t * pucKey,
+                                 size_t xKeyBits,
+                                 const uint8_t * pucIV,
+                                 size_t xIVLength,
+                                 const uint8_t * pucAAD,
+                                 size_t xAADLength,
+                                 const uint8_t * pucInput,
+                                 size_t xLength,
+                                 uint8_t * pucOutput,
+                                 uint8_t * pucTag,
+                                 size_t xTagLength )
+{
+    BaseType_t xResult = pdFALSE;
+
+    if( xTagLength <= cryptoGCM_MAX_TAG_BYTES )
+    {
+        xResult = prvAESGCMCrypt( pdTRUE, pucKey, xKeyBits, pucIV, xIVLength,
+                                  pucAAD, xAADLength, pucInput, xLength,
+                                  pucOutput, pucTag, xTagLength );
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Decrypts and authenticates a message with AES-GCM.
+ */
+BaseType_t CRYPTO_AESGCMDecrypt( const uint8_t * pucKey,
+                                 size_t xKeyBits,
+                                 const uint8_t * pucIV,
+                                 size_t xIVLength,
+                                 const uint8_t * pucAAD,
+                                 size_t xAADLength,
+                                 const uint8_t * pucInput,
+                                 size_t xLength,
+                                 uint8_t * pucOutput,
+                                 const uint8_t * pucTag,
+                                 size_t xTagLength )
+{
+    BaseType_t xResult = pdFALSE;
+    uint8_t ucComputedTag[ cryptoGCM_MAX_TAG_BYTES ];
+    uint8_t ucDifference = 0;
+    size_t xIndex;
+
+    if( xTagLength <= cryptoGCM_MAX_TAG_BYTES )
+    {
+        xResult = prvAESGCMCrypt( pdFALSE, pucKey, xKeyBits, pucIV, xIVLength,
+                                  pucAAD, xAADLength, pucInput, xLength,
+                                  pucOutput, ucComputedTag, xTagLength );
+    }
+
+    if( pdTRUE == xResult )
+    {
+        /* Compare in constant time. */
+        for( xIndex = 0; xIndex < xTagLength; xIndex++ )
+        {
+            ucDifference |= ( uint8_t ) ( pucTag[ xIndex ] ^ ucComputedTag[ xIndex ] );
+        }
+
+        if( 0U != ucDifference )
+        {
+            memset( pucOutput, 0, xLength );
+            xResult = pdFALSE;
+        }
+    }
+
+    return xResult;
+}
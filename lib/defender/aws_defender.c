@@ -39,6 +39,28 @@ typedef enum
     eDefenderTrue = 1,
 } DEFENDERBool_t;
 
+/**
+ * @brief Keep the agent's own MQTT connection open between reports.
+ *
+ * When 0, the agent connects, subscribes, publishes and disconnects for every
+ * report.  When 1, it stays connected and subscribed and only publishes each
+ * period, reconnecting after a failed publish.  A connection shared with
+ * DEFENDER_MQTTAgentSet is always kept.
+ */
+#ifndef defenderconfigKEEP_MQTT_CONNECTION
+    #define defenderconfigKEEP_MQTT_CONNECTION    0
+#endif
+
+/**
+ * @brief Adjusts the time the agent sleeps between two reports.
+ *
+ * It may only make the sleep longer. Set it to WIFI_WakeWindowAlign( xTicks )
+ * to send the reports in the radio's wake windows, see aws_wifi_wake.h.
+ */
+#ifndef defenderconfigALIGN_DEFERRABLE_DELAY
+    #define defenderconfigALIGN_DEFERRABLE_DELAY( xTicks )    ( xTicks )
+#endif
+
 /* Marks that the agent has been asked to stop by the application. */
 static DEFENDERBool_t xDefenderKill;
 /* Endpoint used for connecting to the AWS IoT Device Defender service. */
@@ -54,6 +76,12 @@ static DefenderState_t eDefenderState;
 static uint32_t ulDelayPeriodSec = 300;
 /* Handle for the MQTT agent. */
 static MQTTAgentHandle_t xDefenderMQTTAgent;
+/* The MQTT agent belongs to the application. */
+static DEFENDERBool_t xDefenderMQTTAgentShared;
+/* The agent's own MQTT agent is connected. */
+static DEFENDERBool_t xDefenderMQTTConnected;
+/* The report topics have been subscribed to on the current connection. */
+static DEFENDERBool_t xDefenderMQTTSubscribed;
 /* Handle for the agent task. */
 static TaskHandle_t xDefenderTaskHandle = NULL;
 /* Timeout period for MQTT connections. */
@@ -67,11 +95,13 @@ static TickType_t xMQTTTimeoutPeriodTicks = pdMS_TO_TICKS( 10U * 1000U );
 /**
  * @brief      Publishes metrics report to service
  *
- * @param[in]  xReport  The metrics report
+ * @param[in]  pucBuffer  The encoded metrics report
+ * @param[in]  ulLength   Length of the report in bytes
  *
  * @return     Returns true if error occurred, false (0) on success
  */
-static DEFENDERBool_t prvPublishCborToDevDef( CBORHandle_t xReport );
+static DEFENDERBool_t prvPublishCborToDevDef( uint8_t const * pucBuffer,
+                                              uint32_t ulLength );
 
 /**
  * @brief      Subscribes to the report accept topic
@@ -124,11 +154,14 @@ static MQTTBool_t prvRejectCallback( void * pxPvPublishCallbackContext,
                                      MQTTPublishData_t const * pxPublishData );
 
 static DefenderState_t prvStateInit( void );
+static DefenderState_t prvStateStarted( void );
 static DefenderState_t prvStateNewMQTT( void );
 static DefenderState_t prvStateConnectMqtt( void );
 static DefenderState_t prvStateDisconnectMqtt( void );
 static DefenderState_t prvStateSubscribe( void );
 static DefenderState_t prvStateCreateReport( void );
+static DefenderState_t prvStateReportDone( void );
+static DefenderState_t prvStateReportFailed( void );
 static DefenderState_t prvStateDeleteMqtt( void );
 static DefenderState_t prvStateSleep( void );
 
@@ -195,15 +228,15 @@ static void DEFENDER_StateFunctionSet( void )
     /* clang-format off */
     DEFENDER_States[ eDefenderStateInit ] = prvStateInit;
 
-    DEFENDER_States[ eDefenderStateStarted ] = prvStateNewMQTT;
+    DEFENDER_States[ eDefenderStateStarted ] = prvStateStarted;
     DEFENDER_States[ eDefenderStateNewMqttFailed ] = prvStateSleep;
     DEFENDER_States[ eDefenderStateNewMqttSuccess ] = prvStateConnectMqtt;
     DEFENDER_States[ eDefenderStateConnectMqttFailed ] = prvStateDeleteMqtt;
     DEFENDER_States[ eDefenderStateConnectMqttSuccess ] = prvStateSubscribe;
     DEFENDER_States[ eDefenderStateSubscribeMqttFailed ] = prvStateDisconnectMqtt;
     DEFENDER_States[ eDefenderStateSubscribeMqttSuccess ] = prvStateCreateReport;
-    DEFENDER_States[ eDefenderStateSubmitReportFailed ] = prvStateDisconnectMqtt;
-    DEFENDER_States[ eDefenderStateSubmitReportSuccess ] = prvStateDisconnectMqtt;
+    DEFENDER_States[ eDefenderStateSubmitReportFailed ] = prvStateReportFailed;
+    DEFENDER_States[ eDefenderStateSubmitReportSuccess ] = prvStateReportDone;
     DEFENDER_States[ eDefenderStateDisconnectFailed ] = prvStateDisconnectMqtt;
     DEFENDER_States[ eDefenderStateDisconnected ] = prvStateDeleteMqtt;
     DEFENDER_States[ eDefenderStateDeleteFailed ] = prvStateDeleteMqtt;
@@ -216,6 +249,23 @@ static DefenderState_t prvStateInit( void )
     return eDefenderStateStarted;
 }
 
+static DefenderState_t prvStateStarted( void )
+{
+    /* Skip the steps a kept connection has already been through. */
+    if( ( eDefenderTrue == xDefenderMQTTAgentShared ) ||
+        ( eDefenderTrue == xDefenderMQTTConnected ) )
+    {
+        if( eDefenderTrue == xDefenderMQTTSubscribed )
+        {
+            return eDefenderStateSubscribeMqttSuccess;
+        }
+
+        return eDefenderStateConnectMqttSuccess;
+    }
+
+    return prvStateNewMQTT();
+}
+
 static DefenderState_t prvStateNewMQTT( void )
 {
     MQTTAgentReturnCode_t xCreateResult =
@@ -263,6 +313,8 @@ static DefenderState_t prvStateConnectMqtt( void )
         return eDefenderStateConnectMqttFailed;
     }
 
+    xDefenderMQTTConnected = eDefenderTrue;
+
     return eDefenderStateConnectMqttSuccess;
 }
 
@@ -275,9 +327,17 @@ static DefenderState_t prvStateSubscribe( void )
 
     if( xError )
     {
+        /* The application reconnects a shared agent; try again next period. */
+        if( eDefenderTrue == xDefenderMQTTAgentShared )
+        {
+            return eDefenderStateSleep;
+        }
+
         return eDefenderStateSubscribeMqttFailed;
     }
 
+    xDefenderMQTTSubscribed = eDefenderTrue;
+
     return eDefenderStateSubscribeMqttSuccess;
 }
 
@@ -421,16 +481,25 @@ static MQTTBool_t prvRejectCallback( void * pxPvPublishCallbackContext,
 
 static DefenderState_t prvStateCreateReport( void )
 {
-    CBORHandle_t xReport;
-
-    xReport = CreateReport();
+    CBORHandle_t xReport = NULL;
+    uint8_t const * pucReport = NULL;
+    uint32_t ulReportLength = 0;
 
-    if( NULL == xReport )
+    /* Patch the report template if there is one, else build a report. */
+    if( false == CreateReportInPlace( &pucReport, &ulReportLength ) )
     {
-        return eDefenderStateSubmitReportFailed;
+        xReport = CreateReport();
+
+        if( NULL == xReport )
+        {
+            return eDefenderStateSubmitReportFailed;
+        }
+
+        pucReport = CBOR_GetRawBuffer( xReport );
+        ulReportLength = CBOR_GetBufferSize( xReport );
     }
 
-    DEFENDERBool_t xError = prvPublishCborToDevDef( xReport );
+    DEFENDERBool_t xError = prvPublishCborToDevDef( pucReport, ulReportLength );
     CBOR_Delete( &xReport );
 
     /* Wait for ack from service */
@@ -444,7 +513,8 @@ static DefenderState_t prvStateCreateReport( void )
     return eDefenderStateSubmitReportSuccess;
 }
 
-static DEFENDERBool_t prvPublishCborToDevDef( CBORHandle_t xReport )
+static DEFENDERBool_t prvPublishCborToDevDef( uint8_t const * pucBuffer,
+                                              uint32_t ulLength )
 {
     MQTTAgentPublishParams_t xPubRecParams =
     {
@@ -454,8 +524,6 @@ static DEFENDERBool_t prvPublishCborToDevDef( CBORHandle_t xReport )
         .pvData        = NULL,
         .ulDataLength  = 0,
     };
-    uint8_t const * pucBuffer = CBOR_GetRawBuffer( xReport );
-    int32_t lBufLen = CBOR_GetBufferSize( xReport );
     DEFENDERBool_t xError = eDefenderFalse;
 
     /* Initialize non-static field values. */
@@ -464,7 +532,7 @@ static DEFENDERBool_t prvPublishCborToDevDef( CBORHandle_t xReport )
     xPubRecParams.usTopicLength = ( uint16_t )
                                   strlen( ( const char * ) xPubRecParams.pucTopic );
     xPubRecParams.pvData = pucBuffer;
-    xPubRecParams.ulDataLength = lBufLen;
+    xPubRecParams.ulDataLength = ulLength;
 
     if( NULL == xPubRecParams.pucTopic )
     {
@@ -491,11 +559,39 @@ static DEFENDERBool_t prvPublishCborToDevDef( CBORHandle_t xReport )
         vPortFree( ( void * ) xPubRecParams.pucTopic );
     }
 
-    return eDefenderFalse;
+    return xError;
+}
+
+static DefenderState_t prvStateReportDone( void )
+{
+    if( ( eDefenderTrue == xDefenderMQTTAgentShared ) ||
+        ( 1 == defenderconfigKEEP_MQTT_CONNECTION ) )
+    {
+        return eDefenderStateSleep;
+    }
+
+    return prvStateDisconnectMqtt();
+}
+
+static DefenderState_t prvStateReportFailed( void )
+{
+    /* The connection may have gone.  Subscribe again on a shared agent once
+     * the application has reconnected it, and drop a connection of our own. */
+    xDefenderMQTTSubscribed = eDefenderFalse;
+
+    if( eDefenderTrue == xDefenderMQTTAgentShared )
+    {
+        return eDefenderStateSleep;
+    }
+
+    return prvStateDisconnectMqtt();
 }
 
 static DefenderState_t prvStateDisconnectMqtt( void )
 {
+    xDefenderMQTTConnected = eDefenderFalse;
+    xDefenderMQTTSubscribed = eDefenderFalse;
+
     if( eMQTTAgentSuccess
         != MQTT_AGENT_Disconnect(
             xDefenderMQTTAgent, xMQTTTimeoutPeriodTicks ) )
@@ -530,7 +626,7 @@ static DefenderState_t prvStateSleep( void )
         ulSleepPeriod = 1;
     }
 
-    vTaskDelay( ulSleepPeriod );
+    vTaskDelay( defenderconfigALIGN_DEFERRABLE_DELAY( ulSleepPeriod ) );
 
     xWakeTick = xTaskGetTickCount();
 
@@ -554,6 +650,20 @@ DefenderErr_t DEFENDER_ReportPeriodSet( uint32_t ulPeriodSec )
     return eDefenderErrSuccess;
 }
 
+DefenderErr_t DEFENDER_MQTTAgentSet( void * pvMQTTAgent )
+{
+    if( NULL != xDefenderTaskHandle )
+    {
+        return eDefenderErrAlreadyStarted;
+    }
+
+    xDefenderMQTTAgent = ( MQTTAgentHandle_t ) pvMQTTAgent;
+    xDefenderMQTTAgentShared = ( NULL != pvMQTTAgent ) ? eDefenderTrue : eDefenderFalse;
+    xDefenderMQTTSubscribed = eDefenderFalse;
+
+    return eDefenderErrSuccess;
+}
+
 DefenderErr_t DEFENDER_ConnectionTimeoutSet( uint32_t ulTimeoutMs )
 {
     xMQTTTimeoutPeriodTicks = pdMS_TO_TICKS( ulTimeoutMs );
@@ -628,6 +738,13 @@ static void prvAgentLoop( void * params )
         vTaskDelay( pdMS_TO_TICKS( lStatePeriodMS ) );
     }
 
+    /* Close a connection kept open between reports. */
+    if( eDefenderTrue == xDefenderMQTTConnected )
+    {
+        ( void ) prvStateDisconnectMqtt();
+        ( void ) MQTT_AGENT_Delete( xDefenderMQTTAgent );
+    }
+
     TaskHandle_t xTaskHandle = xDefenderTaskHandle;
     xDefenderTaskHandle = NULL;
     vTaskDelete( xTaskHandle );
@@ -24,15 +24,70 @@
  */
 #include <stdint.h>
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include "aws_defender_cpu.h"
 
+/* The load is derived from the time the idle task has run, as counted by the
+ * run time stats clock. Without that clock no load can be measured. */
+#if ( ( configGENERATE_RUN_TIME_STATS == 1 ) && ( INCLUDE_xTaskGetIdleTaskHandle == 1 ) )
+    #define defenderCPU_LOAD_AVAILABLE    1
+#else
+    #define defenderCPU_LOAD_AVAILABLE    0
+#endif
+
+#if ( defenderCPU_LOAD_AVAILABLE == 1 )
+    static int32_t lDefenderCpuLoadPercent = -1;
+    static uint32_t ulPreviousTotalRunTime = 0;
+    static uint32_t ulPreviousIdleRunTime = 0;
+    static BaseType_t xHavePreviousSample = pdFALSE;
+#endif
+
 int32_t CpuLoadGet( void )
 {
-    /* #error return CPU as a percentage * cores. */
-    return -1;
+    #if ( defenderCPU_LOAD_AVAILABLE == 1 )
+        return lDefenderCpuLoadPercent;
+    #else
+        return -1;
+    #endif
 }
 
 void CpuLoadRefresh( void )
 {
-    /* #error measure and store CPU percentage * cores. */
+    #if ( defenderCPU_LOAD_AVAILABLE == 1 )
+        uint32_t ulTotalRunTime, ulIdleRunTime, ulTotalDelta, ulIdleDelta;
+
+        /* Both counters wrap around, so only their differences since the
+         * previous refresh are used. */
+        #ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+            portALT_GET_RUN_TIME_COUNTER_VALUE( ulTotalRunTime );
+        #else
+            ulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+        #endif
+        ulIdleRunTime = ( uint32_t ) xTaskGetIdleRunTimeCounter();
+
+        ulTotalDelta = ulTotalRunTime - ulPreviousTotalRunTime;
+        ulIdleDelta = ulIdleRunTime - ulPreviousIdleRunTime;
+
+        /* The idle task's counter is only updated when it is switched out,
+         * so its delta can include time from before the previous refresh. */
+        if( ulIdleDelta > ulTotalDelta )
+        {
+            ulIdleDelta = ulTotalDelta;
+        }
+
+        /* The first refresh only takes the reference sample. */
+        if( ( xHavePreviousSample == pdTRUE ) && ( ulTotalDelta > ( uint32_t ) 0 ) )
+        {
+            /* The load is a percentage times the number of cores. There is
+             * a single idle task as configNUM_CORES can only be 1. */
+            lDefenderCpuLoadPercent = ( int32_t ) ( ( ( uint64_t ) 100U * configNUM_CORES ) -
+                                                    ( ( ( uint64_t ) ulIdleDelta * 100U ) / ulTotalDelta ) );
+        }
+
+        ulPreviousTotalRunTime = ulTotalRunTime;
+        ulPreviousIdleRunTime = ulIdleRunTime;
+        xHavePreviousSample = pdTRUE;
+    #endif /* defenderCPU_LOAD_AVAILABLE */
 }
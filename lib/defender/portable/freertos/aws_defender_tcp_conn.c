@@ -24,6 +24,8 @@
  */
 #include "FreeRTOS.h"
 #include "list.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
 
 #include "aws_defender_tcp_conn.h"
 
@@ -35,6 +37,20 @@ int32_t TcpConnGet( void )
     return lDefenderTCPConnCount;
 }
 
+#if ( ipconfigTCP_CONNECTION_STATS != 0 )
+
+/* The IP stack keeps the counters itself, ask it for the number of
+ * established connections rather than the number of bound sockets. */
+void TcpConnRefresh( void )
+{
+    TCPStackStats_t xTotals;
+
+    ( void ) FreeRTOS_TCPSnapshot( NULL, 0, &xTotals );
+    lDefenderTCPConnCount = ( int32_t ) xTotals.ulEstablishedCount;
+}
+
+#else /* if ( ipconfigTCP_CONNECTION_STATS != 0 ) */
+
 void TcpConnRefresh( void )
 {
     int32_t lTCPConnCount[ 2 ];
@@ -57,3 +73,5 @@ void TcpConnRefresh( void )
 
     lDefenderTCPConnCount = lTCPConnCount[ 0 ];
 }
+
+#endif /* if ( ipconfigTCP_CONNECTION_STATS != 0 ) */
@@ -30,6 +30,17 @@
 static DefenderMetric_t xMetricsList[ DEFENDER_MAX_METRICS_COUNT ];
 static int32_t lMetricsCount;
 
+#if ( defenderconfigREPORT_TEMPLATE == 1 )
+    /* The report ID, then the value of each metric */
+    #define defenderTEMPLATE_INTEGERS    ( 1 + DEFENDER_MAX_METRICS_COUNT )
+
+    static uint8_t ucReportTemplate[ defenderconfigREPORT_TEMPLATE_SIZE ];
+    static uint32_t ulReportTemplateLength;
+    static uint32_t ulTemplateIntegerOffset[ defenderTEMPLATE_INTEGERS ];
+    static bool xReportTemplateReady;
+    static bool xReportTemplateUnusable;
+#endif
+
 DefenderErr_t DEFENDER_MetricsInitFunc( DefenderMetric_t * xMetrics,
                                         int32_t lMetricsCountIn )
 {
@@ -42,6 +53,12 @@ DefenderErr_t DEFENDER_MetricsInitFunc( DefenderMetric_t * xMetrics,
     /*Set the metrics count*/
     lMetricsCount = lMetricsCountIn;
 
+    #if ( defenderconfigREPORT_TEMPLATE == 1 )
+        /*The template holds the previous metrics*/
+        xReportTemplateReady = false;
+        xReportTemplateUnusable = false;
+    #endif
+
     /*Copy the list of metrics */
     for( int32_t lI = 0; lI < lMetricsCountIn; ++lI )
     {
@@ -54,29 +71,53 @@ DefenderErr_t DEFENDER_MetricsInitFunc( DefenderMetric_t * xMetrics,
 
 CBORHandle_t CreateReport( void )
 {
-    /*Create new empty report*/
-    CBORHandle_t xReport = CBOR_New( 0 );
+    CBORHandle_t xMetricReports[ DEFENDER_MAX_METRICS_COUNT ];
+
     /*Create new report header*/
     CBORHandle_t xHeader = GetHeader();
+    /*The metrics document holds the pairs of every metric report*/
+    cbor_ssize_t xMetricsSize = CBOR_EMPTY_MAP_SIZE;
+
+    /*Get the report of each metric first, to know the size of the document*/
+    for( int32_t lI = 0; lI < lMetricsCount; ++lI )
+    {
+        /*Update the date for the metric*/
+        xMetricsList[ lI ]->UpdateMetric();
+        /*Get report from the metric*/
+        xMetricReports[ lI ] = xMetricsList[ lI ]->ReportMetric();
+
+        if( NULL != xMetricReports[ lI ] )
+        {
+            xMetricsSize += CBOR_GetBufferSize( xMetricReports[ lI ] ) - CBOR_EMPTY_MAP_SIZE;
+        }
+    }
+
+    /*Allocate the report and the metrics document at their exact size, so
+     * building them does not reallocate*/
+    CBORHandle_t xReport = CBOR_New( CBOR_EMPTY_MAP_SIZE +
+                                     CBOR_StringEncodedSize( DEFENDER_HEADER_TAG ) +
+                                     CBOR_GetBufferSize( xHeader ) +
+                                     CBOR_StringEncodedSize( DEFENDER_METRICS_TAG ) +
+                                     xMetricsSize );
 
     /*Copy header to the report*/
     CBOR_AppendKeyWithMap( xReport, DEFENDER_HEADER_TAG, xHeader );
     /*Delete the header*/
     CBOR_Delete( &xHeader );
     /*Create new empty metrics document*/
-    CBORHandle_t xMetrics = CBOR_New( 0 );
+    CBORHandle_t xMetrics = CBOR_New( xMetricsSize );
 
     /*For each metric, append it to the metrics document*/
     for( int32_t lI = 0; lI < lMetricsCount; ++lI )
     {
-        /*Update the date for the metric*/
-        xMetricsList[ lI ]->UpdateMetric();
-        /*Get report from the metric*/
-        CBORHandle_t xMetric = xMetricsList[ lI ]->ReportMetric();
         /*Copy the metric to the metrics document*/
-        CBOR_AppendMap( xMetrics, xMetric );
+        if( NULL != xMetricReports[ lI ] )
+        {
+            CBOR_AppendMap( xMetrics, xMetricReports[ lI ] );
+        }
+
         /*Delete the metric document*/
-        CBOR_Delete( &xMetric );
+        CBOR_Delete( &xMetricReports[ lI ] );
     }
 
     /*Copy the metrics document to the report*/
@@ -94,3 +135,180 @@ CBORHandle_t CreateReport( void )
     /*Return the report*/
     return xReport;
 }
+
+#if ( defenderconfigREPORT_TEMPLATE == 1 )
+
+    /*Writes a 32 bit integer value, most significant byte first*/
+    static void prvWriteInteger32( uint8_t * pucOut,
+                                   uint32_t ulValue )
+    {
+        pucOut[ 0 ] = ( uint8_t ) ( ulValue >> 24 );
+        pucOut[ 1 ] = ( uint8_t ) ( ulValue >> 16 );
+        pucOut[ 2 ] = ( uint8_t ) ( ulValue >> 8 );
+        pucOut[ 3 ] = ( uint8_t ) ulValue;
+    }
+
+    /*Copies a report into the template, re-encoding every unsigned integer at
+     * 32 bit width and recording where its value is, so later values of any
+     * size fit in the same place*/
+    static bool prvBuildReportTemplate( uint8_t const * pucIn,
+                                        uint32_t ulInLength,
+                                        uint32_t ulIntegers )
+    {
+        uint32_t ulIn = 0;
+        uint32_t ulOut = 0;
+        uint32_t ulFound = 0;
+
+        while( ulIn < ulInLength )
+        {
+            uint8_t ucHead = pucIn[ ulIn ];
+            uint8_t ucMajorType = ucHead >> 5;
+            uint8_t ucInfo = ucHead & 0x1F;
+            uint32_t ulArgLength = 0;
+            uint32_t ulArg = ucInfo;
+
+            /*lib/cbor writes arguments of up to 32 bits*/
+            if( 24 == ucInfo )
+            {
+                ulArgLength = 1;
+            }
+            else if( 25 == ucInfo )
+            {
+                ulArgLength = 2;
+            }
+            else if( 26 == ucInfo )
+            {
+                ulArgLength = 4;
+            }
+            else if( ( 24 < ucInfo ) && ( 0xFF != ucHead ) && ( 0xBF != ucHead ) )
+            {
+                return false;
+            }
+
+            if( ulIn + 1 + ulArgLength > ulInLength )
+            {
+                return false;
+            }
+
+            if( 0 != ulArgLength )
+            {
+                ulArg = 0;
+
+                for( uint32_t ulI = 1; ulI <= ulArgLength; ++ulI )
+                {
+                    ulArg = ( ulArg << 8 ) | pucIn[ ulIn + ulI ];
+                }
+            }
+
+            if( 0 == ucMajorType )
+            {
+                if( ( ulFound == ulIntegers ) ||
+                    ( ulOut + 5 > sizeof( ucReportTemplate ) ) )
+                {
+                    return false;
+                }
+
+                ucReportTemplate[ ulOut ] = 0x1A;
+                ulTemplateIntegerOffset[ ulFound++ ] = ulOut + 1;
+                prvWriteInteger32( &ucReportTemplate[ ulOut + 1 ], ulArg );
+                ulOut += 5;
+                ulIn += 1 + ulArgLength;
+                continue;
+            }
+
+            /*Strings, maps and breaks are copied as they are*/
+            uint32_t ulItemLength = 1 + ulArgLength;
+
+            if( ( 2 == ucMajorType ) || ( 3 == ucMajorType ) )
+            {
+                ulItemLength += ulArg;
+            }
+            else if( ( 5 != ucMajorType ) && ( 0xFF != ucHead ) )
+            {
+                return false;
+            }
+
+            if( ( ulIn + ulItemLength > ulInLength ) ||
+                ( ulOut + ulItemLength > sizeof( ucReportTemplate ) ) )
+            {
+                return false;
+            }
+
+            memcpy( &ucReportTemplate[ ulOut ], &pucIn[ ulIn ], ulItemLength );
+            ulOut += ulItemLength;
+            ulIn += ulItemLength;
+        }
+
+        ulReportTemplateLength = ulOut;
+
+        return ulFound == ulIntegers;
+    }
+
+#endif /* if ( defenderconfigREPORT_TEMPLATE == 1 ) */
+
+bool CreateReportInPlace( uint8_t const ** ppucReport,
+                          uint32_t * pulLength )
+{
+    #if ( defenderconfigREPORT_TEMPLATE == 1 )
+        if( xReportTemplateUnusable )
+        {
+            return false;
+        }
+
+        if( !xReportTemplateReady )
+        {
+            /*Each metric must be able to give its value without a report*/
+            for( int32_t lI = 0; lI < lMetricsCount; ++lI )
+            {
+                if( NULL == xMetricsList[ lI ]->ValueMetric )
+                {
+                    xReportTemplateUnusable = true;
+
+                    return false;
+                }
+            }
+
+            /*Build this report as usual, and keep its layout*/
+            CBORHandle_t xReport = CreateReport();
+
+            if( NULL == xReport )
+            {
+                return false;
+            }
+
+            xReportTemplateReady = prvBuildReportTemplate( CBOR_GetRawBuffer( xReport ),
+                                                           CBOR_GetBufferSize( xReport ),
+                                                           1 + lMetricsCount );
+            xReportTemplateUnusable = !xReportTemplateReady;
+            CBOR_Delete( &xReport );
+
+            if( !xReportTemplateReady )
+            {
+                return false;
+            }
+        }
+        else
+        {
+            /*Write the new values over the old ones*/
+            prvWriteInteger32( &ucReportTemplate[ ulTemplateIntegerOffset[ 0 ] ],
+                               ( uint32_t ) NextReportId() );
+
+            for( int32_t lI = 0; lI < lMetricsCount; ++lI )
+            {
+                xMetricsList[ lI ]->UpdateMetric();
+                prvWriteInteger32( &ucReportTemplate[ ulTemplateIntegerOffset[ 1 + lI ] ],
+                                   ( uint32_t ) xMetricsList[ lI ]->ValueMetric() );
+            }
+        }
+
+        *ppucReport = ucReportTemplate;
+        *pulLength = ulReportTemplateLength;
+
+        return true;
+    #else /* if ( defenderconfigREPORT_TEMPLATE == 1 ) */
+        ( void ) ppucReport;
+        ( void ) pulLength;
+
+        return false;
+    #endif /* if ( defenderconfigREPORT_TEMPLATE == 1 ) */
+}
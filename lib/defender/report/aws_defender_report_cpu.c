@@ -28,6 +28,7 @@ struct DefenderMetric_s xDefenderMetricCpu_s =
 {
     CpuLoadRefresh,
     CpuReportGet,
+    CpuLoadGet,
 };
 
 DefenderMetric_t xDEFENDER_metric_cpu = &xDefenderMetricCpu_s;
@@ -36,7 +37,7 @@ CBORHandle_t CpuReportGet( void )
 {
     CBORHandle_t xCpuMetrics = CBOR_New( 0 );
 
-    CBOR_AssignKeyWithInt( xCpuMetrics, "cpu", CpuLoadGet() );
+    CBOR_AppendKeyWithInt( xCpuMetrics, "cpu", CpuLoadGet() );
 
     return xCpuMetrics;
 }
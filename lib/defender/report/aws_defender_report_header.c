@@ -40,14 +40,29 @@ static uint32_t prvDEFENDER_ReportIdInit( void )
     return ulId;
 }
 
-CBORHandle_t GetHeader( void )
+int32_t NextReportId( void )
 {
     lReportId = lReportId == 0 ? prvDEFENDER_ReportIdInit() : lReportId;
 
-    CBORHandle_t xHeader = CBOR_New( 0 );
+    ++lReportId;
+
+    return lReportId;
+}
+
+CBORHandle_t GetHeader( void )
+{
+    ( void ) NextReportId();
+
+    /*Allocate the exact size of the header, so it is written in place*/
+    cbor_ssize_t xSize = CBOR_EMPTY_MAP_SIZE +
+                         CBOR_StringEncodedSize( DEFENDER_REPORT_ID_TAG ) +
+                         CBOR_IntEncodedSize( lReportId ) +
+                         CBOR_StringEncodedSize( DEFENDER_VERSION_TAG ) +
+                         CBOR_StringEncodedSize( pcDEFENDER_METRICS_VERSION );
+    CBORHandle_t xHeader = CBOR_New( xSize );
 
-    CBOR_AssignKeyWithInt( xHeader, DEFENDER_REPORT_ID_TAG, ++lReportId );
-    CBOR_AssignKeyWithString(
+    CBOR_AppendKeyWithInt( xHeader, DEFENDER_REPORT_ID_TAG, lReportId );
+    CBOR_AppendKeyWithString(
         xHeader, DEFENDER_VERSION_TAG, pcDEFENDER_METRICS_VERSION );
 
     return xHeader;
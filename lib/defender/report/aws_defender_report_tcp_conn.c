@@ -28,6 +28,7 @@ static struct DefenderMetric_s xDefenderTCPConnectionsS =
 {
     TcpConnRefresh,
     TcpConnReportGet,
+    TcpConnGet,
 };
 
 DefenderMetric_t xDefenderTCPConnections = &xDefenderTCPConnectionsS;
@@ -24,10 +24,16 @@
  */
 #include "aws_defender_internals.h"
 
+static int32_t prvUptimeValue( void )
+{
+    return ( int32_t ) UptimeSecondsGet();
+}
+
 static struct DefenderMetric_s xDefenderMetricUptimeS =
 {
     UptimeRefresh,
     UptimeReportGet,
+    prvUptimeValue,
 };
 
 DefenderMetric_t xDefenderMetricUptime = &xDefenderMetricUptimeS;
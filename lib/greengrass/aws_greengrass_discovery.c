@@ -51,6 +51,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 /**
  * @brief Discovery: Strings for JSON file parsing.
@@ -59,7 +60,10 @@
  * the certificate and IP address.
  */
 /** @{ */
+#define ggdJSON_FILE_GROUPS          "GGGroups"
 #define ggdJSON_FILE_GROUPID         "GGGroupId"
+#define ggdJSON_FILE_CORES           "Cores"
+#define ggdJSON_FILE_CONNECTIVITY    "Connectivity"
 #define ggdJSON_FILE_THING_ARN       "thingArn"
 #define ggdJSON_FILE_HOST_ADDRESS    "HostAddress"
 #define ggdJSON_FILE_CERTIFICATE     "CAs"
@@ -73,6 +77,14 @@
     "GET /greengrass/discover/thing/%s" \
     " HTTP/1.1\r\n\r\n"
 
+/**
+ * @brief HTTP command to retrieve JSON file from the Cloud, only when it
+ * differs from the cached version.
+ */
+#define ggdCLOUD_DISCOVERY_ADDRESS_IF_NONE_MATCH \
+    "GET /greengrass/discover/thing/%s"          \
+    " HTTP/1.1\r\nIf-None-Match: %s\r\n\r\n"
+
 #define ggJSON_CONVERTION_RADIX    10
 
 /**
@@ -104,6 +116,159 @@
  */
 #define ggdLOOP_BACK_IP            "127.0.0.1"
 
+/**
+ * @brief Streaming JSON parser limits.
+ *
+ * The discovery document nests 7 levels deep, keys longer than
+ * ggdSTREAM_KEY_SIZE - 1 characters are not looked at.
+ */
+/** @{ */
+#define ggdSTREAM_MAX_DEPTH    10
+#define ggdSTREAM_KEY_SIZE     16
+/** @} */
+
+/**
+ * @brief Role of a JSON container in the discovery document.
+ */
+typedef enum
+{
+    eGGDRoleOther = 0, /**< Not used by the discovery. */
+    eGGDRoleRoot,      /**< The outer object. */
+    eGGDRoleGroup,     /**< An element of "GGGroups". */
+    eGGDRoleCore,      /**< An element of "Cores". */
+    eGGDRoleEntry      /**< An element of "Connectivity". */
+} GGD_StreamRole_t;
+
+/**
+ * @brief Keys of the discovery document that are recognised while streaming.
+ */
+typedef enum
+{
+    eGGDKeyOther = 0,
+    eGGDKeyGroups,
+    eGGDKeyGroupId,
+    eGGDKeyCores,
+    eGGDKeyThingArn,
+    eGGDKeyConnectivity,
+    eGGDKeyHostAddress,
+    eGGDKeyPortNumber,
+    eGGDKeyCertificate
+} GGD_StreamKey_t;
+
+/**
+ * @brief What happens with the characters of the current string or literal.
+ */
+typedef enum
+{
+    eGGDTargetSkip = 0, /**< Ignored. */
+    eGGDTargetKey,      /**< Stored in cKey. */
+    eGGDTargetCompare,  /**< Compared with pcCompare. */
+    eGGDTargetHost,     /**< Appended to the user buffer as host address. */
+    eGGDTargetCA,       /**< Appended to the user buffer as group CA. */
+    eGGDTargetPort      /**< Converted to usEntryPort. */
+} GGD_StreamTarget_t;
+
+/**
+ * @brief One level of nesting: the container type, its role and, for an
+ * object, the key of the value being parsed.  An array keeps the key it was
+ * stored under and the role of the object that holds it.
+ */
+typedef struct
+{
+    uint8_t ucIsArray;
+    uint8_t ucRole;
+    uint8_t ucKey;
+} GGD_StreamLevel_t;
+
+/**
+ * @brief State of the streaming parser.
+ *
+ * Host addresses and the group CA are written to the user buffer as they
+ * arrive.  When a core or group turns out not to be the selected one, the
+ * write index falls back to where that object started.
+ */
+typedef struct
+{
+    const HostParameters_t * pxHostParameters; /**< NULL for auto selection. */
+    char * pcBuffer;                           /**< Storage for the host addresses and the CA. */ /*lint !e971 can use char without signed/unsigned. */
+    uint32_t ulBufferSize;
+    uint32_t ulWriteIndex;
+
+    GGD_StreamLevel_t xLevels[ ggdSTREAM_MAX_DEPTH ];
+    uint32_t ulDepth;
+    BaseType_t xExpectKey;  /**< pdTRUE when the next string in an object is a key. */
+    BaseType_t xInString;
+    BaseType_t xInEscape;
+    BaseType_t xInLiteral;  /**< Inside a number, true, false or null. */
+    uint8_t ucTarget;       /**< One of GGD_StreamTarget_t. */
+    char cKey[ ggdSTREAM_KEY_SIZE ]; /*lint !e971 can use char without signed/unsigned. */
+    uint32_t ulKeyLength;
+    const char * pcCompare;          /*lint !e971 can use char without signed/unsigned. */
+    uint32_t ulCompareIndex;
+    BaseType_t xCompareMatch;
+
+    BaseType_t xEntryHasHost;
+    BaseType_t xEntryHasPort;
+    uint32_t ulEntryHost;
+    uint16_t usEntryPort;
+
+    BaseType_t xCoreMatch;
+    uint32_t ulCoreWriteMark;
+    uint32_t ulCoreEntryMark;
+
+    BaseType_t xGroupMatch;
+    BaseType_t xGroupHasCA;
+    uint32_t ulGroupCA;
+    uint32_t ulGroupWriteMark;
+
+    uint32_t ulEntryHosts[ ggdconfigSTREAM_MAX_CONNECTIVITY ];
+    uint16_t usEntryPorts[ ggdconfigSTREAM_MAX_CONNECTIVITY ];
+    uint32_t ulEntryCount;
+
+    BaseType_t xDone;  /**< A group with a CA and at least one suitable entry was found. */
+    BaseType_t xError;
+} GGD_StreamParser_t;
+
+#if ( ggdconfigDISCOVERY_CACHE == 1 )
+
+/**
+ * @brief HTTP response fields used to revalidate the cached discovery result.
+ */
+/** @{ */
+    #define ggdHTTP_STATUS_OK              ( 200UL )
+    #define ggdHTTP_STATUS_NOT_MODIFIED    ( 304UL )
+    #define ggdHTTP_ETAG_STRING            "etag:"
+    #define ggdHTTP_HEADER_LINE_SIZE       ( ggdconfigDISCOVERY_CACHE_ETAG_SIZE + 16 )
+/** @} */
+
+/**
+ * @brief The result of the latest discovery.
+ *
+ * The structure is handed as a whole to ggdconfigDISCOVERY_CACHE_STORE and
+ * ggdconfigDISCOVERY_CACHE_LOAD, ulStructSize detects an image that was
+ * stored with a different configuration.
+ */
+    typedef struct
+    {
+        uint32_t ulStructSize;                                /**< sizeof( GGD_DiscoveryCache_t ) when the entry is valid. */
+        uint16_t usPort;                                      /**< Port of the core. */
+        uint32_t ulCertificateSize;                           /**< Size of the group CA, including the terminating zero. */
+        char cHostAddress[ ggdconfigDISCOVERY_CACHE_HOST_SIZE ]; /*lint !e971 can use char without signed/unsigned. */
+        char cCertificate[ ggdconfigDISCOVERY_CACHE_CERT_SIZE ]; /*lint !e971 can use char without signed/unsigned. */
+        char cETag[ ggdconfigDISCOVERY_CACHE_ETAG_SIZE ];     /*lint !e971 can use char without signed/unsigned. */
+    } GGD_DiscoveryCache_t;
+
+    static GGD_DiscoveryCache_t xDiscoveryCache;
+
+/* pdTRUE once ggdconfigDISCOVERY_CACHE_LOAD has been called. */
+    static BaseType_t xDiscoveryCacheLoaded = pdFALSE;
+
+/* pdTRUE when xDiscoveryCacheTime is known, it is not after loading the
+ * cache from non-volatile memory. */
+    static BaseType_t xDiscoveryCacheTimed = pdFALSE;
+    static TickType_t xDiscoveryCacheTime;
+#endif /* if ( ggdconfigDISCOVERY_CACHE == 1 ) */
+
 /**
  * @brief JSON parsing helper functions.
  *
@@ -154,6 +319,66 @@ static BaseType_t prvIsIPvalid( const char * pcIP,
 static BaseType_t prvCheckForContentLengthString( uint8_t * pucIndex,
                                                   const char cNewChar ); /*lint !e971 can use char without signed/unsigned. */
 
+/**
+ * @brief Connect to the cloud and send the discovery request.
+ *
+ * When pcETag is not NULL, the request carries an If-None-Match field.
+ */
+static BaseType_t prvJSONRequestStart( Socket_t * pxSocket,
+                                       const char * pcETag ); /*lint !e971 can use char without signed/unsigned. */
+
+#if ( ggdconfigDISCOVERY_CACHE == 1 )
+
+/**
+ * @brief Discovery cache helper functions.
+ */
+/** @{ */
+    static BaseType_t prvReadHeaderLine( Socket_t * pxSocket,
+                                         char * pcLine, /*lint !e971 can use char without signed/unsigned. */
+                                         const uint32_t ulLineSize );
+    static BaseType_t prvHeaderFieldIs( const char * pcLine, /*lint !e971 can use char without signed/unsigned. */
+                                        const char * pcName );
+    static BaseType_t prvJSONRequestGetHeader( Socket_t * pxSocket,
+                                               uint32_t * pulJSONFileSize,
+                                               BaseType_t * pxNotModified,
+                                               char * pcETag ); /*lint !e971 can use char without signed/unsigned. */
+    static BaseType_t prvCacheIsFresh( void );
+    static BaseType_t prvCacheGet( char * pcBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                   const uint32_t ulBufferSize,
+                                   GGD_HostAddressData_t * pxHostAddressData );
+    static void prvCacheSet( const GGD_HostAddressData_t * pxHostAddressData,
+                             const char * pcETag ); /*lint !e971 can use char without signed/unsigned. */
+/** @} */
+#endif /* if ( ggdconfigDISCOVERY_CACHE == 1 ) */
+
+/**
+ * @brief Streaming JSON parse helper functions.
+ *
+ * The discovery document is read in chunks of ggdconfigSTREAM_CHUNK_SIZE bytes
+ * and scanned one character at a time, only the selected core's
+ * connectivity entries and its group CA are kept.
+ */
+/** @{ */
+static BaseType_t prvGGDStreamJSON( Socket_t * pxSocket,
+                                    const uint32_t ulJSONFileSize,
+                                    char * pcBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                    const uint32_t ulBufferSize,
+                                    const HostParameters_t * pxHostParameters,
+                                    const BaseType_t xAutoSelectFlag,
+                                    GGD_HostAddressData_t * pxHostAddressData );
+static void prvStreamParseChar( GGD_StreamParser_t * pxParser,
+                                char cChar ); /*lint !e971 can use char without signed/unsigned. */
+static void prvStreamStartString( GGD_StreamParser_t * pxParser );
+static void prvStreamStringChar( GGD_StreamParser_t * pxParser,
+                                 char cChar ); /*lint !e971 can use char without signed/unsigned. */
+static void prvStreamEndString( GGD_StreamParser_t * pxParser );
+static void prvStreamOpen( GGD_StreamParser_t * pxParser,
+                           const BaseType_t xIsArray );
+static void prvStreamClose( GGD_StreamParser_t * pxParser );
+static void prvStreamAppend( GGD_StreamParser_t * pxParser,
+                             char cChar ); /*lint !e971 can use char without signed/unsigned. */
+/** @} */
+
 /*-----------------------------------------------------------*/
 
 BaseType_t GGD_GetGGCIPandCertificate( char * pcBuffer, /*lint !e971 can use char without signed/unsigned. */
@@ -165,18 +390,91 @@ BaseType_t GGD_GetGGCIPandCertificate( char * pcBuffer, /*lint !e971 can use cha
     BaseType_t xJSONFileRetrieveCompleted = pdFALSE;
     uint32_t ulByteRead = 0;
     BaseType_t xStatus;
+    BaseType_t xFromCache = pdFALSE;
+    BaseType_t xStreamed = pdFALSE;
+
+    #if ( ggdconfigDISCOVERY_CACHE == 1 )
+        BaseType_t xNotModified = pdFALSE;
+        char cETag[ ggdconfigDISCOVERY_CACHE_ETAG_SIZE ]; /*lint !e971 can use char without signed/unsigned. */
+    #endif
 
     configASSERT( pxHostAddressData != NULL );
     configASSERT( pcBuffer != NULL );
 
-    xStatus = GGD_JSONRequestStart( &xSocket );
+    #if ( ggdconfigDISCOVERY_CACHE == 1 )
+        {
+            if( xDiscoveryCacheLoaded == pdFALSE )
+            {
+                xDiscoveryCacheLoaded = pdTRUE;
 
-    if( xStatus == pdPASS )
-    {
-        xStatus = GGD_JSONRequestGetSize( &xSocket, &ulJSONFileSize );
-    }
+                if( ( ggdconfigDISCOVERY_CACHE_LOAD( &xDiscoveryCache, sizeof( xDiscoveryCache ) ) != pdPASS ) ||
+                    ( xDiscoveryCache.ulStructSize != ( uint32_t ) sizeof( xDiscoveryCache ) ) )
+                {
+                    xDiscoveryCache.ulStructSize = 0;
+                }
+            }
 
-    if( xStatus == pdPASS )
+            if( prvCacheIsFresh() == pdTRUE )
+            {
+                xFromCache = pdTRUE;
+                xStatus = pdPASS;
+            }
+            else
+            {
+                /* Ask the cloud, but only for a document that differs from
+                 * the cached one. */
+                xStatus = prvJSONRequestStart( &xSocket,
+                                               ( ( xDiscoveryCache.ulStructSize != 0UL ) &&
+                                                 ( xDiscoveryCache.cETag[ 0 ] != '\0' ) ) ? xDiscoveryCache.cETag : NULL );
+
+                if( xStatus == pdPASS )
+                {
+                    xStatus = prvJSONRequestGetHeader( &xSocket, &ulJSONFileSize, &xNotModified, cETag );
+                }
+
+                if( ( xStatus == pdPASS ) && ( xNotModified == pdTRUE ) )
+                {
+                    GGD_SecureConnect_Disconnect( &xSocket );
+                    xDiscoveryCacheTime = xTaskGetTickCount();
+                    xDiscoveryCacheTimed = pdTRUE;
+                    xFromCache = pdTRUE;
+                }
+            }
+
+            if( xFromCache == pdTRUE )
+            {
+                xStatus = prvCacheGet( pcBuffer, ulBufferSize, pxHostAddressData );
+            }
+        }
+    #else /* if ( ggdconfigDISCOVERY_CACHE == 1 ) */
+        {
+            xStatus = GGD_JSONRequestStart( &xSocket );
+
+            if( xStatus == pdPASS )
+            {
+                xStatus = GGD_JSONRequestGetSize( &xSocket, &ulJSONFileSize );
+            }
+        }
+    #endif /* if ( ggdconfigDISCOVERY_CACHE == 1 ) */
+
+    #if ( ggdconfigDISCOVERY_STREAM_PARSE == 1 )
+        {
+            if( ( xStatus == pdPASS ) && ( xFromCache == pdFALSE ) )
+            {
+                /* Parse while reading, pcBuffer only receives the result. */
+                xStatus = prvGGDStreamJSON( &xSocket,
+                                            ulJSONFileSize,
+                                            pcBuffer,
+                                            ulBufferSize,
+                                            NULL,
+                                            pdTRUE,
+                                            pxHostAddressData );
+                xStreamed = pdTRUE;
+            }
+        }
+    #endif
+
+    if( ( xStatus == pdPASS ) && ( xFromCache == pdFALSE ) && ( xStreamed == pdFALSE ) )
     {
         /* Loop until the full JSON is retrieved. */
         do
@@ -213,7 +511,7 @@ BaseType_t GGD_GetGGCIPandCertificate( char * pcBuffer, /*lint !e971 can use cha
         }
     }
 
-    if( xStatus == pdPASS )
+    if( ( xStatus == pdPASS ) && ( xFromCache == pdFALSE ) && ( xStreamed == pdFALSE ) )
     {
         xStatus = GGD_GetIPandCertificateFromJSON( pcBuffer,
                                                    ulJSONFileSize,
@@ -222,11 +520,79 @@ BaseType_t GGD_GetGGCIPandCertificate( char * pcBuffer, /*lint !e971 can use cha
                                                    pdTRUE );
     }
 
+    #if ( ggdconfigDISCOVERY_CACHE == 1 )
+        {
+            if( ( xStatus == pdPASS ) && ( xFromCache == pdFALSE ) )
+            {
+                prvCacheSet( pxHostAddressData, cETag );
+            }
+        }
+    #endif
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t GGD_GetGGCIPandCertificateStreamed( char * pcBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                               const uint32_t ulBufferSize,
+                                               const HostParameters_t * pxHostParameters,
+                                               GGD_HostAddressData_t * pxHostAddressData,
+                                               const BaseType_t xAutoSelectFlag )
+{
+    Socket_t xSocket;
+    uint32_t ulJSONFileSize = 0;
+    BaseType_t xStatus;
+
+    configASSERT( pxHostAddressData != NULL );
+    configASSERT( pcBuffer != NULL );
+
+    if( xAutoSelectFlag == pdFALSE )
+    {
+        configASSERT( pxHostParameters != NULL );
+    }
+
+    xStatus = GGD_JSONRequestStart( &xSocket );
+
+    if( xStatus == pdPASS )
+    {
+        xStatus = GGD_JSONRequestGetSize( &xSocket, &ulJSONFileSize );
+    }
+
+    if( xStatus == pdPASS )
+    {
+        xStatus = prvGGDStreamJSON( &xSocket,
+                                    ulJSONFileSize,
+                                    pcBuffer,
+                                    ulBufferSize,
+                                    pxHostParameters,
+                                    xAutoSelectFlag,
+                                    pxHostAddressData );
+    }
+
     return xStatus;
 }
 /*-----------------------------------------------------------*/
 
+void GGD_DiscoveryCacheInvalidate( void )
+{
+    #if ( ggdconfigDISCOVERY_CACHE == 1 )
+        {
+            xDiscoveryCache.ulStructSize = 0;
+            xDiscoveryCacheTimed = pdFALSE;
+            ggdconfigDISCOVERY_CACHE_STORE( &xDiscoveryCache, sizeof( xDiscoveryCache ) );
+        }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t GGD_JSONRequestStart( Socket_t * pxSocket )
+{
+    return prvJSONRequestStart( pxSocket, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvJSONRequestStart( Socket_t * pxSocket,
+                                       const char * pcETag ) /*lint !e971 can use char without signed/unsigned. */
 {
     GGD_HostAddressData_t xHostAddressData;
     char * pcHttpGetRequest = NULL;
@@ -250,8 +616,18 @@ BaseType_t GGD_JSONRequestStart( Socket_t * pxSocket )
     if( xStatus == pdPASS )
     {
         /* Build the HTTP GET request string that is specific to this host. */
-        ulHttpGetLength = 1 + strlen( ggdCLOUD_DISCOVERY_ADDRESS ) +
-                          strlen( clientcredentialIOT_THING_NAME );
+        if( pcETag == NULL )
+        {
+            ulHttpGetLength = 1 + strlen( ggdCLOUD_DISCOVERY_ADDRESS ) +
+                              strlen( clientcredentialIOT_THING_NAME );
+        }
+        else
+        {
+            ulHttpGetLength = 1 + strlen( ggdCLOUD_DISCOVERY_ADDRESS_IF_NONE_MATCH ) +
+                              strlen( clientcredentialIOT_THING_NAME ) +
+                              strlen( pcETag );
+        }
+
         pcHttpGetRequest = pvPortMalloc( ulHttpGetLength );
 
         if( NULL == pcHttpGetRequest )
@@ -260,10 +636,21 @@ BaseType_t GGD_JSONRequestStart( Socket_t * pxSocket )
         }
         else
         {
-            ulCharsWritten = snprintf( pcHttpGetRequest,
-                                       ulHttpGetLength,
-                                       ggdCLOUD_DISCOVERY_ADDRESS,
-                                       clientcredentialIOT_THING_NAME );
+            if( pcETag == NULL )
+            {
+                ulCharsWritten = snprintf( pcHttpGetRequest,
+                                           ulHttpGetLength,
+                                           ggdCLOUD_DISCOVERY_ADDRESS,
+                                           clientcredentialIOT_THING_NAME );
+            }
+            else
+            {
+                ulCharsWritten = snprintf( pcHttpGetRequest,
+                                           ulHttpGetLength,
+                                           ggdCLOUD_DISCOVERY_ADDRESS_IF_NONE_MATCH,
+                                           clientcredentialIOT_THING_NAME,
+                                           pcETag );
+            }
 
             if( ulCharsWritten >= ulHttpGetLength )
             {
@@ -494,7 +881,9 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
     uint32_t ulTokenIndex = 0;
     uint8_t ucCurrentInterface = 0, ucTargetInterface = 1;
     BaseType_t xFoundGGC = pdFALSE;
-    BaseType_t xIsIPValid;
+    BaseType_t xMoreInterfaces = pdPASS;
+    GGD_HostAddressData_t xCandidates[ ggdconfigMAX_PARALLEL_CONNECTS ];
+    uint32_t ulCandidates = 0, ulSelected;
 
     configASSERT( pcJSONFile != NULL );
     configASSERT( pxHostAddressData != NULL );
@@ -581,33 +970,48 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
         }
         else
         {
-            while( prvGGDGetIPOnInterface( pcJSONFile,
-                                           ucTargetInterface,
-                                           pxTok,
-                                           ( uint32_t ) lNbTokens,
-                                           pxHostAddressData,
-                                           &ulTokenIndex,
-                                           &ucCurrentInterface ) == pdPASS )
+            /* Collect the valid interfaces in groups that can be tried in parallel. */
+            while( ( xFoundGGC == pdFALSE ) && ( xMoreInterfaces == pdPASS ) )
             {
-                xIsIPValid = prvIsIPvalid( ( const char * ) pxHostAddressData->pcHostAddress,
-                                           strlen( pxHostAddressData->pcHostAddress ) );
+                xMoreInterfaces = prvGGDGetIPOnInterface( pcJSONFile,
+                                                          ucTargetInterface,
+                                                          pxTok,
+                                                          ( uint32_t ) lNbTokens,
+                                                          pxHostAddressData,
+                                                          &ulTokenIndex,
+                                                          &ucCurrentInterface );
+
+                if( xMoreInterfaces == pdPASS )
+                {
+                    if( prvIsIPvalid( ( const char * ) pxHostAddressData->pcHostAddress,
+                                      strlen( pxHostAddressData->pcHostAddress ) ) == pdTRUE )
+                    {
+                        xCandidates[ ulCandidates ] = *pxHostAddressData;
+                        ulCandidates++;
+                    }
+
+                    ucTargetInterface++;
+                }
 
-                if( xIsIPValid == pdTRUE )
+                if( ( ulCandidates == ( uint32_t ) ggdconfigMAX_PARALLEL_CONNECTS ) ||
+                    ( ( xMoreInterfaces == pdFAIL ) && ( ulCandidates > ( uint32_t ) 0 ) ) )
                 {
-                    if( GGD_SecureConnect_Connect( pxHostAddressData,
-                                                   &xSocket,
-                                                   ggdconfigTCP_RECEIVE_TIMEOUT_MS,
-                                                   ggdconfigTCP_SEND_TIMEOUT_MS )
+                    if( GGD_SecureConnect_ConnectFirst( xCandidates,
+                                                        ulCandidates,
+                                                        &xSocket,
+                                                        &ulSelected,
+                                                        ggdconfigTCP_RECEIVE_TIMEOUT_MS,
+                                                        ggdconfigTCP_SEND_TIMEOUT_MS )
                         == pdPASS )
                     {
                         xFoundGGC = pdTRUE;
+                        *pxHostAddressData = xCandidates[ ulSelected ];
                         /* Interface found, disconnect. */
                         GGD_SecureConnect_Disconnect( &xSocket );
-                        break;
                     }
-                }
 
-                ucTargetInterface++;
+                    ulCandidates = 0;
+                }
             }
         }
 
@@ -921,6 +1325,882 @@ static BaseType_t prvCheckForContentLengthString( uint8_t * pucIndex,
     return xMatch;
 }
 /*-----------------------------------------------------------*/
+
+static BaseType_t prvGGDStreamJSON( Socket_t * pxSocket,
+                                    const uint32_t ulJSONFileSize,
+                                    char * pcBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                    const uint32_t ulBufferSize,
+                                    const HostParameters_t * pxHostParameters,
+                                    const BaseType_t xAutoSelectFlag,
+                                    GGD_HostAddressData_t * pxHostAddressData )
+{
+    GGD_StreamParser_t xParser;
+    char cChunk[ ggdconfigSTREAM_CHUNK_SIZE ]; /*lint !e971 can use char without signed/unsigned. */
+    uint32_t ulRemaining = ulJSONFileSize - ( uint32_t ) 1;
+    uint32_t ulRequestSize;
+    uint32_t ulReadSize;
+    uint32_t ulIndex;
+    Socket_t xCoreSocket;
+    BaseType_t xStatus = pdPASS;
+    GGD_HostAddressData_t xCandidates[ ggdconfigMAX_PARALLEL_CONNECTS ];
+    uint32_t ulCandidates = 0, ulSelected;
+
+    memset( &xParser, 0, sizeof( xParser ) );
+    xParser.pxHostParameters = ( xAutoSelectFlag == pdFALSE ) ? pxHostParameters : NULL;
+    xParser.pcBuffer = pcBuffer;
+    xParser.ulBufferSize = ulBufferSize;
+
+    /* Feed the document to the parser until the selected group is complete. */
+    while( ( xStatus == pdPASS ) && ( ulRemaining > ( uint32_t ) 0 ) && ( xParser.xDone == pdFALSE ) )
+    {
+        ulRequestSize = ( ulRemaining < ( uint32_t ) sizeof( cChunk ) ) ? ulRemaining : ( uint32_t ) sizeof( cChunk );
+
+        xStatus = GGD_SecureConnect_Read( cChunk,
+                                          ulRequestSize,
+                                          *pxSocket,
+                                          &ulReadSize );
+
+        if( ( xStatus == pdPASS ) && ( ulReadSize <= ulRequestSize ) )
+        {
+            for( ulIndex = 0;
+                 ( ulIndex < ulReadSize ) && ( xParser.xDone == pdFALSE ) && ( xParser.xError == pdFALSE );
+                 ulIndex++ )
+            {
+                prvStreamParseChar( &xParser, cChunk[ ulIndex ] );
+            }
+
+            ulRemaining -= ulReadSize;
+
+            if( xParser.xError == pdTRUE )
+            {
+                xStatus = pdFAIL;
+            }
+        }
+        else
+        {
+            xStatus = pdFAIL;
+        }
+    }
+
+    /* The rest of the document is not needed. */
+    GGD_SecureConnect_Disconnect( pxSocket );
+
+    if( ( xStatus == pdPASS ) && ( xParser.xDone == pdFALSE ) )
+    {
+        ggdconfigPRINT( "JSON parsing: Couldn't find Green Grass Core\r\n" );
+        xStatus = pdFAIL;
+    }
+
+    if( xStatus == pdPASS )
+    {
+        pxHostAddressData->pcCertificate = &pcBuffer[ xParser.ulGroupCA ];
+        pxHostAddressData->ulCertificateSize = ( uint32_t ) strlen( pxHostAddressData->pcCertificate ) + ( uint32_t ) 1;
+        xStatus = pdFAIL;
+
+        if( xAutoSelectFlag == pdFALSE )
+        {
+            /* Interfaces are numbered from 1. */
+            ulIndex = ( uint32_t ) pxHostParameters->ucInterface - ( uint32_t ) 1;
+
+            if( ( pxHostParameters->ucInterface != ( uint8_t ) 0 ) && ( ulIndex < xParser.ulEntryCount ) )
+            {
+                pxHostAddressData->pcHostAddress = &pcBuffer[ xParser.ulEntryHosts[ ulIndex ] ];
+                pxHostAddressData->usPort = xParser.usEntryPorts[ ulIndex ];
+                xStatus = pdPASS;
+            }
+            else
+            {
+                ggdconfigPRINT( "GGC - Can't find interface\r\n" );
+            }
+        }
+        else
+        {
+            /* Take the first interface that accepts a connection, trying them in
+             * groups that can be connected to in parallel. */
+            for( ulIndex = 0; ( ulIndex < xParser.ulEntryCount ) && ( xStatus != pdPASS ); ulIndex++ )
+            {
+                pxHostAddressData->pcHostAddress = &pcBuffer[ xParser.ulEntryHosts[ ulIndex ] ];
+                pxHostAddressData->usPort = xParser.usEntryPorts[ ulIndex ];
+
+                if( prvIsIPvalid( pxHostAddressData->pcHostAddress,
+                                  strlen( pxHostAddressData->pcHostAddress ) ) == pdTRUE )
+                {
+                    xCandidates[ ulCandidates ] = *pxHostAddressData;
+                    ulCandidates++;
+                }
+
+                if( ( ulCandidates == ( uint32_t ) ggdconfigMAX_PARALLEL_CONNECTS ) ||
+                    ( ( ulIndex == ( xParser.ulEntryCount - ( uint32_t ) 1 ) ) && ( ulCandidates > ( uint32_t ) 0 ) ) )
+                {
+                    if( GGD_SecureConnect_ConnectFirst( xCandidates,
+                                                        ulCandidates,
+                                                        &xCoreSocket,
+                                                        &ulSelected,
+                                                        ggdconfigTCP_RECEIVE_TIMEOUT_MS,
+                                                        ggdconfigTCP_SEND_TIMEOUT_MS )
+                        == pdPASS )
+                    {
+                        *pxHostAddressData = xCandidates[ ulSelected ];
+                        /* Interface found, disconnect. */
+                        GGD_SecureConnect_Disconnect( &xCoreSocket );
+                        xStatus = pdPASS;
+                    }
+
+                    ulCandidates = 0;
+                }
+            }
+
+            if( xStatus != pdPASS )
+            {
+                ggdconfigPRINT( "GGD - Can't connect to greengrass Core\r\n" );
+            }
+        }
+    }
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamParseChar( GGD_StreamParser_t * pxParser,
+                                char cChar ) /*lint !e971 can use char without signed/unsigned. */
+{
+    BaseType_t xConsumed = pdFALSE;
+
+    if( pxParser->xInString == pdTRUE )
+    {
+        xConsumed = pdTRUE;
+
+        if( pxParser->xInEscape == pdTRUE )
+        {
+            pxParser->xInEscape = pdFALSE;
+
+            /* '"', '\\' and '/' stand for themselves. */
+            if( cChar == 'n' )
+            {
+                cChar = '\n';
+            }
+            else if( cChar == 'r' )
+            {
+                cChar = '\r';
+            }
+            else if( cChar == 't' )
+            {
+                cChar = '\t';
+            }
+            else
+            {
+                /* No conversion. */
+            }
+
+            prvStreamStringChar( pxParser, cChar );
+        }
+        else if( cChar == '\\' )
+        {
+            pxParser->xInEscape = pdTRUE;
+        }
+        else if( cChar == '"' )
+        {
+            pxParser->xInString = pdFALSE;
+            prvStreamEndString( pxParser );
+        }
+        else
+        {
+            prvStreamStringChar( pxParser, cChar );
+        }
+    }
+    else if( pxParser->xInLiteral == pdTRUE )
+    {
+        if( ( isalnum( ( int ) cChar ) != 0 ) || ( cChar == '-' ) || ( cChar == '+' ) || ( cChar == '.' ) )
+        {
+            xConsumed = pdTRUE;
+            prvStreamStringChar( pxParser, cChar );
+        }
+        else
+        {
+            /* The literal ends here, the character itself is handled below. */
+            pxParser->xInLiteral = pdFALSE;
+            prvStreamEndString( pxParser );
+        }
+    }
+    else
+    {
+        /* Not in a string or literal. */
+    }
+
+    if( xConsumed == pdFALSE )
+    {
+        switch( cChar )
+        {
+            case '{':
+                prvStreamOpen( pxParser, pdFALSE );
+                break;
+
+            case '[':
+                prvStreamOpen( pxParser, pdTRUE );
+                break;
+
+            case '}':
+            case ']':
+                prvStreamClose( pxParser );
+                break;
+
+            case '"':
+                pxParser->xInString = pdTRUE;
+                prvStreamStartString( pxParser );
+                break;
+
+            case ',':
+
+                if( ( pxParser->ulDepth > ( uint32_t ) 0 ) &&
+                    ( pxParser->xLevels[ pxParser->ulDepth - ( uint32_t ) 1 ].ucIsArray == ( uint8_t ) 0 ) )
+                {
+                    pxParser->xExpectKey = pdTRUE;
+                }
+
+                break;
+
+            case ':':
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                break;
+
+            default:
+
+                if( pxParser->xExpectKey == pdTRUE )
+                {
+                    ggdconfigPRINT( "JSON parsing: Failed to parse JSON\r\n" );
+                    pxParser->xError = pdTRUE;
+                }
+                else
+                {
+                    /* A number, true, false or null. */
+                    pxParser->xInLiteral = pdTRUE;
+                    prvStreamStartString( pxParser );
+                    prvStreamStringChar( pxParser, cChar );
+                }
+
+                break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamStartString( GGD_StreamParser_t * pxParser )
+{
+    const GGD_StreamLevel_t * pxTop;
+
+    pxParser->ucTarget = ( uint8_t ) eGGDTargetSkip;
+
+    if( pxParser->ulDepth > ( uint32_t ) 0 )
+    {
+        pxTop = &pxParser->xLevels[ pxParser->ulDepth - ( uint32_t ) 1 ];
+
+        if( pxTop->ucIsArray != ( uint8_t ) 0 )
+        {
+            /* Only the first element of the "CAs" array is used. */
+            if( ( pxTop->ucRole == ( uint8_t ) eGGDRoleGroup ) &&
+                ( pxTop->ucKey == ( uint8_t ) eGGDKeyCertificate ) &&
+                ( pxParser->xGroupHasCA == pdFALSE ) &&
+                ( pxParser->xInString == pdTRUE ) )
+            {
+                pxParser->ucTarget = ( uint8_t ) eGGDTargetCA;
+                pxParser->ulGroupCA = pxParser->ulWriteIndex;
+            }
+        }
+        else if( pxParser->xExpectKey == pdTRUE )
+        {
+            pxParser->ucTarget = ( uint8_t ) eGGDTargetKey;
+            pxParser->ulKeyLength = 0;
+        }
+        else if( ( pxTop->ucRole == ( uint8_t ) eGGDRoleGroup ) &&
+                 ( pxTop->ucKey == ( uint8_t ) eGGDKeyGroupId ) &&
+                 ( pxParser->pxHostParameters != NULL ) )
+        {
+            pxParser->ucTarget = ( uint8_t ) eGGDTargetCompare;
+            pxParser->pcCompare = pxParser->pxHostParameters->pcGroupName;
+        }
+        else if( ( pxTop->ucRole == ( uint8_t ) eGGDRoleCore ) &&
+                 ( pxTop->ucKey == ( uint8_t ) eGGDKeyThingArn ) &&
+                 ( pxParser->pxHostParameters != NULL ) )
+        {
+            pxParser->ucTarget = ( uint8_t ) eGGDTargetCompare;
+            pxParser->pcCompare = pxParser->pxHostParameters->pcCoreAddress;
+        }
+        else if( ( pxTop->ucRole == ( uint8_t ) eGGDRoleEntry ) &&
+                 ( pxTop->ucKey == ( uint8_t ) eGGDKeyHostAddress ) &&
+                 ( pxParser->xInString == pdTRUE ) )
+        {
+            pxParser->ucTarget = ( uint8_t ) eGGDTargetHost;
+            pxParser->ulEntryHost = pxParser->ulWriteIndex;
+        }
+        else if( ( pxTop->ucRole == ( uint8_t ) eGGDRoleEntry ) &&
+                 ( pxTop->ucKey == ( uint8_t ) eGGDKeyPortNumber ) )
+        {
+            pxParser->ucTarget = ( uint8_t ) eGGDTargetPort;
+            pxParser->usEntryPort = 0;
+        }
+        else
+        {
+            /* Not used. */
+        }
+    }
+
+    if( pxParser->ucTarget == ( uint8_t ) eGGDTargetCompare )
+    {
+        pxParser->ulCompareIndex = 0;
+        pxParser->xCompareMatch = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamStringChar( GGD_StreamParser_t * pxParser,
+                                 char cChar ) /*lint !e971 can use char without signed/unsigned. */
+{
+    switch( pxParser->ucTarget )
+    {
+        case eGGDTargetKey:
+
+            /* Longer keys are not recognised. */
+            if( pxParser->ulKeyLength < ( uint32_t ) ( ggdSTREAM_KEY_SIZE - 1 ) )
+            {
+                pxParser->cKey[ pxParser->ulKeyLength ] = cChar;
+            }
+
+            if( pxParser->ulKeyLength < ( uint32_t ) ggdSTREAM_KEY_SIZE )
+            {
+                pxParser->ulKeyLength++;
+            }
+
+            break;
+
+        case eGGDTargetCompare:
+
+            if( pxParser->pcCompare[ pxParser->ulCompareIndex ] == cChar )
+            {
+                pxParser->ulCompareIndex++;
+            }
+            else
+            {
+                pxParser->xCompareMatch = pdFALSE;
+            }
+
+            break;
+
+        case eGGDTargetHost:
+        case eGGDTargetCA:
+            prvStreamAppend( pxParser, cChar );
+            break;
+
+        case eGGDTargetPort:
+
+            if( ( cChar >= '0' ) && ( cChar <= '9' ) )
+            {
+                pxParser->usEntryPort = ( uint16_t ) ( ( pxParser->usEntryPort * ( uint16_t ) ggJSON_CONVERTION_RADIX ) +
+                                                       ( uint16_t ) ( cChar - '0' ) );
+            }
+
+            break;
+
+        default:
+            break;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamEndString( GGD_StreamParser_t * pxParser )
+{
+    /* Only a string at the outer level has no container, it is skipped. */
+    GGD_StreamLevel_t * pxTop = &pxParser->xLevels[ ( pxParser->ulDepth > ( uint32_t ) 0 ) ? ( pxParser->ulDepth - ( uint32_t ) 1 ) : ( uint32_t ) 0 ];
+    BaseType_t xMatch;
+
+    switch( pxParser->ucTarget )
+    {
+        case eGGDTargetKey:
+            pxTop->ucKey = ( uint8_t ) eGGDKeyOther;
+
+            if( pxParser->ulKeyLength < ( uint32_t ) ggdSTREAM_KEY_SIZE )
+            {
+                pxParser->cKey[ pxParser->ulKeyLength ] = '\0';
+
+                if( strcmp( pxParser->cKey, ggdJSON_FILE_GROUPS ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyGroups;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_GROUPID ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyGroupId;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_CORES ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyCores;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_THING_ARN ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyThingArn;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_CONNECTIVITY ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyConnectivity;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_HOST_ADDRESS ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyHostAddress;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_PORT_NUMBER ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyPortNumber;
+                }
+                else if( strcmp( pxParser->cKey, ggdJSON_FILE_CERTIFICATE ) == 0 )
+                {
+                    pxTop->ucKey = ( uint8_t ) eGGDKeyCertificate;
+                }
+                else
+                {
+                    /* Not used. */
+                }
+            }
+
+            pxParser->xExpectKey = pdFALSE;
+            break;
+
+        case eGGDTargetCompare:
+            xMatch = ( ( pxParser->xCompareMatch == pdTRUE ) &&
+                       ( pxParser->pcCompare[ pxParser->ulCompareIndex ] == '\0' ) ) ? pdTRUE : pdFALSE;
+
+            if( pxTop->ucRole == ( uint8_t ) eGGDRoleGroup )
+            {
+                pxParser->xGroupMatch = xMatch;
+            }
+            else
+            {
+                pxParser->xCoreMatch = xMatch;
+            }
+
+            break;
+
+        case eGGDTargetHost:
+            prvStreamAppend( pxParser, '\0' );
+            pxParser->xEntryHasHost = pdTRUE;
+            break;
+
+        case eGGDTargetCA:
+            prvStreamAppend( pxParser, '\0' );
+            pxParser->xGroupHasCA = pdTRUE;
+            break;
+
+        case eGGDTargetPort:
+            pxParser->xEntryHasPort = pdTRUE;
+            break;
+
+        default:
+            break;
+    }
+
+    pxParser->ucTarget = ( uint8_t ) eGGDTargetSkip;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamOpen( GGD_StreamParser_t * pxParser,
+                           const BaseType_t xIsArray )
+{
+    const GGD_StreamLevel_t * pxParent = NULL;
+    GGD_StreamLevel_t * pxLevel;
+
+    if( pxParser->ulDepth >= ( uint32_t ) ggdSTREAM_MAX_DEPTH )
+    {
+        ggdconfigPRINT( "JSON parsing: Failed to parse JSON\r\n" );
+        pxParser->xError = pdTRUE;
+    }
+    else
+    {
+        if( pxParser->ulDepth > ( uint32_t ) 0 )
+        {
+            pxParent = &pxParser->xLevels[ pxParser->ulDepth - ( uint32_t ) 1 ];
+        }
+
+        pxLevel = &pxParser->xLevels[ pxParser->ulDepth ];
+        pxParser->ulDepth++;
+
+        pxLevel->ucIsArray = ( xIsArray == pdTRUE ) ? ( uint8_t ) 1 : ( uint8_t ) 0;
+        pxLevel->ucRole = ( uint8_t ) eGGDRoleOther;
+        pxLevel->ucKey = ( uint8_t ) eGGDKeyOther;
+
+        if( xIsArray == pdTRUE )
+        {
+            /* Remember under which key of which object the array is stored. */
+            if( ( pxParent != NULL ) && ( pxParent->ucIsArray == ( uint8_t ) 0 ) )
+            {
+                pxLevel->ucRole = pxParent->ucRole;
+                pxLevel->ucKey = pxParent->ucKey;
+            }
+        }
+        else if( pxParent == NULL )
+        {
+            pxLevel->ucRole = ( uint8_t ) eGGDRoleRoot;
+        }
+        else if( pxParent->ucIsArray != ( uint8_t ) 0 )
+        {
+            if( ( pxParent->ucRole == ( uint8_t ) eGGDRoleRoot ) && ( pxParent->ucKey == ( uint8_t ) eGGDKeyGroups ) )
+            {
+                pxLevel->ucRole = ( uint8_t ) eGGDRoleGroup;
+                pxParser->xGroupMatch = ( pxParser->pxHostParameters == NULL ) ? pdTRUE : pdFALSE;
+                pxParser->xGroupHasCA = pdFALSE;
+                pxParser->ulGroupWriteMark = pxParser->ulWriteIndex;
+                pxParser->ulEntryCount = 0;
+            }
+            else if( ( pxParent->ucRole == ( uint8_t ) eGGDRoleGroup ) && ( pxParent->ucKey == ( uint8_t ) eGGDKeyCores ) )
+            {
+                pxLevel->ucRole = ( uint8_t ) eGGDRoleCore;
+                pxParser->xCoreMatch = ( pxParser->pxHostParameters == NULL ) ? pdTRUE : pdFALSE;
+                pxParser->ulCoreWriteMark = pxParser->ulWriteIndex;
+                pxParser->ulCoreEntryMark = pxParser->ulEntryCount;
+            }
+            else if( ( pxParent->ucRole == ( uint8_t ) eGGDRoleCore ) && ( pxParent->ucKey == ( uint8_t ) eGGDKeyConnectivity ) )
+            {
+                pxLevel->ucRole = ( uint8_t ) eGGDRoleEntry;
+                pxParser->xEntryHasHost = pdFALSE;
+                pxParser->xEntryHasPort = pdFALSE;
+            }
+            else
+            {
+                /* Not used. */
+            }
+        }
+        else
+        {
+            /* An object inside an object is not used. */
+        }
+
+        pxParser->xExpectKey = ( xIsArray == pdTRUE ) ? pdFALSE : pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamClose( GGD_StreamParser_t * pxParser )
+{
+    const GGD_StreamLevel_t * pxLevel;
+
+    if( pxParser->ulDepth == ( uint32_t ) 0 )
+    {
+        ggdconfigPRINT( "JSON parsing: Failed to parse JSON\r\n" );
+        pxParser->xError = pdTRUE;
+    }
+    else
+    {
+        pxParser->ulDepth--;
+        pxLevel = &pxParser->xLevels[ pxParser->ulDepth ];
+
+        if( pxLevel->ucIsArray != ( uint8_t ) 0 )
+        {
+            /* The role of an array is that of the object holding it. */
+        }
+        else if( pxLevel->ucRole == ( uint8_t ) eGGDRoleEntry )
+        {
+            if( ( pxParser->xEntryHasHost == pdTRUE ) && ( pxParser->xEntryHasPort == pdTRUE ) )
+            {
+                if( pxParser->ulEntryCount < ( uint32_t ) ggdconfigSTREAM_MAX_CONNECTIVITY )
+                {
+                    pxParser->ulEntryHosts[ pxParser->ulEntryCount ] = pxParser->ulEntryHost;
+                    pxParser->usEntryPorts[ pxParser->ulEntryCount ] = pxParser->usEntryPort;
+                    pxParser->ulEntryCount++;
+                }
+            }
+        }
+        else if( pxLevel->ucRole == ( uint8_t ) eGGDRoleCore )
+        {
+            if( pxParser->xCoreMatch == pdFALSE )
+            {
+                /* Not the selected core: forget its entries. */
+                pxParser->ulWriteIndex = pxParser->ulCoreWriteMark;
+                pxParser->ulEntryCount = pxParser->ulCoreEntryMark;
+            }
+        }
+        else if( pxLevel->ucRole == ( uint8_t ) eGGDRoleGroup )
+        {
+            if( ( pxParser->xGroupMatch == pdTRUE ) &&
+                ( pxParser->xGroupHasCA == pdTRUE ) &&
+                ( pxParser->ulEntryCount > ( uint32_t ) 0 ) )
+            {
+                pxParser->xDone = pdTRUE;
+            }
+            else
+            {
+                /* Not the selected group: forget its CA and entries. */
+                pxParser->ulWriteIndex = pxParser->ulGroupWriteMark;
+                pxParser->ulEntryCount = 0;
+            }
+        }
+        else
+        {
+            /* Nothing to do. */
+        }
+
+        pxParser->xExpectKey = pdFALSE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamAppend( GGD_StreamParser_t * pxParser,
+                             char cChar ) /*lint !e971 can use char without signed/unsigned. */
+{
+    if( pxParser->ulWriteIndex < pxParser->ulBufferSize )
+    {
+        pxParser->pcBuffer[ pxParser->ulWriteIndex ] = cChar;
+        pxParser->ulWriteIndex++;
+    }
+    else if( pxParser->xError == pdFALSE )
+    {
+        ggdconfigPRINT( "[ERROR] The supplied buffer is not large enough to hold the selected core and its group CA. \r\n" );
+        pxParser->xError = pdTRUE;
+    }
+    else
+    {
+        /* Already reported. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( ggdconfigDISCOVERY_CACHE == 1 )
+
+    static BaseType_t prvReadHeaderLine( Socket_t * pxSocket,
+                                         char * pcLine, /*lint !e971 can use char without signed/unsigned. */
+                                         const uint32_t ulLineSize )
+    {
+        BaseType_t xStatus;
+        char cReadChar; /*lint !e971 can use char without signed/unsigned. */
+        uint32_t ulReadSize;
+        uint32_t ulLength = 0;
+
+        /* Read up to the next line feed.  The carriage return is dropped,
+         * characters that do not fit in pcLine are skipped. */
+        for( ; ; )
+        {
+            xStatus = GGD_SecureConnect_Read( &cReadChar,
+                                              ( uint32_t ) 1,
+                                              *pxSocket,
+                                              &ulReadSize );
+
+            if( ( xStatus == pdFAIL ) || ( ulReadSize != ( uint32_t ) 1 ) )
+            {
+                xStatus = pdFAIL;
+                break;
+            }
+
+            if( cReadChar == '\n' )
+            {
+                break;
+            }
+
+            if( ( cReadChar != '\r' ) && ( ulLength < ( ulLineSize - ( uint32_t ) 1 ) ) )
+            {
+                pcLine[ ulLength ] = cReadChar;
+                ulLength++;
+            }
+        }
+
+        pcLine[ ulLength ] = '\0';
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+/* Return pdTRUE if the header line pcLine starts with the field name pcName,
+ * which is given in lower case. */
+    static BaseType_t prvHeaderFieldIs( const char * pcLine, /*lint !e971 can use char without signed/unsigned. */
+                                        const char * pcName )
+    {
+        BaseType_t xMatch = pdTRUE;
+
+        while( *pcName != '\0' )
+        {
+            if( tolower( ( int ) *pcLine ) != ( int ) *pcName )
+            {
+                xMatch = pdFALSE;
+                break;
+            }
+
+            pcLine++;
+            pcName++;
+        }
+
+        return xMatch;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvJSONRequestGetHeader( Socket_t * pxSocket,
+                                               uint32_t * pulJSONFileSize,
+                                               BaseType_t * pxNotModified,
+                                               char * pcETag ) /*lint !e971 can use char without signed/unsigned. */
+    {
+        BaseType_t xStatus;
+        BaseType_t xFoundLength = pdFALSE;
+        char cLine[ ggdHTTP_HEADER_LINE_SIZE ]; /*lint !e971 can use char without signed/unsigned. */
+        const char * pcValue;                   /*lint !e971 can use char without signed/unsigned. */
+        uint32_t ulHTTPStatus = 0;
+
+        *pxNotModified = pdFALSE;
+        pcETag[ 0 ] = '\0';
+
+        /* The status line, e.g. "HTTP/1.1 200 OK". */
+        xStatus = prvReadHeaderLine( pxSocket, cLine, sizeof( cLine ) );
+
+        if( xStatus == pdPASS )
+        {
+            pcValue = strchr( cLine, ( int ) ' ' );
+
+            if( pcValue != NULL )
+            {
+                ulHTTPStatus = ( uint32_t ) strtoul( pcValue, NULL, ggJSON_CONVERTION_RADIX );
+            }
+        }
+
+        /* The header fields, up to the empty line. */
+        while( xStatus == pdPASS )
+        {
+            xStatus = prvReadHeaderLine( pxSocket, cLine, sizeof( cLine ) );
+
+            if( ( xStatus == pdFAIL ) || ( cLine[ 0 ] == '\0' ) )
+            {
+                break;
+            }
+
+            if( prvHeaderFieldIs( cLine, ggdHTTP_CONTENT_LENGTH_STRING ) == pdTRUE )
+            {
+                /* Add 1 because at the end of the JSON file the escape character '\0' will be added. */
+                *pulJSONFileSize =
+                    ( uint32_t ) strtoul( &cLine[ sizeof( ggdHTTP_CONTENT_LENGTH_STRING ) - 1 ], NULL, ggJSON_CONVERTION_RADIX )
+                    + ( uint32_t ) 1;
+                xFoundLength = pdTRUE;
+            }
+            else if( prvHeaderFieldIs( cLine, ggdHTTP_ETAG_STRING ) == pdTRUE )
+            {
+                pcValue = &cLine[ sizeof( ggdHTTP_ETAG_STRING ) - 1 ];
+
+                while( *pcValue == ' ' )
+                {
+                    pcValue++;
+                }
+
+                /* A truncated ETag would never match, do not keep it. */
+                if( strlen( pcValue ) < ( size_t ) ( ggdconfigDISCOVERY_CACHE_ETAG_SIZE - 1 ) )
+                {
+                    ( void ) strcpy( pcETag, pcValue );
+                }
+            }
+            else
+            {
+                /* Other fields are not used. */
+            }
+        }
+
+        if( xStatus == pdPASS )
+        {
+            if( ulHTTPStatus == ggdHTTP_STATUS_NOT_MODIFIED )
+            {
+                *pxNotModified = pdTRUE;
+            }
+            else if( ( ulHTTPStatus != ggdHTTP_STATUS_OK ) || ( xFoundLength == pdFALSE ) )
+            {
+                ggdconfigPRINT( "JSON request - HTTP status %lu\r\n", ulHTTPStatus );
+                xStatus = pdFAIL;
+            }
+            else
+            {
+                /* The JSON file follows. */
+            }
+        }
+
+        if( xStatus == pdFAIL )
+        {
+            /* Don't forget to close the connection. */
+            GGD_SecureConnect_Disconnect( pxSocket );
+            ggdconfigPRINT( "JSON parsing failed\r\n" );
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvCacheIsFresh( void )
+    {
+        BaseType_t xFresh = pdFALSE;
+        TickType_t xAge;
+
+        if( ( xDiscoveryCache.ulStructSize != 0UL ) && ( xDiscoveryCacheTimed == pdTRUE ) )
+        {
+            xAge = xTaskGetTickCount() - xDiscoveryCacheTime;
+
+            if( ( xAge / ( TickType_t ) configTICK_RATE_HZ ) < ( TickType_t ) ggdconfigDISCOVERY_CACHE_TTL_S )
+            {
+                xFresh = pdTRUE;
+            }
+        }
+
+        return xFresh;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvCacheGet( char * pcBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                   const uint32_t ulBufferSize,
+                                   GGD_HostAddressData_t * pxHostAddressData )
+    {
+        BaseType_t xStatus = pdFAIL;
+        uint32_t ulHostSize = ( uint32_t ) strlen( xDiscoveryCache.cHostAddress ) + ( uint32_t ) 1;
+
+        /* Give the caller the same kind of result as after parsing the JSON
+         * file: both strings are stored in pcBuffer. */
+        if( ( ulHostSize + xDiscoveryCache.ulCertificateSize ) <= ulBufferSize )
+        {
+            ( void ) memcpy( pcBuffer, xDiscoveryCache.cHostAddress, ulHostSize );
+            ( void ) memcpy( &pcBuffer[ ulHostSize ], xDiscoveryCache.cCertificate, xDiscoveryCache.ulCertificateSize );
+
+            pxHostAddressData->pcHostAddress = pcBuffer;
+            pxHostAddressData->pcCertificate = &pcBuffer[ ulHostSize ];
+            pxHostAddressData->ulCertificateSize = xDiscoveryCache.ulCertificateSize;
+            pxHostAddressData->usPort = xDiscoveryCache.usPort;
+            xStatus = pdPASS;
+        }
+        else
+        {
+            ggdconfigPRINT( "[ERROR] The supplied buffer is not large enough to hold the cached discovery result. \r\n" );
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvCacheSet( const GGD_HostAddressData_t * pxHostAddressData,
+                             const char * pcETag ) /*lint !e971 can use char without signed/unsigned. */
+    {
+        size_t xHostSize = strlen( pxHostAddressData->pcHostAddress ) + ( size_t ) 1;
+
+        xDiscoveryCache.ulStructSize = 0;
+
+        if( ( xHostSize <= sizeof( xDiscoveryCache.cHostAddress ) ) &&
+            ( pxHostAddressData->ulCertificateSize <= ( uint32_t ) sizeof( xDiscoveryCache.cCertificate ) ) )
+        {
+            ( void ) memcpy( xDiscoveryCache.cHostAddress, pxHostAddressData->pcHostAddress, xHostSize );
+            ( void ) memcpy( xDiscoveryCache.cCertificate, pxHostAddressData->pcCertificate, pxHostAddressData->ulCertificateSize );
+            ( void ) strcpy( xDiscoveryCache.cETag, pcETag );
+            xDiscoveryCache.ulCertificateSize = pxHostAddressData->ulCertificateSize;
+            xDiscoveryCache.usPort = pxHostAddressData->usPort;
+            xDiscoveryCache.ulStructSize = ( uint32_t ) sizeof( xDiscoveryCache );
+
+            xDiscoveryCacheTime = xTaskGetTickCount();
+            xDiscoveryCacheTimed = pdTRUE;
+        }
+        else
+        {
+            ggdconfigPRINT( "GGD - Discovery result too large to be cached\r\n" );
+        }
+
+        ggdconfigDISCOVERY_CACHE_STORE( &xDiscoveryCache, sizeof( xDiscoveryCache ) );
+    }
+
+#endif /* if ( ggdconfigDISCOVERY_CACHE == 1 ) */
+/*-----------------------------------------------------------*/
 /* Provide access to private members for testing. */
 #ifdef AMAZON_FREERTOS_ENABLE_UNIT_TESTS
     #include "aws_greengrass_discovery_test_access_define.h"
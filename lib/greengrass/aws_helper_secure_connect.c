@@ -37,6 +37,7 @@
 #include "task.h"
 #include "queue.h"
 #include "semphr.h"
+#include "event_groups.h"
 
 /* Helper interface includes. */
 #include "aws_helper_secure_connect.h"
@@ -48,11 +49,76 @@
 
 #define helperMAX_IP_ADDRESS_OCTETS    4u
 
+/**
+ * @brief Event group bits set by the connection attempt tasks.
+ */
+#define helperCONNECT_WON_BIT         ( ( EventBits_t ) 1 )
+#define helperCONNECT_DONE_BIT        ( ( EventBits_t ) 2 )
+
+#if ( ggdconfigCONNECT_STAGGER_MS > 0 )
+    struct helperConnectRace;
+
+/**
+ * @brief Parameter of one connection attempt task.
+ */
+    typedef struct helperConnectAttempt
+    {
+        struct helperConnectRace * pxRace; /**< The race the attempt belongs to. */
+        uint32_t ulIndex;                  /**< Index of the host to connect to. */
+    } helperConnectAttempt_t;
+
+/**
+ * @brief State shared by the caller of GGD_SecureConnect_ConnectFirst() and
+ * its connection attempt tasks.
+ *
+ * The attempt tasks may outlive the caller, so the state, along with copies of
+ * the host addresses and certificates, is allocated in one block that is freed
+ * by whoever releases it last.
+ */
+    typedef struct helperConnectRace
+    {
+        EventGroupHandle_t xEvents;                                   /**< Signals the caller when an attempt completes. */
+        UBaseType_t uxReferences;                                     /**< Attempt tasks still running, plus the caller while it waits. */
+        BaseType_t xDecided;                                          /**< Set once the caller stopped waiting. */
+        int32_t lWinner;                                              /**< Index of the first host connected to, -1 until then. */
+        Socket_t xWinnerSocket;                                       /**< Socket connected to the winner. */
+        uint32_t ulFailed;                                            /**< Number of attempts that failed. */
+        uint32_t ulReceiveTimeOut;                                    /**< Receive timeout of the attempts in milliseconds. */
+        uint32_t ulSendTimeOut;                                       /**< Send timeout of the attempts in milliseconds. */
+        GGD_HostAddressData_t xHosts[ ggdconfigMAX_PARALLEL_CONNECTS ]; /**< Copies of the hosts, pointing into the same block. */
+        helperConnectAttempt_t xAttempts[ ggdconfigMAX_PARALLEL_CONNECTS ];
+    } helperConnectRace_t;
+#endif /* if ( ggdconfigCONNECT_STAGGER_MS > 0 ) */
+
 /**
  * @brief This function return non 0 if it is an IP and 0 if it isn't
  */
 static uint32_t prvIsIPaddress( const char * pcIPAddress );
 
+#if ( ggdconfigCONNECT_STAGGER_MS > 0 )
+
+/**
+ * @brief Race staggered connection attempts to at most
+ * ggdconfigMAX_PARALLEL_CONNECTS hosts.
+ */
+    static BaseType_t prvConnectRace( const GGD_HostAddressData_t * pxHostAddressData,
+                                      uint32_t ulHostCount,
+                                      Socket_t * pxSocket,
+                                      uint32_t * pulHostIndex,
+                                      uint32_t ulReceiveTimeOut,
+                                      uint32_t ulSendTimeOut );
+
+/**
+ * @brief Task running one connection attempt of a race.
+ */
+    static void prvConnectAttemptTask( void * pvParameters );
+
+/**
+ * @brief Drop one reference to a race, freeing it with the last one.
+ */
+    static void prvConnectRaceRelease( helperConnectRace_t * pxRace );
+#endif
+
 /*-----------------------------------------------------------*/
 
 BaseType_t GGD_SecureConnect_Connect( const GGD_HostAddressData_t * pxHostAddressData,
@@ -179,6 +245,69 @@ BaseType_t GGD_SecureConnect_Connect( const GGD_HostAddressData_t * pxHostAddres
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t GGD_SecureConnect_ConnectFirst( const GGD_HostAddressData_t * pxHostAddressData,
+                                           uint32_t ulHostCount,
+                                           Socket_t * pxSocket,
+                                           uint32_t * pulHostIndex,
+                                           uint32_t ulReceiveTimeOut,
+                                           uint32_t ulSendTimeOut )
+{
+    BaseType_t xStatus = pdFAIL;
+    uint32_t ulIndex;
+
+    #if ( ggdconfigCONNECT_STAGGER_MS > 0 )
+        uint32_t ulCount;
+    #endif
+
+    configASSERT( pxHostAddressData != NULL );
+    configASSERT( pxSocket != NULL );
+    configASSERT( pulHostIndex != NULL );
+
+    #if ( ggdconfigCONNECT_STAGGER_MS > 0 )
+        for( ulIndex = 0; ( ulIndex < ulHostCount ) && ( xStatus == pdFAIL ); ulIndex += ulCount )
+        {
+            ulCount = ulHostCount - ulIndex;
+
+            if( ulCount > ( uint32_t ) ggdconfigMAX_PARALLEL_CONNECTS )
+            {
+                ulCount = ( uint32_t ) ggdconfigMAX_PARALLEL_CONNECTS;
+            }
+
+            if( ulCount == ( uint32_t ) 1 )
+            {
+                /* Nothing to race against. */
+                xStatus = GGD_SecureConnect_Connect( &pxHostAddressData[ ulIndex ],
+                                                     pxSocket,
+                                                     ulReceiveTimeOut,
+                                                     ulSendTimeOut );
+                *pulHostIndex = ulIndex;
+            }
+            else
+            {
+                xStatus = prvConnectRace( &pxHostAddressData[ ulIndex ],
+                                          ulCount,
+                                          pxSocket,
+                                          pulHostIndex,
+                                          ulReceiveTimeOut,
+                                          ulSendTimeOut );
+                *pulHostIndex += ulIndex;
+            }
+        }
+    #else /* if ( ggdconfigCONNECT_STAGGER_MS > 0 ) */
+        for( ulIndex = 0; ( ulIndex < ulHostCount ) && ( xStatus == pdFAIL ); ulIndex++ )
+        {
+            xStatus = GGD_SecureConnect_Connect( &pxHostAddressData[ ulIndex ],
+                                                 pxSocket,
+                                                 ulReceiveTimeOut,
+                                                 ulSendTimeOut );
+            *pulHostIndex = ulIndex;
+        }
+    #endif /* if ( ggdconfigCONNECT_STAGGER_MS > 0 ) */
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
 void GGD_SecureConnect_Disconnect( Socket_t * pxSocket )
 {
     const TickType_t xShortDelay = pdMS_TO_TICKS( 10 );
@@ -419,3 +548,212 @@ static uint32_t prvIsIPaddress( const char * pcIPAddress )
 
     return ulReturn;
 }
+/*-----------------------------------------------------------*/
+
+#if ( ggdconfigCONNECT_STAGGER_MS > 0 )
+
+    static BaseType_t prvConnectRace( const GGD_HostAddressData_t * pxHostAddressData,
+                                      uint32_t ulHostCount,
+                                      Socket_t * pxSocket,
+                                      uint32_t * pulHostIndex,
+                                      uint32_t ulReceiveTimeOut,
+                                      uint32_t ulSendTimeOut )
+    {
+        helperConnectRace_t * pxRace;
+        char * pcCopy; /*lint !e971 can use char without signed/unsigned. */
+        size_t xSize = sizeof( helperConnectRace_t );
+        uint32_t ulIndex, ulStarted = 0, ulFailed = 0;
+        BaseType_t xStatus = pdFAIL;
+        BaseType_t xWon = pdFALSE;
+
+        /* Room for copies of the strings, the attempts may still use them after this returns. */
+        for( ulIndex = 0; ulIndex < ulHostCount; ulIndex++ )
+        {
+            xSize += strlen( pxHostAddressData[ ulIndex ].pcHostAddress ) + ( size_t ) 1;
+
+            if( ( pxHostAddressData[ ulIndex ].pcCertificate != NULL ) &&
+                ( ( ulIndex == ( uint32_t ) 0 ) ||
+                  ( pxHostAddressData[ ulIndex ].pcCertificate != pxHostAddressData[ ulIndex - ( uint32_t ) 1 ].pcCertificate ) ) )
+            {
+                xSize += ( size_t ) pxHostAddressData[ ulIndex ].ulCertificateSize;
+            }
+        }
+
+        pxRace = ( helperConnectRace_t * ) pvPortMalloc( xSize );
+
+        if( pxRace != NULL )
+        {
+            memset( pxRace, 0, sizeof( helperConnectRace_t ) );
+            pxRace->xEvents = xEventGroupCreate();
+
+            if( pxRace->xEvents == NULL )
+            {
+                vPortFree( pxRace );
+                pxRace = NULL;
+            }
+        }
+
+        if( pxRace == NULL )
+        {
+            ggdconfigPRINT( "SecureConnect - no memory for parallel connections\r\n" );
+        }
+        else
+        {
+            pxRace->uxReferences = ( UBaseType_t ) 1;
+            pxRace->lWinner = -1;
+            pxRace->xWinnerSocket = SOCKETS_INVALID_SOCKET;
+            pxRace->ulReceiveTimeOut = ulReceiveTimeOut;
+            pxRace->ulSendTimeOut = ulSendTimeOut;
+            pcCopy = ( char * ) &pxRace[ 1 ]; /*lint !e971 can use char without signed/unsigned. */
+
+            for( ulIndex = 0; ulIndex < ulHostCount; ulIndex++ )
+            {
+                pxRace->xHosts[ ulIndex ] = pxHostAddressData[ ulIndex ];
+                pxRace->xHosts[ ulIndex ].pcHostAddress = pcCopy;
+                ( void ) strcpy( pcCopy, pxHostAddressData[ ulIndex ].pcHostAddress );
+                pcCopy += strlen( pcCopy ) + ( size_t ) 1;
+
+                if( pxHostAddressData[ ulIndex ].pcCertificate != NULL )
+                {
+                    if( ( ulIndex > ( uint32_t ) 0 ) &&
+                        ( pxHostAddressData[ ulIndex ].pcCertificate == pxHostAddressData[ ulIndex - ( uint32_t ) 1 ].pcCertificate ) )
+                    {
+                        /* Usually all the hosts share the group CA. */
+                        pxRace->xHosts[ ulIndex ].pcCertificate = pxRace->xHosts[ ulIndex - ( uint32_t ) 1 ].pcCertificate;
+                    }
+                    else
+                    {
+                        pxRace->xHosts[ ulIndex ].pcCertificate = pcCopy;
+                        ( void ) memcpy( pcCopy,
+                                         pxHostAddressData[ ulIndex ].pcCertificate,
+                                         ( size_t ) pxHostAddressData[ ulIndex ].ulCertificateSize );
+                        pcCopy += pxHostAddressData[ ulIndex ].ulCertificateSize;
+                    }
+                }
+
+                pxRace->xAttempts[ ulIndex ].pxRace = pxRace;
+                pxRace->xAttempts[ ulIndex ].ulIndex = ulIndex;
+            }
+
+            /* Start the next attempt when the previous one failed or took longer
+             * than the stagger delay, until one connects or all have failed. */
+            do
+            {
+                if( ulStarted < ulHostCount )
+                {
+                    taskENTER_CRITICAL();
+                    pxRace->uxReferences++;
+                    taskEXIT_CRITICAL();
+
+                    if( xTaskCreate( prvConnectAttemptTask,
+                                     "GGDConnect",
+                                     ( uint16_t ) ggdconfigCONNECT_TASK_STACK_SIZE,
+                                     &pxRace->xAttempts[ ulStarted ],
+                                     ggdconfigCONNECT_TASK_PRIORITY,
+                                     NULL ) != pdPASS )
+                    {
+                        ggdconfigPRINT( "SecureConnect - can't start connection task\r\n" );
+
+                        taskENTER_CRITICAL();
+                        pxRace->uxReferences--;
+                        pxRace->ulFailed++;
+                        taskEXIT_CRITICAL();
+                    }
+
+                    ulStarted++;
+                }
+
+                ( void ) xEventGroupWaitBits( pxRace->xEvents,
+                                              helperCONNECT_WON_BIT | helperCONNECT_DONE_BIT,
+                                              pdTRUE,
+                                              pdFALSE,
+                                              ( ulStarted < ulHostCount ) ? pdMS_TO_TICKS( ggdconfigCONNECT_STAGGER_MS ) : portMAX_DELAY );
+
+                taskENTER_CRITICAL();
+                xWon = ( pxRace->lWinner >= 0 ) ? pdTRUE : pdFALSE;
+                ulFailed = pxRace->ulFailed;
+
+                if( ( xWon == pdTRUE ) || ( ulFailed == ulHostCount ) )
+                {
+                    /* Attempts completing from now on close their connection. */
+                    pxRace->xDecided = pdTRUE;
+                }
+
+                taskEXIT_CRITICAL();
+            } while( ( xWon == pdFALSE ) && ( ulFailed < ulHostCount ) );
+
+            if( xWon == pdTRUE )
+            {
+                *pxSocket = pxRace->xWinnerSocket;
+                *pulHostIndex = ( uint32_t ) pxRace->lWinner;
+                xStatus = pdPASS;
+            }
+
+            prvConnectRaceRelease( pxRace );
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvConnectAttemptTask( void * pvParameters )
+    {
+        helperConnectAttempt_t * pxAttempt = ( helperConnectAttempt_t * ) pvParameters;
+        helperConnectRace_t * pxRace = pxAttempt->pxRace;
+        Socket_t xSocket = SOCKETS_INVALID_SOCKET;
+        BaseType_t xConnected;
+        BaseType_t xWon = pdFALSE;
+
+        xConnected = GGD_SecureConnect_Connect( &pxRace->xHosts[ pxAttempt->ulIndex ],
+                                                &xSocket,
+                                                pxRace->ulReceiveTimeOut,
+                                                pxRace->ulSendTimeOut );
+
+        taskENTER_CRITICAL();
+
+        if( xConnected == pdPASS )
+        {
+            if( ( pxRace->lWinner < 0 ) && ( pxRace->xDecided == pdFALSE ) )
+            {
+                pxRace->lWinner = ( int32_t ) pxAttempt->ulIndex;
+                pxRace->xWinnerSocket = xSocket;
+                xWon = pdTRUE;
+            }
+        }
+        else
+        {
+            pxRace->ulFailed++;
+        }
+
+        taskEXIT_CRITICAL();
+
+        if( ( xConnected == pdPASS ) && ( xWon == pdFALSE ) )
+        {
+            /* Another host was faster. */
+            GGD_SecureConnect_Disconnect( &xSocket );
+        }
+
+        ( void ) xEventGroupSetBits( pxRace->xEvents,
+                                     ( xWon == pdTRUE ) ? helperCONNECT_WON_BIT : helperCONNECT_DONE_BIT );
+
+        prvConnectRaceRelease( pxRace );
+        vTaskDelete( NULL );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvConnectRaceRelease( helperConnectRace_t * pxRace )
+    {
+        UBaseType_t uxReferences;
+
+        taskENTER_CRITICAL();
+        pxRace->uxReferences--;
+        uxReferences = pxRace->uxReferences;
+        taskEXIT_CRITICAL();
+
+        if( uxReferences == ( UBaseType_t ) 0 )
+        {
+            vEventGroupDelete( pxRace->xEvents );
+            vPortFree( pxRace );
+        }
+    }
+#endif /* if ( ggdconfigCONNECT_STAGGER_MS > 0 ) */
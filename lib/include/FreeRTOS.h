@@ -270,6 +270,32 @@ extern "C" {
 	#define portCLEAN_UP_TCB( pxTCB ) ( void ) pxTCB
 #endif
 
+/* Declares that the calling task holds no floating point values, so ports
+with a lazily saved FPU context can stop saving it for the task.  Only called
+where no floating point value is live. */
+#ifndef portTASK_USES_NO_FPU
+	#define portTASK_USES_NO_FPU()
+#endif
+
+/* Set to 1 to let ports that support it place the functions marked
+portHOT_FUNCTION and the data marked portHOT_DATA in fast memory, such as TCM
+or IRAM. */
+#ifndef configUSE_HOT_SECTIONS
+	#define configUSE_HOT_SECTIONS 0
+#endif
+
+/* Marks a function on the hot path of the kernel or a library, which the port
+may place in fast memory. */
+#ifndef portHOT_FUNCTION
+	#define portHOT_FUNCTION
+#endif
+
+/* Marks hot data that has no initialiser, which the port may place in fast
+memory.  Such memory is zeroed by the startup code of the board. */
+#ifndef portHOT_DATA
+	#define portHOT_DATA
+#endif
+
 #ifndef portPRE_TASK_DELETE_HOOK
 	#define portPRE_TASK_DELETE_HOOK( pvTaskToDelete, pxYieldPending )
 #endif
@@ -754,6 +780,26 @@ extern "C" {
 	#define configPOST_SLEEP_PROCESSING( x )
 #endif
 
+#ifndef configUSE_TICKLESS_IDLE_STATS
+	#define configUSE_TICKLESS_IDLE_STATS 0
+#endif
+
+#ifndef configUSE_SLEEP_LATENCY_TOLERANCE
+	#define configUSE_SLEEP_LATENCY_TOLERANCE 0
+#endif
+
+#ifndef configTICKLESS_IDLE_SLEEP_DEPTHS
+	#define configTICKLESS_IDLE_SLEEP_DEPTHS 1
+#endif
+
+#ifndef configSELECT_SLEEP_DEPTH
+	#define configSELECT_SLEEP_DEPTH( xExpectedIdleTime, ulLatencyTolerance ) ( ( UBaseType_t ) 0U )
+#endif
+
+#if( ( ( configUSE_TICKLESS_IDLE_STATS == 1 ) || ( configUSE_SLEEP_LATENCY_TOLERANCE == 1 ) ) && ( configUSE_TICKLESS_IDLE == 0 ) )
+	#error configUSE_TICKLESS_IDLE_STATS and configUSE_SLEEP_LATENCY_TOLERANCE require configUSE_TICKLESS_IDLE to be set to a value other than 0
+#endif
+
 #ifndef configUSE_QUEUE_SETS
 	#define configUSE_QUEUE_SETS 0
 #endif
@@ -810,10 +856,152 @@ extern "C" {
 	#define configUSE_TASK_NOTIFICATIONS 1
 #endif
 
+/* Number of notification values each task holds.  Index 0 is used by the
+non-indexed notification API functions, and by the kernel for stream and
+message buffers, so callers that need a channel of their own use a higher
+index. */
+#ifndef configTASK_NOTIFICATION_ARRAY_ENTRIES
+	#define configTASK_NOTIFICATION_ARRAY_ENTRIES 1
+#endif
+
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES < 1
+	#error configTASK_NOTIFICATION_ARRAY_ENTRIES must be at least 1
+#endif
+
 #ifndef configUSE_POSIX_ERRNO
 	#define configUSE_POSIX_ERRNO 0
 #endif
 
+#ifndef configUSE_TASK_ARENAS
+	#define configUSE_TASK_ARENAS 0
+#endif
+
+/* Set to 1 to give each heap_5.c region capabilities, and allocate from the
+regions that have them with pvPortMallocWithCaps().  Only heap_5.c provides
+this. */
+#ifndef configUSE_HEAP_CAPS
+	#define configUSE_HEAP_CAPS 0
+#endif
+
+/* The largest number of regions passed to vPortDefineHeapRegions() when
+configUSE_HEAP_CAPS is 1. */
+#ifndef configHEAP_MAX_REGIONS
+	#define configHEAP_MAX_REGIONS 4
+#endif
+
+#ifndef configUSE_QUEUE_ZERO_COPY
+	#define configUSE_QUEUE_ZERO_COPY 0
+#endif
+
+#ifndef configNUM_CORES
+	#define configNUM_CORES 1
+#endif
+
+#if( configNUM_CORES != 1 )
+	/* The scheduler only runs tasks on one core: pxCurrentTCB, the ready
+	lists and the critical sections in tasks.c are not per core yet. */
+	#error configNUM_CORES must be 1 until tasks.c supports SMP scheduling
+#endif
+
+#ifndef configLIST_INSERT_FROM_NEAREST_END
+	#define configLIST_INSERT_FROM_NEAREST_END 0
+#endif
+
+#ifndef configUSE_TIMER_DIRECT_UPDATE
+	#define configUSE_TIMER_DIRECT_UPDATE 0
+#endif
+
+/* Set to 1 to allow software timers and delays to be given a slack, within
+which their wake up may be postponed to coincide with another one.  See
+vTimerSetSlack() and vTaskDelayWithSlack(). */
+#ifndef configUSE_TIMER_SLACK
+	#define configUSE_TIMER_SLACK 0
+#endif
+
+#ifndef configUSE_EXTENDED_RUN_TIME_STATS
+	#define configUSE_EXTENDED_RUN_TIME_STATS 0
+#endif
+
+#if( ( configUSE_EXTENDED_RUN_TIME_STATS == 1 ) && ( configGENERATE_RUN_TIME_STATS == 0 ) )
+	#error configUSE_EXTENDED_RUN_TIME_STATS requires configGENERATE_RUN_TIME_STATS to be set to 1
+#endif
+
+#ifndef configUSE_RW_LOCKS
+	#define configUSE_RW_LOCKS 0
+#endif
+
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configUSE_MUTEXES == 0 ) )
+	#error configUSE_RW_LOCKS requires configUSE_MUTEXES to be set to 1
+#endif
+
+/* The number of deleted tasks whose TCB and stack are kept for reuse by
+xTaskCreate(), instead of being freed.  0 frees them. */
+#ifndef configTASK_POOL_SIZE
+	#define configTASK_POOL_SIZE 0
+#endif
+
+/* How much larger than requested, in percent, the stack of a pooled task may
+be for the task to be reused. */
+#ifndef configTASK_POOL_STACK_SLACK_PERCENT
+	#define configTASK_POOL_STACK_SLACK_PERCENT 25
+#endif
+
+#if( ( configTASK_POOL_SIZE > 0 ) && ( ( INCLUDE_vTaskDelete != 1 ) || ( configSUPPORT_DYNAMIC_ALLOCATION != 1 ) ) )
+	#error configTASK_POOL_SIZE requires INCLUDE_vTaskDelete and configSUPPORT_DYNAMIC_ALLOCATION to be set to 1
+#endif
+
+/* Set to 1 to keep a list of all tasks, so uxTaskGetSystemStateIncremental()
+can report the state of the tasks a few at a time. */
+#ifndef configUSE_TASK_ITERATOR
+	#define configUSE_TASK_ITERATOR 0
+#endif
+
+#if( ( configUSE_TASK_ITERATOR == 1 ) && ( configUSE_TRACE_FACILITY == 0 ) )
+	#error configUSE_TASK_ITERATOR requires configUSE_TRACE_FACILITY to be set to 1
+#endif
+
+/* The number of tasks vTaskList() and vTaskGetRunTimeStats() report per call
+to uxTaskGetSystemStateIncremental(), which bounds the time the scheduler is
+suspended for. */
+#ifndef configTASK_ITERATOR_CHUNK_SIZE
+	#define configTASK_ITERATOR_CHUNK_SIZE 4
+#endif
+
+/* The number of deleted queues, semaphores and mutexes whose memory is kept
+for reuse by an object of the same size, instead of being freed.  0 frees
+them. */
+#ifndef configQUEUE_POOL_SIZE
+	#define configQUEUE_POOL_SIZE 0
+#endif
+
+#ifndef configUSE_SEMAPHORE_CONTENTION_STATS
+	#define configUSE_SEMAPHORE_CONTENTION_STATS 0
+#endif
+
+#ifndef configUSE_QUEUE_CONTENTION_STATS
+	#define configUSE_QUEUE_CONTENTION_STATS 0
+#endif
+
+#ifndef configUSE_OBJECT_READY_NOTIFICATIONS
+	#define configUSE_OBJECT_READY_NOTIFICATIONS 0
+#endif
+
+#if( ( configUSE_OBJECT_READY_NOTIFICATIONS == 1 ) && ( configUSE_TASK_NOTIFICATIONS != 1 ) )
+	#error configUSE_OBJECT_READY_NOTIFICATIONS requires configUSE_TASK_NOTIFICATIONS to be set to 1
+#endif
+
+#ifndef configEVENT_GROUP_INDEXED_BITS
+	#define configEVENT_GROUP_INDEXED_BITS 0
+#endif
+
+#ifndef configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT
+	#define configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT 0
+#endif
+
+#if( ( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 ) && ( configEVENT_GROUP_INDEXED_BITS == 0 ) )
+	#error configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT requires configEVENT_GROUP_INDEXED_BITS to be greater than 0
+#endif
+
 #ifndef portTICK_TYPE_IS_ATOMIC
 	#define portTICK_TYPE_IS_ATOMIC 0
 #endif
@@ -1023,6 +1211,18 @@ the Secure Side only. */
 #define tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE	( ( ( portUSING_MPU_WRAPPERS == 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) ) || \
 													  ( ( portUSING_MPU_WRAPPERS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) ) )
 
+/*
+ * The use of a pool of deleted objects kept for reuse, as returned by
+ * vTaskGetPoolStats() and vQueueGetPoolStats().
+ */
+typedef struct xOBJECT_POOL_STATS
+{
+	UBaseType_t uxPooled;	/*< The number of objects held in the pool. */
+	uint32_t ulReused;		/*< The number of objects created from the pool. */
+	uint32_t ulAllocated;	/*< The number of objects allocated because the pool held none that fit. */
+	uint32_t ulFreed;		/*< The number of deleted objects freed because the pool was full. */
+} ObjectPoolStats_t;
+
 /*
  * In line with software engineering best practice, FreeRTOS implements a strict
  * data hiding policy, so the real structures used by FreeRTOS to maintain the
@@ -1119,8 +1319,8 @@ typedef struct xSTATIC_TCB
 		struct	_reent	xDummy17;
 	#endif
 	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
-		uint32_t 		ulDummy18;
-		uint8_t 		ucDummy19;
+		uint32_t 		ulDummy18[ configTASK_NOTIFICATION_ARRAY_ENTRIES ];
+		uint8_t 		ucDummy19[ configTASK_NOTIFICATION_ARRAY_ENTRIES ];
 	#endif
 	#if ( tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE != 0 )
 		uint8_t			uxDummy20;
@@ -1132,6 +1332,21 @@ typedef struct xSTATIC_TCB
 	#if ( configUSE_POSIX_ERRNO == 1 )
 		int				iDummy22;
 	#endif
+	#if ( configUSE_TASK_ARENAS == 1 )
+		void			*pvDummy23;
+	#endif
+	#if ( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+		uint32_t		ulDummy25[ 3 ];
+	#endif
+	#if ( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+		uint32_t		ulDummy26;
+	#endif
+	#if ( configTASK_POOL_SIZE > 0 )
+		uint32_t		ulDummy27;
+	#endif
+	#if ( configUSE_TASK_ITERATOR == 1 )
+		StaticListItem_t	xDummy28;
+	#endif
 } StaticTask_t;
 
 /*
@@ -1175,6 +1390,24 @@ typedef struct xSTATIC_QUEUE
 		uint8_t ucDummy9;
 	#endif
 
+	#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+		void *pvDummy10;
+	#endif
+
+	#if ( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+		UBaseType_t uxDummy11;
+	#endif
+
+	#if ( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		void *pvDummy12;
+		uint32_t ulDummy13;
+	#endif
+
+	#if ( configUSE_QUEUE_CONTENTION_STATS == 1 )
+		UBaseType_t uxDummy14[ 4 ];
+		TickType_t xDummy15[ 3 ];
+	#endif
+
 } StaticQueue_t;
 typedef StaticQueue_t StaticSemaphore_t;
 
@@ -1205,6 +1438,21 @@ typedef struct xSTATIC_EVENT_GROUP
 			uint8_t ucDummy4;
 	#endif
 
+	#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		void *pvDummy5;
+		uint32_t ulDummy6;
+		TickType_t xDummy7;
+	#endif
+
+	#if( configEVENT_GROUP_INDEXED_BITS > 0 )
+		TickType_t xDummy8;
+		StaticList_t xDummy9[ configEVENT_GROUP_INDEXED_BITS ];
+	#endif
+
+	#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+		uint8_t ucDummy10;
+	#endif
+
 } StaticEventGroup_t;
 
 /*
@@ -1231,6 +1479,9 @@ typedef struct xSTATIC_TIMER
 	#if( configUSE_TRACE_FACILITY == 1 )
 		UBaseType_t		uxDummy7;
 	#endif
+	#if( configUSE_TIMER_SLACK == 1 )
+		TickType_t		xDummy9;
+	#endif
 	uint8_t 			ucDummy8;
 
 } StaticTimer_t;
@@ -1257,11 +1508,30 @@ typedef struct xSTATIC_STREAM_BUFFER
 	#if ( configUSE_TRACE_FACILITY == 1 )
 		UBaseType_t uxDummy4;
 	#endif
+	#if ( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+		void *pvDummy5;
+		uint32_t ulDummy6;
+	#endif
 } StaticStreamBuffer_t;
 
 /* Message buffers are built on stream buffers. */
 typedef StaticStreamBuffer_t StaticMessageBuffer_t;
 
+/*
+ * In line with software engineering best practice, FreeRTOS implements a strict
+ * data hiding policy, so the arena structure used internally by FreeRTOS is not
+ * accessible to application code.  The StaticTaskArena_t structure below has
+ * the same size and alignment requirements as the genuine structure, so that
+ * an arena can be created without any dynamic memory allocation.  Its contents
+ * are somewhat obfuscated in the hope users will recognise that it would be
+ * unwise to make direct use of the structure members.
+ */
+typedef struct xSTATIC_TASK_ARENA
+{
+	void *pvDummy1[ 5 ];
+	size_t uxDummy2;
+} StaticTaskArena_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -170,8 +170,7 @@ int pthread_barrier_destroy( pthread_barrier_t * barrier );
  *
  * http://pubs.opengroup.org/onlinepubs/9699919799/functions/pthread_barrier_init.html
  *
- * @note attr is ignored. count may be at most 8 when configUSE_16_BIT_TICKS is 1;
- * it may be at most 24 otherwise.
+ * @note attr is ignored. count is not limited by the width of an event group.
  */
 int pthread_barrier_init( pthread_barrier_t * barrier,
                           const pthread_barrierattr_t * attr,
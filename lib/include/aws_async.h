@@ -0,0 +1,286 @@
+/*
+ * Amazon FreeRTOS Async Executor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_async.h
+ * @brief Stackless coroutines that share one FreeRTOS task.
+ *
+ * A protocol client that spends most of its time blocked on I/O can be
+ * written as an async task: a function that returns whenever it would block,
+ * and is called again where it left off once what it waits for is ready.
+ * Any number of async tasks run in the FreeRTOS task that calls ASYNC_Run(),
+ * using that task's stack only while they run, so several clients cost one
+ * stack instead of one each.
+ *
+ * An async task function is written between asyncBEGIN() and asyncEND(),
+ * and waits with the asyncAWAIT_ macros:
+ * @code
+ * static AsyncStatus_t prvClient( AsyncTask_t * pxTask,
+ *                                 void * pvParameter )
+ * {
+ *     Client_t * pxClient = ( Client_t * ) pvParameter;
+ *
+ *     asyncBEGIN( pxTask );
+ *
+ *     for( ; ; )
+ *     {
+ *         asyncAWAIT_SOCKET( pxTask, pxClient->xSocket, SOCKETS_POLLIN, portMAX_DELAY );
+ *         ( void ) SOCKETS_Recv( pxClient->xSocket, pxClient->ucBuffer, sizeof( pxClient->ucBuffer ), 0 );
+ *     }
+ *
+ *     asyncEND( pxTask );
+ * }
+ * @endcode
+ *
+ * As with co-routines, local variables are not kept across an asyncAWAIT_
+ * macro, so state that must survive a wait is kept in the structure passed
+ * as the parameter. The macros may only be used in the function itself, not
+ * in functions it calls, and not inside a switch statement. An async task
+ * must never call a FreeRTOS function that blocks, as that blocks every async
+ * task of the executor.
+ */
+
+#ifndef _AWS_ASYNC_H_
+#define _AWS_ASYNC_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_async.h"
+#endif
+
+#include "task.h"
+#include "queue.h"
+#include "aws_async_config_defaults.h"
+
+#if ( asyncconfigUSE_SOCKETS == 1 )
+    #include "aws_secure_sockets.h"
+#endif
+
+/**
+ * @brief Returned by an async task function.
+ */
+typedef enum AsyncStatus
+{
+    eAsyncWaiting, /**< The task is waiting, and its function must be called again. */
+    eAsyncDone     /**< The task has finished. */
+} AsyncStatus_t;
+
+/**
+ * @brief What an async task is waiting for.
+ */
+typedef enum AsyncWait
+{
+    eAsyncWaitNone,   /**< Nothing, the task is ready to run. */
+    eAsyncWaitDelay,  /**< The timeout. */
+    eAsyncWaitSignal, /**< A call to ASYNC_Signal(). */
+    eAsyncWaitQueue,  /**< An item on a queue. */
+    eAsyncWaitSocket  /**< Events on a socket. */
+} AsyncWait_t;
+
+struct AsyncTask;
+
+/**
+ * @brief An async task function.
+ *
+ * @param[in] pxTask The task being run.
+ * @param[in] pvParameter The parameter given to ASYNC_Spawn().
+ *
+ * @return eAsyncWaiting to be called again, or eAsyncDone once finished.
+ */
+typedef AsyncStatus_t (* AsyncFunction_t)( struct AsyncTask * pxTask,
+                                           void * pvParameter );
+
+/**
+ * @brief An async task.
+ *
+ * Owned by the caller, which must keep it in memory until the task has
+ * finished. Only xResult and ulReadyEvents are meant to be read by the task
+ * function, after an asyncAWAIT_ macro.
+ */
+typedef struct AsyncTask
+{
+    struct AsyncTask * pxNext;     /**< The next task of the executor. */
+    AsyncFunction_t pxFunction;    /**< The task function. */
+    void * pvParameter;            /**< The parameter of pxFunction. */
+    UBaseType_t uxResumePoint;     /**< Where pxFunction continues, 0 to start at the top. */
+    AsyncWait_t eWait;             /**< What the task waits for. */
+    TimeOut_t xTimeOut;            /**< When the wait started. */
+    TickType_t xTicksToWait;       /**< The time left to wait. */
+    QueueHandle_t xQueue;          /**< The queue waited on. */
+    void * pvItem;                 /**< Where an item received from xQueue is copied. */
+    #if ( asyncconfigUSE_SOCKETS == 1 )
+        Socket_t xSocket;          /**< The socket waited on. */
+    #endif
+    uint32_t ulEvents;             /**< The @ref PollEvents waited for. */
+    uint32_t ulReadyEvents;        /**< The @ref PollEvents ready when the wait ended, 0 on timeout. */
+    volatile BaseType_t xSignalled; /**< Set by ASYNC_Signal(). */
+    BaseType_t xResult;            /**< pdPASS if the last wait ended before its timeout, pdFAIL otherwise. */
+} AsyncTask_t;
+
+/**
+ * @brief A set of async tasks run by one FreeRTOS task.
+ */
+typedef struct AsyncExecutor
+{
+    AsyncTask_t * pxTasks;         /**< The tasks that have not finished. */
+    TaskHandle_t xTaskHandle;      /**< The FreeRTOS task running ASYNC_Run(), once it has started. */
+} AsyncExecutor_t;
+
+/**
+ * @brief Starts an async task function.
+ *
+ * Must be called at the top of the function, before any asyncAWAIT_ macro.
+ */
+#define asyncBEGIN( pxTask )    switch( ( pxTask )->uxResumePoint ) { case 0:
+
+/**
+ * @brief Ends an async task function, which then finishes.
+ */
+#define asyncEND( pxTask )      } ( pxTask )->uxResumePoint = 0; return eAsyncDone
+
+/**
+ * @brief Returns to the executor, and continues from here when called again.
+ */
+#define asyncSUSPEND( pxTask )                              \
+    ( pxTask )->uxResumePoint = ( UBaseType_t ) __LINE__; \
+    return eAsyncWaiting;                                   \
+    case __LINE__:
+
+/**
+ * @brief Lets the other ready async tasks run before continuing.
+ */
+#define asyncYIELD( pxTask )                                  \
+    do {                                                      \
+        ASYNC_PrepareWait( ( pxTask ), eAsyncWaitNone, 0 );   \
+        asyncSUSPEND( pxTask );                               \
+    } while( 0 )
+
+/**
+ * @brief Waits for xTicks ticks.
+ */
+#define asyncDELAY( pxTask, xTicks )                                  \
+    do {                                                              \
+        ASYNC_PrepareWait( ( pxTask ), eAsyncWaitDelay, ( xTicks ) ); \
+        asyncSUSPEND( pxTask );                                       \
+    } while( 0 )
+
+/**
+ * @brief Waits for ASYNC_Signal() to be called on the task, for at most
+ * xTimeout ticks. xResult is then pdPASS if the task was signalled.
+ */
+#define asyncAWAIT_SIGNAL( pxTask, xTimeout )                            \
+    do {                                                                 \
+        ASYNC_PrepareWait( ( pxTask ), eAsyncWaitSignal, ( xTimeout ) ); \
+        asyncSUSPEND( pxTask );                                          \
+    } while( 0 )
+
+/**
+ * @brief Waits for an item on a queue, for at most xTimeout ticks. xResult is
+ * then pdPASS if an item was copied to pvBuffer.
+ */
+#define asyncAWAIT_QUEUE( pxTask, xQueueToWait, pvBuffer, xTimeout )    \
+    do {                                                                \
+        ASYNC_PrepareWait( ( pxTask ), eAsyncWaitQueue, ( xTimeout ) ); \
+        ( pxTask )->xQueue = ( xQueueToWait );                          \
+        ( pxTask )->pvItem = ( pvBuffer );                              \
+        asyncSUSPEND( pxTask );                                         \
+    } while( 0 )
+
+/**
+ * @brief Waits for @ref PollEvents on a socket, for at most xTimeout ticks.
+ * ulReadyEvents then holds the events that are ready, or 0 on timeout.
+ */
+#if ( asyncconfigUSE_SOCKETS == 1 )
+    #define asyncAWAIT_SOCKET( pxTask, xSocketToWait, ulEventsToWait, xTimeout ) \
+    do {                                                                         \
+        ASYNC_PrepareWait( ( pxTask ), eAsyncWaitSocket, ( xTimeout ) );         \
+        ( pxTask )->xSocket = ( xSocketToWait );                                 \
+        ( pxTask )->ulEvents = ( ulEventsToWait );                               \
+        asyncSUSPEND( pxTask );                                                  \
+    } while( 0 )
+#endif
+
+/**
+ * @brief Prepares an executor before tasks are spawned on it.
+ *
+ * @param[out] pxExecutor The executor.
+ */
+void ASYNC_ExecutorInit( AsyncExecutor_t * pxExecutor );
+
+/**
+ * @brief Adds an async task to an executor.
+ *
+ * Must be called before ASYNC_Run(), or from an async task of the same
+ * executor. The task runs from the top on the next pass of the executor.
+ *
+ * @param[in] pxExecutor The executor.
+ * @param[out] pxTask The task.
+ * @param[in] pxFunction The task function.
+ * @param[in] pvParameter The parameter passed to pxFunction.
+ */
+void ASYNC_Spawn( AsyncExecutor_t * pxExecutor,
+                  AsyncTask_t * pxTask,
+                  AsyncFunction_t pxFunction,
+                  void * pvParameter );
+
+/**
+ * @brief Runs the tasks of an executor until all have finished.
+ *
+ * @param[in] pxExecutor The executor.
+ */
+void ASYNC_Run( AsyncExecutor_t * pxExecutor );
+
+/**
+ * @brief Wakes an async task waiting in asyncAWAIT_SIGNAL().
+ *
+ * A signal sent while the task is not waiting is kept until its next wait.
+ * Can be called from any FreeRTOS task.
+ *
+ * @param[in] pxExecutor The executor running the task.
+ * @param[in] pxTask The task.
+ */
+void ASYNC_Signal( AsyncExecutor_t * pxExecutor,
+                   AsyncTask_t * pxTask );
+
+/**
+ * @brief ASYNC_Signal() for use in interrupts.
+ *
+ * @param[in] pxExecutor The executor running the task.
+ * @param[in] pxTask The task.
+ * @param[out] pxHigherPriorityTaskWoken Set to pdTRUE if a context switch
+ * should be requested before the interrupt exits. May be NULL.
+ */
+void ASYNC_SignalFromISR( AsyncExecutor_t * pxExecutor,
+                          AsyncTask_t * pxTask,
+                          BaseType_t * pxHigherPriorityTaskWoken );
+
+/**
+ * @brief Records what a task is about to wait for. Used by the asyncAWAIT_
+ * macros only.
+ */
+void ASYNC_PrepareWait( AsyncTask_t * pxTask,
+                        AsyncWait_t eWait,
+                        TickType_t xTicksToWait );
+
+#endif /* _AWS_ASYNC_H_ */
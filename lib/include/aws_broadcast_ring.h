@@ -0,0 +1,191 @@
+/*
+ * Amazon FreeRTOS Broadcast Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_broadcast_ring.h
+ * @brief A ring of fixed size items written by one producer and read by any
+ * number of readers.
+ *
+ * The producer writes each item once, and every registered reader receives
+ * every item through its own read cursor. Each reader chooses what happens
+ * when it falls behind:
+ * - eBroadcastOverwriteOldest: the producer never waits for the reader, which
+ *   loses the oldest items it has not read yet. BROADCAST_ReaderDropped()
+ *   tells how many.
+ * - eBroadcastBlockProducer: the producer waits until the reader has read
+ *   the oldest item, so the reader never loses an item.
+ *
+ * Items are copied into the ring by the producer and out of it by each reader,
+ * outside of any critical section. A write only touches the ring and the
+ * readers that are waiting for an item; the cursors of the blocking readers
+ * are only visited when the ring looks full to the producer. So the cost of a
+ * write does not grow with the number of readers that keep up.
+ *
+ * The rings, readers and their storage are owned by the caller. All functions
+ * must be called from tasks; an interrupt can hand its samples over with
+ * DEFERRED_ScheduleFromISR(). There must be one producer task per ring, and
+ * every reader is used by one task at a time.
+ */
+
+#ifndef _AWS_BROADCAST_RING_H_
+#define _AWS_BROADCAST_RING_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_broadcast_ring.h"
+#endif
+
+#include "task.h"
+
+/**
+ * @brief The number of bytes of storage a ring of ulLength items of xItemSize
+ * bytes needs.
+ */
+#define broadcastSTORAGE_SIZE( xItemSize, ulLength )    ( ( size_t ) ( xItemSize ) * ( size_t ) ( ulLength ) )
+
+/**
+ * @brief What a reader that falls behind does to the producer.
+ */
+typedef enum BroadcastPolicy
+{
+    eBroadcastOverwriteOldest = 0, /**< The reader loses the oldest items. */
+    eBroadcastBlockProducer        /**< The producer waits for the reader. */
+} BroadcastPolicy_t;
+
+/**
+ * @brief A reader of a broadcast ring.
+ *
+ * Owned by the caller, which must keep it in memory while it is registered.
+ * The members should only be accessed through the BROADCAST_ functions.
+ */
+typedef struct BroadcastReader
+{
+    struct BroadcastReader * pxNext;        /**< The next registered reader. */
+    struct BroadcastReader * pxNextWaiting; /**< The next reader waiting for an item. */
+    TaskHandle_t xWaitingTask;              /**< The task waiting for an item, NULL while the reader is not waiting. */
+    uint32_t ulNext;                        /**< Sequence number of the next item to read. */
+    uint32_t ulDropped;                     /**< Items that were overwritten before they were read. */
+    BroadcastPolicy_t ePolicy;              /**< What the reader does when it falls behind. */
+} BroadcastReader_t;
+
+/**
+ * @brief A broadcast ring.
+ *
+ * Owned by the caller. The members should only be accessed through the
+ * BROADCAST_ functions.
+ */
+typedef struct BroadcastRing
+{
+    uint8_t * pucStorage;           /**< ulLength items of xItemSize bytes. */
+    size_t xItemSize;               /**< The size of an item in bytes. */
+    uint32_t ulLength;              /**< The number of items the ring holds. */
+    volatile uint32_t ulHead;       /**< Sequence number of the next item to be published. */
+    volatile uint32_t ulClaimed;    /**< ulHead plus one while the producer copies an item, ulHead otherwise. */
+    uint32_t ulSlowest;             /**< No blocking reader has a cursor below this. */
+    BroadcastReader_t * pxReaders;  /**< The registered readers. */
+    BroadcastReader_t * pxWaiting;  /**< The readers waiting for an item. */
+    TaskHandle_t xWaitingProducer;  /**< The producer while it waits for room, NULL otherwise. */
+} BroadcastRing_t;
+
+/**
+ * @brief Prepares a ring before it is used.
+ *
+ * @param[out] pxRing The ring.
+ * @param[in] pucStorage broadcastSTORAGE_SIZE( xItemSize, ulLength ) bytes the
+ * items are kept in.
+ * @param[in] xItemSize The size of an item in bytes.
+ * @param[in] ulLength The number of items the ring holds, below 2^31.
+ */
+void BROADCAST_Init( BroadcastRing_t * pxRing,
+                     uint8_t * pucStorage,
+                     size_t xItemSize,
+                     uint32_t ulLength );
+
+/**
+ * @brief Registers a reader.
+ *
+ * The reader receives the items written after it was registered.
+ *
+ * @param[in] pxRing The ring.
+ * @param[out] pxReader The reader.
+ * @param[in] ePolicy What the reader does when it falls behind.
+ */
+void BROADCAST_ReaderAdd( BroadcastRing_t * pxRing,
+                          BroadcastReader_t * pxReader,
+                          BroadcastPolicy_t ePolicy );
+
+/**
+ * @brief Unregisters a reader.
+ *
+ * Must not be called while the reader is used by BROADCAST_Read(). A producer
+ * that waits for the reader is released.
+ *
+ * @param[in] pxRing The ring.
+ * @param[in] pxReader The reader.
+ */
+void BROADCAST_ReaderRemove( BroadcastRing_t * pxRing,
+                             BroadcastReader_t * pxReader );
+
+/**
+ * @brief Writes an item, for every registered reader.
+ *
+ * Only waits when a reader with the eBroadcastBlockProducer policy has not
+ * read the oldest item yet.
+ *
+ * @param[in] pxRing The ring.
+ * @param[in] pvItem The xItemSize bytes of the item.
+ * @param[in] xTicksToWait The longest time to wait for room.
+ *
+ * @return pdPASS if the item was written, pdFAIL if there was no room in time.
+ */
+BaseType_t BROADCAST_Write( BroadcastRing_t * pxRing,
+                            const void * pvItem,
+                            TickType_t xTicksToWait );
+
+/**
+ * @brief Reads the next item of a reader.
+ *
+ * @param[in] pxRing The ring.
+ * @param[in] pxReader The reader.
+ * @param[out] pvItem Receives the xItemSize bytes of the item.
+ * @param[in] xTicksToWait The longest time to wait for an item.
+ *
+ * @return pdPASS if an item was read, pdFAIL if none was written in time.
+ */
+BaseType_t BROADCAST_Read( BroadcastRing_t * pxRing,
+                           BroadcastReader_t * pxReader,
+                           void * pvItem,
+                           TickType_t xTicksToWait );
+
+/**
+ * @brief Tells how many items a reader lost.
+ *
+ * @param[in] pxReader The reader.
+ *
+ * @return The number of items that were overwritten before the reader read
+ * them, since it was registered. Always 0 for eBroadcastBlockProducer.
+ */
+uint32_t BROADCAST_ReaderDropped( const BroadcastReader_t * pxReader );
+
+#endif /* _AWS_BROADCAST_RING_H_ */
@@ -94,4 +94,167 @@ BaseType_t CRYPTO_SignatureVerificationFinal( void * pvContext,
                                               uint8_t * pucSignature,
                                               size_t xSignatureLength );
 
+/**
+ * @brief Operations that can be offloaded to a hardware crypto engine.
+ */
+#define cryptoACCEL_OPERATION_SHA256     0
+#define cryptoACCEL_OPERATION_AES_GCM    1
+#define cryptoACCEL_OPERATION_COUNT      2
+
+/**
+ * @brief Hardware crypto engine registered by a board port.
+ *
+ * Every hook is optional.  A hook returns pdFALSE when the engine cannot serve
+ * the request, for example because it is busy or the key size is not
+ * supported, without modifying its outputs; the software implementation is
+ * then used instead.
+ */
+typedef struct CryptoAccelerator
+{
+    /* Name of the engine, for logging. */
+    const char * pcName;
+
+    /* Runs the SHA-256 compression function over xBlockCount consecutive
+     * 64-byte blocks, updating the eight state words H0 to H7. */
+    BaseType_t ( * xSHA256Process )( uint32_t pulState[ 8 ],
+                                     const uint8_t * pucBlocks,
+                                     size_t xBlockCount );
+
+    /* AES-GCM encryption (xEncrypt is pdTRUE) or decryption of a whole
+     * message.  The tag computed over the ciphertext is written to pucTag
+     * in both directions. */
+    BaseType_t ( * xAESGCMCrypt )( BaseType_t xEncrypt,
+                                   const uint8_t * pucKey,
+                                   size_t xKeyBits,
+                                   const uint8_t * pucIV,
+                                   size_t xIVLength,
+                                   const uint8_t * pucAAD,
+                                   size_t xAADLength,
+                                   const uint8_t * pucInput,
+                                   size_t xLength,
+                                   uint8_t * pucOutput,
+                                   uint8_t * pucTag,
+                                   size_t xTagLength );
+} CryptoAccelerator_t;
+
+/**
+ * @brief Registers the hardware crypto engine of the board.
+ *
+ * Data shorter than the threshold of an operation is processed in software,
+ * since setting up the engine costs more than it saves for small inputs.
+ * Registering resets the thresholds to their configured default.
+ *
+ * @param[in] pxNewAccelerator Engine hooks, which must remain valid, or NULL to
+ * use software only.
+ */
+void CRYPTO_RegisterAccelerator( const CryptoAccelerator_t * pxNewAccelerator );
+
+/**
+ * @brief Sets the shortest input, in bytes, that is passed to the engine.
+ *
+ * @param[in] xOperation One of the cryptoACCEL_OPERATION_ values.
+ * @param[in] xMinLength Threshold in bytes.
+ */
+void CRYPTO_SetAcceleratorThreshold( BaseType_t xOperation,
+                                     size_t xMinLength );
+
+/**
+ * @brief Gets the shortest input, in bytes, that is passed to the engine.
+ *
+ * @param[in] xOperation One of the cryptoACCEL_OPERATION_ values.
+ *
+ * @return Threshold in bytes.
+ */
+size_t CRYPTO_GetAcceleratorThreshold( BaseType_t xOperation );
+
+/**
+ * @brief Times the engine against software for each operation over a range
+ * of input sizes, and sets each threshold to the size from which the engine
+ * is faster.
+ *
+ * @return pdTRUE if the benchmark ran, or pdFALSE if no engine is registered
+ * or its buffers could not be allocated.
+ */
+BaseType_t CRYPTO_CalibrateAccelerator( void );
+
+/**
+ * @brief Encrypts a message with AES-GCM.
+ *
+ * @param[in] pucKey AES key.
+ * @param[in] xKeyBits Key length in bits: 128, 192 or 256.
+ * @param[in] pucIV Initialization vector.
+ * @param[in] xIVLength Length in bytes of the initialization vector.
+ * @param[in] pucAAD Additional authenticated data.
+ * @param[in] xAADLength Length in bytes of the additional data.
+ * @param[in] pucInput Plaintext.
+ * @param[in] xLength Length in bytes of the plaintext.
+ * @param[out] pucOutput Ciphertext, xLength bytes.
+ * @param[out] pucTag Authentication tag.
+ * @param[in] xTagLength Length in bytes of the tag, at most 16.
+ *
+ * @return pdTRUE on success, or pdFALSE otherwise.
+ */
+BaseType_t CRYPTO_AESGCMEncrypt( const uint8_t * pucKey,
+                                 size_t xKeyBits,
+                                 const uint8_t * pucIV,
+                                 size_t xIVLength,
+                                 const uint8_t * pucAAD,
+                                 size_t xAADLength,
+                                 const uint8_t * pucInput,
+                                 size_t xLength,
+                                 uint8_t * pucOutput,
+                                 uint8_t * pucTag,
+                                 size_t xTagLength );
+
+/**
+ * @brief Decrypts and authenticates a message with AES-GCM.
+ *
+ * The parameters are those of CRYPTO_AESGCMEncrypt(), except that pucInput is
+ * the ciphertext, pucOutput receives the plaintext and pucTag is the tag to
+ * check.  The output is zeroed if the tag does not match.
+ *
+ * @return pdTRUE if the tag matches, or pdFALSE otherwise.
+ */
+BaseType_t CRYPTO_AESGCMDecrypt( const uint8_t * pucKey,
+                                 size_t xKeyBits,
+                                 const uint8_t * pucIV,
+                                 size_t xIVLength,
+                                 const uint8_t * pucAAD,
+                                 size_t xAADLength,
+                                 const uint8_t * pucInput,
+                                 size_t xLength,
+                                 uint8_t * pucOutput,
+                                 const uint8_t * pucTag,
+                                 size_t xTagLength );
+
+/**
+ * @brief SHA-256 compression kernel of the target (see PAL).
+ *
+ * Ports with an optimized, for example assembly, compression function
+ * implement this and define MBEDTLS_SHA256_PROCESS_ALT in the mbedTLS
+ * configuration. mbedTLS then runs every SHA-256 block through it, including
+ * those of OTA image verification and TLS. It has the prototype of
+ * CryptoAccelerator_t::xSHA256Process, so a multi-block kernel can also be
+ * registered as an engine.
+ *
+ * @param[in,out] pulState The eight words of the hash state.
+ * @param[in] pucBlocks xBlockCount consecutive 64-byte blocks.
+ * @param[in] xBlockCount Number of blocks.
+ *
+ * @return pdTRUE on success.
+ */
+BaseType_t CRYPTO_SHA256ProcessBlocks( uint32_t pulState[ 8 ],
+                                       const uint8_t * pucBlocks,
+                                       size_t xBlockCount );
+
+/**
+ * @brief SHA-1 compression kernel of the target (see PAL).
+ *
+ * As CRYPTO_SHA256ProcessBlocks(), for the five words of SHA-1 state, enabled
+ * by MBEDTLS_SHA1_PROCESS_ALT.
+ */
+BaseType_t CRYPTO_SHA1ProcessBlocks( uint32_t pulState[ 5 ],
+                                     const uint8_t * pucBlocks,
+                                     size_t xBlockCount );
+
 #endif /* ifndef __AWS_CRYPTO__H__ */
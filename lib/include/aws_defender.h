@@ -126,6 +126,20 @@ DefenderErr_t DEFENDER_ReportPeriodSet( uint32_t ulPeriodSec );
  */
 DefenderErr_t DEFENDER_ConnectionTimeoutSet( uint32_t ulTimeoutMs );
 
+/**
+ * @brief Publish reports over an MQTT agent the application has connected
+ *
+ * By default the agent creates, connects and deletes its own MQTT agent for
+ * every report.  Given a connected agent, it only subscribes to the report
+ * topics once and publishes on each period; connecting, reconnecting and
+ * deleting the agent remain the application's job.  Pass NULL to go back to
+ * a connection of the agent's own.
+ *
+ * @param[in] pvMQTTAgent Connected MQTTAgentHandle_t to share, or NULL
+ * @return DefenderErr_t eDefenderErrAlreadyStarted if the agent is running
+ */
+DefenderErr_t DEFENDER_MQTTAgentSet( void * pvMQTTAgent );
+
 /**
  * @brief Starts the defender agent
  * @return DefenderErr_t
@@ -0,0 +1,125 @@
+/*
+ * Amazon FreeRTOS Deferred Work
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_deferred_work.h
+ * @brief Run-to-completion deferred work for interrupt bottom halves.
+ *
+ * A driver keeps a DeferredWork_t for each kind of work its interrupt hands
+ * off, and schedules it from the ISR. Scheduling links the item into a list
+ * and, if the list was empty, notifies a single high priority task that runs
+ * the scheduled items in order on its own stack. Nothing is copied and no
+ * queue is involved, so scheduling costs the same whatever the number of
+ * items, and drivers no longer need a handler task each.
+ *
+ * An item is scheduled at most once at a time: scheduling an item that is
+ * already pending does nothing, so several interrupts before the work runs
+ * are handled by one call. The function runs after the item is unlinked, so
+ * it can schedule its own item again. Functions must not block, as they
+ * delay every item scheduled after them.
+ */
+
+#ifndef _AWS_DEFERRED_WORK_H_
+#define _AWS_DEFERRED_WORK_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_deferred_work.h"
+#endif
+
+/**
+ * @brief The function run for a deferred work item.
+ *
+ * @param[in] pvParameter The parameter given to DEFERRED_WorkInit().
+ */
+typedef void (* DeferredWorkFunction_t)( void * pvParameter );
+
+/**
+ * @brief A deferred work item.
+ *
+ * Owned by the caller, which must keep it in memory while it is pending. The
+ * members should only be accessed through the DEFERRED_ functions.
+ */
+typedef struct DeferredWork
+{
+    struct DeferredWork * pxNext;      /**< The next pending item. */
+    DeferredWorkFunction_t pxFunction; /**< The function to run. */
+    void * pvParameter;                /**< The parameter of pxFunction. */
+    volatile BaseType_t xPending;      /**< pdTRUE while the item is scheduled and has not started to run. */
+} DeferredWork_t;
+
+/**
+ * @brief Starts the task that runs deferred work.
+ *
+ * @return pdPASS if the task was created, pdFAIL otherwise.
+ */
+BaseType_t DEFERRED_Init( void );
+
+/**
+ * @brief Prepares a work item before it is first scheduled.
+ *
+ * @param[out] pxWork The item.
+ * @param[in] pxFunction The function the item runs.
+ * @param[in] pvParameter The parameter passed to pxFunction.
+ */
+void DEFERRED_WorkInit( DeferredWork_t * pxWork,
+                        DeferredWorkFunction_t pxFunction,
+                        void * pvParameter );
+
+/**
+ * @brief Schedules a work item from a task.
+ *
+ * @param[in] pxWork The item.
+ *
+ * @return pdPASS if the item was scheduled, pdFAIL if it was already pending.
+ */
+BaseType_t DEFERRED_Schedule( DeferredWork_t * pxWork );
+
+/**
+ * @brief Schedules a work item from an interrupt.
+ *
+ * @param[in] pxWork The item.
+ * @param[out] pxHigherPriorityTaskWoken Set to pdTRUE if the task running
+ * deferred work was woken and a context switch should be requested before
+ * the interrupt exits. May be NULL.
+ *
+ * @return pdPASS if the item was scheduled, pdFAIL if it was already pending.
+ */
+BaseType_t DEFERRED_ScheduleFromISR( DeferredWork_t * pxWork,
+                                     BaseType_t * pxHigherPriorityTaskWoken );
+
+/**
+ * @brief Removes a pending work item without running it.
+ *
+ * Must be called, and the interrupt that schedules the item disabled, before
+ * the memory of an item is reused. The item's function may still be running
+ * when this returns.
+ *
+ * @param[in] pxWork The item.
+ *
+ * @return pdPASS if the item was pending, pdFAIL otherwise.
+ */
+BaseType_t DEFERRED_Cancel( DeferredWork_t * pxWork );
+
+#endif /* _AWS_DEFERRED_WORK_H_ */
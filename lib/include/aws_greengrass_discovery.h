@@ -89,6 +89,50 @@ BaseType_t GGD_GetGGCIPandCertificate( char * pcBuffer,
                                        const uint32_t ulBufferSize,
                                        GGD_HostAddressData_t * pxHostAddressData );
 
+/*
+ * @brief Connect to the cloud and select a core without buffering the JSON file.
+ *
+ * @note: Like GGD_GetGGCIPandCertificate, but the discovery document is
+ * parsed while it is received, in chunks of ggdconfigSTREAM_CHUNK_SIZE bytes.
+ * Only the connectivity entries of the selected core and the first CA of its
+ * group are written to pcBuffer, the remainder of the document is not read.
+ * With xAutoSelectFlag set to pdTRUE, the first group that has a CA and a
+ * core with connectivity entries is selected, and the first entry that
+ * accepts a connection is returned. Otherwise the group and core are those
+ * named in pxHostParameters, and the entry is pxHostParameters->ucInterface
+ * (starting from 1). pxHostAddressData points into pcBuffer.
+ *
+ * @param [in] pcBuffer: Memory buffer provided by the user.
+ *
+ * @param [in] ulBufferSize: Size of the memory buffer.
+ *
+ * @param [in] pxHostParameters: Contains the group name, cloud address of the desired
+ * core to connect to and interface to use.
+ * @warning: Cannot be NULL if xAutoSelectFlag is set to pdFALSE
+ *
+ * @param [out] pxHostAddressData : host address data
+ *
+ * @param [in] xAutoSelectFlag: The user can opt for the auto select option.
+ *             Then pxHostParameters are not used. Can be set to NULL.
+ *
+ * @return If a core was selected then pdPASS is
+ * returned.  Otherwise pdFAIL is returned.
+ */
+BaseType_t GGD_GetGGCIPandCertificateStreamed( char * pcBuffer,
+                                               const uint32_t ulBufferSize,
+                                               const HostParameters_t * pxHostParameters,
+                                               GGD_HostAddressData_t * pxHostAddressData,
+                                               const BaseType_t xAutoSelectFlag );
+
+/*
+ * @brief Forget the cached result of GGD_GetGGCIPandCertificate.
+ *
+ * @note: Only has an effect when ggdconfigDISCOVERY_CACHE is 1. Call it when
+ * the core that was returned from the cache cannot be reached, the next call
+ * to GGD_GetGGCIPandCertificate will then download the discovery document.
+ */
+void GGD_DiscoveryCacheInvalidate( void );
+
 /*
  * @brief HTML request to get the JSON file from the could.
  *
@@ -0,0 +1,133 @@
+/*
+ * Amazon FreeRTOS Heap Profiler
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_heap_profiler.h
+ * @brief Attributes heap usage to call sites and tracks fragmentation.
+ *
+ * Once aws_heap_profiler_hooks.h is included at the end of FreeRTOSConfig.h,
+ * every allocation is added to the site of its caller and task, and the block
+ * is remembered until it is freed, so each site knows how many bytes it holds
+ * right now, the most it ever held, and how much it allocated in total. The
+ * tables are fixed size and hashed, so the cost per allocation does not grow
+ * with the number of blocks and the profiler can be left on in the field.
+ *
+ * Sites are identified by their return address, which addr2line or the map
+ * file turn into a function. All mbedTLS allocations go through the calloc
+ * function installed by CRYPTO_ConfigureHeap(), so they share a call site in
+ * aws_crypto.c, and the task tells TLS done for the MQTT agent from the
+ * signature checks of the OTA agent. The agents' own buffers come from their
+ * own call sites.
+ *
+ * HEAPPROF_PrintReport() prints the heap totals, the allocation rate since
+ * the previous report, the fragmentation of the free space, and the sites
+ * holding the most memory. HEAPPROF_StartReporting() prints it periodically,
+ * which shows these over time.
+ */
+
+#ifndef _AWS_HEAP_PROFILER_H_
+#define _AWS_HEAP_PROFILER_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_heap_profiler.h"
+#endif
+
+#include "task.h"
+#include "aws_heap_profiler_config_defaults.h"
+
+/**
+ * @brief The allocations made from one call site.
+ *
+ * Sizes are in bytes as used by the heap, so they include block headers and
+ * alignment. Totals wrap around.
+ */
+typedef struct HeapProfilerSite
+{
+    const void * pvCaller;                              /**< Where pvPortMalloc() was called from, NULL for the site collecting overflows. */
+    TaskHandle_t xTask;                                 /**< The task that allocated, NULL before the scheduler started. */
+    char cTaskName[ heapprofconfigTASK_NAME_LENGTH ];   /**< The name of the task when the site was first seen. */
+    size_t xLiveBytes;                                  /**< The bytes allocated and not freed yet. */
+    size_t xPeakLiveBytes;                              /**< The largest xLiveBytes seen. */
+    uint32_t ulLiveBlocks;                              /**< The blocks allocated and not freed yet. */
+    uint32_t ulAllocations;                             /**< The number of successful allocations. */
+    uint32_t ulAllocatedBytes;                          /**< The bytes allocated by successful allocations. */
+    uint32_t ulFailures;                                /**< The number of allocations that failed. */
+} HeapProfilerSite_t;
+
+/**
+ * @brief The state of the whole heap at one point in time.
+ */
+typedef struct HeapProfilerSample
+{
+    TickType_t xTime;                  /**< The tick count when the sample was taken. */
+    size_t xFreeBytes;                 /**< xPortGetFreeHeapSize(). */
+    size_t xMinimumEverFreeBytes;      /**< xPortGetMinimumEverFreeHeapSize(). */
+    size_t xLargestFreeBlock;          /**< heapprofconfigLARGEST_FREE_BLOCK(). */
+    uint32_t ulFragmentationPermille;  /**< The part of the free bytes outside the largest free block, in 1/1000. */
+    size_t xLiveBytes;                 /**< The bytes held by tracked blocks. */
+    uint32_t ulLiveBlocks;             /**< The number of tracked blocks. */
+    uint32_t ulUntrackedBlocks;        /**< The blocks that did not fit in the live block table and are not freed yet. */
+    uint32_t ulAllocations;            /**< The number of successful allocations. */
+    uint32_t ulAllocatedBytes;         /**< The bytes allocated by successful allocations. */
+    uint32_t ulFrees;                  /**< The number of blocks freed. */
+    uint32_t ulFailures;               /**< The number of allocations that failed. */
+} HeapProfilerSample_t;
+
+/**
+ * @brief Takes a sample of the heap.
+ *
+ * @param[out] pxSample The sample.
+ */
+void HEAPPROF_GetSample( HeapProfilerSample_t * pxSample );
+
+/**
+ * @brief Copies the call sites seen so far.
+ *
+ * @param[out] pxSites The array to fill in.
+ * @param[in] uxMaxSites The number of entries in pxSites.
+ *
+ * @return The number of entries that were filled in.
+ */
+UBaseType_t HEAPPROF_GetSites( HeapProfilerSite_t * pxSites,
+                               UBaseType_t uxMaxSites );
+
+/**
+ * @brief Prints a sample, the allocation rates since the previous report and
+ * the heapprofconfigREPORT_SITES sites with the most live bytes with
+ * configPRINTF().
+ *
+ * Must not be called by more than one task at a time.
+ */
+void HEAPPROF_PrintReport( void );
+
+/**
+ * @brief Starts a task that calls HEAPPROF_PrintReport() every
+ * heapprofconfigREPORT_PERIOD_MS.
+ *
+ * @return pdPASS if the task was created, pdFAIL otherwise.
+ */
+BaseType_t HEAPPROF_StartReporting( void );
+
+#endif /* _AWS_HEAP_PROFILER_H_ */
@@ -0,0 +1,97 @@
+/*
+ * Amazon FreeRTOS Heap Profiler
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_heap_profiler_hooks.h
+ * @brief Maps the kernel heap trace macros to the heap profiler.
+ *
+ * Include this file at the end of FreeRTOSConfig.h to profile the heap:
+ * @code
+ * #include "aws_heap_profiler_hooks.h"
+ * @endcode
+ *
+ * traceMALLOC() and traceFREE() are expanded inside pvPortMalloc() and
+ * vPortFree() while the scheduler is suspended, which is what serialises the
+ * profiler's tables. A macro defined in FreeRTOSConfig.h before this file is
+ * included is left as it is.
+ */
+
+#ifndef _AWS_HEAP_PROFILER_HOOKS_H_
+#define _AWS_HEAP_PROFILER_HOOKS_H_
+
+#include <stddef.h>
+
+/**
+ * @brief Tells the rest of the application that the profiler is in use.
+ */
+#define heapprofconfigENABLE_HOOKS    ( 1 )
+
+/**
+ * @brief Returns the address pvPortMalloc() was called from.
+ *
+ * Expanded inside pvPortMalloc(), so the return address of the current
+ * function is the call site. Compilers other than GCC and Clang can define
+ * this in FreeRTOSConfig.h, otherwise allocations are only attributed to
+ * tasks.
+ */
+#ifndef heapprofconfigCALLER
+    #if defined( __GNUC__ )
+        #define heapprofconfigCALLER()    ( ( const void * ) __builtin_return_address( 0 ) )
+    #else
+        #define heapprofconfigCALLER()    ( ( const void * ) NULL )
+    #endif
+#endif
+
+/**
+ * @brief Records an allocation. Only to be called with the scheduler suspended.
+ *
+ * @param[in] pvAddress The block returned by pvPortMalloc(), or NULL if the
+ * allocation failed.
+ * @param[in] xSize The number of bytes the heap used for the block.
+ * @param[in] pvCaller The call site of pvPortMalloc().
+ */
+void HEAPPROF_RecordMalloc( void * pvAddress,
+                            size_t xSize,
+                            const void * pvCaller );
+
+/**
+ * @brief Records that a block was freed. Only to be called with the scheduler
+ * suspended.
+ *
+ * @param[in] pvAddress The block passed to vPortFree().
+ */
+void HEAPPROF_RecordFree( void * pvAddress );
+
+#ifndef traceMALLOC
+    #define traceMALLOC( pvAddress, uiSize ) \
+    HEAPPROF_RecordMalloc( ( pvAddress ), ( size_t ) ( uiSize ), heapprofconfigCALLER() )
+#endif
+
+#ifndef traceFREE
+    #define traceFREE( pvAddress, uiSize ) \
+    HEAPPROF_RecordFree( pvAddress )
+#endif
+
+#endif /* _AWS_HEAP_PROFILER_HOOKS_H_ */
@@ -0,0 +1,186 @@
+/*
+ * Amazon FreeRTOS Histogram
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_histogram.h
+ * @brief Fixed size log-linear histograms for latency distributions.
+ *
+ * A histogram counts values in buckets whose width grows with the value, so
+ * a few hundred bytes cover microseconds to seconds with a bounded relative
+ * error: values below 2^histogramconfigSUB_BUCKET_BITS have a bucket each,
+ * and every power of two above is split into 2^histogramconfigSUB_BUCKET_BITS
+ * buckets.
+ *
+ * HISTOGRAM_Record() can be called from any task or interrupt at the same
+ * time. It uses atomic operations where the compiler provides them lock-free,
+ * and masks interrupts for a few instructions otherwise. The other functions
+ * are meant to be called by one reporting task, usually on a snapshot:
+ * HISTOGRAM_SnapshotAndReset() takes the values recorded since the previous
+ * report, HISTOGRAM_Merge() adds histograms, for instance those of several
+ * connections, and HISTOGRAM_GetPercentile() reads a distribution.
+ *
+ * A zero-initialised Histogram_t is empty, so histograms can be static
+ * variables without an initialisation call.
+ */
+
+#ifndef _AWS_HISTOGRAM_H_
+#define _AWS_HISTOGRAM_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_histogram.h"
+#endif
+
+#include "aws_histogram_config_defaults.h"
+
+/**
+ * @brief The number of buckets in each power of two range.
+ */
+#define histogramSUB_BUCKETS    ( 1UL << histogramconfigSUB_BUCKET_BITS )
+
+/**
+ * @brief The number of buckets of a histogram, including the overflow bucket.
+ */
+#define histogramBUCKET_COUNT \
+    ( ( ( histogramconfigVALUE_BITS - histogramconfigSUB_BUCKET_BITS + 1UL ) * histogramSUB_BUCKETS ) + 1UL )
+
+/**
+ * @brief The index of the bucket counting the values of
+ * 2^histogramconfigVALUE_BITS and above.
+ */
+#define histogramOVERFLOW_BUCKET    ( histogramBUCKET_COUNT - 1UL )
+
+/**
+ * @brief A histogram. Its members are only to be read through the functions
+ * below.
+ */
+typedef struct Histogram
+{
+    volatile uint32_t ulCounts[ histogramBUCKET_COUNT ]; /**< The number of values counted in each bucket. */
+    volatile uint32_t ulMax;                             /**< The largest value recorded. */
+    volatile uint32_t ulInvertedMin;                     /**< The bitwise inverse of the smallest value recorded, so that zero means none. */
+} Histogram_t;
+
+/**
+ * @brief Counts a value.
+ *
+ * Can be called from tasks and interrupts.
+ *
+ * @param[in] pxHistogram The histogram.
+ * @param[in] ulValue The value, for instance a latency in microseconds.
+ */
+void HISTOGRAM_Record( Histogram_t * pxHistogram,
+                       uint32_t ulValue );
+
+/**
+ * @brief Empties a histogram.
+ *
+ * Values recorded while the histogram is being reset can be lost.
+ *
+ * @param[in] pxHistogram The histogram.
+ */
+void HISTOGRAM_Reset( Histogram_t * pxHistogram );
+
+/**
+ * @brief Copies a histogram that may be recorded to at the same time.
+ *
+ * @param[in] pxHistogram The histogram.
+ * @param[out] pxSnapshot The copy.
+ */
+void HISTOGRAM_Snapshot( const Histogram_t * pxHistogram,
+                         Histogram_t * pxSnapshot );
+
+/**
+ * @brief Moves the values of a histogram to a snapshot and empties it.
+ *
+ * Every value recorded at the same time ends up either in the snapshot or in
+ * the histogram, so consecutive snapshots can be added up without losing or
+ * counting values twice. Only the minimum and maximum can be off by the
+ * values recorded while the snapshot is taken.
+ *
+ * @param[in] pxHistogram The histogram.
+ * @param[out] pxSnapshot The values counted since the previous reset.
+ */
+void HISTOGRAM_SnapshotAndReset( Histogram_t * pxHistogram,
+                                 Histogram_t * pxSnapshot );
+
+/**
+ * @brief Adds the values of one histogram to another.
+ *
+ * @param[in,out] pxDestination The histogram added to. Must not be recorded to
+ * at the same time.
+ * @param[in] pxSource The histogram added.
+ */
+void HISTOGRAM_Merge( Histogram_t * pxDestination,
+                      const Histogram_t * pxSource );
+
+/**
+ * @brief Returns the number of values counted.
+ */
+uint32_t HISTOGRAM_GetCount( const Histogram_t * pxHistogram );
+
+/**
+ * @brief Returns the smallest value recorded, or 0 if there is none.
+ */
+uint32_t HISTOGRAM_GetMin( const Histogram_t * pxHistogram );
+
+/**
+ * @brief Returns the largest value recorded, or 0 if there is none.
+ */
+uint32_t HISTOGRAM_GetMax( const Histogram_t * pxHistogram );
+
+/**
+ * @brief Returns the mean of the values, from the middle of their buckets.
+ *
+ * @return The mean, within the relative error of the buckets, or 0 if there
+ * are no values.
+ */
+uint32_t HISTOGRAM_GetMean( const Histogram_t * pxHistogram );
+
+/**
+ * @brief Returns a percentile.
+ *
+ * @param[in] pxHistogram The histogram.
+ * @param[in] ulPerMille The part of the values, in 1/1000, that are at most
+ * the result: 500 for the median, 990 for the 99th percentile.
+ *
+ * @return The upper end of the bucket holding the percentile, within the
+ * smallest and largest values recorded, or 0 if there are no values.
+ */
+uint32_t HISTOGRAM_GetPercentile( const Histogram_t * pxHistogram,
+                                  uint32_t ulPerMille );
+
+/**
+ * @brief Returns the index of the bucket a value is counted in.
+ */
+uint32_t HISTOGRAM_GetBucketIndex( uint32_t ulValue );
+
+/**
+ * @brief Returns the smallest value counted in a bucket, which together with
+ * the counts describes a histogram to a receiver that does not know the
+ * configuration.
+ */
+uint32_t HISTOGRAM_GetBucketLowerBound( uint32_t ulBucket );
+
+#endif /* _AWS_HISTOGRAM_H_ */
@@ -0,0 +1,228 @@
+/*
+ * Amazon FreeRTOS Local Bus
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_local_bus.h
+ * @brief A publish/subscribe bus between the tasks of one device.
+ *
+ * Tasks publish messages on topics and subscribe to topic filters with the
+ * same rules as MQTT, matched by the topic filter trie of the MQTT library,
+ * without the messages leaving the device. A message is written once into a
+ * buffer of the central buffer pool and every matching subscriber receives a
+ * pointer to it. Subscribers that keep the message share the buffer through
+ * its reference count, so a message is never copied however many subscribers
+ * it has.
+ *
+ * Subscription callbacks run in the publishing task, one after the other, so
+ * they should be short. A subscriber that needs more time returns eMQTTTrue to
+ * keep the message, hands the MQTTPublishData_t pointer to its own task, for
+ * example through a queue, and calls LOCAL_BUS_ReturnBuffer() with xBuffer
+ * once done.
+ *
+ * LOCAL_BUS_BridgeToMQTT() forwards local messages to a broker through the
+ * MQTT agent, and LOCAL_BUS_PublishFromMQTT() can be registered as an MQTT
+ * agent subscription callback to bring messages from the broker onto the bus.
+ * The topic filters of the two directions must not overlap, or messages would
+ * loop between the bus and the broker.
+ *
+ * The bus is available when mqttconfigENABLE_LOCAL_BUS and
+ * mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT are both set to 1.
+ */
+
+#ifndef _AWS_LOCAL_BUS_H_
+#define _AWS_LOCAL_BUS_H_
+
+/* MQTT includes. */
+#include "aws_mqtt_agent.h"
+
+/**
+ * @brief Connects a set of local topics to an MQTT broker.
+ *
+ * Owned by the application and passed to LOCAL_BUS_BridgeToMQTT(). It must
+ * remain valid until the bridge is removed with LOCAL_BUS_Unsubscribe().
+ */
+typedef struct LocalBusBridge
+{
+    MQTTAgentHandle_t xMQTTHandle; /**< The MQTT client publishing the messages. */
+    MQTTQoS_t xQoS;                /**< The QoS the messages are published with. */
+} LocalBusBridge_t;
+
+/**
+ * @brief Initializes the local bus.
+ *
+ * Must be called once before any other local bus function.
+ *
+ * @return pdPASS if the bus was initialized, pdFAIL otherwise.
+ */
+lib_initDECLARE_LIB_INIT( LOCAL_BUS_Init );
+
+/**
+ * @brief Registers a callback for the messages published on a topic filter.
+ *
+ * Subscribing again to the same topic filter replaces the callback. The
+ * callbacks of topic filters without wild cards are invoked before those of
+ * topic filters with wild cards.
+ *
+ * The callback receives the message in a MQTTPublishData_t whose xBuffer is
+ * the bus buffer. Returning eMQTTTrue keeps a reference to the buffer, which
+ * must later be released with LOCAL_BUS_ReturnBuffer(). The message then
+ * remains valid, including the MQTTPublishData_t itself. Returning eMQTTFalse
+ * lets go of the message once the callback returns. Unlike the MQTT agent,
+ * keeping the message does not stop it being delivered to other subscribers.
+ *
+ * @param[in] pucTopicFilter The topic filter, which can contain wild cards.
+ * @param[in] usTopicFilterLength The length of the topic filter.
+ * @param[in] pxCallback Invoked in the publishing task for each message.
+ * @param[in] pvCallbackContext Passed as it is to pxCallback.
+ *
+ * @return pdPASS if the subscription was stored, pdFAIL if the topic filter
+ * is invalid or too long, or there are already
+ * mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS subscriptions.
+ */
+BaseType_t LOCAL_BUS_Subscribe( const uint8_t * const pucTopicFilter,
+                                uint16_t usTopicFilterLength,
+                                MQTTPublishCallback_t pxCallback,
+                                void * pvCallbackContext );
+
+/**
+ * @brief Removes a subscription or a bridge.
+ *
+ * A publish that was already in progress in another task can still invoke
+ * the callback once after this function returns.
+ *
+ * @param[in] pucTopicFilter The topic filter as it was subscribed to.
+ * @param[in] usTopicFilterLength The length of the topic filter.
+ *
+ * @return pdPASS if the subscription was removed, pdFAIL if there was none.
+ */
+BaseType_t LOCAL_BUS_Unsubscribe( const uint8_t * const pucTopicFilter,
+                                  uint16_t usTopicFilterLength );
+
+/**
+ * @brief Gets a buffer for a message and stores its topic in it.
+ *
+ * The caller writes the payload to *ppvData, which is aligned as specified by
+ * portBYTE_ALIGNMENT, and then passes the returned message to
+ * LOCAL_BUS_Publish(), or releases it with LOCAL_BUS_ReturnBuffer().
+ *
+ * @param[in] pucTopic The topic of the message, which must not contain wild
+ * cards.
+ * @param[in] usTopicLength The length of the topic.
+ * @param[in] ulDataLength The length of the payload.
+ * @param[out] ppvData The location of the payload in the buffer.
+ *
+ * @return The message, or NULL if the buffer pool has no buffer large enough.
+ */
+MQTTPublishData_t * LOCAL_BUS_CreateMessage( const uint8_t * const pucTopic,
+                                             uint16_t usTopicLength,
+                                             uint32_t ulDataLength,
+                                             void ** ppvData );
+
+/**
+ * @brief Delivers a message to all the matching subscribers.
+ *
+ * The message must come from LOCAL_BUS_CreateMessage(). The reference of the
+ * caller is passed to the bus, so the caller must not use the message after
+ * this call.
+ *
+ * @param[in] pxMessage The message to publish.
+ *
+ * @return The number of subscription callbacks invoked.
+ */
+uint32_t LOCAL_BUS_Publish( MQTTPublishData_t * const pxMessage );
+
+/**
+ * @brief Copies a payload into a new message and publishes it.
+ *
+ * @param[in] pucTopic The topic of the message.
+ * @param[in] usTopicLength The length of the topic.
+ * @param[in] pvData The payload.
+ * @param[in] ulDataLength The length of the payload.
+ *
+ * @return pdPASS if the message was published, pdFAIL if there was no buffer
+ * for it.
+ */
+BaseType_t LOCAL_BUS_PublishCopy( const uint8_t * const pucTopic,
+                                  uint16_t usTopicLength,
+                                  const void * pvData,
+                                  uint32_t ulDataLength );
+
+/**
+ * @brief Adds a reference to a message kept by a subscriber.
+ *
+ * Lets a subscriber hand the same message to several tasks. Each reference is
+ * released with LOCAL_BUS_ReturnBuffer().
+ *
+ * @param[in] xBuffer The xBuffer of the message.
+ *
+ * @return pdPASS if the reference was added, pdFAIL if the message already
+ * has the maximum number of references.
+ */
+BaseType_t LOCAL_BUS_RetainBuffer( MQTTBufferHandle_t xBuffer );
+
+/**
+ * @brief Releases a reference to a message.
+ *
+ * @param[in] xBuffer The xBuffer of the message.
+ */
+void LOCAL_BUS_ReturnBuffer( MQTTBufferHandle_t xBuffer );
+
+/**
+ * @brief Forwards the messages published on a topic filter to an MQTT broker.
+ *
+ * Each matching message is kept and passed to MQTT_AGENT_PublishAsync(), so
+ * the publishing task is not held up by the network, and released once the
+ * MQTT agent is done with it. A message is dropped if the asynchronous publish
+ * window of the client is full. This requires mqttconfigASYNC_PUBLISH_WINDOW
+ * to be above 0.
+ *
+ * @param[in] pxBridge The MQTT client and QoS to forward with.
+ * @param[in] pucTopicFilter The topic filter of the messages to forward.
+ * @param[in] usTopicFilterLength The length of the topic filter.
+ *
+ * @return pdPASS if the bridge was added, with the same failures as
+ * LOCAL_BUS_Subscribe() otherwise.
+ */
+BaseType_t LOCAL_BUS_BridgeToMQTT( LocalBusBridge_t * const pxBridge,
+                                   const uint8_t * const pucTopicFilter,
+                                   uint16_t usTopicFilterLength );
+
+/**
+ * @brief Publishes a message received from a broker on the bus.
+ *
+ * Has the signature of an MQTT subscription callback. Set it as
+ * pxPublishCallback in the MQTTAgentSubscribeParams_t passed to
+ * MQTT_AGENT_Subscribe() to bring the messages of the subscription onto the
+ * bus. The message is copied once, out of the MQTT buffer.
+ *
+ * @param[in] pvPublishCallbackContext Not used.
+ * @param[in] pxPublishData The message received from the broker.
+ *
+ * @return eMQTTFalse, as the MQTT buffer is not kept.
+ */
+MQTTBool_t LOCAL_BUS_PublishFromMQTT( void * pvPublishCallbackContext,
+                                      const MQTTPublishData_t * const pxPublishData );
+
+#endif /* _AWS_LOCAL_BUS_H_ */
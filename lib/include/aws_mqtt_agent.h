@@ -76,8 +76,11 @@ typedef enum
  */
 typedef enum
 {
-    eMQTTAgentPublish,   /**< A Publish message was received from the broker. */
-    eMQTTAgentDisconnect /**< The connection to the broker got disconnected. */
+    eMQTTAgentPublish,    /**< A Publish message was received from the broker. */
+    eMQTTAgentDisconnect, /**< The connection to the broker got disconnected. */
+    #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+        eMQTTAgentPublishChunk /**< Part of a Publish message too large for any free buffer was received. */
+    #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
 } MQTTAgentEvent_t;
 
 /**
@@ -94,6 +97,9 @@ typedef struct MQTTAgentCallbackParams
     union
     {
         MQTTPublishData_t xPublishData; /**< Publish data. Meaningful only in case of eMQTTAgentPublish event. */
+        #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+            MQTTPublishChunkData_t xPublishChunkData; /**< Publish chunk data. Meaningful only in case of eMQTTAgentPublishChunk event. */
+        #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
     } u;
 } MQTTAgentCallbackParams_t;
 
@@ -128,6 +134,8 @@ typedef BaseType_t ( * MQTTAgentCallback_t )( void * pvUserData,
 #define mqttagentURL_IS_IP_ADDRESS       0x00000001    /**< Set this bit in xFlags if the provided URL is an IP address. */
 #define mqttagentREQUIRE_TLS             0x00000002    /**< Set this bit in xFlags to use TLS. */
 #define mqttagentUSE_AWS_IOT_ALPN_443    0x00000004    /**< Set this bit in xFlags to use AWS IoT support for MQTT over TLS port 443. */
+#define mqttagentPERSISTENT_SESSION      0x00000008    /**< Set this bit in xFlags to resume the previous session. Requires mqttconfigENABLE_PERSISTENT_SESSION. A QoS1 publish reported as failed by a disconnect may still be delivered after the reconnect. */
+#define mqttagentUSE_MQTT5               0x00000010    /**< Set this bit in xFlags to connect with MQTT 5.0 instead of MQTT 3.1.1. Requires mqttconfigENABLE_MQTT5. */
 
 /**
  * @brief Parameters passed to the MQTT_AGENT_Connect API.
@@ -182,10 +190,59 @@ typedef struct MQTTAgentPublishParams
     const uint8_t * pucTopic; /**< The topic string on which the message should be published. */
     uint16_t usTopicLength;   /**< The length of the topic. */
     MQTTQoS_t xQoS;           /**< Quality of Service (QoS). */
-    const void * pvData;      /**< The data to publish. This data is copied into the MQTT buffers and therefore the user can free the buffer after the MQTT_AGENT_Publish call returns. */
+    const void * pvData;      /**< The data to publish. The user can free the buffer after the MQTT_AGENT_Publish call returns. When mqttconfigENABLE_SENDV is 1, the data is sent from this buffer without being copied. */
     uint32_t ulDataLength;    /**< Length of the data. */
 } MQTTAgentPublishParams_t;
 
+/**
+ * @brief The number of buckets in an MQTTAgentLatencyHistogram_t.
+ */
+#define mqttagentLATENCY_BUCKETS    ( 12 )
+
+/**
+ * @brief Distribution of a latency measured in ticks.
+ *
+ * Bucket 0 counts latencies of 0 ticks. Bucket n counts latencies from
+ * 2^(n-1) to 2^n - 1 ticks, except for the last bucket, which also counts
+ * all longer latencies.
+ */
+typedef struct MQTTAgentLatencyHistogram
+{
+    uint32_t ulBuckets[ mqttagentLATENCY_BUCKETS ]; /**< Number of samples in each bucket. */
+    TickType_t xMaxTicks;                           /**< The longest latency seen. */
+} MQTTAgentLatencyHistogram_t;
+
+/**
+ * @brief Statistics of one connection, as returned by MQTT_AGENT_GetStatistics().
+ *
+ * All the values count from MQTT_AGENT_Create() and wrap around on overflow.
+ */
+typedef struct MQTTAgentStatistics
+{
+    uint32_t ulBytesSent;                          /**< Bytes written to the socket. */
+    uint32_t ulBytesReceived;                      /**< Bytes read from the socket. */
+    uint32_t ulPublishesSent;                      /**< Publishes passed to the MQTT library. */
+    uint32_t ulNoFreeBuffer;                       /**< Received packets dropped and publishes failed because the buffer pool was empty. */
+    MQTTAgentLatencyHistogram_t xPublishToAck;     /**< Time from sending a QoS1 publish to receiving its PUBACK. */
+    MQTTAgentLatencyHistogram_t xCommandQueueWait; /**< Time commands spend in the command queue. */
+    MQTTAgentLatencyHistogram_t xSocketSend;       /**< Time taken by each write to the socket, including TLS. */
+} MQTTAgentStatistics_t;
+
+/**
+ * @brief Signature of the callback invoked when a publish made with
+ * MQTT_AGENT_PublishAsync() completes.
+ *
+ * The callback runs in the context of the MQTT task and must not call any
+ * MQTT agent API.
+ *
+ * @param[in] pvCallbackContext The context passed to MQTT_AGENT_PublishAsync().
+ * @param[in] xReturnCode eMQTTAgentSuccess once a QoS0 publish is sent or a
+ * QoS1 publish is acknowledged, otherwise an error code explaining the reason
+ * of the failure.
+ */
+typedef void ( * MQTTAgentPublishCallback_t )( void * pvCallbackContext,
+                                               MQTTAgentReturnCode_t xReturnCode );
+
 /**
  * @brief MQTT library Init function.
  *
@@ -204,7 +261,8 @@ lib_initDECLARE_LIB_INIT( MQTT_AGENT_Init );
  * in use, this function will fail immediately. Otherwise a new client is setup and the handle
  * to the created client is returned in the pxMQTTHandle parameter which should be used in all
  * the subsequent API calls. Note that the returned handled is only valid if the return value
- * of the API is eMQTTAgentSuccess.
+ * of the API is eMQTTAgentSuccess. When mqttconfigALLOCATE_CONNECTIONS is 1, this function
+ * also fails if the state of the client cannot be allocated.
  *
  * @param[out] pxMQTTHandle Output parameter to return the opaque client handle.
  *
@@ -339,6 +397,43 @@ MQTTAgentReturnCode_t MQTT_AGENT_Publish( MQTTAgentHandle_t xMQTTHandle,
                                           const MQTTAgentPublishParams_t * const pxPublishParams,
                                           TickType_t xTimeoutTicks );
 
+/**
+ * @brief Publishes a message to a given topic without waiting for the result.
+ *
+ * Up to mqttconfigASYNC_PUBLISH_WINDOW publishes per client can be in progress
+ * at once. This function blocks for up to xTimeoutTicks for one of them to
+ * complete if the window is full, then queues the publish and returns. The
+ * result is reported later through pxCallback. Unlike MQTT_AGENT_Publish(),
+ * the topic and data pointed to by pxPublishParams must remain valid until
+ * pxCallback is invoked. The parameters structure itself is copied.
+ *
+ * When mqttconfigENABLE_SENDV is 1, only the publish header is written into a
+ * buffer from the buffer pool and the data is sent in place, so a large payload
+ * is neither copied nor holds a large pool buffer while it is acknowledged.
+ * The data is only copied if the publish is added to a publish batch or kept
+ * in a persistent session.
+ *
+ * @note This function does not alter the calling task's notification state.
+ *
+ * @param[in] xMQTTHandle The opaque handle as returned from MQTT_AGENT_Create.
+ * @param[in] pxPublishParams Publish parameters.
+ * @param[in] pxCallback Invoked once with the result of the publish. Must not be NULL.
+ * @param[in] pvCallbackContext Passed as it is to pxCallback.
+ * @param[in] xTimeoutTicks Maximum time in ticks to wait for space in the window
+ * and in the command queue, and then for the publish to complete. Use pdMS_TO_TICKS
+ * macro to convert milliseconds to ticks.
+ *
+ * @return eMQTTAgentSuccess if the publish was queued, in which case pxCallback
+ * will be invoked, eMQTTAgentTimeout if there was no space, or another error code
+ * explaining the reason of the failure. eMQTTAgentFailure is always returned if
+ * mqttconfigASYNC_PUBLISH_WINDOW is 0.
+ */
+MQTTAgentReturnCode_t MQTT_AGENT_PublishAsync( MQTTAgentHandle_t xMQTTHandle,
+                                               const MQTTAgentPublishParams_t * const pxPublishParams,
+                                               MQTTAgentPublishCallback_t pxCallback,
+                                               void * pvCallbackContext,
+                                               TickType_t xTimeoutTicks );
+
 /**
  * @brief Returns the buffer provided in the publish callback.
  *
@@ -356,4 +451,22 @@ MQTTAgentReturnCode_t MQTT_AGENT_Publish( MQTTAgentHandle_t xMQTTHandle,
 MQTTAgentReturnCode_t MQTT_AGENT_ReturnBuffer( MQTTAgentHandle_t xMQTTHandle,
                                                MQTTBufferHandle_t xBufferHandle );
 
+/**
+ * @brief Copies the statistics of a connection.
+ *
+ * The statistics are updated by the MQTT task without taking any lock. This
+ * function retries the copy until it gets one which no update overlapped.
+ * If the MQTT task was interrupted in the middle of an update, this function
+ * blocks for one tick to let it finish. It must therefore be called from a
+ * task, but it may be called from the MQTT callbacks.
+ *
+ * @param[in] xMQTTHandle The opaque handle as returned from MQTT_AGENT_Create.
+ * @param[out] pxStatistics The statistics are copied here.
+ *
+ * @return eMQTTAgentSuccess if the statistics were copied. eMQTTAgentFailure
+ * is always returned if mqttconfigENABLE_STATISTICS is 0.
+ */
+MQTTAgentReturnCode_t MQTT_AGENT_GetStatistics( MQTTAgentHandle_t xMQTTHandle,
+                                                MQTTAgentStatistics_t * const pxStatistics );
+
 #endif /* _AWS_MQTT_AGENT_H_ */
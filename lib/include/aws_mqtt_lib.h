@@ -81,7 +81,11 @@ typedef enum
     eMQTTNoFreeBuffer,               /**< No free buffer is available for the operation. */
     eMQTTSendFailed,                 /**< The registered send callback failed to transmit data. */
     eMQTTMalformedPacketReceived,    /**< A malformed packet was received. Client has been disconnected. The user must re-connect before carrying out any other operation. */
-    eMQTTSubscriptionManagerFull     /**< No space left in subscription manager to store any more subscriptions. */
+    eMQTTSubscriptionManagerFull,    /**< No space left in subscription manager to store any more subscriptions. */
+    eMQTTTopicFilterTooManyLevels,   /**< The topic filter has more levels than mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS. */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        eMQTTReceiveMaximumReached   /**< As many QoS1 and QoS2 publishes as the MQTT 5.0 broker allows are waiting for their acknowledgment. */
+    #endif /* mqttconfigENABLE_MQTT5 */
 } MQTTReturnCode_t;
 
 /**
@@ -106,7 +110,10 @@ typedef enum
 typedef enum
 {
     eMQTTRxMessageStore, /**< The message being received is being stored. */
-    eMQTTRxMessageDrop   /**< The message being received is being dropped. */
+    eMQTTRxMessageDrop,  /**< The message being received is being dropped. */
+    #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+        eMQTTRxMessageStream /**< The publish being received is passed to the user in chunks. */
+    #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
 } MQTTRxMessageAction_t;
 
 /**
@@ -121,7 +128,7 @@ typedef enum
     eMQTTPublish,            /**< Publish message received from the broker. */
     eMQTTConnACK,            /**< CONNACK received. */
     eMQTTUnexpectedConnACK,  /**< Unexpected CONNACK received. */
-    eMQTTPubACK,             /**< PUBACK received. */
+    eMQTTPubACK,             /**< PUBACK received, or PUBCOMP for a QoS2 publish. */
     eMQTTUnexpectedPubACK,   /**< Unexpected PUBACK received. */
     eMQTTSubACK,             /**< SUBACK received. */
     eMQTTUnexpectedSubACK,   /**< Unexpected SUBACK received. */
@@ -130,7 +137,10 @@ typedef enum
     eMQTTClientDisconnected, /**< Client has been disconnected. The user must re-connect before carrying out any other operation. */
     eMQTTPacketDropped,      /**< A packet was dropped because a large enough buffer was not available to store it. */
     eMQTTTimeout,            /**< Timeout detected - An expected ACK was not received within the specified time. */
-    eMQTTPingTimeout         /**< A PINGRESP was not received within the expected time. */
+    eMQTTPingTimeout,        /**< A PINGRESP was not received within the expected time. */
+    #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+        eMQTTPublishChunk    /**< Part of a publish message too large for any free buffer. */
+    #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
 } MQTTEventType_t;
 
 /**
@@ -144,9 +154,26 @@ typedef enum
     eMQTTDisconnectReasonMalformedPacket,         /**< The client was disconnected because a malformed packet was received. */
     eMQTTDisconnectReasonBrokerRefusedConnection, /**< The client was disconnected because broker refused the connection request. */
     eMQTTDisconnectReasonUserRequest,             /**< The client was disconnected on user request. */
-    eMQTTDisconnectReasonConnectTimeout           /**< The client was disconnected because an expected CONNACK was not received. */
+    eMQTTDisconnectReasonConnectTimeout,          /**< The client was disconnected because an expected CONNACK was not received. */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        eMQTTDisconnectReasonBrokerDisconnect     /**< The client was disconnected because the MQTT 5.0 broker sent a DISCONNECT. */
+    #endif /* mqttconfigENABLE_MQTT5 */
 } MQTTDisconnectReason_t;
 
+#if ( mqttconfigENABLE_MQTT5 == 1 )
+
+/**
+ * @brief The version of the MQTT protocol used on a connection.
+ *
+ * The values are the protocol levels sent in the CONNECT message.
+ */
+    typedef enum
+    {
+        eMQTTProtocolVersion311 = 4, /**< MQTT 3.1.1. */
+        eMQTTProtocolVersion5 = 5    /**< MQTT 5.0. */
+    } MQTTProtocolVersion_t;
+#endif /* mqttconfigENABLE_MQTT5 */
+
 /**
  * @brief Quality of Service (QoS).
  */
@@ -154,7 +181,7 @@ typedef enum
 {
     eMQTTQoS0 = 0, /**< Quality of Service 0 - Fire and Forget. No ACK. */
     eMQTTQoS1 = 1, /**< Quality of Service 1 - Wait till ACK or Timeout. */
-    eMQTTQoS2 = 2  /**< Quality of Service 2 - Not supported. */
+    eMQTTQoS2 = 2  /**< Quality of Service 2 - Exactly once. Requires mqttconfigENABLE_QOS2. */
 } MQTTQoS_t;
 
 /**
@@ -215,6 +242,12 @@ typedef struct MQTTConnACKData
 {
     MQTTConnACKReturnCode_t xConnACKReturnCode; /**< CONNACK return code. @see MQTTConnACKReturnCode_t. */
     uint16_t usPacketIdentifier;                /**< Packet identifier which the user can use to match the CONNACK with the Connect request. */
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        MQTTBool_t xSessionPresent;             /**< Whether the broker resumed the session of a connection made with xCleanSession set to eMQTTFalse. */
+    #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        uint8_t ucReasonCode;                   /**< The reason code of an MQTT 5.0 CONNACK, from which xConnACKReturnCode is derived. */
+    #endif /* mqttconfigENABLE_MQTT5 */
 } MQTTConnACKData_t;
 
 /**
@@ -243,6 +276,9 @@ typedef struct MQTTUnSubACKData
 typedef struct MQTTPubACKData
 {
     uint16_t usPacketIdentifier; /**< Packet identifier which the user can use to match the PUBACK with the Publish request. */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        uint8_t ucReasonCode;    /**< The reason code of an MQTT 5.0 PUBACK, 0 on success. A value of 0x80 or more means the broker did not accept the publish. Always 0 with MQTT 3.1.1 and for PUBCOMP. */
+    #endif /* mqttconfigENABLE_MQTT5 */
 } MQTTPubACKData_t;
 
 /**
@@ -259,6 +295,28 @@ typedef struct MQTTPublishData
     MQTTBufferHandle_t xBuffer; /**< The buffer containing the whole MQTT message. Both pcTopic and pvData are pointers to the locations in this buffer. */
 } MQTTPublishData_t;
 
+#if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+
+/**
+ * @brief The data sent by the MQTT library in the user supplied callback
+ * for each part of a publish message which is streamed.
+ *
+ * The chunks of one message are reported in order. The message is complete
+ * when ulOffset + ulDataLength equals ulTotalLength. The pointers are only
+ * valid during the callback.
+ */
+    typedef struct MQTTPublishChunkData
+    {
+        MQTTQoS_t xQos;           /**< Quality of Service (QoS). */
+        const uint8_t * pucTopic; /**< The topic on which the message is received. */
+        uint16_t usTopicLength;   /**< Length of the topic. */
+        uint32_t ulTotalLength;   /**< Length of the whole message. */
+        uint32_t ulOffset;        /**< Offset of this chunk in the message. */
+        const void * pvData;      /**< The chunk. */
+        uint32_t ulDataLength;    /**< Length of the chunk. */
+    } MQTTPublishChunkData_t;
+#endif /* mqttconfigENABLE_STREAMING_PUBLISH */
+
 /**
  * @brief The data sent by the MQTT library in the user supplied callback
  * when an operation times out.
@@ -275,6 +333,9 @@ typedef struct MQTTTimeoutData
 typedef struct MQTTDisconnectData
 {
     MQTTDisconnectReason_t xDisconnectReason; /**< The reason of disconnect. @see MQTTDisconnectReason_t. */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        uint8_t ucReasonCode;                 /**< The reason code of the DISCONNECT sent by an MQTT 5.0 broker. Valid only with eMQTTDisconnectReasonBrokerDisconnect. */
+    #endif /* mqttconfigENABLE_MQTT5 */
 } MQTTDisconnectData_t;
 
 /**
@@ -295,6 +356,9 @@ typedef struct MQTTCallbackParams
         MQTTPublishData_t xPublishData;       /**< Publish data. */
         MQTTTimeoutData_t xTimeoutData;       /**< Timeout data. */
         MQTTDisconnectData_t xDisconnectData; /**< Disconnect data. */
+        #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+            MQTTPublishChunkData_t xPublishChunkData; /**< Publish chunk data. */
+        #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
     } u;
 } MQTTEventCallbackParams_t;
 
@@ -369,6 +433,35 @@ typedef uint32_t ( * MQTTSend_t )( void * pvSendContext,
                                    const uint8_t * const pucData,
                                    uint32_t ulDataLength );
 
+/**
+ * @brief One of the buffers passed to the gathered send callback.
+ */
+typedef struct MQTTIOVector
+{
+    const uint8_t * pucData; /**< The data to transmit. */
+    uint32_t ulDataLength;   /**< The length of the data. */
+} MQTTIOVector_t;
+
+/**
+ * @brief Signature of the optional user supplied callback to transmit the data
+ * of several buffers in one go.
+ *
+ * If registered, the library uses this callback to transmit the header and
+ * the payload of a publish message directly from the user supplied payload
+ * buffer instead of first copying the payload into a buffer from the buffer
+ * pool. The callback should queue all of the buffers to the network before
+ * transmitting them so that they are sent in as few packets as possible.
+ *
+ * @param[in] pvSendContext The send context as supplied by the user in Init parameters.
+ * @param[in] pxIOVectors The buffers to transmit, in order.
+ * @param[in] ulIOVectorCount The number of buffers in pxIOVectors.
+ *
+ * @return The total number of bytes actually transmitted.
+ */
+typedef uint32_t ( * MQTTSendV_t )( void * pvSendContext,
+                                    const MQTTIOVector_t * const pxIOVectors,
+                                    uint32_t ulIOVectorCount );
+
 /**
  * @brief Signature of the callback to get the current tick count.
  *
@@ -427,6 +520,29 @@ typedef void ( * MQTTReturnBuffer_t )( uint8_t * pucBuffer );
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
+/**
+ * @brief Represents one topic level in the topic filter trie of the
+ * subscription manager.
+ *
+ * The level string is not stored in the node. It is read from the topic filter
+ * of one of the subscriptions passing through the node, all of which contain
+ * the same level at the same offset.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    typedef struct MQTTTopicTrieNode
+    {
+        uint16_t usSubscription; /**< Index of the subscription whose topic filter ends at this node, if any. */
+        uint16_t usSource;       /**< Index of the subscription whose topic filter holds the level string. */
+        uint16_t usLevelOffset;  /**< Offset of the level string in the topic filter. */
+        uint16_t usLevelLength;  /**< Length of the level string. */
+        uint16_t usFirstChild;   /**< First node of the next level. */
+        uint16_t usNextSibling;  /**< Next node on the same level. Links free nodes when the node is not in use. */
+        uint16_t usRefCount;     /**< Number of subscriptions passing through the node. */
+    } MQTTTopicTrieNode_t;
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
 /**
  * @brief The subscription manager used to keep track of user subscriptions
  * and topic specific callbacks.
@@ -437,6 +553,12 @@ typedef void ( * MQTTReturnBuffer_t )( uint8_t * pucBuffer );
     {
         MQTTSubscription_t xSubscriptions[ mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS ]; /**< User subscriptions. */
         uint32_t ulInUseSubscriptions;                                                         /**< Number of subscription entries currently in use. */
+        MQTTTopicTrieNode_t xTrieNodes[ mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES ];       /**< Topic filter trie. Node 0 is the root. */
+        uint16_t usFreeTrieNode;                                                               /**< First free trie node. */
+        uint16_t usFreeTrieNodes;                                                              /**< Number of free trie nodes. */
+        uint16_t usTrieStack[ mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES ];                 /**< Scratch space for walking the trie. */
+        uint16_t usTrieStackOffsets[ mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES ];          /**< Scratch space for walking the trie. */
+        uint16_t usTrieMatches[ mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS ];            /**< Subscriptions matching the topic of a received publish. */
     } MQTTSubscriptionManager_t;
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -481,6 +603,7 @@ typedef struct MQTTContext
     MQTTEventCallback_t pxCallback;                             /**< Callback supplied  by the user to get notified of various events. */
     void * pvSendContext;                                       /**< As supplied by the user in Init parameters. */
     MQTTSend_t pxMQTTSendFxn;                                   /**< Callback supplied by the user to transmit data. */
+    MQTTSendV_t pxMQTTSendVFxn;                                 /**< Optional callback supplied by the user to transmit several buffers at once. */
     MQTTGetTicks_t pxGetTicksFxn;                               /**< Callback supplied by the user to get current tick count. */
     MQTTBufferPoolInterface_t xBufferPoolInterface;             /**< The buffer pool interface supplied by the user. @see MQTTBufferPoolInterface_t. */
     MQTTConnectionState_t xConnectionState;                     /**< The current connection state. */
@@ -492,6 +615,20 @@ typedef struct MQTTContext
     #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
         MQTTSubscriptionManager_t xSubscriptionManager;         /**< The subscription manager used to keep track of user subscriptions and topic specific callbacks.*/
     #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        MQTTBool_t xCleanSession;                               /**< The Clean Session flag of the last connect, eMQTTFalse if the session state is kept across disconnects. */
+    #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+    #if ( mqttconfigENABLE_QOS2 == 1 )
+        uint16_t usQoS2Received[ mqttconfigQOS2_MAX_RECEIVED ]; /**< Packet identifiers of the incoming QoS2 publishes waiting for PUBREL, 0 if free. */
+    #endif /* mqttconfigENABLE_QOS2 */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        MQTTProtocolVersion_t xProtocolVersion;                 /**< The protocol version of the last connect. */
+        uint16_t usReceiveMaximum;                              /**< The number of QoS1 and QoS2 publishes the broker accepts in flight, as received in the CONNACK. */
+    #endif /* mqttconfigENABLE_MQTT5 */
+    #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+        uint8_t ucRxStreamHeader[ mqttFIXED_HEADER_MAX_SIZE + 2 + mqttconfigSTREAMING_PUBLISH_MAX_TOPIC_LENGTH + 2 ]; /**< The fixed header, topic and packet identifier of the publish being streamed. */
+        uint32_t ulRxStreamHeaderLength;                                                                               /**< The length of the above once the topic length is known, 0 before. */
+    #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
 } MQTTContext_t;
 
 /**
@@ -505,6 +642,7 @@ typedef struct MQTTInitParams
     MQTTEventCallback_t pxCallback;                 /**< User supplied callback to get notified of various events. Can be NULL. @see MQTTEventCallback_t.*/
     void * pvSendContext;                           /**< Passed as it is in the send callback. */
     MQTTSend_t pxMQTTSendFxn;                       /**< User supplied callback to transmit data. Must not be NULL. @see MQTTSend_t. */
+    MQTTSendV_t pxMQTTSendVFxn;                     /**< User supplied callback to transmit several buffers at once. Can be NULL. @see MQTTSendV_t. */
     MQTTGetTicks_t pxGetTicksFxn;                   /**< User supplied callback to get the current tick count. Can be NULL. @see MQTTGetTicks_t. */
     MQTTBufferPoolInterface_t xBufferPoolInterface; /**< User supplied buffer pool interface. @see MQTTBufferPoolInterface_t. */
 } MQTTInitParams_t;
@@ -525,6 +663,12 @@ typedef struct MQTTConnectParams
     uint16_t usUserNameLength;               /**< The length of the user name. */
     uint16_t usPacketIdentifier;             /**< The same identifier is returned in the callback when corresponding CONNACK is received or the operation times out. */
     uint32_t ulTimeoutTicks;                 /**< The time interval in ticks after which the operation should fail. */
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        MQTTBool_t xCleanSession;            /**< Set to eMQTTFalse to resume the previous session and keep this one across disconnects. */
+    #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        MQTTProtocolVersion_t xProtocolVersion; /**< The protocol version to connect with. A session must be resumed with the version it was started with. */
+    #endif /* mqttconfigENABLE_MQTT5 */
 } MQTTConnectParams_t;
 
 /**
@@ -571,12 +715,27 @@ typedef struct MQTTPublishParams
     const uint8_t * pucTopic;    /**< The topic to which the data should be published. */
     uint16_t usTopicLength;      /**< The length of the topic. */
     MQTTQoS_t xQos;              /**< Quality of Service. */
-    const void * pvData;         /**< The data to publish. */
+    const void * pvData;         /**< The data to publish. Sent from this buffer without being copied if pxMQTTSendVFxn was supplied, in which case it must remain valid until MQTT_Publish returns. */
     uint32_t ulDataLength;       /**< Length of the data. */
     uint16_t usPacketIdentifier; /**< The same identifier is returned in the callback when corresponding PUBACK is received or the operation times out. */
     uint32_t ulTimeoutTicks;     /**< The time interval in ticks after which the operation should fail. */
 } MQTTPublishParams_t;
 
+#if ( mqttconfigENABLE_PREPARED_TOPICS == 1 )
+
+/**
+ * @brief A publish topic validated and encoded by MQTT_PrepareTopic.
+ *
+ * The members must not be modified by the user. When MQTT 5 topic aliases
+ * are supported, the alias assigned to the topic belongs here too.
+ */
+    typedef struct MQTTPreparedTopic
+    {
+        uint8_t ucEncodedTopic[ 2 + mqttconfigPREPARED_TOPIC_MAX_LENGTH ]; /**< The length prefix followed by the topic, as written in the PUBLISH message. */
+        uint16_t usEncodedTopicLength;                                     /**< The number of valid bytes in ucEncodedTopic. */
+    } MQTTPreparedTopic_t;
+#endif /* mqttconfigENABLE_PREPARED_TOPICS */
+
 /**
  * @brief Initializes the given MQTT Context.
  *
@@ -685,6 +844,45 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
 MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
                                const MQTTPublishParams_t * const pxPublishParams );
 
+#if ( mqttconfigENABLE_PREPARED_TOPICS == 1 )
+
+/**
+ * @brief Validates and encodes a topic to publish to with MQTT_PublishPrepared.
+ *
+ * The topic must not be empty, must not be longer than
+ * mqttconfigPREPARED_TOPIC_MAX_LENGTH and must not contain wildcards. A
+ * prepared topic can be used with any MQTT context and does not have to be
+ * released.
+ *
+ * @param[out] pxPreparedTopic The prepared topic.
+ * @param[in] pucTopic The topic.
+ * @param[in] usTopicLength The length of the topic.
+ *
+ * @return eMQTTSuccess if the topic was prepared, eMQTTFailure if it is not
+ * a valid topic to publish to.
+ */
+    MQTTReturnCode_t MQTT_PrepareTopic( MQTTPreparedTopic_t * const pxPreparedTopic,
+                                        const uint8_t * const pucTopic,
+                                        uint16_t usTopicLength );
+
+/**
+ * @brief Initiates the Publish operation on a prepared topic.
+ *
+ * Same as MQTT_Publish, except that the topic is copied from the prepared
+ * topic and the pucTopic and usTopicLength members of the publish
+ * parameters are ignored.
+ *
+ * @param[in] pxMQTTContext The initialized MQTT context.
+ * @param[in] pxPreparedTopic The topic, as prepared by MQTT_PrepareTopic.
+ * @param[in] pxPublishParams Publish parameters.
+ *
+ * @return eMQTTSuccess if everything succeeds, otherwise an error code explaining the reason of failure.
+ */
+    MQTTReturnCode_t MQTT_PublishPrepared( MQTTContext_t * pxMQTTContext,
+                                           const MQTTPreparedTopic_t * const pxPreparedTopic,
+                                           const MQTTPublishParams_t * const pxPublishParams );
+#endif /* mqttconfigENABLE_PREPARED_TOPICS */
+
 /**
  * @brief Decodes the incoming messages.
  *
@@ -734,4 +932,75 @@ MQTTReturnCode_t MQTT_ReturnBuffer( MQTTContext_t * pxMQTTContext,
 uint32_t MQTT_Periodic( MQTTContext_t * pxMQTTContext,
                         uint64_t xCurrentTickCount );
 
+/**
+ * @brief Empties a subscription manager.
+ *
+ * The subscription manager of an MQTT context is managed by the library. These
+ * functions let other modules match topics against their own set of topic
+ * filters with the same rules and the same topic filter trie.
+ *
+ * The functions are not thread safe. The caller must serialize the calls made
+ * for one subscription manager.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager to empty.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+    void MQTT_SubscriptionManagerInit( MQTTSubscriptionManager_t * const pxSubscriptionManager );
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Stores a topic filter and its callback in a subscription manager.
+ *
+ * An existing entry for the same topic filter is replaced.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] pucTopicFilter The topic filter, which can contain wild cards.
+ * @param[in] usTopicFilterLength The length of the topic filter.
+ * @param[in] pvPublishCallbackContext Stored with the callback.
+ * @param[in] pxPublishCallback Stored with the topic filter.
+ *
+ * @return eMQTTTrue if the topic filter was stored, eMQTTFalse if it is
+ * invalid, too long, has too many levels, or the subscription manager is full.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+    MQTTBool_t MQTT_SubscriptionManagerStore( MQTTSubscriptionManager_t * const pxSubscriptionManager,
+                                              const uint8_t * const pucTopicFilter,
+                                              uint16_t usTopicFilterLength,
+                                              void * pvPublishCallbackContext,
+                                              MQTTPublishCallback_t pxPublishCallback );
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Removes a topic filter from a subscription manager.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] pucTopicFilter The topic filter as it was stored.
+ * @param[in] usTopicFilterLength The length of the topic filter.
+ *
+ * @return eMQTTTrue if the topic filter was found and removed, eMQTTFalse
+ * otherwise.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+    MQTTBool_t MQTT_SubscriptionManagerRemove( MQTTSubscriptionManager_t * const pxSubscriptionManager,
+                                               const uint8_t * const pucTopicFilter,
+                                               uint16_t usTopicFilterLength );
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Finds the topic filters of a subscription manager matching a topic.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] pucTopic The topic, which must not contain wild cards.
+ * @param[in] usTopicLength The length of the topic.
+ *
+ * @return The number of matching entries. The indexes of the entries in
+ * xSubscriptions are stored in the first elements of usTrieMatches, which the
+ * next call overwrites.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+    uint32_t MQTT_SubscriptionManagerMatch( MQTTSubscriptionManager_t * const pxSubscriptionManager,
+                                            const uint8_t * const pucTopic,
+                                            uint16_t usTopicLength );
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
 #endif /* _AWS_MQTT_LIB_H_ */
@@ -0,0 +1,269 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file aws_mqtt_sn.h
+ * @brief MQTT-SN client interface.
+ *
+ * MQTT-SN 1.2 carries MQTT over datagrams, with two byte topic IDs in place
+ * of topic names. It suits devices for which opening a TCP and TLS session
+ * costs more than the messages themselves. Publish, subscribe and unsubscribe
+ * take the same parameters as the MQTT agent, so an application can switch
+ * between the two with few changes. A gateway translates to MQTT for the
+ * broker.
+ *
+ * Unlike the MQTT agent, the client has no task of its own: every call runs in
+ * the calling task, and received publishes are delivered while a call waits
+ * for its reply, or by MQTT_SN_ProcessIncoming().
+ */
+
+#ifndef _AWS_MQTT_SN_H_
+#define _AWS_MQTT_SN_H_
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* The parameter structures and return codes of the MQTT agent are used. */
+#include "aws_mqtt_agent.h"
+
+/* MQTT-SN config defaults. */
+#include "aws_mqtt_sn_config_defaults.h"
+
+/**
+ * @brief Opaque handle to represent an MQTT-SN client.
+ */
+typedef void * MQTTSNHandle_t;
+
+/**
+ * @brief The datagram transport used to reach the gateway.
+ *
+ * Each call sends or receives exactly one MQTT-SN message. The transport
+ * knows the address of the gateway, and does DTLS if it is required, so that
+ * the client works over any datagram socket.
+ */
+typedef struct MQTTSNTransport
+{
+    void * pvContext; /**< Passed as it is to pxSend and pxRecv. */
+
+    /**
+     * @brief Sends one datagram to the gateway.
+     * @return The number of bytes sent, or a negative value on error.
+     */
+    int32_t ( * pxSend )( void * pvContext,
+                          const uint8_t * pucData,
+                          uint32_t ulDataLength );
+
+    /**
+     * @brief Receives one datagram from the gateway, waiting at most xTimeoutTicks.
+     * @return The length of the datagram, 0 if none arrived in time, or a
+     * negative value on error. A longer datagram may be truncated.
+     */
+    int32_t ( * pxRecv )( void * pvContext,
+                          uint8_t * pucBuffer,
+                          uint32_t ulBufferLength,
+                          TickType_t xTimeoutTicks );
+} MQTTSNTransport_t;
+
+/**
+ * @brief Parameters passed to the MQTT_SN_Connect API.
+ */
+typedef struct MQTTSNConnectParams
+{
+    MQTTSNTransport_t xTransport;   /**< The transport to the gateway. It is copied. */
+    const uint8_t * pucClientId;    /**< Client Identifier of the client, 1 to 23 bytes. It is copied. */
+    uint16_t usClientIdLength;      /**< The length of the client Id. */
+    uint16_t usKeepAliveSeconds;    /**< Keep alive period, 0 to disable. MQTT_SN_ProcessIncoming() sends the PINGREQ messages. */
+    BaseType_t xCleanSession;       /**< pdTRUE to start a new session, pdFALSE to resume the previous one. */
+    void * pvUserData;              /**< User data supplied back as it is in the callback. Can be NULL. */
+    MQTTAgentCallback_t pxCallback; /**< Callback used to report publishes for which there is no subscription callback, and disconnects. Can be NULL. */
+} MQTTSNConnectParams_t;
+
+/**
+ * @brief Creates a new MQTT-SN client.
+ *
+ * @param[out] pxHandle Output parameter to return the opaque client handle.
+ *
+ * @return eMQTTAgentSuccess if a new client is created, eMQTTAgentFailure if
+ * mqttsnconfigMAX_CLIENTS clients are in use already.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Create( MQTTSNHandle_t * const pxHandle );
+
+/**
+ * @brief Deletes a client.
+ *
+ * This function does not send anything. Call MQTT_SN_Disconnect() or
+ * MQTT_SN_Sleep() first.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ *
+ * @return eMQTTAgentSuccess if the client was deleted, otherwise an error code.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Delete( MQTTSNHandle_t xHandle );
+
+/**
+ * @brief Connects to an MQTT-SN gateway.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] pxConnectParams Connect parameters.
+ * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail.
+ *
+ * @return eMQTTAgentSuccess if the gateway accepted the connection, otherwise an
+ * error code explaining the reason of the failure.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Connect( MQTTSNHandle_t xHandle,
+                                       const MQTTSNConnectParams_t * const pxConnectParams,
+                                       TickType_t xTimeoutTicks );
+
+/**
+ * @brief Disconnects from the gateway.
+ *
+ * The client forgets all topics, except for the predefined ones.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] xTimeoutTicks Maximum time in ticks to wait for the reply.
+ *
+ * @return eMQTTAgentSuccess if the gateway confirmed the disconnect, otherwise an
+ * error code. The client is disconnected in either case.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Disconnect( MQTTSNHandle_t xHandle,
+                                          TickType_t xTimeoutTicks );
+
+/**
+ * @brief Gives a topic name a topic ID that the gateway knows beforehand.
+ *
+ * Publishes and subscriptions on the topic then send the two byte ID instead of
+ * the name, and need no registration. The ID must match the configuration of
+ * the gateway. Predefined topics are kept across disconnects.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] pucTopic The topic name, without wild cards.
+ * @param[in] usTopicLength The length of the topic.
+ * @param[in] usTopicId The predefined topic ID.
+ *
+ * @return eMQTTAgentSuccess if the topic was stored, eMQTTAgentFailure if the
+ * topic table is full or the topic is too long.
+ */
+MQTTAgentReturnCode_t MQTT_SN_RegisterPredefinedTopic( MQTTSNHandle_t xHandle,
+                                                       const uint8_t * pucTopic,
+                                                       uint16_t usTopicLength,
+                                                       uint16_t usTopicId );
+
+/**
+ * @brief Publishes a message to a given topic.
+ *
+ * A topic that is neither predefined nor two characters long is registered
+ * with the gateway first, once per session. QoS0 and QoS1 are supported. A
+ * sleeping client connects again before publishing.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] pxPublishParams Publish parameters, as for MQTT_AGENT_Publish().
+ * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail.
+ *
+ * @return eMQTTAgentSuccess once a QoS0 publish is sent or a QoS1 publish is
+ * acknowledged, otherwise an error code explaining the reason of the failure.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Publish( MQTTSNHandle_t xHandle,
+                                       const MQTTAgentPublishParams_t * const pxPublishParams,
+                                       TickType_t xTimeoutTicks );
+
+/**
+ * @brief Subscribes to a given topic.
+ *
+ * The topic may be a topic filter with wild cards. The gateway registers each
+ * matching topic with the client before it delivers the first publish on it.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] pxSubscribeParams Subscribe parameters, as for MQTT_AGENT_Subscribe().
+ * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail.
+ *
+ * @return eMQTTAgentSuccess if the gateway accepted the subscription, otherwise an
+ * error code explaining the reason of the failure.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Subscribe( MQTTSNHandle_t xHandle,
+                                         const MQTTAgentSubscribeParams_t * const pxSubscribeParams,
+                                         TickType_t xTimeoutTicks );
+
+/**
+ * @brief Unsubscribes from a given topic.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] pxUnsubscribeParams Unsubscribe parameters, as for MQTT_AGENT_Unsubscribe().
+ * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail.
+ *
+ * @return eMQTTAgentSuccess if the gateway confirmed, otherwise an error code.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Unsubscribe( MQTTSNHandle_t xHandle,
+                                           const MQTTAgentUnsubscribeParams_t * const pxUnsubscribeParams,
+                                           TickType_t xTimeoutTicks );
+
+/**
+ * @brief Tells the gateway that the client goes to sleep.
+ *
+ * The gateway keeps the session and buffers the publishes for the client
+ * until it wakes up. The device can then power down its radio.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] usDurationSeconds How long the client sleeps at most. The gateway
+ * drops the session when the client does not wake up in time.
+ * @param[in] xTimeoutTicks Maximum time in ticks to wait for the reply.
+ *
+ * @return eMQTTAgentSuccess if the gateway confirmed, otherwise an error code.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Sleep( MQTTSNHandle_t xHandle,
+                                     uint16_t usDurationSeconds,
+                                     TickType_t xTimeoutTicks );
+
+/**
+ * @brief Collects the publishes which the gateway buffered while the client slept.
+ *
+ * They are delivered to the callbacks before this function returns. The client
+ * goes back to sleep afterwards, for the duration given to MQTT_SN_Sleep().
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] xTimeoutTicks Maximum time in ticks to wait for all of them.
+ *
+ * @return eMQTTAgentSuccess if the gateway signalled the end of its buffer,
+ * otherwise an error code.
+ */
+MQTTAgentReturnCode_t MQTT_SN_Wake( MQTTSNHandle_t xHandle,
+                                    TickType_t xTimeoutTicks );
+
+/**
+ * @brief Delivers the publishes received from the gateway, and keeps the
+ * connection alive.
+ *
+ * An application that subscribes, and does not sleep, calls this in a loop.
+ *
+ * @param[in] xHandle The opaque handle as returned from MQTT_SN_Create.
+ * @param[in] xTimeoutTicks How long to wait for a datagram.
+ *
+ * @return eMQTTAgentSuccess if datagrams were processed, eMQTTAgentTimeout if
+ * none arrived, or eMQTTAgentFailure if the client is not connected.
+ */
+MQTTAgentReturnCode_t MQTT_SN_ProcessIncoming( MQTTSNHandle_t xHandle,
+                                               TickType_t xTimeoutTicks );
+
+#endif /* _AWS_MQTT_SN_H_ */
@@ -154,6 +154,9 @@ typedef uint32_t OTA_Err_t;
 #define kOTA_Err_UserAbort               0x28000000UL     /*!< User aborted the active OTA. */
 #define kOTA_Err_ResetNotSupported       0x29000000UL     /*!< We tried to reset the device but the device doesn't support it. */
 #define kOTA_Err_TopicTooLarge           0x2a000000UL     /*!< Attempt to build a topic string larger than the supplied buffer. */
+#define kOTA_Err_DeltaUpdateFailed       0x2b000000UL     /*!< A delta update could not be applied. The sub code is the negated OTA_DeltaResult_t, if any. */
+#define kOTA_Err_DecompressFailed        0x2c000000UL     /*!< A compressed file could not be decompressed. The sub code is the negated OTA_DecompressResult_t, if any. */
+#define kOTA_Err_CheckpointFailed        0x2d000000UL     /*!< The transfer checkpoint could not be stored. */
 
 /**
  * @brief OTA Job callback events.
@@ -206,6 +209,12 @@ typedef enum
 } OTA_ImageState_t;
 
 
+/**
+ * @brief OTA file attribute flags.
+ */
+#define OTA_FILE_ATTRIB_DELTA          0x00000008UL /*!< The file is a patch that rebuilds the new image from the running one. */
+#define OTA_FILE_ATTRIB_COMPRESSED     0x00000010UL /*!< The file is compressed. A compressed patch carries both attributes. */
+
 /**
  * @brief OTA File Context Information.
  *
@@ -234,9 +243,16 @@ typedef struct
     uint8_t * pucStreamName;     /*!< The stream associated with this file from the OTA service. */
     Sig256_t * pxSignature;      /*!< Pointer to the file's signature structure. */
     uint8_t * pucRxBlockBitmap;  /*!< Bitmap of blocks received (for de-duping and missing block request). */
+    uint32_t ulBitmapBase;       /*!< Index of the first block tracked by pucRxBlockBitmap. All blocks before it were received. */
     uint8_t * pucCertFilepath;   /*!< Pathname of the certificate file used to validate the receive file. */
     uint32_t ulUpdaterVersion;   /*!< Used by OTA self-test detection, the version of FW that did the update. */
     bool_t xIsInSelfTest;        /*!< True if the job is in self test mode. */
+    void * pvSigVerifyContext;   /*!< Signature verification context fed by the agent during block ingest, or NULL. */
+    uint32_t ulHashedBlocks;     /*!< Number of leading file blocks already added to pvSigVerifyContext. */
+    void * pvDeltaContext;       /*!< Patch applier state when the file is a delta update, or NULL. */
+    void * pvDecompressContext;  /*!< Decompressor state when the file is compressed, or NULL. */
+    uint8_t * pucUpdateUrl;      /*!< URL the file data is fetched from over HTTP, or NULL to use the data stream. */
+    bool_t xFromGreengrassCache; /*!< True when pucUpdateUrl is the Greengrass core cache, with the data stream to fall back to. */
 } OTA_FileContext_t;
 
 
@@ -410,4 +426,32 @@ uint32_t OTA_GetPacketsProcessed( void );
  */
 uint32_t OTA_GetPacketsDropped( void );
 
+/**
+ * @brief Transfer statistics of the file being received, or of the last one.
+ *
+ * Times are totals in milliseconds. They are collected when otaconfigENABLE_TRANSFER_STATS
+ * is set to 1 and restart with every new file.
+ */
+typedef struct
+{
+    uint32_t ulRequestWaitMs;         /*!< Time from a data request until any block arrived. */
+    uint32_t ulDecodeMs;              /*!< Time spent decoding the stream data messages. */
+    uint32_t ulWriteMs;               /*!< Time spent writing file data to storage. */
+    uint32_t ulVerifyMs;              /*!< Time spent closing the file, which checks its signature. */
+    uint32_t ulActivateMs;            /*!< Time spent in OTA_ActivateNewImage(), if it returned. */
+    uint32_t ulBytesReceived;         /*!< File bytes received, not counting duplicates. */
+    uint32_t ulCurrentBytesPerSecond; /*!< Receive rate over the last second or so. */
+    uint32_t ulAverageBytesPerSecond; /*!< Receive rate since the first data request of the file. */
+    uint32_t ulDuplicateBlocks;       /*!< Blocks received that were already received. */
+    uint32_t ulRequestRetries;        /*!< Data requests sent again before any block arrived. */
+} OTA_TransferStats_t;
+
+/**
+ * @brief Get the transfer statistics of the file being received, or of the last one.
+ *
+ * @param[out] pxStats Receives the statistics. They are all zero when
+ * otaconfigENABLE_TRANSFER_STATS is not set to 1.
+ */
+void OTA_GetTransferStats( OTA_TransferStats_t * pxStats );
+
 #endif /* ifndef _AWS_OTA_AGENT_H_ */
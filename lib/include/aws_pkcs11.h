@@ -113,4 +113,107 @@ typedef struct PKCS11_GenerateKeyPrivateTemplate
 
 #define pkcs11INVALID_OBJECT_HANDLE                     0
 
+/**
+ * @brief Returned by PKCS11_SignAsyncPoll() while the signature is still
+ * being computed.
+ */
+#define pkcs11CKR_SIGN_IN_PROGRESS                      ( CKR_VENDOR_DEFINED | 0x1UL )
+
+/**
+ * @brief Starts computing a signature of the hash without waiting for it.
+ *
+ * This is an extension to C_Sign() for callers that can do other work while a
+ * slow signature, such as one from a secure element, is computed.  It must be
+ * preceded by C_SignInit(), and is followed by calls to PKCS11_SignAsyncPoll()
+ * until that no longer returns pkcs11CKR_SIGN_IN_PROGRESS.  The session lock
+ * is only held during each call, so other users of the session interleave.
+ *
+ * @param[in] xSession Session handle.
+ * @param[in] pucData SHA-256 hash to sign.
+ * @param[in] ulDataLen Length in bytes of the hash.
+ *
+ * @return CKR_OK if the signature was started.
+ */
+CK_RV PKCS11_SignAsyncStart( CK_SESSION_HANDLE xSession,
+                             CK_BYTE_PTR pucData,
+                             CK_ULONG ulDataLen );
+
+/**
+ * @brief Advances the signature started with PKCS11_SignAsyncStart().
+ *
+ * @param[in] xSession Session handle.
+ * @param[out] pucSignature Signature, which must have room for the largest
+ * signature of the key; the same buffer must be passed to every call for a
+ * given signature.
+ * @param[out] pulSignatureLen Length of the signature.
+ *
+ * @return pkcs11CKR_SIGN_IN_PROGRESS if the signature is not ready yet, CKR_OK
+ * once it is in pucSignature, or an error, which ends the operation.
+ */
+CK_RV PKCS11_SignAsyncPoll( CK_SESSION_HANDLE xSession,
+                            CK_BYTE_PTR pucSignature,
+                            CK_ULONG_PTR pulSignatureLen );
+
+/**
+ * @brief Abandons the signature started with PKCS11_SignAsyncStart(), if any.
+ *
+ * @param[in] xSession Session handle.
+ *
+ * @return CKR_OK.
+ */
+CK_RV PKCS11_SignAsyncAbort( CK_SESSION_HANDLE xSession );
+
+/**
+ * @brief Gets the value of a public object without copying it out of flash.
+ *
+ * This is an extension to C_GetAttributeValue() for CKA_VALUE, available when
+ * the PAL keeps objects in memory-mapped flash and sets
+ * pkcs11configPAL_OBJECTS_MAPPED.  The value stays readable until the object
+ * is written again.
+ *
+ * @param[in] xSession Session handle.
+ * @param[in] xObject Object handle, as returned by C_FindObjects().
+ * @param[out] ppucValue Receives a pointer to the value.
+ * @param[out] pulValueLen Receives the length of the value.
+ *
+ * @return CKR_OK, CKR_ATTRIBUTE_SENSITIVE for a private key, or
+ * CKR_FUNCTION_NOT_SUPPORTED if the PAL copies the objects into RAM.
+ */
+CK_RV PKCS11_GetObjectValueInPlace( CK_SESSION_HANDLE xSession,
+                                    CK_OBJECT_HANDLE xObject,
+                                    const CK_BYTE ** ppucValue,
+                                    CK_ULONG_PTR pulValueLen );
+
+/**
+ * @brief Time spent in one kind of PKCS#11 operation since C_Initialize().
+ */
+typedef struct PKCS11OperationTiming
+{
+    uint32_t ulCount; /**< Operations completed. */
+    uint32_t ulTime;  /**< Total time, in units of pkcs11configTIMESTAMP(). */
+} PKCS11OperationTiming_t;
+
+/**
+ * @brief Time spent in the PKCS#11 operations of all sessions.
+ */
+typedef struct PKCS11OperationTimings
+{
+    PKCS11OperationTiming_t xSign;             /**< C_Sign() and PKCS11_SignAsyncPoll(). */
+    PKCS11OperationTiming_t xVerify;           /**< C_Verify(). */
+    PKCS11OperationTiming_t xFindObjects;      /**< C_FindObjects(). */
+    PKCS11OperationTiming_t xGetAttributeValue; /**< C_GetAttributeValue(), which reads the object. */
+    PKCS11OperationTiming_t xGenerateRandom;   /**< C_GenerateRandom(). */
+} PKCS11OperationTimings_t;
+
+/**
+ * @brief Gets the time spent in PKCS#11 operations.
+ *
+ * Requires pkcs11configENABLE_OPERATION_TIMING; otherwise everything reads 0.
+ *
+ * @param[out] pxTimings The totals since C_Initialize().
+ *
+ * @return CKR_OK, or CKR_ARGUMENTS_BAD if pxTimings is NULL.
+ */
+CK_RV PKCS11_GetOperationTimings( PKCS11OperationTimings_t * pxTimings );
+
 #endif /* ifndef _AWS_PKCS11_H_ */
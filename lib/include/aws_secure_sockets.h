@@ -136,7 +136,7 @@ typedef void * Socket_t;
  *
  */
 /**@{ */
-#define SOCKETS_IPPROTO_UDP    ( 17 )   /*!< UDP. This option is currently not supported. */
+#define SOCKETS_IPPROTO_UDP    ( 17 )   /*!< UDP. Only supported by the FreeRTOS+TCP port. */
 #define SOCKETS_IPPROTO_TCP    ( 6 )    /*!< TCP. */
 /**@} */
 
@@ -171,6 +171,17 @@ typedef void * Socket_t;
 #define SOCKETS_SHUT_RDWR    ( 2 )  /**< No further send or receive. */
 /**@} */
 
+/**
+ * @defgroup PollEvents Secure Sockets Poll Events
+ *
+ * @brief Events requested from and reported by SOCKETS_Poll().
+ */
+/**@{ */
+#define SOCKETS_POLLIN     ( 1U ) /**< Data can be received without blocking. */
+#define SOCKETS_POLLOUT    ( 2U ) /**< Data can be sent without blocking. */
+#define SOCKETS_POLLERR    ( 4U ) /**< The connection was closed or has failed. Always reported, even if not requested. */
+/**@} */
+
 /**
  * @brief Maximum length of an ASCII DNS name.
  */
@@ -189,6 +200,17 @@ typedef struct SocketsSockaddr
     uint32_t ulAddress;     /**< IP Address. Convention is to call this sin_addr. */
 } SocketsSockaddr_t;
 
+/**
+ * @brief One of the buffers of a gathered send.
+ *
+ * @see SOCKETS_SendV
+ */
+typedef struct SocketsIOVector
+{
+    const void * pvBuffer; /**< The buffer containing the data to be sent. */
+    size_t xDataLength;    /**< The length of the data in the buffer. */
+} SocketsIOVector_t;
+
 /**
  * @brief Well-known port numbers.
  */
@@ -215,9 +237,13 @@ lib_initDECLARE_LIB_INIT( SOCKETS_Init );
  *
  * @param[in] lDomain Must be set to SOCKETS_AF_INET. See @ref SocketDomains.
  * @param[in] lType Set to SOCKETS_SOCK_STREAM to create a TCP socket.
- * No other value is valid.  See @ref SocketTypes.
- * @param[in] lProtocol Set to SOCKETS_IPPROTO_TCP to create a TCP socket.
- * No other value is valid. See @ref Protocols.
+ * Ports that support UDP also accept SOCKETS_SOCK_DGRAM. See @ref SocketTypes.
+ * @param[in] lProtocol Set to SOCKETS_IPPROTO_TCP to create a TCP socket, or
+ * SOCKETS_IPPROTO_UDP with SOCKETS_SOCK_DGRAM. See @ref Protocols.
+ *
+ * A UDP socket sends to and receives from the address given to
+ * SOCKETS_Connect(), one datagram per call, and negotiates DTLS when
+ * SOCKETS_SO_REQUIRE_TLS is set.
  *
  * @return
  * * If a socket is created successfully, then the socket handle is
@@ -280,6 +306,50 @@ int32_t SOCKETS_Recv( Socket_t xSocket,
                       size_t xBufferLength,
                       uint32_t ulFlags );
 
+/**
+ * @brief Receive data from a TCP socket without copying it.
+ *
+ * Instead of copying the received data into a caller supplied buffer, a
+ * pointer to the data in the receive buffer of the underlying TCP/IP stack is
+ * returned. The data remains in the receive buffer until it is released using
+ * SOCKETS_ReleaseZeroCopy(), which must be called before the next call to
+ * SOCKETS_RecvZeroCopy() or SOCKETS_Recv() on the same socket.
+ *
+ * On sockets which use TLS, the data is the decrypted payload of the current
+ * TLS record, returned from the record buffer of the TLS library, so at most
+ * one record is returned per call. Zero copy reception is an optional part of
+ * the Secure Sockets interface which is currently only provided by the
+ * FreeRTOS+TCP port.
+ *
+ * @param[in] xSocket The handle of the socket from which data is being received.
+ * @param[out] ppucData Set to point to the received data.
+ * @param[in] xMaxLength The maximum number of bytes to return.
+ *
+ * @return
+ * * If the receive was successful then the number of contiguous bytes available
+ *   at *ppucData is returned.
+ * * If no data is available, 0 or SOCKETS_EWOULDBLOCK is returned as for
+ *   SOCKETS_Recv().
+ * * If an error occurred, a negative value is returned. @ref SocketsErrors
+ */
+int32_t SOCKETS_RecvZeroCopy( Socket_t xSocket,
+                              uint8_t ** ppucData,
+                              size_t xMaxLength );
+
+/**
+ * @brief Releases data obtained from SOCKETS_RecvZeroCopy().
+ *
+ * @param[in] xSocket The handle of the socket the data was received on.
+ * @param[in] xLength The number of bytes to release. Must not be larger than
+ * the value returned by the preceding call to SOCKETS_RecvZeroCopy().
+ *
+ * @return
+ * * On success, 0 is returned.
+ * * If an error occurred, a negative value is returned. @ref SocketsErrors
+ */
+int32_t SOCKETS_ReleaseZeroCopy( Socket_t xSocket,
+                                 size_t xLength );
+
 /**
  * @brief Transmit data to the remote socket.
  *
@@ -300,6 +370,64 @@ int32_t SOCKETS_Send( Socket_t xSocket,
                       size_t xDataLength,
                       uint32_t ulFlags );
 
+/**
+ * @brief Transmit the data of several buffers to the remote socket as if it
+ * was one contiguous buffer.
+ *
+ * The data is queued to the network stack before any of it is transmitted so
+ * that small buffers, for example protocol headers, end up in the same TCP
+ * segment as the data that follows them. On a TLS socket, the buffers are
+ * encrypted into as few TLS records as possible. This is an optional part of
+ * the Secure Sockets interface which is currently only provided by the
+ * FreeRTOS+TCP port.
+ *
+ * @param[in] xSocket The handle of the sending socket.
+ * @param[in] pxIOVectors The buffers to send, in order.
+ * @param[in] xIOVectorCount The number of buffers in pxIOVectors. Must not
+ * exceed socketsconfigMAX_SENDV_VECTORS.
+ * @param[in] ulFlags Not currently used. Should be set to 0.
+ *
+ * @return
+ * * On success, the number of bytes actually sent is returned. As with
+ * SOCKETS_Send(), this may be less than the total length of the buffers.
+ * * If an error occurred, a negative value is returned. @ref SocketsErrors
+ */
+int32_t SOCKETS_SendV( Socket_t xSocket,
+                       const SocketsIOVector_t * pxIOVectors,
+                       size_t xIOVectorCount,
+                       uint32_t ulFlags );
+
+/**
+ * @brief Waits until at least one of several sockets is ready.
+ *
+ * On sockets which use TLS, data that has already been decrypted into the
+ * record buffer of the TLS library counts as received data, so a socket is
+ * reported readable even if the TCP/IP stack holds nothing more for it. This
+ * is an optional part of the Secure Sockets interface which is currently
+ * provided by the FreeRTOS+TCP port, when built with
+ * ipconfigSUPPORT_SELECT_FUNCTION, and by the lwIP port.
+ *
+ * \warning Under FreeRTOS+TCP a socket can only be a member of one socket
+ * set, so SOCKETS_Poll() must not be called on the same socket from multiple
+ * threads simultaneously.
+ *
+ * @param[in] pxSockets The sockets to wait on.
+ * @param[in,out] pulEvents One entry per socket. On entry, the @ref PollEvents
+ * to wait for on that socket. On return, the events that are ready, or 0.
+ * @param[in] xSocketCount The number of entries in pxSockets and pulEvents.
+ * @param[in] xTimeout The maximum time to wait, in ticks. 0 checks the
+ * sockets without blocking.
+ *
+ * @return
+ * * The number of sockets with at least one event ready.
+ * * 0 if the timeout expired first.
+ * * If an error occurred, a negative value is returned. @ref SocketsErrors
+ */
+int32_t SOCKETS_Poll( const Socket_t * pxSockets,
+                      uint32_t * pulEvents,
+                      size_t xSocketCount,
+                      TickType_t xTimeout );
+
 /**
  * @brief Closes all or part of a full-duplex connection on the socket.
  *
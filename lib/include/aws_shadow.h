@@ -35,6 +35,10 @@
 
 #include "aws_mqtt_agent.h"
 
+/* The configuration selects the members of ShadowCreateParams_t. */
+#include "aws_shadow_config.h"
+#include "aws_shadow_config_defaults.h"
+
 
 /**
  * @brief The handle of a Shadow Client.
@@ -113,6 +117,20 @@ typedef enum ShadowMQTTClientType
     eDedicatedMQTTClient
 } ShadowMQTTClientType_t;
 
+/**
+ * @brief Encoding of the Shadow documents of a Shadow Client.
+ *
+ * The possible values of #ShadowCreateParams_t.xPayloadFormat.
+ */
+typedef enum ShadowPayloadFormat
+{
+    /** Documents are JSON. */
+    eShadowPayloadJSON = 0,
+    /** Documents are CBOR maps with the same members as the JSON documents.
+     * Requires #shadowconfigENABLE_CBOR. */
+    eShadowPayloadCBOR
+} ShadowPayloadFormat_t;
+
 /**
  * @brief Parameters to pass into #SHADOW_ClientCreate.
  */
@@ -133,6 +151,18 @@ typedef struct ShadowCreateParams
      * the handle of the shared client. This member is ignored if
      #ShadowCreateParams_t.xMQTTClientType is #eDedicatedMQTTClient. */
     MQTTAgentHandle_t xMQTTClientHandle;
+
+    #if ( shadowconfigENABLE_CBOR == 1 )
+
+        /**
+         * @brief Encoding of the documents sent and received.
+         *
+         * With #eShadowPayloadCBOR, the documents given to #SHADOW_Update and
+         * returned by #SHADOW_Get and the callbacks are CBOR, and the Shadow
+         * Client reads the client token and error codes from CBOR.
+         * @see ShadowPayloadFormat. */
+        ShadowPayloadFormat_t xPayloadFormat;
+    #endif
 } ShadowCreateParams_t;
 
 /**
@@ -183,6 +213,8 @@ typedef struct ShadowOperationParams
      * to @c 1, saving time if the same operation is performed again. Set this
      * value to @c 0 to deactivate the operation's MQTT subscriptions after the
      * operation completes.
+     * Kept subscriptions are removed, least recently used first, when the Shadow
+     * Client needs room for others; see #shadowconfigSUBSCRIPTION_CACHE_SIZE.
      * @warning Users may be billed for extraneous messages received on an
      * operation's MQTT topics. If other clients are publishing to the same topics,
      * it is best to deactivate the subscriptions. */
@@ -267,6 +299,44 @@ typedef BaseType_t ( * ShadowDeltaCallback_t )( void * pvUserData,
                                                 uint32_t ulDocumentLength,
                                                 MQTTBufferHandle_t xBuffer );
 
+/**
+ * @brief Function header of a per-property delta handler registered with
+ * #SHADOW_RegisterDeltaHandlers.
+ *
+ * @param in: Custom user data.
+ * @param pcThingName The Thing Name of the delta document.
+ * @param pcPath The path the handler was registered with.
+ * @param pcValue The new desired value in the delta document. Strings are
+ * given without their quotes and escape sequences are not decoded.
+ * @param ulValueLength The length of @p pcValue.
+ *
+ * @note Handlers are called from the MQTT task, in document order, before any
+ * #ShadowDeltaCallback_t of the Thing. @p pcValue is only valid during the call.
+ * @warning <b> Do not make any blocking calls (including #SHADOW_Update, #SHADOW_Get,
+ * #SHADOW_Delete or #SHADOW_RegisterDeltaHandlers) in a handler! </b>
+ */
+typedef void ( * ShadowDeltaHandler_t )( void * pvUserData,
+                                         const char * const pcThingName,
+                                         const char * const pcPath,
+                                         const char * const pcValue,
+                                         uint32_t ulValueLength );
+
+/**
+ * @brief A per-property delta handler.
+ */
+typedef struct ShadowDeltaHandlerParams
+{
+    /**
+     * @brief Path of the property within the "state" of the delta document,
+     * for example "color" or "lights.kitchen.on". Array elements are written
+     * with their index, for example "leds[2]".
+     */
+    const char * pcPath;
+
+    /** @brief Called with the value of the property when it appears in a delta. */
+    ShadowDeltaHandler_t xHandler;
+} ShadowDeltaHandlerParams_t;
+
 /**
  * @brief Parameters to #SHADOW_RegisterCallbacks.
  */
@@ -334,6 +404,8 @@ ShadowReturnCode_t SHADOW_ClientCreate( ShadowClientHandle_t * pxShadowClientHan
  * @param[in] pxConnectParams Pointer to a @c TradstoneMQTTConnectParams_t struct.
  * Note: ClientHandle should be at the top of user data passed in pxConnectParams
  * @param[in] xTimeoutTicks Number of ticks this function may block before timeout.
+ * With #shadowconfigSUBSCRIBE_WILDCARD, it applies to the connection and to the
+ * wildcard subscription that follows each.
  *
  * @return #ShadowReturnCode.
  */
@@ -388,6 +460,9 @@ ShadowReturnCode_t SHADOW_ClientDelete( ShadowClientHandle_t xShadowClientHandle
  * will not be notified if acceptance occurs after a timeout. The user may
  * intentionally set a short timeout if the result of the update isn't relevant,
  * but the timeout must still be long enough for the update to be published.
+ * - Up to #shadowconfigMAX_PENDING_OPERATIONS operations may be in progress on
+ * a Shadow Client at once. Concurrent updates of the same Thing are matched to
+ * their responses by clientToken, so each must have a unique clientToken.
  */
 ShadowReturnCode_t SHADOW_Update( ShadowClientHandle_t xShadowClientHandle,
                                   ShadowOperationParams_t * const pxUpdateParams,
@@ -464,6 +539,42 @@ ShadowReturnCode_t SHADOW_RegisterCallbacks( ShadowClientHandle_t xShadowClientH
                                              ShadowCallbackParams_t * const pxCallbackParams,
                                              TickType_t xTimeoutTicks );
 
+/**
+ * @brief Register per-property handlers for the delta documents of a Thing.
+ *
+ * The paths are compiled into a dispatch trie. Each delta document is then
+ * parsed once, and only the handlers whose property appears in it are called.
+ *
+ * @param[in] xShadowClientHandle Handle of Shadow Client to use for registering handlers.
+ * @param[in] pcThingName Thing Name of the delta documents.
+ * @param[in] pxHandlers Array of handlers. It replaces the handlers registered
+ * before for the Thing.
+ * @param[in] ulHandlerCount Number of entries of @p pxHandlers, or 0 to remove
+ * the handlers of the Thing.
+ * @param[in] xTimeoutTicks Number of ticks this function may block before timeout.
+ *
+ * @return
+ * - #eShadowSuccess if the handlers were registered.
+ * - #eShadowFailure if there are more than #shadowconfigMAX_DELTA_HANDLERS
+ *   handlers, the paths need more than #shadowconfigDELTA_TRIE_NODES nodes, a
+ *   path is empty or given twice, the Shadow Client uses #eShadowPayloadCBOR,
+ *   or subscribing failed.
+ * - #eShadowTimeout if the Shadow Client timed out subscribing to /update/delta.
+ *
+ * @note
+ * - @p pcThingName, @p pxHandlers and the paths must remain valid while the
+ * handlers are registered, as the Shadow Client keeps pointers to them.
+ * - Handlers are only called for strings, numbers, booleans and null; a path
+ * that names an object or array is not matched.
+ * - Handlers may be registered with or without a #ShadowDeltaCallback_t; the
+ * Shadow Client stays subscribed to /update/delta while either is registered.
+ */
+ShadowReturnCode_t SHADOW_RegisterDeltaHandlers( ShadowClientHandle_t xShadowClientHandle,
+                                                 const char * const pcThingName,
+                                                 const ShadowDeltaHandlerParams_t * const pxHandlers,
+                                                 uint32_t ulHandlerCount,
+                                                 TickType_t xTimeoutTicks );
+
 /**
  * @brief Return an MQTT Buffer to the MQTT client.
  *
@@ -488,4 +599,102 @@ ShadowReturnCode_t SHADOW_RegisterCallbacks( ShadowClientHandle_t xShadowClientH
 ShadowReturnCode_t SHADOW_ReturnMQTTBuffer( ShadowClientHandle_t xShadowClientHandle,
                                             MQTTBufferHandle_t xBufferHandle );
 
+/**
+ * @brief Set a field of the reported state kept by the Shadow Client.
+ *
+ * The field is sent by the next #SHADOW_ReportedSync if its value differs from
+ * the one last accepted by the Shadow service.
+ *
+ * @param[in] xShadowClientHandle Handle of Shadow Client keeping the state.
+ * @param[in] pcKey Name of the field, up to #shadowconfigREPORTED_KEY_LENGTH
+ * characters. It is not escaped, so must not contain quotes or backslashes.
+ * @param[in] pcValue JSON value of the field, for example @c "21", @c "true"
+ * or @c ""on"", up to #shadowconfigREPORTED_VALUE_LENGTH characters.
+ *
+ * @return
+ * - #eShadowSuccess if the field was set.
+ * - #eShadowFailure if the key or value is too long, there is no room for
+ *   another field, or #shadowconfigREPORTED_FIELDS is 0.
+ *
+ * @note This function does not block on the network, so may be called from
+ * any task.
+ */
+ShadowReturnCode_t SHADOW_ReportedSet( ShadowClientHandle_t xShadowClientHandle,
+                                       const char * const pcKey,
+                                       const char * const pcValue );
+
+/**
+ * @brief Send the reported state fields that changed since the Shadow service
+ * last accepted them.
+ *
+ * If the first unsent change was made less than
+ * #shadowconfigREPORTED_COALESCE_MS ago, this function first waits out the
+ * remainder, so that changes made in quick succession go in one update. It
+ * then makes a #SHADOW_Update with only the changed fields in the "reported"
+ * section, and a client token of its own.
+ *
+ * @param[in] xShadowClientHandle Handle of Shadow Client keeping the state.
+ * @param[in] pcThingName Thing Name of the Shadow to update.
+ * @param[in] xTimeoutTicks Number of ticks this function may block before timeout.
+ *
+ * @return #ShadowReturnCode of the update, or #eShadowSuccess if no field
+ * changed. Fields that were not accepted are sent again by the next call.
+ *
+ * @note
+ * - The reported state is kept for one Thing per Shadow Client. With
+ * #shadowconfigREPORTED_FIELDS set to 0, this function returns #eShadowFailure.
+ * - Only one task at a time may call this function for a Shadow Client.
+ * - The acknowledged values assume that no other client changes these fields.
+ */
+ShadowReturnCode_t SHADOW_ReportedSync( ShadowClientHandle_t xShadowClientHandle,
+                                        const char * const pcThingName,
+                                        TickType_t xTimeoutTicks );
+
+/**
+ * @brief Convert a JSON Shadow document to CBOR.
+ *
+ * Objects and arrays become indefinite-length maps and arrays, integers of up
+ * to 18 digits become CBOR integers and other numbers doubles.
+ *
+ * @param[in] pcJSON The JSON document, an object or array.
+ * @param[in] ulJSONLength Length of @p pcJSON.
+ * @param[out] pucCBOR Buffer for the CBOR document.
+ * @param[in] ulCBORBufferSize Size of @p pucCBOR.
+ * @param[out] pulCBORLength Set to the length of the CBOR document.
+ *
+ * @return
+ * - #eShadowSuccess if the document was converted.
+ * - #eShadowFailure if the JSON is not valid, nests deeper than
+ *   #jsonpullconfigMAX_DEPTH, does not fit in @p pucCBOR, has a key whose path
+ *   is longer than #jsonpullconfigMAX_PATH_LENGTH or an escaped string longer
+ *   than #shadowconfigCBOR_STRING_LENGTH, or #shadowconfigENABLE_CBOR is 0.
+ */
+ShadowReturnCode_t SHADOW_JSONToCBOR( const char * const pcJSON,
+                                      uint32_t ulJSONLength,
+                                      uint8_t * const pucCBOR,
+                                      uint32_t ulCBORBufferSize,
+                                      uint32_t * const pulCBORLength );
+
+/**
+ * @brief Convert a CBOR Shadow document to JSON.
+ *
+ * @param[in] pucCBOR The CBOR document, a map.
+ * @param[in] ulCBORLength Length of @p pucCBOR.
+ * @param[out] pcJSON Buffer for the JSON document. It is not NUL-terminated.
+ * @param[in] ulJSONBufferSize Size of @p pcJSON.
+ * @param[out] pulJSONLength Set to the length of the JSON document.
+ *
+ * @return
+ * - #eShadowSuccess if the document was converted.
+ * - #eShadowFailure if the CBOR is not valid, has a map key that is not a text
+ *   string, a byte string, tag, half float or indefinite-length string, nests
+ *   deeper than #jsonpullconfigMAX_DEPTH, does not fit in @p pcJSON, or
+ *   #shadowconfigENABLE_CBOR is 0.
+ */
+ShadowReturnCode_t SHADOW_CBORToJSON( const uint8_t * const pucCBOR,
+                                      uint32_t ulCBORLength,
+                                      char * const pcJSON,
+                                      uint32_t ulJSONBufferSize,
+                                      uint32_t * const pulJSONLength );
+
 #endif /* _AWS_SHADOW_H_ */
@@ -0,0 +1,108 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_stack_monitor.h
+ * @brief Background sampling of task stack usage and stack size recommendations.
+ *
+ * Tasks are registered with the stack depth they were created with. A low
+ * priority task measures the high water mark of one registered task per
+ * sample period, so the cost of walking the stack fill pattern is spread over
+ * time instead of being paid for every task at once. The report gives the
+ * smallest amount of free stack seen for each task and a recommended stack
+ * depth, which is the used depth plus stackmonconfigMARGIN_PERCENT.
+ *
+ * Tasks created by libraries, such as the MQTT agent, OTA agent or IP task,
+ * can be registered by looking their handle up with xTaskGetHandle().
+ */
+
+#ifndef _AWS_STACK_MONITOR_H_
+#define _AWS_STACK_MONITOR_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_stack_monitor.h"
+#endif
+
+#include "task.h"
+
+/**
+ * @brief The stack usage of one registered task.
+ *
+ * All depths are in words, as passed to xTaskCreate().
+ */
+typedef struct StackMonitorEntry
+{
+    TaskHandle_t xTask;          /**< The task. */
+    uint32_t ulStackDepth;       /**< The stack depth the task was created with. */
+    uint32_t ulMinimumFree;      /**< The smallest amount of free stack seen so far. */
+    uint32_t ulRecommendedDepth; /**< The recommended stack depth, or 0 if the task has not been sampled yet. */
+} StackMonitorEntry_t;
+
+/**
+ * @brief Starts the task that samples the stacks of registered tasks.
+ *
+ * @return pdPASS if the task was created, pdFAIL otherwise.
+ */
+BaseType_t STACKMON_Init( void );
+
+/**
+ * @brief Adds a task to the set of tasks whose stacks are sampled.
+ *
+ * @param[in] xTask The task to monitor.
+ * @param[in] ulStackDepth The stack depth, in words, the task was created with.
+ *
+ * @return pdPASS if the task was registered, pdFAIL if all
+ * stackmonconfigMAX_TASKS entries are in use.
+ */
+BaseType_t STACKMON_Register( TaskHandle_t xTask,
+                              uint32_t ulStackDepth );
+
+/**
+ * @brief Stops monitoring a task.
+ *
+ * Must be called before a registered task is deleted. Once this returns, the
+ * sampling task no longer accesses the task.
+ *
+ * @param[in] xTask The task to stop monitoring.
+ */
+void STACKMON_Unregister( TaskHandle_t xTask );
+
+/**
+ * @brief Copies the stack usage of the registered tasks.
+ *
+ * @param[out] pxEntries The array to fill in.
+ * @param[in] uxMaxEntries The number of entries in pxEntries.
+ *
+ * @return The number of entries that were filled in.
+ */
+UBaseType_t STACKMON_GetReport( StackMonitorEntry_t * pxEntries,
+                                UBaseType_t uxMaxEntries );
+
+/**
+ * @brief Prints the stack usage of the registered tasks with configPRINTF().
+ */
+void STACKMON_PrintReport( void );
+
+#endif /* _AWS_STACK_MONITOR_H_ */
@@ -30,6 +30,72 @@
     #error "include FreeRTOS.h must appear in source files before include aws_system_init.h"
 #endif
 
+#include "event_groups.h"
+
+/**
+ * @brief The maximum number of modules SYSTEM_InitModules() can start.
+ *
+ * Module n of the table is identified by event bit ( 1 << n ), and the top
+ * eight bits of an event group are reserved by the kernel.
+ */
+#if ( configUSE_16_BIT_TICKS == 1 )
+    #define systeminitMAX_MODULES    ( 8U )
+#else
+    #define systeminitMAX_MODULES    ( 24U )
+#endif
+
+/**
+ * @brief The event bit that identifies module n of the table.
+ */
+#define systeminitMODULE_BIT( n )    ( ( EventBits_t ) 1 << ( n ) )
+
+/**
+ * @brief A module started by SYSTEM_InitModules().
+ */
+typedef struct SystemInitModule
+{
+    const char * pcName;            /**< Name of the task that initializes the module. */
+    BaseType_t ( * xInit )( void ); /**< Initializes the module, returning pdPASS on success. */
+    EventBits_t xPrerequisites;     /**< Bits of the modules that must be initialized first. They must all precede this module in the table. */
+    uint16_t usStackDepth;          /**< Stack depth, in words, of the task that initializes the module. */
+    UBaseType_t uxPriority;         /**< Priority of the task that initializes the module. */
+} SystemInitModule_t;
+
+/**
+ * @brief Initializes the Amazon FreeRTOS libraries that all applications need.
+ */
 BaseType_t SYSTEM_Init( void );
 
+/**
+ * @brief Starts the initialization of a table of modules in the background.
+ *
+ * Each module is initialized by its own task, which first waits for the
+ * module's prerequisites. Modules that do not depend on each other, such as a
+ * Wi-Fi connection and the loading of credentials, therefore make progress at
+ * the same time, and the caller can go on to do work that needs neither. A
+ * module whose prerequisite failed is not initialized and is reported as failed
+ * itself.
+ *
+ * May be called once. The table must remain valid until every module is done.
+ *
+ * @param[in] pxModules The modules to initialize.
+ * @param[in] uxModuleCount The number of modules, at most systeminitMAX_MODULES.
+ *
+ * @return pdPASS if the tasks were started, pdFAIL otherwise.
+ */
+BaseType_t SYSTEM_InitModules( const SystemInitModule_t * pxModules,
+                               UBaseType_t uxModuleCount );
+
+/**
+ * @brief Waits for modules started by SYSTEM_InitModules().
+ *
+ * @param[in] xModules The bits of the modules to wait for.
+ * @param[in] xTicksToWait The maximum time to wait.
+ *
+ * @return pdPASS if all of the modules were initialized successfully, pdFAIL if
+ * any of them failed or is still being initialized after xTicksToWait.
+ */
+BaseType_t SYSTEM_WaitForModules( EventBits_t xModules,
+                                  TickType_t xTicksToWait );
+
 #endif /* _AWS_SYSTEM_INIT_H_ */
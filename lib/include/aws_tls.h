@@ -79,6 +79,10 @@ typedef BaseType_t ( * NetworkSend_t )( void * pvCallerContext,
  * @param[in] pcServerCertificate PEM encoded server certificate to trust.
  * @param[in] ulServerCertificateLength Length in bytes of the encoded server
  * certificate. The length must include the null terminator.
+ * @param[in] xDatagram pdTRUE to negotiate DTLS over a datagram transport. Each
+ * call of pxNetworkSend() then carries one datagram, and pxNetworkRecv()
+ * returns one datagram, or 0 when none arrived within its receive timeout,
+ * after which the handshake retransmits its last flight.
  * @param[in] pxNetworkRecv Caller-defined network receive function pointer.
  * @param[in] pxNetworkSend Caller-defined network send function pointer.
  * @param[in] pvCallerContext Caller-defined context handle to be used with callback
@@ -92,12 +96,42 @@ typedef struct xTLS_PARAMS
     uint32_t ulServerCertificateLength;
     const char ** ppcAlpnProtocols;
     uint32_t ulAlpnProtocolsCount;
+    BaseType_t xDatagram;
 
     NetworkRecv_t pxNetworkRecv;
     NetworkSend_t pxNetworkSend;
     void * pvCallerContext;
 } TLSParams_t;
 
+/**
+ * @brief One of the buffers passed to TLS_SendV().
+ */
+typedef struct TLSIOVector
+{
+    const unsigned char * pucMsg; /**< Data to be sent. */
+    size_t xMsgLength;            /**< Length in bytes of the data. */
+} TLSIOVector_t;
+
+/**
+ * @brief Time spent in each phase of the last TLS_Connect().
+ *
+ * Times are in units of tlsconfigTIMESTAMP(), ticks by default. The phases
+ * receiving a flight of the server include waiting for it, so ulServerHello
+ * is about one round trip plus the time the server takes. DNS lookup and the
+ * TCP connection happen before TLS_Connect() and are not included.
+ */
+typedef struct TLSConnectTimings
+{
+    uint32_t ulTotal;             /**< The whole of TLS_Connect(). */
+    uint32_t ulSetup;             /**< Parsing certificates and loading the credentials. */
+    uint32_t ulServerHello;       /**< Sending the ClientHello until the ServerHello is read. */
+    uint32_t ulServerCertificate; /**< Reading and verifying the server certificate chain. */
+    uint32_t ulKeyExchange;       /**< The key exchange, including ECDHE and its signature check. */
+    uint32_t ulCertificateVerify; /**< Signing the handshake with the device key. */
+    uint32_t ulPrivateKeySign;    /**< Of which inside the PKCS#11 module. */
+    uint32_t ulFinished;          /**< The change cipher spec and finished messages. */
+} TLSConnectTimings_t;
+
 /**
  * @brief Initializes the TLS context.
  *
@@ -126,12 +160,55 @@ BaseType_t TLS_Connect( void * pvContext );
  * network.
  * @param xReadLength Length in bytes of read buffer.
  *
+ * Over DTLS, at most one record is returned per call.
+ *
  * @return Number of bytes read. Error return codes have the high bit set.
  */
 BaseType_t TLS_Recv( void * pvContext,
                      unsigned char * pucReadBuffer,
                      size_t xReadLength );
 
+/**
+ * @brief Reads decrypted data from the secure connection without copying it.
+ *
+ * A pointer to the plaintext of the current TLS record, in the input buffer
+ * of the TLS library, is returned. The data stays there until it is released
+ * with TLS_ReleaseZeroCopy(), which must be called before the next call to
+ * TLS_RecvZeroCopy() or TLS_Recv() on the same context.
+ *
+ * @param pvContext Opaque context handle for TLS library.
+ * @param ppucData Set to point to the decrypted data.
+ * @param xMaxLength The maximum number of bytes to return.
+ *
+ * @return Number of contiguous bytes available at *ppucData, which may be
+ * fewer than the connection has received. 0 if none are available. Error
+ * return codes have the high bit set.
+ */
+BaseType_t TLS_RecvZeroCopy( void * pvContext,
+                             unsigned char ** ppucData,
+                             size_t xMaxLength );
+
+/**
+ * @brief Releases data obtained from TLS_RecvZeroCopy().
+ *
+ * @param pvContext Opaque context handle for TLS library.
+ * @param xLength The number of bytes consumed. Must not be larger than the
+ * value returned by the preceding call to TLS_RecvZeroCopy().
+ */
+void TLS_ReleaseZeroCopy( void * pvContext,
+                          size_t xLength );
+
+/**
+ * @brief Gets the number of decrypted bytes that can be read without
+ * receiving more data from the network.
+ *
+ * @param pvContext Opaque context handle for TLS library.
+ *
+ * @return Number of bytes left over in the record buffer of the TLS library,
+ * 0 if there are none or the context is not connected.
+ */
+size_t TLS_GetBytesAvailable( void * pvContext );
+
 /**
  * @brief Writes the requested number of bytes to the secure connection.
  *
@@ -145,6 +222,49 @@ BaseType_t TLS_Send( void * pvContext,
                      const unsigned char * pucMsg,
                      size_t xMsgLength );
 
+/**
+ * @brief Writes the data of several buffers to the secure connection.
+ *
+ * The buffers are gathered into a single TLS record, or as few records as the
+ * maximum record length allows, rather than producing one record per buffer.
+ *
+ * @param pvContext Opaque context handle for TLS library.
+ * @param pxIOVectors Buffers of data to be encrypted and then sent to the
+ * network, in order.
+ * @param xIOVectorCount Number of buffers in pxIOVectors.
+ *
+ * @return Number of bytes sent. Error return codes have the high bit set.
+ */
+BaseType_t TLS_SendV( void * pvContext,
+                      const TLSIOVector_t * pxIOVectors,
+                      size_t xIOVectorCount );
+
+/**
+ * @brief Gets the phase times of the last TLS_Connect(), successful or not.
+ *
+ * Requires tlsconfigENABLE_CONNECT_TIMING; otherwise all phases read 0.
+ *
+ * @param pvContext Opaque context handle for TLS library.
+ * @param pxTimings Receives the phase times.
+ *
+ * @return Zero on success. Error return codes have the high bit set.
+ */
+BaseType_t TLS_GetConnectTimings( void * pvContext,
+                                  TLSConnectTimings_t * pxTimings );
+
+/**
+ * @brief Gets the name of the cipher suite negotiated by TLS_Connect().
+ *
+ * See tlsconfigHARDWARE_AES and tlsconfigCIPHERSUITES for the suites offered.
+ *
+ * @param pvContext Opaque context handle for TLS library.
+ *
+ * @return The mbedTLS name of the suite, such as
+ * "TLS-ECDHE-ECDSA-WITH-AES-128-GCM-SHA256", or NULL before a successful
+ * handshake.
+ */
+const char * TLS_GetCiphersuite( void * pvContext );
+
 /**
  * @brief Frees resources consumed by the TLS context.
  *
@@ -0,0 +1,158 @@
+/*
+ * Amazon FreeRTOS Trace Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_trace_ring.h
+ * @brief A low overhead binary event trace kept in RAM.
+ *
+ * Each core writes compact records - a timestamp, an event identifier and two
+ * arguments - to its own ring. A writer claims a record with one atomic add
+ * where the compiler provides lock-free atomics, and with the interrupt mask
+ * otherwise, so records can be written from interrupts and from inside the
+ * kernel. The oldest records are overwritten when nobody reads the ring, so
+ * the ring also works as a flight recorder that can be read after a fault.
+ *
+ * Records come from the kernel, FreeRTOS+TCP, MQTT agent and OTA agent trace
+ * macros once aws_trace_ring_hooks.h is included at the end of
+ * FreeRTOSConfig.h, and from the application through TRACE_RING_Record().
+ *
+ * The rings are read with TRACE_RING_Read(), or sent as chunks by the task
+ * started by TRACE_RING_StartStreaming(). A chunk is a TraceRingChunkHeader_t
+ * followed by the records, so the send function can write it to a UART or a
+ * debug port as it is. tools/trace_ring/trace_ring_decode.py converts a
+ * stream of chunks to the JSON trace format of chrome://tracing and Perfetto.
+ */
+
+#ifndef _AWS_TRACE_RING_H_
+#define _AWS_TRACE_RING_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_trace_ring.h"
+#endif
+
+#include "aws_trace_ring_events.h"
+#include "aws_trace_ring_config_defaults.h"
+
+/**
+ * @brief The magic number that starts every chunk, "TRRG" in memory order.
+ */
+#define traceringCHUNK_MAGIC      ( 0x47525254UL )
+
+/**
+ * @brief The version of the chunk format.
+ */
+#define traceringCHUNK_VERSION    ( ( uint16_t ) 1 )
+
+/**
+ * @brief One record of the trace.
+ */
+typedef struct TraceRingRecord
+{
+    uint32_t ulTimestamp;  /**< traceringconfigTIMESTAMP() when the record was written. */
+    uint16_t usEventId;    /**< One of traceringEVENT_* or an application event. */
+    uint16_t usSequence;   /**< The position of the record in its ring plus one, modulo 2^16. */
+    uint32_t ulArg1;       /**< First argument of the event. */
+    uint32_t ulArg2;       /**< Second argument of the event. */
+} TraceRingRecord_t;
+
+/**
+ * @brief The header sent before the records of one chunk.
+ *
+ * All the fields are in the byte order of the device.
+ */
+typedef struct TraceRingChunkHeader
+{
+    uint32_t ulMagic;       /**< traceringCHUNK_MAGIC. */
+    uint16_t usVersion;     /**< traceringCHUNK_VERSION. */
+    uint8_t ucCore;         /**< The core whose ring the records come from. */
+    uint8_t ucRecordSize;   /**< sizeof( TraceRingRecord_t ). */
+    uint32_t ulTimestampHz; /**< traceringconfigTIMESTAMP_HZ. */
+    uint16_t usRecords;     /**< The number of records that follow. */
+    uint16_t usLost;        /**< The number of records overwritten before they could be sent, saturated. */
+} TraceRingChunkHeader_t;
+
+/**
+ * @brief Sends one chunk for the streaming task.
+ *
+ * @param[in] pvContext The context passed to TRACE_RING_StartStreaming().
+ * @param[in] pvData The chunk, a TraceRingChunkHeader_t and its records.
+ * @param[in] xLength The length of the chunk in bytes.
+ *
+ * @return pdPASS if the chunk was sent, pdFAIL otherwise. Chunks that could
+ * not be sent are counted in the usLost field of the next chunk.
+ */
+typedef BaseType_t ( * TraceRingSendFunction_t )( void * pvContext,
+                                                  const void * pvData,
+                                                  size_t xLength );
+
+/**
+ * @brief Copies the oldest unread records of one core's ring.
+ *
+ * There must only be one reader of a ring, which is the streaming task once it
+ * was started.
+ *
+ * @param[in] uxCore The core whose ring is read.
+ * @param[out] pxRecords The array to copy the records to.
+ * @param[in] uxMaxRecords The number of records that fit in pxRecords.
+ * @param[out] pulLost Set to the number of records that were overwritten
+ * before they could be read.
+ *
+ * @return The number of records copied.
+ */
+UBaseType_t TRACE_RING_Read( UBaseType_t uxCore,
+                             TraceRingRecord_t * pxRecords,
+                             UBaseType_t uxMaxRecords,
+                             uint32_t * pulLost );
+
+/**
+ * @brief Starts the task that sends the contents of the rings as chunks.
+ *
+ * @param[in] xSend The function that sends a chunk, for example to a UART or
+ * to the ITM stimulus port of the debug probe.
+ * @param[in] pvContext Passed to xSend.
+ *
+ * @return pdPASS if the task was created, pdFAIL otherwise.
+ */
+BaseType_t TRACE_RING_StartStreaming( TraceRingSendFunction_t xSend,
+                                      void * pvContext );
+
+#if ( traceringconfigMQTT_STREAMING == 1 )
+    #include "aws_mqtt_agent.h"
+
+/**
+ * @brief Starts the streaming task with a send function that publishes every
+ * chunk with QoS0.
+ *
+ * @param[in] xMQTTHandle A connected MQTT agent.
+ * @param[in] pcTopic The topic to publish to. Must stay valid while the
+ * trace is streamed.
+ *
+ * @return pdPASS if the task was created, pdFAIL otherwise.
+ */
+    BaseType_t TRACE_RING_StartMQTTStreaming( MQTTAgentHandle_t xMQTTHandle,
+                                              const char * pcTopic );
+#endif
+
+#endif /* _AWS_TRACE_RING_H_ */
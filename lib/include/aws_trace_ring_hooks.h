@@ -0,0 +1,155 @@
+/*
+ * Amazon FreeRTOS Trace Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_trace_ring_hooks.h
+ * @brief Maps the kernel, FreeRTOS+TCP, MQTT agent and OTA agent trace macros
+ * to the trace ring.
+ *
+ * Include this file at the end of FreeRTOSConfig.h to trace an application:
+ * @code
+ * #include "aws_trace_ring_hooks.h"
+ * @endcode
+ *
+ * The kernel macros are expanded inside tasks.c and queue.c, so they can use
+ * the kernel's private names. A macro defined in FreeRTOSConfig.h before this
+ * file is included is left as it is.
+ */
+
+#ifndef _AWS_TRACE_RING_HOOKS_H_
+#define _AWS_TRACE_RING_HOOKS_H_
+
+#include "aws_trace_ring_events.h"
+
+/**
+ * @brief Converts a handle to the identifier used in records.
+ */
+#define traceringOBJECT( pvObject )    ( ( uint32_t ) ( ( size_t ) ( pvObject ) ) )
+
+/**
+ * @brief Set to 1 to also record every tick interrupt.
+ *
+ * Ticks are frequent and rarely interesting, so they are left out by default
+ * to make the ring last longer.
+ */
+#ifndef traceringconfigTRACE_TICKS
+    #define traceringconfigTRACE_TICKS    ( 0 )
+#endif
+
+/* Kernel. */
+#ifndef traceTASK_SWITCHED_IN
+    #define traceTASK_SWITCHED_IN() \
+    TRACE_RING_Record( traceringEVENT_TASK_SWITCHED_IN, traceringOBJECT( pxCurrentTCB ), ( uint32_t ) pxCurrentTCB->uxPriority )
+#endif
+
+#ifndef traceTASK_SWITCHED_OUT
+    #define traceTASK_SWITCHED_OUT() \
+    TRACE_RING_Record( traceringEVENT_TASK_SWITCHED_OUT, traceringOBJECT( pxCurrentTCB ), 0 )
+#endif
+
+#ifndef traceTASK_CREATE
+    #define traceTASK_CREATE( pxNewTCB )                                                                                       \
+    do {                                                                                                                       \
+        TRACE_RING_Record( traceringEVENT_TASK_CREATE, traceringOBJECT( pxNewTCB ), ( uint32_t ) ( pxNewTCB )->uxPriority ); \
+        TRACE_RING_RecordName( traceringOBJECT( pxNewTCB ), ( pxNewTCB )->pcTaskName );                                      \
+    } while( 0 )
+#endif
+
+#ifndef traceTASK_DELETE
+    #define traceTASK_DELETE( pxTaskToDelete ) \
+    TRACE_RING_Record( traceringEVENT_TASK_DELETE, traceringOBJECT( pxTaskToDelete ), 0 )
+#endif
+
+#ifndef traceTASK_DELAY
+    #define traceTASK_DELAY() \
+    TRACE_RING_Record( traceringEVENT_TASK_DELAY, ( uint32_t ) xTicksToDelay, 0 )
+#endif
+
+#ifndef traceTASK_NOTIFY_TAKE_BLOCK
+    #define traceTASK_NOTIFY_TAKE_BLOCK() \
+    TRACE_RING_Record( traceringEVENT_TASK_NOTIFY_WAIT, 0, 0 )
+#endif
+
+#ifndef traceTASK_NOTIFY_WAIT_BLOCK
+    #define traceTASK_NOTIFY_WAIT_BLOCK() \
+    TRACE_RING_Record( traceringEVENT_TASK_NOTIFY_WAIT, 0, 0 )
+#endif
+
+#ifndef traceBLOCKING_ON_QUEUE_RECEIVE
+    #define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) \
+    TRACE_RING_Record( traceringEVENT_QUEUE_RECEIVE_BLOCK, traceringOBJECT( pxQueue ), 0 )
+#endif
+
+#ifndef traceBLOCKING_ON_QUEUE_SEND
+    #define traceBLOCKING_ON_QUEUE_SEND( pxQueue ) \
+    TRACE_RING_Record( traceringEVENT_QUEUE_SEND_BLOCK, traceringOBJECT( pxQueue ), 0 )
+#endif
+
+#if ( traceringconfigTRACE_TICKS == 1 )
+    #ifndef traceTASK_INCREMENT_TICK
+        #define traceTASK_INCREMENT_TICK( xTickCount ) \
+    TRACE_RING_Record( traceringEVENT_TICK, ( uint32_t ) ( xTickCount ), 0 )
+    #endif
+#endif
+
+/* FreeRTOS+TCP. */
+#ifndef iptraceNETWORK_EVENT_RECEIVED
+    #define iptraceNETWORK_EVENT_RECEIVED( eEvent ) \
+    TRACE_RING_Record( traceringEVENT_IP_EVENT_BEGIN, ( uint32_t ) ( eEvent ), 0 )
+#endif
+
+#ifndef iptraceNETWORK_EVENT_PROCESSED
+    #define iptraceNETWORK_EVENT_PROCESSED( eEvent ) \
+    TRACE_RING_Record( traceringEVENT_IP_EVENT_END, ( uint32_t ) ( eEvent ), 0 )
+#endif
+
+/* MQTT agent. */
+#ifndef mqttconfigTRACE_COMMAND_RECEIVED
+    #define mqttconfigTRACE_COMMAND_RECEIVED( xEventType, uxBrokerNumber ) \
+    TRACE_RING_Record( traceringEVENT_MQTT_COMMAND_BEGIN, ( uint32_t ) ( xEventType ), ( uint32_t ) ( uxBrokerNumber ) )
+#endif
+
+#ifndef mqttconfigTRACE_COMMAND_PROCESSED
+    #define mqttconfigTRACE_COMMAND_PROCESSED( xEventType, uxBrokerNumber ) \
+    TRACE_RING_Record( traceringEVENT_MQTT_COMMAND_END, ( uint32_t ) ( xEventType ), ( uint32_t ) ( uxBrokerNumber ) )
+#endif
+
+/* OTA agent. */
+#ifndef otaconfigTRACE_EVENTS
+    #define otaconfigTRACE_EVENTS( xBits ) \
+    TRACE_RING_Record( traceringEVENT_OTA_EVENTS, ( uint32_t ) ( xBits ), 0 )
+#endif
+
+#ifndef otaconfigTRACE_MESSAGE_RECEIVED
+    #define otaconfigTRACE_MESSAGE_RECEIVED( eMsgType, ulDataLength ) \
+    TRACE_RING_Record( traceringEVENT_OTA_MESSAGE_BEGIN, ( uint32_t ) ( eMsgType ), ( uint32_t ) ( ulDataLength ) )
+#endif
+
+#ifndef otaconfigTRACE_MESSAGE_PROCESSED
+    #define otaconfigTRACE_MESSAGE_PROCESSED( eMsgType ) \
+    TRACE_RING_Record( traceringEVENT_OTA_MESSAGE_END, ( uint32_t ) ( eMsgType ), 0 )
+#endif
+
+#endif /* _AWS_TRACE_RING_HOOKS_H_ */
@@ -0,0 +1,124 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_wifi_reconnect.h
+ * @brief Fast reconnection to the last Access Point, built on the WIFI_ API.
+ *
+ * WIFI_ReconnectAP() is a drop-in replacement for WIFI_ConnectAP(). It
+ * remembers the SSID, BSSID, channel and signal strength of the last network
+ * it joined, and passes the cached channel to WIFI_ConnectAP() so that ports
+ * which honour WIFINetworkParams_t::cChannel only probe that channel. When the
+ * cached channel does not work, the strongest Access Point of the network is
+ * found with WIFI_Scan() and the cache is refreshed. The layer only uses the
+ * portable API, so it works with every port; keys such as the PMK stay in the
+ * vendor driver, which may cache them on its own.
+ *
+ * The cache can be saved with WIFI_ReconnectGetCache() and restored after a
+ * reset with WIFI_ReconnectSetCache(), so that the first connection after a
+ * reboot is fast as well.
+ */
+
+#ifndef _AWS_WIFI_RECONNECT_H_
+#define _AWS_WIFI_RECONNECT_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_wifi_reconnect.h"
+#endif
+
+#include "aws_wifi.h"
+
+/**
+ * @brief The Access Point used by the last successful connection.
+ */
+typedef struct WIFIReconnectCache
+{
+    char cSSID[ wificonfigMAX_SSID_LEN + 1 ];   /**< SSID of the network, with a NULL termination. */
+    uint8_t ucBSSID[ wificonfigMAX_BSSID_LEN ]; /**< BSSID of the Access Point, all zero if it is not known. */
+    int8_t cChannel;                            /**< Channel of the Access Point. */
+    int8_t cRSSI;                               /**< Signal strength when the Access Point was scanned, 0 if it is not known. */
+    uint8_t ucValid;                            /**< Non-zero if the cache holds an Access Point. */
+} WIFIReconnectCache_t;
+
+/**
+ * @brief Connection metrics, as returned by WIFI_ReconnectGetStatistics().
+ *
+ * All the counters wrap around on overflow.
+ */
+typedef struct WIFIReconnectStatistics
+{
+    uint32_t ulConnects;             /**< Calls to WIFI_ReconnectAP() that succeeded. */
+    uint32_t ulFailures;             /**< Calls to WIFI_ReconnectAP() that failed. */
+    uint32_t ulCacheHits;            /**< Connections made on the cached channel. */
+    uint32_t ulCacheMisses;          /**< Connection attempts on the cached channel that failed. */
+    uint32_t ulScans;                /**< Scans made to find the Access Point. */
+    TickType_t xLastConnectTicks;    /**< Duration of the last successful WIFI_ReconnectAP(). */
+    TickType_t xLongestConnectTicks; /**< Duration of the slowest successful WIFI_ReconnectAP(). */
+} WIFIReconnectStatistics_t;
+
+/**
+ * @brief Connects to an Access Point, trying the cached one first.
+ *
+ * The cache is used when it holds the SSID of pxNetworkParams and the
+ * cChannel member of pxNetworkParams is 0. A channel chosen by the caller is
+ * always respected.
+ *
+ * WIFI_ReconnectAP() must not be called from more than one task at a time.
+ *
+ * @param[in] pxNetworkParams The network to join, @see WIFI_ConnectAP().
+ *
+ * @return eWiFiSuccess if connected, failure code otherwise.
+ */
+WIFIReturnCode_t WIFI_ReconnectAP( const WIFINetworkParams_t * const pxNetworkParams );
+
+/**
+ * @brief Copies the cached Access Point, for instance to store it in flash.
+ *
+ * @param[out] pxCache The cache is copied here.
+ */
+void WIFI_ReconnectGetCache( WIFIReconnectCache_t * const pxCache );
+
+/**
+ * @brief Replaces the cached Access Point, for instance with one saved before
+ * a reset.
+ *
+ * @param[in] pxCache The new cache.
+ */
+void WIFI_ReconnectSetCache( const WIFIReconnectCache_t * const pxCache );
+
+/**
+ * @brief Forgets the cached Access Point, so that the next WIFI_ReconnectAP()
+ * scans for it.
+ */
+void WIFI_ReconnectClearCache( void );
+
+/**
+ * @brief Copies the connection metrics.
+ *
+ * @param[out] pxStatistics The metrics are copied here.
+ */
+void WIFI_ReconnectGetStatistics( WIFIReconnectStatistics_t * const pxStatistics );
+
+#endif /* _AWS_WIFI_RECONNECT_H_ */
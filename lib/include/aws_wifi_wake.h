@@ -0,0 +1,95 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_wifi_wake.h
+ * @brief Alignment of deferrable network activity with the radio's wake
+ * windows.
+ *
+ * In power save mode the radio wakes up once per listen interval, which is
+ * usually the DTIM period. Traffic sent at any other time wakes it up once
+ * more. Periodic activity that can be postponed a little, such as MQTT
+ * keep-alives, DHCP renewals and Device Defender reports, can be moved to the
+ * next wake window with WIFI_WakeWindowAlign(), so that it shares one wake-up
+ * with the other deferrable traffic instead of causing its own.
+ *
+ * The libraries call the alignment through their own configuration macros,
+ * which default to no alignment:
+ * @code
+ * // FreeRTOSIPConfig.h
+ * #define ipconfigALIGN_DEFERRABLE_DELAY( xTicks )        WIFI_WakeWindowAlign( xTicks )
+ * // aws_mqtt_agent_config.h
+ * #define mqttconfigALIGN_DEFERRABLE_DELAY( xTicks )      WIFI_WakeWindowAlign( xTicks )
+ * // FreeRTOSConfig.h, for the Device Defender agent
+ * #define defenderconfigALIGN_DEFERRABLE_DELAY( xTicks )  WIFI_WakeWindowAlign( xTicks )
+ * @endcode
+ */
+
+#ifndef _AWS_WIFI_WAKE_H_
+#define _AWS_WIFI_WAKE_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_wifi_wake.h"
+#endif
+
+/**
+ * @brief Converts a beacon interval, in time units of 1024 microseconds, and a
+ * DTIM period, in beacons, into a wake window period in ticks.
+ */
+#define wifiWAKE_PERIOD_FROM_DTIM( ulBeaconIntervalTU, ulDTIMPeriod ) \
+    pdMS_TO_TICKS( ( ( uint32_t ) ( ulBeaconIntervalTU ) * ( uint32_t ) ( ulDTIMPeriod ) * 1024UL ) / 1000UL )
+
+/**
+ * @brief Sets the period of the radio's wake windows.
+ *
+ * The current tick count is taken as the start of a window. Call it again, or
+ * call WIFI_WakeWindowSync(), after a power mode change.
+ *
+ * @param[in] xPeriod The time between two wake windows, or 0 to stop aligning
+ * delays.
+ */
+void WIFI_WakeWindowSet( TickType_t xPeriod );
+
+/**
+ * @brief Takes the current tick count as the start of a wake window.
+ *
+ * Ports or applications that are told when the radio wakes up, for instance on
+ * a beacon, can call it to keep the windows in phase with the radio.
+ */
+void WIFI_WakeWindowSync( void );
+
+/**
+ * @brief Postpones a deferrable delay to the start of the next wake window.
+ *
+ * The delay is extended by less than one period. Delays of 0 and portMAX_DELAY
+ * are returned unchanged, as are all delays while no period is set.
+ *
+ * @param[in] xDelay The delay, in ticks, after which the activity is due.
+ *
+ * @return The delay to use instead.
+ */
+TickType_t WIFI_WakeWindowAlign( TickType_t xDelay );
+
+#endif /* _AWS_WIFI_WAKE_H_ */
@@ -500,6 +500,14 @@ EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup, const EventBits_
  * context of the timer task - where a scheduler lock is used in place of a
  * critical section.
  *
+ * If configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT is set to 1 (which requires
+ * configEVENT_GROUP_INDEXED_BITS to be greater than 0) the bits are instead set
+ * directly from the interrupt when the only tasks that can be unblocked are
+ * tasks waiting for nothing but one of the indexed bits being set.  Those tasks
+ * are held on a list per bit, so no searching is needed.  The timer task is
+ * still used if a task is accessing the event group when the interrupt occurs,
+ * or if any other waiting task might be unblocked.
+ *
  * @param xEventGroup The event group in which the bits are to be set.
  *
  * @param uxBitsToSet A bitwise value that indicates the bit or bits to set.
@@ -516,9 +524,9 @@ EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup, const EventBits_
  * *pxHigherPriorityTaskWoken must be initialised to pdFALSE.  See the
  * example code below.
  *
- * @return If the request to execute the function was posted successfully then
- * pdPASS is returned, otherwise pdFALSE is returned.  pdFALSE will be returned
- * if the timer service queue was full.
+ * @return If the request to execute the function was posted successfully, or
+ * the bits were set directly, then pdPASS is returned, otherwise pdFALSE is
+ * returned.  pdFALSE will be returned if the timer service queue was full.
  *
  * Example usage:
    <pre>
@@ -556,7 +564,7 @@ EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup, const EventBits_
  * \defgroup xEventGroupSetBitsFromISR xEventGroupSetBitsFromISR
  * \ingroup EventGroup
  */
-#if( configUSE_TRACE_FACILITY == 1 )
+#if( ( configUSE_TRACE_FACILITY == 1 ) || ( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 ) )
 	BaseType_t xEventGroupSetBitsFromISR( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 #else
 	#define xEventGroupSetBitsFromISR( xEventGroup, uxBitsToSet, pxHigherPriorityTaskWoken ) xTimerPendFunctionCallFromISR( vEventGroupSetBitsCallback, ( void * ) xEventGroup, ( uint32_t ) uxBitsToSet, pxHigherPriorityTaskWoken )
@@ -738,6 +746,39 @@ EventBits_t xEventGroupGetBitsFromISR( EventGroupHandle_t xEventGroup ) PRIVILEG
  */
 void vEventGroupDelete( EventGroupHandle_t xEventGroup ) PRIVILEGED_FUNCTION;
 
+/**
+ * event_groups.h
+ *<pre>
+	void vEventGroupSetReadyNotification( EventGroupHandle_t xEventGroup, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet, const EventBits_t uxBitsToWatch );
+ </pre>
+ *
+ * Only available when configUSE_OBJECT_READY_NOTIFICATIONS is set to 1.
+ *
+ * Register a task to be told when any of uxBitsToWatch is set in the event
+ * group.  ulBitsToSet is then ORed into the notification value of
+ * xTaskToNotify as if by xTaskNotify( xTaskToNotify, ulBitsToSet, eSetBits ),
+ * which lets the task wait on the event group together with queues, semaphores
+ * and stream buffers - see vQueueSetReadyNotification().  If any of
+ * uxBitsToWatch is already set the task is notified at once.
+ *
+ * Only one task can be registered at a time.  Passing NULL as xTaskToNotify
+ * removes the registration.
+ *
+ * @param xEventGroup The event group to watch.
+ *
+ * @param xTaskToNotify The task to notify, or NULL.
+ *
+ * @param ulBitsToSet The bits to set in the notification value of the task.
+ *
+ * @param uxBitsToWatch The event bits that cause the task to be notified.
+ *
+ * \defgroup vEventGroupSetReadyNotification vEventGroupSetReadyNotification
+ * \ingroup EventGroup
+ */
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	void vEventGroupSetReadyNotification( EventGroupHandle_t xEventGroup, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet, const EventBits_t uxBitsToWatch ) PRIVILEGED_FUNCTION;
+#endif
+
 /* For internal use only. */
 void vEventGroupSetBitsCallback( void *pvEventGroup, const uint32_t ulBitsToSet ) PRIVILEGED_FUNCTION;
 void vEventGroupClearBitsCallback( void *pvEventGroup, const uint32_t ulBitsToClear ) PRIVILEGED_FUNCTION;
@@ -0,0 +1,79 @@
+/*
+ * Amazon FreeRTOS Async Executor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_async_config_defaults.h
+ * @brief Default values for the async executor configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_ASYNC_CONFIG_DEFAULTS_H_
+#define _AWS_ASYNC_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief Set to 1 to let async tasks wait on sockets with SOCKETS_Poll().
+ *
+ * Requires a Secure Sockets port that provides SOCKETS_Poll().
+ */
+#ifndef asyncconfigUSE_SOCKETS
+    #define asyncconfigUSE_SOCKETS    ( 1 )
+#endif
+
+/**
+ * @brief The maximum number of async tasks of one executor that can wait on
+ * sockets at the same time.
+ *
+ * The executor passes this many sockets at most to SOCKETS_Poll(), from its
+ * own stack.
+ */
+#ifndef asyncconfigMAX_SOCKETS
+    #define asyncconfigMAX_SOCKETS    ( 8 )
+#endif
+
+/**
+ * @brief The longest time, in milliseconds, that a queue item or a signal
+ * sent while the executor waits on sockets goes unnoticed.
+ *
+ * Queues cannot wake SOCKETS_Poll(), so while a task waits on a queue, or
+ * on a signal alongside a socket wait, the executor wakes at least this
+ * often to check.
+ */
+#ifndef asyncconfigPOLL_PERIOD_MS
+    #define asyncconfigPOLL_PERIOD_MS    ( 10 )
+#endif
+
+/**
+ * @brief The task notification index used to wake the executor's task.
+ *
+ * Set it to an index below configTASK_NOTIFICATION_ARRAY_ENTRIES other than
+ * tskDEFAULT_INDEX_TO_NOTIFY if the task running ASYNC_Run() also receives
+ * other notifications.
+ */
+#ifndef asyncconfigNOTIFICATION_INDEX
+    #define asyncconfigNOTIFICATION_INDEX    tskDEFAULT_INDEX_TO_NOTIFY
+#endif
+
+#endif /* _AWS_ASYNC_CONFIG_DEFAULTS_H_ */
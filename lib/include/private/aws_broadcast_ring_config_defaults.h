@@ -0,0 +1,48 @@
+/*
+ * Amazon FreeRTOS Broadcast Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_broadcast_ring_config_defaults.h
+ * @brief Default values for the broadcast ring configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_BROADCAST_RING_CONFIG_DEFAULTS_H_
+#define _AWS_BROADCAST_RING_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief The task notification index on which readers wait for items and the
+ * producer waits for room.
+ *
+ * Set it to an index below configTASK_NOTIFICATION_ARRAY_ENTRIES other than
+ * tskDEFAULT_INDEX_TO_NOTIFY so that the reading and writing tasks can keep
+ * using their default notification for other purposes.
+ */
+#ifndef broadcastconfigNOTIFICATION_INDEX
+    #define broadcastconfigNOTIFICATION_INDEX    tskDEFAULT_INDEX_TO_NOTIFY
+#endif
+
+#endif /* _AWS_BROADCAST_RING_CONFIG_DEFAULTS_H_ */
@@ -36,6 +36,8 @@
 
 #include <stdint.h>
 #include "aws_lib_init.h"
+#include "aws_bufferpool_config.h"
+#include "aws_bufferpool_config_defaults.h"
 
 /**
  * @brief Initializes the central buffer pool.
@@ -45,14 +47,53 @@
  */
 lib_initDECLARE_LIB_INIT( BUFFERPOOL_Init );
 
+/**
+ * @brief The maximum number of size classes in the buffer pool.
+ *
+ * Size classes are indexed from 0 (smallest) to bufferpoolNUM_SIZE_CLASSES - 1
+ * (the bufferpoolconfigBUFFER_SIZE class). Unused classes report zero buffers.
+ */
+#define bufferpoolNUM_SIZE_CLASSES    ( 5 )
+
+/**
+ * @brief Usage statistics of one size class of the buffer pool.
+ *
+ * @see BUFFERPOOL_GetStatistics.
+ */
+typedef struct BufferPoolStatistics
+{
+    uint32_t ulBufferSize;     /**< The size of each buffer in the class. */
+    uint32_t ulNumBuffers;     /**< The number of buffers in the class. */
+    uint32_t ulBuffersInUse;   /**< The number of buffers currently in use. */
+    uint32_t ulHighWaterMark;  /**< The maximum number of buffers ever in use at the same time. */
+    uint32_t ulFailedRequests; /**< The number of requests for which this was the smallest fitting class and it had no free buffer. */
+} BufferPoolStatistics_t;
+
+#if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+
+/**
+ * @brief Free buffers kept aside for one task.
+ *
+ * The members must not be accessed by the user.
+ *
+ * @see BUFFERPOOL_TaskCacheRegister.
+ */
+    typedef struct BufferPoolTaskCache
+    {
+        uint8_t * pucBuffers[ bufferpoolNUM_SIZE_CLASSES ][ bufferpoolconfigTASK_CACHE_DEPTH ]; /**< Free buffers of each size class. */
+        uint8_t ucCount[ bufferpoolNUM_SIZE_CLASSES ];                                          /**< Number of buffers in each row of pucBuffers. */
+    } BufferPoolTaskCache_t;
+#endif /* bufferpoolconfigTASK_CACHE_DEPTH */
+
 /**
  * @brief Gets a free buffer from the central buffer pool.
  *
  * It tries to get a free buffer of the given length from the
  * buffer pool. If a free buffer of the requested length or more
  * is available, it is returned and pulBufferLength is updated to
- * the actual length of the buffer. Otherwise NULL is returned to
- * indicate failure.
+ * the actual length of the buffer. The buffer is taken from the
+ * smallest size class that fits the request and has a free buffer.
+ * Otherwise NULL is returned to indicate failure.
  *
  * @param[in, out] pulBufferLength The caller should set it to the
  * desired length of the buffer. The returned buffer can be larger
@@ -63,11 +104,93 @@ lib_initDECLARE_LIB_INIT( BUFFERPOOL_Init );
  */
 uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength );
 
+/**
+ * @brief Gets a free buffer from the central buffer pool, waiting for one to
+ * be returned if none is available.
+ *
+ * Same as BUFFERPOOL_GetFreeBuffer, except that the calling task blocks for up
+ * to xTicksToWait for another task to return a large enough buffer. Only
+ * available when bufferpoolconfigENABLE_BLOCKING_GET is 1.
+ *
+ * @param[in, out] pulBufferLength As for BUFFERPOOL_GetFreeBuffer.
+ * @param[in] xTicksToWait The maximum time to wait for a buffer.
+ *
+ * @return The pointer to the buffer if one became available in time, NULL
+ * otherwise.
+ */
+uint8_t * BUFFERPOOL_GetFreeBufferWait( uint32_t * pulBufferLength,
+                                        TickType_t xTicksToWait );
+
 /**
  * @brief Returns the buffer back to the central buffer pool.
  *
+ * If the buffer was shared with BUFFERPOOL_RetainBuffer, it only goes back to
+ * the pool once every user has returned it.
+ *
  * @param[in] pucBuffer The buffer to return to the buffer pool.
  */
 void BUFFERPOOL_ReturnBuffer( uint8_t * const pucBuffer );
 
+/**
+ * @brief Adds a user to a buffer obtained from BUFFERPOOL_GetFreeBuffer.
+ *
+ * Lets several users share one buffer without copying it. Each call must be
+ * matched by a call to BUFFERPOOL_ReturnBuffer.
+ *
+ * @param[in] pucBuffer The buffer to share.
+ *
+ * @return pdPASS if the user was added, pdFAIL if the buffer already has the
+ * maximum number of users.
+ */
+BaseType_t BUFFERPOOL_RetainBuffer( uint8_t * const pucBuffer );
+
+/**
+ * @brief Gets the number of free buffers in all the size classes.
+ *
+ * Lets a consumer stop taking in work that would need a buffer while the pool
+ * is exhausted.
+ *
+ * @return The number of buffers which are not in use.
+ */
+uint32_t BUFFERPOOL_GetFreeBufferCount( void );
+
+#if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+
+/**
+ * @brief Gives the calling task a cache of free buffers.
+ *
+ * From then on, BUFFERPOOL_GetFreeBuffer and BUFFERPOOL_ReturnBuffer called by
+ * the task first use the cache, which needs no critical section. Buffers held
+ * by a cache are counted as in use in the statistics of the pool and cannot be
+ * used by other tasks.
+ *
+ * @param[in] pxCache Storage for the cache. Must remain valid until
+ * BUFFERPOOL_TaskCacheFlush is called.
+ */
+    void BUFFERPOOL_TaskCacheRegister( BufferPoolTaskCache_t * const pxCache );
+
+/**
+ * @brief Returns the buffers cached for the calling task to the pool and
+ * removes its cache.
+ *
+ * Must be called before a task with a cache is deleted.
+ */
+    void BUFFERPOOL_TaskCacheFlush( void );
+#endif /* bufferpoolconfigTASK_CACHE_DEPTH */
+
+/**
+ * @brief Gets the usage statistics of one size class of the buffer pool.
+ *
+ * The statistics can be used to tune the number of buffers in each size class
+ * from field data.
+ *
+ * @param[in] ulSizeClass The index of the size class.
+ * @param[out] pxStatistics The statistics of the size class.
+ *
+ * @return pdPASS if ulSizeClass is valid and pxStatistics was filled in,
+ * pdFAIL otherwise.
+ */
+BaseType_t BUFFERPOOL_GetStatistics( uint32_t ulSizeClass,
+                                     BufferPoolStatistics_t * const pxStatistics );
+
 #endif /* _AWS_BUFFER_POOL_H_ */
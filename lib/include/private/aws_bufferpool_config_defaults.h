@@ -0,0 +1,126 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_bufferpool_config_defaults.h
+ * @brief Ensures that the required buffer pool configurations are specified.
+ *
+ * The pool always contains bufferpoolconfigNUM_BUFFERS buffers of
+ * bufferpoolconfigBUFFER_SIZE bytes, which form the largest size class. Up to
+ * four additional, smaller size classes can be configured so that small
+ * requests (for example a PUBACK) do not consume a full size buffer. Size
+ * classes must be configured in increasing order of buffer size and must all
+ * be smaller than bufferpoolconfigBUFFER_SIZE. A size class with zero buffers
+ * is unused.
+ *
+ * For example, to add 64, 256 and 1024 byte classes in front of a 4096 byte
+ * bufferpoolconfigBUFFER_SIZE, define the following in aws_bufferpool_config.h:
+ *
+ * @code
+ * #define bufferpoolconfigSIZE_CLASS_0_BUFFER_SIZE    ( 64 )
+ * #define bufferpoolconfigSIZE_CLASS_0_NUM_BUFFERS    ( 8 )
+ * #define bufferpoolconfigSIZE_CLASS_1_BUFFER_SIZE    ( 256 )
+ * #define bufferpoolconfigSIZE_CLASS_1_NUM_BUFFERS    ( 4 )
+ * #define bufferpoolconfigSIZE_CLASS_2_BUFFER_SIZE    ( 1024 )
+ * #define bufferpoolconfigSIZE_CLASS_2_NUM_BUFFERS    ( 4 )
+ * @endcode
+ */
+
+#ifndef _AWS_BUFFER_POOL_CONFIG_DEFAULTS_H_
+#define _AWS_BUFFER_POOL_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief Buffer size and number of buffers of the first optional size class.
+ */
+#ifndef bufferpoolconfigSIZE_CLASS_0_NUM_BUFFERS
+    #define bufferpoolconfigSIZE_CLASS_0_NUM_BUFFERS    ( 0 )
+#endif
+#ifndef bufferpoolconfigSIZE_CLASS_0_BUFFER_SIZE
+    #define bufferpoolconfigSIZE_CLASS_0_BUFFER_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Buffer size and number of buffers of the second optional size class.
+ */
+#ifndef bufferpoolconfigSIZE_CLASS_1_NUM_BUFFERS
+    #define bufferpoolconfigSIZE_CLASS_1_NUM_BUFFERS    ( 0 )
+#endif
+#ifndef bufferpoolconfigSIZE_CLASS_1_BUFFER_SIZE
+    #define bufferpoolconfigSIZE_CLASS_1_BUFFER_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Buffer size and number of buffers of the third optional size class.
+ */
+#ifndef bufferpoolconfigSIZE_CLASS_2_NUM_BUFFERS
+    #define bufferpoolconfigSIZE_CLASS_2_NUM_BUFFERS    ( 0 )
+#endif
+#ifndef bufferpoolconfigSIZE_CLASS_2_BUFFER_SIZE
+    #define bufferpoolconfigSIZE_CLASS_2_BUFFER_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Buffer size and number of buffers of the fourth optional size class.
+ */
+#ifndef bufferpoolconfigSIZE_CLASS_3_NUM_BUFFERS
+    #define bufferpoolconfigSIZE_CLASS_3_NUM_BUFFERS    ( 0 )
+#endif
+#ifndef bufferpoolconfigSIZE_CLASS_3_BUFFER_SIZE
+    #define bufferpoolconfigSIZE_CLASS_3_BUFFER_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Set to 1 to make BUFFERPOOL_GetFreeBufferWait available.
+ *
+ * Tasks waiting for a buffer block on an event group which is set whenever a
+ * buffer goes back to the pool, so event_groups.c must be built.
+ */
+#ifndef bufferpoolconfigENABLE_BLOCKING_GET
+    #define bufferpoolconfigENABLE_BLOCKING_GET    ( 0 )
+#endif
+
+/**
+ * @brief The number of free buffers of each size class a task cache holds.
+ *
+ * A task which registers a BufferPoolTaskCache_t with BUFFERPOOL_TaskCacheRegister
+ * gets and returns buffers of its cache without entering a critical section.
+ * The cache is refilled from, and flushed to, the shared pool half a cache at
+ * a time. Set to 0 to disable task caches.
+ */
+#ifndef bufferpoolconfigTASK_CACHE_DEPTH
+    #define bufferpoolconfigTASK_CACHE_DEPTH    ( 0 )
+#endif
+
+/**
+ * @brief The thread local storage pointer used to find the cache of a task.
+ *
+ * Must be below configNUM_THREAD_LOCAL_STORAGE_POINTERS and not be used for
+ * anything else.
+ */
+#ifndef bufferpoolconfigTASK_CACHE_TLS_INDEX
+    #define bufferpoolconfigTASK_CACHE_TLS_INDEX    ( 0 )
+#endif
+
+#endif /* _AWS_BUFFER_POOL_CONFIG_DEFAULTS_H_ */
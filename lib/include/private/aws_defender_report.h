@@ -32,8 +32,39 @@
 #define DEFENDER_METRICS_TAG    DEFENDER_SelectTag( "metrics", "met" )
 #define DEFENDER_TOTAL_TAG      DEFENDER_SelectTag( "total", "t" )
 
+/**
+ * @brief Patch a preallocated report in place instead of building a new one.
+ *
+ * When 1, the first report after DEFENDER_MetricsInit is built as usual and
+ * then copied into a static template with every integer at full 32 bit width.
+ * Later reports only write the new report ID and metric values over those
+ * integers, so they make no heap allocations.  Metrics without a ValueMetric,
+ * or a report larger than defenderconfigREPORT_TEMPLATE_SIZE, fall back to
+ * CreateReport.
+ */
+#ifndef defenderconfigREPORT_TEMPLATE
+    #define defenderconfigREPORT_TEMPLATE    0
+#endif
+
+/**
+ * @brief Size in bytes of the static report template.
+ */
+#ifndef defenderconfigREPORT_TEMPLATE_SIZE
+    #define defenderconfigREPORT_TEMPLATE_SIZE    ( 128 )
+#endif
+
 CBORHandle_t CreateReport( void );
 
+/**
+ * @brief Updates the report template with the current metrics
+ *
+ * @param[out] ppucReport Receives the encoded report, valid until the next call
+ * @param[out] pulLength  Receives its length in bytes
+ * @return true on success, false if a template cannot be used
+ */
+bool CreateReportInPlace( uint8_t const ** ppucReport,
+                          uint32_t * pulLength );
+
 #endif /* ifndef AWS_DEFENDER_REPORT_H */
 
 /*
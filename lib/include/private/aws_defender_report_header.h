@@ -35,4 +35,10 @@ extern const char * DEFENDER_METRICS_VERSION;
 
 CBORHandle_t GetHeader( void );
 
+/**
+ * @brief Advances the report ID, as GetHeader does, without building a header
+ * @return The new report ID
+ */
+int32_t NextReportId( void );
+
 #endif /* end of include guard: AWS_DEFENDER_HEADER_H */
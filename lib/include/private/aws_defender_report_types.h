@@ -29,11 +29,17 @@
 
 typedef void ( * UpdateMetric_t )( void );
 typedef CBORHandle_t ( * ReportMetric_t )( void );
+typedef int32_t ( * ValueMetric_t )( void );
 
 struct DefenderMetric_s
 {
     UpdateMetric_t UpdateMetric;
     ReportMetric_t ReportMetric;
+
+    /* Current value of a metric whose report holds a single integer, so the
+     * report template can be patched without building the report.  NULL when
+     * the report holds anything else. */
+    ValueMetric_t ValueMetric;
 };
 
 /**
@@ -0,0 +1,55 @@
+/*
+ * Amazon FreeRTOS Deferred Work
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_deferred_work_config_defaults.h
+ * @brief Default values for the deferred work configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_DEFERRED_WORK_CONFIG_DEFAULTS_H_
+#define _AWS_DEFERRED_WORK_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief Priority of the task that runs deferred work.
+ *
+ * Deferred work runs before every task of a lower priority, so this should be
+ * above the tasks that consume what the drivers produce.
+ */
+#ifndef deferredconfigTASK_PRIORITY
+    #define deferredconfigTASK_PRIORITY    ( configMAX_PRIORITIES - 1 )
+#endif
+
+/**
+ * @brief Stack depth, in words, of the task that runs deferred work.
+ *
+ * Every work function runs on this stack, so it must fit the deepest one.
+ */
+#ifndef deferredconfigTASK_STACK_DEPTH
+    #define deferredconfigTASK_STACK_DEPTH    ( configMINIMAL_STACK_SIZE * 4 )
+#endif
+
+#endif /* _AWS_DEFERRED_WORK_CONFIG_DEFAULTS_H_ */
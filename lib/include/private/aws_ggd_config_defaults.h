@@ -77,8 +77,137 @@
     #define ggdconfigJSON_MAX_TOKENS    ( 128 )        /* Size of the array used by jsmn to store the tokens. */
 #endif
 
+/**
+ * @brief Delay in milliseconds between the connection attempts to the
+ * connectivity entries of a core.
+ *
+ * When greater than 0, the entries are tried in parallel, each by a task of
+ * its own. The next attempt starts after this delay, or as soon as one fails.
+ * The first entry to complete a TLS session is selected and the others are
+ * closed as they complete, so an unreachable entry no longer delays the
+ * entries after it by a full connect timeout.
+ *
+ * Set to 0 to try the entries one after another.
+ */
+#ifndef ggdconfigCONNECT_STAGGER_MS
+    #define ggdconfigCONNECT_STAGGER_MS    ( 0 )
+#endif
+
+/**
+ * @brief Largest number of connection attempts running at the same time
+ * when ggdconfigCONNECT_STAGGER_MS is greater than 0.
+ *
+ * The entries are raced in groups of this size, each group only starts once
+ * the previous one failed completely.
+ */
+#ifndef ggdconfigMAX_PARALLEL_CONNECTS
+    #define ggdconfigMAX_PARALLEL_CONNECTS    ( 4 )
+#endif
+
+/**
+ * @brief Stack size, in words, of the connection attempt tasks.  It must be
+ * large enough for a TLS handshake.
+ */
+#ifndef ggdconfigCONNECT_TASK_STACK_SIZE
+    #define ggdconfigCONNECT_TASK_STACK_SIZE    ( configMINIMAL_STACK_SIZE * 16 )
+#endif
+
+/**
+ * @brief Priority of the connection attempt tasks.
+ */
+#ifndef ggdconfigCONNECT_TASK_PRIORITY
+    #define ggdconfigCONNECT_TASK_PRIORITY    ( tskIDLE_PRIORITY )
+#endif
+
 #ifndef ggdconfigPRINT
     #define ggdconfigPRINT    vLoggingPrintf
 #endif
 
+/**
+ * @brief Set to 1 to let GGD_GetGGCIPandCertificate() parse the discovery
+ * document while it is received.
+ *
+ * The buffer passed by the user then only has to hold the host addresses of
+ * the selected core and its group CA, instead of the complete document.
+ * GGD_GetGGCIPandCertificateStreamed() always parses this way.
+ */
+#ifndef ggdconfigDISCOVERY_STREAM_PARSE
+    #define ggdconfigDISCOVERY_STREAM_PARSE    ( 0 )
+#endif
+
+/**
+ * @brief Number of bytes read from the socket at a time by the streaming
+ * parser. The chunk is stored on the stack.
+ */
+#ifndef ggdconfigSTREAM_CHUNK_SIZE
+    #define ggdconfigSTREAM_CHUNK_SIZE    ( 64 )
+#endif
+
+/**
+ * @brief Largest number of connectivity entries of the selected core that
+ * are kept by the streaming parser, further entries are ignored.
+ */
+#ifndef ggdconfigSTREAM_MAX_CONNECTIVITY
+    #define ggdconfigSTREAM_MAX_CONNECTIVITY    ( 8 )
+#endif
+
+/**
+ * @brief Set to 1 to keep the result of GGD_GetGGCIPandCertificate() in RAM.
+ *
+ * While the cached entry is younger than ggdconfigDISCOVERY_CACHE_TTL_S, the
+ * core address and group CA are returned without contacting the cloud.  An
+ * older entry is revalidated with an If-None-Match request when the cloud
+ * returned an ETag, a "304 Not Modified" reply then renews the entry without
+ * downloading and parsing the discovery document again.
+ */
+#ifndef ggdconfigDISCOVERY_CACHE
+    #define ggdconfigDISCOVERY_CACHE    ( 0 )
+#endif
+
+/**
+ * @brief Number of seconds during which a cached discovery result is used
+ * without asking the cloud.
+ */
+#ifndef ggdconfigDISCOVERY_CACHE_TTL_S
+    #define ggdconfigDISCOVERY_CACHE_TTL_S    ( 3600 )
+#endif
+
+/**
+ * @brief Largest host address, including the terminating zero, that can be cached.
+ */
+#ifndef ggdconfigDISCOVERY_CACHE_HOST_SIZE
+    #define ggdconfigDISCOVERY_CACHE_HOST_SIZE    ( 128 )
+#endif
+
+/**
+ * @brief Largest group CA certificate, including the terminating zero, that can be cached.
+ */
+#ifndef ggdconfigDISCOVERY_CACHE_CERT_SIZE
+    #define ggdconfigDISCOVERY_CACHE_CERT_SIZE    ( 2048 )
+#endif
+
+/**
+ * @brief Largest ETag, including the terminating zero, that can be cached.
+ */
+#ifndef ggdconfigDISCOVERY_CACHE_ETAG_SIZE
+    #define ggdconfigDISCOVERY_CACHE_ETAG_SIZE    ( 64 )
+#endif
+
+/**
+ * @brief Hooks to keep the discovery cache in non-volatile memory.
+ *
+ * ggdconfigDISCOVERY_CACHE_STORE( pvData, ulSize ) is called whenever the
+ * cache changes.  ggdconfigDISCOVERY_CACHE_LOAD( pvData, ulSize ) is called
+ * once, before the first discovery, and should return pdPASS when it filled
+ * in all ulSize bytes.  A loaded entry is always revalidated with the cloud
+ * before it is used, the time it was fetched is not known after a reset.
+ */
+#ifndef ggdconfigDISCOVERY_CACHE_LOAD
+    #define ggdconfigDISCOVERY_CACHE_LOAD( pvData, ulSize )    ( pdFAIL )
+#endif
+
+#ifndef ggdconfigDISCOVERY_CACHE_STORE
+    #define ggdconfigDISCOVERY_CACHE_STORE( pvData, ulSize )
+#endif
+
 #endif /* ifndef _AWS_GREENGRASS_CONFIG_DEFAULT_H_ */
@@ -0,0 +1,118 @@
+/*
+ * Amazon FreeRTOS Heap Profiler
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_heap_profiler_config_defaults.h
+ * @brief Default values for the heap profiler configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_HEAP_PROFILER_CONFIG_DEFAULTS_H_
+#define _AWS_HEAP_PROFILER_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief 1 if the kernel heap trace macros are mapped to the profiler.
+ *
+ * aws_heap_profiler_hooks.h sets this to 1, so code which only calls the
+ * profiler when it is linked in can test this macro.
+ */
+#ifndef heapprofconfigENABLE_HOOKS
+    #define heapprofconfigENABLE_HOOKS    ( 0 )
+#endif
+
+/**
+ * @brief The number of call sites that are told apart.
+ *
+ * A call site is a call to pvPortMalloc() made by a given task. Allocations
+ * made once the table is full are added to a single site with a NULL caller.
+ * Must be a power of two.
+ */
+#ifndef heapprofconfigMAX_SITES
+    #define heapprofconfigMAX_SITES    ( 64U )
+#endif
+
+/**
+ * @brief The number of allocated blocks whose call site is remembered until
+ * they are freed.
+ *
+ * Each entry takes three words. Blocks allocated once the table is full are
+ * counted as untracked, and their bytes are not included in the live bytes.
+ * Must be a power of two.
+ */
+#ifndef heapprofconfigMAX_LIVE_BLOCKS
+    #define heapprofconfigMAX_LIVE_BLOCKS    ( 256U )
+#endif
+
+/**
+ * @brief The number of characters of the task name kept for each site,
+ * including the terminating null.
+ */
+#ifndef heapprofconfigTASK_NAME_LENGTH
+    #define heapprofconfigTASK_NAME_LENGTH    ( 8U )
+#endif
+
+/**
+ * @brief Returns the size of the largest free block of the heap.
+ *
+ * heap_1.c, heap_2.c and heap_3.c do not provide
+ * xPortGetLargestFreeBlockSize(), so this has to be defined, for instance
+ * as 0, when one of them is used.
+ */
+#ifndef heapprofconfigLARGEST_FREE_BLOCK
+    #define heapprofconfigLARGEST_FREE_BLOCK()    xPortGetLargestFreeBlockSize()
+#endif
+
+/**
+ * @brief The number of call sites printed by HEAPPROF_PrintReport(), largest
+ * live bytes first.
+ */
+#ifndef heapprofconfigREPORT_SITES
+    #define heapprofconfigREPORT_SITES    ( 8U )
+#endif
+
+/**
+ * @brief The time between two reports printed by the reporting task, in
+ * milliseconds.
+ */
+#ifndef heapprofconfigREPORT_PERIOD_MS
+    #define heapprofconfigREPORT_PERIOD_MS    ( 60000U )
+#endif
+
+/**
+ * @brief Priority of the reporting task.
+ */
+#ifndef heapprofconfigTASK_PRIORITY
+    #define heapprofconfigTASK_PRIORITY    ( tskIDLE_PRIORITY )
+#endif
+
+/**
+ * @brief Stack depth, in words, of the reporting task.
+ */
+#ifndef heapprofconfigTASK_STACK_DEPTH
+    #define heapprofconfigTASK_STACK_DEPTH    ( configMINIMAL_STACK_SIZE * 3 )
+#endif
+
+#endif /* _AWS_HEAP_PROFILER_CONFIG_DEFAULTS_H_ */
@@ -54,6 +54,36 @@ BaseType_t GGD_SecureConnect_Connect( const GGD_HostAddressData_t * pxHostAddres
                                       uint32_t ulReceiveTimeOut,
                                       uint32_t ulSendTimeOut );
 
+/*
+ * @brief Start a secure connection to the first of several hosts that accepts one.
+ *
+ * The hosts are tried in order. When ggdconfigCONNECT_STAGGER_MS is greater
+ * than 0, the attempts overlap: each runs in a task of its own and the next
+ * one starts after ggdconfigCONNECT_STAGGER_MS, or as soon as one fails.
+ * The attempts that complete after the first successful one are closed.
+ *
+ * @param [in] pxHostAddressData : Hosts to connect to.
+ *
+ * @param [in] ulHostCount : Number of hosts in pxHostAddressData.
+ *
+ * @param [out] pxSocket : Returned socket connected to the selected host.
+ *
+ * @param [out] pulHostIndex : Index of the selected host in pxHostAddressData.
+ *
+ * @param [in] ulReceiveTimeOut : Receive Timeout in millisecond.
+ *
+ * @param [in] ulSendTimeOut : Send Timeout in millisecond
+ *
+ * @return If a connection was successful then pdPASS is
+ * returned.  Otherwise pdFAIL is returned.
+ */
+BaseType_t GGD_SecureConnect_ConnectFirst( const GGD_HostAddressData_t * pxHostAddressData,
+                                           uint32_t ulHostCount,
+                                           Socket_t * pxSocket,
+                                           uint32_t * pulHostIndex,
+                                           uint32_t ulReceiveTimeOut,
+                                           uint32_t ulSendTimeOut );
+
 /*
  * @briefstop a secure connection with host.
  *
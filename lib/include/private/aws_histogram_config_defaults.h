@@ -0,0 +1,60 @@
+/*
+ * Amazon FreeRTOS Histogram
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_histogram_config_defaults.h
+ * @brief Default values for the histogram configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h. All histograms share
+ * the same buckets, which is what lets any two of them be merged.
+ */
+
+#ifndef _AWS_HISTOGRAM_CONFIG_DEFAULTS_H_
+#define _AWS_HISTOGRAM_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief Each power of two range of values is split into 2 to the power of
+ * this many buckets.
+ *
+ * A value is known to within 1 / 2^histogramconfigSUB_BUCKET_BITS of itself,
+ * so 25% with the default. Every extra bit halves the error and doubles the
+ * size of a histogram.
+ */
+#ifndef histogramconfigSUB_BUCKET_BITS
+    #define histogramconfigSUB_BUCKET_BITS    ( 2U )
+#endif
+
+/**
+ * @brief Values up to 2 to the power of this, exclusive, have their own
+ * buckets. Larger values are counted in a single overflow bucket.
+ *
+ * The default covers 16 seconds in microseconds, or 4.6 hours in
+ * milliseconds. Must be at most 32.
+ */
+#ifndef histogramconfigVALUE_BITS
+    #define histogramconfigVALUE_BITS    ( 24U )
+#endif
+
+#endif /* _AWS_HISTOGRAM_CONFIG_DEFAULTS_H_ */
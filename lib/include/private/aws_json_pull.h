@@ -0,0 +1,200 @@
+/*
+ * Amazon FreeRTOS JSON Pull Parser
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_json_pull.h
+ * @brief Incremental JSON pull parser with path based key matching.
+ *
+ * The parser reads a JSON document one character at a time and returns an
+ * event for every value it completes, without allocating memory and without
+ * keeping a token array. The document can be given in chunks of any size, as
+ * they arrive from MQTT or TLS: JSONPULL_Next() returns eJSONPullNeedInput when
+ * a chunk has been consumed, and the next chunk is given to JSONPULL_SetInput().
+ *
+ * Every event carries the path of its value, built from the keys and array
+ * indices leading to it, for example "execution.jobDocument.afr_ota.files[0].filesize".
+ * Members of the top-level object have their key as path, and the top-level
+ * container itself has an empty path. Paths are compared with JSONPULL_PathMatch().
+ *
+ * String values are returned without their quotes and escape sequences are left
+ * as they are in the document.
+ */
+
+#ifndef _AWS_JSON_PULL_H_
+#define _AWS_JSON_PULL_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_json_pull.h"
+#endif
+
+#include <stddef.h>
+
+#include "aws_json_pull_config_defaults.h"
+
+/**
+ * @brief Return values of JSONPULL_Next().
+ */
+typedef enum
+{
+    eJSONPullEvent = 0, /**< An event was returned. */
+    eJSONPullNeedInput, /**< The input was consumed; give the next chunk with JSONPULL_SetInput(). */
+    eJSONPullComplete,  /**< The top-level object or array was closed. */
+    eJSONPullInvalid,   /**< The document is not valid JSON. */
+    eJSONPullTooDeep    /**< The document nests deeper than jsonpullconfigMAX_DEPTH. */
+} JSONPullStatus_t;
+
+/**
+ * @brief The kinds of event returned by JSONPULL_Next().
+ */
+typedef enum
+{
+    eJSONPullObjectStart = 0, /**< '{' was read. */
+    eJSONPullObjectEnd,       /**< '}' was read. */
+    eJSONPullArrayStart,      /**< '[' was read. */
+    eJSONPullArrayEnd,        /**< ']' was read. */
+    eJSONPullString,          /**< A string value was read. */
+    eJSONPullPrimitive        /**< A number, true, false or null was read. */
+} JSONPullEventType_t;
+
+/**
+ * @brief An event returned by JSONPULL_Next().
+ *
+ * pcPath points into the parser and pcValue into the current chunk, or into
+ * the scratch buffer for values that spanned chunks. Both stay valid until the
+ * next call to JSONPULL_Next() or JSONPULL_SetInput().
+ */
+typedef struct JSONPullEvent
+{
+    JSONPullEventType_t xType;  /**< The kind of event. */
+    const char * pcPath;        /**< The path of the value, not NUL terminated. */
+    size_t xPathLength;         /**< The length of pcPath. */
+    BaseType_t xPathTooLong;    /**< pdTRUE if the path did not fit in jsonpullconfigMAX_PATH_LENGTH; pcPath is then not usable. */
+    const char * pcValue;       /**< The value of a string or primitive, NULL for other events. */
+    size_t xValueLength;        /**< The length of pcValue. */
+    BaseType_t xValueTruncated; /**< pdTRUE if the value spanned chunks and did not fit in the scratch buffer. */
+} JSONPullEvent_t;
+
+/**
+ * @brief The parser states. Only used by aws_json_pull.c.
+ */
+typedef enum
+{
+    eJSONPullStateValue = 0,   /**< Expecting a value. */
+    eJSONPullStateValueOrEnd,  /**< After '[': expecting a value or ']'. */
+    eJSONPullStateKeyOrEnd,    /**< After '{': expecting a key or '}'. */
+    eJSONPullStateKey,         /**< After ',' in an object: expecting a key. */
+    eJSONPullStateInKey,       /**< Inside a key. */
+    eJSONPullStateColon,       /**< After a key: expecting ':'. */
+    eJSONPullStateInString,    /**< Inside a string value. */
+    eJSONPullStateInPrimitive, /**< Inside a primitive value. */
+    eJSONPullStateCommaOrEnd,  /**< After a value: expecting ',' or the end of the container. */
+    eJSONPullStateComplete,    /**< The top-level container was closed. */
+    eJSONPullStateInvalid      /**< An error was found. */
+} JSONPullState_t;
+
+/**
+ * @brief The parser. Declare one per document and set it up with
+ * JSONPULL_Init(); its members are only used by aws_json_pull.c.
+ */
+typedef struct JSONPullParser
+{
+    const char * pcInput;                                         /**< The current chunk. */
+    size_t xInputLength;                                          /**< The length of the current chunk. */
+    size_t xInputIndex;                                           /**< The next character to read in the current chunk. */
+    JSONPullState_t xState;                                       /**< What the next character is expected to be. */
+    BaseType_t xEscape;                                           /**< pdTRUE if the previous character in a string was a backslash. */
+    uint8_t ucDepth;                                              /**< The number of open containers. */
+    uint32_t ulArrayMask;                                         /**< Bit n is set if the container at depth n is an array. */
+    uint32_t pulElementIndex[ jsonpullconfigMAX_DEPTH ];          /**< The index of the next element of each open array. */
+    uint16_t pusContainerPathLength[ jsonpullconfigMAX_DEPTH ];   /**< The path length of each open container. */
+    uint16_t usPathLength;                                        /**< The current path length, or jsonpullPATH_TOO_LONG. */
+    char cPath[ jsonpullconfigMAX_PATH_LENGTH ];                  /**< The current path. */
+    size_t xValueStart;                                           /**< Where the current value starts in the current chunk. */
+    BaseType_t xValueInScratch;                                   /**< pdTRUE if the current value spans chunks. */
+    BaseType_t xValueTruncated;                                   /**< pdTRUE if the scratch buffer overflowed. */
+    char * pcScratch;                                             /**< Buffer for values that span chunks. */
+    size_t xScratchSize;                                          /**< The size of pcScratch. */
+    size_t xScratchLength;                                        /**< The number of bytes used in pcScratch. */
+} JSONPullParser_t;
+
+/**
+ * @brief The value of usPathLength when the path does not fit.
+ */
+#define jsonpullPATH_TOO_LONG    ( ( uint16_t ) 0xFFFFU )
+
+/**
+ * @brief Sets up a parser for a new document.
+ *
+ * @param[out] pxParser The parser.
+ * @param[in] pcScratch Buffer that collects values that span chunks. Can be NULL
+ * if the document is given in one chunk; values that span chunks are then
+ * returned empty and marked truncated.
+ * @param[in] xScratchSize The size of pcScratch.
+ */
+void JSONPULL_Init( JSONPullParser_t * pxParser,
+                    char * pcScratch,
+                    size_t xScratchSize );
+
+/**
+ * @brief Gives the parser the next chunk of the document.
+ *
+ * The chunk must stay valid until JSONPULL_Next() returns eJSONPullNeedInput.
+ *
+ * @param[in] pxParser The parser.
+ * @param[in] pcInput The chunk.
+ * @param[in] xInputLength The length of the chunk.
+ */
+void JSONPULL_SetInput( JSONPullParser_t * pxParser,
+                        const char * pcInput,
+                        size_t xInputLength );
+
+/**
+ * @brief Reads the document until the next event.
+ *
+ * @param[in] pxParser The parser.
+ * @param[out] pxEvent Set to the event when eJSONPullEvent is returned.
+ *
+ * @return eJSONPullEvent if pxEvent was set, eJSONPullNeedInput if the chunk was
+ * consumed, eJSONPullComplete once the document has been read, or an error.
+ * After an error, eJSONPullInvalid is returned by every call.
+ */
+JSONPullStatus_t JSONPULL_Next( JSONPullParser_t * pxParser,
+                                JSONPullEvent_t * pxEvent );
+
+/**
+ * @brief Checks whether the path of an event matches a pattern.
+ *
+ * The pattern is a path in which array indices can be written "[*]" to match
+ * any index, for example "Cores[*].Connectivity[*].HostAddress".
+ *
+ * @param[in] pxEvent The event.
+ * @param[in] pcPattern The NUL terminated pattern.
+ *
+ * @return pdTRUE if the path matches, pdFALSE otherwise.
+ */
+BaseType_t JSONPULL_PathMatch( const JSONPullEvent_t * pxEvent,
+                               const char * pcPattern );
+
+#endif /* _AWS_JSON_PULL_H_ */
@@ -0,0 +1,58 @@
+/*
+ * Amazon FreeRTOS JSON Pull Parser
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_json_pull_config_defaults.h
+ * @brief Default values for the JSON pull parser configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_JSON_PULL_CONFIG_DEFAULTS_H_
+#define _AWS_JSON_PULL_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief The deepest nesting of objects and arrays a document can have.
+ *
+ * Each level costs 6 bytes in JSONPullParser_t. Must not be more than 32.
+ */
+#ifndef jsonpullconfigMAX_DEPTH
+    #define jsonpullconfigMAX_DEPTH    ( 8 )
+#endif
+
+/**
+ * @brief The longest path, in characters, that can be matched.
+ *
+ * Values with longer paths are still parsed but are reported with xPathTooLong set.
+ */
+#ifndef jsonpullconfigMAX_PATH_LENGTH
+    #define jsonpullconfigMAX_PATH_LENGTH    ( 96 )
+#endif
+
+#if ( jsonpullconfigMAX_DEPTH > 32 )
+    #error "jsonpullconfigMAX_DEPTH must not be more than 32."
+#endif
+
+#endif /* _AWS_JSON_PULL_CONFIG_DEFAULTS_H_ */
@@ -0,0 +1,205 @@
+/*
+ * Amazon FreeRTOS JSON Writer
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_json_writer.h
+ * @brief Streaming JSON writer without printf and without memory allocation.
+ *
+ * The writer appends a document to a caller supplied buffer, one token at a
+ * time. It places the commas and colons, escapes strings, formats integers
+ * itself and keeps the exact length of the document, so a message can be
+ * written straight into the buffer it is published from.
+ *
+ * A string value can also be composed from pieces between
+ * JSONWRITE_StringStart() and JSONWRITE_StringEnd(), for values such as
+ * "12/40" or "v1.2.3".
+ *
+ * Writing never fails half way: when the buffer is too small the writer keeps
+ * counting, and JSONWRITE_Finish() reports the failure and the size that
+ * would have been needed.
+ */
+
+#ifndef _AWS_JSON_WRITER_H_
+#define _AWS_JSON_WRITER_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_json_writer.h"
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief The deepest nesting of objects and arrays the writer supports.
+ */
+#define jsonwriteMAX_DEPTH    ( 32U )
+
+/**
+ * @brief The writer. Declare one per document and set it up with
+ * JSONWRITE_Init(); its members are only used by aws_json_writer.c.
+ */
+typedef struct JSONWriter
+{
+    char * pcBuffer;      /**< Where the document is written. */
+    size_t xBufferSize;   /**< The size of pcBuffer. */
+    size_t xLength;       /**< The length of the document, including what did not fit. */
+    uint32_t ulIsArray;   /**< Bit n is set if the container at depth n is an array. */
+    uint32_t ulHasMember; /**< Bit n is set if the container at depth n already has a member. */
+    uint8_t ucDepth;      /**< The number of open containers. */
+    BaseType_t xAfterKey; /**< pdTRUE if a key was written and its value was not. */
+    BaseType_t xInString; /**< pdTRUE between JSONWRITE_StringStart() and JSONWRITE_StringEnd(). */
+    BaseType_t xInvalid;  /**< pdTRUE if the calls did not form a valid document. */
+} JSONWriter_t;
+
+/**
+ * @brief Prepares a writer.
+ *
+ * @param[out] pxWriter The writer.
+ * @param[in] pcBuffer Where the document is written.
+ * @param[in] xBufferSize The size of pcBuffer. The document is NUL terminated
+ * when there is room for the terminator.
+ */
+void JSONWRITE_Init( JSONWriter_t * pxWriter,
+                     char * pcBuffer,
+                     size_t xBufferSize );
+
+/**
+ * @brief Opens an object, as a value or as an array element.
+ */
+void JSONWRITE_ObjectStart( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Closes the innermost object.
+ */
+void JSONWRITE_ObjectEnd( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Opens an array, as a value or as an array element.
+ */
+void JSONWRITE_ArrayStart( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Closes the innermost array.
+ */
+void JSONWRITE_ArrayEnd( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Writes the key of the next member of the innermost object.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[in] pcKey The NUL terminated key, escaped as needed.
+ */
+void JSONWRITE_Key( JSONWriter_t * pxWriter,
+                    const char * pcKey );
+
+/**
+ * @brief Writes a string value.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[in] pcValue The string, escaped as needed.
+ * @param[in] xLength The length of pcValue.
+ */
+void JSONWRITE_String( JSONWriter_t * pxWriter,
+                       const char * pcValue,
+                       size_t xLength );
+
+/**
+ * @brief Writes an unsigned integer value.
+ */
+void JSONWRITE_UInt( JSONWriter_t * pxWriter,
+                     uint32_t ulValue );
+
+/**
+ * @brief Writes a signed integer value.
+ */
+void JSONWRITE_Int( JSONWriter_t * pxWriter,
+                    int32_t lValue );
+
+/**
+ * @brief Writes true or false.
+ */
+void JSONWRITE_Bool( JSONWriter_t * pxWriter,
+                     BaseType_t xValue );
+
+/**
+ * @brief Writes null.
+ */
+void JSONWRITE_Null( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Opens a string value that is composed with the JSONWRITE_StringAppend
+ * functions.
+ */
+void JSONWRITE_StringStart( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Appends text to the open string, escaped as needed.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[in] pcText The text.
+ * @param[in] xLength The length of pcText.
+ */
+void JSONWRITE_StringAppend( JSONWriter_t * pxWriter,
+                             const char * pcText,
+                             size_t xLength );
+
+/**
+ * @brief Appends an unsigned integer in decimal to the open string.
+ */
+void JSONWRITE_StringAppendUInt( JSONWriter_t * pxWriter,
+                                 uint32_t ulValue );
+
+/**
+ * @brief Appends an unsigned integer in lower case hexadecimal to the open
+ * string, without the "0x" prefix.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[in] ulValue The value.
+ * @param[in] ucMinDigits The value is padded with zeros to this many digits,
+ * at most 8.
+ */
+void JSONWRITE_StringAppendHex( JSONWriter_t * pxWriter,
+                                uint32_t ulValue,
+                                uint8_t ucMinDigits );
+
+/**
+ * @brief Closes the open string.
+ */
+void JSONWRITE_StringEnd( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Checks the document once its top-level value has been written.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[out] pxLength Receives the length of the document without the NUL
+ * terminator, or the buffer size it would need, terminator included, when it
+ * did not fit. May be NULL.
+ *
+ * @return pdPASS if the document is complete and fits in the buffer with its
+ * terminator, pdFAIL otherwise.
+ */
+BaseType_t JSONWRITE_Finish( const JSONWriter_t * pxWriter,
+                             size_t * pxLength );
+
+#endif /* _AWS_JSON_WRITER_H_ */
@@ -51,6 +51,41 @@
     #define mqttconfigENABLE_METRICS    ( 1 )
 #endif
 
+/**
+ * @brief Set to 1 to collect the statistics returned by
+ * MQTT_AGENT_GetStatistics().
+ *
+ * Each statistics update costs a few instructions in the MQTT task, and a
+ * tick count read for the latencies.
+ */
+#ifndef mqttconfigENABLE_STATISTICS
+    #define mqttconfigENABLE_STATISTICS    ( 0 )
+#endif
+
+/**
+ * @brief The number of QoS1 publishes per connection whose time to PUBACK is
+ * measured at the same time.
+ *
+ * A publish sent while all the entries are in use is not measured.
+ */
+#ifndef mqttconfigSTATISTICS_TIMED_PUBLISHES
+    #define mqttconfigSTATISTICS_TIMED_PUBLISHES    ( 8 )
+#endif
+
+/**
+ * @brief Trace hooks called when the MQTT task starts and finishes processing a
+ * command from its queue.
+ *
+ * Empty by default. aws_trace_ring_hooks.h maps them to the trace ring.
+ */
+#ifndef mqttconfigTRACE_COMMAND_RECEIVED
+    #define mqttconfigTRACE_COMMAND_RECEIVED( xEventType, uxBrokerNumber )
+#endif
+
+#ifndef mqttconfigTRACE_COMMAND_PROCESSED
+    #define mqttconfigTRACE_COMMAND_PROCESSED( xEventType, uxBrokerNumber )
+#endif
+
 /**
  * @brief The maximum time interval in seconds allowed to elapse between 2 consecutive
  * control packets.
@@ -118,6 +153,19 @@
 #ifndef mqttconfigMQTT_TASK_PRIORITY
     #define mqttconfigMQTT_TASK_PRIORITY    ( tskIDLE_PRIORITY )
 #endif
+
+/**
+ * @brief Number of MQTT tasks which serve the broker connections.
+ *
+ * Broker connection n is served by task ( n % mqttconfigMQTT_TASKS ), and
+ * each task has its own command queue, so a slow send on one connection
+ * does not delay commands for connections served by other tasks. Each task
+ * has a stack of mqttconfigMQTT_TASK_STACK_DEPTH words and runs at
+ * mqttconfigMQTT_TASK_PRIORITY.
+ */
+#ifndef mqttconfigMQTT_TASKS
+    #define mqttconfigMQTT_TASKS    ( 1 )
+#endif
 /** @} */
 
 /**
@@ -134,6 +182,20 @@
     #define mqttconfigMAX_PARALLEL_OPS    ( 5 )
 #endif
 
+/**
+ * @brief Maximum number of MQTT_AGENT_PublishAsync() calls in progress per
+ * client.
+ *
+ * Publishes made with MQTT_AGENT_PublishAsync() do not use the
+ * mqttconfigMAX_PARALLEL_OPS slots, so a single task can pipeline up to this
+ * many of them before it blocks. Each QoS1 publish in flight also holds an MQTT
+ * buffer until its PUBACK arrives, so the buffer pool must be large enough.
+ * Set to 0 to remove MQTT_AGENT_PublishAsync() support.
+ */
+#ifndef mqttconfigASYNC_PUBLISH_WINDOW
+    #define mqttconfigASYNC_PUBLISH_WINDOW    ( 0 )
+#endif
+
 /**
  * @brief Time in milliseconds after which the TCP send operation should timeout.
  */
@@ -141,6 +203,32 @@
     #define mqttconfigTCP_SEND_TIMEOUT_MS    ( 2000 )
 #endif
 
+/**
+ * @brief Maximum time in milliseconds for which outgoing publish messages are
+ * held back so that they can be written to the socket together.
+ *
+ * When non-zero, publish messages are collected in a per connection batch
+ * buffer and the batch is written to the socket with one send call once it is
+ * full, once mqttconfigPUBLISH_BATCH_MAX_DELAY_MS has elapsed since the first
+ * message was added, or before any other MQTT packet is sent on the
+ * connection. This reduces the number of TCP segments, TLS records and radio
+ * wake-ups at the cost of latency. QoS0 publishes are reported as sent when
+ * they are added to the batch. Set to 0 to send every publish immediately.
+ */
+#ifndef mqttconfigPUBLISH_BATCH_MAX_DELAY_MS
+    #define mqttconfigPUBLISH_BATCH_MAX_DELAY_MS    ( 0 )
+#endif
+
+/**
+ * @brief Size in bytes of the per connection publish batch buffer.
+ *
+ * Only used when mqttconfigPUBLISH_BATCH_MAX_DELAY_MS is non-zero. Publish
+ * messages larger than this are sent immediately.
+ */
+#ifndef mqttconfigPUBLISH_BATCH_MAX_BYTES
+    #define mqttconfigPUBLISH_BATCH_MAX_BYTES    ( 1024 )
+#endif
+
 /**
  * @brief Length of the buffer used to receive data.
  */
@@ -148,6 +236,165 @@
     #define mqttconfigRX_BUFFER_SIZE    ( 1024 )
 #endif
 
+/**
+ * @brief Set to 1 to allocate the state of a connection when it is first used.
+ *
+ * By default the state of all mqttconfigMAX_BROKERS connections, including
+ * their receive buffers, is reserved statically. When set to 1, the state of a
+ * connection is allocated with pvPortMalloc() by the first MQTT_AGENT_Create()
+ * that gets it, and is kept for reuse after MQTT_AGENT_Delete(). Its receive
+ * buffer of mqttconfigRX_BUFFER_SIZE bytes is only allocated while the
+ * connection has a socket. Brokers that are never used then cost no RAM.
+ */
+#ifndef mqttconfigALLOCATE_CONNECTIONS
+    #define mqttconfigALLOCATE_CONNECTIONS    ( 0 )
+#endif
+
+/**
+ * @brief Maximum time in milliseconds the MQTT task waits for a free buffer.
+ *
+ * When non-zero, a packet received while the buffer pool is empty is only
+ * dropped, and a command only fails for lack of a buffer, once no buffer has
+ * been returned for this long. While the pool is empty, the MQTT task also
+ * stops reading from the sockets for up to this long, which leaves the data in
+ * the TCP window and makes the broker slow down. Buffers holding publishes
+ * that wait for a PUBACK are only freed once reading resumes or the publishes
+ * time out, so the wait should be short.
+ *
+ * Requires the default buffer pool functions and bufferpoolconfigENABLE_BLOCKING_GET
+ * set to 1. Set to 0 to drop packets immediately.
+ */
+#ifndef mqttconfigBUFFER_WAIT_MS
+    #define mqttconfigBUFFER_WAIT_MS    ( 0 )
+#endif
+
+/**
+ * @brief Set to 1 to pass received data to the MQTT Core library directly from
+ * the receive buffer of the TCP/IP stack.
+ *
+ * When enabled, connections are read with SOCKETS_RecvZeroCopy() and the data
+ * is parsed in place, from the TCP stream or from the decrypted TLS record,
+ * instead of being copied into the receive buffer of the connection first.
+ * Requires a Secure Sockets port which provides SOCKETS_RecvZeroCopy().
+ */
+#ifndef mqttconfigENABLE_ZERO_COPY_RX
+    #define mqttconfigENABLE_ZERO_COPY_RX    ( 0 )
+#endif
+
+/**
+ * @brief Set to 1 to transmit the header and the payload of publish messages
+ * with a single call to SOCKETS_SendV().
+ *
+ * When enabled, the payload is sent directly from the buffer passed to
+ * MQTT_AGENT_Publish() instead of being copied into a buffer from the buffer
+ * pool first, and the header and payload are coalesced into one TCP segment
+ * or TLS record where possible. Requires a Secure Sockets port which provides
+ * SOCKETS_SendV().
+ */
+#ifndef mqttconfigENABLE_SENDV
+    #define mqttconfigENABLE_SENDV    ( 0 )
+#endif
+
+/**
+ * @brief Set to 1 to read only the connections which have received data.
+ *
+ * When enabled, the socket wakeup callback records which connection needs
+ * attention and the MQTT task only reads those sockets, instead of calling
+ * SOCKETS_Recv() on every connection each time it wakes up. The task then
+ * sleeps until the next keep-alive or timeout is due rather than for at most
+ * mqttconfigMQTT_TASK_MAX_BLOCK_TICKS. Connections whose socket does not
+ * support SOCKETS_SO_WAKEUP_CALLBACK are still polled. mqttconfigMAX_BROKERS
+ * must not exceed 32.
+ */
+#ifndef mqttconfigENABLE_EVENT_DRIVEN_RX
+    #define mqttconfigENABLE_EVENT_DRIVEN_RX    ( 0 )
+#endif
+
+/**
+ * @brief Number of QoS1 publishes stored for each connection while it is down.
+ *
+ * When non-zero, a QoS1 MQTT_AGENT_Publish() on a connection that is not
+ * connected succeeds and stores the publish instead of failing. Stored
+ * publishes are sent one at a time, every
+ * mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS, once the broker has accepted
+ * the next connection, and are only removed when their PUBACK arrives. They
+ * may therefore be delivered after publishes made since the reconnect. Set to
+ * 0 to fail publishes on a disconnected connection.
+ */
+#ifndef mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH
+    #define mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH    ( 0 )
+#endif
+
+/**
+ * @brief The largest topic length plus payload length of a stored publish.
+ */
+#ifndef mqttconfigOFFLINE_PUBLISH_MAX_BYTES
+    #define mqttconfigOFFLINE_PUBLISH_MAX_BYTES    ( 256 )
+#endif
+
+/**
+ * @brief The time between two stored publishes sent after a reconnect.
+ */
+#ifndef mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS
+    #define mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS    ( 100 )
+#endif
+
+/**
+ * @brief The time to wait for the PUBACK of a stored publish before sending it
+ * again.
+ */
+#ifndef mqttconfigOFFLINE_PUBLISH_ACK_TIMEOUT_MS
+    #define mqttconfigOFFLINE_PUBLISH_ACK_TIMEOUT_MS    ( 5000 )
+#endif
+
+/**
+ * @brief Hooks to keep the stored publishes in non-volatile memory.
+ *
+ * Each connection's stored publishes form a log, oldest first.
+ * mqttconfigOFFLINE_PUBLISH_APPEND() is called after a publish is added to the
+ * end of the log, and mqttconfigOFFLINE_PUBLISH_REMOVE() after the oldest one
+ * is acknowledged. When MQTT_AGENT_Create() returns a connection, the log is
+ * read back with mqttconfigOFFLINE_PUBLISH_LOAD() for uxIndex 0, 1 and so on
+ * until it evaluates to pdFALSE. It must copy xEntryLength bytes into pvEntry.
+ * Broker numbers are assigned in the order connections are created, so an
+ * application which creates its connections in the same order after a reset
+ * gets its logs back. By default nothing is persisted.
+ */
+#ifndef mqttconfigOFFLINE_PUBLISH_APPEND
+    #define mqttconfigOFFLINE_PUBLISH_APPEND( uxBrokerNumber, pvEntry, xEntryLength )
+#endif
+#ifndef mqttconfigOFFLINE_PUBLISH_REMOVE
+    #define mqttconfigOFFLINE_PUBLISH_REMOVE( uxBrokerNumber )
+#endif
+#ifndef mqttconfigOFFLINE_PUBLISH_LOAD
+    #define mqttconfigOFFLINE_PUBLISH_LOAD( uxBrokerNumber, uxIndex, pvEntry, xEntryLength )    ( pdFALSE )
+#endif
+
+/**
+ * @brief Adjusts the time until the next keep-alive or timeout check.
+ *
+ * It is applied to the delay returned by MQTT_Periodic() and may only make
+ * it longer, by less than the keep-alive slack of the broker. Commands and
+ * received data still wake the MQTT task at once. Set it to
+ * WIFI_WakeWindowAlign( xTicks ) to send keep-alives in the radio's wake
+ * windows, see aws_wifi_wake.h. By default the delay is not changed.
+ */
+#ifndef mqttconfigALIGN_DEFERRABLE_DELAY
+    #define mqttconfigALIGN_DEFERRABLE_DELAY( xTicks )    ( xTicks )
+#endif
+
+/**
+ * @brief The task notification index on which tasks calling the MQTT API wait
+ * for the MQTT task to complete their commands.
+ *
+ * Set it to an index below configTASK_NOTIFICATION_ARRAY_ENTRIES other than
+ * tskDEFAULT_INDEX_TO_NOTIFY so that the calling tasks can keep using their
+ * default notification for other purposes.
+ */
+#ifndef mqttconfigNOTIFICATION_INDEX
+    #define mqttconfigNOTIFICATION_INDEX    tskDEFAULT_INDEX_TO_NOTIFY
+#endif
+
 /**
  * @defgroup BufferPoolInterface The functions used by the MQTT client to get and return buffers.
  *
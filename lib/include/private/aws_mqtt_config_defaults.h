@@ -73,6 +73,160 @@
     #define mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS    ( 8 )
 #endif
 
+/**
+ * @brief Maximum number of topic levels in a topic filter which can be stored
+ * in subscription manager.
+ *
+ * A topic filter has one level more than it has '/' characters, so "a/+/#"
+ * has three levels. The subscribe operation will fail with
+ * eMQTTTopicFilterTooManyLevels if the user tries to subscribe to a topic
+ * filter with more levels than the maximum specified here. The default is
+ * the limit of AWS IoT, which allows at most seven '/' characters in a topic,
+ * unless mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LENGTH is too short to hold
+ * that many.
+ */
+#ifndef mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS
+    #if ( mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LENGTH < 7 )
+        #define mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS    ( mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LENGTH + 1 )
+    #else
+        #define mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS    ( 8 )
+    #endif
+#endif
+
+/**
+ * @brief Number of nodes in the topic filter trie of the subscription manager.
+ *
+ * If the user has enabled subscription management (by defining the macro
+ * mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT to 1), the subscribed topic filters
+ * are indexed in a trie with one node per distinct topic level prefix, plus
+ * one root node. Topic filters which share leading levels share nodes. The
+ * default is large enough for every subscription to have the maximum number
+ * of levels without sharing any. When set lower, the subscribe operation will
+ * fail with eMQTTSubscriptionManagerFull if there are not enough free nodes
+ * left to store the new topic filter.
+ */
+#ifndef mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES
+    #define mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES    ( ( mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS * mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS ) + 1 )
+#endif
+
+/**
+ * @brief Enable the local publish/subscribe bus of aws_local_bus.h.
+ *
+ * The bus keeps its own subscription manager, so it also requires
+ * subscription management.
+ */
+#ifndef mqttconfigENABLE_LOCAL_BUS
+    #define mqttconfigENABLE_LOCAL_BUS    ( 0 )
+#endif
+
+/**
+ * @brief Define mqttconfigENABLE_PERSISTENT_SESSION to 1 to allow connecting
+ * with the Clean Session flag cleared.
+ *
+ * The session state of a connection made with xCleanSession set to eMQTTFalse
+ * survives a disconnect: QoS1 publishes waiting for PUBACK stay in the Tx
+ * list until they time out, and the subscription manager is kept. When the
+ * next CONNACK is accepted, the stored publishes are sent again with the DUP
+ * flag set, and the subscription manager is only emptied if the broker
+ * reports that it has no session. The payload of these publishes is always
+ * copied into the Tx buffer, even if a gathered send callback is registered.
+ */
+#ifndef mqttconfigENABLE_PERSISTENT_SESSION
+    #define mqttconfigENABLE_PERSISTENT_SESSION    ( 0 )
+#endif
+
+/**
+ * @brief Define mqttconfigENABLE_QOS2 to 1 to allow publishing and subscribing
+ * with QoS2.
+ *
+ * An outgoing QoS2 publish keeps its Tx buffer, rewritten as a PUBREL after
+ * the PUBREC, until the PUBCOMP arrives. The packet identifiers of incoming
+ * QoS2 publishes are stored, two bytes each, from the PUBLISH until the
+ * PUBREL so that duplicates are not delivered again.
+ */
+#ifndef mqttconfigENABLE_QOS2
+    #define mqttconfigENABLE_QOS2    ( 0 )
+#endif
+
+/**
+ * @brief Maximum number of incoming QoS2 publishes waiting for their PUBREL.
+ *
+ * An incoming QoS2 publish which does not fit is dropped without a PUBREC, so
+ * the broker sends it again later.
+ */
+#ifndef mqttconfigQOS2_MAX_RECEIVED
+    #define mqttconfigQOS2_MAX_RECEIVED    ( 8 )
+#endif
+
+/**
+ * @brief Define mqttconfigENABLE_STREAMING_PUBLISH to 1 to receive publishes
+ * larger than any free buffer in chunks.
+ *
+ * When no buffer is large enough for an incoming QoS0 or QoS1 publish, the
+ * payload is passed to the generic callback as eMQTTPublishChunk events while
+ * it is being received, instead of dropping the message. Topic specific
+ * callbacks are not invoked for chunks.
+ */
+#ifndef mqttconfigENABLE_STREAMING_PUBLISH
+    #define mqttconfigENABLE_STREAMING_PUBLISH    ( 0 )
+#endif
+
+/**
+ * @brief Longest topic of a streamed publish.
+ *
+ * The topic is kept in the MQTT context while the payload is streamed. A
+ * publish with a longer topic is dropped.
+ */
+#ifndef mqttconfigSTREAMING_PUBLISH_MAX_TOPIC_LENGTH
+    #define mqttconfigSTREAMING_PUBLISH_MAX_TOPIC_LENGTH    ( 128 )
+#endif
+
+/**
+ * @brief Define mqttconfigENABLE_RX_FAST_PATH to 1 to process packets which
+ * are received whole in one step.
+ *
+ * When a packet starts at the beginning of the remaining data passed to
+ * MQTT_ParseReceivedData and all of it is present, its fixed header is decoded
+ * in one go and the packet is copied into the Rx buffer with a single memcpy.
+ * Packets split across calls are still assembled byte by byte.
+ */
+#ifndef mqttconfigENABLE_RX_FAST_PATH
+    #define mqttconfigENABLE_RX_FAST_PATH    ( 0 )
+#endif
+
+/**
+ * @brief Define mqttconfigENABLE_PREPARED_TOPICS to 1 to make the
+ * MQTT_PrepareTopic and MQTT_PublishPrepared APIs available.
+ *
+ * A prepared topic is validated and encoded once, and then copied as it is
+ * into every publish made with it.
+ */
+#ifndef mqttconfigENABLE_PREPARED_TOPICS
+    #define mqttconfigENABLE_PREPARED_TOPICS    ( 0 )
+#endif
+
+/**
+ * @brief Longest topic which can be prepared.
+ *
+ * Each MQTTPreparedTopic_t takes this many bytes plus four.
+ */
+#ifndef mqttconfigPREPARED_TOPIC_MAX_LENGTH
+    #define mqttconfigPREPARED_TOPIC_MAX_LENGTH    ( 128 )
+#endif
+
+/**
+ * @brief Define mqttconfigENABLE_MQTT5 to 1 to allow connecting with MQTT 5.0.
+ *
+ * The protocol version is then chosen per connection with the
+ * xProtocolVersion member of MQTTConnectParams_t. MQTT 5.0 packets are sent
+ * without properties. The properties received are checked and skipped,
+ * except for the Receive Maximum of the CONNACK, which limits the number of
+ * QoS1 and QoS2 publishes in flight. Reason codes are passed to the user.
+ */
+#ifndef mqttconfigENABLE_MQTT5
+    #define mqttconfigENABLE_MQTT5    ( 0 )
+#endif
+
 /**
  * @brief Define mqttconfigASSERT to enable asserts.
  *
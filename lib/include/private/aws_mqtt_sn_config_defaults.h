@@ -0,0 +1,98 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file aws_mqtt_sn_config_defaults.h
+ * @brief MQTT-SN client default config options.
+ *
+ * Ensures that the config options for the MQTT-SN client are set to sensible
+ * default values if the user does not provide one in aws_mqtt_config.h.
+ */
+
+#ifndef _AWS_MQTT_SN_CONFIG_DEFAULTS_H_
+#define _AWS_MQTT_SN_CONFIG_DEFAULTS_H_
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief The maximum number of MQTT-SN clients that can exist at once.
+ */
+#ifndef mqttsnconfigMAX_CLIENTS
+    #define mqttsnconfigMAX_CLIENTS    ( 1 )
+#endif
+
+/**
+ * @brief The size of the transmit buffer and of the receive buffer of each
+ * client.
+ *
+ * A publish with a payload longer than this, less 7 bytes, can not be sent.
+ * Received datagrams must fit as well, so the gateway should be configured with
+ * the same limit.
+ */
+#ifndef mqttsnconfigMAX_PACKET_SIZE
+    #define mqttsnconfigMAX_PACKET_SIZE    ( 256 )
+#endif
+
+/**
+ * @brief The number of topics each client remembers.
+ *
+ * An entry is used by every predefined topic, every registered topic name,
+ * every subscription and every topic that the gateway registers with the
+ * client. Two character topic names do not need one.
+ */
+#ifndef mqttsnconfigMAX_TOPICS
+    #define mqttsnconfigMAX_TOPICS    ( 8 )
+#endif
+
+/**
+ * @brief The longest topic name or topic filter that can be stored.
+ */
+#ifndef mqttsnconfigMAX_TOPIC_LENGTH
+    #define mqttsnconfigMAX_TOPIC_LENGTH    ( 64 )
+#endif
+
+/**
+ * @brief The time to wait for a reply before a message is sent again.
+ *
+ * The MQTT-SN specification calls this T_retry and suggests 10 to 15
+ * seconds. The timeout passed to an API call is never exceeded.
+ */
+#ifndef mqttsnconfigRETRY_TICKS
+    #define mqttsnconfigRETRY_TICKS    ( pdMS_TO_TICKS( 10000 ) )
+#endif
+
+/**
+ * @brief The number of times a message is sent again when no reply comes.
+ *
+ * The MQTT-SN specification calls this N_retry and suggests 3 to 5.
+ */
+#ifndef mqttsnconfigMAX_RETRIES
+    #define mqttsnconfigMAX_RETRIES    ( 3 )
+#endif
+
+#endif /* _AWS_MQTT_SN_CONFIG_DEFAULTS_H_ */
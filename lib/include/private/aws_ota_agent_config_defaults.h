@@ -0,0 +1,406 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file aws_ota_agent_config_defaults.h
+ * @brief OTA agent default config options.
+ *
+ * Ensures that the config options for the OTA agent are set to
+ * sensible default values if the user does not provide one.
+ */
+#ifndef _AWS_OTA_AGENT_CONFIG_DEFAULTS_H_
+#define _AWS_OTA_AGENT_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief Hash the received file while its blocks are being ingested.
+ *
+ * When set to 1, the OTA agent starts an ECDSA-SHA256 signature verification
+ * context when the receive file is created and feeds it every block of the
+ * contiguous received prefix of the file as it grows. Blocks that arrive ahead
+ * of a gap are read back through prvPAL_ReadBlock() once the gap is filled.
+ * The PAL then only has to finalize the verification when the file is closed
+ * instead of reading the whole image back from storage.
+ *
+ * Set to 0 to leave the whole file signature check to the PAL.
+ */
+#ifndef otaconfigSTREAM_SIGNATURE_VERIFY
+    #define otaconfigSTREAM_SIGNATURE_VERIFY    ( 0 )
+#endif
+
+/**
+ * @brief Number of entries in the queue that passes MQTT messages to the OTA task.
+ *
+ * Stream data blocks that arrive while the queue is full are dropped and counted
+ * by OTA_GetPacketsDropped().
+ */
+#ifndef otaconfigMSG_QUEUE_LENGTH
+    #define otaconfigMSG_QUEUE_LENGTH    ( 6U )
+#endif
+
+/**
+ * @brief Maximum number of file blocks kept in flight by pipelined stream requests.
+ *
+ * When set to 0, every stream request asks for all blocks that are still missing
+ * and the next request is only sent when otaconfigFILE_REQUEST_WAIT_MS passes
+ * without a block arriving.
+ *
+ * When greater than 0, each request only asks for the next missing blocks that
+ * fit in the current window, and a new request is sent as soon as half of the
+ * window has arrived. The window starts at otaconfigMSG_QUEUE_LENGTH blocks
+ * (bounded by this value), grows by one block for every window delivered without
+ * dropped packets and halves when packets are dropped or blocks are lost. The
+ * request timeout follows four times the smoothed time from a request to its first
+ * block, bounded by otaconfigFILE_REQUEST_WAIT_MS. Lost blocks are requested again
+ * when the request cursor wraps around the file.
+ */
+#ifndef otaconfigMAX_BLOCKS_IN_FLIGHT
+    #define otaconfigMAX_BLOCKS_IN_FLIGHT    ( 0U )
+#endif
+
+/**
+ * @brief Largest number of file blocks requested per second.
+ *
+ * When greater than 0, stream requests draw on a token bucket that fills at this
+ * rate and holds up to otaconfigMAX_BLOCKS_IN_FLIGHT blocks, so the download
+ * leaves the rest of the MQTT connection to the application. When the bucket is
+ * empty the next request waits for it to refill. Requires
+ * otaconfigMAX_BLOCKS_IN_FLIGHT to be greater than 0.
+ *
+ * Set to 0 to request blocks as fast as the request window allows.
+ */
+#ifndef otaconfigMAX_BLOCKS_PER_SECOND
+    #define otaconfigMAX_BLOCKS_PER_SECOND    ( 0U )
+#endif
+
+/**
+ * @brief MQTT latency, in milliseconds, above which the block rate is lowered.
+ *
+ * When greater than 0, the agent reads the MQTT agent statistics (see
+ * MQTT_AGENT_GetStatistics()) every time half of the request window arrives. If
+ * any command waited in the MQTT command queue or any QoS1 publish waited for its
+ * PUBACK for this long since the last check, the block rate is halved. Otherwise it
+ * grows by one block per second, up to otaconfigMAX_BLOCKS_PER_SECOND. Requires
+ * otaconfigMAX_BLOCKS_PER_SECOND to be greater than 0 and mqttconfigENABLE_STATISTICS
+ * to be 1 for the MQTT agent, without which the rate stays fixed.
+ *
+ * Set to 0 to keep the block rate fixed.
+ */
+#ifndef otaconfigBACKOFF_MQTT_LATENCY_MS
+    #define otaconfigBACKOFF_MQTT_LATENCY_MS    ( 0U )
+#endif
+
+/**
+ * @brief Priority of the OTA task while a file is being received.
+ *
+ * Set it below otaconfigAGENT_PRIORITY to decode and write blocks only when the
+ * application tasks leave the CPU idle. The task returns to otaconfigAGENT_PRIORITY
+ * once the file is closed. Requires INCLUDE_vTaskPrioritySet to be 1.
+ */
+#ifndef otaconfigINGEST_PRIORITY
+    #define otaconfigINGEST_PRIORITY    ( otaconfigAGENT_PRIORITY )
+#endif
+
+/**
+ * @brief Accept delta updates.
+ *
+ * When set to 1, a job file with the OTA_FILE_ATTRIB_DELTA attribute is treated
+ * as a patch against the running image (see aws_ota_delta.h). Its blocks are
+ * applied in order as they arrive, reading the running image through
+ * prvPAL_ReadActiveImage() and writing the rebuilt image through
+ * prvPAL_WriteBlock(), so only the patch is downloaded. The job signature covers
+ * the rebuilt image and is checked by the PAL as for a full image. Patch blocks
+ * that arrive out of order are requested again.
+ *
+ * Set to 0 to reject delta update jobs.
+ */
+#ifndef otaconfigENABLE_DELTA_UPDATE
+    #define otaconfigENABLE_DELTA_UPDATE    ( 0 )
+#endif
+
+/**
+ * @brief Accept compressed updates.
+ *
+ * When set to 1, a job file with the OTA_FILE_ATTRIB_COMPRESSED attribute is
+ * decompressed as its blocks arrive, in order, and the image is written through
+ * prvPAL_WriteBlock() at its decompressed offsets (see aws_ota_decompress.h).
+ * A file that is also a delta update is a compressed patch. The job signature
+ * covers the decompressed image.
+ *
+ * Set to 0 to reject compressed update jobs.
+ */
+#ifndef otaconfigENABLE_COMPRESSED_UPDATE
+    #define otaconfigENABLE_COMPRESSED_UPDATE    ( 0 )
+#endif
+
+/**
+ * @brief Largest decompression window, in bits, of a compressed update.
+ *
+ * The decompressor allocates 2 ^ otaconfigDECOMPRESS_WINDOW_BITS bytes of window
+ * next to one file block of staging buffer. Files compressed with a larger window
+ * are rejected. Must be between 4 and 15.
+ */
+#ifndef otaconfigDECOMPRESS_WINDOW_BITS
+    #define otaconfigDECOMPRESS_WINDOW_BITS    ( 10U )
+#endif
+
+/**
+ * @brief Number of staging buffers of the file write-behind stage.
+ *
+ * When greater than 0, received file blocks are copied to staging buffers and
+ * written to the receive file by a writer task of their own, so the OTA task goes
+ * on receiving stream messages while the flash is erased and programmed. Adjacent
+ * blocks are collected in a buffer until it reaches an otaconfigWRITE_BUFFER_SIZE
+ * aligned end. The OTA task waits for a free buffer when all of them are being
+ * written. Use 2 or more for receiving and writing to overlap. The writer task
+ * uses otaconfigSTACK_SIZE and otaconfigAGENT_PRIORITY.
+ *
+ * Set to 0 to write every block on the OTA task as it is received.
+ */
+#ifndef otaconfigWRITE_BUFFER_COUNT
+    #define otaconfigWRITE_BUFFER_COUNT    ( 0U )
+#endif
+
+/**
+ * @brief Size of each staging buffer of the file write-behind stage.
+ *
+ * Must be a multiple of the file block size and at most 16 KB. Set it to the flash
+ * sector size for every write to cover whole sectors.
+ */
+#ifndef otaconfigWRITE_BUFFER_SIZE
+    #define otaconfigWRITE_BUFFER_SIZE    OTA_FILE_BLOCK_SIZE
+#endif
+
+/**
+ * @brief Hand stream blocks to the file write path inside the received message.
+ *
+ * When set to 1, the block payload of a stream message is not copied out of the
+ * message into a buffer of its own: the write path, or the write-behind stage,
+ * reads it straight from the MQTT buffer. The PAL must then not modify the data it
+ * is given to write.
+ *
+ * Set to 0 to copy each block payload out of the message before writing it.
+ */
+#ifndef otaconfigDECODE_BLOCK_IN_PLACE
+    #define otaconfigDECODE_BLOCK_IN_PLACE    ( 0 )
+#endif
+
+/**
+ * @brief Receive file data over HTTP when the job document gives a URL for it.
+ *
+ * When set to 1, a job file with an "update_data_url" member, typically a pre-signed
+ * URL, is received with HTTP/1.1 range requests over Secure Sockets instead of the
+ * MQTT data stream (see aws_ota_http.h). The ranges feed the same block bitmap and
+ * file write path, and the connection is kept open between them. The "streamname"
+ * member becomes optional for such a file.
+ *
+ * Set to 0 to receive all file data over the MQTT data stream.
+ */
+#ifndef otaconfigENABLE_HTTP_DATA_PLANE
+    #define otaconfigENABLE_HTTP_DATA_PLANE    ( 0 )
+#endif
+
+/**
+ * @brief Number of file blocks fetched by each HTTP range request.
+ */
+#ifndef otaconfigHTTP_BLOCKS_PER_REQUEST
+    #define otaconfigHTTP_BLOCKS_PER_REQUEST    ( 16U )
+#endif
+
+/**
+ * @brief Size of the buffer of the HTTP data plane.
+ *
+ * It holds the response headers and then one file block at a time, so it must be
+ * larger than the file block size. Pre-signed URL responses carry about 1 KB of
+ * headers.
+ */
+#ifndef otaconfigHTTP_BUFFER_SIZE
+    #define otaconfigHTTP_BUFFER_SIZE    ( OTA_FILE_BLOCK_SIZE + 1024U )
+#endif
+
+/**
+ * @brief Send and receive timeout of the HTTP data plane socket, in milliseconds.
+ */
+#ifndef otaconfigHTTP_TIMEOUT_MS
+    #define otaconfigHTTP_TIMEOUT_MS    ( 10000U )
+#endif
+
+/**
+ * @brief PEM certificate trusted for the HTTP data plane server.
+ *
+ * Set to a null terminated PEM string when the server certificate does not chain
+ * to the default Secure Sockets trust. NULL uses the default.
+ */
+#ifndef otaconfigHTTP_SERVER_CERTIFICATE
+    #define otaconfigHTTP_SERVER_CERTIFICATE    NULL
+#endif
+
+/**
+ * @brief Fetch stream files from a cache on the local Greengrass core first.
+ *
+ * When set to 1, which needs otaconfigENABLE_HTTP_DATA_PLANE, the agent looks up the
+ * Greengrass core of the device with GGD_GetGGCIPandCertificate() before receiving a file
+ * that has a data stream and no URL. The file is then fetched with range requests from
+ * https://<core>:<otaconfigGREENGRASS_CACHE_PORT>/<otaconfigGREENGRASS_CACHE_PATH>/<stream>/<file ID>,
+ * trusting the group CA of the core. A site service on the core is expected to fill the
+ * cache from the cloud, so a fleet behind one gateway downloads each image once. The blocks
+ * go through the same bitmap, signature check and PAL as stream blocks. When no core is
+ * found, the cache does not have the file, or too many range requests in a row fail, the
+ * rest of the file is received over the data stream.
+ *
+ * Set to 0 to receive stream files from the cloud only.
+ */
+#ifndef otaconfigENABLE_GREENGRASS_CACHE
+    #define otaconfigENABLE_GREENGRASS_CACHE    ( 0 )
+#endif
+
+/**
+ * @brief Port of the file cache on the Greengrass core.
+ */
+#ifndef otaconfigGREENGRASS_CACHE_PORT
+    #define otaconfigGREENGRASS_CACHE_PORT    ( 8443U )
+#endif
+
+/**
+ * @brief Path of the file cache on the Greengrass core, without slashes.
+ */
+#ifndef otaconfigGREENGRASS_CACHE_PATH
+    #define otaconfigGREENGRASS_CACHE_PATH    "ota"
+#endif
+
+/**
+ * @brief Size of the buffer for the Greengrass discovery document.
+ *
+ * It is allocated when a file starts, and holds the certificate of the core until the
+ * file is done with.
+ */
+#ifndef otaconfigGREENGRASS_DISCOVERY_BUFFER_SIZE
+    #define otaconfigGREENGRASS_DISCOVERY_BUFFER_SIZE    ( 4096U )
+#endif
+
+/**
+ * @brief Resume interrupted file transfers after a reset.
+ *
+ * When set to 1, the agent saves a checkpoint of the block bitmap of the file being
+ * received through prvPAL_SaveCheckpoint() every otaconfigCHECKPOINT_BLOCKS blocks and
+ * when it is shut down. When the same job and file are received again after a reset,
+ * the file is reopened with prvPAL_ResumeFileForRx() and only the missing blocks are
+ * requested. Delta and compressed files are decoded in one pass and always start over.
+ *
+ * Set to 0 to start every transfer from the first block.
+ */
+#ifndef otaconfigENABLE_RESUME
+    #define otaconfigENABLE_RESUME    ( 0 )
+#endif
+
+/**
+ * @brief Number of received blocks between two checkpoints of a resumable transfer.
+ *
+ * At most this many blocks are received again after a reset. Each checkpoint flushes
+ * the staged blocks and writes about 200 bytes to the checkpoint storage of the PAL.
+ */
+#ifndef otaconfigCHECKPOINT_BLOCKS
+    #define otaconfigCHECKPOINT_BLOCKS    ( 32U )
+#endif
+
+/**
+ * @brief Maximum number of files of one OTA job.
+ *
+ * The files of a job are received one after the other within the job, so the job is
+ * accepted, reported and completed once for all of them. Each file has its own file
+ * context, which the PAL routes to its target by the file path and attributes, and
+ * each file is authenticated when it is closed. The job completes, and a new image
+ * is activated, after the last file.
+ *
+ * Each file costs a file context and its job document strings from the time the job
+ * is accepted. Jobs with more files are rejected.
+ */
+#ifndef otaconfigMAX_FILES_PER_JOB
+    #define otaconfigMAX_FILES_PER_JOB    ( 1U )
+#endif
+
+/**
+ * @brief Collect timing and throughput statistics of file transfers.
+ *
+ * When set to 1, the agent times the wait for data after a request, the decode of
+ * stream messages, the file writes, the file close with its signature check and the
+ * image activation, and tracks the receive rate and the retransmissions. They are
+ * returned by OTA_GetTransferStats() and the rates and retransmissions are added to
+ * the periodic "receive" job status update.
+ *
+ * Set to 0 to leave them out. OTA_GetTransferStats() then returns zeros.
+ */
+#ifndef otaconfigENABLE_TRANSFER_STATS
+    #define otaconfigENABLE_TRANSFER_STATS    ( 0 )
+#endif
+
+/**
+ * @brief Timestamp source of the transfer statistics.
+ *
+ * The RTOS tick is too coarse to time a single block decode or write. Map this to a
+ * free running counter, such as the one used for the kernel run time statistics, to
+ * time them precisely. otaconfigSTATS_TIMESTAMP_HZ must give its frequency.
+ */
+#ifndef otaconfigSTATS_TIMESTAMP
+    #define otaconfigSTATS_TIMESTAMP()    ( ( uint32_t ) xTaskGetTickCount() )
+#endif
+
+/**
+ * @brief Frequency of otaconfigSTATS_TIMESTAMP(), in Hz.
+ */
+#ifndef otaconfigSTATS_TIMESTAMP_HZ
+    #define otaconfigSTATS_TIMESTAMP_HZ    ( ( uint32_t ) configTICK_RATE_HZ )
+#endif
+
+/**
+ * @brief Trace hooks called with the events the OTA agent task wakes up for,
+ * and when it starts and finishes processing a received message.
+ *
+ * Empty by default. aws_trace_ring_hooks.h maps them to the trace ring.
+ */
+#ifndef otaconfigTRACE_EVENTS
+    #define otaconfigTRACE_EVENTS( xBits )
+#endif
+
+#ifndef otaconfigTRACE_MESSAGE_RECEIVED
+    #define otaconfigTRACE_MESSAGE_RECEIVED( eMsgType, ulDataLength )
+#endif
+
+#ifndef otaconfigTRACE_MESSAGE_PROCESSED
+    #define otaconfigTRACE_MESSAGE_PROCESSED( eMsgType )
+#endif
+
+/**
+ * @brief Time in milliseconds by which the file request timer may expire late,
+ * so its expiry can be coalesced with other wake ups.
+ *
+ * Only used when configUSE_TIMER_SLACK is 1. The default of 0 keeps the
+ * request timer exact.
+ */
+#ifndef otaconfigREQUEST_TIMER_SLACK_MS
+    #define otaconfigREQUEST_TIMER_SLACK_MS    ( 0U )
+#endif
+
+#endif /* ifndef _AWS_OTA_AGENT_CONFIG_DEFAULTS_H_ */
@@ -54,6 +54,7 @@ typedef enum
     eIngest_Result_Uninitialized = -127,    /* Software BUG: We forgot to set the result code. */
     eIngest_Result_Accepted_Continue = 0,   /* The block was accepted and we're expecting more. */
     eIngest_Result_Duplicate_Continue = 1,  /* The block was a duplicate but that's OK. Continue. */
+    eIngest_Result_Ignored_Continue = 2,    /* The block is ahead of the tracked part of the file. It is requested again later. Continue. */
 } IngestResult_t;
 
 /* Generic JSON document parser errors. */
@@ -121,6 +122,12 @@ typedef struct
 } JSON_DocParam_t;
 
 
+/* Number of slots in the key lookup table of a document model. It must be a power of
+ * two and at least twice the maximum number of model parameters (32) so that the open
+ * addressing probe sequences stay short. */
+#define OTA_DOC_MODEL_KEY_TABLE_SIZE    64U
+
+
 /* The document model is currently limited to 32 parameters per the implementation,
  * although it may be easily expanded to more in the future by simply expanding
  * the parameter bitmap.
@@ -138,6 +145,9 @@ typedef struct
     uint16_t usNumModelParams;         /* The number of entries in the document model (limited to 32). */
     uint32_t ulParamsReceivedBitmap;   /* Bitmap of the parameters received based on the model. */
     uint32_t ulParamsRequiredBitmap;   /* Bitmap of the parameters required from the model. */
+    uint16_t usArrayElement;           /* Keys within array parameters are only extracted from this element. */
+    uint16_t usArrayElements;          /* The number of elements of the last array parameter found. */
+    uint8_t ucKeyTable[ OTA_DOC_MODEL_KEY_TABLE_SIZE ]; /* Hash table of the model keys. Each slot holds a parameter index plus 1, or 0 if empty. */
 } JSON_DocModel_t;
 
 #endif /* ifndef _AWS_OTA_AGENT_INTERAL_H_ */
@@ -37,6 +37,22 @@ BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageB
                                                      uint8_t ** ppucPayload,
                                                      size_t * pxPayloadSize );
 
+/**
+ * @brief Decode a Get Stream response message from AWS IoT OTA, giving the
+ * payload in place.
+ *
+ * Same as OTA_CBOR_Decode_GetStreamResponseMessage(), except that
+ * *ppucPayload points to the block data inside pucMessageBuffer instead of a
+ * copy, so it must not be freed and is only valid as long as the message.
+ */
+BaseType_t OTA_CBOR_Decode_GetStreamResponseMessageInPlace( const uint8_t * pucMessageBuffer,
+                                                            size_t xMessageSize,
+                                                            int32_t * plFileId,
+                                                            int32_t * plBlockId,
+                                                            int32_t * plBlockSize,
+                                                            const uint8_t ** ppucPayload,
+                                                            size_t * pxPayloadSize );
+
 /**
  * @brief Create an encoded Get Stream Request message for the AWS IoT OTA
  * service.
@@ -0,0 +1,131 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_decompress.h
+ * @brief Streaming decompressor for compressed OTA updates.
+ *
+ * A compressed file starts with a header, all integers being little endian:
+ *
+ *   "OTAZ" <32 bit output size> <window bits> <lookahead bits>
+ *
+ * followed by a heatshrink (LZSS) bit stream produced with the same window and
+ * lookahead sizes. Decompression only needs a window of 2 ^ window bits bytes,
+ * which bounds RAM no matter how large the image is. The stream has to be fed in
+ * order but may be split anywhere. The output is written in order, in writes of
+ * the staging buffer size except for the last one.
+ */
+
+#ifndef _AWS_OTA_DECOMPRESS_H_
+#define _AWS_OTA_DECOMPRESS_H_
+
+#include <stdint.h>
+
+#define OTA_DECOMPRESS_HEADER_SIZE          10U /*!< Magic, output size, window and lookahead bits. */
+#define OTA_DECOMPRESS_MIN_WINDOW_BITS      4U  /*!< Smallest window heatshrink supports. */
+#define OTA_DECOMPRESS_MAX_WINDOW_BITS      15U /*!< Largest window heatshrink supports. */
+#define OTA_DECOMPRESS_MIN_LOOKAHEAD_BITS   3U  /*!< Smallest lookahead heatshrink supports. */
+
+/**
+ * @brief Result of feeding compressed bytes to the decompressor.
+ */
+typedef enum
+{
+    eOTA_Decompress_Continue = 0,     /*!< The input was consumed and more is expected. */
+    eOTA_Decompress_Complete = 1,     /*!< The whole output has been written. */
+    eOTA_Decompress_BadStream = -1,   /*!< The stream is malformed or needs a larger window than available. */
+    eOTA_Decompress_WriteFailed = -2, /*!< Writing the output failed. */
+} OTA_DecompressResult_t;
+
+/**
+ * @brief Write output bytes. Returns the number of bytes written or a negative error code.
+ */
+typedef int32_t ( * OTA_DecompressWrite_t )( void * pvContext,
+                                             uint32_t ulOffset,
+                                             uint8_t * pucData,
+                                             uint32_t ulLength );
+
+/**
+ * @brief State of a stream being decompressed. Treat as opaque.
+ */
+typedef struct
+{
+    OTA_DecompressWrite_t xWrite; /*!< Output writer. */
+    void * pvContext;             /*!< Passed to xWrite. */
+    uint8_t * pucWindow;          /*!< The last output bytes, referenced by back references. */
+    uint8_t * pucBuffer;          /*!< Staging buffer of the output. */
+    uint32_t ulBufferSize;        /*!< Size of pucBuffer, also the size of every write but the last. */
+    uint32_t ulBuffered;          /*!< Output bytes staged in pucBuffer. */
+    uint32_t ulOutputSize;        /*!< Output size from the stream header. */
+    uint32_t ulOutputOffset;      /*!< Output bytes produced so far, staged or written. */
+    uint32_t ulBits;              /*!< Input bits not consumed yet, in the low ucBitCount bits. */
+    uint16_t usBackrefOffset;     /*!< Distance back into the window of the current back reference. */
+    uint16_t usBackrefCount;      /*!< Bytes left to copy for the current back reference. */
+    uint8_t ucHeader[ OTA_DECOMPRESS_HEADER_SIZE ]; /*!< Header being collected. */
+    uint8_t ucHeaderLength;       /*!< Bytes collected in ucHeader. */
+    uint8_t ucMaxWindowBits;      /*!< log2 of the size of pucWindow. */
+    uint8_t ucWindowBits;         /*!< Window bits from the stream header. */
+    uint8_t ucLookaheadBits;      /*!< Lookahead bits from the stream header. */
+    uint8_t ucBitCount;           /*!< Number of valid bits in ulBits. */
+    uint8_t ucState;              /*!< Decoder state. */
+} OTA_DecompressContext_t;
+
+/**
+ * @brief Prepare a context for decompressing a new stream.
+ *
+ * @param[out] pxDecompress The context to initialize.
+ * @param[in] pucWindow Window buffer of 2 ^ ucMaxWindowBits bytes.
+ * @param[in] ucMaxWindowBits Largest window, in bits, a stream may use.
+ * @param[in] pucBuffer Staging buffer for the output.
+ * @param[in] ulBufferSize Size of pucBuffer.
+ * @param[in] xWrite Output writer.
+ * @param[in] pvContext Passed to xWrite.
+ */
+void OTA_Decompress_Init( OTA_DecompressContext_t * pxDecompress,
+                          uint8_t * pucWindow,
+                          uint8_t ucMaxWindowBits,
+                          uint8_t * pucBuffer,
+                          uint32_t ulBufferSize,
+                          OTA_DecompressWrite_t xWrite,
+                          void * pvContext );
+
+/**
+ * @brief Decompress the next bytes of a stream.
+ *
+ * @param[in] pxDecompress The stream context.
+ * @param[in] pucInput Stream bytes following those passed in the previous call.
+ * @param[in] ulLength Number of bytes in pucInput.
+ *
+ * @return eOTA_Decompress_Complete once the output has been written in full,
+ * eOTA_Decompress_Continue if more input is needed, a negative
+ * OTA_DecompressResult_t otherwise. Input bytes past the end of the output are
+ * an error, and so is a stream that ends while eOTA_Decompress_Continue is
+ * returned.
+ */
+OTA_DecompressResult_t OTA_Decompress_Apply( OTA_DecompressContext_t * pxDecompress,
+                                             const uint8_t * pucInput,
+                                             uint32_t ulLength );
+
+#endif /* ifndef _AWS_OTA_DECOMPRESS_H_ */
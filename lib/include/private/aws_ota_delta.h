@@ -0,0 +1,138 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_delta.h
+ * @brief Streaming patch applier for delta OTA updates.
+ *
+ * A delta patch rebuilds the new image from the image currently running on the
+ * device. It starts with a header and continues with a sequence of records,
+ * all integers being 32 bit little endian:
+ *
+ *   header: "OTAD" <target size>
+ *   copy:   0x01 <source offset> <length>            target = source
+ *   add:    0x02 <source offset> <length> <bytes>    target = source + bytes, byte wise modulo 256
+ *   insert: 0x03 <length> <bytes>                    target = bytes
+ *
+ * The add and insert records are what a bsdiff control triple turns into, so
+ * bsdiff style patches convert to this format without loss. The patch has to be
+ * fed in order but may be split anywhere. The target is written in order, in
+ * writes of the staging buffer size except for the last one.
+ */
+
+#ifndef _AWS_OTA_DELTA_H_
+#define _AWS_OTA_DELTA_H_
+
+#include <stdint.h>
+
+#define OTA_DELTA_HEADER_SIZE    8U  /*!< Magic and target size. */
+#define OTA_DELTA_OP_COPY        1U  /*!< Copy bytes of the source. */
+#define OTA_DELTA_OP_ADD         2U  /*!< Add patch bytes to bytes of the source. */
+#define OTA_DELTA_OP_INSERT      3U  /*!< Insert patch bytes. */
+
+/**
+ * @brief Result of feeding patch bytes to the applier.
+ */
+typedef enum
+{
+    eOTA_Delta_Continue = 0,     /*!< The patch was consumed and more is expected. */
+    eOTA_Delta_Complete = 1,     /*!< The whole target has been written. */
+    eOTA_Delta_BadPatch = -1,    /*!< The patch is malformed or does not match its header. */
+    eOTA_Delta_ReadFailed = -2,  /*!< Reading the source image failed. */
+    eOTA_Delta_WriteFailed = -3, /*!< Writing the target image failed. */
+} OTA_DeltaResult_t;
+
+/**
+ * @brief Read source image bytes. Returns the number of bytes read or a negative error code.
+ */
+typedef int32_t ( * OTA_DeltaRead_t )( void * pvContext,
+                                       uint32_t ulOffset,
+                                       uint8_t * pucData,
+                                       uint32_t ulLength );
+
+/**
+ * @brief Write target image bytes. Returns the number of bytes written or a negative error code.
+ */
+typedef int32_t ( * OTA_DeltaWrite_t )( void * pvContext,
+                                        uint32_t ulOffset,
+                                        uint8_t * pucData,
+                                        uint32_t ulLength );
+
+/**
+ * @brief State of a patch being applied. Treat as opaque.
+ */
+typedef struct
+{
+    OTA_DeltaRead_t xRead;    /*!< Source image reader. */
+    OTA_DeltaWrite_t xWrite;  /*!< Target image writer. */
+    void * pvContext;         /*!< Passed to xRead and xWrite. */
+    uint8_t * pucBuffer;      /*!< Staging buffer of the target. */
+    uint32_t ulBufferSize;    /*!< Size of pucBuffer, also the size of every target write but the last. */
+    uint32_t ulBuffered;      /*!< Target bytes staged in pucBuffer. */
+    uint32_t ulTargetSize;    /*!< Target size from the patch header. */
+    uint32_t ulTargetOffset;  /*!< Target bytes produced so far, staged or written. */
+    uint32_t ulSourceOffset;  /*!< Source offset of the current copy or add record. */
+    uint32_t ulRemaining;     /*!< Target bytes left in the current record. */
+    uint8_t ucRecord[ 9 ];    /*!< Header or record being collected. */
+    uint8_t ucRecordLength;   /*!< Bytes collected in ucRecord. */
+    uint8_t ucOp;             /*!< Current record type, 0 while collecting a header or record. */
+    uint8_t ucHeaderDone;     /*!< Non zero once the patch header was parsed. */
+} OTA_DeltaContext_t;
+
+/**
+ * @brief Prepare a context for applying a new patch.
+ *
+ * @param[out] pxDelta The context to initialize.
+ * @param[in] pucBuffer Staging buffer for the target image.
+ * @param[in] ulBufferSize Size of pucBuffer.
+ * @param[in] xRead Source image reader.
+ * @param[in] xWrite Target image writer.
+ * @param[in] pvContext Passed to xRead and xWrite.
+ */
+void OTA_Delta_Init( OTA_DeltaContext_t * pxDelta,
+                     uint8_t * pucBuffer,
+                     uint32_t ulBufferSize,
+                     OTA_DeltaRead_t xRead,
+                     OTA_DeltaWrite_t xWrite,
+                     void * pvContext );
+
+/**
+ * @brief Apply the next bytes of a patch.
+ *
+ * @param[in] pxDelta The patch context.
+ * @param[in] pucPatch Patch bytes following those passed in the previous call.
+ * @param[in] ulLength Number of bytes in pucPatch.
+ *
+ * @return eOTA_Delta_Complete once the target has been written in full,
+ * eOTA_Delta_Continue if more patch bytes are needed, a negative
+ * OTA_DeltaResult_t otherwise. Patch bytes past the end of the target are an
+ * error, and so is a patch that ends while eOTA_Delta_Continue is returned.
+ * Passing no bytes returns whether the target is complete.
+ */
+OTA_DeltaResult_t OTA_Delta_Apply( OTA_DeltaContext_t * pxDelta,
+                                   const uint8_t * pucPatch,
+                                   uint32_t ulLength );
+
+#endif /* ifndef _AWS_OTA_DELTA_H_ */
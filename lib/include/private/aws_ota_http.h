@@ -0,0 +1,127 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_http.h
+ * @brief HTTP/1.1 range request client for the OTA file data plane.
+ *
+ * Fetches byte ranges of a file, typically through a pre-signed URL taken from
+ * the OTA job document, over Secure Sockets. The connection is kept open between
+ * requests to the same host and opened again once if the server dropped it. The
+ * body of each range is handed out in blocks of the requested block size, the last
+ * block of the range possibly being shorter.
+ *
+ * Only absolute "https://" and "http://" URLs with a host name or IPv4 address
+ * are supported. Chunked transfer encoding is not, the server has to send the
+ * length of the range it returns.
+ */
+
+#ifndef _AWS_OTA_HTTP_H_
+#define _AWS_OTA_HTTP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "aws_secure_sockets.h"
+
+/**
+ * @brief Result of an HTTP range request.
+ */
+typedef enum
+{
+    eOTA_HTTP_Success = 0,        /*!< The whole range was received and handed out. */
+    eOTA_HTTP_BadURL = -1,        /*!< The URL could not be parsed or its host name is too long. */
+    eOTA_HTTP_ConnectFailed = -2, /*!< The socket could not be created, configured or connected. */
+    eOTA_HTTP_SendFailed = -3,    /*!< Sending the request failed. */
+    eOTA_HTTP_RecvFailed = -4,    /*!< Receiving the response failed or timed out. */
+    eOTA_HTTP_BadResponse = -5,   /*!< The response is not the requested range or its headers do not fit the buffer. */
+    eOTA_HTTP_Stopped = -6,       /*!< The block callback asked to stop before the end of the range. */
+} OTA_HTTP_Result_t;
+
+/**
+ * @brief Take a block of the range at byte offset ulOffset of the file.
+ *
+ * @return true to go on receiving the range, false to stop.
+ */
+typedef bool ( * OTA_HTTP_Block_t )( void * pvContext,
+                                     uint32_t ulOffset,
+                                     uint8_t * pucData,
+                                     uint32_t ulLength );
+
+/**
+ * @brief A persistent HTTP connection. Treat as opaque.
+ */
+typedef struct
+{
+    Socket_t xSocket;                                        /*!< Connected socket, or SOCKETS_INVALID_SOCKET. */
+    char cHost[ securesocketsMAX_DNS_NAME_LENGTH + 1 ];      /*!< Host the socket is connected to. */
+    uint16_t usPort;                                         /*!< Port the socket is connected to. */
+    bool xSecure;                                            /*!< True if the socket uses TLS. */
+    const char * pcCertificate;                              /*!< PEM server certificate to trust, or NULL for the default. */
+    uint8_t * pucBuffer;                                     /*!< Request, response header and block buffer. */
+    uint32_t ulBufferSize;                                   /*!< Size of pucBuffer. */
+    TickType_t xTimeout;                                     /*!< Send and receive timeout of the socket. */
+} OTA_HTTP_Connection_t;
+
+/**
+ * @brief Set up a connection. Nothing is connected until the first request.
+ *
+ * @param[in] pxConnection The connection.
+ * @param[in] pucBuffer Buffer used for the request, the response headers and the
+ * blocks. It must be larger than the block size and hold the response headers.
+ * @param[in] ulBufferSize Size of pucBuffer.
+ * @param[in] pcCertificate Null terminated PEM certificate of the server to trust,
+ * or NULL to use the default trust of Secure Sockets.
+ * @param[in] ulTimeoutMs Send and receive timeout in milliseconds.
+ */
+void OTA_HTTP_Init( OTA_HTTP_Connection_t * pxConnection,
+                    uint8_t * pucBuffer,
+                    uint32_t ulBufferSize,
+                    const char * pcCertificate,
+                    uint32_t ulTimeoutMs );
+
+/**
+ * @brief Fetch ulLength bytes at offset ulOffset of the file at pcURL.
+ *
+ * The connection is reused if it is open to the host of pcURL. xBlock is called for
+ * every ulBlockSize bytes of the range, in order.
+ *
+ * @return eOTA_HTTP_Success if the whole range was handed out, else the failure.
+ * The connection is closed on any failure, the rest of the range being unread.
+ */
+OTA_HTTP_Result_t OTA_HTTP_GetRange( OTA_HTTP_Connection_t * pxConnection,
+                                     const char * pcURL,
+                                     uint32_t ulOffset,
+                                     uint32_t ulLength,
+                                     uint32_t ulBlockSize,
+                                     OTA_HTTP_Block_t xBlock,
+                                     void * pvContext );
+
+/**
+ * @brief Close the connection if it is open.
+ */
+void OTA_HTTP_Disconnect( OTA_HTTP_Connection_t * pxConnection );
+
+#endif /* ifndef _AWS_OTA_HTTP_H_ */
@@ -133,6 +133,99 @@ int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C,
                            uint8_t * const pcData,
                            uint32_t ulBlockSize );
 
+/**
+ * @brief Read back a block of data that was previously written to the specified file.
+ *
+ * @note This is only called by the OTA agent when otaconfigSTREAM_SIGNATURE_VERIFY is 1, to add
+ * blocks that arrived out of order to the file hash once the blocks before them have been received.
+ * A PAL that cannot read its receive file may return a negative error code; the agent then leaves
+ * the whole signature check to prvPAL_CloseFile().
+ *
+ * @note When the agent has hashed the complete file, C->pvSigVerifyContext is non-NULL on entry
+ * to prvPAL_CloseFile(). A PAL that verifies the signature with aws_crypto.h should then take
+ * ownership of that context, set C->pvSigVerifyContext to NULL and only perform
+ * CRYPTO_SignatureVerificationFinal() instead of reading the file back.
+ *
+ * @param[in] C OTA file context information.
+ * @param[in] ulOffset Byte offset to read from the beginning of the file.
+ * @param[out] pucData Pointer to the buffer receiving the data.
+ * @param[in] ulBlockSize The number of bytes to read.
+ *
+ * @return The number of bytes read on a success, or a negative error code from the platform abstraction layer.
+ */
+int16_t prvPAL_ReadBlock( OTA_FileContext_t * const C,
+                          uint32_t ulOffset,
+                          uint8_t * const pucData,
+                          uint32_t ulBlockSize );
+
+/**
+ * @brief Read a block of the firmware image that is currently running.
+ *
+ * @note This is only called by the OTA agent when otaconfigENABLE_DELTA_UPDATE is 1, while
+ * applying a delta update that rebuilds the new image from the running one. A PAL that cannot
+ * read its running image shall return a negative error code; delta updates then fail.
+ *
+ * @param[in] C OTA file context information.
+ * @param[in] ulOffset Byte offset to read from the beginning of the running image.
+ * @param[out] pucData Pointer to the buffer receiving the data.
+ * @param[in] ulBlockSize The number of bytes to read.
+ *
+ * @return The number of bytes read on a success, or a negative error code from the platform abstraction layer.
+ */
+int16_t prvPAL_ReadActiveImage( OTA_FileContext_t * const C,
+                                uint32_t ulOffset,
+                                uint8_t * const pucData,
+                                uint32_t ulBlockSize );
+
+/**
+ * @brief Reopen the receive file of an interrupted transfer without erasing it.
+ *
+ * @note This is only called by the OTA agent when otaconfigENABLE_RESUME is 1, instead of
+ * prvPAL_CreateFileForRx(), when a checkpoint shows that part of the same file was received
+ * before a reset. The blocks already written must be kept. A PAL that cannot reopen its
+ * receive file shall return an error; the agent then creates the file again.
+ *
+ * @param[in] C OTA file context information.
+ * @param[in] ulBytesReceived Number of bytes of the file already written.
+ *
+ * @return The OTA PAL layer error code combined with the MCU specific error code. See OTA Agent
+ * error codes information in aws_ota_agent.h.
+ *
+ * kOTA_Err_None is returned when the file was reopened.
+ * kOTA_Err_RxFileCreateFailed is returned for any error reopening the file.
+ */
+OTA_Err_t prvPAL_ResumeFileForRx( OTA_FileContext_t * const C,
+                                  uint32_t ulBytesReceived );
+
+/**
+ * @brief Store the transfer checkpoint of the OTA agent in non-volatile memory.
+ *
+ * @note This is only called by the OTA agent when otaconfigENABLE_RESUME is 1. The checkpoint
+ * replaces the previous one. A NULL pucData with a zero ulSize erases the checkpoint. The
+ * agent checks the integrity of the checkpoint itself.
+ *
+ * @param[in] pucData The checkpoint.
+ * @param[in] ulSize The size of the checkpoint in bytes.
+ *
+ * @return kOTA_Err_None if the checkpoint was stored, else kOTA_Err_CheckpointFailed combined
+ * with the MCU specific error code.
+ */
+OTA_Err_t prvPAL_SaveCheckpoint( const uint8_t * pucData,
+                                 uint32_t ulSize );
+
+/**
+ * @brief Read back the transfer checkpoint of the OTA agent.
+ *
+ * @note This is only called by the OTA agent when otaconfigENABLE_RESUME is 1.
+ *
+ * @param[out] pucData Buffer receiving the checkpoint.
+ * @param[in] ulSize Size of pucData in bytes.
+ *
+ * @return The number of bytes read, or a negative value if there is no checkpoint.
+ */
+int32_t prvPAL_LoadCheckpoint( uint8_t * pucData,
+                               uint32_t ulSize );
+
 /**
  * @brief Activate the newest MCU image received via OTA.
  *
@@ -61,4 +61,12 @@
     #define socketsconfigDEFAULT_RECV_TIMEOUT    ( 10000 )
 #endif
 
+/**
+ * @brief Maximum number of buffers that can be passed to a single call to
+ * SOCKETS_SendV.
+ */
+#ifndef socketsconfigMAX_SENDV_VECTORS
+    #define socketsconfigMAX_SENDV_VECTORS    ( 4 )
+#endif
+
 #endif /* AWS_INC_SECURE_SOCKETS_CONFIG_DEFAULTS_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_shadow_cbor.h
+ * @brief Shadow CBOR utility functions.
+ */
+
+#ifndef _AWS_SHADOW_CBOR_H_
+#define _AWS_SHADOW_CBOR_H_
+
+#include "FreeRTOS.h"
+
+/**
+ * @brief Check if the client tokens in pucDoc1 and pucDoc2 match.
+ *
+ * @param[in] pucDoc1, pucDoc2 CBOR documents
+ * @param[in] ulDoc1Length, ulDoc2Length the lengths of pucDoc1 and pucDoc2,
+ *     respectively
+ * @return pdTRUE if the client tokens in pucDoc1 and pucDoc2 match; pdFALSE
+ *     if the client tokens don't match or either document has no top-level
+ *     "clientToken" text string.
+ */
+BaseType_t SHADOW_CBORDocClientTokenMatch( const uint8_t * const pucDoc1,
+                                           uint32_t ulDoc1Length,
+                                           const uint8_t * const pucDoc2,
+                                           uint32_t ulDoc2Length );
+
+/**
+ * @brief Extracts the error code and message from a Shadow error CBOR document.
+ *
+ * @param[in] pucErrorCBOR a Shadow error CBOR document
+ * @param[in] ulErrorCBORLength the length of pucErrorCBOR
+ * @param[out] ppcErrorMessage set to the location of the error message in
+ *     pucErrorCBOR. Pass NULL to ignore error message.
+ * @param[out] pusErrorMessageLength set to the size of the error message
+ *     Pass NULL to ignore error message.
+ * @return a positive code corresponding to an error reason on success; 0 if
+ *     pucErrorCBOR has no top-level integer "code"
+ *
+ * @note The error message is not NUL-terminated. It is only found if it is a
+ * definite-length text string.
+ */
+int16_t SHADOW_CBORGetErrorCodeAndMessage( const uint8_t * const pucErrorCBOR,
+                                           uint32_t ulErrorCBORLength,
+                                           char ** ppcErrorMessage,
+                                           uint16_t * pusErrorMessageLength );
+
+#endif /* _AWS_SHADOW_CBOR_H_ */
@@ -34,7 +34,9 @@
 /**
  * @brief Number of jsmn tokens to use in parsing.  Each jsmn token contains 4 ints.
  * Ensure that the number of tokens does not overflow the calling task's stack,
- * but is also sufficient to parse the largest expected JSON documents. */
+ * but is also sufficient to parse the largest expected JSON documents.
+ * The Shadow library itself scans its response documents without jsmn tokens;
+ * this setting is kept for applications that include it. */
 #ifndef shadowconfigJSON_JSMN_TOKENS
     #define shadowconfigJSON_JSMN_TOKENS    ( 64 )
 #endif
@@ -71,12 +73,147 @@
  * Each Shadow Client stores the Things with user notify callbacks registered.
  * Define how many unique Things require user notify callbacks here.
  *
- * @note Should be less than 256.
+ * Incoming messages find their Thing through a hash index of the Thing Names,
+ * so this can be large; each Thing takes an entry and two 2-byte index slots.
+ *
+ * @note Must be less than 32768.
  */
 #ifndef shadowconfigMAX_THINGS_WITH_CALLBACKS
     #define shadowconfigMAX_THINGS_WITH_CALLBACKS    ( 1 )
 #endif
 
+/**
+ * @brief Number of operations that may be in progress at once on each Shadow
+ * Client.
+ *
+ * #SHADOW_Update, #SHADOW_Get and #SHADOW_Delete calls made from different
+ * tasks wait for their responses concurrently, up to this number. Further
+ * calls block until an operation completes. Each pending operation holds a
+ * semaphore and a copy of its topic, roughly 250 bytes on a 32-bit target.
+ *
+ * @note The default of 1 completes one operation at a time on each Shadow
+ * Client.
+ */
+#ifndef shadowconfigMAX_PENDING_OPERATIONS
+    #define shadowconfigMAX_PENDING_OPERATIONS    ( 1 )
+#endif
+
+/**
+ * @brief Number of accepted/rejected subscriptions each Shadow Client can keep
+ * in addition to those used by pending operations.
+ *
+ * Operations made with #ShadowOperationParams_t.ucKeepSubscriptions set leave
+ * their subscriptions in place, so later operations of the same kind on the
+ * same Thing need only publish. When a Shadow Client needs room for another
+ * subscription, it unsubscribes from the least recently used one that no
+ * pending operation relies on.
+ *
+ * @note Each subscription uses a copy of its topic, roughly 180 bytes.
+ */
+#ifndef shadowconfigSUBSCRIPTION_CACHE_SIZE
+    #define shadowconfigSUBSCRIPTION_CACHE_SIZE    ( 2 )
+#endif
+
+/**
+ * @brief Number of reported state fields each Shadow Client keeps for
+ * #SHADOW_ReportedSet and #SHADOW_ReportedSync.
+ *
+ * Set to 0 to leave out the reported state, in which case both functions
+ * return #eShadowFailure.
+ */
+#ifndef shadowconfigREPORTED_FIELDS
+    #define shadowconfigREPORTED_FIELDS    ( 0 )
+#endif
+
+/**
+ * @brief Maximum length of the name of a reported state field.
+ */
+#ifndef shadowconfigREPORTED_KEY_LENGTH
+    #define shadowconfigREPORTED_KEY_LENGTH    ( 16 )
+#endif
+
+/**
+ * @brief Maximum length of the JSON value of a reported state field.
+ *
+ * @note Each field keeps both its latest and its acknowledged value.
+ */
+#ifndef shadowconfigREPORTED_VALUE_LENGTH
+    #define shadowconfigREPORTED_VALUE_LENGTH    ( 16 )
+#endif
+
+/**
+ * @brief Size of the update document built by #SHADOW_ReportedSync.
+ *
+ * Changed fields that do not fit are sent by the next call.
+ */
+#ifndef shadowconfigREPORTED_DOCUMENT_LENGTH
+    #define shadowconfigREPORTED_DOCUMENT_LENGTH    ( 256 )
+#endif
+
+/**
+ * @brief Time (in milliseconds) #SHADOW_ReportedSync waits after the first
+ * unsent change, so that changes made in quick succession go in one update.
+ */
+#ifndef shadowconfigREPORTED_COALESCE_MS
+    #define shadowconfigREPORTED_COALESCE_MS    ( 100 )
+#endif
+
+/**
+ * @brief Number of per-property delta handlers that can be registered for each
+ * Thing with #SHADOW_RegisterDeltaHandlers.
+ *
+ * Set to 0 to leave out delta dispatch, in which case
+ * #SHADOW_RegisterDeltaHandlers returns #eShadowFailure.
+ */
+#ifndef shadowconfigMAX_DELTA_HANDLERS
+    #define shadowconfigMAX_DELTA_HANDLERS    ( 0 )
+#endif
+
+/**
+ * @brief Number of path segments in the dispatch trie of each Thing.
+ *
+ * Each key or array index of a handler path that is not shared with an
+ * earlier path uses one node of 8 bytes. Must be less than 255.
+ */
+#ifndef shadowconfigDELTA_TRIE_NODES
+    #define shadowconfigDELTA_TRIE_NODES    ( 4 * shadowconfigMAX_DELTA_HANDLERS )
+#endif
+
+/**
+ * @brief Set to 1 to subscribe once to $aws/things/+/shadow/# on connect,
+ * instead of to the topics of each Thing.
+ *
+ * Suits gateways that act for many Things over one connection: registering
+ * callbacks and making operations then never subscribes or unsubscribes. The
+ * policy of the Shadow Client must allow the wildcard subscription, and the
+ * messages of Things that the Shadow Client does not handle are received and
+ * dropped.
+ */
+#ifndef shadowconfigSUBSCRIBE_WILDCARD
+    #define shadowconfigSUBSCRIBE_WILDCARD    ( 0 )
+#endif
+
+/**
+ * @brief Set to 1 to allow Shadow Clients with CBOR documents.
+ *
+ * Needs tinycbor. Also enables #SHADOW_JSONToCBOR and #SHADOW_CBORToJSON,
+ * which return #eShadowFailure when this is 0.
+ */
+#ifndef shadowconfigENABLE_CBOR
+    #define shadowconfigENABLE_CBOR    ( 0 )
+#endif
+
+/**
+ * @brief Longest JSON string with escape sequences that #SHADOW_JSONToCBOR
+ * converts, in bytes after decoding.
+ *
+ * Escaped strings are decoded on the stack; strings without escapes are copied
+ * straight to the CBOR document and are not limited.
+ */
+#ifndef shadowconfigCBOR_STRING_LENGTH
+    #define shadowconfigCBOR_STRING_LENGTH    ( 64 )
+#endif
+
 /**
  * @brief Time (in milliseconds) a Shadow Client may block during cleanup @b IF
  * a timeout occurs.
@@ -41,8 +41,8 @@
  * @param[in] ulDoc1Length, ulDoc2Length the lengths of pcDoc1 and pcDoc2,
  *     respectively
  * @return pdTRUE if the client tokens in pcDoc1 and pcDoc2 match; pdFALSE
- *     if the client tokens don't match; jsmn error (see jsmn.h) if jsmn
- *     fails to parse either string.
+ *     if the client tokens don't match or either document has no top-level
+ *     "clientToken".
  */
 BaseType_t SHADOW_JSONDocClientTokenMatch( const char * const pcDoc1,
                                            uint32_t ulDoc1Length,
@@ -58,8 +58,11 @@ BaseType_t SHADOW_JSONDocClientTokenMatch( const char * const pcDoc1,
  *     Pass NULL to ignore error message.
  * @param[out] pusErrorMessageLength set to the size of the error message
  *     Pass NULL to ignore error message.
- * @return a positive code corresponding to an error reason on success; jsmn error
- *     (see jsmn.h) if jsmn fails to parse pcErrorJSON; 0 for bad pointer arguments
+ * @return a positive code corresponding to an error reason on success; 0 if
+ *     pcErrorJSON has no top-level "code" or for bad pointer arguments
+ *
+ * @note Only the members of the top-level object are searched. The document is
+ * scanned once and is not tokenized.
  */
 int16_t SHADOW_JSONGetErrorCodeAndMessage( const char * const pcErrorJSON,
                                            uint32_t ulErrorJSONLength,
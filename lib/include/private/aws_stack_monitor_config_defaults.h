@@ -0,0 +1,74 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_stack_monitor_config_defaults.h
+ * @brief Default values for the stack monitor configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_STACK_MONITOR_CONFIG_DEFAULTS_H_
+#define _AWS_STACK_MONITOR_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief The maximum number of tasks that can be registered.
+ */
+#ifndef stackmonconfigMAX_TASKS
+    #define stackmonconfigMAX_TASKS    ( 16 )
+#endif
+
+/**
+ * @brief The time between two samples, in milliseconds.
+ *
+ * Each sample measures one registered task, so every task is measured once
+ * every stackmonconfigMAX_TASKS samples at most.
+ */
+#ifndef stackmonconfigSAMPLE_PERIOD_MS
+    #define stackmonconfigSAMPLE_PERIOD_MS    ( 1000 )
+#endif
+
+/**
+ * @brief The margin added to the used stack depth in recommendations.
+ */
+#ifndef stackmonconfigMARGIN_PERCENT
+    #define stackmonconfigMARGIN_PERCENT    ( 25 )
+#endif
+
+/**
+ * @brief Priority of the sampling task.
+ */
+#ifndef stackmonconfigTASK_PRIORITY
+    #define stackmonconfigTASK_PRIORITY    ( tskIDLE_PRIORITY )
+#endif
+
+/**
+ * @brief Stack depth, in words, of the sampling task.
+ */
+#ifndef stackmonconfigTASK_STACK_DEPTH
+    #define stackmonconfigTASK_STACK_DEPTH    ( configMINIMAL_STACK_SIZE * 2 )
+#endif
+
+#endif /* _AWS_STACK_MONITOR_CONFIG_DEFAULTS_H_ */
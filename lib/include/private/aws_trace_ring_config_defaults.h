@@ -0,0 +1,123 @@
+/*
+ * Amazon FreeRTOS Trace Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_trace_ring_config_defaults.h
+ * @brief Default values for the trace ring configuration.
+ *
+ * Any of these can be overridden in FreeRTOSConfig.h.
+ */
+
+#ifndef _AWS_TRACE_RING_CONFIG_DEFAULTS_H_
+#define _AWS_TRACE_RING_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief The number of records in the ring of each core.
+ *
+ * Must be a power of two. Each record takes 16 bytes. When streaming, the
+ * ring has to hold the records written in traceringconfigSTREAM_PERIOD_MS,
+ * which with context switch tracing is often several per millisecond.
+ */
+#ifndef traceringconfigRECORDS_PER_CORE
+    #define traceringconfigRECORDS_PER_CORE    ( 256U )
+#endif
+
+/**
+ * @brief Timestamp source of the records.
+ *
+ * The RTOS tick is too coarse to see the time spent in most events. Map this
+ * to a free running counter, such as a cycle counter or the counter used for
+ * the kernel run time statistics, to time them precisely.
+ * traceringconfigTIMESTAMP_HZ must give its frequency. It is called from
+ * interrupts and critical sections, so it must not use the kernel API.
+ */
+#ifndef traceringconfigTIMESTAMP
+    #define traceringconfigTIMESTAMP()    ( ( uint32_t ) xTaskGetTickCountFromISR() )
+#endif
+
+/**
+ * @brief Frequency of traceringconfigTIMESTAMP(), in Hz.
+ *
+ * Sent with the records, so the decoder can convert timestamps to time.
+ */
+#ifndef traceringconfigTIMESTAMP_HZ
+    #define traceringconfigTIMESTAMP_HZ    ( ( uint32_t ) configTICK_RATE_HZ )
+#endif
+
+/**
+ * @brief Returns the core that executes the caller.
+ *
+ * Every core writes to its own ring, so cores never contend for a record.
+ */
+#ifndef traceringconfigGET_CORE_ID
+    #define traceringconfigGET_CORE_ID()    ( 0U )
+#endif
+
+/**
+ * @brief The number of records sent in one chunk by the streaming task.
+ */
+#ifndef traceringconfigCHUNK_RECORDS
+    #define traceringconfigCHUNK_RECORDS    ( 32U )
+#endif
+
+/**
+ * @brief The time the streaming task waits after emptying the rings, in
+ * milliseconds.
+ */
+#ifndef traceringconfigSTREAM_PERIOD_MS
+    #define traceringconfigSTREAM_PERIOD_MS    ( 20U )
+#endif
+
+/**
+ * @brief Priority of the streaming task.
+ */
+#ifndef traceringconfigSTREAM_TASK_PRIORITY
+    #define traceringconfigSTREAM_TASK_PRIORITY    ( tskIDLE_PRIORITY )
+#endif
+
+/**
+ * @brief Stack depth, in words, of the streaming task.
+ */
+#ifndef traceringconfigSTREAM_TASK_STACK_DEPTH
+    #define traceringconfigSTREAM_TASK_STACK_DEPTH    ( configMINIMAL_STACK_SIZE * 4 )
+#endif
+
+/**
+ * @brief Set to 1 to build TRACE_RING_StartMQTTStreaming().
+ *
+ * Left out by default, so the trace ring does not depend on the MQTT agent.
+ */
+#ifndef traceringconfigMQTT_STREAMING
+    #define traceringconfigMQTT_STREAMING    ( 0 )
+#endif
+
+/**
+ * @brief The time a chunk publish may take, in milliseconds.
+ */
+#ifndef traceringconfigMQTT_PUBLISH_TIMEOUT_MS
+    #define traceringconfigMQTT_PUBLISH_TIMEOUT_MS    ( 1000U )
+#endif
+
+#endif /* _AWS_TRACE_RING_CONFIG_DEFAULTS_H_ */
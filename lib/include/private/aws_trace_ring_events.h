@@ -0,0 +1,96 @@
+/*
+ * Amazon FreeRTOS Trace Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_trace_ring_events.h
+ * @brief Event identifiers of the trace ring, and the functions that record them.
+ *
+ * This header only depends on stdint.h, so it can be included from
+ * FreeRTOSConfig.h through aws_trace_ring_hooks.h.
+ */
+
+#ifndef _AWS_TRACE_RING_EVENTS_H_
+#define _AWS_TRACE_RING_EVENTS_H_
+
+#include <stdint.h>
+
+/**
+ * @defgroup TraceRingEvents Event identifiers.
+ *
+ * The meaning of the two arguments of each record is given for every event.
+ * Objects, such as tasks and queues, are identified by the low 32 bits of
+ * their handle. Events that begin and end a duration are paired, so the
+ * decoder can show them as spans of the task that was running.
+ */
+/** @{ */
+#define traceringEVENT_TASK_SWITCHED_IN     ( ( uint16_t ) 0x0001 ) /**< Task, priority. */
+#define traceringEVENT_TASK_SWITCHED_OUT    ( ( uint16_t ) 0x0002 ) /**< Task, 0. */
+#define traceringEVENT_TASK_CREATE          ( ( uint16_t ) 0x0003 ) /**< Task, priority. */
+#define traceringEVENT_TASK_DELETE          ( ( uint16_t ) 0x0004 ) /**< Task, 0. */
+#define traceringEVENT_TASK_NAME            ( ( uint16_t ) 0x0005 ) /**< Task, four characters of the name. */
+#define traceringEVENT_TASK_DELAY           ( ( uint16_t ) 0x0006 ) /**< Ticks to delay, 0. */
+#define traceringEVENT_TASK_NOTIFY_WAIT     ( ( uint16_t ) 0x0007 ) /**< 0, 0. */
+#define traceringEVENT_QUEUE_RECEIVE_BLOCK  ( ( uint16_t ) 0x0008 ) /**< Queue, 0. */
+#define traceringEVENT_QUEUE_SEND_BLOCK     ( ( uint16_t ) 0x0009 ) /**< Queue, 0. */
+#define traceringEVENT_TICK                 ( ( uint16_t ) 0x000A ) /**< Tick count, 0. */
+#define traceringEVENT_IP_EVENT_BEGIN       ( ( uint16_t ) 0x0100 ) /**< eIPEvent_t, 0. */
+#define traceringEVENT_IP_EVENT_END         ( ( uint16_t ) 0x0101 ) /**< eIPEvent_t, 0. */
+#define traceringEVENT_MQTT_COMMAND_BEGIN   ( ( uint16_t ) 0x0200 ) /**< Command type, broker number. */
+#define traceringEVENT_MQTT_COMMAND_END     ( ( uint16_t ) 0x0201 ) /**< Command type, broker number. */
+#define traceringEVENT_OTA_EVENTS           ( ( uint16_t ) 0x0300 ) /**< Event group bits, 0. */
+#define traceringEVENT_OTA_MESSAGE_BEGIN    ( ( uint16_t ) 0x0301 ) /**< Message type, message length. */
+#define traceringEVENT_OTA_MESSAGE_END      ( ( uint16_t ) 0x0302 ) /**< Message type, 0. */
+#define traceringEVENT_USER                 ( ( uint16_t ) 0x8000 ) /**< First identifier free for applications. */
+/** @} */
+
+/**
+ * @brief Adds a record to the ring of the calling core.
+ *
+ * Can be called from tasks, interrupts and critical sections, and before the
+ * scheduler is started. When the ring is full, the oldest record is
+ * overwritten.
+ *
+ * @param[in] usEventId The event, one of traceringEVENT_* or an application
+ * event from traceringEVENT_USER up.
+ * @param[in] ulArg1 First argument of the event.
+ * @param[in] ulArg2 Second argument of the event.
+ */
+void TRACE_RING_Record( uint16_t usEventId,
+                        uint32_t ulArg1,
+                        uint32_t ulArg2 );
+
+/**
+ * @brief Records the name of an object as traceringEVENT_TASK_NAME records.
+ *
+ * The name is split over one record per four characters, so the decoder can
+ * label the object without a separate symbol table.
+ *
+ * @param[in] ulObject The object the name belongs to.
+ * @param[in] pcName The NUL terminated name.
+ */
+void TRACE_RING_RecordName( uint32_t ulObject,
+                            const char * pcName );
+
+#endif /* _AWS_TRACE_RING_EVENTS_H_ */
@@ -0,0 +1,48 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_wifi_reconnect_config_defaults.h
+ * @brief Default values for the Wi-Fi reconnection configuration.
+ *
+ * Any of these can be overridden in aws_wifi_config.h.
+ */
+
+#ifndef _AWS_WIFI_RECONNECT_CONFIG_DEFAULTS_H_
+#define _AWS_WIFI_RECONNECT_CONFIG_DEFAULTS_H_
+
+/**
+ * @brief The number of scan results examined to find the strongest Access
+ * Point of a network when the cached one cannot be joined.
+ *
+ * The results are held in a static array of WIFIScanResult_t. Set to 0 to
+ * never scan, in which case a miss falls back to a plain WIFI_ConnectAP() and
+ * the cache is only filled from WIFI_ReconnectSetCache().
+ */
+#ifndef wificonfigRECONNECT_MAX_SCAN_RESULTS
+    #define wificonfigRECONNECT_MAX_SCAN_RESULTS    ( 8 )
+#endif
+
+#endif /* _AWS_WIFI_RECONNECT_CONFIG_DEFAULTS_H_ */
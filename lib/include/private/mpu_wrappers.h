@@ -52,6 +52,7 @@ only for ports that are using the MPU. */
 		#define vTaskAllocateMPURegions					MPU_vTaskAllocateMPURegions
 		#define vTaskDelete								MPU_vTaskDelete
 		#define vTaskDelay								MPU_vTaskDelay
+		#define vTaskDelayWithSlack						MPU_vTaskDelayWithSlack
 		#define vTaskDelayUntil							MPU_vTaskDelayUntil
 		#define xTaskAbortDelay							MPU_xTaskAbortDelay
 		#define uxTaskPriorityGet						MPU_uxTaskPriorityGet
@@ -79,9 +80,9 @@ only for ports that are using the MPU. */
 		#define vTaskGetRunTimeStats					MPU_vTaskGetRunTimeStats
 		#define xTaskGetIdleRunTimeCounter				MPU_xTaskGetIdleRunTimeCounter
 		#define xTaskGenericNotify						MPU_xTaskGenericNotify
-		#define xTaskNotifyWait							MPU_xTaskNotifyWait
-		#define ulTaskNotifyTake						MPU_ulTaskNotifyTake
-		#define xTaskNotifyStateClear					MPU_xTaskNotifyStateClear
+		#define xTaskGenericNotifyWait					MPU_xTaskGenericNotifyWait
+		#define ulTaskGenericNotifyTake					MPU_ulTaskGenericNotifyTake
+		#define xTaskGenericNotifyStateClear			MPU_xTaskGenericNotifyStateClear
 
 		#define xTaskGetCurrentTaskHandle				MPU_xTaskGetCurrentTaskHandle
 		#define vTaskSetTimeOutState					MPU_vTaskSetTimeOutState
@@ -127,6 +128,8 @@ only for ports that are using the MPU. */
 		#define xTimerPendFunctionCall					MPU_xTimerPendFunctionCall
 		#define pcTimerGetName							MPU_pcTimerGetName
 		#define vTimerSetReloadMode						MPU_vTimerSetReloadMode
+		#define vTimerSetSlack							MPU_vTimerSetSlack
+		#define xTimerGetSlack							MPU_xTimerGetSlack
 		#define xTimerGetPeriod							MPU_xTimerGetPeriod
 		#define xTimerGetExpiryTime						MPU_xTimerGetExpiryTime
 		#define xTimerGenericCommand					MPU_xTimerGenericCommand
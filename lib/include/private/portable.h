@@ -119,8 +119,16 @@ typedef struct HeapRegion
 {
 	uint8_t *pucStartAddress;
 	size_t xSizeInBytes;
+	#if( configUSE_HEAP_CAPS == 1 )
+		uint32_t ulCaps;	/* The heapCAPS_ bits of the memory in the region. */
+	#endif
 } HeapRegion_t;
 
+/* Capabilities of heap_5.c regions, requested by pvPortMallocWithCaps(). */
+#define heapCAPS_FAST	( ( uint32_t ) 0x01UL )	/* Fast internal memory, for data that is used often. */
+#define heapCAPS_DMA	( ( uint32_t ) 0x02UL )	/* Memory that peripherals can access by DMA. */
+#define heapCAPS_BULK	( ( uint32_t ) 0x04UL )	/* Large and possibly slow memory, for big buffers that are used rarely. */
+
 /*
  * Used to define multiple heap regions for use by heap_5.c.  This function
  * must be called before any calls to pvPortMalloc() - not creating a task,
@@ -134,6 +142,46 @@ typedef struct HeapRegion
  */
 void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEGED_FUNCTION;
 
+#if( configUSE_HEAP_CAPS == 1 )
+
+	/* The use of one heap_5.c region, as returned by xPortGetHeapRegionStats(). */
+	typedef struct HeapRegionStats
+	{
+		uint32_t ulCaps;
+		size_t xSizeInBytes;
+		size_t xFreeBytesRemaining;
+		size_t xMinimumEverFreeBytesRemaining;
+		size_t xLargestFreeBlockSize;
+		uint32_t ulAllocations;	/* The number of blocks allocated from the region. */
+	} HeapRegionStats_t;
+
+	/*
+	 * Allocates from the heap_5.c regions whose ulCaps include all of the
+	 * heapCAPS_ bits in ulCaps, trying them in the order they were defined.
+	 *
+	 * heapCAPS_FAST and heapCAPS_BULK are preferences: when no region with
+	 * them has space the rest of the heap is used.  heapCAPS_DMA is a
+	 * requirement if any region was defined with it, so a board on which all
+	 * memory can be used for DMA need not mark its regions.
+	 *
+	 * The block is freed with vPortFree().
+	 */
+	void *pvPortMallocWithCaps( size_t xSize, uint32_t ulCaps ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Fills *pxStats with the use of the heap region with index xRegion in
+	 * the array passed to vPortDefineHeapRegions().  Returns pdFALSE if there
+	 * is no such region.
+	 */
+	BaseType_t xPortGetHeapRegionStats( BaseType_t xRegion, HeapRegionStats_t *pxStats ) PRIVILEGED_FUNCTION;
+
+#else
+
+	/* Without regions all memory is alike. */
+	#define pvPortMallocWithCaps( xSize, ulCaps ) pvPortMalloc( xSize )
+
+#endif /* configUSE_HEAP_CAPS */
+
 
 /*
  * Map to the memory management routines required for the port.
@@ -144,6 +192,13 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Returns the size of the largest free block, which together with
+ * xPortGetFreeHeapSize() shows how fragmented the heap is.  Only provided by
+ * heap_4.c, heap_5.c and heap_6.c.
+ */
+size_t xPortGetLargestFreeBlockSize( void ) PRIVILEGED_FUNCTION;
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
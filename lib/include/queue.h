@@ -61,6 +61,15 @@ typedef struct QueueDefinition * QueueSetHandle_t;
  */
 typedef struct QueueDefinition * QueueSetMemberHandle_t;
 
+/**
+ * Type by which reader/writer locks are referenced.  For example, a call to
+ * xSemaphoreCreateRWLock() returns a QueueRWLockHandle_t variable that can
+ * then be used as a parameter to xSemaphoreTakeRead(), xSemaphoreTakeWrite(),
+ * etc.
+ */
+struct QueueRWLockDefinition;
+typedef struct QueueRWLockDefinition * QueueRWLockHandle_t;
+
 /* For internal use only. */
 #define	queueSEND_TO_BACK		( ( BaseType_t ) 0 )
 #define	queueSEND_TO_FRONT		( ( BaseType_t ) 1 )
@@ -913,6 +922,25 @@ UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue ) PRIVILEGED_FUNC
  */
 void vQueueDelete( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
 
+/**
+ * queue. h
+ * <pre>void vQueueGetPoolStats( ObjectPoolStats_t *pxStats );</pre>
+ *
+ * configQUEUE_POOL_SIZE must be greater than 0 for this function to be
+ * available.
+ *
+ * When a dynamically allocated queue, semaphore or mutex is deleted its
+ * memory is kept in a pool of up to configQUEUE_POOL_SIZE blocks instead of
+ * being freed, and reused by the next object created that needs a block of
+ * exactly the same size.
+ *
+ * @param pxStats Filled in with the use of the queue pool.
+ *
+ * \defgroup vQueueGetPoolStats vQueueGetPoolStats
+ * \ingroup QueueManagement
+ */
+void vQueueGetPoolStats( ObjectPoolStats_t *pxStats ) PRIVILEGED_FUNCTION;
+
 /**
  * queue. h
  * <pre>
@@ -1384,6 +1412,172 @@ BaseType_t xQueueGiveFromISR( QueueHandle_t xQueue, BaseType_t * const pxHigherP
  */
 BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+#if( ( configUSE_QUEUE_ZERO_COPY == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	/**
+	 * queue. h
+	 * <pre>
+	 QueueHandle_t xQueueCreateZeroCopy(
+								  UBaseType_t uxQueueLength,
+								  UBaseType_t uxItemSize
+							  );
+	 * </pre>
+	 *
+	 * Creates a queue that passes items by reference.  Next to the queue, a pool
+	 * of uxQueueLength slots of uxItemSize bytes is created, in the same block of
+	 * memory.  A sender borrows a free slot with pvQueueAcquireZeroCopy(), fills
+	 * it in place and posts it with xQueueSendZeroCopy().  The receiver gets the
+	 * slot with pvQueueReceiveZeroCopy() and returns it to the pool with
+	 * vQueueReleaseZeroCopy() once it is done with the item.  Only a pointer is
+	 * copied in each step, no matter how large the items are.
+	 *
+	 * The slots are owned by one task at a time: the sender until the slot is
+	 * posted, the receiver until it is released.  Blocking happens when the pool
+	 * is empty (in pvQueueAcquireZeroCopy()) or when the queue is empty (in
+	 * pvQueueReceiveZeroCopy()).  The handle is deleted with vQueueDelete(), and
+	 * it may be added to a queue set.  The normal send and receive functions must
+	 * not be used on it.
+	 *
+	 * @param uxQueueLength The number of slots, which is also the number of
+	 * items that can be in the queue at any time.
+	 *
+	 * @param uxItemSize The size of a slot in bytes.
+	 *
+	 * @return The handle of the queue, or NULL if there was not enough heap.
+	 *
+	 * Example usage:
+	   <pre>
+	 xQueue = xQueueCreateZeroCopy( 4, sizeof( LargeMessage_t ) );
+
+	 // Sender.
+	 pxMessage = pvQueueAcquireZeroCopy( xQueue, portMAX_DELAY );
+	 vFillMessage( pxMessage );
+	 xQueueSendZeroCopy( xQueue, pxMessage );
+
+	 // Receiver.
+	 pxMessage = pvQueueReceiveZeroCopy( xQueue, portMAX_DELAY );
+	 vHandleMessage( pxMessage );
+	 vQueueReleaseZeroCopy( xQueue, pxMessage );
+	 </pre>
+	 * \defgroup xQueueCreateZeroCopy xQueueCreateZeroCopy
+	 * \ingroup QueueManagement
+	 */
+	QueueHandle_t xQueueCreateZeroCopy( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Borrow a free slot of a queue created with xQueueCreateZeroCopy(),
+	 * waiting at most xTicksToWait for one to become free.  Returns NULL on
+	 * time-out.
+	 */
+	void *pvQueueAcquireZeroCopy( QueueHandle_t xQueue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Post a slot obtained from pvQueueAcquireZeroCopy() to the back of the
+	 * queue.  This never blocks: there is always space for every slot.
+	 */
+	BaseType_t xQueueSendZeroCopy( QueueHandle_t xQueue, void *pvSlot ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Take the slot from the front of the queue, waiting at most xTicksToWait
+	 * for one to arrive.  Returns NULL on time-out.
+	 */
+	void *pvQueueReceiveZeroCopy( QueueHandle_t xQueue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Give a slot obtained from pvQueueReceiveZeroCopy() back to the pool of
+	 * free slots.  A sender may also give back a slot that it has not posted.
+	 */
+	void vQueueReleaseZeroCopy( QueueHandle_t xQueue, void *pvSlot ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+
+/*
+ * For internal use only.  Use uxSemaphoreGetContentionCount() instead of
+ * calling this function directly.
+ */
+#if( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+	UBaseType_t uxQueueGetContentionCount( const QueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+#endif
+
+/*
+ * Contention statistics of a queue, semaphore or mutex, as returned by
+ * vQueueGetStats().  Times are in ticks, and count from the first time a call
+ * blocked until the call returned, whether it succeeded or timed out.  Peeks
+ * and semaphore takes count as receives, semaphore gives as sends.
+ */
+typedef struct xQUEUE_STATS
+{
+	UBaseType_t uxBlockedSends;			/*< The number of send calls that blocked. */
+	UBaseType_t uxBlockedReceives;		/*< The number of receive calls that blocked. */
+	UBaseType_t uxPriorityInheritances;	/*< For a mutex, the number of times a task that blocked on it raised the priority of the holder. */
+	UBaseType_t uxHighWaterMark;		/*< The largest number of items the queue has held. */
+	TickType_t xSendBlockedTime;		/*< The total time send calls spent blocked. */
+	TickType_t xReceiveBlockedTime;		/*< The total time receive calls spent blocked. */
+	TickType_t xMaxBlockedTime;			/*< The longest time a single call spent blocked. */
+} QueueStats_t;
+
+/**
+ * queue. h
+ * <pre>void vQueueGetStats( const QueueHandle_t xQueue, QueueStats_t * const pxStats );</pre>
+ *
+ * Copies the contention statistics of a queue, semaphore or mutex, which show
+ * how often and for how long tasks wait on it.  configUSE_QUEUE_CONTENTION_STATS
+ * must be set to 1 in FreeRTOSConfig.h for this function to be available.
+ * Queues in the queue registry can be found by name with
+ * xQueueGetHandleFromName().
+ *
+ * @param xQueue The queue, semaphore or mutex.
+ *
+ * @param pxStats The structure the statistics are copied to.
+ */
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	void vQueueGetStats( const QueueHandle_t xQueue, QueueStats_t * const pxStats ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * queue. h
+ * <pre>void vQueueResetStats( QueueHandle_t xQueue );</pre>
+ *
+ * Sets the contention statistics of a queue, semaphore or mutex back to 0, and
+ * its high water mark to the number of items it holds now, so that a later
+ * call to vQueueGetStats() only covers what happened in between.
+ *
+ * @param xQueue The queue, semaphore or mutex.
+ */
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	void vQueueResetStats( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+#endif
+
+/*
+ * Only available when configUSE_OBJECT_READY_NOTIFICATIONS is set to 1.
+ *
+ * Register a task to be told when an item is posted to a queue, or when a
+ * semaphore or mutex is given.  Each post ORs ulBitsToSet into the
+ * notification value of xTaskToNotify as if by
+ * xTaskNotify( xTaskToNotify, ulBitsToSet, eSetBits ).  If the queue already
+ * holds items the task is notified at once.  Passing NULL as xTaskToNotify
+ * removes the registration.
+ *
+ * Unlike a queue set, which queues the handle of every member each time it is
+ * posted to, this costs a constant time per post however many objects the task
+ * waits on.  Give each object a different bit, including the stream buffers
+ * and event groups registered with vStreamBufferSetReadyNotification() and
+ * vEventGroupSetReadyNotification(), then wait on all of them at once with:
+ *
+ * xTaskNotifyWait( 0, ulAllBits, &ulReadyBits, xTicksToWait );
+ *
+ * ulReadyBits then holds the bit of every object that became ready while the
+ * task was blocked.  Read each of those objects, with a block time of 0, until
+ * it is empty - an object that still holds data after its bit has been cleared
+ * is not reported again until it is next posted to.  Bits not used for objects
+ * remain available for direct to task notifications.
+ *
+ * Only one task can be registered with an object at a time.
+ */
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	void vQueueSetReadyNotification( QueueHandle_t xQueue, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Utilities to query queues that are safe to use from an ISR.  These utilities
  * should be used only from witin an ISR, or within a critical section.
@@ -1426,6 +1620,17 @@ TaskHandle_t xQueueGetMutexHolderFromISR( QueueHandle_t xSemaphore ) PRIVILEGED_
 BaseType_t xQueueTakeMutexRecursive( QueueHandle_t xMutex, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
 BaseType_t xQueueGiveMutexRecursive( QueueHandle_t xMutex ) PRIVILEGED_FUNCTION;
 
+/*
+ * For internal use only.  Use xSemaphoreCreateRWLock(), xSemaphoreTakeRead(),
+ * etc. instead of calling these functions directly.
+ */
+QueueRWLockHandle_t xQueueCreateRWLock( void ) PRIVILEGED_FUNCTION;
+void vQueueDeleteRWLock( QueueRWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+BaseType_t xQueueRWLockTakeRead( QueueRWLockHandle_t xRWLock, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+void vQueueRWLockGiveRead( QueueRWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+BaseType_t xQueueRWLockTakeWrite( QueueRWLockHandle_t xRWLock, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+BaseType_t xQueueRWLockGiveWrite( QueueRWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+
 /*
  * Reset a queue back to its original empty state.  The return value is now
  * obsolete and is always set to pdPASS.
@@ -1487,6 +1692,18 @@ BaseType_t xQueueGiveMutexRecursive( QueueHandle_t xMutex ) PRIVILEGED_FUNCTION;
 	const char *pcQueueGetName( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 #endif
 
+/*
+ * Looks up the handle of a queue, semaphore or mutex in the queue registry from
+ * the name it was added with, which is the reverse of pcQueueGetName().
+ *
+ * @param pcQueueName The name passed to vQueueAddToRegistry().
+ * @return The handle of the first queue in the registry with that name, or
+ * NULL if there is none.
+ */
+#if( configQUEUE_REGISTRY_SIZE > 0 )
+	QueueHandle_t xQueueGetHandleFromName( const char *pcQueueName ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif
+
 /*
  * Generic version of the function used to creaet a queue using dynamic memory
  * allocation.  This is called by other functions and macros that create other
@@ -35,6 +35,7 @@
 #include "queue.h"
 
 typedef QueueHandle_t SemaphoreHandle_t;
+typedef QueueRWLockHandle_t RWLockHandle_t;
 
 #define semBINARY_SEMAPHORE_QUEUE_LENGTH	( ( uint8_t ) 1U )
 #define semSEMAPHORE_QUEUE_ITEM_LENGTH		( ( uint8_t ) 0U )
@@ -1135,6 +1136,112 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define uxSemaphoreGetCount( xSemaphore ) uxQueueMessagesWaiting( ( QueueHandle_t ) ( xSemaphore ) )
 
+/**
+ * semphr.h
+ * <pre>UBaseType_t uxSemaphoreGetContentionCount( SemaphoreHandle_t xSemaphore );</pre>
+ *
+ * Returns the number of calls to xSemaphoreTake() on xSemaphore that found it
+ * unavailable, whether they then blocked or not.  For a mutex that is the
+ * number of times another task held it, which shows which locks are worth
+ * splitting or shortening.  configUSE_SEMAPHORE_CONTENTION_STATS must be set
+ * to 1 in FreeRTOSConfig.h for this macro to be available.
+ */
+#if( configUSE_SEMAPHORE_CONTENTION_STATS == 1 )
+	#define uxSemaphoreGetContentionCount( xSemaphore ) uxQueueGetContentionCount( ( QueueHandle_t ) ( xSemaphore ) )
+#endif
+
+/**
+ * semphr.h
+ * <pre>void vSemaphoreGetStats( SemaphoreHandle_t xSemaphore, QueueStats_t *pxStats );</pre>
+ *
+ * Copies the contention statistics of a semaphore or mutex: how many takes
+ * and gives blocked, for how long, how often a blocked take raised the
+ * priority of a mutex holder, and the highest count reached.  See
+ * vQueueGetStats().  configUSE_QUEUE_CONTENTION_STATS must be set to 1 in
+ * FreeRTOSConfig.h for this macro to be available.
+ */
+#if( configUSE_QUEUE_CONTENTION_STATS == 1 )
+	#define vSemaphoreGetStats( xSemaphore, pxStats ) vQueueGetStats( ( QueueHandle_t ) ( xSemaphore ), ( pxStats ) )
+#endif
+
+/**
+ * semphr. h
+ * <pre>RWLockHandle_t xSemaphoreCreateRWLock( void )</pre>
+ *
+ * Creates a reader/writer lock, and returns a handle by which the lock can be
+ * referenced.  Any number of tasks can hold the lock for reading at the same
+ * time, using xSemaphoreTakeRead() and xSemaphoreGiveRead(), or one task can
+ * hold it for writing, using xSemaphoreTakeWrite() and xSemaphoreGiveWrite().
+ * This suits structures that are looked up often and changed rarely.
+ *
+ * Writers are preferred: once a writer is waiting, tasks that want to read
+ * wait until the writer has given the lock back.  The lock is built on a
+ * mutex that is held by the writer, so a writer inherits the priority of the
+ * tasks that wait for it, as with xSemaphoreCreateMutex().  Readers do not
+ * inherit priorities, as there can be many of them, so reading should only
+ * be done for short periods.
+ *
+ * configUSE_RW_LOCKS must be set to 1 in FreeRTOSConfig.h, and the lock is
+ * allocated from the FreeRTOS heap.  A lock must not be taken recursively, and
+ * these functions must not be used from an interrupt.
+ *
+ * @return If the lock was created then a handle to the lock is returned.  If
+ * there was not enough heap to allocate the lock then NULL is returned.
+ *
+ * Example usage:
+ <pre>
+ RWLockHandle_t xCacheLock;
+
+ void vLookUp( void )
+ {
+     if( xSemaphoreTakeRead( xCacheLock, pdMS_TO_TICKS( 10 ) ) == pdTRUE )
+     {
+         // Read the cache, other readers may be doing the same.
+         xSemaphoreGiveRead( xCacheLock );
+     }
+ }
+
+ void vUpdate( void )
+ {
+     if( xSemaphoreTakeWrite( xCacheLock, portMAX_DELAY ) == pdTRUE )
+     {
+         // Change the cache, no other task is reading or writing it.
+         xSemaphoreGiveWrite( xCacheLock );
+     }
+ }
+ </pre>
+ * \defgroup xSemaphoreCreateRWLock xSemaphoreCreateRWLock
+ * \ingroup Semaphores
+ */
+#if( ( configUSE_RW_LOCKS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+	#define xSemaphoreCreateRWLock() xQueueCreateRWLock()
+	#define vSemaphoreDeleteRWLock( xRWLock ) vQueueDeleteRWLock( ( xRWLock ) )
+
+	/**
+	 * Take the lock for reading, waiting at most xBlockTime ticks while a
+	 * writer holds it or waits for it.  Returns pdTRUE if the lock was taken.
+	 */
+	#define xSemaphoreTakeRead( xRWLock, xBlockTime ) xQueueRWLockTakeRead( ( xRWLock ), ( xBlockTime ) )
+
+	/**
+	 * Give back a lock taken with xSemaphoreTakeRead().
+	 */
+	#define xSemaphoreGiveRead( xRWLock ) vQueueRWLockGiveRead( ( xRWLock ) )
+
+	/**
+	 * Take the lock for writing, waiting at most xBlockTime ticks for other
+	 * writers and then for the readers to give the lock back.  Returns pdTRUE
+	 * if the lock was taken.
+	 */
+	#define xSemaphoreTakeWrite( xRWLock, xBlockTime ) xQueueRWLockTakeWrite( ( xRWLock ), ( xBlockTime ) )
+
+	/**
+	 * Give back a lock taken with xSemaphoreTakeWrite().  Must be called by
+	 * the task that took it.
+	 */
+	#define xSemaphoreGiveWrite( xRWLock ) xQueueRWLockGiveWrite( ( xRWLock ) )
+#endif /* configUSE_RW_LOCKS */
+
 #endif /* SEMAPHORE_H */
 
 
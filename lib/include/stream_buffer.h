@@ -55,6 +55,8 @@
 extern "C" {
 #endif
 
+#include "task.h"
+
 /**
  * Type by which stream buffers are referenced.  For example, a call to
  * xStreamBufferCreate() returns an StreamBufferHandle_t variable that can
@@ -829,6 +831,129 @@ BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuf
  */
 BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferReserve( StreamBufferHandle_t xStreamBuffer, uint8_t **ppucData );
+void vStreamBufferCommit( StreamBufferHandle_t xStreamBuffer, size_t xCount );
+void vStreamBufferCommitFromISR( StreamBufferHandle_t xStreamBuffer, size_t xCount, BaseType_t * const pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * Write to a stream buffer in place, without copying the data through an
+ * intermediate buffer.  xStreamBufferReserve() sets *ppucData to the next free
+ * byte of the buffer and returns how many bytes can be written there
+ * contiguously.  After writing up to that many bytes, the writer makes them
+ * visible to the reader with vStreamBufferCommit(), or
+ * vStreamBufferCommitFromISR() from an interrupt.  If the free space wraps
+ * round the end of the buffer, a second reserve after the commit returns the
+ * rest.  These functions never block and never mask interrupts unless a task
+ * is waiting to be notified.  They can be used from tasks and from interrupts
+ * (xStreamBufferReserve() in both cases), so a DMA or UART interrupt can fill
+ * the buffer directly.
+ *
+ * They may only be used on stream buffers, not on message buffers, and only by
+ * the single writer of the buffer.
+ *
+ * @param xStreamBuffer The handle of the stream buffer.
+ *
+ * @param ppucData Set to the address at which data can be written.
+ *
+ * @param xCount The number of bytes written at the address returned by the
+ * last xStreamBufferReserve(), which must not be more than it returned.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if committing the data woke a
+ * task with a priority above the priority of the interrupted task.
+ *
+ * @return The number of bytes that can be written at *ppucData.
+ *
+ * \defgroup xStreamBufferReserve xStreamBufferReserve
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReserve( StreamBufferHandle_t xStreamBuffer, uint8_t **ppucData ) PRIVILEGED_FUNCTION;
+void vStreamBufferCommit( StreamBufferHandle_t xStreamBuffer, size_t xCount ) PRIVILEGED_FUNCTION;
+void vStreamBufferCommitFromISR( StreamBufferHandle_t xStreamBuffer, size_t xCount, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferPeekContiguous( StreamBufferHandle_t xStreamBuffer, const uint8_t **ppucData, TickType_t xTicksToWait );
+void vStreamBufferConsume( StreamBufferHandle_t xStreamBuffer, size_t xCount );
+void vStreamBufferConsumeFromISR( StreamBufferHandle_t xStreamBuffer, size_t xCount, BaseType_t * const pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * Read from a stream buffer in place, the counterpart of
+ * xStreamBufferReserve().  xStreamBufferPeekContiguous() sets *ppucData to the
+ * oldest byte in the buffer and returns how many bytes can be read there
+ * contiguously.  vStreamBufferConsume(), or vStreamBufferConsumeFromISR() from
+ * an interrupt, then frees the first xCount of them.  A task may wait up to
+ * xTicksToWait for data to arrive, an interrupt must pass 0.  As with
+ * xStreamBufferReceive(), the wait ends once the trigger level is reached.
+ *
+ * They may only be used on stream buffers, not on message buffers, and only by
+ * the single reader of the buffer.
+ *
+ * @param xStreamBuffer The handle of the stream buffer.
+ *
+ * @param ppucData Set to the address from which data can be read.
+ *
+ * @param xTicksToWait The maximum time to wait for data if the buffer is empty.
+ *
+ * @param xCount The number of bytes to free, which must not be more than the
+ * last xStreamBufferPeekContiguous() returned.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if freeing the space woke a
+ * task with a priority above the priority of the interrupted task.
+ *
+ * @return The number of bytes that can be read at *ppucData, which is 0 if the
+ * buffer is still empty when xTicksToWait expires.
+ *
+ * \defgroup xStreamBufferPeekContiguous xStreamBufferPeekContiguous
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferPeekContiguous( StreamBufferHandle_t xStreamBuffer, const uint8_t **ppucData, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+void vStreamBufferConsume( StreamBufferHandle_t xStreamBuffer, size_t xCount ) PRIVILEGED_FUNCTION;
+void vStreamBufferConsumeFromISR( StreamBufferHandle_t xStreamBuffer, size_t xCount, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+void vStreamBufferSetReadyNotification( StreamBufferHandle_t xStreamBuffer, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet );
+</pre>
+ *
+ * Only available when configUSE_OBJECT_READY_NOTIFICATIONS is set to 1.
+ *
+ * Register a task to be told when data can be read from a stream or message
+ * buffer.  Each time a send leaves at least the trigger level number of bytes
+ * in the buffer, ulBitsToSet is ORed into the notification value of
+ * xTaskToNotify as if by xTaskNotify( xTaskToNotify, ulBitsToSet, eSetBits ).
+ * If the buffer already holds enough data the task is notified at once.
+ *
+ * Giving each buffer, queue, semaphore and event group the task waits on a
+ * different bit lets the task wait on all of them with a single call to
+ * xTaskNotifyWait(), which returns the bits of every object that became ready
+ * while it was blocked.  The task must then read each of those objects until
+ * it is empty, as an object that still holds data when the bit is cleared is
+ * not reported again until the next send to it.
+ *
+ * Only one task can be registered at a time.  Passing NULL as xTaskToNotify
+ * removes the registration.
+ *
+ * @param xStreamBuffer The handle of the stream or message buffer.
+ *
+ * @param xTaskToNotify The task to notify, or NULL.
+ *
+ * @param ulBitsToSet The bits to set in the notification value of the task.
+ *
+ * \defgroup vStreamBufferSetReadyNotification vStreamBufferSetReadyNotification
+ * \ingroup StreamBufferManagement
+ */
+#if( configUSE_OBJECT_READY_NOTIFICATIONS == 1 )
+	void vStreamBufferSetReadyNotification( StreamBufferHandle_t xStreamBuffer, TaskHandle_t xTaskToNotify, uint32_t ulBitsToSet ) PRIVILEGED_FUNCTION;
+#endif
+
 /* Functions below here are not part of the public API. */
 StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes,
 												 size_t xTriggerLevelBytes,
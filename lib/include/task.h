@@ -69,6 +69,12 @@ extern "C" {
 struct tskTaskControlBlock; /* The old naming convention is used to prevent breaking kernel aware debuggers. */
 typedef struct tskTaskControlBlock* TaskHandle_t;
 
+/*
+ * Type by which arenas are referenced, see xTaskArenaCreateStatic().
+ */
+struct tskTaskArena;
+typedef struct tskTaskArena* TaskArenaHandle_t;
+
 /*
  * Defines the prototype to which the application task hook function must
  * conform.
@@ -147,6 +153,39 @@ typedef struct xTASK_STATUS
 	configSTACK_DEPTH_TYPE usStackHighWaterMark;	/* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
+/* The position of uxTaskGetSystemStateIncremental() among the tasks.  Set up
+with vTaskIteratorInit() and otherwise only used by the kernel. */
+typedef struct xTASK_ITERATOR
+{
+	void *pvLastItem;				/* The task list item of the task reported last, or NULL. */
+	UBaseType_t uxLastTaskNumber;	/* The xTaskNumber of the task reported last. */
+	UBaseType_t uxGeneration;		/* The number of task deletions when the task was reported. */
+} TaskIterator_t;
+
+/* Used with the uxTaskGetRunTimeStatsSnapshot() function to obtain the run
+time counters of each task in the system.  All times are in units of the run
+time stats clock. */
+typedef struct xTASK_RUN_TIME_STATS
+{
+	TaskHandle_t xHandle;			/* The handle of the task to which the rest of the information in the structure relates. */
+	uint32_t ulRunTimeCounter;		/* The total run time allocated to the task so far. */
+	uint32_t ulSwitchInCount;		/* The number of times the task has been switched in. */
+	uint32_t ulPreemptionCount;		/* The number of times the task has been switched out while it was still ready to run, because it was preempted or yielded. */
+	uint32_t ulLongestRunTime;		/* The longest time the task has run before being switched out. */
+} TaskRunTimeStats_t;
+
+/* Used with the vTaskGetTicklessIdleStats() function to obtain the low power
+idle statistics.  Sleep depths are the values returned by
+configSELECT_SLEEP_DEPTH(), or 0 when configUSE_SLEEP_LATENCY_TOLERANCE is not
+set to 1. */
+typedef struct xTICKLESS_IDLE_STATS
+{
+	uint32_t ulSleepEntries;	/* The number of times portSUPPRESS_TICKS_AND_SLEEP() was called. */
+	uint32_t ulSleepAborts;		/* The number of times eTaskConfirmSleepModeStatus() returned eAbortSleep, so no sleep mode was entered. */
+	uint32_t ulDepthEntries[ configTICKLESS_IDLE_SLEEP_DEPTHS ];	/* The number of times portSUPPRESS_TICKS_AND_SLEEP() was called at each sleep depth. */
+	uint32_t ulDepthResidency[ configTICKLESS_IDLE_SLEEP_DEPTHS ];	/* The number of ticks that passed inside portSUPPRESS_TICKS_AND_SLEEP() at each sleep depth. */
+} TicklessIdleStats_t;
+
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
 typedef enum
 {
@@ -162,6 +201,20 @@ typedef enum
  */
 #define tskIDLE_PRIORITY			( ( UBaseType_t ) 0U )
 
+/*
+ * The notification index used by the task notification API functions that do
+ * not take an index.
+ */
+#define tskDEFAULT_INDEX_TO_NOTIFY	( 0 )
+
+/**
+ * The sleep latency tolerance of a task that does not constrain the sleep
+ * depth.  See vTaskSetSleepLatencyTolerance().
+ *
+ * \ingroup TaskUtils
+ */
+#define tskNO_LATENCY_CONSTRAINT	( ( uint32_t ) 0xffffffffUL )
+
 /**
  * task. h
  *
@@ -757,6 +810,31 @@ void vTaskDelete( TaskHandle_t xTaskToDelete ) PRIVILEGED_FUNCTION;
  */
 void vTaskDelay( const TickType_t xTicksToDelay ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * <pre>void vTaskDelayWithSlack( const TickType_t xTicksToDelay, const TickType_t xSlack );</pre>
+ *
+ * INCLUDE_vTaskDelay and configUSE_TIMER_SLACK must be defined as 1 for this
+ * function to be available.
+ *
+ * Like vTaskDelay(), but the task may remain blocked for up to xSlack ticks
+ * longer.  The task wakes up together with the first task (or software timer)
+ * that is already due to unblock within that window.  If there is none it
+ * wakes up at the end of the window, so that delays started later can still
+ * join it.  With configUSE_TICKLESS_IDLE this reduces the number of times the
+ * CPU wakes up.
+ *
+ * @param xTicksToDelay The minimum amount of time, in tick periods, that the
+ * calling task should block.
+ *
+ * @param xSlack The number of tick periods by which the wake up may be
+ * postponed.  0 behaves as vTaskDelay().
+ *
+ * \defgroup vTaskDelayWithSlack vTaskDelayWithSlack
+ * \ingroup TaskCtrl
+ */
+void vTaskDelayWithSlack( const TickType_t xTicksToDelay, const TickType_t xSlack ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * <pre>void vTaskDelayUntil( TickType_t *pxPreviousWakeTime, const TickType_t xTimeIncrement );</pre>
@@ -1463,6 +1541,28 @@ UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask ) PRIVILEGED_FUNCTIO
  */
 configSTACK_DEPTH_TYPE uxTaskGetStackHighWaterMark2( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
 
+/**
+ * task.h
+ * <PRE>void vTaskGetPoolStats( ObjectPoolStats_t *pxStats );</PRE>
+ *
+ * configTASK_POOL_SIZE must be greater than 0 for this function to be
+ * available.
+ *
+ * When a task created with xTaskCreate() is deleted, its TCB and stack are
+ * kept in a pool of up to configTASK_POOL_SIZE tasks instead of being freed.
+ * xTaskCreate() then reuses the pooled task with the smallest stack that is
+ * deep enough, if it is no more than configTASK_POOL_STACK_SLACK_PERCENT
+ * deeper than requested, and only allocates when none fits.  Tasks that
+ * deleted themselves are reclaimed by the next xTaskCreate() rather than
+ * waiting for the idle task.
+ *
+ * @param pxStats Filled in with the use of the task pool.
+ *
+ * \defgroup vTaskGetPoolStats vTaskGetPoolStats
+ * \ingroup TaskUtils
+ */
+void vTaskGetPoolStats( ObjectPoolStats_t *pxStats ) PRIVILEGED_FUNCTION;
+
 /* When using trace macros it is sometimes necessary to include task.h before
 FreeRTOS.h.  When this is done TaskHookFunction_t will not yet have been defined,
 so the following two prototypes will cause a compilation error.  This can be
@@ -1514,6 +1614,150 @@ constant. */
 
 #endif
 
+#if( configUSE_TASK_ARENAS == 1 )
+
+	/**
+	 * task.h
+	 * <pre>TaskArenaHandle_t xTaskArenaCreateStatic( uint8_t *pucArenaStorage, size_t xArenaSizeBytes, StaticTaskArena_t *pxStaticArena );</pre>
+	 *
+	 * Create an arena: a region of memory from which blocks are handed out by
+	 * simply moving a pointer forward.  Blocks are not freed individually,
+	 * all of them are released at once by vTaskArenaReset().  This is much
+	 * faster than pvPortMalloc() and vPortFree(), and the many short lived
+	 * blocks of, for instance, a TLS handshake do not fragment the heap.
+	 *
+	 * An arena can be used directly with pvTaskArenaAllocate(), or it can be
+	 * bound to a task with xTaskArenaBind(), in which case pvPortMalloc() calls
+	 * from that task are served from the arena.  Only heap_4.c, heap_5.c and
+	 * heap_6.c support bound arenas.
+	 *
+	 * @param pucArenaStorage The memory from which blocks are allocated.
+	 *
+	 * @param xArenaSizeBytes The size of pucArenaStorage in bytes.
+	 *
+	 * @param pxStaticArena Memory of type StaticTaskArena_t which holds the
+	 * arena's data structure.
+	 *
+	 * @return The handle of the arena, or NULL if a parameter is NULL.
+	 */
+	TaskArenaHandle_t xTaskArenaCreateStatic( uint8_t *pucArenaStorage, size_t xArenaSizeBytes, StaticTaskArena_t *pxStaticArena ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>void vTaskArenaDelete( TaskArenaHandle_t xArena );</pre>
+	 *
+	 * Remove an arena from the kernel's administration, after which its storage
+	 * can be re-used.  The arena must not be bound to any task.
+	 */
+	void vTaskArenaDelete( TaskArenaHandle_t xArena ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>void *pvTaskArenaAllocate( TaskArenaHandle_t xArena, size_t xWantedSize );</pre>
+	 *
+	 * Take a block of xWantedSize bytes, aligned to portBYTE_ALIGNMENT, from the
+	 * arena.  Returns NULL when the arena does not have enough space left.  An
+	 * arena has no locking: it must only be used by one task at a time.
+	 */
+	void *pvTaskArenaAllocate( TaskArenaHandle_t xArena, size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>void vTaskArenaReset( TaskArenaHandle_t xArena );</pre>
+	 *
+	 * Release all blocks of an arena at once.  After a reset, none of the
+	 * blocks that were obtained from the arena may be used any more.
+	 */
+	void vTaskArenaReset( TaskArenaHandle_t xArena ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>size_t xTaskArenaGetHighWaterMark( TaskArenaHandle_t xArena );</pre>
+	 *
+	 * Returns the highest number of bytes that has been in use in the arena,
+	 * which helps to find the right size for it.
+	 */
+	size_t xTaskArenaGetHighWaterMark( TaskArenaHandle_t xArena ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>TaskArenaHandle_t xTaskArenaBind( TaskArenaHandle_t xArena );</pre>
+	 *
+	 * Bind an arena to the calling task, or unbind the current arena when
+	 * xArena is NULL.  While an arena is bound, pvPortMalloc() calls from the
+	 * task are served from the arena, and fall back to the heap when the arena
+	 * is full.  vPortFree() of a block that belongs to an arena does nothing,
+	 * except when it is the last block handed out by an arena bound to the
+	 * calling task, in which case its space is re-used.  So blocks from an
+	 * arena may safely be passed to vPortFree() by any task, until the arena is
+	 * reset.
+	 *
+	 * @return The arena that was bound before, so that calls can be nested.
+	 *
+	 * Example usage:
+	   <pre>
+	   xPrevious = xTaskArenaBind( xArena );
+	   vParseDocument();	// All pvPortMalloc() calls are served by xArena.
+	   ( void ) xTaskArenaBind( xPrevious );
+	   vTaskArenaReset( xArena );
+	   </pre>
+	 */
+	TaskArenaHandle_t xTaskArenaBind( TaskArenaHandle_t xArena ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TASK_ARENAS */
+
+#if( configUSE_SLEEP_LATENCY_TOLERANCE == 1 )
+
+	/**
+	 * task.h
+	 * <pre>void vTaskSetSleepLatencyTolerance( TaskHandle_t xTask, uint32_t ulLatencyTolerance );</pre>
+	 *
+	 * Set the longest wake up latency a task tolerates while it is blocked.
+	 * Before the idle task enters a low power mode it passes the smallest
+	 * tolerance of all the blocked and suspended tasks, together with the
+	 * expected idle time, to configSELECT_SLEEP_DEPTH(), which returns the
+	 * sleep depth to use.  The units are whatever configSELECT_SLEEP_DEPTH()
+	 * expects, for example microseconds.  tskNO_LATENCY_CONSTRAINT, the
+	 * default, places no constraint on the sleep depth.  Passing xTask as
+	 * NULL sets the tolerance of the calling task.
+	 */
+	void vTaskSetSleepLatencyTolerance( TaskHandle_t xTask, uint32_t ulLatencyTolerance ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>UBaseType_t uxTaskGetSleepDepth( void );</pre>
+	 *
+	 * Returns the sleep depth selected by configSELECT_SLEEP_DEPTH() for the
+	 * current call to portSUPPRESS_TICKS_AND_SLEEP(), so the port or
+	 * configPRE_SLEEP_PROCESSING() can enter the matching low power mode.
+	 */
+	UBaseType_t uxTaskGetSleepDepth( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_SLEEP_LATENCY_TOLERANCE */
+
+#if( configUSE_TICKLESS_IDLE_STATS == 1 )
+
+	/**
+	 * task.h
+	 * <pre>void vTaskGetTicklessIdleStats( TicklessIdleStats_t * const pxStats );</pre>
+	 *
+	 * Copies the low power idle statistics into pxStats.  The statistics show
+	 * how often the idle task tried to sleep, how often the attempt was
+	 * aborted because a task became ready, and how many ticks were spent
+	 * asleep at each sleep depth.
+	 */
+	void vTaskGetTicklessIdleStats( TicklessIdleStats_t * const pxStats ) PRIVILEGED_FUNCTION;
+
+	/**
+	 * task.h
+	 * <pre>void vTaskClearTicklessIdleStats( void );</pre>
+	 *
+	 * Sets all the low power idle statistics back to zero.
+	 */
+	void vTaskClearTicklessIdleStats( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TICKLESS_IDLE_STATS */
+
 /**
  * task.h
  * <pre>BaseType_t xTaskCallApplicationTaskHook( TaskHandle_t xTask, void *pvParameter );</pre>
@@ -1635,6 +1879,87 @@ TaskHandle_t xTaskGetIdleTaskHandle( void ) PRIVILEGED_FUNCTION;
  */
 UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime ) PRIVILEGED_FUNCTION;
 
+/**
+ * configUSE_TASK_ITERATOR must be defined as 1 in FreeRTOSConfig.h for
+ * vTaskIteratorInit() and uxTaskGetSystemStateIncremental() to be available.
+ *
+ * uxTaskGetSystemStateIncremental() fills in the same TaskStatus_t structures
+ * as uxTaskGetSystemState(), but only for the next uxArraySize tasks after
+ * those reported by previous calls with the same iterator, so the scheduler is
+ * only suspended while uxArraySize tasks are inspected.  Tasks are reported in
+ * the order they were created.  A task created before the iteration gets to it
+ * is reported, and a task deleted before the iteration gets to it is not.
+ * Iterating again finds one task at most once, even if tasks are deleted
+ * between calls.
+ *
+ * @param pxIterator The position of the iteration, set up by
+ * vTaskIteratorInit() before the first call.
+ *
+ * @param pxTaskStatusArray A pointer to an array of uxArraySize TaskStatus_t
+ * structures.
+ *
+ * @param uxArraySize The most tasks to report.
+ *
+ * @param pulTotalRunTime As for uxTaskGetSystemState(), at the time of this
+ * call.  Can be NULL.
+ *
+ * @return The number of TaskStatus_t structures that were populated, which is
+ * zero once all tasks have been reported.
+ *
+ * Example usage:
+   <pre>
+	TaskIterator_t xIterator;
+	TaskStatus_t xStatus[ 4 ];
+	UBaseType_t uxCount, x;
+
+		vTaskIteratorInit( &xIterator );
+
+		while( ( uxCount = uxTaskGetSystemStateIncremental( &xIterator, xStatus, 4, NULL ) ) > 0 )
+		{
+			for( x = 0; x < uxCount; x++ )
+			{
+				// Process xStatus[ x ].  Other tasks can run between the calls.
+			}
+		}
+   </pre>
+ */
+void vTaskIteratorInit( TaskIterator_t * const pxIterator ) PRIVILEGED_FUNCTION;
+UBaseType_t uxTaskGetSystemStateIncremental( TaskIterator_t * const pxIterator, TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <PRE>UBaseType_t uxTaskGetRunTimeStatsSnapshot( TaskRunTimeStats_t * const pxStatsArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime );</PRE>
+ *
+ * configUSE_EXTENDED_RUN_TIME_STATS must be defined as 1 for this function to
+ * be available.
+ *
+ * Copies the run time counters of up to uxArraySize tasks into pxStatsArray,
+ * for sampling CPU usage from production code.  Unlike
+ * uxTaskGetSystemState() it neither measures the stack high water marks nor
+ * formats anything, and it fills as much of the array as fits, so the time
+ * the scheduler stays suspended is short and bounded.  Tasks that have been
+ * deleted but not yet cleaned up by the idle task are not included.
+ *
+ * The counters come from the run time stats clock, so cycle-accurate figures
+ * are obtained by defining portGET_RUN_TIME_COUNTER_VALUE() to read a cycle
+ * counter, such as the DWT CYCCNT register on Cortex-M3/M4/M7 parts.
+ *
+ * @param pxStatsArray An array of TaskRunTimeStats_t structures.
+ *
+ * @param uxArraySize The number of structures in pxStatsArray.
+ *
+ * @param pulTotalRunTime If not NULL, set to the run time stats clock value
+ * at the time the snapshot was taken.
+ *
+ * @return The number of structures that were filled in.
+ *
+ * \defgroup uxTaskGetRunTimeStatsSnapshot uxTaskGetRunTimeStatsSnapshot
+ * \ingroup TaskUtils
+ */
+#if( configUSE_EXTENDED_RUN_TIME_STATS == 1 )
+	UBaseType_t uxTaskGetRunTimeStatsSnapshot( TaskRunTimeStats_t * const pxStatsArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime ) PRIVILEGED_FUNCTION;
+#endif
+
 /**
  * task. h
  * <PRE>void vTaskList( char *pcWriteBuffer );</PRE>
@@ -1769,6 +2094,7 @@ TickType_t xTaskGetIdleRunTimeCounter( void ) PRIVILEGED_FUNCTION;
 /**
  * task. h
  * <PRE>BaseType_t xTaskNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction );</PRE>
+ * <PRE>BaseType_t xTaskNotifyIndexed( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction );</PRE>
  *
  * configUSE_TASK_NOTIFICATIONS must be undefined or defined as 1 for this
  * function to be available.
@@ -1776,6 +2102,15 @@ TickType_t xTaskGetIdleRunTimeCounter( void ) PRIVILEGED_FUNCTION;
  * When configUSE_TASK_NOTIFICATIONS is set to one each task has its own private
  * "notification value", which is a 32-bit unsigned integer (uint32_t).
  *
+ * Each task in fact holds an array of configTASK_NOTIFICATION_ARRAY_ENTRIES
+ * notification values, each with its own pending state.  The functions without
+ * "Indexed" in their name act on index tskDEFAULT_INDEX_TO_NOTIFY, which the
+ * kernel also uses for stream and message buffers.  The "Indexed" variants
+ * take the index to use, so that a library can wait on a channel of its own
+ * without disturbing another user of the task's notifications.  A task waits
+ * on one index at a time, and is only unblocked by a notification sent to
+ * that index.
+ *
  * Events can be sent to a task using an intermediary object.  Examples of such
  * objects are queues, semaphores, mutexes and event groups.  Task notifications
  * are a method of sending an event directly to a task without the need for such
@@ -1845,9 +2180,11 @@ TickType_t xTaskGetIdleRunTimeCounter( void ) PRIVILEGED_FUNCTION;
  * \defgroup xTaskNotify xTaskNotify
  * \ingroup TaskNotifications
  */
-BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue ) PRIVILEGED_FUNCTION;
-#define xTaskNotify( xTaskToNotify, ulValue, eAction ) xTaskGenericNotify( ( xTaskToNotify ), ( ulValue ), ( eAction ), NULL )
-#define xTaskNotifyAndQuery( xTaskToNotify, ulValue, eAction, pulPreviousNotifyValue ) xTaskGenericNotify( ( xTaskToNotify ), ( ulValue ), ( eAction ), ( pulPreviousNotifyValue ) )
+BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue ) PRIVILEGED_FUNCTION;
+#define xTaskNotify( xTaskToNotify, ulValue, eAction ) xTaskGenericNotify( ( xTaskToNotify ), ( tskDEFAULT_INDEX_TO_NOTIFY ), ( ulValue ), ( eAction ), NULL )
+#define xTaskNotifyIndexed( xTaskToNotify, uxIndexToNotify, ulValue, eAction ) xTaskGenericNotify( ( xTaskToNotify ), ( uxIndexToNotify ), ( ulValue ), ( eAction ), NULL )
+#define xTaskNotifyAndQuery( xTaskToNotify, ulValue, eAction, pulPreviousNotifyValue ) xTaskGenericNotify( ( xTaskToNotify ), ( tskDEFAULT_INDEX_TO_NOTIFY ), ( ulValue ), ( eAction ), ( pulPreviousNotifyValue ) )
+#define xTaskNotifyAndQueryIndexed( xTaskToNotify, uxIndexToNotify, ulValue, eAction, pulPreviousNotifyValue ) xTaskGenericNotify( ( xTaskToNotify ), ( uxIndexToNotify ), ( ulValue ), ( eAction ), ( pulPreviousNotifyValue ) )
 
 /**
  * task. h
@@ -1936,13 +2273,16 @@ BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNo
  * \defgroup xTaskNotify xTaskNotify
  * \ingroup TaskNotifications
  */
-BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
-#define xTaskNotifyFromISR( xTaskToNotify, ulValue, eAction, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( ulValue ), ( eAction ), NULL, ( pxHigherPriorityTaskWoken ) )
-#define xTaskNotifyAndQueryFromISR( xTaskToNotify, ulValue, eAction, pulPreviousNotificationValue, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( ulValue ), ( eAction ), ( pulPreviousNotificationValue ), ( pxHigherPriorityTaskWoken ) )
+BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+#define xTaskNotifyFromISR( xTaskToNotify, ulValue, eAction, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( tskDEFAULT_INDEX_TO_NOTIFY ), ( ulValue ), ( eAction ), NULL, ( pxHigherPriorityTaskWoken ) )
+#define xTaskNotifyIndexedFromISR( xTaskToNotify, uxIndexToNotify, ulValue, eAction, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( uxIndexToNotify ), ( ulValue ), ( eAction ), NULL, ( pxHigherPriorityTaskWoken ) )
+#define xTaskNotifyAndQueryFromISR( xTaskToNotify, ulValue, eAction, pulPreviousNotificationValue, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( tskDEFAULT_INDEX_TO_NOTIFY ), ( ulValue ), ( eAction ), ( pulPreviousNotificationValue ), ( pxHigherPriorityTaskWoken ) )
+#define xTaskNotifyAndQueryIndexedFromISR( xTaskToNotify, uxIndexToNotify, ulValue, eAction, pulPreviousNotificationValue, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( uxIndexToNotify ), ( ulValue ), ( eAction ), ( pulPreviousNotificationValue ), ( pxHigherPriorityTaskWoken ) )
 
 /**
  * task. h
  * <PRE>BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait );</pre>
+ * <PRE>BaseType_t xTaskNotifyWaitIndexed( UBaseType_t uxIndexToWaitOn, uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait );</pre>
  *
  * configUSE_TASK_NOTIFICATIONS must be undefined or defined as 1 for this
  * function to be available.
@@ -2013,11 +2353,14 @@ BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulVal
  * \defgroup xTaskNotifyWait xTaskNotifyWait
  * \ingroup TaskNotifications
  */
-BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+BaseType_t xTaskGenericNotifyWait( UBaseType_t uxIndexToWait, uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+#define xTaskNotifyWait( ulBitsToClearOnEntry, ulBitsToClearOnExit, pulNotificationValue, xTicksToWait ) xTaskGenericNotifyWait( tskDEFAULT_INDEX_TO_NOTIFY, ( ulBitsToClearOnEntry ), ( ulBitsToClearOnExit ), ( pulNotificationValue ), ( xTicksToWait ) )
+#define xTaskNotifyWaitIndexed( uxIndexToWaitOn, ulBitsToClearOnEntry, ulBitsToClearOnExit, pulNotificationValue, xTicksToWait ) xTaskGenericNotifyWait( ( uxIndexToWaitOn ), ( ulBitsToClearOnEntry ), ( ulBitsToClearOnExit ), ( pulNotificationValue ), ( xTicksToWait ) )
 
 /**
  * task. h
  * <PRE>BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify );</PRE>
+ * <PRE>BaseType_t xTaskNotifyGiveIndexed( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify );</PRE>
  *
  * configUSE_TASK_NOTIFICATIONS must be undefined or defined as 1 for this macro
  * to be available.
@@ -2059,7 +2402,8 @@ BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClea
  * \defgroup xTaskNotifyGive xTaskNotifyGive
  * \ingroup TaskNotifications
  */
-#define xTaskNotifyGive( xTaskToNotify ) xTaskGenericNotify( ( xTaskToNotify ), ( 0 ), eIncrement, NULL )
+#define xTaskNotifyGive( xTaskToNotify ) xTaskGenericNotify( ( xTaskToNotify ), ( tskDEFAULT_INDEX_TO_NOTIFY ), ( 0 ), eIncrement, NULL )
+#define xTaskNotifyGiveIndexed( xTaskToNotify, uxIndexToNotify ) xTaskGenericNotify( ( xTaskToNotify ), ( uxIndexToNotify ), ( 0 ), eIncrement, NULL )
 
 /**
  * task. h
@@ -2114,11 +2458,14 @@ BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClea
  * \defgroup xTaskNotifyWait xTaskNotifyWait
  * \ingroup TaskNotifications
  */
-void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+void vTaskGenericNotifyGiveFromISR( TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+#define vTaskNotifyGiveFromISR( xTaskToNotify, pxHigherPriorityTaskWoken ) vTaskGenericNotifyGiveFromISR( ( xTaskToNotify ), ( tskDEFAULT_INDEX_TO_NOTIFY ), ( pxHigherPriorityTaskWoken ) )
+#define vTaskNotifyGiveIndexedFromISR( xTaskToNotify, uxIndexToNotify, pxHigherPriorityTaskWoken ) vTaskGenericNotifyGiveFromISR( ( xTaskToNotify ), ( uxIndexToNotify ), ( pxHigherPriorityTaskWoken ) )
 
 /**
  * task. h
  * <PRE>uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait );</pre>
+ * <PRE>uint32_t ulTaskNotifyTakeIndexed( UBaseType_t uxIndexToWaitOn, BaseType_t xClearCountOnExit, TickType_t xTicksToWait );</pre>
  *
  * configUSE_TASK_NOTIFICATIONS must be undefined or defined as 1 for this
  * function to be available.
@@ -2183,11 +2530,14 @@ void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPri
  * \defgroup ulTaskNotifyTake ulTaskNotifyTake
  * \ingroup TaskNotifications
  */
-uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+uint32_t ulTaskGenericNotifyTake( UBaseType_t uxIndexToWait, BaseType_t xClearCountOnExit, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+#define ulTaskNotifyTake( xClearCountOnExit, xTicksToWait ) ulTaskGenericNotifyTake( ( tskDEFAULT_INDEX_TO_NOTIFY ), ( xClearCountOnExit ), ( xTicksToWait ) )
+#define ulTaskNotifyTakeIndexed( uxIndexToWaitOn, xClearCountOnExit, xTicksToWait ) ulTaskGenericNotifyTake( ( uxIndexToWaitOn ), ( xClearCountOnExit ), ( xTicksToWait ) )
 
 /**
  * task. h
  * <PRE>BaseType_t xTaskNotifyStateClear( TaskHandle_t xTask );</pre>
+ * <PRE>BaseType_t xTaskNotifyStateClearIndexed( TaskHandle_t xTask, UBaseType_t uxIndexToClear );</pre>
  *
  * If the notification state of the task referenced by the handle xTask is
  * eNotified, then set the task's notification state to eNotWaitingNotification.
@@ -2199,12 +2549,30 @@ uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait
  * \defgroup xTaskNotifyStateClear xTaskNotifyStateClear
  * \ingroup TaskNotifications
  */
-BaseType_t xTaskNotifyStateClear( TaskHandle_t xTask );
+BaseType_t xTaskGenericNotifyStateClear( TaskHandle_t xTask, UBaseType_t uxIndexToClear ) PRIVILEGED_FUNCTION;
+#define xTaskNotifyStateClear( xTask ) xTaskGenericNotifyStateClear( ( xTask ), ( tskDEFAULT_INDEX_TO_NOTIFY ) )
+#define xTaskNotifyStateClearIndexed( xTask, uxIndexToClear ) xTaskGenericNotifyStateClear( ( xTask ), ( uxIndexToClear ) )
 
 /*-----------------------------------------------------------
  * SCHEDULER INTERNALS AVAILABLE FOR PORTING PURPOSES
  *----------------------------------------------------------*/
 
+#if( configUSE_TASK_ARENAS == 1 )
+
+	/*
+	 * THESE FUNCTIONS MUST NOT BE USED FROM APPLICATION CODE.  THEY ARE ONLY
+	 * INTENDED FOR USE BY THE pvPortMalloc() AND vPortFree() IMPLEMENTATIONS.
+	 *
+	 * pvTaskArenaMalloc() returns a block from the arena that is bound to the
+	 * calling task, or NULL if there is no arena or it is full.
+	 * xTaskArenaFree() returns pdTRUE if pv belongs to an arena, in which case
+	 * the heap must not free it.
+	 */
+	void *pvTaskArenaMalloc( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+	BaseType_t xTaskArenaFree( void *pv ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TASK_ARENAS */
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
  * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
@@ -2269,6 +2637,21 @@ void vTaskPlaceOnUnorderedEventList( List_t * pxEventList, const TickType_t xIte
  */
 void vTaskPlaceOnEventListRestricted( List_t * const pxEventList, TickType_t xTicksToWait, const BaseType_t xWaitIndefinitely ) PRIVILEGED_FUNCTION;
 
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED.
+ *
+ * Returns a block time between xTicksToWait and xTicksToWait + xSlack.  This
+ * is the time of the first task that is already due to unblock within that
+ * window, or the end of the window when there is none.  Used by
+ * vTaskDelayWithSlack() and by the timer service task to coalesce wake ups.
+ */
+#if( configUSE_TIMER_SLACK == 1 )
+	TickType_t xTaskGetCoalescedDelay( const TickType_t xTicksToWait, TickType_t xSlack ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
  * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
@@ -2296,6 +2679,24 @@ void vTaskPlaceOnEventListRestricted( List_t * const pxEventList, TickType_t xTi
 BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList ) PRIVILEGED_FUNCTION;
 void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem, const TickType_t xItemValue ) PRIVILEGED_FUNCTION;
 
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * A version of vTaskRemoveFromUnorderedEventList() that can be called from an
+ * interrupt, or from a task with the scheduler running.  If the scheduler is
+ * suspended the unblocked task is held on the pending ready list.  Used by the
+ * direct xEventGroupSetBitsFromISR() path.
+ *
+ * @return pdTRUE if the task being removed has a higher priority than the task
+ * that was interrupted, otherwise pdFALSE.
+ */
+#if( configEVENT_GROUP_SET_BITS_FROM_ISR_DIRECT == 1 )
+	BaseType_t xTaskRemoveFromUnorderedEventListFromISR( ListItem_t * pxEventListItem, const TickType_t xItemValue ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
  * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
@@ -1248,6 +1248,39 @@ const char * pcTimerGetName( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION; /*lint
  */
 void vTimerSetReloadMode( TimerHandle_t xTimer, const UBaseType_t uxAutoReload ) PRIVILEGED_FUNCTION;
 
+/**
+ * void vTimerSetSlack( TimerHandle_t xTimer, const TickType_t xSlack );
+ *
+ * configUSE_TIMER_SLACK must be set to 1 in FreeRTOSConfig.h for this function
+ * to be available.
+ *
+ * Allows the expiry of a timer to be postponed by up to xSlack ticks.  The
+ * timer service task then sleeps until the earliest expiry time plus slack of
+ * the active timers, or until a task that is due to wake up within that window
+ * wakes up, and processes all the timers that have expired by then in one go.
+ * With configUSE_TICKLESS_IDLE this reduces the number of times the CPU wakes
+ * up.  The period of an auto reload timer is still counted from its nominal
+ * expiry time, so a postponed expiry does not make the timer drift.
+ *
+ * @param xTimer The handle of the timer being updated.
+ *
+ * @param xSlack The number of ticks by which the timer may expire late.  A new
+ * timer has a slack of 0.
+ */
+void vTimerSetSlack( TimerHandle_t xTimer, const TickType_t xSlack ) PRIVILEGED_FUNCTION;
+
+/**
+ * TickType_t xTimerGetSlack( TimerHandle_t xTimer );
+ *
+ * configUSE_TIMER_SLACK must be set to 1 in FreeRTOSConfig.h for this function
+ * to be available.
+ *
+ * @param xTimer The handle of the timer being queried.
+ *
+ * @return The slack of the timer in ticks, as set by vTimerSetSlack().
+ */
+TickType_t xTimerGetSlack( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION;
+
 /**
  * TickType_t xTimerGetPeriod( TimerHandle_t xTimer );
  *
@@ -1274,6 +1307,40 @@ TickType_t xTimerGetPeriod( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION;
 */
 TickType_t xTimerGetExpiryTime( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION;
 
+#if( configUSE_TIMER_DIRECT_UPDATE == 1 )
+
+	/**
+	 * BaseType_t xTimerStartDirect( TimerHandle_t xTimer );
+	 * BaseType_t xTimerResetDirect( TimerHandle_t xTimer );
+	 * BaseType_t xTimerStopDirect( TimerHandle_t xTimer );
+	 *
+	 * Versions of xTimerStart(), xTimerReset() and xTimerStop() that change
+	 * the active timer list in place, with the scheduler suspended for the
+	 * length of a list insertion, instead of sending a command to the timer
+	 * service task.  The calling task does not have to wait for space in the
+	 * timer command queue, and the timer service task only runs if the timer
+	 * becomes the next one to expire.  configUSE_TIMER_DIRECT_UPDATE must be
+	 * set to 1 in FreeRTOSConfig.h for these macros to be available.
+	 *
+	 * They may only be called from tasks, not from interrupts or timer
+	 * callbacks.  If the lists cannot be changed in place, because the
+	 * scheduler is not running or the tick count has just overflowed, the
+	 * command is sent to the timer service task as by the normal functions,
+	 * without blocking.  The direct and the queued functions should not be
+	 * mixed for the same timer, as a queued command that has not been
+	 * processed yet would be applied after a later direct command.
+	 *
+	 * @param xTimer The handle of the timer being started, reset or stopped.
+	 *
+	 * @return pdPASS if the timer was updated or the command was queued,
+	 * otherwise pdFAIL.
+	 */
+	#define xTimerStartDirect( xTimer ) xTimerGenericCommandDirect( ( xTimer ), tmrCOMMAND_START )
+	#define xTimerResetDirect( xTimer ) xTimerGenericCommandDirect( ( xTimer ), tmrCOMMAND_RESET )
+	#define xTimerStopDirect( xTimer ) xTimerGenericCommandDirect( ( xTimer ), tmrCOMMAND_STOP )
+
+#endif /* configUSE_TIMER_DIRECT_UPDATE */
+
 /*
  * Functions beyond this part are not part of the public API and are intended
  * for use by the kernel only.
@@ -1281,6 +1348,10 @@ TickType_t xTimerGetExpiryTime( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION;
 BaseType_t xTimerCreateTimerTask( void ) PRIVILEGED_FUNCTION;
 BaseType_t xTimerGenericCommand( TimerHandle_t xTimer, const BaseType_t xCommandID, const TickType_t xOptionalValue, BaseType_t * const pxHigherPriorityTaskWoken, const TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
 
+#if( configUSE_TIMER_DIRECT_UPDATE == 1 )
+	BaseType_t xTimerGenericCommandDirect( TimerHandle_t xTimer, const BaseType_t xCommandID ) PRIVILEGED_FUNCTION;
+#endif
+
 #if( configUSE_TRACE_FACILITY == 1 )
 	void vTimerSetTimerNumber( TimerHandle_t xTimer, UBaseType_t uxTimerNumber ) PRIVILEGED_FUNCTION;
 	UBaseType_t uxTimerGetTimerNumber( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION;
@@ -0,0 +1,366 @@
+/*
+ * Amazon FreeRTOS Local Bus
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_local_bus.c
+ * @brief Implements the local publish/subscribe bus.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/* Local bus includes. */
+#include "aws_local_bus.h"
+
+/* Buffer pool includes. */
+#include "aws_bufferpool.h"
+
+#if ( mqttconfigENABLE_LOCAL_BUS == 1 )
+
+    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT != 1 )
+        #error "mqttconfigENABLE_LOCAL_BUS requires mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT to be set to 1."
+    #endif
+
+/**
+ * @brief The offset of the payload in a bus buffer.
+ *
+ * The MQTTPublishData_t describing the message is at the start of the buffer,
+ * followed by the payload and then the topic.
+ */
+    #define localbusDATA_OFFSET                                                                                                \
+    ( ( sizeof( MQTTPublishData_t ) + ( size_t ) portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/**
+ * @brief A subscription callback found for a message.
+ *
+ * The matches are copied out of the subscription manager so that the
+ * callbacks run without holding the bus mutex, and are then free to publish,
+ * subscribe and unsubscribe.
+ */
+    typedef struct LocalBusMatch
+    {
+        MQTTPublishCallback_t pxCallback;
+        void * pvCallbackContext;
+    } LocalBusMatch_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Keeps a message and passes it to MQTT_AGENT_PublishAsync().
+ *
+ * The subscription callback of the bridges.
+ */
+    static MQTTBool_t prvBridgeCallback( void * pvPublishCallbackContext,
+                                         const MQTTPublishData_t * const pxPublishData );
+
+/**
+ * @brief Releases a message once the MQTT agent is done with it.
+ */
+    static void prvBridgePublishComplete( void * pvCallbackContext,
+                                          MQTTAgentReturnCode_t xReturnCode );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The topic filters of the bus.
+ *
+ * Only accessed while holding xLocalBusMutex.
+ */
+    static MQTTSubscriptionManager_t xLocalBusSubscriptions;
+
+/**
+ * @brief Serializes the access to xLocalBusSubscriptions.
+ */
+    static SemaphoreHandle_t xLocalBusMutex = NULL;
+
+/*-----------------------------------------------------------*/
+
+    BaseType_t LOCAL_BUS_Init( void )
+    {
+        BaseType_t xResult = pdFAIL;
+
+        if( xLocalBusMutex == NULL )
+        {
+            xLocalBusMutex = xSemaphoreCreateMutex();
+
+            if( xLocalBusMutex != NULL )
+            {
+                MQTT_SubscriptionManagerInit( &xLocalBusSubscriptions );
+                xResult = pdPASS;
+            }
+        }
+
+        return xResult;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t LOCAL_BUS_Subscribe( const uint8_t * const pucTopicFilter,
+                                    uint16_t usTopicFilterLength,
+                                    MQTTPublishCallback_t pxCallback,
+                                    void * pvCallbackContext )
+    {
+        MQTTBool_t xStored;
+
+        configASSERT( xLocalBusMutex != NULL );
+        configASSERT( pxCallback != NULL );
+
+        ( void ) xSemaphoreTake( xLocalBusMutex, portMAX_DELAY );
+        {
+            xStored = MQTT_SubscriptionManagerStore( &xLocalBusSubscriptions,
+                                                     pucTopicFilter,
+                                                     usTopicFilterLength,
+                                                     pvCallbackContext,
+                                                     pxCallback );
+        }
+        ( void ) xSemaphoreGive( xLocalBusMutex );
+
+        return ( xStored == eMQTTTrue ) ? pdPASS : pdFAIL;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t LOCAL_BUS_Unsubscribe( const uint8_t * const pucTopicFilter,
+                                      uint16_t usTopicFilterLength )
+    {
+        MQTTBool_t xRemoved;
+
+        configASSERT( xLocalBusMutex != NULL );
+
+        ( void ) xSemaphoreTake( xLocalBusMutex, portMAX_DELAY );
+        {
+            xRemoved = MQTT_SubscriptionManagerRemove( &xLocalBusSubscriptions,
+                                                       pucTopicFilter,
+                                                       usTopicFilterLength );
+        }
+        ( void ) xSemaphoreGive( xLocalBusMutex );
+
+        return ( xRemoved == eMQTTTrue ) ? pdPASS : pdFAIL;
+    }
+/*-----------------------------------------------------------*/
+
+    MQTTPublishData_t * LOCAL_BUS_CreateMessage( const uint8_t * const pucTopic,
+                                                 uint16_t usTopicLength,
+                                                 uint32_t ulDataLength,
+                                                 void ** ppvData )
+    {
+        MQTTPublishData_t * pxMessage = NULL;
+        uint8_t * pucBuffer;
+        uint32_t ulBufferLength = ( uint32_t ) localbusDATA_OFFSET + ulDataLength + ( uint32_t ) usTopicLength;
+
+        configASSERT( pucTopic != NULL );
+        configASSERT( ppvData != NULL );
+
+        pucBuffer = BUFFERPOOL_GetFreeBuffer( &ulBufferLength );
+
+        if( pucBuffer != NULL )
+        {
+            pxMessage = ( MQTTPublishData_t * ) pucBuffer;
+            pxMessage->xQos = eMQTTQoS0;
+            pxMessage->pvData = &( pucBuffer[ localbusDATA_OFFSET ] );
+            pxMessage->ulDataLength = ulDataLength;
+            pxMessage->pucTopic = &( pucBuffer[ localbusDATA_OFFSET + ulDataLength ] );
+            pxMessage->usTopicLength = usTopicLength;
+            pxMessage->xBuffer = ( MQTTBufferHandle_t ) pucBuffer;
+
+            memcpy( &( pucBuffer[ localbusDATA_OFFSET + ulDataLength ] ), pucTopic, usTopicLength );
+            *ppvData = &( pucBuffer[ localbusDATA_OFFSET ] );
+        }
+
+        return pxMessage;
+    }
+/*-----------------------------------------------------------*/
+
+    uint32_t LOCAL_BUS_Publish( MQTTPublishData_t * const pxMessage )
+    {
+        LocalBusMatch_t xMatches[ mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS ];
+        const MQTTSubscription_t * pxSubscription;
+        MQTTTopicFilterType_t xTopicFilterType = eMQTTTopicFilterTypeSimple;
+        uint32_t ulFound, ulMatches = 0, ulCallbacks = 0, x;
+
+        configASSERT( xLocalBusMutex != NULL );
+        configASSERT( pxMessage != NULL );
+
+        ( void ) xSemaphoreTake( xLocalBusMutex, portMAX_DELAY );
+        {
+            ulFound = MQTT_SubscriptionManagerMatch( &xLocalBusSubscriptions, pxMessage->pucTopic, pxMessage->usTopicLength );
+
+            /* Topic filters without wild cards first, as the MQTT agent
+             * does. */
+            for( ; ; )
+            {
+                for( x = 0; x < ulFound; x++ )
+                {
+                    pxSubscription = &( xLocalBusSubscriptions.xSubscriptions[ xLocalBusSubscriptions.usTrieMatches[ x ] ] );
+
+                    if( ( pxSubscription->xInUse == eMQTTTrue ) &&
+                        ( pxSubscription->xTopicFilterType == xTopicFilterType ) &&
+                        ( pxSubscription->pxPublishCallback != NULL ) )
+                    {
+                        xMatches[ ulMatches ].pxCallback = pxSubscription->pxPublishCallback;
+                        xMatches[ ulMatches ].pvCallbackContext = pxSubscription->pvPublishCallbackContext;
+                        ulMatches++;
+                    }
+                }
+
+                if( xTopicFilterType == eMQTTTopicFilterTypeWildCard )
+                {
+                    break;
+                }
+
+                xTopicFilterType = eMQTTTopicFilterTypeWildCard;
+            }
+        }
+        ( void ) xSemaphoreGive( xLocalBusMutex );
+
+        for( x = 0; x < ulMatches; x++ )
+        {
+            /* Each subscriber gets its own reference for the duration of
+             * the callback, which it keeps by returning eMQTTTrue. Taking it
+             * first means a subscriber that hands the message to another task
+             * cannot have it freed before the callback returns. */
+            if( BUFFERPOOL_RetainBuffer( ( uint8_t * ) pxMessage->xBuffer ) == pdPASS )
+            {
+                ulCallbacks++;
+
+                if( xMatches[ x ].pxCallback( xMatches[ x ].pvCallbackContext, pxMessage ) == eMQTTFalse )
+                {
+                    BUFFERPOOL_ReturnBuffer( ( uint8_t * ) pxMessage->xBuffer );
+                }
+            }
+        }
+
+        /* Drop the reference of the publisher. */
+        BUFFERPOOL_ReturnBuffer( ( uint8_t * ) pxMessage->xBuffer );
+
+        return ulCallbacks;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t LOCAL_BUS_PublishCopy( const uint8_t * const pucTopic,
+                                      uint16_t usTopicLength,
+                                      const void * pvData,
+                                      uint32_t ulDataLength )
+    {
+        MQTTPublishData_t * pxMessage;
+        void * pvPayload;
+        BaseType_t xResult = pdFAIL;
+
+        pxMessage = LOCAL_BUS_CreateMessage( pucTopic, usTopicLength, ulDataLength, &pvPayload );
+
+        if( pxMessage != NULL )
+        {
+            if( ulDataLength > 0 )
+            {
+                memcpy( pvPayload, pvData, ulDataLength );
+            }
+
+            ( void ) LOCAL_BUS_Publish( pxMessage );
+            xResult = pdPASS;
+        }
+
+        return xResult;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t LOCAL_BUS_RetainBuffer( MQTTBufferHandle_t xBuffer )
+    {
+        return BUFFERPOOL_RetainBuffer( ( uint8_t * ) xBuffer );
+    }
+/*-----------------------------------------------------------*/
+
+    void LOCAL_BUS_ReturnBuffer( MQTTBufferHandle_t xBuffer )
+    {
+        BUFFERPOOL_ReturnBuffer( ( uint8_t * ) xBuffer );
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t LOCAL_BUS_BridgeToMQTT( LocalBusBridge_t * const pxBridge,
+                                       const uint8_t * const pucTopicFilter,
+                                       uint16_t usTopicFilterLength )
+    {
+        configASSERT( pxBridge != NULL );
+
+        return LOCAL_BUS_Subscribe( pucTopicFilter, usTopicFilterLength, prvBridgeCallback, pxBridge );
+    }
+/*-----------------------------------------------------------*/
+
+    static MQTTBool_t prvBridgeCallback( void * pvPublishCallbackContext,
+                                         const MQTTPublishData_t * const pxPublishData )
+    {
+        const LocalBusBridge_t * pxBridge = ( const LocalBusBridge_t * ) pvPublishCallbackContext;
+        MQTTAgentPublishParams_t xPublishParams;
+        MQTTBool_t xKept = eMQTTFalse;
+
+        /* The topic and payload stay in the bus buffer, which is kept until
+         * prvBridgePublishComplete() runs. */
+        xPublishParams.pucTopic = pxPublishData->pucTopic;
+        xPublishParams.usTopicLength = pxPublishData->usTopicLength;
+        xPublishParams.xQoS = pxBridge->xQoS;
+        xPublishParams.pvData = pxPublishData->pvData;
+        xPublishParams.ulDataLength = pxPublishData->ulDataLength;
+
+        /* Do not block the publishing task. The message is dropped if the
+         * publish window is full. */
+        if( MQTT_AGENT_PublishAsync( pxBridge->xMQTTHandle,
+                                     &xPublishParams,
+                                     prvBridgePublishComplete,
+                                     pxPublishData->xBuffer,
+                                     0 ) == eMQTTAgentSuccess )
+        {
+            xKept = eMQTTTrue;
+        }
+
+        return xKept;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvBridgePublishComplete( void * pvCallbackContext,
+                                          MQTTAgentReturnCode_t xReturnCode )
+    {
+        ( void ) xReturnCode;
+
+        LOCAL_BUS_ReturnBuffer( ( MQTTBufferHandle_t ) pvCallbackContext );
+    }
+/*-----------------------------------------------------------*/
+
+    MQTTBool_t LOCAL_BUS_PublishFromMQTT( void * pvPublishCallbackContext,
+                                          const MQTTPublishData_t * const pxPublishData )
+    {
+        ( void ) pvPublishCallbackContext;
+
+        ( void ) LOCAL_BUS_PublishCopy( pxPublishData->pucTopic,
+                                        pxPublishData->usTopicLength,
+                                        pxPublishData->pvData,
+                                        pxPublishData->ulDataLength );
+
+        /* The MQTT buffer is not needed any more. */
+        return eMQTTFalse;
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* mqttconfigENABLE_LOCAL_BUS */
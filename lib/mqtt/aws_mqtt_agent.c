@@ -53,12 +53,28 @@
  * @brief The length of the command queue used to send commands from application
  * tasks to the MQTT task.
  *
- * The queue can have a maximum of mqttconfigMAX_PARALLEL_OPS parallel operations
- * for each broker connection at any one time. The socket wake callback will only
- * post to the queue if the queue is empty, so there is no need to leave space for
+ * Each MQTT task has its own queue. The queue can have a maximum of
+ * mqttconfigMAX_PARALLEL_OPS parallel operations for each broker connection the
+ * task serves at any one time, plus mqttconfigASYNC_PUBLISH_WINDOW publishes
+ * made with MQTT_AGENT_PublishAsync(). The socket wake callback will only post
+ * to the queue if the queue is empty, so there is no need to leave space for
  * that.
  */
-#define mqttCOMMAND_QUEUE_LENGTH    ( ( UBaseType_t ) ( mqttconfigMAX_BROKERS * mqttconfigMAX_PARALLEL_OPS ) )
+#define mqttCOMMAND_QUEUE_LENGTH      ( ( UBaseType_t ) ( mqttBROKERS_PER_TASK * ( mqttconfigMAX_PARALLEL_OPS + mqttconfigASYNC_PUBLISH_WINDOW ) ) )
+
+/**
+ * @brief The largest number of broker connections served by one MQTT task.
+ */
+#define mqttBROKERS_PER_TASK          ( ( mqttconfigMAX_BROKERS + mqttconfigMQTT_TASKS - 1 ) / mqttconfigMQTT_TASKS )
+
+/**
+ * @brief The MQTT task which serves a broker connection.
+ */
+#define mqttTASK_FOR_BROKER( uxBrokerNumber )    ( ( UBaseType_t ) ( uxBrokerNumber ) % ( UBaseType_t ) mqttconfigMQTT_TASKS )
+
+#if ( mqttconfigMQTT_TASKS < 1 ) || ( mqttconfigMQTT_TASKS > mqttconfigMAX_BROKERS )
+    #error "mqttconfigMQTT_TASKS must be between 1 and mqttconfigMAX_BROKERS."
+#endif
 
 /**
  * @defgroup MessageIdentifer Macros related to message identifier.
@@ -107,8 +123,13 @@
  */
 /** @{ */
 #define mqttCONNECTION_SECURED    ( ( UBaseType_t ) 1 << ( UBaseType_t ) 0 )
+#define mqttCONNECTION_POLL_RX    ( ( UBaseType_t ) 1 << ( UBaseType_t ) 1 ) /**< The socket does not report received data, so it is read on every pass. */
 /** @} */
 
+#if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 ) && ( mqttconfigMAX_BROKERS > 32 )
+    #error "mqttconfigENABLE_EVENT_DRIVEN_RX requires mqttconfigMAX_BROKERS to be at most 32."
+#endif
+
 /**
  * @brief Encodes the broker number returned to the user.
  *
@@ -120,8 +141,8 @@
 /**
  * @brief Decodes the broker number supplied by the user.
  *
- * Subtracting one ensures that we index the correct MQTTBrokerConnection_t
- * in the xMQTTConnections array since we added one to the index before giving
+ * Subtracting one ensures that we get the index of the correct
+ * MQTTBrokerConnection_t since we added one to the index before giving
  * it to the user as an opaque handle.
  */
 #define mqttDECODE_BROKER_NUMBER( xBrokerNumber )    ( ( UBaseType_t ) xBrokerNumber - ( UBaseType_t ) 1 )
@@ -137,7 +158,8 @@ typedef enum
     eMQTTDisconnectRequest,  /**< Disconnect the connection to an MQTT broker. */
     eMQTTSubscribeRequest,   /**< Initiate a subscribe to a topic.  _TODO_ Currently limited to one topic per subscribe message. */
     eMQTTUnsubscribeRequest, /**< Initiate unsubscribe from a topic.  _TODO_ Currently limited to one topic per unsubscribe message. */
-    eMQTTPublishRequest      /**< Initiate a publish to a topic.  _TODO_ Currently limited to one topic per publish message. */
+    eMQTTPublishRequest,     /**< Initiate a publish to a topic.  _TODO_ Currently limited to one topic per publish message. */
+    eMQTTAsyncPublishRequest /**< Initiate a publish made with MQTT_AGENT_PublishAsync(). */
 } MQTTAction_t;
 
 /**
@@ -164,7 +186,8 @@ typedef enum
     eMQTTBufferAdded = 28,                /**< Provided buffer was successfully added to the MQTT core library. */
     eMQTTBufferCouldNotBeAdded = 30,      /**< Provided buffer could not be added to the MQTT library. */
     eMQTTOperationTimedOut = 32,          /**< The requested operation could not be completed within the specified time. */
-    eMQTTClientGotDisconnected = 34       /**< The MQTT client got disconnect in the middle of an operation. */
+    eMQTTClientGotDisconnected = 34,      /**< The MQTT client got disconnect in the middle of an operation. */
+    eMQTTPUBStoredOffline = 36            /**< PUBLISH message stored to be sent once the connection is back up. */
 } MQTTNotifyCodes_t;
 
 /**
@@ -177,6 +200,22 @@ typedef struct MQTTNotificationData
     uint32_t ulMessageIdentifier; /**< Used to match a request going from application task to MQTT task with response going the other way. */
 } MQTTNotificationData_t;
 
+#if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+
+/**
+ * @brief A publish made with MQTT_AGENT_PublishAsync() which has not completed.
+ */
+    typedef struct MQTTAsyncPublish
+    {
+        MQTTAgentPublishParams_t xParams;      /**< Copy of the publish parameters. */
+        MQTTAgentPublishCallback_t pxCallback; /**< Invoked with the result. */
+        void * pvCallbackContext;              /**< Passed as it is to pxCallback. */
+        uint16_t usPacketIdentifier;           /**< Matches the PUBACK or timeout with this publish. */
+        BaseType_t xInFlight;                  /**< Set while a QoS1 publish waits for its PUBACK. */
+        BaseType_t xInUse;                     /**< Set from MQTT_AGENT_PublishAsync() until completion. Accessed from application tasks and hence in critical section. */
+    } MQTTAsyncPublish_t;
+#endif
+
 /**
  * @brief Contents of the message sent from an application task to the MQTT task to
  * initiate an MQTT operation.
@@ -198,9 +237,25 @@ typedef struct MQTTEventData
         const MQTTAgentSubscribeParams_t * pxSubscribeParams;     /**< Subscribe Parameters. */
         const MQTTAgentUnsubscribeParams_t * pxUnsubscribeParams; /**< Unsubscribe Parameters. */
         const MQTTAgentPublishParams_t * pxPublishParams;         /**< Publish Parameters. */
+        #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+            MQTTAsyncPublish_t * pxAsyncPublish;                  /**< Asynchronous publish. */
+        #endif
     } u;
 } MQTTEventData_t;
 
+#if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+
+/**
+ * @brief A QoS1 publish stored while its connection was down.
+ */
+    typedef struct MQTTOfflinePublish
+    {
+        uint16_t usTopicLength;                                               /**< Length of the topic at the start of ucTopicAndData. */
+        uint32_t ulDataLength;                                                /**< Length of the payload which follows the topic. */
+        uint8_t ucTopicAndData[ mqttconfigOFFLINE_PUBLISH_MAX_BYTES ];        /**< The topic followed by the payload. */
+    } MQTTOfflinePublish_t;
+#endif
+
 /**
  * @brief Contains the state of a connection to MQTT broker.
  *
@@ -216,8 +271,40 @@ typedef struct MQTTBrokerConnection
     void * pvUserData;                                                  /**< User data to be supplied back in the callback as it is. */
     MQTTAgentCallback_t pxCallback;                                     /**< The callback to notify user of various events including the Publish messages received from the broker. */
     UBaseType_t uxFlags;                                                /**< Various properties of the connection - secured etc. */
-    BaseType_t xConnectionInUse;                                        /**< Tracks whether or not the connection is in use. It is accessed from application tasks (prvGetFreeConnection and prvReturnConnection) and hence should be accessed in critical section. */
-    uint8_t ucRxBuffer[ mqttconfigRX_BUFFER_SIZE ];                     /**< Buffers incoming messages. */
+    UBaseType_t uxBrokerNumber;                                         /**< Index of the connection, as encoded in its handle. */
+    uint8_t * pucRxBuffer;                                              /**< Buffers incoming messages, mqttconfigRX_BUFFER_SIZE bytes. */
+    #if ( mqttconfigALLOCATE_CONNECTIONS == 0 )
+        uint8_t ucRxBuffer[ mqttconfigRX_BUFFER_SIZE ];                 /**< Storage for pucRxBuffer. */
+    #endif
+    #if ( mqttconfigBUFFER_WAIT_MS > 0 )
+        BaseType_t xReadPaused;                                         /**< Set while reading is paused because the buffer pool is empty. */
+        TickType_t xReadPausedTicks;                                    /**< Tick count at which reading was paused. */
+    #endif
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        BaseType_t xBatchingPublish;                                    /**< Set while a publish which can be added to the batch is being sent. */
+        TickType_t xBatchStartTicks;                                    /**< Tick count when the first publish was added to the batch. */
+        size_t xBatchLength;                                            /**< Number of bytes in ucBatchBuffer. */
+        uint8_t ucBatchBuffer[ mqttconfigPUBLISH_BATCH_MAX_BYTES ];     /**< Buffers outgoing publish messages. */
+    #endif
+    #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+        MQTTOfflinePublish_t xOfflinePublishes[ mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH ]; /**< Ring of publishes stored while the connection was down. */
+        UBaseType_t uxOfflineHead;                                                        /**< Index of the oldest stored publish. */
+        UBaseType_t uxOfflineCount;                                                       /**< Number of stored publishes. */
+        BaseType_t xOfflineDrainEnabled;                                                  /**< Set once the broker has accepted the connection. */
+        uint16_t usOfflineInFlight;                                                       /**< Packet identifier of the stored publish waiting for a PUBACK, or 0. */
+        TickType_t xOfflineNextDrainTicks;                                                /**< Tick count at which the next stored publish may be sent. */
+    #endif
+    #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+        MQTTAsyncPublish_t xAsyncPublishes[ mqttconfigASYNC_PUBLISH_WINDOW ];             /**< Publishes made with MQTT_AGENT_PublishAsync() which have not completed. */
+        SemaphoreHandle_t xAsyncPublishWindow;                                            /**< Counts the free entries of xAsyncPublishes. */
+        StaticSemaphore_t xAsyncPublishWindowBuffer;                                      /**< Storage for xAsyncPublishWindow. */
+    #endif
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        volatile MQTTAgentStatistics_t xStatistics;                                       /**< Updated by the MQTT task only. */
+        volatile uint32_t ulStatisticsSequence;                                           /**< Odd while xStatistics is being updated. */
+        uint16_t usTimedPublishes[ mqttconfigSTATISTICS_TIMED_PUBLISHES ];                /**< Packet identifiers of the QoS1 publishes whose time to PUBACK is measured, 0 if unused. */
+        TickType_t xTimedPublishSentTicks[ mqttconfigSTATISTICS_TIMED_PUBLISHES ];        /**< Tick count at which each of them was sent. */
+    #endif
 } MQTTBrokerConnection_t;
 /*-----------------------------------------------------------*/
 
@@ -248,26 +335,52 @@ static const uint16_t usUserNameLength = ( uint16_t ) ( sizeof( cUserName ) - 1U
  *
  * Each MQTTBrokerConnection_t structure maintains the state of one connection
  * to an MQTT broker. The maximum number of simultaneous connections is set by
- * mqttconfigMAX_BROKERS.
+ * mqttconfigMAX_BROKERS. When mqttconfigALLOCATE_CONNECTIONS is 1, only the
+ * connections that have been created are allocated, and the others are NULL.
  */
-static MQTTBrokerConnection_t xMQTTConnections[ mqttconfigMAX_BROKERS ];
+#if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+    static MQTTBrokerConnection_t * pxMQTTConnections[ mqttconfigMAX_BROKERS ] = { NULL };
+    #define mqttCONNECTION( uxBrokerNumber )    ( pxMQTTConnections[ ( uxBrokerNumber ) ] )
+#else
+    static MQTTBrokerConnection_t xMQTTConnections[ mqttconfigMAX_BROKERS ];
+    #define mqttCONNECTION( uxBrokerNumber )    ( &( xMQTTConnections[ ( uxBrokerNumber ) ] ) )
+#endif
 
 /**
- * @brief Handle of the command queue used to pass commands from application
- * tasks to the MQTT task.
+ * @brief Tracks whether or not each connection is in use.
+ *
+ * It is accessed from application tasks (prvGetFreeConnection and
+ * prvReturnConnection) and hence should be accessed in critical section.
  */
-static QueueHandle_t xCommandQueue = NULL;
+static BaseType_t xConnectionInUse[ mqttconfigMAX_BROKERS ];
 
 /**
- * @brief Handle of the MQTT task.
+ * @brief Handles of the command queues used to pass commands from application
+ * tasks to each MQTT task.
  */
-static TaskHandle_t xMQTTTaskHandle = NULL;
+static QueueHandle_t xCommandQueues[ mqttconfigMQTT_TASKS ] = { NULL };
+
+/**
+ * @brief Handles of the MQTT tasks.
+ */
+static TaskHandle_t xMQTTTaskHandles[ mqttconfigMQTT_TASKS ] = { NULL };
 
 /**
  * @brief Used to match commands sent to the MQTT task to replies coming from the
  * MQTT task.
  */
 static uint32_t ulQueueMessageIdentifier = 0;
+
+#if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+
+/**
+ * @brief Bit n is set when the socket of broker n may have data to read.
+ *
+ * Set from the socket wakeup callback and cleared by the MQTT task, so it is
+ * only accessed in critical sections.
+ */
+    static uint32_t ulConnectionsToRead = 0;
+#endif
 /*-----------------------------------------------------------*/
 
 /**
@@ -286,6 +399,81 @@ static uint32_t prvMQTTSendCallback( void * pvSendContext,
                                      const uint8_t * const pucData,
                                      uint32_t ulDataLength );
 
+/**
+ * @brief Transmits bytes over the socket of the given connection.
+ *
+ * Keeps retrying until all the data is sent, mqttconfigTCP_SEND_TIMEOUT_MS
+ * expires or an error other than SOCKETS_EWOULDBLOCK occurs.
+ *
+ * @param[in] pxConnection The connection to send the data on.
+ * @param[in] pucData The data to transmit.
+ * @param[in] ulDataLength Length of the data.
+ *
+ * @return The number of actually transmitted bytes.
+ */
+static uint32_t prvSendOnConnection( MQTTBrokerConnection_t * const pxConnection,
+                                     const uint8_t * const pucData,
+                                     uint32_t ulDataLength );
+
+#if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+
+/**
+ * @brief Adds the data being sent to the publish batch of the connection.
+ *
+ * The data is only added if it belongs to a publish (xBatchingPublish is set)
+ * and fits in the batch buffer. Otherwise the batch is flushed first so that
+ * packets go out on the wire in the order in which they were sent.
+ *
+ * @param[in] pxConnection The connection the data is sent on.
+ * @param[in] pxIOVectors The data being sent.
+ * @param[in] ulIOVectorCount Number of buffers in pxIOVectors.
+ *
+ * @return pdTRUE if the data was added to the batch, pdFALSE if the caller
+ * must send it.
+ */
+    static BaseType_t prvAddToPublishBatch( MQTTBrokerConnection_t * const pxConnection,
+                                            const MQTTIOVector_t * const pxIOVectors,
+                                            uint32_t ulIOVectorCount );
+
+/**
+ * @brief Writes the publish batch of the connection, if any, to the socket.
+ *
+ * @param[in] pxConnection The connection to flush.
+ */
+    static void prvFlushPublishBatch( MQTTBrokerConnection_t * const pxConnection );
+
+/**
+ * @brief Flushes the publish batches which have been held back for
+ * mqttconfigPUBLISH_BATCH_MAX_DELAY_MS.
+ *
+ * @param[in] uxTaskNumber The MQTT task whose connections are flushed.
+ * @param[in] xNextTimeoutTicks The time the MQTT task is going to block for.
+ *
+ * @return The time the MQTT task should block for so that the remaining
+ * batches are flushed in time.
+ */
+    static TickType_t prvManagePublishBatches( UBaseType_t uxTaskNumber,
+                                               TickType_t xNextTimeoutTicks );
+#endif /* mqttconfigPUBLISH_BATCH_MAX_DELAY_MS */
+
+#if ( mqttconfigENABLE_SENDV == 1 )
+
+/**
+ * @brief The callback registered with the core MQTT library to transmit the data
+ * of several buffers over wire with one call to SOCKETS_SendV.
+ *
+ * @param[in] pvSendContext The send context is broker number in our case.
+ * @param[in] pxIOVectors The buffers to transmit.
+ * @param[in] ulIOVectorCount Number of buffers in pxIOVectors.
+ *
+ * @return The number of actually transmitted bytes. Can be less than the total
+ * length of the buffers if transmission fails for some reason.
+ */
+    static uint32_t prvMQTTSendVCallback( void * pvSendContext,
+                                          const MQTTIOVector_t * const pxIOVectors,
+                                          uint32_t ulIOVectorCount );
+#endif /* mqttconfigENABLE_SENDV */
+
 /**
  * @brief The callback registered with the core MQTT library to receive various MQTT events.
  *
@@ -323,21 +511,53 @@ static void prvMQTTGetTicks( uint64_t * pxCurrentTickCount );
 /**
  * @brief Gets an unused connection.
  *
- * This functions iterates over xMQTTConnections array and tries to find a free connection (i.e. one with
- * mqttCONNECTION_IN_USE bit in uxFlags cleared). If it finds one, it returns its index in the xMQTTConnections
- * array otherwise it returns -1 to indicate failure.
+ * This functions iterates over xConnectionInUse array and tries to find a free connection. If it
+ * finds one, it marks it "in use" and returns its index otherwise it returns -1 to indicate failure.
  *
- * @return The index of a free connection in xMQTTConnections array if one is available, -1 otherwise.
+ * @return The index of a free connection if one is available, -1 otherwise.
  */
 static BaseType_t prvGetFreeConnection( void );
 
 /**
  * @brief Returns the connection to the unused pool by marking it "not in use".
  *
- * @param[in] uxBrokerNumber Index of the connection in the xMQTTConnections array.
+ * @param[in] uxBrokerNumber Index of the connection.
  */
 static void prvReturnConnection( UBaseType_t uxBrokerNumber );
 
+/**
+ * @brief Initializes the state of a connection which is not in use.
+ *
+ * @param[in] pxConnection The connection to initialize.
+ * @param[in] uxBrokerNumber Index of the connection.
+ *
+ * @return pdPASS if the MQTT Core library context was initialized, pdFAIL otherwise.
+ */
+static BaseType_t prvInitConnection( MQTTBrokerConnection_t * const pxConnection,
+                                     UBaseType_t uxBrokerNumber );
+
+#if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+
+/**
+ * @brief Allocates the state of a connection the first time it is used.
+ *
+ * The state is kept once allocated, as the MQTT tasks may still access it
+ * after the connection is deleted.
+ *
+ * @param[in] uxBrokerNumber Index of the connection, which must be "in use".
+ *
+ * @return pdPASS if the connection is allocated, pdFAIL otherwise.
+ */
+    static BaseType_t prvAllocateConnection( UBaseType_t uxBrokerNumber );
+
+/**
+ * @brief Frees the receive buffer of a connection, if it has one.
+ *
+ * @param[in] pxConnection The connection whose socket was closed.
+ */
+    static void prvFreeRxBuffer( MQTTBrokerConnection_t * const pxConnection );
+#endif
+
 /**
  * @brief Stores the notification data in one of the available buffers in MQTTBrokerConnection_t.
  *
@@ -403,6 +623,43 @@ static void prvGracefulSocketClose( MQTTBrokerConnection_t * const pxConnection
  */
 static void prvMQTTClientSocketWakeupCallback( Socket_t pxSocket );
 
+#if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+
+/**
+ * @brief Records that the socket of a broker may have data to read.
+ *
+ * @param[in] uxBrokerNumber The broker whose socket needs to be read.
+ */
+    static void prvMarkConnectionToRead( UBaseType_t uxBrokerNumber );
+#endif
+
+#if ( mqttconfigBUFFER_WAIT_MS > 0 )
+
+/**
+ * @brief Gets a buffer for the MQTT Core library, waiting up to
+ * mqttconfigBUFFER_WAIT_MS for one to be returned.
+ *
+ * @param[in, out] pulBufferLength As for BUFFERPOOL_GetFreeBuffer.
+ *
+ * @return The buffer, or NULL if none was returned in time.
+ */
+    static uint8_t * prvGetFreeBufferWait( uint32_t * pulBufferLength );
+
+/**
+ * @brief Decides whether to leave the received data of a connection in its
+ * socket for now.
+ *
+ * Reading is paused while the buffer pool is empty, for up to
+ * mqttconfigBUFFER_WAIT_MS.
+ *
+ * @param[in] pxConnection The connection about to be read.
+ *
+ * @return pdTRUE if the connection must not be read now, pdFALSE otherwise.
+ */
+    static BaseType_t prvPauseReading( MQTTBrokerConnection_t * const pxConnection );
+
+#endif /* mqttconfigBUFFER_WAIT_MS */
+
 /**
  * @brief Notifies the application task about the received CONNACK message.
  *
@@ -465,6 +722,18 @@ static void prvProcessReceivedPUBACK( MQTTBrokerConnection_t * const pxConnectio
 static BaseType_t prvProcessReceivedPublish( MQTTBrokerConnection_t * const pxConnection,
                                              const MQTTEventCallbackParams_t * const pxParams );
 
+#if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+
+/**
+ * @brief Passes a chunk of a streamed Publish message to the user callback.
+ *
+ * @param[in] pxConnection The MQTTBrokerConnection_t corresponding to the connection on which Publish is received.
+ * @param[in] pxParams The parameters received in the callback form the MQTT Core library containing relevant data.
+ */
+    static void prvProcessReceivedPublishChunk( MQTTBrokerConnection_t * const pxConnection,
+                                                const MQTTEventCallbackParams_t * const pxParams );
+#endif /* mqttconfigENABLE_STREAMING_PUBLISH */
+
 /**
  * @brief Notifies the application task about the timeout.
  *
@@ -513,9 +782,11 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
  * MQTT Core library. It also invokes the MQTT_Periodic function of the core library
  * to ensure regular timeout and keep alive processing.
  *
+ * @param[in] uxTaskNumber The MQTT task whose connections are serviced.
+ *
  * @return Time in ticks when the next invocation of MQTT_Periodic is required.
  */
-static TickType_t prvManageConnections( void );
+static TickType_t prvManageConnections( UBaseType_t uxTaskNumber );
 
 /**
  * @brief Initiates the MQTT Connect operation.
@@ -586,6 +857,58 @@ static void prvInitiateMQTTUnSubscribe( MQTTEventData_t * const pxEventData );
  */
 static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData );
 
+/**
+ * @brief Calls the MQTT_Publish function of the core MQTT library.
+ *
+ * @param[in] pxConnection The connection to publish on.
+ * @param[in] pxParams The publish parameters supplied by the application.
+ * @param[in] usPacketIdentifier Identifies the PUBACK or the timeout of a QoS1 publish.
+ * @param[in] xTicksToWait Time after which a QoS1 publish times out.
+ *
+ * @return pdPASS if the publish was sent, pdFAIL otherwise.
+ */
+static BaseType_t prvPublishToBroker( MQTTBrokerConnection_t * const pxConnection,
+                                      const MQTTAgentPublishParams_t * const pxParams,
+                                      uint16_t usPacketIdentifier,
+                                      TickType_t xTicksToWait );
+
+#if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+
+/**
+ * @brief Sends a publish made with MQTT_AGENT_PublishAsync().
+ *
+ * Completes the publish straight away unless it is a QoS1 publish which was
+ * sent, in which case it completes when its PUBACK or timeout is received.
+ *
+ * @param[in] pxEventData The event data as posted by application task to the command queue.
+ */
+    static void prvInitiateMQTTAsyncPublish( MQTTEventData_t * const pxEventData );
+
+/**
+ * @brief Invokes the callback of an asynchronous publish and frees its entry
+ * in the window.
+ *
+ * @param[in] pxConnection The connection the publish was made on.
+ * @param[in] pxAsyncPublish The publish which completed.
+ * @param[in] xReturnCode The result passed to the callback.
+ */
+    static void prvCompleteAsyncPublish( MQTTBrokerConnection_t * const pxConnection,
+                                         MQTTAsyncPublish_t * const pxAsyncPublish,
+                                         MQTTAgentReturnCode_t xReturnCode );
+
+/**
+ * @brief Completes the QoS1 asynchronous publish waiting for the given
+ * packet identifier, if any.
+ *
+ * @param[in] pxConnection The connection on which the PUBACK or timeout was received.
+ * @param[in] usPacketIdentifier The packet identifier of the PUBACK or timeout.
+ * @param[in] xReturnCode The result passed to the callback.
+ */
+    static void prvCompleteAsyncPublishInFlight( MQTTBrokerConnection_t * const pxConnection,
+                                                 uint16_t usPacketIdentifier,
+                                                 MQTTAgentReturnCode_t xReturnCode );
+#endif /* mqttconfigASYNC_PUBLISH_WINDOW */
+
 /*
  * @brief Posts the event to the command queue and waits for the notification from the MQTT task.
  *
@@ -614,9 +937,115 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
  * It wakes up periodically and calls prvManageConnections() in order to
  * ensure regular timeout and keep alive processing by the MQTT Core library.
  *
- * @param[in] pvParameters The parameters as specified when creating the task, NULL in this case.
+ * @param[in] pvParameters The parameters as specified when creating the task,
+ * the index of the task in this case.
  */
 static void prvMQTTTask( void * pvParameters );
+
+/**
+ * @brief Checks whether a task is one of the MQTT tasks.
+ *
+ * @param[in] xTask The task to check.
+ *
+ * @return pdTRUE if xTask is an MQTT task, pdFALSE otherwise.
+ */
+static BaseType_t prvIsMQTTTask( TaskHandle_t xTask );
+
+/**
+ * @brief Returns the next message identifier used to match a command with
+ * its result.
+ */
+static uint32_t prvGetMessageIdentifier( void );
+
+#if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+
+/**
+ * @brief Stores a QoS1 publish if its connection is down.
+ *
+ * @param[in] pxEventData The publish request posted to the command queue.
+ *
+ * @return pdTRUE if the request was handled here, in which case the
+ * requesting task has been notified, pdFALSE if it must be published.
+ */
+    static BaseType_t prvStoreOfflinePublish( MQTTEventData_t * const pxEventData );
+
+/**
+ * @brief Reads back the stored publishes of a new connection from the
+ * mqttconfigOFFLINE_PUBLISH_LOAD() hook.
+ *
+ * @param[in] uxBrokerNumber The connection to load.
+ */
+    static void prvLoadOfflinePublishes( UBaseType_t uxBrokerNumber );
+
+/**
+ * @brief Sends the oldest stored publish of each connection served by an MQTT
+ * task, at most one every mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS.
+ *
+ * @param[in] uxTaskNumber The MQTT task whose connections are drained.
+ * @param[in] xNextTimeoutTicks The time the MQTT task is going to block for.
+ *
+ * @return The time the MQTT task should block for so that the next stored
+ * publish is sent in time.
+ */
+    static TickType_t prvManageOfflinePublishes( UBaseType_t uxTaskNumber,
+                                                 TickType_t xNextTimeoutTicks );
+
+/**
+ * @brief Removes the oldest stored publish if it was the one acknowledged.
+ *
+ * @param[in] pxConnection The connection on which the PUBACK was received.
+ * @param[in] usPacketIdentifier The packet identifier of the PUBACK.
+ */
+    static void prvOfflinePublishAcknowledged( MQTTBrokerConnection_t * const pxConnection,
+                                               uint16_t usPacketIdentifier );
+#endif /* mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH */
+
+#if ( mqttconfigENABLE_STATISTICS == 1 )
+
+/**
+ * @brief Adds to a counter in the statistics of a connection.
+ *
+ * @param[in] pxConnection The connection whose statistics are updated.
+ * @param[in] pulCounter The counter, in pxConnection->xStatistics.
+ * @param[in] ulValue Added to the counter.
+ */
+    static void prvAddToStatistic( MQTTBrokerConnection_t * const pxConnection,
+                                   volatile uint32_t * const pulCounter,
+                                   uint32_t ulValue );
+
+/**
+ * @brief Adds a sample to a latency histogram of a connection.
+ *
+ * @param[in] pxConnection The connection whose statistics are updated.
+ * @param[in] pxHistogram The histogram, in pxConnection->xStatistics.
+ * @param[in] xTicks The latency.
+ */
+    static void prvRecordLatency( MQTTBrokerConnection_t * const pxConnection,
+                                  volatile MQTTAgentLatencyHistogram_t * const pxHistogram,
+                                  TickType_t xTicks );
+
+/**
+ * @brief Starts measuring the time to PUBACK of a publish, if an entry is free.
+ *
+ * @param[in] pxConnection The connection on which the publish was sent.
+ * @param[in] usPacketIdentifier The packet identifier of the publish.
+ */
+    static void prvStartPublishTimer( MQTTBrokerConnection_t * const pxConnection,
+                                      uint16_t usPacketIdentifier );
+
+/**
+ * @brief Stops measuring the time to PUBACK of a publish.
+ *
+ * @param[in] pxConnection The connection on which the publish was sent.
+ * @param[in] usPacketIdentifier The packet identifier of the publish, or 0
+ * to stop all the measurements.
+ * @param[in] xAcknowledged pdTRUE to record the time because the PUBACK was
+ * received, pdFALSE to discard it.
+ */
+    static void prvStopPublishTimer( MQTTBrokerConnection_t * const pxConnection,
+                                     uint16_t usPacketIdentifier,
+                                     BaseType_t xAcknowledged );
+#endif /* mqttconfigENABLE_STATISTICS */
 /*-----------------------------------------------------------*/
 
 static uint32_t prvMQTTSendCallback( void * pvSendContext,
@@ -625,58 +1054,442 @@ static uint32_t prvMQTTSendCallback( void * pvSendContext,
 {
     MQTTBrokerConnection_t * pxConnection;
     UBaseType_t uxBrokerNumber = ( UBaseType_t ) pvSendContext; /*lint !e923 The cast is ok as we passed the index of the client before. */
+    uint32_t ulBytesSent;
+
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        MQTTIOVector_t xIOVector;
+    #endif
+
+    /* Broker number must be valid. */
+    configASSERT( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+
+    /* Get the actual connection to the broker. */
+    pxConnection = mqttCONNECTION( uxBrokerNumber );
+
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        xIOVector.pucData = pucData;
+        xIOVector.ulDataLength = ulDataLength;
+
+        if( prvAddToPublishBatch( pxConnection, &( xIOVector ), 1 ) == pdTRUE )
+        {
+            ulBytesSent = ulDataLength;
+        }
+        else
+    #endif /* mqttconfigPUBLISH_BATCH_MAX_DELAY_MS */
+    {
+        ulBytesSent = prvSendOnConnection( pxConnection, pucData, ulDataLength );
+    }
+
+    return ulBytesSent;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSendOnConnection( MQTTBrokerConnection_t * const pxConnection,
+                                     const uint8_t * const pucData,
+                                     uint32_t ulDataLength )
+{
     int32_t lSendRetVal;
     uint32_t ulBytesSent = 0;
     TimeOut_t xTimestamp;
     TickType_t xTicksToWait = pdMS_TO_TICKS( mqttconfigTCP_SEND_TIMEOUT_MS );
 
-    /* Broker number must be valid. */
-    configASSERT( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        TickType_t xStartTicks = xTaskGetTickCount();
+    #endif
 
     /* Record the timestamp when this function was called. */
     vTaskSetTimeOutState( &( xTimestamp ) );
 
-    /* Get the actual connection to the broker. */
-    pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
+    /* Keep re-trying until timeout or any error
+     * other than SOCKETS_EWOULDBLOCK occurs. */
+    while( ulBytesSent < ulDataLength )
+    {
+        /* Check for timeout and if timeout has occurred, stop retrying. */
+        if( xTaskCheckForTimeOut( &( xTimestamp ), &( xTicksToWait ) ) == pdTRUE )
+        {
+            break;
+        }
+
+        /* Try sending the remaining data. */
+        lSendRetVal = SOCKETS_Send( pxConnection->xSocket,
+                                    &( pucData[ ulBytesSent ] ),               /* Only send the remaining data. */
+                                    ( size_t ) ( ulDataLength - ulBytesSent ), /* Only send the remaining data. */
+                                    0 );
+
+        /* A negative return value from SOCKETS_Send
+         * means some error occurred. */
+        if( lSendRetVal < 0 )
+        {
+            /* Since the socket is non-blocking, send can return
+             * SOCKETS_EWOULDBLOCK, in which case we retry again until
+             * timeout. In case of any other error, we stop re-trying. */
+            if( lSendRetVal != SOCKETS_EWOULDBLOCK )
+            {
+                break;
+            }
+        }
+        else
+        {
+            /* Update the count of sent bytes. */
+            ulBytesSent += ( uint32_t ) lSendRetVal;
+        }
+    }
+
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        prvAddToStatistic( pxConnection, &( pxConnection->xStatistics.ulBytesSent ), ulBytesSent );
+        prvRecordLatency( pxConnection, &( pxConnection->xStatistics.xSocketSend ), xTaskGetTickCount() - xStartTicks );
+    #endif
+
+    return ulBytesSent;
+}
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SENDV == 1 )
+
+    static uint32_t prvMQTTSendVCallback( void * pvSendContext,
+                                          const MQTTIOVector_t * const pxIOVectors,
+                                          uint32_t ulIOVectorCount )
+    {
+        MQTTBrokerConnection_t * pxConnection;
+        UBaseType_t uxBrokerNumber = ( UBaseType_t ) pvSendContext; /*lint !e923 The cast is ok as we passed the index of the client before. */
+        SocketsIOVector_t xIOVectors[ socketsconfigMAX_SENDV_VECTORS ];
+        uint32_t ulFirstVector = 0, ulBytesSent = 0, ulBytesLeft, x;
+        int32_t lSendRetVal;
+        TimeOut_t xTimestamp;
+        TickType_t xTicksToWait = pdMS_TO_TICKS( mqttconfigTCP_SEND_TIMEOUT_MS );
+
+        #if ( mqttconfigENABLE_STATISTICS == 1 )
+            TickType_t xStartTicks = xTaskGetTickCount();
+        #endif
+
+        /* Broker number and the number of buffers must be valid. */
+        configASSERT( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+        configASSERT( ulIOVectorCount <= ( uint32_t ) socketsconfigMAX_SENDV_VECTORS );
+
+        /* Record the timestamp when this function was called. */
+        vTaskSetTimeOutState( &( xTimestamp ) );
+
+        /* Get the actual connection to the broker. */
+        pxConnection = mqttCONNECTION( uxBrokerNumber );
+
+        #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+            if( prvAddToPublishBatch( pxConnection, pxIOVectors, ulIOVectorCount ) == pdTRUE )
+            {
+                for( x = 0; x < ulIOVectorCount; x++ )
+                {
+                    ulBytesSent += pxIOVectors[ x ].ulDataLength;
+                }
+
+                /* Nothing left to send. */
+                ulIOVectorCount = 0;
+            }
+        #endif /* mqttconfigPUBLISH_BATCH_MAX_DELAY_MS */
+
+        for( x = 0; x < ulIOVectorCount; x++ )
+        {
+            xIOVectors[ x ].pvBuffer = pxIOVectors[ x ].pucData;
+            xIOVectors[ x ].xDataLength = ( size_t ) pxIOVectors[ x ].ulDataLength;
+        }
+
+        /* Keep re-trying until timeout or any error
+         * other than SOCKETS_EWOULDBLOCK occurs. */
+        while( ulFirstVector < ulIOVectorCount )
+        {
+            /* Check for timeout and if timeout has occurred, stop retrying. */
+            if( xTaskCheckForTimeOut( &( xTimestamp ), &( xTicksToWait ) ) == pdTRUE )
+            {
+                break;
+            }
+
+            /* Try sending the remaining buffers. */
+            lSendRetVal = SOCKETS_SendV( pxConnection->xSocket,
+                                         &( xIOVectors[ ulFirstVector ] ),
+                                         ( size_t ) ( ulIOVectorCount - ulFirstVector ),
+                                         0 );
+
+            /* A negative return value from SOCKETS_SendV
+             * means some error occurred. */
+            if( lSendRetVal < 0 )
+            {
+                /* Since the socket is non-blocking, send can return
+                 * SOCKETS_EWOULDBLOCK, in which case we retry again until
+                 * timeout. In case of any other error, we stop re-trying. */
+                if( lSendRetVal != SOCKETS_EWOULDBLOCK )
+                {
+                    break;
+                }
+            }
+            else
+            {
+                /* Update the count of sent bytes and skip the data
+                 * which has been sent. */
+                ulBytesSent += ( uint32_t ) lSendRetVal;
+                ulBytesLeft = ( uint32_t ) lSendRetVal;
+
+                while( ( ulFirstVector < ulIOVectorCount ) && ( ulBytesLeft >= ( uint32_t ) xIOVectors[ ulFirstVector ].xDataLength ) )
+                {
+                    ulBytesLeft -= ( uint32_t ) xIOVectors[ ulFirstVector ].xDataLength;
+                    ulFirstVector++;
+                }
+
+                if( ulFirstVector < ulIOVectorCount )
+                {
+                    xIOVectors[ ulFirstVector ].pvBuffer = &( ( ( const uint8_t * ) xIOVectors[ ulFirstVector ].pvBuffer )[ ulBytesLeft ] );
+                    xIOVectors[ ulFirstVector ].xDataLength -= ( size_t ) ulBytesLeft;
+                }
+            }
+        }
+
+        #if ( mqttconfigENABLE_STATISTICS == 1 )
+            /* Batched data is counted when the batch is sent. */
+            if( ulIOVectorCount > ( uint32_t ) 0 )
+            {
+                prvAddToStatistic( pxConnection, &( pxConnection->xStatistics.ulBytesSent ), ulBytesSent );
+                prvRecordLatency( pxConnection, &( pxConnection->xStatistics.xSocketSend ), xTaskGetTickCount() - xStartTicks );
+            }
+        #endif
+
+        return ulBytesSent;
+    }
+
+#endif /* mqttconfigENABLE_SENDV */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+
+    static BaseType_t prvAddToPublishBatch( MQTTBrokerConnection_t * const pxConnection,
+                                            const MQTTIOVector_t * const pxIOVectors,
+                                            uint32_t ulIOVectorCount )
+    {
+        BaseType_t xAdded = pdFALSE;
+        size_t xTotalLength = 0;
+        uint32_t x;
+
+        for( x = 0; x < ulIOVectorCount; x++ )
+        {
+            xTotalLength += ( size_t ) pxIOVectors[ x ].ulDataLength;
+        }
+
+        /* Make room for the new data, or get the batch out on the wire
+         * before a packet which is not batched. */
+        if( ( pxConnection->xBatchingPublish == pdFALSE ) ||
+            ( xTotalLength > ( sizeof( pxConnection->ucBatchBuffer ) - pxConnection->xBatchLength ) ) )
+        {
+            prvFlushPublishBatch( pxConnection );
+        }
+
+        if( ( pxConnection->xBatchingPublish == pdTRUE ) &&
+            ( xTotalLength <= sizeof( pxConnection->ucBatchBuffer ) ) )
+        {
+            /* Start the batching window with the first publish. */
+            if( pxConnection->xBatchLength == ( size_t ) 0 )
+            {
+                pxConnection->xBatchStartTicks = xTaskGetTickCount();
+            }
+
+            for( x = 0; x < ulIOVectorCount; x++ )
+            {
+                memcpy( &( pxConnection->ucBatchBuffer[ pxConnection->xBatchLength ] ), pxIOVectors[ x ].pucData, ( size_t ) pxIOVectors[ x ].ulDataLength );
+                pxConnection->xBatchLength += ( size_t ) pxIOVectors[ x ].ulDataLength;
+            }
+
+            xAdded = pdTRUE;
+        }
+
+        return xAdded;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvFlushPublishBatch( MQTTBrokerConnection_t * const pxConnection )
+    {
+        uint32_t ulBatchLength = ( uint32_t ) pxConnection->xBatchLength;
+
+        if( ulBatchLength > ( uint32_t ) 0 )
+        {
+            pxConnection->xBatchLength = 0;
+
+            /* The publishes in the batch have already been reported as sent.
+             * If they cannot be sent now, QoS1 publishes will time out waiting
+             * for PUBACK. */
+            if( prvSendOnConnection( pxConnection, pxConnection->ucBatchBuffer, ulBatchLength ) != ulBatchLength )
+            {
+                mqttconfigDEBUG_LOG( ( "Failed to send the publish batch.\r\n" ) );
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static TickType_t prvManagePublishBatches( UBaseType_t uxTaskNumber,
+                                               TickType_t xNextTimeoutTicks )
+    {
+        UBaseType_t uxBrokerNumber;
+        MQTTBrokerConnection_t * pxConnection;
+        TickType_t xElapsedTicks, xWindowTicks = pdMS_TO_TICKS( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS );
+
+        for( uxBrokerNumber = uxTaskNumber; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber += ( UBaseType_t ) mqttconfigMQTT_TASKS )
+        {
+            pxConnection = mqttCONNECTION( uxBrokerNumber );
+
+            if( ( pxConnection != NULL ) && ( pxConnection->xBatchLength > ( size_t ) 0 ) )
+            {
+                xElapsedTicks = xTaskGetTickCount() - pxConnection->xBatchStartTicks;
+
+                if( xElapsedTicks >= xWindowTicks )
+                {
+                    prvFlushPublishBatch( pxConnection );
+                }
+                else if( ( xWindowTicks - xElapsedTicks ) < xNextTimeoutTicks )
+                {
+                    /* Wake up in time to flush this batch. Any publish
+                     * received in the meantime joins the batch. */
+                    xNextTimeoutTicks = xWindowTicks - xElapsedTicks;
+                }
+                else
+                {
+                    /* The MQTT task wakes up before the window elapses. */
+                }
+            }
+        }
+
+        return xNextTimeoutTicks;
+    }
+
+#endif /* mqttconfigPUBLISH_BATCH_MAX_DELAY_MS */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+
+    static BaseType_t prvStoreOfflinePublish( MQTTEventData_t * const pxEventData )
+    {
+        BaseType_t xHandled = pdFALSE;
+        const MQTTAgentPublishParams_t * pxParams = pxEventData->u.pxPublishParams;
+        MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
+        MQTTOfflinePublish_t * pxEntry;
+
+        if( ( pxConnection->xSocket == SOCKETS_INVALID_SOCKET ) && ( pxParams->xQoS == eMQTTQoS1 ) )
+        {
+            xHandled = pdTRUE;
+
+            if( ( pxConnection->uxOfflineCount < ( UBaseType_t ) mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH ) &&
+                ( ( ( uint32_t ) pxParams->usTopicLength + pxParams->ulDataLength ) <= ( uint32_t ) mqttconfigOFFLINE_PUBLISH_MAX_BYTES ) )
+            {
+                pxEntry = &( pxConnection->xOfflinePublishes[ ( pxConnection->uxOfflineHead + pxConnection->uxOfflineCount ) % ( UBaseType_t ) mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH ] );
+                pxEntry->usTopicLength = pxParams->usTopicLength;
+                pxEntry->ulDataLength = pxParams->ulDataLength;
+                ( void ) memcpy( pxEntry->ucTopicAndData, pxParams->pucTopic, pxParams->usTopicLength );
+                ( void ) memcpy( &( pxEntry->ucTopicAndData[ pxParams->usTopicLength ] ), pxParams->pvData, pxParams->ulDataLength );
+                pxConnection->uxOfflineCount++;
+
+                mqttconfigOFFLINE_PUBLISH_APPEND( pxEventData->uxBrokerNumber, pxEntry, sizeof( MQTTOfflinePublish_t ) );
+
+                prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBStoredOffline, pdPASS );
+            }
+            else
+            {
+                mqttconfigDEBUG_LOG( ( "Could not store the publish while disconnected.\r\n" ) );
+                prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBCouldNotBeSent, pdFAIL );
+            }
+        }
+
+        return xHandled;
+    }
+/*-----------------------------------------------------------*/
 
-    /* Keep re-trying until timeout or any error
-     * other than SOCKETS_EWOULDBLOCK occurs. */
-    while( ulBytesSent < ulDataLength )
+    static void prvLoadOfflinePublishes( UBaseType_t uxBrokerNumber )
     {
-        /* Check for timeout and if timeout has occurred, stop retrying. */
-        if( xTaskCheckForTimeOut( &( xTimestamp ), &( xTicksToWait ) ) == pdTRUE )
+        MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( uxBrokerNumber );
+
+        /* The connection is not in use yet, so the MQTT task does not
+         * access it concurrently. */
+        pxConnection->uxOfflineHead = 0;
+        pxConnection->uxOfflineCount = 0;
+        pxConnection->xOfflineDrainEnabled = pdFALSE;
+        pxConnection->usOfflineInFlight = 0;
+
+        while( ( pxConnection->uxOfflineCount < ( UBaseType_t ) mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH ) &&
+               ( mqttconfigOFFLINE_PUBLISH_LOAD( uxBrokerNumber,
+                                                 pxConnection->uxOfflineCount,
+                                                 &( pxConnection->xOfflinePublishes[ pxConnection->uxOfflineCount ] ),
+                                                 sizeof( MQTTOfflinePublish_t ) ) == pdTRUE ) )
         {
-            break;
+            pxConnection->uxOfflineCount++;
         }
+    }
+/*-----------------------------------------------------------*/
 
-        /* Try sending the remaining data. */
-        lSendRetVal = SOCKETS_Send( pxConnection->xSocket,
-                                    &( pucData[ ulBytesSent ] ),               /* Only send the remaining data. */
-                                    ( size_t ) ( ulDataLength - ulBytesSent ), /* Only send the remaining data. */
-                                    0 );
+    static TickType_t prvManageOfflinePublishes( UBaseType_t uxTaskNumber,
+                                                 TickType_t xNextTimeoutTicks )
+    {
+        UBaseType_t uxBrokerNumber;
+        MQTTBrokerConnection_t * pxConnection;
+        MQTTOfflinePublish_t * pxEntry;
+        MQTTPublishParams_t xPublishParams;
+        TickType_t xTicksUntilDrain, xTickCount = xTaskGetTickCount();
 
-        /* A negative return value from SOCKETS_Send
-         * means some error occurred. */
-        if( lSendRetVal < 0 )
+        for( uxBrokerNumber = uxTaskNumber; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber += ( UBaseType_t ) mqttconfigMQTT_TASKS )
         {
-            /* Since the socket is non-blocking, send can return
-             * SOCKETS_EWOULDBLOCK, in which case we retry again until
-             * timeout. In case of any other error, we stop re-trying. */
-            if( lSendRetVal != SOCKETS_EWOULDBLOCK )
+            pxConnection = mqttCONNECTION( uxBrokerNumber );
+
+            /* Stored publishes are sent one at a time, so only the oldest is
+             * ever waiting for its PUBACK. */
+            if( ( pxConnection != NULL ) &&
+                ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) &&
+                ( pxConnection->xOfflineDrainEnabled == pdTRUE ) &&
+                ( pxConnection->uxOfflineCount > ( UBaseType_t ) 0 ) &&
+                ( pxConnection->usOfflineInFlight == ( uint16_t ) 0 ) )
             {
-                break;
+                xTicksUntilDrain = pxConnection->xOfflineNextDrainTicks - xTickCount;
+
+                /* The subtraction wraps if the drain time is in the past. */
+                if( ( xTicksUntilDrain == ( TickType_t ) 0 ) ||
+                    ( xTicksUntilDrain > pdMS_TO_TICKS( mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS ) ) )
+                {
+                    pxEntry = &( pxConnection->xOfflinePublishes[ pxConnection->uxOfflineHead ] );
+
+                    xPublishParams.pucTopic = pxEntry->ucTopicAndData;
+                    xPublishParams.usTopicLength = pxEntry->usTopicLength;
+                    xPublishParams.xQos = eMQTTQoS1;
+                    xPublishParams.pvData = &( pxEntry->ucTopicAndData[ pxEntry->usTopicLength ] );
+                    xPublishParams.ulDataLength = pxEntry->ulDataLength;
+                    xPublishParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( prvGetMessageIdentifier() ) );
+                    xPublishParams.ulTimeoutTicks = pdMS_TO_TICKS( mqttconfigOFFLINE_PUBLISH_ACK_TIMEOUT_MS );
+
+                    /* No task waits for the result, so a failed publish is
+                     * simply tried again after the drain interval. */
+                    if( MQTT_Publish( &( pxConnection->xMQTTContext ), &( xPublishParams ) ) == eMQTTSuccess )
+                    {
+                        pxConnection->usOfflineInFlight = xPublishParams.usPacketIdentifier;
+                    }
+
+                    pxConnection->xOfflineNextDrainTicks = xTickCount + pdMS_TO_TICKS( mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS );
+                    xTicksUntilDrain = pdMS_TO_TICKS( mqttconfigOFFLINE_PUBLISH_DRAIN_INTERVAL_MS );
+                }
+
+                xNextTimeoutTicks = configMIN( xNextTimeoutTicks, xTicksUntilDrain );
             }
         }
-        else
+
+        return xNextTimeoutTicks;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvOfflinePublishAcknowledged( MQTTBrokerConnection_t * const pxConnection,
+                                               uint16_t usPacketIdentifier )
+    {
+        if( ( pxConnection->usOfflineInFlight != ( uint16_t ) 0 ) &&
+            ( pxConnection->usOfflineInFlight == usPacketIdentifier ) )
         {
-            /* Update the count of sent bytes. */
-            ulBytesSent += ( uint32_t ) lSendRetVal;
+            pxConnection->usOfflineInFlight = 0;
+            pxConnection->uxOfflineHead = ( pxConnection->uxOfflineHead + 1U ) % ( UBaseType_t ) mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH;
+            pxConnection->uxOfflineCount--;
+
+            mqttconfigOFFLINE_PUBLISH_REMOVE( ( UBaseType_t ) pxConnection->uxBrokerNumber );
         }
     }
 
-    return ulBytesSent;
-}
+#endif /* mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH */
 /*-----------------------------------------------------------*/
+
 static MQTTBool_t prvMQTTEventCallback( void * pvCallbackContext,
                                         const MQTTEventCallbackParams_t * const pxParams )
 {
@@ -688,7 +1501,7 @@ static MQTTBool_t prvMQTTEventCallback( void * pvCallbackContext,
     configASSERT( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
 
     /* Get the actual connection to the broker. */
-    pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
+    pxConnection = mqttCONNECTION( uxBrokerNumber );
 
     switch( pxParams->xEventType )
     {
@@ -727,9 +1540,19 @@ static MQTTBool_t prvMQTTEventCallback( void * pvCallbackContext,
             prvProcessReceivedDisconnect( pxConnection, pxParams );
             break;
 
+        #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+            case eMQTTPublishChunk:
+                prvProcessReceivedPublishChunk( pxConnection, pxParams );
+                break;
+        #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
+
         case eMQTTPacketDropped:
             mqttconfigDEBUG_LOG( ( "[WARN] MQTT Agent dropped a packet. No buffer available.\r\n" ) );
             mqttconfigDEBUG_LOG( ( "Consider adjusting parameters in aws_bufferpool_config.h.\r\n" ) );
+
+            #if ( mqttconfigENABLE_STATISTICS == 1 )
+                prvAddToStatistic( pxConnection, &( pxConnection->xStatistics.ulNoFreeBuffer ), 1 );
+            #endif
             break;
 
         default:
@@ -768,10 +1591,10 @@ static BaseType_t prvGetFreeConnection( void )
     for( x = 0; x < mqttconfigMAX_BROKERS; x++ )
     {
         /* If we find a free connection... */
-        if( xMQTTConnections[ x ].xConnectionInUse == pdFALSE )
+        if( xConnectionInUse[ x ] == pdFALSE )
         {
             /* ...mark the connection "in use" and stop. */
-            xMQTTConnections[ x ].xConnectionInUse = pdTRUE;
+            xConnectionInUse[ x ] = pdTRUE;
             break;
         }
     }
@@ -797,11 +1620,141 @@ static void prvReturnConnection( UBaseType_t uxBrokerNumber )
      * be in critical section. */
     taskENTER_CRITICAL();
     /* Mark the connection as "not in use". */
-    xMQTTConnections[ uxBrokerNumber ].xConnectionInUse = pdFALSE;
+    xConnectionInUse[ uxBrokerNumber ] = pdFALSE;
     taskEXIT_CRITICAL();
 }
 /*-----------------------------------------------------------*/
 
+static BaseType_t prvInitConnection( MQTTBrokerConnection_t * const pxConnection,
+                                     UBaseType_t uxBrokerNumber )
+{
+    BaseType_t xReturnCode = pdPASS;
+    MQTTInitParams_t xInitParams;
+    UBaseType_t y;
+
+    /* Ensure the connection structure starts in a consistent state. */
+    memset( pxConnection, 0x00, sizeof( MQTTBrokerConnection_t ) );
+
+    pxConnection->xSocket = SOCKETS_INVALID_SOCKET;
+    pxConnection->uxBrokerNumber = uxBrokerNumber;
+
+    #if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+        /* Allocated when the socket is created. */
+        pxConnection->pucRxBuffer = NULL;
+    #else
+        pxConnection->pucRxBuffer = pxConnection->ucRxBuffer;
+    #endif
+
+    /* Initialize user callback and data. These are provided during connect. */
+    pxConnection->pvUserData = NULL;
+    pxConnection->pxCallback = NULL;
+
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        /* Start with an empty publish batch. */
+        pxConnection->xBatchingPublish = pdFALSE;
+        pxConnection->xBatchLength = 0;
+    #endif
+
+    /* Initialize the MQTT Core Library context. */
+    xInitParams.pvCallbackContext = ( void * ) uxBrokerNumber; /*lint !e923 The cast is ok as we are passing the index of the client. */
+    xInitParams.pxCallback = prvMQTTEventCallback;
+    xInitParams.pvSendContext = ( void * ) uxBrokerNumber;     /*lint !e923 The cast is ok as we are passing the index of the client. */
+    xInitParams.pxMQTTSendFxn = prvMQTTSendCallback;
+    #if ( mqttconfigENABLE_SENDV == 1 )
+        xInitParams.pxMQTTSendVFxn = prvMQTTSendVCallback;
+    #else
+        xInitParams.pxMQTTSendVFxn = NULL;
+    #endif
+    xInitParams.pxGetTicksFxn = prvMQTTGetTicks;
+    #if ( mqttconfigBUFFER_WAIT_MS > 0 )
+        xInitParams.xBufferPoolInterface.pxGetBufferFxn = prvGetFreeBufferWait;
+        pxConnection->xReadPaused = pdFALSE;
+    #else
+        xInitParams.xBufferPoolInterface.pxGetBufferFxn = mqttconfigGET_FREE_BUFFER_FXN;
+    #endif
+    xInitParams.xBufferPoolInterface.pxReturnBufferFxn = mqttconfigRETURN_BUFFER_FXN;
+
+    if( MQTT_Init( &( pxConnection->xMQTTContext ), &xInitParams ) != eMQTTSuccess )
+    {
+        xReturnCode = pdFAIL;
+    }
+    else
+    {
+        /* Initialize waiting tasks list. */
+        for( y = 0; y < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; y++ )
+        {
+            pxConnection->xWaitingTasks[ y ].xTaskToNotify = NULL;
+            pxConnection->xWaitingTasks[ y ].ulMessageIdentifier = 0;
+        }
+
+        #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+            /* Start with an empty asynchronous publish window. */
+            for( y = 0; y < ( UBaseType_t ) mqttconfigASYNC_PUBLISH_WINDOW; y++ )
+            {
+                pxConnection->xAsyncPublishes[ y ].xInUse = pdFALSE;
+                pxConnection->xAsyncPublishes[ y ].xInFlight = pdFALSE;
+            }
+
+            pxConnection->xAsyncPublishWindow = xSemaphoreCreateCountingStatic( ( UBaseType_t ) mqttconfigASYNC_PUBLISH_WINDOW,
+                                                                                ( UBaseType_t ) mqttconfigASYNC_PUBLISH_WINDOW,
+                                                                                &( pxConnection->xAsyncPublishWindowBuffer ) );
+            configASSERT( pxConnection->xAsyncPublishWindow );
+        #endif
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+
+    static BaseType_t prvAllocateConnection( UBaseType_t uxBrokerNumber )
+    {
+        BaseType_t xReturnCode = pdPASS;
+        MQTTBrokerConnection_t * pxConnection;
+
+        /* Only the application task which got the connection from
+         * prvGetFreeConnection() writes its pointer. */
+        if( pxMQTTConnections[ uxBrokerNumber ] == NULL )
+        {
+            pxConnection = ( MQTTBrokerConnection_t * ) pvPortMalloc( sizeof( MQTTBrokerConnection_t ) );
+
+            if( pxConnection == NULL )
+            {
+                mqttconfigDEBUG_LOG( ( "Failed to allocate MQTTBrokerConnection_t!\r\n" ) );
+                xReturnCode = pdFAIL;
+            }
+            else if( prvInitConnection( pxConnection, uxBrokerNumber ) != pdPASS )
+            {
+                vPortFree( pxConnection );
+                xReturnCode = pdFAIL;
+            }
+            else
+            {
+                /* The MQTT tasks skip the connection until it is published
+                 * here, fully initialized. */
+                taskENTER_CRITICAL();
+                pxMQTTConnections[ uxBrokerNumber ] = pxConnection;
+                taskEXIT_CRITICAL();
+            }
+        }
+
+        return xReturnCode;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvFreeRxBuffer( MQTTBrokerConnection_t * const pxConnection )
+    {
+        if( pxConnection->pucRxBuffer != NULL )
+        {
+            vPortFree( pxConnection->pucRxBuffer );
+            pxConnection->pucRxBuffer = NULL;
+        }
+    }
+
+#endif /* mqttconfigALLOCATE_CONNECTIONS */
+/*-----------------------------------------------------------*/
+
 static MQTTNotificationData_t * prvStoreNotificationData( MQTTBrokerConnection_t * const pxConnection,
                                                           const MQTTEventData_t * const pxEventData )
 {
@@ -855,7 +1808,7 @@ static BaseType_t prvSetupConnection( const MQTTEventData_t * const pxEventData
     SocketsSockaddr_t xMQTTServerAddress = { 0 };
     BaseType_t xStatus = pdPASS;
     size_t xURLLength;
-    MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+    MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
     char * ppcAlpns[] = { socketsAWS_IOT_ALPN_MQTT };
     TickType_t xMqttTimeout;
 
@@ -883,18 +1836,32 @@ static BaseType_t prvSetupConnection( const MQTTEventData_t * const pxEventData
         xMQTTServerAddress.ulAddress = SOCKETS_GetHostByName( pxEventData->u.pxConnectParams->pcURL );
         xMQTTServerAddress.ucSocketDomain = SOCKETS_AF_INET;
 
-        /* Create the socket. */
-        pxConnection->xSocket = SOCKETS_Socket( SOCKETS_AF_INET, SOCKETS_SOCK_STREAM, SOCKETS_IPPROTO_TCP );
+        #if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+            /* The receive buffer is only held while there is a socket. */
+            pxConnection->pucRxBuffer = ( uint8_t * ) pvPortMalloc( mqttconfigRX_BUFFER_SIZE );
+
+            if( pxConnection->pucRxBuffer != NULL )
+        #endif
+        {
+            /* Create the socket. */
+            pxConnection->xSocket = SOCKETS_Socket( SOCKETS_AF_INET, SOCKETS_SOCK_STREAM, SOCKETS_IPPROTO_TCP );
+        }
 
         if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
         {
             /* Set a callback function that will unblock the MQTT task when data
-             * is received on a socket. */
-            ( void ) SOCKETS_SetSockOpt( pxConnection->xSocket,
-                                         0,                                            /* Level - Unused. */
-                                         SOCKETS_SO_WAKEUP_CALLBACK,
-                                         ( void * ) prvMQTTClientSocketWakeupCallback, /*lint !e9087 !e9074 The cast is ok as we are setting the callback here. */
-                                         sizeof( &( prvMQTTClientSocketWakeupCallback ) ) );
+             * is received on a socket. If the socket cannot report received
+             * data, it has to be read every time the MQTT task runs. */
+            pxConnection->uxFlags &= ~mqttCONNECTION_POLL_RX;
+
+            if( SOCKETS_SetSockOpt( pxConnection->xSocket,
+                                    0,                                            /* Level - Unused. */
+                                    SOCKETS_SO_WAKEUP_CALLBACK,
+                                    ( void * ) prvMQTTClientSocketWakeupCallback, /*lint !e9087 !e9074 The cast is ok as we are setting the callback here. */
+                                    sizeof( &( prvMQTTClientSocketWakeupCallback ) ) ) != SOCKETS_ERROR_NONE )
+            {
+                pxConnection->uxFlags |= mqttCONNECTION_POLL_RX;
+            }
 
             /* Set secure socket option if it is a secured connection. */
             if( ( pxConnection->uxFlags & mqttCONNECTION_SECURED ) == mqttCONNECTION_SECURED )
@@ -970,6 +1937,12 @@ static BaseType_t prvSetupConnection( const MQTTEventData_t * const pxEventData
                                              NULL /* Unused. */,
                                              0 /* Unused. */ );
 
+                #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+                    /* Data may have arrived during the handshake, so read the
+                     * new connection at least once. */
+                    prvMarkConnectionToRead( pxEventData->uxBrokerNumber );
+                #endif
+
                 /* Set the Send Timeout of Socket to mqttconfigTCP_SEND_TIMEOUT_MS to block on sends. */
 
                 xMqttTimeout = pdMS_TO_TICKS( mqttconfigTCP_SEND_TIMEOUT_MS );
@@ -991,6 +1964,9 @@ static BaseType_t prvSetupConnection( const MQTTEventData_t * const pxEventData
         }
         else
         {
+            #if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+                prvFreeRxBuffer( pxConnection );
+            #endif
             xStatus = pdFAIL;
         }
     }
@@ -1021,7 +1997,7 @@ static void prvGracefulSocketClose( MQTTBrokerConnection_t * const pxConnection
 
     /* Wait for the socket to disconnect gracefully (indicated by a
      * SOCKETS_ERRNO_EINVAL error) before closing the socket. */
-    while( SOCKETS_Recv( pxConnection->xSocket, pxConnection->ucRxBuffer, sizeof( pxConnection->ucRxBuffer ), 0 ) >= 0 )
+    while( SOCKETS_Recv( pxConnection->xSocket, pxConnection->pucRxBuffer, mqttconfigRX_BUFFER_SIZE, 0 ) >= 0 )
     {
         vTaskDelay( xShortDelay );
 
@@ -1036,6 +2012,15 @@ static void prvGracefulSocketClose( MQTTBrokerConnection_t * const pxConnection
     /* Close the socket. */
     ( void ) SOCKETS_Close( pxConnection->xSocket );
     pxConnection->xSocket = SOCKETS_INVALID_SOCKET;
+
+    #if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+        prvFreeRxBuffer( pxConnection );
+    #endif
+
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        /* Anything still in the batch can no longer be sent. */
+        pxConnection->xBatchLength = 0;
+    #endif
     mqttconfigDEBUG_LOG( ( "Socket closed.\r\n" ) );
 
     #if ( INCLUDE_uxTaskGetStackHighWaterMark == 1 )
@@ -1047,24 +2032,109 @@ static void prvGracefulSocketClose( MQTTBrokerConnection_t * const pxConnection
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+
+    static void prvMarkConnectionToRead( UBaseType_t uxBrokerNumber )
+    {
+        taskENTER_CRITICAL();
+        ulConnectionsToRead |= ( uint32_t ) 1 << uxBrokerNumber;
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* mqttconfigENABLE_EVENT_DRIVEN_RX */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigBUFFER_WAIT_MS > 0 )
+
+    static uint8_t * prvGetFreeBufferWait( uint32_t * pulBufferLength )
+    {
+        return BUFFERPOOL_GetFreeBufferWait( pulBufferLength, pdMS_TO_TICKS( mqttconfigBUFFER_WAIT_MS ) );
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvPauseReading( MQTTBrokerConnection_t * const pxConnection )
+    {
+        BaseType_t xPause = pdFALSE;
+
+        if( BUFFERPOOL_GetFreeBufferCount() == ( uint32_t ) 0 )
+        {
+            if( pxConnection->xReadPaused == pdFALSE )
+            {
+                pxConnection->xReadPaused = pdTRUE;
+                pxConnection->xReadPausedTicks = xTaskGetTickCount();
+            }
+
+            /* Read again once the wait is over, so that acknowledgements
+             * which free buffers are not held back for ever. Packets which
+             * then find no buffer are dropped. */
+            if( ( xTaskGetTickCount() - pxConnection->xReadPausedTicks ) < pdMS_TO_TICKS( mqttconfigBUFFER_WAIT_MS ) )
+            {
+                xPause = pdTRUE;
+            }
+        }
+        else
+        {
+            pxConnection->xReadPaused = pdFALSE;
+        }
+
+        return xPause;
+    }
+
+#endif /* mqttconfigBUFFER_WAIT_MS */
+/*-----------------------------------------------------------*/
+
 static void prvMQTTClientSocketWakeupCallback( Socket_t pxSocket )
 {
     const TickType_t xTicksToWait = pdMS_TO_TICKS( 20 );
     MQTTEventData_t xEventData;
-
-    /* Just to avoid compiler warnings.  The socket is not used but the function
-     * prototype cannot be changed because this is a callback function. */
-    ( void ) pxSocket;
+    UBaseType_t uxBrokerNumber;
+    MQTTBrokerConnection_t * pxConnection;
+    QueueHandle_t xCommandQueue;
 
     /* Should not be possible to get here without the task having been
      * created! */
-    configASSERT( xMQTTTaskHandle );
+    configASSERT( xMQTTTaskHandles[ 0 ] );
+
+    /* Find the connection the socket belongs to, so the MQTT task which
+     * serves it can be woken. */
+    for( uxBrokerNumber = 0; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber++ )
+    {
+        pxConnection = mqttCONNECTION( uxBrokerNumber );
+
+        if( ( pxConnection != NULL ) && ( pxConnection->xSocket == pxSocket ) )
+        {
+            break;
+        }
+    }
+
+    #if ( mqttconfigMQTT_TASKS == 1 )
+        /* There is only one MQTT task to wake, whichever connection this is. */
+        xCommandQueue = xCommandQueues[ 0 ];
+    #else
+        if( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS )
+        {
+            xCommandQueue = xCommandQueues[ mqttTASK_FOR_BROKER( uxBrokerNumber ) ];
+        }
+        else
+        {
+            /* The socket was closed, so no task needs to service it. */
+            xCommandQueue = NULL;
+        }
+    #endif
+
+    #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+        /* Record which connection needs to be read. */
+        if( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS )
+        {
+            prvMarkConnectionToRead( uxBrokerNumber );
+        }
+    #endif
 
     /* A socket used by the MQTT task may need attention.  Send an event
-     * to the MQTT task to make sure the task is not blocked on xCommandQueue.
+     * to the MQTT task to make sure the task is not blocked on its command queue.
      * There is only any need to do this if there are no messages already in the
      * queue, as if there are, the task won't block anyway. */
-    if( uxQueueMessagesWaiting( xCommandQueue ) == ( UBaseType_t ) 0 )
+    if( ( xCommandQueue != NULL ) && ( uxQueueMessagesWaiting( xCommandQueue ) == ( UBaseType_t ) 0 ) )
     {
         /* The eMQTTServiceSocket event is not handled directly, it is only used
          * to unblock the MQTT task, so only the xEventType needs to be set. */
@@ -1081,6 +2151,15 @@ static void prvProcessReceivedCONNACK( MQTTBrokerConnection_t * const pxConnecti
 {
     MQTTNotificationData_t * pxNotificationData;
 
+    #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+        /* Publishes stored while the connection was down can be sent now. */
+        if( pxParams->u.xMQTTConnACKData.xConnACKReturnCode == eMQTTConnACKConnectionAccepted )
+        {
+            pxConnection->xOfflineDrainEnabled = pdTRUE;
+            pxConnection->xOfflineNextDrainTicks = xTaskGetTickCount();
+        }
+    #endif
+
     /* Retrieve the notification data for the task which initiated the Connect operation.*/
     pxNotificationData = prvRetrieveNotificationData( pxConnection, pxParams->u.xMQTTConnACKData.usPacketIdentifier );
 
@@ -1155,6 +2234,27 @@ static void prvProcessReceivedPUBACK( MQTTBrokerConnection_t * const pxConnectio
                                       const MQTTEventCallbackParams_t * const pxParams )
 {
     MQTTNotificationData_t * pxNotificationData;
+    BaseType_t xAccepted = pdPASS;
+
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        /* An MQTT 5.0 broker may refuse the publish in the PUBACK. */
+        if( pxParams->u.xMQTTPubACKData.ucReasonCode >= ( uint8_t ) 0x80 )
+        {
+            xAccepted = pdFAIL;
+        }
+    #endif
+
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        prvStopPublishTimer( pxConnection, pxParams->u.xMQTTPubACKData.usPacketIdentifier, pdTRUE );
+    #endif
+
+    #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+        prvOfflinePublishAcknowledged( pxConnection, pxParams->u.xMQTTPubACKData.usPacketIdentifier );
+    #endif
+
+    #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+        prvCompleteAsyncPublishInFlight( pxConnection, pxParams->u.xMQTTPubACKData.usPacketIdentifier, ( xAccepted == pdPASS ) ? eMQTTAgentSuccess : eMQTTAgentFailure );
+    #endif
 
     /* Retrieve the notification data for the task which initiated the Publish operation.*/
     pxNotificationData = prvRetrieveNotificationData( pxConnection, pxParams->u.xMQTTPubACKData.usPacketIdentifier );
@@ -1163,8 +2263,8 @@ static void prvProcessReceivedPUBACK( MQTTBrokerConnection_t * const pxConnectio
     if( pxNotificationData != NULL )
     {
         /* Otherwise inform the task. */
-        mqttconfigDEBUG_LOG( ( "MQTT Publish was successful.\r\n" ) );
-        prvNotifyRequestingTask( pxNotificationData, eMQTTPUBACKReceived, pdPASS );
+        mqttconfigDEBUG_LOG( ( ( xAccepted == pdPASS ) ? "MQTT Publish was successful.\r\n" : "MQTT Publish was refused by the broker.\r\n" ) );
+        prvNotifyRequestingTask( pxNotificationData, eMQTTPUBACKReceived, xAccepted );
     }
 }
 /*-----------------------------------------------------------*/
@@ -1192,11 +2292,48 @@ static BaseType_t prvProcessReceivedPublish( MQTTBrokerConnection_t * const pxCo
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+
+    static void prvProcessReceivedPublishChunk( MQTTBrokerConnection_t * const pxConnection,
+                                                const MQTTEventCallbackParams_t * const pxParams )
+    {
+        MQTTAgentCallbackParams_t xCallbackParams;
+
+        /* The chunk is only valid during the callback, so there is no
+         * buffer for the user to take. */
+        if( pxConnection->pxCallback != NULL )
+        {
+            xCallbackParams.xMQTTEvent = eMQTTAgentPublishChunk;
+            xCallbackParams.u.xPublishChunkData = pxParams->u.xPublishChunkData;
+
+            ( void ) pxConnection->pxCallback( pxConnection->pvUserData, &( xCallbackParams ) );
+        }
+    }
+
+#endif /* mqttconfigENABLE_STREAMING_PUBLISH */
+/*-----------------------------------------------------------*/
+
 static void prvProcessReceivedTimeout( MQTTBrokerConnection_t * const pxConnection,
                                        const MQTTEventCallbackParams_t * const pxParams )
 {
     MQTTNotificationData_t * pxNotificationData;
 
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        prvStopPublishTimer( pxConnection, pxParams->u.xTimeoutData.usPacketIdentifier, pdFALSE );
+    #endif
+
+    #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+        /* A stored publish whose PUBACK timed out is sent again. */
+        if( pxConnection->usOfflineInFlight == pxParams->u.xTimeoutData.usPacketIdentifier )
+        {
+            pxConnection->usOfflineInFlight = 0;
+        }
+    #endif
+
+    #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+        prvCompleteAsyncPublishInFlight( pxConnection, pxParams->u.xTimeoutData.usPacketIdentifier, eMQTTAgentTimeout );
+    #endif
+
     /* Try to see if there is a task waiting for the operation which just timed out. */
     pxNotificationData = prvRetrieveNotificationData( pxConnection, pxParams->u.xTimeoutData.usPacketIdentifier );
 
@@ -1219,6 +2356,18 @@ static void prvProcessReceivedDisconnect( MQTTBrokerConnection_t * const pxConne
     /* Remove compiler warnings about unused parameters. */
     ( void ) pxParams;
 
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        /* No PUBACK can arrive for the publishes still being timed. */
+        prvStopPublishTimer( pxConnection, 0, pdFALSE );
+    #endif
+
+    #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+        /* Stored publishes wait for the next accepted connection, including
+         * one which was sent but not acknowledged. */
+        pxConnection->xOfflineDrainEnabled = pdFALSE;
+        pxConnection->usOfflineInFlight = 0;
+    #endif
+
     /* Only process the disconnect event if the client is connected. */
     if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
     {
@@ -1250,6 +2399,18 @@ static void prvProcessReceivedDisconnect( MQTTBrokerConnection_t * const pxConne
                                      pdFAIL );
         }
     }
+
+    #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+        /* The same applies to asynchronous publishes. Those still in the
+         * command queue fail when they are processed. */
+        for( x = 0; x < ( UBaseType_t ) mqttconfigASYNC_PUBLISH_WINDOW; x++ )
+        {
+            if( pxConnection->xAsyncPublishes[ x ].xInFlight == pdTRUE )
+            {
+                prvCompleteAsyncPublish( pxConnection, &( pxConnection->xAsyncPublishes[ x ] ), eMQTTAgentFailure );
+            }
+        }
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -1269,7 +2430,7 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
         pxNotificationData->ulMessageIdentifier |= uxStatus;
 
         /* Notify the task. */
-        ( void ) xTaskNotify( pxNotificationData->xTaskToNotify, pxNotificationData->ulMessageIdentifier, eSetValueWithoutOverwrite );
+        ( void ) xTaskNotifyIndexed( pxNotificationData->xTaskToNotify, mqttconfigNOTIFICATION_INDEX, pxNotificationData->ulMessageIdentifier, eSetValueWithoutOverwrite );
 
         /* Free up the buffer for further use. */
         pxNotificationData->xTaskToNotify = NULL;
@@ -1277,7 +2438,7 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
 }
 /*-----------------------------------------------------------*/
 
-static TickType_t prvManageConnections( void )
+static TickType_t prvManageConnections( UBaseType_t uxTaskNumber )
 {
     UBaseType_t uxBrokerNumber;
     MQTTBrokerConnection_t * pxConnection;
@@ -1285,77 +2446,185 @@ static TickType_t prvManageConnections( void )
     int32_t lBytesReceived;
     TickType_t xNextMQTTPeriodicInvokeTicks, xNextTimeoutTicks = portMAX_DELAY;
     uint64_t xTickCount = 0;
+    BaseType_t xReadPaused = pdFALSE;
 
-    /* For each broker the MQTT task might be connected to. */
-    for( uxBrokerNumber = 0; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber++ )
+    #if ( mqttconfigENABLE_ZERO_COPY_RX == 1 )
+        uint8_t * pucReceivedData = NULL;
+    #endif
+
+    #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+        BaseType_t xAnyPolledClient = pdFALSE;
+        uint32_t ulToRead, ulServedByTask = 0;
+
+        for( uxBrokerNumber = uxTaskNumber; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber += ( UBaseType_t ) mqttconfigMQTT_TASKS )
+        {
+            ulServedByTask |= ( uint32_t ) 1 << uxBrokerNumber;
+        }
+
+        /* Take the set of connections served by this task that reported data.
+         * Connections that report more data while they are being read are
+         * marked again. */
+        taskENTER_CRITICAL();
+        ulToRead = ulConnectionsToRead & ulServedByTask;
+        ulConnectionsToRead &= ~ulServedByTask;
+        taskEXIT_CRITICAL();
+    #endif
+
+    /* For each broker this MQTT task might be connected to. */
+    for( uxBrokerNumber = uxTaskNumber; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber += ( UBaseType_t ) mqttconfigMQTT_TASKS )
     {
-        pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
+        pxConnection = mqttCONNECTION( uxBrokerNumber );
 
-        /* Process only the connected clients. */
-        if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+        /* Only the connections which have been created are allocated. */
+        if( pxConnection != NULL )
         {
-            /* Read data from the socket. */
-            lBytesReceived = SOCKETS_Recv( pxConnection->xSocket, pxConnection->ucRxBuffer, mqttconfigRX_BUFFER_SIZE, 0 );
+            lBytesReceived = 0;
 
-            /* If data was read, pass it to the MQTT Core library. */
-            if( lBytesReceived > 0 )
-            {
-                ( void ) MQTT_ParseReceivedData( &( pxConnection->xMQTTContext ), pxConnection->ucRxBuffer, ( size_t ) lBytesReceived );
-
-                /* Some data was received on this socket and we do not
-                 * know if there is more data available. Therefore we
-                 * set xNextTimeoutTicks to zero which ensures that we
-                 * do not block on the command queue and try to read
-                 * again from this socket on the next invocation of
-                 * prvManageConnections. This way we ensure that we keep
-                 * processing commands received on the command queue
-                 * between calls to SOCKETS_Recv. As a result, a socket
-                 * receiving lots of data continuously does not starve
-                 * the command processing. */
-                xNextTimeoutTicks = 0;
-            }
-            else if( lBytesReceived < 0 )
-            {
-                /* A negative return value from SOCKETS_Recv indicates error.
-                 * Since the socket is marked non-blocking, read can potentially
-                 * return SOCKETS_EWOULDBLOCK in which case we will re-try to
-                 * read on the next execution of this function. In case of any
-                 * other error, we disconnect. */
-                if( lBytesReceived != SOCKETS_EWOULDBLOCK )
+            #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+                if( ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) &&
+                    ( ( pxConnection->uxFlags & mqttCONNECTION_POLL_RX ) == mqttCONNECTION_POLL_RX ) )
                 {
-                    /* Disconnect from the broker. Note that the socket close
-                     * and cleanup will happen in the disconnect callback
-                     * ( prvProcessReceivedDisconnect function ) from the core
-                     * MQTT library. */
-                    ( void ) MQTT_Disconnect( &( pxConnection->xMQTTContext ) );
+                    xAnyPolledClient = pdTRUE;
                 }
-            }
-            else
+            #endif
+
+            /* Process only the connected clients, and when reads are event
+             * driven, only those which may have data. */
+            #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+                if( ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) &&
+                    ( ( ( ulToRead & ( ( uint32_t ) 1 << uxBrokerNumber ) ) != 0 ) ||
+                      ( ( pxConnection->uxFlags & mqttCONNECTION_POLL_RX ) == mqttCONNECTION_POLL_RX ) ) )
+            #else
+                if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+            #endif
             {
-                /* If no data was received on this socket, we continue
-                 * to call MQTT_Periodic and calculate xNextTimeoutTicks
-                 * accordingly. */
+                #if ( mqttconfigBUFFER_WAIT_MS > 0 )
+                    xReadPaused = prvPauseReading( pxConnection );
+
+                    if( xReadPaused == pdTRUE )
+                    {
+                        /* Leave the data in the socket and check the buffer pool
+                         * again on the next tick. */
+                        xNextTimeoutTicks = configMIN( xNextTimeoutTicks, ( TickType_t ) 1 );
+
+                        #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+                            prvMarkConnectionToRead( uxBrokerNumber );
+                        #endif
+                    }
+                #endif /* mqttconfigBUFFER_WAIT_MS */
+
+                #if ( mqttconfigENABLE_ZERO_COPY_RX == 1 )
+                    if( xReadPaused == pdFALSE )
+                    {
+                        /* Parse the data in place in the receive buffer of the
+                         * TCP/IP stack, or of TLS once decrypted, and then
+                         * release it. */
+                        lBytesReceived = SOCKETS_RecvZeroCopy( pxConnection->xSocket, &pucReceivedData, mqttconfigRX_BUFFER_SIZE );
+
+                        if( lBytesReceived > 0 )
+                        {
+                            ( void ) MQTT_ParseReceivedData( &( pxConnection->xMQTTContext ), pucReceivedData, ( size_t ) lBytesReceived );
+
+                            /* The socket may have been closed in one of the callbacks
+                             * invoked while parsing the data. */
+                            if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+                            {
+                                ( void ) SOCKETS_ReleaseZeroCopy( pxConnection->xSocket, ( size_t ) lBytesReceived );
+                            }
+                        }
+                    }
+                #else /* mqttconfigENABLE_ZERO_COPY_RX */
+                    if( xReadPaused == pdFALSE )
+                    {
+                        /* Read data from the socket. */
+                        lBytesReceived = SOCKETS_Recv( pxConnection->xSocket, pxConnection->pucRxBuffer, mqttconfigRX_BUFFER_SIZE, 0 );
+
+                        /* If data was read, pass it to the MQTT Core library. */
+                        if( lBytesReceived > 0 )
+                        {
+                            ( void ) MQTT_ParseReceivedData( &( pxConnection->xMQTTContext ), pxConnection->pucRxBuffer, ( size_t ) lBytesReceived );
+                        }
+                    }
+                #endif /* mqttconfigENABLE_ZERO_COPY_RX */
+
+                if( lBytesReceived > 0 )
+                {
+                    #if ( mqttconfigENABLE_STATISTICS == 1 )
+                        prvAddToStatistic( pxConnection, &( pxConnection->xStatistics.ulBytesReceived ), ( uint32_t ) lBytesReceived );
+                    #endif
+
+                    /* Some data was received on this socket and we do not
+                     * know if there is more data available. Therefore we
+                     * set xNextTimeoutTicks to zero which ensures that we
+                     * do not block on the command queue and try to read
+                     * again from this socket on the next invocation of
+                     * prvManageConnections. This way we ensure that we keep
+                     * processing commands received on the command queue
+                     * between calls to SOCKETS_Recv. As a result, a socket
+                     * receiving lots of data continuously does not starve
+                     * the command processing. */
+                    xNextTimeoutTicks = 0;
+
+                    #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+                        /* The wakeup callback is not invoked again for data that
+                         * is already buffered, for example by TLS, so keep reading
+                         * this connection until it runs dry. */
+                        if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+                        {
+                            prvMarkConnectionToRead( uxBrokerNumber );
+                        }
+                    #endif
+                }
+                else if( lBytesReceived < 0 )
+                {
+                    /* A negative return value from SOCKETS_Recv indicates error.
+                     * Since the socket is marked non-blocking, read can potentially
+                     * return SOCKETS_EWOULDBLOCK in which case we will re-try to
+                     * read on the next execution of this function. In case of any
+                     * other error, we disconnect. */
+                    if( lBytesReceived != SOCKETS_EWOULDBLOCK )
+                    {
+                        /* Disconnect from the broker. Note that the socket close
+                         * and cleanup will happen in the disconnect callback
+                         * ( prvProcessReceivedDisconnect function ) from the core
+                         * MQTT library. */
+                        ( void ) MQTT_Disconnect( &( pxConnection->xMQTTContext ) );
+                    }
+                }
+                else
+                {
+                    /* If no data was received on this socket, we continue
+                     * to call MQTT_Periodic and calculate xNextTimeoutTicks
+                     * accordingly. */
+                }
             }
-        }
 
-        /* Is the client connected? */
-        if( ( xAnyConnectedClient == pdFALSE ) && ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) )
-        {
-            xAnyConnectedClient = pdTRUE;
-        }
+            /* Is the client connected? */
+            if( ( xAnyConnectedClient == pdFALSE ) && ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) )
+            {
+                xAnyConnectedClient = pdTRUE;
+            }
 
-        /* Get the current tick count. */
-        prvMQTTGetTicks( &xTickCount );
+            /* Get the current tick count. */
+            prvMQTTGetTicks( &xTickCount );
 
-        /* Invoke MQTT_Periodic. */
-        xNextMQTTPeriodicInvokeTicks = ( TickType_t ) MQTT_Periodic( &( pxConnection->xMQTTContext ), xTickCount );
+            /* Invoke MQTT_Periodic. */
+            xNextMQTTPeriodicInvokeTicks = ( TickType_t ) MQTT_Periodic( &( pxConnection->xMQTTContext ), xTickCount );
+            xNextMQTTPeriodicInvokeTicks = mqttconfigALIGN_DEFERRABLE_DELAY( xNextMQTTPeriodicInvokeTicks );
 
-        /* Update the next timeout value. */
-        xNextTimeoutTicks = configMIN( xNextTimeoutTicks, xNextMQTTPeriodicInvokeTicks );
+            /* Update the next timeout value. */
+            xNextTimeoutTicks = configMIN( xNextTimeoutTicks, xNextMQTTPeriodicInvokeTicks );
+        }
     }
 
     /* The MQTT task must not block for more than mqttconfigMQTT_TASK_MAX_BLOCK_TICKS
-     * ticks if any client is connected. */
+     * ticks if any client is connected. When reads are event driven, that is
+     * only needed for the clients that must be polled, as the others wake the
+     * task up when they receive data. */
+    #if ( mqttconfigENABLE_EVENT_DRIVEN_RX == 1 )
+        xAnyConnectedClient = xAnyPolledClient;
+    #endif
+
     if( xAnyConnectedClient == pdTRUE )
     {
         xNextTimeoutTicks = configMIN( xNextTimeoutTicks, ( TickType_t ) mqttconfigMQTT_TASK_MAX_BLOCK_TICKS );
@@ -1371,7 +2640,7 @@ static void prvInitiateMQTTConnect( MQTTEventData_t * const pxEventData )
     BaseType_t xStatus = pdFAIL;
     MQTTNotificationData_t * pxNotificationData;
     MQTTConnectParams_t xConnectParams;
-    MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+    MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
 
     /* Store notification data. */
     pxNotificationData = prvStoreNotificationData( pxConnection, pxEventData );
@@ -1417,6 +2686,14 @@ static void prvInitiateMQTTConnect( MQTTEventData_t * const pxEventData )
             xConnectParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) );
             xConnectParams.ulTimeoutTicks = pxEventData->xTicksToWait;
 
+            #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+                xConnectParams.xCleanSession = ( ( pxEventData->u.pxConnectParams->xFlags & mqttagentPERSISTENT_SESSION ) != 0 ) ? eMQTTFalse : eMQTTTrue;
+            #endif
+
+            #if ( mqttconfigENABLE_MQTT5 == 1 )
+                xConnectParams.xProtocolVersion = ( ( pxEventData->u.pxConnectParams->xFlags & mqttagentUSE_MQTT5 ) != 0 ) ? eMQTTProtocolVersion5 : eMQTTProtocolVersion311;
+            #endif
+
             if( MQTT_Connect( &( pxConnection->xMQTTContext ), &( xConnectParams ) ) != eMQTTSuccess )
             {
                 mqttconfigDEBUG_LOG( ( "MQTT_Connect failed!\r\n" ) );
@@ -1452,7 +2729,7 @@ static void prvInitiateMQTTConnect( MQTTEventData_t * const pxEventData )
 
 static void prvInitiateMQTTDisconnect( MQTTEventData_t * const pxEventData )
 {
-    MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+    MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
 
     /* There is no need to store notification data as we will
      * not get any ACK. Try to send MQTT Disconnect message and
@@ -1476,7 +2753,7 @@ static void prvInitiateMQTTSubscribe( MQTTEventData_t * const pxEventData )
     BaseType_t xStatus = pdFAIL;
     MQTTNotificationData_t * pxNotificationData;
     MQTTSubscribeParams_t xSubscribeParams;
-    MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+    MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
 
     /* Store notification data. */
     pxNotificationData = prvStoreNotificationData( pxConnection, pxEventData );
@@ -1531,7 +2808,7 @@ static void prvInitiateMQTTUnSubscribe( MQTTEventData_t * const pxEventData )
     BaseType_t xStatus = pdFAIL;
     MQTTNotificationData_t * pxNotificationData;
     MQTTUnsubscribeParams_t xUnsubscribeParams;
-    MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+    MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
 
     /* Store notification data. */
     pxNotificationData = prvStoreNotificationData( pxConnection, pxEventData );
@@ -1581,8 +2858,7 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
 {
     BaseType_t xStatus = pdFAIL;
     MQTTNotificationData_t * pxNotificationData = NULL;
-    MQTTPublishParams_t xPublishParams;
-    MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+    MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
 
     /* No need to store  notification data in case of QoS0 because
      * there will not be any ACK. */
@@ -1597,23 +2873,10 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
      * proceed anyways. */
     if( ( pxNotificationData != NULL ) || ( pxEventData->u.pxPublishParams->xQoS == eMQTTQoS0 ) )
     {
-        /* Setup publish parameters and call the Core library publish function. */
-        xPublishParams.pucTopic = pxEventData->u.pxPublishParams->pucTopic;
-        xPublishParams.usTopicLength = pxEventData->u.pxPublishParams->usTopicLength;
-        xPublishParams.xQos = pxEventData->u.pxPublishParams->xQoS;
-        xPublishParams.pvData = pxEventData->u.pxPublishParams->pvData;
-        xPublishParams.ulDataLength = pxEventData->u.pxPublishParams->ulDataLength;
-        xPublishParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) );
-        xPublishParams.ulTimeoutTicks = pxEventData->xTicksToWait;
-
-        if( MQTT_Publish( &( pxConnection->xMQTTContext ), &( xPublishParams ) ) == eMQTTSuccess )
-        {
-            xStatus = pdPASS;
-        }
-        else
-        {
-            mqttconfigDEBUG_LOG( ( "MQTT_Publish failed!\r\n" ) );
-        }
+        xStatus = prvPublishToBroker( pxConnection,
+                                      pxEventData->u.pxPublishParams,
+                                      ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) ),
+                                      pxEventData->xTicksToWait );
     }
     else
     {
@@ -1642,11 +2905,215 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
 }
 /*-----------------------------------------------------------*/
 
+static BaseType_t prvPublishToBroker( MQTTBrokerConnection_t * const pxConnection,
+                                      const MQTTAgentPublishParams_t * const pxParams,
+                                      uint16_t usPacketIdentifier,
+                                      TickType_t xTicksToWait )
+{
+    BaseType_t xStatus = pdFAIL;
+    MQTTPublishParams_t xPublishParams;
+    MQTTReturnCode_t xReturnCode;
+
+    /* Setup publish parameters and call the Core library publish function. */
+    xPublishParams.pucTopic = pxParams->pucTopic;
+    xPublishParams.usTopicLength = pxParams->usTopicLength;
+    xPublishParams.xQos = pxParams->xQoS;
+    xPublishParams.pvData = pxParams->pvData;
+    xPublishParams.ulDataLength = pxParams->ulDataLength;
+    xPublishParams.usPacketIdentifier = usPacketIdentifier;
+    xPublishParams.ulTimeoutTicks = xTicksToWait;
+
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        /* Let the send callback add this publish to the batch. */
+        pxConnection->xBatchingPublish = pdTRUE;
+    #endif
+
+    xReturnCode = MQTT_Publish( &( pxConnection->xMQTTContext ), &( xPublishParams ) );
+
+    if( xReturnCode == eMQTTSuccess )
+    {
+        xStatus = pdPASS;
+
+        #if ( mqttconfigENABLE_STATISTICS == 1 )
+            prvAddToStatistic( pxConnection, &( pxConnection->xStatistics.ulPublishesSent ), 1 );
+
+            if( pxParams->xQoS != eMQTTQoS0 )
+            {
+                prvStartPublishTimer( pxConnection, usPacketIdentifier );
+            }
+        #endif
+    }
+    else
+    {
+        mqttconfigDEBUG_LOG( ( "MQTT_Publish failed!\r\n" ) );
+
+        #if ( mqttconfigENABLE_STATISTICS == 1 )
+            if( xReturnCode == eMQTTNoFreeBuffer )
+            {
+                prvAddToStatistic( pxConnection, &( pxConnection->xStatistics.ulNoFreeBuffer ), 1 );
+            }
+        #endif
+    }
+
+    #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+        pxConnection->xBatchingPublish = pdFALSE;
+    #endif
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+
+    static void prvInitiateMQTTAsyncPublish( MQTTEventData_t * const pxEventData )
+    {
+        MQTTBrokerConnection_t * pxConnection = mqttCONNECTION( pxEventData->uxBrokerNumber );
+        MQTTAsyncPublish_t * pxAsyncPublish = pxEventData->u.pxAsyncPublish;
+
+        if( prvPublishToBroker( pxConnection,
+                                &( pxAsyncPublish->xParams ),
+                                pxAsyncPublish->usPacketIdentifier,
+                                pxEventData->xTicksToWait ) == pdFAIL )
+        {
+            prvCompleteAsyncPublish( pxConnection, pxAsyncPublish, eMQTTAgentFailure );
+        }
+        else if( pxAsyncPublish->xParams.xQoS == eMQTTQoS0 )
+        {
+            /* No PUBACK is expected in case of QoS0. */
+            prvCompleteAsyncPublish( pxConnection, pxAsyncPublish, eMQTTAgentSuccess );
+        }
+        else
+        {
+            pxAsyncPublish->xInFlight = pdTRUE;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvCompleteAsyncPublish( MQTTBrokerConnection_t * const pxConnection,
+                                         MQTTAsyncPublish_t * const pxAsyncPublish,
+                                         MQTTAgentReturnCode_t xReturnCode )
+    {
+        pxAsyncPublish->pxCallback( pxAsyncPublish->pvCallbackContext, xReturnCode );
+
+        /* Free the entry only after the callback, so that the next publish
+         * does not overwrite it while it is still being read. */
+        pxAsyncPublish->xInFlight = pdFALSE;
+        taskENTER_CRITICAL();
+        {
+            pxAsyncPublish->xInUse = pdFALSE;
+        }
+        taskEXIT_CRITICAL();
+
+        ( void ) xSemaphoreGive( pxConnection->xAsyncPublishWindow );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvCompleteAsyncPublishInFlight( MQTTBrokerConnection_t * const pxConnection,
+                                                 uint16_t usPacketIdentifier,
+                                                 MQTTAgentReturnCode_t xReturnCode )
+    {
+        UBaseType_t x;
+
+        for( x = 0; x < ( UBaseType_t ) mqttconfigASYNC_PUBLISH_WINDOW; x++ )
+        {
+            if( ( pxConnection->xAsyncPublishes[ x ].xInFlight == pdTRUE ) &&
+                ( pxConnection->xAsyncPublishes[ x ].usPacketIdentifier == usPacketIdentifier ) )
+            {
+                prvCompleteAsyncPublish( pxConnection, &( pxConnection->xAsyncPublishes[ x ] ), xReturnCode );
+                break;
+            }
+        }
+    }
+
+#endif /* mqttconfigASYNC_PUBLISH_WINDOW */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_STATISTICS == 1 )
+
+    static void prvAddToStatistic( MQTTBrokerConnection_t * const pxConnection,
+                                   volatile uint32_t * const pulCounter,
+                                   uint32_t ulValue )
+    {
+        /* The sequence number is odd while the update is in progress, so
+         * that MQTT_AGENT_GetStatistics() can tell if its copy overlapped it. */
+        pxConnection->ulStatisticsSequence++;
+        *pulCounter += ulValue;
+        pxConnection->ulStatisticsSequence++;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvRecordLatency( MQTTBrokerConnection_t * const pxConnection,
+                                  volatile MQTTAgentLatencyHistogram_t * const pxHistogram,
+                                  TickType_t xTicks )
+    {
+        TickType_t xRemainingTicks = xTicks;
+        UBaseType_t uxBucket;
+
+        /* The bucket is the number of significant bits in the latency. */
+        for( uxBucket = 0; ( xRemainingTicks != ( TickType_t ) 0 ) && ( uxBucket < ( UBaseType_t ) ( mqttagentLATENCY_BUCKETS - 1 ) ); uxBucket++ )
+        {
+            xRemainingTicks >>= 1;
+        }
+
+        pxConnection->ulStatisticsSequence++;
+        pxHistogram->ulBuckets[ uxBucket ]++;
+
+        if( xTicks > pxHistogram->xMaxTicks )
+        {
+            pxHistogram->xMaxTicks = xTicks;
+        }
+
+        pxConnection->ulStatisticsSequence++;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvStartPublishTimer( MQTTBrokerConnection_t * const pxConnection,
+                                      uint16_t usPacketIdentifier )
+    {
+        UBaseType_t x;
+
+        for( x = 0; x < ( UBaseType_t ) mqttconfigSTATISTICS_TIMED_PUBLISHES; x++ )
+        {
+            if( pxConnection->usTimedPublishes[ x ] == ( uint16_t ) 0 )
+            {
+                pxConnection->usTimedPublishes[ x ] = usPacketIdentifier;
+                pxConnection->xTimedPublishSentTicks[ x ] = xTaskGetTickCount();
+                break;
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvStopPublishTimer( MQTTBrokerConnection_t * const pxConnection,
+                                     uint16_t usPacketIdentifier,
+                                     BaseType_t xAcknowledged )
+    {
+        UBaseType_t x;
+
+        for( x = 0; x < ( UBaseType_t ) mqttconfigSTATISTICS_TIMED_PUBLISHES; x++ )
+        {
+            if( ( pxConnection->usTimedPublishes[ x ] != ( uint16_t ) 0 ) &&
+                ( ( usPacketIdentifier == ( uint16_t ) 0 ) || ( pxConnection->usTimedPublishes[ x ] == usPacketIdentifier ) ) )
+            {
+                if( xAcknowledged == pdTRUE )
+                {
+                    prvRecordLatency( pxConnection, &( pxConnection->xStatistics.xPublishToAck ), xTaskGetTickCount() - pxConnection->xTimedPublishSentTicks[ x ] );
+                }
+
+                pxConnection->usTimedPublishes[ x ] = 0;
+            }
+        }
+    }
+
+#endif /* mqttconfigENABLE_STATISTICS */
+/*-----------------------------------------------------------*/
+
 static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEventData )
 {
     BaseType_t xReturn;
     MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
     uint32_t ulReceivedMessageIdentifier;
+    QueueHandle_t xCommandQueue = xCommandQueues[ mqttTASK_FOR_BROKER( pxEventData->uxBrokerNumber ) ];
 
     /* Should not try to send commands until after the MQTT task has been
      * initialized, in which case the command queue will have been created. */
@@ -1655,28 +3122,15 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
     /* Setup notification data. */
     pxEventData->xNotificationData.xTaskToNotify = xTaskGetCurrentTaskHandle();
 
-    /* Commands must not be sent from the MQTT task itself (which could be
-     * the case if a command is sent from a callback function).  Otherwise
-     * there is the possibility that the task could end up waiting for itself
-     * resulting in deadlock. */
-    if( pxEventData->xNotificationData.xTaskToNotify != xMQTTTaskHandle )
+    /* Commands must not be sent from an MQTT task (which could be the case
+     * if a command is sent from a callback function).  Otherwise there is the
+     * possibility that the task could end up waiting for itself, or two MQTT
+     * tasks for each other, resulting in deadlock. */
+    if( prvIsMQTTTask( pxEventData->xNotificationData.xTaskToNotify ) == pdFALSE )
     {
-        taskENTER_CRITICAL();
-        {
-            /* The message identifier is used to know which message is being
-             * acknowledged.  A critical region is used as a single message identifier
-             * variable is used by all connections. The identifier uses the top 16-bits
-             * of the 32-bit word, leaving the lowest 16-bits free for use by the MQTT
-             * task to return a status code. */
-            pxEventData->xNotificationData.ulMessageIdentifier = ulQueueMessageIdentifier;
-            ulQueueMessageIdentifier += mqttMESSAGE_IDENTIFIER_MIN;
-
-            if( ulQueueMessageIdentifier >= mqttMESSAGE_IDENTIFIER_MAX )
-            {
-                ulQueueMessageIdentifier = mqttMESSAGE_IDENTIFIER_MIN;
-            }
-        }
-        taskEXIT_CRITICAL();
+        /* The message identifier is used to know which message is being
+         * acknowledged. */
+        pxEventData->xNotificationData.ulMessageIdentifier = prvGetMessageIdentifier();
 
         /* Record the time at which this event is created. */
         vTaskSetTimeOutState( &( pxEventData->xEventCreationTimestamp ) );
@@ -1684,7 +3138,7 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
         /* The calling task is going to wait for a notification, so clear the
          * notifications state first.  This is probably not necessary as the task will
          * wait for a particular notification value, but is for maximum robustness. */
-        ( void ) xTaskNotifyStateClear( NULL );
+        ( void ) xTaskNotifyStateClearIndexed( NULL, mqttconfigNOTIFICATION_INDEX );
 
         /* The MQTT protocol is running in a separate task, to which commands
          * are sent on a queue, and a signal is sent back using a task
@@ -1707,7 +3161,7 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
                  * block here forever and rely on the notification from the MQTT task
                  * to unblock us. Return value is ignored because in case of portMAX_DELAY
                  * the function will return only when a notification is received. */
-                ( void ) xTaskNotifyWait( 0UL, 0UL, &ulReceivedMessageIdentifier, portMAX_DELAY );
+                ( void ) xTaskNotifyWaitIndexed( mqttconfigNOTIFICATION_INDEX, 0UL, 0UL, &ulReceivedMessageIdentifier, portMAX_DELAY );
 
                 if( pxEventData->xNotificationData.ulMessageIdentifier == ( ulReceivedMessageIdentifier & mqttMESSAGE_IDENTIFIER_MASK ) )
                 {
@@ -1759,16 +3213,69 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
 }
 /*-----------------------------------------------------------*/
 
+static uint32_t prvGetMessageIdentifier( void )
+{
+    uint32_t ulMessageIdentifier;
+
+    taskENTER_CRITICAL();
+    {
+        /* A critical region is used as a single message identifier variable is
+         * used by all connections. The identifier uses the top 16-bits of the
+         * 32-bit word, leaving the lowest 16-bits free for use by the MQTT task
+         * to return a status code. */
+        ulMessageIdentifier = ulQueueMessageIdentifier;
+        ulQueueMessageIdentifier += mqttMESSAGE_IDENTIFIER_MIN;
+
+        if( ulQueueMessageIdentifier >= mqttMESSAGE_IDENTIFIER_MAX )
+        {
+            ulQueueMessageIdentifier = mqttMESSAGE_IDENTIFIER_MIN;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return ulMessageIdentifier;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsMQTTTask( TaskHandle_t xTask )
+{
+    BaseType_t xReturn = pdFALSE;
+    UBaseType_t uxTaskNumber;
+
+    for( uxTaskNumber = 0; uxTaskNumber < ( UBaseType_t ) mqttconfigMQTT_TASKS; uxTaskNumber++ )
+    {
+        if( xMQTTTaskHandles[ uxTaskNumber ] == xTask )
+        {
+            xReturn = pdTRUE;
+            break;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 static void prvMQTTTask( void * pvParameters )
 {
     MQTTEventData_t xMQTTCommand;
     TickType_t xNextTimeoutTicks = 0;
+    UBaseType_t uxTaskNumber = ( UBaseType_t ) pvParameters; /*lint !e923 The cast is ok as we passed the index of the task. */
+    QueueHandle_t xCommandQueue = xCommandQueues[ uxTaskNumber ];
 
-    /* Remove compiler warnings about unused parameters. */
-    ( void ) pvParameters;
+    #if ( bufferpoolconfigTASK_CACHE_DEPTH > 0 )
+        static BufferPoolTaskCache_t xBufferCaches[ mqttconfigMQTT_TASKS ];
+
+        /* Most buffers are taken and returned by the MQTT tasks, so let each
+         * of them keep a few without going through the shared pool. */
+        BUFFERPOOL_TaskCacheRegister( &( xBufferCaches[ uxTaskNumber ] ) );
+    #endif
 
     for( ; ; )
     {
+        /* No floating point value is live here, so drop the FPU context that
+         * logging a float would otherwise leave the task with. */
+        portTASK_USES_NO_FPU();
+
         if( xQueueReceive( xCommandQueue, &xMQTTCommand, xNextTimeoutTicks ) != pdFALSE )
         {
             mqttconfigDEBUG_LOG( ( "Received message %x from queue.\r\n", xMQTTCommand.xNotificationData.ulMessageIdentifier ) );
@@ -1778,6 +3285,16 @@ static void prvMQTTTask( void * pvParameters )
              * functions further down the call tree don't have to.  A check is
              * performed before messages are sent to the command queue anyway. */
             configASSERT( xMQTTCommand.uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+            configASSERT( mqttTASK_FOR_BROKER( xMQTTCommand.uxBrokerNumber ) == uxTaskNumber );
+
+            mqttconfigTRACE_COMMAND_RECEIVED( xMQTTCommand.xEventType, xMQTTCommand.uxBrokerNumber );
+
+            #if ( mqttconfigENABLE_STATISTICS == 1 )
+                /* The timeout check below moves the creation timestamp. */
+                prvRecordLatency( mqttCONNECTION( xMQTTCommand.uxBrokerNumber ),
+                                  &( mqttCONNECTION( xMQTTCommand.uxBrokerNumber )->xStatistics.xCommandQueueWait ),
+                                  xTaskGetTickCount() - xMQTTCommand.xEventCreationTimestamp.xTimeOnEntering );
+            #endif
 
             /* Check if the timeout for the event has been reached.
              * It means that the MQTT task picked up this command for
@@ -1791,6 +3308,14 @@ static void prvMQTTTask( void * pvParameters )
                  * be NULL and therefore prvNotifyRequestingTask returns
                  * without doing anything. */
                 prvNotifyRequestingTask( &( xMQTTCommand.xNotificationData ), eMQTTOperationTimedOut, pdFAIL );
+
+                #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+                    /* Asynchronous publishes report the timeout through their callback. */
+                    if( xMQTTCommand.xEventType == eMQTTAsyncPublishRequest )
+                    {
+                        prvCompleteAsyncPublish( mqttCONNECTION( xMQTTCommand.uxBrokerNumber ), xMQTTCommand.u.pxAsyncPublish, eMQTTAgentTimeout );
+                    }
+                #endif
             }
             else
             {
@@ -1817,20 +3342,43 @@ static void prvMQTTTask( void * pvParameters )
                         break;
 
                     case eMQTTPublishRequest:
-                        prvInitiateMQTTPublish( &( xMQTTCommand ) );
+                        #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+                            if( prvStoreOfflinePublish( &( xMQTTCommand ) ) == pdFALSE )
+                        #endif
+                        {
+                            prvInitiateMQTTPublish( &( xMQTTCommand ) );
+                        }
                         break;
 
+                    #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+                        case eMQTTAsyncPublishRequest:
+                            prvInitiateMQTTAsyncPublish( &( xMQTTCommand ) );
+                            break;
+                    #endif
+
                     default:
                         /* Anything else is illegal. */
                         mqttconfigDEBUG_LOG( ( "Unknown request received on command queue.\r\n" ) );
                         break;
                 }
             }
+
+            mqttconfigTRACE_COMMAND_PROCESSED( xMQTTCommand.xEventType, xMQTTCommand.uxBrokerNumber );
         }
 
         /* Process active connections each time the queue unblocks.  It might
          * be that the queue read timed out because a connection needs service. */
-        xNextTimeoutTicks = prvManageConnections();
+        xNextTimeoutTicks = prvManageConnections( uxTaskNumber );
+
+        #if ( mqttconfigPUBLISH_BATCH_MAX_DELAY_MS > 0 )
+            /* Send the publish batches whose window has elapsed. */
+            xNextTimeoutTicks = prvManagePublishBatches( uxTaskNumber, xNextTimeoutTicks );
+        #endif
+
+        #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+            /* Send the next publish stored while the connection was down. */
+            xNextTimeoutTicks = prvManageOfflinePublishes( uxTaskNumber, xNextTimeoutTicks );
+        #endif
     }
 }
 /*-----------------------------------------------------------*/
@@ -1840,75 +3388,61 @@ BaseType_t MQTT_AGENT_Init( void )
     /* The following variables must be static as they hold data that is used as
      * long as the MQTT application is running. */
 
-    /* The variable used to hold the queue's data structure. */
-    static StaticQueue_t xStaticQueue;
+    /* The variables used to hold the queues' data structures. */
+    static StaticQueue_t xStaticQueues[ mqttconfigMQTT_TASKS ];
 
-    /* The array to use as the queue's storage area.  This must be at least
+    /* The arrays to use as the queues' storage areas.  These must be at least
      * uxQueueLength * uxItemSize bytes.  Again, must be static. */
-    static uint8_t ucQueueStorageArea[ mqttCOMMAND_QUEUE_LENGTH * sizeof( MQTTEventData_t ) ];
+    static uint8_t ucQueueStorageAreas[ mqttconfigMQTT_TASKS ][ mqttCOMMAND_QUEUE_LENGTH * sizeof( MQTTEventData_t ) ];
 
-    /* The stack used by the MQTT task. */
-    static StackType_t xStack[ mqttconfigMQTT_TASK_STACK_DEPTH ];
+    /* The stacks used by the MQTT tasks. */
+    static StackType_t xStacks[ mqttconfigMQTT_TASKS ][ mqttconfigMQTT_TASK_STACK_DEPTH ];
 
-    /* The variable used to hold the MQTT task's data structures. */
-    static StaticTask_t xStaticTask;
+    /* The variables used to hold the MQTT tasks' data structures. */
+    static StaticTask_t xStaticTasks[ mqttconfigMQTT_TASKS ];
 
     BaseType_t xReturnCode = pdPASS;
-    UBaseType_t x, y;
+    UBaseType_t x;
 
-    /* If the command queue is not NULL then the queue and task have already
+    /* If the command queue is not NULL then the queues and tasks have already
      * been created. */
-    if( xCommandQueue == NULL )
+    if( xCommandQueues[ 0 ] == NULL )
     {
-        /* Ensure the connection structures start in a consistent state. */
-        memset( xMQTTConnections, 0x00, sizeof( xMQTTConnections ) );
-
         for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_BROKERS; x++ )
         {
-            xMQTTConnections[ x ].xSocket = SOCKETS_INVALID_SOCKET;
-
-            /* Initialize user callback and data. These are provided during connect. */
-            xMQTTConnections[ x ].pvUserData = NULL;
-            xMQTTConnections[ x ].pxCallback = NULL;
-
             /* Mark the connection "not in use". */
-            xMQTTConnections[ x ].xConnectionInUse = pdFALSE;
-
-            /* Initialize the MQTT Core Library context. */
-            MQTTInitParams_t xInitParams;
-            xInitParams.pvCallbackContext = ( void * ) x; /*lint !e923 The cast is ok as we are passing the index of the client. */
-            xInitParams.pxCallback = prvMQTTEventCallback;
-            xInitParams.pvSendContext = ( void * ) x;     /*lint !e923 The cast is ok as we are passing the index of the client. */
-            xInitParams.pxMQTTSendFxn = prvMQTTSendCallback;
-            xInitParams.pxGetTicksFxn = prvMQTTGetTicks;
-            xInitParams.xBufferPoolInterface.pxGetBufferFxn = mqttconfigGET_FREE_BUFFER_FXN;
-            xInitParams.xBufferPoolInterface.pxReturnBufferFxn = mqttconfigRETURN_BUFFER_FXN;
-
-            if( MQTT_Init( &xMQTTConnections[ x ].xMQTTContext, &xInitParams ) != eMQTTSuccess )
-            {
-                xReturnCode = pdFAIL;
-                break;
-            }
+            xConnectionInUse[ x ] = pdFALSE;
 
-            /* Initialize waiting tasks list. */
-            for( y = 0; y < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; y++ )
-            {
-                xMQTTConnections[ x ].xWaitingTasks[ y ].xTaskToNotify = NULL;
-                xMQTTConnections[ x ].xWaitingTasks[ y ].ulMessageIdentifier = 0;
-            }
+            #if ( mqttconfigALLOCATE_CONNECTIONS == 0 )
+                if( prvInitConnection( mqttCONNECTION( x ), x ) != pdPASS )
+                {
+                    xReturnCode = pdFAIL;
+                    break;
+                }
+            #endif
         }
 
         /* ulQueueMessageIdentifier uses the top 16-bits of a 32-bit value, so
          * initialize it to its start value. */
         ulQueueMessageIdentifier = mqttMESSAGE_IDENTIFIER_MIN;
 
-        /* Don't create the MQTT task until the command queue has been created,
-         * as the task itself assumes the queue is valid. */
-        xCommandQueue = xQueueCreateStatic( mqttCOMMAND_QUEUE_LENGTH, sizeof( MQTTEventData_t ), ucQueueStorageArea, &xStaticQueue );
-        configASSERT( xCommandQueue );
+        /* Don't create the MQTT tasks until all the command queues have been
+         * created, as the tasks themselves assume the queues are valid. */
+        for( x = 0; x < ( UBaseType_t ) mqttconfigMQTT_TASKS; x++ )
+        {
+            xCommandQueues[ x ] = xQueueCreateStatic( mqttCOMMAND_QUEUE_LENGTH, sizeof( MQTTEventData_t ), ucQueueStorageAreas[ x ], &( xStaticQueues[ x ] ) );
+            configASSERT( xCommandQueues[ x ] );
+
+            /* Makes the queue visible to kernel aware debuggers, and to
+             * xQueueGetHandleFromName(). */
+            vQueueAddToRegistry( xCommandQueues[ x ], "MQTTCmd" );
+        }
 
-        xMQTTTaskHandle = xTaskCreateStatic( prvMQTTTask, "MQTT", mqttconfigMQTT_TASK_STACK_DEPTH, NULL, mqttconfigMQTT_TASK_PRIORITY, xStack, &xStaticTask );
-        configASSERT( xMQTTTaskHandle );
+        for( x = 0; x < ( UBaseType_t ) mqttconfigMQTT_TASKS; x++ )
+        {
+            xMQTTTaskHandles[ x ] = xTaskCreateStatic( prvMQTTTask, "MQTT", mqttconfigMQTT_TASK_STACK_DEPTH, ( void * ) x, mqttconfigMQTT_TASK_PRIORITY, xStacks[ x ], &( xStaticTasks[ x ] ) ); /*lint !e923 The cast is ok as we are passing the index of the task. */
+            configASSERT( xMQTTTaskHandles[ x ] );
+        }
     }
 
     return xReturnCode;
@@ -1924,9 +3458,28 @@ MQTTAgentReturnCode_t MQTT_AGENT_Create( MQTTAgentHandle_t * const pxMQTTHandle
     /* Try to get a free MQTTBrokerConnection_t. */
     xBrokerNumber = prvGetFreeConnection();
 
+    #if ( mqttconfigALLOCATE_CONNECTIONS == 1 )
+        if( ( xBrokerNumber >= 0 ) && ( prvAllocateConnection( ( UBaseType_t ) xBrokerNumber ) != pdPASS ) )
+        {
+            prvReturnConnection( ( UBaseType_t ) xBrokerNumber );
+            xBrokerNumber = -1;
+        }
+    #endif
+
     /* If we cannot get a free connection, fail immediately. */
     if( xBrokerNumber >= 0 )
     {
+        #if ( mqttconfigOFFLINE_PUBLISH_QUEUE_LENGTH > 0 )
+            /* Restore the publishes stored before a reset, if any. */
+            prvLoadOfflinePublishes( ( UBaseType_t ) xBrokerNumber );
+        #endif
+
+        #if ( mqttconfigENABLE_STATISTICS == 1 )
+            /* The connection is not in use by the MQTT task yet. */
+            memset( ( void * ) &( mqttCONNECTION( xBrokerNumber )->xStatistics ), 0x00, sizeof( MQTTAgentStatistics_t ) );
+            memset( mqttCONNECTION( xBrokerNumber )->usTimedPublishes, 0x00, sizeof( mqttCONNECTION( xBrokerNumber )->usTimedPublishes ) );
+        #endif
+
         /* Encode the broker number. */
         xEncodedBrokerNumber = mqttENCODE_BROKER_NUMBER( xBrokerNumber );
 
@@ -2066,6 +3619,106 @@ MQTTAgentReturnCode_t MQTT_AGENT_Publish( MQTTAgentHandle_t xMQTTHandle,
 }
 /*-----------------------------------------------------------*/
 
+MQTTAgentReturnCode_t MQTT_AGENT_PublishAsync( MQTTAgentHandle_t xMQTTHandle,
+                                               const MQTTAgentPublishParams_t * const pxPublishParams,
+                                               MQTTAgentPublishCallback_t pxCallback,
+                                               void * pvCallbackContext,
+                                               TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+
+    #if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 )
+        MQTTEventData_t xEventData;
+        MQTTBrokerConnection_t * pxConnection;
+        MQTTAsyncPublish_t * pxAsyncPublish = NULL;
+        UBaseType_t x;
+
+        configASSERT( pxCallback != NULL );
+
+        xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
+        pxConnection = mqttCONNECTION( xEventData.uxBrokerNumber );
+
+        /* An MQTT task waiting for space in the window would wait for itself. */
+        if( prvIsMQTTTask( xTaskGetCurrentTaskHandle() ) == pdTRUE )
+        {
+            xReturnCode = eMQTTAgentAPICalledFromCallback;
+        }
+        else
+        {
+            vTaskSetTimeOutState( &( xEventData.xEventCreationTimestamp ) );
+            xEventData.xTicksToWait = xTimeoutTicks;
+
+            /* Wait for a free entry in the window. */
+            if( xSemaphoreTake( pxConnection->xAsyncPublishWindow, xEventData.xTicksToWait ) == pdTRUE )
+            {
+                /* Taking the semaphore guarantees that an entry is free. */
+                taskENTER_CRITICAL();
+                {
+                    for( x = 0; x < ( UBaseType_t ) mqttconfigASYNC_PUBLISH_WINDOW; x++ )
+                    {
+                        if( pxConnection->xAsyncPublishes[ x ].xInUse == pdFALSE )
+                        {
+                            pxAsyncPublish = &( pxConnection->xAsyncPublishes[ x ] );
+                            pxAsyncPublish->xInUse = pdTRUE;
+                            break;
+                        }
+                    }
+                }
+                taskEXIT_CRITICAL();
+
+                configASSERT( pxAsyncPublish != NULL );
+
+                pxAsyncPublish->xParams = *pxPublishParams;
+                pxAsyncPublish->pxCallback = pxCallback;
+                pxAsyncPublish->pvCallbackContext = pvCallbackContext;
+                pxAsyncPublish->usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( prvGetMessageIdentifier() ) );
+                pxAsyncPublish->xInFlight = pdFALSE;
+
+                /* No task waits for the result. */
+                xEventData.xEventType = eMQTTAsyncPublishRequest;
+                xEventData.xNotificationData.xTaskToNotify = NULL;
+                xEventData.xNotificationData.ulMessageIdentifier = 0;
+                xEventData.u.pxAsyncPublish = pxAsyncPublish;
+
+                /* The time spent waiting for the window counts towards the
+                 * timeout. */
+                ( void ) xTaskCheckForTimeOut( &( xEventData.xEventCreationTimestamp ), &( xEventData.xTicksToWait ) );
+
+                if( xQueueSendToBack( xCommandQueues[ mqttTASK_FOR_BROKER( xEventData.uxBrokerNumber ) ], &xEventData, xEventData.xTicksToWait ) != pdFALSE )
+                {
+                    xReturnCode = eMQTTAgentSuccess;
+                }
+                else
+                {
+                    /* The callback will not be invoked, return the entry. */
+                    taskENTER_CRITICAL();
+                    {
+                        pxAsyncPublish->xInUse = pdFALSE;
+                    }
+                    taskEXIT_CRITICAL();
+
+                    ( void ) xSemaphoreGive( pxConnection->xAsyncPublishWindow );
+                    xReturnCode = eMQTTAgentTimeout;
+                }
+            }
+            else
+            {
+                xReturnCode = eMQTTAgentTimeout;
+            }
+        }
+    #else /* if ( mqttconfigASYNC_PUBLISH_WINDOW > 0 ) */
+        /* Remove compiler warnings about unused parameters. */
+        ( void ) xMQTTHandle;
+        ( void ) pxPublishParams;
+        ( void ) pxCallback;
+        ( void ) pvCallbackContext;
+        ( void ) xTimeoutTicks;
+    #endif /* mqttconfigASYNC_PUBLISH_WINDOW */
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
 MQTTAgentReturnCode_t MQTT_AGENT_ReturnBuffer( MQTTAgentHandle_t xMQTTHandle,
                                                MQTTBufferHandle_t xBufferHandle )
 {
@@ -2081,3 +3734,50 @@ MQTTAgentReturnCode_t MQTT_AGENT_ReturnBuffer( MQTTAgentHandle_t xMQTTHandle,
     return eMQTTAgentSuccess;
 }
 /*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_AGENT_GetStatistics( MQTTAgentHandle_t xMQTTHandle,
+                                                MQTTAgentStatistics_t * const pxStatistics )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+
+    #if ( mqttconfigENABLE_STATISTICS == 1 )
+        const UBaseType_t uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
+        MQTTBrokerConnection_t * const pxConnection = mqttCONNECTION( uxBrokerNumber );
+        uint32_t ulSequence;
+
+        configASSERT( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+        configASSERT( pxStatistics != NULL );
+
+        /* The MQTT task does not lock the statistics. The copy is only
+         * consistent if no update started or ended while it was made. */
+        for( ; ; )
+        {
+            ulSequence = pxConnection->ulStatisticsSequence;
+            memcpy( pxStatistics, ( const void * ) &( pxConnection->xStatistics ), sizeof( MQTTAgentStatistics_t ) );
+
+            if( ( ulSequence & ( uint32_t ) 1 ) != ( uint32_t ) 0 )
+            {
+                /* The MQTT task was preempted part way through an update, let
+                 * it finish. */
+                vTaskDelay( 1 );
+            }
+            else if( ulSequence == pxConnection->ulStatisticsSequence )
+            {
+                break;
+            }
+            else
+            {
+                /* An update was made during the copy, try again. */
+            }
+        }
+
+        xReturnCode = eMQTTAgentSuccess;
+    #else /* if ( mqttconfigENABLE_STATISTICS == 1 ) */
+        /* Remove compiler warnings about unused parameters. */
+        ( void ) xMQTTHandle;
+        ( void ) pxStatistics;
+    #endif /* mqttconfigENABLE_STATISTICS */
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
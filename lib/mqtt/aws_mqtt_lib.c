@@ -195,6 +195,7 @@
  * variable header.
  */
 /** @{ */
+#define mqttCONNECT_PROTOCOL_LEVEL_OFFSET   8
 #define mqttCONNECT_FLAGS_OFFSET            9
 #define mqttCONNECT_KEEPALIVE_MSB_OFFSET    10
 #define mqttCONNECT_KEEPALIVE_LSB_OFFSET    11
@@ -263,6 +264,7 @@
 /** @{ */
 #define mqttPUBACK_PACKET_ID_MSB_OFFSET    2
 #define mqttPUBACK_PACKET_ID_LSB_OFFSET    3
+#define mqttPUBACK_REASON_CODE_OFFSET      4 /* MQTT 5.0 only, when "Remaining Length" is more than 2. */
 /** @} */
 
 /**
@@ -298,6 +300,54 @@
 #define mqttLOWER_NIBBLE_MASK    ( ( uint8_t ) 0x0F )
 /** @} */
 
+/**
+ * @brief The highest QoS of the publishes accepted from the broker.
+ */
+#if ( mqttconfigENABLE_QOS2 == 1 )
+    #define mqttMAX_RECEIVED_QOS    ( ( uint8_t ) 2 )
+#else
+    #define mqttMAX_RECEIVED_QOS    ( ( uint8_t ) 1 )
+#endif
+
+/**
+ * @brief The length of the property list in the packets sent on a context.
+ *
+ * MQTT 5.0 packets are sent with an empty property list, which takes one
+ * byte. MQTT 3.1.1 packets have no property list.
+ */
+#if ( mqttconfigENABLE_MQTT5 == 1 )
+    #define mqttPROPERTIES_LENGTH( pxMQTTContext )    ( ( ( pxMQTTContext )->xProtocolVersion == eMQTTProtocolVersion5 ) ? ( uint32_t ) 1 : ( uint32_t ) 0 )
+#else
+    #define mqttPROPERTIES_LENGTH( pxMQTTContext )    ( ( uint32_t ) 0 )
+#endif
+
+/**
+ * @brief Whether the Rx buffer holds an MQTT 5.0 acknowledgement of the given type.
+ *
+ * MQTT 5.0 acknowledgements may carry a reason code and properties after the
+ * packet identifier, so only the control byte of their fixed header is known.
+ */
+#if ( mqttconfigENABLE_MQTT5 == 1 )
+    #define mqttIS_MQTT5_ACK( pxMQTTContext, ucControlByte )                \
+    ( ( ( pxMQTTContext )->xProtocolVersion == eMQTTProtocolVersion5 ) && \
+      ( mqttbufferGET_DATA( ( pxMQTTContext )->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( ucControlByte ) ) )
+#else
+    #define mqttIS_MQTT5_ACK( pxMQTTContext, ucControlByte )    ( 0 )
+#endif
+
+#if ( mqttconfigENABLE_MQTT5 == 1 )
+
+/**
+ * @defgroup MQTT5 Values from the MQTT 5.0 specification.
+ */
+/** @{ */
+    #define mqttPROPERTY_RECEIVE_MAXIMUM     ( ( uint8_t ) 0x21 )
+    #define mqttPROPERTY_USER_PROPERTY       ( ( uint8_t ) 0x26 )
+    #define mqttRECEIVE_MAXIMUM_DEFAULT      ( ( uint16_t ) 65535 )
+    #define mqttREASON_CODE_FAILURE          ( ( uint8_t ) 0x80 ) /* Reason codes from this value on report a failure. */
+/** @} */
+#endif /* mqttconfigENABLE_MQTT5 */
+
 /**
  * @brief Returns minimum of the two given values.
  *
@@ -306,6 +356,14 @@
  */
 #define mqttMIN( A, B )    ( ( A ) < ( B ) ? ( A ) : ( B ) )
 
+/**
+ * @defgroup Topic filter trie node indexes.
+ */
+/** @{ */
+#define mqttTOPIC_TRIE_ROOT    ( ( uint16_t ) 0 )      /**< The root node, representing the empty prefix. */
+#define mqttTOPIC_TRIE_NONE    ( ( uint16_t ) 0xFFFF ) /**< No node or no subscription. */
+/** @} */
+
 /**
  * @brief Copies the given number of bytes from the source buffer to the
  * destination buffer.
@@ -425,6 +483,79 @@ static MQTTBufferHandle_t prvPacketTypeIdentifierGetTxBuffer( MQTTContext_t * px
  */
 static void prvResetRxMessageState( MQTTContext_t * pxMQTTContext );
 
+#if ( mqttconfigENABLE_MQTT5 == 1 )
+
+/**
+ * @brief Checks and skips the properties of the MQTT 5.0 packet in the Rx buffer.
+ *
+ * @param[in] pxMQTTContext The MQTT context whose Rx buffer holds the packet.
+ * @param[in, out] pulOffset The offset of the property length. Set to the
+ * offset of the byte following the properties on success.
+ * @param[out] pusReceiveMaximum Set to the value of the Receive Maximum
+ * property, if present. May be NULL if not needed.
+ *
+ * @return eMQTTTrue if the properties are well formed and within the packet,
+ * eMQTTFalse otherwise.
+ */
+    static MQTTBool_t prvDecodeProperties( MQTTContext_t * pxMQTTContext,
+                                           uint32_t * const pulOffset,
+                                           uint16_t * const pusReceiveMaximum );
+
+/**
+ * @brief Checks the MQTT 5.0 CONNACK in the Rx buffer and converts its
+ * reason code to the matching MQTT 3.1.1 return code.
+ *
+ * The Receive Maximum of the broker is stored in the context.
+ *
+ * @param[in] pxMQTTContext The MQTT context whose Rx buffer holds the CONNACK.
+ * @param[out] pucReturnCode The MQTT 3.1.1 return code, or a reserved value
+ * if the reason code is not valid in a CONNACK.
+ *
+ * @return eMQTTTrue if the CONNACK is well formed, eMQTTFalse otherwise.
+ */
+    static MQTTBool_t prvDecodeConnACKReasonCode( MQTTContext_t * pxMQTTContext,
+                                                  uint8_t * const pucReturnCode );
+
+/**
+ * @brief Processes a DISCONNECT received from an MQTT 5.0 broker.
+ *
+ * @param[in] pxMQTTContext The MQTT context for which the DISCONNECT was received.
+ * @param[in] ucReasonCode The reason code of the DISCONNECT.
+ */
+    static void prvProcessReceivedDISCONNECT( MQTTContext_t * pxMQTTContext,
+                                              uint8_t ucReasonCode );
+
+/**
+ * @brief Counts the QoS1 and QoS2 publishes waiting for their acknowledgment.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ *
+ * @return The number of PUBLISH and PUBREL messages in the Tx buffer list.
+ */
+    static uint32_t prvCountPublishesInFlight( MQTTContext_t * pxMQTTContext );
+#endif /* mqttconfigENABLE_MQTT5 */
+
+#if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+
+/**
+ * @brief Processes the bytes of a publish which is passed to the user in chunks.
+ *
+ * The fixed header, topic and packet identifier are kept in the context. The
+ * payload is passed to the user directly from the received data, without
+ * being copied. A PUBACK is sent once the last byte of a QoS1 publish has
+ * been received.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] pucReceivedData The received data.
+ * @param[in] ulReceivedDataLength The length of the received data.
+ *
+ * @return The number of bytes of the received data which were consumed.
+ */
+    static uint32_t prvProcessStreamedPublishBytes( MQTTContext_t * pxMQTTContext,
+                                                    const uint8_t * pucReceivedData,
+                                                    uint32_t ulReceivedDataLength );
+#endif /* mqttconfigENABLE_STREAMING_PUBLISH */
+
 /**
  * @brief Resets the MQTT contexts and puts in "not connected" state.
  *
@@ -437,6 +568,21 @@ static void prvResetRxMessageState( MQTTContext_t * pxMQTTContext );
  */
 static void prvResetMQTTContext( MQTTContext_t * pxMQTTContext );
 
+#if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+/**
+ * @brief Sends again, with the DUP flag set, the QoS1 publishes kept from the
+ * previous connection.
+ *
+ * Called after the broker has accepted a connection made with the Clean
+ * Session flag cleared. Publishes which cannot be sent now are sent again
+ * after the next reconnect, or fail when they time out.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ */
+    static void prvResendSessionPublishes( MQTTContext_t * pxMQTTContext );
+#endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+
 /**
  * @brief Gets the current tick count.
  *
@@ -490,6 +636,24 @@ static MQTTReturnCode_t prvSendData( MQTTContext_t * pxMQTTContext,
                                      const uint8_t * const pucData,
                                      uint32_t ulDataLength );
 
+/**
+ * @brief Transmits the data of several buffers using the user supplied
+ * gathered send callback.
+ *
+ * Updates the last sent message timestamp in the same way as prvSendData.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] pxIOVectors The buffers to transmit.
+ * @param[in] ulIOVectorCount Number of buffers in pxIOVectors.
+ * @param[in] ulTotalDataLength Sum of the lengths of all the buffers.
+ *
+ * @return eMQTTSuccess if send is successful, eMQTTSendFailed otherwise.
+ */
+static MQTTReturnCode_t prvSendDataV( MQTTContext_t * pxMQTTContext,
+                                      const MQTTIOVector_t * const pxIOVectors,
+                                      uint32_t ulIOVectorCount,
+                                      uint32_t ulTotalDataLength );
+
 /**
  * @brief Decodes and processes the received MQTT message containing only fixed header.
  *
@@ -521,6 +685,29 @@ static void prvProcessReceivedFixedHeaderOnlyMQTTPacket( MQTTContext_t * pxMQTTC
  */
 static void prvProcessReceivedMQTTPacket( MQTTContext_t * pxMQTTContext );
 
+/**
+ * @brief Processes a packet which has been received whole.
+ *
+ * Used by MQTT_ParseReceivedData at the start of a packet. If all the bytes of
+ * the packet are in pucReceivedData and a large enough buffer is available,
+ * the packet is processed directly and the number of its bytes is returned.
+ * Otherwise nothing is consumed and the Rx state is left untouched, so that
+ * the packet goes through the byte by byte state machine.
+ *
+ * @param[in] pxMQTTContext The MQTT context for which the data was received.
+ * @param[in] pucReceivedData The data starting with the packet type byte.
+ * @param[in] xReceivedDataLength The number of bytes in pucReceivedData.
+ *
+ * @return The length of the processed packet, or 0 if it was not processed.
+ */
+#if ( mqttconfigENABLE_RX_FAST_PATH == 1 )
+
+    static size_t prvProcessCompletePacket( MQTTContext_t * pxMQTTContext,
+                                            const uint8_t * const pucReceivedData,
+                                            size_t xReceivedDataLength );
+
+#endif /* mqttconfigENABLE_RX_FAST_PATH */
+
 /**
  * @brief Decodes and processes the received CONNACK message.
  *
@@ -565,6 +752,46 @@ static void prvProcessReceivedUNSUBACK( MQTTContext_t * pxMQTTContext );
  */
 static void prvProcessReceivedPUBACK( MQTTContext_t * pxMQTTContext );
 
+#if ( mqttconfigENABLE_QOS2 == 1 )
+
+/**
+ * @brief Decodes and processes a received PUBREC, PUBREL or PUBCOMP message.
+ *
+ * A PUBREC turns the Tx buffer of the matching QoS2 publish into a PUBREL and
+ * sends it. A PUBREL releases the packet identifier of an incoming QoS2
+ * publish and is answered with a PUBCOMP. A PUBCOMP completes an outgoing
+ * QoS2 publish, which is reported to the user as a PUBACK.
+ *
+ * @param[in] pxMQTTContext The MQTT context for which the message was received.
+ */
+    static void prvProcessReceivedQoS2Ack( MQTTContext_t * pxMQTTContext );
+
+/**
+ * @brief Sends a PUBREC, PUBREL or PUBCOMP message.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] ucControlByte The first byte of the fixed header.
+ * @param[in] usPacketIdentifier The packet identifier to acknowledge.
+ */
+    static void prvSendQoS2Ack( MQTTContext_t * pxMQTTContext,
+                                uint8_t ucControlByte,
+                                uint16_t usPacketIdentifier );
+
+/**
+ * @brief Records the packet identifier of an incoming QoS2 publish.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] usPacketIdentifier The packet identifier of the publish.
+ *
+ * @return eMQTTTrue if the publish must be acknowledged, eMQTTFalse if there
+ * is no room to record it. *pxIsDuplicate is set to eMQTTTrue if the publish
+ * had already been received.
+ */
+    static MQTTBool_t prvRecordReceivedQoS2Publish( MQTTContext_t * pxMQTTContext,
+                                                    uint16_t usPacketIdentifier,
+                                                    MQTTBool_t * pxIsDuplicate );
+#endif /* mqttconfigENABLE_QOS2 */
+
 /**
  * @brief Decodes and processes the received PINGRESP message.
  *
@@ -589,6 +816,20 @@ static void prvProcessReceivedPINGRESP( MQTTContext_t * pxMQTTContext );
  */
 static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext );
 
+/**
+ * @brief Finds the start of the data in the received Publish message.
+ *
+ * The data follows the topic, the packet identifier if the QoS is not 0
+ * and, with MQTT 5.0, the properties.
+ *
+ * @param[in] pxMQTTContext The MQTT context for which the message was received.
+ * @param[out] pulPayloadOffset The offset of the data in the Rx buffer.
+ *
+ * @return eMQTTTrue if the message is well formed, eMQTTFalse otherwise.
+ */
+static MQTTBool_t prvGetPublishPayloadOffset( MQTTContext_t * pxMQTTContext,
+                                              uint32_t * const pulPayloadOffset );
+
 /**
  * @brief Invokes the user supplied callback.
  *
@@ -633,6 +874,22 @@ static uint8_t * prvWriteString( uint8_t * pucDestination,
                                  const uint8_t * const pucString,
                                  uint16_t usStringLength );
 
+/**
+ * @brief Prepares and transmits an MQTT publish message.
+ *
+ * @param[in] pxMQTTContext The initialized MQTT context.
+ * @param[in] pxPublishParams Publish parameters.
+ * @param[in] pucEncodedTopic The topic with its length prefix, as written in
+ * the message, or NULL to encode the topic of the publish parameters.
+ * @param[in] usEncodedTopicLength The length of pucEncodedTopic.
+ *
+ * @return eMQTTSuccess if everything succeeds, otherwise an error code explaining the reason of failure.
+ */
+static MQTTReturnCode_t prvPublish( MQTTContext_t * pxMQTTContext,
+                                    const MQTTPublishParams_t * const pxPublishParams,
+                                    const uint8_t * const pucEncodedTopic,
+                                    uint16_t usEncodedTopicLength );
+
 /**
  * @brief Returns the number of bytes required to encode the given "Remaining Length"
  * using the variable length encoding scheme documented by the MQTT protocol spec.
@@ -691,21 +948,24 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
  * This function can fail to store the subscription if all the entries in the
  * subscription manager are in use or the topic name is longer than the maximum
  * length as specified by the mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LENGTH
- * macro or if the topic represents an invalid topic filter. eMQTTFalse is returned
- * to indicate the failure.
+ * macro or if the topic represents an invalid topic filter. It also fails if
+ * the topic filter has more levels than mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS.
  *
- * @param[in] pxMQTTContext The MQTT context for which to store the subscription.
+ * @param[in] pxSubscriptionManager The subscription manager in which to store
+ * the subscription.
  * @param[in] pucTopic The topic this subscription entry is for.
  * @param[in] usTopicLength The length of the topic.
  * @param[in] pvPublishCallbackContext The user supplied callback context.
  * @param[in] pxPublishCallback The callback to invoke whenever a publish message
  * is received on this topic.
  *
- * @return eMQTTTrue if subscription is stored successfully, eMQTTFalse otherwise.
+ * @return eMQTTSuccess if subscription is stored successfully,
+ * eMQTTTopicFilterTooManyLevels if the topic filter has too many levels,
+ * eMQTTSubscriptionManagerFull otherwise.
  */
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-    static MQTTBool_t prvStoreSubscription( MQTTContext_t * pxMQTTContext,
+    static MQTTReturnCode_t prvStoreSubscription( MQTTSubscriptionManager_t * pxSubscriptionManager,
                                             const uint8_t * const pucTopic,
                                             uint16_t usTopicLength,
                                             void * pvPublishCallbackContext,
@@ -713,6 +973,17 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
+/**
+ * @brief Marks all the entries of the subscription manager as free.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static void prvResetSubscriptionManager( MQTTSubscriptionManager_t * pxSubscriptionManager );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
 /**
  * @brief Removes the subscription entry from the subscription manager corresponding
  * to the provided topic.
@@ -721,15 +992,18 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
  * the one with the matching topic. If it finds one, removes it by marking it
  * free.
  *
- * @param[in] pxMQTTContext The MQTT context for which to remove the subscription.
+ * @param[in] pxSubscriptionManager The subscription manager from which to remove
+ * the subscription.
  * @param[in] pucTopic The topic for which the subscription entry is to be removed.
  * @param[in] usTopicLength The length of the topic.
+ *
+ * @return eMQTTTrue if a subscription was removed, eMQTTFalse otherwise.
  */
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-    static void prvRemoveSubscription( MQTTContext_t * pxMQTTContext,
-                                       const uint8_t * const pucTopic,
-                                       uint16_t usTopicLength );
+    static MQTTBool_t prvRemoveSubscription( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                             const uint8_t * const pucTopic,
+                                             uint16_t usTopicLength );
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
@@ -812,6 +1086,9 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
  * @brief Checks whether the given topic matches the given topic
  * filter.
  *
+ * Received publishes are dispatched using the topic filter trie. This
+ * function is the reference the trie is tested against.
+ *
  * @warning It assumes that the given topic filter is valid i.e.
  * calling prvIsValidTopicFilter with the given topic will not
  * return eMQTTTopicFilterTypeInvalid.
@@ -830,13 +1107,156 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
  *
  * @return eMQTTTrue if the topic matches the filter, eMQTTFalse otherwise.
  */
-#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && defined( AMAZON_FREERTOS_ENABLE_UNIT_TESTS )
 
     static MQTTBool_t prvDoesTopicMatchTopicFilter( const uint8_t * const pucTopic,
                                                     uint16_t usTopicLength,
                                                     const uint8_t * const pucTopicFilter,
                                                     uint16_t usTopicFilterLength );
 
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && AMAZON_FREERTOS_ENABLE_UNIT_TESTS */
+
+/**
+ * @brief Returns the length of the topic level starting at the given offset.
+ *
+ * @param[in] pucTopic The topic or topic filter.
+ * @param[in] usTopicLength The length of the topic or topic filter.
+ * @param[in] usLevelOffset The offset of the first character of the level.
+ *
+ * @return The number of characters until the next '/' or the end of the topic.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint16_t prvGetTopicLevelLength( const uint8_t * const pucTopic,
+                                            uint16_t usTopicLength,
+                                            uint16_t usLevelOffset );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Returns the number of levels of a topic or topic filter.
+ *
+ * @param[in] pucTopic The topic or topic filter.
+ * @param[in] usTopicLength The length of the topic or topic filter.
+ *
+ * @return One more than the number of '/' characters.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint32_t prvGetTopicLevelCount( const uint8_t * const pucTopic,
+                                           uint16_t usTopicLength );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Returns the level string of the given topic filter trie node.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usNode The trie node. Must not be the root.
+ *
+ * @return Pointer to the level string in the topic filter of a subscription.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static const uint8_t * prvGetTopicTrieNodeLevel( const MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                                     uint16_t usNode );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Finds the child of a topic filter trie node with the given level
+ * string.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usParent The parent node.
+ * @param[in] pucLevel The level string.
+ * @param[in] usLevelLength The length of the level string.
+ *
+ * @return The index of the child node or mqttTOPIC_TRIE_NONE if there is none.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint16_t prvFindTopicTrieChild( const MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                           uint16_t usParent,
+                                           const uint8_t * const pucLevel,
+                                           uint16_t usLevelLength );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Resets the topic filter trie of the subscription manager to contain
+ * only the root node.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static void prvTopicTrieInit( MQTTSubscriptionManager_t * pxSubscriptionManager );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Adds the topic filter of the given subscription entry to the topic
+ * filter trie.
+ *
+ * Levels already present in the trie are shared. Nodes are only taken from
+ * the free list once it is known that enough nodes are available for all the
+ * missing levels, so that a failed insert leaves the trie unchanged.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usSubscription Index of the subscription entry to add. The entry
+ * must contain the topic filter.
+ *
+ * @return eMQTTTrue if the topic filter was added, eMQTTFalse if there were
+ * not enough free trie nodes.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static MQTTBool_t prvTopicTrieInsert( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                          uint16_t usSubscription );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Removes the topic filter of the given subscription entry from the
+ * topic filter trie.
+ *
+ * Nodes no longer used by any subscription are returned to the free list.
+ * Nodes which read their level string from the removed subscription are
+ * pointed at another subscription passing through them.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usSubscription Index of the subscription entry to remove. The
+ * entry must still contain the topic filter.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static void prvTopicTrieRemove( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                    uint16_t usSubscription );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+/**
+ * @brief Finds all the subscription entries whose topic filter matches the
+ * given topic.
+ *
+ * Walks the trie one topic level at a time, following the child matching the
+ * level as well as any '+' child, and collecting the subscriptions of '#'
+ * children on the way. The matching indexes are written to usTrieMatches of
+ * the subscription manager.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] pucTopic The topic to match.
+ * @param[in] usTopicLength The length of the topic.
+ *
+ * @return The number of matching subscription entries.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint32_t prvTopicTrieMatch( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                       const uint8_t * const pucTopic,
+                                       uint16_t usTopicLength );
+
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 /*-----------------------------------------------------------*/
 
@@ -998,63 +1418,471 @@ static void prvResetRxMessageState( MQTTContext_t * pxMQTTContext )
     pxMQTTContext->xRxMessageState.xRxNextByte = eMQTTRxNextBytePacketType;
     pxMQTTContext->ulRxMessageReceivedLength = 0;
     pxMQTTContext->xRxBuffer = NULL;
+
+    #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+        pxMQTTContext->ulRxStreamHeaderLength = 0;
+    #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
 }
 /*-----------------------------------------------------------*/
 
-static void prvResetMQTTContext( MQTTContext_t * pxMQTTContext )
-{
-    Link_t * pxLink, * pxTempLink;
-    MQTTBufferHandle_t xBufferHandle;
+#if ( mqttconfigENABLE_MQTT5 == 1 )
 
-    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
-        uint32_t x;
-    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+    static MQTTBool_t prvDecodeProperties( MQTTContext_t * pxMQTTContext,
+                                           uint32_t * const pulOffset,
+                                           uint16_t * const pusReceiveMaximum )
+    {
+        const uint8_t * pucData = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer );
+        uint32_t ulPacketLength = mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer );
+        uint32_t ulOffset = *pulOffset, ulPropertiesEnd = 0, ulValueLength, ulStrings, x;
+        uint8_t ucLengthBytes, ucIdentifier, ucEncodedLength[ mqttREMAINING_LENGTH_MAX_BYTES ] = { 0 };
+        MQTTBool_t xValid = eMQTTFalse;
+
+        /* The property length is encoded like "Remaining Length". It is
+         * copied first so that decoding cannot read past the packet. */
+        if( ulOffset < ulPacketLength )
+        {
+            memcpy( ucEncodedLength, &( pucData[ ulOffset ] ), ( size_t ) mqttMIN( ulPacketLength - ulOffset, ( uint32_t ) mqttREMAINING_LENGTH_MAX_BYTES ) );
+            ucLengthBytes = prvDecodeRemainingLength( ucEncodedLength, &ulPropertiesEnd );
 
-    /* Set connection state to not connected. */
-    pxMQTTContext->xConnectionState = eMQTTNotConnected;
+            if( ( ucLengthBytes > ( uint8_t ) 0 ) &&
+                ( ( uint32_t ) ucLengthBytes <= ( ulPacketLength - ulOffset ) ) &&
+                ( ulPropertiesEnd <= ( ulPacketLength - ulOffset - ( uint32_t ) ucLengthBytes ) ) )
+            {
+                ulOffset += ( uint32_t ) ucLengthBytes;
+                ulPropertiesEnd += ulOffset;
+                xValid = eMQTTTrue;
+            }
+        }
 
-    /* Return all Tx buffers to the free buffer pool. */
-    listFOR_EACH_SAFE( pxLink, pxTempLink, &( pxMQTTContext->xTxBufferListHead ) )
-    {
-        xBufferHandle = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
-        prvReturnBuffer( pxMQTTContext, xBufferHandle );
-    }
+        while( ( xValid == eMQTTTrue ) && ( ulOffset < ulPropertiesEnd ) )
+        {
+            ucIdentifier = pucData[ ulOffset ];
+            ulOffset++;
+            ulValueLength = 0;
+            ulStrings = 0;
 
-    /* Return Rx buffer to the free buffer pool. */
-    prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
+            /* The length of a property value depends on its type. */
+            switch( ucIdentifier )
+            {
+                /* Byte. */
+                case 0x01:
+                case 0x17:
+                case 0x19:
+                case 0x24:
+                case 0x25:
+                case 0x28:
+                case 0x29:
+                case 0x2A:
+                    ulValueLength = 1;
+                    break;
 
-    /* Reset Rx message state. */
-    prvResetRxMessageState( pxMQTTContext );
+                /* Two Byte Integer. */
+                case 0x13:
+                case mqttPROPERTY_RECEIVE_MAXIMUM:
+                case 0x22:
+                case 0x23:
+                    ulValueLength = 2;
+                    break;
 
-    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+                /* Four Byte Integer. */
+                case 0x02:
+                case 0x11:
+                case 0x18:
+                case 0x27:
+                    ulValueLength = 4;
+                    break;
 
-        /* Mark all the subscription entires in the subscription
-         * manager as free. */
-        for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
-        {
-            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse = eMQTTFalse;
-        }
+                /* Variable Byte Integer. */
+                case 0x0B:
 
-        /* Set the number of in-use subscription entries to zero. */
-        pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions = 0;
-    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
-}
-/*-----------------------------------------------------------*/
+                    for( ulValueLength = 1; ulValueLength < ( uint32_t ) mqttREMAINING_LENGTH_MAX_BYTES; ulValueLength++ )
+                    {
+                        if( ( ( ulOffset + ulValueLength ) > ulPropertiesEnd ) ||
+                            ( ( pucData[ ulOffset + ulValueLength - ( uint32_t ) 1 ] & mqttREMAINING_LENGTH_CONTINUATION_BITMASK ) == ( uint8_t ) 0 ) )
+                        {
+                            break;
+                        }
+                    }
 
-static uint64_t prvGetCurrentTickCount( MQTTContext_t * pxMQTTContext )
-{
-    uint64_t uxCurrentTickCount = 0;
+                    break;
 
-    /* If user has supplied get ticks function, use it to get the
-     * current tick count. */
-    if( pxMQTTContext->pxGetTicksFxn != NULL )
-    {
-        pxMQTTContext->pxGetTicksFxn( &( uxCurrentTickCount ) );
-    }
+                /* UTF-8 Encoded String or Binary Data. */
+                case 0x03:
+                case 0x08:
+                case 0x09:
+                case 0x12:
+                case 0x15:
+                case 0x16:
+                case 0x1A:
+                case 0x1C:
+                case 0x1F:
+                    ulStrings = 1;
+                    break;
 
-    /* If user has not supplied get ticks function, we return zero
-     * and time-stamp is stored on the next invocation of MQTT_Periodic.
-     * Note that in this case the time measurement will start from the
+                /* UTF-8 String Pair. */
+                case mqttPROPERTY_USER_PROPERTY:
+                    ulStrings = 2;
+                    break;
+
+                default:
+                    /* Unknown property. */
+                    xValid = eMQTTFalse;
+                    break;
+            }
+
+            /* Each string is preceded by its two byte length. */
+            for( x = 0; ( x < ulStrings ) && ( xValid == eMQTTTrue ); x++ )
+            {
+                if( ( ulOffset + ulValueLength + ( uint32_t ) 2 ) > ulPropertiesEnd )
+                {
+                    xValid = eMQTTFalse;
+                }
+                else
+                {
+                    ulValueLength += ( uint32_t ) 2 +
+                                     ( ( ( uint32_t ) pucData[ ulOffset + ulValueLength ] ) << mqttBITS_PER_BYTE ) +
+                                     ( uint32_t ) pucData[ ulOffset + ulValueLength + ( uint32_t ) 1 ];
+                }
+            }
+
+            if( ( ulOffset + ulValueLength ) > ulPropertiesEnd )
+            {
+                xValid = eMQTTFalse;
+            }
+            else if( ( xValid == eMQTTTrue ) && ( ucIdentifier == mqttPROPERTY_RECEIVE_MAXIMUM ) && ( pusReceiveMaximum != NULL ) )
+            {
+                *pusReceiveMaximum = ( uint16_t ) ( ( ( uint16_t ) pucData[ ulOffset ] << mqttBITS_PER_BYTE ) | ( uint16_t ) pucData[ ulOffset + ( uint32_t ) 1 ] );
+
+                /* A Receive Maximum of 0 is a protocol error. */
+                if( *pusReceiveMaximum == ( uint16_t ) 0 )
+                {
+                    xValid = eMQTTFalse;
+                }
+            }
+            else
+            {
+                /* The value of any other property is not used. */
+            }
+
+            ulOffset += ulValueLength;
+        }
+
+        if( xValid == eMQTTTrue )
+        {
+            *pulOffset = ulOffset;
+        }
+
+        return xValid;
+    }
+/*-----------------------------------------------------------*/
+
+    static MQTTBool_t prvDecodeConnACKReasonCode( MQTTContext_t * pxMQTTContext,
+                                                  uint8_t * const pucReturnCode )
+    {
+        uint32_t ulOffset = mqttADJUST_OFFSET( mqttCONNACK_RETURN_CODE_OFFSET, pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes );
+        uint8_t ucReasonCode;
+        MQTTBool_t xValid = eMQTTFalse;
+
+        /* The broker allows any number of publishes in flight unless it
+         * sends a Receive Maximum. */
+        pxMQTTContext->usReceiveMaximum = mqttRECEIVE_MAXIMUM_DEFAULT;
+
+        if( ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_CONNACK | mqttFLAGS_CONNACK ) ) &&
+            ( ulOffset < mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) ) )
+        {
+            ucReasonCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ ulOffset ];
+            ulOffset++;
+
+            xValid = prvDecodeProperties( pxMQTTContext, &ulOffset, &( pxMQTTContext->usReceiveMaximum ) );
+
+            switch( ucReasonCode )
+            {
+                case 0x00: /* Success. */
+                    *pucReturnCode = ( uint8_t ) eMQTTConnACKConnectionAccepted;
+                    break;
+
+                case 0x84: /* Unsupported Protocol Version. */
+                    *pucReturnCode = ( uint8_t ) eMQTTConnACKUnacceptableProtocolVersion;
+                    break;
+
+                case 0x85: /* Client Identifier not valid. */
+                    *pucReturnCode = ( uint8_t ) eMQTTConnACKIdentifierRejected;
+                    break;
+
+                case 0x86: /* Bad User Name or Password. */
+                    *pucReturnCode = ( uint8_t ) eMQTTConnACKBadUsernameOrPassword;
+                    break;
+
+                case 0x87: /* Not authorized. */
+                case 0x8A: /* Banned. */
+                    *pucReturnCode = ( uint8_t ) eMQTTConnACKUnauthorized;
+                    break;
+
+                default:
+
+                    /* Any other failure means that the broker cannot be used
+                     * at the moment. Other reason codes are not valid in a
+                     * CONNACK. */
+                    *pucReturnCode = ( ucReasonCode >= mqttREASON_CODE_FAILURE ) ? ( uint8_t ) eMQTTConnACKServerUnavailable : ( uint8_t ) 0xFF;
+                    break;
+            }
+        }
+
+        return xValid;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvProcessReceivedDISCONNECT( MQTTContext_t * pxMQTTContext,
+                                              uint8_t ucReasonCode )
+    {
+        MQTTEventCallbackParams_t xEventCallbackParams;
+
+        mqttconfigDEBUG_LOG( ( "DISCONNECT received, reason code %x.\r\n", ucReasonCode ) );
+
+        /* The broker closes the connection after sending a DISCONNECT. */
+        prvResetMQTTContext( pxMQTTContext );
+
+        xEventCallbackParams.xEventType = eMQTTClientDisconnected;
+        xEventCallbackParams.u.xDisconnectData.xDisconnectReason = eMQTTDisconnectReasonBrokerDisconnect;
+        xEventCallbackParams.u.xDisconnectData.ucReasonCode = ucReasonCode;
+        ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+    }
+/*-----------------------------------------------------------*/
+
+    static uint32_t prvCountPublishesInFlight( MQTTContext_t * pxMQTTContext )
+    {
+        Link_t * pxLink;
+        MQTTBufferHandle_t xBuffer;
+        uint32_t ulCount = 0;
+
+        /* QoS0 publishes are never kept in the Tx buffer list. */
+        listFOR_EACH( pxLink, &( pxMQTTContext->xTxBufferListHead ) )
+        {
+            xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+
+            if( ( ( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH ) ||
+                ( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_PUBREL | mqttFLAGS_PUBREL ) ) )
+            {
+                ulCount++;
+            }
+        }
+
+        return ulCount;
+    }
+
+#endif /* mqttconfigENABLE_MQTT5 */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+
+    static uint32_t prvProcessStreamedPublishBytes( MQTTContext_t * pxMQTTContext,
+                                                    const uint8_t * pucReceivedData,
+                                                    uint32_t ulReceivedDataLength )
+    {
+        MQTTEventCallbackParams_t xEventCallbackParams;
+        uint8_t ucPUBACKPacket[ mqttFIXED_HEADER_MIN_SIZE + mqttPUBACK_PACKET_IDENTIFER_LENGTH ] = { mqttCONTROL_PUBACK | mqttFLAGS_PUBACK, 0x02, 0x00, 0x00 };
+        uint32_t ulTopicOffset = mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET, pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes );
+        uint32_t ulPacketIdentifierLength, ulProcessedBytes = 0, ulChunkLength = 0;
+        uint8_t ucQos = mqttPUBLISH_QoS_BITS( pxMQTTContext->ucRxStreamHeader[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] );
+        MQTTBool_t xDeliver = eMQTTFalse;
+
+        ulPacketIdentifierLength = ( ucQos == ( uint8_t ) 0 ) ? ( uint32_t ) mqttPUBLISH_QOS0_PACKET_IDENTIFER_LENGTH : ( uint32_t ) mqttPUBLISH_QOS1_PACKET_IDENTIFER_LENGTH;
+
+        if( pxMQTTContext->ulRxMessageReceivedLength < ulTopicOffset )
+        {
+            /* The topic length is needed to know how long the header is. */
+            ulChunkLength = mqttMIN( ulReceivedDataLength, ulTopicOffset - pxMQTTContext->ulRxMessageReceivedLength );
+            mqttCOPY_BYTES( pucReceivedData, ulProcessedBytes, pxMQTTContext->ucRxStreamHeader, pxMQTTContext->ulRxMessageReceivedLength, ulChunkLength );
+            ulChunkLength = 0;
+
+            if( pxMQTTContext->ulRxMessageReceivedLength == ulTopicOffset )
+            {
+                pxMQTTContext->ulRxStreamHeaderLength = ulTopicOffset + ulPacketIdentifierLength +
+                                                        ( ( ( uint32_t ) pxMQTTContext->ucRxStreamHeader[ ulTopicOffset - ( uint32_t ) 2 ] ) << mqttBITS_PER_BYTE ) +
+                                                        ( uint32_t ) pxMQTTContext->ucRxStreamHeader[ ulTopicOffset - ( uint32_t ) 1 ];
+
+                /* Drop the rest of a message whose header cannot be kept. */
+                if( ( pxMQTTContext->ulRxStreamHeaderLength > ( uint32_t ) sizeof( pxMQTTContext->ucRxStreamHeader ) ) ||
+                    ( pxMQTTContext->ulRxStreamHeaderLength > pxMQTTContext->xRxMessageState.ulTotalMessageLength ) )
+                {
+                    mqttconfigDEBUG_LOG( ( "Topic too long to stream the publish, dropping it.\r\n" ) );
+                    pxMQTTContext->xRxMessageState.xRxMessageAction = eMQTTRxMessageDrop;
+                }
+                else if( pxMQTTContext->ulRxStreamHeaderLength == pxMQTTContext->xRxMessageState.ulTotalMessageLength )
+                {
+                    /* An empty message without topic. */
+                    xDeliver = eMQTTTrue;
+                }
+                else
+                {
+                    /* The topic follows. */
+                }
+            }
+        }
+        else if( pxMQTTContext->ulRxMessageReceivedLength < pxMQTTContext->ulRxStreamHeaderLength )
+        {
+            /* Receiving the topic and packet identifier. A message without
+             * payload is reported as one empty chunk. */
+            ulChunkLength = mqttMIN( ulReceivedDataLength, pxMQTTContext->ulRxStreamHeaderLength - pxMQTTContext->ulRxMessageReceivedLength );
+            mqttCOPY_BYTES( pucReceivedData, ulProcessedBytes, pxMQTTContext->ucRxStreamHeader, pxMQTTContext->ulRxMessageReceivedLength, ulChunkLength );
+            ulChunkLength = 0;
+
+            if( pxMQTTContext->ulRxMessageReceivedLength == pxMQTTContext->xRxMessageState.ulTotalMessageLength )
+            {
+                xDeliver = eMQTTTrue;
+            }
+        }
+        else
+        {
+            /* Receiving the payload, which is passed on without a copy. */
+            ulChunkLength = mqttMIN( ulReceivedDataLength, pxMQTTContext->xRxMessageState.ulTotalMessageLength - pxMQTTContext->ulRxMessageReceivedLength );
+            xDeliver = eMQTTTrue;
+        }
+
+        if( xDeliver == eMQTTTrue )
+        {
+            xEventCallbackParams.xEventType = eMQTTPublishChunk;
+            xEventCallbackParams.u.xPublishChunkData.xQos = ( MQTTQoS_t ) ucQos;
+            xEventCallbackParams.u.xPublishChunkData.pucTopic = &( pxMQTTContext->ucRxStreamHeader[ ulTopicOffset ] );
+            xEventCallbackParams.u.xPublishChunkData.usTopicLength = ( uint16_t ) ( pxMQTTContext->ulRxStreamHeaderLength - ulTopicOffset - ulPacketIdentifierLength );
+            xEventCallbackParams.u.xPublishChunkData.ulTotalLength = pxMQTTContext->xRxMessageState.ulTotalMessageLength - pxMQTTContext->ulRxStreamHeaderLength;
+            xEventCallbackParams.u.xPublishChunkData.ulOffset = pxMQTTContext->ulRxMessageReceivedLength - pxMQTTContext->ulRxStreamHeaderLength;
+            xEventCallbackParams.u.xPublishChunkData.pvData = &( pucReceivedData[ ulProcessedBytes ] );
+            xEventCallbackParams.u.xPublishChunkData.ulDataLength = ulChunkLength;
+            ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+
+            ulProcessedBytes += ulChunkLength;
+            pxMQTTContext->ulRxMessageReceivedLength += ulChunkLength;
+
+            /* Acknowledge a QoS1 publish once all of it has been passed on. */
+            if( ( pxMQTTContext->ulRxMessageReceivedLength == pxMQTTContext->xRxMessageState.ulTotalMessageLength ) &&
+                ( ucQos == ( uint8_t ) 1 ) )
+            {
+                ucPUBACKPacket[ mqttPUBACK_PACKET_ID_MSB_OFFSET ] = pxMQTTContext->ucRxStreamHeader[ pxMQTTContext->ulRxStreamHeaderLength - ( uint32_t ) 2 ];
+                ucPUBACKPacket[ mqttPUBACK_PACKET_ID_LSB_OFFSET ] = pxMQTTContext->ucRxStreamHeader[ pxMQTTContext->ulRxStreamHeaderLength - ( uint32_t ) 1 ];
+                ( void ) prvSendData( pxMQTTContext, ucPUBACKPacket, ( uint32_t ) sizeof( ucPUBACKPacket ) );
+            }
+        }
+
+        return ulProcessedBytes;
+    }
+
+#endif /* mqttconfigENABLE_STREAMING_PUBLISH */
+/*-----------------------------------------------------------*/
+
+static void prvResetMQTTContext( MQTTContext_t * pxMQTTContext )
+{
+    Link_t * pxLink, * pxTempLink;
+    MQTTBufferHandle_t xBufferHandle;
+    MQTTBool_t xKeepSession = eMQTTFalse;
+
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        xKeepSession = ( pxMQTTContext->xCleanSession == eMQTTFalse ) ? eMQTTTrue : eMQTTFalse;
+    #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+
+    /* Set connection state to not connected. */
+    pxMQTTContext->xConnectionState = eMQTTNotConnected;
+
+    /* Return all Tx buffers to the free buffer pool, except the QoS1
+     * publishes which are part of a session kept across disconnects. */
+    listFOR_EACH_SAFE( pxLink, pxTempLink, &( pxMQTTContext->xTxBufferListHead ) )
+    {
+        xBufferHandle = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+
+        if( ( xKeepSession == eMQTTTrue ) &&
+            ( ( ( mqttbufferGET_DATA( xBufferHandle )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH ) ||
+              ( mqttbufferGET_DATA( xBufferHandle )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_PUBREL | mqttFLAGS_PUBREL ) ) ) )
+        {
+            continue;
+        }
+
+        #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+            /* A kept subscription manager must not hold a subscription the
+             * broker may never have acknowledged. */
+            if( ( xKeepSession == eMQTTTrue ) &&
+                ( mqttbufferGET_DATA( xBufferHandle )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_SUBSCRIBE | mqttFLAGS_SUBSCRIBE ) ) )
+            {
+                prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xBufferHandle );
+            }
+        #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+        prvReturnBuffer( pxMQTTContext, xBufferHandle );
+    }
+
+    /* Return Rx buffer to the free buffer pool. */
+    prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
+
+    /* Reset Rx message state. */
+    prvResetRxMessageState( pxMQTTContext );
+
+    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+        if( xKeepSession == eMQTTFalse )
+        {
+            prvResetSubscriptionManager( &( pxMQTTContext->xSubscriptionManager ) );
+        }
+    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+    #if ( mqttconfigENABLE_QOS2 == 1 )
+        /* The broker forgets the incoming QoS2 publishes of a clean session. */
+        if( xKeepSession == eMQTTFalse )
+        {
+            memset( pxMQTTContext->usQoS2Received, 0x00, sizeof( pxMQTTContext->usQoS2Received ) );
+        }
+    #endif /* mqttconfigENABLE_QOS2 */
+
+    /* Remove compiler warnings when the session is never kept. */
+    ( void ) xKeepSession;
+}
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+    static void prvResendSessionPublishes( MQTTContext_t * pxMQTTContext )
+    {
+        Link_t * pxLink;
+        MQTTBufferHandle_t xBufferHandle;
+
+        /* Only publishes and PUBRELs can be left in the Tx list at this
+         * point, as the CONNECT buffer has just been returned. A PUBREL is
+         * sent again as it is. */
+        listFOR_EACH( pxLink, &( pxMQTTContext->xTxBufferListHead ) )
+        {
+            xBufferHandle = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+
+            if( ( mqttbufferGET_DATA( xBufferHandle )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH )
+            {
+                mqttbufferGET_DATA( xBufferHandle )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] |= mqttFLAGS_PUBLISH_DUP;
+            }
+
+            if( ( mqttbufferGET_DATA( xBufferHandle )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) != mqttCONTROL_CONNECT )
+            {
+
+                if( prvSendData( pxMQTTContext, mqttbufferGET_DATA( xBufferHandle ), mqttbufferGET_DATA_LENGTH( xBufferHandle ) ) != eMQTTSuccess )
+                {
+                    mqttconfigDEBUG_LOG( ( "Failed to resend a publish of the persistent session.\r\n" ) );
+                }
+            }
+        }
+    }
+
+#endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetCurrentTickCount( MQTTContext_t * pxMQTTContext )
+{
+    uint64_t uxCurrentTickCount = 0;
+
+    /* If user has supplied get ticks function, use it to get the
+     * current tick count. */
+    if( pxMQTTContext->pxGetTicksFxn != NULL )
+    {
+        pxMQTTContext->pxGetTicksFxn( &( uxCurrentTickCount ) );
+    }
+
+    /* If user has not supplied get ticks function, we return zero
+     * and time-stamp is stored on the next invocation of MQTT_Periodic.
+     * Note that in this case the time measurement will start from the
      * next invocation of MQTT_Periodic( as opposed to this moment ). */
     return uxCurrentTickCount;
 }
@@ -1121,6 +1949,27 @@ static MQTTReturnCode_t prvSendData( MQTTContext_t * pxMQTTContext,
 }
 /*-----------------------------------------------------------*/
 
+static MQTTReturnCode_t prvSendDataV( MQTTContext_t * pxMQTTContext,
+                                      const MQTTIOVector_t * const pxIOVectors,
+                                      uint32_t ulIOVectorCount,
+                                      uint32_t ulTotalDataLength )
+{
+    MQTTReturnCode_t xReturnCode = eMQTTSendFailed;
+
+    if( pxMQTTContext->pxMQTTSendVFxn( pxMQTTContext->pvSendContext, pxIOVectors, ulIOVectorCount ) == ulTotalDataLength )
+    {
+        xReturnCode = eMQTTSuccess;
+
+        /* Sending any message delays when the next keep alive should
+         * be sent. */
+        pxMQTTContext->xLastSentMessageTimestamp = prvGetCurrentTickCount( pxMQTTContext );
+        pxMQTTContext->ulNextPeriodicInvokeTicks = pxMQTTContext->ulKeepAliveActualIntervalTicks;
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
 static void prvProcessReceivedFixedHeaderOnlyMQTTPacket( MQTTContext_t * pxMQTTContext )
 {
     MQTTEventCallbackParams_t xEventCallbackParams;
@@ -1130,6 +1979,15 @@ static void prvProcessReceivedFixedHeaderOnlyMQTTPacket( MQTTContext_t * pxMQTTC
     {
         prvProcessReceivedPINGRESP( pxMQTTContext );
     }
+
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        /* Is this a DISCONNECT without a reason code? */
+        else if( ( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 ) &&
+                 ( pxMQTTContext->ucRxFixedHeaderBuffer[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_DISCONNECT | mqttFLAGS_DISCONNECT ) ) )
+        {
+            prvProcessReceivedDISCONNECT( pxMQTTContext, ( uint8_t ) 0 );
+        }
+    #endif /* mqttconfigENABLE_MQTT5 */
     /* Any other fixed header only packet is considered a malformed packet. */
     else
     {
@@ -1144,6 +2002,89 @@ static void prvProcessReceivedFixedHeaderOnlyMQTTPacket( MQTTContext_t * pxMQTTC
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_RX_FAST_PATH == 1 )
+
+    static size_t prvProcessCompletePacket( MQTTContext_t * pxMQTTContext,
+                                            const uint8_t * const pucReceivedData,
+                                            size_t xReceivedDataLength )
+    {
+        size_t xPacketLength = 0;
+        uint32_t ulRemainingLength = 0, ulFixedHeaderLength;
+        uint8_t ucLengthBytes = 0;
+        MQTTBufferHandle_t xBuffer;
+
+        /* Find the last byte of the "Remaining Length" field. A field which
+         * is incomplete or longer than allowed is left to the state machine,
+         * which waits for more data or reports the malformed packet. */
+        while( ( ucLengthBytes < ( uint8_t ) mqttREMAINING_LENGTH_MAX_BYTES ) &&
+               ( ( size_t ) ucLengthBytes + ( size_t ) 1 < xReceivedDataLength ) )
+        {
+            ucLengthBytes++;
+
+            if( ( pucReceivedData[ ucLengthBytes ] & mqttREMAINING_LENGTH_CONTINUATION_BITMASK ) == ( uint8_t ) 0 )
+            {
+                ( void ) prvDecodeRemainingLength( &( pucReceivedData[ mqttFIXED_HEADER_REMAINING_LENGTH_OFFSET ] ), &ulRemainingLength );
+                ulFixedHeaderLength = ( uint32_t ) ucLengthBytes + ( uint32_t ) 1;
+
+                /* Is all of the packet present? */
+                if( ( ( size_t ) ulRemainingLength + ( size_t ) ulFixedHeaderLength ) <= xReceivedDataLength )
+                {
+                    xPacketLength = ( size_t ) ulRemainingLength + ( size_t ) ulFixedHeaderLength;
+                }
+
+                break;
+            }
+        }
+
+        if( xPacketLength == ( size_t ) 0 )
+        {
+            /* The packet is not complete. */
+        }
+        else if( ulRemainingLength == ( uint32_t ) 0 )
+        {
+            /* Fixed header only packets are processed from the fixed header
+             * buffer. */
+            memcpy( pxMQTTContext->ucRxFixedHeaderBuffer, pucReceivedData, ( size_t ) ulFixedHeaderLength );
+            pxMQTTContext->ulRxMessageReceivedLength = ulFixedHeaderLength;
+            pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes = ucLengthBytes;
+            pxMQTTContext->xRxMessageState.ulTotalMessageLength = ulFixedHeaderLength;
+
+            prvProcessReceivedFixedHeaderOnlyMQTTPacket( pxMQTTContext );
+            prvResetRxMessageState( pxMQTTContext );
+        }
+        else
+        {
+            xBuffer = prvGetFreeBuffer( pxMQTTContext, ( uint32_t ) xPacketLength );
+
+            if( xBuffer != NULL )
+            {
+                /* Copy the whole packet at once and process it as if it had
+                 * been assembled by the state machine. */
+                memcpy( mqttbufferGET_DATA( xBuffer ), pucReceivedData, xPacketLength );
+                mqttbufferGET_DATA_LENGTH( xBuffer ) = ( uint32_t ) xPacketLength;
+
+                memcpy( pxMQTTContext->ucRxFixedHeaderBuffer, pucReceivedData, ( size_t ) ulFixedHeaderLength );
+                pxMQTTContext->xRxBuffer = xBuffer;
+                pxMQTTContext->ulRxMessageReceivedLength = ulFixedHeaderLength;
+                pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes = ucLengthBytes;
+                pxMQTTContext->xRxMessageState.ulTotalMessageLength = ( uint32_t ) xPacketLength;
+
+                prvProcessReceivedMQTTPacket( pxMQTTContext );
+                prvResetRxMessageState( pxMQTTContext );
+            }
+            else
+            {
+                /* Let the state machine drop or stream the packet. */
+                xPacketLength = 0;
+            }
+        }
+
+        return xPacketLength;
+    }
+
+#endif /* mqttconfigENABLE_RX_FAST_PATH */
+/*-----------------------------------------------------------*/
+
 static void prvProcessReceivedMQTTPacket( MQTTContext_t * pxMQTTContext )
 {
     MQTTEventCallbackParams_t xEventCallbackParams;
@@ -1173,6 +2114,27 @@ static void prvProcessReceivedMQTTPacket( MQTTContext_t * pxMQTTContext )
     {
         prvProcessReceivedUNSUBACK( pxMQTTContext );
     }
+
+    #if ( mqttconfigENABLE_QOS2 == 1 )
+        /* Is this a PUBREC, PUBREL or PUBCOMP? */
+        else if( ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_PUBREC | mqttFLAGS_PUBREC ) ) ||
+                 ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_PUBREL | mqttFLAGS_PUBREL ) ) ||
+                 ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_PUBCOMP | mqttFLAGS_PUBCOMP ) ) )
+        {
+            prvProcessReceivedQoS2Ack( pxMQTTContext );
+        }
+    #endif /* mqttconfigENABLE_QOS2 */
+
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        /* Is this a DISCONNECT with a reason code? The reset which follows
+         * it also returns the Rx buffer. */
+        else if( ( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 ) &&
+                 ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_DISCONNECT | mqttFLAGS_DISCONNECT ) ) )
+        {
+            prvProcessReceivedDISCONNECT( pxMQTTContext, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttVARIABLE_LENGTH_HEADER_START_OFFSET,
+                                                                                                                           pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ] );
+        }
+    #endif /* mqttconfigENABLE_MQTT5 */
     /* Any other packet is considered malformed. */
     else
     {
@@ -1191,8 +2153,8 @@ static void prvProcessReceivedCONNACK( MQTTContext_t * pxMQTTContext )
 {
     MQTTBufferHandle_t xConnectTxBuffer;
     MQTTEventCallbackParams_t xEventCallbackParams;
-    MQTTBool_t xConnectionEstablished = eMQTTFalse, xConnectionRefused = eMQTTFalse, xMalformedPacket = eMQTTFalse;
-    uint8_t ucReturnCode;
+    MQTTBool_t xConnectionEstablished = eMQTTFalse, xConnectionRefused = eMQTTFalse, xMalformedPacket = eMQTTFalse, xValidHeader;
+    uint8_t ucReturnCode = 0;
     static const uint8_t ucDefaultCONNACKParameters[] =
     {
         mqttCONTROL_CONNACK | mqttFLAGS_CONNACK, /* Fixed header control packet type. */
@@ -1218,18 +2180,33 @@ static void prvProcessReceivedCONNACK( MQTTContext_t * pxMQTTContext )
     {
         if( mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) >= sizeof( ucDefaultCONNACKParameters ) )
         {
-            /* Received enough data for a CONNACK - does the received fixed header match
-             * the expected one for the CONNACK message (Fixed header is of 2 bytes for CONNACK
-             * message because Remaining Length is 2 which takes only one byte)? */
-            if( memcmp( ucDefaultCONNACKParameters, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ), mqttFIXED_HEADER_MIN_SIZE ) == 0 )
+            #if ( mqttconfigENABLE_MQTT5 == 1 )
+                /* An MQTT 5.0 CONNACK carries a reason code and properties,
+                 * and its reason code is converted to an MQTT 3.1.1 one. */
+                if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+                {
+                    xValidHeader = prvDecodeConnACKReasonCode( pxMQTTContext, &ucReturnCode );
+                }
+                else
+            #endif /* mqttconfigENABLE_MQTT5 */
+            {
+                /* Received enough data for a CONNACK - does the received fixed header match
+                 * the expected one for the CONNACK message (Fixed header is of 2 bytes for CONNACK
+                 * message because Remaining Length is 2 which takes only one byte)? */
+                xValidHeader = ( memcmp( ucDefaultCONNACKParameters, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ), mqttFIXED_HEADER_MIN_SIZE ) == 0 ) ? eMQTTTrue : eMQTTFalse;
+                ucReturnCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttCONNACK_RETURN_CODE_OFFSET ];
+            }
+
+            if( xValidHeader == eMQTTTrue )
             {
                 mqttconfigDEBUG_LOG( ( "CONNACK received.\r\n" ) );
 
                 xEventCallbackParams.xEventType = eMQTTConnACK;
 
-                /* Since AWS IoT only supports CleanSession 1, SP bit will
-                 * always be zero. */
-                ucReturnCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttCONNACK_RETURN_CODE_OFFSET ];
+                #if ( mqttconfigENABLE_MQTT5 == 1 )
+                    xEventCallbackParams.u.xMQTTConnACKData.ucReasonCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttCONNACK_RETURN_CODE_OFFSET,
+                                                                                                                                              pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+                #endif /* mqttconfigENABLE_MQTT5 */
 
                 if( ucReturnCode == ( uint8_t ) 0 ) /* Connection Accepted. */
                 {
@@ -1238,6 +2215,26 @@ static void prvProcessReceivedCONNACK( MQTTContext_t * pxMQTTContext )
                     xEventCallbackParams.xEventType = eMQTTConnACK;
                     xEventCallbackParams.u.xMQTTConnACKData.xConnACKReturnCode = eMQTTConnACKConnectionAccepted;
                     xEventCallbackParams.u.xMQTTConnACKData.usPacketIdentifier = mqttbufferGET_PACKET_IDENTIFIER( xConnectTxBuffer );
+
+                    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+                        /* The SP bit can only be set if the connect cleared the
+                         * Clean Session flag. */
+                        xEventCallbackParams.u.xMQTTConnACKData.xSessionPresent =
+                            ( ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttCONNACK_SESSION_PRESENT_OFFSET,
+                                                                                   pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ] & ( uint8_t ) 0x01 ) != ( uint8_t ) 0 ) ? eMQTTTrue : eMQTTFalse;
+
+                        #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+                            /* The broker has no subscriptions for this client,
+                             * so the kept ones no longer apply. */
+                            if( xEventCallbackParams.u.xMQTTConnACKData.xSessionPresent == eMQTTFalse )
+                            {
+                                prvResetSubscriptionManager( &( pxMQTTContext->xSubscriptionManager ) );
+                            }
+                        #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+                    #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+
                     ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
 
                     /* Connection is established. */
@@ -1336,6 +2333,15 @@ static void prvProcessReceivedCONNACK( MQTTContext_t * pxMQTTContext )
 
         /* No ping has been sent yet. */
         pxMQTTContext->xWaitingForPingResp = eMQTTFalse;
+
+        #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+            /* Complete the publishes which were in flight when the previous
+             * connection was lost. */
+            if( pxMQTTContext->xCleanSession == eMQTTFalse )
+            {
+                prvResendSessionPublishes( pxMQTTContext );
+            }
+        #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
     }
 
     /* Return the RxBuffer to the free buffer pool. */
@@ -1351,6 +2357,10 @@ static void prvProcessReceivedSUBACK( MQTTContext_t * pxMQTTContext )
     uint8_t ucReturnCode;
     uint16_t usPacketIdentifier;
 
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        uint32_t ulReturnCodeOffset;
+    #endif
+
     /* Must have enough bytes to at least read out one return code. */
     if( mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) > ( uint32_t ) mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
                                                                                                 pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) )
@@ -1375,12 +2385,41 @@ static void prvProcessReceivedSUBACK( MQTTContext_t * pxMQTTContext )
         }
         else
         {
-            /* Extract the return code from the packet. */
-            ucReturnCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
-                                                                                              pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+            #if ( mqttconfigENABLE_MQTT5 == 1 )
+
+                /* MQTT 5.0 puts properties before the return code, and
+                 * has more than one failure reason code. */
+                if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+                {
+                    ulReturnCodeOffset = mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET, pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes );
 
-            /* Return code must be valid. Note that QoS2 is not supported. */
-            if( ( ucReturnCode <= ( uint8_t ) 1 ) || ( ucReturnCode == ( uint8_t ) 128 ) )
+                    if( ( prvDecodeProperties( pxMQTTContext, &ulReturnCodeOffset, NULL ) == eMQTTTrue ) &&
+                        ( ulReturnCodeOffset < mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) ) )
+                    {
+                        ucReturnCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ ulReturnCodeOffset ];
+
+                        if( ucReturnCode > ( uint8_t ) 128 )
+                        {
+                            ucReturnCode = ( uint8_t ) 128;
+                        }
+                    }
+                    else
+                    {
+                        /* Reserved, so the packet is treated as malformed. */
+                        ucReturnCode = ( uint8_t ) 0xFF;
+                    }
+                }
+                else
+            #endif /* mqttconfigENABLE_MQTT5 */
+            {
+                /* Extract the return code from the packet. */
+                ucReturnCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
+                                                                                                  pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+            }
+
+            /* Return code must be valid. Note that QoS2 is only granted if
+             * it was enabled and requested. */
+            if( ( ucReturnCode <= mqttMAX_RECEIVED_QOS ) || ( ucReturnCode == ( uint8_t ) 128 ) )
             {
                 /* Inform the user about the received SUBACK. */
                 xEventCallbackParams.xEventType = eMQTTSubACK;
@@ -1467,7 +2506,8 @@ static void prvProcessReceivedUNSUBACK( MQTTContext_t * pxMQTTContext )
         /* Received enough data for an UNSUBACK - does the received fixed header match
          * the expected one for the UNSUBACK message (Fixed header is of 2 bytes for UNSUBACK
          * message because Remaining Length is 2 which takes only one byte)? */
-        if( memcmp( ucUNSUBACKFixedHeader, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ), sizeof( ucUNSUBACKFixedHeader ) ) == 0 )
+        if( ( memcmp( ucUNSUBACKFixedHeader, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ), sizeof( ucUNSUBACKFixedHeader ) ) == 0 ) ||
+            ( mqttIS_MQTT5_ACK( pxMQTTContext, ucUNSUBACKFixedHeader[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] ) ) )
         {
             /* Extract the packet identifier and see if there is an unsubscribe
              * packet waiting for ACK. */
@@ -1555,7 +2595,8 @@ static void prvProcessReceivedPUBACK( MQTTContext_t * pxMQTTContext )
         /* Received enough data for a PUBACK - does the received fixed header match
          * the expected one for the PUBACK message (Fixed header is of 2 bytes for PUBACK
          * message because Remaining Length is 2 which takes only one byte)? */
-        if( memcmp( ucPUBACKFixedHeader, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ), sizeof( ucPUBACKFixedHeader ) ) == 0 )
+        if( ( memcmp( ucPUBACKFixedHeader, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ), sizeof( ucPUBACKFixedHeader ) ) == 0 ) ||
+            ( mqttIS_MQTT5_ACK( pxMQTTContext, ucPUBACKFixedHeader[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] ) ) )
         {
             /* Extract the packet identifier and see if there is a publish
              * packet waiting for ACK. */
@@ -1579,6 +2620,20 @@ static void prvProcessReceivedPUBACK( MQTTContext_t * pxMQTTContext )
                 /* Inform the user about the received UNSUBACK. */
                 xEventCallbackParams.xEventType = eMQTTPubACK;
                 xEventCallbackParams.u.xMQTTPubACKData.usPacketIdentifier = usPacketIdentifier;
+
+                #if ( mqttconfigENABLE_MQTT5 == 1 )
+                    /* The reason code is left out on success. */
+                    if( ( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 ) &&
+                        ( mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) > mqttADJUST_OFFSET( mqttPUBACK_REASON_CODE_OFFSET, pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ) )
+                    {
+                        xEventCallbackParams.u.xMQTTPubACKData.ucReasonCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBACK_REASON_CODE_OFFSET,
+                                                                                                                                               pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+                    }
+                    else
+                    {
+                        xEventCallbackParams.u.xMQTTPubACKData.ucReasonCode = ( uint8_t ) 0;
+                    }
+                #endif /* mqttconfigENABLE_MQTT5 */
                 ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
 
                 /* Return the Tx Buffer to the pool. */
@@ -1669,11 +2724,48 @@ static void prvProcessReceivedPINGRESP( MQTTContext_t * pxMQTTContext )
 }
 /*-----------------------------------------------------------*/
 
+static MQTTBool_t prvGetPublishPayloadOffset( MQTTContext_t * pxMQTTContext,
+                                              uint32_t * const pulPayloadOffset )
+{
+    const uint8_t * pucData = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer );
+    uint8_t ucRemainingLengthFieldBytes = pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes;
+    uint32_t ulOffset;
+    MQTTBool_t xValid = eMQTTTrue;
+
+    ulOffset = mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET, ucRemainingLengthFieldBytes ) +
+               ( ( ( uint32_t ) pucData[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_MSB, ucRemainingLengthFieldBytes ) ] ) << mqttBITS_PER_BYTE ) +
+               ( uint32_t ) pucData[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_LSB, ucRemainingLengthFieldBytes ) ];
+
+    /* Note that QoS0 publishes do not have packet identifier. */
+    if( mqttPUBLISH_QoS_BITS( pucData[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] ) != ( uint8_t ) 0 )
+    {
+        ulOffset += ( uint32_t ) mqttPUBLISH_QOS1_PACKET_IDENTIFER_LENGTH;
+    }
+
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+        {
+            xValid = prvDecodeProperties( pxMQTTContext, &ulOffset, NULL );
+        }
+    #endif /* mqttconfigENABLE_MQTT5 */
+
+    *pulPayloadOffset = ulOffset;
+
+    return xValid;
+}
+/*-----------------------------------------------------------*/
+
 static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
 {
     MQTTEventCallbackParams_t xEventCallbackParams;
-    uint8_t ucPacketIdentiferLength; /* Length in bytes taken by the packet identifier field in the received publish packet. */
+    uint32_t ulPayloadOffset;
     uint8_t ucQos;
+    MQTTBool_t xDeliver = eMQTTTrue;
+
+    #if ( mqttconfigENABLE_QOS2 == 1 )
+        uint16_t usPacketIdentifier;
+        MQTTBool_t xIsDuplicate;
+    #endif /* mqttconfigENABLE_QOS2 */
     static uint8_t ucPUBACKPacket[] =
     {
         mqttCONTROL_PUBACK | mqttFLAGS_PUBACK, /* Fixed header control packet type. */
@@ -1689,19 +2781,11 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
     /*_TODO_ Do we want to expose DUP and RETAIN? */
     ucQos = mqttPUBLISH_QoS_BITS( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] );
 
-    /* QoS2 is not supported. */
-    if( ( ucQos == ( uint8_t ) 0 /* QoS0. */ ) || ( ucQos == ( uint8_t ) 1 /* QoS1. */ ) )
+    /* QoS2 is only supported if enabled. */
+    if( ( ucQos <= mqttMAX_RECEIVED_QOS ) &&
+        ( prvGetPublishPayloadOffset( pxMQTTContext, &ulPayloadOffset ) == eMQTTTrue ) )
     {
-        xEventCallbackParams.u.xPublishData.xQos = ( ucQos == ( uint8_t ) 0 ) ? eMQTTQoS0 : eMQTTQoS1;
-
-        if( xEventCallbackParams.u.xPublishData.xQos == eMQTTQoS0 )
-        {
-            ucPacketIdentiferLength = mqttPUBLISH_QOS0_PACKET_IDENTIFER_LENGTH;
-        }
-        else
-        {
-            ucPacketIdentiferLength = mqttPUBLISH_QOS1_PACKET_IDENTIFER_LENGTH;
-        }
+        xEventCallbackParams.u.xPublishData.xQos = ( MQTTQoS_t ) ucQos;
 
         /* Extract Topic Length. */
         xEventCallbackParams.u.xPublishData.usTopicLength = ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_MSB,
@@ -1715,18 +2799,8 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
                                                                                                                              pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ] );
 
         /* Extract Published Data. */
-        xEventCallbackParams.u.xPublishData.pvData = ( void * ) &( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
-                                                                                                                                      pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
-                                                                                                                   xEventCallbackParams.u.xPublishData.usTopicLength +
-                                                                                                                   ucPacketIdentiferLength ] ); /*lint !e9087 Publish data is provided as void* to the user. */
-
-        /* Topic string is followed by packet identifier which is
-         * followed by actual data. NOte that QoS0 publishes do not
-         * have packet identifier. */
-        xEventCallbackParams.u.xPublishData.ulDataLength = pxMQTTContext->xRxMessageState.ulTotalMessageLength - ( mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
-                                                                                                                                      pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
-                                                                                                                   xEventCallbackParams.u.xPublishData.usTopicLength +
-                                                                                                                   ucPacketIdentiferLength );
+        xEventCallbackParams.u.xPublishData.pvData = ( void * ) &( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ ulPayloadOffset ] ); /*lint !e9087 Publish data is provided as void* to the user. */
+        xEventCallbackParams.u.xPublishData.ulDataLength = pxMQTTContext->xRxMessageState.ulTotalMessageLength - ulPayloadOffset;
 
         /* Pass the handle of the buffer containing the whole MQTT message. */
         xEventCallbackParams.u.xPublishData.xBuffer = pxMQTTContext->xRxBuffer;
@@ -1751,17 +2825,55 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
             ( void ) prvSendData( pxMQTTContext, ucPUBACKPacket, ( uint32_t ) sizeof( ucPUBACKPacket ) );
         }
 
+        #if ( mqttconfigENABLE_QOS2 == 1 )
+
+            /* If this is a QoS2 publish, send the PUBREC before invoking the
+             * callback, and deliver the message only the first time it is
+             * received. */
+            if( xEventCallbackParams.u.xPublishData.xQos == eMQTTQoS2 )
+            {
+                usPacketIdentifier = ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
+                                                                                                                     pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
+                                                                                                  xEventCallbackParams.u.xPublishData.usTopicLength ];
+                usPacketIdentifier <<= mqttBITS_PER_BYTE;
+                usPacketIdentifier |= ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
+                                                                                                                      pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
+                                                                                                   xEventCallbackParams.u.xPublishData.usTopicLength +
+                                                                                                   ( uint16_t ) 1 /* Packet ID LSB follows MSB. */ ];
+
+                if( prvRecordReceivedQoS2Publish( pxMQTTContext, usPacketIdentifier, &xIsDuplicate ) == eMQTTTrue )
+                {
+                    prvSendQoS2Ack( pxMQTTContext, mqttCONTROL_PUBREC | mqttFLAGS_PUBREC, usPacketIdentifier );
+                    xDeliver = ( xIsDuplicate == eMQTTTrue ) ? eMQTTFalse : eMQTTTrue;
+                }
+                else
+                {
+                    /* Without a PUBREC the broker sends the message again. */
+                    mqttconfigDEBUG_LOG( ( "No room to record the QoS2 publish, dropping it.\r\n" ) );
+                    xDeliver = eMQTTFalse;
+                }
+            }
+        #endif /* mqttconfigENABLE_QOS2 */
+
         /* If the user chooses not to take the ownership of the buffer,
          * return it back to the free buffer pool. */
-        if( prvInvokeCallback( pxMQTTContext, &xEventCallbackParams ) == eMQTTFalse )
+        if( xDeliver == eMQTTFalse )
         {
             prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
         }
+        else if( prvInvokeCallback( pxMQTTContext, &xEventCallbackParams ) == eMQTTFalse )
+        {
+            prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
+        }
+        else
+        {
+            /* The user owns the buffer. */
+        }
     }
     else
     {
-        /* A publish packet with QoS2 is considered malformed and
-         * we disconnect. */
+        /* A publish packet with an unsupported QoS or invalid
+         * properties is considered malformed and we disconnect. */
         prvResetMQTTContext( pxMQTTContext );
 
         /* Inform user about the malformed packet received. */
@@ -1772,6 +2884,163 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_QOS2 == 1 )
+
+    static void prvProcessReceivedQoS2Ack( MQTTContext_t * pxMQTTContext )
+    {
+        MQTTBufferHandle_t xTxBuffer;
+        MQTTEventCallbackParams_t xEventCallbackParams;
+        uint8_t ucControlByte = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ];
+        uint16_t usPacketIdentifier;
+        uint32_t x;
+
+        /* PUBREC, PUBREL and PUBCOMP have the same layout as PUBACK. */
+        if( ( mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) >= ( ( uint32_t ) mqttFIXED_HEADER_MIN_SIZE + ( uint32_t ) mqttPUBACK_PACKET_IDENTIFER_LENGTH ) ) &&
+            ( ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_REMAINING_LENGTH_OFFSET ] == ( uint8_t ) mqttPUBACK_PACKET_IDENTIFER_LENGTH ) ||
+              ( mqttIS_MQTT5_ACK( pxMQTTContext, ucControlByte ) ) ) )
+        {
+            usPacketIdentifier = ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBACK_PACKET_ID_MSB_OFFSET,
+                                                                                                                 pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+            usPacketIdentifier <<= mqttBITS_PER_BYTE;
+            usPacketIdentifier |= ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBACK_PACKET_ID_LSB_OFFSET,
+                                                                                                                  pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+
+            if( ucControlByte == ( uint8_t ) ( mqttCONTROL_PUBREC | mqttFLAGS_PUBREC ) )
+            {
+                /* The publish was received by the broker. From now on only
+                 * the PUBREL needs to be sent again, so it replaces the
+                 * publish in the Tx buffer, which keeps its timeout. */
+                xTxBuffer = prvPacketTypeIdentifierGetTxBuffer( pxMQTTContext, mqttCONTROL_PUBLISH, usPacketIdentifier );
+
+                if( xTxBuffer != NULL )
+                {
+                    mqttbufferGET_DATA( xTxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] = mqttCONTROL_PUBREL | mqttFLAGS_PUBREL;
+                    mqttbufferGET_DATA( xTxBuffer )[ mqttFIXED_HEADER_REMAINING_LENGTH_OFFSET ] = ( uint8_t ) mqttPUBACK_PACKET_IDENTIFER_LENGTH;
+                    mqttbufferGET_DATA( xTxBuffer )[ mqttPUBACK_PACKET_ID_MSB_OFFSET ] = ( uint8_t ) ( usPacketIdentifier >> mqttBITS_PER_BYTE );
+                    mqttbufferGET_DATA( xTxBuffer )[ mqttPUBACK_PACKET_ID_LSB_OFFSET ] = ( uint8_t ) usPacketIdentifier;
+                    mqttbufferGET_DATA_LENGTH( xTxBuffer ) = ( uint32_t ) mqttFIXED_HEADER_MIN_SIZE + ( uint32_t ) mqttPUBACK_PACKET_IDENTIFER_LENGTH;
+                }
+
+                /* A repeated PUBREC is answered with the same PUBREL. */
+                if( ( xTxBuffer != NULL ) ||
+                    ( prvPacketTypeFlagsIdentifierGetTxBuffer( pxMQTTContext, mqttCONTROL_PUBREL, mqttFLAGS_PUBREL, usPacketIdentifier ) != NULL ) )
+                {
+                    prvSendQoS2Ack( pxMQTTContext, mqttCONTROL_PUBREL | mqttFLAGS_PUBREL, usPacketIdentifier );
+                }
+                else
+                {
+                    xEventCallbackParams.xEventType = eMQTTUnexpectedPubACK;
+                    ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+                }
+            }
+            else if( ucControlByte == ( uint8_t ) ( mqttCONTROL_PUBREL | mqttFLAGS_PUBREL ) )
+            {
+                /* The broker will not send this publish again, so forget it. */
+                for( x = 0; x < ( uint32_t ) mqttconfigQOS2_MAX_RECEIVED; x++ )
+                {
+                    if( pxMQTTContext->usQoS2Received[ x ] == usPacketIdentifier )
+                    {
+                        pxMQTTContext->usQoS2Received[ x ] = 0;
+                        break;
+                    }
+                }
+
+                /* The PUBCOMP is sent even for an unknown identifier, as the
+                 * previous PUBCOMP may have been lost. */
+                prvSendQoS2Ack( pxMQTTContext, mqttCONTROL_PUBCOMP | mqttFLAGS_PUBCOMP, usPacketIdentifier );
+            }
+            else
+            {
+                /* PUBCOMP completes the publish. */
+                xTxBuffer = prvPacketTypeFlagsIdentifierGetTxBuffer( pxMQTTContext, mqttCONTROL_PUBREL, mqttFLAGS_PUBREL, usPacketIdentifier );
+
+                if( xTxBuffer == NULL )
+                {
+                    xEventCallbackParams.xEventType = eMQTTUnexpectedPubACK;
+                    ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+                }
+                else
+                {
+                    xEventCallbackParams.xEventType = eMQTTPubACK;
+                    xEventCallbackParams.u.xMQTTPubACKData.usPacketIdentifier = usPacketIdentifier;
+
+                    #if ( mqttconfigENABLE_MQTT5 == 1 )
+                        xEventCallbackParams.u.xMQTTPubACKData.ucReasonCode = ( uint8_t ) 0;
+                    #endif /* mqttconfigENABLE_MQTT5 */
+                    ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+
+                    /* Return the Tx Buffer to the pool. */
+                    prvReturnBuffer( pxMQTTContext, xTxBuffer );
+                }
+            }
+        }
+        else
+        {
+            /* A malformed packet should result in disconnect. */
+            prvResetMQTTContext( pxMQTTContext );
+
+            /* Inform user about the malformed packet received. */
+            xEventCallbackParams.xEventType = eMQTTClientDisconnected;
+            xEventCallbackParams.u.xDisconnectData.xDisconnectReason = eMQTTDisconnectReasonMalformedPacket;
+            ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+        }
+
+        /* Return the RxBuffer to the free buffer pool. */
+        prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvSendQoS2Ack( MQTTContext_t * pxMQTTContext,
+                                uint8_t ucControlByte,
+                                uint16_t usPacketIdentifier )
+    {
+        uint8_t ucAckPacket[ mqttFIXED_HEADER_MIN_SIZE + mqttPUBACK_PACKET_IDENTIFER_LENGTH ];
+
+        ucAckPacket[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] = ucControlByte;
+        ucAckPacket[ mqttFIXED_HEADER_REMAINING_LENGTH_OFFSET ] = ( uint8_t ) mqttPUBACK_PACKET_IDENTIFER_LENGTH;
+        ucAckPacket[ mqttPUBACK_PACKET_ID_MSB_OFFSET ] = ( uint8_t ) ( usPacketIdentifier >> mqttBITS_PER_BYTE );
+        ucAckPacket[ mqttPUBACK_PACKET_ID_LSB_OFFSET ] = ( uint8_t ) usPacketIdentifier;
+
+        /* If the send fails, the broker sends its packet again. */
+        ( void ) prvSendData( pxMQTTContext, ucAckPacket, ( uint32_t ) sizeof( ucAckPacket ) );
+    }
+/*-----------------------------------------------------------*/
+
+    static MQTTBool_t prvRecordReceivedQoS2Publish( MQTTContext_t * pxMQTTContext,
+                                                    uint16_t usPacketIdentifier,
+                                                    MQTTBool_t * pxIsDuplicate )
+    {
+        uint32_t x, ulFree = ( uint32_t ) mqttconfigQOS2_MAX_RECEIVED;
+        MQTTBool_t xRecorded = eMQTTFalse;
+
+        *pxIsDuplicate = eMQTTFalse;
+
+        for( x = 0; x < ( uint32_t ) mqttconfigQOS2_MAX_RECEIVED; x++ )
+        {
+            if( pxMQTTContext->usQoS2Received[ x ] == usPacketIdentifier )
+            {
+                *pxIsDuplicate = eMQTTTrue;
+                xRecorded = eMQTTTrue;
+                break;
+            }
+            else if( ( pxMQTTContext->usQoS2Received[ x ] == ( uint16_t ) 0 ) && ( ulFree == ( uint32_t ) mqttconfigQOS2_MAX_RECEIVED ) )
+            {
+                ulFree = x;
+            }
+        }
+
+        if( ( xRecorded == eMQTTFalse ) && ( ulFree < ( uint32_t ) mqttconfigQOS2_MAX_RECEIVED ) )
+        {
+            pxMQTTContext->usQoS2Received[ ulFree ] = usPacketIdentifier;
+            xRecorded = eMQTTTrue;
+        }
+
+        return xRecorded;
+    }
+
+#endif /* mqttconfigENABLE_QOS2 */
+/*-----------------------------------------------------------*/
+
 static MQTTBool_t prvInvokeCallback( MQTTContext_t * pxMQTTContext,
                                      MQTTEventCallbackParams_t * pxEventCallbackParams )
 {
@@ -1980,18 +3249,41 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-    static MQTTBool_t prvStoreSubscription( MQTTContext_t * pxMQTTContext,
-                                            const uint8_t * const pucTopic,
-                                            uint16_t usTopicLength,
-                                            void * pvPublishCallbackContext,
-                                            MQTTPublishCallback_t pxPublishCallback )
+    static void prvResetSubscriptionManager( MQTTSubscriptionManager_t * pxSubscriptionManager )
+    {
+        uint32_t x;
+
+        /* Mark all the subscription entires in the subscription
+         * manager as free. */
+        for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
+        {
+            pxSubscriptionManager->xSubscriptions[ x ].xInUse = eMQTTFalse;
+        }
+
+        /* Set the number of in-use subscription entries to zero. */
+        pxSubscriptionManager->ulInUseSubscriptions = 0;
+
+        /* Empty the topic filter trie. */
+        prvTopicTrieInit( pxSubscriptionManager );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static MQTTReturnCode_t prvStoreSubscription( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                                  const uint8_t * const pucTopic,
+                                                  uint16_t usTopicLength,
+                                                  void * pvPublishCallbackContext,
+                                                  MQTTPublishCallback_t pxPublishCallback )
     {
         uint32_t x;
-        MQTTBool_t xSubscriptionStored = eMQTTFalse;
+        MQTTReturnCode_t xReturnCode = eMQTTSubscriptionManagerFull;
         MQTTTopicFilterType_t xTopicFilterType;
 
         /* Is there a free entry in the subscription manager? */
-        if( pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS )
+        if( pxSubscriptionManager->ulInUseSubscriptions < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS )
         {
             /* Check that the topic name is not too long. */
             if( usTopicLength <= ( uint16_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LENGTH )
@@ -1999,36 +3291,54 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                 /* Ensure that the topic is not invalid. */
                 xTopicFilterType = prvGetTopicFilterType( pucTopic, usTopicLength );
 
-                if( xTopicFilterType != eMQTTTopicFilterTypeInvalid )
+                if( ( xTopicFilterType != eMQTTTopicFilterTypeInvalid ) &&
+                    ( prvGetTopicLevelCount( pucTopic, usTopicLength ) > ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS ) )
+                {
+                    /* Each level takes a trie node, so deeper topic filters
+                     * are rejected like topics which are too long. */
+                    mqttconfigDEBUG_LOG( ( "WARN: Topic filter has too many levels to be stored in the subscription manager. Consider increasing mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LEVELS.\r\n" ) );
+                    xReturnCode = eMQTTTopicFilterTooManyLevels;
+                }
+                else if( xTopicFilterType != eMQTTTopicFilterTypeInvalid )
                 {
                     /* Ensure that subscription manager does not contain
                      * an entry for the topic filter already. */
-                    prvRemoveSubscription( pxMQTTContext, pucTopic, usTopicLength );
+                    ( void ) prvRemoveSubscription( pxSubscriptionManager, pucTopic, usTopicLength );
 
                     /* Find a free entry in the subscription manager. */
                     for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
                     {
-                        if( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse == eMQTTFalse )
+                        if( pxSubscriptionManager->xSubscriptions[ x ].xInUse == eMQTTFalse )
                         {
                             /* Found a free entry. Mark it as used and
                              * store the subscription. */
-                            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse = eMQTTTrue;
+                            pxSubscriptionManager->xSubscriptions[ x ].xInUse = eMQTTTrue;
 
                             /* Store the subscription. */
-                            memcpy( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].ucTopicFilter,
+                            memcpy( pxSubscriptionManager->xSubscriptions[ x ].ucTopicFilter,
                                     pucTopic,
                                     usTopicLength );
-                            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].usTopicFilterLength = usTopicLength;
-                            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].pvPublishCallbackContext = pvPublishCallbackContext;
-                            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].pxPublishCallback = pxPublishCallback;
-                            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xTopicFilterType = xTopicFilterType;
+                            pxSubscriptionManager->xSubscriptions[ x ].usTopicFilterLength = usTopicLength;
+                            pxSubscriptionManager->xSubscriptions[ x ].pvPublishCallbackContext = pvPublishCallbackContext;
+                            pxSubscriptionManager->xSubscriptions[ x ].pxPublishCallback = pxPublishCallback;
+                            pxSubscriptionManager->xSubscriptions[ x ].xTopicFilterType = xTopicFilterType;
 
-                            /* Increase the in-use subscription entries count. */
-                            pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions += ( uint32_t ) 1;
+                            /* Index the topic filter. */
+                            if( prvTopicTrieInsert( pxSubscriptionManager, ( uint16_t ) x ) == eMQTTTrue )
+                            {
+                                /* Increase the in-use subscription entries count. */
+                                pxSubscriptionManager->ulInUseSubscriptions += ( uint32_t ) 1;
 
-                            /* Inform the user that the subscription was stored
-                             * successfully. */
-                            xSubscriptionStored = eMQTTTrue;
+                                /* Inform the user that the subscription was stored
+                                 * successfully. */
+                                xReturnCode = eMQTTSuccess;
+                            }
+                            else
+                            {
+                                /* Not enough trie nodes, release the entry. */
+                                pxSubscriptionManager->xSubscriptions[ x ].xInUse = eMQTTFalse;
+                                mqttconfigDEBUG_LOG( ( "WARN: Subscription Manager trie full! Consider increasing mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES.\r\n" ) );
+                            }
 
                             /* Done. */
                             break;
@@ -2053,7 +3363,7 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
             mqttconfigDEBUG_LOG( ( "WARN: Subscription Manager full! No space left to store new subscriptions.\r\n" ) );
         }
 
-        return xSubscriptionStored;
+        return xReturnCode;
     }
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -2061,34 +3371,40 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-    static void prvRemoveSubscription( MQTTContext_t * pxMQTTContext,
-                                       const uint8_t * const pucTopic,
-                                       uint16_t usTopicLength )
+    static MQTTBool_t prvRemoveSubscription( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                             const uint8_t * const pucTopic,
+                                             uint16_t usTopicLength )
     {
         uint32_t x;
+        MQTTBool_t xSubscriptionRemoved = eMQTTFalse;
 
         /* Iterate over all the subscription entries in
          * the subscription manager and try to find the
          * matching one. */
         for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
         {
-            if( ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse == eMQTTTrue ) &&
-                ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].usTopicFilterLength == usTopicLength ) )
+            if( ( pxSubscriptionManager->xSubscriptions[ x ].xInUse == eMQTTTrue ) &&
+                ( pxSubscriptionManager->xSubscriptions[ x ].usTopicFilterLength == usTopicLength ) )
             {
-                if( memcmp( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].ucTopicFilter, pucTopic, usTopicLength ) == 0 )
+                if( memcmp( pxSubscriptionManager->xSubscriptions[ x ].ucTopicFilter, pucTopic, usTopicLength ) == 0 )
                 {
-                    /* Found a matching subscription, mark it as free. */
-                    pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse = eMQTTFalse;
+                    /* Found a matching subscription, remove it from the
+                     * trie and mark it as free. */
+                    prvTopicTrieRemove( pxSubscriptionManager, ( uint16_t ) x );
+                    pxSubscriptionManager->xSubscriptions[ x ].xInUse = eMQTTFalse;
 
                     /* Reduce the count of in-use subscription entries
                      * in the subscription manager. */
-                    pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions -= ( uint32_t ) 1;
+                    pxSubscriptionManager->ulInUseSubscriptions -= ( uint32_t ) 1;
+                    xSubscriptionRemoved = eMQTTTrue;
 
                     /* Done. */
                     break;
                 }
             }
         }
+
+        return xSubscriptionRemoved;
     }
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -2115,16 +3431,16 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
          * happens to be at the same offset in both subscribe
          * and unsubscribe message and therefore there is no need
          * to repeat the same code with different #defines. */
-        usTopicLength = ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET,
+        usTopicLength = ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET + mqttPROPERTIES_LENGTH( pxMQTTContext ),
                                                                                         ucRemaingingLengthFieldBytes ) ] );
         usTopicLength <<= mqttBITS_PER_BYTE;
-        usTopicLength |= ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( ( mqttSUBSCRIBE_TOPIC_OFFSET + 1 ),
+        usTopicLength |= ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( ( mqttSUBSCRIBE_TOPIC_OFFSET + 1 ) + mqttPROPERTIES_LENGTH( pxMQTTContext ),
                                                                                          ucRemaingingLengthFieldBytes ) ] );
 
         /* Remove the subscription entry from the subscription manager. */
-        prvRemoveSubscription( pxMQTTContext,
-                               &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( ( mqttSUBSCRIBE_TOPIC_OFFSET + 2 ), ucRemaingingLengthFieldBytes ) ] ),
-                               usTopicLength );
+        ( void ) prvRemoveSubscription( &( pxMQTTContext->xSubscriptionManager ),
+                                        &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( ( mqttSUBSCRIBE_TOPIC_OFFSET + 2 ) + mqttPROPERTIES_LENGTH( pxMQTTContext ), ucRemaingingLengthFieldBytes ) ] ),
+                                        usTopicLength );
     }
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 /*-----------------------------------------------------------*/
@@ -2137,87 +3453,53 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
     {
         MQTTBool_t xBufferOwnershipTaken = eMQTTFalse;
         MQTTSubscription_t * pxSubscription;
-        uint32_t x;
+        MQTTTopicFilterType_t xTopicFilterType = eMQTTTopicFilterTypeSimple;
+        uint32_t x, ulMatches;
 
         /* Set the output parameter to eMQTTFalse. It will
          * be set to eMQTTTrue if any callback is invoked. */
         *pxSubscriptionCallbackInvoked = eMQTTFalse;
 
-        /* Iterate over the subscription entries containing topic filters
-         * without any wild-cards and invoke the registered callbacks. */
-        for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
+        /* Find all the matching subscriptions up front so that the
+         * callbacks are free to change the subscriptions. */
+        ulMatches = prvTopicTrieMatch( &( pxMQTTContext->xSubscriptionManager ), pxPublishData->pucTopic, pxPublishData->usTopicLength );
+
+        /* Invoke the callbacks of the matching entries containing topic
+         * filters without any wild-cards first and then the ones of the
+         * entries containing topic filters with wild-cards. */
+        for( ; ; )
         {
-            if( ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse == eMQTTTrue ) &&
-                ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xTopicFilterType == eMQTTTopicFilterTypeSimple ) &&
-                ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].usTopicFilterLength == pxPublishData->usTopicLength ) )
+            for( x = 0; x < ulMatches; x++ )
             {
-                if( memcmp( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].ucTopicFilter, pxPublishData->pucTopic, pxPublishData->usTopicLength ) == 0 )
-                {
-                    /* Found a matching subscription. */
-                    pxSubscription = &( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ] );
+                pxSubscription = &( pxMQTTContext->xSubscriptionManager.xSubscriptions[ pxMQTTContext->xSubscriptionManager.usTrieMatches[ x ] ] );
 
-                    /* If a callback is registered with the subscription,
-                     * invoke it. */
-                    if( pxSubscription->pxPublishCallback != NULL )
-                    {
-                        /* Note that a callback was invoked. */
-                        *pxSubscriptionCallbackInvoked = eMQTTTrue;
+                /* If a callback is registered with the subscription,
+                 * invoke it. */
+                if( ( pxSubscription->xInUse == eMQTTTrue ) &&
+                    ( pxSubscription->xTopicFilterType == xTopicFilterType ) &&
+                    ( pxSubscription->pxPublishCallback != NULL ) )
+                {
+                    /* Note that a callback was invoked. */
+                    *pxSubscriptionCallbackInvoked = eMQTTTrue;
 
-                        /* Invoke callback. */
-                        xBufferOwnershipTaken = pxSubscription->pxPublishCallback( pxSubscription->pvPublishCallbackContext, pxPublishData );
+                    /* Invoke callback. */
+                    xBufferOwnershipTaken = pxSubscription->pxPublishCallback( pxSubscription->pvPublishCallbackContext, pxPublishData );
 
-                        /* If the user takes the buffer ownership, do
-                         * not invoke any other callbacks. */
-                        if( xBufferOwnershipTaken == eMQTTTrue )
-                        {
-                            break;
-                        }
+                    /* If the user takes the buffer ownership, do
+                     * not invoke any other callbacks. */
+                    if( xBufferOwnershipTaken == eMQTTTrue )
+                    {
+                        break;
                     }
                 }
             }
-        }
 
-        /* If the user has not taken the buffer ownership yet (which can
-         * happen if there is no exact matching entry in the subscription
-         * manager or the user does not take the ownership in the callback),
-         * iterate over the subscription entries containing topic filters
-         * with wild-cards and invoke the registered callbacks for the ones
-         * which match the topic. */
-        if( xBufferOwnershipTaken == eMQTTFalse )
-        {
-            for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
+            if( ( xBufferOwnershipTaken == eMQTTTrue ) || ( xTopicFilterType == eMQTTTopicFilterTypeWildCard ) )
             {
-                if( ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse == eMQTTTrue ) &&
-                    ( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xTopicFilterType == eMQTTTopicFilterTypeWildCard ) )
-                {
-                    if( prvDoesTopicMatchTopicFilter( pxPublishData->pucTopic,
-                                                      pxPublishData->usTopicLength,
-                                                      pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].ucTopicFilter,
-                                                      pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].usTopicFilterLength ) == eMQTTTrue )
-                    {
-                        /* Found a matching subscription. */
-                        pxSubscription = &( pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ] );
-
-                        /* If a callback is registered with the subscription,
-                         * invoke it. */
-                        if( pxSubscription->pxPublishCallback != NULL )
-                        {
-                            /* Note that a callback was invoked. */
-                            *pxSubscriptionCallbackInvoked = eMQTTTrue;
-
-                            /* Invoke callback. */
-                            xBufferOwnershipTaken = pxSubscription->pxPublishCallback( pxSubscription->pvPublishCallbackContext, pxPublishData );
-
-                            /* If the user takes the buffer ownership, do
-                             * not invoke any other callbacks. */
-                            if( xBufferOwnershipTaken == eMQTTTrue )
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
+                break;
             }
+
+            xTopicFilterType = eMQTTTopicFilterTypeWildCard;
         }
 
         /* Return whether or not the user has taken the
@@ -2299,22 +3581,387 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                         break;
                     }
                 }
-                else
+                else
+                {
+                    /* If '#' is not the first character and the preceding
+                     * character is not '/', then it is not a valid topic
+                     * filter. */
+                    xTopicFilterType = eMQTTTopicFilterTypeInvalid;
+                    break;
+                }
+            }
+            else
+            {
+                /* Any character other than '+' and '#' is okay. */
+            }
+        }
+
+        return xTopicFilterType;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && defined( AMAZON_FREERTOS_ENABLE_UNIT_TESTS )
+
+    static MQTTBool_t prvDoesTopicMatchTopicFilter( const uint8_t * const pucTopic,
+                                                    uint16_t usTopicLength,
+                                                    const uint8_t * const pucTopicFilter,
+                                                    uint16_t usTopicFilterLength )
+    {
+        MQTTBool_t xTopicMatchesTopicFilter = eMQTTFalse;
+        uint16_t usTopicIndex = 0, usTopicFilterIndex = 0;
+
+        while( ( usTopicIndex < usTopicLength ) && ( usTopicFilterIndex < usTopicFilterLength ) )
+        {
+            /* Does the character in the topic string matches the
+             * corresponding one in the topic filter string? */
+            if( pucTopic[ usTopicIndex ] == pucTopicFilter[ usTopicFilterIndex ] )
+            {
+                /* Handle special corner cases as documented by
+                 * the MQTT protocol spec. */
+
+                /* Filter of type "sport/#" also matches the singular
+                 * "sport" since # includes the parent level. */
+                if( ( usTopicIndex == usTopicLength - ( uint16_t ) 1 ) &&
+                    ( usTopicFilterIndex == usTopicFilterLength - ( uint16_t ) 3 ) &&
+                    ( pucTopicFilter[ usTopicFilterIndex + ( uint16_t ) 1 ] == ( uint8_t ) '/' ) &&
+                    ( pucTopicFilter[ usTopicFilterIndex + ( uint16_t ) 2 ] == ( uint8_t ) '#' ) )
+                {
+                    xTopicMatchesTopicFilter = eMQTTTrue;
+                    break;
+                }
+
+                /* Filter of type "sport/+" also matches the "sport/"
+                 * but not "sport". */
+                if( ( usTopicIndex == usTopicLength - ( uint16_t ) 1 ) &&
+                    ( usTopicFilterIndex == usTopicFilterLength - ( uint16_t ) 2 ) &&
+                    ( pucTopicFilter[ usTopicFilterIndex + ( uint16_t ) 1 ] == ( uint8_t ) '+' ) )
+                {
+                    xTopicMatchesTopicFilter = eMQTTTrue;
+                    break;
+                }
+            }
+            else
+            {
+                if( pucTopicFilter[ usTopicFilterIndex ] == ( uint8_t ) '+' )
+                {
+                    /* Consume the current topic level which is until
+                     * we encounter '/' in the topic string or the end
+                     * of the topic string. */
+                    while( usTopicIndex < usTopicLength && pucTopic[ usTopicIndex ] != ( uint8_t ) '/' )
+                    {
+                        usTopicIndex++;
+                    }
+
+                    /* Since we are already at the '/' character or at
+                     * the end in the topic string, increment the topic
+                     * filter index here and skip the index increments
+                     * at the end of the loop. */
+                    usTopicFilterIndex++;
+                    continue;
+                }
+                else if( pucTopicFilter[ usTopicFilterIndex ] == ( uint8_t ) '#' )
+                {
+                    /* Since it is assumed that the given topic filter
+                     * is a valid topic filter, this must be the last
+                     * character in it. The rest of the topic string
+                     * matches this multi-level wild-card and hence this
+                     * is a match. */
+                    xTopicMatchesTopicFilter = eMQTTTrue;
+                    break;
+                }
+                else
+                {
+                    /* Any character mismatch other than '+' or
+                     * '#' means the topic does not match the
+                     * given filter. */
+                    break;
+                }
+            }
+
+            /* Increment indexes. */
+            usTopicIndex++;
+            usTopicFilterIndex++;
+        }
+
+        /* If the topic is not matched yet and both topic
+         * and topic filter strings are consumed, it's a match
+         * else we would have broken the loop in between.*/
+        if( ( xTopicMatchesTopicFilter == eMQTTFalse ) &&
+            ( ( usTopicIndex > ( uint16_t ) 0 ) && ( usTopicIndex >= usTopicLength ) ) &&
+            ( ( usTopicFilterIndex > ( uint16_t ) 0 ) && ( usTopicFilterIndex >= usTopicFilterLength ) ) )
+        {
+            xTopicMatchesTopicFilter = eMQTTTrue;
+        }
+
+        /* Return the result. */
+        return xTopicMatchesTopicFilter;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && AMAZON_FREERTOS_ENABLE_UNIT_TESTS */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint16_t prvGetTopicLevelLength( const uint8_t * const pucTopic,
+                                            uint16_t usTopicLength,
+                                            uint16_t usLevelOffset )
+    {
+        uint16_t usLevelEnd = usLevelOffset;
+
+        /* A level extends until the next '/' or the end of the topic. */
+        while( ( usLevelEnd < usTopicLength ) && ( pucTopic[ usLevelEnd ] != ( uint8_t ) '/' ) )
+        {
+            usLevelEnd++;
+        }
+
+        return ( uint16_t ) ( usLevelEnd - usLevelOffset );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint32_t prvGetTopicLevelCount( const uint8_t * const pucTopic,
+                                           uint16_t usTopicLength )
+    {
+        uint32_t ulLevels = 1;
+        uint16_t x;
+
+        for( x = 0; x < usTopicLength; x++ )
+        {
+            if( pucTopic[ x ] == ( uint8_t ) '/' )
+            {
+                ulLevels++;
+            }
+        }
+
+        return ulLevels;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static const uint8_t * prvGetTopicTrieNodeLevel( const MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                                     uint16_t usNode )
+    {
+        const MQTTTopicTrieNode_t * pxNode = &( pxSubscriptionManager->xTrieNodes[ usNode ] );
+
+        return &( pxSubscriptionManager->xSubscriptions[ pxNode->usSource ].ucTopicFilter[ pxNode->usLevelOffset ] );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static uint16_t prvFindTopicTrieChild( const MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                           uint16_t usParent,
+                                           const uint8_t * const pucLevel,
+                                           uint16_t usLevelLength )
+    {
+        uint16_t usChild = pxSubscriptionManager->xTrieNodes[ usParent ].usFirstChild;
+
+        /* Wild-cards are stored as the level strings "+" and "#", so
+         * comparing the level strings is enough to find them too. */
+        while( usChild != mqttTOPIC_TRIE_NONE )
+        {
+            if( ( pxSubscriptionManager->xTrieNodes[ usChild ].usLevelLength == usLevelLength ) &&
+                ( memcmp( prvGetTopicTrieNodeLevel( pxSubscriptionManager, usChild ), pucLevel, usLevelLength ) == 0 ) )
+            {
+                break;
+            }
+
+            usChild = pxSubscriptionManager->xTrieNodes[ usChild ].usNextSibling;
+        }
+
+        return usChild;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static void prvTopicTrieInit( MQTTSubscriptionManager_t * pxSubscriptionManager )
+    {
+        uint16_t x;
+
+        /* Link all the nodes except the root into the free list. */
+        for( x = 1; x < ( uint16_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES; x++ )
+        {
+            pxSubscriptionManager->xTrieNodes[ x ].usNextSibling = ( uint16_t ) ( x + ( uint16_t ) 1 );
+        }
+
+        pxSubscriptionManager->xTrieNodes[ mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES - 1 ].usNextSibling = mqttTOPIC_TRIE_NONE;
+        pxSubscriptionManager->usFreeTrieNode = ( mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES > 1 ) ? ( uint16_t ) 1 : mqttTOPIC_TRIE_NONE;
+        pxSubscriptionManager->usFreeTrieNodes = ( uint16_t ) ( mqttconfigSUBSCRIPTION_MANAGER_MAX_TRIE_NODES - 1 );
+
+        /* The root node represents the empty prefix and has no level string. */
+        pxSubscriptionManager->xTrieNodes[ mqttTOPIC_TRIE_ROOT ].usSubscription = mqttTOPIC_TRIE_NONE;
+        pxSubscriptionManager->xTrieNodes[ mqttTOPIC_TRIE_ROOT ].usFirstChild = mqttTOPIC_TRIE_NONE;
+        pxSubscriptionManager->xTrieNodes[ mqttTOPIC_TRIE_ROOT ].usNextSibling = mqttTOPIC_TRIE_NONE;
+        pxSubscriptionManager->xTrieNodes[ mqttTOPIC_TRIE_ROOT ].usRefCount = 0;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static MQTTBool_t prvTopicTrieInsert( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                          uint16_t usSubscription )
+    {
+        MQTTBool_t xInserted = eMQTTFalse;
+        const MQTTSubscription_t * pxSubscription = &( pxSubscriptionManager->xSubscriptions[ usSubscription ] );
+        MQTTTopicTrieNode_t * pxNode;
+        uint16_t usNode = mqttTOPIC_TRIE_ROOT, usChild, usLevelOffset = 0, usLevelLength, usMissingNodes = 0;
+
+        /* Count the levels which are not in the trie yet. Once a level
+         * is missing, all the following ones are missing too. */
+        do
+        {
+            usLevelLength = prvGetTopicLevelLength( pxSubscription->ucTopicFilter, pxSubscription->usTopicFilterLength, usLevelOffset );
+
+            if( usNode != mqttTOPIC_TRIE_NONE )
+            {
+                usNode = prvFindTopicTrieChild( pxSubscriptionManager, usNode, &( pxSubscription->ucTopicFilter[ usLevelOffset ] ), usLevelLength );
+            }
+
+            if( usNode == mqttTOPIC_TRIE_NONE )
+            {
+                usMissingNodes++;
+            }
+
+            usLevelOffset = ( uint16_t ) ( usLevelOffset + usLevelLength + ( uint16_t ) 1 );
+        } while( usLevelOffset <= pxSubscription->usTopicFilterLength );
+
+        if( usMissingNodes <= pxSubscriptionManager->usFreeTrieNodes )
+        {
+            usNode = mqttTOPIC_TRIE_ROOT;
+            usLevelOffset = 0;
+
+            do
+            {
+                usLevelLength = prvGetTopicLevelLength( pxSubscription->ucTopicFilter, pxSubscription->usTopicFilterLength, usLevelOffset );
+                usChild = prvFindTopicTrieChild( pxSubscriptionManager, usNode, &( pxSubscription->ucTopicFilter[ usLevelOffset ] ), usLevelLength );
+
+                if( usChild == mqttTOPIC_TRIE_NONE )
+                {
+                    /* Take a node from the free list and make it the first
+                     * child of the current node. */
+                    usChild = pxSubscriptionManager->usFreeTrieNode;
+                    pxNode = &( pxSubscriptionManager->xTrieNodes[ usChild ] );
+                    pxSubscriptionManager->usFreeTrieNode = pxNode->usNextSibling;
+                    pxSubscriptionManager->usFreeTrieNodes--;
+
+                    pxNode->usSubscription = mqttTOPIC_TRIE_NONE;
+                    pxNode->usSource = usSubscription;
+                    pxNode->usLevelOffset = usLevelOffset;
+                    pxNode->usLevelLength = usLevelLength;
+                    pxNode->usFirstChild = mqttTOPIC_TRIE_NONE;
+                    pxNode->usRefCount = 0;
+                    pxNode->usNextSibling = pxSubscriptionManager->xTrieNodes[ usNode ].usFirstChild;
+                    pxSubscriptionManager->xTrieNodes[ usNode ].usFirstChild = usChild;
+                }
+
+                usNode = usChild;
+                pxSubscriptionManager->xTrieNodes[ usNode ].usRefCount++;
+
+                usLevelOffset = ( uint16_t ) ( usLevelOffset + usLevelLength + ( uint16_t ) 1 );
+            } while( usLevelOffset <= pxSubscription->usTopicFilterLength );
+
+            /* The topic filter ends at the last node. */
+            pxSubscriptionManager->xTrieNodes[ usNode ].usSubscription = usSubscription;
+            xInserted = eMQTTTrue;
+        }
+
+        return xInserted;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    static void prvTopicTrieRemove( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                    uint16_t usSubscription )
+    {
+        const MQTTSubscription_t * pxSubscription = &( pxSubscriptionManager->xSubscriptions[ usSubscription ] );
+        MQTTTopicTrieNode_t * pxNode;
+        uint16_t usNode = mqttTOPIC_TRIE_ROOT, usParent, usLevelOffset = 0, usLevelLength, usDepth = 0;
+        uint16_t * pusLink;
+
+        /* Record the path of the topic filter. */
+        do
+        {
+            usLevelLength = prvGetTopicLevelLength( pxSubscription->ucTopicFilter, pxSubscription->usTopicFilterLength, usLevelOffset );
+            usNode = prvFindTopicTrieChild( pxSubscriptionManager, usNode, &( pxSubscription->ucTopicFilter[ usLevelOffset ] ), usLevelLength );
+
+            /* The topic filter was added to the trie when the subscription
+             * was stored. */
+            mqttconfigASSERT( usNode != mqttTOPIC_TRIE_NONE );
+
+            pxSubscriptionManager->usTrieStack[ usDepth ] = usNode;
+            usDepth++;
+
+            usLevelOffset = ( uint16_t ) ( usLevelOffset + usLevelLength + ( uint16_t ) 1 );
+        } while( usLevelOffset <= pxSubscription->usTopicFilterLength );
+
+        pxSubscriptionManager->xTrieNodes[ usNode ].usSubscription = mqttTOPIC_TRIE_NONE;
+
+        /* Walk the path bottom up so that the reference counts of the
+         * deeper nodes are already up to date. */
+        while( usDepth > ( uint16_t ) 0 )
+        {
+            usDepth--;
+            usNode = pxSubscriptionManager->usTrieStack[ usDepth ];
+            usParent = ( usDepth > ( uint16_t ) 0 ) ? pxSubscriptionManager->usTrieStack[ usDepth - ( uint16_t ) 1 ] : ( uint16_t ) mqttTOPIC_TRIE_ROOT;
+            pxNode = &( pxSubscriptionManager->xTrieNodes[ usNode ] );
+
+            pxNode->usRefCount--;
+
+            if( pxNode->usRefCount == ( uint16_t ) 0 )
+            {
+                /* No other subscription passes through this node. Unlink it
+                 * from its parent and return it to the free list. */
+                pusLink = &( pxSubscriptionManager->xTrieNodes[ usParent ].usFirstChild );
+
+                while( *pusLink != usNode )
+                {
+                    pusLink = &( pxSubscriptionManager->xTrieNodes[ *pusLink ].usNextSibling );
+                }
+
+                *pusLink = pxNode->usNextSibling;
+
+                pxNode->usNextSibling = pxSubscriptionManager->usFreeTrieNode;
+                pxSubscriptionManager->usFreeTrieNode = usNode;
+                pxSubscriptionManager->usFreeTrieNodes++;
+            }
+            else if( pxNode->usSource == usSubscription )
+            {
+                /* The level string must be read from another subscription
+                 * passing through this node. Every node still in use either
+                 * ends a topic filter or has a child in use, so descend until
+                 * one is found. */
+                while( pxSubscriptionManager->xTrieNodes[ usNode ].usSubscription == mqttTOPIC_TRIE_NONE )
                 {
-                    /* If '#' is not the first character and the preceding
-                     * character is not '/', then it is not a valid topic
-                     * filter. */
-                    xTopicFilterType = eMQTTTopicFilterTypeInvalid;
-                    break;
+                    usNode = pxSubscriptionManager->xTrieNodes[ usNode ].usFirstChild;
+                    mqttconfigASSERT( usNode != mqttTOPIC_TRIE_NONE );
                 }
+
+                pxNode->usSource = pxSubscriptionManager->xTrieNodes[ usNode ].usSubscription;
             }
             else
             {
-                /* Any character other than '+' and '#' is okay. */
+                /* The node is still in use and its level string is
+                 * unaffected. */
             }
         }
-
-        return xTopicFilterType;
     }
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -2322,99 +3969,86 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-    static MQTTBool_t prvDoesTopicMatchTopicFilter( const uint8_t * const pucTopic,
-                                                    uint16_t usTopicLength,
-                                                    const uint8_t * const pucTopicFilter,
-                                                    uint16_t usTopicFilterLength )
+    static uint32_t prvTopicTrieMatch( MQTTSubscriptionManager_t * pxSubscriptionManager,
+                                       const uint8_t * const pucTopic,
+                                       uint16_t usTopicLength )
     {
-        MQTTBool_t xTopicMatchesTopicFilter = eMQTTFalse;
-        uint16_t usTopicIndex = 0, usTopicFilterIndex = 0;
-
-        while( ( usTopicIndex < usTopicLength ) && ( usTopicFilterIndex < usTopicFilterLength ) )
+        const MQTTTopicTrieNode_t * pxChild;
+        uint32_t ulMatches = 0, ulStackDepth = 0;
+        uint16_t usNode, usChild, usLevelOffset, usLevelLength, usNextLevelOffset;
+        const uint8_t * pucChildLevel;
+
+        /* Each node can only be reached along one path, so every node is
+         * pushed at most once and the stack cannot overflow. */
+        pxSubscriptionManager->usTrieStack[ 0 ] = mqttTOPIC_TRIE_ROOT;
+        pxSubscriptionManager->usTrieStackOffsets[ 0 ] = 0;
+        ulStackDepth = 1;
+
+        while( ulStackDepth > ( uint32_t ) 0 )
         {
-            /* Does the character in the topic string matches the
-             * corresponding one in the topic filter string? */
-            if( pucTopic[ usTopicIndex ] == pucTopicFilter[ usTopicFilterIndex ] )
-            {
-                /* Handle special corner cases as documented by
-                 * the MQTT protocol spec. */
+            ulStackDepth--;
+            usNode = pxSubscriptionManager->usTrieStack[ ulStackDepth ];
+            usLevelOffset = pxSubscriptionManager->usTrieStackOffsets[ ulStackDepth ];
 
-                /* Filter of type "sport/#" also matches the singular
-                 * "sport" since # includes the parent level. */
-                if( ( usTopicIndex == usTopicLength - ( uint16_t ) 1 ) &&
-                    ( usTopicFilterIndex == usTopicFilterLength - ( uint16_t ) 3 ) &&
-                    ( pucTopicFilter[ usTopicFilterIndex + ( uint16_t ) 1 ] == ( uint8_t ) '/' ) &&
-                    ( pucTopicFilter[ usTopicFilterIndex + ( uint16_t ) 2 ] == ( uint8_t ) '#' ) )
+            if( usLevelOffset > usTopicLength )
+            {
+                /* All the topic levels have been matched. The topic filter
+                 * ending here matches and so does a trailing "/#", since '#'
+                 * includes the parent level. */
+                if( pxSubscriptionManager->xTrieNodes[ usNode ].usSubscription != mqttTOPIC_TRIE_NONE )
                 {
-                    xTopicMatchesTopicFilter = eMQTTTrue;
-                    break;
+                    pxSubscriptionManager->usTrieMatches[ ulMatches ] = pxSubscriptionManager->xTrieNodes[ usNode ].usSubscription;
+                    ulMatches++;
                 }
 
-                /* Filter of type "sport/+" also matches the "sport/"
-                 * but not "sport". */
-                if( ( usTopicIndex == usTopicLength - ( uint16_t ) 1 ) &&
-                    ( usTopicFilterIndex == usTopicFilterLength - ( uint16_t ) 2 ) &&
-                    ( pucTopicFilter[ usTopicFilterIndex + ( uint16_t ) 1 ] == ( uint8_t ) '+' ) )
+                usChild = prvFindTopicTrieChild( pxSubscriptionManager, usNode, ( const uint8_t * ) "#", ( uint16_t ) 1 );
+
+                if( ( usChild != mqttTOPIC_TRIE_NONE ) &&
+                    ( pxSubscriptionManager->xTrieNodes[ usChild ].usSubscription != mqttTOPIC_TRIE_NONE ) )
                 {
-                    xTopicMatchesTopicFilter = eMQTTTrue;
-                    break;
+                    pxSubscriptionManager->usTrieMatches[ ulMatches ] = pxSubscriptionManager->xTrieNodes[ usChild ].usSubscription;
+                    ulMatches++;
                 }
             }
             else
             {
-                if( pucTopicFilter[ usTopicFilterIndex ] == ( uint8_t ) '+' )
+                usLevelLength = prvGetTopicLevelLength( pucTopic, usTopicLength, usLevelOffset );
+                usNextLevelOffset = ( uint16_t ) ( usLevelOffset + usLevelLength + ( uint16_t ) 1 );
+
+                for( usChild = pxSubscriptionManager->xTrieNodes[ usNode ].usFirstChild;
+                     usChild != mqttTOPIC_TRIE_NONE;
+                     usChild = pxChild->usNextSibling )
                 {
-                    /* Consume the current topic level which is until
-                     * we encounter '/' in the topic string or the end
-                     * of the topic string. */
-                    while( usTopicIndex < usTopicLength && pucTopic[ usTopicIndex ] != ( uint8_t ) '/' )
+                    pxChild = &( pxSubscriptionManager->xTrieNodes[ usChild ] );
+                    pucChildLevel = prvGetTopicTrieNodeLevel( pxSubscriptionManager, usChild );
+
+                    if( ( pxChild->usLevelLength == ( uint16_t ) 1 ) && ( pucChildLevel[ 0 ] == ( uint8_t ) '#' ) )
                     {
-                        usTopicIndex++;
+                        /* '#' matches all the remaining levels. */
+                        if( pxChild->usSubscription != mqttTOPIC_TRIE_NONE )
+                        {
+                            pxSubscriptionManager->usTrieMatches[ ulMatches ] = pxChild->usSubscription;
+                            ulMatches++;
+                        }
+                    }
+                    else if( ( ( pxChild->usLevelLength == ( uint16_t ) 1 ) && ( pucChildLevel[ 0 ] == ( uint8_t ) '+' ) ) ||
+                             ( ( pxChild->usLevelLength == usLevelLength ) && ( memcmp( pucChildLevel, &( pucTopic[ usLevelOffset ] ), usLevelLength ) == 0 ) ) )
+                    {
+                        /* '+' or the same level string. Continue with the
+                         * next topic level. */
+                        pxSubscriptionManager->usTrieStack[ ulStackDepth ] = usChild;
+                        pxSubscriptionManager->usTrieStackOffsets[ ulStackDepth ] = usNextLevelOffset;
+                        ulStackDepth++;
+                    }
+                    else
+                    {
+                        /* This level does not match. */
                     }
-
-                    /* Since we are already at the '/' character or at
-                     * the end in the topic string, increment the topic
-                     * filter index here and skip the index increments
-                     * at the end of the loop. */
-                    usTopicFilterIndex++;
-                    continue;
-                }
-                else if( pucTopicFilter[ usTopicFilterIndex ] == ( uint8_t ) '#' )
-                {
-                    /* Since it is assumed that the given topic filter
-                     * is a valid topic filter, this must be the last
-                     * character in it. The rest of the topic string
-                     * matches this multi-level wild-card and hence this
-                     * is a match. */
-                    xTopicMatchesTopicFilter = eMQTTTrue;
-                    break;
-                }
-                else
-                {
-                    /* Any character mismatch other than '+' or
-                     * '#' means the topic does not match the
-                     * given filter. */
-                    break;
                 }
             }
-
-            /* Increment indexes. */
-            usTopicIndex++;
-            usTopicFilterIndex++;
         }
 
-        /* If the topic is not matched yet and both topic
-         * and topic filter strings are consumed, it's a match
-         * else we would have broken the loop in between.*/
-        if( ( xTopicMatchesTopicFilter == eMQTTFalse ) &&
-            ( ( usTopicIndex > ( uint16_t ) 0 ) && ( usTopicIndex >= usTopicLength ) ) &&
-            ( ( usTopicFilterIndex > ( uint16_t ) 0 ) && ( usTopicFilterIndex >= usTopicFilterLength ) ) )
-        {
-            xTopicMatchesTopicFilter = eMQTTTrue;
-        }
-
-        /* Return the result. */
-        return xTopicMatchesTopicFilter;
+        return ulMatches;
     }
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -2423,10 +4057,6 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 MQTTReturnCode_t MQTT_Init( MQTTContext_t * pxMQTTContext,
                             const MQTTInitParams_t * const pxInitParams )
 {
-    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
-        uint32_t x;
-    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
-
     /* These are checked here once and are later used without
      * NULL checks. */
     mqttconfigASSERT( pxMQTTContext != NULL );
@@ -2451,6 +4081,7 @@ MQTTReturnCode_t MQTT_Init( MQTTContext_t * pxMQTTContext,
     /* Store send context and function. */
     pxMQTTContext->pvSendContext = pxInitParams->pvSendContext;
     pxMQTTContext->pxMQTTSendFxn = pxInitParams->pxMQTTSendFxn;
+    pxMQTTContext->pxMQTTSendVFxn = pxInitParams->pxMQTTSendVFxn;
 
     /* Store get ticks function. */
     pxMQTTContext->pxGetTicksFxn = pxInitParams->pxGetTicksFxn;
@@ -2459,17 +4090,24 @@ MQTTReturnCode_t MQTT_Init( MQTTContext_t * pxMQTTContext,
     pxMQTTContext->xBufferPoolInterface = pxInitParams->xBufferPoolInterface;
 
     #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+        prvResetSubscriptionManager( &( pxMQTTContext->xSubscriptionManager ) );
+    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
-        /* Mark all the subscription entires in the subscription
-         * manager as free. */
-        for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; x++ )
-        {
-            pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse = eMQTTFalse;
-        }
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        /* There is no session to keep until a connect asks for one. */
+        pxMQTTContext->xCleanSession = eMQTTTrue;
+    #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
 
-        /* Set the number of in-use subscription entries to zero. */
-        pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions = 0;
-    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+    #if ( mqttconfigENABLE_QOS2 == 1 )
+        /* No incoming QoS2 publish is waiting for PUBREL. */
+        memset( pxMQTTContext->usQoS2Received, 0x00, sizeof( pxMQTTContext->usQoS2Received ) );
+    #endif /* mqttconfigENABLE_QOS2 */
+
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        /* MQTT 3.1.1 is used unless a connect asks for MQTT 5.0. */
+        pxMQTTContext->xProtocolVersion = eMQTTProtocolVersion311;
+        pxMQTTContext->usReceiveMaximum = mqttRECEIVE_MAXIMUM_DEFAULT;
+    #endif /* mqttconfigENABLE_MQTT5 */
 
     return eMQTTSuccess;
 }
@@ -2492,7 +4130,7 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
         ( uint8_t ) 'T',                /* Protocol name byte 2. */
         ( uint8_t ) 'T',                /* Protocol name byte 3. */
         mqttPROTOCOL_LEVEL,             /* Protocol level. */
-        mqttCONNECT_CLEAN_SESSION_FLAG, /* AWS IoT Broker does not support persistent sessions i.e. Clean Session flag must be set. */
+        mqttCONNECT_CLEAN_SESSION_FLAG, /* Cleared below if a persistent session is requested. */
         ( uint8_t ) 0,                  /* Keep-alive time in seconds MSB. */
         ( uint8_t ) 0,                  /* Keep-alive time in seconds LSB. */
     };
@@ -2519,12 +4157,18 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
         pxMQTTContext->ulKeepAliveActualIntervalTicks = pxConnectParams->ulKeepAliveActualIntervalTicks;
         pxMQTTContext->ulPingRequestTimeoutTicks = pxConnectParams->ulPingRequestTimeoutTicks;
 
+        #if ( mqttconfigENABLE_MQTT5 == 1 )
+            /* The protocol version decides the layout of all later packets. */
+            pxMQTTContext->xProtocolVersion = pxConnectParams->xProtocolVersion;
+        #endif /* mqttconfigENABLE_MQTT5 */
+
         /* Client ID and username length. */
         usClientIdLength = mqttSTRLEN( pxConnectParams->usClientIdLength );
         usUserNameLength = pxConnectParams->usUserNameLength > ( uint16_t ) 0 ? mqttSTRLEN( pxConnectParams->usUserNameLength ) : ( uint16_t ) 0;
 
         /* Calculate "Remaining Length" i.e. length of the packet excluding Fixed Header. */
         ulRemainingLength = ( uint32_t ) sizeof( ucDefaultConnectVariableHeader ) +
+                            mqttPROPERTIES_LENGTH( pxMQTTContext ) +
                             ( uint32_t ) usClientIdLength +
                             ( uint32_t ) usUserNameLength;
 
@@ -2575,6 +4219,26 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
                 pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttVARIABLE_LENGTH_HEADER_START_OFFSET, ucRemainingLengthFieldBytes ) ] );
                 memcpy( pucNextByte, ucDefaultConnectVariableHeader, sizeof( ucDefaultConnectVariableHeader ) );
 
+                #if ( mqttconfigENABLE_MQTT5 == 1 )
+                    /* MQTT 5.0 uses protocol level 5 and an empty property
+                     * list after the keep-alive time. */
+                    if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+                    {
+                        mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttCONNECT_PROTOCOL_LEVEL_OFFSET, ucRemainingLengthFieldBytes ) ] = ( uint8_t ) eMQTTProtocolVersion5;
+                        mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttCONNECT_CLIENT_ID_OFFSET, ucRemainingLengthFieldBytes ) ] = ( uint8_t ) 0;
+                    }
+                #endif /* mqttconfigENABLE_MQTT5 */
+
+                #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+                    /* Keep the session state on both sides across disconnects. */
+                    if( pxConnectParams->xCleanSession == eMQTTFalse )
+                    {
+                        mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttCONNECT_FLAGS_OFFSET, ucRemainingLengthFieldBytes ) ] &= ( uint8_t ) ~mqttCONNECT_CLEAN_SESSION_FLAG;
+                    }
+
+                    pxMQTTContext->xCleanSession = pxConnectParams->xCleanSession;
+                #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+
                 /* Update the user name flag. */
                 if( pxConnectParams->usUserNameLength > ( uint16_t ) 0 )
                 {
@@ -2588,7 +4252,7 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
                                                                   ucRemainingLengthFieldBytes ) ] = ( uint8_t ) ( pxConnectParams->usKeepAliveIntervalSeconds );
 
                 /* Write the client ID into the payload. */
-                pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttCONNECT_CLIENT_ID_OFFSET, ucRemainingLengthFieldBytes ) ] );
+                pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttCONNECT_CLIENT_ID_OFFSET + mqttPROPERTIES_LENGTH( pxMQTTContext ), ucRemainingLengthFieldBytes ) ] );
                 pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxConnectParams->pucClientId, pxConnectParams->usClientIdLength );
 
                 /* Write the user name into the payload. */
@@ -2696,7 +4360,9 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
     mqttconfigASSERT( pxMQTTContext->xBufferPoolInterface.pxReturnBufferFxn != NULL );
     mqttconfigASSERT( pxSubscribeParams != NULL );
     mqttconfigASSERT( pxSubscribeParams->pucTopic != NULL );
-    mqttconfigASSERT( pxSubscribeParams->xQos != eMQTTQoS2 ); /* QoS2 is not supported. */
+    #if ( mqttconfigENABLE_QOS2 == 0 )
+        mqttconfigASSERT( pxSubscribeParams->xQos != eMQTTQoS2 ); /* QoS2 is not enabled. */
+    #endif
 
     mqttconfigDEBUG_LOG( ( "Initiating MQTT subscribe.\r\n" ) );
 
@@ -2711,19 +4377,15 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
         #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
             /* Try to store the subscription in the subscription
-             * manager. */
-            if( prvStoreSubscription( pxMQTTContext,
-                                      pxSubscribeParams->pucTopic,
-                                      pxSubscribeParams->usTopicLength,
-                                      pxSubscribeParams->pvPublishCallbackContext,
-                                      pxSubscribeParams->pxPublishCallback ) == eMQTTFalse )
-            {
-                /* Fail the subscribe operation immediately, if we
-                 * fail to store the subscription in the subscription
-                 * manager. */
-                xReturnCode = eMQTTSubscriptionManagerFull;
-            }
-            else
+             * manager. Fail the subscribe operation immediately, if
+             * we fail to store it. */
+            xReturnCode = prvStoreSubscription( &( pxMQTTContext->xSubscriptionManager ),
+                                                pxSubscribeParams->pucTopic,
+                                                pxSubscribeParams->usTopicLength,
+                                                pxSubscribeParams->pvPublishCallbackContext,
+                                                pxSubscribeParams->pxPublishCallback );
+
+            if( xReturnCode == eMQTTSuccess )
         #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
         {
             /* Length of the topic in the actual MQTT message. */
@@ -2732,6 +4394,7 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
             /* Calculate the "Remaining Length" i.e. length of the packet
              * excluding fixed header. */
             ulRemainingLength = ( uint32_t ) mqttSUBSCRIBE_PACKET_IDENTIFER_LENGTH +
+                                mqttPROPERTIES_LENGTH( pxMQTTContext ) +
                                 ( uint32_t ) usTopicLength +
                                 ( uint32_t ) mqttSUBSCRIBE_REQUESTED_QOS_LENGTH;
 
@@ -2785,8 +4448,16 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
                     mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_PACKET_ID_LSB_OFFSET,
                                                                       ucRemainingLengthFieldBytes ) ] = ( uint8_t ) ( pxSubscribeParams->usPacketIdentifier );
 
+                    #if ( mqttconfigENABLE_MQTT5 == 1 )
+                        /* Write an empty property list. */
+                        if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+                        {
+                            mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] = ( uint8_t ) 0;
+                        }
+                    #endif /* mqttconfigENABLE_MQTT5 */
+
                     /* Write the topic into the message. */
-                    pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] );
+                    pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET + mqttPROPERTIES_LENGTH( pxMQTTContext ), ucRemainingLengthFieldBytes ) ] );
                     pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxSubscribeParams->pucTopic, pxSubscribeParams->usTopicLength );
 
                     /* Write the Requested QoS into the message. */
@@ -2827,9 +4498,9 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
              * This if check is an optimization - If the subscribe failed because
              * we could not store the subscription, there is not need to remove
              * it as it was never stored. */
-            if( xReturnCode != eMQTTSubscriptionManagerFull )
+            if( ( xReturnCode != eMQTTSubscriptionManagerFull ) && ( xReturnCode != eMQTTTopicFilterTooManyLevels ) )
             {
-                prvRemoveSubscription( pxMQTTContext, pxSubscribeParams->pucTopic, pxSubscribeParams->usTopicLength );
+                ( void ) prvRemoveSubscription( &( pxMQTTContext->xSubscriptionManager ), pxSubscribeParams->pucTopic, pxSubscribeParams->usTopicLength );
             }
         #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
     }
@@ -2870,7 +4541,7 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
 
         /* Calculate the "Remaining Length" i.e. length of the packet
          * excluding fixed header. */
-        ulRemainingLength = ( uint32_t ) mqttUNSUBSCRIBE_PACKET_IDENTIFER_LENGTH + ( uint32_t ) usTopicLength;
+        ulRemainingLength = ( uint32_t ) mqttUNSUBSCRIBE_PACKET_IDENTIFER_LENGTH + mqttPROPERTIES_LENGTH( pxMQTTContext ) + ( uint32_t ) usTopicLength;
 
         /* Calculate the number of bytes occupied by the "Remaining Length" field. */
         ucRemainingLengthFieldBytes = prvSizeOfRemainingLength( ulRemainingLength );
@@ -2922,8 +4593,16 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
                 mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttUNSUBSCRIBE_PACKET_ID_LSB_OFFSET,
                                                                   ucRemainingLengthFieldBytes ) ] = ( uint8_t ) ( pxUnsubscribeParams->usPacketIdentifier );
 
+                #if ( mqttconfigENABLE_MQTT5 == 1 )
+                    /* Write an empty property list. */
+                    if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+                    {
+                        mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttUNSUBSCRIBE_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] = ( uint8_t ) 0;
+                    }
+                #endif /* mqttconfigENABLE_MQTT5 */
+
                 /* Write the topic into the message. */
-                pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttUNSUBSCRIBE_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] );
+                pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttUNSUBSCRIBE_TOPIC_OFFSET + mqttPROPERTIES_LENGTH( pxMQTTContext ), ucRemainingLengthFieldBytes ) ] );
                 pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxUnsubscribeParams->pucTopic, pxUnsubscribeParams->usTopicLength );
 
                 /* MISRA compliance. */
@@ -2960,14 +4639,17 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
 }
 /*-----------------------------------------------------------*/
 
-MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
-                               const MQTTPublishParams_t * const pxPublishParams )
+static MQTTReturnCode_t prvPublish( MQTTContext_t * pxMQTTContext,
+                                    const MQTTPublishParams_t * const pxPublishParams,
+                                    const uint8_t * const pucEncodedTopic,
+                                    uint16_t usEncodedTopicLength )
 {
     uint8_t * pucNextByte, * pucLastByteInBuffer, ucRemainingLengthFieldBytes;
-    uint32_t ulRemainingLength, ulTotalMessageLength;
+    uint32_t ulRemainingLength, ulTotalMessageLength, ulPayloadLengthInBuffer;
     uint16_t usTopicLength;
     MQTTBufferHandle_t xBuffer = NULL;
     MQTTReturnCode_t xReturnCode = eMQTTFailure;
+    MQTTIOVector_t xIOVectors[ 2 ];
 
     /* These are checked here once and are later used without
      * NULL checks. */
@@ -2985,14 +4667,32 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
          * MQTT client is not connected. */
         xReturnCode = eMQTTClientNotConnected;
     }
+
+    #if ( mqttconfigENABLE_MQTT5 == 1 )
+        else if( ( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 ) &&
+                 ( pxPublishParams->xQos != eMQTTQoS0 ) &&
+                 ( prvCountPublishesInFlight( pxMQTTContext ) >= ( uint32_t ) pxMQTTContext->usReceiveMaximum ) )
+        {
+            /* The broker does not accept more unacknowledged publishes. */
+            xReturnCode = eMQTTReceiveMaximumReached;
+        }
+    #endif /* mqttconfigENABLE_MQTT5 */
     else
     {
         /* Length of the topic in the actual MQTT message. */
-        usTopicLength = mqttSTRLEN( pxPublishParams->usTopicLength );
+        if( pucEncodedTopic != NULL )
+        {
+            usTopicLength = usEncodedTopicLength;
+        }
+        else
+        {
+            usTopicLength = mqttSTRLEN( pxPublishParams->usTopicLength );
+        }
 
         /* Calculate the "Remaining Length" i.e. length of the packet excluding Fixed Header. */
         ulRemainingLength = ( uint32_t ) usTopicLength +
                             ( pxPublishParams->xQos == eMQTTQoS0 ? ( uint32_t ) mqttPUBLISH_QOS0_PACKET_IDENTIFER_LENGTH : ( uint32_t ) mqttPUBLISH_QOS1_PACKET_IDENTIFER_LENGTH ) +
+                            mqttPROPERTIES_LENGTH( pxMQTTContext ) +
                             pxPublishParams->ulDataLength;
 
         /* Calculate the number of bytes occupied by the "Remaining Length" field. */
@@ -3004,8 +4704,23 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
             /* Calculate total MQTT message length. */
             ulTotalMessageLength = mqttTOTAL_MESSAGE_LENGTH( ucRemainingLengthFieldBytes, ulRemainingLength );
 
+            /* If the user has registered a gathered send callback, the payload
+             * is transmitted directly from the user buffer and only the
+             * headers need to be written into the Tx buffer. */
+            ulPayloadLengthInBuffer = ( pxMQTTContext->pxMQTTSendVFxn != NULL ) ? ( uint32_t ) 0 : pxPublishParams->ulDataLength;
+
+            #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+                /* A publish kept across disconnects is sent again from the
+                 * Tx buffer alone, after the user buffer has been released. */
+                if( ( pxMQTTContext->xCleanSession == eMQTTFalse ) && ( pxPublishParams->xQos == eMQTTQoS1 ) )
+                {
+                    ulPayloadLengthInBuffer = pxPublishParams->ulDataLength;
+                }
+            #endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+
             /* Try to get a buffer from the free buffer pool. */
-            xBuffer = prvGetFreeBuffer( pxMQTTContext, ulTotalMessageLength );
+            xBuffer = prvGetFreeBuffer( pxMQTTContext, ulTotalMessageLength - ( pxPublishParams->ulDataLength - ulPayloadLengthInBuffer ) );
 
             if( xBuffer == NULL )
             {
@@ -3030,8 +4745,8 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
                 /*_TODO_ Note!  DUP and RETAIN are all currently all set to 0. */
                 mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] = mqttCONTROL_PUBLISH;
 
-                /* Set QoS. QoS2 is not supported.*/
-                mqttconfigASSERT( pxPublishParams->xQos == eMQTTQoS0 || pxPublishParams->xQos == eMQTTQoS1 );
+                /* Set QoS. QoS2 is only supported if enabled. */
+                mqttconfigASSERT( ( uint8_t ) pxPublishParams->xQos <= mqttMAX_RECEIVED_QOS );
                 mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] |= ( ( ( uint8_t ) ( pxPublishParams->xQos ) ) << 1 );
 
                 /* Write encoded "Remaining Length" in the fixed header. */
@@ -3045,7 +4760,15 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
 
                 /* Write the topic into the message (part of variable header). */
                 pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] );
-                pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxPublishParams->pucTopic, pxPublishParams->usTopicLength );
+                if( pucEncodedTopic != NULL )
+                {
+                    memcpy( pucNextByte, pucEncodedTopic, ( size_t ) usEncodedTopicLength );
+                    pucNextByte += usEncodedTopicLength;
+                }
+                else
+                {
+                    pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxPublishParams->pucTopic, pxPublishParams->usTopicLength );
+                }
 
                 /* Write packet identifier into the message, if it is not QoS0. */
                 if( pxPublishParams->xQos != eMQTTQoS0 )
@@ -3059,15 +4782,25 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
                     pucNextByte++;
                 }
 
-                /* Write the payload into the message. */
-                memcpy( pucNextByte, pxPublishParams->pvData, ( size_t ) pxPublishParams->ulDataLength );
+                #if ( mqttconfigENABLE_MQTT5 == 1 )
+                    /* Write an empty property list. */
+                    if( pxMQTTContext->xProtocolVersion == eMQTTProtocolVersion5 )
+                    {
+                        *pucNextByte = ( uint8_t ) 0;
+                        pucNextByte++;
+                    }
+                #endif /* mqttconfigENABLE_MQTT5 */
+
+                /* Write the payload into the message, unless it is
+                 * transmitted directly from the user buffer. */
+                memcpy( pucNextByte, pxPublishParams->pvData, ( size_t ) ulPayloadLengthInBuffer );
 
                 /* Store the packet identifier in TxBuffer also for matching
                  * ACK later. */
                 mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) = pxPublishParams->usPacketIdentifier;
 
                 /* Update the number of bytes written to the buffer. */
-                mqttbufferGET_DATA_LENGTH( xBuffer ) = ulTotalMessageLength;
+                mqttbufferGET_DATA_LENGTH( xBuffer ) = ulTotalMessageLength - ( pxPublishParams->ulDataLength - ulPayloadLengthInBuffer );
 
                 /* MQTT packet created. */
                 xReturnCode = eMQTTSuccess;
@@ -3078,7 +4811,21 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
     /* If the packet was successfully constructed, transmit it. */
     if( xReturnCode == eMQTTSuccess )
     {
-        xReturnCode = prvSendData( pxMQTTContext, mqttbufferGET_DATA( xBuffer ), mqttbufferGET_DATA_LENGTH( xBuffer ) );
+        if( ulPayloadLengthInBuffer < pxPublishParams->ulDataLength )
+        {
+            /* Transmit the headers from the Tx buffer and the payload
+             * from the user buffer together. */
+            xIOVectors[ 0 ].pucData = mqttbufferGET_DATA( xBuffer );
+            xIOVectors[ 0 ].ulDataLength = mqttbufferGET_DATA_LENGTH( xBuffer );
+            xIOVectors[ 1 ].pucData = ( const uint8_t * ) pxPublishParams->pvData;
+            xIOVectors[ 1 ].ulDataLength = pxPublishParams->ulDataLength;
+
+            xReturnCode = prvSendDataV( pxMQTTContext, xIOVectors, ( uint32_t ) 2, ulTotalMessageLength );
+        }
+        else
+        {
+            xReturnCode = prvSendData( pxMQTTContext, mqttbufferGET_DATA( xBuffer ), mqttbufferGET_DATA_LENGTH( xBuffer ) );
+        }
     }
 
     /* If some error occurred or QOS0 (No ACK is expected in case of QOS0),
@@ -3094,6 +4841,64 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
 }
 /*-----------------------------------------------------------*/
 
+MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
+                               const MQTTPublishParams_t * const pxPublishParams )
+{
+    return prvPublish( pxMQTTContext, pxPublishParams, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_PREPARED_TOPICS == 1 )
+
+    MQTTReturnCode_t MQTT_PrepareTopic( MQTTPreparedTopic_t * const pxPreparedTopic,
+                                        const uint8_t * const pucTopic,
+                                        uint16_t usTopicLength )
+    {
+        MQTTReturnCode_t xReturnCode = eMQTTSuccess;
+        uint16_t x;
+
+        mqttconfigASSERT( pxPreparedTopic != NULL );
+        mqttconfigASSERT( pucTopic != NULL );
+
+        if( ( usTopicLength == ( uint16_t ) 0 ) || ( usTopicLength > ( uint16_t ) mqttconfigPREPARED_TOPIC_MAX_LENGTH ) )
+        {
+            xReturnCode = eMQTTFailure;
+        }
+
+        /* Wildcards are only allowed in topic filters. */
+        for( x = 0; ( x < usTopicLength ) && ( xReturnCode == eMQTTSuccess ); x++ )
+        {
+            if( ( pucTopic[ x ] == ( uint8_t ) '+' ) || ( pucTopic[ x ] == ( uint8_t ) '#' ) )
+            {
+                xReturnCode = eMQTTFailure;
+            }
+        }
+
+        if( xReturnCode == eMQTTSuccess )
+        {
+            pxPreparedTopic->usEncodedTopicLength = mqttSTRLEN( usTopicLength );
+            ( void ) prvWriteString( pxPreparedTopic->ucEncodedTopic,
+                                     &( pxPreparedTopic->ucEncodedTopic[ pxPreparedTopic->usEncodedTopicLength - ( uint16_t ) 1 ] ),
+                                     pucTopic,
+                                     usTopicLength );
+        }
+
+        return xReturnCode;
+    }
+/*-----------------------------------------------------------*/
+
+    MQTTReturnCode_t MQTT_PublishPrepared( MQTTContext_t * pxMQTTContext,
+                                           const MQTTPreparedTopic_t * const pxPreparedTopic,
+                                           const MQTTPublishParams_t * const pxPublishParams )
+    {
+        mqttconfigASSERT( pxPreparedTopic != NULL );
+
+        return prvPublish( pxMQTTContext, pxPublishParams, pxPreparedTopic->ucEncodedTopic, pxPreparedTopic->usEncodedTopicLength );
+    }
+
+#endif /* mqttconfigENABLE_PREPARED_TOPICS */
+/*-----------------------------------------------------------*/
+
 MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
                                          const uint8_t * pucReceivedData,
                                          size_t xReceivedDataLength )
@@ -3102,6 +4907,10 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
     MQTTEventCallbackParams_t xEventCallbackParams;
     size_t xProcessedBytes = 0, xExpectedBytes, xUnprocessedBytes;
 
+    #if ( mqttconfigENABLE_RX_FAST_PATH == 1 )
+        size_t xCompletePacketLength;
+    #endif
+
     /* These are checked here once and are later used without
      * NULL checks. */
     mqttconfigASSERT( pxMQTTContext != NULL );
@@ -3125,6 +4934,23 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
             break;
         }
 
+        #if ( mqttconfigENABLE_RX_FAST_PATH == 1 )
+            /* Process a packet received whole without going through the
+             * state machine. */
+            if( pxMQTTContext->xRxMessageState.xRxNextByte == eMQTTRxNextBytePacketType )
+            {
+                xCompletePacketLength = prvProcessCompletePacket( pxMQTTContext,
+                                                                  &( pucReceivedData[ xProcessedBytes ] ),
+                                                                  xReceivedDataLength - xProcessedBytes );
+
+                if( xCompletePacketLength > ( size_t ) 0 )
+                {
+                    xProcessedBytes += xCompletePacketLength;
+                    continue;
+                }
+            }
+        #endif /* mqttconfigENABLE_RX_FAST_PATH */
+
         if( pxMQTTContext->xRxMessageState.xRxNextByte == eMQTTRxNextBytePacketType )
         {
             /* Looking for the start of a new MQTT message, which always begins with
@@ -3220,6 +5046,23 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
                          * can be used for other operations. */
                         prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
                         pxMQTTContext->xRxBuffer = NULL;
+
+                        #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+
+                            /* A QoS0 or QoS1 publish can still be passed to
+                             * the user in chunks. QoS2 publishes are not
+                             * streamed, as a partly delivered message could
+                             * not be told apart from a duplicate. Neither are
+                             * MQTT 5.0 publishes, as their properties do not
+                             * fit in the stream header. */
+                            if( ( ( pxMQTTContext->ucRxFixedHeaderBuffer[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH ) &&
+                                ( mqttPUBLISH_QoS_BITS( pxMQTTContext->ucRxFixedHeaderBuffer[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] ) <= ( uint8_t ) 1 ) &&
+                                ( mqttPROPERTIES_LENGTH( pxMQTTContext ) == ( uint32_t ) 0 ) )
+                            {
+                                memcpy( pxMQTTContext->ucRxStreamHeader, pxMQTTContext->ucRxFixedHeaderBuffer, pxMQTTContext->ulRxMessageReceivedLength );
+                                pxMQTTContext->xRxMessageState.xRxMessageAction = eMQTTRxMessageStream;
+                            }
+                        #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
                     }
                 }
             }
@@ -3247,6 +5090,29 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
                 prvResetRxMessageState( pxMQTTContext );
             }
         }
+
+        #if ( mqttconfigENABLE_STREAMING_PUBLISH == 1 )
+            else if( ( pxMQTTContext->xRxMessageState.xRxNextByte == eMQTTRxNextByteMessage ) && ( pxMQTTContext->xRxMessageState.xRxMessageAction == eMQTTRxMessageStream ) )
+            {
+                xProcessedBytes += ( size_t ) prvProcessStreamedPublishBytes( pxMQTTContext,
+                                                                              &( pucReceivedData[ xProcessedBytes ] ),
+                                                                              ( uint32_t ) ( xReceivedDataLength - xProcessedBytes ) );
+
+                /* Reset Rx state to receive next packet once all of the
+                 * message has been processed, unless it is being dropped
+                 * and the drop must be reported. */
+                if( pxMQTTContext->ulRxMessageReceivedLength == pxMQTTContext->xRxMessageState.ulTotalMessageLength )
+                {
+                    if( pxMQTTContext->xRxMessageState.xRxMessageAction == eMQTTRxMessageDrop )
+                    {
+                        xEventCallbackParams.xEventType = eMQTTPacketDropped;
+                        ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+                    }
+
+                    prvResetRxMessageState( pxMQTTContext );
+                }
+            }
+        #endif /* mqttconfigENABLE_STREAMING_PUBLISH */
         else if( ( pxMQTTContext->xRxMessageState.xRxNextByte == eMQTTRxNextByteMessage ) && ( pxMQTTContext->xRxMessageState.xRxMessageAction == eMQTTRxMessageDrop ) )
         {
             xExpectedBytes = pxMQTTContext->xRxMessageState.ulTotalMessageLength - pxMQTTContext->ulRxMessageReceivedLength; /* These many bytes are still needed to constitute a packet. */
@@ -3426,6 +5292,69 @@ uint32_t MQTT_Periodic( MQTTContext_t * pxMQTTContext,
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    void MQTT_SubscriptionManagerInit( MQTTSubscriptionManager_t * const pxSubscriptionManager )
+    {
+        mqttconfigASSERT( pxSubscriptionManager != NULL );
+
+        prvResetSubscriptionManager( pxSubscriptionManager );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    MQTTBool_t MQTT_SubscriptionManagerStore( MQTTSubscriptionManager_t * const pxSubscriptionManager,
+                                              const uint8_t * const pucTopicFilter,
+                                              uint16_t usTopicFilterLength,
+                                              void * pvPublishCallbackContext,
+                                              MQTTPublishCallback_t pxPublishCallback )
+    {
+        mqttconfigASSERT( pxSubscriptionManager != NULL );
+        mqttconfigASSERT( pucTopicFilter != NULL );
+
+        return ( prvStoreSubscription( pxSubscriptionManager,
+                                       pucTopicFilter,
+                                       usTopicFilterLength,
+                                       pvPublishCallbackContext,
+                                       pxPublishCallback ) == eMQTTSuccess ) ? eMQTTTrue : eMQTTFalse;
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    MQTTBool_t MQTT_SubscriptionManagerRemove( MQTTSubscriptionManager_t * const pxSubscriptionManager,
+                                               const uint8_t * const pucTopicFilter,
+                                               uint16_t usTopicFilterLength )
+    {
+        mqttconfigASSERT( pxSubscriptionManager != NULL );
+        mqttconfigASSERT( pucTopicFilter != NULL );
+
+        return prvRemoveSubscription( pxSubscriptionManager, pucTopicFilter, usTopicFilterLength );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    uint32_t MQTT_SubscriptionManagerMatch( MQTTSubscriptionManager_t * const pxSubscriptionManager,
+                                            const uint8_t * const pucTopic,
+                                            uint16_t usTopicLength )
+    {
+        mqttconfigASSERT( pxSubscriptionManager != NULL );
+        mqttconfigASSERT( pucTopic != NULL );
+
+        return prvTopicTrieMatch( pxSubscriptionManager, pucTopic, usTopicLength );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
 /* Provide access to private members for testing. */
 #ifdef AMAZON_FREERTOS_ENABLE_UNIT_TESTS
     #include "aws_mqtt_lib_test_access_define.h"
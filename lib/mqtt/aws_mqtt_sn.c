@@ -0,0 +1,1799 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file aws_mqtt_sn.c
+ * @brief MQTT-SN 1.2 client over a datagram transport.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* MQTT-SN include. */
+#include "aws_mqtt_sn.h"
+
+/**
+ * @defgroup MessageTypes MQTT-SN message types used by the client.
+ */
+/** @{ */
+#define mqttsnCONNECT        ( ( uint8_t ) 0x04 )
+#define mqttsnCONNACK        ( ( uint8_t ) 0x05 )
+#define mqttsnREGISTER       ( ( uint8_t ) 0x0A )
+#define mqttsnREGACK         ( ( uint8_t ) 0x0B )
+#define mqttsnPUBLISH        ( ( uint8_t ) 0x0C )
+#define mqttsnPUBACK         ( ( uint8_t ) 0x0D )
+#define mqttsnSUBSCRIBE      ( ( uint8_t ) 0x12 )
+#define mqttsnSUBACK         ( ( uint8_t ) 0x13 )
+#define mqttsnUNSUBSCRIBE    ( ( uint8_t ) 0x14 )
+#define mqttsnUNSUBACK       ( ( uint8_t ) 0x15 )
+#define mqttsnPINGREQ        ( ( uint8_t ) 0x16 )
+#define mqttsnPINGRESP       ( ( uint8_t ) 0x17 )
+#define mqttsnDISCONNECT     ( ( uint8_t ) 0x18 )
+/** @} */
+
+/**
+ * @defgroup Flags Bits of the flags field.
+ */
+/** @{ */
+#define mqttsnFLAG_DUP              ( ( uint8_t ) 0x80 )
+#define mqttsnFLAG_QOS_MASK         ( ( uint8_t ) 0x60 )
+#define mqttsnFLAG_QOS1             ( ( uint8_t ) 0x20 )
+#define mqttsnFLAG_CLEAN_SESSION    ( ( uint8_t ) 0x04 )
+#define mqttsnFLAG_TOPIC_ID_MASK    ( ( uint8_t ) 0x03 )
+/** @} */
+
+/**
+ * @defgroup TopicIdTypes Values of the topic ID type in the flags field.
+ */
+/** @{ */
+#define mqttsnTOPIC_NORMAL        ( ( uint8_t ) 0x00 ) /**< A topic ID from REGISTER or SUBACK, or a topic name in SUBSCRIBE. */
+#define mqttsnTOPIC_PREDEFINED    ( ( uint8_t ) 0x01 ) /**< A topic ID that is configured in the gateway. */
+#define mqttsnTOPIC_SHORT         ( ( uint8_t ) 0x02 ) /**< A two character topic name in place of the ID. */
+/** @} */
+
+/**
+ * @defgroup ReturnCodes MQTT-SN return codes.
+ */
+/** @{ */
+#define mqttsnACCEPTED                  ( ( uint8_t ) 0x00 )
+#define mqttsnREJECTED_CONGESTION       ( ( uint8_t ) 0x01 )
+#define mqttsnREJECTED_INVALID_TOPIC    ( ( uint8_t ) 0x02 )
+#define mqttsnREJECTED_NOT_SUPPORTED    ( ( uint8_t ) 0x03 )
+/** @} */
+
+/**
+ * @brief The protocol ID sent in CONNECT.
+ */
+#define mqttsnPROTOCOL_ID    ( ( uint8_t ) 0x01 )
+
+/**
+ * @brief The longest client ID permitted by the specification.
+ */
+#define mqttsnMAX_CLIENT_ID_LENGTH    ( 23 )
+
+/**
+ * @brief A first length byte of this value means that the length is in the
+ * next two bytes.
+ */
+#define mqttsnLONG_LENGTH    ( ( uint8_t ) 0x01 )
+
+/**
+ * @brief The size of the buffer for the acknowledgements the client sends
+ * while it waits for a reply, which leaves the transmit buffer intact for
+ * retransmissions.
+ */
+#define mqttsnACK_BUFFER_SIZE    ( 7 )
+
+/**
+ * @defgroup TopicFlags Uses of an entry of the topic table.
+ *
+ * An entry for which none of these are set is free.
+ */
+/** @{ */
+#define mqttsnENTRY_PREDEFINED    ( ( uint8_t ) 0x01 ) /**< usTopicId is a predefined ID. */
+#define mqttsnENTRY_REGISTERED    ( ( uint8_t ) 0x02 ) /**< usTopicId was given by the gateway for this session. */
+#define mqttsnENTRY_SUBSCRIBED    ( ( uint8_t ) 0x04 ) /**< The topic is a subscription of the client. */
+#define mqttsnENTRY_PENDING       ( ( uint8_t ) 0x08 ) /**< A REGISTER for the topic is in progress. */
+/** @} */
+
+/**
+ * @defgroup ReceiveResults Values returned by prvReceive().
+ */
+/** @{ */
+#define mqttsnRX_ERROR      ( ( BaseType_t ) -1 )
+#define mqttsnRX_NONE       ( ( BaseType_t ) 0 )
+#define mqttsnRX_MESSAGE    ( ( BaseType_t ) 1 )
+/** @} */
+
+/**
+ * @brief Encodes the index of a client returned to the user.
+ *
+ * Adding one ensures that the user does not ever get a NULL handle.
+ */
+#define mqttsnENCODE_CLIENT_NUMBER( xClientNumber )    ( ( UBaseType_t ) ( xClientNumber ) + ( UBaseType_t ) 1 )
+
+/**
+ * @brief Decodes the handle back to the index of the client.
+ */
+#define mqttsnDECODE_CLIENT_NUMBER( xHandle )          ( ( UBaseType_t ) ( xHandle ) - ( UBaseType_t ) 1 )
+
+/**
+ * @brief The state of a client.
+ */
+typedef enum
+{
+    eMQTTSNDisconnected, /**< Not connected to a gateway. */
+    eMQTTSNActive,       /**< Connected. */
+    eMQTTSNAsleep        /**< Connected, the gateway buffers the publishes for the client. */
+} MQTTSNState_t;
+
+/**
+ * @brief An entry of the topic table of a client.
+ */
+typedef struct MQTTSNTopic
+{
+    uint8_t ucTopic[ mqttsnconfigMAX_TOPIC_LENGTH ]; /**< The topic name or topic filter. */
+    uint16_t usTopicLength;                          /**< Length of ucTopic. */
+    uint16_t usTopicId;                              /**< The ID of the topic, see mqttsnENTRY_PREDEFINED and mqttsnENTRY_REGISTERED. */
+    uint8_t ucFlags;                                 /**< Uses of the entry, see TopicFlags. */
+    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+        void * pvPublishCallbackContext;             /**< Passed as it is in the publish callback. */
+        MQTTPublishCallback_t pxPublishCallback;     /**< Called for the publishes that match a subscription. */
+    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+} MQTTSNTopic_t;
+
+/**
+ * @brief An MQTT-SN client.
+ */
+typedef struct MQTTSNClient
+{
+    BaseType_t xInUse;                                   /**< pdTRUE if the client was created. */
+    MQTTSNState_t xState;                                /**< State of the connection. */
+    SemaphoreHandle_t xMutex;                            /**< Serialises the API calls. */
+    TaskHandle_t xCallbackTask;                          /**< The task running a user callback, NULL if none is. */
+    MQTTSNTransport_t xTransport;                        /**< The transport to the gateway. */
+    uint8_t ucClientId[ mqttsnMAX_CLIENT_ID_LENGTH ];    /**< Client Identifier, also sent when waking up. */
+    uint16_t usClientIdLength;                           /**< Length of ucClientId. */
+    uint16_t usKeepAliveSeconds;                         /**< Keep alive period sent in CONNECT. */
+    uint16_t usNextMessageId;                            /**< The message ID of the next request. */
+    TickType_t xLastSendTime;                            /**< When the client last sent something, for the keep alive. */
+    void * pvUserData;                                   /**< Passed as it is in pxCallback. */
+    MQTTAgentCallback_t pxCallback;                      /**< The generic callback. */
+    MQTTSNTopic_t xTopics[ mqttsnconfigMAX_TOPICS ];     /**< The topic table. */
+    uint8_t * pucTxFlags;                                /**< The flags of the message in ucTxBuffer, which get the DUP bit when it is sent again. NULL for messages without one. */
+    uint32_t ulTxLength;                                 /**< Length of the message in ucTxBuffer. */
+    uint8_t ucTxBuffer[ mqttsnconfigMAX_PACKET_SIZE ];   /**< The request being sent. */
+    uint8_t ucRxType;                                    /**< Type of the last received message. */
+    const uint8_t * pucRxBody;                           /**< The part of the last received message after its type. */
+    uint32_t ulRxBodyLength;                             /**< Length of pucRxBody. */
+    uint8_t ucRxBuffer[ mqttsnconfigMAX_PACKET_SIZE ];   /**< The last received message. */
+} MQTTSNClient_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Returns the client for a handle, or NULL if it is not valid.
+ */
+static MQTTSNClient_t * prvGetClient( MQTTSNHandle_t xHandle );
+
+/**
+ * @brief Gets exclusive use of a client for an API call.
+ *
+ * @return The client, or NULL with the reason in *pxReturnCode.
+ */
+static MQTTSNClient_t * prvTakeClient( MQTTSNHandle_t xHandle,
+                                       TickType_t xTimeoutTicks,
+                                       MQTTAgentReturnCode_t * pxReturnCode );
+
+/**
+ * @brief Returns the next message ID, which is never 0.
+ */
+static uint16_t prvNextMessageId( MQTTSNClient_t * const pxClient );
+
+/**
+ * @brief Writes the length and type of a message to the transmit buffer.
+ *
+ * @return Where the body of ulBodyLength bytes goes, or NULL if the message
+ * does not fit.
+ */
+static uint8_t * prvStartMessage( MQTTSNClient_t * const pxClient,
+                                  uint8_t ucType,
+                                  uint32_t ulBodyLength );
+
+/**
+ * @brief Sends a whole message through the transport.
+ */
+static BaseType_t prvSendDatagram( MQTTSNClient_t * const pxClient,
+                                   const uint8_t * pucData,
+                                   uint32_t ulLength );
+
+/**
+ * @brief Receives and checks one message, waiting at most xTimeoutTicks.
+ *
+ * @return mqttsnRX_MESSAGE if ucRxType and pucRxBody describe a new message,
+ * mqttsnRX_NONE if nothing valid arrived, or mqttsnRX_ERROR.
+ */
+static BaseType_t prvReceive( MQTTSNClient_t * const pxClient,
+                              TickType_t xTimeoutTicks );
+
+/**
+ * @brief Checks whether the received message is the reply of type ucReplyType
+ * to the request with the message ID usMessageId.
+ */
+static BaseType_t prvIsReply( const MQTTSNClient_t * const pxClient,
+                              uint8_t ucReplyType,
+                              uint16_t usMessageId );
+
+/**
+ * @brief Sends the message in the transmit buffer and waits for its reply.
+ *
+ * The message is sent again every mqttsnconfigRETRY_TICKS, up to
+ * mqttsnconfigMAX_RETRIES times. The messages that the gateway sends in the
+ * mean time are handled. On success the reply is in pucRxBody.
+ */
+static MQTTAgentReturnCode_t prvSendAndWait( MQTTSNClient_t * const pxClient,
+                                             uint8_t ucReplyType,
+                                             uint16_t usMessageId,
+                                             TimeOut_t * const pxTimeOut,
+                                             TickType_t * const pxTicksLeft );
+
+/**
+ * @brief Handles a message which the gateway sent on its own.
+ *
+ * @return pdFAIL if the gateway closed the connection.
+ */
+static BaseType_t prvHandleGatewayMessage( MQTTSNClient_t * const pxClient );
+
+/**
+ * @brief Handles a PUBLISH from the gateway.
+ */
+static void prvHandlePublish( MQTTSNClient_t * const pxClient );
+
+/**
+ * @brief Passes a received publish to the callbacks.
+ */
+static void prvDeliverPublish( MQTTSNClient_t * const pxClient,
+                               const MQTTPublishData_t * const pxPublishData );
+
+/**
+ * @brief Sends an acknowledgement with a topic ID, a message ID and a return code.
+ */
+static void prvSendTopicAck( MQTTSNClient_t * const pxClient,
+                             uint8_t ucType,
+                             uint16_t usTopicId,
+                             uint16_t usMessageId,
+                             uint8_t ucReturnCode );
+
+/**
+ * @brief Forgets the topic IDs of the session, and the subscriptions as well
+ * if xSubscriptions is pdTRUE. Predefined topics are kept.
+ */
+static void prvClearSession( MQTTSNClient_t * const pxClient,
+                             BaseType_t xSubscriptions );
+
+/**
+ * @brief Marks the client as disconnected and tells the application.
+ */
+static void prvConnectionLost( MQTTSNClient_t * const pxClient );
+
+/**
+ * @brief Sends CONNECT and waits for CONNACK.
+ */
+static MQTTAgentReturnCode_t prvConnect( MQTTSNClient_t * const pxClient,
+                                         BaseType_t xCleanSession,
+                                         TimeOut_t * const pxTimeOut,
+                                         TickType_t * const pxTicksLeft );
+
+/**
+ * @brief Connects a sleeping client again.
+ */
+static MQTTAgentReturnCode_t prvMakeActive( MQTTSNClient_t * const pxClient,
+                                            TimeOut_t * const pxTimeOut,
+                                            TickType_t * const pxTicksLeft );
+
+/**
+ * @brief Finds the topic table entry for a topic, NULL if there is none.
+ */
+static MQTTSNTopic_t * prvTopicFind( MQTTSNClient_t * const pxClient,
+                                     const uint8_t * pucTopic,
+                                     uint16_t usTopicLength );
+
+/**
+ * @brief Finds the entry with topic ID usTopicId, used as ucFlag.
+ */
+static MQTTSNTopic_t * prvTopicFindById( MQTTSNClient_t * const pxClient,
+                                         uint16_t usTopicId,
+                                         uint8_t ucFlag );
+
+/**
+ * @brief Finds the entry for a topic, or else takes a free entry for it.
+ *
+ * @return The entry, or NULL if the topic is too long or the table is full.
+ */
+static MQTTSNTopic_t * prvTopicStore( MQTTSNClient_t * const pxClient,
+                                      const uint8_t * pucTopic,
+                                      uint16_t usTopicLength );
+
+/**
+ * @brief Checks whether a topic name matches a topic filter.
+ */
+static BaseType_t prvTopicMatches( const uint8_t * pucFilter,
+                                   uint16_t usFilterLength,
+                                   const uint8_t * pucTopic,
+                                   uint16_t usTopicLength );
+
+/**
+ * @brief Finds how to name a topic in a PUBLISH, registering it if needed.
+ */
+static MQTTAgentReturnCode_t prvGetTopicId( MQTTSNClient_t * const pxClient,
+                                            const uint8_t * pucTopic,
+                                            uint16_t usTopicLength,
+                                            uint8_t * pucIdType,
+                                            uint16_t * pusTopicId,
+                                            TimeOut_t * const pxTimeOut,
+                                            TickType_t * const pxTicksLeft );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The clients.
+ */
+static MQTTSNClient_t xMQTTSNClients[ mqttsnconfigMAX_CLIENTS ];
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvReadUInt16( const uint8_t * pucData )
+{
+    return ( uint16_t ) ( ( ( uint16_t ) pucData[ 0 ] << 8 ) | ( uint16_t ) pucData[ 1 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteUInt16( uint8_t * pucData,
+                            uint16_t usValue )
+{
+    pucData[ 0 ] = ( uint8_t ) ( usValue >> 8 );
+    pucData[ 1 ] = ( uint8_t ) ( usValue & 0xFFU );
+}
+/*-----------------------------------------------------------*/
+
+static MQTTSNClient_t * prvGetClient( MQTTSNHandle_t xHandle )
+{
+    UBaseType_t uxClientNumber = mqttsnDECODE_CLIENT_NUMBER( xHandle ); /*lint !e923 Opaque pointer. */
+    MQTTSNClient_t * pxClient = NULL;
+
+    if( ( xHandle != NULL ) &&
+        ( uxClientNumber < ( UBaseType_t ) mqttsnconfigMAX_CLIENTS ) &&
+        ( xMQTTSNClients[ uxClientNumber ].xInUse == pdTRUE ) )
+    {
+        pxClient = &( xMQTTSNClients[ uxClientNumber ] );
+    }
+
+    return pxClient;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTSNClient_t * prvTakeClient( MQTTSNHandle_t xHandle,
+                                       TickType_t xTimeoutTicks,
+                                       MQTTAgentReturnCode_t * pxReturnCode )
+{
+    MQTTSNClient_t * pxClient = prvGetClient( xHandle );
+
+    if( pxClient == NULL )
+    {
+        *pxReturnCode = eMQTTAgentFailure;
+    }
+    else if( pxClient->xCallbackTask == xTaskGetCurrentTaskHandle() )
+    {
+        /* The callbacks run while the mutex is held by this task. */
+        *pxReturnCode = eMQTTAgentAPICalledFromCallback;
+        pxClient = NULL;
+    }
+    else if( xSemaphoreTake( pxClient->xMutex, xTimeoutTicks ) != pdTRUE )
+    {
+        *pxReturnCode = eMQTTAgentTimeout;
+        pxClient = NULL;
+    }
+    else
+    {
+        *pxReturnCode = eMQTTAgentSuccess;
+    }
+
+    return pxClient;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvNextMessageId( MQTTSNClient_t * const pxClient )
+{
+    pxClient->usNextMessageId++;
+
+    if( pxClient->usNextMessageId == 0U )
+    {
+        pxClient->usNextMessageId = 1U;
+    }
+
+    return pxClient->usNextMessageId;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t * prvStartMessage( MQTTSNClient_t * const pxClient,
+                                  uint8_t ucType,
+                                  uint32_t ulBodyLength )
+{
+    uint8_t * pucBody = NULL;
+    uint32_t ulLength = ulBodyLength + 2U;
+
+    /* Messages of 256 bytes and more use three bytes for the length. */
+    if( ulLength > 255U )
+    {
+        ulLength += 2U;
+    }
+
+    if( ulLength <= ( uint32_t ) mqttsnconfigMAX_PACKET_SIZE )
+    {
+        if( ulLength <= 255U )
+        {
+            pxClient->ucTxBuffer[ 0 ] = ( uint8_t ) ulLength;
+            pxClient->ucTxBuffer[ 1 ] = ucType;
+            pucBody = &( pxClient->ucTxBuffer[ 2 ] );
+        }
+        else
+        {
+            pxClient->ucTxBuffer[ 0 ] = mqttsnLONG_LENGTH;
+            prvWriteUInt16( &( pxClient->ucTxBuffer[ 1 ] ), ( uint16_t ) ulLength );
+            pxClient->ucTxBuffer[ 3 ] = ucType;
+            pucBody = &( pxClient->ucTxBuffer[ 4 ] );
+        }
+
+        pxClient->ulTxLength = ulLength;
+        pxClient->pucTxFlags = NULL;
+    }
+
+    return pucBody;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendDatagram( MQTTSNClient_t * const pxClient,
+                                   const uint8_t * pucData,
+                                   uint32_t ulLength )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( pxClient->xTransport.pxSend( pxClient->xTransport.pvContext, pucData, ulLength ) == ( int32_t ) ulLength )
+    {
+        pxClient->xLastSendTime = xTaskGetTickCount();
+        xReturn = pdPASS;
+    }
+    else
+    {
+        mqttconfigDEBUG_LOG( ( "MQTT-SN transport failed to send %u bytes.\r\n", ( unsigned ) ulLength ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReceive( MQTTSNClient_t * const pxClient,
+                              TickType_t xTimeoutTicks )
+{
+    int32_t lReceived;
+    uint32_t ulLength, ulHeaderLength;
+    BaseType_t xReturn = mqttsnRX_NONE;
+
+    lReceived = pxClient->xTransport.pxRecv( pxClient->xTransport.pvContext,
+                                             pxClient->ucRxBuffer,
+                                             ( uint32_t ) sizeof( pxClient->ucRxBuffer ),
+                                             xTimeoutTicks );
+
+    if( lReceived < 0 )
+    {
+        xReturn = mqttsnRX_ERROR;
+    }
+    else if( lReceived >= 2 )
+    {
+        if( pxClient->ucRxBuffer[ 0 ] == mqttsnLONG_LENGTH )
+        {
+            ulLength = ( lReceived >= 4 ) ? ( uint32_t ) prvReadUInt16( &( pxClient->ucRxBuffer[ 1 ] ) ) : 0U;
+            ulHeaderLength = 3U;
+        }
+        else
+        {
+            ulLength = ( uint32_t ) pxClient->ucRxBuffer[ 0 ];
+            ulHeaderLength = 1U;
+        }
+
+        /* A datagram shorter than its length field is dropped, bytes after
+         * the message are ignored. */
+        if( ( ulLength > ulHeaderLength ) && ( ulLength <= ( uint32_t ) lReceived ) )
+        {
+            pxClient->ucRxType = pxClient->ucRxBuffer[ ulHeaderLength ];
+            pxClient->pucRxBody = &( pxClient->ucRxBuffer[ ulHeaderLength + 1U ] );
+            pxClient->ulRxBodyLength = ulLength - ulHeaderLength - 1U;
+            xReturn = mqttsnRX_MESSAGE;
+        }
+        else
+        {
+            mqttconfigDEBUG_LOG( ( "MQTT-SN dropped a malformed datagram.\r\n" ) );
+        }
+    }
+    else
+    {
+        /* Timeout, or a datagram too short to be a message. */
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsReply( const MQTTSNClient_t * const pxClient,
+                              uint8_t ucReplyType,
+                              uint16_t usMessageId )
+{
+    const uint8_t * pucBody = pxClient->pucRxBody;
+    uint32_t ulLength = pxClient->ulRxBodyLength;
+    BaseType_t xReturn = pdFALSE;
+
+    if( pxClient->ucRxType == ucReplyType )
+    {
+        switch( ucReplyType )
+        {
+            case mqttsnREGACK:
+            case mqttsnPUBACK:
+                /* Topic ID, message ID, return code. */
+                xReturn = ( ( ulLength >= 5U ) && ( prvReadUInt16( &( pucBody[ 2 ] ) ) == usMessageId ) ) ? pdTRUE : pdFALSE;
+                break;
+
+            case mqttsnSUBACK:
+                /* Flags, topic ID, message ID, return code. */
+                xReturn = ( ( ulLength >= 6U ) && ( prvReadUInt16( &( pucBody[ 3 ] ) ) == usMessageId ) ) ? pdTRUE : pdFALSE;
+                break;
+
+            case mqttsnUNSUBACK:
+                xReturn = ( ( ulLength >= 2U ) && ( prvReadUInt16( pucBody ) == usMessageId ) ) ? pdTRUE : pdFALSE;
+                break;
+
+            case mqttsnCONNACK:
+                xReturn = ( ulLength >= 1U ) ? pdTRUE : pdFALSE;
+                break;
+
+            default:
+                /* PINGRESP and DISCONNECT carry nothing to check. */
+                xReturn = pdTRUE;
+                break;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTAgentReturnCode_t prvSendAndWait( MQTTSNClient_t * const pxClient,
+                                             uint8_t ucReplyType,
+                                             uint16_t usMessageId,
+                                             TimeOut_t * const pxTimeOut,
+                                             TickType_t * const pxTicksLeft )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentTimeout;
+    BaseType_t xAttempt, xDone = pdFALSE, xReceived;
+    TickType_t xSendTime, xElapsed, xWait;
+
+    for( xAttempt = 0; ( xAttempt <= ( BaseType_t ) mqttsnconfigMAX_RETRIES ) && ( xDone == pdFALSE ); xAttempt++ )
+    {
+        if( ( xAttempt > 0 ) && ( pxClient->pucTxFlags != NULL ) )
+        {
+            *( pxClient->pucTxFlags ) |= mqttsnFLAG_DUP;
+        }
+
+        if( prvSendDatagram( pxClient, pxClient->ucTxBuffer, pxClient->ulTxLength ) != pdPASS )
+        {
+            xReturnCode = eMQTTAgentFailure;
+            break;
+        }
+
+        xSendTime = xTaskGetTickCount();
+
+        for( ; ; )
+        {
+            if( xTaskCheckForTimeOut( pxTimeOut, pxTicksLeft ) != pdFALSE )
+            {
+                xDone = pdTRUE;
+                break;
+            }
+
+            xElapsed = xTaskGetTickCount() - xSendTime;
+
+            if( xElapsed >= ( TickType_t ) mqttsnconfigRETRY_TICKS )
+            {
+                /* Send it again. */
+                break;
+            }
+
+            xWait = ( TickType_t ) mqttsnconfigRETRY_TICKS - xElapsed;
+
+            if( xWait > *pxTicksLeft )
+            {
+                xWait = *pxTicksLeft;
+            }
+
+            xReceived = prvReceive( pxClient, xWait );
+
+            if( xReceived == mqttsnRX_ERROR )
+            {
+                xReturnCode = eMQTTAgentFailure;
+                xDone = pdTRUE;
+                break;
+            }
+            else if( xReceived == mqttsnRX_MESSAGE )
+            {
+                if( prvIsReply( pxClient, ucReplyType, usMessageId ) == pdTRUE )
+                {
+                    xReturnCode = eMQTTAgentSuccess;
+                    xDone = pdTRUE;
+                    break;
+                }
+                else if( prvHandleGatewayMessage( pxClient ) == pdFAIL )
+                {
+                    xReturnCode = eMQTTAgentFailure;
+                    xDone = pdTRUE;
+                    break;
+                }
+                else
+                {
+                    /* Keep waiting. */
+                }
+            }
+            else
+            {
+                /* Nothing arrived in time. */
+            }
+        }
+    }
+
+    pxClient->pucTxFlags = NULL;
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHandleGatewayMessage( MQTTSNClient_t * const pxClient )
+{
+    const uint8_t * pucBody = pxClient->pucRxBody;
+    MQTTSNTopic_t * pxTopic;
+    uint8_t ucReturnCode, ucPingResponse[ 2 ];
+    BaseType_t xReturn = pdPASS;
+
+    switch( pxClient->ucRxType )
+    {
+        case mqttsnPUBLISH:
+            prvHandlePublish( pxClient );
+            break;
+
+        case mqttsnREGISTER:
+
+            /* The gateway names a topic that matches a wild card
+             * subscription, before it publishes on it. */
+            if( pxClient->ulRxBodyLength > 4U )
+            {
+                pxTopic = prvTopicStore( pxClient, &( pucBody[ 4 ] ), ( uint16_t ) ( pxClient->ulRxBodyLength - 4U ) );
+
+                if( pxTopic != NULL )
+                {
+                    pxTopic->usTopicId = prvReadUInt16( pucBody );
+                    pxTopic->ucFlags |= mqttsnENTRY_REGISTERED;
+                    ucReturnCode = mqttsnACCEPTED;
+                }
+                else
+                {
+                    mqttconfigDEBUG_LOG( ( "MQTT-SN topic table full, mqttsnconfigMAX_TOPICS is too small.\r\n" ) );
+                    ucReturnCode = mqttsnREJECTED_CONGESTION;
+                }
+
+                prvSendTopicAck( pxClient, mqttsnREGACK, prvReadUInt16( pucBody ), prvReadUInt16( &( pucBody[ 2 ] ) ), ucReturnCode );
+            }
+
+            break;
+
+        case mqttsnPINGREQ:
+            ucPingResponse[ 0 ] = 2U;
+            ucPingResponse[ 1 ] = mqttsnPINGRESP;
+            ( void ) prvSendDatagram( pxClient, ucPingResponse, sizeof( ucPingResponse ) );
+            break;
+
+        case mqttsnDISCONNECT:
+            prvConnectionLost( pxClient );
+            xReturn = pdFAIL;
+            break;
+
+        default:
+            /* Late replies to requests that were sent again, and messages
+             * that are not used by this client. */
+            break;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHandlePublish( MQTTSNClient_t * const pxClient )
+{
+    const uint8_t * pucBody = pxClient->pucRxBody;
+    MQTTSNTopic_t * pxTopic = NULL;
+    MQTTPublishData_t xPublishData;
+    uint8_t ucFlags, ucReturnCode = mqttsnACCEPTED;
+    uint16_t usTopicId, usMessageId;
+
+    /* Flags, topic ID, message ID, data. */
+    if( pxClient->ulRxBodyLength >= 5U )
+    {
+        ucFlags = pucBody[ 0 ];
+        usTopicId = prvReadUInt16( &( pucBody[ 1 ] ) );
+        usMessageId = prvReadUInt16( &( pucBody[ 3 ] ) );
+
+        xPublishData.xQos = ( ( ucFlags & mqttsnFLAG_QOS_MASK ) == mqttsnFLAG_QOS1 ) ? eMQTTQoS1 : eMQTTQoS0;
+        xPublishData.pvData = ( const void * ) &( pucBody[ 5 ] );
+        xPublishData.ulDataLength = pxClient->ulRxBodyLength - 5U;
+        xPublishData.xBuffer = NULL;
+        xPublishData.pucTopic = NULL;
+        xPublishData.usTopicLength = 0U;
+
+        switch( ucFlags & mqttsnFLAG_TOPIC_ID_MASK )
+        {
+            case mqttsnTOPIC_SHORT:
+                xPublishData.pucTopic = &( pucBody[ 1 ] );
+                xPublishData.usTopicLength = 2U;
+                break;
+
+            case mqttsnTOPIC_PREDEFINED:
+                pxTopic = prvTopicFindById( pxClient, usTopicId, mqttsnENTRY_PREDEFINED );
+                break;
+
+            case mqttsnTOPIC_NORMAL:
+                pxTopic = prvTopicFindById( pxClient, usTopicId, mqttsnENTRY_REGISTERED );
+                break;
+
+            default:
+                break;
+        }
+
+        if( pxTopic != NULL )
+        {
+            xPublishData.pucTopic = pxTopic->ucTopic;
+            xPublishData.usTopicLength = pxTopic->usTopicLength;
+        }
+
+        if( xPublishData.pucTopic != NULL )
+        {
+            prvDeliverPublish( pxClient, &xPublishData );
+        }
+        else
+        {
+            mqttconfigDEBUG_LOG( ( "MQTT-SN publish on unknown topic ID %u dropped.\r\n", ( unsigned ) usTopicId ) );
+            ucReturnCode = mqttsnREJECTED_INVALID_TOPIC;
+        }
+
+        if( xPublishData.xQos == eMQTTQoS1 )
+        {
+            prvSendTopicAck( pxClient, mqttsnPUBACK, usTopicId, usMessageId, ucReturnCode );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeliverPublish( MQTTSNClient_t * const pxClient,
+                               const MQTTPublishData_t * const pxPublishData )
+{
+    MQTTAgentCallbackParams_t xCallbackParams;
+    BaseType_t xDelivered = pdFALSE;
+
+    pxClient->xCallbackTask = xTaskGetCurrentTaskHandle();
+
+    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+        {
+            UBaseType_t uxIndex;
+            MQTTSNTopic_t * pxTopic;
+
+            /* The data lives in the receive buffer of the client, so the
+             * callbacks can not take ownership and their result is ignored. */
+            for( uxIndex = 0U; uxIndex < ( UBaseType_t ) mqttsnconfigMAX_TOPICS; uxIndex++ )
+            {
+                pxTopic = &( pxClient->xTopics[ uxIndex ] );
+
+                if( ( ( pxTopic->ucFlags & mqttsnENTRY_SUBSCRIBED ) != 0U ) &&
+                    ( pxTopic->pxPublishCallback != NULL ) &&
+                    ( prvTopicMatches( pxTopic->ucTopic, pxTopic->usTopicLength, pxPublishData->pucTopic, pxPublishData->usTopicLength ) == pdTRUE ) )
+                {
+                    ( void ) pxTopic->pxPublishCallback( pxTopic->pvPublishCallbackContext, pxPublishData );
+                    xDelivered = pdTRUE;
+                }
+            }
+        }
+    #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+    if( ( xDelivered == pdFALSE ) && ( pxClient->pxCallback != NULL ) )
+    {
+        xCallbackParams.xMQTTEvent = eMQTTAgentPublish;
+        xCallbackParams.u.xPublishData = *pxPublishData;
+        ( void ) pxClient->pxCallback( pxClient->pvUserData, &xCallbackParams );
+    }
+
+    pxClient->xCallbackTask = NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendTopicAck( MQTTSNClient_t * const pxClient,
+                             uint8_t ucType,
+                             uint16_t usTopicId,
+                             uint16_t usMessageId,
+                             uint8_t ucReturnCode )
+{
+    uint8_t ucAck[ mqttsnACK_BUFFER_SIZE ];
+
+    /* REGACK and PUBACK have the same layout. */
+    ucAck[ 0 ] = ( uint8_t ) mqttsnACK_BUFFER_SIZE;
+    ucAck[ 1 ] = ucType;
+    prvWriteUInt16( &( ucAck[ 2 ] ), usTopicId );
+    prvWriteUInt16( &( ucAck[ 4 ] ), usMessageId );
+    ucAck[ 6 ] = ucReturnCode;
+
+    ( void ) prvSendDatagram( pxClient, ucAck, sizeof( ucAck ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvClearSession( MQTTSNClient_t * const pxClient,
+                             BaseType_t xSubscriptions )
+{
+    UBaseType_t uxIndex;
+    uint8_t ucKeep = mqttsnENTRY_PREDEFINED;
+
+    if( xSubscriptions == pdFALSE )
+    {
+        ucKeep |= mqttsnENTRY_SUBSCRIBED;
+    }
+
+    for( uxIndex = 0U; uxIndex < ( UBaseType_t ) mqttsnconfigMAX_TOPICS; uxIndex++ )
+    {
+        pxClient->xTopics[ uxIndex ].ucFlags &= ucKeep;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvConnectionLost( MQTTSNClient_t * const pxClient )
+{
+    MQTTAgentCallbackParams_t xCallbackParams;
+
+    pxClient->xState = eMQTTSNDisconnected;
+    prvClearSession( pxClient, pdFALSE );
+
+    if( pxClient->pxCallback != NULL )
+    {
+        xCallbackParams.xMQTTEvent = eMQTTAgentDisconnect;
+        pxClient->xCallbackTask = xTaskGetCurrentTaskHandle();
+        ( void ) pxClient->pxCallback( pxClient->pvUserData, &xCallbackParams );
+        pxClient->xCallbackTask = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static MQTTAgentReturnCode_t prvConnect( MQTTSNClient_t * const pxClient,
+                                         BaseType_t xCleanSession,
+                                         TimeOut_t * const pxTimeOut,
+                                         TickType_t * const pxTicksLeft )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+    uint8_t * pucBody;
+
+    /* Flags, protocol ID, duration, client ID. */
+    pucBody = prvStartMessage( pxClient, mqttsnCONNECT, 4U + ( uint32_t ) pxClient->usClientIdLength );
+
+    if( pucBody != NULL )
+    {
+        pucBody[ 0 ] = ( xCleanSession != pdFALSE ) ? mqttsnFLAG_CLEAN_SESSION : 0U;
+        pucBody[ 1 ] = mqttsnPROTOCOL_ID;
+        prvWriteUInt16( &( pucBody[ 2 ] ), pxClient->usKeepAliveSeconds );
+        memcpy( &( pucBody[ 4 ] ), pxClient->ucClientId, pxClient->usClientIdLength );
+
+        xReturnCode = prvSendAndWait( pxClient, mqttsnCONNACK, 0U, pxTimeOut, pxTicksLeft );
+
+        if( xReturnCode == eMQTTAgentSuccess )
+        {
+            if( pxClient->pucRxBody[ 0 ] == mqttsnACCEPTED )
+            {
+                pxClient->xState = eMQTTSNActive;
+            }
+            else
+            {
+                mqttconfigDEBUG_LOG( ( "MQTT-SN gateway refused the connection, return code %u.\r\n", ( unsigned ) pxClient->pucRxBody[ 0 ] ) );
+                xReturnCode = eMQTTAgentFailure;
+            }
+        }
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTAgentReturnCode_t prvMakeActive( MQTTSNClient_t * const pxClient,
+                                            TimeOut_t * const pxTimeOut,
+                                            TickType_t * const pxTicksLeft )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+
+    if( pxClient->xState == eMQTTSNActive )
+    {
+        xReturnCode = eMQTTAgentSuccess;
+    }
+    else if( pxClient->xState == eMQTTSNAsleep )
+    {
+        /* The gateway kept the session while the client slept. */
+        xReturnCode = prvConnect( pxClient, pdFALSE, pxTimeOut, pxTicksLeft );
+    }
+    else
+    {
+        xReturnCode = eMQTTAgentFailure;
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTSNTopic_t * prvTopicFind( MQTTSNClient_t * const pxClient,
+                                     const uint8_t * pucTopic,
+                                     uint16_t usTopicLength )
+{
+    UBaseType_t uxIndex;
+    MQTTSNTopic_t * pxTopic, * pxReturn = NULL;
+
+    for( uxIndex = 0U; uxIndex < ( UBaseType_t ) mqttsnconfigMAX_TOPICS; uxIndex++ )
+    {
+        pxTopic = &( pxClient->xTopics[ uxIndex ] );
+
+        if( ( pxTopic->ucFlags != 0U ) &&
+            ( pxTopic->usTopicLength == usTopicLength ) &&
+            ( memcmp( pxTopic->ucTopic, pucTopic, usTopicLength ) == 0 ) )
+        {
+            pxReturn = pxTopic;
+            break;
+        }
+    }
+
+    return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTSNTopic_t * prvTopicFindById( MQTTSNClient_t * const pxClient,
+                                         uint16_t usTopicId,
+                                         uint8_t ucFlag )
+{
+    UBaseType_t uxIndex;
+    MQTTSNTopic_t * pxTopic, * pxReturn = NULL;
+
+    for( uxIndex = 0U; uxIndex < ( UBaseType_t ) mqttsnconfigMAX_TOPICS; uxIndex++ )
+    {
+        pxTopic = &( pxClient->xTopics[ uxIndex ] );
+
+        if( ( ( pxTopic->ucFlags & ucFlag ) != 0U ) && ( pxTopic->usTopicId == usTopicId ) )
+        {
+            pxReturn = pxTopic;
+            break;
+        }
+    }
+
+    return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTSNTopic_t * prvTopicStore( MQTTSNClient_t * const pxClient,
+                                      const uint8_t * pucTopic,
+                                      uint16_t usTopicLength )
+{
+    UBaseType_t uxIndex;
+    MQTTSNTopic_t * pxTopic = NULL;
+
+    if( usTopicLength <= ( uint16_t ) mqttsnconfigMAX_TOPIC_LENGTH )
+    {
+        pxTopic = prvTopicFind( pxClient, pucTopic, usTopicLength );
+
+        for( uxIndex = 0U; ( pxTopic == NULL ) && ( uxIndex < ( UBaseType_t ) mqttsnconfigMAX_TOPICS ); uxIndex++ )
+        {
+            if( pxClient->xTopics[ uxIndex ].ucFlags == 0U )
+            {
+                pxTopic = &( pxClient->xTopics[ uxIndex ] );
+                memset( pxTopic, 0x00, sizeof( MQTTSNTopic_t ) );
+                memcpy( pxTopic->ucTopic, pucTopic, usTopicLength );
+                pxTopic->usTopicLength = usTopicLength;
+            }
+        }
+    }
+
+    return pxTopic;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvTopicMatches( const uint8_t * pucFilter,
+                                   uint16_t usFilterLength,
+                                   const uint8_t * pucTopic,
+                                   uint16_t usTopicLength )
+{
+    uint16_t usFilterIndex = 0U, usTopicIndex = 0U;
+    BaseType_t xMatch = pdFALSE;
+
+    for( ; ; )
+    {
+        if( usFilterIndex == usFilterLength )
+        {
+            xMatch = ( usTopicIndex == usTopicLength ) ? pdTRUE : pdFALSE;
+            break;
+        }
+        else if( pucFilter[ usFilterIndex ] == ( uint8_t ) '#' )
+        {
+            /* Matches the rest of the topic. */
+            xMatch = pdTRUE;
+            break;
+        }
+        else if( pucFilter[ usFilterIndex ] == ( uint8_t ) '+' )
+        {
+            /* Matches one level. */
+            while( ( usTopicIndex < usTopicLength ) && ( pucTopic[ usTopicIndex ] != ( uint8_t ) '/' ) )
+            {
+                usTopicIndex++;
+            }
+
+            usFilterIndex++;
+        }
+        else if( usTopicIndex == usTopicLength )
+        {
+            /* "a/#" also matches "a". */
+            xMatch = ( ( ( usFilterLength - usFilterIndex ) == 2U ) &&
+                       ( pucFilter[ usFilterIndex ] == ( uint8_t ) '/' ) &&
+                       ( pucFilter[ usFilterIndex + 1U ] == ( uint8_t ) '#' ) ) ? pdTRUE : pdFALSE;
+            break;
+        }
+        else if( pucFilter[ usFilterIndex ] == pucTopic[ usTopicIndex ] )
+        {
+            usFilterIndex++;
+            usTopicIndex++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return xMatch;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTAgentReturnCode_t prvGetTopicId( MQTTSNClient_t * const pxClient,
+                                            const uint8_t * pucTopic,
+                                            uint16_t usTopicLength,
+                                            uint8_t * pucIdType,
+                                            uint16_t * pusTopicId,
+                                            TimeOut_t * const pxTimeOut,
+                                            TickType_t * const pxTicksLeft )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentSuccess;
+    MQTTSNTopic_t * pxTopic = prvTopicFind( pxClient, pucTopic, usTopicLength );
+    uint16_t usMessageId;
+    uint8_t * pucBody;
+
+    if( ( pxTopic != NULL ) && ( ( pxTopic->ucFlags & mqttsnENTRY_PREDEFINED ) != 0U ) )
+    {
+        *pucIdType = mqttsnTOPIC_PREDEFINED;
+        *pusTopicId = pxTopic->usTopicId;
+    }
+    else if( usTopicLength == 2U )
+    {
+        *pucIdType = mqttsnTOPIC_SHORT;
+        *pusTopicId = prvReadUInt16( pucTopic );
+    }
+    else if( ( pxTopic != NULL ) && ( ( pxTopic->ucFlags & mqttsnENTRY_REGISTERED ) != 0U ) )
+    {
+        *pucIdType = mqttsnTOPIC_NORMAL;
+        *pusTopicId = pxTopic->usTopicId;
+    }
+    else
+    {
+        /* Ask the gateway for a topic ID. The entry is marked, so that a
+         * REGISTER from the gateway does not take it in the mean time. */
+        pxTopic = prvTopicStore( pxClient, pucTopic, usTopicLength );
+        pucBody = prvStartMessage( pxClient, mqttsnREGISTER, 4U + ( uint32_t ) usTopicLength );
+
+        if( ( pxTopic == NULL ) || ( pucBody == NULL ) )
+        {
+            mqttconfigDEBUG_LOG( ( "MQTT-SN can not register the topic, it is too long or the table is full.\r\n" ) );
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            pxTopic->ucFlags |= mqttsnENTRY_PENDING;
+            usMessageId = prvNextMessageId( pxClient );
+
+            /* Topic ID, message ID, topic name. */
+            prvWriteUInt16( pucBody, 0U );
+            prvWriteUInt16( &( pucBody[ 2 ] ), usMessageId );
+            memcpy( &( pucBody[ 4 ] ), pucTopic, usTopicLength );
+
+            xReturnCode = prvSendAndWait( pxClient, mqttsnREGACK, usMessageId, pxTimeOut, pxTicksLeft );
+
+            if( ( xReturnCode == eMQTTAgentSuccess ) && ( pxClient->pucRxBody[ 4 ] == mqttsnACCEPTED ) )
+            {
+                pxTopic->usTopicId = prvReadUInt16( pxClient->pucRxBody );
+                pxTopic->ucFlags |= mqttsnENTRY_REGISTERED;
+                *pucIdType = mqttsnTOPIC_NORMAL;
+                *pusTopicId = pxTopic->usTopicId;
+            }
+            else if( xReturnCode == eMQTTAgentSuccess )
+            {
+                mqttconfigDEBUG_LOG( ( "MQTT-SN gateway refused to register the topic, return code %u.\r\n", ( unsigned ) pxClient->pucRxBody[ 4 ] ) );
+                xReturnCode = eMQTTAgentFailure;
+            }
+            else
+            {
+                /* Timeout or failure. */
+            }
+
+            pxTopic->ucFlags &= ( uint8_t ) ~mqttsnENTRY_PENDING;
+        }
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Create( MQTTSNHandle_t * const pxHandle )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+    SemaphoreHandle_t xMutex;
+    BaseType_t xClientNumber = -1, x;
+
+    configASSERT( pxHandle != NULL );
+
+    xMutex = xSemaphoreCreateMutex();
+
+    if( xMutex != NULL )
+    {
+        taskENTER_CRITICAL();
+        {
+            for( x = 0; x < ( BaseType_t ) mqttsnconfigMAX_CLIENTS; x++ )
+            {
+                if( xMQTTSNClients[ x ].xInUse == pdFALSE )
+                {
+                    xMQTTSNClients[ x ].xInUse = pdTRUE;
+                    xClientNumber = x;
+                    break;
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( xClientNumber >= 0 )
+        {
+            /* Only the xInUse field is shared, the rest is owned by this
+             * task until the handle is returned. */
+            memset( &( xMQTTSNClients[ xClientNumber ] ), 0x00, sizeof( MQTTSNClient_t ) );
+            xMQTTSNClients[ xClientNumber ].xInUse = pdTRUE;
+            xMQTTSNClients[ xClientNumber ].xMutex = xMutex;
+            xMQTTSNClients[ xClientNumber ].xState = eMQTTSNDisconnected;
+
+            *pxHandle = ( MQTTSNHandle_t ) mqttsnENCODE_CLIENT_NUMBER( xClientNumber ); /*lint !e923 Opaque pointer. */
+            xReturnCode = eMQTTAgentSuccess;
+        }
+        else
+        {
+            mqttconfigDEBUG_LOG( ( "No free MQTT-SN client available.\r\n" ) );
+            vSemaphoreDelete( xMutex );
+        }
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Delete( MQTTSNHandle_t xHandle )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient = prvTakeClient( xHandle, portMAX_DELAY, &xReturnCode );
+    SemaphoreHandle_t xMutex;
+
+    if( pxClient != NULL )
+    {
+        xMutex = pxClient->xMutex;
+        pxClient->xMutex = NULL;
+        pxClient->xInUse = pdFALSE;
+        ( void ) xSemaphoreGive( xMutex );
+        vSemaphoreDelete( xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Connect( MQTTSNHandle_t xHandle,
+                                       const MQTTSNConnectParams_t * const pxConnectParams,
+                                       TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+
+    configASSERT( pxConnectParams != NULL );
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( ( pxClient->xState != eMQTTSNDisconnected ) ||
+            ( pxConnectParams->xTransport.pxSend == NULL ) ||
+            ( pxConnectParams->xTransport.pxRecv == NULL ) ||
+            ( pxConnectParams->usClientIdLength == 0U ) ||
+            ( pxConnectParams->usClientIdLength > ( uint16_t ) mqttsnMAX_CLIENT_ID_LENGTH ) )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            pxClient->xTransport = pxConnectParams->xTransport;
+            memcpy( pxClient->ucClientId, pxConnectParams->pucClientId, pxConnectParams->usClientIdLength );
+            pxClient->usClientIdLength = pxConnectParams->usClientIdLength;
+            pxClient->usKeepAliveSeconds = pxConnectParams->usKeepAliveSeconds;
+            pxClient->pvUserData = pxConnectParams->pvUserData;
+            pxClient->pxCallback = pxConnectParams->pxCallback;
+
+            if( pxConnectParams->xCleanSession != pdFALSE )
+            {
+                prvClearSession( pxClient, pdTRUE );
+            }
+
+            xReturnCode = prvConnect( pxClient, pxConnectParams->xCleanSession, &xTimeOut, &xTicksLeft );
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Disconnect( MQTTSNHandle_t xHandle,
+                                          TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( pxClient->xState == eMQTTSNDisconnected )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            ( void ) prvStartMessage( pxClient, mqttsnDISCONNECT, 0U );
+            xReturnCode = prvSendAndWait( pxClient, mqttsnDISCONNECT, 0U, &xTimeOut, &xTicksLeft );
+
+            pxClient->xState = eMQTTSNDisconnected;
+            prvClearSession( pxClient, pdFALSE );
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_RegisterPredefinedTopic( MQTTSNHandle_t xHandle,
+                                                       const uint8_t * pucTopic,
+                                                       uint16_t usTopicLength,
+                                                       uint16_t usTopicId )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    MQTTSNTopic_t * pxTopic;
+
+    pxClient = prvTakeClient( xHandle, portMAX_DELAY, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        pxTopic = prvTopicStore( pxClient, pucTopic, usTopicLength );
+
+        if( pxTopic != NULL )
+        {
+            /* The predefined ID replaces a registered one. */
+            pxTopic->usTopicId = usTopicId;
+            pxTopic->ucFlags = ( uint8_t ) ( ( pxTopic->ucFlags & ( uint8_t ) ~mqttsnENTRY_REGISTERED ) | mqttsnENTRY_PREDEFINED );
+        }
+        else
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Publish( MQTTSNHandle_t xHandle,
+                                       const MQTTAgentPublishParams_t * const pxPublishParams,
+                                       TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    MQTTSNTopic_t * pxTopic;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+    uint8_t ucIdType = mqttsnTOPIC_NORMAL, * pucBody;
+    uint16_t usTopicId = 0U, usMessageId = 0U;
+
+    configASSERT( pxPublishParams != NULL );
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( ( pxPublishParams->xQoS == eMQTTQoS2 ) || ( pxPublishParams->usTopicLength == 0U ) )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            xReturnCode = prvMakeActive( pxClient, &xTimeOut, &xTicksLeft );
+        }
+
+        if( xReturnCode == eMQTTAgentSuccess )
+        {
+            xReturnCode = prvGetTopicId( pxClient, pxPublishParams->pucTopic, pxPublishParams->usTopicLength, &ucIdType, &usTopicId, &xTimeOut, &xTicksLeft );
+        }
+
+        if( xReturnCode == eMQTTAgentSuccess )
+        {
+            /* Flags, topic ID, message ID, data. */
+            pucBody = prvStartMessage( pxClient, mqttsnPUBLISH, 5U + pxPublishParams->ulDataLength );
+
+            if( pucBody == NULL )
+            {
+                mqttconfigDEBUG_LOG( ( "MQTT-SN publish does not fit in mqttsnconfigMAX_PACKET_SIZE.\r\n" ) );
+                xReturnCode = eMQTTAgentFailure;
+            }
+            else
+            {
+                if( pxPublishParams->xQoS == eMQTTQoS1 )
+                {
+                    usMessageId = prvNextMessageId( pxClient );
+                    pucBody[ 0 ] = ( uint8_t ) ( mqttsnFLAG_QOS1 | ucIdType );
+                }
+                else
+                {
+                    pucBody[ 0 ] = ucIdType;
+                }
+
+                prvWriteUInt16( &( pucBody[ 1 ] ), usTopicId );
+                prvWriteUInt16( &( pucBody[ 3 ] ), usMessageId );
+                memcpy( &( pucBody[ 5 ] ), pxPublishParams->pvData, pxPublishParams->ulDataLength );
+
+                if( pxPublishParams->xQoS == eMQTTQoS0 )
+                {
+                    xReturnCode = ( prvSendDatagram( pxClient, pxClient->ucTxBuffer, pxClient->ulTxLength ) == pdPASS ) ? eMQTTAgentSuccess : eMQTTAgentFailure;
+                }
+                else
+                {
+                    pxClient->pucTxFlags = pucBody;
+                    xReturnCode = prvSendAndWait( pxClient, mqttsnPUBACK, usMessageId, &xTimeOut, &xTicksLeft );
+
+                    if( ( xReturnCode == eMQTTAgentSuccess ) && ( pxClient->pucRxBody[ 4 ] != mqttsnACCEPTED ) )
+                    {
+                        mqttconfigDEBUG_LOG( ( "MQTT-SN gateway refused the publish, return code %u.\r\n", ( unsigned ) pxClient->pucRxBody[ 4 ] ) );
+
+                        if( ( pxClient->pucRxBody[ 4 ] == mqttsnREJECTED_INVALID_TOPIC ) && ( ucIdType == mqttsnTOPIC_NORMAL ) )
+                        {
+                            /* The gateway lost the registration, the next
+                             * publish registers the topic again. */
+                            pxTopic = prvTopicFind( pxClient, pxPublishParams->pucTopic, pxPublishParams->usTopicLength );
+
+                            if( pxTopic != NULL )
+                            {
+                                pxTopic->ucFlags &= ( uint8_t ) ~mqttsnENTRY_REGISTERED;
+                            }
+                        }
+
+                        xReturnCode = eMQTTAgentFailure;
+                    }
+                }
+            }
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Subscribe( MQTTSNHandle_t xHandle,
+                                         const MQTTAgentSubscribeParams_t * const pxSubscribeParams,
+                                         TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    MQTTSNTopic_t * pxTopic = NULL;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+    uint8_t ucIdType, ucWasSubscribed = 0U, * pucBody = NULL;
+    uint16_t usMessageId, usTopicId;
+    uint32_t ulNameLength;
+
+    configASSERT( pxSubscribeParams != NULL );
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( pxSubscribeParams->xQoS == eMQTTQoS2 )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            xReturnCode = prvMakeActive( pxClient, &xTimeOut, &xTicksLeft );
+        }
+
+        if( xReturnCode == eMQTTAgentSuccess )
+        {
+            /* The entry holds the callback, and is marked before sending so
+             * that it can not be taken while waiting for SUBACK. */
+            pxTopic = prvTopicStore( pxClient, pxSubscribeParams->pucTopic, pxSubscribeParams->usTopicLength );
+
+            if( pxTopic == NULL )
+            {
+                mqttconfigDEBUG_LOG( ( "MQTT-SN can not subscribe, the topic is too long or the table is full.\r\n" ) );
+                xReturnCode = eMQTTAgentFailure;
+            }
+            else
+            {
+                ucWasSubscribed = pxTopic->ucFlags & mqttsnENTRY_SUBSCRIBED;
+                pxTopic->ucFlags |= mqttsnENTRY_SUBSCRIBED;
+
+                if( ( pxTopic->ucFlags & mqttsnENTRY_PREDEFINED ) != 0U )
+                {
+                    ucIdType = mqttsnTOPIC_PREDEFINED;
+                    ulNameLength = 2U;
+                }
+                else if( ( pxSubscribeParams->usTopicLength == 2U ) &&
+                         ( pxSubscribeParams->pucTopic[ 0 ] != ( uint8_t ) '+' ) && ( pxSubscribeParams->pucTopic[ 0 ] != ( uint8_t ) '#' ) &&
+                         ( pxSubscribeParams->pucTopic[ 1 ] != ( uint8_t ) '+' ) && ( pxSubscribeParams->pucTopic[ 1 ] != ( uint8_t ) '#' ) )
+                {
+                    ucIdType = mqttsnTOPIC_SHORT;
+                    ulNameLength = 2U;
+                }
+                else
+                {
+                    ucIdType = mqttsnTOPIC_NORMAL;
+                    ulNameLength = pxSubscribeParams->usTopicLength;
+                }
+
+                /* Flags, message ID, topic name or topic ID. */
+                pucBody = prvStartMessage( pxClient, mqttsnSUBSCRIBE, 3U + ulNameLength );
+
+                if( pucBody == NULL )
+                {
+                    xReturnCode = eMQTTAgentFailure;
+                }
+            }
+        }
+
+        if( pucBody != NULL )
+        {
+            usMessageId = prvNextMessageId( pxClient );
+            pucBody[ 0 ] = ( uint8_t ) ( ( ( pxSubscribeParams->xQoS == eMQTTQoS1 ) ? mqttsnFLAG_QOS1 : 0U ) | ucIdType );
+            prvWriteUInt16( &( pucBody[ 1 ] ), usMessageId );
+
+            if( ucIdType == mqttsnTOPIC_PREDEFINED )
+            {
+                prvWriteUInt16( &( pucBody[ 3 ] ), pxTopic->usTopicId );
+            }
+            else
+            {
+                memcpy( &( pucBody[ 3 ] ), pxSubscribeParams->pucTopic, ulNameLength );
+            }
+
+            pxClient->pucTxFlags = pucBody;
+            xReturnCode = prvSendAndWait( pxClient, mqttsnSUBACK, usMessageId, &xTimeOut, &xTicksLeft );
+
+            if( ( xReturnCode == eMQTTAgentSuccess ) && ( pxClient->pucRxBody[ 5 ] != mqttsnACCEPTED ) )
+            {
+                mqttconfigDEBUG_LOG( ( "MQTT-SN gateway refused the subscription, return code %u.\r\n", ( unsigned ) pxClient->pucRxBody[ 5 ] ) );
+                xReturnCode = eMQTTAgentFailure;
+            }
+
+            if( xReturnCode == eMQTTAgentSuccess )
+            {
+                /* A topic name without wild cards gets an ID, which the
+                 * gateway uses in the publishes and may be published to. */
+                usTopicId = prvReadUInt16( &( pxClient->pucRxBody[ 1 ] ) );
+
+                if( ( ucIdType == mqttsnTOPIC_NORMAL ) && ( usTopicId != 0U ) )
+                {
+                    pxTopic->usTopicId = usTopicId;
+                    pxTopic->ucFlags |= mqttsnENTRY_REGISTERED;
+                }
+
+                #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+                    {
+                        pxTopic->pvPublishCallbackContext = pxSubscribeParams->pvPublishCallbackContext;
+                        pxTopic->pxPublishCallback = pxSubscribeParams->pxPublishCallback;
+                    }
+                #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+            }
+        }
+
+        if( ( xReturnCode != eMQTTAgentSuccess ) && ( pxTopic != NULL ) )
+        {
+            pxTopic->ucFlags = ( uint8_t ) ( ( pxTopic->ucFlags & ( uint8_t ) ~mqttsnENTRY_SUBSCRIBED ) | ucWasSubscribed );
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Unsubscribe( MQTTSNHandle_t xHandle,
+                                           const MQTTAgentUnsubscribeParams_t * const pxUnsubscribeParams,
+                                           TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    MQTTSNTopic_t * pxTopic;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+    uint8_t ucIdType = mqttsnTOPIC_NORMAL, * pucBody = NULL;
+    uint16_t usMessageId;
+
+    configASSERT( pxUnsubscribeParams != NULL );
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        xReturnCode = prvMakeActive( pxClient, &xTimeOut, &xTicksLeft );
+        pxTopic = prvTopicFind( pxClient, pxUnsubscribeParams->pucTopic, pxUnsubscribeParams->usTopicLength );
+
+        if( xReturnCode == eMQTTAgentSuccess )
+        {
+            if( ( pxTopic != NULL ) && ( ( pxTopic->ucFlags & mqttsnENTRY_PREDEFINED ) != 0U ) )
+            {
+                ucIdType = mqttsnTOPIC_PREDEFINED;
+                pucBody = prvStartMessage( pxClient, mqttsnUNSUBSCRIBE, 5U );
+
+                if( pucBody != NULL )
+                {
+                    prvWriteUInt16( &( pucBody[ 3 ] ), pxTopic->usTopicId );
+                }
+            }
+            else
+            {
+                if( pxUnsubscribeParams->usTopicLength == 2U )
+                {
+                    ucIdType = mqttsnTOPIC_SHORT;
+                }
+
+                pucBody = prvStartMessage( pxClient, mqttsnUNSUBSCRIBE, 3U + ( uint32_t ) pxUnsubscribeParams->usTopicLength );
+
+                if( pucBody != NULL )
+                {
+                    memcpy( &( pucBody[ 3 ] ), pxUnsubscribeParams->pucTopic, pxUnsubscribeParams->usTopicLength );
+                }
+            }
+
+            if( pucBody == NULL )
+            {
+                xReturnCode = eMQTTAgentFailure;
+            }
+        }
+
+        if( pucBody != NULL )
+        {
+            /* Flags, message ID, topic name or topic ID. */
+            usMessageId = prvNextMessageId( pxClient );
+            pucBody[ 0 ] = ucIdType;
+            prvWriteUInt16( &( pucBody[ 1 ] ), usMessageId );
+
+            pxClient->pucTxFlags = pucBody;
+            xReturnCode = prvSendAndWait( pxClient, mqttsnUNSUBACK, usMessageId, &xTimeOut, &xTicksLeft );
+
+            /* The gateway may have registered a topic in the mean time. */
+            pxTopic = prvTopicFind( pxClient, pxUnsubscribeParams->pucTopic, pxUnsubscribeParams->usTopicLength );
+
+            if( ( xReturnCode == eMQTTAgentSuccess ) && ( pxTopic != NULL ) )
+            {
+                pxTopic->ucFlags &= ( uint8_t ) ~mqttsnENTRY_SUBSCRIBED;
+            }
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Sleep( MQTTSNHandle_t xHandle,
+                                     uint16_t usDurationSeconds,
+                                     TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+    uint8_t * pucBody;
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( pxClient->xState == eMQTTSNDisconnected )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            /* A DISCONNECT with a duration. */
+            pucBody = prvStartMessage( pxClient, mqttsnDISCONNECT, 2U );
+            prvWriteUInt16( pucBody, usDurationSeconds );
+
+            xReturnCode = prvSendAndWait( pxClient, mqttsnDISCONNECT, 0U, &xTimeOut, &xTicksLeft );
+
+            if( xReturnCode == eMQTTAgentSuccess )
+            {
+                pxClient->xState = eMQTTSNAsleep;
+            }
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_Wake( MQTTSNHandle_t xHandle,
+                                    TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    TimeOut_t xTimeOut;
+    TickType_t xTicksLeft = xTimeoutTicks;
+    uint8_t * pucBody;
+
+    vTaskSetTimeOutState( &xTimeOut );
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( pxClient->xState != eMQTTSNAsleep )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            /* A PINGREQ with the client ID asks for the buffered publishes,
+             * which come before the PINGRESP. */
+            pucBody = prvStartMessage( pxClient, mqttsnPINGREQ, pxClient->usClientIdLength );
+            memcpy( pucBody, pxClient->ucClientId, pxClient->usClientIdLength );
+
+            xReturnCode = prvSendAndWait( pxClient, mqttsnPINGRESP, 0U, &xTimeOut, &xTicksLeft );
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_SN_ProcessIncoming( MQTTSNHandle_t xHandle,
+                                               TickType_t xTimeoutTicks )
+{
+    MQTTAgentReturnCode_t xReturnCode;
+    MQTTSNClient_t * pxClient;
+    BaseType_t xReceived;
+    TickType_t xWait = xTimeoutTicks;
+    uint8_t ucPing[ 2 ];
+
+    pxClient = prvTakeClient( xHandle, xTimeoutTicks, &xReturnCode );
+
+    if( pxClient != NULL )
+    {
+        if( pxClient->xState != eMQTTSNActive )
+        {
+            xReturnCode = eMQTTAgentFailure;
+        }
+        else
+        {
+            if( ( pxClient->usKeepAliveSeconds != 0U ) &&
+                ( ( xTaskGetTickCount() - pxClient->xLastSendTime ) >= ( ( TickType_t ) pxClient->usKeepAliveSeconds * ( TickType_t ) configTICK_RATE_HZ ) ) )
+            {
+                /* The PINGRESP is consumed below like any other message. */
+                ucPing[ 0 ] = 2U;
+                ucPing[ 1 ] = mqttsnPINGREQ;
+                ( void ) prvSendDatagram( pxClient, ucPing, sizeof( ucPing ) );
+            }
+
+            xReturnCode = eMQTTAgentTimeout;
+
+            /* Wait for the first datagram, then take the ones that are
+             * already there. */
+            for( ; ; )
+            {
+                xReceived = prvReceive( pxClient, xWait );
+
+                if( xReceived == mqttsnRX_ERROR )
+                {
+                    xReturnCode = eMQTTAgentFailure;
+                    break;
+                }
+                else if( xReceived == mqttsnRX_NONE )
+                {
+                    break;
+                }
+                else
+                {
+                    xReturnCode = eMQTTAgentSuccess;
+                    xWait = 0U;
+
+                    if( prvHandleGatewayMessage( pxClient ) == pdFAIL )
+                    {
+                        xReturnCode = eMQTTAgentFailure;
+                        break;
+                    }
+                }
+            }
+        }
+
+        ( void ) xSemaphoreGive( pxClient->xMutex );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
@@ -37,6 +37,7 @@
 #include "aws_ota_cbor.h"
 #include "aws_application_version.h"
 #include "aws_ota_agent_config.h"
+#include "aws_ota_agent_config_defaults.h"
 
 /* Internal header file for shared definitions. */
 #include "aws_ota_agent_internal.h"
@@ -55,6 +56,40 @@
 #include "jsmn.h" /*lint !e537 All headers have multiple inclusion prevention. */
 #include "mbedtls/base64.h"
 
+/* JSON status message writer includes. */
+#include "aws_json_writer.h"
+
+#if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+    #include "aws_crypto.h"
+#endif
+
+#if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+    #include "aws_ota_delta.h"
+#endif
+
+#if ( otaconfigENABLE_COMPRESSED_UPDATE == 1 )
+    #include "aws_ota_decompress.h"
+#endif
+
+#if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+    #include "aws_ota_http.h"
+#endif
+
+#if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
+    #if ( otaconfigENABLE_HTTP_DATA_PLANE != 1 )
+        #error "otaconfigENABLE_GREENGRASS_CACHE requires otaconfigENABLE_HTTP_DATA_PLANE."
+    #endif
+    #include "aws_greengrass_discovery.h"
+#endif
+
+#if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U ) && ( otaconfigMAX_BLOCKS_IN_FLIGHT == 0U )
+    #error "otaconfigMAX_BLOCKS_PER_SECOND requires otaconfigMAX_BLOCKS_IN_FLIGHT."
+#endif
+
+#if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U ) && ( otaconfigMAX_BLOCKS_PER_SECOND == 0U )
+    #error "otaconfigBACKOFF_MQTT_LATENCY_MS requires otaconfigMAX_BLOCKS_PER_SECOND."
+#endif
+
 /* Returns the byte offset of the element 'e' in the typedef structure 't'.
  * Setting an arbitrarily large base of 0x10000 and masking off that base allows
  * us to do the same thing as a zero offset without the lint warnings of using a
@@ -66,12 +101,13 @@
 /* General constants. */
 #define OTA_MAX_JSON_STR_LEN               256U             /* Limit our JSON string compares to something small to avoid going into the weeds. */
 #define OTA_ERASED_BLOCKS_VAL              0xffU            /* The starting state of a group of erased blocks in the Rx block bitmap. */
-#define OTA_MAX_FILES                      1U               /* [MUST REMAIN 1! Future support.] Maximum number of concurrent OTA files. */
-#define OTA_NUM_MSG_Q_ENTRIES              6U               /* Maximum number of entries in the OTA message queue. */
+#define OTA_MAX_FILES                      otaconfigMAX_FILES_PER_JOB /* Maximum number of files of one job. They are received one after the other. */
+#define OTA_NUM_MSG_Q_ENTRIES              otaconfigMSG_QUEUE_LENGTH /* Maximum number of entries in the OTA message queue. */
 #define OTA_SUBSCRIBE_WAIT_TICKS           pdMS_TO_TICKS( 30000UL )
 #define OTA_UNSUBSCRIBE_WAIT_TICKS         pdMS_TO_TICKS( 1000UL )
 #define OTA_PUBLISH_WAIT_TICKS             pdMS_TO_TICKS( 10000UL )
 #define OTA_MAX_STREAM_REQUEST_MOMENTUM    32U              /* Max number of stream requests allowed without a response before we abort. */
+#define OTA_MIN_REQUEST_WAIT_TICKS         pdMS_TO_TICKS( 200UL ) /* Lower bound of the request timeout derived from the measured block round trip. */
 #define U32_MAX_PLACES                     10U              /* Maximum number of output digits of an unsigned long value. */
 
 /* OTA Agent task event flags. */
@@ -84,12 +120,16 @@
 /* Stream GET message constants. */
 
 #define OTA_CLIENT_TOKEN             "rdy"              /* Arbitrary client token sent in the stream "GET" message. */
-#define OTA_MAX_BLOCK_BITMAP_SIZE    128U               /* Max allowed number of bytes to track all blocks of an OTA file. Adjust block size if more range is needed. */
+#define OTA_MAX_BLOCK_BITMAP_SIZE    128U               /* Max number of bytes of the block bitmap. Larger files are tracked by sliding the bitmap over the file. */
 #define OTA_REQUEST_MSG_MAX_SIZE     ( 3U * OTA_MAX_BLOCK_BITMAP_SIZE )
 
 /* Agent to Job Service status message constants. */
 
-#define OTA_STATUS_MSG_MAX_SIZE        128U             /* Max length of a job status message to the service. */
+#if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+    #define OTA_STATUS_MSG_MAX_SIZE    192U             /* Max length of a job status message to the service, with the receive statistics. */
+#else
+    #define OTA_STATUS_MSG_MAX_SIZE    128U             /* Max length of a job status message to the service. */
+#endif
 #define OTA_UPDATE_STATUS_FREQUENCY    64U              /* Update the job status every 64 unique blocks received. */
 
 /* Job document parser constants. */
@@ -124,7 +164,13 @@ typedef struct
  * size, attributes, etc. The following value specifies the number of parameters
  * that are included in the job document model although some may be optional. */
 
-#define OTA_NUM_JOB_PARAMS         ( 16 ) /* Number of parameters in the job document. */
+#if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+    #define OTA_NUM_JOB_PARAMS           ( 17 ) /* Number of parameters in the job document. */
+    #define OTA_STREAM_NAME_PARAM_MODE   OTA_JOB_PARAM_OPTIONAL /* A file may be fetched from its URL instead. */
+#else
+    #define OTA_NUM_JOB_PARAMS           ( 16 ) /* Number of parameters in the job document. */
+    #define OTA_STREAM_NAME_PARAM_MODE   OTA_JOB_PARAM_REQUIRED
+#endif
 /* We need the following string to match in a couple places in the code so use a #define. */
 #define OTA_JSON_UPDATED_BY_KEY    "updatedBy"
 
@@ -144,6 +190,10 @@ static const char cOTA_JSON_FileIDKey[] = "fileid";
 static const char cOTA_JSON_FileAttributeKey[] = "attr";
 static const char cOTA_JSON_FileCertNameKey[] = "certfile";
 
+#if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+    static const char cOTA_JSON_UpdateDataUrlKey[] = "update_data_url";
+#endif
+
 enum
 {
     eJobReason_Receiving = 0,  /* Update progress status. */
@@ -237,14 +287,8 @@ static const char cOTA_JobsGetNext_TopicTemplate[] = "$aws/things/%s/jobs/$next/
 static const char cOTA_JobStatus_TopicTemplate[] = "$aws/things/%s/jobs/%s/update";
 static const char cOTA_StreamData_TopicTemplate[] = "$aws/things/%s/streams/%s/data/cbor";
 static const char cOTA_GetStream_TopicTemplate[] = "$aws/things/%s/streams/%s/get/cbor";
-static const char cOTA_GetNextJob_MsgTemplate[] = "{\"clientToken\":\"%u:%s\"}";
-static const char cOTA_JobStatus_StatusTemplate[] = "{\"status\":\"%s\",\"statusDetails\":{";
-static const char cOTA_JobStatus_ReceiveDetailsTemplate[] = "\"%s\":\"%u/%u\"}}";
-static const char cOTA_JobStatus_SelfTestDetailsTemplate[] = "\"%s\":\"%s\",\"" OTA_JSON_UPDATED_BY_KEY "\":\"0x%x\"}}";
-static const char cOTA_JobStatus_ReasonStrTemplate[] = "\"reason\":\"%s: 0x%08x\"}}";
-static const char cOTA_JobStatus_SucceededStrTemplate[] = "\"reason\":\"%s v%u.%u.%u\"}}";
-static const char cOTA_JobStatus_ReasonValTemplate[] = "\"reason\":\"0x%08x: 0x%08x\"}}";
 static const char cOTA_String_Receive[] = "receive";
+static const char cOTA_String_Reason[] = "reason";
 
 /* Flag for self-test mode. */
 static bool_t xInSelfTest = false;
@@ -309,6 +353,15 @@ static MQTTAgentReturnCode_t prvPublishMessage( void * pvClient,
                                                 uint32_t ulMsgSize,
                                                 MQTTQoS_t eQOS );
 
+/* Number of bytes of the block bitmap that tracks a file of the given number of blocks. */
+
+static uint32_t prvGetBlockBitmapLen( uint32_t ulNumBlocks );
+
+/* Slide the block bitmap over the leading bytes whose blocks have all been received. */
+
+static void prvSlideBlockBitmap( OTA_FileContext_t * C,
+                                 uint32_t ulNumBlocks );
+
 /* Called when the OTA agent receives a file data block message. */
 
 static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
@@ -316,15 +369,197 @@ static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
                                           uint32_t ulMsgSize,
                                           OTA_Err_t * pxCloseResult );
 
+/* Check a received file block against the block bitmap and write it, whatever it was received over. */
+
+static IngestResult_t prvIngestFileBlock( OTA_FileContext_t * C,
+                                          uint32_t ulBlockIndex,
+                                          uint32_t ulBlockSize,
+                                          uint8_t * pucPayload,
+                                          OTA_Err_t * pxCloseResult );
+
+/* Act on the result of ingesting file blocks. Returns NULL if the file was closed, else the context. */
+
+static OTA_FileContext_t * prvProcessIngestResult( OTA_FileContext_t * C,
+                                                   IngestResult_t xResult,
+                                                   OTA_Err_t xCloseResult );
+
+/* True if the file data is fetched over HTTP rather than the MQTT data stream. */
+
+static bool_t prvUsesHTTPDataPlane( const OTA_FileContext_t * C );
+
+#if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+
+/* Fetch the next range of missing blocks over HTTP. Returns NULL if the file was closed, else the context. */
+
+    static OTA_FileContext_t * prvRequestFileRange( OTA_FileContext_t * C );
+#endif
+
+#if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
+
+/* Point a stream file at the cache of the Greengrass core, if one is found. */
+
+    static void prvGreengrassCacheStart( OTA_FileContext_t * C );
+
+/* Go back to the data stream for the rest of a file that came from the Greengrass core cache. */
+
+    static void prvGreengrassCacheStop( OTA_FileContext_t * C );
+#endif
+
+#if ( otaconfigENABLE_RESUME == 1 )
+
+/* Save the transfer state of a file so it can be resumed after a reset. */
+
+    static void prvCheckpointSave( OTA_FileContext_t * C );
+
+/* Erase the saved transfer state, if any. */
+
+    static void prvCheckpointClear( void );
+
+/* Reopen the receive file where a previous transfer of the same file stopped. Fails if there is none. */
+
+    static OTA_Err_t prvCheckpointResume( OTA_FileContext_t * C );
+#endif
+
+#if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+
+/* Add a newly written block, and any already stored blocks that now follow it, to the file hash. */
+
+    static void prvStreamSignatureUpdate( OTA_FileContext_t * C,
+                                          uint32_t ulBlockIndex,
+                                          uint8_t * pucBlock,
+                                          uint32_t ulBlockSize );
+
+/* Check whether a block has been written to the receive file. */
+
+    static bool_t prvStreamSignatureBlockReceived( const OTA_FileContext_t * C,
+                                                   uint32_t ulBlockIndex,
+                                                   uint32_t ulNumBlocks );
+
+/* Free the agent's signature verification context, if any, leaving the full check to the PAL. */
+
+    static void prvStreamSignatureAbandon( OTA_FileContext_t * C );
+#endif
+
+/* Set up the decoders of a file that is a delta update or is compressed, if any. */
+
+static OTA_Err_t prvDecodeStart( OTA_FileContext_t * C );
+
+/* Write a received block, passing it through the decoders of the file, if any. */
+
+static int32_t prvDecodeWriteBlock( OTA_FileContext_t * C,
+                                    uint32_t ulBlockIndex,
+                                    uint32_t ulLastBlock,
+                                    uint8_t * pucPayload,
+                                    uint32_t ulBlockSize,
+                                    OTA_Err_t * pxCloseResult );
+
+/* Write image data to the receive file, staging it for the writer task if write-behind is enabled. */
+
+static int32_t prvWriteImage( OTA_FileContext_t * C,
+                              uint32_t ulOffset,
+                              uint8_t * pucData,
+                              uint32_t ulLength );
+
+/* Wait until all staged image data has been written to the receive file. */
+
+static int32_t prvWriteFlush( void );
+
+/* Write image data to the receive file through the PAL, timing the write if transfer statistics are enabled. */
+
+static int16_t prvWriteStorage( OTA_FileContext_t * const C,
+                                uint32_t ulOffset,
+                                uint8_t * const pucData,
+                                uint32_t ulLength );
+
+#if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+
+/* Restart the transfer statistics for a new file. */
+
+    static void prvTransferStatsReset( void );
+
+/* Account for a data request sent for the active file. */
+
+    static void prvTransferStatsRequested( void );
+
+/* Account for a block of the active file that arrived. */
+
+    static void prvTransferStatsBlock( uint32_t ulBytes,
+                                       bool_t xDuplicate );
+
+/* Convert a statistics timestamp difference to milliseconds. */
+
+    static uint32_t prvTransferStatsToMs( uint32_t ulTime );
+#endif
+
+#if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+
+/* Create the write-behind queues and the writer task. */
+
+    static void prvWriteBehindInit( void );
+
+/* Hand the buffer being filled, if any, to the writer task. */
+
+    static void prvWriteBehindSubmit( void );
+
+/* The writer task. Writes the staged buffers to the receive file. */
+
+    static void prvOTAWriterTask( void * pvUnused );
+#endif
+
+#if ( ( otaconfigENABLE_DELTA_UPDATE == 1 ) || ( otaconfigENABLE_COMPRESSED_UPDATE == 1 ) )
+
+/* Decoder callback writing the rebuilt image to the receive file. */
+
+    static int32_t prvDecodeWriteImage( void * pvContext,
+                                        uint32_t ulOffset,
+                                        uint8_t * pucData,
+                                        uint32_t ulLength );
+#endif
+
+#if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+
+/* Patch applier callback reading the running image. */
+
+    static int32_t prvDeltaReadSource( void * pvContext,
+                                       uint32_t ulOffset,
+                                       uint8_t * pucData,
+                                       uint32_t ulLength );
+#endif
+
+#if ( otaconfigENABLE_COMPRESSED_UPDATE == 1 )
+
+/* Decompressor callback passing its output to the patch applier or to the receive file. */
+
+    static int32_t prvDecompressWriteOutput( void * pvContext,
+                                             uint32_t ulOffset,
+                                             uint8_t * pucData,
+                                             uint32_t ulLength );
+#endif
+
 /* Called when the OTA agent receives an OTA version message. */
 
 static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
                                                 uint32_t ulMsgLen );
 
+/* Prepare a file of the job for receiving and start requesting its data. */
+
+static OTA_FileContext_t * prvStartFileRx( OTA_FileContext_t * pxUpdateFile );
+
 /* Get an available OTA file context structure or NULL if none available. */
 
 static OTA_FileContext_t * prvGetFreeContext( void );
 
+/* Get the file of the job that is received after the specified one, or NULL if it is the last. */
+
+static OTA_FileContext_t * prvGetNextJobFile( const OTA_FileContext_t * C );
+
+/* Parse the files of the job document after the first one into free file contexts. */
+
+static OTA_JobParseErr_t prvParseQueuedFiles( const char * pcJSON,
+                                              uint32_t ulMsgLen,
+                                              const JSON_DocParam_t * pxBodyDef,
+                                              uint16_t usNumFiles );
+
 /* Parse a JSON document using the specified document model. */
 
 static DocParseErr_t prvParseJSONbyModel( const char * pcJSON,
@@ -340,6 +575,10 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
 
 static bool_t prvOTA_Close( OTA_FileContext_t * const C );
 
+/* Close an open OTA file context and the files of its job that are still to be received. */
+
+static bool_t prvOTA_CloseJob( OTA_FileContext_t * const C );
+
 /* Called when a MQTT message is received on an OTA agent topic of interest. */
 
 static MQTTBool_t prvOTAPublishCallback( void * pvCallbackContext,
@@ -352,10 +591,72 @@ static void prvUpdateJobStatus( OTA_FileContext_t * C,
                                 int32_t lReason,
                                 int32_t lSubReason );
 
+/* Write the opening of a job status message, up to and including the start of statusDetails. */
+
+static void prvJobStatusBegin( JSONWriter_t * pxWriter,
+                               OTA_JobStatus_t eStatus );
+
+#if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+
+/* Write a statusDetails member whose value is an unsigned decimal number in a string. */
+
+    static void prvJobStatusUIntDetail( JSONWriter_t * pxWriter,
+                                        const char * pcKey,
+                                        uint32_t ulValue );
+#endif
+
 /* Construct the "Get Stream" message and publish it to the stream service request topic. */
 
 static OTA_Err_t prvPublishGetStreamMessage( OTA_FileContext_t * C );
 
+#if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+
+/* Start a new request window for a file that is about to be received. */
+
+    static void prvRequestWindowReset( void );
+
+/* Select the next missing blocks that fit in the request window. Returns the number of blocks selected. */
+
+    static uint32_t prvRequestWindowSelect( const OTA_FileContext_t * C,
+                                            uint8_t * pucBitmap,
+                                            uint32_t ulBitmapLen );
+
+/* Account for a received block and send the next request once half of the window has arrived. */
+
+    static void prvRequestWindowBlockReceived( OTA_FileContext_t * C );
+
+/* The request timer expired, so anything still in flight is considered lost. */
+
+    static void prvRequestWindowTimeout( void );
+#endif
+
+#if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+
+/* Return the number of blocks the token bucket allows to be requested now. */
+
+    static uint32_t prvRequestBudgetAvailable( void );
+
+/* Take the blocks of a request that is about to be sent from the token bucket. */
+
+    static void prvRequestBudgetSpend( const OTA_FileContext_t * C,
+                                       uint32_t ulBlocks );
+
+/* Wake up the request timer once the token bucket allows the next block. Returns true if it was set up. */
+
+    static bool_t prvRequestBudgetWait( const OTA_FileContext_t * C );
+#endif
+
+#if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U )
+
+/* Count the MQTT latency samples that reached the back off threshold. Returns false if the statistics are not available. */
+
+    static bool_t prvCountSlowMQTTSamples( uint32_t * pulSlowSamples );
+
+/* Lower the block rate if the MQTT agent got slow since the last call, or raise it otherwise. */
+
+    static void prvRequestBudgetAdapt( void );
+#endif
+
 /* Internal function to set the image state including an optional reason code. */
 
 static OTA_Err_t prvSetImageStateWithReason( OTA_ImageState_t eState,
@@ -369,6 +670,11 @@ static void prvDefaultOTACompleteCallback( OTA_JobEvent_t eEvent );
 
 static void prvAgentShutdownCleanup( OTA_PubMsg_t * pxMsgMetaData );
 
+/* Hash a document model key of known length for the key lookup table. */
+
+static uint32_t prvHashModelKey( const char * pcKey,
+                                 uint32_t ulLen );
+
 /* Search the document model for a key that matches the specified JSON key. */
 
 static DocParseErr_t prvSearchModelForTokenKey( JSON_DocModel_t * pxDocModel,
@@ -404,6 +710,33 @@ typedef struct ota_agent_statistics
     uint32_t ulOTA_PublishFailures;  /* Number of MQTT publish failures. */
 } OTA_AgentStatistics_t;
 
+#if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+
+/* Bookkeeping of the pipelined stream requests for the file being received. */
+
+    typedef struct ota_request_window
+    {
+        uint32_t ulCursor;       /* Block index where the next request starts looking for missing blocks. */
+        uint32_t ulInFlight;     /* Number of requested blocks that have not arrived yet. */
+        uint32_t ulSize;         /* Number of blocks that may currently be in flight. */
+        uint32_t ulDropped;      /* Agent packet drop count when the last request was sent. */
+        TickType_t xRequestTick; /* Tick count when the last request was sent. */
+        bool_t xRTTPending;      /* True until the first block after the last request arrives. */
+        bool_t xResizePending;   /* True until the window has been resized after the last request. */
+        TickType_t xSmoothedRTT; /* Smoothed ticks from a request to its first block, 0 until measured. */
+        #if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+            TickType_t xTimeout;     /* Request timer period when not waiting for the token bucket. */
+            uint32_t ulCredit;       /* Token bucket fill level, in blocks times configTICK_RATE_HZ. */
+            uint32_t ulRate;         /* Current token bucket fill rate, in blocks per second. */
+            TickType_t xCreditTick;  /* Tick count when the token bucket was last filled. */
+            bool_t xBudgetWait;      /* True while the request timer waits for the token bucket. */
+        #endif
+        #if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U )
+            uint32_t ulSlowSamples;  /* MQTT latency samples over the back off threshold at the last check. */
+        #endif
+    } OTA_RequestWindow_t;
+#endif
+
 /* The OTA agent is a singleton today. The structure keeps it nice and organized. */
 
 typedef struct ota_agent_context
@@ -420,6 +753,9 @@ typedef struct ota_agent_context
     OTA_ImageState_t eImageState;                           /* The current OTA image state as set by the OTA agent. */
     QueueHandle_t xOTA_MsgQ;                                /* Used to pass MQTT messages to the OTA agent. */
     OTA_AgentStatistics_t xStatistics;                      /* The OTA agent statistics block. */
+    #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+        OTA_RequestWindow_t xRequestWindow;                 /* The pipelined stream request state of the active file. */
+    #endif
 } OTA_AgentContext_t;
 
 
@@ -439,8 +775,128 @@ static OTA_AgentContext_t xOTA_Agent =
     .eImageState                    = eOTA_ImageState_Unknown,
     .xOTA_MsgQ                      = NULL,
     .xStatistics                    = { 0 },
+    #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+        .xRequestWindow             = { 0 },
+    #endif
 };
 
+#if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+
+/* A staging buffer of the write-behind stage. It collects a run of adjacent blocks that lie
+ * in one buffer sized, buffer aligned part of the file, so each write covers whole sectors
+ * when the buffer size is the flash sector size. */
+
+    typedef struct ota_write_buffer
+    {
+        OTA_FileContext_t * pxFile;                   /* The file the data is written to. */
+        uint32_t ulOffset;                            /* File offset of ucData[ 0 ]. */
+        uint32_t ulLength;                            /* Number of bytes staged in ucData. */
+        uint8_t ucData[ otaconfigWRITE_BUFFER_SIZE ]; /* The staged data. */
+    } OTA_WriteBuffer_t;
+
+/* State of the write-behind stage, shared by the OTA task and the writer task. Buffers
+ * move from the free queue to the OTA task, which fills them, to the full queue and the
+ * writer task, which writes them, and back to the free queue. */
+
+    typedef struct ota_write_behind
+    {
+        QueueHandle_t xFullQueue;                                  /* Buffers waiting for the writer task. */
+        QueueHandle_t xFreeQueue;                                  /* Buffers the OTA task may fill. */
+        TaskHandle_t xWriterTask;                                  /* The writer task, NULL if the OTA task writes itself. */
+        OTA_WriteBuffer_t * pxFilling;                             /* The buffer being filled by the OTA task, or NULL. */
+        volatile int32_t lError;                                   /* First writer task error since the file was opened, or 0. */
+        OTA_WriteBuffer_t xBuffers[ otaconfigWRITE_BUFFER_COUNT ]; /* The staging buffers. */
+    } OTA_WriteBehind_t;
+
+    static OTA_WriteBehind_t xWriteBehind;
+#endif
+
+#if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+
+/* The HTTP data plane connection. It is kept open between the range requests of a file. */
+
+    static OTA_HTTP_Connection_t xHTTPConnection;
+    static uint8_t ucHTTPBuffer[ otaconfigHTTP_BUFFER_SIZE ];
+
+/* Outcome of the blocks of a range, passed through the HTTP block callback. */
+
+    typedef struct ota_http_range
+    {
+        OTA_FileContext_t * pxFile; /* The file being received. */
+        IngestResult_t xResult;     /* Result of the last block ingested. */
+        OTA_Err_t xCloseResult;     /* Close result of the last block ingested. */
+        uint32_t ulAccepted;        /* Number of blocks of the range that were new. */
+    } OTA_HTTPRange_t;
+#endif
+
+#if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
+
+/* The discovery document of the core the file is fetched from. It holds the certificate of the core. */
+
+    static char * pcGreengrassDiscovery = NULL;
+#endif
+
+#if ( otaconfigENABLE_RESUME == 1 )
+
+    #define OTA_CHECKPOINT_MAGIC            0x5241544FUL /* "OTAR" in little endian. */
+    #define OTA_CHECKPOINT_JOB_NAME_SIZE    68U          /* Job IDs have up to 64 characters. */
+
+/* The saved transfer state of the file being received. It tells the blocks that are stored in
+ * the receive file, and which job and file they belong to. */
+
+    typedef struct ota_checkpoint
+    {
+        uint32_t ulMagic;                                   /* OTA_CHECKPOINT_MAGIC. */
+        uint32_t ulChecksum;                                /* FNV-1a hash of the fields that follow. */
+        uint32_t ulServerFileID;                            /* File ID of the file in the job document. */
+        uint32_t ulFileSize;                                /* Size of the file. */
+        uint32_t ulFileAttributes;                          /* Attributes of the file. */
+        uint32_t ulBitmapBase;                              /* Block index of the first bit of ucBitmap. */
+        uint32_t ulBlocksRemaining;                         /* Number of blocks still missing. */
+        char cJobName[ OTA_CHECKPOINT_JOB_NAME_SIZE ];      /* Zero terminated job ID. */
+        uint8_t ucBitmap[ OTA_MAX_BLOCK_BITMAP_SIZE ];      /* The block bitmap. */
+    } OTA_Checkpoint_t;
+#endif
+
+#if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+
+/* Transfer statistics of the active file. Times are in otaconfigSTATS_TIMESTAMP() units and
+ * converted when they are queried. The write time is also added to by the writer task. */
+
+    typedef struct ota_transfer_stats
+    {
+        uint32_t ulStartTime;             /* Time of the first data request of the file. */
+        uint32_t ulLastTime;              /* Time of the last block that arrived. */
+        uint32_t ulRequestTime;           /* Time of the oldest data request not answered by any block. */
+        bool_t xRequestPending;           /* A data request was sent and no block arrived since. */
+        bool_t xStarted;                  /* The first data request of the file was sent. */
+        uint32_t ulRateTime;              /* Start of the current receive rate interval. */
+        uint32_t ulRateBytes;             /* Bytes received in the current receive rate interval. */
+        uint32_t ulCurrentBytesPerSecond; /* Receive rate of the last complete interval. */
+        uint32_t ulBytesReceived;         /* File bytes received, not counting duplicates. */
+        uint32_t ulRequestWaitTime;       /* Total time from a data request until any block arrived. */
+        uint32_t ulDecodeTime;            /* Total time decoding stream data messages. */
+        uint32_t ulWriteTime;             /* Total time writing file data to storage. */
+        uint32_t ulVerifyTime;            /* Total time closing the file. */
+        uint32_t ulActivateTime;          /* Time spent in OTA_ActivateNewImage(). */
+        uint32_t ulDuplicateBlocks;       /* Blocks that were already received. */
+        uint32_t ulRequestRetries;        /* Data requests sent while the previous one was unanswered. */
+    } OTA_TransferStatsState_t;
+
+    static OTA_TransferStatsState_t xTransferStats;
+#endif
+
+#if ( configUSE_TASK_ARENAS == 1 )
+
+/* The token array of the job document parser is served from an arena of its
+ * own, so that it never has to be taken from the heap. The array is bounded by
+ * OTA_MAX_JSON_TOKENS and it is not needed any more once the parse is done. */
+
+    static uint8_t ucJobParserArenaStorage[ ( OTA_MAX_JSON_TOKENS * sizeof( jsmntok_t ) ) + portBYTE_ALIGNMENT ];
+    static StaticTaskArena_t xJobParserArenaBuffer;
+    static TaskArenaHandle_t xJobParserArena = NULL;
+#endif
+
 
 /* This is the default OTA callback handler if the user does not provide
  * one. It will do the basic activation and commit of accepted images.
@@ -560,11 +1016,25 @@ OTA_State_t OTA_AgentInit( void * pvClient,
             xOTA_Agent.xOTA_MsgQ = xQueueCreateStatic( ( UBaseType_t ) OTA_NUM_MSG_Q_ENTRIES, ( UBaseType_t ) sizeof( OTA_PubMsg_t ), ( uint8_t * ) xQueueData, &xStaticQueue );
             configASSERT( xOTA_Agent.xOTA_MsgQ );
 
+            /* Makes the queue visible to kernel aware debuggers, and to
+             * xQueueGetHandleFromName(). The queue is created again in the same
+             * storage after a shutdown, so an earlier entry is removed first. */
+            vQueueUnregisterQueue( xOTA_Agent.xOTA_MsgQ );
+            vQueueAddToRegistry( xOTA_Agent.xOTA_MsgQ, "OTAMsgQ" );
+
             for( ulIndex = 0; ulIndex < OTA_MAX_FILES; ulIndex++ )
             {
                 xOTA_Agent.xOTA_Files[ ulIndex ].pucFilePath = NULL;
             }
 
+            #if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+                prvWriteBehindInit();
+            #endif
+
+            #if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+                OTA_HTTP_Init( &xHTTPConnection, ucHTTPBuffer, sizeof( ucHTTPBuffer ), otaconfigHTTP_SERVER_CERTIFICATE, otaconfigHTTP_TIMEOUT_MS );
+            #endif
+
             xReturn = xTaskCreate( prvOTAUpdateTask, "OTA Task", otaconfigSTACK_SIZE, NULL, otaconfigAGENT_PRIORITY, &xOTA_TaskHandle );
             portEXIT_CRITICAL(); /* Protected elements are initialized. It's now safe to context switch. */
 
@@ -657,6 +1127,106 @@ uint32_t OTA_GetPacketsReceived( void )
     return xOTA_Agent.xStatistics.ulOTA_PacketsReceived;
 }
 
+void OTA_GetTransferStats( OTA_TransferStats_t * pxStats )
+{
+    if( pxStats != NULL )
+    {
+        memset( pxStats, 0, sizeof( OTA_TransferStats_t ) );
+
+        #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+            uint32_t ulElapsedMs = prvTransferStatsToMs( xTransferStats.ulLastTime - xTransferStats.ulStartTime );
+
+            pxStats->ulRequestWaitMs = prvTransferStatsToMs( xTransferStats.ulRequestWaitTime );
+            pxStats->ulDecodeMs = prvTransferStatsToMs( xTransferStats.ulDecodeTime );
+            pxStats->ulWriteMs = prvTransferStatsToMs( xTransferStats.ulWriteTime );
+            pxStats->ulVerifyMs = prvTransferStatsToMs( xTransferStats.ulVerifyTime );
+            pxStats->ulActivateMs = prvTransferStatsToMs( xTransferStats.ulActivateTime );
+            pxStats->ulBytesReceived = xTransferStats.ulBytesReceived;
+            pxStats->ulCurrentBytesPerSecond = xTransferStats.ulCurrentBytesPerSecond;
+            pxStats->ulDuplicateBlocks = xTransferStats.ulDuplicateBlocks;
+            pxStats->ulRequestRetries = xTransferStats.ulRequestRetries;
+
+            if( ulElapsedMs > 0U )
+            {
+                pxStats->ulAverageBytesPerSecond = ( uint32_t ) ( ( ( uint64_t ) xTransferStats.ulBytesReceived * 1000U ) / ulElapsedMs );
+            }
+        #endif /* if ( otaconfigENABLE_TRANSFER_STATS == 1 ) */
+    }
+}
+
+#if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+
+    static void prvTransferStatsReset( void )
+    {
+        memset( &xTransferStats, 0, sizeof( xTransferStats ) );
+    }
+
+/* The request wait runs from the first request that no block answered yet, so a request
+ * sent again by the request timer is counted as a retry and does not restart the wait. */
+
+    static void prvTransferStatsRequested( void )
+    {
+        uint32_t ulNow = otaconfigSTATS_TIMESTAMP();
+
+        if( xTransferStats.xStarted == false )
+        {
+            xTransferStats.xStarted = true;
+            xTransferStats.ulStartTime = ulNow;
+            xTransferStats.ulLastTime = ulNow;
+            xTransferStats.ulRateTime = ulNow;
+        }
+
+        if( xTransferStats.xRequestPending == true )
+        {
+            xTransferStats.ulRequestRetries++;
+        }
+        else
+        {
+            xTransferStats.xRequestPending = true;
+            xTransferStats.ulRequestTime = ulNow;
+        }
+    }
+
+/* The current rate is measured over intervals of at least one second. */
+
+    static void prvTransferStatsBlock( uint32_t ulBytes,
+                                       bool_t xDuplicate )
+    {
+        uint32_t ulNow = otaconfigSTATS_TIMESTAMP();
+        uint32_t ulInterval;
+
+        if( xTransferStats.xRequestPending == true )
+        {
+            xTransferStats.xRequestPending = false;
+            xTransferStats.ulRequestWaitTime += ulNow - xTransferStats.ulRequestTime;
+        }
+
+        if( xDuplicate == true )
+        {
+            xTransferStats.ulDuplicateBlocks++;
+        }
+        else
+        {
+            xTransferStats.ulLastTime = ulNow;
+            xTransferStats.ulBytesReceived += ulBytes;
+            xTransferStats.ulRateBytes += ulBytes;
+            ulInterval = ulNow - xTransferStats.ulRateTime;
+
+            if( ulInterval >= otaconfigSTATS_TIMESTAMP_HZ )
+            {
+                xTransferStats.ulCurrentBytesPerSecond = ( uint32_t ) ( ( ( uint64_t ) xTransferStats.ulRateBytes * otaconfigSTATS_TIMESTAMP_HZ ) / ulInterval );
+                xTransferStats.ulRateTime = ulNow;
+                xTransferStats.ulRateBytes = 0U;
+            }
+        }
+    }
+
+    static uint32_t prvTransferStatsToMs( uint32_t ulTime )
+    {
+        return ( uint32_t ) ( ( ( uint64_t ) ulTime * 1000U ) / otaconfigSTATS_TIMESTAMP_HZ );
+    }
+#endif /* if ( otaconfigENABLE_TRANSFER_STATS == 1 ) */
+
 /* Request for the next available OTA job from the job service by publishing
  * a "get next job" message to the job service. */
 
@@ -673,23 +1243,36 @@ OTA_Err_t OTA_CheckForUpdate( void )
 
     /* The following buffer is big enough to hold a dynamically constructed $next/get job message.
      * It contains a client token that is used to track how many requests have been made. */
-    char cMsg[ CONST_STRLEN( cOTA_GetNextJob_MsgTemplate ) + U32_MAX_PLACES + otaconfigMAX_THINGNAME_LEN ];
+    char cMsg[ CONST_STRLEN( "{\"\":\":\"}" ) + CONST_STRLEN( cOTA_JSON_ClientTokenKey ) + U32_MAX_PLACES + otaconfigMAX_THINGNAME_LEN + 1U ];
+    JSONWriter_t xWriter;
+    size_t xMsgLen;
 
     OTA_LOG_L1( "[%s] Request #%u\r\n", OTA_METHOD_NAME, ulReqCounter );
-    /*lint -e586 Intentionally using snprintf. */
-    ulMsgLen = ( uint32_t ) snprintf( cMsg,
-                                      sizeof( cMsg ),
-                                      cOTA_GetNextJob_MsgTemplate,
-                                      ulReqCounter,
-                                      xOTA_Agent.ucThingName );
+    JSONWRITE_Init( &xWriter, cMsg, sizeof( cMsg ) );
+    JSONWRITE_ObjectStart( &xWriter );
+    JSONWRITE_Key( &xWriter, cOTA_JSON_ClientTokenKey );
+    JSONWRITE_StringStart( &xWriter );
+    JSONWRITE_StringAppendUInt( &xWriter, ulReqCounter );
+    JSONWRITE_StringAppend( &xWriter, ":", 1U );
+    JSONWRITE_StringAppend( &xWriter,
+                            ( const char * ) xOTA_Agent.ucThingName,
+                            strlen( ( const char * ) xOTA_Agent.ucThingName ) );
+    JSONWRITE_StringEnd( &xWriter );
+    JSONWRITE_ObjectEnd( &xWriter );
     ulReqCounter++;
-    usTopicLen = ( uint16_t ) snprintf( cJobTopic,
+    usTopicLen = ( uint16_t ) snprintf( cJobTopic, /*lint -e586 Intentionally using snprintf. */
                                         sizeof( cJobTopic ),
                                         cOTA_JobsGetNext_TopicTemplate,
                                         xOTA_Agent.ucThingName );
 
-    if( ( usTopicLen > 0U ) && ( usTopicLen < sizeof( cJobTopic ) ) )
+    if( JSONWRITE_Finish( &xWriter, &xMsgLen ) != pdPASS )
+    {
+        OTA_LOG_L1( "[%s] Message too large for supplied buffer.\r\n", OTA_METHOD_NAME );
+        xError = kOTA_Err_PublishFailed;
+    }
+    else if( ( usTopicLen > 0U ) && ( usTopicLen < sizeof( cJobTopic ) ) )
     {
+        ulMsgLen = ( uint32_t ) xMsgLen;
         eResult = prvPublishMessage(
             xOTA_Agent.pvPubSubClient,
             cJobTopic,
@@ -742,6 +1325,14 @@ static void prvAgentShutdownCleanup( OTA_PubMsg_t * pxMsgMetaData )
     /* Close any open OTA transfers. */
     for( ulIndex = 0; ulIndex < OTA_MAX_FILES; ulIndex++ )
     {
+        #if ( otaconfigENABLE_RESUME == 1 )
+            if( xOTA_Agent.xOTA_Files[ ulIndex ].pucRxBlockBitmap != NULL )
+            {
+                /* Keep what was received of the file for when the job is received again. */
+                prvCheckpointSave( &xOTA_Agent.xOTA_Files[ ulIndex ] );
+            }
+        #endif
+
         if( prvOTA_Close( &xOTA_Agent.xOTA_Files[ ulIndex ] ) == ( bool_t ) pdFALSE )
         {
             OTA_LOG_L1( "[%s] Error! OTA_FileContext_t[%u] pointer is null.\r\n", OTA_METHOD_NAME, ulIndex );
@@ -803,7 +1394,16 @@ OTA_Err_t OTA_ActivateNewImage( void )
     /* Call platform specific code to activate the image. This should reset the device
      * and not return unless there is a problem within the PAL layer. If it does return,
      * output an error message. The device may need to be reset manually. */
+    #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+        uint32_t ulStart = otaconfigSTATS_TIMESTAMP();
+    #endif
+
     xErr = prvPAL_ActivateNewImage();
+
+    #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+        xTransferStats.ulActivateTime = otaconfigSTATS_TIMESTAMP() - ulStart;
+    #endif
+
     OTA_LOG_L1( "[%s] Failed to activate new image (0x%08x). Please reset manually.\r\n", OTA_METHOD_NAME, xErr );
     return xErr;
 }
@@ -997,6 +1597,32 @@ static OTA_Err_t prvSetImageStateWithReason( OTA_ImageState_t eState,
 
 
 
+static void prvJobStatusBegin( JSONWriter_t * pxWriter,
+                               OTA_JobStatus_t eStatus )
+{
+    JSONWRITE_ObjectStart( pxWriter );
+    JSONWRITE_Key( pxWriter, "status" );
+    JSONWRITE_String( pxWriter,
+                      pcOTA_JobStatus_Strings[ eStatus ],
+                      strlen( pcOTA_JobStatus_Strings[ eStatus ] ) );
+    JSONWRITE_Key( pxWriter, cOTA_JSON_StatusDetailsKey );
+    JSONWRITE_ObjectStart( pxWriter );
+}
+
+#if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+
+    static void prvJobStatusUIntDetail( JSONWriter_t * pxWriter,
+                                        const char * pcKey,
+                                        uint32_t ulValue )
+    {
+        JSONWRITE_Key( pxWriter, pcKey );
+        JSONWRITE_StringStart( pxWriter );
+        JSONWRITE_StringAppendUInt( pxWriter, ulValue );
+        JSONWRITE_StringEnd( pxWriter );
+    }
+
+#endif
+
 /* Update the job status on the service side with progress or completion info. */
 
 static void prvUpdateJobStatus( OTA_FileContext_t * C,
@@ -1011,12 +1637,16 @@ static void prvUpdateJobStatus( OTA_FileContext_t * C,
     MQTTQoS_t eQOS;
     char cMsg[ OTA_STATUS_MSG_MAX_SIZE ];
     char cTopicBuffer[ OTA_MAX_TOPIC_LEN ];
+    JSONWriter_t xWriter;
+    size_t xMsgSize;
+    BaseType_t xHaveMsg;
 
     /* All job state transitions except streaming progress use QOS 1 since it is required to have status in the job document. */
     eQOS = eMQTTQoS1;
 
-    /* A message size of zero means don't publish anything. */
-    ulMsgSize = 0UL;
+    /* A message is only published if one of the branches below starts it. */
+    xHaveMsg = pdFALSE;
+    JSONWRITE_Init( &xWriter, cMsg, sizeof( cMsg ) );
 
     if( eStatus == eJobStatus_InProgress )
     {
@@ -1031,21 +1661,26 @@ static void prvUpdateJobStatus( OTA_FileContext_t * C,
                 {
                     /* Downgrade Progress updates to QOS 0 to avoid overloading MQTT buffers during active streaming. */
                     eQOS = eMQTTQoS0;
-                    ulMsgSize = ( uint32_t ) snprintf( cMsg, /*lint -e586 Intentionally using snprintf. */
-                                                       sizeof( cMsg ),
-                                                       cOTA_JobStatus_StatusTemplate,
-                                                       pcOTA_JobStatus_Strings[ eStatus ] );
-                    ulMsgSize += ( uint32_t ) snprintf( &cMsg[ ulMsgSize ], /*lint -e586 Intentionally using snprintf. */
-                                                        sizeof( cMsg ) - ulMsgSize,
-                                                        cOTA_JobStatus_ReceiveDetailsTemplate,
-                                                        cOTA_String_Receive,
-                                                        ulReceived,
-                                                        ulNumBlocks );
+                    prvJobStatusBegin( &xWriter, eStatus );
+                    JSONWRITE_Key( &xWriter, cOTA_String_Receive );
+                    JSONWRITE_StringStart( &xWriter );
+                    JSONWRITE_StringAppendUInt( &xWriter, ulReceived );
+                    JSONWRITE_StringAppend( &xWriter, "/", 1U );
+                    JSONWRITE_StringAppendUInt( &xWriter, ulNumBlocks );
+                    JSONWRITE_StringEnd( &xWriter );
+                    #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                        OTA_TransferStats_t xStats;
+
+                        OTA_GetTransferStats( &xStats );
+                        prvJobStatusUIntDetail( &xWriter, "rate", xStats.ulCurrentBytesPerSecond );
+                        prvJobStatusUIntDetail( &xWriter, "avgRate", xStats.ulAverageBytesPerSecond );
+                        prvJobStatusUIntDetail( &xWriter, "retx", xStats.ulDuplicateBlocks + xStats.ulRequestRetries );
+                    #endif
+                    xHaveMsg = pdTRUE;
                 }
                 else
                 {
                     /* Don't send a status update yet. */
-                    ulMsgSize = 0UL;
                 }
             }
             else
@@ -1053,23 +1688,23 @@ static void prvUpdateJobStatus( OTA_FileContext_t * C,
                 /* Can't send a status update without data from the OTA context. Some calls intentionally
                  * don't use a context structure but never with this reason code so log this error. */
                 OTA_LOG_L1( "[%s] Error: null context pointer!\r\n", OTA_METHOD_NAME );
-                ulMsgSize = 0UL;
             }
         }
         else
         {
             /* We're no longer receiving but we're still In Progress so we are implicitly in the Self
              * Test phase. Prepare to update the job status with the self_test phase (ready or active). */
-            ulMsgSize = ( uint32_t ) snprintf( cMsg, /*lint -e586 Intentionally using snprintf. */
-                                               sizeof( cMsg ),
-                                               cOTA_JobStatus_StatusTemplate,
-                                               pcOTA_JobStatus_Strings[ eStatus ] );
-            ulMsgSize += ( uint32_t ) snprintf( &cMsg[ ulMsgSize ], /*lint -e586 Intentionally using snprintf. */
-                                                sizeof( cMsg ) - ulMsgSize,
-                                                cOTA_JobStatus_SelfTestDetailsTemplate,
-                                                cOTA_JSON_SelfTestKey,
-                                                pcOTA_JobReason_Strings[ lReason ],
-                                                xAppFirmwareVersion.u.ulVersion32 );
+            prvJobStatusBegin( &xWriter, eStatus );
+            JSONWRITE_Key( &xWriter, cOTA_JSON_SelfTestKey );
+            JSONWRITE_String( &xWriter,
+                              pcOTA_JobReason_Strings[ lReason ],
+                              strlen( pcOTA_JobReason_Strings[ lReason ] ) );
+            JSONWRITE_Key( &xWriter, cOTA_JSON_UpdatedByKey );
+            JSONWRITE_StringStart( &xWriter );
+            JSONWRITE_StringAppend( &xWriter, "0x", 2U );
+            JSONWRITE_StringAppendHex( &xWriter, xAppFirmwareVersion.u.ulVersion32, 1U );
+            JSONWRITE_StringEnd( &xWriter );
+            xHaveMsg = pdTRUE;
         }
     }
     else
@@ -1081,18 +1716,16 @@ static void prvUpdateJobStatus( OTA_FileContext_t * C,
              * a numeric OTA error code and sub-reason code to cover the case where there may be too
              * many description strings to reasonably include in the code.
              */
-            ulMsgSize = ( uint32_t ) snprintf( cMsg, /*lint -e586 Intentionally using snprintf. */
-                                               sizeof( cMsg ),
-                                               cOTA_JobStatus_StatusTemplate,
-                                               pcOTA_JobStatus_Strings[ eStatus ] );
+            prvJobStatusBegin( &xWriter, eStatus );
+            JSONWRITE_Key( &xWriter, cOTA_String_Reason );
+            JSONWRITE_StringStart( &xWriter );
 
             if( eStatus == eJobStatus_FailedWithVal )
             {
-                ulMsgSize += ( uint32_t ) snprintf( &cMsg[ ulMsgSize ], /*lint -e586 Intentionally using snprintf. */
-                                                    sizeof( cMsg ) - ulMsgSize,
-                                                    cOTA_JobStatus_ReasonValTemplate,
-                                                    lReason,
-                                                    lSubReason );
+                JSONWRITE_StringAppend( &xWriter, "0x", 2U );
+                JSONWRITE_StringAppendHex( &xWriter, ( uint32_t ) lReason, 8U );
+                JSONWRITE_StringAppend( &xWriter, ": 0x", 4U );
+                JSONWRITE_StringAppendHex( &xWriter, ( uint32_t ) lSubReason, 8U );
             }
 
             /* If the status update is for "SUCCEEDED," we are identifying the version of firmware
@@ -1105,27 +1738,50 @@ static void prvUpdateJobStatus( OTA_FileContext_t * C,
                 AppVersion32_t xNewVersion;
 
                 xNewVersion.u.lVersion32 = lSubReason;
-                ulMsgSize += ( uint32_t ) snprintf( &cMsg[ ulMsgSize ], /*lint -e586 Intentionally using snprintf. */
-                                                    sizeof( cMsg ) - ulMsgSize,
-                                                    cOTA_JobStatus_SucceededStrTemplate,
-                                                    pcOTA_JobReason_Strings[ lReason ],
-                                                    xNewVersion.u.x.ucMajor,
-                                                    xNewVersion.u.x.ucMinor,
-                                                    xNewVersion.u.x.usBuild );
+                JSONWRITE_StringAppend( &xWriter,
+                                        pcOTA_JobReason_Strings[ lReason ],
+                                        strlen( pcOTA_JobReason_Strings[ lReason ] ) );
+                JSONWRITE_StringAppend( &xWriter, " v", 2U );
+                JSONWRITE_StringAppendUInt( &xWriter, xNewVersion.u.x.ucMajor );
+                JSONWRITE_StringAppend( &xWriter, ".", 1U );
+                JSONWRITE_StringAppendUInt( &xWriter, xNewVersion.u.x.ucMinor );
+                JSONWRITE_StringAppend( &xWriter, ".", 1U );
+                JSONWRITE_StringAppendUInt( &xWriter, xNewVersion.u.x.usBuild );
             }
             else
             {
-                ulMsgSize += ( uint32_t ) snprintf( &cMsg[ ulMsgSize ], /*lint -e586 Intentionally using snprintf. */
-                                                    sizeof( cMsg ) - ulMsgSize,
-                                                    cOTA_JobStatus_ReasonStrTemplate,
-                                                    pcOTA_JobReason_Strings[ lReason ],
-                                                    lSubReason );
+                JSONWRITE_StringAppend( &xWriter,
+                                        pcOTA_JobReason_Strings[ lReason ],
+                                        strlen( pcOTA_JobReason_Strings[ lReason ] ) );
+                JSONWRITE_StringAppend( &xWriter, ": 0x", 4U );
+                JSONWRITE_StringAppendHex( &xWriter, ( uint32_t ) lSubReason, 8U );
             }
+
+            JSONWRITE_StringEnd( &xWriter );
+            xHaveMsg = pdTRUE;
         }
         else
         {
             /* Unknown status code. Just ignore it. */
-            ulMsgSize = 0UL;
+        }
+    }
+
+    /* A message size of zero means don't publish anything. */
+    ulMsgSize = 0UL;
+
+    if( xHaveMsg == pdTRUE )
+    {
+        /* Close the statusDetails object and the outer object. */
+        JSONWRITE_ObjectEnd( &xWriter );
+        JSONWRITE_ObjectEnd( &xWriter );
+
+        if( JSONWRITE_Finish( &xWriter, &xMsgSize ) == pdPASS )
+        {
+            ulMsgSize = ( uint32_t ) xMsgSize;
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] Error: status message needs %u bytes.\r\n", OTA_METHOD_NAME, ( uint32_t ) xMsgSize );
         }
     }
 
@@ -1179,28 +1835,74 @@ static OTA_Err_t prvPublishGetStreamMessage( OTA_FileContext_t * C )
 
     uint32_t ulMsgSizeToPublish;
     size_t xMsgSizeFromStream;
-    uint32_t ulNumBlocks, ulBitmapLen, ulTopicLen;
+    uint32_t ulNumBlocks, ulBitmapLen, ulTopicLen, ulBlockOffset;
     MQTTAgentReturnCode_t eResult;
     OTA_Err_t xErr = kOTA_Err_None;
     char cMsg[ OTA_REQUEST_MSG_MAX_SIZE ];
     char cTopicBuffer[ OTA_MAX_TOPIC_LEN ];
+    uint8_t * pucBitmap;
+    bool_t xWindowFull = false;
+
+    #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+        uint8_t ucWindowBitmap[ OTA_MAX_BLOCK_BITMAP_SIZE ];
+    #endif
 
     if( C != NULL )
     {
         if( C->ulRequestMomentum < OTA_MAX_STREAM_REQUEST_MOMENTUM )
         {
             ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
-            ulBitmapLen = ( ulNumBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+            ulBitmapLen = prvGetBlockBitmapLen( ulNumBlocks );
+            pucBitmap = C->pucRxBlockBitmap;
 
-            if( pdTRUE == OTA_CBOR_Encode_GetStreamRequestMessage(
-                    ( uint8_t * ) cMsg,
-                    sizeof( cMsg ),
+            /* The bitmap in the request starts at this block. */
+            ulBlockOffset = C->ulBitmapBase;
+
+            #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+                /* Only ask for the blocks that fit in the request window. */
+                if( prvRequestWindowSelect( C, ucWindowBitmap, ulBitmapLen ) == 0U )
+                {
+                    xWindowFull = true;
+                }
+                else
+                {
+                    /* Only send the bytes of the window bitmap that actually request blocks. */
+                    pucBitmap = ucWindowBitmap;
+
+                    while( pucBitmap[ 0 ] == 0U )
+                    {
+                        pucBitmap++;
+                        ulBitmapLen--;
+                        ulBlockOffset += BITS_PER_BYTE;
+                    }
+
+                    while( pucBitmap[ ulBitmapLen - 1U ] == 0U )
+                    {
+                        ulBitmapLen--;
+                    }
+                }
+            #endif
+
+            if( xWindowFull == true )
+            {
+                #if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+                    /* Or the token bucket is empty. Wait for it to refill if nothing is in flight. */
+                    if( prvRequestBudgetWait( C ) == false )
+                #endif
+                {
+                    /* Everything that may be requested now is in flight. Wait for it or for the request timeout. */
+                    prvStartRequestTimer( C );
+                }
+            }
+            else if( pdTRUE == OTA_CBOR_Encode_GetStreamRequestMessage(
+                    ( uint8_t * ) cMsg,
+                    sizeof( cMsg ),
                     &xMsgSizeFromStream,
                     OTA_CLIENT_TOKEN,
                     ( int32_t ) C->ulServerFileID,
                     ( int32_t ) ( OTA_FILE_BLOCK_SIZE & 0x7fffffffUL ), /* Mask to keep lint happy. It's still a constant. */
-                    0,
-                    C->pucRxBlockBitmap,
+                    ( int32_t ) ulBlockOffset,
+                    pucBitmap,
                     ulBitmapLen ) )
             {
                 ulMsgSizeToPublish = ( uint32_t ) xMsgSizeFromStream;
@@ -1237,6 +1939,10 @@ static OTA_Err_t prvPublishGetStreamMessage( OTA_FileContext_t * C )
                         OTA_LOG_L1( "[%s] OK: %s\r\n", OTA_METHOD_NAME, cTopicBuffer );
                         /* Restart the request timer to retry if we don't complete the update. */
                         prvStartRequestTimer( C );
+
+                        #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                            prvTransferStatsRequested();
+                        #endif
                     }
                 }
                 else
@@ -1325,6 +2031,10 @@ static void prvOTAUpdateTask( void * pvUnused )
     ( void ) pvUnused;
     OTA_PubMsg_t xMsgMetaData;
 
+    #if ( INCLUDE_vTaskPrioritySet == 1 )
+        UBaseType_t uxTaskPriority = otaconfigAGENT_PRIORITY;
+    #endif
+
     /* Subscribe to the OTA job notification topic. */
     if( prvSubscribeToJobNotificationTopics() == ( bool_t ) pdTRUE )
     {
@@ -1353,6 +2063,8 @@ static void prvOTAUpdateTask( void * pvUnused )
                     pdFALSE,                    /* Any bit set will do. */
                     ( TickType_t ) ~( 0U ) );   /* Wait forever. */
 
+                otaconfigTRACE_EVENTS( xBits );
+
                 /* Check for the shutdown event. */
                 if( ( ( uint32_t ) xBits & OTA_EVT_MASK_SHUTDOWN ) != 0U )
                 {
@@ -1365,21 +2077,37 @@ static void prvOTAUpdateTask( void * pvUnused )
                 {
                     OTA_LOG_L1( "[%s] Received user abort event.\r\n", OTA_METHOD_NAME );
                     ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted, kOTA_Err_UserAbort );
-                    ( void ) prvOTA_Close( pxC ); /* Ignore false result since we're setting the pointer to null on the next line. */
+
+                    #if ( otaconfigENABLE_RESUME == 1 )
+                        prvCheckpointClear();
+                    #endif
+
+                    ( void ) prvOTA_CloseJob( pxC ); /* Ignore false result since we're setting the pointer to null on the next line. */
                     pxC = NULL;
                 }
 
                 /* On OTA request timer timeout, publish the stream request if we have context. */
                 if( ( ( xBits & OTA_EVT_MASK_REQ_TIMEOUT ) != 0U ) && ( pxC != NULL ) )
                 {
+                    #if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+                        if( ( pxC->ulBlocksRemaining > 0U ) && ( prvUsesHTTPDataPlane( pxC ) == true ) )
+                        {
+                            pxC = prvRequestFileRange( pxC );
+                        }
+                        else
+                    #endif
                     if( pxC->ulBlocksRemaining > 0U )
                     {
+                        #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+                            prvRequestWindowTimeout();
+                        #endif
+
                         xErr = prvPublishGetStreamMessage( pxC );
 
                         if( xErr != kOTA_Err_None )
-                        {                                 /* Abort the current OTA. */
+                        {                                    /* Abort the current OTA. */
                             ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted, xErr );
-                            ( void ) prvOTA_Close( pxC ); /* Ignore false result since we're setting the pointer to null on the next line. */
+                            ( void ) prvOTA_CloseJob( pxC ); /* Ignore false result since we're setting the pointer to null on the next line. */
                             pxC = NULL;
                         }
                     }
@@ -1400,13 +2128,15 @@ static void prvOTAUpdateTask( void * pvUnused )
                     {
                         while( xQueueReceive( xOTA_Agent.xOTA_MsgQ, &xMsgMetaData, 0 ) != pdFALSE )
                         {
+                            otaconfigTRACE_MESSAGE_RECEIVED( xMsgMetaData.eMsgType, xMsgMetaData.xPubData.ulDataLength );
+
                             /* Check for OTA update job messages. */
                             if( xMsgMetaData.eMsgType == eOTA_PubMsgType_Job )
                             {
                                 if( pxC != NULL )
                                 {
                                     ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted, kOTA_Err_UserAbort );
-                                    ( void ) prvOTA_Close( pxC ); /* Abort the existing OTA and ignore impossible false result by design. */
+                                    ( void ) prvOTA_CloseJob( pxC ); /* Abort the existing OTA and ignore impossible false result by design. */
                                 }
 
                                 pxC = prvProcessOTAJobMsg( ( const char * ) xMsgMetaData.xPubData.pvData, /*lint !e9079 pointer to void is OK to cast to the real type. */
@@ -1454,56 +2184,14 @@ static void prvOTAUpdateTask( void * pvUnused )
                                                                                  xMsgMetaData.xPubData.ulDataLength,
                                                                                  &xCloseResult );
 
-                                    if( xResult < eIngest_Result_Accepted_Continue )
-                                    {
-                                        /* Negative result codes mean we should stop the OTA process
-                                         * because we are either done or in an unrecoverable error state.
-                                         * We don't want to hang on to the resources. */
-
-                                        if( xResult == eIngest_Result_FileComplete )
-                                        {
-                                            /* File receive is complete and authenticated. Update the job status with the self_test ready identifier. */
-                                            prvUpdateJobStatus( pxC, eJobStatus_InProgress, ( int32_t ) eJobReason_SigCheckPassed, ( int32_t ) NULL );
-                                        }
-                                        else
-                                        {
-                                            OTA_LOG_L1( "[%s] Aborting due to IngestResult_t error %d\r\n", OTA_METHOD_NAME, ( int32_t ) xResult );
-                                            /* Call the platform specific code to reject the image. */
-                                            xErr = prvPAL_SetPlatformImageState( eOTA_ImageState_Rejected );
-
-                                            if( xErr != kOTA_Err_None )
-                                            {
-                                                OTA_LOG_L2( "[%s] Error trying to set platform image state (0x%08x)\r\n", OTA_METHOD_NAME, ( int32_t ) xErr );
-                                            }
-                                            else
-                                            {
-                                                /* Nothing special to do on success. */
-                                            }
-
-                                            prvUpdateJobStatus( pxC, eJobStatus_FailedWithVal, ( int32_t ) xCloseResult, ( int32_t ) xResult );
-                                        }
-
-                                        /* Release all remaining resources of the OTA file. */
-                                        ( void ) prvOTA_Close( pxC ); /* Ignore false result since we're setting the pointer to null on the next line. */
-                                        pxC = NULL;
+                                    pxC = prvProcessIngestResult( pxC, xResult, xCloseResult );
 
-                                        /* Let main application know of our result. */
-                                        xOTA_Agent.xOTAJobCompleteCallback( ( xResult == eIngest_Result_FileComplete ) ? eOTA_JobEvent_Activate : eOTA_JobEvent_Fail );
-
-                                        /* Free any remaining string memory holding the job name since this job is done. */
-                                        if( xOTA_Agent.pucOTA_Singleton_ActiveJobName != NULL )
+                                    #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+                                        if( pxC != NULL )
                                         {
-                                            vPortFree( xOTA_Agent.pucOTA_Singleton_ActiveJobName );
-                                            xOTA_Agent.pucOTA_Singleton_ActiveJobName = NULL;
+                                            prvRequestWindowBlockReceived( pxC );
                                         }
-                                    }
-                                    else
-                                    {
-                                        /* We're actively receiving a file so update the job status as needed. */
-                                        /* First reset the momentum counter since we received a good block. */
-                                        pxC->ulRequestMomentum = 0;
-                                        prvUpdateJobStatus( pxC, eJobStatus_InProgress, ( int32_t ) eJobReason_Receiving, ( int32_t ) NULL );
-                                    }
+                                    #endif
                                 }
                             }
                             else
@@ -1512,6 +2200,8 @@ static void prvOTAUpdateTask( void * pvUnused )
                                 OTA_LOG_L2( "[%s] Ignoring unknown message type %d.\r\n", OTA_METHOD_NAME, xMsgMetaData.lMsgType );
                             }
 
+                            otaconfigTRACE_MESSAGE_PROCESSED( xMsgMetaData.eMsgType );
+
                             if( xMsgMetaData.xPubData.xBuffer != NULL )
                             {
                                 xOTA_Agent.xStatistics.ulOTA_PacketsProcessed++;
@@ -1540,6 +2230,20 @@ static void prvOTAUpdateTask( void * pvUnused )
                     /* Any event that releases the context structure tells us we're not active anymore. */
                     xOTA_Agent.eState = eOTA_AgentState_Ready;
                 }
+
+                #if ( INCLUDE_vTaskPrioritySet == 1 )
+                    /* Give way to the application tasks while the blocks of a file are being decoded and written. */
+                    if( otaconfigINGEST_PRIORITY != otaconfigAGENT_PRIORITY )
+                    {
+                        UBaseType_t uxPriority = ( ( pxC != NULL ) && ( pxC->ulBlocksRemaining > 0U ) ) ? otaconfigINGEST_PRIORITY : otaconfigAGENT_PRIORITY;
+
+                        if( uxPriority != uxTaskPriority )
+                        {
+                            vTaskPrioritySet( NULL, uxPriority );
+                            uxTaskPriority = uxPriority;
+                        }
+                    }
+                #endif
             }
 
             /* If we're here, we're shutting down the OTA agent. Free up all resources and quit. */
@@ -1672,6 +2376,9 @@ static void prvStartRequestTimer( OTA_FileContext_t * C )
 
         if( C->xRequestTimer != NULL )
         {
+            #if ( configUSE_TIMER_SLACK == 1 )
+                vTimerSetSlack( C->xRequestTimer, pdMS_TO_TICKS( otaconfigREQUEST_TIMER_SLACK_MS ) );
+            #endif
             xTimerStarted = xTimerStart( C->xRequestTimer, 0 );
         }
     }
@@ -1704,6 +2411,377 @@ static void prvStopRequestTimer( OTA_FileContext_t * C )
     }
 }
 
+#if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+
+/* Start a new request window for a file that is about to be received. The initial window
+ * matches what the message queue can buffer while the OTA task is busy writing blocks. */
+
+    static void prvRequestWindowReset( void )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+
+        memset( pxWindow, 0, sizeof( OTA_RequestWindow_t ) );
+        pxWindow->ulSize = ( OTA_NUM_MSG_Q_ENTRIES < otaconfigMAX_BLOCKS_IN_FLIGHT ) ? OTA_NUM_MSG_Q_ENTRIES : otaconfigMAX_BLOCKS_IN_FLIGHT;
+
+        if( pxWindow->ulSize == 0U )
+        {
+            pxWindow->ulSize = 1U;
+        }
+
+        #if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+            /* Start with a full bucket so that the first request is not delayed. */
+            pxWindow->xTimeout = pdMS_TO_TICKS( otaconfigFILE_REQUEST_WAIT_MS );
+            pxWindow->ulCredit = otaconfigMAX_BLOCKS_IN_FLIGHT * configTICK_RATE_HZ;
+            pxWindow->ulRate = otaconfigMAX_BLOCKS_PER_SECOND;
+            pxWindow->xCreditTick = xTaskGetTickCount();
+        #endif
+
+        #if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U )
+            /* Only what happens from now on counts. */
+            ( void ) prvCountSlowMQTTSamples( &pxWindow->ulSlowSamples );
+        #endif
+    }
+
+
+/* Select the next missing blocks, starting at the request cursor, until the window is full.
+ * Blocks passed by the cursor are in flight. The cursor only wraps around the end of the part
+ * of the file tracked by the block bitmap once nothing is in flight any more, so that only the
+ * blocks that were lost are requested again and none that may still be on their way. The
+ * selection has the same layout as the block bitmap, starting at C->ulBitmapBase. */
+
+    static uint32_t prvRequestWindowSelect( const OTA_FileContext_t * C,
+                                            uint8_t * pucBitmap,
+                                            uint32_t ulBitmapLen )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+        uint32_t ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulTrackedEnd = C->ulBitmapBase + ( ulBitmapLen * BITS_PER_BYTE );
+        uint32_t ulWanted = 0U;
+        uint32_t ulSelected = 0U;
+        uint32_t ulScanned;
+        uint8_t ucBitMask;
+        uint32_t ulByte;
+
+        memset( pucBitmap, 0, ulBitmapLen );
+
+        if( ulTrackedEnd > ulNumBlocks )
+        {
+            ulTrackedEnd = ulNumBlocks;
+        }
+
+        if( pxWindow->ulSize > pxWindow->ulInFlight )
+        {
+            ulWanted = pxWindow->ulSize - pxWindow->ulInFlight;
+        }
+
+        #if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+            {
+                uint32_t ulAllowed = prvRequestBudgetAvailable();
+
+                if( ulWanted > ulAllowed )
+                {
+                    ulWanted = ulAllowed;
+                }
+            }
+        #endif
+
+        /* Everything before the bitmap has been received already. */
+        if( pxWindow->ulCursor < C->ulBitmapBase )
+        {
+            pxWindow->ulCursor = C->ulBitmapBase;
+        }
+
+        for( ulScanned = 0U; ( ulScanned < ( ulTrackedEnd - C->ulBitmapBase ) ) && ( ulSelected < ulWanted ); ulScanned++ )
+        {
+            if( pxWindow->ulCursor >= ulTrackedEnd )
+            {
+                if( ( pxWindow->ulInFlight + ulSelected ) > 0U )
+                {
+                    break;
+                }
+
+                pxWindow->ulCursor = C->ulBitmapBase;
+            }
+
+            ucBitMask = 1U << ( pxWindow->ulCursor % BITS_PER_BYTE ); /*lint !e9031 The composite expression will never be greater than BITS_PER_BYTE(8). */
+            ulByte = ( pxWindow->ulCursor - C->ulBitmapBase ) >> LOG2_BITS_PER_BYTE;
+
+            if( ( C->pucRxBlockBitmap[ ulByte ] & ucBitMask ) != 0U )
+            {
+                pucBitmap[ ulByte ] |= ucBitMask;
+                ulSelected++;
+            }
+
+            pxWindow->ulCursor++;
+        }
+
+        if( ulSelected > 0U )
+        {
+            pxWindow->ulInFlight += ulSelected;
+            pxWindow->ulDropped = xOTA_Agent.xStatistics.ulOTA_PacketsDropped;
+            pxWindow->xRequestTick = xTaskGetTickCount();
+            pxWindow->xRTTPending = true;
+            pxWindow->xResizePending = true;
+
+            #if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+                prvRequestBudgetSpend( C, ulSelected );
+            #endif
+        }
+
+        return ulSelected;
+    }
+
+
+/* Account for a received block. The first block after a request gives a round trip sample
+ * that sets the request timeout. Once half of the window has arrived the window is resized,
+ * halving it if the message queue dropped packets since the last request and growing it by
+ * one block otherwise, and the next request is sent while the rest is still arriving. */
+
+    static void prvRequestWindowBlockReceived( OTA_FileContext_t * C )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+        TickType_t xTimeout;
+
+        if( pxWindow->ulInFlight > 0U )
+        {
+            pxWindow->ulInFlight--;
+        }
+
+        if( pxWindow->xRTTPending == true )
+        {
+            TickType_t xSample = xTaskGetTickCount() - pxWindow->xRequestTick;
+
+            pxWindow->xRTTPending = false;
+
+            if( pxWindow->xSmoothedRTT == 0U )
+            {
+                pxWindow->xSmoothedRTT = xSample;
+            }
+            else
+            {
+                pxWindow->xSmoothedRTT = ( ( pxWindow->xSmoothedRTT * 7U ) + xSample ) / 8U;
+            }
+
+            xTimeout = pxWindow->xSmoothedRTT * 4U;
+
+            if( xTimeout < OTA_MIN_REQUEST_WAIT_TICKS )
+            {
+                xTimeout = OTA_MIN_REQUEST_WAIT_TICKS;
+            }
+            else if( xTimeout > pdMS_TO_TICKS( otaconfigFILE_REQUEST_WAIT_MS ) )
+            {
+                xTimeout = pdMS_TO_TICKS( otaconfigFILE_REQUEST_WAIT_MS );
+            }
+
+            #if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+                pxWindow->xTimeout = xTimeout;
+            #endif
+
+            if( C->xRequestTimer != NULL )
+            {
+                ( void ) xTimerChangePeriod( C->xRequestTimer, xTimeout, 0 );
+            }
+        }
+
+        if( ( C->ulBlocksRemaining > 0U ) && ( pxWindow->ulInFlight <= ( pxWindow->ulSize / 2U ) ) )
+        {
+            if( pxWindow->xResizePending == true )
+            {
+                pxWindow->xResizePending = false;
+
+                if( xOTA_Agent.xStatistics.ulOTA_PacketsDropped != pxWindow->ulDropped )
+                {
+                    pxWindow->ulSize = ( pxWindow->ulSize > 1U ) ? ( pxWindow->ulSize / 2U ) : 1U;
+                }
+                else if( pxWindow->ulSize < otaconfigMAX_BLOCKS_IN_FLIGHT )
+                {
+                    pxWindow->ulSize++;
+                }
+
+                #if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U )
+                    prvRequestBudgetAdapt();
+                #endif
+            }
+
+            /* A failure is retried by the request timer, which also aborts on too much momentum. */
+            ( void ) prvPublishGetStreamMessage( C );
+        }
+    }
+
+
+/* The request timer expired, so the blocks still in flight are considered lost and the
+ * window is halved. The cursor already moved past them so they are requested again only
+ * when it wraps around, after the rest of the file has been requested. */
+
+    static void prvRequestWindowTimeout( void )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+
+        if( pxWindow->ulInFlight > 0U )
+        {
+            pxWindow->ulInFlight = 0U;
+            pxWindow->xRTTPending = false;
+            pxWindow->xResizePending = false;
+            pxWindow->ulSize = ( pxWindow->ulSize > 1U ) ? ( pxWindow->ulSize / 2U ) : 1U;
+        }
+    }
+#endif /* if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U ) */
+
+#if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U )
+
+/* Fill the token bucket for the ticks passed since it was last filled and return the number
+ * of whole blocks in it. The fill level is kept in blocks times configTICK_RATE_HZ so that
+ * every tick adds the rate in blocks per second without rounding. */
+
+    static uint32_t prvRequestBudgetAvailable( void )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+        const uint32_t ulCapacity = otaconfigMAX_BLOCKS_IN_FLIGHT * configTICK_RATE_HZ;
+        TickType_t xNow = xTaskGetTickCount();
+        TickType_t xElapsed = xNow - pxWindow->xCreditTick;
+
+        pxWindow->xCreditTick = xNow;
+
+        /* A long pause fills the bucket anyway, so don't risk overflowing the product. */
+        if( xElapsed >= ( TickType_t ) ( otaconfigMAX_BLOCKS_IN_FLIGHT * configTICK_RATE_HZ ) )
+        {
+            pxWindow->ulCredit = ulCapacity;
+        }
+        else
+        {
+            pxWindow->ulCredit += ( uint32_t ) xElapsed * pxWindow->ulRate;
+
+            if( pxWindow->ulCredit > ulCapacity )
+            {
+                pxWindow->ulCredit = ulCapacity;
+            }
+        }
+
+        return pxWindow->ulCredit / configTICK_RATE_HZ;
+    }
+
+
+/* Take the blocks of a request from the token bucket. prvRequestBudgetAvailable() has just
+ * checked that they are in it. If the request timer was waiting for the bucket, put back the
+ * period that waits for the blocks. */
+
+    static void prvRequestBudgetSpend( const OTA_FileContext_t * C,
+                                       uint32_t ulBlocks )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+
+        pxWindow->ulCredit -= ulBlocks * configTICK_RATE_HZ;
+
+        if( ( pxWindow->xBudgetWait == true ) && ( C->xRequestTimer != NULL ) )
+        {
+            ( void ) xTimerChangePeriod( C->xRequestTimer, pxWindow->xTimeout, 0 );
+        }
+
+        pxWindow->xBudgetWait = false;
+    }
+
+
+/* Nothing could be requested. If blocks are still in flight, the next one to arrive tries
+ * again, so the request timer keeps watching for them. Otherwise, run the request timer until
+ * the bucket holds one block. It then sends the next request like a timeout would, without
+ * losing anything since nothing is in flight. */
+
+    static bool_t prvRequestBudgetWait( const OTA_FileContext_t * C )
+    {
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+        bool_t xWaiting = false;
+        TickType_t xWait;
+
+        if( ( pxWindow->ulInFlight == 0U ) && ( C->xRequestTimer != NULL ) &&
+            ( pxWindow->ulCredit < configTICK_RATE_HZ ) )
+        {
+            xWait = ( TickType_t ) ( ( configTICK_RATE_HZ - pxWindow->ulCredit + pxWindow->ulRate - 1U ) / pxWindow->ulRate );
+
+            if( xWait == 0U )
+            {
+                xWait = 1U;
+            }
+
+            if( xTimerChangePeriod( C->xRequestTimer, xWait, 0 ) == pdPASS )
+            {
+                pxWindow->xBudgetWait = true;
+                xWaiting = true;
+            }
+        }
+
+        return xWaiting;
+    }
+#endif /* if ( otaconfigMAX_BLOCKS_PER_SECOND > 0U ) */
+
+#if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U )
+
+/* Count the MQTT command queue waits and PUBACK waits that reached the back off threshold.
+ * The latency histograms only tell which power of two range a sample fell in, so only the
+ * buckets that start at or above the threshold are counted. */
+
+    static bool_t prvCountSlowMQTTSamples( uint32_t * pulSlowSamples )
+    {
+        const TickType_t xThreshold = pdMS_TO_TICKS( otaconfigBACKOFF_MQTT_LATENCY_MS );
+        MQTTAgentStatistics_t xMQTTStats;
+        bool_t xCounted = false;
+        uint32_t ulFirstBucket = 1U;
+        uint32_t ulBucket;
+
+        if( MQTT_AGENT_GetStatistics( xOTA_Agent.pvPubSubClient, &xMQTTStats ) == eMQTTAgentSuccess )
+        {
+            /* Bucket n starts at 2 ^ ( n - 1 ) ticks. */
+            while( ( ulFirstBucket < ( mqttagentLATENCY_BUCKETS - 1U ) ) &&
+                   ( ( ( TickType_t ) 1U << ( ulFirstBucket - 1U ) ) < xThreshold ) )
+            {
+                ulFirstBucket++;
+            }
+
+            *pulSlowSamples = 0U;
+
+            for( ulBucket = ulFirstBucket; ulBucket < mqttagentLATENCY_BUCKETS; ulBucket++ )
+            {
+                *pulSlowSamples += xMQTTStats.xCommandQueueWait.ulBuckets[ ulBucket ];
+                *pulSlowSamples += xMQTTStats.xPublishToAck.ulBuckets[ ulBucket ];
+            }
+
+            xCounted = true;
+        }
+
+        return xCounted;
+    }
+
+
+/* Halve the block rate if the MQTT agent had slow samples since the last call, otherwise
+ * grow it by one block per second. The rate is left alone if the statistics are not available. */
+
+    static void prvRequestBudgetAdapt( void )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvRequestBudgetAdapt" );
+
+        OTA_RequestWindow_t * pxWindow = &xOTA_Agent.xRequestWindow;
+        uint32_t ulSlowSamples;
+
+        if( prvCountSlowMQTTSamples( &ulSlowSamples ) == true )
+        {
+            if( ulSlowSamples != pxWindow->ulSlowSamples )
+            {
+                pxWindow->ulRate = ( pxWindow->ulRate > 1U ) ? ( pxWindow->ulRate / 2U ) : 1U;
+                OTA_LOG_L1( "[%s] MQTT is slow, %u blocks per second.\r\n", OTA_METHOD_NAME, pxWindow->ulRate );
+            }
+            else if( pxWindow->ulRate < otaconfigMAX_BLOCKS_PER_SECOND )
+            {
+                pxWindow->ulRate++;
+            }
+            else
+            {
+                /* Already at the configured rate. */
+            }
+
+            pxWindow->ulSlowSamples = ulSlowSamples;
+        }
+    }
+#endif /* if ( otaconfigBACKOFF_MQTT_LATENCY_MS > 0U ) */
+
 
 /* Close an existing OTA context and free its resources. */
 
@@ -1725,13 +2803,31 @@ static bool_t prvOTA_Close( OTA_FileContext_t * const C )
             C->xRequestTimer = NULL;
         }
 
+        #if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
+            prvGreengrassCacheStop( C ); /* The data stream is then unsubscribed from below. */
+        #endif
+
         if( C->pucStreamName != NULL )
         {
-            ( void ) prvUnSubscribeFromDataStream( C ); /* Unsubscribe from the data stream if needed. */
-            vPortFree( C->pucStreamName );              /* Free any previously allocated stream name memory. */
+            if( prvUsesHTTPDataPlane( C ) == false )
+            {
+                ( void ) prvUnSubscribeFromDataStream( C ); /* Unsubscribe from the data stream if needed. */
+            }
+
+            vPortFree( C->pucStreamName ); /* Free any previously allocated stream name memory. */
             C->pucStreamName = NULL;
         }
 
+        if( C->pucUpdateUrl != NULL )
+        {
+            #if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+                OTA_HTTP_Disconnect( &xHTTPConnection ); /* Don't hold the connection open between files. */
+            #endif
+
+            vPortFree( C->pucUpdateUrl ); /* Free the file data URL string memory. */
+            C->pucUpdateUrl = NULL;
+        }
+
         if( C->pucJobName != NULL )
         {
             vPortFree( C->pucJobName ); /* Free the job name memory. */
@@ -1762,6 +2858,29 @@ static bool_t prvOTA_Close( OTA_FileContext_t * const C )
             C->pucCertFilepath = NULL;
         }
 
+        if( C->pvDeltaContext != NULL )
+        {
+            vPortFree( C->pvDeltaContext ); /* Free the patch applier state and its staging buffer. */
+            C->pvDeltaContext = NULL;
+        }
+
+        if( C->pvDecompressContext != NULL )
+        {
+            vPortFree( C->pvDecompressContext ); /* Free the decompressor state, its staging buffer and window. */
+            C->pvDecompressContext = NULL;
+        }
+
+        #if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+            prvStreamSignatureAbandon( C );
+        #endif
+
+        /* Let the writer task finish with the file before it is released. */
+        ( void ) prvWriteFlush();
+
+        #if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+            xWriteBehind.lError = 0;
+        #endif
+
         /* Abort any active file access and release the file resource, if needed. */
         ( void ) prvPAL_Abort( C );
         memset( C, 0, sizeof( OTA_FileContext_t ) ); /* Clear the entire structure now that it is free. */
@@ -1798,20 +2917,58 @@ static OTA_FileContext_t * prvGetFreeContext( void )
 }
 
 
-bool_t JSON_IsCStringEqual( const char * pcJSONString,
-                            uint32_t ulLen,
-                            const char * pcCString )
+/* The files of a job take the free contexts in the order of the job document when the job
+ * is accepted, so the files still to be received are the ones in the contexts after it. */
+
+static OTA_FileContext_t * prvGetNextJobFile( const OTA_FileContext_t * C )
 {
-    bool_t xResult;
+    uint32_t ulIndex;
+    OTA_FileContext_t * pxNext = NULL;
 
-    if( ( ulLen <= OTA_MAX_JSON_STR_LEN ) &&
-        ( strncmp( pcJSONString, pcCString, ulLen ) == 0 ) && /*lint !e9007 I see no side effect. Possibly a lint bug. */
-        ( pcCString[ ulLen ] == '\0' ) )
+    for( ulIndex = ( uint32_t ) ( C - xOTA_Agent.xOTA_Files ) + 1U; ( ulIndex < OTA_MAX_FILES ) && ( pxNext == NULL ); ulIndex++ )
     {
-        xResult = pdTRUE;
+        if( xOTA_Agent.xOTA_Files[ ulIndex ].pucFilePath != NULL )
+        {
+            pxNext = &xOTA_Agent.xOTA_Files[ ulIndex ];
+        }
     }
-    else
-    {
+
+    return pxNext;
+}
+
+
+/* Close a file context that ends the job, along with the files of the job still to be received. */
+
+static bool_t prvOTA_CloseJob( OTA_FileContext_t * const C )
+{
+    OTA_FileContext_t * pxNext;
+
+    if( C != NULL )
+    {
+        for( pxNext = prvGetNextJobFile( C ); pxNext != NULL; pxNext = prvGetNextJobFile( C ) )
+        {
+            ( void ) prvOTA_Close( pxNext );
+        }
+    }
+
+    return prvOTA_Close( C );
+}
+
+
+bool_t JSON_IsCStringEqual( const char * pcJSONString,
+                            uint32_t ulLen,
+                            const char * pcCString )
+{
+    bool_t xResult;
+
+    if( ( ulLen <= OTA_MAX_JSON_STR_LEN ) &&
+        ( strncmp( pcJSONString, pcCString, ulLen ) == 0 ) && /*lint !e9007 I see no side effect. Possibly a lint bug. */
+        ( pcCString[ ulLen ] == '\0' ) )
+    {
+        xResult = pdTRUE;
+    }
+    else
+    {
         xResult = pdFALSE;
     }
 
@@ -1819,7 +2976,26 @@ bool_t JSON_IsCStringEqual( const char * pcJSONString,
 }
 
 
-/* Search our document model for a key match with the given token. */
+/* FNV-1a hash of the key. Any well mixed hash works since the table resolves collisions. */
+
+static uint32_t prvHashModelKey( const char * pcKey,
+                                 uint32_t ulLen )
+{
+    uint32_t ulHash = 2166136261UL;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0U; ulIndex < ulLen; ulIndex++ )
+    {
+        ulHash = ( ulHash ^ ( uint8_t ) pcKey[ ulIndex ] ) * 16777619UL;
+    }
+
+    return ulHash;
+}
+
+
+/* Search our document model for a key match with the given token. The key table built by
+ * prvInitDocModel() is probed from the slot of the key hash until the key or an empty slot
+ * is found, so usually only one model key is compared instead of all of them. */
 
 static DocParseErr_t prvSearchModelForTokenKey( JSON_DocModel_t * pxDocModel,
                                                 const char * pcJSONString,
@@ -1828,9 +3004,21 @@ static DocParseErr_t prvSearchModelForTokenKey( JSON_DocModel_t * pxDocModel,
 {
     DocParseErr_t eErr = eDocParseErr_ParamKeyNotInModel;
     uint16_t usParamIndex;
+    uint32_t ulSlot = prvHashModelKey( pcJSONString, ulStrLen );
+    uint32_t ulProbe;
 
-    for( usParamIndex = 0; usParamIndex < pxDocModel->usNumModelParams; usParamIndex++ )
+    for( ulProbe = 0U; ulProbe < OTA_DOC_MODEL_KEY_TABLE_SIZE; ulProbe++ )
     {
+        ulSlot &= ( OTA_DOC_MODEL_KEY_TABLE_SIZE - 1U );
+
+        if( pxDocModel->ucKeyTable[ ulSlot ] == 0U )
+        {
+            break; /* An empty slot ends the probe sequence so the key is not in the model. */
+        }
+
+        usParamIndex = ( uint16_t ) pxDocModel->ucKeyTable[ ulSlot ] - 1U;
+        ulSlot++;
+
         if( JSON_IsCStringEqual( pcJSONString, ulStrLen,
                                  pxDocModel->pxBodyDef[ usParamIndex ].pcSrcKey ) == ( bool_t ) pdTRUE )
         {
@@ -1873,6 +3061,8 @@ static DocParseErr_t prvParseJSONbyModel( const char * pcJSON,
     uint32_t ulIndex;
     uint16_t usModelParamIndex;
     uint32_t ulScanIndex;
+    int32_t lArrayToken = -1;    /* Token of the array parameter value being scanned, if any. */
+    uint32_t ulArrayElement = 0; /* Index of the next element of that array. */
     DocParseErr_t eErr = eDocParseErr_Unknown;
 
 
@@ -1904,23 +3094,46 @@ static DocParseErr_t prvParseJSONbyModel( const char * pcJSON,
     {
         pxModelParam = pxDocModel->pxBodyDef;
 
-        /* Count the total number of tokens in our JSON document. */
-        ulNumTokens = ( uint32_t ) jsmn_parse( &xParser, pcJSON, ( size_t ) ulMsgLen, NULL, 1UL );
+        #if ( configUSE_TASK_ARENAS == 1 )
+            if( xJobParserArena == NULL )
+            {
+                xJobParserArena = xTaskArenaCreateStatic( ucJobParserArenaStorage,
+                                                          sizeof( ucJobParserArenaStorage ),
+                                                          &xJobParserArenaBuffer );
+            }
+
+            /* Start from an empty arena, also after a parse that failed. The arena always has
+             * room for OTA_MAX_JSON_TOKENS tokens so the document is tokenized in a single pass.
+             * A document with more tokens makes jsmn return a negative count, which the size
+             * check below rejects just like it does for the counting pass. */
+            vTaskArenaReset( xJobParserArena );
+            pxTokens = ( jsmntok_t * ) pvTaskArenaAllocate( xJobParserArena, OTA_MAX_JSON_TOKENS * sizeof( jsmntok_t ) ); /*lint !e9079 !e9087 arena allocations return void* so we allow casting to a pointer to the actual type. */
+            configASSERT( pxTokens != NULL );
+            ulNumTokens = ( uint32_t ) jsmn_parse( &xParser, pcJSON, ( size_t ) ulMsgLen, pxTokens, OTA_MAX_JSON_TOKENS );
+        #else
+            /* Count the total number of tokens in our JSON document. */
+            ulNumTokens = ( uint32_t ) jsmn_parse( &xParser, pcJSON, ( size_t ) ulMsgLen, NULL, 1UL );
+        #endif
 
         if( ulNumTokens > 0U )
         {
             /* If the JSON document isn't too big for our token array... */
             if( ulNumTokens <= OTA_MAX_JSON_TOKENS )
             {
-                /* Allocate space for the document JSON tokens. */
-                void * pvTokenArray = pvPortMalloc( ulNumTokens * sizeof( jsmntok_t ) ); /* Allocate space on heap for temporary token array. */
-                pxTokens = ( jsmntok_t * ) pvTokenArray;                                 /*lint !e9079 !e9087 heap allocations return void* so we allow casting to a pointer to the actual type. */
+                #if ( configUSE_TASK_ARENAS == 0 )
+                    /* Allocate space on heap for temporary token array. */
+                    pxTokens = ( jsmntok_t * ) pvPortMalloc( ulNumTokens * sizeof( jsmntok_t ) ); /*lint !e9079 !e9087 heap allocations return void* so we allow casting to a pointer to the actual type. */
+                #endif
 
                 if( pxTokens != NULL )
                 {
-                    /* Reset Jasmine again and tokenize the document for real. */
-                    jsmn_init( &xParser );
-                    ulIndex = ( uint32_t ) jsmn_parse( &xParser, pcJSON, ulMsgLen, pxTokens, ulNumTokens );
+                    #if ( configUSE_TASK_ARENAS == 1 )
+                        ulIndex = ulNumTokens; /* Already tokenized above. */
+                    #else
+                        /* Reset Jasmine again and tokenize the document for real. */
+                        jsmn_init( &xParser );
+                        ulIndex = ( uint32_t ) jsmn_parse( &xParser, pcJSON, ulMsgLen, pxTokens, ulNumTokens );
+                    #endif
 
                     if( ulIndex == ulNumTokens )
                     {
@@ -1930,8 +3143,26 @@ static DocParseErr_t prvParseJSONbyModel( const char * pcJSON,
                         /* Examine each JSON token, searching for job parameters based on our document model. */
                         for( ulIndex = 0U; ( eErr == eDocParseErr_None ) && ( ulIndex < ulNumTokens ); ulIndex++ )
                         {
+                            /* Only the selected element of an array parameter is extracted. */
+                            if( ( lArrayToken >= 0 ) && ( pxTokens[ ulIndex ].parent == lArrayToken ) )
+                            {
+                                if( ulArrayElement != pxDocModel->usArrayElement )
+                                {
+                                    int32_t lRoot = ( int32_t ) ulIndex; /* Skip the other elements like unrecognized keys. */
+                                    ulIndex++;
+
+                                    while( ( ulIndex < ulNumTokens ) && ( pxTokens[ ulIndex ].parent >= lRoot ) )
+                                    {
+                                        ulIndex++;
+                                    }
+
+                                    --ulIndex; /* Adjust for outer for-loop increment. */
+                                }
+
+                                ulArrayElement++;
+                            }
                             /* All parameter keys are JSON strings. */
-                            if( pxTokens[ ulIndex ].type == JSMN_STRING )
+                            else if( pxTokens[ ulIndex ].type == JSMN_STRING )
                             {
                                 /* Search the document model to see if it matches the current key. */
                                 ulTokenLen = ( uint32_t ) pxTokens[ ulIndex ].end - ( uint32_t ) pxTokens[ ulIndex ].start;
@@ -1972,6 +3203,14 @@ static DocParseErr_t prvParseJSONbyModel( const char * pcJSON,
                                     }
                                     else if( OTA_DONT_STORE_PARAM == pxModelParam[ usModelParamIndex ].ulDestOffset )
                                     {
+                                        if( eModelParamType_Array == pxModelParam[ usModelParamIndex ].xModelParamType )
+                                        {
+                                            /* Keys are only taken from one element of the array. Count the elements for the caller. */
+                                            lArrayToken = ( int32_t ) ulIndex + 1;
+                                            ulArrayElement = 0U;
+                                            pxDocModel->usArrayElements = ( uint16_t ) pxValTok->size;
+                                        }
+
                                         /* Nothing to do with this parameter since we're not storing it. */
                                         continue;
                                     }
@@ -2117,7 +3356,11 @@ static DocParseErr_t prvParseJSONbyModel( const char * pcJSON,
                         }
 
                         /* Free the token memory. */
-                        vPortFree( pxTokens ); /*lint !e850 ulIndex is intentionally modified within the loop to skip over unknown tags. */
+                        #if ( configUSE_TASK_ARENAS == 1 )
+                            vTaskArenaReset( xJobParserArena );
+                        #else
+                            vPortFree( pxTokens ); /*lint !e850 ulIndex is intentionally modified within the loop to skip over unknown tags. */
+                        #endif
 
                         if( eErr == eDocParseErr_None )
                         {
@@ -2188,6 +3431,7 @@ static DocParseErr_t prvInitDocModel( JSON_DocModel_t * pxDocModel,
 
     DocParseErr_t eErr = eDocParseErr_Unknown;
     uint32_t ulScanIndex;
+    uint32_t ulSlot;
 
     /* Sanity check the model pointers and parameter count. Exclude the context base address and size since
      * it is technically possible to create a model that writes entirely into absolute memory locations.
@@ -2215,6 +3459,9 @@ static DocParseErr_t prvInitDocModel( JSON_DocModel_t * pxDocModel,
         pxDocModel->usNumModelParams = usNumJobParams;
         pxDocModel->ulParamsReceivedBitmap = 0;
         pxDocModel->ulParamsRequiredBitmap = 0;
+        pxDocModel->usArrayElement = 0;
+        pxDocModel->usArrayElements = 0;
+        memset( pxDocModel->ucKeyTable, 0, sizeof( pxDocModel->ucKeyTable ) );
 
         /* Scan the model and detect all required parameters (i.e. not optional). */
         for( ulScanIndex = 0; ulScanIndex < pxDocModel->usNumModelParams; ulScanIndex++ )
@@ -2224,6 +3471,18 @@ static DocParseErr_t prvInitDocModel( JSON_DocModel_t * pxDocModel,
                 /* Add parameter to the required bitmap. */
                 pxDocModel->ulParamsRequiredBitmap |= ( 1UL << ulScanIndex );
             }
+
+            /* Enter the key into the lookup table at the first free slot from its hash. The table
+             * is at least twice the maximum parameter count so there is always a free slot. */
+            ulSlot = prvHashModelKey( pxDocModel->pxBodyDef[ ulScanIndex ].pcSrcKey,
+                                      ( uint32_t ) strlen( pxDocModel->pxBodyDef[ ulScanIndex ].pcSrcKey ) );
+
+            while( pxDocModel->ucKeyTable[ ulSlot & ( OTA_DOC_MODEL_KEY_TABLE_SIZE - 1U ) ] != 0U )
+            {
+                ulSlot++;
+            }
+
+            pxDocModel->ucKeyTable[ ulSlot & ( OTA_DOC_MODEL_KEY_TABLE_SIZE - 1U ) ] = ( uint8_t ) ( ulScanIndex + 1U );
         }
 
         eErr = eDocParseErr_None;
@@ -2255,7 +3514,7 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
         { cOTA_JSON_UpdatedByKey,     OTA_JOB_PARAM_OPTIONAL, { OFFSET_OF( OTA_FileContext_t, ulUpdaterVersion )}, eModelParamType_UInt32,      JSMN_STRING    },
         { cOTA_JSON_JobDocKey,        OTA_JOB_PARAM_REQUIRED, { OTA_DONT_STORE_PARAM                           }, eModelParamType_Object,      JSMN_OBJECT    },
         { cOTA_JSON_OTAUnitKey,       OTA_JOB_PARAM_REQUIRED, { OTA_DONT_STORE_PARAM                           }, eModelParamType_Object,      JSMN_OBJECT    },
-        { cOTA_JSON_StreamNameKey,    OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, pucStreamName )  }, eModelParamType_StringCopy,  JSMN_STRING    },
+        { cOTA_JSON_StreamNameKey,    OTA_STREAM_NAME_PARAM_MODE, { OFFSET_OF( OTA_FileContext_t, pucStreamName )  }, eModelParamType_StringCopy,  JSMN_STRING    },
         { cOTA_JSON_FileGroupKey,     OTA_JOB_PARAM_REQUIRED, { OTA_DONT_STORE_PARAM                           }, eModelParamType_Array,       JSMN_ARRAY     },
         { cOTA_JSON_FilePathKey,      OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, pucFilePath )    }, eModelParamType_StringCopy,  JSMN_STRING    },
         { cOTA_JSON_FileSizeKey,      OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, ulFileSize )     }, eModelParamType_UInt32,      JSMN_PRIMITIVE },
@@ -2263,6 +3522,9 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
         { cOTA_JSON_FileCertNameKey,  OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, pucCertFilepath )}, eModelParamType_StringCopy,  JSMN_STRING    },
         { cOTA_JSON_FileSignatureKey, OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, pxSignature )    }, eModelParamType_SigBase64,   JSMN_STRING    },
         { cOTA_JSON_FileAttributeKey, OTA_JOB_PARAM_OPTIONAL, { OFFSET_OF( OTA_FileContext_t, ulFileAttributes )}, eModelParamType_UInt32,      JSMN_PRIMITIVE },
+        #if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+            { cOTA_JSON_UpdateDataUrlKey, OTA_JOB_PARAM_OPTIONAL, { OFFSET_OF( OTA_FileContext_t, pucUpdateUrl ) }, eModelParamType_StringCopy,  JSMN_STRING    },
+        #endif
     };
 
     OTA_JobParseErr_t eErr = eOTA_JobParseErr_Unknown;
@@ -2299,6 +3561,16 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
                 OTA_LOG_L1( "[%s] Zero file size is not allowed!\r\n", OTA_METHOD_NAME );
                 eErr = eOTA_JobParseErr_ZeroFileSize;
             }
+            else if( ( pxC->pucStreamName == NULL ) && ( prvUsesHTTPDataPlane( pxC ) == false ) )
+            {
+                OTA_LOG_L1( "[%s] The file has neither a stream nor a URL to receive it from!\r\n", OTA_METHOD_NAME );
+                eErr = eOTA_JobParseErr_NonConformingJobDoc;
+            }
+            else if( xOTA_JobDocModel.usArrayElements > OTA_MAX_FILES )
+            {
+                OTA_LOG_L1( "[%s] The job has %u files but at most %u are supported!\r\n", OTA_METHOD_NAME, xOTA_JobDocModel.usArrayElements, OTA_MAX_FILES );
+                eErr = eOTA_JobParseErr_NonConformingJobDoc;
+            }
             /* If there's an active job, verify that it's the same as what's being reported now. */
             /* We already checked for missing parameters so we SHOULD have a job name in the context. */
             else if( xOTA_Agent.pucOTA_Singleton_ActiveJobName != NULL )
@@ -2328,9 +3600,18 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
             }
             else
             {
-                /* Assume control of the job name from the context. */
-                xOTA_Agent.pucOTA_Singleton_ActiveJobName = pxC->pucJobName;
-                pxC->pucJobName = NULL;
+                if( pxC->xIsInSelfTest == ( bool_t ) pdFALSE )
+                {
+                    /* The other files of the job are received after this one. */
+                    eErr = prvParseQueuedFiles( pcJSON, ulMsgLen, xOTA_JobDocModelParamStructure, xOTA_JobDocModel.usArrayElements );
+                }
+
+                if( eErr == eOTA_JobParseErr_None )
+                {
+                    /* Assume control of the job name from the context. */
+                    xOTA_Agent.pucOTA_Singleton_ActiveJobName = pxC->pucJobName;
+                    pxC->pucJobName = NULL;
+                }
             }
 
             if( eErr == eOTA_JobParseErr_None )
@@ -2449,6 +3730,100 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
 }
 
 
+/* prvParseQueuedFiles
+ *
+ * Parse element 1 and up of the files array of the job document, each into a free file context
+ * in the order of the document, so that prvGetNextJobFile() finds them in that order. They share
+ * the job with the first file, so the job ID copy of each is dropped. On failure, the contexts
+ * taken here are released again and the job is rejected by the caller.
+ */
+
+static OTA_JobParseErr_t prvParseQueuedFiles( const char * pcJSON,
+                                              uint32_t ulMsgLen,
+                                              const JSON_DocParam_t * pxBodyDef,
+                                              uint16_t usNumFiles )
+{
+    DEFINE_OTA_METHOD_NAME( "prvParseQueuedFiles" );
+
+    OTA_JobParseErr_t eErr = eOTA_JobParseErr_None;
+    OTA_FileContext_t * pxFirst = NULL;
+    OTA_FileContext_t * pxFile;
+    JSON_DocModel_t xDocModel;
+    uint16_t usFile;
+
+    for( usFile = 1U; ( usFile < usNumFiles ) && ( eErr == eOTA_JobParseErr_None ); usFile++ )
+    {
+        pxFile = prvGetFreeContext();
+
+        if( pxFile == NULL )
+        {
+            OTA_LOG_L1( "[%s] Error! No context available for file %u of the job.\r\n", OTA_METHOD_NAME, usFile );
+            eErr = eOTA_JobParseErr_NoContextAvailable;
+        }
+        else if( prvInitDocModel( &xDocModel,
+                                  pxBodyDef,
+                                  ( uint32_t ) pxFile, /*lint !e9078 !e923 Intentionally casting context pointer to a value for prvInitDocModel. */
+                                  sizeof( OTA_FileContext_t ),
+                                  OTA_NUM_JOB_PARAMS ) != eDocParseErr_None )
+        {
+            eErr = eOTA_JobParseErr_BadModelInitParams;
+        }
+        else
+        {
+            xDocModel.usArrayElement = usFile;
+
+            if( prvParseJSONbyModel( pcJSON, ulMsgLen, &xDocModel ) != eDocParseErr_None )
+            {
+                eErr = eOTA_JobParseErr_NonConformingJobDoc;
+            }
+            else if( pxFile->ulFileSize == 0U )
+            {
+                OTA_LOG_L1( "[%s] Zero file size is not allowed!\r\n", OTA_METHOD_NAME );
+                eErr = eOTA_JobParseErr_ZeroFileSize;
+            }
+            else if( ( pxFile->pucStreamName == NULL ) && ( prvUsesHTTPDataPlane( pxFile ) == false ) )
+            {
+                OTA_LOG_L1( "[%s] The file has neither a stream nor a URL to receive it from!\r\n", OTA_METHOD_NAME );
+                eErr = eOTA_JobParseErr_NonConformingJobDoc;
+            }
+            else
+            {
+                OTA_LOG_L1( "[%s] File %u of the job is %s.\r\n", OTA_METHOD_NAME, usFile, pxFile->pucFilePath );
+            }
+
+            if( pxFile->pucJobName != NULL )
+            {
+                vPortFree( pxFile->pucJobName ); /* The first file holds the job ID. */
+                pxFile->pucJobName = NULL;
+            }
+        }
+
+        if( pxFile != NULL )
+        {
+            if( eErr != eOTA_JobParseErr_None )
+            {
+                ( void ) prvOTA_Close( pxFile ); /* Release the context of the file that failed. */
+            }
+            else if( pxFirst == NULL )
+            {
+                pxFirst = pxFile;
+            }
+            else
+            {
+                /* Queued after the first one. */
+            }
+        }
+    }
+
+    if( ( eErr != eOTA_JobParseErr_None ) && ( pxFirst != NULL ) )
+    {
+        ( void ) prvOTA_CloseJob( pxFirst );
+    }
+
+    return eErr;
+}
+
+
 /* prvProcessOTAJobMsg
  *
  * We received an OTA update job message from the job notification service.
@@ -2458,11 +3833,7 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
 static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
                                                 uint32_t ulMsgLen )
 {
-    uint32_t ulIndex;
-    uint32_t ulNumBlocks;             /* How many data pages are in the expected update image. */
-    uint32_t ulBitmapLen;             /* Length of the file block bitmap in bytes. */
     OTA_FileContext_t * pxUpdateFile; /* Pointer to an OTA update context. */
-    OTA_Err_t xErr = kOTA_Err_Uninitialized;
 
     /* Populate an OTA update context from the OTA job document. */
 
@@ -2470,250 +3841,1491 @@ static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
 
     if( ( pxUpdateFile != NULL ) && ( prvInSelftest() == false ) )
     {
+        pxUpdateFile = prvStartFileRx( pxUpdateFile );
+    }
+
+    return pxUpdateFile; /* Return the OTA file context. */
+}
+
+
+/* prvStartFileRx
+ *
+ * Allocate the block bitmap of a file of the job, subscribe to its data stream and open
+ * the receive file. The first file starts when the job is accepted and each following
+ * file of the job when the previous one is complete. On failure, the job is aborted.
+ */
+
+static OTA_FileContext_t * prvStartFileRx( OTA_FileContext_t * pxUpdateFile )
+{
+    uint32_t ulIndex;
+    uint32_t ulNumBlocks;             /* How many data pages are in the expected update image. */
+    uint32_t ulBitmapLen;             /* Length of the file block bitmap in bytes. */
+    OTA_Err_t xErr = kOTA_Err_Uninitialized;
+
+    if( pxUpdateFile->pucRxBlockBitmap != NULL )
+    {
+        vPortFree( pxUpdateFile->pucRxBlockBitmap ); /* Free any previously allocated bitmap. */
+        pxUpdateFile->pucRxBlockBitmap = NULL;
+    }
+
+    /* Calculate how many bytes we need in our bitmap for tracking received blocks.
+     * The below calculation requires power of 2 page sizes. */
+
+    ulNumBlocks = ( pxUpdateFile->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+    ulBitmapLen = prvGetBlockBitmapLen( ulNumBlocks );
+    pxUpdateFile->pucRxBlockBitmap = ( uint8_t * ) pvPortMallocWithCaps( ulBitmapLen, heapCAPS_BULK ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+    pxUpdateFile->ulBitmapBase = 0U;
+
+    #if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
         if( pxUpdateFile->pucRxBlockBitmap != NULL )
         {
-            vPortFree( pxUpdateFile->pucRxBlockBitmap ); /* Free any previously allocated bitmap. */
-            pxUpdateFile->pucRxBlockBitmap = NULL;
+            prvGreengrassCacheStart( pxUpdateFile );
         }
+    #endif
 
-        /* Calculate how many bytes we need in our bitmap for tracking received blocks.
-         * The below calculation requires power of 2 page sizes. */
+    if( pxUpdateFile->pucRxBlockBitmap != NULL )
+    {
+        /* A file fetched over HTTP has no data stream to subscribe to, unless the stream is
+         * there to fall back to from the Greengrass core cache. */
+        if( ( ( prvUsesHTTPDataPlane( pxUpdateFile ) == true ) && ( pxUpdateFile->xFromGreengrassCache == false ) ) ||
+            ( ( BaseType_t ) ( prvSubscribeToDataStream( pxUpdateFile ) ) == pdTRUE ) )
+        {
+            /* Set all bits in the bitmap to the erased state (we use 1 for erased just like flash memory). */
+            memset( pxUpdateFile->pucRxBlockBitmap, ( int ) OTA_ERASED_BLOCKS_VAL, ulBitmapLen );
 
-        ulNumBlocks = ( pxUpdateFile->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
-        ulBitmapLen = ( ulNumBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
-        pxUpdateFile->pucRxBlockBitmap = ( uint8_t * ) pvPortMalloc( ulBitmapLen ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+            /* Mark as used any pages in the bitmap that are out of range, based on the file size.
+             * This keeps us from requesting those pages during retry processing or if using a windowed
+             * block request. It also avoids erroneously accepting an out of range data block should it
+             * get past any safety checks.
+             * Files aren't always a multiple of 8 pages (8 bits/pages per byte) so some bits of the
+             * last byte may be out of range and those are the bits we want to clear. A bitmap that
+             * does not reach the end of the file yet has no out of range bits. */
 
-        if( pxUpdateFile->pucRxBlockBitmap != NULL )
-        {
-            if( ( BaseType_t ) ( prvSubscribeToDataStream( pxUpdateFile ) ) == pdTRUE )
+            uint8_t ucBit = 1U << ( BITS_PER_BYTE - 1U );
+            uint32_t ulNumOutOfRange = 0U;
+
+            if( ( ulBitmapLen * BITS_PER_BYTE ) > ulNumBlocks )
+            {
+                ulNumOutOfRange = ( ulBitmapLen * BITS_PER_BYTE ) - ulNumBlocks;
+            }
+
+            for( ulIndex = 0U; ulIndex < ulNumOutOfRange; ulIndex++ )
             {
-                /* Set all bits in the bitmap to the erased state (we use 1 for erased just like flash memory). */
-                memset( pxUpdateFile->pucRxBlockBitmap, ( int ) OTA_ERASED_BLOCKS_VAL, ulBitmapLen );
+                pxUpdateFile->pucRxBlockBitmap[ ulBitmapLen - 1U ] &= ~ucBit;
+                ucBit >>= 1U;
+            }
 
-                /* Mark as used any pages in the bitmap that are out of range, based on the file size.
-                 * This keeps us from requesting those pages during retry processing or if using a windowed
-                 * block request. It also avoids erroneously accepting an out of range data block should it
-                 * get past any safety checks.
-                 * Files aren't always a multiple of 8 pages (8 bits/pages per byte) so some bits of the
-                 * last byte may be out of range and those are the bits we want to clear. */
+            pxUpdateFile->ulBlocksRemaining = ulNumBlocks; /* Initialize our blocks remaining counter. */
 
-                uint8_t ucBit = 1U << ( BITS_PER_BYTE - 1U );
-                uint32_t ulNumOutOfRange = ( ulBitmapLen * BITS_PER_BYTE ) - ulNumBlocks;
+            #if ( otaconfigMAX_BLOCKS_IN_FLIGHT > 0U )
+                prvRequestWindowReset();
+            #endif
 
-                for( ulIndex = 0U; ulIndex < ulNumOutOfRange; ulIndex++ )
-                {
-                    pxUpdateFile->pucRxBlockBitmap[ ulBitmapLen - 1U ] &= ~ucBit;
-                    ucBit >>= 1U;
-                }
+            #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                prvTransferStatsReset();
+            #endif
 
-                pxUpdateFile->ulBlocksRemaining = ulNumBlocks; /* Initialize our blocks remaining counter. */
-                prvStartRequestTimer( pxUpdateFile );
+            prvStartRequestTimer( pxUpdateFile );
 
-                /* Create/Open the OTA file on the file system. */
-                xErr = prvPAL_CreateFileForRx( pxUpdateFile );
+            xErr = prvDecodeStart( pxUpdateFile );
 
-                if( xErr != kOTA_Err_None )
+            if( xErr == kOTA_Err_None )
+            {
+                #if ( otaconfigENABLE_RESUME == 1 )
+                    /* Continue where an interrupted transfer of the same file stopped, if any. */
+                    if( prvCheckpointResume( pxUpdateFile ) != kOTA_Err_None )
+                #endif
                 {
-                    ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted, xErr );
-                    ( void ) prvOTA_Close( pxUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
-                    pxUpdateFile = NULL;
+                    /* Create/Open the OTA file on the file system. */
+                    xErr = prvPAL_CreateFileForRx( pxUpdateFile );
                 }
             }
-            else
+
+            if( xErr != kOTA_Err_None )
             {
-                /* Can't receive the image without a subscription. */
-                ( void ) prvOTA_Close( pxUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
+                ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted, xErr );
+                ( void ) prvOTA_CloseJob( pxUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
                 pxUpdateFile = NULL;
             }
+
+            #if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+                else if( pxUpdateFile->ulBlocksRemaining == ulNumBlocks )
+                {
+                    /* Hash the file as it arrives. Without a context the PAL checks the whole file on close,
+                     * as it does for a resumed file, whose first blocks were received before. */
+                    pxUpdateFile->ulHashedBlocks = 0U;
+
+                    if( CRYPTO_SignatureVerificationStart( &pxUpdateFile->pvSigVerifyContext,
+                                                           cryptoASYMMETRIC_ALGORITHM_ECDSA,
+                                                           cryptoHASH_ALGORITHM_SHA256 ) == pdFALSE )
+                    {
+                        pxUpdateFile->pvSigVerifyContext = NULL;
+                    }
+                }
+            #endif
         }
         else
         {
-            /* Can't receive the image without enough memory. */
-            ( void ) prvOTA_Close( pxUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
+            /* Can't receive the image without a subscription. */
+            ( void ) prvOTA_CloseJob( pxUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
             pxUpdateFile = NULL;
         }
     }
+    else
+    {
+        /* Can't receive the image without enough memory. */
+        ( void ) prvOTA_CloseJob( pxUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
+        pxUpdateFile = NULL;
+    }
 
     return pxUpdateFile; /* Return the OTA file context. */
 }
 
 
 
-/* prvIngestDataBlock
+#if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+
+/* Check whether a block has been written to the receive file. Blocks before the block bitmap
+ * have all been received and blocks past it not yet. */
+
+    static bool_t prvStreamSignatureBlockReceived( const OTA_FileContext_t * C,
+                                                   uint32_t ulBlockIndex,
+                                                   uint32_t ulNumBlocks )
+    {
+        bool_t xReceived = false;
+        uint32_t ulBit;
+
+        if( ulBlockIndex < C->ulBitmapBase )
+        {
+            xReceived = true;
+        }
+        else
+        {
+            ulBit = ulBlockIndex - C->ulBitmapBase;
+
+            if( ( ulBit < ( prvGetBlockBitmapLen( ulNumBlocks ) * BITS_PER_BYTE ) ) &&
+                ( ( C->pucRxBlockBitmap[ ulBit >> LOG2_BITS_PER_BYTE ] & ( 1U << ( ulBit % BITS_PER_BYTE ) ) ) == 0U ) )
+            {
+                xReceived = true;
+            }
+        }
+
+        return xReceived;
+    }
+
+/* prvStreamSignatureUpdate
  *
- * A block of file data was received by the application via some configured communication protocol.
- * If it looks like it is in range, write it to persistent storage. If it's the last block we're
- * expecting, close the file and perform the final signature check on it. If the close and signature
- * check are OK, let the caller know so it can be used by the system. Firmware updates generally
- * reboot the system and perform a self test phase. If the close or signature check fails, abort
- * the file transfer and return the result and any available details to the caller.
+ * Extend the hash of the contiguous received prefix of the file. The block just written is hashed
+ * straight from the message payload if it is the next one in the prefix. Blocks that arrived ahead
+ * of it are already in storage, so they are read back into the payload buffer and hashed until the
+ * next missing block is reached. The payload buffer is always large enough since only the final
+ * block of the file may be short and nothing follows it.
  */
-static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
-                                          const char * pcRawMsg,
-                                          uint32_t ulMsgSize,
-                                          OTA_Err_t * pxCloseResult )
-{
-    DEFINE_OTA_METHOD_NAME( "prvIngestDataBlock" );
-
-    IngestResult_t eIngestResult = eIngest_Result_Uninitialized;
-    int32_t lFileId = 0;
-    uint32_t ulBlockSize = 0;
-    uint32_t ulBlockIndex = 0;
-    uint8_t * pucPayload = NULL;
-    size_t xPayloadSize = 0;
 
-    if( C != NULL )
+    static void prvStreamSignatureUpdate( OTA_FileContext_t * C,
+                                          uint32_t ulBlockIndex,
+                                          uint8_t * pucBlock,
+                                          uint32_t ulBlockSize )
     {
-        if( pxCloseResult != NULL )
+        DEFINE_OTA_METHOD_NAME( "prvStreamSignatureUpdate" );
+
+        uint32_t ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulSize;
+
+        /* A decoded file hashes the image it rebuilds, not the received blocks. */
+        if( ( C->pvSigVerifyContext != NULL ) && ( C->pvDeltaContext == NULL ) && ( C->pvDecompressContext == NULL ) &&
+            ( ulBlockIndex == C->ulHashedBlocks ) )
         {
-            *pxCloseResult = kOTA_Err_GenericIngestError; /* Default to a generic ingest function error until we prove success. */
+            CRYPTO_SignatureVerificationUpdate( C->pvSigVerifyContext, pucBlock, ulBlockSize );
+            C->ulHashedBlocks++;
 
-            /* If we have a block bitmap available then process the message. */
-            if( C->pucRxBlockBitmap && ( C->ulBlocksRemaining > 0U ) )
+            while( ( C->pvSigVerifyContext != NULL ) &&
+                   ( C->ulHashedBlocks < ulNumBlocks ) &&
+                   ( prvStreamSignatureBlockReceived( C, C->ulHashedBlocks, ulNumBlocks ) == true ) )
             {
-                /* Reset or start the firmware request timer. */
-                prvStartRequestTimer( C );
+                if( C->ulHashedBlocks == ( ulNumBlocks - 1U ) )
+                {
+                    ulSize = C->ulFileSize - ( C->ulHashedBlocks * OTA_FILE_BLOCK_SIZE );
+                }
+                else
+                {
+                    ulSize = OTA_FILE_BLOCK_SIZE;
+                }
 
-                /* Decode the CBOR content. */
-                if( pdFALSE == OTA_CBOR_Decode_GetStreamResponseMessage(
-                        ( const uint8_t * ) pcRawMsg,
-                        ulMsgSize,
-                        &lFileId,
-                        ( int32_t * ) &ulBlockIndex, /*lint !e9087 CBOR requires pointer to int and our block index's never exceed 31 bits. */
-                        ( int32_t * ) &ulBlockSize,  /*lint !e9087 CBOR requires pointer to int and our block sizes never exceed 31 bits. */
-                        &pucPayload,                 /* This payload gets malloc'd by OTA_CBOR_Decode_GetStreamResponseMessage(). We must free it. */
-                        ( size_t * ) &xPayloadSize ) )
+                if( ( prvWriteFlush() != 0 ) ||
+                    ( prvPAL_ReadBlock( C, C->ulHashedBlocks * OTA_FILE_BLOCK_SIZE, pucBlock, ulSize ) != ( int16_t ) ulSize ) )
                 {
-                    eIngestResult = eIngest_Result_BadData;
+                    OTA_LOG_L1( "[%s] Unable to read back block %u, deferring the hash to the PAL.\r\n", OTA_METHOD_NAME, C->ulHashedBlocks );
+                    prvStreamSignatureAbandon( C );
                 }
                 else
                 {
-                    /* Validate the block index and size. */
-                    /* If it is NOT the last block, it MUST be equal to a full block size. */
-                    /* If it IS the last block, it MUST be equal to the expected remainder. */
-                    /* If the block ID is out of range, that's an error so abort. */
-                    uint32_t ulLastBlock = ( ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE ) - 1U;
-
-                    if( ( ( ( uint32_t ) ulBlockIndex < ulLastBlock ) && ( ulBlockSize == OTA_FILE_BLOCK_SIZE ) ) ||
-                        ( ( ( uint32_t ) ulBlockIndex == ulLastBlock ) && ( ( uint32_t ) ulBlockSize == ( C->ulFileSize - ( ulLastBlock * OTA_FILE_BLOCK_SIZE ) ) ) ) )
-                    {
-                        OTA_LOG_L1( "[%s] Received file block %u, size %u\r\n", OTA_METHOD_NAME, ulBlockIndex, ulBlockSize );
+                    CRYPTO_SignatureVerificationUpdate( C->pvSigVerifyContext, pucBlock, ulSize );
+                    C->ulHashedBlocks++;
+                }
+            }
+        }
+    }
 
-                        /* Create bit mask for use in our bitmap. */
-                        uint8_t ucBitMask = 1U << ( ulBlockIndex % BITS_PER_BYTE ); /*lint !e9031 The composite expression will never be greater than BITS_PER_BYTE(8). */
-                        /* Calculate byte offset into bitmap. */
-                        uint32_t ulByte = ulBlockIndex >> LOG2_BITS_PER_BYTE;
+/* prvStreamSignatureAbandon
+ *
+ * Release the signature verification context without verifying anything. The PAL sees a NULL
+ * context when the file is closed and falls back to hashing the whole file itself.
+ */
 
-                        if( ( C->pucRxBlockBitmap[ ulByte ] & ucBitMask ) == 0U ) /* If we've already received this block... */
-                        {
-                            OTA_LOG_L1( "[%s] block %u is a DUPLICATE. %u blocks remaining.\r\n", OTA_METHOD_NAME,
-                                        ulBlockIndex,
-                                        C->ulBlocksRemaining );
-                            eIngestResult = eIngest_Result_Duplicate_Continue;
-                            *pxCloseResult = kOTA_Err_None; /* This is a success path. */
-                        }
-                        else /* Otherwise, process it normally... */
-                        {
-                            if( C->pucFile != NULL )
-                            {
-                                int32_t lBytesWritten = prvPAL_WriteBlock( C, ( ulBlockIndex * OTA_FILE_BLOCK_SIZE ), pucPayload, ( uint32_t ) ulBlockSize );
+    static void prvStreamSignatureAbandon( OTA_FileContext_t * C )
+    {
+        if( C->pvSigVerifyContext != NULL )
+        {
+            /* Calling the final step with only the context pointer just frees it. */
+            ( void ) CRYPTO_SignatureVerificationFinal( C->pvSigVerifyContext, NULL, 0, NULL, 0 );
+            C->pvSigVerifyContext = NULL;
+        }
+    }
+#endif /* if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 ) */
 
-                                if( lBytesWritten < 0 )
-                                {
-                                    OTA_LOG_L1( "[%s] Error (%d) writing file block\r\n", OTA_METHOD_NAME, lBytesWritten );
-                                    eIngestResult = eIngest_Result_WriteBlockFailed;
-                                }
-                                else
-                                {
-                                    C->pucRxBlockBitmap[ ulByte ] &= ~ucBitMask; /* Mark this block as received in our bitmap. */
-                                    C->ulBlocksRemaining--;
-                                    eIngestResult = eIngest_Result_Accepted_Continue;
-                                    *pxCloseResult = kOTA_Err_None; /* This is a success path. */
-                                }
-                            }
-                            else
-                            {
-                                OTA_LOG_L1( "[%s] Error: Unable to write block, file handle is NULL.\r\n", OTA_METHOD_NAME );
-                                eIngestResult = eIngest_Result_BadFileHandle;
-                            }
+/* prvWriteImage
+ *
+ * Without write-behind, or when the writer task could not be created, image data is written
+ * through the PAL right away. Otherwise it is copied to a staging buffer that the writer task
+ * writes while the OTA task goes on receiving. A write that fails in the writer task is
+ * reported by the next call, and by prvWriteFlush().
+ */
+static int32_t prvWriteImage( OTA_FileContext_t * C,
+                              uint32_t ulOffset,
+                              uint8_t * pucData,
+                              uint32_t ulLength )
+{
+    int32_t lBytesWritten;
+
+    #if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+        OTA_WriteBuffer_t * pxBuffer = xWriteBehind.pxFilling;
+        uint32_t ulRoom = otaconfigWRITE_BUFFER_SIZE - ( ulOffset % otaconfigWRITE_BUFFER_SIZE );
+
+        /* Only data that continues the run in the buffer being filled is added to it. */
+        if( ( pxBuffer != NULL ) &&
+            ( ( pxBuffer->pxFile != C ) ||
+              ( ( pxBuffer->ulOffset + pxBuffer->ulLength ) != ulOffset ) ||
+              ( ( pxBuffer->ulOffset / otaconfigWRITE_BUFFER_SIZE ) != ( ulOffset / otaconfigWRITE_BUFFER_SIZE ) ) ) )
+        {
+            prvWriteBehindSubmit();
+        }
+
+        if( ( xWriteBehind.xWriterTask == NULL ) || ( ulLength > ulRoom ) )
+        {
+            /* Data that does not fit in an aligned buffer is written here, after what is staged. */
+            lBytesWritten = prvWriteFlush();
+
+            if( lBytesWritten == 0 )
+            {
+                lBytesWritten = ( int32_t ) prvWriteStorage( C, ulOffset, pucData, ulLength );
+            }
+        }
+        else
+        {
+            if( xWriteBehind.pxFilling == NULL )
+            {
+                /* This waits while every buffer is being written, which throttles the download to the flash. */
+                ( void ) xQueueReceive( xWriteBehind.xFreeQueue, &xWriteBehind.pxFilling, portMAX_DELAY );
+                xWriteBehind.pxFilling->pxFile = C;
+                xWriteBehind.pxFilling->ulOffset = ulOffset;
+                xWriteBehind.pxFilling->ulLength = 0U;
+            }
+
+            pxBuffer = xWriteBehind.pxFilling;
+            memcpy( &pxBuffer->ucData[ pxBuffer->ulLength ], pucData, ulLength );
+            pxBuffer->ulLength += ulLength;
+
+            if( ulLength == ulRoom )
+            {
+                prvWriteBehindSubmit(); /* The buffer reached its aligned end. */
+            }
+
+            lBytesWritten = ( xWriteBehind.lError != 0 ) ? xWriteBehind.lError : ( int32_t ) ulLength;
+        }
+    #else /* if ( otaconfigWRITE_BUFFER_COUNT > 0U ) */
+        lBytesWritten = ( int32_t ) prvWriteStorage( C, ulOffset, pucData, ulLength );
+    #endif /* if ( otaconfigWRITE_BUFFER_COUNT > 0U ) */
+
+    return lBytesWritten;
+}
+
+/* prvWriteStorage
+ *
+ * The single place where image data reaches the PAL, so the write time covers both the OTA
+ * task and the writer task.
+ */
+static int16_t prvWriteStorage( OTA_FileContext_t * const C,
+                                uint32_t ulOffset,
+                                uint8_t * const pucData,
+                                uint32_t ulLength )
+{
+    int16_t sBytesWritten;
+
+    #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+        uint32_t ulStart = otaconfigSTATS_TIMESTAMP();
+    #endif
+
+    sBytesWritten = prvPAL_WriteBlock( C, ulOffset, pucData, ulLength );
+
+    #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+        xTransferStats.ulWriteTime += otaconfigSTATS_TIMESTAMP() - ulStart;
+    #endif
+
+    return sBytesWritten;
+}
+
+/* prvWriteFlush
+ *
+ * Hand the buffer being filled to the writer task and wait until the writer task has given
+ * every buffer back. Returns 0, or the first write error since the file was opened.
+ */
+static int32_t prvWriteFlush( void )
+{
+    int32_t lResult = 0;
+
+    #if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+        OTA_WriteBuffer_t * pxBuffers[ otaconfigWRITE_BUFFER_COUNT ];
+        uint32_t ulIndex;
+
+        if( xWriteBehind.xWriterTask != NULL )
+        {
+            prvWriteBehindSubmit();
+
+            for( ulIndex = 0U; ulIndex < otaconfigWRITE_BUFFER_COUNT; ulIndex++ )
+            {
+                ( void ) xQueueReceive( xWriteBehind.xFreeQueue, &pxBuffers[ ulIndex ], portMAX_DELAY );
+            }
+
+            for( ulIndex = 0U; ulIndex < otaconfigWRITE_BUFFER_COUNT; ulIndex++ )
+            {
+                ( void ) xQueueSendToBack( xWriteBehind.xFreeQueue, &pxBuffers[ ulIndex ], 0 );
+            }
+
+            lResult = xWriteBehind.lError;
+        }
+    #endif /* if ( otaconfigWRITE_BUFFER_COUNT > 0U ) */
+
+    return lResult;
+}
+
+#if ( otaconfigWRITE_BUFFER_COUNT > 0U )
+
+/* prvWriteBehindInit
+ *
+ * The queues and the writer task outlive an agent shutdown, so they are only created once.
+ * If the writer task can't be created, the OTA task writes the receive file itself.
+ */
+    static void prvWriteBehindInit( void )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvWriteBehindInit" );
+
+        static StaticQueue_t xStaticFullQueue;
+        static StaticQueue_t xStaticFreeQueue;
+        static OTA_WriteBuffer_t * pxFullQueueData[ otaconfigWRITE_BUFFER_COUNT ];
+        static OTA_WriteBuffer_t * pxFreeQueueData[ otaconfigWRITE_BUFFER_COUNT ];
+        OTA_WriteBuffer_t * pxBuffer;
+        uint32_t ulIndex;
+
+        if( xWriteBehind.xFullQueue == NULL )
+        {
+            xWriteBehind.xFullQueue = xQueueCreateStatic( ( UBaseType_t ) otaconfigWRITE_BUFFER_COUNT, ( UBaseType_t ) sizeof( OTA_WriteBuffer_t * ), ( uint8_t * ) pxFullQueueData, &xStaticFullQueue );
+            xWriteBehind.xFreeQueue = xQueueCreateStatic( ( UBaseType_t ) otaconfigWRITE_BUFFER_COUNT, ( UBaseType_t ) sizeof( OTA_WriteBuffer_t * ), ( uint8_t * ) pxFreeQueueData, &xStaticFreeQueue );
+            configASSERT( xWriteBehind.xFullQueue );
+            configASSERT( xWriteBehind.xFreeQueue );
+
+            for( ulIndex = 0U; ulIndex < otaconfigWRITE_BUFFER_COUNT; ulIndex++ )
+            {
+                pxBuffer = &xWriteBehind.xBuffers[ ulIndex ];
+                ( void ) xQueueSendToBack( xWriteBehind.xFreeQueue, &pxBuffer, 0 );
+            }
+
+            if( xTaskCreate( prvOTAWriterTask, "OTA Writer", otaconfigSTACK_SIZE, NULL, otaconfigAGENT_PRIORITY, &xWriteBehind.xWriterTask ) != pdPASS )
+            {
+                OTA_LOG_L1( "[%s] Writer task not created, writing file blocks on the OTA task.\r\n", OTA_METHOD_NAME );
+                xWriteBehind.xWriterTask = NULL;
+            }
+        }
+    }
+
+    static void prvWriteBehindSubmit( void )
+    {
+        if( xWriteBehind.pxFilling != NULL )
+        {
+            /* The full queue has room for every buffer, this never blocks. */
+            ( void ) xQueueSendToBack( xWriteBehind.xFullQueue, &xWriteBehind.pxFilling, portMAX_DELAY );
+            xWriteBehind.pxFilling = NULL;
+        }
+    }
+
+    static void prvOTAWriterTask( void * pvUnused )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvOTAWriterTask" );
+
+        OTA_WriteBuffer_t * pxBuffer;
+        int16_t sBytesWritten;
+
+        ( void ) pvUnused;
+
+        for( ; ; )
+        {
+            if( xQueueReceive( xWriteBehind.xFullQueue, &pxBuffer, portMAX_DELAY ) == pdTRUE )
+            {
+                sBytesWritten = prvWriteStorage( pxBuffer->pxFile, pxBuffer->ulOffset, pxBuffer->ucData, pxBuffer->ulLength );
+
+                if( ( sBytesWritten != ( int16_t ) pxBuffer->ulLength ) && ( xWriteBehind.lError == 0 ) )
+                {
+                    OTA_LOG_L1( "[%s] Error (%d) writing %u bytes at offset %u\r\n", OTA_METHOD_NAME, sBytesWritten, pxBuffer->ulLength, pxBuffer->ulOffset );
+                    xWriteBehind.lError = ( sBytesWritten < 0 ) ? ( int32_t ) sBytesWritten : -1;
+                }
+
+                ( void ) xQueueSendToBack( xWriteBehind.xFreeQueue, &pxBuffer, portMAX_DELAY );
+            }
+        }
+    }
+#endif /* if ( otaconfigWRITE_BUFFER_COUNT > 0U ) */
+
+/* prvDecodeStart
+ *
+ * A delta update file is a patch against the running image and a compressed file is
+ * decompressed as it arrives; a compressed patch is both. Allocate the state of each decoder
+ * the file needs together with its buffers, so the rebuilt image is written in full blocks.
+ * A file that needs a decoder this build does not include is rejected, since writing it as
+ * it is would only brick the update.
+ */
+static OTA_Err_t prvDecodeStart( OTA_FileContext_t * C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvDecodeStart" );
+
+    OTA_Err_t xErr = kOTA_Err_None;
+
+    if( ( C->ulFileAttributes & OTA_FILE_ATTRIB_DELTA ) != 0U )
+    {
+        #if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+            OTA_DeltaContext_t * pxDelta = ( OTA_DeltaContext_t * ) pvPortMallocWithCaps( sizeof( OTA_DeltaContext_t ) + OTA_FILE_BLOCK_SIZE, heapCAPS_BULK ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+            if( pxDelta != NULL )
+            {
+                OTA_Delta_Init( pxDelta, ( uint8_t * ) &pxDelta[ 1 ], OTA_FILE_BLOCK_SIZE, prvDeltaReadSource, prvDecodeWriteImage, C );
+                C->pvDeltaContext = pxDelta;
+                OTA_LOG_L1( "[%s] File is a delta update.\r\n", OTA_METHOD_NAME );
+            }
+            else
+            {
+                xErr = kOTA_Err_OutOfMemory;
+            }
+        #else
+            OTA_LOG_L1( "[%s] Error: Delta updates are not enabled.\r\n", OTA_METHOD_NAME );
+            xErr = kOTA_Err_DeltaUpdateFailed;
+        #endif
+    }
+
+    if( ( xErr == kOTA_Err_None ) && ( ( C->ulFileAttributes & OTA_FILE_ATTRIB_COMPRESSED ) != 0U ) )
+    {
+        #if ( otaconfigENABLE_COMPRESSED_UPDATE == 1 )
+            OTA_DecompressContext_t * pxDecompress = ( OTA_DecompressContext_t * ) pvPortMallocWithCaps( sizeof( OTA_DecompressContext_t ) + OTA_FILE_BLOCK_SIZE +
+                                                                                                         ( 1UL << otaconfigDECOMPRESS_WINDOW_BITS ), heapCAPS_BULK ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+            if( pxDecompress != NULL )
+            {
+                uint8_t * pucBuffer = ( uint8_t * ) &pxDecompress[ 1 ];
+
+                OTA_Decompress_Init( pxDecompress,
+                                     &pucBuffer[ OTA_FILE_BLOCK_SIZE ],
+                                     ( uint8_t ) otaconfigDECOMPRESS_WINDOW_BITS,
+                                     pucBuffer,
+                                     OTA_FILE_BLOCK_SIZE,
+                                     prvDecompressWriteOutput,
+                                     C );
+                C->pvDecompressContext = pxDecompress;
+                OTA_LOG_L1( "[%s] File is compressed.\r\n", OTA_METHOD_NAME );
+            }
+            else
+            {
+                xErr = kOTA_Err_OutOfMemory;
+            }
+        #else
+            OTA_LOG_L1( "[%s] Error: Compressed updates are not enabled.\r\n", OTA_METHOD_NAME );
+            xErr = kOTA_Err_DecompressFailed;
+        #endif
+    }
+
+    return xErr;
+}
+
+/* prvDecodeWriteBlock
+ *
+ * Blocks of a plain image are written as they are. Blocks of a compressed file or of a patch
+ * arrive in order and are decoded; the last one must complete the rebuilt image. On a decoding
+ * failure the close result is set to kOTA_Err_DecompressFailed or kOTA_Err_DeltaUpdateFailed
+ * with the decoder result as the sub code.
+ */
+static int32_t prvDecodeWriteBlock( OTA_FileContext_t * C,
+                                    uint32_t ulBlockIndex,
+                                    uint32_t ulLastBlock,
+                                    uint8_t * pucPayload,
+                                    uint32_t ulBlockSize,
+                                    OTA_Err_t * pxCloseResult )
+{
+    DEFINE_OTA_METHOD_NAME( "prvDecodeWriteBlock" );
+
+    int32_t lBytesWritten = ( int32_t ) ulBlockSize;
+    OTA_Err_t xErr = kOTA_Err_None;
+
+    if( C->pvDecompressContext != NULL )
+    {
+        #if ( otaconfigENABLE_COMPRESSED_UPDATE == 1 )
+            OTA_DecompressResult_t xResult = OTA_Decompress_Apply( ( OTA_DecompressContext_t * ) C->pvDecompressContext, pucPayload, ulBlockSize );
+
+            if( ( xResult == eOTA_Decompress_Continue ) && ( ulBlockIndex == ulLastBlock ) )
+            {
+                xResult = eOTA_Decompress_BadStream; /* The stream ended before the output was complete. */
+            }
+
+            if( xResult < eOTA_Decompress_Continue )
+            {
+                xErr = kOTA_Err_DecompressFailed | ( ( uint32_t ) -( ( int32_t ) xResult ) & kOTA_PAL_ErrMask );
+            }
+
+            #if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+                else if( ( xResult == eOTA_Decompress_Complete ) && ( C->pvDeltaContext != NULL ) &&
+                         ( OTA_Delta_Apply( ( OTA_DeltaContext_t * ) C->pvDeltaContext, NULL, 0U ) != eOTA_Delta_Complete ) )
+                {
+                    xErr = kOTA_Err_DeltaUpdateFailed | ( ( uint32_t ) -( ( int32_t ) eOTA_Delta_BadPatch ) & kOTA_PAL_ErrMask ); /* The patch ended before the image was complete. */
+                }
+            #endif
+        #endif /* if ( otaconfigENABLE_COMPRESSED_UPDATE == 1 ) */
+    }
+    else if( C->pvDeltaContext != NULL )
+    {
+        #if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+            OTA_DeltaResult_t xResult = OTA_Delta_Apply( ( OTA_DeltaContext_t * ) C->pvDeltaContext, pucPayload, ulBlockSize );
+
+            if( ( xResult == eOTA_Delta_Continue ) && ( ulBlockIndex == ulLastBlock ) )
+            {
+                xResult = eOTA_Delta_BadPatch; /* The patch ended before the image was complete. */
+            }
+
+            if( xResult < eOTA_Delta_Continue )
+            {
+                xErr = kOTA_Err_DeltaUpdateFailed | ( ( uint32_t ) -( ( int32_t ) xResult ) & kOTA_PAL_ErrMask );
+            }
+        #endif
+    }
+    else
+    {
+        lBytesWritten = prvWriteImage( C, ( ulBlockIndex * OTA_FILE_BLOCK_SIZE ), pucPayload, ulBlockSize );
+    }
+
+    if( xErr != kOTA_Err_None )
+    {
+        OTA_LOG_L1( "[%s] Error (0x%08x) decoding block %u\r\n", OTA_METHOD_NAME, xErr, ulBlockIndex );
+        *pxCloseResult = xErr;
+        lBytesWritten = -1;
+    }
+
+    return lBytesWritten;
+}
+
+#if ( ( otaconfigENABLE_DELTA_UPDATE == 1 ) || ( otaconfigENABLE_COMPRESSED_UPDATE == 1 ) )
+    static int32_t prvDecodeWriteImage( void * pvContext,
+                                        uint32_t ulOffset,
+                                        uint8_t * pucData,
+                                        uint32_t ulLength )
+    {
+        OTA_FileContext_t * C = ( OTA_FileContext_t * ) pvContext; /*lint !e9079 The decoders pass back the file context. */
+        int32_t lBytesWritten = prvWriteImage( C, ulOffset, pucData, ulLength );
+
+        #if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+            /* The rebuilt image is written in order, so hash it on the way out. */
+            if( ( lBytesWritten == ( int32_t ) ulLength ) && ( C->pvSigVerifyContext != NULL ) )
+            {
+                CRYPTO_SignatureVerificationUpdate( C->pvSigVerifyContext, pucData, ulLength );
+            }
+        #endif
+
+        return lBytesWritten;
+    }
+#endif
+
+#if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+    static int32_t prvDeltaReadSource( void * pvContext,
+                                       uint32_t ulOffset,
+                                       uint8_t * pucData,
+                                       uint32_t ulLength )
+    {
+        return ( int32_t ) prvPAL_ReadActiveImage( ( OTA_FileContext_t * ) pvContext, ulOffset, pucData, ulLength ); /*lint !e9079 The applier passes back the file context. */
+    }
+#endif
+
+#if ( otaconfigENABLE_COMPRESSED_UPDATE == 1 )
+    static int32_t prvDecompressWriteOutput( void * pvContext,
+                                             uint32_t ulOffset,
+                                             uint8_t * pucData,
+                                             uint32_t ulLength )
+    {
+        OTA_FileContext_t * C = ( OTA_FileContext_t * ) pvContext; /*lint !e9079 The decompressor passes back the file context. */
+        int32_t lBytesWritten = ( int32_t ) ulLength;
+
+        if( C->pvDeltaContext == NULL )
+        {
+            lBytesWritten = prvDecodeWriteImage( pvContext, ulOffset, pucData, ulLength );
+        }
+
+        #if ( otaconfigENABLE_DELTA_UPDATE == 1 )
+            /* The decompressed stream is a patch. */
+            else if( OTA_Delta_Apply( ( OTA_DeltaContext_t * ) C->pvDeltaContext, pucData, ulLength ) < eOTA_Delta_Continue )
+            {
+                lBytesWritten = -1;
+            }
+        #endif
+
+        return lBytesWritten;
+    }
+#endif
+
+/* The block bitmap covers the whole file when it fits in OTA_MAX_BLOCK_BITMAP_SIZE bytes.
+ * Larger files are tracked in two levels: every block before ulBitmapBase has been received
+ * and the bitmap tracks the next OTA_MAX_BLOCK_BITMAP_SIZE * 8 blocks in detail. */
+
+static uint32_t prvGetBlockBitmapLen( uint32_t ulNumBlocks )
+{
+    uint32_t ulBitmapLen = ( ulNumBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+
+    if( ulBitmapLen > OTA_MAX_BLOCK_BITMAP_SIZE )
+    {
+        ulBitmapLen = OTA_MAX_BLOCK_BITMAP_SIZE;
+    }
+
+    return ulBitmapLen;
+}
+
+
+/* While the first byte of the block bitmap is complete and the bitmap does not reach the end
+ * of the file yet, drop that byte and bring the next 8 blocks of the file into the bitmap.
+ * Bits of blocks past the end of the file are cleared just like when the bitmap is created. */
+
+static void prvSlideBlockBitmap( OTA_FileContext_t * C,
+                                 uint32_t ulNumBlocks )
+{
+    uint32_t ulBitmapLen = prvGetBlockBitmapLen( ulNumBlocks );
+    uint32_t ulFirstNewBlock;
+    uint8_t ucNewByte;
+
+    while( ( C->pucRxBlockBitmap[ 0 ] == 0U ) &&
+           ( ( C->ulBitmapBase + ( ulBitmapLen * BITS_PER_BYTE ) ) < ulNumBlocks ) )
+    {
+        ulFirstNewBlock = C->ulBitmapBase + ( ulBitmapLen * BITS_PER_BYTE );
+        ucNewByte = OTA_ERASED_BLOCKS_VAL;
+
+        if( ( ulNumBlocks - ulFirstNewBlock ) < BITS_PER_BYTE )
+        {
+            ucNewByte = ( uint8_t ) ( ( 1U << ( ulNumBlocks - ulFirstNewBlock ) ) - 1U );
+        }
+
+        memmove( &C->pucRxBlockBitmap[ 0 ], &C->pucRxBlockBitmap[ 1 ], ulBitmapLen - 1U );
+        C->pucRxBlockBitmap[ ulBitmapLen - 1U ] = ucNewByte;
+        C->ulBitmapBase += BITS_PER_BYTE;
+    }
+}
+
+
+/* prvIngestDataBlock
+ *
+ * A block of file data was received by the application via some configured communication protocol.
+ * Decode the stream message and pass its block to prvIngestFileBlock(). If it looks like it is in
+ * range, write it to persistent storage. If it's the last block we're
+ * expecting, close the file and perform the final signature check on it. If the close and signature
+ * check are OK, let the caller know so it can be used by the system. Firmware updates generally
+ * reboot the system and perform a self test phase. If the close or signature check fails, abort
+ * the file transfer and return the result and any available details to the caller.
+ */
+static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
+                                          const char * pcRawMsg,
+                                          uint32_t ulMsgSize,
+                                          OTA_Err_t * pxCloseResult )
+{
+    DEFINE_OTA_METHOD_NAME( "prvIngestDataBlock" );
+
+    IngestResult_t eIngestResult = eIngest_Result_Uninitialized;
+    int32_t lFileId = 0;
+    uint32_t ulBlockSize = 0;
+    uint32_t ulBlockIndex = 0;
+    uint8_t * pucPayload = NULL;
+    size_t xPayloadSize = 0;
+
+    if( C != NULL )
+    {
+        if( pxCloseResult != NULL )
+        {
+            *pxCloseResult = kOTA_Err_GenericIngestError; /* Default to a generic ingest function error until we prove success. */
+
+            /* If we have a block bitmap available then process the message. */
+            if( C->pucRxBlockBitmap && ( C->ulBlocksRemaining > 0U ) )
+            {
+                /* Reset or start the firmware request timer. */
+                prvStartRequestTimer( C );
+
+                #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                    uint32_t ulDecodeStart = otaconfigSTATS_TIMESTAMP();
+                #endif
+
+                /* Decode the CBOR content. */
+                #if ( otaconfigDECODE_BLOCK_IN_PLACE == 1 )
+                    const uint8_t * pucMessagePayload = NULL;
+                    BaseType_t xDecoded = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+                        ( const uint8_t * ) pcRawMsg,
+                        ulMsgSize,
+                        &lFileId,
+                        ( int32_t * ) &ulBlockIndex, /*lint !e9087 CBOR requires pointer to int and our block index's never exceed 31 bits. */
+                        ( int32_t * ) &ulBlockSize,  /*lint !e9087 CBOR requires pointer to int and our block sizes never exceed 31 bits. */
+                        &pucMessagePayload,          /* This payload points into the message, so it is not freed. */
+                        ( size_t * ) &xPayloadSize );
+                #else
+                    BaseType_t xDecoded = OTA_CBOR_Decode_GetStreamResponseMessage(
+                        ( const uint8_t * ) pcRawMsg,
+                        ulMsgSize,
+                        &lFileId,
+                        ( int32_t * ) &ulBlockIndex, /*lint !e9087 CBOR requires pointer to int and our block index's never exceed 31 bits. */
+                        ( int32_t * ) &ulBlockSize,  /*lint !e9087 CBOR requires pointer to int and our block sizes never exceed 31 bits. */
+                        &pucPayload,                 /* This payload gets malloc'd by OTA_CBOR_Decode_GetStreamResponseMessage(). We must free it. */
+                        ( size_t * ) &xPayloadSize );
+                #endif
+
+                #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                    xTransferStats.ulDecodeTime += otaconfigSTATS_TIMESTAMP() - ulDecodeStart;
+                #endif
+
+                if( pdFALSE == xDecoded )
+                {
+                    eIngestResult = eIngest_Result_BadData;
+                }
+                else if( ( uint32_t ) lFileId != C->ulServerFileID )
+                {
+                    /* A late block of another file of the job, which shares the stream. */
+                    OTA_LOG_L1( "[%s] block of file %d received while receiving file %u, ignoring it.\r\n", OTA_METHOD_NAME, lFileId, C->ulServerFileID );
+                    eIngestResult = eIngest_Result_Ignored_Continue;
+                    *pxCloseResult = kOTA_Err_None; /* A stray block is not an error of this file. */
+                }
+                else
+                {
+                    #if ( otaconfigDECODE_BLOCK_IN_PLACE == 1 )
+                        /* The write path only reads the block. */
+                        eIngestResult = prvIngestFileBlock( C, ulBlockIndex, ulBlockSize, ( uint8_t * ) pucMessagePayload, pxCloseResult ); /*lint !e9005 The block is not modified. */
+                    #else
+                        eIngestResult = prvIngestFileBlock( C, ulBlockIndex, ulBlockSize, pucPayload, pxCloseResult );
+                    #endif
+                }
+            }
+            else
+            {
+                eIngestResult = eIngest_Result_UnexpectedBlock;
+            }
+        }
+        else
+        {
+            eIngestResult = eIngest_Result_NullResultPointer;
+        }
+    }
+    else
+    {
+        eIngestResult = eIngest_Result_NullContext;
+    }
+
+    if( NULL != pucPayload )
+    {
+        vPortFree( pucPayload );
+    }
+
+    return eIngestResult;
+}
+
+
+/* prvIngestFileBlock
+ *
+ * Check the index and size of a received file block against the file and the block bitmap.
+ * A new block is written and, if it is the last one, the file is closed. The same checks
+ * apply whether the block came from a stream message or an HTTP range.
+ */
+static IngestResult_t prvIngestFileBlock( OTA_FileContext_t * C,
+                                          uint32_t ulBlockIndex,
+                                          uint32_t ulBlockSize,
+                                          uint8_t * pucPayload,
+                                          OTA_Err_t * pxCloseResult )
+{
+    DEFINE_OTA_METHOD_NAME( "prvIngestFileBlock" );
+
+    IngestResult_t eIngestResult = eIngest_Result_Uninitialized;
+
+    /* Validate the block index and size. */
+    /* If it is NOT the last block, it MUST be equal to a full block size. */
+    /* If it IS the last block, it MUST be equal to the expected remainder. */
+    /* If the block ID is out of range, that's an error so abort. */
+    uint32_t ulLastBlock = ( ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE ) - 1U;
+
+    if( ( ( ( uint32_t ) ulBlockIndex < ulLastBlock ) && ( ulBlockSize == OTA_FILE_BLOCK_SIZE ) ) ||
+        ( ( ( uint32_t ) ulBlockIndex == ulLastBlock ) && ( ( uint32_t ) ulBlockSize == ( C->ulFileSize - ( ulLastBlock * OTA_FILE_BLOCK_SIZE ) ) ) ) )
+    {
+        OTA_LOG_L1( "[%s] Received file block %u, size %u\r\n", OTA_METHOD_NAME, ulBlockIndex, ulBlockSize );
+
+        /* Create bit mask for use in our bitmap. */
+        uint8_t ucBitMask = 1U << ( ulBlockIndex % BITS_PER_BYTE ); /*lint !e9031 The composite expression will never be greater than BITS_PER_BYTE(8). */
+        /* Calculate byte offset into bitmap. The bitmap starts at a multiple of 8 blocks. */
+        uint32_t ulByte = ( ulBlockIndex - C->ulBitmapBase ) >> LOG2_BITS_PER_BYTE;
+
+        if( ( ulBlockIndex >= C->ulBitmapBase ) && ( ulByte >= prvGetBlockBitmapLen( ulLastBlock + 1U ) ) )
+        {
+            /* The bitmap has not slid far enough to track this block yet. It is requested again later. */
+            OTA_LOG_L1( "[%s] block %u is ahead of the block bitmap, ignoring it.\r\n", OTA_METHOD_NAME, ulBlockIndex );
+            eIngestResult = eIngest_Result_Ignored_Continue;
+            *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+        }
+        else if( ( ulBlockIndex < C->ulBitmapBase ) ||
+                 ( ( C->pucRxBlockBitmap[ ulByte ] & ucBitMask ) == 0U ) ) /* If we've already received this block... */
+        {
+            OTA_LOG_L1( "[%s] block %u is a DUPLICATE. %u blocks remaining.\r\n", OTA_METHOD_NAME,
+                        ulBlockIndex,
+                        C->ulBlocksRemaining );
+            eIngestResult = eIngest_Result_Duplicate_Continue;
+            *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+
+            #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                prvTransferStatsBlock( ulBlockSize, true );
+            #endif
+        }
+        else if( ( ( C->pvDeltaContext != NULL ) || ( C->pvDecompressContext != NULL ) ) &&
+                 ( ulBlockIndex != ( ( ulLastBlock + 1U ) - C->ulBlocksRemaining ) ) )
+        {
+            /* A patch or a compressed file is decoded in order. This block is requested again once the blocks before it arrived. */
+            OTA_LOG_L1( "[%s] block %u is ahead of the file being decoded, ignoring it.\r\n", OTA_METHOD_NAME, ulBlockIndex );
+            eIngestResult = eIngest_Result_Ignored_Continue;
+            *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+        }
+        else /* Otherwise, process it normally... */
+        {
+            if( C->pucFile != NULL )
+            {
+                int32_t lBytesWritten = prvDecodeWriteBlock( C, ulBlockIndex, ulLastBlock, pucPayload, ( uint32_t ) ulBlockSize, pxCloseResult );
+
+                if( lBytesWritten < 0 )
+                {
+                    OTA_LOG_L1( "[%s] Error (%d) writing file block\r\n", OTA_METHOD_NAME, lBytesWritten );
+                    eIngestResult = eIngest_Result_WriteBlockFailed;
+                }
+                else
+                {
+                    C->pucRxBlockBitmap[ ulByte ] &= ~ucBitMask; /* Mark this block as received in our bitmap. */
+                    C->ulBlocksRemaining--;
+                    prvSlideBlockBitmap( C, ulLastBlock + 1U );
+
+                    #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                        prvTransferStatsBlock( ulBlockSize, false );
+                    #endif
+
+                    #if ( otaconfigSTREAM_SIGNATURE_VERIFY == 1 )
+                        prvStreamSignatureUpdate( C, ulBlockIndex, pucPayload, ulBlockSize );
+                    #endif
+
+                    #if ( otaconfigENABLE_RESUME == 1 )
+                        if( ( C->ulBlocksRemaining > 0U ) &&
+                            ( ( ( ( ulLastBlock + 1U ) - C->ulBlocksRemaining ) % otaconfigCHECKPOINT_BLOCKS ) == 0U ) )
+                        {
+                            prvCheckpointSave( C );
+                        }
+                    #endif
+
+                    eIngestResult = eIngest_Result_Accepted_Continue;
+                    *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+                }
+            }
+            else
+            {
+                OTA_LOG_L1( "[%s] Error: Unable to write block, file handle is NULL.\r\n", OTA_METHOD_NAME );
+                eIngestResult = eIngest_Result_BadFileHandle;
+            }
 
-                            if( C->ulBlocksRemaining == 0U )
-                            {
-                                OTA_LOG_L1( "[%s] Received final expected block of file.\r\n", OTA_METHOD_NAME );
-                                prvStopRequestTimer( C );         /* Don't request any more since we're done. */
-                                vPortFree( C->pucRxBlockBitmap ); /* Free the bitmap now that we're done with the download. */
-                                C->pucRxBlockBitmap = NULL;
+            if( C->ulBlocksRemaining == 0U )
+            {
+                OTA_LOG_L1( "[%s] Received final expected block of file.\r\n", OTA_METHOD_NAME );
+                prvStopRequestTimer( C );         /* Don't request any more since we're done. */
+                vPortFree( C->pucRxBlockBitmap ); /* Free the bitmap now that we're done with the download. */
+                C->pucRxBlockBitmap = NULL;
 
-                                if( C->pucFile != NULL )
-                                {
-                                    *pxCloseResult = prvPAL_CloseFile( C );
+                if( C->pucFile != NULL )
+                {
+                    /* The file is checked as stored, so the staged blocks must be written first. */
+                    if( prvWriteFlush() != 0 )
+                    {
+                        OTA_LOG_L1( "[%s] Error: Staged file blocks could not be written.\r\n", OTA_METHOD_NAME );
+                        *pxCloseResult = kOTA_Err_FileClose;
+                    }
+                    else
+                    {
+                        #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                            uint32_t ulCloseStart = otaconfigSTATS_TIMESTAMP();
+                        #endif
 
-                                    if( *pxCloseResult == kOTA_Err_None )
-                                    {
-                                        OTA_LOG_L1( "[%s] File receive complete and signature is valid.\r\n", OTA_METHOD_NAME );
-                                        eIngestResult = eIngest_Result_FileComplete;
-                                    }
-                                    else
-                                    {
-                                        uint32_t ulCloseResult = ( uint32_t ) *pxCloseResult;
-                                        OTA_LOG_L1( "[%s] Error (%u:0x%06x) closing OTA file.\r\n",
-                                                    OTA_METHOD_NAME,
-                                                    ulCloseResult >> kOTA_MainErrShiftDownBits,
-                                                    ulCloseResult & ( uint32_t ) kOTA_PAL_ErrMask );
+                        *pxCloseResult = prvPAL_CloseFile( C );
 
-                                        if( ( ulCloseResult & kOTA_Main_ErrMask ) == kOTA_Err_SignatureCheckFailed )
-                                        {
-                                            eIngestResult = eIngest_Result_SigCheckFail;
-                                        }
-                                        else
-                                        {
-                                            eIngestResult = eIngest_Result_FileCloseFail;
-                                        }
-                                    }
+                        #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                            xTransferStats.ulVerifyTime = otaconfigSTATS_TIMESTAMP() - ulCloseStart;
+                        #endif
+                    }
 
-                                    C->pucFile = NULL; /* File is now closed so clear the file handle in the context. */
-                                }
-                                else
-                                {
-                                    OTA_LOG_L1( "[%s] Error: File handle is NULL after last block received.\r\n", OTA_METHOD_NAME );
-                                    eIngestResult = eIngest_Result_BadFileHandle;
-                                }
-                            }
-                            else
-                            {
-                                OTA_LOG_L1( "[%s] Remaining: %u\r\n", OTA_METHOD_NAME, C->ulBlocksRemaining );
-                            }
-                        }
+                    if( *pxCloseResult == kOTA_Err_None )
+                    {
+                        OTA_LOG_L1( "[%s] File receive complete and signature is valid.\r\n", OTA_METHOD_NAME );
+                        eIngestResult = eIngest_Result_FileComplete;
                     }
                     else
                     {
-                        OTA_LOG_L1( "[%s] Error! Block %u out of expected range! Size %u\r\n", OTA_METHOD_NAME, ulBlockIndex, ulBlockSize );
-                        eIngestResult = eIngest_Result_BlockOutOfRange;
+                        uint32_t ulCloseResult = ( uint32_t ) *pxCloseResult;
+                        OTA_LOG_L1( "[%s] Error (%u:0x%06x) closing OTA file.\r\n",
+                                    OTA_METHOD_NAME,
+                                    ulCloseResult >> kOTA_MainErrShiftDownBits,
+                                    ulCloseResult & ( uint32_t ) kOTA_PAL_ErrMask );
+
+                        if( ( ulCloseResult & kOTA_Main_ErrMask ) == kOTA_Err_SignatureCheckFailed )
+                        {
+                            eIngestResult = eIngest_Result_SigCheckFail;
+                        }
+                        else
+                        {
+                            eIngestResult = eIngest_Result_FileCloseFail;
+                        }
                     }
+
+                    C->pucFile = NULL; /* File is now closed so clear the file handle in the context. */
+                }
+                else
+                {
+                    OTA_LOG_L1( "[%s] Error: File handle is NULL after last block received.\r\n", OTA_METHOD_NAME );
+                    eIngestResult = eIngest_Result_BadFileHandle;
                 }
             }
             else
             {
-                eIngestResult = eIngest_Result_UnexpectedBlock;
+                OTA_LOG_L1( "[%s] Remaining: %u\r\n", OTA_METHOD_NAME, C->ulBlocksRemaining );
             }
         }
+    }
+    else
+    {
+        OTA_LOG_L1( "[%s] Error! Block %u out of expected range! Size %u\r\n", OTA_METHOD_NAME, ulBlockIndex, ulBlockSize );
+        eIngestResult = eIngest_Result_BlockOutOfRange;
+    }
+
+    return eIngestResult;
+}
+
+
+/* Act on the result of ingesting file blocks. A negative result stops the OTA, either because
+ * the file is complete or because of an unrecoverable error, and the file is closed. Otherwise
+ * the job status is updated with the transfer progress.
+ */
+static OTA_FileContext_t * prvProcessIngestResult( OTA_FileContext_t * C,
+                                                   IngestResult_t xResult,
+                                                   OTA_Err_t xCloseResult )
+{
+    DEFINE_OTA_METHOD_NAME( "prvProcessIngestResult" );
+
+    OTA_Err_t xErr;
+    OTA_FileContext_t * pxResult = NULL;
+    OTA_FileContext_t * pxNext = NULL;
+
+    if( xResult == eIngest_Result_FileComplete )
+    {
+        pxNext = prvGetNextJobFile( C );
+    }
+
+    if( pxNext != NULL )
+    {
+        /* This file of the job is complete and authenticated. The job goes on with the next file. */
+        OTA_LOG_L1( "[%s] File complete. Starting the next file of the job.\r\n", OTA_METHOD_NAME );
+
+        #if ( otaconfigENABLE_RESUME == 1 )
+            prvCheckpointClear();
+        #endif
+
+        ( void ) prvOTA_Close( C ); /* Ignore false result since the context is not returned. */
+        pxResult = prvStartFileRx( pxNext );
+    }
+    else if( xResult < eIngest_Result_Accepted_Continue )
+    {
+        /* Negative result codes mean we should stop the OTA process
+         * because we are either done or in an unrecoverable error state.
+         * We don't want to hang on to the resources. */
+
+        if( xResult == eIngest_Result_FileComplete )
+        {
+            /* File receive is complete and authenticated. Update the job status with the self_test ready identifier. */
+            prvUpdateJobStatus( C, eJobStatus_InProgress, ( int32_t ) eJobReason_SigCheckPassed, ( int32_t ) NULL );
+        }
         else
         {
-            eIngestResult = eIngest_Result_NullResultPointer;
+            OTA_LOG_L1( "[%s] Aborting due to IngestResult_t error %d\r\n", OTA_METHOD_NAME, ( int32_t ) xResult );
+            /* Call the platform specific code to reject the image. */
+            xErr = prvPAL_SetPlatformImageState( eOTA_ImageState_Rejected );
+
+            if( xErr != kOTA_Err_None )
+            {
+                OTA_LOG_L2( "[%s] Error trying to set platform image state (0x%08x)\r\n", OTA_METHOD_NAME, ( int32_t ) xErr );
+            }
+            else
+            {
+                /* Nothing special to do on success. */
+            }
+
+            prvUpdateJobStatus( C, eJobStatus_FailedWithVal, ( int32_t ) xCloseResult, ( int32_t ) xResult );
+        }
+
+        #if ( otaconfigENABLE_RESUME == 1 )
+            prvCheckpointClear(); /* The file is done with, whatever the result. */
+        #endif
+
+        /* Release all remaining resources of the OTA file. */
+        ( void ) prvOTA_CloseJob( C ); /* Ignore false result since the context is not returned. */
+
+        /* Let main application know of our result. */
+        xOTA_Agent.xOTAJobCompleteCallback( ( xResult == eIngest_Result_FileComplete ) ? eOTA_JobEvent_Activate : eOTA_JobEvent_Fail );
+
+        /* Free any remaining string memory holding the job name since this job is done. */
+        if( xOTA_Agent.pucOTA_Singleton_ActiveJobName != NULL )
+        {
+            vPortFree( xOTA_Agent.pucOTA_Singleton_ActiveJobName );
+            xOTA_Agent.pucOTA_Singleton_ActiveJobName = NULL;
         }
     }
     else
     {
-        eIngestResult = eIngest_Result_NullContext;
+        /* We're actively receiving a file so update the job status as needed. */
+        /* First reset the momentum counter since we received a good block. */
+        C->ulRequestMomentum = 0;
+        prvUpdateJobStatus( C, eJobStatus_InProgress, ( int32_t ) eJobReason_Receiving, ( int32_t ) NULL );
+        pxResult = C;
     }
 
-    if( NULL != pucPayload )
+    return pxResult;
+}
+
+
+/* A file is received over HTTP when the job document gave a URL for it and the data plane is enabled. */
+
+static bool_t prvUsesHTTPDataPlane( const OTA_FileContext_t * C )
+{
+    bool_t xResult = false;
+
+    #if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+        if( C->pucUpdateUrl != NULL )
+        {
+            xResult = true;
+        }
+    #else
+        ( void ) C;
+    #endif
+
+    return xResult;
+}
+
+#if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 )
+
+/* Ingest a block of an HTTP range. Returns false to stop the range once the file is done with. */
+
+    static bool prvHTTPBlockReceived( void * pvContext,
+                                      uint32_t ulOffset,
+                                      uint8_t * pucData,
+                                      uint32_t ulLength )
     {
-        vPortFree( pucPayload );
+        OTA_HTTPRange_t * pxRange = ( OTA_HTTPRange_t * ) pvContext;
+
+        pxRange->xCloseResult = kOTA_Err_GenericIngestError;
+        pxRange->xResult = prvIngestFileBlock( pxRange->pxFile,
+                                               ulOffset >> otaconfigLOG2_FILE_BLOCK_SIZE,
+                                               ulLength,
+                                               pucData,
+                                               &pxRange->xCloseResult );
+
+        if( pxRange->xResult == eIngest_Result_Accepted_Continue )
+        {
+            pxRange->ulAccepted++;
+        }
+
+        return ( pxRange->xResult >= eIngest_Result_Accepted_Continue ) ? true : false;
     }
 
-    return eIngestResult;
-}
+
+/* Fetch the first run of missing blocks, up to otaconfigHTTP_BLOCKS_PER_REQUEST of them, with
+ * one range request. The blocks go through the same bitmap and write path as stream blocks.
+ * While blocks remain, the request event is set again to fetch the next range, which lets the
+ * OTA task handle other events in between. A failed request is retried by the request timer
+ * and too many failures in a row abort the OTA, as with unanswered stream requests. */
+
+    static OTA_FileContext_t * prvRequestFileRange( OTA_FileContext_t * C )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvRequestFileRange" );
+
+        OTA_HTTPRange_t xRange;
+        OTA_HTTP_Result_t eResult;
+        OTA_FileContext_t * pxResult = C;
+        uint32_t ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulBitmapLen = prvGetBlockBitmapLen( ulNumBlocks );
+        uint32_t ulFirst = ulNumBlocks;
+        uint32_t ulCount = 0U;
+        uint32_t ulBit;
+        uint32_t ulOffset;
+        uint32_t ulLength;
+
+        /* Find the first missing block and the missing blocks that directly follow it. */
+        for( ulBit = 0U; ( ulBit < ( ulBitmapLen * BITS_PER_BYTE ) ) && ( ulCount < otaconfigHTTP_BLOCKS_PER_REQUEST ); ulBit++ )
+        {
+            if( ( C->pucRxBlockBitmap[ ulBit >> LOG2_BITS_PER_BYTE ] & ( 1U << ( ulBit % BITS_PER_BYTE ) ) ) != 0U )
+            {
+                if( ulCount == 0U )
+                {
+                    ulFirst = C->ulBitmapBase + ulBit;
+                }
+
+                ulCount++;
+            }
+            else if( ulCount > 0U )
+            {
+                break;
+            }
+            else
+            {
+                /* Still looking for the first missing block. */
+            }
+        }
+
+        if( ulCount == 0U )
+        {
+            /* The blocks the bitmap tracks are all here. It slides on as they are received, so this is not expected. */
+            OTA_LOG_L1( "[%s] No missing block to fetch.\r\n", OTA_METHOD_NAME );
+            prvStartRequestTimer( C );
+        }
+        else
+        {
+            ulOffset = ulFirst * OTA_FILE_BLOCK_SIZE;
+            ulLength = ulCount * OTA_FILE_BLOCK_SIZE;
+
+            if( ulLength > ( C->ulFileSize - ulOffset ) )
+            {
+                ulLength = C->ulFileSize - ulOffset;
+            }
+
+            /* Each range request increases the momentum until a block is received. */
+            C->ulRequestMomentum++;
+
+            xRange.pxFile = C;
+            xRange.xResult = eIngest_Result_Accepted_Continue;
+            xRange.xCloseResult = kOTA_Err_None;
+            xRange.ulAccepted = 0U;
+
+            OTA_LOG_L1( "[%s] Fetching blocks %u to %u.\r\n", OTA_METHOD_NAME, ulFirst, ulFirst + ulCount - 1U );
+
+            #if ( otaconfigENABLE_TRANSFER_STATS == 1 )
+                prvTransferStatsRequested();
+            #endif
+
+            eResult = OTA_HTTP_GetRange( &xHTTPConnection,
+                                         ( const char * ) C->pucUpdateUrl,
+                                         ulOffset,
+                                         ulLength,
+                                         OTA_FILE_BLOCK_SIZE,
+                                         prvHTTPBlockReceived,
+                                         &xRange );
+
+            if( xRange.xResult < eIngest_Result_Accepted_Continue )
+            {
+                /* The file is complete or failed. */
+                pxResult = prvProcessIngestResult( C, xRange.xResult, xRange.xCloseResult );
+            }
+            else
+            {
+                if( xRange.ulAccepted > 0U )
+                {
+                    ( void ) prvProcessIngestResult( C, eIngest_Result_Accepted_Continue, kOTA_Err_None );
+                }
+
+                if( eResult != eOTA_HTTP_Success )
+                {
+                    OTA_LOG_L1( "[%s] Range request failed (%d).\r\n", OTA_METHOD_NAME, ( int32_t ) eResult );
+                }
+
+                #if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
+                    if( ( C->xFromGreengrassCache == true ) &&
+                        ( ( eResult == eOTA_HTTP_BadResponse ) || ( C->ulRequestMomentum >= OTA_MAX_STREAM_REQUEST_MOMENTUM ) ) )
+                    {
+                        /* The core does not have the file or cannot be reached. The bitmap keeps the
+                         * blocks it gave, and the stream sends the others. */
+                        OTA_LOG_L1( "[%s] Greengrass core cache failed, receiving the rest from the data stream.\r\n", OTA_METHOD_NAME );
+                        prvGreengrassCacheStop( C );
+                        GGD_DiscoveryCacheInvalidate();
+                        C->ulRequestMomentum = 0;
+                        ( void ) xEventGroupSetBits( xOTA_Agent.xOTA_EventFlags, OTA_EVT_MASK_REQ_TIMEOUT );
+                    }
+                    else
+                #endif
+
+                if( C->ulRequestMomentum >= OTA_MAX_STREAM_REQUEST_MOMENTUM )
+                {
+                    /* Too many range requests failed in a row. Abort. Store attempt count in low bits. */
+                    ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted,
+                                                         ( uint32_t ) kOTA_Err_MomentumAbort | ( OTA_MAX_STREAM_REQUEST_MOMENTUM & ( uint32_t ) kOTA_PAL_ErrMask ) );
+                    ( void ) prvOTA_CloseJob( C ); /* Ignore false result since the context is not returned. */
+                    pxResult = NULL;
+                }
+                else if( eResult == eOTA_HTTP_Success )
+                {
+                    /* Go on with the next range right away. */
+                    ( void ) xEventGroupSetBits( xOTA_Agent.xOTA_EventFlags, OTA_EVT_MASK_REQ_TIMEOUT );
+                }
+                else
+                {
+                    /* Retry when the request timer expires. */
+                    prvStartRequestTimer( C );
+                }
+            }
+        }
+
+        return pxResult;
+    }
+#endif /* if ( otaconfigENABLE_HTTP_DATA_PLANE == 1 ) */
+
+#if ( otaconfigENABLE_GREENGRASS_CACHE == 1 )
+
+/* prvGreengrassCacheStart
+ *
+ * Only a file that would be received over the data stream is fetched from the core, so the
+ * stream is there to fall back to. The URL names the stream and file, which identify the
+ * image the same way for every device of the job. Without a core, the file is received over
+ * the data stream as usual.
+ */
+
+    static void prvGreengrassCacheStart( OTA_FileContext_t * C )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvGreengrassCacheStart" );
+
+        GGD_HostAddressData_t xHostAddressData;
+        char * pcUrl = NULL;
+        uint32_t ulUrlSize = 0U;
+
+        if( ( C->pucUpdateUrl == NULL ) && ( C->pucStreamName != NULL ) && ( pcGreengrassDiscovery == NULL ) )
+        {
+            pcGreengrassDiscovery = ( char * ) pvPortMalloc( otaconfigGREENGRASS_DISCOVERY_BUFFER_SIZE ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+            if( pcGreengrassDiscovery == NULL )
+            {
+                OTA_LOG_L1( "[%s] No memory for the Greengrass discovery.\r\n", OTA_METHOD_NAME );
+            }
+            else if( GGD_GetGGCIPandCertificate( pcGreengrassDiscovery,
+                                                 otaconfigGREENGRASS_DISCOVERY_BUFFER_SIZE,
+                                                 &xHostAddressData ) == pdPASS )
+            {
+                /* "https://" host ":" port "/" path "/" stream "/" file ID, and the terminator. */
+                ulUrlSize = ( uint32_t ) ( sizeof( "https://:65535///4294967295" ) +
+                                           strlen( xHostAddressData.pcHostAddress ) +
+                                           strlen( otaconfigGREENGRASS_CACHE_PATH ) +
+                                           strlen( ( const char * ) C->pucStreamName ) );
+                pcUrl = ( char * ) pvPortMalloc( ulUrlSize ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+            }
+            else
+            {
+                OTA_LOG_L1( "[%s] No Greengrass core found.\r\n", OTA_METHOD_NAME );
+            }
+
+            if( pcUrl != NULL )
+            {
+                /*lint -e586 Intentionally using snprintf. */
+                ( void ) snprintf( pcUrl,
+                                   ulUrlSize,
+                                   "https://%s:%u/%s/%s/%u",
+                                   xHostAddressData.pcHostAddress,
+                                   ( uint32_t ) otaconfigGREENGRASS_CACHE_PORT,
+                                   otaconfigGREENGRASS_CACHE_PATH,
+                                   ( const char * ) C->pucStreamName,
+                                   C->ulServerFileID );
+                C->pucUpdateUrl = ( uint8_t * ) pcUrl;
+                C->xFromGreengrassCache = true;
+                xHTTPConnection.pcCertificate = xHostAddressData.pcCertificate;
+                OTA_LOG_L1( "[%s] Fetching the file from %s.\r\n", OTA_METHOD_NAME, pcUrl );
+            }
+            else if( pcGreengrassDiscovery != NULL )
+            {
+                vPortFree( pcGreengrassDiscovery );
+                pcGreengrassDiscovery = NULL;
+            }
+            else
+            {
+                /* The file is received over the data stream. */
+            }
+        }
+    }
+
+
+    static void prvGreengrassCacheStop( OTA_FileContext_t * C )
+    {
+        if( C->xFromGreengrassCache == true )
+        {
+            OTA_HTTP_Disconnect( &xHTTPConnection );
+            xHTTPConnection.pcCertificate = otaconfigHTTP_SERVER_CERTIFICATE;
+
+            vPortFree( C->pucUpdateUrl );
+            C->pucUpdateUrl = NULL;
+            C->xFromGreengrassCache = false;
+
+            vPortFree( pcGreengrassDiscovery );
+            pcGreengrassDiscovery = NULL;
+        }
+    }
+#endif /* if ( otaconfigENABLE_GREENGRASS_CACHE == 1 ) */
+
+#if ( otaconfigENABLE_RESUME == 1 )
+
+/* FNV-1a hash of the fields of a checkpoint that follow its checksum. */
+
+    static uint32_t prvCheckpointChecksum( const OTA_Checkpoint_t * pxCheckpoint )
+    {
+        const uint8_t * pucByte = ( const uint8_t * ) &pxCheckpoint->ulServerFileID;
+        uint32_t ulLength = sizeof( OTA_Checkpoint_t ) - ( uint32_t ) ( pucByte - ( const uint8_t * ) pxCheckpoint );
+        uint32_t ulHash = 2166136261UL;
+        uint32_t ulIndex;
+
+        for( ulIndex = 0U; ulIndex < ulLength; ulIndex++ )
+        {
+            ulHash = ( ulHash ^ pucByte[ ulIndex ] ) * 16777619UL;
+        }
+
+        return ulHash;
+    }
+
+
+/* prvCheckpointSave
+ *
+ * The checkpoint describes the blocks that are stored in the receive file, so the staged blocks
+ * are written first. Files that are decoded as they arrive are not checkpointed since the
+ * decoder state is not saved with them. A failure is only logged; the transfer goes on and is
+ * resumed from an older checkpoint, or from the start, after a reset.
+ */
+
+    static void prvCheckpointSave( OTA_FileContext_t * C )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvCheckpointSave" );
+
+        OTA_Checkpoint_t xCheckpoint;
+        uint32_t ulBitmapLen = prvGetBlockBitmapLen( ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE );
+        const char * pcJobName = ( const char * ) xOTA_Agent.pucOTA_Singleton_ActiveJobName;
+
+        if( ( C->pucRxBlockBitmap != NULL ) && ( C->pvDeltaContext == NULL ) && ( C->pvDecompressContext == NULL ) &&
+            ( pcJobName != NULL ) && ( strlen( pcJobName ) < OTA_CHECKPOINT_JOB_NAME_SIZE ) )
+        {
+            memset( &xCheckpoint, 0, sizeof( xCheckpoint ) );
+            xCheckpoint.ulMagic = OTA_CHECKPOINT_MAGIC;
+            xCheckpoint.ulServerFileID = C->ulServerFileID;
+            xCheckpoint.ulFileSize = C->ulFileSize;
+            xCheckpoint.ulFileAttributes = C->ulFileAttributes;
+            xCheckpoint.ulBitmapBase = C->ulBitmapBase;
+            xCheckpoint.ulBlocksRemaining = C->ulBlocksRemaining;
+            strcpy( xCheckpoint.cJobName, pcJobName ); /*lint !e586 The length was checked above. */
+            memcpy( xCheckpoint.ucBitmap, C->pucRxBlockBitmap, ulBitmapLen );
+            xCheckpoint.ulChecksum = prvCheckpointChecksum( &xCheckpoint );
+
+            if( prvWriteFlush() != 0 )
+            {
+                OTA_LOG_L1( "[%s] Staged file blocks could not be written, no checkpoint.\r\n", OTA_METHOD_NAME );
+            }
+            else if( prvPAL_SaveCheckpoint( ( const uint8_t * ) &xCheckpoint, sizeof( xCheckpoint ) ) != kOTA_Err_None )
+            {
+                OTA_LOG_L1( "[%s] Failed to save the checkpoint.\r\n", OTA_METHOD_NAME );
+            }
+            else
+            {
+                OTA_LOG_L2( "[%s] Checkpoint with %u blocks remaining.\r\n", OTA_METHOD_NAME, C->ulBlocksRemaining );
+            }
+        }
+    }
+
+
+    static void prvCheckpointClear( void )
+    {
+        ( void ) prvPAL_SaveCheckpoint( NULL, 0U );
+    }
+
+
+/* prvCheckpointResume
+ *
+ * The checkpoint is used if it is intact and was saved for the same job and file. The receive
+ * file is then reopened with the number of bytes it holds and the block bitmap and counters of
+ * the context are restored, so only the missing blocks are requested. Otherwise the context is
+ * left as it is for a new transfer and a checkpoint of another transfer is erased.
+ */
+
+    static OTA_Err_t prvCheckpointResume( OTA_FileContext_t * C )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvCheckpointResume" );
+
+        OTA_Err_t xErr = kOTA_Err_RxFileCreateFailed;
+        OTA_Checkpoint_t xCheckpoint;
+        uint32_t ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulBitmapLen = prvGetBlockBitmapLen( ulNumBlocks );
+        uint32_t ulLastBlock = ulNumBlocks - 1U;
+        uint32_t ulMissingBytes;
+        const char * pcJobName = ( const char * ) xOTA_Agent.pucOTA_Singleton_ActiveJobName;
+
+        if( prvPAL_LoadCheckpoint( ( uint8_t * ) &xCheckpoint, sizeof( xCheckpoint ) ) != ( int32_t ) sizeof( xCheckpoint ) )
+        {
+            /* There is no checkpoint. */
+        }
+        else if( ( xCheckpoint.ulMagic != OTA_CHECKPOINT_MAGIC ) ||
+                 ( xCheckpoint.ulChecksum != prvCheckpointChecksum( &xCheckpoint ) ) ||
+                 ( xCheckpoint.cJobName[ OTA_CHECKPOINT_JOB_NAME_SIZE - 1U ] != '\0' ) ||
+                 ( pcJobName == NULL ) ||
+                 ( strcmp( xCheckpoint.cJobName, pcJobName ) != 0 ) ||
+                 ( xCheckpoint.ulServerFileID != C->ulServerFileID ) ||
+                 ( xCheckpoint.ulFileSize != C->ulFileSize ) ||
+                 ( xCheckpoint.ulFileAttributes != C->ulFileAttributes ) ||
+                 ( C->pvDeltaContext != NULL ) ||
+                 ( C->pvDecompressContext != NULL ) ||
+                 ( xCheckpoint.ulBlocksRemaining == 0U ) ||
+                 ( xCheckpoint.ulBlocksRemaining > ulNumBlocks ) ||
+                 ( ( xCheckpoint.ulBitmapBase % BITS_PER_BYTE ) != 0U ) ||
+                 ( xCheckpoint.ulBitmapBase > ulLastBlock ) )
+        {
+            OTA_LOG_L1( "[%s] The checkpoint is not for this file. Starting over.\r\n", OTA_METHOD_NAME );
+            prvCheckpointClear();
+        }
+        else
+        {
+            /* The last block is the only one that may be short, so find out whether it is missing. */
+            ulMissingBytes = xCheckpoint.ulBlocksRemaining * OTA_FILE_BLOCK_SIZE;
+
+            if( ( ( ( ulLastBlock - xCheckpoint.ulBitmapBase ) >> LOG2_BITS_PER_BYTE ) >= ulBitmapLen ) ||
+                ( ( xCheckpoint.ucBitmap[ ( ulLastBlock - xCheckpoint.ulBitmapBase ) >> LOG2_BITS_PER_BYTE ] & ( 1U << ( ulLastBlock % BITS_PER_BYTE ) ) ) != 0U ) )
+            {
+                ulMissingBytes -= ( ulNumBlocks * OTA_FILE_BLOCK_SIZE ) - C->ulFileSize;
+            }
+
+            xErr = prvPAL_ResumeFileForRx( C, C->ulFileSize - ulMissingBytes );
+
+            if( xErr == kOTA_Err_None )
+            {
+                OTA_LOG_L1( "[%s] Resuming the transfer with %u of %u blocks remaining.\r\n", OTA_METHOD_NAME,
+                            xCheckpoint.ulBlocksRemaining,
+                            ulNumBlocks );
+                memcpy( C->pucRxBlockBitmap, xCheckpoint.ucBitmap, ulBitmapLen );
+                C->ulBitmapBase = xCheckpoint.ulBitmapBase;
+                C->ulBlocksRemaining = xCheckpoint.ulBlocksRemaining;
+            }
+            else
+            {
+                OTA_LOG_L1( "[%s] The receive file could not be reopened. Starting over.\r\n", OTA_METHOD_NAME );
+                prvCheckpointClear();
+            }
+        }
+
+        return xErr;
+    }
+#endif /* if ( otaconfigENABLE_RESUME == 1 ) */
 
 
 /* Subscribe to the OTA job notification topics. */
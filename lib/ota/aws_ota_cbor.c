@@ -49,25 +49,27 @@ typedef struct OTAMessageDecodeContext
 } OTAMessageDecodeContext_t, * OTAMessageDecodeContextPtr_t;
 
 /**
- * @brief Decode a Get Stream response message from AWS IoT OTA.
+ * @brief Decode the fields of a Get Stream response message and find its payload.
+ *
+ * @param[out] pxCborParser Parser that pxPayload refers to.
+ * @param[out] pxPayload The byte string value of the block payload.
  */
-BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageBuffer,
-                                                     size_t xMessageSize,
-                                                     int32_t * plFileId,
-                                                     int32_t * plBlockId,
-                                                     int32_t * plBlockSize,
-                                                     uint8_t ** ppucPayload,
-                                                     size_t * pxPayloadSize )
+static CborError prvDecodeGetStreamResponseFields( const uint8_t * pucMessageBuffer,
+                                                   size_t xMessageSize,
+                                                   int32_t * plFileId,
+                                                   int32_t * plBlockId,
+                                                   int32_t * plBlockSize,
+                                                   CborParser * pxCborParser,
+                                                   CborValue * pxPayload )
 {
     CborError xCborResult = CborNoError;
-    CborParser xCborParser;
     CborValue xCborValue, xCborMap;
 
     /* Initialize the parser. */
     xCborResult = cbor_parser_init( pucMessageBuffer,
                                     xMessageSize,
                                     0,
-                                    &xCborParser,
+                                    pxCborParser,
                                     &xCborMap );
 
     /* Get the outer element and confirm that it's a "map," i.e., a set of
@@ -151,17 +153,43 @@ BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageB
     {
         xCborResult = cbor_value_map_find_value( &xCborMap,
                                                  OTA_CBOR_BLOCKPAYLOAD_KEY,
-                                                 &xCborValue );
+                                                 pxPayload );
     }
 
     if( CborNoError == xCborResult )
     {
-        if( CborByteStringType != cbor_value_get_type( &xCborValue ) )
+        if( CborByteStringType != cbor_value_get_type( pxPayload ) )
         {
             xCborResult = CborErrorIllegalType;
         }
     }
 
+    return xCborResult;
+}
+
+/**
+ * @brief Decode a Get Stream response message from AWS IoT OTA.
+ */
+BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageBuffer,
+                                                     size_t xMessageSize,
+                                                     int32_t * plFileId,
+                                                     int32_t * plBlockId,
+                                                     int32_t * plBlockSize,
+                                                     uint8_t ** ppucPayload,
+                                                     size_t * pxPayloadSize )
+{
+    CborError xCborResult = CborNoError;
+    CborParser xCborParser;
+    CborValue xCborValue;
+
+    xCborResult = prvDecodeGetStreamResponseFields( pucMessageBuffer,
+                                                    xMessageSize,
+                                                    plFileId,
+                                                    plBlockId,
+                                                    plBlockSize,
+                                                    &xCborParser,
+                                                    &xCborValue );
+
     if( CborNoError == xCborResult )
     {
         xCborResult = cbor_value_calculate_string_length( &xCborValue,
@@ -189,6 +217,81 @@ BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageB
     return CborNoError == xCborResult;
 }
 
+/**
+ * @brief Decode a Get Stream response message from AWS IoT OTA without copying
+ * the payload.
+ */
+BaseType_t OTA_CBOR_Decode_GetStreamResponseMessageInPlace( const uint8_t * pucMessageBuffer,
+                                                            size_t xMessageSize,
+                                                            int32_t * plFileId,
+                                                            int32_t * plBlockId,
+                                                            int32_t * plBlockSize,
+                                                            const uint8_t ** ppucPayload,
+                                                            size_t * pxPayloadSize )
+{
+    CborError xCborResult = CborNoError;
+    CborParser xCborParser;
+    CborValue xCborValue;
+    size_t xHeadSize = 0;
+
+    xCborResult = prvDecodeGetStreamResponseFields( pucMessageBuffer,
+                                                    xMessageSize,
+                                                    plFileId,
+                                                    plBlockId,
+                                                    plBlockSize,
+                                                    &xCborParser,
+                                                    &xCborValue );
+
+    /* Only a definite length string is contiguous in the message. The service
+     * sends those; a chunked one is reported as an error. */
+    if( CborNoError == xCborResult )
+    {
+        xCborResult = cbor_value_get_string_length( &xCborValue,
+                                                    pxPayloadSize );
+    }
+
+    /* The string data follows its head, whose size is set by the additional
+     * information in the low five bits of the initial byte. */
+    if( CborNoError == xCborResult )
+    {
+        switch( *xCborValue.ptr & 0x1FU )
+        {
+            case 24:
+                xHeadSize = 2;
+                break;
+
+            case 25:
+                xHeadSize = 3;
+                break;
+
+            case 26:
+                xHeadSize = 5;
+                break;
+
+            case 27:
+                xHeadSize = 9;
+                break;
+
+            default:
+                xHeadSize = 1;
+                break;
+        }
+
+        if( ( size_t ) ( ( pucMessageBuffer + xMessageSize ) - xCborValue.ptr ) <
+            ( xHeadSize + *pxPayloadSize ) )
+        {
+            xCborResult = CborErrorUnexpectedEOF;
+        }
+    }
+
+    if( CborNoError == xCborResult )
+    {
+        *ppucPayload = xCborValue.ptr + xHeadSize;
+    }
+
+    return CborNoError == xCborResult;
+}
+
 
 
 /**
@@ -0,0 +1,295 @@
+/*
+ * Amazon FreeRTOS OTA Agent V1.0.2
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_decompress.c
+ * @brief Streaming decompressor for compressed OTA updates.
+ */
+
+#include <string.h>
+#include "aws_ota_decompress.h"
+
+/**
+ * @brief Decoder states.
+ */
+#define OTA_DECOMPRESS_STATE_HEADER     0U /*!< Collecting the stream header. */
+#define OTA_DECOMPRESS_STATE_TAG        1U /*!< Reading the bit that tells a literal from a back reference. */
+#define OTA_DECOMPRESS_STATE_LITERAL    2U /*!< Reading a literal byte. */
+#define OTA_DECOMPRESS_STATE_INDEX      3U /*!< Reading the distance of a back reference. */
+#define OTA_DECOMPRESS_STATE_COUNT      4U /*!< Reading the length of a back reference. */
+#define OTA_DECOMPRESS_STATE_BACKREF    5U /*!< Copying a back reference. */
+
+/**
+ * @brief Stream header magic.
+ */
+static const uint8_t ucDecompressMagic[ 4 ] = { 'O', 'T', 'A', 'Z' };
+
+/**
+ * @brief Take the next ucCount bits of the stream, most significant bit first.
+ *
+ * @return 1 if the bits were available, 0 if more input is needed.
+ */
+static uint8_t prvDecompressGetBits( OTA_DecompressContext_t * pxDecompress,
+                                     const uint8_t ** ppucInput,
+                                     uint32_t * pulLength,
+                                     uint8_t ucCount,
+                                     uint16_t * pusValue )
+{
+    uint8_t ucAvailable = 1U;
+
+    while( ( pxDecompress->ucBitCount < ucCount ) && ( *pulLength > 0U ) )
+    {
+        pxDecompress->ulBits = ( pxDecompress->ulBits << 8 ) | **ppucInput;
+        pxDecompress->ucBitCount += 8U;
+        ( *ppucInput )++;
+        ( *pulLength )--;
+    }
+
+    if( pxDecompress->ucBitCount < ucCount )
+    {
+        ucAvailable = 0U;
+    }
+    else
+    {
+        pxDecompress->ucBitCount -= ucCount;
+        *pusValue = ( uint16_t ) ( ( pxDecompress->ulBits >> pxDecompress->ucBitCount ) & ( ( 1UL << ucCount ) - 1UL ) );
+    }
+
+    return ucAvailable;
+}
+
+/**
+ * @brief Append a byte to the output, writing the staging buffer when it is full or the output is complete.
+ */
+static OTA_DecompressResult_t prvDecompressEmit( OTA_DecompressContext_t * pxDecompress,
+                                                 uint8_t ucByte )
+{
+    OTA_DecompressResult_t xResult = eOTA_Decompress_Continue;
+    uint32_t ulMask = ( 1UL << pxDecompress->ucWindowBits ) - 1UL;
+
+    pxDecompress->pucWindow[ pxDecompress->ulOutputOffset & ulMask ] = ucByte;
+    pxDecompress->pucBuffer[ pxDecompress->ulBuffered ] = ucByte;
+    pxDecompress->ulBuffered++;
+    pxDecompress->ulOutputOffset++;
+
+    if( ( pxDecompress->ulBuffered == pxDecompress->ulBufferSize ) ||
+        ( pxDecompress->ulOutputOffset == pxDecompress->ulOutputSize ) )
+    {
+        if( pxDecompress->xWrite( pxDecompress->pvContext,
+                                  pxDecompress->ulOutputOffset - pxDecompress->ulBuffered,
+                                  pxDecompress->pucBuffer,
+                                  pxDecompress->ulBuffered ) != ( int32_t ) pxDecompress->ulBuffered )
+        {
+            xResult = eOTA_Decompress_WriteFailed;
+        }
+
+        pxDecompress->ulBuffered = 0U;
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Parse the collected stream header.
+ */
+static OTA_DecompressResult_t prvDecompressParseHeader( OTA_DecompressContext_t * pxDecompress )
+{
+    OTA_DecompressResult_t xResult = eOTA_Decompress_Continue;
+    const uint8_t * pucHeader = pxDecompress->ucHeader;
+
+    pxDecompress->ulOutputSize = ( uint32_t ) pucHeader[ 4 ] |
+                                 ( ( uint32_t ) pucHeader[ 5 ] << 8 ) |
+                                 ( ( uint32_t ) pucHeader[ 6 ] << 16 ) |
+                                 ( ( uint32_t ) pucHeader[ 7 ] << 24 );
+    pxDecompress->ucWindowBits = pucHeader[ 8 ];
+    pxDecompress->ucLookaheadBits = pucHeader[ 9 ];
+
+    if( ( memcmp( pucHeader, ucDecompressMagic, sizeof( ucDecompressMagic ) ) != 0 ) ||
+        ( pxDecompress->ucWindowBits < OTA_DECOMPRESS_MIN_WINDOW_BITS ) ||
+        ( pxDecompress->ucWindowBits > pxDecompress->ucMaxWindowBits ) ||
+        ( pxDecompress->ucLookaheadBits < OTA_DECOMPRESS_MIN_LOOKAHEAD_BITS ) ||
+        ( pxDecompress->ucLookaheadBits >= pxDecompress->ucWindowBits ) )
+    {
+        xResult = eOTA_Decompress_BadStream;
+    }
+    else
+    {
+        pxDecompress->ucState = OTA_DECOMPRESS_STATE_TAG;
+    }
+
+    return xResult;
+}
+
+void OTA_Decompress_Init( OTA_DecompressContext_t * pxDecompress,
+                          uint8_t * pucWindow,
+                          uint8_t ucMaxWindowBits,
+                          uint8_t * pucBuffer,
+                          uint32_t ulBufferSize,
+                          OTA_DecompressWrite_t xWrite,
+                          void * pvContext )
+{
+    memset( pxDecompress, 0, sizeof( OTA_DecompressContext_t ) );
+    pxDecompress->pucWindow = pucWindow;
+    pxDecompress->ucMaxWindowBits = ucMaxWindowBits;
+    pxDecompress->pucBuffer = pucBuffer;
+    pxDecompress->ulBufferSize = ulBufferSize;
+    pxDecompress->xWrite = xWrite;
+    pxDecompress->pvContext = pvContext;
+    pxDecompress->ucState = OTA_DECOMPRESS_STATE_HEADER;
+
+    /* Back references before the start of the output read zeros, as in heatshrink. */
+    memset( pucWindow, 0, ( size_t ) 1U << ucMaxWindowBits );
+}
+
+OTA_DecompressResult_t OTA_Decompress_Apply( OTA_DecompressContext_t * pxDecompress,
+                                             const uint8_t * pucInput,
+                                             uint32_t ulLength )
+{
+    OTA_DecompressResult_t xResult = eOTA_Decompress_Continue;
+    uint8_t ucMore = 1U;
+    uint16_t usValue = 0U;
+    uint32_t ulCopy;
+
+    while( ( xResult == eOTA_Decompress_Continue ) && ( ucMore != 0U ) )
+    {
+        switch( pxDecompress->ucState )
+        {
+            case OTA_DECOMPRESS_STATE_HEADER:
+                ulCopy = OTA_DECOMPRESS_HEADER_SIZE - pxDecompress->ucHeaderLength;
+
+                if( ulCopy > ulLength )
+                {
+                    ulCopy = ulLength;
+                }
+
+                memcpy( &pxDecompress->ucHeader[ pxDecompress->ucHeaderLength ], pucInput, ulCopy );
+                pxDecompress->ucHeaderLength += ( uint8_t ) ulCopy;
+                pucInput += ulCopy;
+                ulLength -= ulCopy;
+
+                if( pxDecompress->ucHeaderLength == OTA_DECOMPRESS_HEADER_SIZE )
+                {
+                    xResult = prvDecompressParseHeader( pxDecompress );
+                }
+                else
+                {
+                    ucMore = 0U;
+                }
+
+                break;
+
+            case OTA_DECOMPRESS_STATE_TAG:
+
+                if( pxDecompress->ulOutputOffset == pxDecompress->ulOutputSize )
+                {
+                    /* Only the padding bits of the last byte may follow the output. */
+                    if( ulLength > 0U )
+                    {
+                        xResult = eOTA_Decompress_BadStream;
+                    }
+
+                    ucMore = 0U;
+                }
+                else if( prvDecompressGetBits( pxDecompress, &pucInput, &ulLength, 1U, &usValue ) == 0U )
+                {
+                    ucMore = 0U;
+                }
+                else
+                {
+                    pxDecompress->ucState = ( usValue != 0U ) ? OTA_DECOMPRESS_STATE_LITERAL : OTA_DECOMPRESS_STATE_INDEX;
+                }
+
+                break;
+
+            case OTA_DECOMPRESS_STATE_LITERAL:
+
+                if( prvDecompressGetBits( pxDecompress, &pucInput, &ulLength, 8U, &usValue ) == 0U )
+                {
+                    ucMore = 0U;
+                }
+                else
+                {
+                    xResult = prvDecompressEmit( pxDecompress, ( uint8_t ) usValue );
+                    pxDecompress->ucState = OTA_DECOMPRESS_STATE_TAG;
+                }
+
+                break;
+
+            case OTA_DECOMPRESS_STATE_INDEX:
+
+                if( prvDecompressGetBits( pxDecompress, &pucInput, &ulLength, pxDecompress->ucWindowBits, &usValue ) == 0U )
+                {
+                    ucMore = 0U;
+                }
+                else
+                {
+                    pxDecompress->usBackrefOffset = ( uint16_t ) ( usValue + 1U );
+                    pxDecompress->ucState = OTA_DECOMPRESS_STATE_COUNT;
+                }
+
+                break;
+
+            case OTA_DECOMPRESS_STATE_COUNT:
+
+                if( prvDecompressGetBits( pxDecompress, &pucInput, &ulLength, pxDecompress->ucLookaheadBits, &usValue ) == 0U )
+                {
+                    ucMore = 0U;
+                }
+                else if( ( ( uint32_t ) usValue + 1U ) > ( pxDecompress->ulOutputSize - pxDecompress->ulOutputOffset ) )
+                {
+                    xResult = eOTA_Decompress_BadStream; /* The back reference reaches past the end of the output. */
+                }
+                else
+                {
+                    pxDecompress->usBackrefCount = ( uint16_t ) ( usValue + 1U );
+                    pxDecompress->ucState = OTA_DECOMPRESS_STATE_BACKREF;
+                }
+
+                break;
+
+            default: /* OTA_DECOMPRESS_STATE_BACKREF */
+
+                while( ( xResult == eOTA_Decompress_Continue ) && ( pxDecompress->usBackrefCount > 0U ) )
+                {
+                    uint32_t ulMask = ( 1UL << pxDecompress->ucWindowBits ) - 1UL;
+
+                    pxDecompress->usBackrefCount--;
+                    xResult = prvDecompressEmit( pxDecompress,
+                                                 pxDecompress->pucWindow[ ( pxDecompress->ulOutputOffset - pxDecompress->usBackrefOffset ) & ulMask ] );
+                }
+
+                pxDecompress->ucState = OTA_DECOMPRESS_STATE_TAG;
+                break;
+        }
+    }
+
+    if( ( xResult == eOTA_Decompress_Continue ) && ( pxDecompress->ucState == OTA_DECOMPRESS_STATE_TAG ) &&
+        ( pxDecompress->ulOutputOffset == pxDecompress->ulOutputSize ) )
+    {
+        xResult = eOTA_Decompress_Complete;
+    }
+
+    return xResult;
+}
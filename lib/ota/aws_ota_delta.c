@@ -0,0 +1,294 @@
+/*
+ * Amazon FreeRTOS OTA Agent V1.0.2
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_delta.c
+ * @brief Streaming patch applier for delta OTA updates.
+ */
+
+#include <string.h>
+#include "aws_ota_delta.h"
+
+/**
+ * @brief Patch header magic.
+ */
+static const uint8_t ucDeltaMagic[ 4 ] = { 'O', 'T', 'A', 'D' };
+
+/**
+ * @brief Decode a 32 bit little endian integer.
+ */
+static uint32_t prvDeltaGetU32( const uint8_t * pucData )
+{
+    return ( uint32_t ) pucData[ 0 ] |
+           ( ( uint32_t ) pucData[ 1 ] << 8 ) |
+           ( ( uint32_t ) pucData[ 2 ] << 16 ) |
+           ( ( uint32_t ) pucData[ 3 ] << 24 );
+}
+
+/**
+ * @brief Number of bytes that make up a record of the given type, or 0 if the type is unknown.
+ */
+static uint8_t prvDeltaRecordLength( uint8_t ucOp )
+{
+    uint8_t ucLength = 0U;
+
+    if( ( ucOp == OTA_DELTA_OP_COPY ) || ( ucOp == OTA_DELTA_OP_ADD ) )
+    {
+        ucLength = 9U;
+    }
+    else if( ucOp == OTA_DELTA_OP_INSERT )
+    {
+        ucLength = 5U;
+    }
+
+    return ucLength;
+}
+
+/**
+ * @brief Write the staged target bytes.
+ */
+static OTA_DeltaResult_t prvDeltaFlush( OTA_DeltaContext_t * pxDelta )
+{
+    OTA_DeltaResult_t xResult = eOTA_Delta_Continue;
+    uint32_t ulOffset;
+
+    if( pxDelta->ulBuffered > 0U )
+    {
+        ulOffset = pxDelta->ulTargetOffset - pxDelta->ulBuffered;
+
+        if( pxDelta->xWrite( pxDelta->pvContext, ulOffset, pxDelta->pucBuffer, pxDelta->ulBuffered ) !=
+            ( int32_t ) pxDelta->ulBuffered )
+        {
+            xResult = eOTA_Delta_WriteFailed;
+        }
+
+        pxDelta->ulBuffered = 0U;
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Parse the collected header or record.
+ */
+static OTA_DeltaResult_t prvDeltaParseRecord( OTA_DeltaContext_t * pxDelta )
+{
+    OTA_DeltaResult_t xResult = eOTA_Delta_Continue;
+    uint8_t ucOp = pxDelta->ucRecord[ 0 ];
+    uint32_t ulLength;
+
+    if( pxDelta->ucHeaderDone == 0U )
+    {
+        if( memcmp( pxDelta->ucRecord, ucDeltaMagic, sizeof( ucDeltaMagic ) ) != 0 )
+        {
+            xResult = eOTA_Delta_BadPatch;
+        }
+        else
+        {
+            pxDelta->ulTargetSize = prvDeltaGetU32( &pxDelta->ucRecord[ 4 ] );
+            pxDelta->ucHeaderDone = 1U;
+        }
+    }
+    else
+    {
+        if( ucOp == OTA_DELTA_OP_INSERT )
+        {
+            ulLength = prvDeltaGetU32( &pxDelta->ucRecord[ 1 ] );
+        }
+        else
+        {
+            pxDelta->ulSourceOffset = prvDeltaGetU32( &pxDelta->ucRecord[ 1 ] );
+            ulLength = prvDeltaGetU32( &pxDelta->ucRecord[ 5 ] );
+        }
+
+        /* Records must not be empty nor reach past the end of the target. */
+        if( ( ulLength == 0U ) || ( ulLength > ( pxDelta->ulTargetSize - pxDelta->ulTargetOffset ) ) )
+        {
+            xResult = eOTA_Delta_BadPatch;
+        }
+        else
+        {
+            pxDelta->ucOp = ucOp;
+            pxDelta->ulRemaining = ulLength;
+        }
+    }
+
+    pxDelta->ucRecordLength = 0U;
+
+    return xResult;
+}
+
+/**
+ * @brief Produce target bytes for the current record, consuming patch bytes if the record carries any.
+ *
+ * @return The number of patch bytes consumed.
+ */
+static uint32_t prvDeltaProduce( OTA_DeltaContext_t * pxDelta,
+                                 const uint8_t * pucPatch,
+                                 uint32_t ulLength,
+                                 OTA_DeltaResult_t * pxResult )
+{
+    uint32_t ulChunk = pxDelta->ulBufferSize - pxDelta->ulBuffered;
+    uint32_t ulConsumed = 0U;
+    uint32_t i;
+    uint8_t * pucTarget = &pxDelta->pucBuffer[ pxDelta->ulBuffered ];
+
+    if( ulChunk > pxDelta->ulRemaining )
+    {
+        ulChunk = pxDelta->ulRemaining;
+    }
+
+    /* Add and insert records are bounded by the patch bytes at hand. */
+    if( ( pxDelta->ucOp != OTA_DELTA_OP_COPY ) && ( ulChunk > ulLength ) )
+    {
+        ulChunk = ulLength;
+    }
+
+    if( pxDelta->ucOp == OTA_DELTA_OP_INSERT )
+    {
+        memcpy( pucTarget, pucPatch, ulChunk );
+        ulConsumed = ulChunk;
+    }
+    else if( pxDelta->xRead( pxDelta->pvContext, pxDelta->ulSourceOffset, pucTarget, ulChunk ) != ( int32_t ) ulChunk )
+    {
+        *pxResult = eOTA_Delta_ReadFailed;
+        ulChunk = 0U;
+    }
+    else
+    {
+        if( pxDelta->ucOp == OTA_DELTA_OP_ADD )
+        {
+            for( i = 0U; i < ulChunk; i++ )
+            {
+                pucTarget[ i ] = ( uint8_t ) ( pucTarget[ i ] + pucPatch[ i ] );
+            }
+
+            ulConsumed = ulChunk;
+        }
+
+        pxDelta->ulSourceOffset += ulChunk;
+    }
+
+    pxDelta->ulBuffered += ulChunk;
+    pxDelta->ulTargetOffset += ulChunk;
+    pxDelta->ulRemaining -= ulChunk;
+
+    if( pxDelta->ulRemaining == 0U )
+    {
+        pxDelta->ucOp = 0U;
+    }
+
+    if( ( *pxResult == eOTA_Delta_Continue ) &&
+        ( ( pxDelta->ulBuffered == pxDelta->ulBufferSize ) || ( pxDelta->ulTargetOffset == pxDelta->ulTargetSize ) ) )
+    {
+        *pxResult = prvDeltaFlush( pxDelta );
+    }
+
+    return ulConsumed;
+}
+
+void OTA_Delta_Init( OTA_DeltaContext_t * pxDelta,
+                     uint8_t * pucBuffer,
+                     uint32_t ulBufferSize,
+                     OTA_DeltaRead_t xRead,
+                     OTA_DeltaWrite_t xWrite,
+                     void * pvContext )
+{
+    memset( pxDelta, 0, sizeof( OTA_DeltaContext_t ) );
+    pxDelta->pucBuffer = pucBuffer;
+    pxDelta->ulBufferSize = ulBufferSize;
+    pxDelta->xRead = xRead;
+    pxDelta->xWrite = xWrite;
+    pxDelta->pvContext = pvContext;
+}
+
+OTA_DeltaResult_t OTA_Delta_Apply( OTA_DeltaContext_t * pxDelta,
+                                   const uint8_t * pucPatch,
+                                   uint32_t ulLength )
+{
+    OTA_DeltaResult_t xResult = eOTA_Delta_Continue;
+    uint32_t ulConsumed;
+    uint8_t ucNeeded;
+
+    /* Copy records produce target bytes without consuming the patch, so keep
+     * going while one is pending even when the patch bytes have run out. */
+    while( ( xResult == eOTA_Delta_Continue ) && ( ( ulLength > 0U ) || ( pxDelta->ucOp == OTA_DELTA_OP_COPY ) ) )
+    {
+        if( pxDelta->ucOp != 0U )
+        {
+            ulConsumed = prvDeltaProduce( pxDelta, pucPatch, ulLength, &xResult );
+            pucPatch += ulConsumed;
+            ulLength -= ulConsumed;
+        }
+        else if( ( pxDelta->ucHeaderDone != 0U ) && ( pxDelta->ulTargetOffset == pxDelta->ulTargetSize ) )
+        {
+            /* Patch bytes past the end of the target. */
+            xResult = eOTA_Delta_BadPatch;
+        }
+        else
+        {
+            if( pxDelta->ucHeaderDone == 0U )
+            {
+                ucNeeded = ( uint8_t ) OTA_DELTA_HEADER_SIZE;
+            }
+            else
+            {
+                ucNeeded = prvDeltaRecordLength( ( pxDelta->ucRecordLength > 0U ) ? pxDelta->ucRecord[ 0 ] : *pucPatch );
+            }
+
+            if( ucNeeded == 0U )
+            {
+                xResult = eOTA_Delta_BadPatch;
+            }
+            else
+            {
+                ulConsumed = ( uint32_t ) ( ucNeeded - pxDelta->ucRecordLength );
+
+                if( ulConsumed > ulLength )
+                {
+                    ulConsumed = ulLength;
+                }
+
+                memcpy( &pxDelta->ucRecord[ pxDelta->ucRecordLength ], pucPatch, ulConsumed );
+                pxDelta->ucRecordLength += ( uint8_t ) ulConsumed;
+                pucPatch += ulConsumed;
+                ulLength -= ulConsumed;
+
+                if( pxDelta->ucRecordLength == ucNeeded )
+                {
+                    xResult = prvDeltaParseRecord( pxDelta );
+                }
+            }
+        }
+    }
+
+    if( ( xResult == eOTA_Delta_Continue ) && ( pxDelta->ucHeaderDone != 0U ) &&
+        ( pxDelta->ulTargetOffset == pxDelta->ulTargetSize ) && ( pxDelta->ucRecordLength == 0U ) )
+    {
+        xResult = eOTA_Delta_Complete;
+    }
+
+    return xResult;
+}
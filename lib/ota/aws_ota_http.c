@@ -0,0 +1,602 @@
+/*
+ * Amazon FreeRTOS OTA Agent V1.0.2
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_http.c
+ * @brief HTTP/1.1 range request client for the OTA file data plane.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aws_ota_http.h"
+
+#define OTA_HTTP_DEFAULT_PORT           80U  /*!< Port of "http://" URLs without one. */
+#define OTA_HTTP_DEFAULT_SECURE_PORT    443U /*!< Port of "https://" URLs without one. */
+#define OTA_HTTP_STATUS_OK              200U /*!< The server returned the whole file. */
+#define OTA_HTTP_STATUS_PARTIAL         206U /*!< The server returned the requested range. */
+
+static const char cHttpScheme[] = "http://";
+static const char cHttpsScheme[] = "https://";
+static const char cHeaderEnd[] = "\r\n\r\n";
+static const char cContentLengthHeader[] = "content-length:";
+static const char cConnectionHeader[] = "connection:";
+
+/**
+ * @brief Parts of a URL. pcPath points into the URL and runs to its end.
+ */
+typedef struct
+{
+    char cHost[ securesocketsMAX_DNS_NAME_LENGTH + 1 ];
+    uint16_t usPort;
+    bool xSecure;
+    const char * pcPath;
+} OTA_HTTP_URL_t;
+
+/**
+ * @brief Response headers the client acts on.
+ */
+typedef struct
+{
+    uint32_t ulStatus;
+    uint32_t ulContentLength;
+    bool xHasContentLength;
+    bool xClose;
+} OTA_HTTP_Response_t;
+
+
+/* Split an absolute URL into scheme, host, port and path. */
+
+static bool prvParseURL( const char * pcURL,
+                         OTA_HTTP_URL_t * pxURL )
+{
+    bool xResult = true;
+    const char * pcHost = pcURL;
+    size_t xHostLength = 0;
+    uint32_t ulPort = 0;
+
+    if( strncmp( pcURL, cHttpsScheme, sizeof( cHttpsScheme ) - 1U ) == 0 )
+    {
+        pxURL->xSecure = true;
+        ulPort = OTA_HTTP_DEFAULT_SECURE_PORT;
+        pcHost += sizeof( cHttpsScheme ) - 1U;
+    }
+    else if( strncmp( pcURL, cHttpScheme, sizeof( cHttpScheme ) - 1U ) == 0 )
+    {
+        pxURL->xSecure = false;
+        ulPort = OTA_HTTP_DEFAULT_PORT;
+        pcHost += sizeof( cHttpScheme ) - 1U;
+    }
+    else
+    {
+        xResult = false;
+    }
+
+    if( xResult == true )
+    {
+        xHostLength = strcspn( pcHost, ":/?" );
+        pxURL->pcPath = &pcHost[ xHostLength ];
+
+        if( ( xHostLength == 0U ) || ( xHostLength >= sizeof( pxURL->cHost ) ) )
+        {
+            xResult = false;
+        }
+        else
+        {
+            memcpy( pxURL->cHost, pcHost, xHostLength );
+            pxURL->cHost[ xHostLength ] = '\0';
+        }
+    }
+
+    if( ( xResult == true ) && ( *pxURL->pcPath == ':' ) )
+    {
+        ulPort = 0;
+        pxURL->pcPath++;
+
+        while( isdigit( ( int ) *pxURL->pcPath ) != 0 )
+        {
+            ulPort = ( ulPort * 10U ) + ( uint32_t ) ( *pxURL->pcPath - '0' );
+            pxURL->pcPath++;
+
+            if( ulPort > 0xFFFFU )
+            {
+                break;
+            }
+        }
+
+        if( ( ulPort == 0U ) || ( ulPort > 0xFFFFU ) || ( ( *pxURL->pcPath != '/' ) && ( *pxURL->pcPath != '?' ) && ( *pxURL->pcPath != '\0' ) ) )
+        {
+            xResult = false;
+        }
+    }
+
+    pxURL->usPort = ( uint16_t ) ulPort;
+
+    return xResult;
+}
+
+
+/* True if the host is written as an IPv4 address, so it is not sent for server name indication. */
+
+static bool prvIsIPAddress( const char * pcHost )
+{
+    return ( strspn( pcHost, "0123456789." ) == strlen( pcHost ) ) ? true : false;
+}
+
+
+/* Open a socket to the host of the URL and remember which host it is connected to. */
+
+static OTA_HTTP_Result_t prvConnect( OTA_HTTP_Connection_t * pxConnection,
+                                     const OTA_HTTP_URL_t * pxURL )
+{
+    OTA_HTTP_Result_t eResult = eOTA_HTTP_Success;
+    SocketsSockaddr_t xServerAddress;
+
+    pxConnection->xSocket = SOCKETS_Socket( SOCKETS_AF_INET, SOCKETS_SOCK_STREAM, SOCKETS_IPPROTO_TCP );
+
+    if( pxConnection->xSocket == SOCKETS_INVALID_SOCKET )
+    {
+        eResult = eOTA_HTTP_ConnectFailed;
+    }
+    else
+    {
+        xServerAddress.ucLength = sizeof( SocketsSockaddr_t );
+        xServerAddress.ucSocketDomain = SOCKETS_AF_INET;
+        xServerAddress.usPort = SOCKETS_htons( pxURL->usPort );
+        xServerAddress.ulAddress = SOCKETS_GetHostByName( pxURL->cHost );
+
+        ( void ) SOCKETS_SetSockOpt( pxConnection->xSocket, 0, SOCKETS_SO_SNDTIMEO, &pxConnection->xTimeout, sizeof( pxConnection->xTimeout ) );
+        ( void ) SOCKETS_SetSockOpt( pxConnection->xSocket, 0, SOCKETS_SO_RCVTIMEO, &pxConnection->xTimeout, sizeof( pxConnection->xTimeout ) );
+
+        if( xServerAddress.ulAddress == 0U )
+        {
+            eResult = eOTA_HTTP_ConnectFailed;
+        }
+        else if( pxURL->xSecure == true )
+        {
+            if( SOCKETS_SetSockOpt( pxConnection->xSocket, 0, SOCKETS_SO_REQUIRE_TLS, NULL, ( size_t ) 0 ) != SOCKETS_ERROR_NONE )
+            {
+                eResult = eOTA_HTTP_ConnectFailed;
+            }
+            else if( ( pxConnection->pcCertificate != NULL ) &&
+                     ( SOCKETS_SetSockOpt( pxConnection->xSocket,
+                                           0,
+                                           SOCKETS_SO_TRUSTED_SERVER_CERTIFICATE,
+                                           pxConnection->pcCertificate,
+                                           strlen( pxConnection->pcCertificate ) + 1U ) != SOCKETS_ERROR_NONE ) )
+            {
+                eResult = eOTA_HTTP_ConnectFailed;
+            }
+            else if( ( prvIsIPAddress( pxURL->cHost ) == false ) &&
+                     ( SOCKETS_SetSockOpt( pxConnection->xSocket,
+                                           0,
+                                           SOCKETS_SO_SERVER_NAME_INDICATION,
+                                           pxURL->cHost,
+                                           strlen( pxURL->cHost ) + 1U ) != SOCKETS_ERROR_NONE ) )
+            {
+                eResult = eOTA_HTTP_ConnectFailed;
+            }
+            else
+            {
+                /* The socket is ready to connect. */
+            }
+        }
+        else
+        {
+            /* A plain connection needs no more options. */
+        }
+
+        if( ( eResult == eOTA_HTTP_Success ) &&
+            ( SOCKETS_Connect( pxConnection->xSocket, &xServerAddress, ( uint32_t ) sizeof( xServerAddress ) ) != SOCKETS_ERROR_NONE ) )
+        {
+            eResult = eOTA_HTTP_ConnectFailed;
+        }
+
+        if( eResult == eOTA_HTTP_Success )
+        {
+            memcpy( pxConnection->cHost, pxURL->cHost, sizeof( pxConnection->cHost ) );
+            pxConnection->usPort = pxURL->usPort;
+            pxConnection->xSecure = pxURL->xSecure;
+        }
+        else
+        {
+            OTA_HTTP_Disconnect( pxConnection );
+        }
+    }
+
+    return eResult;
+}
+
+
+/* Send all of the data, retrying partial sends until the socket fails. */
+
+static bool prvSendAll( Socket_t xSocket,
+                        const char * pcData,
+                        size_t xLength )
+{
+    size_t xSent = 0;
+    int32_t lResult = 0;
+
+    while( ( xSent < xLength ) && ( lResult >= 0 ) )
+    {
+        lResult = SOCKETS_Send( xSocket, &pcData[ xSent ], xLength - xSent, 0U );
+
+        if( lResult > 0 )
+        {
+            xSent += ( size_t ) lResult;
+        }
+        else
+        {
+            /* Nothing could be sent within the send timeout. */
+            lResult = -1;
+        }
+    }
+
+    return ( xSent == xLength ) ? true : false;
+}
+
+
+/* Send the range request. The path of a pre-signed URL is long so it is sent from the URL itself. */
+
+static OTA_HTTP_Result_t prvSendRequest( OTA_HTTP_Connection_t * pxConnection,
+                                         const OTA_HTTP_URL_t * pxURL,
+                                         uint32_t ulOffset,
+                                         uint32_t ulLength )
+{
+    OTA_HTTP_Result_t eResult = eOTA_HTTP_Success;
+    char * pcHeaders = ( char * ) pxConnection->pucBuffer;
+    int lHeadersLength;
+
+    lHeadersLength = snprintf( pcHeaders,
+                               pxConnection->ulBufferSize,
+                               " HTTP/1.1\r\nHost: %s\r\nRange: bytes=%u-%u\r\n\r\n",
+                               pxURL->cHost,
+                               ( unsigned int ) ulOffset,
+                               ( unsigned int ) ( ulOffset + ulLength - 1U ) );
+
+    if( ( lHeadersLength <= 0 ) || ( ( uint32_t ) lHeadersLength >= pxConnection->ulBufferSize ) )
+    {
+        eResult = eOTA_HTTP_BadURL;
+    }
+    else if( ( prvSendAll( pxConnection->xSocket, "GET ", 4U ) == false ) ||
+             ( ( *pxURL->pcPath != '/' ) && ( prvSendAll( pxConnection->xSocket, "/", 1U ) == false ) ) ||
+             ( prvSendAll( pxConnection->xSocket, pxURL->pcPath, strlen( pxURL->pcPath ) ) == false ) ||
+             ( prvSendAll( pxConnection->xSocket, pcHeaders, ( size_t ) lHeadersLength ) == false ) )
+    {
+        eResult = eOTA_HTTP_SendFailed;
+    }
+    else
+    {
+        /* The request is on its way. */
+    }
+
+    return eResult;
+}
+
+
+/* True if the header line starts with the given lower case header name. */
+
+static bool prvHeaderIs( const char * pcLine,
+                         const char * pcName )
+{
+    while( ( *pcName != '\0' ) && ( tolower( ( int ) *pcLine ) == ( int ) *pcName ) )
+    {
+        pcLine++;
+        pcName++;
+    }
+
+    return ( *pcName == '\0' ) ? true : false;
+}
+
+
+/* Parse the status line and the headers the client acts on. The headers are zero terminated. */
+
+static OTA_HTTP_Result_t prvParseHeaders( char * pcHeaders,
+                                          OTA_HTTP_Response_t * pxResponse )
+{
+    OTA_HTTP_Result_t eResult = eOTA_HTTP_Success;
+    char * pcLine = pcHeaders;
+    char * pcValue;
+
+    memset( pxResponse, 0, sizeof( *pxResponse ) );
+
+    /* The status line is "HTTP/1.x <status> <reason>". */
+    if( strncmp( pcLine, "HTTP/1.", 7U ) != 0 )
+    {
+        eResult = eOTA_HTTP_BadResponse;
+    }
+    else
+    {
+        pxResponse->ulStatus = ( uint32_t ) strtoul( &pcLine[ 8 ], NULL, 10 );
+
+        /* HTTP/1.0 servers close the connection unless asked not to. */
+        pxResponse->xClose = ( pcLine[ 7 ] == '0' ) ? true : false;
+    }
+
+    while( ( eResult == eOTA_HTTP_Success ) && ( pcLine != NULL ) )
+    {
+        pcLine = strstr( pcLine, "\r\n" );
+
+        if( pcLine != NULL )
+        {
+            pcLine += 2;
+
+            if( prvHeaderIs( pcLine, cContentLengthHeader ) == true )
+            {
+                pcValue = &pcLine[ sizeof( cContentLengthHeader ) - 1U ];
+                pxResponse->ulContentLength = ( uint32_t ) strtoul( pcValue, NULL, 10 );
+                pxResponse->xHasContentLength = true;
+            }
+            else if( prvHeaderIs( pcLine, cConnectionHeader ) == true )
+            {
+                pcValue = &pcLine[ sizeof( cConnectionHeader ) - 1U ];
+                pcValue += strspn( pcValue, " \t" );
+                pxResponse->xClose = prvHeaderIs( pcValue, "close" );
+            }
+            else
+            {
+                /* Other headers are not needed. */
+            }
+        }
+    }
+
+    return eResult;
+}
+
+
+/* Receive the response headers. On success the received body bytes are moved to the start of the buffer. */
+
+static OTA_HTTP_Result_t prvRecvHeaders( OTA_HTTP_Connection_t * pxConnection,
+                                         OTA_HTTP_Response_t * pxResponse,
+                                         uint32_t * pulBodyReceived )
+{
+    OTA_HTTP_Result_t eResult = eOTA_HTTP_Success;
+    char * pcBuffer = ( char * ) pxConnection->pucBuffer;
+    char * pcEnd = NULL;
+    uint32_t ulReceived = 0;
+    uint32_t ulHeadersLength;
+    int32_t lResult;
+
+    while( ( eResult == eOTA_HTTP_Success ) && ( pcEnd == NULL ) )
+    {
+        /* Leave room for the terminator the header parser needs. */
+        if( ulReceived >= ( pxConnection->ulBufferSize - 1U ) )
+        {
+            eResult = eOTA_HTTP_BadResponse;
+        }
+        else
+        {
+            lResult = SOCKETS_Recv( pxConnection->xSocket,
+                                    &pcBuffer[ ulReceived ],
+                                    ( pxConnection->ulBufferSize - 1U ) - ulReceived,
+                                    0U );
+
+            if( lResult <= 0 )
+            {
+                eResult = eOTA_HTTP_RecvFailed;
+            }
+            else
+            {
+                ulReceived += ( uint32_t ) lResult;
+                pcBuffer[ ulReceived ] = '\0';
+                pcEnd = strstr( pcBuffer, cHeaderEnd );
+            }
+        }
+    }
+
+    if( eResult == eOTA_HTTP_Success )
+    {
+        ulHeadersLength = ( uint32_t ) ( pcEnd - pcBuffer ) + ( sizeof( cHeaderEnd ) - 1U );
+        pcEnd[ 2 ] = '\0'; /* Keep the line end of the last header for the parser. */
+        eResult = prvParseHeaders( pcBuffer, pxResponse );
+        *pulBodyReceived = ulReceived - ulHeadersLength;
+        memmove( pcBuffer, &pcBuffer[ ulHeadersLength ], *pulBodyReceived );
+    }
+
+    return eResult;
+}
+
+
+/* Receive the body and hand it out in blocks. The first ulBuffered bytes are already at the start of the buffer. */
+
+static OTA_HTTP_Result_t prvRecvBody( OTA_HTTP_Connection_t * pxConnection,
+                                      uint32_t ulOffset,
+                                      uint32_t ulLength,
+                                      uint32_t ulBuffered,
+                                      uint32_t ulBlockSize,
+                                      OTA_HTTP_Block_t xBlock,
+                                      void * pvContext )
+{
+    OTA_HTTP_Result_t eResult = eOTA_HTTP_Success;
+    uint32_t ulDelivered = 0;
+    uint32_t ulStart = 0;
+    uint32_t ulWanted;
+    int32_t lResult;
+
+    while( ( eResult == eOTA_HTTP_Success ) && ( ulDelivered < ulLength ) )
+    {
+        ulWanted = ulLength - ulDelivered;
+
+        if( ulWanted > ulBlockSize )
+        {
+            ulWanted = ulBlockSize;
+        }
+
+        if( ulBuffered >= ulWanted )
+        {
+            if( xBlock( pvContext, ulOffset + ulDelivered, &pxConnection->pucBuffer[ ulStart ], ulWanted ) == false )
+            {
+                eResult = eOTA_HTTP_Stopped;
+            }
+
+            ulDelivered += ulWanted;
+            ulStart += ulWanted;
+            ulBuffered -= ulWanted;
+        }
+        else
+        {
+            /* Move a partial block received with the headers to the start of the buffer. */
+            if( ulStart != 0U )
+            {
+                memmove( pxConnection->pucBuffer, &pxConnection->pucBuffer[ ulStart ], ulBuffered );
+                ulStart = 0;
+            }
+
+            lResult = SOCKETS_Recv( pxConnection->xSocket,
+                                    &pxConnection->pucBuffer[ ulBuffered ],
+                                    ulWanted - ulBuffered,
+                                    0U );
+
+            if( lResult <= 0 )
+            {
+                eResult = eOTA_HTTP_RecvFailed;
+            }
+            else
+            {
+                ulBuffered += ( uint32_t ) lResult;
+            }
+        }
+    }
+
+    return eResult;
+}
+
+
+void OTA_HTTP_Init( OTA_HTTP_Connection_t * pxConnection,
+                    uint8_t * pucBuffer,
+                    uint32_t ulBufferSize,
+                    const char * pcCertificate,
+                    uint32_t ulTimeoutMs )
+{
+    memset( pxConnection, 0, sizeof( *pxConnection ) );
+    pxConnection->xSocket = SOCKETS_INVALID_SOCKET;
+    pxConnection->pucBuffer = pucBuffer;
+    pxConnection->ulBufferSize = ulBufferSize;
+    pxConnection->pcCertificate = pcCertificate;
+    pxConnection->xTimeout = pdMS_TO_TICKS( ulTimeoutMs );
+}
+
+
+OTA_HTTP_Result_t OTA_HTTP_GetRange( OTA_HTTP_Connection_t * pxConnection,
+                                     const char * pcURL,
+                                     uint32_t ulOffset,
+                                     uint32_t ulLength,
+                                     uint32_t ulBlockSize,
+                                     OTA_HTTP_Block_t xBlock,
+                                     void * pvContext )
+{
+    OTA_HTTP_Result_t eResult = eOTA_HTTP_Success;
+    OTA_HTTP_URL_t xURL;
+    OTA_HTTP_Response_t xResponse;
+    uint32_t ulBodyReceived = 0;
+    bool xReused = false;
+    bool xRetry = true;
+
+    memset( &xResponse, 0, sizeof( xResponse ) );
+
+    if( ( ulLength == 0U ) || ( ulBlockSize == 0U ) || ( ulBlockSize >= pxConnection->ulBufferSize ) ||
+        ( prvParseURL( pcURL, &xURL ) == false ) )
+    {
+        eResult = eOTA_HTTP_BadURL;
+        xRetry = false;
+    }
+
+    while( xRetry == true )
+    {
+        xRetry = false;
+
+        if( ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) &&
+            ( ( strcmp( pxConnection->cHost, xURL.cHost ) != 0 ) ||
+              ( pxConnection->usPort != xURL.usPort ) ||
+              ( pxConnection->xSecure != xURL.xSecure ) ) )
+        {
+            OTA_HTTP_Disconnect( pxConnection );
+        }
+
+        if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+        {
+            xReused = true;
+        }
+        else
+        {
+            xReused = false;
+            eResult = prvConnect( pxConnection, &xURL );
+        }
+
+        if( eResult == eOTA_HTTP_Success )
+        {
+            eResult = prvSendRequest( pxConnection, &xURL, ulOffset, ulLength );
+        }
+
+        if( eResult == eOTA_HTTP_Success )
+        {
+            eResult = prvRecvHeaders( pxConnection, &xResponse, &ulBodyReceived );
+        }
+
+        /* A kept alive connection may have been closed by the server while it was idle. Try a new one once. */
+        if( ( xReused == true ) && ( ( eResult == eOTA_HTTP_SendFailed ) || ( eResult == eOTA_HTTP_RecvFailed ) ) )
+        {
+            OTA_HTTP_Disconnect( pxConnection );
+            eResult = eOTA_HTTP_Success;
+            xRetry = true;
+        }
+    }
+
+    if( eResult == eOTA_HTTP_Success )
+    {
+        /* A server that ignores the range may return the whole file if that is what was asked for. */
+        if( ( ( xResponse.ulStatus != OTA_HTTP_STATUS_PARTIAL ) &&
+              ( ( xResponse.ulStatus != OTA_HTTP_STATUS_OK ) || ( ulOffset != 0U ) ) ) ||
+            ( xResponse.xHasContentLength == false ) ||
+            ( xResponse.ulContentLength != ulLength ) ||
+            ( ulBodyReceived > ulLength ) )
+        {
+            eResult = eOTA_HTTP_BadResponse;
+        }
+        else
+        {
+            eResult = prvRecvBody( pxConnection, ulOffset, ulLength, ulBodyReceived, ulBlockSize, xBlock, pvContext );
+        }
+    }
+
+    if( ( eResult != eOTA_HTTP_Success ) || ( xResponse.xClose == true ) )
+    {
+        OTA_HTTP_Disconnect( pxConnection );
+    }
+
+    return eResult;
+}
+
+
+void OTA_HTTP_Disconnect( OTA_HTTP_Connection_t * pxConnection )
+{
+    if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+    {
+        ( void ) SOCKETS_Shutdown( pxConnection->xSocket, ( uint32_t ) SOCKETS_SHUT_RDWR );
+        ( void ) SOCKETS_Close( pxConnection->xSocket );
+        pxConnection->xSocket = SOCKETS_INVALID_SOCKET;
+    }
+}
@@ -54,6 +54,19 @@ extern "C"
  */
 esp_err_t aws_esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle);
 
+/**
+ * @brief   Continue an interrupted OTA update of the specified partition.
+ *
+ * Same as aws_esp_ota_begin() except that nothing is erased, so the data written
+ * before the interruption is kept. The rest of the partition must still be erased.
+ *
+ * @param partition Pointer to info for partition which receives the OTA update. Required.
+ * @param out_handle On success, returns a handle which should be used for subsequent esp_ota_write() and esp_ota_end() calls.
+ *
+ * @return The same as aws_esp_ota_begin(), except for the flash erase errors.
+ */
+esp_err_t aws_esp_ota_resume(const esp_partition_t* partition, esp_ota_handle_t* out_handle);
+
 /**
  * @brief   Write OTA update data to partition
  *
@@ -35,6 +35,7 @@
 #include "esp_image_format.h"
 #include "esp_ota_ops.h"
 #include "aws_esp_ota_ops.h"
+#include "nvs.h"
 #include "mbedtls/asn1.h"
 #include "mbedtls/bignum.h"
 #include "mbedtls/base64.h"
@@ -216,6 +217,114 @@ OTA_Err_t prvPAL_CreateFileForRx( OTA_FileContext_t * const C )
     return kOTA_Err_None;
 }
 
+OTA_Err_t prvPAL_ResumeFileForRx( OTA_FileContext_t * const C,
+                                  uint32_t ulBytesReceived )
+{
+    if( ( NULL == C ) || ( NULL == C->pucFilePath ) )
+    {
+        return kOTA_Err_RxFileCreateFailed;
+    }
+
+    const esp_partition_t * update_partition = aws_esp_ota_get_next_update_partition( NULL );
+
+    if( update_partition == NULL )
+    {
+        ESP_LOGE( TAG, "failed to find update partition" );
+        return kOTA_Err_RxFileCreateFailed;
+    }
+
+    esp_ota_handle_t update_handle;
+    esp_err_t err = aws_esp_ota_resume( update_partition, &update_handle );
+
+    if( err != ESP_OK )
+    {
+        ESP_LOGE( TAG, "aws_esp_ota_resume failed (%d)", err );
+        return kOTA_Err_RxFileCreateFailed;
+    }
+
+    ota_ctx.cur_ota = C;
+    ota_ctx.update_partition = update_partition;
+    ota_ctx.update_handle = update_handle;
+
+    C->pucFile = ( uint8_t * ) &ota_ctx;
+    ota_ctx.data_write_len = ulBytesReceived; /* Counts the bytes written before the interruption. */
+    ota_ctx.valid_image = false;
+
+    ESP_LOGI( TAG, "Resuming partition subtype %d after %u bytes", update_partition->subtype, ulBytesReceived );
+
+    return kOTA_Err_None;
+}
+
+/* The checkpoint is kept in the NVS partition that also holds the credentials. */
+#define OTA_CHECKPOINT_NVS_PART_NAME    "storage"
+#define OTA_CHECKPOINT_NVS_NAMESPACE    "aws_ota"
+#define OTA_CHECKPOINT_NVS_KEY          "checkpoint"
+
+OTA_Err_t prvPAL_SaveCheckpoint( const uint8_t * pucData,
+                                 uint32_t ulSize )
+{
+    nvs_handle handle;
+    esp_err_t err = nvs_open_from_partition( OTA_CHECKPOINT_NVS_PART_NAME, OTA_CHECKPOINT_NVS_NAMESPACE, NVS_READWRITE, &handle );
+
+    if( err != ESP_OK )
+    {
+        ESP_LOGE( TAG, "failed nvs open %d", err );
+        return kOTA_Err_CheckpointFailed | ( err & kOTA_PAL_ErrMask );
+    }
+
+    if( ( pucData == NULL ) || ( ulSize == 0 ) )
+    {
+        err = nvs_erase_key( handle, OTA_CHECKPOINT_NVS_KEY );
+
+        if( err == ESP_ERR_NVS_NOT_FOUND )
+        {
+            err = ESP_OK;
+        }
+    }
+    else
+    {
+        err = nvs_set_blob( handle, OTA_CHECKPOINT_NVS_KEY, pucData, ulSize );
+    }
+
+    if( err == ESP_OK )
+    {
+        err = nvs_commit( handle );
+    }
+
+    nvs_close( handle );
+
+    if( err != ESP_OK )
+    {
+        ESP_LOGE( TAG, "failed to store the checkpoint %d", err );
+        return kOTA_Err_CheckpointFailed | ( err & kOTA_PAL_ErrMask );
+    }
+
+    return kOTA_Err_None;
+}
+
+int32_t prvPAL_LoadCheckpoint( uint8_t * pucData,
+                               uint32_t ulSize )
+{
+    nvs_handle handle;
+    size_t length = ulSize;
+    esp_err_t err = nvs_open_from_partition( OTA_CHECKPOINT_NVS_PART_NAME, OTA_CHECKPOINT_NVS_NAMESPACE, NVS_READONLY, &handle );
+
+    if( err != ESP_OK )
+    {
+        return -1;
+    }
+
+    err = nvs_get_blob( handle, OTA_CHECKPOINT_NVS_KEY, pucData, &length );
+    nvs_close( handle );
+
+    if( err != ESP_OK )
+    {
+        return -1;
+    }
+
+    return ( int32_t ) length;
+}
+
 
 static CK_RV prvGetCertificateHandle( CK_FUNCTION_LIST_PTR pxFunctionList,
                                       CK_SESSION_HANDLE xSession,
@@ -387,10 +496,18 @@ OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
     u8 * pucSignerCert = 0;
     static spi_flash_mmap_memory_t ota_data_map;
     const void * buf = NULL;
+    bool xFileHashed = false;
 
+    if( C->pvSigVerifyContext != NULL )
+    {
+        /* The agent hashed the file while it was received, only the verification itself is left. */
+        pvSigVerifyContext = C->pvSigVerifyContext;
+        C->pvSigVerifyContext = NULL;
+        xFileHashed = true;
+    }
     /* Verify an ECDSA-SHA256 signature. */
-    if( CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA,
-                                           cryptoHASH_ALGORITHM_SHA256 ) == pdFALSE )
+    else if( CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA,
+                                                cryptoHASH_ALGORITHM_SHA256 ) == pdFALSE )
     {
         ESP_LOGE( TAG, "signature verification start failed" );
         return kOTA_Err_SignatureCheckFailed;
@@ -404,18 +521,21 @@ OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
         return kOTA_Err_BadSignerCert;
     }
 
-    esp_err_t ret = esp_partition_mmap( ota_ctx.update_partition, 0, ota_ctx.data_write_len,
-                                        SPI_FLASH_MMAP_DATA, &buf, &ota_data_map );
-
-    if( ret != ESP_OK )
+    if( !xFileHashed )
     {
-        ESP_LOGE( TAG, "partition mmap failed %d", ret );
-        result = kOTA_Err_SignatureCheckFailed;
-        goto end;
-    }
+        esp_err_t ret = esp_partition_mmap( ota_ctx.update_partition, 0, ota_ctx.data_write_len,
+                                            SPI_FLASH_MMAP_DATA, &buf, &ota_data_map );
 
-    CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, buf, ota_ctx.data_write_len );
-    spi_flash_munmap( ota_data_map );
+        if( ret != ESP_OK )
+        {
+            ESP_LOGE( TAG, "partition mmap failed %d", ret );
+            result = kOTA_Err_SignatureCheckFailed;
+            goto end;
+        }
+
+        CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, buf, ota_ctx.data_write_len );
+        spi_flash_munmap( ota_data_map );
+    }
 
     if( CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, ( char * ) pucSignerCert, ulSignerCertSize,
                                            C->pxSignature->ucData, C->pxSignature->usSize ) == pdFALSE )
@@ -568,6 +688,58 @@ int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C,
     return iBlockSize;
 }
 
+/* Read back a block of data previously written to the specified file. */
+int16_t prvPAL_ReadBlock( OTA_FileContext_t * const C,
+                          uint32_t iOffset,
+                          uint8_t * const pacData,
+                          uint32_t iBlockSize )
+{
+    if( _esp_ota_ctx_validate( C ) )
+    {
+        esp_err_t ret = esp_partition_read( ota_ctx.update_partition, iOffset, pacData, iBlockSize );
+
+        if( ret != ESP_OK )
+        {
+            ESP_LOGE( TAG, "Couldn't read flash at the offset %d", iOffset );
+            return -1;
+        }
+    }
+    else
+    {
+        ESP_LOGI( TAG, "Invalid OTA Context" );
+        return -1;
+    }
+
+    return iBlockSize;
+}
+
+/* Read a block of the image that is currently running, the source of a delta update. */
+int16_t prvPAL_ReadActiveImage( OTA_FileContext_t * const C,
+                                uint32_t iOffset,
+                                uint8_t * const pacData,
+                                uint32_t iBlockSize )
+{
+    const esp_partition_t * running_partition = esp_ota_get_running_partition();
+
+    if( _esp_ota_ctx_validate( C ) && ( running_partition != NULL ) )
+    {
+        esp_err_t ret = esp_partition_read( running_partition, iOffset, pacData, iBlockSize );
+
+        if( ret != ESP_OK )
+        {
+            ESP_LOGE( TAG, "Couldn't read the running image at the offset %d", iOffset );
+            return -1;
+        }
+    }
+    else
+    {
+        ESP_LOGI( TAG, "Invalid OTA Context" );
+        return -1;
+    }
+
+    return iBlockSize;
+}
+
 OTA_PAL_ImageState_t prvPAL_GetPlatformImageState()
 {
     OTA_PAL_ImageState_t eImageState = eOTA_PAL_ImageState_Unknown;
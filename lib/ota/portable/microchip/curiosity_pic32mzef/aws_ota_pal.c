@@ -293,6 +293,36 @@ OTA_Err_t prvPAL_Abort( OTA_FileContext_t * C )
     return kOTA_Err_None;
 }
 
+/* Resuming an interrupted download is not supported on this platform. The agent
+ * finds no checkpoint and receives the file from the start. */
+
+OTA_Err_t prvPAL_ResumeFileForRx( OTA_FileContext_t * const C,
+                                  uint32_t ulBytesReceived )
+{
+    ( void ) C;
+    ( void ) ulBytesReceived;
+
+    return kOTA_Err_RxFileCreateFailed;
+}
+
+OTA_Err_t prvPAL_SaveCheckpoint( const uint8_t * pucData,
+                                 uint32_t ulSize )
+{
+    ( void ) pucData;
+    ( void ) ulSize;
+
+    return kOTA_Err_CheckpointFailed;
+}
+
+int32_t prvPAL_LoadCheckpoint( uint8_t * pucData,
+                               uint32_t ulSize )
+{
+    ( void ) pucData;
+    ( void ) ulSize;
+
+    return -1;
+}
+
 /* Write a block of data to the specified file.
  * Returns the number of bytes written on success or negative error code.
  */
@@ -351,6 +381,65 @@ int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C,
     return sReturnVal;
 }
 
+/* Read back a block of data previously written to the specified file.
+ * Returns the number of bytes read on success or negative error code.
+ */
+int16_t prvPAL_ReadBlock( OTA_FileContext_t * const C,
+                          uint32_t ulOffset,
+                          uint8_t * const pucData,
+                          uint32_t ulBlockSize )
+{
+    int16_t sReturnVal = 0;
+
+    if( prvContextValidate( C ) == ( bool_t ) pdFALSE )
+    {
+        sReturnVal = MCHP_ERR_INVALID_CONTEXT;
+    }
+    else if( ( ulOffset + ulBlockSize ) > ulFlashImageMaxSize )
+    {   /* invalid address. */
+        sReturnVal = MCHP_ERR_ADDR_OUT_OF_RANGE;
+    }
+    else
+    {
+        const uint8_t * pucFlashAddr = &pcProgImageBankStart[ sizeof( BootImageHeader_t ) + ulOffset ]; /* Image descriptor is not part of the image. */
+        pucFlashAddr = ( const uint8_t * ) KVA0_TO_KVA1( pucFlashAddr );                                     /*lint !e9078 !e923 !e9027 !e9029 !e9033 !e9079 Please see the comment header block above. */
+        memcpy( pucData, pucFlashAddr, ulBlockSize );
+        sReturnVal = ( int16_t ) ulBlockSize;
+    }
+
+    return sReturnVal;
+}
+
+/**
+ * @brief Read a block of the application image in the lower flash bank, the image that is
+ * currently running and the source of a delta update.
+ */
+int16_t prvPAL_ReadActiveImage( OTA_FileContext_t * const C,
+                                uint32_t ulOffset,
+                                uint8_t * const pucData,
+                                uint32_t ulBlockSize )
+{
+    int16_t sReturnVal = 0;
+
+    if( prvContextValidate( C ) == ( bool_t ) pdFALSE )
+    {
+        sReturnVal = MCHP_ERR_INVALID_CONTEXT;
+    }
+    else if( ( ulOffset + ulBlockSize ) > ulFlashImageMaxSize )
+    {   /* invalid address. */
+        sReturnVal = MCHP_ERR_ADDR_OUT_OF_RANGE;
+    }
+    else
+    {
+        const uint8_t * pucFlashAddr = &pcFlashLowerBankStart[ sizeof( BootImageHeader_t ) + ulOffset ]; /* Image descriptor is not part of the image. */
+        pucFlashAddr = ( const uint8_t * ) KVA0_TO_KVA1( pucFlashAddr );                                      /*lint !e9078 !e923 !e9027 !e9029 !e9033 !e9079 Please see the comment header block above. */
+        memcpy( pucData, pucFlashAddr, ulBlockSize );
+        sReturnVal = ( int16_t ) ulBlockSize;
+    }
+
+    return sReturnVal;
+}
+
 /**
  * @brief Closes the specified file. This will also authenticate the file if it
  * is marked as secure.
@@ -418,10 +507,20 @@ static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
     uint32_t ulSignerCertSize;
     void * pvSigVerifyContext;
     uint8_t * pucSignerCert = NULL;
+    bool_t xFileHashed = ( bool_t ) pdFALSE;
+
+    if( C->pvSigVerifyContext != NULL )
+    {
+        /* The agent hashed the file while it was received, only the verification itself is left. */
+        pvSigVerifyContext = C->pvSigVerifyContext;
+        C->pvSigVerifyContext = NULL;
+        xFileHashed = ( bool_t ) pdTRUE;
+    }
 
     /* Verify an ECDSA-SHA256 signature. */
-    if( CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA,
-                                           cryptoHASH_ALGORITHM_SHA256 ) == pdFALSE )
+    if( ( xFileHashed == ( bool_t ) pdFALSE ) &&
+        ( CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA,
+                                             cryptoHASH_ALGORITHM_SHA256 ) == pdFALSE ) )
     {
         eResult = kOTA_Err_SignatureCheckFailed;
     }
@@ -437,10 +536,13 @@ static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
         }
         else
         {
-            const uint8_t * pucFlashAddr = &pcProgImageBankStart[ sizeof( BootImageHeader_t ) + pxCurOTADesc->ulLowImageOffset ]; /* Image descriptor is not part of the image. */
-            pucFlashAddr = ( const uint8_t * ) KVA0_TO_KVA1( pucFlashAddr );                                                      /*lint !e9078 !e923 !e9027 !e9029 !e9033 !e9079 Please see the comment header block above. */
-            CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, pucFlashAddr,
-                                                pxCurOTADesc->ulHighImageOffset - pxCurOTADesc->ulLowImageOffset );
+            if( xFileHashed == ( bool_t ) pdFALSE )
+            {
+                const uint8_t * pucFlashAddr = &pcProgImageBankStart[ sizeof( BootImageHeader_t ) + pxCurOTADesc->ulLowImageOffset ]; /* Image descriptor is not part of the image. */
+                pucFlashAddr = ( const uint8_t * ) KVA0_TO_KVA1( pucFlashAddr );                                                      /*lint !e9078 !e923 !e9027 !e9029 !e9033 !e9079 Please see the comment header block above. */
+                CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, pucFlashAddr,
+                                                    pxCurOTADesc->ulHighImageOffset - pxCurOTADesc->ulLowImageOffset );
+            }
 
             if( CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, ( char * ) pucSignerCert, ulSignerCertSize,
                                                    C->pxSignature->ucData, C->pxSignature->usSize ) == pdFALSE )
@@ -53,6 +53,9 @@ static inline BaseType_t prvContextValidate( OTA_FileContext_t * C )
 /* Size of buffer used in file operations on this platform (Windows). */
 #define OTA_PAL_WIN_BUF_SIZE ( ( size_t ) 4096UL )
 
+/* File holding the transfer checkpoint of the OTA agent, in the working directory. */
+#define OTA_PAL_CHECKPOINT_FILE "aws_ota_checkpoint.bin"
+
 /* Attempt to create a new receive file for the file chunks as they come in. */
 
 OTA_Err_t prvPAL_CreateFileForRx( OTA_FileContext_t * const C )
@@ -192,6 +195,165 @@ int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C,
     return ( int16_t ) lResult;
 }
 
+/* Read back a block of data previously written to the specified file. */
+
+int16_t prvPAL_ReadBlock( OTA_FileContext_t * const C,
+                          uint32_t ulOffset,
+                          uint8_t * const pucData,
+                          uint32_t ulBlockSize )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_ReadBlock" );
+
+    int32_t lResult = 0;
+
+    if( prvContextValidate( C ) == pdTRUE )
+    {
+        lResult = fseek( C->pxFile, ulOffset, SEEK_SET ); /*lint !e586 !e713 !e9034
+                                                            * C standard library call is being used for portability. */
+
+        if( 0 == lResult )
+        {
+            lResult = fread( pucData, 1, ulBlockSize, C->pxFile ); /*lint !e586 !e713 !e9034
+                                                                     * C standard library call is being used for portability. */
+
+            if( ferror( C->pxFile ) != 0 ) /*lint !e586
+                                            * C standard library call is being used for portability. */
+            {
+                OTA_LOG_L1( "[%s] ERROR - fread failed\r\n", OTA_METHOD_NAME );
+                /* Mask to return a negative value. */
+                lResult = OTA_PAL_INT16_NEGATIVE_MASK | errno; /*lint !e40 !e9027
+                                                                * Errno is being used in accordance with host API documentation.
+                                                                * Bitmasking is being used to preserve host API error with library status code. */
+            }
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - fseek failed\r\n", OTA_METHOD_NAME );
+            /* Mask to return a negative value. */
+            lResult = OTA_PAL_INT16_NEGATIVE_MASK | errno; /*lint !e40 !e9027
+                                                            * Errno is being used in accordance with host API documentation.
+                                                            * Bitmasking is being used to preserve host API error with library status code. */
+        }
+    }
+    else /* Invalid context or file pointer provided. */
+    {
+        OTA_LOG_L1( "[%s] ERROR - Invalid context.\r\n", OTA_METHOD_NAME );
+        lResult = -1;
+    }
+
+    return ( int16_t ) lResult;
+}
+
+/* Read the running image, the source of a delta update. The simulator has no image to read. */
+
+int16_t prvPAL_ReadActiveImage( OTA_FileContext_t * const C,
+                                uint32_t ulOffset,
+                                uint8_t * const pucData,
+                                uint32_t ulBlockSize )
+{
+    ( void ) C;
+    ( void ) ulOffset;
+    ( void ) pucData;
+    ( void ) ulBlockSize;
+
+    return -1;
+}
+
+/* Reopen the receive file of an interrupted transfer for update, keeping its contents. */
+
+OTA_Err_t prvPAL_ResumeFileForRx( OTA_FileContext_t * const C,
+                                  uint32_t ulBytesReceived )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_ResumeFileForRx" );
+
+    OTA_Err_t eResult = kOTA_Err_RxFileCreateFailed;
+
+    ( void ) ulBytesReceived;
+
+    if( ( C != NULL ) && ( C->pucFilePath != NULL ) )
+    {
+        C->pxFile = fopen( ( const char * )C->pucFilePath, "r+b" ); /*lint !e586
+                                                                       * C standard library call is being used for portability. */
+
+        if( C->pxFile != NULL )
+        {
+            eResult = kOTA_Err_None;
+            OTA_LOG_L1( "[%s] Receive file reopened.\r\n", OTA_METHOD_NAME );
+        }
+        else
+        {
+            eResult = ( kOTA_Err_RxFileCreateFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                       * Errno is being used in accordance with host API documentation.
+                                                                                       * Bitmasking is being used to preserve host API error with library status code. */
+            OTA_LOG_L1( "[%s] ERROR - Failed to reopen the receive file.\r\n", OTA_METHOD_NAME );
+        }
+    }
+    else
+    {
+        OTA_LOG_L1( "[%s] ERROR - Invalid context provided.\r\n", OTA_METHOD_NAME );
+    }
+
+    return eResult; /*lint !e480 !e481 Exiting function without calling fclose.
+                     * Context file handle state is managed by this API. */
+}
+
+/* Store the transfer checkpoint in a file of its own, or delete that file. */
+
+OTA_Err_t prvPAL_SaveCheckpoint( const uint8_t * pucData,
+                                 uint32_t ulSize )
+{
+    OTA_Err_t eResult = kOTA_Err_None;
+    FILE * pxFile;
+
+    if( ( pucData == NULL ) || ( ulSize == 0U ) )
+    {
+        /* A missing checkpoint file is already erased. */
+        ( void ) remove( OTA_PAL_CHECKPOINT_FILE ); /*lint !e586 C standard library call is being used for portability. */
+    }
+    else
+    {
+        pxFile = fopen( OTA_PAL_CHECKPOINT_FILE, "wb" ); /*lint !e586 C standard library call is being used for portability. */
+
+        if( pxFile == NULL )
+        {
+            eResult = ( kOTA_Err_CheckpointFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                     * Errno is being used in accordance with host API documentation.
+                                                                                     * Bitmasking is being used to preserve host API error with library status code. */
+        }
+        else
+        {
+            if( fwrite( pucData, 1, ulSize, pxFile ) != ulSize ) /*lint !e586 C standard library call is being used for portability. */
+            {
+                eResult = kOTA_Err_CheckpointFailed;
+            }
+
+            if( fclose( pxFile ) != 0 ) /*lint !e586 C standard library call is being used for portability. */
+            {
+                eResult = kOTA_Err_CheckpointFailed;
+            }
+        }
+    }
+
+    return eResult;
+}
+
+/* Read the transfer checkpoint back from its file. */
+
+int32_t prvPAL_LoadCheckpoint( uint8_t * pucData,
+                               uint32_t ulSize )
+{
+    int32_t lResult = -1;
+    FILE * pxFile = fopen( OTA_PAL_CHECKPOINT_FILE, "rb" ); /*lint !e586 C standard library call is being used for portability. */
+
+    if( pxFile != NULL )
+    {
+        lResult = ( int32_t ) fread( pucData, 1, ulSize, pxFile ); /*lint !e586 C standard library call is being used for portability. */
+        ( void ) fclose( pxFile );                                 /*lint !e586 C standard library call is being used for portability. */
+    }
+
+    return lResult;
+}
+
 /* Close the specified file. This shall authenticate the file if it is marked as secure. */
 
 OTA_Err_t prvPAL_CloseFile( OTA_FileContext_t * const C )
@@ -263,11 +425,21 @@ static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
     uint32_t ulSignerCertSize;
     uint8_t * pucBuf, * pucSignerCert;
     void * pvSigVerifyContext;
+    BaseType_t xFileHashed = pdFALSE;
 
     if( prvContextValidate( C ) == pdTRUE )
     {
+        if( C->pvSigVerifyContext != NULL )
+        {
+            /* The agent hashed the file while it was received, only the verification itself is left. */
+            pvSigVerifyContext = C->pvSigVerifyContext;
+            C->pvSigVerifyContext = NULL;
+            xFileHashed = pdTRUE;
+        }
+
         /* Verify an ECDSA-SHA256 signature. */
-        if( pdFALSE == CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA, cryptoHASH_ALGORITHM_SHA256 ) )
+        if( ( xFileHashed == pdFALSE ) &&
+            ( pdFALSE == CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA, cryptoHASH_ALGORITHM_SHA256 ) ) )
         {
             eResult = kOTA_Err_SignatureCheckFailed;
         }
@@ -287,13 +459,16 @@ static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
                     if( fseek( C->pxFile, 0L, SEEK_SET ) == 0 ) /*lint !e586
                                                                   * C standard library call is being used for portability. */
                     {
-                        do
+                        if( xFileHashed == pdFALSE )
                         {
-                            ulBytesRead = fread( pucBuf, 1, OTA_PAL_WIN_BUF_SIZE, C->pxFile ); /*lint !e586
-                                                                                               * C standard library call is being used for portability. */
-                            /* Include the file chunk in the signature validation. Zero size is OK. */
-                            CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, pucBuf, ulBytesRead );
-                        } while( ulBytesRead > 0UL );
+                            do
+                            {
+                                ulBytesRead = fread( pucBuf, 1, OTA_PAL_WIN_BUF_SIZE, C->pxFile ); /*lint !e586
+                                                                                                   * C standard library call is being used for portability. */
+                                /* Include the file chunk in the signature validation. Zero size is OK. */
+                                CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, pucBuf, ulBytesRead );
+                            } while( ulBytesRead > 0UL );
+                        }
 
                         if( pdFALSE == CRYPTO_SignatureVerificationFinal( pvSigVerifyContext,
                                                                           ( char * ) pucSignerCert,
@@ -237,6 +237,37 @@ OTA_Err_t prvPAL_CreateFileForRx(OTA_FileContext_t *C)
 }
 
 
+/* Resuming an interrupted download is not supported on this platform. The agent
+ * finds no checkpoint and receives the file from the start. */
+
+OTA_Err_t prvPAL_ResumeFileForRx( OTA_FileContext_t * const C,
+                                  uint32_t ulBytesReceived )
+{
+    ( void ) C;
+    ( void ) ulBytesReceived;
+
+    return kOTA_Err_RxFileCreateFailed;
+}
+
+OTA_Err_t prvPAL_SaveCheckpoint( const uint8_t * pucData,
+                                 uint32_t ulSize )
+{
+    ( void ) pucData;
+    ( void ) ulSize;
+
+    return kOTA_Err_CheckpointFailed;
+}
+
+int32_t prvPAL_LoadCheckpoint( uint8_t * pucData,
+                               uint32_t ulSize )
+{
+    ( void ) pucData;
+    ( void ) ulSize;
+
+    return -1;
+}
+
+
 /* Create the required system mcubootinfo.bin file to configure the system watchdog timer. */
 
 static int32_t prvCreateBootInfoFile( void )
@@ -541,3 +572,28 @@ int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C, uint32_t ulOffset, uint8
     	}
     return lReturnVal;
 }
+
+/* Read back a block of data previously written to the specified file.
+ * The receive file is open for writing only and its signature is verified by the
+ * secure file system on close, so reading back is not supported.
+ */
+int16_t prvPAL_ReadBlock( OTA_FileContext_t * const C, uint32_t ulOffset, uint8_t * const pucData, uint32_t ulBlockSize )
+{
+    ( void ) C;
+    ( void ) ulOffset;
+    ( void ) pucData;
+    ( void ) ulBlockSize;
+
+    return -1;
+}
+
+/* Delta updates are not supported, the running image is not accessible as a file. */
+int16_t prvPAL_ReadActiveImage( OTA_FileContext_t * const C, uint32_t ulOffset, uint8_t * const pucData, uint32_t ulBlockSize )
+{
+    ( void ) C;
+    ( void ) ulOffset;
+    ( void ) pucData;
+    ( void ) ulBlockSize;
+
+    return -1;
+}
@@ -45,8 +45,13 @@
 #include "mbedtls/entropy.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/base64.h"
+#include "mbedtls/ecdsa.h"
 #include "threading_alt.h"
 
+#if ( pkcs11configRANDOM_POOL_DEFERRED_REFILL == 1 )
+    #include "timers.h"
+#endif
+
 /* C runtime includes. */
 #include <stdio.h>
 #include <string.h>
@@ -67,6 +72,45 @@ typedef int ( * pfnMbedTlsSign )( void * ctx,
 /* The size of the buffer malloc'ed for the exported public key in C_GenerateKeyPair */
 #define pkcs11KEY_GEN_MAX_DER_SIZE    200
 
+/**
+ * @brief Give each session its own DRBG, seeded from the module's.
+ *
+ * With one DRBG, every signature, key generation and C_GenerateRandom() in
+ * any session serializes on its mutex.  When 1, sessions draw from their own
+ * generator and only go to the module DRBG to seed and reseed, so TLS,
+ * OTA verification and other users proceed in parallel.  Costs a CTR_DRBG
+ * context per session.
+ */
+#ifndef pkcs11configSESSION_DRBG
+    #define pkcs11configSESSION_DRBG    0
+#endif
+
+/**
+ * @brief Set to 1 to total the time spent in signing, verification, object
+ * lookups and reads, and random number generation, for
+ * PKCS11_GetOperationTimings().
+ */
+#ifndef pkcs11configENABLE_OPERATION_TIMING
+    #define pkcs11configENABLE_OPERATION_TIMING    0
+#endif
+
+/**
+ * @brief Time source of the operation timing.
+ *
+ * Ports should map this to a cycle counter when ticks are too coarse.
+ */
+#ifndef pkcs11configTIMESTAMP
+    #define pkcs11configTIMESTAMP()    ( ( uint32_t ) xTaskGetTickCount() )
+#endif
+
+#if ( pkcs11configENABLE_OPERATION_TIMING == 1 )
+    #define pkcs11TIMING_START()                             uint32_t ulOperationStart = pkcs11configTIMESTAMP()
+    #define pkcs11TIMING_RECORD( xOperation, xCompleted )    prvRecordOperation( &xOperationTimings.xOperation, ulOperationStart, xCompleted )
+#else
+    #define pkcs11TIMING_START()
+    #define pkcs11TIMING_RECORD( xOperation, xCompleted )
+#endif
+
 /* PKCS#11 Object */
 typedef struct P11Struct_t
 {
@@ -77,6 +121,10 @@ typedef struct P11Struct_t
 
 static P11Struct_t xP11Context;
 
+#if ( pkcs11configENABLE_OPERATION_TIMING == 1 )
+    static PKCS11OperationTimings_t xOperationTimings;
+#endif
+
 
 /**
  * @brief Session structure.
@@ -95,6 +143,14 @@ typedef struct P11Session
     SemaphoreHandle_t xSignMutex;   /* Protects the signing key from being modified while in use. */
     mbedtls_pk_context xSignKey;
     mbedtls_sha256_context xSHA256Context;
+    CK_BBOOL xSignAsyncActive; /* A signature started by PKCS11_SignAsyncStart() is pending. */
+    CK_BYTE ucSignAsyncHash[ cryptoSHA256_DIGEST_BYTES ];
+    #if defined( MBEDTLS_ECP_RESTARTABLE )
+        mbedtls_ecdsa_restart_ctx xSignRestartCtx; /* Progress of a pending ECDSA signature. */
+    #endif
+    #if ( pkcs11configSESSION_DRBG == 1 )
+        mbedtls_ctr_drbg_context xDrbgCtx; /* Random numbers for this session only. */
+    #endif
 } P11Session_t, * P11SessionPtr_t;
 
 /**
@@ -113,6 +169,64 @@ typedef struct P11Session
 #define pkcs11GENERATE_KEY_PAIR_KEYTYPE_ATTRIBUTE_INDEX     0
 #define pkcs11GENERATE_KEY_PAIR_ECPARAMS_ATTRIBUTE_INDEX    1
 
+/**
+ * @brief Number of objects whose handle and value are kept in RAM.
+ *
+ * Every TLS connection looks up the device key and certificate by label and
+ * reads their values, which the PAL fetches from flash each time.  When
+ * non-zero, C_FindObjects() and the object reads are served from a cache
+ * shared by all sessions, which also remembers the key type so that
+ * C_GetAttributeValue() does not parse the key for it.  Any object write
+ * empties the cache.  Private key values are then held in RAM.  0 goes to
+ * the PAL every time.
+ */
+#ifndef pkcs11configOBJECT_CACHE_SIZE
+    #define pkcs11configOBJECT_CACHE_SIZE    0
+#endif
+
+#define pkcs11OBJECT_CACHE_MAX_LABEL_LENGTH    32
+
+/**
+ * @brief Set to 1 when the PAL returns object values in memory-mapped flash.
+ *
+ * The PAL then promises that PKCS11_PAL_GetObjectValue() hands out a pointer
+ * into flash that stays valid until the object is written again, and that
+ * PKCS11_PAL_GetObjectValueCleanup() does nothing.  PKCS11_GetObjectValueInPlace()
+ * is available, so that the TLS layer parses the device certificate where it
+ * lies, and the object cache keeps no copies of values.
+ */
+#ifndef pkcs11configPAL_OBJECTS_MAPPED
+    #define pkcs11configPAL_OBJECTS_MAPPED    0
+#endif
+
+/**
+ * @brief Bytes of random data generated ahead of C_GenerateRandom().
+ *
+ * TLS, TCP sequence numbers and client tokens ask for a few bytes at a time,
+ * and each request otherwise runs the DRBG under its mutex.  When non-zero,
+ * requests no larger than half the pool are copied out of a buffer that is
+ * refilled from the module DRBG in one go once it runs low.  Bytes leave the
+ * pool once and are wiped as they do.  The copy is made in a critical
+ * section, so keep the pool small.  0 runs the DRBG for every request.
+ */
+#ifndef pkcs11configRANDOM_POOL_SIZE
+    #define pkcs11configRANDOM_POOL_SIZE    0
+#endif
+
+/**
+ * @brief Set to 1 to refill the random pool from the timer service task.
+ *
+ * Takes the refill off the path of the request that drained the pool.  The
+ * timer task stack must then fit a DRBG call, including a reseed.
+ */
+#ifndef pkcs11configRANDOM_POOL_DEFERRED_REFILL
+    #define pkcs11configRANDOM_POOL_DEFERRED_REFILL    0
+#endif
+
+#if ( pkcs11configRANDOM_POOL_DEFERRED_REFILL == 1 ) && ( ( configUSE_TIMERS != 1 ) || ( INCLUDE_xTimerPendFunctionCall != 1 ) )
+    #error "pkcs11configRANDOM_POOL_DEFERRED_REFILL needs configUSE_TIMERS and INCLUDE_xTimerPendFunctionCall set to 1."
+#endif
+
 
 /*-----------------------------------------------------------*/
 /*------------ Port Specific File Access API ----------------*/
@@ -150,7 +264,34 @@ extern void PKCS11_PAL_GetObjectValueCleanup( uint8_t * pucBuffer,
 
 /*-----------------------------------------------------------*/
 
+#if ( pkcs11configOBJECT_CACHE_SIZE > 0 )
 
+    /**
+     * @brief An object handle and value remembered from the PAL.
+     */
+    typedef struct P11CachedObject
+    {
+        CK_BBOOL xValid;
+        CK_OBJECT_HANDLE xHandle;
+        uint8_t ucLabel[ pkcs11OBJECT_CACHE_MAX_LABEL_LENGTH ];
+        uint8_t ucLabelLength;   /* 0 when the object was not looked up by label. */
+        uint8_t * pucValue;      /* NULL until the value is read. */
+        uint32_t ulValueLength;
+        CK_BBOOL xIsPrivate;
+        CK_KEY_TYPE xKeyType;    /* ~0 until the type is determined. */
+    } P11CachedObject_t;
+
+    static P11CachedObject_t xObjectCache[ pkcs11configOBJECT_CACHE_SIZE ];
+    static SemaphoreHandle_t xObjectCacheMutex = NULL;
+    static uint32_t ulObjectCacheVictim = 0;
+#endif /* if ( pkcs11configOBJECT_CACHE_SIZE > 0 ) */
+
+#if ( pkcs11configRANDOM_POOL_SIZE > 0 )
+    static uint8_t ucRandomPool[ pkcs11configRANDOM_POOL_SIZE ];
+    static uint8_t ucRandomPoolRefill[ pkcs11configRANDOM_POOL_SIZE ];
+    static size_t xRandomPoolAvailable = 0;      /* Unused bytes, at the start of the pool. */
+    static BaseType_t xRandomPoolRefilling = pdFALSE;
+#endif
 
 /*-----------------------------------------------------------*/
 /*--------- mbedTLS threading functions for FreeRTOS --------*/
@@ -253,6 +394,540 @@ P11SessionPtr_t prvSessionPointerFromHandle( CK_SESSION_HANDLE xSession )
     return ( P11SessionPtr_t ) xSession; /*lint !e923 Allow casting integer type to pointer for handle. */
 }
 
+#if ( pkcs11configENABLE_OPERATION_TIMING == 1 )
+
+    /**
+     * @brief Adds the time since ulStart to an operation total.
+     */
+    static void prvRecordOperation( PKCS11OperationTiming_t * pxTiming,
+                                    uint32_t ulStart,
+                                    BaseType_t xCompleted )
+    {
+        uint32_t ulElapsed = pkcs11configTIMESTAMP() - ulStart;
+
+        /* Sessions may run in several tasks. */
+        taskENTER_CRITICAL();
+        {
+            pxTiming->ulTime += ulElapsed;
+
+            if( pdTRUE == xCompleted )
+            {
+                pxTiming->ulCount++;
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* if ( pkcs11configENABLE_OPERATION_TIMING == 1 ) */
+
+/**
+ * @brief Gets the DRBG a session draws random numbers from.
+ */
+static mbedtls_ctr_drbg_context * prvSessionDrbg( P11SessionPtr_t pxSession )
+{
+    #if ( pkcs11configSESSION_DRBG == 1 )
+        return ( NULL != pxSession ) ? &pxSession->xDrbgCtx : &xP11Context.xMbedDrbgCtx;
+    #else
+        ( void ) pxSession;
+
+        return &xP11Context.xMbedDrbgCtx;
+    #endif
+}
+
+#if ( pkcs11configOBJECT_CACHE_SIZE > 0 )
+
+    /**
+     * @brief Takes the object cache lock, creating it on first use.
+     */
+    static BaseType_t prvObjectCacheLock( void )
+    {
+        SemaphoreHandle_t xMutex = NULL;
+        BaseType_t xInstalled = pdFALSE;
+
+        if( NULL == xObjectCacheMutex )
+        {
+            xMutex = xSemaphoreCreateMutex();
+
+            /* Another task may have raced to create the lock. */
+            taskENTER_CRITICAL();
+            {
+                if( NULL == xObjectCacheMutex )
+                {
+                    xObjectCacheMutex = xMutex;
+                    xInstalled = pdTRUE;
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            if( ( pdFALSE == xInstalled ) && ( NULL != xMutex ) )
+            {
+                vSemaphoreDelete( xMutex );
+            }
+        }
+
+        return ( NULL != xObjectCacheMutex ) ? xSemaphoreTake( xObjectCacheMutex, portMAX_DELAY ) : pdFALSE;
+    }
+
+    /**
+     * @brief Forgets an object; the cache lock must be held.
+     */
+    static void prvObjectCacheDrop( P11CachedObject_t * pxEntry )
+    {
+        if( NULL != pxEntry->pucValue )
+        {
+            /* The value may be a private key. */
+            memset( pxEntry->pucValue, 0, pxEntry->ulValueLength );
+            vPortFree( pxEntry->pucValue );
+        }
+
+        memset( pxEntry, 0, sizeof( P11CachedObject_t ) );
+    }
+
+    /**
+     * @brief Forgets every object, after the objects in storage changed.
+     */
+    static void prvObjectCacheInvalidate( void )
+    {
+        uint32_t ulIndex;
+
+        if( pdTRUE == prvObjectCacheLock() )
+        {
+            for( ulIndex = 0; ulIndex < ( uint32_t ) pkcs11configOBJECT_CACHE_SIZE; ulIndex++ )
+            {
+                prvObjectCacheDrop( &xObjectCache[ ulIndex ] );
+            }
+
+            ( void ) xSemaphoreGive( xObjectCacheMutex );
+        }
+    }
+
+    /**
+     * @brief Finds the entry of a handle, or of a label when pucLabel is not
+     * NULL; the cache lock must be held.
+     */
+    static P11CachedObject_t * prvObjectCacheFind( CK_OBJECT_HANDLE xHandle,
+                                                   const uint8_t * pucLabel,
+                                                   uint8_t ucLabelLength )
+    {
+        P11CachedObject_t * pxEntry = NULL;
+        uint32_t ulIndex;
+
+        for( ulIndex = 0; ( NULL == pxEntry ) && ( ulIndex < ( uint32_t ) pkcs11configOBJECT_CACHE_SIZE ); ulIndex++ )
+        {
+            if( CK_TRUE == xObjectCache[ ulIndex ].xValid )
+            {
+                if( NULL == pucLabel )
+                {
+                    if( xHandle == xObjectCache[ ulIndex ].xHandle )
+                    {
+                        pxEntry = &xObjectCache[ ulIndex ];
+                    }
+                }
+                else if( ( ucLabelLength == xObjectCache[ ulIndex ].ucLabelLength ) &&
+                         ( 0 == memcmp( pucLabel, xObjectCache[ ulIndex ].ucLabel, ucLabelLength ) ) )
+                {
+                    pxEntry = &xObjectCache[ ulIndex ];
+                }
+                else
+                {
+                    /* Not this one. */
+                }
+            }
+        }
+
+        return pxEntry;
+    }
+
+    /**
+     * @brief Gets the entry of a handle, creating it in a free or else the
+     * oldest-filled slot; the cache lock must be held.
+     */
+    static P11CachedObject_t * prvObjectCacheAdd( CK_OBJECT_HANDLE xHandle )
+    {
+        P11CachedObject_t * pxEntry = prvObjectCacheFind( xHandle, NULL, 0 );
+        uint32_t ulIndex;
+
+        for( ulIndex = 0; ( NULL == pxEntry ) && ( ulIndex < ( uint32_t ) pkcs11configOBJECT_CACHE_SIZE ); ulIndex++ )
+        {
+            if( CK_FALSE == xObjectCache[ ulIndex ].xValid )
+            {
+                pxEntry = &xObjectCache[ ulIndex ];
+            }
+        }
+
+        if( NULL == pxEntry )
+        {
+            pxEntry = &xObjectCache[ ulObjectCacheVictim ];
+            ulObjectCacheVictim = ( ulObjectCacheVictim + 1U ) % ( uint32_t ) pkcs11configOBJECT_CACHE_SIZE;
+            prvObjectCacheDrop( pxEntry );
+        }
+
+        if( CK_FALSE == pxEntry->xValid )
+        {
+            pxEntry->xValid = CK_TRUE;
+            pxEntry->xHandle = xHandle;
+            pxEntry->xKeyType = ( CK_KEY_TYPE ) ~0;
+        }
+
+        return pxEntry;
+    }
+
+    /**
+     * @brief PKCS11_PAL_SaveObject(), emptying the cache.
+     */
+    static CK_OBJECT_HANDLE prvSaveObject( CK_ATTRIBUTE_PTR pxLabel,
+                                           uint8_t * pucData,
+                                           uint32_t ulDataSize )
+    {
+        CK_OBJECT_HANDLE xHandle = PKCS11_PAL_SaveObject( pxLabel, pucData, ulDataSize );
+
+        prvObjectCacheInvalidate();
+
+        return xHandle;
+    }
+
+    /**
+     * @brief PKCS11_PAL_FindObject(), through the cache.
+     */
+    static CK_OBJECT_HANDLE prvFindObject( uint8_t * pLabel,
+                                           uint8_t usLength )
+    {
+        CK_OBJECT_HANDLE xHandle = 0;
+        P11CachedObject_t * pxEntry = NULL;
+
+        if( usLength > ( uint8_t ) pkcs11OBJECT_CACHE_MAX_LABEL_LENGTH )
+        {
+            xHandle = PKCS11_PAL_FindObject( pLabel, usLength );
+        }
+        else if( pdTRUE == prvObjectCacheLock() )
+        {
+            pxEntry = prvObjectCacheFind( 0, pLabel, usLength );
+
+            if( NULL != pxEntry )
+            {
+                xHandle = pxEntry->xHandle;
+            }
+            else
+            {
+                xHandle = PKCS11_PAL_FindObject( pLabel, usLength );
+
+                /* 0 is always an invalid handle. */
+                if( 0 != xHandle )
+                {
+                    pxEntry = prvObjectCacheAdd( xHandle );
+                    memcpy( pxEntry->ucLabel, pLabel, usLength );
+                    pxEntry->ucLabelLength = usLength;
+                }
+            }
+
+            ( void ) xSemaphoreGive( xObjectCacheMutex );
+        }
+        else
+        {
+            xHandle = PKCS11_PAL_FindObject( pLabel, usLength );
+        }
+
+        return xHandle;
+    }
+
+    #if ( pkcs11configPAL_OBJECTS_MAPPED == 1 )
+        /* The values are read where they lie; only handles and key types are
+         * cached. */
+        #define prvGetObjectValue           PKCS11_PAL_GetObjectValue
+        #define prvGetObjectValueCleanup    PKCS11_PAL_GetObjectValueCleanup
+    #else
+
+    /**
+     * @brief PKCS11_PAL_GetObjectValue(), through the cache.
+     *
+     * The value returned is a copy, so that the cache can change while it is
+     * used, and must be released with prvGetObjectValueCleanup().
+     */
+    static BaseType_t prvGetObjectValue( CK_OBJECT_HANDLE xHandle,
+                                         uint8_t ** ppucData,
+                                         uint32_t * pulDataSize,
+                                         CK_BBOOL * pxIsPrivate )
+    {
+        BaseType_t xResult = CKR_OK;
+        P11CachedObject_t * pxEntry = NULL;
+        uint8_t * pucPalData = NULL;
+        uint32_t ulPalDataSize = 0;
+
+        *ppucData = NULL;
+
+        if( pdTRUE == prvObjectCacheLock() )
+        {
+            pxEntry = prvObjectCacheAdd( xHandle );
+
+            if( NULL == pxEntry->pucValue )
+            {
+                xResult = PKCS11_PAL_GetObjectValue( xHandle, &pucPalData, &ulPalDataSize, &pxEntry->xIsPrivate );
+
+                if( CKR_OK == xResult )
+                {
+                    pxEntry->pucValue = ( uint8_t * ) pvPortMalloc( ulPalDataSize ); /*lint !e9079 Allow casting void* to other types. */
+
+                    if( NULL != pxEntry->pucValue )
+                    {
+                        memcpy( pxEntry->pucValue, pucPalData, ulPalDataSize );
+                        pxEntry->ulValueLength = ulPalDataSize;
+                    }
+                    else
+                    {
+                        xResult = CKR_HOST_MEMORY;
+                    }
+
+                    PKCS11_PAL_GetObjectValueCleanup( pucPalData, ulPalDataSize );
+                }
+            }
+
+            if( ( CKR_OK == xResult ) && ( NULL != pxEntry->pucValue ) )
+            {
+                *ppucData = ( uint8_t * ) pvPortMalloc( pxEntry->ulValueLength ); /*lint !e9079 Allow casting void* to other types. */
+
+                if( NULL != *ppucData )
+                {
+                    memcpy( *ppucData, pxEntry->pucValue, pxEntry->ulValueLength );
+                    *pulDataSize = pxEntry->ulValueLength;
+                    *pxIsPrivate = pxEntry->xIsPrivate;
+                }
+                else
+                {
+                    xResult = CKR_HOST_MEMORY;
+                }
+            }
+
+            /* Do not keep an entry for an object that could not be read. */
+            if( NULL == pxEntry->pucValue )
+            {
+                prvObjectCacheDrop( pxEntry );
+            }
+
+            ( void ) xSemaphoreGive( xObjectCacheMutex );
+        }
+        else
+        {
+            xResult = CKR_CANT_LOCK;
+        }
+
+        return xResult;
+    }
+
+    /**
+     * @brief Releases a value returned by prvGetObjectValue().
+     */
+    static void prvGetObjectValueCleanup( uint8_t * pucData,
+                                          uint32_t ulDataSize )
+    {
+        if( NULL != pucData )
+        {
+            memset( pucData, 0, ulDataSize );
+            vPortFree( pucData );
+        }
+    }
+    #endif /* if ( pkcs11configPAL_OBJECTS_MAPPED == 1 ) */
+
+    /**
+     * @brief Gets the remembered type of a key.
+     *
+     * @return CK_TRUE if the type is known.
+     */
+    static CK_BBOOL prvObjectCacheGetKeyType( CK_OBJECT_HANDLE xHandle,
+                                              CK_KEY_TYPE * pxKeyType )
+    {
+        CK_BBOOL xFound = CK_FALSE;
+        P11CachedObject_t * pxEntry = NULL;
+
+        if( pdTRUE == prvObjectCacheLock() )
+        {
+            pxEntry = prvObjectCacheFind( xHandle, NULL, 0 );
+
+            if( ( NULL != pxEntry ) && ( ( CK_KEY_TYPE ) ~0 != pxEntry->xKeyType ) )
+            {
+                *pxKeyType = pxEntry->xKeyType;
+                xFound = CK_TRUE;
+            }
+
+            ( void ) xSemaphoreGive( xObjectCacheMutex );
+        }
+
+        return xFound;
+    }
+
+    /**
+     * @brief Remembers the type of a key.
+     */
+    static void prvObjectCacheSetKeyType( CK_OBJECT_HANDLE xHandle,
+                                          CK_KEY_TYPE xKeyType )
+    {
+        P11CachedObject_t * pxEntry = NULL;
+
+        if( pdTRUE == prvObjectCacheLock() )
+        {
+            pxEntry = prvObjectCacheFind( xHandle, NULL, 0 );
+
+            if( NULL != pxEntry )
+            {
+                pxEntry->xKeyType = xKeyType;
+            }
+
+            ( void ) xSemaphoreGive( xObjectCacheMutex );
+        }
+    }
+
+#else /* if ( pkcs11configOBJECT_CACHE_SIZE > 0 ) */
+    #define prvSaveObject                 PKCS11_PAL_SaveObject
+    #define prvFindObject                 PKCS11_PAL_FindObject
+    #define prvGetObjectValue             PKCS11_PAL_GetObjectValue
+    #define prvGetObjectValueCleanup      PKCS11_PAL_GetObjectValueCleanup
+    #define prvObjectCacheInvalidate()
+    #define prvObjectCacheGetKeyType( xHandle, pxKeyType )    ( CK_FALSE )
+    #define prvObjectCacheSetKeyType( xHandle, xKeyType )
+#endif /* if ( pkcs11configOBJECT_CACHE_SIZE > 0 ) */
+
+#if ( pkcs11configRANDOM_POOL_SIZE > 0 )
+
+    /**
+     * @brief Fills the random pool from the module DRBG.
+     *
+     * Only one task refills at a time.  The DRBG runs into a scratch buffer
+     * outside the critical section, so takers are only held off for the copy.
+     */
+    static void prvRandomPoolRefill( void )
+    {
+        BaseType_t xRefill = pdFALSE;
+
+        taskENTER_CRITICAL();
+        {
+            if( ( pdFALSE == xRandomPoolRefilling ) &&
+                ( xRandomPoolAvailable < ( pkcs11configRANDOM_POOL_SIZE / 2 ) ) )
+            {
+                xRandomPoolRefilling = pdTRUE;
+                xRefill = pdTRUE;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( pdTRUE == xRefill )
+        {
+            if( 0 == mbedtls_ctr_drbg_random( &xP11Context.xMbedDrbgCtx,
+                                              ucRandomPoolRefill,
+                                              sizeof( ucRandomPoolRefill ) ) )
+            {
+                taskENTER_CRITICAL();
+                {
+                    /* The bytes still in the pool are replaced rather than
+                     * kept, which is as good and saves a move. */
+                    memcpy( ucRandomPool, ucRandomPoolRefill, sizeof( ucRandomPool ) );
+                    xRandomPoolAvailable = sizeof( ucRandomPool );
+                }
+                taskEXIT_CRITICAL();
+            }
+
+            memset( ucRandomPoolRefill, 0, sizeof( ucRandomPoolRefill ) );
+
+            taskENTER_CRITICAL();
+            {
+                xRandomPoolRefilling = pdFALSE;
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    #if ( pkcs11configRANDOM_POOL_DEFERRED_REFILL == 1 )
+
+        /**
+         * @brief Runs a random pool refill in the timer service task.
+         */
+        static void prvRandomPoolRefillCallback( void * pvParameter1,
+                                                 uint32_t ulParameter2 )
+        {
+            ( void ) pvParameter1;
+            ( void ) ulParameter2;
+
+            if( CK_TRUE == xP11Context.xIsInitialized )
+            {
+                prvRandomPoolRefill();
+            }
+        }
+    #endif
+
+    /**
+     * @brief Copies random bytes out of the pool.
+     *
+     * @return CK_TRUE if the pool held enough bytes, else CK_FALSE and the
+     * caller goes to the DRBG itself.
+     */
+    static CK_BBOOL prvRandomPoolTake( CK_BYTE_PTR pucRandomData,
+                                       CK_ULONG ulRandomLen )
+    {
+        CK_BBOOL xTaken = CK_FALSE;
+        BaseType_t xLow = pdFALSE;
+
+        if( ulRandomLen <= ( pkcs11configRANDOM_POOL_SIZE / 2 ) )
+        {
+            taskENTER_CRITICAL();
+            {
+                if( xRandomPoolAvailable >= ulRandomLen )
+                {
+                    xRandomPoolAvailable -= ulRandomLen;
+                    memcpy( pucRandomData, &ucRandomPool[ xRandomPoolAvailable ], ulRandomLen );
+                    memset( &ucRandomPool[ xRandomPoolAvailable ], 0, ulRandomLen );
+                    xTaken = CK_TRUE;
+                }
+
+                xLow = ( xRandomPoolAvailable < ( pkcs11configRANDOM_POOL_SIZE / 2 ) ) &&
+                       ( pdFALSE == xRandomPoolRefilling );
+            }
+            taskEXIT_CRITICAL();
+
+            if( pdTRUE == xLow )
+            {
+                #if ( pkcs11configRANDOM_POOL_DEFERRED_REFILL == 1 )
+                    /* If the timer queue is full, a later request asks again. */
+                    ( void ) xTimerPendFunctionCall( prvRandomPoolRefillCallback, NULL, 0, 0 );
+                #else
+                    prvRandomPoolRefill();
+                #endif
+            }
+        }
+
+        return xTaken;
+    }
+
+    /**
+     * @brief Wipes the random pool.
+     */
+    static void prvRandomPoolClear( void )
+    {
+        taskENTER_CRITICAL();
+        {
+            memset( ucRandomPool, 0, sizeof( ucRandomPool ) );
+            xRandomPoolAvailable = 0;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#else /* if ( pkcs11configRANDOM_POOL_SIZE > 0 ) */
+    #define prvRandomPoolTake( pucRandomData, ulRandomLen )    ( CK_FALSE )
+    #define prvRandomPoolClear()
+#endif /* if ( pkcs11configRANDOM_POOL_SIZE > 0 ) */
+
+/**
+ * @brief Ends a pending asynchronous signature; the sign lock must be held.
+ */
+static void prvSignAsyncEnd( P11SessionPtr_t pxSession )
+{
+    if( CK_TRUE == pxSession->xSignAsyncActive )
+    {
+        #if defined( MBEDTLS_ECP_RESTARTABLE )
+            mbedtls_ecdsa_restart_free( &pxSession->xSignRestartCtx );
+        #endif
+
+        pxSession->xSignAsyncActive = CK_FALSE;
+    }
+}
+
 
 /*
  * PKCS#11 module implementation.
@@ -371,6 +1046,10 @@ CK_RV prvMbedTLS_Initialize( void )
         else
         {
             xP11Context.xIsInitialized = CK_TRUE;
+
+            #if ( pkcs11configENABLE_OPERATION_TIMING == 1 )
+                memset( &xOperationTimings, 0, sizeof( xOperationTimings ) );
+            #endif
         }
     }
 
@@ -419,6 +1098,9 @@ CK_DEFINE_FUNCTION( CK_RV, C_Finalize )( CK_VOID_PTR pvReserved )
             mbedtls_ctr_drbg_free( &xP11Context.xMbedDrbgCtx );
         }
 
+        prvObjectCacheInvalidate();
+        prvRandomPoolClear();
+
         xP11Context.xIsInitialized = CK_FALSE;
     }
 
@@ -544,6 +1226,24 @@ CK_DEFINE_FUNCTION( CK_RV, C_OpenSession )( CK_SLOT_ID xSlotID,
         }
     }
 
+    #if ( pkcs11configSESSION_DRBG == 1 )
+        if( CKR_OK == xResult )
+        {
+            /* The module DRBG locks itself, and is only needed again to reseed. */
+            mbedtls_ctr_drbg_init( &pxSessionObj->xDrbgCtx );
+
+            if( 0 != mbedtls_ctr_drbg_seed( &pxSessionObj->xDrbgCtx,
+                                            mbedtls_ctr_drbg_random,
+                                            &xP11Context.xMbedDrbgCtx,
+                                            NULL,
+                                            0 ) )
+            {
+                mbedtls_ctr_drbg_free( &pxSessionObj->xDrbgCtx );
+                xResult = CKR_FUNCTION_FAILED;
+            }
+        }
+    #endif
+
     if( CKR_OK == xResult )
     {
         /*
@@ -591,6 +1291,8 @@ CK_DEFINE_FUNCTION( CK_RV, C_CloseSession )( CK_SESSION_HANDLE xSession )
          * Tear down the session.
          */
 
+        prvSignAsyncEnd( pxSession );
+
         if( NULL != pxSession->xSignKey.pk_ctx )
         {
             mbedtls_pk_free( &pxSession->xSignKey );
@@ -617,6 +1319,10 @@ CK_DEFINE_FUNCTION( CK_RV, C_CloseSession )( CK_SESSION_HANDLE xSession )
             mbedtls_sha256_free( &pxSession->xSHA256Context );
         }
 
+        #if ( pkcs11configSESSION_DRBG == 1 )
+            mbedtls_ctr_drbg_free( &pxSession->xDrbgCtx );
+        #endif
+
         vPortFree( pxSession );
     }
     else
@@ -719,7 +1425,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_CreateObject )( CK_SESSION_HANDLE xSession,
                 }
 
                 /* Write the certificate to NVM. */
-                if( 0 == ( *pxObject = PKCS11_PAL_SaveObject( &pxCertificateTemplate->xLabel,
+                if( 0 == ( *pxObject = prvSaveObject( &pxCertificateTemplate->xLabel,
                                                               pxCertificateTemplate->xValue.pValue,
                                                               pxCertificateTemplate->xValue.ulValueLen ) ) )
                 {
@@ -789,7 +1495,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_CreateObject )( CK_SESSION_HANDLE xSession,
                 }
 
                 /* Save the key to NVM. */
-                if( 0 == ( *pxObject = PKCS11_PAL_SaveObject( &pxKeyTemplate->xLabel,
+                if( 0 == ( *pxObject = prvSaveObject( &pxKeyTemplate->xLabel,
                                                               pxKeyTemplate->xValue.pValue,
                                                               pxKeyTemplate->xValue.ulValueLen ) ) )
                 {
@@ -816,6 +1522,9 @@ CK_DEFINE_FUNCTION( CK_RV, C_DestroyObject )( CK_SESSION_HANDLE xSession,
     /* TODO: Delete objects from NVM. */
     ( void ) xSession;
     ( void ) xObject;
+
+    prvObjectCacheInvalidate();
+
     return CKR_OK;
 }
 
@@ -837,6 +1546,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
 
     uint8_t * pxObjectValue = NULL;
     uint32_t ulLength = 0;
+    pkcs11TIMING_START();
 
     /* Avoid warnings about unused parameters. */
     ( void ) xSession;
@@ -850,7 +1560,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
         /*
          * Copy the object into a buffer.
          */
-        xResult = PKCS11_PAL_GetObjectValue( xObject, &pxObjectValue, &ulLength, &xIsPrivate );
+        xResult = prvGetObjectValue( xObject, &pxObjectValue, &ulLength, &xIsPrivate );
     }
 
     if( xResult == CKR_OK )
@@ -894,6 +1604,10 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
                     {
                         xResult = CKR_BUFFER_TOO_SMALL;
                     }
+                    else if( CK_TRUE == prvObjectCacheGetKeyType( xObject, &xPkcsKeyType ) )
+                    {
+                        memcpy( pxTemplate[ iAttrib ].pValue, &xPkcsKeyType, sizeof( CK_KEY_TYPE ) );
+                    }
                     else
                     {
                         mbedtls_pk_init( &privateKeyContext );
@@ -930,6 +1644,11 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
                             }
 
                             memcpy( pxTemplate[ iAttrib ].pValue, &xPkcsKeyType, sizeof( CK_KEY_TYPE ) );
+
+                            if( CKR_OK == xResult )
+                            {
+                                prvObjectCacheSetKeyType( xObject, xPkcsKeyType );
+                            }
                         }
 
                         /* Free the mbedTLS structure used to parse the key. */
@@ -944,9 +1663,11 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
         }
 
         /* Free the buffer where object was stored. */
-        PKCS11_PAL_GetObjectValueCleanup( pxObjectValue, ulLength );
+        prvGetObjectValueCleanup( pxObjectValue, ulLength );
     }
 
+    pkcs11TIMING_RECORD( xGetAttributeValue, pdTRUE );
+
     return xResult;
 }
 
@@ -1024,6 +1745,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_FindObjects )( CK_SESSION_HANDLE xSession,
     CK_RV xResult = CKR_OK;
     BaseType_t xDone = pdFALSE;
     P11SessionPtr_t pxSession = prvSessionPointerFromHandle( xSession );
+    pkcs11TIMING_START();
 
     /*
      * Check parameters.
@@ -1057,7 +1779,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_FindObjects )( CK_SESSION_HANDLE xSession,
 
     if( ( pdFALSE == xDone ) )
     {
-        *pxObject = PKCS11_PAL_FindObject( pxSession->xFindObjectLabel, pxSession->xFindObjectLabelLength );
+        *pxObject = prvFindObject( pxSession->xFindObjectLabel, pxSession->xFindObjectLabelLength );
 
         if( *pxObject != 0 ) /* 0 is always an invalid handle. */
         {
@@ -1071,6 +1793,8 @@ CK_DEFINE_FUNCTION( CK_RV, C_FindObjects )( CK_SESSION_HANDLE xSession,
         }
     }
 
+    pkcs11TIMING_RECORD( xFindObjects, pdTRUE );
+
     return xResult;
 }
 
@@ -1235,7 +1959,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
     }
     else
     {
-        xResult = PKCS11_PAL_GetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
+        xResult = prvGetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
 
         if( xIsPrivate != CK_TRUE )
         {
@@ -1244,7 +1968,12 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
 
         if( xResult == CKR_OK )
         {
-            if( pdTRUE == xSemaphoreTake( pxSession->xSignMutex, portMAX_DELAY ) )
+            if( CK_TRUE == pxSession->xSignAsyncActive )
+            {
+                /* The pending signature still uses the key. */
+                xResult = CKR_OPERATION_ACTIVE;
+            }
+            else if( pdTRUE == xSemaphoreTake( pxSession->xSignMutex, portMAX_DELAY ) )
             {
                 /* Free the private key context if it exists.
                 * TODO: Check if the key is the same as was used previously. */
@@ -1278,7 +2007,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
             }
         }
 
-        PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
+        prvGetObjectValueCleanup( keyData, ulKeyDataLength );
     }
 
     return xResult;
@@ -1295,6 +2024,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
 {   /*lint !e9072 It's OK to have different parameter name. */
     CK_RV xResult = CKR_OK;
     P11SessionPtr_t pxSessionObj = prvSessionPointerFromHandle( xSession );
+    pkcs11TIMING_START();
 
     if( NULL == pulSignatureLen )
     {
@@ -1335,7 +2065,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
                                                     pucSignature,
                                                     ( size_t * ) pulSignatureLen,
                                                     mbedtls_ctr_drbg_random,
-                                                    &xP11Context.xMbedDrbgCtx );
+                                                    prvSessionDrbg( pxSessionObj ) );
 
                     if( x != CKR_OK )
                     {
@@ -1352,6 +2082,241 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
         }
     }
 
+    pkcs11TIMING_RECORD( xSign, pdTRUE );
+
+    return xResult;
+}
+
+/**
+ * @brief Start a digital signature of the indicated hash without waiting for
+ * it.
+ */
+CK_RV PKCS11_SignAsyncStart( CK_SESSION_HANDLE xSession,
+                             CK_BYTE_PTR pucData,
+                             CK_ULONG ulDataLen )
+{
+    CK_RV xResult = CKR_OK;
+    P11SessionPtr_t pxSessionObj = prvSessionPointerFromHandle( xSession );
+
+    if( ( NULL == pxSessionObj ) || ( NULL == pucData ) )
+    {
+        xResult = CKR_ARGUMENTS_BAD;
+    }
+    else if( ( CK_ULONG ) cryptoSHA256_DIGEST_BYTES != ulDataLen )
+    {
+        xResult = CKR_DATA_LEN_RANGE;
+    }
+    else if( pdTRUE == xSemaphoreTake( pxSessionObj->xSignMutex, portMAX_DELAY ) )
+    {
+        if( CK_TRUE == pxSessionObj->xSignAsyncActive )
+        {
+            xResult = CKR_OPERATION_ACTIVE;
+        }
+        else if( NULL == pxSessionObj->xSignKey.pk_ctx )
+        {
+            xResult = CKR_OPERATION_NOT_INITIALIZED;
+        }
+        else
+        {
+            memcpy( pxSessionObj->ucSignAsyncHash, pucData, sizeof( pxSessionObj->ucSignAsyncHash ) );
+
+            #if defined( MBEDTLS_ECP_RESTARTABLE )
+                mbedtls_ecdsa_restart_init( &pxSessionObj->xSignRestartCtx );
+            #endif
+
+            pxSessionObj->xSignAsyncActive = CK_TRUE;
+        }
+
+        xSemaphoreGive( pxSessionObj->xSignMutex );
+    }
+    else
+    {
+        xResult = CKR_CANT_LOCK;
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Advance a digital signature started with PKCS11_SignAsyncStart().
+ *
+ * ECDSA signatures are computed in steps of at most the number of operations
+ * set with mbedtls_ecp_set_max_ops() when mbedTLS supports restartable ECC.
+ * Other signatures are computed by the first call.
+ */
+CK_RV PKCS11_SignAsyncPoll( CK_SESSION_HANDLE xSession,
+                            CK_BYTE_PTR pucSignature,
+                            CK_ULONG_PTR pulSignatureLen )
+{
+    CK_RV xResult = CKR_OK;
+    int lResult = 0;
+    P11SessionPtr_t pxSessionObj = prvSessionPointerFromHandle( xSession );
+    pkcs11TIMING_START();
+
+    if( ( NULL == pxSessionObj ) || ( NULL == pucSignature ) || ( NULL == pulSignatureLen ) )
+    {
+        xResult = CKR_ARGUMENTS_BAD;
+    }
+    else if( pdTRUE == xSemaphoreTake( pxSessionObj->xSignMutex, portMAX_DELAY ) )
+    {
+        if( CK_TRUE != pxSessionObj->xSignAsyncActive )
+        {
+            xResult = CKR_OPERATION_NOT_INITIALIZED;
+        }
+        else
+        {
+            #if defined( MBEDTLS_ECP_RESTARTABLE )
+                if( 0 != mbedtls_pk_can_do( &pxSessionObj->xSignKey, MBEDTLS_PK_ECDSA ) )
+                {
+                    lResult = mbedtls_ecdsa_write_signature_restartable( mbedtls_pk_ec( pxSessionObj->xSignKey ),
+                                                                         MBEDTLS_MD_SHA256,
+                                                                         pxSessionObj->ucSignAsyncHash,
+                                                                         sizeof( pxSessionObj->ucSignAsyncHash ),
+                                                                         pucSignature,
+                                                                         ( size_t * ) pulSignatureLen,
+                                                                         mbedtls_ctr_drbg_random,
+                                                                         prvSessionDrbg( pxSessionObj ),
+                                                                         &pxSessionObj->xSignRestartCtx );
+                }
+                else
+            #endif /* if defined( MBEDTLS_ECP_RESTARTABLE ) */
+            {
+                lResult = mbedtls_pk_sign( &pxSessionObj->xSignKey,
+                                           MBEDTLS_MD_SHA256,
+                                           pxSessionObj->ucSignAsyncHash,
+                                           sizeof( pxSessionObj->ucSignAsyncHash ),
+                                           pucSignature,
+                                           ( size_t * ) pulSignatureLen,
+                                           mbedtls_ctr_drbg_random,
+                                           prvSessionDrbg( pxSessionObj ) );
+            }
+
+            if( MBEDTLS_ERR_ECP_IN_PROGRESS == lResult )
+            {
+                xResult = pkcs11CKR_SIGN_IN_PROGRESS;
+            }
+            else
+            {
+                if( 0 != lResult )
+                {
+                    xResult = CKR_FUNCTION_FAILED;
+                }
+
+                prvSignAsyncEnd( pxSessionObj );
+            }
+        }
+
+        xSemaphoreGive( pxSessionObj->xSignMutex );
+    }
+    else
+    {
+        xResult = CKR_CANT_LOCK;
+    }
+
+    pkcs11TIMING_RECORD( xSign, ( pkcs11CKR_SIGN_IN_PROGRESS != xResult ) ? pdTRUE : pdFALSE );
+
+    return xResult;
+}
+
+/**
+ * @brief Abandon a digital signature started with PKCS11_SignAsyncStart().
+ */
+CK_RV PKCS11_SignAsyncAbort( CK_SESSION_HANDLE xSession )
+{
+    CK_RV xResult = CKR_OK;
+    P11SessionPtr_t pxSessionObj = prvSessionPointerFromHandle( xSession );
+
+    if( NULL == pxSessionObj )
+    {
+        xResult = CKR_ARGUMENTS_BAD;
+    }
+    else if( pdTRUE == xSemaphoreTake( pxSessionObj->xSignMutex, portMAX_DELAY ) )
+    {
+        prvSignAsyncEnd( pxSessionObj );
+        xSemaphoreGive( pxSessionObj->xSignMutex );
+    }
+    else
+    {
+        xResult = CKR_CANT_LOCK;
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Get a pointer to the value of an object in memory-mapped flash.
+ */
+CK_RV PKCS11_GetObjectValueInPlace( CK_SESSION_HANDLE xSession,
+                                    CK_OBJECT_HANDLE xObject,
+                                    const CK_BYTE ** ppucValue,
+                                    CK_ULONG_PTR pulValueLen )
+{
+    CK_RV xResult = CKR_FUNCTION_NOT_SUPPORTED;
+
+    #if ( pkcs11configPAL_OBJECTS_MAPPED == 1 )
+        uint8_t * pucValue = NULL;
+        uint32_t ulLength = 0;
+        CK_BBOOL xIsPrivate = CK_TRUE;
+    #endif
+
+    /* Avoid warnings about unused parameters. */
+    ( void ) xSession;
+    ( void ) xObject;
+
+    if( ( NULL == ppucValue ) || ( NULL == pulValueLen ) )
+    {
+        xResult = CKR_ARGUMENTS_BAD;
+    }
+
+    #if ( pkcs11configPAL_OBJECTS_MAPPED == 1 )
+        else
+        {
+            xResult = prvGetObjectValue( xObject, &pucValue, &ulLength, &xIsPrivate );
+
+            if( ( CKR_OK == xResult ) && ( CK_TRUE == xIsPrivate ) )
+            {
+                /* As from C_GetAttributeValue(). */
+                xResult = CKR_ATTRIBUTE_SENSITIVE;
+            }
+
+            if( CKR_OK == xResult )
+            {
+                *ppucValue = pucValue;
+                *pulValueLen = ulLength;
+            }
+
+            /* Does nothing to a mapped value, which stays readable. */
+            prvGetObjectValueCleanup( pucValue, ulLength );
+        }
+    #endif
+
+    return xResult;
+}
+
+/**
+ * @brief Get the time spent in PKCS#11 operations.
+ */
+CK_RV PKCS11_GetOperationTimings( PKCS11OperationTimings_t * pxTimings )
+{
+    CK_RV xResult = CKR_OK;
+
+    if( NULL == pxTimings )
+    {
+        xResult = CKR_ARGUMENTS_BAD;
+    }
+    else
+    {
+        #if ( pkcs11configENABLE_OPERATION_TIMING == 1 )
+            taskENTER_CRITICAL();
+            {
+                *pxTimings = xOperationTimings;
+            }
+            taskEXIT_CRITICAL();
+        #else
+            memset( pxTimings, 0, sizeof( PKCS11OperationTimings_t ) );
+        #endif
+    }
+
     return xResult;
 }
 
@@ -1380,13 +2345,13 @@ CK_DEFINE_FUNCTION( CK_RV, C_VerifyInit )( CK_SESSION_HANDLE xSession,
 
     if( xResult == CKR_OK )
     {
-        xResult = PKCS11_PAL_GetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
+        xResult = prvGetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
     }
 
     if( ( xResult == CKR_OK ) && ( xIsPrivate != CK_FALSE ) )
     {
         xResult = CKR_KEY_TYPE_INCONSISTENT;
-        PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
+        prvGetObjectValueCleanup( keyData, ulKeyDataLength );
     }
 
     if( xResult == CKR_OK )
@@ -1417,7 +2382,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_VerifyInit )( CK_SESSION_HANDLE xSession,
             xResult = CKR_CANT_LOCK;
         }
 
-        PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
+        prvGetObjectValueCleanup( keyData, ulKeyDataLength );
     }
 
     return xResult;
@@ -1435,6 +2400,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_Verify )( CK_SESSION_HANDLE xSession,
 {
     CK_RV xResult = CKR_OK;
     P11SessionPtr_t pxSessionObj;
+    pkcs11TIMING_START();
 
     /*
      * Check parameters.
@@ -1475,6 +2441,8 @@ CK_DEFINE_FUNCTION( CK_RV, C_Verify )( CK_SESSION_HANDLE xSession,
     }
 
     /* Return the signature verification result. */
+    pkcs11TIMING_RECORD( xVerify, pdTRUE );
+
     return xResult;
 }
 
@@ -1551,7 +2519,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_GenerateKeyPair )( CK_SESSION_HANDLE xSession,
 
     if( xResult > 0 )
     {
-        *pxPrivateKey = PKCS11_PAL_SaveObject( &pxPrivateTemplate->xLabel, pucDerFile + pkcs11KEY_GEN_MAX_DER_SIZE - xResult, xResult );
+        *pxPrivateKey = prvSaveObject( &pxPrivateTemplate->xLabel, pucDerFile + pkcs11KEY_GEN_MAX_DER_SIZE - xResult, xResult );
         /* FIXME: This is a hack.*/
         *pxPublicKey = *pxPrivateKey + 1;
         xResult = CKR_OK;
@@ -1580,22 +2548,27 @@ CK_DEFINE_FUNCTION( CK_RV, C_GenerateRandom )( CK_SESSION_HANDLE xSession,
                                                CK_ULONG ulRandomLen )
 {
     CK_RV xResult = CKR_OK;
-
-    /* Avoid warnings about unused parameters. */
-    ( void ) xSession;
+    P11SessionPtr_t pxSession = prvSessionPointerFromHandle( xSession );
+    pkcs11TIMING_START();
 
     if( ( NULL == pucRandomData ) ||
         ( ulRandomLen == 0 ) )
     {
         xResult = CKR_ARGUMENTS_BAD;
     }
+    else if( CK_TRUE == prvRandomPoolTake( pucRandomData, ulRandomLen ) )
+    {
+        /* Served from the bytes generated ahead. */
+    }
     else
     {
-        if( 0 != mbedtls_ctr_drbg_random( &xP11Context.xMbedDrbgCtx, pucRandomData, ulRandomLen ) )
+        if( 0 != mbedtls_ctr_drbg_random( prvSessionDrbg( pxSession ), pucRandomData, ulRandomLen ) )
         {
             xResult = CKR_FUNCTION_FAILED;
         }
     }
 
+    pkcs11TIMING_RECORD( xGenerateRandom, pdTRUE );
+
     return xResult;
 }
@@ -36,6 +36,9 @@
 #include "aws_pkcs11.h"
 #include "aws_crypto.h"
 
+/* Standard includes. */
+#include <string.h>
+
 /* Internal context structure. */
 typedef struct SSOCKETContext
 {
@@ -50,6 +53,8 @@ typedef struct SSOCKETContext
     char ** ppcAlpnProtocols;
     uint32_t ulAlpnProtocolsCount;
     BaseType_t xConnectAttempted;
+    BaseType_t xDatagram;                    /* pdTRUE for a UDP socket. */
+    struct freertos_sockaddr xPeerAddress;   /* Where a UDP socket sends to and receives from. */
 } SSOCKETContext_t, * SSOCKETContextPtr_t;
 
 /*
@@ -64,8 +69,29 @@ static BaseType_t prvNetworkSend( void * pvContext,
                                   size_t xDataLength )
 {
     SSOCKETContextPtr_t pxContext = ( SSOCKETContextPtr_t ) pvContext; /*lint !e9087 cast used for portability. */
+    BaseType_t xReturn;
+
+    if( pdTRUE == pxContext->xDatagram )
+    {
+        /* FreeRTOS_sendto() returns 0 when the datagram could not be sent. */
+        xReturn = FreeRTOS_sendto( pxContext->xSocket,
+                                   pucData,
+                                   xDataLength,
+                                   pxContext->xSendFlags,
+                                   &pxContext->xPeerAddress,
+                                   sizeof( pxContext->xPeerAddress ) );
+
+        if( ( 0 == xReturn ) && ( 0U != xDataLength ) )
+        {
+            xReturn = SOCKETS_SOCKET_ERROR;
+        }
+    }
+    else
+    {
+        xReturn = FreeRTOS_send( pxContext->xSocket, pucData, xDataLength, pxContext->xSendFlags );
+    }
 
-    return FreeRTOS_send( pxContext->xSocket, pucData, xDataLength, pxContext->xSendFlags );
+    return xReturn;
 }
 /*-----------------------------------------------------------*/
 
@@ -77,8 +103,37 @@ static BaseType_t prvNetworkRecv( void * pvContext,
                                   size_t xReceiveLength )
 {
     SSOCKETContextPtr_t pxContext = ( SSOCKETContextPtr_t ) pvContext; /*lint !e9087 cast used for portability. */
+    struct freertos_sockaddr xSourceAddress;
+    socklen_t xSourceAddressLength = sizeof( xSourceAddress );
+    BaseType_t xReturn;
 
-    return FreeRTOS_recv( pxContext->xSocket, pucReceiveBuffer, xReceiveLength, pxContext->xRecvFlags );
+    if( pdTRUE == pxContext->xDatagram )
+    {
+        /* Drop the datagrams of other hosts, as a connected socket would. A
+         * timeout is reported as 0 bytes, the same as for TCP. */
+        do
+        {
+            xReturn = FreeRTOS_recvfrom( pxContext->xSocket,
+                                         pucReceiveBuffer,
+                                         xReceiveLength,
+                                         pxContext->xRecvFlags,
+                                         &xSourceAddress,
+                                         &xSourceAddressLength );
+        } while( ( xReturn >= 0 ) &&
+                 ( ( xSourceAddress.sin_addr != pxContext->xPeerAddress.sin_addr ) ||
+                   ( xSourceAddress.sin_port != pxContext->xPeerAddress.sin_port ) ) );
+
+        if( -pdFREERTOS_ERRNO_EWOULDBLOCK == xReturn )
+        {
+            xReturn = 0;
+        }
+    }
+    else
+    {
+        xReturn = FreeRTOS_recv( pxContext->xSocket, pucReceiveBuffer, xReceiveLength, pxContext->xRecvFlags );
+    }
+
+    return xReturn;
 }
 /*-----------------------------------------------------------*/
 
@@ -164,7 +219,18 @@ int32_t SOCKETS_Connect( Socket_t xSocket,
         xTempAddress.sin_family = pxAddress->ucSocketDomain;
         xTempAddress.sin_len = ( uint8_t ) sizeof( xTempAddress );
         xTempAddress.sin_port = pxAddress->usPort;
-        lStatus = FreeRTOS_connect( pxContext->xSocket, &xTempAddress, xAddressLength );
+
+        if( pdTRUE == pxContext->xDatagram )
+        {
+            /* UDP has no connection: bind to a free port and remember the
+             * peer. */
+            pxContext->xPeerAddress = xTempAddress;
+            lStatus = FreeRTOS_bind( pxContext->xSocket, NULL, 0 );
+        }
+        else
+        {
+            lStatus = FreeRTOS_connect( pxContext->xSocket, &xTempAddress, xAddressLength );
+        }
 
         /* Negotiate TLS if requested. */
         if( ( SOCKETS_ERROR_NONE == lStatus ) && ( pdTRUE == pxContext->xRequireTLS ) )
@@ -175,6 +241,7 @@ int32_t SOCKETS_Connect( Socket_t xSocket,
             xTLSParams.ulServerCertificateLength = pxContext->ulServerCertificateLength;
             xTLSParams.ppcAlpnProtocols = ( const char ** ) pxContext->ppcAlpnProtocols;
             xTLSParams.ulAlpnProtocolsCount = pxContext->ulAlpnProtocolsCount;
+            xTLSParams.xDatagram = pxContext->xDatagram;
             xTLSParams.pvCallerContext = pxContext;
             xTLSParams.pxNetworkRecv = prvNetworkRecv;
             xTLSParams.pxNetworkSend = prvNetworkSend;
@@ -239,6 +306,80 @@ int32_t SOCKETS_Recv( Socket_t xSocket,
 }
 /*-----------------------------------------------------------*/
 
+int32_t SOCKETS_RecvZeroCopy( Socket_t xSocket,
+                              uint8_t ** ppucData,
+                              size_t xMaxLength )
+{
+    int32_t lStatus = SOCKETS_SOCKET_ERROR;
+    SSOCKETContextPtr_t pxContext = ( SSOCKETContextPtr_t ) xSocket; /*lint !e9087 cast used for portability. */
+
+    if( ( xSocket != SOCKETS_INVALID_SOCKET ) &&
+        ( ppucData != NULL ) &&
+        ( pdTRUE == pxContext->xRequireTLS ) )
+    {
+        /* Lend the decrypted data from the record buffer of the TLS pipe. */
+        pxContext->xRecvFlags = 0;
+        lStatus = TLS_RecvZeroCopy( pxContext->pvTLSContext, ppucData, xMaxLength );
+    }
+    else if( ( xSocket != SOCKETS_INVALID_SOCKET ) &&
+             ( ppucData != NULL ) &&
+             ( pdFALSE == pxContext->xDatagram ) )
+    {
+        /* With FREERTOS_ZERO_COPY, FreeRTOS_recv() returns a pointer into
+         * the RX stream of the socket and the number of contiguous bytes
+         * available there. Nothing is removed from the stream yet. */
+        lStatus = FreeRTOS_recv( pxContext->xSocket,
+                                 ( void * ) ppucData,
+                                 xMaxLength,
+                                 pxContext->xRecvFlags | FREERTOS_ZERO_COPY );
+
+        if( lStatus > ( int32_t ) xMaxLength )
+        {
+            lStatus = ( int32_t ) xMaxLength;
+        }
+    }
+    else
+    {
+        lStatus = SOCKETS_EINVAL;
+    }
+
+    return lStatus;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_ReleaseZeroCopy( Socket_t xSocket,
+                                 size_t xLength )
+{
+    int32_t lStatus = SOCKETS_ERROR_NONE;
+    SSOCKETContextPtr_t pxContext = ( SSOCKETContextPtr_t ) xSocket; /*lint !e9087 cast used for portability. */
+
+    if( ( xSocket != SOCKETS_INVALID_SOCKET ) &&
+        ( pdTRUE == pxContext->xRequireTLS ) )
+    {
+        TLS_ReleaseZeroCopy( pxContext->pvTLSContext, xLength );
+    }
+    else if( ( xSocket != SOCKETS_INVALID_SOCKET ) &&
+             ( pdFALSE == pxContext->xDatagram ) )
+    {
+        /* Receiving into a NULL buffer only advances the tail of the RX
+         * stream, which releases the data lent by SOCKETS_RecvZeroCopy(). */
+        if( xLength > 0 )
+        {
+            if( FreeRTOS_recv( pxContext->xSocket, NULL, xLength, 0 ) < 0 )
+            {
+                lStatus = SOCKETS_SOCKET_ERROR;
+            }
+        }
+    }
+    else
+    {
+        lStatus = SOCKETS_EINVAL;
+    }
+
+    return lStatus;
+}
+/*-----------------------------------------------------------*/
+
 int32_t SOCKETS_Send( Socket_t xSocket,
                       const void * pvBuffer,
                       size_t xDataLength,
@@ -272,6 +413,245 @@ int32_t SOCKETS_Send( Socket_t xSocket,
 }
 /*-----------------------------------------------------------*/
 
+int32_t SOCKETS_SendV( Socket_t xSocket,
+                       const SocketsIOVector_t * pxIOVectors,
+                       size_t xIOVectorCount,
+                       uint32_t ulFlags )
+{
+    int32_t lStatus = SOCKETS_SOCKET_ERROR;
+    SSOCKETContextPtr_t pxContext = ( SSOCKETContextPtr_t ) xSocket; /*lint !e9087 cast used for portability. */
+    TLSIOVector_t xTLSIOVectors[ socketsconfigMAX_SENDV_VECTORS ];
+    uint8_t * pucTxHead;
+    BaseType_t xTxSpace = 0;
+    size_t xTotalLength = 0;
+    size_t xSent = 0;
+    size_t x;
+
+    if( ( xSocket != SOCKETS_INVALID_SOCKET ) &&
+        ( pxIOVectors != NULL ) &&
+        ( xIOVectorCount <= ( size_t ) socketsconfigMAX_SENDV_VECTORS ) )
+    {
+        pxContext->xSendFlags = ( BaseType_t ) ulFlags;
+
+        for( x = 0; x < xIOVectorCount; x++ )
+        {
+            xTotalLength += pxIOVectors[ x ].xDataLength;
+        }
+
+        if( pdTRUE == pxContext->xRequireTLS )
+        {
+            /* Let the TLS layer gather the buffers into records. */
+            for( x = 0; x < xIOVectorCount; x++ )
+            {
+                xTLSIOVectors[ x ].pucMsg = ( const unsigned char * ) pxIOVectors[ x ].pvBuffer;
+                xTLSIOVectors[ x ].xMsgLength = pxIOVectors[ x ].xDataLength;
+            }
+
+            lStatus = TLS_SendV( pxContext->pvTLSContext, xTLSIOVectors, xIOVectorCount );
+        }
+        else if( pdTRUE == pxContext->xDatagram )
+        {
+            /* Gather the buffers into one datagram, in a network buffer that
+             * FreeRTOS_sendto() passes on without copying. */
+            if( xTotalLength > ( size_t ) ( ipconfigNETWORK_MTU - ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER ) ) )
+            {
+                pucTxHead = NULL;
+                lStatus = SOCKETS_EINVAL;
+            }
+            else
+            {
+                pucTxHead = ( uint8_t * ) FreeRTOS_GetUDPPayloadBuffer( xTotalLength,
+                                                                        ( ( pxContext->xSendFlags & FREERTOS_MSG_DONTWAIT ) != 0 ) ? 0 : portMAX_DELAY );
+                lStatus = SOCKETS_ENOMEM;
+            }
+
+            if( pucTxHead != NULL )
+            {
+                for( x = 0; x < xIOVectorCount; x++ )
+                {
+                    memcpy( &pucTxHead[ xSent ], pxIOVectors[ x ].pvBuffer, pxIOVectors[ x ].xDataLength );
+                    xSent += pxIOVectors[ x ].xDataLength;
+                }
+
+                lStatus = FreeRTOS_sendto( pxContext->xSocket,
+                                           pucTxHead,
+                                           xTotalLength,
+                                           pxContext->xSendFlags | FREERTOS_ZERO_COPY,
+                                           &pxContext->xPeerAddress,
+                                           sizeof( pxContext->xPeerAddress ) );
+
+                if( lStatus == 0 )
+                {
+                    /* The buffer is still ours when it was not sent. */
+                    FreeRTOS_ReleaseUDPPayloadBuffer( pucTxHead );
+                    lStatus = SOCKETS_SOCKET_ERROR;
+                }
+            }
+        }
+        else
+        {
+            pucTxHead = FreeRTOS_get_tx_head( pxContext->xSocket, &xTxSpace );
+
+            if( ( pucTxHead != NULL ) && ( ( size_t ) xTxSpace >= xTotalLength ) )
+            {
+                /* All the data fits in the TX stream without wrapping, so copy
+                 * it in directly and hand it to the IP task with one call. */
+                for( x = 0; x < xIOVectorCount; x++ )
+                {
+                    memcpy( &pucTxHead[ xSent ], pxIOVectors[ x ].pvBuffer, pxIOVectors[ x ].xDataLength );
+                    xSent += pxIOVectors[ x ].xDataLength;
+                }
+
+                lStatus = FreeRTOS_send( pxContext->xSocket, NULL, xTotalLength, pxContext->xSendFlags );
+            }
+            else
+            {
+                /* Send the buffers one after the other. */
+                lStatus = 0;
+
+                for( x = 0; x < xIOVectorCount; x++ )
+                {
+                    lStatus = prvNetworkSend( pxContext, pxIOVectors[ x ].pvBuffer, pxIOVectors[ x ].xDataLength );
+
+                    if( lStatus > 0 )
+                    {
+                        xSent += ( size_t ) lStatus;
+                    }
+
+                    if( ( size_t ) lStatus != pxIOVectors[ x ].xDataLength )
+                    {
+                        break;
+                    }
+                }
+
+                /* Report the data that was queued before any error. */
+                if( ( lStatus >= 0 ) || ( xSent > 0 ) )
+                {
+                    lStatus = ( int32_t ) xSent;
+                }
+            }
+        }
+    }
+    else
+    {
+        lStatus = SOCKETS_EINVAL;
+    }
+
+    return lStatus;
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+
+    int32_t SOCKETS_Poll( const Socket_t * pxSockets,
+                          uint32_t * pulEvents,
+                          size_t xSocketCount,
+                          TickType_t xTimeout )
+    {
+        int32_t lStatus = 0;
+        SSOCKETContextPtr_t pxContext;
+        SocketSet_t xSocketSet = NULL;
+        EventBits_t xSelectBits;
+        uint32_t ulReady;
+        size_t x;
+
+        if( ( pxSockets == NULL ) || ( pulEvents == NULL ) || ( xSocketCount == 0 ) )
+        {
+            lStatus = SOCKETS_EINVAL;
+        }
+
+        for( x = 0; ( x < xSocketCount ) && ( lStatus == 0 ); x++ )
+        {
+            if( ( pxSockets[ x ] == SOCKETS_INVALID_SOCKET ) || ( pxSockets[ x ] == NULL ) )
+            {
+                lStatus = SOCKETS_EINVAL;
+            }
+        }
+
+        if( lStatus == 0 )
+        {
+            xSocketSet = FreeRTOS_CreateSocketSet();
+
+            if( xSocketSet == NULL )
+            {
+                lStatus = SOCKETS_ENOMEM;
+            }
+        }
+
+        if( lStatus == 0 )
+        {
+            for( x = 0; x < xSocketCount; x++ )
+            {
+                pxContext = ( SSOCKETContextPtr_t ) pxSockets[ x ]; /*lint !e9087 cast used for portability. */
+                xSelectBits = eSELECT_EXCEPT;
+
+                if( ( pulEvents[ x ] & SOCKETS_POLLIN ) != 0U )
+                {
+                    /* Data left over in the TLS record buffer will not show up
+                     * in the RX stream, so do not block if there is any. */
+                    if( ( pdTRUE == pxContext->xRequireTLS ) &&
+                        ( TLS_GetBytesAvailable( pxContext->pvTLSContext ) > 0U ) )
+                    {
+                        xTimeout = 0;
+                    }
+
+                    xSelectBits |= eSELECT_READ;
+                }
+
+                if( ( pulEvents[ x ] & SOCKETS_POLLOUT ) != 0U )
+                {
+                    xSelectBits |= eSELECT_WRITE;
+                }
+
+                FreeRTOS_FD_SET( pxContext->xSocket, xSocketSet, xSelectBits );
+            }
+
+            ( void ) FreeRTOS_select( xSocketSet, xTimeout );
+
+            for( x = 0; x < xSocketCount; x++ )
+            {
+                pxContext = ( SSOCKETContextPtr_t ) pxSockets[ x ]; /*lint !e9087 cast used for portability. */
+                xSelectBits = FreeRTOS_FD_ISSET( pxContext->xSocket, xSocketSet );
+                ulReady = 0;
+
+                if( ( ( pulEvents[ x ] & SOCKETS_POLLIN ) != 0U ) &&
+                    ( ( ( xSelectBits & eSELECT_READ ) != 0 ) ||
+                      ( ( pdTRUE == pxContext->xRequireTLS ) &&
+                        ( TLS_GetBytesAvailable( pxContext->pvTLSContext ) > 0U ) ) ) )
+                {
+                    ulReady |= SOCKETS_POLLIN;
+                }
+
+                if( ( ( pulEvents[ x ] & SOCKETS_POLLOUT ) != 0U ) &&
+                    ( ( xSelectBits & eSELECT_WRITE ) != 0 ) )
+                {
+                    ulReady |= SOCKETS_POLLOUT;
+                }
+
+                if( ( xSelectBits & eSELECT_EXCEPT ) != 0 )
+                {
+                    ulReady |= SOCKETS_POLLERR;
+                }
+
+                /* A socket can only be in one set, take it out again. */
+                FreeRTOS_FD_CLR( pxContext->xSocket, xSocketSet, eSELECT_ALL );
+                pulEvents[ x ] = ulReady;
+
+                if( ulReady != 0U )
+                {
+                    lStatus++;
+                }
+            }
+
+            FreeRTOS_DeleteSocketSet( xSocketSet );
+        }
+
+        return lStatus;
+    }
+
+#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+/*-----------------------------------------------------------*/
+
 int32_t SOCKETS_SetSockOpt( Socket_t xSocket,
                             int32_t lLevel,
                             int32_t lOptionName,
@@ -490,8 +870,8 @@ Socket_t SOCKETS_Socket( int32_t lDomain,
 
     /* Ensure that only supported values are supplied. */
     configASSERT( lDomain == SOCKETS_AF_INET );
-    configASSERT( lType == SOCKETS_SOCK_STREAM );
-    configASSERT( lProtocol == SOCKETS_IPPROTO_TCP );
+    configASSERT( ( ( lType == SOCKETS_SOCK_STREAM ) && ( lProtocol == SOCKETS_IPPROTO_TCP ) ) ||
+                  ( ( lType == SOCKETS_SOCK_DGRAM ) && ( lProtocol == SOCKETS_IPPROTO_UDP ) ) );
 
     /* Create the wrapped socket. */
     xSocket = FreeRTOS_socket( lDomain, lType, lProtocol );
@@ -509,6 +889,7 @@ Socket_t SOCKETS_Socket( int32_t lDomain,
         {
             memset( pxContext, 0, sizeof( SSOCKETContext_t ) );
             pxContext->xSocket = xSocket;
+            pxContext->xDatagram = ( lType == SOCKETS_SOCK_DGRAM ) ? pdTRUE : pdFALSE;
         }
     }
     else
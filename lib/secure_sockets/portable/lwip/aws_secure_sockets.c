@@ -43,6 +43,7 @@
 #include "FreeRTOSConfig.h"
 
 #include "task.h"
+#include "semphr.h"
 
 #include <stdbool.h>
 
@@ -52,26 +53,39 @@
 #define SS_STATUS_SECURED       (2)
 
 /*
- * secure socket context.
+ * How long, in milliseconds, the shared receive task blocks in lwip_select
+ * before it rebuilds its descriptor set. lwIP offers no way to interrupt a
+ * pending select, so this bounds how long a newly registered socket may wait
+ * for its first callback. The task blocks indefinitely while no socket has
+ * a callback registered.
  */
-typedef enum E_AWS_SOCkET_RX_STATE
-{
-    SST_RX_IDLE,
-    SST_RX_READY,
-    SST_RX_CLOSING,
-    SST_RX_CLOSED,
-} T_AWS_SOCKET_RX_STATE;
+#ifndef socketsconfigLWIP_RX_SELECT_PERIOD_MS
+    #define socketsconfigLWIP_RX_SELECT_PERIOD_MS    ( 100 )
+#endif
+
+/*
+ * Stack depth and priority of the shared receive task. The registered
+ * callbacks run in its context.
+ */
+#ifndef socketsconfigLWIP_RX_TASK_STACK_SIZE
+    #define socketsconfigLWIP_RX_TASK_STACK_SIZE     ( 512 )
+#endif
+
+#ifndef socketsconfigLWIP_RX_TASK_PRIORITY
+    #define socketsconfigLWIP_RX_TASK_PRIORITY       ( 1 )
+#endif
 
+/*
+ * secure socket context.
+ */
 typedef struct _ss_ctx_t
 {
     int     ip_socket;
 
-    int     state;
     unsigned int    status;
     int     send_flag;
     int     recv_flag;
 
-    TaskHandle_t    rx_handle;
     void            (*rx_callback)( Socket_t pxSocket );
 
     bool    enforce_tls;
@@ -95,6 +109,15 @@ typedef struct _ss_ctx_t
 //static int8_t sockets_allocated = SUPPORTED_DESCRIPTORS;
 static int8_t sockets_allocated = socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS;
 
+/*
+ * Sockets with a receive callback, serviced by a single select task. The
+ * mutex guards the table and is held while callbacks are dispatched, so a
+ * socket removed from the table will not be called back afterwards.
+ */
+static ss_ctx_t *           rx_sockets[ socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS ];
+static SemaphoreHandle_t    rx_mutex  = NULL;
+static TaskHandle_t         rx_handle = NULL;
+
 
 /*-----------------------------------------------------------*/
 
@@ -184,46 +207,79 @@ static BaseType_t prvNetworkRecv( void * pvContext,
 
 static void vTaskRxSelect( void * param )
 {
-    ss_ctx_t *  ctx = ( ss_ctx_t * )param;
-    int         s   = ctx->ip_socket;
+    ss_ctx_t *      ctx;
+    int             max_fd;
+    int             i;
 
-    fd_set      read_fds;
-    fd_set      write_fds;
-    fd_set      err_fds;
+    fd_set          read_fds;
+    fd_set          err_fds;
+    struct timeval  tv;
 
-    FD_ZERO (&read_fds);
-    FD_ZERO (&write_fds);
-    FD_ZERO (&err_fds);
-
-    FD_SET  (s, &read_fds);
-    FD_SET  (s, &err_fds);
+    ( void ) param;
 
-    ctx->state = SST_RX_READY;
     while( 1 )
     {
-        if (ctx->state == SST_RX_CLOSING)
+        FD_ZERO (&read_fds);
+        FD_ZERO (&err_fds);
+        max_fd = -1;
+
+        /* Rebuild the descriptor set, the table may have changed since the
+         * last pass. */
+        xSemaphoreTakeRecursive( rx_mutex, portMAX_DELAY );
+
+        for( i = 0; i < socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS; i++ )
         {
-            ctx->state = SST_RX_CLOSED;
-            vTaskDelete( NULL );
+            ctx = rx_sockets[ i ];
+
+            if( ctx != NULL )
+            {
+                FD_SET  (ctx->ip_socket, &read_fds);
+                FD_SET  (ctx->ip_socket, &err_fds);
+
+                if( ctx->ip_socket > max_fd )
+                {
+                    max_fd = ctx->ip_socket;
+                }
+            }
         }
-        if( lwip_select( s + 1, &read_fds, &write_fds, &err_fds, NULL ) == -1 )
+
+        xSemaphoreGiveRecursive( rx_mutex );
+
+        if( max_fd < 0 )
         {
-            //TaskHandle_t rx_handle = ctx->rx_handle;
+            /* Nothing to watch, sleep until a callback is registered. */
+            ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+            continue;
+        }
 
-            //ctx->rx_handle   = NULL;
-            //ctx->rx_callback = NULL;
+        tv.tv_sec  = socketsconfigLWIP_RX_SELECT_PERIOD_MS / 1000;
+        tv.tv_usec = ( socketsconfigLWIP_RX_SELECT_PERIOD_MS % 1000 ) * 1000;
 
-            //vTaskDelete( rx_handle );
-            vTaskDelete( NULL );
-            return;
+        if( lwip_select( max_fd + 1, &read_fds, NULL, &err_fds, &tv ) == -1 )
+        {
+            /* A watched socket was closed under the select, back off rather
+             * than spin until the next pass drops it. */
+            vTaskDelay( pdMS_TO_TICKS( socketsconfigLWIP_RX_SELECT_PERIOD_MS ) );
+            continue;
         }
 
-        if( FD_ISSET( s, &read_fds ) )
+        xSemaphoreTakeRecursive( rx_mutex, portMAX_DELAY );
+
+        for( i = 0; i < socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS; i++ )
         {
-            configASSERT( ctx->rx_callback );
-            ctx->rx_callback( ( Socket_t )ctx );
-            //vTaskDelay( 10 ); // delay a little bit to yield time for RX
+            /* Re-read the slot each time, a callback may close its socket. */
+            ctx = rx_sockets[ i ];
+
+            if( ( ctx != NULL ) &&
+                ( FD_ISSET( ctx->ip_socket, &read_fds ) ||
+                  FD_ISSET( ctx->ip_socket, &err_fds ) ) )
+            {
+                configASSERT( ctx->rx_callback );
+                ctx->rx_callback( ( Socket_t )ctx );
+            }
         }
+
+        xSemaphoreGiveRecursive( rx_mutex );
     }
 }
 
@@ -232,28 +288,81 @@ static void vTaskRxSelect( void * param )
 static void prvRxSelectSet( ss_ctx_t * ctx, const void * pvOptionValue )
 {
     BaseType_t xReturned;
-    TaskHandle_t xHandle = NULL;
+    int i;
+    int free_slot = -1;
+
+    configASSERT( rx_mutex != NULL );
+
+    xSemaphoreTakeRecursive( rx_mutex, portMAX_DELAY );
 
     ctx->rx_callback = (void (*)(Socket_t))pvOptionValue;
 
-    xReturned = xTaskCreate( vTaskRxSelect,   /* pvTaskCode */
-                               "rxs",         /* pcName */
-                               512,           /* usStackDepth */
-                               ctx,           /* pvParameters */
-                               1,             /* uxPriority */
-                               &xHandle );    /* pxCreatedTask */
+    for( i = 0; i < socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS; i++ )
+    {
+        if( rx_sockets[ i ] == ctx )
+        {
+            /* Already registered, only the callback changes. */
+            break;
+        }
+
+        if( ( rx_sockets[ i ] == NULL ) && ( free_slot < 0 ) )
+        {
+            free_slot = i;
+        }
+    }
+
+    if( i == socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS )
+    {
+        /* The table has one slot per socket that can be allocated. */
+        configASSERT( free_slot >= 0 );
+        rx_sockets[ free_slot ] = ctx;
+    }
 
-    configASSERT( xReturned == pdPASS );
-    configASSERT( xHandle != NULL );
+    if( rx_handle == NULL )
+    {
+        xReturned = xTaskCreate( vTaskRxSelect,   /* pvTaskCode */
+                                   "rxs",         /* pcName */
+                                   socketsconfigLWIP_RX_TASK_STACK_SIZE,  /* usStackDepth */
+                                   NULL,          /* pvParameters */
+                                   socketsconfigLWIP_RX_TASK_PRIORITY,    /* uxPriority */
+                                   &rx_handle );  /* pxCreatedTask */
+
+        configASSERT( xReturned == pdPASS );
+        configASSERT( rx_handle != NULL );
+    }
+    else
+    {
+        xTaskNotifyGive( rx_handle );
+    }
 
-    ctx->rx_handle   = xHandle;
+    xSemaphoreGiveRecursive( rx_mutex );
 }
 
 /*-----------------------------------------------------------*/
 
 static void prvRxSelectClear( ss_ctx_t * ctx )
 {
-    // TODO
+    int i;
+
+    if( rx_mutex == NULL )
+    {
+        return;
+    }
+
+    /* Taking the mutex also waits out a callback in progress. */
+    xSemaphoreTakeRecursive( rx_mutex, portMAX_DELAY );
+
+    for( i = 0; i < socketsconfigDEFAULT_MAX_NUM_SECURE_SOCKETS; i++ )
+    {
+        if( rx_sockets[ i ] == ctx )
+        {
+            rx_sockets[ i ] = NULL;
+        }
+    }
+
+    ctx->rx_callback = NULL;
+
+    xSemaphoreGiveRecursive( rx_mutex );
 }
 
 /*-----------------------------------------------------------*/
@@ -478,6 +587,114 @@ int32_t SOCKETS_Send( Socket_t xSocket,
 
 /*-----------------------------------------------------------*/
 
+int32_t SOCKETS_Poll( const Socket_t * pxSockets,
+                      uint32_t * pulEvents,
+                      size_t xSocketCount,
+                      TickType_t xTimeout )
+{
+    ss_ctx_t *      ctx;
+    int             max_fd = -1;
+    int32_t         ready  = 0;
+    uint32_t        revents;
+    size_t          i;
+
+    fd_set          read_fds;
+    fd_set          write_fds;
+    fd_set          err_fds;
+    struct timeval  tv;
+
+    if( NULL == pxSockets || NULL == pulEvents || 0 == xSocketCount )
+    {
+        return SOCKETS_EINVAL;
+    }
+
+    FD_ZERO (&read_fds);
+    FD_ZERO (&write_fds);
+    FD_ZERO (&err_fds);
+
+    for( i = 0; i < xSocketCount; i++ )
+    {
+        if( SOCKETS_INVALID_SOCKET == pxSockets[ i ] )
+        {
+            return SOCKETS_EINVAL;
+        }
+
+        ctx = ( ss_ctx_t * )pxSockets[ i ];
+
+        if( 0 > ctx->ip_socket )
+        {
+            return SOCKETS_SOCKET_ERROR;
+        }
+
+        if( pulEvents[ i ] & SOCKETS_POLLIN )
+        {
+            /* Data left over in the TLS record buffer is invisible to
+             * lwip_select, so do not block if there is any. */
+            if( ctx->enforce_tls && TLS_GetBytesAvailable( ctx->tls_ctx ) > 0 )
+            {
+                xTimeout = 0;
+            }
+
+            FD_SET  (ctx->ip_socket, &read_fds);
+        }
+
+        if( pulEvents[ i ] & SOCKETS_POLLOUT )
+        {
+            FD_SET  (ctx->ip_socket, &write_fds);
+        }
+
+        FD_SET  (ctx->ip_socket, &err_fds);
+
+        if( ctx->ip_socket > max_fd )
+        {
+            max_fd = ctx->ip_socket;
+        }
+    }
+
+    tv.tv_sec  = TICK_TO_S ( xTimeout );
+    tv.tv_usec = TICK_TO_US( xTimeout % configTICK_RATE_HZ );
+
+    if( lwip_select( max_fd + 1, &read_fds, &write_fds, &err_fds,
+                     xTimeout == portMAX_DELAY ? NULL : &tv ) == -1 )
+    {
+        return SOCKETS_SOCKET_ERROR;
+    }
+
+    for( i = 0; i < xSocketCount; i++ )
+    {
+        ctx     = ( ss_ctx_t * )pxSockets[ i ];
+        revents = 0;
+
+        if( ( pulEvents[ i ] & SOCKETS_POLLIN ) &&
+            ( FD_ISSET( ctx->ip_socket, &read_fds ) ||
+              ( ctx->enforce_tls && TLS_GetBytesAvailable( ctx->tls_ctx ) > 0 ) ) )
+        {
+            revents |= SOCKETS_POLLIN;
+        }
+
+        if( ( pulEvents[ i ] & SOCKETS_POLLOUT ) && FD_ISSET( ctx->ip_socket, &write_fds ) )
+        {
+            revents |= SOCKETS_POLLOUT;
+        }
+
+        if( FD_ISSET( ctx->ip_socket, &err_fds ) )
+        {
+            revents |= SOCKETS_POLLERR;
+        }
+
+        pulEvents[ i ] = revents;
+
+        if( revents )
+        {
+            ready++;
+        }
+    }
+
+    return ready;
+}
+
+/*-----------------------------------------------------------*/
+
 int32_t SOCKETS_Shutdown( Socket_t xSocket,
                           uint32_t ulHow )
 {
@@ -543,13 +760,7 @@ int32_t SOCKETS_Close( Socket_t xSocket )
 
     if( 0 <= ctx->ip_socket )
     {
-        int   cnt = 0;
-        ctx->state = SST_RX_CLOSING;
-        while ((ctx->state != SST_RX_CLOSED) && (cnt<30))
-        {
-            cnt++;
-            vTaskDelay( 10 );
-        }
+        prvRxSelectClear( ctx );
         lwip_close( ctx->ip_socket );
 
         sockets_allocated ++;
@@ -805,6 +1016,17 @@ uint32_t SOCKETS_GetHostByName( const char * pcHostName )
 BaseType_t SOCKETS_Init( void )
 {
     BaseType_t xResult = pdPASS;
+
+    if( rx_mutex == NULL )
+    {
+        rx_mutex = xSemaphoreCreateRecursiveMutex();
+
+        if( rx_mutex == NULL )
+        {
+            xResult = pdFAIL;
+        }
+    }
+
     return xResult;
 }
 
@@ -43,6 +43,10 @@
 #include "aws_shadow_config_defaults.h"
 #include "aws_shadow.h"
 #include "aws_shadow_json.h"
+#include "aws_json_pull.h"
+#if ( shadowconfigENABLE_CBOR == 1 )
+    #include "aws_shadow_cbor.h"
+#endif
 
 /**
  * @brief Format strings for the AWS IoT Shadow MQTT topics.
@@ -71,6 +75,7 @@
 #define shadowTOPIC_DELETE              shadowTOPIC_PREFIX shadowTOPIC_OPERATION_DELETE
 #define shadowTOPIC_DELETE_ACCEPTED     shadowTOPIC_DELETE shadowTOPIC_SUFFIX_ACCEPTED
 #define shadowTOPIC_DELETE_REJECTED     shadowTOPIC_DELETE shadowTOPIC_SUFFIX_REJECTED
+#define shadowTOPIC_WILDCARD            "$aws/things/+/shadow/#" /* Subscribed to instead of per-Thing topics with shadowconfigSUBSCRIBE_WILDCARD. */
 /** @} */
 
 /** Maximum length of a Shadow MQTT topic. 128 is currently the longest Thing
@@ -79,6 +84,42 @@
 #define configMAX_THING_NAME_LENGTH    128
 #define shadowTOPIC_BUFFER_LENGTH      ( configMAX_THING_NAME_LENGTH + ( int16_t ) sizeof( shadowTOPIC_UPDATE_DOCUMENTS ) )
 
+/**
+ * @brief The parts of a topic around the Thing Name, and the topics of user
+ * notify callbacks after the second part.
+ */
+#define shadowTOPIC_THINGS              "$aws/things/"
+#define shadowTOPIC_SHADOW              "/shadow/"
+#define shadowTOPIC_TAIL_DOCUMENTS      shadowTOPIC_OPERATION_UPDATE "/documents"
+#define shadowTOPIC_TAIL_DELTA          shadowTOPIC_OPERATION_UPDATE "/delta"
+#define shadowTOPIC_TAIL_DELETED        shadowTOPIC_OPERATION_DELETE shadowTOPIC_SUFFIX_ACCEPTED
+
+/**
+ * @brief Number of slots of the Thing Name index of the callback catalog.
+ * Twice the number of entries keeps the probe sequences short.
+ */
+#define shadowCALLBACK_INDEX_LENGTH     ( 2 * shadowconfigMAX_THINGS_WITH_CALLBACKS )
+
+/**
+ * @brief An unused slot of the Thing Name index; used slots hold the catalog
+ * index plus one.
+ */
+#define shadowCALLBACK_INDEX_EMPTY      ( ( uint16_t ) 0 )
+
+/**
+ * @brief pdTRUE if operations and callbacks subscribe to the topics of each
+ * Thing, pdFALSE if the wildcard subscription made on connect covers them.
+ */
+#if ( shadowconfigSUBSCRIBE_WILDCARD == 1 )
+    #define shadowSUBSCRIBE_PER_THING    pdFALSE
+#else
+    #define shadowSUBSCRIBE_PER_THING    pdTRUE
+#endif
+
+#if ( shadowconfigMAX_THINGS_WITH_CALLBACKS >= 32768 )
+    #error "shadowconfigMAX_THINGS_WITH_CALLBACKS must be less than 32768."
+#endif
+
 #if shadowconfigENABLE_DEBUG_LOGS == 1
     #define Shadow_debug_printf( X )    configPRINTF( X )
 #else
@@ -101,14 +142,55 @@ typedef enum ShadowOperationName
 } ShadowOperationName_t;
 
 /**
- * @brief Data on the Shadow operation currently in progress.
+ * @brief Number of accepted/rejected subscription pairs tracked by each
+ * Shadow Client.
+ */
+#define shadowSUBSCRIPTION_TABLE_LENGTH    ( shadowconfigMAX_PENDING_OPERATIONS + shadowconfigSUBSCRIPTION_CACHE_SIZE )
+
+/**
+ * @brief An accepted/rejected subscription pair of one operation on one Thing.
+ *
+ * Guarded by the Shadow Client's xSubscriptionMutex.
+ */
+typedef struct ShadowSubscription
+{
+    BaseType_t xInUse;
+    BaseType_t xLost;               /* Lost on disconnect while still referenced. */
+    UBaseType_t uxReferenceCount;   /* Number of pending operations relying on the subscription. */
+    uint32_t ulLastUsed;            /* ulSubscriptionClock when last referenced; the oldest is evicted first. */
+    ShadowOperationName_t xOperationName;
+
+    /* The operation topic; the subscribed topics add the accepted and
+     * rejected suffixes to it. */
+    uint8_t ucTopicBuffer[ shadowTOPIC_BUFFER_LENGTH ];
+} ShadowSubscription_t;
+
+/**
+ * @brief A Shadow operation waiting for its accepted or rejected response.
  *
+ * Members other than xCallbackSemaphore are guarded by the Shadow Client's
+ * xOperationDataMutex.
  */
-typedef struct ShadowOperationData
+typedef struct ShadowPendingOperation
 {
+    BaseType_t xInUse;
+    BaseType_t xSubscribed; /* The accepted/rejected subscription for this operation is in place. */
+    BaseType_t xCompleted;  /* A response was delivered, or the operation stopped waiting for one. */
     ShadowOperationName_t xOperationInProgress;
     ShadowOperationParams_t * pxOperationParams;
-} ShadowOperationData_t;
+    ShadowSubscription_t * pxSubscription; /* Only accessed by the task making the operation. */
+
+    /* The callback functions pass data to the API calls by setting xOperationResult. */
+    ShadowReturnCode_t xOperationResult;
+
+    /* Given by the callbacks once xOperationResult is set. */
+    SemaphoreHandle_t xCallbackSemaphore;
+    StaticSemaphore_t xCallbackSemaphoreBuffer;
+
+    /* The topic the operation was published to; responses are matched to the
+     * operation by this prefix. */
+    uint8_t ucTopicBuffer[ shadowTOPIC_BUFFER_LENGTH ];
+} ShadowPendingOperation_t;
 
 /**
  * @brief Data on the timeout by which a function needs to complete.
@@ -150,12 +232,82 @@ typedef struct ShadowOperationCallParams
  * The callback catalog is the member of the Shadow Client that stores the
  * callback functions associated with Thing Names.
  */
+#if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+
+    #if ( ( shadowconfigMAX_DELTA_HANDLERS >= 255 ) || ( shadowconfigDELTA_TRIE_NODES >= 255 ) )
+        #error "shadowconfigMAX_DELTA_HANDLERS and shadowconfigDELTA_TRIE_NODES must be less than 255."
+    #endif
+
+/**
+ * @brief Marks the end of a list of trie nodes, and nodes at which no
+ * handler path ends.
+ */
+    #define shadowDELTA_TRIE_NONE       ( ( uint8_t ) 0xFF )
+
+/**
+ * @brief Handler paths are relative to this part of the delta document.
+ */
+    #define shadowDELTA_STATE_PREFIX    "state."
+
+/**
+ * @brief A node of the delta dispatch trie: one key or array index of one or
+ * more handler paths.
+ */
+    typedef struct ShadowDeltaTrieNode
+    {
+        const char * pcSegment; /* Points into the registered path. */
+        uint8_t ucSegmentLength;
+        uint8_t ucFirstChild;
+        uint8_t ucNextSibling;
+        uint8_t ucHandler; /* Index of the handler whose path ends here, or shadowDELTA_TRIE_NONE. */
+    } ShadowDeltaTrieNode_t;
+
+#endif /* shadowconfigMAX_DELTA_HANDLERS */
+
 typedef struct CallbackCatalogEntry
 {
     ShadowCallbackParams_t xCallbackInfo;
     BaseType_t xInUse;
+    uint32_t ulThingNameHash;    /* Hash of pcThingName, for the Thing Name index. */
+    uint16_t usThingNameLength;
+
+    #if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+        /* Per-property delta handlers; the trie is guarded by the Shadow
+         * Client's xOperationDataMutex. */
+        const ShadowDeltaHandlerParams_t * pxDeltaHandlers;
+        uint32_t ulDeltaHandlerCount; /* 0 if no handlers are registered. */
+        uint8_t ucDeltaTrieRoot;      /* First node of the top-level keys. */
+        ShadowDeltaTrieNode_t xDeltaTrie[ shadowconfigDELTA_TRIE_NODES ];
+    #endif
 } CallbackCatalogEntry_t;
 
+#if ( shadowconfigREPORTED_FIELDS > 0 )
+
+/**
+ * @brief The "reported" document of an update made by SHADOW_ReportedSync.
+ * The changed fields and the client token follow.
+ */
+    #define shadowREPORTED_DOCUMENT_START    "{\"state\":{\"reported\":{"
+    #define shadowREPORTED_DOCUMENT_TOKEN    "}},\"clientToken\":\"reported-"
+    #define shadowREPORTED_DOCUMENT_END      "\"}"
+
+/**
+ * @brief A field of the reported state kept by the Shadow Client.
+ *
+ * Guarded by the Shadow Client's xReportedMutex.
+ */
+    typedef struct ShadowReportedField
+    {
+        BaseType_t xInUse;
+        uint16_t usDocumentOffset; /* Where the value was written in ucReportedDocument, 0 if not sent. */
+        uint16_t usDocumentLength;
+        char cKey[ shadowconfigREPORTED_KEY_LENGTH + 1 ];
+        char cValue[ shadowconfigREPORTED_VALUE_LENGTH + 1 ];             /* Latest value set by the application. */
+        char cAcknowledgedValue[ shadowconfigREPORTED_VALUE_LENGTH + 1 ]; /* Value last accepted by the Shadow service, empty if none. */
+    } ShadowReportedField_t;
+
+#endif /* shadowconfigREPORTED_FIELDS */
+
 /**
  * @brief The Shadow Client.
  *
@@ -165,37 +317,59 @@ typedef struct ShadowClient
     /* MQTT Client handle. */
     MQTTAgentHandle_t xMQTTClient;
 
+    #if ( shadowconfigENABLE_CBOR == 1 )
+        ShadowPayloadFormat_t xPayloadFormat; /* Encoding of the documents. */
+    #endif
+
     /* Shadow Client flags. */
     BaseType_t xInUse;
-    BaseType_t xUpdateSubscribed;
-    BaseType_t xGetSubscribed;
-    BaseType_t xDeleteSubscribed;
+    volatile BaseType_t xSubscriptionsLost; /* Set on disconnect; xSubscriptions is updated by the next operation. */
 
     /* Synchronization mechanisms. */
-    SemaphoreHandle_t xOperationDataMutex; /* Allows only one in-progress operation. */
-    SemaphoreHandle_t xOperationMutex;     /* Allows only one in-progress operation. */
-    SemaphoreHandle_t xCallbackSemaphore;  /* Communication with callbacks. */
-    StaticSemaphore_t xOperationMutexBuffer;
-    StaticSemaphore_t xCallbackSemaphoreBuffer;
+    SemaphoreHandle_t xOperationDataMutex;     /* Guards xPendingOperations. */
+    SemaphoreHandle_t xSubscriptionMutex;      /* Allows only one operation to change subscriptions. */
+    SemaphoreHandle_t xPendingOperationSlots;  /* Counts the free entries of xPendingOperations. */
+    StaticSemaphore_t xSubscriptionMutexBuffer;
+    StaticSemaphore_t xPendingOperationSlotsBuffer;
     StaticSemaphore_t xOperationDataMutexBuffer;
 
-    /* Data shared between blocking function and MQTT callback. */
-    ShadowOperationData_t * pxOperationData;
+    /* Data shared between blocking functions and MQTT callback. */
+    ShadowPendingOperation_t xPendingOperations[ shadowconfigMAX_PENDING_OPERATIONS ];
 
-    /* The callback functions pass data to the API calls by setting xOperationResult.
-     * This value is volatile to ensure that the compiler knows the value can change
-     * without anything happening in the API call. */
-    volatile ShadowReturnCode_t xOperationResult;
+    /* Subscriptions in place, whether used by pending operations or kept
+     * for later ones. */
+    ShadowSubscription_t xSubscriptions[ shadowSUBSCRIPTION_TABLE_LENGTH ];
+    uint32_t ulSubscriptionClock;
 
-    /* Callback catalog stores Thing Names and registered callbacks. */
+    /* Callback catalog stores Thing Names and registered callbacks. It is
+     * found by Thing Name through an open-addressing hash index, so that
+     * dispatching a message does not scan the catalog. Both are modified in
+     * critical sections. */
     CallbackCatalogEntry_t xCallbackCatalog[ shadowconfigMAX_THINGS_WITH_CALLBACKS ];
+    uint16_t usCallbackIndex[ shadowCALLBACK_INDEX_LENGTH ];
 
-    /* Stores the topic of the in-progress operation. Some of the Shadow API's
-     * static functions depend on this buffer remaining the same throughout a
-     * Shadow API operation. Therefore, only prvShadowOperation (and the static
-     * functions called by prvShadowOperation) should modify the contents of this
-     * buffer. */
+    /* Stores the topic being subscribed to or unsubscribed from. Only the
+     * holder of xSubscriptionMutex may modify the contents of this buffer. */
     uint8_t ucTopicBuffer[ shadowTOPIC_BUFFER_LENGTH ];
+
+    #if ( shadowconfigREPORTED_FIELDS > 0 )
+        /* Reported state set by SHADOW_ReportedSet and sent by SHADOW_ReportedSync. */
+        SemaphoreHandle_t xReportedMutex;
+        StaticSemaphore_t xReportedMutexBuffer;
+        ShadowReportedField_t xReportedFields[ shadowconfigREPORTED_FIELDS ];
+        BaseType_t xReportedChanged;     /* A field differs from its acknowledged value. */
+        TickType_t xReportedChangeTicks; /* When xReportedChanged was last set. */
+        uint32_t ulReportedToken;
+
+        /* The document of the update in progress. Only SHADOW_ReportedSync
+         * uses it. */
+        uint8_t ucReportedDocument[ shadowconfigREPORTED_DOCUMENT_LENGTH ];
+
+        #if ( shadowconfigENABLE_CBOR == 1 )
+            /* ucReportedDocument converted for a CBOR Shadow Client. */
+            uint8_t ucReportedCBOR[ shadowconfigREPORTED_DOCUMENT_LENGTH ];
+        #endif
+    #endif
 } ShadowClient_t;
 
 /**
@@ -206,12 +380,32 @@ static BaseType_t prvGetFreeShadowClient( void );
 
 /**
  * @brief Returns the slot index of callback catalog for matching thing name, if thing name not found
- * returns the next available unused slot index in catalog.
+ * returns the next available unused slot index in catalog, or -1 if the catalog is full.
  *
  */
-static BaseType_t prvGetCallbackCatalogEntry( CallbackCatalogEntry_t * const xCallbackCatalog,
+static BaseType_t prvGetCallbackCatalogEntry( ShadowClient_t * const pxShadowClient,
                                               const char * const pcThingName );
 
+/**
+ * @brief Hashes a Thing Name with FNV-1a.
+ */
+static uint32_t prvHashThingName( const char * const pcThingName,
+                                  size_t xThingNameLength );
+
+/**
+ * @brief Returns the index of the callback catalog entry of a Thing Name, or -1.
+ * The name need not be NUL-terminated.
+ */
+static BaseType_t prvFindCallbackCatalogEntry( const ShadowClient_t * const pxShadowClient,
+                                               const char * const pcThingName,
+                                               size_t xThingNameLength );
+
+/**
+ * @brief Clears a callback catalog entry and removes it from the Thing Name index.
+ */
+static void prvFreeCallbackCatalogEntry( ShadowClient_t * const pxShadowClient,
+                                         CallbackCatalogEntry_t * const pxCallbackCatalogEntry );
+
 
 /**
  * @brief Wrapper function for MQTT API calls; converts MQTTAgentReturnCode_t to
@@ -247,15 +441,35 @@ static ShadowReturnCode_t prvShadowSubscribeToAcceptedRejected( BaseType_t
                                                                 TimeOutData_t * const pxTimeOutData );
 
 /**
- * @brief Unsubscribe to an accepted and rejected topic.
+ * @brief Unsubscribe from the accepted and rejected topics of a subscription.
  *
  */
 static ShadowReturnCode_t prvShadowUnsubscribeFromAcceptedRejected( BaseType_t xShadowClientID,
-                                                                    const char * const pcThingName,
-                                                                    const char * const pcAcceptedTopic,
-                                                                    const char * const pcRejectedTopic,
+                                                                    const ShadowSubscription_t * const pxSubscription,
                                                                     TimeOutData_t * const pxTimeOutData );
 
+/**
+ * @brief Finds or makes the accepted/rejected subscription of an operation
+ * and references it from the operation.
+ *
+ * Must be called with xSubscriptionMutex held. If every entry is in use, the
+ * least recently used subscription that no pending operation relies on is
+ * unsubscribed to make room.
+ */
+static ShadowReturnCode_t prvAcquireSubscription( const ShadowOperationCallParams_t * const pxParams,
+                                                  ShadowPendingOperation_t * const pxOperation,
+                                                  TimeOutData_t * const pxTimeOutData );
+
+/**
+ * @brief Drops an operation's reference to its subscription.
+ *
+ * Must be called with xSubscriptionMutex held. The last operation to drop
+ * its reference unsubscribes, unless it is keeping subscriptions.
+ */
+static void prvReleaseSubscription( const ShadowOperationCallParams_t * const pxParams,
+                                    ShadowPendingOperation_t * const pxOperation,
+                                    TimeOutData_t * const pxTimeOutData );
+
 /**
  * @brief Universal MQTT callback; parses topics for Thing Name and operation matches.
  *
@@ -280,12 +494,33 @@ static const CallbackCatalogEntry_t * prvMatchCallbackTopic( const ShadowClient_
                                                              uint16_t usTopicLength,
                                                              ShadowOperationName_t * const pxOperationName );
 
+/**
+ * @brief Finds the pending operation a received publish is the response to.
+ *
+ * Must be called with xOperationDataMutex held. Concurrent updates of the same
+ * Thing are told apart by clientToken; concurrent gets or deletes of the same
+ * Thing receive identical responses, so the oldest waiting one is chosen.
+ */
+static ShadowPendingOperation_t * prvMatchPendingOperation( ShadowClient_t * const pxShadowClient,
+                                                            const MQTTPublishData_t * const pxPublishData,
+                                                            ShadowReturnCode_t * const pxResult );
+
+/**
+ * @brief Compares the client tokens of two documents in the encoding of the
+ * Shadow Client.
+ */
+static BaseType_t prvDocClientTokenMatch( const ShadowClient_t * const pxShadowClient,
+                                          const char * const pcDoc1,
+                                          uint32_t ulDoc1Length,
+                                          const char * const pcDoc2,
+                                          uint32_t ulDoc2Length );
+
 /**
  * @brief Update callback for Shadow Operations.
  */
 static void prvShadowUpdateCallback( BaseType_t xShadowClientID,
+                                     ShadowPendingOperation_t * const pxOperation,
                                      ShadowReturnCode_t xResult,
-                                     const ShadowOperationParams_t * const pxParams,
                                      const char * const pcData,
                                      uint32_t ulDataLength );
 
@@ -293,8 +528,8 @@ static void prvShadowUpdateCallback( BaseType_t xShadowClientID,
  * @brief Get callback for shadow operations
  */
 static void prvShadowGetCallback( BaseType_t xShadowClientID,
+                                  ShadowPendingOperation_t * const pxOperation,
                                   ShadowReturnCode_t xResult,
-                                  ShadowOperationParams_t * const pxParams,
                                   const char * const pcData,
                                   uint32_t ulDataLength,
                                   MQTTBufferHandle_t xBuffer );
@@ -303,6 +538,7 @@ static void prvShadowGetCallback( BaseType_t xShadowClientID,
  * @briefDelete callback for shadow operations
  */
 static void prvShadowDeleteCallback( BaseType_t xShadowClientID,
+                                     ShadowPendingOperation_t * const pxOperation,
                                      ShadowReturnCode_t xResult,
                                      const char * const pcData,
                                      uint32_t ulDataLength );
@@ -320,12 +556,76 @@ static ShadowReturnCode_t prvGetErrorCodeAndMessage( const char * const pcData,
  */
 static ShadowReturnCode_t prvShadowOperation( ShadowOperationCallParams_t * pxParams );
 
-static void prvSetSubscribedFlag( ShadowClient_t * const pxShadowClient,
-                                  ShadowOperationName_t xOperationName,
-                                  BaseType_t xValue );
+#if ( shadowconfigREPORTED_FIELDS > 0 )
+
+/**
+ * @brief Appends to a document being built, if it fits.
+ *
+ * @return pdTRUE if the string was appended, pdFALSE if the document is full.
+ */
+    static BaseType_t prvReportedAppend( uint8_t * const pucDocument,
+                                         size_t * const pxDocumentLength,
+                                         const char * const pcString,
+                                         size_t xStringLength );
+
+/**
+ * @brief Builds the update document of the reported fields that differ from
+ * their acknowledged values, as many as fit.
+ *
+ * Must be called with xReportedMutex held.
+ *
+ * @return The document length, or 0 if no field changed.
+ */
+    static size_t prvReportedBuildDocument( ShadowClient_t * const pxShadowClient );
+
+#endif /* shadowconfigREPORTED_FIELDS */
 
-static uint8_t prvGetSubscribedFlag( const ShadowClient_t * const pxShadowClient,
-                                     ShadowOperationName_t xOperationName );
+#if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+
+/**
+ * @brief Finds the next key or array index of a path, starting at *pxIndex.
+ *
+ * Keys are separated by '.', and array indices are written "[n]". *pxIndex is
+ * moved to the end of the segment.
+ *
+ * @return The length of the segment, 0 if the path is empty there.
+ */
+    static size_t prvNextPathSegment( const char * const pcPath,
+                                      size_t xPathLength,
+                                      size_t * const pxIndex,
+                                      const char ** const ppcSegment );
+
+/**
+ * @brief Builds the dispatch trie of a callback catalog entry from handler paths.
+ *
+ * Must be called with xOperationDataMutex held.
+ *
+ * @return pdPASS if the trie was built, pdFAIL if a path is empty, repeated, or
+ * the trie needs more than shadowconfigDELTA_TRIE_NODES nodes.
+ */
+    static BaseType_t prvCompileDeltaTrie( CallbackCatalogEntry_t * const pxCallbackCatalogEntry,
+                                           const ShadowDeltaHandlerParams_t * const pxHandlers,
+                                           uint32_t ulHandlerCount );
+
+/**
+ * @brief Returns the index of the handler registered for a path relative to
+ * "state", or shadowDELTA_TRIE_NONE.
+ */
+    static uint8_t prvFindDeltaHandler( const CallbackCatalogEntry_t * const pxCallbackCatalogEntry,
+                                        const char * const pcPath,
+                                        size_t xPathLength );
+
+/**
+ * @brief Parses a delta document once and calls the handlers of the
+ * properties in it.
+ */
+    static void prvDispatchDelta( void * pvUserData,
+                                  ShadowClient_t * const pxShadowClient,
+                                  const CallbackCatalogEntry_t * const pxCallbackCatalogEntry,
+                                  const char * const pcDeltaDocument,
+                                  uint32_t ulDocumentLength );
+
+#endif /* shadowconfigMAX_DELTA_HANDLERS */
 
 /**
  * @brief Memory allocated to store Shadow Clients.
@@ -364,52 +664,162 @@ static BaseType_t prvGetFreeShadowClient( void )
 }
 /*-----------------------------------------------------------*/
 
-static BaseType_t prvGetCallbackCatalogEntry( CallbackCatalogEntry_t * const xCallbackCatalog,
-                                              const char * const pcThingName ) /*_RB_ I find the name of this function confusing compared to what it is actually doing. */
-{                                                                              /* Todo: sub manager. */
+static uint32_t prvHashThingName( const char * const pcThingName,
+                                  size_t xThingNameLength )
+{
+    uint32_t ulHash = 2166136261UL;
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < xThingNameLength; xIndex++ )
+    {
+        ulHash ^= ( uint32_t ) ( uint8_t ) pcThingName[ xIndex ];
+        ulHash *= 16777619UL;
+    }
+
+    return ulHash;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFindCallbackCatalogEntry( const ShadowClient_t * const pxShadowClient,
+                                               const char * const pcThingName,
+                                               size_t xThingNameLength )
+{
+    const CallbackCatalogEntry_t * pxCallbackCatalogEntry;
+    const uint32_t ulHash = prvHashThingName( pcThingName, xThingNameLength );
+    uint32_t ulSlot = ulHash % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
+    BaseType_t xReturn = -1;
+    uint16_t usEntry;
+
+    /* Linear probing; the index is never full, so an empty slot ends the search. */
+    for( usEntry = pxShadowClient->usCallbackIndex[ ulSlot ];
+         usEntry != shadowCALLBACK_INDEX_EMPTY;
+         usEntry = pxShadowClient->usCallbackIndex[ ulSlot ] )
+    {
+        pxCallbackCatalogEntry = &( pxShadowClient->xCallbackCatalog[ usEntry - ( uint16_t ) 1 ] );
+
+        if( ( pxCallbackCatalogEntry->ulThingNameHash == ulHash ) &&
+            ( ( size_t ) pxCallbackCatalogEntry->usThingNameLength == xThingNameLength ) &&
+            ( strncmp( pxCallbackCatalogEntry->xCallbackInfo.pcThingName,
+                       pcThingName,
+                       xThingNameLength ) == 0 ) )
+        {
+            xReturn = ( BaseType_t ) usEntry - 1;
+            break;
+        }
+
+        ulSlot = ( ulSlot + ( uint32_t ) 1 ) % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvGetCallbackCatalogEntry( ShadowClient_t * const pxShadowClient,
+                                              const char * const pcThingName )
+{
     CallbackCatalogEntry_t * pxCallbackCatalogEntry;
-    BaseType_t xIterator, xReturn = -1, xThingNameFound = pdFALSE;
-    size_t xThingNameLengh;
-    size_t xThingName_cb_Lengh;
+    BaseType_t xIterator, xReturn;
+    size_t xThingNameLength;
+    uint32_t ulSlot;
+
+    xThingNameLength = strlen( pcThingName );
 
     taskENTER_CRITICAL();
     {
-        for( xIterator = 0; xIterator < shadowconfigMAX_THINGS_WITH_CALLBACKS; xIterator++ )
-        {
-            pxCallbackCatalogEntry = &( xCallbackCatalog[ xIterator ] );
+        xReturn = prvFindCallbackCatalogEntry( pxShadowClient, pcThingName, xThingNameLength );
 
-            if( pxCallbackCatalogEntry->xInUse == pdFALSE )
+        if( xReturn < 0 )
+        {
+            /* Registering is rare, so a free entry is searched for. */
+            for( xIterator = 0; xIterator < shadowconfigMAX_THINGS_WITH_CALLBACKS; xIterator++ )
             {
-                xReturn = xIterator;
+                if( pxShadowClient->xCallbackCatalog[ xIterator ].xInUse == pdFALSE )
+                {
+                    xReturn = xIterator;
+                    break;
+                }
             }
-            else
+
+            if( xReturn >= 0 )
             {
-                xThingNameLengh = strlen( pxCallbackCatalogEntry->xCallbackInfo.pcThingName );
-                xThingName_cb_Lengh = strlen( pcThingName );
+                pxCallbackCatalogEntry = &( pxShadowClient->xCallbackCatalog[ xReturn ] );
+                pxCallbackCatalogEntry->xInUse = pdTRUE;
+                pxCallbackCatalogEntry->xCallbackInfo.pcThingName = pcThingName;
+                pxCallbackCatalogEntry->ulThingNameHash = prvHashThingName( pcThingName, xThingNameLength );
+                pxCallbackCatalogEntry->usThingNameLength = ( uint16_t ) xThingNameLength;
+
+                ulSlot = pxCallbackCatalogEntry->ulThingNameHash % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
 
-                if( xThingNameLengh == xThingName_cb_Lengh )
+                while( pxShadowClient->usCallbackIndex[ ulSlot ] != shadowCALLBACK_INDEX_EMPTY )
                 {
-                    if( strncmp( pcThingName,
-                                 pxCallbackCatalogEntry->xCallbackInfo.pcThingName,
-                                 xThingNameLengh ) == 0 )
-                    {
-                        xReturn = xIterator;
-                        xThingNameFound = pdTRUE;
-                        break;
-                    }
+                    ulSlot = ( ulSlot + ( uint32_t ) 1 ) % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
                 }
+
+                pxShadowClient->usCallbackIndex[ ulSlot ] = ( uint16_t ) ( xReturn + 1 );
             }
         }
     }
     taskEXIT_CRITICAL();
 
-    if( xThingNameFound == pdFALSE )
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvFreeCallbackCatalogEntry( ShadowClient_t * const pxShadowClient,
+                                         CallbackCatalogEntry_t * const pxCallbackCatalogEntry )
+{
+    const uint16_t usEntry = ( uint16_t ) ( ( pxCallbackCatalogEntry - pxShadowClient->xCallbackCatalog ) + 1 );
+    uint32_t ulSlot, ulNext, ulHome;
+
+    taskENTER_CRITICAL();
     {
-        xCallbackCatalog[ xReturn ].xInUse = pdTRUE;
-        xCallbackCatalog[ xReturn ].xCallbackInfo.pcThingName = pcThingName;
-    }
+        ulSlot = pxCallbackCatalogEntry->ulThingNameHash % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
 
-    return xReturn;
+        while( ( pxShadowClient->usCallbackIndex[ ulSlot ] != usEntry ) &&
+               ( pxShadowClient->usCallbackIndex[ ulSlot ] != shadowCALLBACK_INDEX_EMPTY ) )
+        {
+            ulSlot = ( ulSlot + ( uint32_t ) 1 ) % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
+        }
+
+        if( pxShadowClient->usCallbackIndex[ ulSlot ] == usEntry )
+        {
+            /* Move later entries of the probe sequence back into the hole, so
+             * that no tombstones are needed. */
+            ulNext = ulSlot;
+
+            for( ; ; )
+            {
+                ulNext = ( ulNext + ( uint32_t ) 1 ) % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
+
+                if( pxShadowClient->usCallbackIndex[ ulNext ] == shadowCALLBACK_INDEX_EMPTY )
+                {
+                    break;
+                }
+
+                ulHome = pxShadowClient->xCallbackCatalog[ pxShadowClient->usCallbackIndex[ ulNext ] - ( uint16_t ) 1 ].ulThingNameHash %
+                         ( uint32_t ) shadowCALLBACK_INDEX_LENGTH;
+
+                /* The entry can move if its home slot is not cyclically in
+                 * ( ulSlot, ulNext ]. */
+                if( ( ( ulNext + ( uint32_t ) shadowCALLBACK_INDEX_LENGTH - ulHome ) % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH ) >=
+                    ( ( ulNext + ( uint32_t ) shadowCALLBACK_INDEX_LENGTH - ulSlot ) % ( uint32_t ) shadowCALLBACK_INDEX_LENGTH ) )
+                {
+                    pxShadowClient->usCallbackIndex[ ulSlot ] = pxShadowClient->usCallbackIndex[ ulNext ];
+                    ulSlot = ulNext;
+                }
+            }
+
+            pxShadowClient->usCallbackIndex[ ulSlot ] = shadowCALLBACK_INDEX_EMPTY;
+        }
+
+        memset( pxCallbackCatalogEntry,
+                0,
+                sizeof( CallbackCatalogEntry_t ) );
+    }
+    taskEXIT_CRITICAL();
 }
 
 /*-----------------------------------------------------------*/
@@ -535,7 +945,8 @@ static ShadowReturnCode_t prvRegisterCallback( BaseType_t xShadowClientID,
                                     ( const char * ) pucTopicFormat, pcThingName );
     pxShadowClient = &( xShadowClients[ xShadowClientID ] );
 
-    if( *ppvOldCallback != NULL )
+    /* With the wildcard subscription, only the callback changes. */
+    if( ( *ppvOldCallback != NULL ) && ( shadowSUBSCRIBE_PER_THING == pdTRUE ) )
     {
         xUnsubscribeParams.usTopicLength = usTopicLength;
         xUnsubscribeParams.pucTopic = ucTopicString;
@@ -550,7 +961,7 @@ static ShadowReturnCode_t prvRegisterCallback( BaseType_t xShadowClientID,
     }
 
     /* Registering a new callback; subscribe to topic. */
-    if( *ppvNewCallback != NULL )
+    if( ( *ppvNewCallback != NULL ) && ( shadowSUBSCRIBE_PER_THING == pdTRUE ) )
     {
         xSubscribeParams.usTopicLength = usTopicLength;
         xSubscribeParams.pucTopic = ucTopicString;
@@ -664,31 +1075,40 @@ static ShadowReturnCode_t prvShadowSubscribeToAcceptedRejected( BaseType_t
 }
 
 /*-----------------------------------------------------------*/
-static ShadowReturnCode_t prvShadowUnsubscribeFromAcceptedRejected( BaseType_t
-                                                                    xShadowClientID,
-                                                                    const char * const pcThingName,
-                                                                    const char * const
-                                                                    pcAcceptedTopic,
-                                                                    const char * const pcRejectedTopic,
+static ShadowReturnCode_t prvShadowUnsubscribeFromAcceptedRejected( BaseType_t xShadowClientID,
+                                                                    const ShadowSubscription_t * const pxSubscription,
                                                                     TimeOutData_t * const pxTimeOutData )
 {
-    ShadowReturnCode_t xReturn = eShadowFailure;
+    ShadowReturnCode_t xReturn = eShadowSuccess;
     ShadowClient_t * pxShadowClient;
     MQTTAgentUnsubscribeParams_t xUnsubscribeParams;
     MQTTAgentReturnCode_t xMQTTReturn;
+    size_t xTopicLength;
 
     pxShadowClient = &( xShadowClients[ xShadowClientID ] );
+    xTopicLength = strlen( ( const char * ) pxSubscription->ucTopicBuffer );
+
+    /* The accepted and rejected suffixes have the same length. */
+    configASSERT( ( xTopicLength + sizeof( shadowTOPIC_SUFFIX_ACCEPTED ) ) <= ( size_t ) shadowTOPIC_BUFFER_LENGTH );
 
     /* MQTT unsubscribe parameters. */
+    memcpy( pxShadowClient->ucTopicBuffer, pxSubscription->ucTopicBuffer, xTopicLength );
     xUnsubscribeParams.pucTopic = pxShadowClient->ucTopicBuffer;
-
-    if( pcAcceptedTopic != NULL )
+    xUnsubscribeParams.usTopicLength = ( uint16_t ) ( xTopicLength + sizeof( shadowTOPIC_SUFFIX_ACCEPTED ) - ( size_t ) 1 );
+
+    /* If the Shadow client is subscribed to delete/accepted for this Thing for
+     * a user notify callback, do not unsubscribe from it; that would break
+     * callback notify. */
+    if( ( pxSubscription->xOperationName != eShadowOperationDelete ) ||
+        ( prvMatchCallbackTopic( pxShadowClient,
+                                 pxSubscription->ucTopicBuffer,
+                                 ( uint16_t ) xTopicLength,
+                                 NULL ) == NULL ) )
     {
         /* Fill the accepted topic. */
-        xUnsubscribeParams.usTopicLength = prvCreateTopic( ( char * ) pxShadowClient->ucTopicBuffer,
-                                                           shadowTOPIC_BUFFER_LENGTH,
-                                                           pcAcceptedTopic,
-                                                           pcThingName );
+        memcpy( &( pxShadowClient->ucTopicBuffer[ xTopicLength ] ),
+                shadowTOPIC_SUFFIX_ACCEPTED,
+                sizeof( shadowTOPIC_SUFFIX_ACCEPTED ) );
 
         xMQTTReturn = MQTT_AGENT_Unsubscribe( pxShadowClient->xMQTTClient,
                                               &xUnsubscribeParams,
@@ -699,18 +1119,17 @@ static ShadowReturnCode_t prvShadowUnsubscribeFromAcceptedRejected( BaseType_t
                                             "Unsubscribe from accepted topic" );
     }
 
-    if( pcRejectedTopic != NULL )
-    {
-        /* Fill the rejected topic. */
-        xUnsubscribeParams.usTopicLength = prvCreateTopic( ( char * ) pxShadowClient->ucTopicBuffer,
-                                                           shadowTOPIC_BUFFER_LENGTH,
-                                                           pcRejectedTopic,
-                                                           pcThingName );
+    /* Fill the rejected topic. */
+    memcpy( &( pxShadowClient->ucTopicBuffer[ xTopicLength ] ),
+            shadowTOPIC_SUFFIX_REJECTED,
+            sizeof( shadowTOPIC_SUFFIX_REJECTED ) );
 
-        xMQTTReturn = MQTT_AGENT_Unsubscribe( pxShadowClient->xMQTTClient,
-                                              &xUnsubscribeParams,
-                                              pxTimeOutData->xTicksRemaining );
+    xMQTTReturn = MQTT_AGENT_Unsubscribe( pxShadowClient->xMQTTClient,
+                                          &xUnsubscribeParams,
+                                          pxTimeOutData->xTicksRemaining );
 
+    if( xReturn == eShadowSuccess )
+    {
         xReturn = prvConvertMQTTReturnCode( xMQTTReturn,
                                             ( ShadowClientHandle_t ) xShadowClientID, /*lint !e923 Safe cast from pointer handle. */
                                             "Unsubscribe from rejected topic" );
@@ -720,106 +1139,255 @@ static ShadowReturnCode_t prvShadowUnsubscribeFromAcceptedRejected( BaseType_t
 }
 /*-----------------------------------------------------------*/
 
-static BaseType_t prvShadowMQTTCallback( void * pvUserData,
-                                         const MQTTAgentCallbackParams_t * const pxCallbackParams )
+static ShadowReturnCode_t prvAcquireSubscription( const ShadowOperationCallParams_t * const pxParams,
+                                                  ShadowPendingOperation_t * const pxOperation,
+                                                  TimeOutData_t * const pxTimeOutData )
 {
-    BaseType_t xOperationMatched = pdFALSE;
+    ShadowReturnCode_t xReturn = eShadowSuccess;
     ShadowClient_t * pxShadowClient;
-    const MQTTPublishData_t * pxPublishData;
-    ShadowOperationName_t xOperationName;
-    ShadowReturnCode_t xResult;
-    const CallbackCatalogEntry_t * pxCallbackCatalogEntry;
-    BaseType_t xReturn = pdFALSE;
-    BaseType_t xCompareLen;
-    BaseType_t xShadowClientID;
+    ShadowSubscription_t * pxSubscription;
+    ShadowSubscription_t * pxFound = NULL;
+    ShadowSubscription_t * pxUnused = NULL;
+    BaseType_t xIterator;
+    uint32_t ulClock;
 
+    pxShadowClient = &( xShadowClients[ pxParams->xShadowClientID ] );
 
-    xShadowClientID = *( ( BaseType_t * ) pvUserData ); /*lint !e9087 Safe cast from pointer handle. */
-    pxShadowClient = &( xShadowClients[ xShadowClientID ] );
-
-    if( pxCallbackParams->xMQTTEvent == eMQTTAgentPublish )
+    /* The Shadow Client assumes all subscriptions are lost on disconnect.
+     * Those still referenced are forgotten when they are released. */
+    if( pxShadowClient->xSubscriptionsLost == pdTRUE )
     {
-        pxPublishData = ( &( pxCallbackParams->u.xPublishData ) );
+        pxShadowClient->xSubscriptionsLost = pdFALSE;
 
-        /* If xOperationMutex is locked, the client is waiting on the acceptance
-         * or rejection of a publish. Publish results take priority over user notify
-         * callbacks. This also means that the client will not be notified of gets or
-         * deletes performed by itself in a user notify callback. However, the client
-         * will still be notified of updates performed by itself if it has registered
-         * a callback for /update/documents or update/delta. */
+        for( xIterator = 0; xIterator < shadowSUBSCRIPTION_TABLE_LENGTH; xIterator++ )
+        {
+            pxSubscription = &( pxShadowClient->xSubscriptions[ xIterator ] );
 
-        if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
-                            portMAX_DELAY ) == pdPASS )
+            if( pxSubscription->uxReferenceCount == ( UBaseType_t ) 0 )
+            {
+                pxSubscription->xInUse = pdFALSE;
+            }
+            else
+            {
+                pxSubscription->xLost = pdTRUE;
+            }
+        }
+    }
+
+    pxShadowClient->ulSubscriptionClock++;
+    ulClock = pxShadowClient->ulSubscriptionClock;
+
+    /* Look for this operation's subscription, and for a free entry or else
+     * the least recently used unreferenced one. */
+    for( xIterator = 0; xIterator < shadowSUBSCRIPTION_TABLE_LENGTH; xIterator++ )
+    {
+        pxSubscription = &( pxShadowClient->xSubscriptions[ xIterator ] );
+
+        if( pxSubscription->xInUse == pdFALSE )
         {
-            if( pxShadowClient->pxOperationData != NULL )
+            if( ( pxUnused == NULL ) || ( pxUnused->xInUse == pdTRUE ) )
             {
-                /* Verify Thing Name and operation by comparing the received topic with
-                 * the current operation's topic. */
+                pxUnused = pxSubscription;
+            }
+        }
+        else if( ( pxSubscription->xLost == pdFALSE ) &&
+                 ( strcmp( ( const char * ) pxSubscription->ucTopicBuffer,
+                           ( const char * ) pxOperation->ucTopicBuffer ) == 0 ) )
+        {
+            pxFound = pxSubscription;
+            break;
+        }
+        else if( pxSubscription->uxReferenceCount == ( UBaseType_t ) 0 )
+        {
+            if( ( pxUnused == NULL ) ||
+                ( ( pxUnused->xInUse == pdTRUE ) &&
+                  ( ( ulClock - pxSubscription->ulLastUsed ) > ( ulClock - pxUnused->ulLastUsed ) ) ) )
+            {
+                pxUnused = pxSubscription;
+            }
+        }
+        else
+        {
+            /* In use by a pending operation. */
+        }
+    }
 
-                xCompareLen = ( BaseType_t ) configMIN( ( BaseType_t ) strlen( ( const char * ) pxShadowClient->ucTopicBuffer ),
-                                                        ( BaseType_t ) pxPublishData->usTopicLength );
+    if( pxFound == NULL )
+    {
+        /* Each of the other pending operations references at most one
+         * entry, so one is always unreferenced. */
+        configASSERT( pxUnused != NULL );
 
-                if( strncmp( ( const char * ) pxPublishData->pucTopic,
-                             ( const char * ) pxShadowClient->ucTopicBuffer,
-                             ( size_t ) xCompareLen ) == 0 )
-                {
-                    /* Parse the in-progress operation and result. */
-                    xOperationName = ( pxShadowClient->pxOperationData )->xOperationInProgress;
-                    xResult = prvParseShadowOperationStatus( pxPublishData->pucTopic,
-                                                             pxPublishData->usTopicLength );
-
-                    /* Both an operation and result were identified, and both match
-                     * the operation this Shadow Client is waiting on; call the
-                     * operation-specific callback. */
-                    if( ( xResult != eShadowUnknown ) && ( xOperationName != eShadowOperationOther ) )
-                    {
-                        xOperationMatched = pdTRUE;
+        if( pxUnused->xInUse == pdTRUE )
+        {
+            Shadow_debug_printf( ( "[Shadow %d] Evicting subscription to %s.\r\n",
+                                   pxParams->xShadowClientID,
+                                   ( const char * ) pxUnused->ucTopicBuffer ) );
 
-                        switch( xOperationName )
-                        {
-                            case eShadowOperationUpdate:
-                                prvShadowUpdateCallback( xShadowClientID,
-                                                         xResult,
-                                                         ( pxShadowClient->pxOperationData )->pxOperationParams,
-                                                         ( const char * ) pxPublishData->pvData,
-                                                         pxPublishData->ulDataLength );
-                                break;
-
-                            case eShadowOperationGet:
-                                prvShadowGetCallback( xShadowClientID,
-                                                      xResult,
-                                                      ( pxShadowClient->pxOperationData )->pxOperationParams,
-                                                      ( const char * ) pxPublishData->pvData,
-                                                      pxPublishData->ulDataLength,
-                                                      pxPublishData->xBuffer );
-
-                                /* Only take an MQTT buffer if the Get operation succeeded. */
-                                if( xResult == eShadowSuccess )
-                                {
-                                    xReturn = pdTRUE;
-                                }
-
-                                break;
-
-                            case eShadowOperationDelete:
-                                prvShadowDeleteCallback( xShadowClientID,
-                                                         xResult,
-                                                         ( const char * ) pxPublishData->pvData,
-                                                         pxPublishData->ulDataLength );
-                                break;
-
-                            default:
-                                /* Should not fall here. */
-                                break;
-                        }
-                    }
-                }
+            if( shadowSUBSCRIBE_PER_THING == pdTRUE )
+            {
+                ( void ) prvShadowUnsubscribeFromAcceptedRejected( pxParams->xShadowClientID,
+                                                                   pxUnused,
+                                                                   pxTimeOutData );
             }
 
-            configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+            pxUnused->xInUse = pdFALSE;
         }
 
-        /* If the received topic doesn't match the current operation, it's
+        if( shadowSUBSCRIBE_PER_THING == pdTRUE )
+        {
+            xReturn = prvShadowSubscribeToAcceptedRejected( pxParams->xShadowClientID,
+                                                            ( pxParams->pxOperationParams )->pcThingName,
+                                                            pxParams->pcOperationAcceptedTopic,
+                                                            pxParams->pcOperationRejectedTopic,
+                                                            pxTimeOutData );
+        }
+
+        if( xReturn == eShadowSuccess )
+        {
+            pxFound = pxUnused;
+            pxFound->xInUse = pdTRUE;
+            pxFound->xLost = pdFALSE;
+            pxFound->uxReferenceCount = 0;
+            pxFound->xOperationName = pxParams->xOperationName;
+            memcpy( pxFound->ucTopicBuffer, pxOperation->ucTopicBuffer, shadowTOPIC_BUFFER_LENGTH );
+        }
+    }
+
+    if( pxFound != NULL )
+    {
+        pxFound->uxReferenceCount++;
+        pxFound->ulLastUsed = ulClock;
+    }
+
+    pxOperation->pxSubscription = pxFound;
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseSubscription( const ShadowOperationCallParams_t * const pxParams,
+                                    ShadowPendingOperation_t * const pxOperation,
+                                    TimeOutData_t * const pxTimeOutData )
+{
+    ShadowSubscription_t * const pxSubscription = pxOperation->pxSubscription;
+
+    if( pxSubscription != NULL )
+    {
+        pxSubscription->uxReferenceCount--;
+
+        if( pxSubscription->uxReferenceCount == ( UBaseType_t ) 0 )
+        {
+            if( pxSubscription->xLost == pdTRUE )
+            {
+                pxSubscription->xInUse = pdFALSE;
+            }
+            else if( ( pxParams->pxOperationParams )->ucKeepSubscriptions == ( uint8_t ) 0 )
+            {
+                if( shadowSUBSCRIBE_PER_THING == pdTRUE )
+                {
+                    ( void ) prvShadowUnsubscribeFromAcceptedRejected( pxParams->xShadowClientID,
+                                                                       pxSubscription,
+                                                                       pxTimeOutData );
+                }
+
+                pxSubscription->xInUse = pdFALSE;
+            }
+            else
+            {
+                /* Kept for later operations until evicted. */
+            }
+        }
+
+        pxOperation->pxSubscription = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvShadowMQTTCallback( void * pvUserData,
+                                         const MQTTAgentCallbackParams_t * const pxCallbackParams )
+{
+    BaseType_t xOperationMatched = pdFALSE;
+    ShadowClient_t * pxShadowClient;
+    const MQTTPublishData_t * pxPublishData;
+    ShadowOperationName_t xOperationName;
+    ShadowReturnCode_t xResult;
+    const CallbackCatalogEntry_t * pxCallbackCatalogEntry;
+    ShadowPendingOperation_t * pxOperation;
+    BaseType_t xReturn = pdFALSE;
+    BaseType_t xShadowClientID;
+
+
+    xShadowClientID = *( ( BaseType_t * ) pvUserData ); /*lint !e9087 Safe cast from pointer handle. */
+    pxShadowClient = &( xShadowClients[ xShadowClientID ] );
+
+    if( pxCallbackParams->xMQTTEvent == eMQTTAgentPublish )
+    {
+        pxPublishData = ( &( pxCallbackParams->u.xPublishData ) );
+
+        /* If an operation is pending, the client is waiting on the acceptance
+         * or rejection of a publish. Publish results take priority over user notify
+         * callbacks. This also means that the client will not be notified of gets or
+         * deletes performed by itself in a user notify callback. However, the client
+         * will still be notified of updates performed by itself if it has registered
+         * a callback for /update/documents or update/delta. */
+
+        if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
+                            portMAX_DELAY ) == pdPASS )
+        {
+            pxOperation = prvMatchPendingOperation( pxShadowClient,
+                                                    pxPublishData,
+                                                    &xResult );
+
+            if( pxOperation != NULL )
+            {
+                xOperationMatched = pdTRUE;
+
+                /* Call the operation-specific callback. */
+                switch( pxOperation->xOperationInProgress )
+                {
+                    case eShadowOperationUpdate:
+                        prvShadowUpdateCallback( xShadowClientID,
+                                                 pxOperation,
+                                                 xResult,
+                                                 ( const char * ) pxPublishData->pvData,
+                                                 pxPublishData->ulDataLength );
+                        break;
+
+                    case eShadowOperationGet:
+                        prvShadowGetCallback( xShadowClientID,
+                                              pxOperation,
+                                              xResult,
+                                              ( const char * ) pxPublishData->pvData,
+                                              pxPublishData->ulDataLength,
+                                              pxPublishData->xBuffer );
+
+                        /* Only take an MQTT buffer if the Get operation succeeded. */
+                        if( xResult == eShadowSuccess )
+                        {
+                            xReturn = pdTRUE;
+                        }
+
+                        break;
+
+                    case eShadowOperationDelete:
+                        prvShadowDeleteCallback( xShadowClientID,
+                                                 pxOperation,
+                                                 xResult,
+                                                 ( const char * ) pxPublishData->pvData,
+                                                 pxPublishData->ulDataLength );
+                        break;
+
+                    default:
+                        /* Should not fall here. */
+                        break;
+                }
+            }
+
+            configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+        }
+
+        /* If the received topic doesn't match the current operation, it's
          * still possible for it to match a registered callback. */
         if( xOperationMatched == pdFALSE )
         {
@@ -846,6 +1414,14 @@ static BaseType_t prvShadowMQTTCallback( void * pvUserData,
 
                     case eShadowOperationUpdateDelta:
 
+                        #if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+                            prvDispatchDelta( pvUserData,
+                                              pxShadowClient,
+                                              pxCallbackCatalogEntry,
+                                              ( const char * ) pxPublishData->pvData,
+                                              pxPublishData->ulDataLength );
+                        #endif
+
                         if( pxCallbackCatalogEntry->xCallbackInfo.xShadowDeltaCallback != NULL )
                         {
                             xReturn = pxCallbackCatalogEntry->xCallbackInfo.xShadowDeltaCallback( pvUserData,
@@ -882,9 +1458,9 @@ static BaseType_t prvShadowMQTTCallback( void * pvUserData,
             Shadow_debug_printf( ( "[Shadow %d] Warning: got an MQTT disconnect"
                                    " message.\r\n", xShadowClientID ) );
 
-            prvSetSubscribedFlag( pxShadowClient, eShadowOperationUpdate, 0 );
-            prvSetSubscribedFlag( pxShadowClient, eShadowOperationGet, 0 );
-            prvSetSubscribedFlag( pxShadowClient, eShadowOperationDelete, 0 );
+            /* The next operation forgets the lost subscriptions, so that
+             * operations subscribe again. */
+            pxShadowClient->xSubscriptionsLost = pdTRUE;
 
             /*_RB_ TODO below. */
             /* TODO: resubscribe to all callback topics. */
@@ -896,6 +1472,70 @@ static BaseType_t prvShadowMQTTCallback( void * pvUserData,
 
 /*-----------------------------------------------------------*/
 
+static ShadowPendingOperation_t * prvMatchPendingOperation( ShadowClient_t * const pxShadowClient,
+                                                            const MQTTPublishData_t * const pxPublishData,
+                                                            ShadowReturnCode_t * const pxResult )
+{
+    ShadowPendingOperation_t * pxReturn = NULL;
+    ShadowPendingOperation_t * pxOperation;
+    BaseType_t xIterator;
+    BaseType_t xCompareLen;
+
+    *pxResult = prvParseShadowOperationStatus( pxPublishData->pucTopic,
+                                               pxPublishData->usTopicLength );
+
+    if( *pxResult != eShadowUnknown )
+    {
+        for( xIterator = 0; xIterator < shadowconfigMAX_PENDING_OPERATIONS; xIterator++ )
+        {
+            pxOperation = &( pxShadowClient->xPendingOperations[ xIterator ] );
+
+            /* Only operations that were published and are still waiting can
+             * receive a response. */
+            if( ( pxOperation->xInUse == pdTRUE ) &&
+                ( pxOperation->xSubscribed == pdTRUE ) &&
+                ( pxOperation->xCompleted == pdFALSE ) )
+            {
+                /* Verify Thing Name and operation by comparing the received topic with
+                 * the operation's topic. */
+                xCompareLen = ( BaseType_t ) configMIN( ( BaseType_t ) strlen( ( const char * ) pxOperation->ucTopicBuffer ),
+                                                        ( BaseType_t ) pxPublishData->usTopicLength );
+
+                if( strncmp( ( const char * ) pxPublishData->pucTopic,
+                             ( const char * ) pxOperation->ucTopicBuffer,
+                             ( size_t ) xCompareLen ) == 0 )
+                {
+                    if( pxOperation->xOperationInProgress != eShadowOperationUpdate )
+                    {
+                        pxReturn = pxOperation;
+                    }
+                    else if( prvDocClientTokenMatch( pxShadowClient,
+                                                     pxOperation->pxOperationParams->pcData,
+                                                     pxOperation->pxOperationParams->ulDataLength,
+                                                     ( const char * ) pxPublishData->pvData,
+                                                     pxPublishData->ulDataLength ) == pdPASS )
+                    {
+                        pxReturn = pxOperation;
+                    }
+                    else
+                    {
+                        /* The response to another update of this Thing. */
+                    }
+
+                    if( pxReturn != NULL )
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return pxReturn;
+}
+
+/*-----------------------------------------------------------*/
+
 static ShadowReturnCode_t prvParseShadowOperationStatus( const uint8_t * const
                                                          pucTopic,
                                                          uint16_t usTopicLength )
@@ -937,143 +1577,104 @@ static const CallbackCatalogEntry_t * prvMatchCallbackTopic( const ShadowClient_
                                                              ShadowOperationName_t * const pxOperationName )
 {
     const CallbackCatalogEntry_t * pxReturn = NULL;
-    BaseType_t xIterator, xTopicFound = pdFALSE;
-    uint8_t ucTopicBuffer[ shadowTOPIC_BUFFER_LENGTH ];
-    size_t xCompareLength;
-
-    for( xIterator = 0; xIterator < shadowconfigMAX_THINGS_WITH_CALLBACKS; xIterator++ )
+    const char * const pcTopic = ( const char * ) pucTopic;
+    const size_t xThingsLength = sizeof( shadowTOPIC_THINGS ) - ( size_t ) 1;
+    const size_t xShadowLength = sizeof( shadowTOPIC_SHADOW ) - ( size_t ) 1;
+    const char * pcThingName = NULL;
+    const char * pcTail;
+    size_t xThingNameLength = 0, xTailLength;
+    BaseType_t xCallbackCatalogIndex = -1;
+
+    /* The Thing Name is taken from the topic and looked up, rather than a
+     * topic being made for every Thing in the catalog. */
+    if( ( ( size_t ) usTopicLength > xThingsLength ) &&
+        ( strncmp( pcTopic, shadowTOPIC_THINGS, xThingsLength ) == 0 ) )
     {
-        pxReturn = &( pxShadowClient->xCallbackCatalog[ xIterator ] );
+        pcThingName = &( pcTopic[ xThingsLength ] );
 
-        if( pxReturn->xInUse == pdTRUE )
+        while( ( xThingsLength + xThingNameLength < ( size_t ) usTopicLength ) &&
+               ( pcThingName[ xThingNameLength ] != '/' ) )
         {
-            xCompareLength = prvCreateTopic( ( char * ) ucTopicBuffer,
-                                             shadowTOPIC_BUFFER_LENGTH,
-                                             shadowTOPIC_PREFIX, pxReturn->xCallbackInfo.pcThingName );
-
-            if( strncmp( ( const char * ) ucTopicBuffer,
-                         ( const char * ) pucTopic,
-                         xCompareLength ) == 0 )
-            {
-                xTopicFound = pdTRUE;
-
-                xCompareLength = prvCreateTopic( ( char * ) ucTopicBuffer,
-                                                 shadowTOPIC_BUFFER_LENGTH, shadowTOPIC_UPDATE_DOCUMENTS,
-                                                 pxReturn->xCallbackInfo.pcThingName );
-
-                xCompareLength = configMAX( xCompareLength, usTopicLength );
+            xThingNameLength++;
+        }
 
-                if( pxOperationName != NULL )
-                {
-                    if( strncmp( ( const char * ) ucTopicBuffer,
-                                 ( const char * ) pucTopic,
-                                 xCompareLength ) == 0 )
-                    {
-                        *pxOperationName = eShadowOperationUpdateDocuments;
-                    }
-                    else
-                    {
-                        xCompareLength = prvCreateTopic( ( char * ) ucTopicBuffer,
-                                                         shadowTOPIC_BUFFER_LENGTH, shadowTOPIC_UPDATE_DELTA,
-                                                         pxReturn->xCallbackInfo.pcThingName );
+        if( ( xThingsLength + xThingNameLength + xShadowLength <= ( size_t ) usTopicLength ) &&
+            ( strncmp( &( pcThingName[ xThingNameLength ] ), shadowTOPIC_SHADOW, xShadowLength ) == 0 ) )
+        {
+            xCallbackCatalogIndex = prvFindCallbackCatalogEntry( pxShadowClient, pcThingName, xThingNameLength );
+        }
+    }
 
-                        xCompareLength = configMAX( xCompareLength, usTopicLength );
+    if( xCallbackCatalogIndex >= 0 )
+    {
+        pxReturn = &( pxShadowClient->xCallbackCatalog[ xCallbackCatalogIndex ] );
 
-                        if( strncmp( ( const char * ) ucTopicBuffer,
-                                     ( const char * ) pucTopic,
-                                     xCompareLength ) == 0 )
-                        {
-                            *pxOperationName = eShadowOperationUpdateDelta;
-                        }
-                        else
-                        {
-                            xCompareLength = prvCreateTopic( ( char * ) ucTopicBuffer,
-                                                             shadowTOPIC_BUFFER_LENGTH,
-                                                             shadowTOPIC_DELETE_ACCEPTED,
-                                                             pxReturn->xCallbackInfo.pcThingName );
-
-                            xCompareLength = configMAX( xCompareLength, usTopicLength );
-
-                            if( strncmp( ( const char * ) ucTopicBuffer,
-                                         ( const char * ) pucTopic,
-                                         xCompareLength ) == 0 )
-                            {
-                                *pxOperationName = eShadowOperationDeletedByAnother;
-                            }
-                            else
-                            {
-                                *pxOperationName = eShadowOperationOther;
-                            }
-                        }
-                    }
-                }
+        if( pxOperationName != NULL )
+        {
+            pcTail = &( pcThingName[ xThingNameLength + xShadowLength ] );
+            xTailLength = ( size_t ) usTopicLength - ( xThingsLength + xThingNameLength + xShadowLength );
 
-                break;
+            if( ( xTailLength == ( sizeof( shadowTOPIC_TAIL_DOCUMENTS ) - ( size_t ) 1 ) ) &&
+                ( strncmp( pcTail, shadowTOPIC_TAIL_DOCUMENTS, xTailLength ) == 0 ) )
+            {
+                *pxOperationName = eShadowOperationUpdateDocuments;
+            }
+            else if( ( xTailLength == ( sizeof( shadowTOPIC_TAIL_DELTA ) - ( size_t ) 1 ) ) &&
+                     ( strncmp( pcTail, shadowTOPIC_TAIL_DELTA, xTailLength ) == 0 ) )
+            {
+                *pxOperationName = eShadowOperationUpdateDelta;
+            }
+            else if( ( xTailLength == ( sizeof( shadowTOPIC_TAIL_DELETED ) - ( size_t ) 1 ) ) &&
+                     ( strncmp( pcTail, shadowTOPIC_TAIL_DELETED, xTailLength ) == 0 ) )
+            {
+                *pxOperationName = eShadowOperationDeletedByAnother;
+            }
+            else
+            {
+                *pxOperationName = eShadowOperationOther;
             }
         }
     }
 
-    if( xTopicFound == pdFALSE )
-    {
-        pxReturn = NULL;
-    }
-
     return pxReturn;
 }
 
 /*-----------------------------------------------------------*/
 
 static void prvShadowUpdateCallback( BaseType_t xShadowClientID,
+                                     ShadowPendingOperation_t * const pxOperation,
                                      ShadowReturnCode_t xResult,
-                                     const ShadowOperationParams_t * const pxParams,
                                      const char * const pcData,
                                      uint32_t ulDataLength )
 {
-    /* Remove warning about unused parameters. */
-    ( void ) pxParams;
-
-    ShadowClient_t * pxShadowClient;
-
-    BaseType_t xReturn;
-
-    pxShadowClient = &( xShadowClients[ xShadowClientID ] );
-
-    /* Verify client token match. */
-    xReturn = SHADOW_JSONDocClientTokenMatch( pxParams->pcData,
-                                              pxParams->ulDataLength,
-                                              pcData,
-                                              ulDataLength );
+    /* The client token was matched by prvMatchPendingOperation. */
+    pxOperation->xOperationResult = xResult;
 
-    if( xReturn == pdPASS )
+    /* For failures, get the code and message. */
+    if( xResult == eShadowFailure )
     {
-        pxShadowClient->xOperationResult = xResult;
-
-        /* For failures, get the code and message. */
-        if( xResult == eShadowFailure )
-        {
-            pxShadowClient->xOperationResult = prvGetErrorCodeAndMessage( pcData,
-                                                                          ulDataLength,
-                                                                          xShadowClientID,
-                                                                          shadowTOPIC_OPERATION_UPDATE );
-        }
-
-        configASSERT( xSemaphoreGive( pxShadowClient->xCallbackSemaphore ) == pdPASS );
+        pxOperation->xOperationResult = prvGetErrorCodeAndMessage( pcData,
+                                                                   ulDataLength,
+                                                                   xShadowClientID,
+                                                                   shadowTOPIC_OPERATION_UPDATE );
     }
+
+    pxOperation->xCompleted = pdTRUE;
+    configASSERT( xSemaphoreGive( pxOperation->xCallbackSemaphore ) == pdPASS );
 }
 
 /*-----------------------------------------------------------*/
 
 static void prvShadowGetCallback( BaseType_t xShadowClientID,
+                                  ShadowPendingOperation_t * const pxOperation,
                                   ShadowReturnCode_t xResult,
-                                  ShadowOperationParams_t * const pxParams,
                                   const char * const pcData,
                                   uint32_t ulDataLength,
                                   MQTTBufferHandle_t xBuffer )
 {
-    ShadowClient_t * pxShadowClient;
+    ShadowOperationParams_t * const pxParams = pxOperation->pxOperationParams;
 
-    pxShadowClient = &( xShadowClients[ xShadowClientID ] );
-    pxShadowClient->xOperationResult = xResult;
+    pxOperation->xOperationResult = xResult;
 
 /* For successes, fill the user's buffer with the Shadow document. */
     if( xResult == eShadowSuccess )
@@ -1085,38 +1686,70 @@ static void prvShadowGetCallback( BaseType_t xShadowClientID,
 /* For failures , get the code and message. */
     else
     {
-        pxShadowClient->xOperationResult = prvGetErrorCodeAndMessage( pcData,
-                                                                      ulDataLength,
-                                                                      xShadowClientID,
-                                                                      shadowTOPIC_OPERATION_GET );
+        pxOperation->xOperationResult = prvGetErrorCodeAndMessage( pcData,
+                                                                   ulDataLength,
+                                                                   xShadowClientID,
+                                                                   shadowTOPIC_OPERATION_GET );
         pxParams->pcData = NULL;
         pxParams->ulDataLength = 0;
     }
 
-    configASSERT( xSemaphoreGive( pxShadowClient->xCallbackSemaphore ) == pdPASS );
+    pxOperation->xCompleted = pdTRUE;
+    configASSERT( xSemaphoreGive( pxOperation->xCallbackSemaphore ) == pdPASS );
 }
 /*-----------------------------------------------------------*/
 
 static void prvShadowDeleteCallback( BaseType_t xShadowClientID,
+                                     ShadowPendingOperation_t * const pxOperation,
                                      ShadowReturnCode_t xResult,
                                      const char * const pcData,
                                      uint32_t ulDataLength )
 {
-    ShadowClient_t * pxShadowClient;
-
-    pxShadowClient = &( xShadowClients[ xShadowClientID ] );
-    pxShadowClient->xOperationResult = xResult;
+    pxOperation->xOperationResult = xResult;
 
     if( xResult == eShadowFailure )
     {
-        pxShadowClient->xOperationResult = prvGetErrorCodeAndMessage( pcData,
-                                                                      ulDataLength,
-                                                                      xShadowClientID,
-                                                                      shadowTOPIC_OPERATION_DELETE );
+        pxOperation->xOperationResult = prvGetErrorCodeAndMessage( pcData,
+                                                                   ulDataLength,
+                                                                   xShadowClientID,
+                                                                   shadowTOPIC_OPERATION_DELETE );
+    }
+
+    pxOperation->xCompleted = pdTRUE;
+    configASSERT( xSemaphoreGive( pxOperation->xCallbackSemaphore ) == pdPASS );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDocClientTokenMatch( const ShadowClient_t * const pxShadowClient,
+                                          const char * const pcDoc1,
+                                          uint32_t ulDoc1Length,
+                                          const char * const pcDoc2,
+                                          uint32_t ulDoc2Length )
+{
+    BaseType_t xReturn;
+
+    #if ( shadowconfigENABLE_CBOR == 1 )
+        if( pxShadowClient->xPayloadFormat == eShadowPayloadCBOR )
+        {
+            xReturn = SHADOW_CBORDocClientTokenMatch( ( const uint8_t * ) pcDoc1,
+                                                      ulDoc1Length,
+                                                      ( const uint8_t * ) pcDoc2,
+                                                      ulDoc2Length );
+        }
+        else
+    #else
+        ( void ) pxShadowClient;
+    #endif
+    {
+        xReturn = SHADOW_JSONDocClientTokenMatch( pcDoc1,
+                                                  ulDoc1Length,
+                                                  pcDoc2,
+                                                  ulDoc2Length );
     }
 
-    configASSERT( xSemaphoreGive( pxShadowClient->xCallbackSemaphore ) == pdPASS );
+    return xReturn;
 }
+
 /*-----------------------------------------------------------*/
 
 static ShadowReturnCode_t prvGetErrorCodeAndMessage( const char * const pcData,
@@ -1125,13 +1758,25 @@ static ShadowReturnCode_t prvGetErrorCodeAndMessage( const char * const pcData,
                                                      const char * const pcOperationName )
 {
     ShadowReturnCode_t xErrorCode;
-    char * pcErrorMessage;
-    uint16_t usErrorMessageLength;
+    char * pcErrorMessage = NULL;
+    uint16_t usErrorMessageLength = 0;
 
-    xErrorCode = ( ShadowReturnCode_t ) SHADOW_JSONGetErrorCodeAndMessage( pcData,
-                                                                           ulDataLength,
-                                                                           &pcErrorMessage,
-                                                                           &usErrorMessageLength );
+    #if ( shadowconfigENABLE_CBOR == 1 )
+        if( xShadowClients[ xShadowClientID ].xPayloadFormat == eShadowPayloadCBOR )
+        {
+            xErrorCode = ( ShadowReturnCode_t ) SHADOW_CBORGetErrorCodeAndMessage( ( const uint8_t * ) pcData,
+                                                                                   ulDataLength,
+                                                                                   &pcErrorMessage,
+                                                                                   &usErrorMessageLength );
+        }
+        else
+    #endif
+    {
+        xErrorCode = ( ShadowReturnCode_t ) SHADOW_JSONGetErrorCodeAndMessage( pcData,
+                                                                               ulDataLength,
+                                                                               &pcErrorMessage,
+                                                                               &usErrorMessageLength );
+    }
 
     if( xErrorCode > 0 )
     {
@@ -1170,62 +1815,92 @@ static ShadowReturnCode_t prvShadowOperation( ShadowOperationCallParams_t * pxPa
     MQTTAgentPublishParams_t xPublishParams;
     ShadowClient_t * pxShadowClient;
     TimeOutData_t xTimeOutData;
-    ShadowOperationData_t xOperationData;
+    ShadowPendingOperation_t * pxOperation = NULL;
     MQTTAgentReturnCode_t xMQTTReturn;
+    BaseType_t xIterator;
 
     /* Initialize timeout data. */
     xTimeOutData.xTicksRemaining = pxParams->xTimeoutTicks;
 
-    /* Identify the relevant Shadow Client, then lock that client's operation mutex.
-     * This allows only one operation to be in progress. */
+    /* Identify the relevant Shadow Client, then reserve one of that client's
+     * pending operations. This limits the number of operations in progress. */
     pxShadowClient = &( xShadowClients[ ( pxParams->xShadowClientID ) ] );
 
-    if( xSemaphoreTake( pxShadowClient->xOperationMutex,
+    if( xSemaphoreTake( pxShadowClient->xPendingOperationSlots,
                         xTimeOutData.xTicksRemaining ) == pdPASS )
     {
-        /* Subscribe to accepted/rejected if necessary. */
-        if( ( BaseType_t ) prvGetSubscribedFlag( pxShadowClient,
-                                                 pxParams->xOperationName ) == pdFALSE )
+        if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
+                            portMAX_DELAY ) == pdPASS )
         {
-            xReturn = prvShadowSubscribeToAcceptedRejected( pxParams->xShadowClientID,
-                                                            ( pxParams->pxOperationParams )->pcThingName,
-                                                            pxParams->pcOperationAcceptedTopic,
-                                                            pxParams->pcOperationRejectedTopic,
-                                                            &xTimeOutData );
+            for( xIterator = 0; xIterator < shadowconfigMAX_PENDING_OPERATIONS; xIterator++ )
+            {
+                if( pxShadowClient->xPendingOperations[ xIterator ].xInUse == pdFALSE )
+                {
+                    pxOperation = &( pxShadowClient->xPendingOperations[ xIterator ] );
+                    break;
+                }
+            }
+
+            /* xPendingOperationSlots guarantees that an entry is free. */
+            configASSERT( pxOperation != NULL );
+
+            pxOperation->xInUse = pdTRUE;
+            pxOperation->xSubscribed = pdFALSE;
+            pxOperation->xCompleted = pdFALSE;
+            pxOperation->xOperationInProgress = pxParams->xOperationName;
+            pxOperation->pxOperationParams = pxParams->pxOperationParams;
+            pxOperation->pxSubscription = NULL;
+            pxOperation->xOperationResult = eShadowSuccess;
+
+            /* Fill the operation's topic buffer with the operation topic. */
+            xPublishParams.usTopicLength =
+                prvCreateTopic( ( char * ) pxOperation->ucTopicBuffer,
+                                shadowTOPIC_BUFFER_LENGTH,
+                                pxParams->pcOperationTopic,
+                                ( pxParams->pxOperationParams )->pcThingName );
+
+            configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
         }
         else
         {
-            xReturn = eShadowSuccess;
+            Shadow_debug_printf( ( "Error while taking mutex\n" ) );
+            configASSERT( 0 );
         }
 
-        if( xReturn == eShadowSuccess )
+        /* A response may have been given to the previous operation that used
+         * this entry after it stopped waiting. */
+        ( void ) xSemaphoreTake( pxOperation->xCallbackSemaphore, 0 );
+
+        /* Subscribe to accepted/rejected if the subscription is not already
+         * in place. Only one operation at a time may change the subscriptions. */
+        if( xSemaphoreTake( pxShadowClient->xSubscriptionMutex,
+                            xTimeOutData.xTicksRemaining ) == pdPASS )
         {
-            /* The subscribe to update/accepted and update/rejected succeeded,
-             * so set the appropriate flag. */
-            prvSetSubscribedFlag( pxShadowClient, pxParams->xOperationName, 1 );
+            xReturn = prvAcquireSubscription( pxParams, pxOperation, &xTimeOutData );
 
-            /* This is guarded by xOperationMutex and should never fail. */
-            configASSERT( xSemaphoreTake( pxShadowClient->xCallbackSemaphore,
-                                          xTimeOutData.xTicksRemaining ) == pdPASS );
+            if( xReturn == eShadowSuccess )
+            {
+                /* The subscription to accepted and rejected is in place, so the
+                 * callback may now deliver responses to this operation. */
+                if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
+                                    portMAX_DELAY ) == pdPASS )
+                {
+                    pxOperation->xSubscribed = pdTRUE;
+                    configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+                }
+            }
 
-            /* Fill ucTopicBuffer with the update topic. */
-            xPublishParams.usTopicLength =
-                prvCreateTopic( ( char * ) pxShadowClient->ucTopicBuffer,
-                                shadowTOPIC_BUFFER_LENGTH,
-                                pxParams->pcOperationTopic,
-                                ( pxParams->pxOperationParams )->pcThingName );
+            configASSERT( xSemaphoreGive( pxShadowClient->xSubscriptionMutex ) == pdPASS );
+        }
 
+        if( xReturn == eShadowSuccess )
+        {
             /* Operation parameters. */
-            xPublishParams.pucTopic = pxShadowClient->ucTopicBuffer;
+            xPublishParams.pucTopic = pxOperation->ucTopicBuffer;
             xPublishParams.pvData = pxParams->pcPublishMessage;
             xPublishParams.ulDataLength = pxParams->ulPublishMessageLength;
             xPublishParams.xQoS = ( pxParams->pxOperationParams )->xQoS;
 
-            /* Data to pass to the callback. */
-            xOperationData.xOperationInProgress = pxParams->xOperationName;
-            xOperationData.pxOperationParams = pxParams->pxOperationParams;
-            pxShadowClient->pxOperationData = &xOperationData;
-
             xMQTTReturn = MQTT_AGENT_Publish( pxShadowClient->xMQTTClient,
                                               &xPublishParams,
                                               xTimeOutData.xTicksRemaining );
@@ -1237,9 +1912,9 @@ static ShadowReturnCode_t prvShadowOperation( ShadowOperationCallParams_t * pxPa
 
             if( xReturn == eShadowSuccess )
             {
-                /* Wait for the semaphore to become available again; it should be
-                 * released by the update callback. */
-                if( xSemaphoreTake( pxShadowClient->xCallbackSemaphore,
+                /* Wait for the semaphore to become available; it should be
+                 * released by the operation callback. */
+                if( xSemaphoreTake( pxOperation->xCallbackSemaphore,
                                     xTimeOutData.xTicksRemaining ) != pdPASS )
                 {
                     Shadow_debug_printf( ( "[Shadow %d] Error while waiting for"
@@ -1250,150 +1925,405 @@ static ShadowReturnCode_t prvShadowOperation( ShadowOperationCallParams_t * pxPa
                 }
                 else
                 {
-                    /* The update callback reports its status as xOperationResult. */
-                    xReturn = pxShadowClient->xOperationResult;
+                    /* The operation callback reports its status as xOperationResult. */
+                    xReturn = pxOperation->xOperationResult;
+                }
+            }
+
+            /* Stop responses from being delivered to this operation. A response
+             * delivered since the wait timed out is still reported. */
+            if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
+                                portMAX_DELAY ) == pdPASS )
+            {
+                if( ( xReturn == eShadowTimeout ) && ( pxOperation->xCompleted == pdTRUE ) )
+                {
+                    xReturn = pxOperation->xOperationResult;
+                }
+
+                pxOperation->xCompleted = pdTRUE;
+                configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+            }
+        }
+
+        /* Drop this operation's reference to the subscription. The holder of
+         * xSubscriptionMutex only blocks for bounded MQTT calls. */
+        if( pxOperation->pxSubscription != NULL )
+        {
+            xTimeOutData.xTicksRemaining = configMAX( xTimeOutData.xTicksRemaining,
+                                                      pdMS_TO_TICKS( shadowconfigCLEANUP_TIME_MS ) );
+
+            if( xSemaphoreTake( pxShadowClient->xSubscriptionMutex,
+                                portMAX_DELAY ) == pdPASS )
+            {
+                prvReleaseSubscription( pxParams, pxOperation, &xTimeOutData );
+                configASSERT( xSemaphoreGive( pxShadowClient->xSubscriptionMutex ) == pdPASS );
+            }
+        }
+
+        /* Release this operation's entry so that the next operation has a
+         * clean entry, then release the slot. */
+        if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
+                            portMAX_DELAY ) == pdPASS )
+        {
+            pxOperation->xInUse = pdFALSE;
+            pxOperation->xSubscribed = pdFALSE;
+            configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+        }
+        else
+        {
+            Shadow_debug_printf( ( "Error while taking mutex\n" ) );
+            configASSERT( 0 );
+        }
+
+        configASSERT( xSemaphoreGive( pxShadowClient->xPendingOperationSlots ) == pdPASS );
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( shadowconfigREPORTED_FIELDS > 0 )
+
+    static BaseType_t prvReportedAppend( uint8_t * const pucDocument,
+                                         size_t * const pxDocumentLength,
+                                         const char * const pcString,
+                                         size_t xStringLength )
+    {
+        BaseType_t xReturn = pdFALSE;
+
+        if( ( *pxDocumentLength + xStringLength ) <= ( size_t ) shadowconfigREPORTED_DOCUMENT_LENGTH )
+        {
+            memcpy( &( pucDocument[ *pxDocumentLength ] ), pcString, xStringLength );
+            *pxDocumentLength += xStringLength;
+            xReturn = pdTRUE;
+        }
+
+        return xReturn;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static size_t prvReportedBuildDocument( ShadowClient_t * const pxShadowClient )
+    {
+        ShadowReportedField_t * pxField;
+        uint8_t * const pucDocument = pxShadowClient->ucReportedDocument;
+        BaseType_t xIterator, xFieldAdded = pdFALSE;
+        size_t xLength = 0, xFieldStart, xValueLength;
+        char cToken[ 10 ];
+        size_t xTokenLength = 0;
+        uint32_t ulToken;
+
+        /* Room is kept for the client token, which has up to 10 digits. */
+        const size_t xTrailerLength = ( sizeof( shadowREPORTED_DOCUMENT_TOKEN ) - ( size_t ) 1 ) +
+                                      sizeof( cToken ) +
+                                      ( sizeof( shadowREPORTED_DOCUMENT_END ) - ( size_t ) 1 );
+
+        ( void ) prvReportedAppend( pucDocument,
+                                    &xLength,
+                                    shadowREPORTED_DOCUMENT_START,
+                                    sizeof( shadowREPORTED_DOCUMENT_START ) - ( size_t ) 1 );
+
+        for( xIterator = 0; xIterator < shadowconfigREPORTED_FIELDS; xIterator++ )
+        {
+            pxField = &( pxShadowClient->xReportedFields[ xIterator ] );
+            pxField->usDocumentOffset = 0;
+
+            if( ( pxField->xInUse == pdTRUE ) &&
+                ( strcmp( pxField->cValue, pxField->cAcknowledgedValue ) != 0 ) )
+            {
+                /* Write ,"key":value after the previous field. */
+                xFieldStart = xLength;
+                xValueLength = strlen( pxField->cValue );
+
+                if( ( ( xFieldAdded == pdFALSE ) || ( prvReportedAppend( pucDocument, &xLength, ",", 1 ) == pdTRUE ) ) &&
+                    ( prvReportedAppend( pucDocument, &xLength, "\"", 1 ) == pdTRUE ) &&
+                    ( prvReportedAppend( pucDocument, &xLength, pxField->cKey, strlen( pxField->cKey ) ) == pdTRUE ) &&
+                    ( prvReportedAppend( pucDocument, &xLength, "\":", 2 ) == pdTRUE ) &&
+                    ( prvReportedAppend( pucDocument, &xLength, pxField->cValue, xValueLength ) == pdTRUE ) &&
+                    ( ( xLength + xTrailerLength ) <= ( size_t ) shadowconfigREPORTED_DOCUMENT_LENGTH ) )
+                {
+                    pxField->usDocumentOffset = ( uint16_t ) ( xLength - xValueLength );
+                    pxField->usDocumentLength = ( uint16_t ) xValueLength;
+                    xFieldAdded = pdTRUE;
+                }
+                else
+                {
+                    /* The field does not fit; it is left for the next update. */
+                    xLength = xFieldStart;
+                }
+            }
+        }
+
+        if( xFieldAdded == pdTRUE )
+        {
+            /* A new client token identifies the response to this update. */
+            pxShadowClient->ulReportedToken++;
+            ulToken = pxShadowClient->ulReportedToken;
+
+            do
+            {
+                cToken[ ( sizeof( cToken ) - ( size_t ) 1 ) - xTokenLength ] = ( char ) ( '0' + ( char ) ( ulToken % ( uint32_t ) 10 ) );
+                ulToken /= ( uint32_t ) 10;
+                xTokenLength++;
+            } while( ulToken != ( uint32_t ) 0 );
+
+            ( void ) prvReportedAppend( pucDocument,
+                                        &xLength,
+                                        shadowREPORTED_DOCUMENT_TOKEN,
+                                        sizeof( shadowREPORTED_DOCUMENT_TOKEN ) - ( size_t ) 1 );
+            ( void ) prvReportedAppend( pucDocument,
+                                        &xLength,
+                                        &( cToken[ sizeof( cToken ) - xTokenLength ] ),
+                                        xTokenLength );
+            ( void ) prvReportedAppend( pucDocument,
+                                        &xLength,
+                                        shadowREPORTED_DOCUMENT_END,
+                                        sizeof( shadowREPORTED_DOCUMENT_END ) - ( size_t ) 1 );
+        }
+        else
+        {
+            xLength = 0;
+        }
+
+        return xLength;
+    }
+
+#endif /* shadowconfigREPORTED_FIELDS */
+/*-----------------------------------------------------------*/
+
+#if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+
+    static size_t prvNextPathSegment( const char * const pcPath,
+                                      size_t xPathLength,
+                                      size_t * const pxIndex,
+                                      const char ** const ppcSegment )
+    {
+        size_t xStart = *pxIndex, xEnd;
+
+        /* Skip the separator before a key. */
+        if( ( xStart > ( size_t ) 0 ) && ( xStart < xPathLength ) && ( pcPath[ xStart ] == '.' ) )
+        {
+            xStart++;
+        }
+
+        xEnd = xStart;
+
+        if( ( xEnd < xPathLength ) && ( pcPath[ xEnd ] == '[' ) )
+        {
+            /* An array index runs up to and including the ']'. */
+            while( ( xEnd < xPathLength ) && ( pcPath[ xEnd ] != ']' ) )
+            {
+                xEnd++;
+            }
+
+            if( xEnd < xPathLength )
+            {
+                xEnd++;
+            }
+        }
+        else
+        {
+            while( ( xEnd < xPathLength ) && ( pcPath[ xEnd ] != '.' ) && ( pcPath[ xEnd ] != '[' ) )
+            {
+                xEnd++;
+            }
+        }
+
+        *ppcSegment = &( pcPath[ xStart ] );
+        *pxIndex = xEnd;
+
+        return xEnd - xStart;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvCompileDeltaTrie( CallbackCatalogEntry_t * const pxCallbackCatalogEntry,
+                                           const ShadowDeltaHandlerParams_t * const pxHandlers,
+                                           uint32_t ulHandlerCount )
+    {
+        BaseType_t xReturn = pdPASS;
+        ShadowDeltaTrieNode_t * const pxTrie = pxCallbackCatalogEntry->xDeltaTrie;
+        uint8_t * pucChildren;
+        uint8_t ucNode, ucLastSibling, ucNodeCount = 0;
+        uint32_t ulHandler;
+        size_t xPathLength, xIndex, xSegmentLength;
+        const char * pcSegment;
+
+        pxCallbackCatalogEntry->ucDeltaTrieRoot = shadowDELTA_TRIE_NONE;
+
+        for( ulHandler = 0; ( ulHandler < ulHandlerCount ) && ( xReturn == pdPASS ); ulHandler++ )
+        {
+            xPathLength = strlen( pxHandlers[ ulHandler ].pcPath );
+            xIndex = 0;
+            pucChildren = &( pxCallbackCatalogEntry->ucDeltaTrieRoot );
+            ucNode = shadowDELTA_TRIE_NONE;
+
+            if( ( xPathLength == ( size_t ) 0 ) || ( pxHandlers[ ulHandler ].xHandler == NULL ) )
+            {
+                xReturn = pdFAIL;
+            }
+
+            /* Walk down the trie one segment at a time, adding the segments
+             * not shared with an earlier path. */
+            while( ( xIndex < xPathLength ) && ( xReturn == pdPASS ) )
+            {
+                xSegmentLength = prvNextPathSegment( pxHandlers[ ulHandler ].pcPath, xPathLength, &xIndex, &pcSegment );
+
+                if( ( xSegmentLength == ( size_t ) 0 ) || ( xSegmentLength > ( size_t ) UINT8_MAX ) )
+                {
+                    xReturn = pdFAIL;
+                    break;
                 }
-            }
 
-            configASSERT( xSemaphoreGive( pxShadowClient->xCallbackSemaphore ) == pdPASS );
-        }
+                ucNode = *pucChildren;
+                ucLastSibling = shadowDELTA_TRIE_NONE;
 
-        /* Unsubscribe. */
-        if( ( pxParams->pxOperationParams )->ucKeepSubscriptions == ( uint8_t ) 0 )
-        {
-            xTimeOutData.xTicksRemaining = configMAX( xTimeOutData.xTicksRemaining,
-                                                      pdMS_TO_TICKS( shadowconfigCLEANUP_TIME_MS ) );
+                while( ( ucNode != shadowDELTA_TRIE_NONE ) &&
+                       ( ( ( size_t ) pxTrie[ ucNode ].ucSegmentLength != xSegmentLength ) ||
+                         ( memcmp( pxTrie[ ucNode ].pcSegment, pcSegment, xSegmentLength ) != 0 ) ) )
+                {
+                    ucLastSibling = ucNode;
+                    ucNode = pxTrie[ ucNode ].ucNextSibling;
+                }
 
-            /* If the Shadow client is subscribed to delete/accepted for this
-             * Thing for a user notify callback, do not unsubscribe; that would
-             * break callback notify. */
-            if( pxParams->xOperationName == eShadowOperationDelete )
-            {
-                ( void ) prvCreateTopic( ( char * ) pxShadowClient->ucTopicBuffer,
-                                         shadowTOPIC_BUFFER_LENGTH,
-                                         shadowTOPIC_DELETE_ACCEPTED,
-                                         pxParams->pxOperationParams->pcThingName );
-
-                /* If there's a callback registered for delete/accepted, only
-                 * unsubscribe from delete/rejected. */
-                if( prvMatchCallbackTopic( pxShadowClient,
-                                           pxShadowClient->ucTopicBuffer,
-                                           ( uint16_t )
-                                           strlen( ( const char * ) pxShadowClient->ucTopicBuffer ),
-                                           NULL ) == NULL )
+                if( ucNode == shadowDELTA_TRIE_NONE )
                 {
-                    if( prvShadowUnsubscribeFromAcceptedRejected( pxParams->xShadowClientID,
-                                                                  pxParams->pxOperationParams->pcThingName,
-                                                                  NULL,
-                                                                  pxParams->pcOperationRejectedTopic,
-                                                                  &xTimeOutData ) == eShadowSuccess )
+                    if( ucNodeCount >= ( uint8_t ) shadowconfigDELTA_TRIE_NODES )
+                    {
+                        xReturn = pdFAIL;
+                        break;
+                    }
+
+                    ucNode = ucNodeCount;
+                    ucNodeCount++;
+                    pxTrie[ ucNode ].pcSegment = pcSegment;
+                    pxTrie[ ucNode ].ucSegmentLength = ( uint8_t ) xSegmentLength;
+                    pxTrie[ ucNode ].ucFirstChild = shadowDELTA_TRIE_NONE;
+                    pxTrie[ ucNode ].ucNextSibling = shadowDELTA_TRIE_NONE;
+                    pxTrie[ ucNode ].ucHandler = shadowDELTA_TRIE_NONE;
+
+                    if( ucLastSibling == shadowDELTA_TRIE_NONE )
+                    {
+                        *pucChildren = ucNode;
+                    }
+                    else
                     {
-                        prvSetSubscribedFlag( pxShadowClient,
-                                              pxParams->xOperationName,
-                                              0 );
+                        pxTrie[ ucLastSibling ].ucNextSibling = ucNode;
                     }
                 }
+
+                pucChildren = &( pxTrie[ ucNode ].ucFirstChild );
             }
-            else
+
+            if( xReturn == pdPASS )
             {
-                if( prvShadowUnsubscribeFromAcceptedRejected( pxParams->xShadowClientID,
-                                                              pxParams->pxOperationParams->pcThingName,
-                                                              pxParams->pcOperationAcceptedTopic,
-                                                              pxParams->pcOperationRejectedTopic,
-                                                              &xTimeOutData ) == eShadowSuccess )
+                /* Each path may only be registered once. */
+                if( pxTrie[ ucNode ].ucHandler != shadowDELTA_TRIE_NONE )
+                {
+                    xReturn = pdFAIL;
+                }
+                else
                 {
-                    prvSetSubscribedFlag( pxShadowClient,
-                                          pxParams->xOperationName,
-                                          0 );
+                    pxTrie[ ucNode ].ucHandler = ( uint8_t ) ulHandler;
                 }
             }
         }
 
-        /* Delete this operation's data so that the next operation has a clean Shadow
-         * Client, then release the operation mutex. */
-        if( xSemaphoreTake( pxShadowClient->xOperationDataMutex,
-                            portMAX_DELAY ) == pdPASS )
-        {
-            pxShadowClient->pxOperationData = NULL;
-            configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
-        }
-        else
-        {
-            Shadow_debug_printf( ( "Error while taking mutex\n" ) );
-            configASSERT( 0 );
-        }
-
-        pxShadowClient->xOperationResult = eShadowSuccess;
-        memset( pxShadowClient->ucTopicBuffer, 0, shadowTOPIC_BUFFER_LENGTH );
-        configASSERT( xSemaphoreGive( pxShadowClient->xOperationMutex )
-                      == pdPASS );
+        return xReturn;
     }
 
-    return xReturn;
-}
-
 /*-----------------------------------------------------------*/
 
-static void prvSetSubscribedFlag( ShadowClient_t * const pxShadowClient,
-                                  ShadowOperationName_t xOperationName,
-                                  BaseType_t xValue )
-{
-    switch( xOperationName )
+    static uint8_t prvFindDeltaHandler( const CallbackCatalogEntry_t * const pxCallbackCatalogEntry,
+                                        const char * const pcPath,
+                                        size_t xPathLength )
     {
-        case eShadowOperationUpdate:
-            pxShadowClient->xUpdateSubscribed = xValue;
-            break;
+        const ShadowDeltaTrieNode_t * const pxTrie = pxCallbackCatalogEntry->xDeltaTrie;
+        uint8_t ucNode = pxCallbackCatalogEntry->ucDeltaTrieRoot;
+        size_t xIndex = 0, xSegmentLength;
+        const char * pcSegment;
 
-        case eShadowOperationGet:
-            pxShadowClient->xGetSubscribed = xValue;
-            break;
+        while( ( xIndex < xPathLength ) && ( ucNode != shadowDELTA_TRIE_NONE ) )
+        {
+            xSegmentLength = prvNextPathSegment( pcPath, xPathLength, &xIndex, &pcSegment );
 
-        case eShadowOperationDelete:
-            pxShadowClient->xDeleteSubscribed = xValue;
-            break;
+            /* Find the segment among the children of the previous one. */
+            while( ( ucNode != shadowDELTA_TRIE_NONE ) &&
+                   ( ( ( size_t ) pxTrie[ ucNode ].ucSegmentLength != xSegmentLength ) ||
+                     ( memcmp( pxTrie[ ucNode ].pcSegment, pcSegment, xSegmentLength ) != 0 ) ) )
+            {
+                ucNode = pxTrie[ ucNode ].ucNextSibling;
+            }
 
-        default:
-            /* Should not fall here. */
-            break;
+            if( ( ucNode != shadowDELTA_TRIE_NONE ) && ( xIndex < xPathLength ) )
+            {
+                ucNode = pxTrie[ ucNode ].ucFirstChild;
+            }
+        }
+
+        return ( ucNode != shadowDELTA_TRIE_NONE ) ? pxTrie[ ucNode ].ucHandler : shadowDELTA_TRIE_NONE;
     }
-}
 
 /*-----------------------------------------------------------*/
 
-static uint8_t prvGetSubscribedFlag( const ShadowClient_t * const pxShadowClient,
-                                     ShadowOperationName_t xOperationName )
-{
-    uint8_t ucReturn = 0;
-
-    switch( xOperationName )
+    static void prvDispatchDelta( void * pvUserData,
+                                  ShadowClient_t * const pxShadowClient,
+                                  const CallbackCatalogEntry_t * const pxCallbackCatalogEntry,
+                                  const char * const pcDeltaDocument,
+                                  uint32_t ulDocumentLength )
     {
-        case eShadowOperationUpdate:
-            ucReturn = ( uint8_t ) pxShadowClient->xUpdateSubscribed;
-            break;
+        JSONPullParser_t xParser;
+        JSONPullEvent_t xEvent;
+        const ShadowDeltaHandlerParams_t * pxHandler;
+        const size_t xPrefixLength = sizeof( shadowDELTA_STATE_PREFIX ) - ( size_t ) 1;
+        uint8_t ucHandler;
 
-        case eShadowOperationGet:
-            ucReturn = ( uint8_t ) pxShadowClient->xGetSubscribed;
-            break;
+        if( xSemaphoreTake( pxShadowClient->xOperationDataMutex, portMAX_DELAY ) == pdPASS )
+        {
+            if( pxCallbackCatalogEntry->ulDeltaHandlerCount > ( uint32_t ) 0 )
+            {
+                /* The delta is one MQTT message, so no scratch buffer is needed. */
+                JSONPULL_Init( &xParser, NULL, 0 );
+                JSONPULL_SetInput( &xParser, pcDeltaDocument, ( size_t ) ulDocumentLength );
 
-        case eShadowOperationDelete:
-            ucReturn = ( uint8_t ) pxShadowClient->xDeleteSubscribed;
-            break;
+                while( JSONPULL_Next( &xParser, &xEvent ) == eJSONPullEvent )
+                {
+                    if( ( ( xEvent.xType == eJSONPullString ) || ( xEvent.xType == eJSONPullPrimitive ) ) &&
+                        ( xEvent.xPathLength > xPrefixLength ) &&
+                        ( strncmp( xEvent.pcPath, shadowDELTA_STATE_PREFIX, xPrefixLength ) == 0 ) )
+                    {
+                        ucHandler = prvFindDeltaHandler( pxCallbackCatalogEntry,
+                                                         &( xEvent.pcPath[ xPrefixLength ] ),
+                                                         xEvent.xPathLength - xPrefixLength );
 
-        default:
-            /* Should not fall here. */
-            break;
-    }
+                        if( ucHandler != shadowDELTA_TRIE_NONE )
+                        {
+                            pxHandler = &( pxCallbackCatalogEntry->pxDeltaHandlers[ ucHandler ] );
+                            pxHandler->xHandler( pvUserData,
+                                                 pxCallbackCatalogEntry->xCallbackInfo.pcThingName,
+                                                 pxHandler->pcPath,
+                                                 xEvent.pcValue,
+                                                 ( uint32_t ) xEvent.xValueLength );
+                        }
+                    }
+                }
+            }
 
-    return ucReturn;
-}
+            configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+        }
+    }
 
+#endif /* shadowconfigMAX_DELTA_HANDLERS */
 /*-----------------------------------------------------------*/
 
 ShadowReturnCode_t SHADOW_ClientCreate( ShadowClientHandle_t * pxShadowClientHandle,
                                         const ShadowCreateParams_t * const pxShadowCreateParams )
 {
     ShadowClient_t * pxShadowClient;
+    ShadowPendingOperation_t * pxOperation;
     BaseType_t xShadowClientID;
+    BaseType_t xIterator;
     ShadowReturnCode_t xReturn = eShadowFailure;
     MQTTAgentReturnCode_t xMQTTReturn;
 
@@ -1411,6 +2341,10 @@ ShadowReturnCode_t SHADOW_ClientCreate( ShadowClientHandle_t * pxShadowClientHan
     {
         pxShadowClient = &( xShadowClients[ xShadowClientID ] );
 
+        #if ( shadowconfigENABLE_CBOR == 1 )
+            pxShadowClient->xPayloadFormat = pxShadowCreateParams->xPayloadFormat;
+        #endif
+
         xMQTTReturn = MQTT_AGENT_Create( &( pxShadowClient->xMQTTClient ) );
 
         xReturn = prvConvertMQTTReturnCode( xMQTTReturn,
@@ -1420,10 +2354,22 @@ ShadowReturnCode_t SHADOW_ClientCreate( ShadowClientHandle_t * pxShadowClientHan
         if( xReturn == eShadowSuccess )
         {
             /* Create synchronization mechanisms; these calls should never fail. */
-            pxShadowClient->xCallbackSemaphore = xSemaphoreCreateBinaryStatic( &( pxShadowClient->xCallbackSemaphoreBuffer ) );
-            pxShadowClient->xOperationMutex = xSemaphoreCreateMutexStatic( &( pxShadowClient->xOperationMutexBuffer ) );
+            pxShadowClient->xSubscriptionMutex = xSemaphoreCreateMutexStatic( &( pxShadowClient->xSubscriptionMutexBuffer ) );
             pxShadowClient->xOperationDataMutex = xSemaphoreCreateMutexStatic( &( pxShadowClient->xOperationDataMutexBuffer ) );
-            configASSERT( xSemaphoreGive( pxShadowClient->xCallbackSemaphore ) == pdPASS );
+            pxShadowClient->xPendingOperationSlots = xSemaphoreCreateCountingStatic( ( UBaseType_t ) shadowconfigMAX_PENDING_OPERATIONS,
+                                                                                     ( UBaseType_t ) shadowconfigMAX_PENDING_OPERATIONS,
+                                                                                     &( pxShadowClient->xPendingOperationSlotsBuffer ) );
+
+            for( xIterator = 0; xIterator < shadowconfigMAX_PENDING_OPERATIONS; xIterator++ )
+            {
+                /* Created empty; given by the callbacks. */
+                pxOperation = &( pxShadowClient->xPendingOperations[ xIterator ] );
+                pxOperation->xCallbackSemaphore = xSemaphoreCreateBinaryStatic( &( pxOperation->xCallbackSemaphoreBuffer ) );
+            }
+
+            #if ( shadowconfigREPORTED_FIELDS > 0 )
+                pxShadowClient->xReportedMutex = xSemaphoreCreateMutexStatic( &( pxShadowClient->xReportedMutexBuffer ) );
+            #endif
 
             /* Set the output parameter. */
             *pxShadowClientHandle = ( ShadowClientHandle_t ) xShadowClientID; /*lint !e923 Safe cast from pointer handle. */
@@ -1451,6 +2397,10 @@ ShadowReturnCode_t SHADOW_ClientConnect( ShadowClientHandle_t xShadowClientHandl
     ShadowReturnCode_t xReturn;
     MQTTAgentReturnCode_t xMQTTReturn;
 
+    #if ( shadowconfigSUBSCRIBE_WILDCARD == 1 )
+        MQTTAgentSubscribeParams_t xSubscribeParams;
+    #endif
+
     configASSERT( ( ( BaseType_t ) xShadowClientHandle >= 0 &&
                     ( BaseType_t ) xShadowClientHandle < shadowconfigMAX_CLIENTS ) );                       /*lint !e923 Safe cast from pointer handle. */
     configASSERT( xShadowClientHandle == *( ( ShadowClientHandle_t * ) ( pxConnectParams->pvUserData ) ) ); /*lint !e9087 Safe cast from opaque context. */
@@ -1468,6 +2418,29 @@ ShadowReturnCode_t SHADOW_ClientConnect( ShadowClientHandle_t xShadowClientHandl
                                         xShadowClientHandle,
                                         "Connect" );
 
+    #if ( shadowconfigSUBSCRIBE_WILDCARD == 1 )
+        /* One subscription routes the messages of every Thing. */
+        if( xReturn == eShadowSuccess )
+        {
+            xSubscribeParams.pucTopic = ( const uint8_t * ) shadowTOPIC_WILDCARD;
+            xSubscribeParams.usTopicLength = ( uint16_t ) ( sizeof( shadowTOPIC_WILDCARD ) - ( size_t ) 1 );
+            xSubscribeParams.xQoS = eMQTTQoS1;
+
+            #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+                xSubscribeParams.pvPublishCallbackContext = NULL;
+                xSubscribeParams.pxPublishCallback = NULL;
+            #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+
+            xMQTTReturn = MQTT_AGENT_Subscribe( pxShadowClient->xMQTTClient,
+                                                &xSubscribeParams,
+                                                xTimeoutTicks );
+
+            xReturn = prvConvertMQTTReturnCode( xMQTTReturn,
+                                                xShadowClientHandle,
+                                                "Subscribe to wildcard topic" );
+        }
+    #endif
+
     pxConnectParams->pxCallback = NULL;
 
     return xReturn;
@@ -1643,6 +2616,7 @@ ShadowReturnCode_t SHADOW_RegisterCallbacks( ShadowClientHandle_t xShadowClientH
     CallbackCatalogEntry_t * pxCallbackCatalogEntry;
     ShadowReturnCode_t xReturn = eShadowFailure;
     BaseType_t xCallbackCatalogIndex;
+    BaseType_t xDeltaHandlersRegistered = pdFALSE;
 
     configASSERT( ( ( BaseType_t ) xShadowClientHandle >= 0 &&
                     ( BaseType_t ) xShadowClientHandle < shadowconfigMAX_CLIENTS ) ); /*lint !e923 Safe cast from pointer handle. */
@@ -1653,55 +2627,73 @@ ShadowReturnCode_t SHADOW_RegisterCallbacks( ShadowClientHandle_t xShadowClientH
     pxShadowClient = &( xShadowClients[ ( BaseType_t ) xShadowClientHandle ] ); /*lint !e923 Safe cast from pointer handle. */
     configASSERT( ( pxShadowClient->xInUse == pdTRUE ) );
 
-    xCallbackCatalogIndex = prvGetCallbackCatalogEntry( pxShadowClient->xCallbackCatalog,
+    xCallbackCatalogIndex = prvGetCallbackCatalogEntry( pxShadowClient,
                                                         pxCallbackParams->pcThingName );
-    configASSERT( xCallbackCatalogIndex >= 0 );
-
-    /* Initialize timeout data. */
-
-    pxCallbackCatalogEntry = &( pxShadowClient->xCallbackCatalog
-                                [ xCallbackCatalogIndex ] );
 
-    /*_RB_ Casting on these calls make the code unreadable.  Types need changing to remove the need for the casts. */
-    /* ToDo: sub manager. */
-    xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle,                                                      /*lint !e923 Safe cast from pointer handle. */
-                                   ( const void ** ) &( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowUpdatedCallback ), /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. No const is being cast away either.*/
-                                   ( const void ** ) &( pxCallbackParams->xShadowUpdatedCallback ),                         /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. */
-                                   pxCallbackParams->pcThingName,
-                                   ( const uint8_t * ) shadowTOPIC_UPDATE_DOCUMENTS,
-                                   xTimeoutTicks );
-
-    if( xReturn == eShadowSuccess )
+    if( xCallbackCatalogIndex < 0 )
     {
-        xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle,                                                      /*lint !e923 Safe cast from pointer handle. */
-                                       ( const void ** ) &( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeletedCallback ), /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. No const is being cast away either.*/
-                                       ( const void ** ) &( pxCallbackParams->xShadowDeletedCallback ),                         /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. */
-                                       pxCallbackParams->pcThingName,
-                                       ( const uint8_t * ) shadowTOPIC_DELETE_ACCEPTED,
-                                       xTimeoutTicks );
+        Shadow_debug_printf( ( "[Shadow %d] No free callback catalog entry for %s.\r\n",
+                               ( BaseType_t ) xShadowClientHandle, /*lint !e923 Safe cast from pointer handle. */
+                               pxCallbackParams->pcThingName ) );
     }
-
-    if( xReturn == eShadowSuccess )
+    else
     {
-        xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle,                                                    /*lint !e923 Safe cast from pointer handle. */
-                                       ( const void ** ) &( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeltaCallback ), /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. No const is being cast away either.*/
-                                       ( const void ** ) &( pxCallbackParams->xShadowDeltaCallback ),                         /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. */
+        pxCallbackCatalogEntry = &( pxShadowClient->xCallbackCatalog
+                                    [ xCallbackCatalogIndex ] );
+
+        /*_RB_ Casting on these calls make the code unreadable.  Types need changing to remove the need for the casts. */
+        /* ToDo: sub manager. */
+        xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle,                                                      /*lint !e923 Safe cast from pointer handle. */
+                                       ( const void ** ) &( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowUpdatedCallback ), /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. No const is being cast away either.*/
+                                       ( const void ** ) &( pxCallbackParams->xShadowUpdatedCallback ),                         /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. */
                                        pxCallbackParams->pcThingName,
-                                       ( const uint8_t * ) shadowTOPIC_UPDATE_DELTA,
+                                       ( const uint8_t * ) shadowTOPIC_UPDATE_DOCUMENTS,
                                        xTimeoutTicks );
-    }
 
-    if( ( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowUpdatedCallback == NULL ) &&
-        ( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeltaCallback == NULL ) &&
-        ( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeletedCallback == NULL ) )
-    {
-        taskENTER_CRITICAL();
+        if( xReturn == eShadowSuccess )
         {
-            memset( pxCallbackCatalogEntry,
-                    0,
-                    sizeof( CallbackCatalogEntry_t ) );
+            xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle,                                                      /*lint !e923 Safe cast from pointer handle. */
+                                           ( const void ** ) &( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeletedCallback ), /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. No const is being cast away either.*/
+                                           ( const void ** ) &( pxCallbackParams->xShadowDeletedCallback ),                         /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. */
+                                           pxCallbackParams->pcThingName,
+                                           ( const uint8_t * ) shadowTOPIC_DELETE_ACCEPTED,
+                                           xTimeoutTicks );
+        }
+
+        #if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+            if( pxCallbackCatalogEntry->ulDeltaHandlerCount > ( uint32_t ) 0 )
+            {
+                xDeltaHandlersRegistered = pdTRUE;
+            }
+        #endif
+
+        if( ( xReturn == eShadowSuccess ) && ( xDeltaHandlersRegistered == pdTRUE ) )
+        {
+            /* The delta handlers keep the subscription to /update/delta, so only
+             * the callback changes. */
+            ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeltaCallback = pxCallbackParams->xShadowDeltaCallback;
+        }
+        else if( xReturn == eShadowSuccess )
+        {
+            xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle,                                                    /*lint !e923 Safe cast from pointer handle. */
+                                           ( const void ** ) &( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeltaCallback ), /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. No const is being cast away either.*/
+                                           ( const void ** ) &( pxCallbackParams->xShadowDeltaCallback ),                         /*lint !e9087 !e9005 cast is opaque and recast correctly inside the function. */
+                                           pxCallbackParams->pcThingName,
+                                           ( const uint8_t * ) shadowTOPIC_UPDATE_DELTA,
+                                           xTimeoutTicks );
+        }
+        else
+        {
+            /* An earlier registration failed. */
+        }
+
+        if( ( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowUpdatedCallback == NULL ) &&
+            ( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeltaCallback == NULL ) &&
+            ( ( pxCallbackCatalogEntry->xCallbackInfo ).xShadowDeletedCallback == NULL ) &&
+            ( xDeltaHandlersRegistered == pdFALSE ) )
+        {
+            prvFreeCallbackCatalogEntry( pxShadowClient, pxCallbackCatalogEntry );
         }
-        taskEXIT_CRITICAL();
     }
 
     return xReturn;
@@ -1709,6 +2701,151 @@ ShadowReturnCode_t SHADOW_RegisterCallbacks( ShadowClientHandle_t xShadowClientH
 
 /*-----------------------------------------------------------*/
 
+ShadowReturnCode_t SHADOW_RegisterDeltaHandlers( ShadowClientHandle_t xShadowClientHandle,
+                                                 const char * const pcThingName,
+                                                 const ShadowDeltaHandlerParams_t * const pxHandlers,
+                                                 uint32_t ulHandlerCount,
+                                                 TickType_t xTimeoutTicks )
+{
+    ShadowReturnCode_t xReturn = eShadowFailure;
+
+    #if ( shadowconfigMAX_DELTA_HANDLERS > 0 )
+        ShadowClient_t * pxShadowClient;
+        CallbackCatalogEntry_t * pxCallbackCatalogEntry;
+        const ShadowDeltaHandlerParams_t * pxOldHandlers;
+        const void * pvOldSubscriber;
+        const void * pvNewSubscriber;
+        BaseType_t xWasSubscribed, xCompiled = pdFALSE;
+        BaseType_t xJSONDocuments = pdTRUE;
+        BaseType_t xCallbackCatalogIndex = -1;
+
+        configASSERT( ( ( BaseType_t ) xShadowClientHandle >= 0 &&
+                        ( BaseType_t ) xShadowClientHandle < shadowconfigMAX_CLIENTS ) ); /*lint !e923 Safe cast from pointer handle. */
+        configASSERT( ( pcThingName != NULL ) );
+        configASSERT( ( ( pxHandlers != NULL ) || ( ulHandlerCount == ( uint32_t ) 0 ) ) );
+
+        pxShadowClient = &( xShadowClients[ ( BaseType_t ) xShadowClientHandle ] ); /*lint !e923 Safe cast from pointer handle. */
+        configASSERT( ( pxShadowClient->xInUse == pdTRUE ) );
+
+        #if ( shadowconfigENABLE_CBOR == 1 )
+            /* Delta documents are only parsed as JSON. */
+            xJSONDocuments = ( pxShadowClient->xPayloadFormat == eShadowPayloadJSON ) ? pdTRUE : pdFALSE;
+        #endif
+
+        if( ( ulHandlerCount <= ( uint32_t ) shadowconfigMAX_DELTA_HANDLERS ) && ( xJSONDocuments == pdTRUE ) )
+        {
+            xCallbackCatalogIndex = prvGetCallbackCatalogEntry( pxShadowClient, pcThingName );
+        }
+
+        if( xCallbackCatalogIndex >= 0 )
+        {
+            pxCallbackCatalogEntry = &( pxShadowClient->xCallbackCatalog[ xCallbackCatalogIndex ] );
+
+            pxOldHandlers = pxCallbackCatalogEntry->pxDeltaHandlers;
+            xWasSubscribed = ( ( pxCallbackCatalogEntry->ulDeltaHandlerCount > ( uint32_t ) 0 ) ||
+                               ( pxCallbackCatalogEntry->xCallbackInfo.xShadowDeltaCallback != NULL ) ) ? pdTRUE : pdFALSE;
+
+            /* Replace the trie while no delta is being dispatched. */
+            if( xSemaphoreTake( pxShadowClient->xOperationDataMutex, portMAX_DELAY ) == pdPASS )
+            {
+                pxCallbackCatalogEntry->ulDeltaHandlerCount = 0;
+
+                if( ulHandlerCount > ( uint32_t ) 0 )
+                {
+                    xCompiled = prvCompileDeltaTrie( pxCallbackCatalogEntry, pxHandlers, ulHandlerCount );
+
+                    if( xCompiled == pdPASS )
+                    {
+                        pxCallbackCatalogEntry->pxDeltaHandlers = pxHandlers;
+                        pxCallbackCatalogEntry->ulDeltaHandlerCount = ulHandlerCount;
+                    }
+                    else
+                    {
+                        Shadow_debug_printf( ( "[Shadow %d] Delta handler paths could not be compiled.\r\n",
+                                               ( BaseType_t ) xShadowClientHandle ) ); /*lint !e923 Safe cast from pointer handle. */
+                    }
+                }
+
+                configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+            }
+
+            if( ( ulHandlerCount > ( uint32_t ) 0 ) && ( xCompiled == pdFAIL ) )
+            {
+                xReturn = eShadowFailure;
+            }
+            else
+            {
+                xReturn = eShadowSuccess;
+            }
+
+            /* Subscribe to /update/delta while handlers or a delta callback
+             * are registered. */
+            if( ( pxCallbackCatalogEntry->ulDeltaHandlerCount > ( uint32_t ) 0 ) && ( xWasSubscribed == pdFALSE ) )
+            {
+                pvOldSubscriber = NULL;
+                pvNewSubscriber = ( const void * ) pxHandlers;
+                xReturn = prvRegisterCallback( ( BaseType_t ) xShadowClientHandle, /*lint !e923 Safe cast from pointer handle. */
+                                               &pvOldSubscriber,
+                                               &pvNewSubscriber,
+                                               pcThingName,
+                                               ( const uint8_t * ) shadowTOPIC_UPDATE_DELTA,
+                                               xTimeoutTicks );
+
+                if( ( xReturn != eShadowSuccess ) &&
+                    ( xSemaphoreTake( pxShadowClient->xOperationDataMutex, portMAX_DELAY ) == pdPASS ) )
+                {
+                    /* The handlers would never be called. */
+                    pxCallbackCatalogEntry->ulDeltaHandlerCount = 0;
+                    configASSERT( xSemaphoreGive( pxShadowClient->xOperationDataMutex ) == pdPASS );
+                }
+            }
+            else if( ( pxCallbackCatalogEntry->ulDeltaHandlerCount == ( uint32_t ) 0 ) &&
+                     ( pxCallbackCatalogEntry->xCallbackInfo.xShadowDeltaCallback == NULL ) &&
+                     ( xWasSubscribed == pdTRUE ) )
+            {
+                pvOldSubscriber = ( const void * ) pxOldHandlers;
+                pvNewSubscriber = NULL;
+
+                /* The unsubscribe result is only reported if the handlers
+                 * were being removed. */
+                if( ( prvRegisterCallback( ( BaseType_t ) xShadowClientHandle, /*lint !e923 Safe cast from pointer handle. */
+                                           &pvOldSubscriber,
+                                           &pvNewSubscriber,
+                                           pcThingName,
+                                           ( const uint8_t * ) shadowTOPIC_UPDATE_DELTA,
+                                           xTimeoutTicks ) != eShadowSuccess ) &&
+                    ( ulHandlerCount == ( uint32_t ) 0 ) )
+                {
+                    xReturn = eShadowFailure;
+                }
+            }
+            else
+            {
+                /* The subscription is unchanged. */
+            }
+
+            /* Free the catalog entry if nothing is registered for the Thing. */
+            if( ( pxCallbackCatalogEntry->xCallbackInfo.xShadowUpdatedCallback == NULL ) &&
+                ( pxCallbackCatalogEntry->xCallbackInfo.xShadowDeltaCallback == NULL ) &&
+                ( pxCallbackCatalogEntry->xCallbackInfo.xShadowDeletedCallback == NULL ) &&
+                ( pxCallbackCatalogEntry->ulDeltaHandlerCount == ( uint32_t ) 0 ) )
+            {
+                prvFreeCallbackCatalogEntry( pxShadowClient, pxCallbackCatalogEntry );
+            }
+        }
+    #else /* if ( shadowconfigMAX_DELTA_HANDLERS > 0 ) */
+        ( void ) xShadowClientHandle;
+        ( void ) pcThingName;
+        ( void ) pxHandlers;
+        ( void ) ulHandlerCount;
+        ( void ) xTimeoutTicks;
+    #endif /* shadowconfigMAX_DELTA_HANDLERS */
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
 ShadowReturnCode_t SHADOW_ReturnMQTTBuffer( ShadowClientHandle_t xShadowClientHandle,
                                             MQTTBufferHandle_t xBufferHandle )
 {
@@ -1731,3 +2868,228 @@ ShadowReturnCode_t SHADOW_ReturnMQTTBuffer( ShadowClientHandle_t xShadowClientHa
 
     return xReturn;
 }
+
+/*-----------------------------------------------------------*/
+
+ShadowReturnCode_t SHADOW_ReportedSet( ShadowClientHandle_t xShadowClientHandle,
+                                       const char * const pcKey,
+                                       const char * const pcValue )
+{
+    ShadowReturnCode_t xReturn = eShadowFailure;
+
+    #if ( shadowconfigREPORTED_FIELDS > 0 )
+        ShadowClient_t * pxShadowClient;
+        ShadowReportedField_t * pxField = NULL;
+        BaseType_t xIterator;
+        size_t xKeyLength, xValueLength;
+
+        configASSERT( ( ( BaseType_t ) xShadowClientHandle >= 0 &&
+                        ( BaseType_t ) xShadowClientHandle < shadowconfigMAX_CLIENTS ) ); /*lint !e923 Safe cast from pointer handle. */
+        configASSERT( ( pcKey != NULL ) );
+        configASSERT( ( pcValue != NULL ) );
+
+        pxShadowClient = &( xShadowClients[ ( BaseType_t ) xShadowClientHandle ] );       /*lint !e923 Safe cast from pointer handle. */
+        configASSERT( ( pxShadowClient->xInUse == pdTRUE ) );
+
+        xKeyLength = strlen( pcKey );
+        xValueLength = strlen( pcValue );
+
+        if( ( xKeyLength > ( size_t ) 0 ) &&
+            ( xKeyLength <= ( size_t ) shadowconfigREPORTED_KEY_LENGTH ) &&
+            ( xValueLength > ( size_t ) 0 ) &&
+            ( xValueLength <= ( size_t ) shadowconfigREPORTED_VALUE_LENGTH ) &&
+            ( xSemaphoreTake( pxShadowClient->xReportedMutex, portMAX_DELAY ) == pdPASS ) )
+        {
+            /* Find the field, or else a free entry for it. */
+            for( xIterator = 0; xIterator < shadowconfigREPORTED_FIELDS; xIterator++ )
+            {
+                if( pxShadowClient->xReportedFields[ xIterator ].xInUse == pdFALSE )
+                {
+                    if( pxField == NULL )
+                    {
+                        pxField = &( pxShadowClient->xReportedFields[ xIterator ] );
+                    }
+                }
+                else if( strcmp( pxShadowClient->xReportedFields[ xIterator ].cKey, pcKey ) == 0 )
+                {
+                    pxField = &( pxShadowClient->xReportedFields[ xIterator ] );
+                    break;
+                }
+                else
+                {
+                    /* Another field. */
+                }
+            }
+
+            if( pxField != NULL )
+            {
+                if( pxField->xInUse == pdFALSE )
+                {
+                    pxField->xInUse = pdTRUE;
+                    memcpy( pxField->cKey, pcKey, xKeyLength + ( size_t ) 1 );
+                    pxField->cAcknowledgedValue[ 0 ] = '\0';
+                }
+
+                memcpy( pxField->cValue, pcValue, xValueLength + ( size_t ) 1 );
+
+                /* The coalescing window starts with the first change that has
+                 * not been sent. */
+                if( ( pxShadowClient->xReportedChanged == pdFALSE ) &&
+                    ( strcmp( pxField->cValue, pxField->cAcknowledgedValue ) != 0 ) )
+                {
+                    pxShadowClient->xReportedChanged = pdTRUE;
+                    pxShadowClient->xReportedChangeTicks = xTaskGetTickCount();
+                }
+
+                xReturn = eShadowSuccess;
+            }
+            else
+            {
+                Shadow_debug_printf( ( "[Shadow %d] No room for reported field %s.\r\n",
+                                       ( BaseType_t ) xShadowClientHandle, /*lint !e923 Safe cast from pointer handle. */
+                                       pcKey ) );
+            }
+
+            configASSERT( xSemaphoreGive( pxShadowClient->xReportedMutex ) == pdPASS );
+        }
+    #else /* if ( shadowconfigREPORTED_FIELDS > 0 ) */
+        /* Remove compiler warnings about unused parameters. */
+        ( void ) xShadowClientHandle;
+        ( void ) pcKey;
+        ( void ) pcValue;
+    #endif /* shadowconfigREPORTED_FIELDS */
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+ShadowReturnCode_t SHADOW_ReportedSync( ShadowClientHandle_t xShadowClientHandle,
+                                        const char * const pcThingName,
+                                        TickType_t xTimeoutTicks )
+{
+    ShadowReturnCode_t xReturn = eShadowSuccess;
+
+    #if ( shadowconfigREPORTED_FIELDS > 0 )
+        ShadowClient_t * pxShadowClient;
+        ShadowReportedField_t * pxField;
+        ShadowOperationParams_t xUpdateParams;
+        TimeOut_t xTimeOut;
+        TickType_t xTicksRemaining = xTimeoutTicks;
+        TickType_t xElapsedTicks = 0;
+        const TickType_t xWindowTicks = pdMS_TO_TICKS( shadowconfigREPORTED_COALESCE_MS );
+        BaseType_t xChanged = pdFALSE;
+        BaseType_t xIterator;
+        size_t xDocumentLength = 0;
+
+        configASSERT( ( ( BaseType_t ) xShadowClientHandle >= 0 &&
+                        ( BaseType_t ) xShadowClientHandle < shadowconfigMAX_CLIENTS ) ); /*lint !e923 Safe cast from pointer handle. */
+        configASSERT( ( pcThingName != NULL ) );
+
+        pxShadowClient = &( xShadowClients[ ( BaseType_t ) xShadowClientHandle ] );       /*lint !e923 Safe cast from pointer handle. */
+        configASSERT( ( pxShadowClient->xInUse == pdTRUE ) );
+
+        vTaskSetTimeOutState( &xTimeOut );
+
+        if( xSemaphoreTake( pxShadowClient->xReportedMutex, portMAX_DELAY ) == pdPASS )
+        {
+            xChanged = pxShadowClient->xReportedChanged;
+            xElapsedTicks = xTaskGetTickCount() - pxShadowClient->xReportedChangeTicks;
+            configASSERT( xSemaphoreGive( pxShadowClient->xReportedMutex ) == pdPASS );
+        }
+
+        if( xChanged == pdTRUE )
+        {
+            /* Changes made shortly after the first one go in the same update. */
+            if( xElapsedTicks < xWindowTicks )
+            {
+                vTaskDelay( configMIN( xWindowTicks - xElapsedTicks, xTicksRemaining ) );
+                ( void ) xTaskCheckForTimeOut( &xTimeOut, &xTicksRemaining );
+            }
+
+            if( xSemaphoreTake( pxShadowClient->xReportedMutex, portMAX_DELAY ) == pdPASS )
+            {
+                xDocumentLength = prvReportedBuildDocument( pxShadowClient );
+
+                if( xDocumentLength == ( size_t ) 0 )
+                {
+                    /* The fields were set back to their acknowledged values. */
+                    pxShadowClient->xReportedChanged = pdFALSE;
+                }
+
+                configASSERT( xSemaphoreGive( pxShadowClient->xReportedMutex ) == pdPASS );
+            }
+        }
+
+        if( xDocumentLength > ( size_t ) 0 )
+        {
+            xUpdateParams.pcThingName = pcThingName;
+            xUpdateParams.pcData = ( const char * ) pxShadowClient->ucReportedDocument;
+            xUpdateParams.ulDataLength = ( uint32_t ) xDocumentLength;
+            xUpdateParams.xQoS = eMQTTQoS1;
+
+            /* Reports are expected to be frequent. */
+            xUpdateParams.ucKeepSubscriptions = 1;
+
+            #if ( shadowconfigENABLE_CBOR == 1 )
+                /* The fields are acknowledged from the JSON document, so only
+                 * the copy that is sent is converted. */
+                if( pxShadowClient->xPayloadFormat == eShadowPayloadCBOR )
+                {
+                    xReturn = SHADOW_JSONToCBOR( ( const char * ) pxShadowClient->ucReportedDocument,
+                                                 ( uint32_t ) xDocumentLength,
+                                                 pxShadowClient->ucReportedCBOR,
+                                                 ( uint32_t ) sizeof( pxShadowClient->ucReportedCBOR ),
+                                                 &( xUpdateParams.ulDataLength ) );
+                    xUpdateParams.pcData = ( const char * ) pxShadowClient->ucReportedCBOR;
+                }
+            #endif
+
+            if( xReturn == eShadowSuccess )
+            {
+                xReturn = SHADOW_Update( xShadowClientHandle, &xUpdateParams, xTicksRemaining );
+            }
+
+            if( xSemaphoreTake( pxShadowClient->xReportedMutex, portMAX_DELAY ) == pdPASS )
+            {
+                xChanged = pdFALSE;
+
+                for( xIterator = 0; xIterator < shadowconfigREPORTED_FIELDS; xIterator++ )
+                {
+                    pxField = &( pxShadowClient->xReportedFields[ xIterator ] );
+
+                    /* The value sent, rather than the current one, was accepted. */
+                    if( ( xReturn == eShadowSuccess ) && ( pxField->usDocumentOffset != ( uint16_t ) 0 ) )
+                    {
+                        memcpy( pxField->cAcknowledgedValue,
+                                &( pxShadowClient->ucReportedDocument[ pxField->usDocumentOffset ] ),
+                                ( size_t ) pxField->usDocumentLength );
+                        pxField->cAcknowledgedValue[ pxField->usDocumentLength ] = '\0';
+                    }
+
+                    pxField->usDocumentOffset = 0;
+
+                    if( ( pxField->xInUse == pdTRUE ) &&
+                        ( strcmp( pxField->cValue, pxField->cAcknowledgedValue ) != 0 ) )
+                    {
+                        xChanged = pdTRUE;
+                    }
+                }
+
+                /* Fields that changed during the update, did not fit in it, or
+                 * were rejected are sent by the next call. */
+                pxShadowClient->xReportedChanged = xChanged;
+                configASSERT( xSemaphoreGive( pxShadowClient->xReportedMutex ) == pdPASS );
+            }
+        }
+    #else /* if ( shadowconfigREPORTED_FIELDS > 0 ) */
+        /* Remove compiler warnings about unused parameters. */
+        ( void ) xShadowClientHandle;
+        ( void ) pcThingName;
+        ( void ) xTimeoutTicks;
+
+        xReturn = eShadowFailure;
+    #endif /* shadowconfigREPORTED_FIELDS */
+
+    return xReturn;
+}
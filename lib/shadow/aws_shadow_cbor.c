@@ -0,0 +1,1002 @@
+/*
+ * Amazon FreeRTOS Shadow V1.0.6
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_shadow_cbor.c
+ * @brief CBOR encoding of Shadow documents.
+ *
+ * Shadow documents are JSON on the wire unless a Shadow Client is created with
+ * #eShadowPayloadCBOR. This file holds the CBOR counterparts of the lookups in
+ * aws_shadow_json.c, and converts documents between the two formats so that an
+ * application can keep its documents in one of them.
+ */
+
+/* C library includes. */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* AWS includes. */
+#include "aws_shadow_config.h"
+#include "aws_shadow_config_defaults.h"
+#include "aws_shadow.h"
+
+#if ( shadowconfigENABLE_CBOR == 1 )
+    #include "aws_shadow_cbor.h"
+    #include "aws_json_pull.h"
+    #include "cbor.h"
+
+/* The CBOR keys to search for when looking for the error code and message,
+ * and client token, respectively. */
+    #define shadowCBOR_ERROR_CODE       "code"
+    #define shadowCBOR_ERROR_MESSAGE    "message"
+    #define shadowCBOR_CLIENT_TOKEN     "clientToken"
+
+/* The longest JSON number converted to CBOR, and the longest number written
+ * for a CBOR float. */
+    #define shadowCBOR_NUMBER_LENGTH    ( 32 )
+
+/* The longest integer converted to a CBOR integer. Longer ones are converted
+ * to a double, so that they cannot overflow. */
+    #define shadowCBOR_INTEGER_DIGITS   ( 18 )
+
+/**
+ * @brief The JSON document being written by SHADOW_CBORToJSON.
+ */
+    typedef struct ShadowJSONWriter
+    {
+        char * pcBuffer;
+        size_t xBufferSize;
+        size_t xLength;
+        BaseType_t xOverflow; /* pdTRUE once the document did not fit. */
+    } ShadowJSONWriter_t;
+
+/**
+ * @brief Get the characters of a definite-length text string in place.
+ */
+    static CborError prvCBORGetTextString( const CborValue * pxValue,
+                                           const char ** ppcString,
+                                           size_t * pxLength );
+
+/**
+ * @brief Find a top-level definite-length text string in a CBOR map.
+ *
+ * @return pdPASS if found; ppcValue then points into pucDoc.
+ */
+    static BaseType_t prvCBORGetTopLevelString( const uint8_t * const pucDoc,
+                                                uint32_t ulDocLength,
+                                                const char * const pcKey,
+                                                const char ** ppcValue,
+                                                size_t * pxValueLength );
+
+/**
+ * @brief Decode the escape sequences of a JSON string into UTF-8.
+ */
+    static BaseType_t prvUnescapeJSONString( const char * pcString,
+                                             size_t xLength,
+                                             char * pcOut,
+                                             size_t xOutSize,
+                                             size_t * pxOutLength );
+
+/**
+ * @brief Encode a raw JSON string (without its quotes) as a CBOR text string.
+ */
+    static CborError prvEncodeJSONString( CborEncoder * pxEncoder,
+                                          const char * pcString,
+                                          size_t xLength );
+
+/**
+ * @brief Encode a JSON number, true, false or null.
+ */
+    static CborError prvEncodeJSONPrimitive( CborEncoder * pxEncoder,
+                                             const char * pcPrimitive,
+                                             size_t xLength );
+
+/**
+ * @brief Append to the JSON document; sets xOverflow if it does not fit.
+ */
+    static void prvWriteJSON( ShadowJSONWriter_t * pxWriter,
+                              const char * pcText,
+                              size_t xLength );
+
+/**
+ * @brief Write a CBOR text string as a JSON string and advance past it.
+ */
+    static CborError prvCBORStringToJSON( CborValue * pxValue,
+                                          ShadowJSONWriter_t * pxWriter );
+
+/**
+ * @brief Write a CBOR value as JSON and advance past it.
+ */
+    static CborError prvCBORValueToJSON( CborValue * pxValue,
+                                         ShadowJSONWriter_t * pxWriter,
+                                         BaseType_t xDepth );
+
+/*-----------------------------------------------------------*/
+
+    static CborError prvCBORGetTextString( const CborValue * pxValue,
+                                           const char ** ppcString,
+                                           size_t * pxLength )
+    {
+        CborError xError;
+        size_t xHeaderLength;
+        uint8_t ucAdditionalInfo;
+
+        xError = cbor_value_get_string_length( pxValue, pxLength );
+
+        if( xError == CborNoError )
+        {
+            /* The length follows the initial byte in 0, 1, 2, 4 or 8 bytes. */
+            ucAdditionalInfo = ( uint8_t ) ( pxValue->ptr[ 0 ] & 0x1FU );
+
+            if( ucAdditionalInfo < ( uint8_t ) 24 )
+            {
+                xHeaderLength = 1;
+            }
+            else
+            {
+                xHeaderLength = ( size_t ) 1 + ( ( size_t ) 1 << ( ucAdditionalInfo - ( uint8_t ) 24 ) );
+            }
+
+            *ppcString = ( const char * ) &( pxValue->ptr[ xHeaderLength ] );
+        }
+
+        return xError;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvCBORGetTopLevelString( const uint8_t * const pucDoc,
+                                                uint32_t ulDocLength,
+                                                const char * const pcKey,
+                                                const char ** ppcValue,
+                                                size_t * pxValueLength )
+    {
+        BaseType_t xReturn = pdFAIL;
+        CborParser xParser;
+        CborValue xMap, xValue;
+        size_t xLength = 0;
+
+        if( ( cbor_parser_init( pucDoc, ( size_t ) ulDocLength, 0, &xParser, &xMap ) == CborNoError ) &&
+            ( cbor_value_is_map( &xMap ) == true ) &&
+            ( cbor_value_map_find_value( &xMap, pcKey, &xValue ) == CborNoError ) &&
+            ( cbor_value_is_text_string( &xValue ) == true ) &&
+            ( prvCBORGetTextString( &xValue, ppcValue, &xLength ) == CborNoError ) )
+        {
+            *pxValueLength = xLength;
+            xReturn = pdPASS;
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t SHADOW_CBORDocClientTokenMatch( const uint8_t * const pucDoc1,
+                                               uint32_t ulDoc1Length,
+                                               const uint8_t * const pucDoc2,
+                                               uint32_t ulDoc2Length )
+    {
+        BaseType_t xReturn = pdFAIL;
+        const char * pcClientToken1;
+        const char * pcClientToken2;
+        size_t xClientToken1Length, xClientToken2Length;
+
+        if( ( prvCBORGetTopLevelString( pucDoc1,
+                                        ulDoc1Length,
+                                        shadowCBOR_CLIENT_TOKEN,
+                                        &pcClientToken1,
+                                        &xClientToken1Length ) == pdPASS ) &&
+            ( prvCBORGetTopLevelString( pucDoc2,
+                                        ulDoc2Length,
+                                        shadowCBOR_CLIENT_TOKEN,
+                                        &pcClientToken2,
+                                        &xClientToken2Length ) == pdPASS ) )
+        {
+            if( ( xClientToken1Length == xClientToken2Length ) &&
+                ( memcmp( pcClientToken1, pcClientToken2, xClientToken1Length ) == 0 ) )
+            {
+                xReturn = pdPASS;
+            }
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    int16_t SHADOW_CBORGetErrorCodeAndMessage( const uint8_t * const pucErrorCBOR,
+                                               uint32_t ulErrorCBORLength,
+                                               char ** ppcErrorMessage,
+                                               uint16_t * pusErrorMessageLength )
+    {
+        int16_t sReturn = 0;
+        int lCode = 0;
+        CborParser xParser;
+        CborValue xMap, xValue;
+        const char * pcMessage;
+        size_t xMessageLength;
+
+        if( ( cbor_parser_init( pucErrorCBOR, ( size_t ) ulErrorCBORLength, 0, &xParser, &xMap ) == CborNoError ) &&
+            ( cbor_value_is_map( &xMap ) == true ) &&
+            ( cbor_value_map_find_value( &xMap, shadowCBOR_ERROR_CODE, &xValue ) == CborNoError ) &&
+            ( cbor_value_is_integer( &xValue ) == true ) &&
+            ( cbor_value_get_int( &xValue, &lCode ) == CborNoError ) &&
+            ( lCode > 0 ) && ( lCode <= INT16_MAX ) )
+        {
+            sReturn = ( int16_t ) lCode;
+
+            if( ( ppcErrorMessage != NULL ) && ( pusErrorMessageLength != NULL ) )
+            {
+                *pusErrorMessageLength = 0;
+
+                if( prvCBORGetTopLevelString( pucErrorCBOR,
+                                              ulErrorCBORLength,
+                                              shadowCBOR_ERROR_MESSAGE,
+                                              &pcMessage,
+                                              &xMessageLength ) == pdPASS )
+                {
+                    *ppcErrorMessage = ( char * ) pcMessage;
+                    *pusErrorMessageLength = ( uint16_t ) configMIN( xMessageLength, ( size_t ) UINT16_MAX );
+                }
+            }
+        }
+
+        return sReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvParseHex4( const char * pcHex,
+                                    uint32_t * pulValue )
+    {
+        BaseType_t xReturn = pdPASS;
+        BaseType_t xIndex;
+        uint32_t ulValue = 0;
+        char cDigit;
+
+        for( xIndex = 0; ( xIndex < 4 ) && ( xReturn == pdPASS ); xIndex++ )
+        {
+            cDigit = pcHex[ xIndex ];
+            ulValue <<= 4;
+
+            if( ( cDigit >= '0' ) && ( cDigit <= '9' ) )
+            {
+                ulValue |= ( uint32_t ) ( cDigit - '0' );
+            }
+            else if( ( cDigit >= 'a' ) && ( cDigit <= 'f' ) )
+            {
+                ulValue |= ( uint32_t ) ( cDigit - 'a' + 10 );
+            }
+            else if( ( cDigit >= 'A' ) && ( cDigit <= 'F' ) )
+            {
+                ulValue |= ( uint32_t ) ( cDigit - 'A' + 10 );
+            }
+            else
+            {
+                xReturn = pdFAIL;
+            }
+        }
+
+        *pulValue = ulValue;
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvUnescapeJSONString( const char * pcString,
+                                             size_t xLength,
+                                             char * pcOut,
+                                             size_t xOutSize,
+                                             size_t * pxOutLength )
+    {
+        BaseType_t xReturn = pdPASS;
+        size_t xIn = 0, xOut = 0, xBytes, xIndex;
+        uint32_t ulCodePoint, ulLowSurrogate;
+        uint8_t ucUTF8[ 4 ];
+
+        while( ( xIn < xLength ) && ( xReturn == pdPASS ) )
+        {
+            if( pcString[ xIn ] != '\\' )
+            {
+                /* Raw bytes, including UTF-8 sequences, are copied as they are. */
+                ucUTF8[ 0 ] = ( uint8_t ) pcString[ xIn ];
+                xBytes = 1;
+                xIn++;
+            }
+            else if( xIn + ( size_t ) 1 >= xLength )
+            {
+                xReturn = pdFAIL;
+                xBytes = 0;
+            }
+            else
+            {
+                ulCodePoint = ( uint32_t ) ( uint8_t ) pcString[ xIn + ( size_t ) 1 ];
+                xIn += 2;
+
+                switch( ulCodePoint )
+                {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        break;
+
+                    case 'b':
+                        ulCodePoint = '\b';
+                        break;
+
+                    case 'f':
+                        ulCodePoint = '\f';
+                        break;
+
+                    case 'n':
+                        ulCodePoint = '\n';
+                        break;
+
+                    case 'r':
+                        ulCodePoint = '\r';
+                        break;
+
+                    case 't':
+                        ulCodePoint = '\t';
+                        break;
+
+                    case 'u':
+
+                        if( ( xIn + ( size_t ) 4 > xLength ) ||
+                            ( prvParseHex4( &pcString[ xIn ], &ulCodePoint ) == pdFAIL ) )
+                        {
+                            xReturn = pdFAIL;
+                        }
+                        else
+                        {
+                            xIn += 4;
+
+                            /* Characters outside the BMP are written as a pair
+                             * of surrogates, which must be joined again. */
+                            if( ( ulCodePoint >= 0xD800UL ) && ( ulCodePoint <= 0xDBFFUL ) )
+                            {
+                                if( ( xIn + ( size_t ) 6 <= xLength ) &&
+                                    ( pcString[ xIn ] == '\\' ) &&
+                                    ( pcString[ xIn + ( size_t ) 1 ] == 'u' ) &&
+                                    ( prvParseHex4( &pcString[ xIn + ( size_t ) 2 ], &ulLowSurrogate ) == pdPASS ) &&
+                                    ( ulLowSurrogate >= 0xDC00UL ) && ( ulLowSurrogate <= 0xDFFFUL ) )
+                                {
+                                    ulCodePoint = 0x10000UL + ( ( ulCodePoint - 0xD800UL ) << 10 ) + ( ulLowSurrogate - 0xDC00UL );
+                                    xIn += 6;
+                                }
+                                else
+                                {
+                                    xReturn = pdFAIL;
+                                }
+                            }
+                            else if( ( ulCodePoint >= 0xDC00UL ) && ( ulCodePoint <= 0xDFFFUL ) )
+                            {
+                                xReturn = pdFAIL;
+                            }
+                            else
+                            {
+                                /* A character of the BMP. */
+                            }
+                        }
+
+                        break;
+
+                    default:
+                        xReturn = pdFAIL;
+                        break;
+                }
+
+                /* Encode the character as UTF-8. */
+                if( ulCodePoint < 0x80UL )
+                {
+                    ucUTF8[ 0 ] = ( uint8_t ) ulCodePoint;
+                    xBytes = 1;
+                }
+                else if( ulCodePoint < 0x800UL )
+                {
+                    ucUTF8[ 0 ] = ( uint8_t ) ( 0xC0UL | ( ulCodePoint >> 6 ) );
+                    ucUTF8[ 1 ] = ( uint8_t ) ( 0x80UL | ( ulCodePoint & 0x3FUL ) );
+                    xBytes = 2;
+                }
+                else if( ulCodePoint < 0x10000UL )
+                {
+                    ucUTF8[ 0 ] = ( uint8_t ) ( 0xE0UL | ( ulCodePoint >> 12 ) );
+                    ucUTF8[ 1 ] = ( uint8_t ) ( 0x80UL | ( ( ulCodePoint >> 6 ) & 0x3FUL ) );
+                    ucUTF8[ 2 ] = ( uint8_t ) ( 0x80UL | ( ulCodePoint & 0x3FUL ) );
+                    xBytes = 3;
+                }
+                else
+                {
+                    ucUTF8[ 0 ] = ( uint8_t ) ( 0xF0UL | ( ulCodePoint >> 18 ) );
+                    ucUTF8[ 1 ] = ( uint8_t ) ( 0x80UL | ( ( ulCodePoint >> 12 ) & 0x3FUL ) );
+                    ucUTF8[ 2 ] = ( uint8_t ) ( 0x80UL | ( ( ulCodePoint >> 6 ) & 0x3FUL ) );
+                    ucUTF8[ 3 ] = ( uint8_t ) ( 0x80UL | ( ulCodePoint & 0x3FUL ) );
+                    xBytes = 4;
+                }
+            }
+
+            if( xReturn == pdPASS )
+            {
+                if( xBytes <= xOutSize - xOut )
+                {
+                    for( xIndex = 0; xIndex < xBytes; xIndex++ )
+                    {
+                        pcOut[ xOut ] = ( char ) ucUTF8[ xIndex ];
+                        xOut++;
+                    }
+                }
+                else
+                {
+                    xReturn = pdFAIL;
+                }
+            }
+        }
+
+        *pxOutLength = xOut;
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static CborError prvEncodeJSONString( CborEncoder * pxEncoder,
+                                          const char * pcString,
+                                          size_t xLength )
+    {
+        CborError xError;
+        char cBuffer[ shadowconfigCBOR_STRING_LENGTH ];
+        size_t xDecodedLength = 0;
+
+        if( memchr( pcString, ( int ) '\\', xLength ) == NULL )
+        {
+            /* Most strings have no escapes and are encoded in place. */
+            xError = cbor_encode_text_string( pxEncoder, pcString, xLength );
+        }
+        else if( prvUnescapeJSONString( pcString,
+                                        xLength,
+                                        cBuffer,
+                                        sizeof( cBuffer ),
+                                        &xDecodedLength ) == pdPASS )
+        {
+            xError = cbor_encode_text_string( pxEncoder, cBuffer, xDecodedLength );
+        }
+        else
+        {
+            xError = CborErrorDataTooLarge;
+        }
+
+        return xError;
+    }
+/*-----------------------------------------------------------*/
+
+    static CborError prvEncodeJSONPrimitive( CborEncoder * pxEncoder,
+                                             const char * pcPrimitive,
+                                             size_t xLength )
+    {
+        CborError xError = CborErrorIllegalType;
+        char cNumber[ shadowCBOR_NUMBER_LENGTH ];
+        char * pcEnd = NULL;
+        size_t xDigits;
+        double dValue;
+        long long llValue;
+
+        if( ( xLength == ( size_t ) 4 ) && ( strncmp( pcPrimitive, "true", 4 ) == 0 ) )
+        {
+            xError = cbor_encode_boolean( pxEncoder, true );
+        }
+        else if( ( xLength == ( size_t ) 5 ) && ( strncmp( pcPrimitive, "false", 5 ) == 0 ) )
+        {
+            xError = cbor_encode_boolean( pxEncoder, false );
+        }
+        else if( ( xLength == ( size_t ) 4 ) && ( strncmp( pcPrimitive, "null", 4 ) == 0 ) )
+        {
+            xError = cbor_encode_null( pxEncoder );
+        }
+        else if( xLength < sizeof( cNumber ) )
+        {
+            /* strtoll and strtod need a terminated copy. */
+            ( void ) memcpy( cNumber, pcPrimitive, xLength );
+            cNumber[ xLength ] = '\0';
+            xDigits = ( cNumber[ 0 ] == '-' ) ? ( xLength - ( size_t ) 1 ) : xLength;
+
+            if( ( strpbrk( cNumber, ".eE" ) == NULL ) && ( xDigits <= ( size_t ) shadowCBOR_INTEGER_DIGITS ) )
+            {
+                llValue = strtoll( cNumber, &pcEnd, 10 );
+
+                if( ( xDigits > ( size_t ) 0 ) && ( pcEnd == &cNumber[ xLength ] ) )
+                {
+                    xError = cbor_encode_int( pxEncoder, ( int64_t ) llValue );
+                }
+            }
+            else
+            {
+                dValue = strtod( cNumber, &pcEnd );
+
+                if( ( pcEnd != cNumber ) && ( pcEnd == &cNumber[ xLength ] ) )
+                {
+                    xError = cbor_encode_double( pxEncoder, dValue );
+                }
+            }
+        }
+        else
+        {
+            /* Too long to be a number this file converts. */
+        }
+
+        return xError;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvWriteJSON( ShadowJSONWriter_t * pxWriter,
+                              const char * pcText,
+                              size_t xLength )
+    {
+        if( ( pxWriter->xOverflow == pdFALSE ) &&
+            ( xLength <= pxWriter->xBufferSize - pxWriter->xLength ) )
+        {
+            ( void ) memcpy( &pxWriter->pcBuffer[ pxWriter->xLength ], pcText, xLength );
+            pxWriter->xLength += xLength;
+        }
+        else
+        {
+            pxWriter->xOverflow = pdTRUE;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvWriteJSONInteger( ShadowJSONWriter_t * pxWriter,
+                                     uint64_t ullMagnitude,
+                                     BaseType_t xNegative )
+    {
+        char cDigits[ 21 ];
+        size_t xIndex = sizeof( cDigits );
+
+        /* printf cannot be relied on for 64-bit integers on all toolchains. */
+        do
+        {
+            xIndex--;
+            cDigits[ xIndex ] = ( char ) ( '0' + ( char ) ( ullMagnitude % 10ULL ) );
+            ullMagnitude /= 10ULL;
+        } while( ullMagnitude > 0ULL );
+
+        if( xNegative == pdTRUE )
+        {
+            xIndex--;
+            cDigits[ xIndex ] = '-';
+        }
+
+        prvWriteJSON( pxWriter, &cDigits[ xIndex ], sizeof( cDigits ) - xIndex );
+    }
+/*-----------------------------------------------------------*/
+
+    static CborError prvCBORStringToJSON( CborValue * pxValue,
+                                          ShadowJSONWriter_t * pxWriter )
+    {
+        CborError xError;
+        const char * pcString;
+        size_t xLength = 0, xIndex, xRunStart = 0;
+        char cEscape[ 7 ];
+        uint8_t ucChar;
+
+        xError = prvCBORGetTextString( pxValue, &pcString, &xLength );
+
+        if( xError == CborNoError )
+        {
+            xError = cbor_value_advance( pxValue );
+        }
+
+        if( xError == CborNoError )
+        {
+            prvWriteJSON( pxWriter, "\"", 1 );
+
+            /* Write the characters that need no escape in runs. */
+            for( xIndex = 0; xIndex < xLength; xIndex++ )
+            {
+                ucChar = ( uint8_t ) pcString[ xIndex ];
+
+                if( ( ucChar == ( uint8_t ) '"' ) || ( ucChar == ( uint8_t ) '\\' ) || ( ucChar < ( uint8_t ) 0x20 ) )
+                {
+                    prvWriteJSON( pxWriter, &pcString[ xRunStart ], xIndex - xRunStart );
+
+                    if( ucChar >= ( uint8_t ) 0x20 )
+                    {
+                        cEscape[ 0 ] = '\\';
+                        cEscape[ 1 ] = ( char ) ucChar;
+                        prvWriteJSON( pxWriter, cEscape, 2 );
+                    }
+                    else
+                    {
+                        ( void ) snprintf( cEscape, sizeof( cEscape ), "\\u%04x", ( unsigned int ) ucChar );
+                        prvWriteJSON( pxWriter, cEscape, 6 );
+                    }
+
+                    xRunStart = xIndex + ( size_t ) 1;
+                }
+            }
+
+            prvWriteJSON( pxWriter, &pcString[ xRunStart ], xLength - xRunStart );
+            prvWriteJSON( pxWriter, "\"", 1 );
+        }
+
+        return xError;
+    }
+/*-----------------------------------------------------------*/
+
+    static CborError prvCBORValueToJSON( CborValue * pxValue,
+                                         ShadowJSONWriter_t * pxWriter,
+                                         BaseType_t xDepth )
+    {
+        CborError xError = CborNoError;
+        CborValue xElement;
+        BaseType_t xIsMap, xFirst = pdTRUE, xFixedSize = pdTRUE;
+        uint64_t ullValue = 0;
+        int64_t llValue = 0;
+        bool xBoolean = false;
+        float fValue = 0.0f;
+        double dValue = 0.0;
+        char cNumber[ shadowCBOR_NUMBER_LENGTH ];
+        int lLength;
+
+        switch( cbor_value_get_type( pxValue ) )
+        {
+            case CborMapType:
+            case CborArrayType:
+                xIsMap = ( cbor_value_is_map( pxValue ) == true ) ? pdTRUE : pdFALSE;
+                xFixedSize = pdFALSE;
+
+                /* Recursion is bounded by the depth the JSON parser accepts, so
+                 * that any document converted back can be read again. */
+                if( xDepth >= ( BaseType_t ) jsonpullconfigMAX_DEPTH )
+                {
+                    xError = CborErrorNestingTooDeep;
+                }
+                else
+                {
+                    xError = cbor_value_enter_container( pxValue, &xElement );
+                }
+
+                if( xError == CborNoError )
+                {
+                    prvWriteJSON( pxWriter, ( xIsMap == pdTRUE ) ? "{" : "[", 1 );
+
+                    while( ( xError == CborNoError ) && ( cbor_value_at_end( &xElement ) == false ) )
+                    {
+                        if( xFirst == pdFALSE )
+                        {
+                            prvWriteJSON( pxWriter, ",", 1 );
+                        }
+
+                        xFirst = pdFALSE;
+
+                        if( xIsMap == pdTRUE )
+                        {
+                            /* JSON keys can only be strings. */
+                            if( cbor_value_is_text_string( &xElement ) == false )
+                            {
+                                xError = CborErrorIllegalType;
+                            }
+                            else
+                            {
+                                xError = prvCBORStringToJSON( &xElement, pxWriter );
+                                prvWriteJSON( pxWriter, ":", 1 );
+                            }
+                        }
+
+                        if( xError == CborNoError )
+                        {
+                            xError = prvCBORValueToJSON( &xElement, pxWriter, xDepth + 1 );
+                        }
+                    }
+
+                    if( xError == CborNoError )
+                    {
+                        xError = cbor_value_leave_container( pxValue, &xElement );
+                    }
+
+                    prvWriteJSON( pxWriter, ( xIsMap == pdTRUE ) ? "}" : "]", 1 );
+                }
+
+                break;
+
+            case CborTextStringType:
+                xFixedSize = pdFALSE;
+                xError = prvCBORStringToJSON( pxValue, pxWriter );
+                break;
+
+            case CborIntegerType:
+
+                if( cbor_value_is_unsigned_integer( pxValue ) == true )
+                {
+                    xError = cbor_value_get_uint64( pxValue, &ullValue );
+                    prvWriteJSONInteger( pxWriter, ullValue, pdFALSE );
+                }
+                else
+                {
+                    xError = cbor_value_get_int64_checked( pxValue, &llValue );
+
+                    /* Negate without overflowing for INT64_MIN. */
+                    prvWriteJSONInteger( pxWriter, ( uint64_t ) ( -( llValue + 1 ) ) + 1ULL, pdTRUE );
+                }
+
+                break;
+
+            case CborBooleanType:
+                xError = cbor_value_get_boolean( pxValue, &xBoolean );
+
+                if( xBoolean == true )
+                {
+                    prvWriteJSON( pxWriter, "true", 4 );
+                }
+                else
+                {
+                    prvWriteJSON( pxWriter, "false", 5 );
+                }
+
+                break;
+
+            case CborNullType:
+            case CborUndefinedType:
+                prvWriteJSON( pxWriter, "null", 4 );
+                break;
+
+            case CborFloatType:
+            case CborDoubleType:
+
+                if( cbor_value_is_float( pxValue ) == true )
+                {
+                    xError = cbor_value_get_float( pxValue, &fValue );
+                    dValue = ( double ) fValue;
+                    lLength = snprintf( cNumber, sizeof( cNumber ), "%.9g", dValue );
+                }
+                else
+                {
+                    xError = cbor_value_get_double( pxValue, &dValue );
+                    lLength = snprintf( cNumber, sizeof( cNumber ), "%.17g", dValue );
+                }
+
+                /* JSON has no infinities or NaN; dValue - dValue is only 0 for
+                 * finite values. */
+                if( ( dValue - dValue ) != 0.0 )
+                {
+                    prvWriteJSON( pxWriter, "null", 4 );
+                }
+                else if( ( lLength > 0 ) && ( lLength < ( int ) sizeof( cNumber ) ) )
+                {
+                    prvWriteJSON( pxWriter, cNumber, ( size_t ) lLength );
+                }
+                else
+                {
+                    xError = CborErrorDataTooLarge;
+                }
+
+                break;
+
+            default:
+                /* Byte strings, tags, half floats and other simple values have
+                 * no JSON equivalent. */
+                xError = CborErrorUnsupportedType;
+                break;
+        }
+
+        /* Containers and strings were advanced past above. */
+        if( ( xError == CborNoError ) && ( xFixedSize == pdTRUE ) )
+        {
+            xError = cbor_value_advance_fixed( pxValue );
+        }
+
+        return xError;
+    }
+/*-----------------------------------------------------------*/
+
+    ShadowReturnCode_t SHADOW_JSONToCBOR( const char * const pcJSON,
+                                          uint32_t ulJSONLength,
+                                          uint8_t * const pucCBOR,
+                                          uint32_t ulCBORBufferSize,
+                                          uint32_t * const pulCBORLength )
+    {
+        ShadowReturnCode_t xReturn = eShadowFailure;
+        JSONPullParser_t xParser;
+        JSONPullEvent_t xEvent;
+        JSONPullStatus_t xStatus;
+        CborEncoder xEncoders[ jsonpullconfigMAX_DEPTH + 1 ];
+        size_t xContainerPathLength[ jsonpullconfigMAX_DEPTH ];
+        BaseType_t xContainerIsMap[ jsonpullconfigMAX_DEPTH ];
+        CborError xError = CborNoError;
+        size_t xDepth = 0, xKeyStart;
+
+        configASSERT( ( pcJSON != NULL ) );
+        configASSERT( ( pucCBOR != NULL ) );
+        configASSERT( ( pulCBORLength != NULL ) );
+
+        cbor_encoder_init( &xEncoders[ 0 ], pucCBOR, ( size_t ) ulCBORBufferSize, 0 );
+        JSONPULL_Init( &xParser, NULL, 0 );
+        JSONPULL_SetInput( &xParser, pcJSON, ( size_t ) ulJSONLength );
+
+        xStatus = JSONPULL_Next( &xParser, &xEvent );
+
+        while( ( xStatus == eJSONPullEvent ) && ( xError == CborNoError ) )
+        {
+            /* The members of an object are preceded by their key, which is the
+             * last segment of their path. */
+            if( ( xDepth > ( size_t ) 0 ) &&
+                ( xContainerIsMap[ xDepth - ( size_t ) 1 ] == pdTRUE ) &&
+                ( xEvent.xType != eJSONPullObjectEnd ) )
+            {
+                xKeyStart = xContainerPathLength[ xDepth - ( size_t ) 1 ];
+
+                if( xKeyStart > ( size_t ) 0 )
+                {
+                    /* Skip the '.' after the path of the object. */
+                    xKeyStart++;
+                }
+
+                if( ( xEvent.xPathTooLong == pdTRUE ) || ( xKeyStart > xEvent.xPathLength ) )
+                {
+                    xError = CborErrorDataTooLarge;
+                }
+                else
+                {
+                    xError = prvEncodeJSONString( &xEncoders[ xDepth ],
+                                                  &xEvent.pcPath[ xKeyStart ],
+                                                  xEvent.xPathLength - xKeyStart );
+                }
+            }
+
+            if( xError == CborNoError )
+            {
+                switch( xEvent.xType )
+                {
+                    case eJSONPullObjectStart:
+                    case eJSONPullArrayStart:
+
+                        /* The number of members is not known until the end, so
+                         * containers are written with indefinite length. */
+                        if( xEvent.xType == eJSONPullObjectStart )
+                        {
+                            xError = cbor_encoder_create_map( &xEncoders[ xDepth ],
+                                                              &xEncoders[ xDepth + ( size_t ) 1 ],
+                                                              CborIndefiniteLength );
+                        }
+                        else
+                        {
+                            xError = cbor_encoder_create_array( &xEncoders[ xDepth ],
+                                                                &xEncoders[ xDepth + ( size_t ) 1 ],
+                                                                CborIndefiniteLength );
+                        }
+
+                        xContainerPathLength[ xDepth ] = xEvent.xPathLength;
+                        xContainerIsMap[ xDepth ] = ( xEvent.xType == eJSONPullObjectStart ) ? pdTRUE : pdFALSE;
+                        xDepth++;
+                        break;
+
+                    case eJSONPullObjectEnd:
+                    case eJSONPullArrayEnd:
+                        xDepth--;
+                        xError = cbor_encoder_close_container( &xEncoders[ xDepth ],
+                                                               &xEncoders[ xDepth + ( size_t ) 1 ] );
+                        break;
+
+                    case eJSONPullString:
+                        xError = prvEncodeJSONString( &xEncoders[ xDepth ],
+                                                      xEvent.pcValue,
+                                                      xEvent.xValueLength );
+                        break;
+
+                    case eJSONPullPrimitive:
+                    default:
+                        xError = prvEncodeJSONPrimitive( &xEncoders[ xDepth ],
+                                                         xEvent.pcValue,
+                                                         xEvent.xValueLength );
+                        break;
+                }
+            }
+
+            if( xError == CborNoError )
+            {
+                xStatus = JSONPULL_Next( &xParser, &xEvent );
+            }
+        }
+
+        if( ( xStatus == eJSONPullComplete ) && ( xError == CborNoError ) )
+        {
+            *pulCBORLength = ( uint32_t ) cbor_encoder_get_buffer_size( &xEncoders[ 0 ], pucCBOR );
+            xReturn = eShadowSuccess;
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    ShadowReturnCode_t SHADOW_CBORToJSON( const uint8_t * const pucCBOR,
+                                          uint32_t ulCBORLength,
+                                          char * const pcJSON,
+                                          uint32_t ulJSONBufferSize,
+                                          uint32_t * const pulJSONLength )
+    {
+        ShadowReturnCode_t xReturn = eShadowFailure;
+        ShadowJSONWriter_t xWriter;
+        CborParser xParser;
+        CborValue xValue;
+        CborError xError;
+
+        configASSERT( ( pucCBOR != NULL ) );
+        configASSERT( ( pcJSON != NULL ) );
+        configASSERT( ( pulJSONLength != NULL ) );
+
+        xWriter.pcBuffer = pcJSON;
+        xWriter.xBufferSize = ( size_t ) ulJSONBufferSize;
+        xWriter.xLength = 0;
+        xWriter.xOverflow = pdFALSE;
+
+        xError = cbor_parser_init( pucCBOR, ( size_t ) ulCBORLength, 0, &xParser, &xValue );
+
+        /* Shadow documents are objects, as are all documents of this file. */
+        if( ( xError == CborNoError ) && ( cbor_value_is_map( &xValue ) == true ) )
+        {
+            xError = prvCBORValueToJSON( &xValue, &xWriter, 0 );
+
+            if( ( xError == CborNoError ) && ( xWriter.xOverflow == pdFALSE ) )
+            {
+                *pulJSONLength = ( uint32_t ) xWriter.xLength;
+                xReturn = eShadowSuccess;
+            }
+        }
+
+        return xReturn;
+    }
+
+#else /* if ( shadowconfigENABLE_CBOR == 1 ) */
+
+    ShadowReturnCode_t SHADOW_JSONToCBOR( const char * const pcJSON,
+                                          uint32_t ulJSONLength,
+                                          uint8_t * const pucCBOR,
+                                          uint32_t ulCBORBufferSize,
+                                          uint32_t * const pulCBORLength )
+    {
+        ( void ) pcJSON;
+        ( void ) ulJSONLength;
+        ( void ) pucCBOR;
+        ( void ) ulCBORBufferSize;
+        ( void ) pulCBORLength;
+
+        return eShadowFailure;
+    }
+/*-----------------------------------------------------------*/
+
+    ShadowReturnCode_t SHADOW_CBORToJSON( const uint8_t * const pucCBOR,
+                                          uint32_t ulCBORLength,
+                                          char * const pcJSON,
+                                          uint32_t ulJSONBufferSize,
+                                          uint32_t * const pulJSONLength )
+    {
+        ( void ) pucCBOR;
+        ( void ) ulCBORLength;
+        ( void ) pcJSON;
+        ( void ) ulJSONBufferSize;
+        ( void ) pulJSONLength;
+
+        return eShadowFailure;
+    }
+
+#endif /* if ( shadowconfigENABLE_CBOR == 1 ) */
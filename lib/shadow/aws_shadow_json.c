@@ -34,9 +34,7 @@
 
 /* AWS includes. */
 #include "aws_shadow_json.h"
-
-/* Other includes. */
-#include "jsmn.h"
+#include "aws_json_pull.h"
 
 /* Sockets configuration includes. */
 #include "aws_shadow_config.h"
@@ -55,23 +53,16 @@
 #endif
 
 /**
- * @brief Given a JSON key, get its value. Does not work on arrays or objects.  Returns
- * length of value and sets ppcValue to the start of the value.  Returns 0 on
- * error (key-value does not exist).
+ * @brief Given a top-level JSON key, get its value. Does not work on arrays or
+ * objects. Returns length of value and sets ppcValue to the start of the value.
+ * Returns 0 on error (key-value does not exist).
+ *
+ * The document is read with the JSON pull parser, which stops at the key.
  */
 static uint16_t prvGetJSONValue( const char ** ppcValue,
                                  const char * const pcKey,
                                  const char * const pcDoc,
-                                 jsmntok_t * pxJSMNTokens,
-                                 int16_t sTokensParsed );
-
-/**
- * @brief Wrapper for jsmn functions. Returns negative values (see jsmn error codes) on
- * error.  Returns the number of tokens parsed on success.
- */
-static int16_t prvParseJSON( const char * const pcDoc,
-                             uint32_t ulDocLength,
-                             jsmntok_t * pxJSMNTokens );
+                                 uint32_t ulDocLength );
 
 /*-----------------------------------------------------------*/
 
@@ -80,49 +71,33 @@ BaseType_t SHADOW_JSONDocClientTokenMatch( const char * const pcDoc1,
                                            const char * const pcDoc2,
                                            uint32_t ulDoc2Length )
 {
-    jsmntok_t pxJSMNTokens[ shadowconfigJSON_JSMN_TOKENS ];
     BaseType_t xReturn = pdFAIL;
     uint16_t usClientToken1Length, usClientToken2Length;
-    int16_t sNbTokens;
-    char * pcClientToken1;
-    char * pcClientToken2;
+    const char * pcClientToken1;
+    const char * pcClientToken2;
 
-    /* Parse pcDoc1 with jsmn. */
-    sNbTokens = prvParseJSON( pcDoc1, ulDoc1Length, pxJSMNTokens );
+    /* Attempt to find the "clientToken" string in pcDoc1. */
+    usClientToken1Length = prvGetJSONValue( &pcClientToken1,
+                                            shadowJSON_CLIENT_TOKEN,
+                                            pcDoc1,
+                                            ulDoc1Length );
 
-    if( sNbTokens > 0 )
+    if( usClientToken1Length > ( uint16_t ) 0 )
     {
-        /* Attempt to find the "clientToken" string in parsed pcDoc1. */
-        usClientToken1Length = prvGetJSONValue( ( const char ** ) &pcClientToken1,
+        /* If "clientToken" was found in pcDoc1, attempt to find "clientToken" in pcDoc2. */
+        usClientToken2Length = prvGetJSONValue( &pcClientToken2,
                                                 shadowJSON_CLIENT_TOKEN,
-                                                pcDoc1,
-                                                ( jsmntok_t * ) pxJSMNTokens,
-                                                sNbTokens );
+                                                pcDoc2,
+                                                ulDoc2Length );
 
-        if( usClientToken1Length > ( uint16_t ) 0 )
+        /* Compare the client tokens. */
+        if( usClientToken2Length == usClientToken1Length )
         {
-            /* Parse pcDoc2 with jsmn. */
-            sNbTokens = prvParseJSON( pcDoc2, ulDoc2Length, pxJSMNTokens );
-
-            if( sNbTokens > 0 )
+            if( strncmp( pcClientToken1,
+                         pcClientToken2,
+                         ( size_t ) usClientToken1Length ) == 0 )
             {
-                /* If "clientToken" was found in pcDoc1, attempt to find "clientToken" in pcDoc2. */
-                usClientToken2Length = prvGetJSONValue( ( const char ** ) &pcClientToken2,
-                                                        shadowJSON_CLIENT_TOKEN,
-                                                        pcDoc2,
-                                                        ( jsmntok_t * ) pxJSMNTokens,
-                                                        sNbTokens );
-
-                /* Compare the client tokens. */
-                if( usClientToken2Length == usClientToken1Length )
-                {
-                    if( strncmp( ( const char * ) pcClientToken1,
-                                 ( const char * ) pcClientToken2,
-                                 ( size_t ) usClientToken1Length ) == 0 )
-                    {
-                        xReturn = pdPASS;
-                    }
-                }
+                xReturn = pdPASS;
             }
         }
     }
@@ -136,66 +111,32 @@ int16_t SHADOW_JSONGetErrorCodeAndMessage( const char * const pcErrorJSON,
                                            char ** ppcErrorMessage,
                                            uint16_t * pusErrorMessageLength )
 {
-    jsmntok_t pxJSMNTokens[ shadowconfigJSON_JSMN_TOKENS ];
-    char * pcErrorCode;
-    int16_t sReturn = 0;
-    int16_t sTokensParsed;
+    const char * pcErrorCode;
+    int16_t sReturn;
 
-    sTokensParsed = prvParseJSON( pcErrorJSON, ulErrorJSONLength, pxJSMNTokens );
+    /* Attempt to find the error code. */
+    sReturn = ( int16_t ) prvGetJSONValue( &pcErrorCode,
+                                           shadowJSON_ERROR_CODE,
+                                           pcErrorJSON,
+                                           ulErrorJSONLength );
 
-    if( sTokensParsed > 0 )
+    if( sReturn > 0 )
     {
-        /* Attempt to find the error code. */
-        sReturn = ( int16_t ) prvGetJSONValue( ( const char ** ) &pcErrorCode,
-                                               shadowJSON_ERROR_CODE,
-                                               pcErrorJSON,
-                                               pxJSMNTokens,
-                                               sTokensParsed );
-
-        if( sReturn > 0 )
-        {
-            /* Convert the error code to int16_t for return value. */
-            sReturn = ( int16_t ) strtol( pcErrorCode, NULL, 0 );
+        /* Convert the error code to int16_t for return value. */
+        sReturn = ( int16_t ) strtol( pcErrorCode, NULL, 0 );
 
-            if( ( ppcErrorMessage != NULL ) && ( pusErrorMessageLength != NULL ) )
-            {
-                /* Set the pointer to the error message and the error message length. */
-                *pusErrorMessageLength = prvGetJSONValue( ( const char ** ) ppcErrorMessage,
-                                                          shadowJSON_ERROR_MESSAGE,
-                                                          pcErrorJSON,
-                                                          pxJSMNTokens,
-                                                          sTokensParsed );
-            }
+        if( ( ppcErrorMessage != NULL ) && ( pusErrorMessageLength != NULL ) )
+        {
+            /* Set the pointer to the error message and the error message length. */
+            *pusErrorMessageLength = prvGetJSONValue( ( const char ** ) ppcErrorMessage,
+                                                      shadowJSON_ERROR_MESSAGE,
+                                                      pcErrorJSON,
+                                                      ulErrorJSONLength );
         }
     }
     else
     {
-        /* On failure, sTokenParsed returns a jsmn error code.  Return this error code. */
-        sReturn = sTokensParsed;
-    }
-
-    return sReturn;
-}
-/*-----------------------------------------------------------*/
-
-static int16_t prvParseJSON( const char * const pcDoc,
-                             uint32_t ulDocLength,
-                             jsmntok_t * pxJSMNTokens )
-{
-    jsmn_parser xJSMNParser;
-    int16_t sReturn;
-
-    jsmn_init( &xJSMNParser );
-    sReturn = ( int16_t ) jsmn_parse( &xJSMNParser,
-                                      pcDoc,
-                                      ulDocLength,
-                                      pxJSMNTokens,
-                                      shadowconfigJSON_JSMN_TOKENS );
-
-    /* Report errors in JSON parsing. */
-    if( sReturn < 0 )
-    {
-        Shadow_json_debug_printf( ( "[Shadow JSON]: Error parsing JSON: JSMN error code %d\r\n", sReturn ) );
+        Shadow_json_debug_printf( ( "[Shadow JSON]: No error code in document.\r\n" ) );
     }
 
     return sReturn;
@@ -205,46 +146,37 @@ static int16_t prvParseJSON( const char * const pcDoc,
 static uint16_t prvGetJSONValue( const char ** ppcValue,
                                  const char * const pcKey,
                                  const char * const pcDoc,
-                                 jsmntok_t * pxJSMNTokens,
-                                 int16_t sTokensParsed )
+                                 uint32_t ulDocLength )
 {
-    jsmntok_t * pxJSMNToken;
     uint16_t usReturn = 0;
-    int16_t sIterator;
-    uint16_t usCompareLength;
-    BaseType_t xValueFound = pdFALSE;
+    JSONPullParser_t xParser;
+    JSONPullEvent_t xEvent;
+    BaseType_t xKeyFound = pdFALSE;
 
-    if( ppcValue != NULL )
+    if( ( ppcValue != NULL ) && ( pcDoc != NULL ) )
     {
-        /* "clientToken" is usually (but not guaranteed to be) the last key in the Shadow JSON document.
-         * Since this function is primarily used to find "clientToken", find "clientToken" faster
-         * by starting from the end. */
-        for( sIterator = ( sTokensParsed - 1 ); sIterator >= 0; sIterator-- )
-        {
-            pxJSMNToken = &( pxJSMNTokens[ sIterator ] );
-            usCompareLength = configMAX( ( ( uint16_t ) pxJSMNToken->end - ( uint16_t ) pxJSMNToken->start ),
-                                         ( ( uint16_t ) strlen( pcKey ) ) );
+        /* The whole document is one chunk, so no scratch buffer is needed. */
+        JSONPULL_Init( &xParser, NULL, 0 );
+        JSONPULL_SetInput( &xParser, pcDoc, ( size_t ) ulDocLength );
 
-            /* Compare pcKey with the keys in the JSON document. */
-            if( ( ( strncmp( pcKey, pcDoc + pxJSMNToken->start, usCompareLength ) ) == 0 ) && ( pxJSMNToken->size == 1 ) )
+        while( ( xKeyFound == pdFALSE ) && ( JSONPULL_Next( &xParser, &xEvent ) == eJSONPullEvent ) )
+        {
+            /* Only strings and primitives are values here. */
+            if( ( ( xEvent.xType == eJSONPullString ) || ( xEvent.xType == eJSONPullPrimitive ) ) &&
+                ( JSONPULL_PathMatch( &xEvent, pcKey ) == pdTRUE ) )
             {
-                /* The JSON value is the next jsmn token after the key. */
-                pxJSMNToken++;
+                xKeyFound = pdTRUE;
 
                 /* Set the pointer to the value and the value's length. */
-                *ppcValue = ( const char * ) ( pcDoc + pxJSMNToken->start );
-                usReturn = ( uint16_t ) pxJSMNToken->end - ( uint16_t ) pxJSMNToken->start;
-                xValueFound = pdTRUE;
-                break;
+                if( xEvent.xValueLength <= ( size_t ) UINT16_MAX )
+                {
+                    *ppcValue = xEvent.pcValue;
+                    usReturn = ( uint16_t ) xEvent.xValueLength;
+                }
             }
         }
     }
 
-    if( xValueFound == pdFALSE )
-    {
-        usReturn = 0;
-    }
-
     return usReturn;
 }
 /*-----------------------------------------------------------*/
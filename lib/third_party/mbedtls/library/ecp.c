@@ -545,6 +545,15 @@ void mbedtls_ecp_point_init( mbedtls_ecp_point *pt )
     mbedtls_mpi_init( &pt->Z );
 }
 
+/*
+ * A group may point to a comb table of its base point in flash (see
+ * ecp_curves.c), which it does not own; those are marked by T_size 0
+ */
+static int ecp_group_is_static_comb_table( const mbedtls_ecp_group *grp )
+{
+    return( grp->T != NULL && grp->T_size == 0 );
+}
+
 /*
  * Initialize (the components of) a group
  */
@@ -613,7 +622,7 @@ void mbedtls_ecp_group_free( mbedtls_ecp_group *grp )
         mbedtls_mpi_free( &grp->N );
     }
 
-    if( grp->T != NULL )
+    if( grp->T != NULL && !ecp_group_is_static_comb_table( grp ) )
     {
         for( i = 0; i < grp->T_size; i++ )
             mbedtls_ecp_point_free( &grp->T[i] );
@@ -116,8 +116,10 @@ $(NAME)_SOURCES :=  $(AMAZON_FREERTOS_LIB_PATH)lib/bufferpool/aws_bufferpool_sta
                     $(AMAZON_FREERTOS_LIB_PATH)lib/secure_sockets/portable/lwip/aws_secure_sockets.c \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/shadow/aws_shadow.c                                   \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/shadow/aws_shadow_json.c                              \
+                    $(AMAZON_FREERTOS_LIB_PATH)lib/shadow/aws_shadow_cbor.c                              \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/tls/aws_tls.c                                         \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/utils/aws_system_init.c                               \
+                    $(AMAZON_FREERTOS_LIB_PATH)lib/utils/aws_json_pull.c                                 \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/wifi/portable/cypress/$(PLATFORM)/aws_wifi.c     \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/pkcs11/mbedtls/aws_pkcs11_mbedtls.c \
                     $(AMAZON_FREERTOS_LIB_PATH)lib/crypto/aws_crypto.c \
@@ -9,7 +9,10 @@ global-cflags-y += -I$(d)/../../../../../../../../third_party/jsmn \
 libawsota-objs-y := \
 		../../../../../../../../ota/portable/marvell/mw300_rd/aws_ota_pal.c \
 		../../../../../../../../ota/aws_ota_agent.c \
-		../../../../../../../../ota/aws_ota_cbor.c 
+		../../../../../../../../ota/aws_ota_cbor.c \
+		../../../../../../../../ota/aws_ota_decompress.c \
+		../../../../../../../../ota/aws_ota_delta.c \
+		../../../../../../../../ota/aws_ota_http.c
 
 libawsota-supported-toolchain-y := arm_gcc iar
 
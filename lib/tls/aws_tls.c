@@ -31,6 +31,7 @@
 #include "aws_pkcs11.h"
 #include "aws_pkcs11_config.h"
 #include "task.h"
+#include "semphr.h"
 #include "aws_clientcredential_keys.h"
 #include "aws_default_root_certificates.h"
 
@@ -43,6 +44,7 @@
 #include "mbedtls/pk.h"
 #include "mbedtls/pk_internal.h"
 #include "mbedtls/debug.h"
+#include "mbedtls/ssl_internal.h"
 #ifdef MBEDTLS_DEBUG_C
     #define tlsDEBUG_VERBOSE    4
 #endif
@@ -52,12 +54,357 @@
 #include <time.h>
 #include <stdio.h>
 
+/**
+ * @brief Size of the arena from which the allocations of TLS_Connect() are
+ * served.
+ *
+ * The certificate parsing and the handshake make many short-lived allocations
+ * that fragment the heap.  When non-zero, and configUSE_TASK_ARENAS is 1, each
+ * TLS context obtains one block of this size at TLS_Init(), which is bound to
+ * the calling task during TLS_Connect() and released at TLS_Cleanup().  When
+ * the arena is full, the heap is used.
+ */
+#ifndef tlsconfigCONNECT_ARENA_SIZE
+    #define tlsconfigCONNECT_ARENA_SIZE    0
+#endif
+
+#if ( configUSE_TASK_ARENAS == 1 ) && ( tlsconfigCONNECT_ARENA_SIZE > 0 )
+    #define tlsUSE_CONNECT_ARENA    1
+#else
+    #define tlsUSE_CONNECT_ARENA    0
+#endif
+
+/**
+ * @brief Number of TLS sessions kept in RAM for resumption.
+ *
+ * A full handshake verifies the server certificate chain and signs with the
+ * device private key through PKCS#11, which takes seconds on small cores.
+ * When non-zero, the session negotiated with each destination is saved after
+ * a successful handshake and the next TLS_Connect() to the same destination
+ * offers it (session ID or session ticket) for an abbreviated handshake.  The
+ * least recently used session is replaced when the cache is full.  0 disables
+ * resumption, and session tickets are then not requested.
+ */
+#ifndef tlsconfigSESSION_CACHE_SIZE
+    #define tlsconfigSESSION_CACHE_SIZE    0
+#endif
+
+/**
+ * @brief Longest destination name, in bytes, for which a session is cached.
+ */
+#ifndef tlsconfigSESSION_CACHE_NAME_LENGTH
+    #define tlsconfigSESSION_CACHE_NAME_LENGTH    64
+#endif
+
+/**
+ * @brief Largest record payload, in bytes, that the server is asked to send.
+ *
+ * When non-zero, the ClientHello carries the max_fragment_length extension
+ * (RFC 6066) with this value, which must be 512, 1024, 2048 or 4096.  Servers
+ * that support the extension then send records no larger than this, and
+ * records sent by TLS_Send() and TLS_SendV() are limited to it, so that
+ * MBEDTLS_SSL_IN_CONTENT_LEN and MBEDTLS_SSL_OUT_CONTENT_LEN can be lowered
+ * to match when every server in use honours the extension.  0 leaves records
+ * at the mbedTLS maximum.
+ */
+#ifndef tlsconfigMAX_FRAGMENT_LENGTH
+    #define tlsconfigMAX_FRAGMENT_LENGTH    0
+#endif
+
+/**
+ * @brief Elliptic curve operations after which the handshake pauses.
+ *
+ * When non-zero, mbedTLS must be built with MBEDTLS_ECP_RESTARTABLE.  The
+ * handshake of ECDHE-ECDSA cipher suites then computes its elliptic curve
+ * operations in steps of this many, and signs with the device key through
+ * PKCS11_SignAsyncStart() and PKCS11_SignAsyncPoll(), so that the PKCS#11
+ * session is not held for the whole signature.  TLS_Connect() yields between
+ * steps.  0 performs each operation in one go.
+ */
+#ifndef tlsconfigECP_MAX_OPS
+    #define tlsconfigECP_MAX_OPS    0
+#endif
+
+#if ( tlsconfigECP_MAX_OPS > 0 ) && !defined( MBEDTLS_ECP_RESTARTABLE )
+    #error "tlsconfigECP_MAX_OPS requires MBEDTLS_ECP_RESTARTABLE"
+#endif
+
+/**
+ * @brief Set to 1 to send application data before the server Finished
+ * message (TLS False Start, RFC 7918).
+ *
+ * A full handshake then returns from TLS_Connect() once the client Finished
+ * message is sent, so the first request, such as an MQTT CONNECT, goes out one
+ * round trip earlier. The server Finished message is checked by the first
+ * TLS_Recv(), before any data is returned. Only forward secret ECDHE key
+ * exchanges with AEAD ciphers false start; resumed sessions and DTLS complete
+ * the handshake as usual.
+ */
+#ifndef tlsconfigENABLE_FALSE_START
+    #define tlsconfigENABLE_FALSE_START    0
+#endif
+
+/**
+ * @brief Set to 1 to time the phases of TLS_Connect(), for
+ * TLS_GetConnectTimings().
+ */
+#ifndef tlsconfigENABLE_CONNECT_TIMING
+    #define tlsconfigENABLE_CONNECT_TIMING    0
+#endif
+
+/**
+ * @brief Set to 1 to also log the phase times at the end of every
+ * TLS_Connect().  Requires tlsconfigENABLE_CONNECT_TIMING.
+ */
+#ifndef tlsconfigLOG_CONNECT_TIMING
+    #define tlsconfigLOG_CONNECT_TIMING    0
+#endif
+
+/**
+ * @brief Time source of the connect timing.
+ *
+ * Ports should map this to a cycle or microsecond counter when ticks are too
+ * coarse.
+ */
+#ifndef tlsconfigTIMESTAMP
+    #define tlsconfigTIMESTAMP()    ( ( uint32_t ) xTaskGetTickCount() )
+#endif
+
+#if ( tlsconfigLOG_CONNECT_TIMING == 1 ) && ( tlsconfigENABLE_CONNECT_TIMING != 1 )
+    #error "tlsconfigLOG_CONNECT_TIMING requires tlsconfigENABLE_CONNECT_TIMING"
+#endif
+
+/**
+ * @brief Set to 0 when the MCU has no AES acceleration.
+ *
+ * mbedTLS prefers AES-256 suites, which in software run 40% more rounds than
+ * AES-128 and are far slower than ChaCha20-Poly1305.  When 0, TLS_Connect()
+ * offers ChaCha20-Poly1305 first, when mbedTLS is built with it, then AES-128
+ * before AES-256.  Boards without AES acceleration set the SOFTWARE_AES board
+ * metadata in cmake/vendors to get this.
+ */
+#ifndef tlsconfigHARDWARE_AES
+    #define tlsconfigHARDWARE_AES    1
+#endif
+
+/**
+ * @brief Cipher suites offered by TLS_Connect(), most preferred first.
+ *
+ * A brace-enclosed list of MBEDTLS_TLS_* suites ending in 0.  Takes the place
+ * of the list chosen by tlsconfigHARDWARE_AES when defined.
+ */
+#if !defined( tlsconfigCIPHERSUITES ) && ( tlsconfigHARDWARE_AES == 0 )
+
+/* Suites that mbedTLS is built without are skipped when the ClientHello is
+ * written, so ChaCha20-Poly1305 can be listed unconditionally. */
+    #define tlsconfigCIPHERSUITES                               \
+    {                                                           \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256, \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,   \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,       \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,         \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,       \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,         \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,       \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,         \
+        MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,               \
+        MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA256,               \
+        MBEDTLS_TLS_RSA_WITH_AES_256_GCM_SHA384,               \
+        0                                                       \
+    }
+#endif
+
+/**
+ * @brief Number of TLS contexts kept for reuse.
+ *
+ * When non-zero, TLS_Init() hands out contexts from a static pool and
+ * TLS_Cleanup() returns them there, keeping their connect arena and gathered
+ * send buffer allocated for the next connection. Short-lived connections then
+ * stop churning the heap. When the pool is empty, contexts are allocated as
+ * usual. 0 allocates every context.
+ */
+#ifndef tlsconfigCONTEXT_POOL_SIZE
+    #define tlsconfigCONTEXT_POOL_SIZE    0
+#endif
+
+/**
+ * @brief Set to 1 to parse the default root certificates once and share them.
+ *
+ * Otherwise every TLS_Connect() without its own server certificate decodes
+ * and parses the default roots again, and frees them after the handshake.
+ * Shorthand for a tlsconfigCA_STORE_SIZE of 1.
+ */
+#ifndef tlsconfigSHARE_DEFAULT_CA_CHAIN
+    #define tlsconfigSHARE_DEFAULT_CA_CHAIN    0
+#endif
+
+/**
+ * @brief Number of distinct sets of root certificates kept parsed.
+ *
+ * Connections with the same roots, the defaults or the same
+ * SOCKETS_SO_TRUSTED_SERVER_CERTIFICATE contents, share one read-only,
+ * reference-counted parsed chain, so they skip PEM decoding and do not hold
+ * a copy each. Sets are matched by their SHA-256, as each socket keeps its
+ * own copy of the PEM. An unreferenced set stays parsed until its entry is
+ * needed for another one. DER certificates are accepted too and skip the
+ * Base64 decoding. 0 parses the roots for every connection.
+ */
+#ifndef tlsconfigCA_STORE_SIZE
+    #define tlsconfigCA_STORE_SIZE    tlsconfigSHARE_DEFAULT_CA_CHAIN
+#endif
+
+/**
+ * @brief Number of verified server certificate chains remembered.
+ *
+ * When non-zero, a chain that passed verification is remembered by the
+ * SHA-256 of the chain, the destination name and the trusted roots. A later
+ * handshake presenting the same chain to the same destination then skips the
+ * signature checks, while the validity period of every certificate is still
+ * checked on each use. A chain that is not found is verified in full. The
+ * least recently used chain is replaced when the cache is full. 0 verifies
+ * every chain.
+ */
+#ifndef tlsconfigVERIFY_CACHE_SIZE
+    #define tlsconfigVERIFY_CACHE_SIZE    0
+#endif
+
+/**
+ * @brief Shortest and longest wait, in milliseconds, for the reply to a DTLS
+ * handshake flight.
+ *
+ * The flight is sent again when the wait is over, and the wait doubles each
+ * time until the handshake fails past the longest. A flight is also sent again
+ * whenever the network receive callback returns 0, so the receive timeout of
+ * the socket should not be longer than tlsconfigDTLS_HANDSHAKE_TIMEOUT_MIN.
+ */
+#ifndef tlsconfigDTLS_HANDSHAKE_TIMEOUT_MIN
+    #define tlsconfigDTLS_HANDSHAKE_TIMEOUT_MIN    1000
+#endif
+
+#ifndef tlsconfigDTLS_HANDSHAKE_TIMEOUT_MAX
+    #define tlsconfigDTLS_HANDSHAKE_TIMEOUT_MAX    60000
+#endif
+
+/**
+ * @brief Largest datagram, in bytes, sent by a DTLS connection.
+ *
+ * Larger handshake messages, such as the client certificate, are split into
+ * fragments. FreeRTOS+TCP does not reassemble IP fragments, so the default
+ * leaves room for the IP and UDP headers in ipconfigNETWORK_MTU. 0 lets
+ * mbedTLS send datagrams of any size.
+ */
+#ifndef tlsconfigDTLS_MTU
+    #if defined( ipconfigNETWORK_MTU )
+        #define tlsconfigDTLS_MTU    ( ipconfigNETWORK_MTU - 28 )
+    #else
+        #define tlsconfigDTLS_MTU    0
+    #endif
+#endif
+
+#if ( tlsconfigMAX_FRAGMENT_LENGTH > 0 )
+    #if !defined( MBEDTLS_SSL_MAX_FRAGMENT_LENGTH )
+        #error "tlsconfigMAX_FRAGMENT_LENGTH requires MBEDTLS_SSL_MAX_FRAGMENT_LENGTH"
+    #endif
+
+    #if ( tlsconfigMAX_FRAGMENT_LENGTH == 512 )
+        #define tlsMAX_FRAGMENT_LENGTH_CODE    MBEDTLS_SSL_MAX_FRAG_LEN_512
+    #elif ( tlsconfigMAX_FRAGMENT_LENGTH == 1024 )
+        #define tlsMAX_FRAGMENT_LENGTH_CODE    MBEDTLS_SSL_MAX_FRAG_LEN_1024
+    #elif ( tlsconfigMAX_FRAGMENT_LENGTH == 2048 )
+        #define tlsMAX_FRAGMENT_LENGTH_CODE    MBEDTLS_SSL_MAX_FRAG_LEN_2048
+    #elif ( tlsconfigMAX_FRAGMENT_LENGTH == 4096 )
+        #define tlsMAX_FRAGMENT_LENGTH_CODE    MBEDTLS_SSL_MAX_FRAG_LEN_4096
+    #else
+        #error "tlsconfigMAX_FRAGMENT_LENGTH must be 0, 512, 1024, 2048 or 4096"
+    #endif
+#endif
+
+#if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+
+    /**
+     * @brief A saved TLS session.
+     *
+     * @param[out] cDestination Server the session was negotiated with.
+     * @param[out] xDatagram pdTRUE for a DTLS session.
+     * @param[out] xSession Session state, as copied out of mbedTLS.
+     * @param[out] xLastUsed Tick count of the last save or resumption.
+     * @param[out] xValid pdTRUE when the entry holds a session.
+     */
+    typedef struct TLSSessionCacheEntry
+    {
+        char cDestination[ tlsconfigSESSION_CACHE_NAME_LENGTH + 1 ];
+        BaseType_t xDatagram;
+        mbedtls_ssl_session xSession;
+        TickType_t xLastUsed;
+        BaseType_t xValid;
+    } TLSSessionCacheEntry_t;
+
+    static TLSSessionCacheEntry_t xSessionCache[ tlsconfigSESSION_CACHE_SIZE ];
+
+    /* Serializes access to xSessionCache between connecting tasks. */
+    static SemaphoreHandle_t xSessionCacheMutex = NULL;
+#endif
+
+#if ( tlsconfigCA_STORE_SIZE > 0 )
+
+    /**
+     * @brief Length of the key of a CA store entry.
+     */
+    #define tlsCA_STORE_DIGEST_LENGTH    32
+
+    /**
+     * @brief A parsed set of root certificates, shared by the connections
+     * that trust it.
+     *
+     * @param[out] pucDigest SHA-256 of the certificates, zero for the defaults.
+     * @param[out] ulLength Length of the certificates.
+     * @param[out] ulRefCount Number of contexts using xChain.
+     * @param[out] ulAge Order in which the entries were parsed.
+     * @param[out] xParsed pdTRUE when xChain holds the certificates.
+     * @param[out] xChain The parsed certificates.
+     */
+    typedef struct TLSCAStoreEntry
+    {
+        uint8_t pucDigest[ tlsCA_STORE_DIGEST_LENGTH ];
+        uint32_t ulLength;
+        uint32_t ulRefCount;
+        uint32_t ulAge;
+        BaseType_t xParsed;
+        mbedtls_x509_crt xChain;
+    } TLSCAStoreEntry_t;
+#endif
+
+#if ( tlsconfigVERIFY_CACHE_SIZE > 0 )
+
+    /**
+     * @brief Length of the key of a verification cache entry.
+     */
+    #define tlsVERIFY_CACHE_DIGEST_LENGTH    32
+
+    /**
+     * @brief A server certificate chain that passed verification.
+     *
+     * @param[out] pucDigest SHA-256 of the destination, the chain and the roots.
+     * @param[out] xLastUsed Tick count of the last verification or use.
+     * @param[out] xValid pdTRUE when the entry holds a chain.
+     */
+    typedef struct TLSVerifyCacheEntry
+    {
+        uint8_t pucDigest[ tlsVERIFY_CACHE_DIGEST_LENGTH ];
+        TickType_t xLastUsed;
+        BaseType_t xValid;
+    } TLSVerifyCacheEntry_t;
+
+    static TLSVerifyCacheEntry_t xVerifyCache[ tlsconfigVERIFY_CACHE_SIZE ];
+#endif
+
 /**
  * @brief Internal context structure.
  *
  * @param[in] pcDestination Server location, can be a DNS name or IP address.
  * @param[in] pcServerCertificate Server X.509 certificate in PEM format to trust.
  * @param[in] ulServerCertificateLength Length in bytes of the server certificate.
+ * @param[in] xDatagram pdTRUE to use DTLS.
  * @param[in] xNetworkRecv Callback for receiving data on an open TCP socket.
  * @param[in] xNetworkSend Callback for sending data on an open TCP socket.
  * @param[in] pvCallerContext Opaque pointer provided by caller for above callbacks.
@@ -70,6 +417,15 @@
  * @param[out] xP11FunctionList PKCS#11 function list structure.
  * @param[out] xP11Session PKCS#11 session context.
  * @param[out] xP11PrivateKey PKCS#11 private key context.
+ * @param[out] pucSendVBuffer Buffer used by TLS_SendV to gather data into records.
+ * @param[out] xSendVBufferLength Length in bytes of pucSendVBuffer.
+ * @param[out] pucArenaStorage Storage of the arena used by TLS_Connect.
+ * @param[out] xArenaBuffer Arena structure.
+ * @param[out] xArena Handle of the arena, or NULL if it could not be allocated.
+ * @param[out] xFalseStarted pdTRUE while the server Finished message is still to be read.
+ * @param[out] xTimerStart Tick count when the DTLS retransmission timer was set.
+ * @param[out] ulTimerIntermediateMs Intermediate delay of the timer.
+ * @param[out] ulTimerFinalMs Final delay of the timer, 0 if it is cancelled.
  */
 typedef struct TLSContext
 {
@@ -78,6 +434,7 @@ typedef struct TLSContext
     uint32_t ulServerCertificateLength;
     const char ** ppcAlpnProtocols;
     uint32_t ulAlpnProtocolsCount;
+    BaseType_t xDatagram;
 
     NetworkRecv_t xNetworkRecv;
     NetworkSend_t xNetworkSend;
@@ -96,8 +453,57 @@ typedef struct TLSContext
     CK_FUNCTION_LIST_PTR xP11FunctionList;
     CK_SESSION_HANDLE xP11Session;
     CK_OBJECT_HANDLE xP11PrivateKey;
+
+    /* Gathered send. */
+    unsigned char * pucSendVBuffer;
+    size_t xSendVBufferLength;
+
+    #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+        /* Phase times of the last TLS_Connect. */
+        TLSConnectTimings_t xTimings;
+    #endif
+
+    #if ( tlsUSE_CONNECT_ARENA == 1 )
+        /* Arena for the allocations of TLS_Connect. */
+        uint8_t * pucArenaStorage;
+        StaticTaskArena_t xArenaBuffer;
+        TaskArenaHandle_t xArena;
+    #endif
+
+    #if ( tlsconfigCONTEXT_POOL_SIZE > 0 )
+        /* pdTRUE when the context belongs to xContextPool. */
+        BaseType_t xPooled;
+    #endif
+
+    #if ( tlsconfigCA_STORE_SIZE > 0 )
+        /* The shared root certificates, or NULL to parse xMbedX509CA. */
+        TLSCAStoreEntry_t * pxCAStoreEntry;
+    #endif
+
+    #if ( tlsconfigENABLE_FALSE_START == 1 )
+        /* The handshake is completed by the first read. */
+        BaseType_t xFalseStarted;
+    #endif
+
+    #if defined( MBEDTLS_SSL_PROTO_DTLS )
+        /* DTLS retransmission timer. */
+        TickType_t xTimerStart;
+        uint32_t ulTimerIntermediateMs;
+        uint32_t ulTimerFinalMs;
+    #endif
 } TLSContext_t;
 
+#if ( tlsconfigCONTEXT_POOL_SIZE > 0 )
+    static TLSContext_t xContextPool[ tlsconfigCONTEXT_POOL_SIZE ];
+    static BaseType_t xContextPoolInUse[ tlsconfigCONTEXT_POOL_SIZE ];
+#endif
+
+#if ( tlsconfigCA_STORE_SIZE > 0 )
+    static TLSCAStoreEntry_t xCAStore[ tlsconfigCA_STORE_SIZE ];
+    static SemaphoreHandle_t xCAStoreMutex = NULL;
+    static uint32_t ulCAStoreAge = 0;
+#endif
+
 
 #define TLS_PRINT( X )    vLoggingPrintf X
 
@@ -105,6 +511,16 @@ typedef struct TLSContext
  * Helper routines.
  */
 
+/**
+ * @brief Parses the default root certificates.
+ *
+ * @param[out] pxChain Initialized certificate chain to add them to.
+ *
+ * @return Zero on success.
+ */
+static int prvParseDefaultRootCertificates( mbedtls_x509_crt * pxChain );
+
+
 /**
  * @brief TLS internal context rundown helper routine.
  *
@@ -166,6 +582,93 @@ static int prvNetworkRecv( void * pvContext,
     return ( int ) pxCtx->xNetworkRecv( pxCtx->pvCallerContext, pucReceiveBuffer, xReceiveLength );
 }
 
+#if defined( MBEDTLS_SSL_PROTO_DTLS )
+
+    /**
+     * @brief Network receive callback shim for DTLS.
+     *
+     * The receive timeout of the caller applies rather than ulTimeoutMs, and
+     * receiving nothing is reported as a timeout, on which mbedTLS sends the
+     * current handshake flight again.
+     *
+     * @param[in] pvContext Caller context.
+     * @param[out] pucReceiveBuffer Byte buffer to receive into.
+     * @param[in] xReceiveLength Length of byte buffer for receive.
+     * @param[in] ulTimeoutMs Unused.
+     *
+     * @return Number of bytes received, or a negative value on error.
+     */
+    static int prvNetworkRecvTimeout( void * pvContext,
+                                      unsigned char * pucReceiveBuffer,
+                                      size_t xReceiveLength,
+                                      uint32_t ulTimeoutMs )
+    {
+        int lResult = prvNetworkRecv( pvContext, pucReceiveBuffer, xReceiveLength );
+
+        ( void ) ulTimeoutMs;
+
+        if( 0 == lResult )
+        {
+            lResult = MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+
+        return lResult;
+    }
+
+    /**
+     * @brief Starts or cancels the DTLS retransmission timer.
+     *
+     * @param[in] pvContext Caller context.
+     * @param[in] ulIntermediateMs Delay after which the timer reports 1.
+     * @param[in] ulFinalMs Delay after which the timer reports 2, 0 to cancel.
+     */
+    static void prvTimerSet( void * pvContext,
+                             uint32_t ulIntermediateMs,
+                             uint32_t ulFinalMs )
+    {
+        TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+        pxCtx->xTimerStart = xTaskGetTickCount();
+        pxCtx->ulTimerIntermediateMs = ulIntermediateMs;
+        pxCtx->ulTimerFinalMs = ulFinalMs;
+    }
+
+    /**
+     * @brief Reads the DTLS retransmission timer.
+     *
+     * @param[in] pvContext Caller context.
+     *
+     * @return -1 if the timer is cancelled, 2 if the final delay passed, 1 if
+     * the intermediate delay passed, 0 otherwise.
+     */
+    static int prvTimerGet( void * pvContext )
+    {
+        TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+        TickType_t xElapsed = xTaskGetTickCount() - pxCtx->xTimerStart;
+        int lResult = 0;
+
+        if( 0U == pxCtx->ulTimerFinalMs )
+        {
+            lResult = -1;
+        }
+        else if( xElapsed >= pdMS_TO_TICKS( pxCtx->ulTimerFinalMs ) )
+        {
+            lResult = 2;
+        }
+        else if( xElapsed >= pdMS_TO_TICKS( pxCtx->ulTimerIntermediateMs ) )
+        {
+            lResult = 1;
+        }
+        else
+        {
+            lResult = 0;
+        }
+
+        return lResult;
+    }
+
+#endif /* if defined( MBEDTLS_SSL_PROTO_DTLS ) */
+
 /**
  * @brief Callback that wraps PKCS#11 for pseudo-random number generation.
  *
@@ -296,6 +799,10 @@ static int prvPrivateKeySigningCallback( void * pvContext,
     TLSContext_t * pxSession = ( TLSContext_t * ) pvContext;
     CK_MECHANISM xMech = { 0 };
 
+    #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+        uint32_t ulStart = tlsconfigTIMESTAMP();
+    #endif
+
     /* Unreferenced parameters. */
     ( void ) ( piRng );
     ( void ) ( pvRng );
@@ -317,6 +824,10 @@ static int prvPrivateKeySigningCallback( void * pvContext,
                                          ( CK_ULONG_PTR ) pxSigLen );
     }
 
+    #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+        pxSession->xTimings.ulPrivateKeySign += tlsconfigTIMESTAMP() - ulStart;
+    #endif
+
     if( xResult != 0 )
     {
         TLS_PRINT( ( "ERROR: Failure in signing callback: %d \r\n", xResult ) );
@@ -326,6 +837,142 @@ static int prvPrivateKeySigningCallback( void * pvContext,
     return xResult;
 }
 
+#if ( tlsconfigECP_MAX_OPS > 0 )
+
+    /**
+     * @brief Progress of a restartable signature.
+     *
+     * @param[out] xP11Session PKCS#11 session the signature runs in.
+     * @param[out] xStarted pdTRUE once PKCS11_SignAsyncStart() succeeded.
+     */
+    typedef struct TLSSignRestart
+    {
+        CK_SESSION_HANDLE xP11Session;
+        BaseType_t xStarted;
+    } TLSSignRestart_t;
+
+    /**
+     * @brief Allocates the restart context of a signature for mbedTLS.
+     */
+    static void * prvSignRestartAlloc( void )
+    {
+        TLSSignRestart_t * pxRestart = ( TLSSignRestart_t * ) pvPortMalloc( sizeof( TLSSignRestart_t ) ); /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+        if( NULL != pxRestart )
+        {
+            memset( pxRestart, 0, sizeof( TLSSignRestart_t ) );
+        }
+
+        return pxRestart;
+    }
+
+    /**
+     * @brief Frees the restart context of a signature, abandoning the
+     * signature if it did not complete.
+     */
+    static void prvSignRestartFree( void * pvRestart )
+    {
+        TLSSignRestart_t * pxRestart = ( TLSSignRestart_t * ) pvRestart; /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+        if( ( NULL != pxRestart ) && ( pdTRUE == pxRestart->xStarted ) )
+        {
+            ( void ) PKCS11_SignAsyncAbort( pxRestart->xP11Session );
+        }
+
+        vPortFree( pxRestart );
+    }
+
+    /**
+     * @brief Restartable variant of prvPrivateKeySigningCallback().
+     *
+     * @return 0 once the signature is complete, MBEDTLS_ERR_ECP_IN_PROGRESS
+     * while it is being computed, or TLS_ERROR_SIGN.
+     */
+    static int prvPrivateKeySigningCallbackRestartable( void * pvContext,
+                                                        mbedtls_md_type_t xMdAlg,
+                                                        const unsigned char * pucHash,
+                                                        size_t xHashLen,
+                                                        unsigned char * pucSig,
+                                                        size_t * pxSigLen,
+                                                        int ( * piRng )( void *,
+                                                                         unsigned char *,
+                                                                         size_t ), /*lint !e955 This parameter is unused. */
+                                                        void * pvRng,
+                                                        void * pvRestart )
+    {
+        BaseType_t xResult = 0;
+        TLSContext_t * pxSession = ( TLSContext_t * ) pvContext;
+        TLSSignRestart_t * pxRestart = ( TLSSignRestart_t * ) pvRestart; /*lint !e9087 !e9079 Allow casting void* to other types. */
+        CK_MECHANISM xMech = { 0 };
+
+        #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+            uint32_t ulStart = tlsconfigTIMESTAMP();
+        #endif
+
+        /* Unreferenced parameters. */
+        ( void ) ( piRng );
+        ( void ) ( pvRng );
+        ( void ) ( xMdAlg );
+
+        /* The first call starts the signature, as the blocking callback
+         * would. */
+        if( pdFALSE == pxRestart->xStarted )
+        {
+            xMech.mechanism = CKM_SHA256;
+
+            xResult = ( BaseType_t ) C_SignInit( pxSession->xP11Session,
+                                                 &xMech,
+                                                 pxSession->xP11PrivateKey );
+
+            if( 0 == xResult )
+            {
+                xResult = ( BaseType_t ) PKCS11_SignAsyncStart( pxSession->xP11Session,
+                                                                ( CK_BYTE_PTR ) pucHash, /*lint !e9005 The interfaces are from 3rdparty libraries, we are not suppose to change them. */
+                                                                ( CK_ULONG ) xHashLen );
+            }
+
+            if( 0 == xResult )
+            {
+                pxRestart->xP11Session = pxSession->xP11Session;
+                pxRestart->xStarted = pdTRUE;
+            }
+        }
+
+        if( 0 == xResult )
+        {
+            xResult = ( BaseType_t ) PKCS11_SignAsyncPoll( pxSession->xP11Session,
+                                                           pucSig,
+                                                           ( CK_ULONG_PTR ) pxSigLen );
+
+            /* Nothing is left to abandon once the poll stops. */
+            if( ( BaseType_t ) pkcs11CKR_SIGN_IN_PROGRESS != xResult )
+            {
+                pxRestart->xStarted = pdFALSE;
+            }
+        }
+
+        #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+            pxSession->xTimings.ulPrivateKeySign += tlsconfigTIMESTAMP() - ulStart;
+        #endif
+
+        if( ( BaseType_t ) pkcs11CKR_SIGN_IN_PROGRESS == xResult )
+        {
+            xResult = MBEDTLS_ERR_ECP_IN_PROGRESS;
+        }
+        else if( xResult != 0 )
+        {
+            TLS_PRINT( ( "ERROR: Failure in signing callback: %d \r\n", xResult ) );
+            xResult = TLS_ERROR_SIGN;
+        }
+        else
+        {
+            /* Signature complete. */
+        }
+
+        return xResult;
+    }
+#endif /* if ( tlsconfigECP_MAX_OPS > 0 ) */
+
 /**
  * @brief Helper for setting up potentially hardware-based cryptographic context
  * for the client TLS certificate and private key.
@@ -342,6 +989,7 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
     CK_ATTRIBUTE xTemplate = { 0 };
     CK_OBJECT_HANDLE xCertObj = 0;
     CK_BYTE * pxCertificate = NULL;
+    const CK_BYTE * pucMappedCertificate = NULL;
     mbedtls_pk_type_t xKeyAlgo = ( mbedtls_pk_type_t ) ~0;
     CK_KEY_TYPE xKeyType = ( CK_KEY_TYPE ) ~0;
     char * pcJitrCertificate = keyJITR_DEVICE_CERTIFICATE_AUTHORITY_PEM;
@@ -425,6 +1073,18 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         memcpy( &pxCtx->xMbedPkInfo, mbedtls_pk_info_from_type( xKeyAlgo ), sizeof( mbedtls_pk_info_t ) );
 
         pxCtx->xMbedPkInfo.sign_func = prvPrivateKeySigningCallback;
+
+        #if defined( MBEDTLS_ECDSA_C ) && defined( MBEDTLS_ECP_RESTARTABLE )
+            #if ( tlsconfigECP_MAX_OPS > 0 )
+                pxCtx->xMbedPkInfo.sign_rs_func = prvPrivateKeySigningCallbackRestartable;
+                pxCtx->xMbedPkInfo.rs_alloc_func = prvSignRestartAlloc;
+                pxCtx->xMbedPkInfo.rs_free_func = prvSignRestartFree;
+            #else
+                /* The copied restartable signature would use the software
+                 * key context. */
+                pxCtx->xMbedPkInfo.sign_rs_func = NULL;
+            #endif
+        #endif
         pxCtx->xMbedPkCtx.pk_info = &pxCtx->xMbedPkInfo;
         pxCtx->xMbedPkCtx.pk_ctx = pxCtx;
     }
@@ -453,7 +1113,23 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_FindObjectsFinal( pxCtx->xP11Session );
     }
 
-    if( 0 == xResult )
+    #if defined( pkcs11configPAL_OBJECTS_MAPPED ) && ( pkcs11configPAL_OBJECTS_MAPPED == 1 )
+        if( 0 == xResult )
+        {
+            /* Parse the certificate where it lies in flash. */
+            if( CKR_OK == PKCS11_GetObjectValueInPlace( pxCtx->xP11Session,
+                                                        xCertObj,
+                                                        &pucMappedCertificate,
+                                                        &xTemplate.ulValueLen ) )
+            {
+                xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509Cli,
+                                                  pucMappedCertificate,
+                                                  xTemplate.ulValueLen );
+            }
+        }
+    #endif
+
+    if( ( 0 == xResult ) && ( NULL == pucMappedCertificate ) )
     {
         /* Query the device certificate size. */
         xTemplate.type = CKA_VALUE;
@@ -465,7 +1141,7 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
                                                                                1 );
     }
 
-    if( 0 == xResult )
+    if( ( 0 == xResult ) && ( NULL == pucMappedCertificate ) )
     {
         /* Create a buffer for the certificate. */
         pxCertificate = ( CK_BYTE_PTR ) pvPortMalloc( xTemplate.ulValueLen ); /*lint !e9079 Allow casting void* to other types. */
@@ -476,7 +1152,7 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         }
     }
 
-    if( 0 == xResult )
+    if( ( 0 == xResult ) && ( NULL == pucMappedCertificate ) )
     {
         /* Export the certificate. */
         xTemplate.pValue = pxCertificate;
@@ -487,7 +1163,7 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
     }
 
     /* Decode the client certificate. */
-    if( 0 == xResult )
+    if( ( 0 == xResult ) && ( NULL == pucMappedCertificate ) )
     {
         xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509Cli,
                                           ( const unsigned char * ) pxCertificate,
@@ -532,35 +1208,1029 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
     return xResult;
 }
 
-/*
- * Interface routines.
- */
-
-BaseType_t TLS_Init( void ** ppvContext,
-                     TLSParams_t * pxParams )
-{
-    BaseType_t xResult = 0;
-    TLSContext_t * pxCtx = NULL;
-    CK_C_GetFunctionList xCkGetFunctionList = NULL;
-
-    /* Allocate an internal context. */
-    pxCtx = ( TLSContext_t * ) pvPortMalloc( sizeof( TLSContext_t ) ); /*lint !e9087 !e9079 Allow casting void* to other types. */
+#if ( tlsconfigSESSION_CACHE_SIZE > 0 )
 
-    if( NULL != pxCtx )
+    /**
+     * @brief Create the session cache lock, if no connection has done so yet.
+     */
+    static void prvSessionCacheInit( void )
     {
-        memset( pxCtx, 0, sizeof( TLSContext_t ) );
-        *ppvContext = pxCtx;
+        SemaphoreHandle_t xMutex = NULL;
+        BaseType_t xInstalled = pdFALSE;
 
-        /* Initialize the context. */
-        pxCtx->pcDestination = pxParams->pcDestination;
-        pxCtx->pcServerCertificate = pxParams->pcServerCertificate;
-        pxCtx->ulServerCertificateLength = pxParams->ulServerCertificateLength;
+        if( NULL == xSessionCacheMutex )
+        {
+            xMutex = xSemaphoreCreateMutex();
+
+            /* Another task may have raced to create the lock. */
+            taskENTER_CRITICAL();
+            {
+                if( NULL == xSessionCacheMutex )
+                {
+                    xSessionCacheMutex = xMutex;
+                    xInstalled = pdTRUE;
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            if( ( pdFALSE == xInstalled ) && ( NULL != xMutex ) )
+            {
+                vSemaphoreDelete( xMutex );
+            }
+        }
+    }
+
+    /**
+     * @brief Take the session cache lock.
+     *
+     * @param[in] pxCtx Caller context.
+     *
+     * @return pdTRUE if the lock was taken and the destination can be cached.
+     */
+    static BaseType_t prvSessionCacheLock( const TLSContext_t * pxCtx )
+    {
+        BaseType_t xResult = pdFALSE;
+
+        if( ( NULL != xSessionCacheMutex ) &&
+            ( NULL != pxCtx->pcDestination ) &&
+            ( strlen( pxCtx->pcDestination ) <= ( size_t ) tlsconfigSESSION_CACHE_NAME_LENGTH ) )
+        {
+            xResult = xSemaphoreTake( xSessionCacheMutex, portMAX_DELAY );
+        }
+
+        return xResult;
+    }
+
+    /**
+     * @brief Find the saved session of a destination; the lock must be held.
+     *
+     * @param[in] pxCtx Caller context, naming the server and the transport.
+     *
+     * @return The cache entry, or NULL if there is none.
+     */
+    static TLSSessionCacheEntry_t * prvSessionCacheFind( const TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry = NULL;
+        uint32_t ulIndex;
+
+        for( ulIndex = 0; ulIndex < ( uint32_t ) tlsconfigSESSION_CACHE_SIZE; ulIndex++ )
+        {
+            if( ( pdTRUE == xSessionCache[ ulIndex ].xValid ) &&
+                ( xSessionCache[ ulIndex ].xDatagram == pxCtx->xDatagram ) &&
+                ( 0 == strcmp( xSessionCache[ ulIndex ].cDestination, pxCtx->pcDestination ) ) )
+            {
+                pxEntry = &xSessionCache[ ulIndex ];
+                break;
+            }
+        }
+
+        return pxEntry;
+    }
+
+    /**
+     * @brief Offer the saved session of the destination in the next handshake.
+     *
+     * Must be called between mbedtls_ssl_setup() and the handshake.  If the
+     * server declines the session, mbedTLS falls back to a full handshake.
+     *
+     * @param[in] pxCtx Caller context.
+     */
+    static void prvSessionCacheOffer( TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry = NULL;
+
+        if( pdTRUE == prvSessionCacheLock( pxCtx ) )
+        {
+            pxEntry = prvSessionCacheFind( pxCtx );
+
+            if( ( NULL != pxEntry ) &&
+                ( 0 == mbedtls_ssl_set_session( &pxCtx->xMbedSslCtx, &pxEntry->xSession ) ) )
+            {
+                pxEntry->xLastUsed = xTaskGetTickCount();
+            }
+
+            ( void ) xSemaphoreGive( xSessionCacheMutex );
+        }
+    }
+
+    /**
+     * @brief Save the session negotiated by a successful handshake.
+     *
+     * @param[in] pxCtx Caller context.
+     */
+    static void prvSessionCacheSave( TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry = NULL;
+        uint32_t ulIndex;
+
+        if( pdTRUE == prvSessionCacheLock( pxCtx ) )
+        {
+            pxEntry = prvSessionCacheFind( pxCtx );
+
+            /* Otherwise take a free entry, or else the least recently used. */
+            for( ulIndex = 0; ( NULL == pxEntry ) && ( ulIndex < ( uint32_t ) tlsconfigSESSION_CACHE_SIZE ); ulIndex++ )
+            {
+                if( pdFALSE == xSessionCache[ ulIndex ].xValid )
+                {
+                    pxEntry = &xSessionCache[ ulIndex ];
+                }
+            }
+
+            if( NULL == pxEntry )
+            {
+                pxEntry = &xSessionCache[ 0 ];
+
+                for( ulIndex = 1; ulIndex < ( uint32_t ) tlsconfigSESSION_CACHE_SIZE; ulIndex++ )
+                {
+                    if( ( xTaskGetTickCount() - xSessionCache[ ulIndex ].xLastUsed ) >
+                        ( xTaskGetTickCount() - pxEntry->xLastUsed ) )
+                    {
+                        pxEntry = &xSessionCache[ ulIndex ];
+                    }
+                }
+            }
+
+            /* mbedtls_ssl_get_session() does not free the session it copies
+             * into. */
+            if( pdTRUE == pxEntry->xValid )
+            {
+                mbedtls_ssl_session_free( &pxEntry->xSession );
+            }
+
+            mbedtls_ssl_session_init( &pxEntry->xSession );
+
+            if( 0 == mbedtls_ssl_get_session( &pxCtx->xMbedSslCtx, &pxEntry->xSession ) )
+            {
+                ( void ) strcpy( pxEntry->cDestination, pxCtx->pcDestination );
+                pxEntry->xDatagram = pxCtx->xDatagram;
+                pxEntry->xLastUsed = xTaskGetTickCount();
+                pxEntry->xValid = pdTRUE;
+            }
+            else
+            {
+                mbedtls_ssl_session_free( &pxEntry->xSession );
+                pxEntry->xValid = pdFALSE;
+            }
+
+            ( void ) xSemaphoreGive( xSessionCacheMutex );
+        }
+    }
+
+    /**
+     * @brief Forget the saved session of a destination whose handshake failed.
+     *
+     * @param[in] pxCtx Caller context.
+     */
+    static void prvSessionCacheDrop( const TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry = NULL;
+
+        if( pdTRUE == prvSessionCacheLock( pxCtx ) )
+        {
+            pxEntry = prvSessionCacheFind( pxCtx );
+
+            if( NULL != pxEntry )
+            {
+                mbedtls_ssl_session_free( &pxEntry->xSession );
+                pxEntry->xValid = pdFALSE;
+            }
+
+            ( void ) xSemaphoreGive( xSessionCacheMutex );
+        }
+    }
+#endif /* if ( tlsconfigSESSION_CACHE_SIZE > 0 ) */
+
+#if ( tlsconfigVERIFY_CACHE_SIZE > 0 )
+
+    /**
+     * @brief Computes the verification cache key of the presented chain.
+     *
+     * @param[in] pxSsl Handshake whose server certificate was parsed.
+     * @param[out] pucDigest The key.
+     */
+    static void prvVerifyCacheKey( const mbedtls_ssl_context * pxSsl,
+                                   uint8_t pucDigest[ tlsVERIFY_CACHE_DIGEST_LENGTH ] )
+    {
+        mbedtls_sha256_context xSha;
+        const mbedtls_x509_crt * pxCert = NULL;
+
+        mbedtls_sha256_init( &xSha );
+        ( void ) mbedtls_sha256_starts_ret( &xSha, 0 );
+
+        /* The names in the chain were checked against this destination. */
+        if( NULL != pxSsl->hostname )
+        {
+            ( void ) mbedtls_sha256_update_ret( &xSha,
+                                                ( const unsigned char * ) pxSsl->hostname,
+                                                strlen( pxSsl->hostname ) + 1U );
+        }
+
+        for( pxCert = pxSsl->session_negotiate->peer_cert; NULL != pxCert; pxCert = pxCert->next )
+        {
+            ( void ) mbedtls_sha256_update_ret( &xSha, pxCert->raw.p, pxCert->raw.len );
+        }
+
+        /* A chain trusted by one set of roots is not by another. */
+        for( pxCert = pxSsl->conf->ca_chain; NULL != pxCert; pxCert = pxCert->next )
+        {
+            ( void ) mbedtls_sha256_update_ret( &xSha, pxCert->raw.p, pxCert->raw.len );
+        }
+
+        ( void ) mbedtls_sha256_finish_ret( &xSha, pucDigest );
+        mbedtls_sha256_free( &xSha );
+    }
+
+    /**
+     * @brief Looks up a verified chain, and marks it as used.
+     *
+     * @return pdTRUE if the chain was verified before.
+     */
+    static BaseType_t prvVerifyCacheFind( const uint8_t pucDigest[ tlsVERIFY_CACHE_DIGEST_LENGTH ] )
+    {
+        BaseType_t xFound = pdFALSE;
+        uint32_t ulIndex;
+
+        taskENTER_CRITICAL();
+        {
+            for( ulIndex = 0; ulIndex < ( uint32_t ) tlsconfigVERIFY_CACHE_SIZE; ulIndex++ )
+            {
+                if( ( pdTRUE == xVerifyCache[ ulIndex ].xValid ) &&
+                    ( 0 == memcmp( xVerifyCache[ ulIndex ].pucDigest, pucDigest, tlsVERIFY_CACHE_DIGEST_LENGTH ) ) )
+                {
+                    xVerifyCache[ ulIndex ].xLastUsed = xTaskGetTickCount();
+                    xFound = pdTRUE;
+                    break;
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        return xFound;
+    }
+
+    /**
+     * @brief Remembers a chain that passed verification.
+     */
+    static void prvVerifyCacheStore( const uint8_t pucDigest[ tlsVERIFY_CACHE_DIGEST_LENGTH ] )
+    {
+        TLSVerifyCacheEntry_t * pxEntry = NULL;
+        uint32_t ulIndex;
+
+        taskENTER_CRITICAL();
+        {
+            /* Take a free entry, or else the least recently used. */
+            for( ulIndex = 0; ( NULL == pxEntry ) && ( ulIndex < ( uint32_t ) tlsconfigVERIFY_CACHE_SIZE ); ulIndex++ )
+            {
+                if( pdFALSE == xVerifyCache[ ulIndex ].xValid )
+                {
+                    pxEntry = &xVerifyCache[ ulIndex ];
+                }
+            }
+
+            if( NULL == pxEntry )
+            {
+                pxEntry = &xVerifyCache[ 0 ];
+
+                for( ulIndex = 1; ulIndex < ( uint32_t ) tlsconfigVERIFY_CACHE_SIZE; ulIndex++ )
+                {
+                    if( ( xTaskGetTickCount() - xVerifyCache[ ulIndex ].xLastUsed ) >
+                        ( xTaskGetTickCount() - pxEntry->xLastUsed ) )
+                    {
+                        pxEntry = &xVerifyCache[ ulIndex ];
+                    }
+                }
+            }
+
+            memcpy( pxEntry->pucDigest, pucDigest, tlsVERIFY_CACHE_DIGEST_LENGTH );
+            pxEntry->xLastUsed = xTaskGetTickCount();
+            pxEntry->xValid = pdTRUE;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    /**
+     * @brief Checks that every certificate of a chain is within its validity
+     * period, as a full verification would.
+     *
+     * @return Zero if no certificate has expired or is not yet valid.
+     */
+    static uint32_t prvVerifyCacheCheckDates( TLSContext_t * pxCtx,
+                                              mbedtls_x509_crt * pxChain )
+    {
+        mbedtls_x509_crt * pxCert = NULL;
+        uint32_t ulFlags = 0;
+        int lDepth = 0;
+
+        for( pxCert = pxChain; NULL != pxCert; pxCert = pxCert->next )
+        {
+            if( 0 != mbedtls_x509_time_is_past( &pxCert->valid_to ) )
+            {
+                ulFlags |= MBEDTLS_X509_BADCERT_EXPIRED;
+            }
+
+            if( 0 != mbedtls_x509_time_is_future( &pxCert->valid_from ) )
+            {
+                ulFlags |= MBEDTLS_X509_BADCERT_FUTURE;
+            }
+
+            ( void ) prvCheckCertificate( pxCtx, pxCert, lDepth, &ulFlags );
+            lDepth++;
+        }
+
+        return ulFlags;
+    }
+
+    /**
+     * @brief Parses the server certificate chain, and verifies it unless it
+     * was verified before.
+     *
+     * mbedTLS is told not to verify the chain, so that it can be looked up
+     * first. The checks that mbedTLS makes after verifying, of the key usage
+     * and the curve, are made here for every handshake.
+     *
+     * @param[in] pxCtx Caller context.
+     *
+     * @return Zero on success.
+     */
+    static int prvServerCertificateStep( TLSContext_t * pxCtx )
+    {
+        mbedtls_ssl_context * pxSsl = &pxCtx->xMbedSslCtx;
+        mbedtls_x509_crt * pxPeer = NULL;
+        uint8_t pucDigest[ tlsVERIFY_CACHE_DIGEST_LENGTH ];
+        uint32_t ulFlags = 0;
+        int lResult = 0;
+
+        mbedtls_ssl_conf_authmode( &pxCtx->xMbedSslConfig, MBEDTLS_SSL_VERIFY_NONE );
+        lResult = mbedtls_ssl_handshake_step( pxSsl );
+        mbedtls_ssl_conf_authmode( &pxCtx->xMbedSslConfig, MBEDTLS_SSL_VERIFY_REQUIRED );
+
+        if( 0 == lResult )
+        {
+            pxPeer = pxSsl->session_negotiate->peer_cert;
+        }
+
+        /* There is no chain for cipher suites without certificates. */
+        if( NULL != pxPeer )
+        {
+            prvVerifyCacheKey( pxSsl, pucDigest );
+
+            if( ( pdFALSE == prvVerifyCacheFind( pucDigest ) ) ||
+                ( 0U != prvVerifyCacheCheckDates( pxCtx, pxPeer ) ) )
+            {
+                ulFlags = 0;
+                lResult = mbedtls_x509_crt_verify_with_profile( pxPeer,
+                                                                pxSsl->conf->ca_chain,
+                                                                pxSsl->conf->ca_crl,
+                                                                pxSsl->conf->cert_profile,
+                                                                pxSsl->hostname,
+                                                                &ulFlags,
+                                                                pxSsl->conf->f_vrfy,
+                                                                pxSsl->conf->p_vrfy );
+
+                if( 0 == lResult )
+                {
+                    prvVerifyCacheStore( pucDigest );
+                }
+            }
+
+            #if defined( MBEDTLS_ECP_C )
+                if( ( 0 != mbedtls_pk_can_do( &pxPeer->pk, MBEDTLS_PK_ECKEY ) ) &&
+                    ( 0 != mbedtls_ssl_check_curve( pxSsl, mbedtls_pk_ec( pxPeer->pk )->grp.id ) ) )
+                {
+                    ulFlags |= MBEDTLS_X509_BADCERT_BAD_KEY;
+                    lResult = ( 0 == lResult ) ? MBEDTLS_ERR_SSL_BAD_HS_CERTIFICATE : lResult;
+                }
+            #endif
+
+            if( 0 != mbedtls_ssl_check_cert_usage( pxPeer,
+                                                   pxSsl->transform_negotiate->ciphersuite_info,
+                                                   MBEDTLS_SSL_IS_SERVER,
+                                                   &ulFlags ) )
+            {
+                lResult = ( 0 == lResult ) ? MBEDTLS_ERR_SSL_BAD_HS_CERTIFICATE : lResult;
+            }
+
+            pxSsl->session_negotiate->verify_result = ulFlags;
+
+            if( 0 != lResult )
+            {
+                TLS_PRINT( ( "ERROR: Server certificate verification failed, flags 0x%08x \r\n", ( unsigned ) ulFlags ) );
+                ( void ) mbedtls_ssl_send_alert_message( pxSsl,
+                                                         MBEDTLS_SSL_ALERT_LEVEL_FATAL,
+                                                         MBEDTLS_SSL_ALERT_MSG_BAD_CERT );
+            }
+        }
+
+        return lResult;
+    }
+
+#endif /* if ( tlsconfigVERIFY_CACHE_SIZE > 0 ) */
+
+/**
+ * @brief Runs one step of the handshake.
+ */
+static int prvHandshakeStep( TLSContext_t * pxCtx )
+{
+    int lResult = 0;
+
+    #if ( tlsconfigVERIFY_CACHE_SIZE > 0 )
+        if( MBEDTLS_SSL_SERVER_CERTIFICATE == pxCtx->xMbedSslCtx.state )
+        {
+            lResult = prvServerCertificateStep( pxCtx );
+        }
+        else
+    #endif
+    {
+        lResult = mbedtls_ssl_handshake_step( &pxCtx->xMbedSslCtx );
+    }
+
+    return lResult;
+}
+
+#if ( tlsconfigENABLE_FALSE_START == 1 )
+
+    /**
+     * @brief Checks whether the handshake may stop before the server
+     * ChangeCipherSpec and Finished messages.
+     *
+     * @param[in] pxCtx Caller context.
+     *
+     * @return pdTRUE once the client Finished message is written, for a full
+     * handshake of a forward secret AEAD cipher suite.
+     */
+    static BaseType_t prvFalseStartReady( const TLSContext_t * pxCtx )
+    {
+        const mbedtls_ssl_context * pxSsl = &pxCtx->xMbedSslCtx;
+        const mbedtls_ssl_ciphersuite_t * pxSuite = NULL;
+        const mbedtls_cipher_info_t * pxCipher = NULL;
+        BaseType_t xReady = pdFALSE;
+
+        /* The server sends its Finished message first when resuming. */
+        if( ( MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC == pxSsl->state ) &&
+            ( pdFALSE == pxCtx->xDatagram ) &&
+            ( NULL != pxSsl->handshake ) &&
+            ( 0 == pxSsl->handshake->resume ) &&
+            ( NULL != pxSsl->transform_negotiate ) )
+        {
+            pxSuite = pxSsl->transform_negotiate->ciphersuite_info;
+        }
+
+        if( ( NULL != pxSuite ) &&
+            ( ( MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA == pxSuite->key_exchange ) ||
+              ( MBEDTLS_KEY_EXCHANGE_ECDHE_RSA == pxSuite->key_exchange ) ) )
+        {
+            pxCipher = mbedtls_cipher_info_from_type( pxSuite->cipher );
+        }
+
+        if( ( NULL != pxCipher ) &&
+            ( ( MBEDTLS_MODE_GCM == pxCipher->mode ) ||
+              ( MBEDTLS_MODE_CCM == pxCipher->mode ) ) )
+        {
+            xReady = pdTRUE;
+        }
+
+        return xReady;
+    }
+
+    /**
+     * @brief Writes one application data record before the handshake is over,
+     * as mbedtls_ssl_write() does once it is.
+     *
+     * @return Number of bytes written, or a negative value on error.
+     */
+    static int prvFalseStartWrite( TLSContext_t * pxCtx,
+                                   const unsigned char * pucMsg,
+                                   size_t xMsgLength )
+    {
+        mbedtls_ssl_context * pxSsl = &pxCtx->xMbedSslCtx;
+        int lResult = mbedtls_ssl_get_max_out_record_payload( pxSsl );
+
+        if( 0 < lResult )
+        {
+            if( xMsgLength > ( size_t ) lResult )
+            {
+                xMsgLength = ( size_t ) lResult;
+            }
+
+            if( 0U != pxSsl->out_left )
+            {
+                /* The previous record was only partly sent; the caller
+                 * passes the same data again. */
+                lResult = mbedtls_ssl_flush_output( pxSsl );
+            }
+            else
+            {
+                pxSsl->out_msglen = xMsgLength;
+                pxSsl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+                memcpy( pxSsl->out_msg, pucMsg, xMsgLength );
+                lResult = mbedtls_ssl_write_record( pxSsl, 1 );
+            }
+
+            if( 0 == lResult )
+            {
+                lResult = ( int ) xMsgLength;
+            }
+        }
+
+        return lResult;
+    }
+
+    /**
+     * @brief Notes the end of a false started handshake, after a read.
+     */
+    static void prvFalseStartFinish( TLSContext_t * pxCtx )
+    {
+        if( ( pdTRUE == pxCtx->xFalseStarted ) &&
+            ( MBEDTLS_SSL_HANDSHAKE_OVER == pxCtx->xMbedSslCtx.state ) )
+        {
+            pxCtx->xFalseStarted = pdFALSE;
+
+            #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+                /* The session was not complete when TLS_Connect() returned. */
+                prvSessionCacheSave( pxCtx );
+            #endif
+        }
+    }
+
+    #define tlsFALSE_START_READY( pxCtx )    prvFalseStartReady( pxCtx )
+#else
+    #define tlsFALSE_START_READY( pxCtx )    pdFALSE
+#endif /* if ( tlsconfigENABLE_FALSE_START == 1 ) */
+
+/**
+ * @brief Runs the handshake as mbedtls_ssl_handshake() does, stopping where
+ * it may false start.
+ */
+static int prvHandshake( TLSContext_t * pxCtx )
+{
+    int lResult = 0;
+
+    while( ( 0 == lResult ) &&
+           ( MBEDTLS_SSL_HANDSHAKE_OVER != pxCtx->xMbedSslCtx.state ) &&
+           ( pdFALSE == tlsFALSE_START_READY( pxCtx ) ) )
+    {
+        lResult = prvHandshakeStep( pxCtx );
+    }
+
+    return lResult;
+}
+
+#if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+
+    /**
+     * @brief Runs the handshake as mbedtls_ssl_handshake() does, adding the
+     * time of each step to the phase it belongs to.
+     *
+     * A step includes waiting for the records it reads, so the time of a phase
+     * that receives a flight of the server includes the network round trip.
+     */
+    static int prvTimedHandshake( TLSContext_t * pxCtx )
+    {
+        int lResult = 0;
+        int lState = 0;
+        uint32_t ulStart = 0;
+        uint32_t * pulPhase = NULL;
+
+        while( ( 0 == lResult ) &&
+               ( MBEDTLS_SSL_HANDSHAKE_OVER != pxCtx->xMbedSslCtx.state ) &&
+               ( pdFALSE == tlsFALSE_START_READY( pxCtx ) ) )
+        {
+            lState = pxCtx->xMbedSslCtx.state;
+            ulStart = tlsconfigTIMESTAMP();
+            lResult = prvHandshakeStep( pxCtx );
+
+            switch( lState )
+            {
+                case MBEDTLS_SSL_HELLO_REQUEST:
+                case MBEDTLS_SSL_CLIENT_HELLO:
+                case MBEDTLS_SSL_SERVER_HELLO:
+                    pulPhase = &pxCtx->xTimings.ulServerHello;
+                    break;
+
+                case MBEDTLS_SSL_SERVER_CERTIFICATE:
+                    pulPhase = &pxCtx->xTimings.ulServerCertificate;
+                    break;
+
+                case MBEDTLS_SSL_SERVER_KEY_EXCHANGE:
+                case MBEDTLS_SSL_CERTIFICATE_REQUEST:
+                case MBEDTLS_SSL_SERVER_HELLO_DONE:
+                case MBEDTLS_SSL_CLIENT_CERTIFICATE:
+                case MBEDTLS_SSL_CLIENT_KEY_EXCHANGE:
+                    pulPhase = &pxCtx->xTimings.ulKeyExchange;
+                    break;
+
+                case MBEDTLS_SSL_CERTIFICATE_VERIFY:
+                    pulPhase = &pxCtx->xTimings.ulCertificateVerify;
+                    break;
+
+                default:
+                    pulPhase = &pxCtx->xTimings.ulFinished;
+                    break;
+            }
+
+            *pulPhase += tlsconfigTIMESTAMP() - ulStart;
+        }
+
+        return lResult;
+    }
+
+#endif /* if ( tlsconfigENABLE_CONNECT_TIMING == 1 ) */
+
+static int prvParseDefaultRootCertificates( mbedtls_x509_crt * pxChain )
+{
+    int lResult = 0;
+
+    lResult = mbedtls_x509_crt_parse( pxChain,
+                                      ( const unsigned char * ) tlsVERISIGN_ROOT_CERTIFICATE_PEM,
+                                      tlsVERISIGN_ROOT_CERTIFICATE_LENGTH );
+
+    if( 0 == lResult )
+    {
+        lResult = mbedtls_x509_crt_parse( pxChain,
+                                          ( const unsigned char * ) tlsATS1_ROOT_CERTIFICATE_PEM,
+                                          tlsATS1_ROOT_CERTIFICATE_LENGTH );
+
+        if( 0 == lResult )
+        {
+            lResult = mbedtls_x509_crt_parse( pxChain,
+                                              ( const unsigned char * ) tlsSTARFIELD_ROOT_CERTIFICATE_PEM,
+                                              tlsSTARFIELD_ROOT_CERTIFICATE_LENGTH );
+        }
+    }
+
+    if( 0 != lResult )
+    {
+        /* Default root certificates should be in aws_default_root_certificate.h */
+        TLS_PRINT( ( "ERROR: Failed to parse default server certificates %d \r\n", lResult ) );
+    }
+
+    return lResult;
+}
+
+#if ( tlsconfigCA_STORE_SIZE > 0 )
+
+    /**
+     * @brief Computes the key of a set of root certificates in the CA store.
+     *
+     * @param[in] pcCertificates The PEM or DER certificates, or NULL for the
+     * default roots.
+     * @param[in] ulLength Length of pcCertificates.
+     * @param[out] pucDigest SHA-256 of the certificates, zero for the defaults.
+     */
+    static void prvCAStoreKey( const char * pcCertificates,
+                               uint32_t ulLength,
+                               uint8_t pucDigest[ tlsCA_STORE_DIGEST_LENGTH ] )
+    {
+        memset( pucDigest, 0, tlsCA_STORE_DIGEST_LENGTH );
+
+        if( NULL != pcCertificates )
+        {
+            /* Hashing is far cheaper than decoding and parsing the PEM. */
+            ( void ) mbedtls_sha256_ret( ( const unsigned char * ) pcCertificates,
+                                         ( size_t ) ulLength,
+                                         pucDigest,
+                                         0 );
+        }
+    }
+
+    /**
+     * @brief Precomputes the values that verifying with a parsed chain caches.
+     *
+     * mbedTLS fills the Montgomery constant of an RSA key and the comb table of
+     * an EC generator on first use. Doing it here, before the chain is shared,
+     * means that concurrent handshakes only read it.
+     */
+    static void prvCAStoreWarm( mbedtls_x509_crt * pxChain )
+    {
+        mbedtls_x509_crt * pxCertificate = NULL;
+        mbedtls_mpi xOne;
+        mbedtls_mpi xResult;
+
+        mbedtls_mpi_init( &xOne );
+        mbedtls_mpi_init( &xResult );
+
+        if( 0 == mbedtls_mpi_lset( &xOne, 1 ) )
+        {
+            for( pxCertificate = pxChain;
+                 ( NULL != pxCertificate ) && ( 0 != pxCertificate->version );
+                 pxCertificate = pxCertificate->next )
+            {
+                #if defined( MBEDTLS_RSA_C )
+                    if( MBEDTLS_PK_RSA == mbedtls_pk_get_type( &pxCertificate->pk ) )
+                    {
+                        mbedtls_rsa_context * pxRsa = mbedtls_pk_rsa( pxCertificate->pk );
+
+                        ( void ) mbedtls_mpi_exp_mod( &xResult, &xOne, &pxRsa->E, &pxRsa->N, &pxRsa->RN );
+                    }
+                #endif
+
+                #if defined( MBEDTLS_ECP_C )
+                    if( MBEDTLS_PK_ECKEY == mbedtls_pk_get_type( &pxCertificate->pk ) )
+                    {
+                        mbedtls_ecp_keypair * pxEc = mbedtls_pk_ec( pxCertificate->pk );
+                        mbedtls_ecp_point xPoint;
+
+                        mbedtls_ecp_point_init( &xPoint );
+                        ( void ) mbedtls_ecp_mul( &pxEc->grp, &xPoint, &xOne, &pxEc->grp.G, NULL, NULL );
+                        mbedtls_ecp_point_free( &xPoint );
+                    }
+                #endif
+            }
+        }
+
+        mbedtls_mpi_free( &xOne );
+        mbedtls_mpi_free( &xResult );
+    }
+
+    /**
+     * @brief Creates the lock of the CA store, if not done yet.
+     *
+     * @return pdTRUE if the lock exists.
+     */
+    static BaseType_t prvCAStoreInit( void )
+    {
+        SemaphoreHandle_t xMutex = NULL;
+        BaseType_t xInstalled = pdFALSE;
+
+        if( NULL == xCAStoreMutex )
+        {
+            xMutex = xSemaphoreCreateMutex();
+
+            /* Another task may have raced to create the lock. */
+            taskENTER_CRITICAL();
+            {
+                if( NULL == xCAStoreMutex )
+                {
+                    xCAStoreMutex = xMutex;
+                    xInstalled = pdTRUE;
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            if( ( pdFALSE == xInstalled ) && ( NULL != xMutex ) )
+            {
+                vSemaphoreDelete( xMutex );
+            }
+        }
+
+        return ( NULL != xCAStoreMutex ) ? pdTRUE : pdFALSE;
+    }
+
+    /**
+     * @brief Takes a reference to the parsed form of a set of root certificates.
+     *
+     * Parses the certificates into a free entry when the store does not have
+     * them yet, replacing the least recently parsed unreferenced entry if the
+     * store is full. Runs in TLS_Init(), where no connect arena is bound,
+     * because the entry outlives the context.
+     *
+     * @param[in] pcCertificates The PEM or DER certificates, or NULL for the
+     * default roots.
+     * @param[in] ulLength Length of pcCertificates.
+     *
+     * @return The entry, or NULL if the store is full or parsing failed, in
+     * which case the connection parses its own copy.
+     */
+    static TLSCAStoreEntry_t * prvCAStoreAcquire( const char * pcCertificates,
+                                                  uint32_t ulLength )
+    {
+        TLSCAStoreEntry_t * pxEntry = NULL;
+        TLSCAStoreEntry_t * pxFree = NULL;
+        uint8_t pucDigest[ tlsCA_STORE_DIGEST_LENGTH ];
+        uint32_t ulIndex;
+        int lResult = 0;
+
+        prvCAStoreKey( pcCertificates, ulLength, pucDigest );
+
+        if( ( pdTRUE == prvCAStoreInit() ) &&
+            ( pdTRUE == xSemaphoreTake( xCAStoreMutex, portMAX_DELAY ) ) )
+        {
+            for( ulIndex = 0; ( NULL == pxEntry ) && ( ulIndex < ( uint32_t ) tlsconfigCA_STORE_SIZE ); ulIndex++ )
+            {
+                if( pdFALSE == xCAStore[ ulIndex ].xParsed )
+                {
+                    if( NULL == pxFree )
+                    {
+                        pxFree = &xCAStore[ ulIndex ];
+                    }
+                }
+                else if( ( xCAStore[ ulIndex ].ulLength == ulLength ) &&
+                         ( 0 == memcmp( xCAStore[ ulIndex ].pucDigest, pucDigest, sizeof( pucDigest ) ) ) )
+                {
+                    pxEntry = &xCAStore[ ulIndex ];
+                }
+                else if( ( 0 == xCAStore[ ulIndex ].ulRefCount ) &&
+                         ( ( NULL == pxFree ) ||
+                           ( ( pdTRUE == pxFree->xParsed ) && ( pxFree->ulAge > xCAStore[ ulIndex ].ulAge ) ) ) )
+                {
+                    pxFree = &xCAStore[ ulIndex ];
+                }
+                else
+                {
+                    /* In use by other connections. */
+                }
+            }
+
+            if( ( NULL == pxEntry ) && ( NULL != pxFree ) )
+            {
+                if( pdTRUE == pxFree->xParsed )
+                {
+                    mbedtls_x509_crt_free( &pxFree->xChain );
+                    pxFree->xParsed = pdFALSE;
+                }
+
+                mbedtls_x509_crt_init( &pxFree->xChain );
+
+                if( NULL != pcCertificates )
+                {
+                    lResult = mbedtls_x509_crt_parse( &pxFree->xChain,
+                                                      ( const unsigned char * ) pcCertificates,
+                                                      ( size_t ) ulLength );
+                }
+                else
+                {
+                    lResult = prvParseDefaultRootCertificates( &pxFree->xChain );
+                }
+
+                if( 0 == lResult )
+                {
+                    prvCAStoreWarm( &pxFree->xChain );
+                    memcpy( pxFree->pucDigest, pucDigest, sizeof( pucDigest ) );
+                    pxFree->ulLength = ulLength;
+                    pxFree->ulAge = ++ulCAStoreAge;
+                    pxFree->xParsed = pdTRUE;
+                    pxEntry = pxFree;
+                }
+                else
+                {
+                    mbedtls_x509_crt_free( &pxFree->xChain );
+                }
+            }
+
+            if( NULL != pxEntry )
+            {
+                pxEntry->ulRefCount++;
+            }
+
+            ( void ) xSemaphoreGive( xCAStoreMutex );
+        }
+
+        return pxEntry;
+    }
+
+    /**
+     * @brief Drops a reference taken by prvCAStoreAcquire().
+     *
+     * The entry stays parsed for the next connection with the same roots.
+     */
+    static void prvCAStoreRelease( TLSCAStoreEntry_t * pxEntry )
+    {
+        if( pdTRUE == xSemaphoreTake( xCAStoreMutex, portMAX_DELAY ) )
+        {
+            pxEntry->ulRefCount--;
+            ( void ) xSemaphoreGive( xCAStoreMutex );
+        }
+    }
+
+#endif /* if ( tlsconfigCA_STORE_SIZE > 0 ) */
+
+#if ( tlsconfigCONTEXT_POOL_SIZE > 0 )
+
+    /**
+     * @brief Takes a free context from the pool and resets it.
+     *
+     * @return The context, or NULL if all are in use.
+     */
+    static TLSContext_t * prvContextPoolTake( void )
+    {
+        TLSContext_t * pxCtx = NULL;
+        unsigned char * pucSendVBuffer = NULL;
+        size_t xSendVBufferLength = 0;
+        uint32_t ulIndex;
+
+        #if ( tlsUSE_CONNECT_ARENA == 1 )
+            uint8_t * pucArenaStorage = NULL;
+        #endif
+
+        taskENTER_CRITICAL();
+        {
+            for( ulIndex = 0; ( NULL == pxCtx ) && ( ulIndex < ( uint32_t ) tlsconfigCONTEXT_POOL_SIZE ); ulIndex++ )
+            {
+                if( pdFALSE == xContextPoolInUse[ ulIndex ] )
+                {
+                    xContextPoolInUse[ ulIndex ] = pdTRUE;
+                    pxCtx = &xContextPool[ ulIndex ];
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( NULL != pxCtx )
+        {
+            /* Keep the buffers of the previous connection. */
+            pucSendVBuffer = pxCtx->pucSendVBuffer;
+            xSendVBufferLength = pxCtx->xSendVBufferLength;
+            #if ( tlsUSE_CONNECT_ARENA == 1 )
+                pucArenaStorage = pxCtx->pucArenaStorage;
+            #endif
+
+            memset( pxCtx, 0, sizeof( TLSContext_t ) );
+
+            pxCtx->pucSendVBuffer = pucSendVBuffer;
+            pxCtx->xSendVBufferLength = xSendVBufferLength;
+            #if ( tlsUSE_CONNECT_ARENA == 1 )
+                pxCtx->pucArenaStorage = pucArenaStorage;
+            #endif
+            pxCtx->xPooled = pdTRUE;
+        }
+
+        return pxCtx;
+    }
+
+    /**
+     * @brief Returns a context to the pool.
+     */
+    static void prvContextPoolGive( const TLSContext_t * pxCtx )
+    {
+        uint32_t ulIndex = ( uint32_t ) ( pxCtx - xContextPool );
+
+        taskENTER_CRITICAL();
+        {
+            xContextPoolInUse[ ulIndex ] = pdFALSE;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* if ( tlsconfigCONTEXT_POOL_SIZE > 0 ) */
+
+/*
+ * Interface routines.
+ */
+
+BaseType_t TLS_Init( void ** ppvContext,
+                     TLSParams_t * pxParams )
+{
+    BaseType_t xResult = 0;
+    TLSContext_t * pxCtx = NULL;
+    CK_C_GetFunctionList xCkGetFunctionList = NULL;
+
+    /* Allocate an internal context. */
+    #if ( tlsconfigCONTEXT_POOL_SIZE > 0 )
+        pxCtx = prvContextPoolTake();
+
+        if( NULL == pxCtx )
+    #endif
+    {
+        pxCtx = ( TLSContext_t * ) pvPortMallocWithCaps( sizeof( TLSContext_t ), heapCAPS_FAST ); /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+        if( NULL != pxCtx )
+        {
+            memset( pxCtx, 0, sizeof( TLSContext_t ) );
+        }
+    }
+
+    if( NULL != pxCtx )
+    {
+        *ppvContext = pxCtx;
+
+        /* Initialize the context. */
+        pxCtx->pcDestination = pxParams->pcDestination;
+        pxCtx->pcServerCertificate = pxParams->pcServerCertificate;
+        pxCtx->ulServerCertificateLength = pxParams->ulServerCertificateLength;
         pxCtx->ppcAlpnProtocols = pxParams->ppcAlpnProtocols;
         pxCtx->ulAlpnProtocolsCount = pxParams->ulAlpnProtocolsCount;
+        pxCtx->xDatagram = pxParams->xDatagram;
         pxCtx->xNetworkRecv = pxParams->pxNetworkRecv;
         pxCtx->xNetworkSend = pxParams->pxNetworkSend;
         pxCtx->pvCallerContext = pxParams->pvCallerContext;
 
+        #if ( tlsUSE_CONNECT_ARENA == 1 )
+            {
+                /* The arena is optional: without it, the heap is used. A
+                 * pooled context may still have the storage. */
+                if( NULL == pxCtx->pucArenaStorage )
+                {
+                    pxCtx->pucArenaStorage = ( uint8_t * ) pvPortMallocWithCaps( tlsconfigCONNECT_ARENA_SIZE, heapCAPS_FAST ); /*lint !e9079 Allow casting void* to other types. */
+                }
+
+                if( NULL != pxCtx->pucArenaStorage )
+                {
+                    pxCtx->xArena = xTaskArenaCreateStatic( pxCtx->pucArenaStorage,
+                                                            tlsconfigCONNECT_ARENA_SIZE,
+                                                            &pxCtx->xArenaBuffer );
+                }
+            }
+        #endif
+
+        #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+            prvSessionCacheInit();
+        #endif
+
+        #if ( tlsconfigCA_STORE_SIZE > 0 )
+            pxCtx->pxCAStoreEntry = prvCAStoreAcquire( pxCtx->pcServerCertificate,
+                                                       pxCtx->ulServerCertificateLength );
+        #endif
+
         /* Get the function pointer list for the PKCS#11 module. */
         xCkGetFunctionList = C_GetFunctionList;
         xResult = ( BaseType_t ) xCkGetFunctionList( &pxCtx->xP11FunctionList );
@@ -611,6 +2281,29 @@ BaseType_t TLS_Connect( void * pvContext )
     BaseType_t xResult = 0;
     TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
 
+    #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+        BaseType_t xHandshakeFailed = pdFALSE;
+    #endif
+
+    #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+        uint32_t ulConnectStart = tlsconfigTIMESTAMP();
+    #endif
+
+    #if ( tlsUSE_CONNECT_ARENA == 1 )
+        TaskArenaHandle_t xPreviousArena = NULL;
+
+        /* Serve the allocations of the handshake from the arena of this
+         * context. */
+        if( NULL != pxCtx->xArena )
+        {
+            xPreviousArena = xTaskArenaBind( pxCtx->xArena );
+        }
+    #endif
+
+    #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+        memset( &pxCtx->xTimings, 0, sizeof( pxCtx->xTimings ) );
+    #endif
+
     /* Ensure that the FreeRTOS heap is used. */
     CRYPTO_ConfigureHeap();
 
@@ -620,6 +2313,13 @@ BaseType_t TLS_Connect( void * pvContext )
     mbedtls_x509_crt_init( &pxCtx->xMbedX509CA );
 
     /* Decode the root certificate: either the default or the override. */
+    #if ( tlsconfigCA_STORE_SIZE > 0 )
+        if( NULL != pxCtx->pxCAStoreEntry )
+        {
+            /* Use the chain taken from the store by TLS_Init. */
+        }
+        else
+    #endif
     if( NULL != pxCtx->pcServerCertificate )
     {
         xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
@@ -633,38 +2333,38 @@ BaseType_t TLS_Connect( void * pvContext )
     }
     else
     {
-        xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
-                                          ( const unsigned char * ) tlsVERISIGN_ROOT_CERTIFICATE_PEM,
-                                          tlsVERISIGN_ROOT_CERTIFICATE_LENGTH );
-
-        if( 0 == xResult )
-        {
-            xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
-                                              ( const unsigned char * ) tlsATS1_ROOT_CERTIFICATE_PEM,
-                                              tlsATS1_ROOT_CERTIFICATE_LENGTH );
-
-            if( 0 == xResult )
-            {
-                xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
-                                                  ( const unsigned char * ) tlsSTARFIELD_ROOT_CERTIFICATE_PEM,
-                                                  tlsSTARFIELD_ROOT_CERTIFICATE_LENGTH );
-            }
-        }
-
-        if( 0 != xResult )
-        {
-            /* Default root certificates should be in aws_default_root_certificate.h */
-            TLS_PRINT( ( "ERROR: Failed to parse default server certificates %d \r\n", xResult ) );
-        }
+        xResult = prvParseDefaultRootCertificates( &pxCtx->xMbedX509CA );
     }
 
     /* Start with protocol defaults. */
     if( 0 == xResult )
     {
-        xResult = mbedtls_ssl_config_defaults( &pxCtx->xMbedSslConfig,
-                                               MBEDTLS_SSL_IS_CLIENT,
-                                               MBEDTLS_SSL_TRANSPORT_STREAM,
-                                               MBEDTLS_SSL_PRESET_DEFAULT );
+        #if defined( MBEDTLS_SSL_PROTO_DTLS )
+            xResult = mbedtls_ssl_config_defaults( &pxCtx->xMbedSslConfig,
+                                                   MBEDTLS_SSL_IS_CLIENT,
+                                                   ( pdFALSE != pxCtx->xDatagram ) ? MBEDTLS_SSL_TRANSPORT_DATAGRAM : MBEDTLS_SSL_TRANSPORT_STREAM,
+                                                   MBEDTLS_SSL_PRESET_DEFAULT );
+
+            if( ( 0 == xResult ) && ( pdFALSE != pxCtx->xDatagram ) )
+            {
+                mbedtls_ssl_conf_handshake_timeout( &pxCtx->xMbedSslConfig,
+                                                    tlsconfigDTLS_HANDSHAKE_TIMEOUT_MIN,
+                                                    tlsconfigDTLS_HANDSHAKE_TIMEOUT_MAX );
+            }
+        #else
+            if( pdFALSE != pxCtx->xDatagram )
+            {
+                TLS_PRINT( ( "ERROR: DTLS requires MBEDTLS_SSL_PROTO_DTLS \r\n" ) );
+                xResult = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+            }
+            else
+            {
+                xResult = mbedtls_ssl_config_defaults( &pxCtx->xMbedSslConfig,
+                                                       MBEDTLS_SSL_IS_CLIENT,
+                                                       MBEDTLS_SSL_TRANSPORT_STREAM,
+                                                       MBEDTLS_SSL_PRESET_DEFAULT );
+            }
+        #endif /* if defined( MBEDTLS_SSL_PROTO_DTLS ) */
     }
 
     if( 0 == xResult )
@@ -680,13 +2380,49 @@ BaseType_t TLS_Connect( void * pvContext )
         /* Set the RNG callback. */
         mbedtls_ssl_conf_rng( &pxCtx->xMbedSslConfig, &prvGenerateRandomBytes, pxCtx ); /*lint !e546 Nothing wrong here. */
 
+        #if defined( tlsconfigCIPHERSUITES )
+            {
+                /* mbedTLS keeps the pointer. */
+                static const int xCiphersuites[] = tlsconfigCIPHERSUITES;
+
+                mbedtls_ssl_conf_ciphersuites( &pxCtx->xMbedSslConfig, xCiphersuites );
+            }
+        #endif
+
         /* Set issuer certificate. */
-        mbedtls_ssl_conf_ca_chain( &pxCtx->xMbedSslConfig, &pxCtx->xMbedX509CA, NULL );
+        #if ( tlsconfigCA_STORE_SIZE > 0 )
+            if( NULL != pxCtx->pxCAStoreEntry )
+            {
+                mbedtls_ssl_conf_ca_chain( &pxCtx->xMbedSslConfig, &pxCtx->pxCAStoreEntry->xChain, NULL );
+            }
+            else
+        #endif
+        {
+            mbedtls_ssl_conf_ca_chain( &pxCtx->xMbedSslConfig, &pxCtx->xMbedX509CA, NULL );
+        }
+
+        #if defined( MBEDTLS_SSL_SESSION_TICKETS )
+            #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+                mbedtls_ssl_conf_session_tickets( &pxCtx->xMbedSslConfig, MBEDTLS_SSL_SESSION_TICKETS_ENABLED );
+            #else
+                /* A ticket could not be used without a session cache. */
+                mbedtls_ssl_conf_session_tickets( &pxCtx->xMbedSslConfig, MBEDTLS_SSL_SESSION_TICKETS_DISABLED );
+            #endif
+        #endif
 
         /* Configure the SSL context for the device credentials. */
         xResult = prvInitializeClientCredential( pxCtx );
     }
 
+    #if ( tlsconfigMAX_FRAGMENT_LENGTH > 0 )
+        if( 0 == xResult )
+        {
+            /* Ask the server for smaller records. */
+            xResult = mbedtls_ssl_conf_max_frag_len( &pxCtx->xMbedSslConfig,
+                                                     tlsMAX_FRAGMENT_LENGTH_CODE );
+        }
+    #endif
+
     if( ( 0 == xResult ) && ( NULL != pxCtx->ppcAlpnProtocols ) )
     {
         /* Include an application protocol list in the TLS ClientHello
@@ -716,18 +2452,74 @@ BaseType_t TLS_Connect( void * pvContext )
         xResult = mbedtls_ssl_set_hostname( &pxCtx->xMbedSslCtx, pxCtx->pcDestination );
     }
 
+    #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+        /* Try an abbreviated handshake, which skips the certificate chain
+         * verification and the private key signature. */
+        if( 0 == xResult )
+        {
+            prvSessionCacheOffer( pxCtx );
+        }
+    #endif
+
     /* Set the socket callbacks. */
     if( 0 == xResult )
     {
-        mbedtls_ssl_set_bio( &pxCtx->xMbedSslCtx,
-                             pxCtx,
-                             prvNetworkSend,
-                             prvNetworkRecv,
-                             NULL );
+        #if defined( MBEDTLS_SSL_PROTO_DTLS )
+            if( pdFALSE != pxCtx->xDatagram )
+            {
+                /* The session cache above also lets DTLS resume the session
+                 * after the address of the device changed, for instance by
+                 * NAT rebinding. */
+                mbedtls_ssl_set_bio( &pxCtx->xMbedSslCtx,
+                                     pxCtx,
+                                     prvNetworkSend,
+                                     NULL,
+                                     prvNetworkRecvTimeout );
+                mbedtls_ssl_set_timer_cb( &pxCtx->xMbedSslCtx,
+                                          pxCtx,
+                                          prvTimerSet,
+                                          prvTimerGet );
+
+                #if ( tlsconfigDTLS_MTU > 0 )
+                    mbedtls_ssl_set_mtu( &pxCtx->xMbedSslCtx, ( uint16_t ) tlsconfigDTLS_MTU );
+                #endif
+            }
+            else
+        #endif /* if defined( MBEDTLS_SSL_PROTO_DTLS ) */
+        {
+            mbedtls_ssl_set_bio( &pxCtx->xMbedSslCtx,
+                                 pxCtx,
+                                 prvNetworkSend,
+                                 prvNetworkRecv,
+                                 NULL );
+        }
+
+        #if ( tlsconfigECP_MAX_OPS > 0 )
+            /* Let the handshake pause during elliptic curve operations. */
+            mbedtls_ecp_set_max_ops( tlsconfigECP_MAX_OPS );
+        #endif
+
+        #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+            pxCtx->xTimings.ulSetup = tlsconfigTIMESTAMP() - ulConnectStart;
+        #endif
 
         /* Negotiate. */
-        while( 0 != ( xResult = mbedtls_ssl_handshake( &pxCtx->xMbedSslCtx ) ) )
+        #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+            while( 0 != ( xResult = prvTimedHandshake( pxCtx ) ) )
+        #else
+            while( 0 != ( xResult = prvHandshake( pxCtx ) ) )
+        #endif
         {
+            #if ( tlsconfigECP_MAX_OPS > 0 )
+                if( MBEDTLS_ERR_SSL_CRYPTO_IN_PROGRESS == xResult )
+                {
+                    /* Let other tasks, and other users of the PKCS#11
+                     * session, run before continuing. */
+                    taskYIELD();
+                    continue;
+                }
+            #endif
+
             if( ( MBEDTLS_ERR_SSL_WANT_READ != xResult ) &&
                 ( MBEDTLS_ERR_SSL_WANT_WRITE != xResult ) )
             {
@@ -736,11 +2528,37 @@ BaseType_t TLS_Connect( void * pvContext )
                  * a context that failed the handshake. */
                 prvFreeContext( pxCtx );
                 TLS_PRINT( ( "ERROR: Handshake failed with error code %d \r\n", xResult ) );
+
+                #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+                    xHandshakeFailed = pdTRUE;
+                #endif
                 break;
             }
         }
     }
 
+    #if ( tlsconfigENABLE_FALSE_START == 1 )
+        pxCtx->xFalseStarted = pdFALSE;
+
+        if( ( 0 == xResult ) && ( MBEDTLS_SSL_HANDSHAKE_OVER != pxCtx->xMbedSslCtx.state ) )
+        {
+            /* Send the client Finished message now, rather than with the
+             * first record of application data. */
+            while( MBEDTLS_ERR_SSL_WANT_WRITE == ( xResult = mbedtls_ssl_flush_output( &pxCtx->xMbedSslCtx ) ) )
+            {
+            }
+
+            if( 0 == xResult )
+            {
+                pxCtx->xFalseStarted = pdTRUE;
+            }
+            else
+            {
+                prvFreeContext( pxCtx );
+            }
+        }
+    #endif /* if ( tlsconfigENABLE_FALSE_START == 1 ) */
+
     /* Keep track of successful completion of the handshake. */
     if( 0 == xResult )
     {
@@ -757,11 +2575,98 @@ BaseType_t TLS_Connect( void * pvContext )
     mbedtls_x509_crt_free( &pxCtx->xMbedX509CA );
     mbedtls_x509_crt_free( &pxCtx->xMbedX509Cli );
 
+    #if ( tlsUSE_CONNECT_ARENA == 1 )
+        if( NULL != pxCtx->xArena )
+        {
+            ( void ) xTaskArenaBind( xPreviousArena );
+        }
+    #endif
+
+    #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+        /* The cache outlives this context, so its copies of the session must
+         * not come from the arena. */
+        if( 0 == xResult )
+        {
+            #if ( tlsconfigENABLE_FALSE_START == 1 )
+                if( pdFALSE == pxCtx->xFalseStarted )
+            #endif
+            {
+                prvSessionCacheSave( pxCtx );
+            }
+        }
+        else if( pdTRUE == xHandshakeFailed )
+        {
+            prvSessionCacheDrop( pxCtx );
+        }
+        else
+        {
+            /* Failed before the handshake; the saved session is still good. */
+        }
+    #endif
+
+    #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+        pxCtx->xTimings.ulTotal = tlsconfigTIMESTAMP() - ulConnectStart;
+    #endif
+
+    #if ( tlsconfigLOG_CONNECT_TIMING == 1 )
+        TLS_PRINT( ( "TLS_Connect %d (%s): total %u, setup %u, ServerHello %u, certificate %u, key exchange %u, "
+                     "certificate verify %u (signing %u), finished %u.\r\n",
+                     ( int ) xResult,
+                     ( 0 == xResult ) ? TLS_GetCiphersuite( pxCtx ) : "-",
+                     ( unsigned ) pxCtx->xTimings.ulTotal,
+                     ( unsigned ) pxCtx->xTimings.ulSetup,
+                     ( unsigned ) pxCtx->xTimings.ulServerHello,
+                     ( unsigned ) pxCtx->xTimings.ulServerCertificate,
+                     ( unsigned ) pxCtx->xTimings.ulKeyExchange,
+                     ( unsigned ) pxCtx->xTimings.ulCertificateVerify,
+                     ( unsigned ) pxCtx->xTimings.ulPrivateKeySign,
+                     ( unsigned ) pxCtx->xTimings.ulFinished ) );
+    #endif
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t TLS_GetConnectTimings( void * pvContext,
+                                  TLSConnectTimings_t * pxTimings )
+{
+    BaseType_t xResult = 0;
+    TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+    if( ( NULL == pxCtx ) || ( NULL == pxTimings ) )
+    {
+        xResult = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    else
+    {
+        #if ( tlsconfigENABLE_CONNECT_TIMING == 1 )
+            *pxTimings = pxCtx->xTimings;
+        #else
+            memset( pxTimings, 0, sizeof( TLSConnectTimings_t ) );
+        #endif
+    }
+
     return xResult;
 }
 
 /*-----------------------------------------------------------*/
 
+const char * TLS_GetCiphersuite( void * pvContext )
+{
+    const char * pcCiphersuite = NULL;
+    TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+    if( ( NULL != pxCtx ) && ( pdTRUE == pxCtx->xTLSHandshakeSuccessful ) )
+    {
+        pcCiphersuite = mbedtls_ssl_get_ciphersuite( &pxCtx->xMbedSslCtx );
+    }
+
+    return pcCiphersuite;
+}
+
+/*-----------------------------------------------------------*/
+
 BaseType_t TLS_Recv( void * pvContext,
                      unsigned char * pucReadBuffer,
                      size_t xReadLength )
@@ -778,16 +2683,27 @@ BaseType_t TLS_Recv( void * pvContext,
                                         pucReadBuffer + xRead,
                                         xReadLength - xRead );
 
+            #if ( tlsconfigENABLE_FALSE_START == 1 )
+                prvFalseStartFinish( pxCtx );
+            #endif
+
             if( 0 < xResult )
             {
                 /* Got data, so update the tally and keep looping. */
                 xRead += ( size_t ) xResult;
+
+                /* Datagrams are not joined together. */
+                if( pdFALSE != pxCtx->xDatagram )
+                {
+                    break;
+                }
             }
-            else if( 0 == xResult )
+            else if( ( 0 == xResult ) || ( MBEDTLS_ERR_SSL_TIMEOUT == xResult ) )
             {
                 /* No data received (and no error). The secure sockets
                  * API supports non-blocking read, so stop the loop but don't
-                 * flag an error. */
+                 * flag an error. Over DTLS, nothing arrived in time. */
+                xResult = 0;
                 break;
             }
             else if( MBEDTLS_ERR_SSL_WANT_READ != xResult )
@@ -813,6 +2729,106 @@ BaseType_t TLS_Recv( void * pvContext,
 
 /*-----------------------------------------------------------*/
 
+BaseType_t TLS_RecvZeroCopy( void * pvContext,
+                             unsigned char ** ppucData,
+                             size_t xMaxLength )
+{
+    BaseType_t xResult = 0;
+    TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+    unsigned char ucUnused = 0;
+
+    if( ( NULL != pxCtx ) && ( pdTRUE == pxCtx->xTLSHandshakeSuccessful ) )
+    {
+        /* A zero length read decrypts the next record, if none is left over,
+         * without consuming any of its data. */
+        if( NULL == pxCtx->xMbedSslCtx.in_offt )
+        {
+            xResult = mbedtls_ssl_read( &pxCtx->xMbedSslCtx, &ucUnused, 0 );
+
+            #if ( tlsconfigENABLE_FALSE_START == 1 )
+                prvFalseStartFinish( pxCtx );
+            #endif
+        }
+
+        if( 0 <= xResult )
+        {
+            *ppucData = pxCtx->xMbedSslCtx.in_offt;
+            xResult = ( BaseType_t ) mbedtls_ssl_get_bytes_avail( &pxCtx->xMbedSslCtx );
+
+            if( ( size_t ) xResult > xMaxLength )
+            {
+                xResult = ( BaseType_t ) xMaxLength;
+            }
+        }
+        else if( ( MBEDTLS_ERR_SSL_WANT_READ == xResult ) ||
+                 ( MBEDTLS_ERR_SSL_TIMEOUT == xResult ) )
+        {
+            /* No data received; the same as for TLS_Recv(). */
+            xResult = 0;
+        }
+        else
+        {
+            /* Hard error: invalidate the context. */
+            prvFreeContext( pxCtx );
+        }
+    }
+    else
+    {
+        xResult = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+    }
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+void TLS_ReleaseZeroCopy( void * pvContext,
+                          size_t xLength )
+{
+    TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+    mbedtls_ssl_context * pxSsl = NULL;
+
+    if( ( NULL != pxCtx ) && ( pdTRUE == pxCtx->xTLSHandshakeSuccessful ) )
+    {
+        pxSsl = &pxCtx->xMbedSslCtx;
+
+        if( xLength > pxSsl->in_msglen )
+        {
+            xLength = pxSsl->in_msglen;
+        }
+
+        /* Consume the data as mbedtls_ssl_read() does after copying it. */
+        pxSsl->in_msglen -= xLength;
+
+        if( 0 == pxSsl->in_msglen )
+        {
+            pxSsl->in_offt = NULL;
+            pxSsl->keep_current_message = 0;
+        }
+        else
+        {
+            pxSsl->in_offt += xLength;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+size_t TLS_GetBytesAvailable( void * pvContext )
+{
+    size_t xAvailable = 0;
+    TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+    if( ( NULL != pxCtx ) && ( pdTRUE == pxCtx->xTLSHandshakeSuccessful ) )
+    {
+        xAvailable = mbedtls_ssl_get_bytes_avail( &pxCtx->xMbedSslCtx );
+    }
+
+    return xAvailable;
+}
+
+/*-----------------------------------------------------------*/
+
 BaseType_t TLS_Send( void * pvContext,
                      const unsigned char * pucMsg,
                      size_t xMsgLength )
@@ -825,9 +2841,22 @@ BaseType_t TLS_Send( void * pvContext,
     {
         while( xWritten < xMsgLength )
         {
-            xResult = mbedtls_ssl_write( &pxCtx->xMbedSslCtx,
-                                         pucMsg + xWritten,
-                                         xMsgLength - xWritten );
+            #if ( tlsconfigENABLE_FALSE_START == 1 )
+                if( pdTRUE == pxCtx->xFalseStarted )
+                {
+                    /* mbedtls_ssl_write() would wait for the server Finished
+                     * message. */
+                    xResult = prvFalseStartWrite( pxCtx,
+                                                  pucMsg + xWritten,
+                                                  xMsgLength - xWritten );
+                }
+                else
+            #endif
+            {
+                xResult = mbedtls_ssl_write( &pxCtx->xMbedSslCtx,
+                                             pucMsg + xWritten,
+                                             xMsgLength - xWritten );
+            }
 
             if( 0 < xResult )
             {
@@ -865,6 +2894,108 @@ BaseType_t TLS_Send( void * pvContext,
 
 /*-----------------------------------------------------------*/
 
+BaseType_t TLS_SendV( void * pvContext,
+                      const TLSIOVector_t * pxIOVectors,
+                      size_t xIOVectorCount )
+{
+    BaseType_t xResult = 0;
+    TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+    size_t xTotalLength = 0;
+    size_t xRecordLength = 0;
+    size_t xGathered = 0;
+    size_t xChunkLength = 0;
+    size_t xWritten = 0;
+    size_t xVector = 0;
+    size_t xOffset = 0;
+    int lMaxPayload = 0;
+
+    if( ( NULL != pxCtx ) && ( NULL != pxIOVectors ) && ( pdTRUE == pxCtx->xTLSHandshakeSuccessful ) )
+    {
+        for( xVector = 0; xVector < xIOVectorCount; xVector++ )
+        {
+            xTotalLength += pxIOVectors[ xVector ].xMsgLength;
+        }
+
+        /* Gather at most one full record at a time.  The record payload
+         * limit accounts for a negotiated max_fragment_length. */
+        xRecordLength = xTotalLength;
+        lMaxPayload = mbedtls_ssl_get_max_out_record_payload( &pxCtx->xMbedSslCtx );
+
+        if( ( lMaxPayload > 0 ) && ( xRecordLength > ( size_t ) lMaxPayload ) )
+        {
+            xRecordLength = ( size_t ) lMaxPayload;
+        }
+
+        /* The gather buffer is kept for the lifetime of the context and only
+         * grown when a larger record is needed. */
+        if( pxCtx->xSendVBufferLength < xRecordLength )
+        {
+            vPortFree( pxCtx->pucSendVBuffer );
+            pxCtx->pucSendVBuffer = ( unsigned char * ) pvPortMallocWithCaps( xRecordLength, heapCAPS_FAST ); /*lint !e9079 Allow casting void* to other types. */
+            pxCtx->xSendVBufferLength = ( NULL == pxCtx->pucSendVBuffer ) ? 0 : xRecordLength;
+        }
+
+        if( pxCtx->xSendVBufferLength < xRecordLength )
+        {
+            xResult = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        }
+
+        xVector = 0;
+
+        while( ( 0 <= xResult ) && ( xWritten < xTotalLength ) )
+        {
+            /* Copy the next record out of the vectors. */
+            xGathered = 0;
+
+            while( ( xGathered < xRecordLength ) && ( xVector < xIOVectorCount ) )
+            {
+                xChunkLength = pxIOVectors[ xVector ].xMsgLength - xOffset;
+
+                if( xChunkLength > ( xRecordLength - xGathered ) )
+                {
+                    xChunkLength = xRecordLength - xGathered;
+                }
+
+                memcpy( &pxCtx->pucSendVBuffer[ xGathered ], &pxIOVectors[ xVector ].pucMsg[ xOffset ], xChunkLength );
+                xGathered += xChunkLength;
+                xOffset += xChunkLength;
+
+                if( xOffset == pxIOVectors[ xVector ].xMsgLength )
+                {
+                    xVector++;
+                    xOffset = 0;
+                }
+            }
+
+            xResult = TLS_Send( pxCtx, pxCtx->pucSendVBuffer, xGathered );
+
+            if( 0 < xResult )
+            {
+                xWritten += ( size_t ) xResult;
+            }
+
+            /* Stop on error or if the record could not be sent completely. */
+            if( ( size_t ) xResult != xGathered )
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        xResult = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+    }
+
+    if( 0 <= xResult )
+    {
+        xResult = ( BaseType_t ) xWritten;
+    }
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
 void TLS_Cleanup( void * pvContext )
 {
     TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
@@ -876,7 +3007,40 @@ void TLS_Cleanup( void * pvContext )
             prvFreeContext( pxCtx );
         }
 
-        /* Free memory. */
-        vPortFree( pxCtx );
+        #if ( tlsUSE_CONNECT_ARENA == 1 )
+            {
+                /* All mbedTLS objects have been freed, so the arena can go. */
+                if( NULL != pxCtx->xArena )
+                {
+                    vTaskArenaDelete( pxCtx->xArena );
+                }
+            }
+        #endif
+
+        #if ( tlsconfigCA_STORE_SIZE > 0 )
+            if( NULL != pxCtx->pxCAStoreEntry )
+            {
+                prvCAStoreRelease( pxCtx->pxCAStoreEntry );
+            }
+        #endif
+
+        #if ( tlsconfigCONTEXT_POOL_SIZE > 0 )
+            if( pdTRUE == pxCtx->xPooled )
+            {
+                /* Keep the buffers for the next connection. */
+                prvContextPoolGive( pxCtx );
+            }
+            else
+        #endif
+        {
+            /* Free memory. */
+            vPortFree( pxCtx->pucSendVBuffer );
+
+            #if ( tlsUSE_CONNECT_ARENA == 1 )
+                vPortFree( pxCtx->pucArenaStorage );
+            #endif
+
+            vPortFree( pxCtx );
+        }
     }
 }
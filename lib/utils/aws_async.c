@@ -0,0 +1,350 @@
+/*
+ * Amazon FreeRTOS Async Executor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "aws_async.h"
+
+#if ( configUSE_TASK_NOTIFICATIONS != 1 )
+    #error "The async executor requires configUSE_TASK_NOTIFICATIONS to be set to 1."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Checks whether what a task waits for has happened, or its timeout
+ * has expired, and records the outcome in xResult.
+ *
+ * @return pdTRUE if the task is ready to run.
+ */
+static BaseType_t prvWaitIsOver( AsyncTask_t * pxTask )
+{
+    BaseType_t xReady = pdFALSE;
+
+    switch( pxTask->eWait )
+    {
+        case eAsyncWaitNone:
+            xReady = pdTRUE;
+            break;
+
+        case eAsyncWaitSignal:
+            taskENTER_CRITICAL();
+            {
+                if( pxTask->xSignalled == pdTRUE )
+                {
+                    pxTask->xSignalled = pdFALSE;
+                    xReady = pdTRUE;
+                }
+            }
+            taskEXIT_CRITICAL();
+            break;
+
+        case eAsyncWaitQueue:
+            xReady = ( xQueueReceive( pxTask->xQueue, pxTask->pvItem, 0 ) == pdPASS ) ? pdTRUE : pdFALSE;
+            break;
+
+        case eAsyncWaitSocket:
+            /* Set by the last poll. */
+            xReady = ( pxTask->ulReadyEvents != 0U ) ? pdTRUE : pdFALSE;
+            break;
+
+        default:
+            /* A delay only ends with its timeout. */
+            break;
+    }
+
+    if( xReady == pdTRUE )
+    {
+        pxTask->xResult = pdPASS;
+    }
+    else if( xTaskCheckForTimeOut( &( pxTask->xTimeOut ), &( pxTask->xTicksToWait ) ) != pdFALSE )
+    {
+        pxTask->xResult = ( pxTask->eWait == eAsyncWaitDelay ) ? pdPASS : pdFAIL;
+        xReady = pdTRUE;
+    }
+    else
+    {
+        /* Keep waiting. */
+    }
+
+    return xReady;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Blocks the executor's task until an async task may be ready.
+ *
+ * Sockets are waited on with SOCKETS_Poll(), which also sets ulReadyEvents.
+ * Without sockets the task waits for a signal or the nearest timeout.
+ */
+static void prvWaitForEvents( AsyncExecutor_t * pxExecutor )
+{
+    AsyncTask_t * pxTask;
+    TickType_t xWait = portMAX_DELAY;
+    BaseType_t xWaitsOnQueue = pdFALSE;
+    BaseType_t xWaitsOnSignal = pdFALSE;
+    size_t xSocketCount = 0;
+
+    #if ( asyncconfigUSE_SOCKETS == 1 )
+        Socket_t xSockets[ asyncconfigMAX_SOCKETS ];
+        uint32_t ulEvents[ asyncconfigMAX_SOCKETS ];
+        AsyncTask_t * pxSocketTasks[ asyncconfigMAX_SOCKETS ];
+        size_t x;
+        int32_t lResult;
+    #endif
+
+    for( pxTask = pxExecutor->pxTasks; pxTask != NULL; pxTask = pxTask->pxNext )
+    {
+        switch( pxTask->eWait )
+        {
+            case eAsyncWaitNone:
+                xWait = 0;
+                break;
+
+            case eAsyncWaitSignal:
+                xWaitsOnSignal = pdTRUE;
+
+                if( pxTask->xSignalled == pdTRUE )
+                {
+                    xWait = 0;
+                }
+
+                break;
+
+            case eAsyncWaitQueue:
+                xWaitsOnQueue = pdTRUE;
+
+                if( uxQueueMessagesWaiting( pxTask->xQueue ) != ( UBaseType_t ) 0 )
+                {
+                    xWait = 0;
+                }
+
+                break;
+
+            #if ( asyncconfigUSE_SOCKETS == 1 )
+                case eAsyncWaitSocket:
+                    configASSERT( xSocketCount < ( size_t ) asyncconfigMAX_SOCKETS );
+
+                    if( xSocketCount < ( size_t ) asyncconfigMAX_SOCKETS )
+                    {
+                        xSockets[ xSocketCount ] = pxTask->xSocket;
+                        ulEvents[ xSocketCount ] = pxTask->ulEvents;
+                        pxSocketTasks[ xSocketCount ] = pxTask;
+                        xSocketCount++;
+                    }
+
+                    break;
+            #endif
+
+            default:
+                break;
+        }
+
+        /* xTicksToWait was brought up to date by the last prvWaitIsOver(). */
+        if( ( pxTask->eWait != eAsyncWaitNone ) && ( pxTask->xTicksToWait < xWait ) )
+        {
+            xWait = pxTask->xTicksToWait;
+        }
+    }
+
+    /* Nothing wakes the executor for queue items, nor for signals while it
+     * is in SOCKETS_Poll(). */
+    if( ( xWaitsOnQueue == pdTRUE ) || ( ( xWaitsOnSignal == pdTRUE ) && ( xSocketCount > 0U ) ) )
+    {
+        if( xWait > pdMS_TO_TICKS( asyncconfigPOLL_PERIOD_MS ) )
+        {
+            xWait = pdMS_TO_TICKS( asyncconfigPOLL_PERIOD_MS );
+        }
+    }
+
+    #if ( asyncconfigUSE_SOCKETS == 1 )
+        if( xSocketCount > 0U )
+        {
+            lResult = SOCKETS_Poll( xSockets, ulEvents, xSocketCount, xWait );
+
+            for( x = 0; x < xSocketCount; x++ )
+            {
+                if( lResult > 0 )
+                {
+                    pxSocketTasks[ x ]->ulReadyEvents = ulEvents[ x ];
+                }
+                else if( lResult < 0 )
+                {
+                    /* Let the tasks find out what is wrong with their sockets
+                     * rather than polling them again at once. */
+                    pxSocketTasks[ x ]->ulReadyEvents = SOCKETS_POLLERR;
+                }
+                else
+                {
+                    pxSocketTasks[ x ]->ulReadyEvents = 0;
+                }
+            }
+        }
+        else
+    #endif /* if ( asyncconfigUSE_SOCKETS == 1 ) */
+
+    if( xWait > ( TickType_t ) 0 )
+    {
+        ( void ) ulTaskNotifyTakeIndexed( asyncconfigNOTIFICATION_INDEX, pdTRUE, xWait );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Calls the function of every ready task once, and removes the tasks
+ * that have finished.
+ */
+static void prvRunReadyTasks( AsyncExecutor_t * pxExecutor )
+{
+    AsyncTask_t ** ppxLink = &( pxExecutor->pxTasks );
+    AsyncTask_t * pxTask;
+
+    while( *ppxLink != NULL )
+    {
+        pxTask = *ppxLink;
+
+        if( ( prvWaitIsOver( pxTask ) == pdTRUE ) &&
+            ( pxTask->pxFunction( pxTask, pxTask->pvParameter ) == eAsyncDone ) )
+        {
+            /* Read the link after the call, as the function may have spawned
+             * a task at the end of the list. */
+            *ppxLink = pxTask->pxNext;
+            pxTask->pxNext = NULL;
+        }
+        else
+        {
+            ppxLink = &( pxTask->pxNext );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void ASYNC_ExecutorInit( AsyncExecutor_t * pxExecutor )
+{
+    configASSERT( pxExecutor != NULL );
+
+    pxExecutor->pxTasks = NULL;
+    pxExecutor->xTaskHandle = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void ASYNC_Spawn( AsyncExecutor_t * pxExecutor,
+                  AsyncTask_t * pxTask,
+                  AsyncFunction_t pxFunction,
+                  void * pvParameter )
+{
+    AsyncTask_t ** ppxLink = &( pxExecutor->pxTasks );
+
+    configASSERT( pxTask != NULL );
+    configASSERT( pxFunction != NULL );
+
+    pxTask->pxNext = NULL;
+    pxTask->pxFunction = pxFunction;
+    pxTask->pvParameter = pvParameter;
+    pxTask->uxResumePoint = 0;
+    pxTask->xSignalled = pdFALSE;
+    ASYNC_PrepareWait( pxTask, eAsyncWaitNone, 0 );
+
+    /* Appending keeps the order in which tasks run stable. */
+    while( *ppxLink != NULL )
+    {
+        ppxLink = &( ( *ppxLink )->pxNext );
+    }
+
+    *ppxLink = pxTask;
+}
+/*-----------------------------------------------------------*/
+
+void ASYNC_Run( AsyncExecutor_t * pxExecutor )
+{
+    configASSERT( pxExecutor != NULL );
+
+    pxExecutor->xTaskHandle = xTaskGetCurrentTaskHandle();
+
+    while( pxExecutor->pxTasks != NULL )
+    {
+        prvRunReadyTasks( pxExecutor );
+
+        if( pxExecutor->pxTasks != NULL )
+        {
+            prvWaitForEvents( pxExecutor );
+        }
+    }
+
+    pxExecutor->xTaskHandle = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void ASYNC_Signal( AsyncExecutor_t * pxExecutor,
+                   AsyncTask_t * pxTask )
+{
+    TaskHandle_t xTaskHandle;
+
+    taskENTER_CRITICAL();
+    {
+        pxTask->xSignalled = pdTRUE;
+        xTaskHandle = pxExecutor->xTaskHandle;
+    }
+    taskEXIT_CRITICAL();
+
+    if( xTaskHandle != NULL )
+    {
+        ( void ) xTaskNotifyGiveIndexed( xTaskHandle, asyncconfigNOTIFICATION_INDEX );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void ASYNC_SignalFromISR( AsyncExecutor_t * pxExecutor,
+                          AsyncTask_t * pxTask,
+                          BaseType_t * pxHigherPriorityTaskWoken )
+{
+    TaskHandle_t xTaskHandle;
+    UBaseType_t uxSavedInterruptStatus;
+
+    uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        pxTask->xSignalled = pdTRUE;
+        xTaskHandle = pxExecutor->xTaskHandle;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+    if( xTaskHandle != NULL )
+    {
+        vTaskNotifyGiveIndexedFromISR( xTaskHandle, asyncconfigNOTIFICATION_INDEX, pxHigherPriorityTaskWoken );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void ASYNC_PrepareWait( AsyncTask_t * pxTask,
+                        AsyncWait_t eWait,
+                        TickType_t xTicksToWait )
+{
+    pxTask->eWait = eWait;
+    pxTask->xTicksToWait = xTicksToWait;
+    pxTask->ulReadyEvents = 0;
+    pxTask->xResult = pdFAIL;
+    vTaskSetTimeOutState( &( pxTask->xTimeOut ) );
+}
+/*-----------------------------------------------------------*/
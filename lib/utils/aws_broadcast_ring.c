@@ -0,0 +1,416 @@
+/*
+ * Amazon FreeRTOS Broadcast Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_broadcast_ring.c
+ * @brief One producer, many readers ring of fixed size items.
+ *
+ * Items are numbered with a 32-bit sequence number that wraps; the item of
+ * sequence number n is kept in slot n % ulLength. The state of the ring and
+ * of its readers is only changed with the scheduler suspended, as in
+ * stream_buffer.c, which keeps interrupts enabled while a write wakes the
+ * waiting readers. The items themselves are copied with the scheduler
+ * running: the producer first claims the slot of the next item, so a reader
+ * that copied an item from that slot at the same time can tell that its copy
+ * may be torn.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "aws_broadcast_ring.h"
+#include "aws_broadcast_ring_config_defaults.h"
+
+#if ( configUSE_TASK_NOTIFICATIONS != 1 )
+    #error "The broadcast ring requires configUSE_TASK_NOTIFICATIONS to be set to 1."
+#endif
+
+#if ( INCLUDE_xTaskGetCurrentTaskHandle != 1 )
+    #error "The broadcast ring requires INCLUDE_xTaskGetCurrentTaskHandle to be set to 1."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Returns the slot of the item with sequence number ulSequence.
+ */
+static uint8_t * prvSlot( const BroadcastRing_t * pxRing,
+                          uint32_t ulSequence )
+{
+    return &( pxRing->pucStorage[ ( size_t ) ( ulSequence % pxRing->ulLength ) * pxRing->xItemSize ] );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Tells whether writing the next item would overwrite an item that a
+ * blocking reader has not read yet.
+ *
+ * The cursors of the blocking readers are only visited when the last known
+ * bound of the slowest one says the ring is full; the readers can only have
+ * moved forward since. Must be called with the scheduler suspended.
+ */
+static BaseType_t prvIsFull( BroadcastRing_t * pxRing )
+{
+    BroadcastReader_t * pxReader;
+    uint32_t ulSlowest;
+
+    if( ( pxRing->ulHead - pxRing->ulSlowest ) >= pxRing->ulLength )
+    {
+        ulSlowest = pxRing->ulHead;
+
+        for( pxReader = pxRing->pxReaders; pxReader != NULL; pxReader = pxReader->pxNext )
+        {
+            if( ( pxReader->ePolicy == eBroadcastBlockProducer ) &&
+                ( ( pxRing->ulHead - pxReader->ulNext ) > ( pxRing->ulHead - ulSlowest ) ) )
+            {
+                ulSlowest = pxReader->ulNext;
+            }
+        }
+
+        pxRing->ulSlowest = ulSlowest;
+    }
+
+    return ( ( pxRing->ulHead - pxRing->ulSlowest ) >= pxRing->ulLength ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wakes all the readers waiting for an item.
+ *
+ * Must be called with the scheduler suspended.
+ */
+static void prvWakeReaders( BroadcastRing_t * pxRing )
+{
+    BroadcastReader_t * pxReader;
+
+    for( pxReader = pxRing->pxWaiting; pxReader != NULL; pxReader = pxReader->pxNextWaiting )
+    {
+        ( void ) xTaskNotifyGiveIndexed( pxReader->xWaitingTask, broadcastconfigNOTIFICATION_INDEX );
+        pxReader->xWaitingTask = NULL;
+    }
+
+    pxRing->pxWaiting = NULL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wakes the producer if it waits for room.
+ *
+ * Must be called with the scheduler suspended.
+ */
+static void prvWakeProducer( BroadcastRing_t * pxRing )
+{
+    if( pxRing->xWaitingProducer != NULL )
+    {
+        ( void ) xTaskNotifyGiveIndexed( pxRing->xWaitingProducer, broadcastconfigNOTIFICATION_INDEX );
+        pxRing->xWaitingProducer = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Takes a reader off the list of readers waiting for an item, if it is
+ * still on it.
+ *
+ * Must be called with the scheduler suspended.
+ */
+static void prvStopWaiting( BroadcastRing_t * pxRing,
+                            BroadcastReader_t * pxReader )
+{
+    BroadcastReader_t ** ppxLink;
+
+    if( pxReader->xWaitingTask != NULL )
+    {
+        for( ppxLink = &( pxRing->pxWaiting ); *ppxLink != pxReader; ppxLink = &( ( *ppxLink )->pxNextWaiting ) )
+        {
+        }
+
+        *ppxLink = pxReader->pxNextWaiting;
+        pxReader->pxNextWaiting = NULL;
+        pxReader->xWaitingTask = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void BROADCAST_Init( BroadcastRing_t * pxRing,
+                     uint8_t * pucStorage,
+                     size_t xItemSize,
+                     uint32_t ulLength )
+{
+    configASSERT( pxRing != NULL );
+    configASSERT( pucStorage != NULL );
+    configASSERT( xItemSize > 0 );
+    configASSERT( ( ulLength > 0UL ) && ( ulLength < 0x80000000UL ) );
+
+    pxRing->pucStorage = pucStorage;
+    pxRing->xItemSize = xItemSize;
+    pxRing->ulLength = ulLength;
+    pxRing->ulHead = 0UL;
+    pxRing->ulClaimed = 0UL;
+    pxRing->ulSlowest = 0UL;
+    pxRing->pxReaders = NULL;
+    pxRing->pxWaiting = NULL;
+    pxRing->xWaitingProducer = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void BROADCAST_ReaderAdd( BroadcastRing_t * pxRing,
+                          BroadcastReader_t * pxReader,
+                          BroadcastPolicy_t ePolicy )
+{
+    configASSERT( pxRing != NULL );
+    configASSERT( pxReader != NULL );
+
+    pxReader->pxNextWaiting = NULL;
+    pxReader->xWaitingTask = NULL;
+    pxReader->ulDropped = 0UL;
+    pxReader->ePolicy = ePolicy;
+
+    vTaskSuspendAll();
+    {
+        /* A new blocking reader starts at the head, so it does not lower the
+         * bound of the slowest one. */
+        pxReader->ulNext = pxRing->ulHead;
+        pxReader->pxNext = pxRing->pxReaders;
+        pxRing->pxReaders = pxReader;
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void BROADCAST_ReaderRemove( BroadcastRing_t * pxRing,
+                             BroadcastReader_t * pxReader )
+{
+    BroadcastReader_t ** ppxLink;
+
+    configASSERT( pxRing != NULL );
+    configASSERT( pxReader != NULL );
+
+    vTaskSuspendAll();
+    {
+        for( ppxLink = &( pxRing->pxReaders ); *ppxLink != NULL; ppxLink = &( ( *ppxLink )->pxNext ) )
+        {
+            if( *ppxLink == pxReader )
+            {
+                *ppxLink = pxReader->pxNext;
+                break;
+            }
+        }
+
+        prvStopWaiting( pxRing, pxReader );
+        pxReader->pxNext = NULL;
+
+        if( pxReader->ePolicy == eBroadcastBlockProducer )
+        {
+            /* The producer may have waited for this reader. */
+            prvWakeProducer( pxRing );
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t BROADCAST_Write( BroadcastRing_t * pxRing,
+                            const void * pvItem,
+                            TickType_t xTicksToWait )
+{
+    BaseType_t xFull;
+    TimeOut_t xTimeOut;
+
+    configASSERT( pxRing != NULL );
+    configASSERT( pvItem != NULL );
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    for( ; ; )
+    {
+        vTaskSuspendAll();
+        {
+            xFull = prvIsFull( pxRing );
+
+            if( xFull == pdFALSE )
+            {
+                /* Readers that copy the item this one overwrites will now
+                 * see that their copy may be torn. */
+                pxRing->ulClaimed = pxRing->ulHead + 1UL;
+                pxRing->xWaitingProducer = NULL;
+            }
+            else if( xTicksToWait != ( TickType_t ) 0 )
+            {
+                /* A reader that moves on from now will wake the producer. */
+                ( void ) xTaskNotifyStateClearIndexed( NULL, broadcastconfigNOTIFICATION_INDEX );
+                pxRing->xWaitingProducer = xTaskGetCurrentTaskHandle();
+            }
+            else
+            {
+                pxRing->xWaitingProducer = NULL;
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        if( ( xFull == pdFALSE ) || ( xTicksToWait == ( TickType_t ) 0 ) )
+        {
+            break;
+        }
+
+        ( void ) ulTaskNotifyTakeIndexed( broadcastconfigNOTIFICATION_INDEX, pdTRUE, xTicksToWait );
+
+        if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+        {
+            /* Look for room one last time. */
+            xTicksToWait = ( TickType_t ) 0;
+        }
+    }
+
+    if( xFull == pdFALSE )
+    {
+        /* Only the producer changes the head. */
+        ( void ) memcpy( prvSlot( pxRing, pxRing->ulHead ), pvItem, pxRing->xItemSize );
+
+        vTaskSuspendAll();
+        {
+            pxRing->ulHead = pxRing->ulClaimed;
+            prvWakeReaders( pxRing );
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+    return ( xFull == pdFALSE ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t BROADCAST_Read( BroadcastRing_t * pxRing,
+                           BroadcastReader_t * pxReader,
+                           void * pvItem,
+                           TickType_t xTicksToWait )
+{
+    BaseType_t xResult = pdFAIL;
+    BaseType_t xAvailable;
+    uint32_t ulSequence;
+    uint32_t ulBehind;
+    TimeOut_t xTimeOut;
+
+    configASSERT( pxRing != NULL );
+    configASSERT( pxReader != NULL );
+    configASSERT( pvItem != NULL );
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    for( ; ; )
+    {
+        vTaskSuspendAll();
+        {
+            /* Only a reader that does not hold the producer back can be more
+             * than a ring behind; its oldest items are gone. */
+            ulBehind = pxRing->ulHead - pxReader->ulNext;
+
+            if( ulBehind > pxRing->ulLength )
+            {
+                pxReader->ulDropped += ulBehind - pxRing->ulLength;
+                pxReader->ulNext = pxRing->ulHead - pxRing->ulLength;
+            }
+
+            ulSequence = pxReader->ulNext;
+            xAvailable = ( pxRing->ulHead != ulSequence ) ? pdTRUE : pdFALSE;
+
+            if( ( xAvailable == pdFALSE ) && ( xTicksToWait != ( TickType_t ) 0 ) )
+            {
+                /* The next write will wake this task. */
+                ( void ) xTaskNotifyStateClearIndexed( NULL, broadcastconfigNOTIFICATION_INDEX );
+                pxReader->xWaitingTask = xTaskGetCurrentTaskHandle();
+                pxReader->pxNextWaiting = pxRing->pxWaiting;
+                pxRing->pxWaiting = pxReader;
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        if( xAvailable != pdFALSE )
+        {
+            ( void ) memcpy( pvItem, prvSlot( pxRing, ulSequence ), pxRing->xItemSize );
+
+            vTaskSuspendAll();
+            {
+                if( ( pxRing->ulClaimed - ulSequence ) > pxRing->ulLength )
+                {
+                    /* The producer has claimed the slot while the item was
+                     * copied.  Skip the item rather than wait for the
+                     * producer, which may have a lower priority. */
+                    pxReader->ulDropped++;
+                }
+                else
+                {
+                    xResult = pdPASS;
+                }
+
+                pxReader->ulNext = ulSequence + 1UL;
+
+                if( pxReader->ePolicy == eBroadcastBlockProducer )
+                {
+                    prvWakeProducer( pxRing );
+                }
+            }
+            ( void ) xTaskResumeAll();
+
+            if( xResult == pdPASS )
+            {
+                break;
+            }
+        }
+        else if( xTicksToWait == ( TickType_t ) 0 )
+        {
+            break;
+        }
+        else
+        {
+            ( void ) ulTaskNotifyTakeIndexed( broadcastconfigNOTIFICATION_INDEX, pdTRUE, xTicksToWait );
+
+            vTaskSuspendAll();
+            {
+                prvStopWaiting( pxRing, pxReader );
+            }
+            ( void ) xTaskResumeAll();
+
+            if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+            {
+                /* Look for an item one last time. */
+                xTicksToWait = ( TickType_t ) 0;
+            }
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t BROADCAST_ReaderDropped( const BroadcastReader_t * pxReader )
+{
+    configASSERT( pxReader != NULL );
+
+    return pxReader->ulDropped;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,265 @@
+/*
+ * Amazon FreeRTOS Deferred Work
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "aws_deferred_work.h"
+#include "aws_deferred_work_config_defaults.h"
+
+#if ( configUSE_TASK_NOTIFICATIONS != 1 )
+    #error "Deferred work requires configUSE_TASK_NOTIFICATIONS to be set to 1."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The pending items, oldest first. Accessed with interrupts masked.
+ */
+static DeferredWork_t * pxHead = NULL;
+static DeferredWork_t * pxTail = NULL;
+
+/**
+ * @brief The task that runs deferred work.
+ */
+static TaskHandle_t xDeferredTask = NULL;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Links an item at the end of the pending list.
+ *
+ * Must be called with interrupts masked.
+ *
+ * @return pdTRUE if the list was empty, so the task must be woken.
+ */
+static BaseType_t prvPush( DeferredWork_t * pxWork )
+{
+    BaseType_t xWasEmpty = ( pxHead == NULL ) ? pdTRUE : pdFALSE;
+
+    pxWork->pxNext = NULL;
+    pxWork->xPending = pdTRUE;
+
+    if( xWasEmpty == pdTRUE )
+    {
+        pxHead = pxWork;
+    }
+    else
+    {
+        pxTail->pxNext = pxWork;
+    }
+
+    pxTail = pxWork;
+
+    return xWasEmpty;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Unlinks the oldest pending item.
+ *
+ * @return The item, or NULL if none is pending.
+ */
+static DeferredWork_t * prvPop( void )
+{
+    DeferredWork_t * pxWork;
+
+    taskENTER_CRITICAL();
+    {
+        pxWork = pxHead;
+
+        if( pxWork != NULL )
+        {
+            pxHead = pxWork->pxNext;
+
+            if( pxHead == NULL )
+            {
+                pxTail = NULL;
+            }
+
+            pxWork->pxNext = NULL;
+            pxWork->xPending = pdFALSE;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return pxWork;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Runs pending items until none is left, then waits to be woken.
+ */
+static void prvDeferredWorkTask( void * pvParameters )
+{
+    DeferredWork_t * pxWork;
+    DeferredWorkFunction_t pxFunction;
+    void * pvParameter;
+
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+        /* Items scheduled while the list is drained are run in this pass, and
+         * the notification they may have sent is consumed by the next wait. */
+        while( ( pxWork = prvPop() ) != NULL )
+        {
+            /* Read before running, as the function may reschedule or reuse
+             * its item. */
+            pxFunction = pxWork->pxFunction;
+            pvParameter = pxWork->pvParameter;
+            pxFunction( pvParameter );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t DEFERRED_Init( void )
+{
+    BaseType_t xResult = pdFAIL;
+
+    configASSERT( xDeferredTask == NULL );
+
+    if( xTaskCreate( prvDeferredWorkTask,
+                     "Deferred",
+                     deferredconfigTASK_STACK_DEPTH,
+                     NULL,
+                     deferredconfigTASK_PRIORITY,
+                     &xDeferredTask ) == pdPASS )
+    {
+        xResult = pdPASS;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void DEFERRED_WorkInit( DeferredWork_t * pxWork,
+                        DeferredWorkFunction_t pxFunction,
+                        void * pvParameter )
+{
+    configASSERT( pxWork != NULL );
+    configASSERT( pxFunction != NULL );
+
+    pxWork->pxNext = NULL;
+    pxWork->pxFunction = pxFunction;
+    pxWork->pvParameter = pvParameter;
+    pxWork->xPending = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t DEFERRED_Schedule( DeferredWork_t * pxWork )
+{
+    BaseType_t xResult = pdFAIL;
+    BaseType_t xWake = pdFALSE;
+
+    configASSERT( xDeferredTask != NULL );
+
+    taskENTER_CRITICAL();
+    {
+        if( pxWork->xPending == pdFALSE )
+        {
+            xWake = prvPush( pxWork );
+            xResult = pdPASS;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xWake == pdTRUE )
+    {
+        ( void ) xTaskNotifyGive( xDeferredTask );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t DEFERRED_ScheduleFromISR( DeferredWork_t * pxWork,
+                                     BaseType_t * pxHigherPriorityTaskWoken )
+{
+    BaseType_t xResult = pdFAIL;
+    BaseType_t xWake = pdFALSE;
+    UBaseType_t uxSavedInterruptStatus;
+
+    configASSERT( xDeferredTask != NULL );
+
+    uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        if( pxWork->xPending == pdFALSE )
+        {
+            xWake = prvPush( pxWork );
+            xResult = pdPASS;
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+    if( xWake == pdTRUE )
+    {
+        vTaskNotifyGiveFromISR( xDeferredTask, pxHigherPriorityTaskWoken );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t DEFERRED_Cancel( DeferredWork_t * pxWork )
+{
+    BaseType_t xResult = pdFAIL;
+    DeferredWork_t * pxPrevious = NULL;
+    DeferredWork_t * pxItem;
+
+    taskENTER_CRITICAL();
+    {
+        if( pxWork->xPending == pdTRUE )
+        {
+            for( pxItem = pxHead; pxItem != pxWork; pxItem = pxItem->pxNext )
+            {
+                pxPrevious = pxItem;
+            }
+
+            if( pxPrevious == NULL )
+            {
+                pxHead = pxWork->pxNext;
+            }
+            else
+            {
+                pxPrevious->pxNext = pxWork->pxNext;
+            }
+
+            if( pxTail == pxWork )
+            {
+                pxTail = pxPrevious;
+            }
+
+            pxWork->pxNext = NULL;
+            pxWork->xPending = pdFALSE;
+            xResult = pdPASS;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
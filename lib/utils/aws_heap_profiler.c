@@ -0,0 +1,474 @@
+/*
+ * Amazon FreeRTOS Heap Profiler
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_heap_profiler.c
+ * @brief Heap profiler tables and reports.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "aws_heap_profiler.h"
+
+#if ( INCLUDE_xTaskGetSchedulerState != 1 )
+    #error "The heap profiler requires INCLUDE_xTaskGetSchedulerState to be set to 1."
+#endif
+
+#if ( ( heapprofconfigMAX_SITES & ( heapprofconfigMAX_SITES - 1U ) ) != 0 ) || ( heapprofconfigMAX_SITES > 0xFFFFU )
+    #error "heapprofconfigMAX_SITES must be a power of two smaller than 65536."
+#endif
+
+#if ( heapprofconfigMAX_LIVE_BLOCKS & ( heapprofconfigMAX_LIVE_BLOCKS - 1U ) ) != 0
+    #error "heapprofconfigMAX_LIVE_BLOCKS must be a power of two."
+#endif
+
+/**
+ * @brief The index of the site collecting the allocations made once the site
+ * table is full.
+ */
+#define heapprofOVERFLOW_SITE    ( heapprofconfigMAX_SITES )
+
+/**
+ * @brief Spreads addresses, whose low bits are mostly zero, over a table.
+ */
+#define heapprofHASH( xValue, uxMask ) \
+    ( ( UBaseType_t ) ( ( ( ( uint32_t ) ( ( xValue ) >> 3 ) ) * 2654435761UL ) >> 16 ) & ( uxMask ) )
+
+/**
+ * @brief A site is in use once something has been recorded for it.
+ */
+#define heapprofSITE_IN_USE( pxSite ) \
+    ( ( ( pxSite )->ulAllocations != 0U ) || ( ( pxSite )->ulFailures != 0U ) )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A block that has been allocated and not freed yet.
+ */
+typedef struct HeapProfilerBlock
+{
+    void * pvAddress; /**< The block, NULL for unused entries. */
+    uint32_t ulSize;  /**< The size recorded when the block was allocated. */
+    uint16_t usSite;  /**< The index of the site that allocated the block. */
+} HeapProfilerBlock_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The call sites, in an open addressed hash table, followed by the
+ * overflow site.
+ */
+static HeapProfilerSite_t xSites[ heapprofconfigMAX_SITES + 1U ];
+
+/**
+ * @brief The totals of each site at the time of the previous report, used to
+ * compute rates.
+ */
+static uint32_t ulReportedAllocations[ heapprofconfigMAX_SITES + 1U ];
+static uint32_t ulReportedBytes[ heapprofconfigMAX_SITES + 1U ];
+
+/**
+ * @brief The allocated blocks, in an open addressed hash table.
+ */
+static HeapProfilerBlock_t xBlocks[ heapprofconfigMAX_LIVE_BLOCKS ];
+static UBaseType_t uxBlockCount = 0;
+
+/**
+ * @brief Totals for the whole heap.
+ */
+static uint32_t ulAllocations = 0;
+static uint32_t ulAllocatedBytes = 0;
+static uint32_t ulFrees = 0;
+static uint32_t ulFailures = 0;
+static uint32_t ulUntrackedBlocks = 0;
+
+/**
+ * @brief The heap totals and time of the previous report.
+ */
+static uint32_t ulReportedTotalAllocations = 0;
+static uint32_t ulReportedTotalBytes = 0;
+static TickType_t xReportedTime = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Finds the site of a caller in the current task, and adds it if it is
+ * new.
+ */
+static UBaseType_t prvFindSite( const void * pvCaller )
+{
+    TaskHandle_t xTask = NULL;
+    UBaseType_t uxIndex, uxProbes;
+    const UBaseType_t uxMask = ( UBaseType_t ) heapprofconfigMAX_SITES - 1U;
+
+    /* The current task is not defined before the scheduler has started. */
+    if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
+    {
+        xTask = xTaskGetCurrentTaskHandle();
+    }
+
+    uxIndex = heapprofHASH( ( size_t ) pvCaller ^ ( size_t ) xTask, uxMask );
+
+    for( uxProbes = 0; uxProbes < ( UBaseType_t ) heapprofconfigMAX_SITES; uxProbes++ )
+    {
+        HeapProfilerSite_t * pxSite = &( xSites[ uxIndex ] );
+
+        if( heapprofSITE_IN_USE( pxSite ) == pdFALSE )
+        {
+            /* An unused entry, so the site is new. The caller records
+             * something for it straight away. */
+            pxSite->pvCaller = pvCaller;
+            pxSite->xTask = xTask;
+
+            if( xTask != NULL )
+            {
+                ( void ) strncpy( pxSite->cTaskName, pcTaskGetName( xTask ), sizeof( pxSite->cTaskName ) - 1U );
+            }
+
+            break;
+        }
+
+        if( ( pxSite->pvCaller == pvCaller ) && ( pxSite->xTask == xTask ) )
+        {
+            break;
+        }
+
+        uxIndex = ( uxIndex + 1U ) & uxMask;
+    }
+
+    if( uxProbes == ( UBaseType_t ) heapprofconfigMAX_SITES )
+    {
+        uxIndex = heapprofOVERFLOW_SITE;
+    }
+
+    return uxIndex;
+}
+/*-----------------------------------------------------------*/
+
+void HEAPPROF_RecordMalloc( void * pvAddress,
+                            size_t xSize,
+                            const void * pvCaller )
+{
+    HeapProfilerSite_t * pxSite;
+    UBaseType_t uxSite, uxIndex;
+    const UBaseType_t uxMask = ( UBaseType_t ) heapprofconfigMAX_LIVE_BLOCKS - 1U;
+
+    /* pvPortMalloc( 0 ) returns NULL as well, but is not a failure. */
+    if( ( pvAddress != NULL ) || ( xSize != 0U ) )
+    {
+        uxSite = prvFindSite( pvCaller );
+        pxSite = &( xSites[ uxSite ] );
+
+        if( pvAddress == NULL )
+        {
+            pxSite->ulFailures++;
+            ulFailures++;
+        }
+        else
+        {
+            pxSite->ulAllocations++;
+            pxSite->ulAllocatedBytes += ( uint32_t ) xSize;
+            ulAllocations++;
+            ulAllocatedBytes += ( uint32_t ) xSize;
+
+            /* One entry is always left unused, so that searches end. */
+            if( uxBlockCount < ( ( UBaseType_t ) heapprofconfigMAX_LIVE_BLOCKS - 1U ) )
+            {
+                uxIndex = heapprofHASH( ( size_t ) pvAddress, uxMask );
+
+                while( xBlocks[ uxIndex ].pvAddress != NULL )
+                {
+                    uxIndex = ( uxIndex + 1U ) & uxMask;
+                }
+
+                xBlocks[ uxIndex ].pvAddress = pvAddress;
+                xBlocks[ uxIndex ].ulSize = ( uint32_t ) xSize;
+                xBlocks[ uxIndex ].usSite = ( uint16_t ) uxSite;
+                uxBlockCount++;
+
+                pxSite->xLiveBytes += xSize;
+                pxSite->ulLiveBlocks++;
+
+                if( pxSite->xLiveBytes > pxSite->xPeakLiveBytes )
+                {
+                    pxSite->xPeakLiveBytes = pxSite->xLiveBytes;
+                }
+            }
+            else
+            {
+                ulUntrackedBlocks++;
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void HEAPPROF_RecordFree( void * pvAddress )
+{
+    HeapProfilerSite_t * pxSite;
+    UBaseType_t uxIndex, uxNext, uxHome;
+    const UBaseType_t uxMask = ( UBaseType_t ) heapprofconfigMAX_LIVE_BLOCKS - 1U;
+
+    ulFrees++;
+    uxIndex = heapprofHASH( ( size_t ) pvAddress, uxMask );
+
+    while( ( xBlocks[ uxIndex ].pvAddress != NULL ) && ( xBlocks[ uxIndex ].pvAddress != pvAddress ) )
+    {
+        uxIndex = ( uxIndex + 1U ) & uxMask;
+    }
+
+    if( xBlocks[ uxIndex ].pvAddress == NULL )
+    {
+        /* The block did not fit in the table when it was allocated. */
+        if( ulUntrackedBlocks > 0U )
+        {
+            ulUntrackedBlocks--;
+        }
+    }
+    else
+    {
+        pxSite = &( xSites[ xBlocks[ uxIndex ].usSite ] );
+        pxSite->xLiveBytes -= ( size_t ) xBlocks[ uxIndex ].ulSize;
+        pxSite->ulLiveBlocks--;
+        uxBlockCount--;
+
+        /* Move the following entries of the probe sequence back over the
+         * removed one, where that brings them closer to their home position,
+         * so that the table needs no deleted markers. */
+        uxNext = ( uxIndex + 1U ) & uxMask;
+
+        while( xBlocks[ uxNext ].pvAddress != NULL )
+        {
+            uxHome = heapprofHASH( ( size_t ) xBlocks[ uxNext ].pvAddress, uxMask );
+
+            if( ( ( uxNext - uxHome ) & uxMask ) >= ( ( uxNext - uxIndex ) & uxMask ) )
+            {
+                xBlocks[ uxIndex ] = xBlocks[ uxNext ];
+                uxIndex = uxNext;
+            }
+
+            uxNext = ( uxNext + 1U ) & uxMask;
+        }
+
+        xBlocks[ uxIndex ].pvAddress = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void HEAPPROF_GetSample( HeapProfilerSample_t * pxSample )
+{
+    UBaseType_t uxIndex;
+
+    /* Walks the free blocks, so it is done before the totals are copied. */
+    pxSample->xLargestFreeBlock = heapprofconfigLARGEST_FREE_BLOCK();
+
+    vTaskSuspendAll();
+    {
+        pxSample->xTime = xTaskGetTickCount();
+        pxSample->xFreeBytes = xPortGetFreeHeapSize();
+        pxSample->xMinimumEverFreeBytes = xPortGetMinimumEverFreeHeapSize();
+        pxSample->xLiveBytes = 0;
+        pxSample->ulLiveBlocks = ( uint32_t ) uxBlockCount;
+        pxSample->ulUntrackedBlocks = ulUntrackedBlocks;
+        pxSample->ulAllocations = ulAllocations;
+        pxSample->ulAllocatedBytes = ulAllocatedBytes;
+        pxSample->ulFrees = ulFrees;
+        pxSample->ulFailures = ulFailures;
+
+        for( uxIndex = 0; uxIndex <= heapprofOVERFLOW_SITE; uxIndex++ )
+        {
+            pxSample->xLiveBytes += xSites[ uxIndex ].xLiveBytes;
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    if( pxSample->xLargestFreeBlock >= pxSample->xFreeBytes )
+    {
+        pxSample->ulFragmentationPermille = 0;
+    }
+    else
+    {
+        pxSample->ulFragmentationPermille = ( uint32_t ) ( ( ( uint64_t ) ( pxSample->xFreeBytes - pxSample->xLargestFreeBlock ) * 1000U ) /
+                                                           pxSample->xFreeBytes );
+    }
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t HEAPPROF_GetSites( HeapProfilerSite_t * pxSites,
+                               UBaseType_t uxMaxSites )
+{
+    UBaseType_t uxCount = 0;
+    UBaseType_t uxIndex;
+
+    vTaskSuspendAll();
+    {
+        for( uxIndex = 0; ( uxIndex <= heapprofOVERFLOW_SITE ) && ( uxCount < uxMaxSites ); uxIndex++ )
+        {
+            if( heapprofSITE_IN_USE( &( xSites[ uxIndex ] ) ) )
+            {
+                pxSites[ uxCount ] = xSites[ uxIndex ];
+                uxCount++;
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Converts a count over a number of ticks to a count per second.
+ */
+static uint32_t prvPerSecond( uint32_t ulCount,
+                              TickType_t xTicks )
+{
+    uint32_t ulRate = 0;
+
+    if( xTicks != 0U )
+    {
+        ulRate = ( uint32_t ) ( ( ( uint64_t ) ulCount * configTICK_RATE_HZ ) / ( uint64_t ) xTicks );
+    }
+
+    return ulRate;
+}
+/*-----------------------------------------------------------*/
+
+void HEAPPROF_PrintReport( void )
+{
+    HeapProfilerSample_t xSample;
+    HeapProfilerSite_t xSite;
+    TickType_t xElapsed;
+    UBaseType_t uxRank, uxIndex, uxBest, uxPrevious = 0;
+    size_t xPreviousBytes = 0;
+    uint32_t ulSiteAllocations, ulSiteBytes;
+
+    HEAPPROF_GetSample( &xSample );
+    xElapsed = xSample.xTime - xReportedTime;
+
+    configPRINTF( ( "Heap: %u free, %u min ever free, %u largest free block, fragmentation %u.%u%%\r\n",
+                    ( unsigned ) xSample.xFreeBytes,
+                    ( unsigned ) xSample.xMinimumEverFreeBytes,
+                    ( unsigned ) xSample.xLargestFreeBlock,
+                    ( unsigned ) ( xSample.ulFragmentationPermille / 10U ),
+                    ( unsigned ) ( xSample.ulFragmentationPermille % 10U ) ) );
+    configPRINTF( ( "Heap: %u bytes live in %u blocks (%u untracked), %u allocations/s, %u bytes/s, %u failures\r\n",
+                    ( unsigned ) xSample.xLiveBytes,
+                    ( unsigned ) xSample.ulLiveBlocks,
+                    ( unsigned ) xSample.ulUntrackedBlocks,
+                    ( unsigned ) prvPerSecond( xSample.ulAllocations - ulReportedTotalAllocations, xElapsed ),
+                    ( unsigned ) prvPerSecond( xSample.ulAllocatedBytes - ulReportedTotalBytes, xElapsed ),
+                    ( unsigned ) xSample.ulFailures ) );
+
+    ulReportedTotalAllocations = xSample.ulAllocations;
+    ulReportedTotalBytes = xSample.ulAllocatedBytes;
+    xReportedTime = xSample.xTime;
+
+    /* Print the sites in order of live bytes, and of index for equal bytes,
+     * by looking for the next site in that order each time, so that no copy
+     * of the table is needed. Printing allocates in some logging
+     * implementations, so the table is only locked to copy one site. */
+    for( uxRank = 0; uxRank < heapprofconfigREPORT_SITES; uxRank++ )
+    {
+        uxBest = heapprofOVERFLOW_SITE + 1U;
+
+        for( uxIndex = 0; uxIndex <= heapprofOVERFLOW_SITE; uxIndex++ )
+        {
+            size_t xBytes = xSites[ uxIndex ].xLiveBytes;
+
+            if( heapprofSITE_IN_USE( &( xSites[ uxIndex ] ) ) &&
+                ( ( uxRank == 0U ) || ( xBytes < xPreviousBytes ) || ( ( xBytes == xPreviousBytes ) && ( uxIndex > uxPrevious ) ) ) &&
+                ( ( uxBest > heapprofOVERFLOW_SITE ) || ( xBytes > xSites[ uxBest ].xLiveBytes ) ) )
+            {
+                uxBest = uxIndex;
+            }
+        }
+
+        if( uxBest > heapprofOVERFLOW_SITE )
+        {
+            break;
+        }
+
+        vTaskSuspendAll();
+        {
+            xSite = xSites[ uxBest ];
+        }
+        ( void ) xTaskResumeAll();
+
+        ulSiteAllocations = xSite.ulAllocations - ulReportedAllocations[ uxBest ];
+        ulSiteBytes = xSite.ulAllocatedBytes - ulReportedBytes[ uxBest ];
+        ulReportedAllocations[ uxBest ] = xSite.ulAllocations;
+        ulReportedBytes[ uxBest ] = xSite.ulAllocatedBytes;
+
+        configPRINTF( ( "Heap: %p %s: %u bytes live in %u blocks, %u peak, %u allocations/s, %u bytes/s, %u failures\r\n",
+                        xSite.pvCaller,
+                        ( xSite.xTask != NULL ) ? xSite.cTaskName : "-",
+                        ( unsigned ) xSite.xLiveBytes,
+                        ( unsigned ) xSite.ulLiveBlocks,
+                        ( unsigned ) xSite.xPeakLiveBytes,
+                        ( unsigned ) prvPerSecond( ulSiteAllocations, xElapsed ),
+                        ( unsigned ) prvPerSecond( ulSiteBytes, xElapsed ),
+                        ( unsigned ) xSite.ulFailures ) );
+
+        xPreviousBytes = xSite.xLiveBytes;
+        uxPrevious = uxBest;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Prints a report every heapprofconfigREPORT_PERIOD_MS.
+ */
+static void prvHeapProfilerTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        vTaskDelay( pdMS_TO_TICKS( heapprofconfigREPORT_PERIOD_MS ) );
+        HEAPPROF_PrintReport();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t HEAPPROF_StartReporting( void )
+{
+    BaseType_t xResult = pdFAIL;
+
+    if( xTaskCreate( prvHeapProfilerTask,
+                     "HeapProf",
+                     heapprofconfigTASK_STACK_DEPTH,
+                     NULL,
+                     heapprofconfigTASK_PRIORITY,
+                     NULL ) == pdPASS )
+    {
+        xResult = pdPASS;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,417 @@
+/*
+ * Amazon FreeRTOS Histogram
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_histogram.c
+ * @brief Fixed size log-linear histograms.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "aws_histogram.h"
+
+#if ( histogramconfigSUB_BUCKET_BITS < 1U ) || ( histogramconfigSUB_BUCKET_BITS >= histogramconfigVALUE_BITS )
+    #error "histogramconfigSUB_BUCKET_BITS must be from 1 to histogramconfigVALUE_BITS - 1."
+#endif
+
+#if ( histogramconfigVALUE_BITS > 32U )
+    #error "histogramconfigVALUE_BITS must be at most 32."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Use the compiler's atomics where they are lock-free on the target.
+ *
+ * Otherwise the interrupt mask keeps interrupts from interleaving with a
+ * writer, which covers a single core.
+ */
+#if defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+    #define histogramENTER( uxSavedMask )    ( void ) ( uxSavedMask )
+    #define histogramEXIT( uxSavedMask )     ( void ) ( uxSavedMask )
+    #define histogramLOAD( pulValue )        __atomic_load_n( ( pulValue ), __ATOMIC_RELAXED )
+    #define histogramINCREMENT( pulValue )   ( void ) __atomic_fetch_add( ( pulValue ), 1U, __ATOMIC_RELAXED )
+    #define histogramEXCHANGE( pulValue, ulNew ) \
+    __atomic_exchange_n( ( pulValue ), ( ulNew ), __ATOMIC_RELAXED )
+#else
+    #define histogramENTER( uxSavedMask )    ( uxSavedMask ) = portSET_INTERRUPT_MASK_FROM_ISR()
+    #define histogramEXIT( uxSavedMask )     portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedMask )
+    #define histogramLOAD( pulValue )        ( *( pulValue ) )
+    #define histogramINCREMENT( pulValue )   ( *( pulValue ) )++
+    #define histogramEXCHANGE( pulValue, ulNew ) \
+    prvExchange( ( pulValue ), ( ulNew ) )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Raises a value to at least ulValue.
+ *
+ * Called with interrupts masked when there are no atomics.
+ */
+static void prvRaise( volatile uint32_t * pulValue,
+                      uint32_t ulValue );
+
+#if !defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+
+/**
+ * @brief Replaces a value, with interrupts masked.
+ */
+    static uint32_t prvExchange( volatile uint32_t * pulValue,
+                                 uint32_t ulNew );
+#endif
+
+/**
+ * @brief Returns the number of values in a bucket.
+ */
+static uint32_t prvBucketWidth( uint32_t ulBucket );
+
+/*-----------------------------------------------------------*/
+
+static void prvRaise( volatile uint32_t * pulValue,
+                      uint32_t ulValue )
+{
+    #if defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+        uint32_t ulCurrent = __atomic_load_n( pulValue, __ATOMIC_RELAXED );
+
+        /* A failed exchange reloads ulCurrent, so this stops as soon as another
+         * writer has stored a value at least as large. */
+        while( ( ulCurrent < ulValue ) &&
+               ( __atomic_compare_exchange_n( pulValue,
+                                              &ulCurrent,
+                                              ulValue,
+                                              pdTRUE,
+                                              __ATOMIC_RELAXED,
+                                              __ATOMIC_RELAXED ) == pdFALSE ) )
+        {
+        }
+    #else
+        if( *pulValue < ulValue )
+        {
+            *pulValue = ulValue;
+        }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+#if !defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+    static uint32_t prvExchange( volatile uint32_t * pulValue,
+                                 uint32_t ulNew )
+    {
+        UBaseType_t uxSavedMask;
+        uint32_t ulOld;
+
+        uxSavedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+        ulOld = *pulValue;
+        *pulValue = ulNew;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedMask );
+
+        return ulOld;
+    }
+#endif
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBucketWidth( uint32_t ulBucket )
+{
+    uint32_t ulWidth = 1U;
+
+    if( ulBucket >= histogramSUB_BUCKETS )
+    {
+        ulWidth = 1UL << ( ( ulBucket >> histogramconfigSUB_BUCKET_BITS ) - 1U );
+    }
+
+    return ulWidth;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetBucketIndex( uint32_t ulValue )
+{
+    uint32_t ulBucket;
+    uint32_t ulTopBit = 0U;
+    uint32_t ulRest;
+
+    if( ulValue < histogramSUB_BUCKETS )
+    {
+        ulBucket = ulValue;
+    }
+    else
+    {
+        for( ulRest = ulValue >> 1; ulRest != 0U; ulRest >>= 1 )
+        {
+            ulTopBit++;
+        }
+
+        if( ulTopBit >= histogramconfigVALUE_BITS )
+        {
+            ulBucket = histogramOVERFLOW_BUCKET;
+        }
+        else
+        {
+            /* The power of two range selects a group of buckets, the bits
+             * below the top one the bucket in the group. */
+            ulBucket = ( ( ulTopBit - histogramconfigSUB_BUCKET_BITS + 1U ) << histogramconfigSUB_BUCKET_BITS ) +
+                       ( ( ulValue >> ( ulTopBit - histogramconfigSUB_BUCKET_BITS ) ) - histogramSUB_BUCKETS );
+        }
+    }
+
+    return ulBucket;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetBucketLowerBound( uint32_t ulBucket )
+{
+    uint32_t ulLower;
+
+    if( ulBucket < histogramSUB_BUCKETS )
+    {
+        ulLower = ulBucket;
+    }
+    else if( ulBucket >= histogramOVERFLOW_BUCKET )
+    {
+        #if ( histogramconfigVALUE_BITS < 32U )
+            ulLower = 1UL << histogramconfigVALUE_BITS;
+        #else
+            ulLower = UINT32_MAX;
+        #endif
+    }
+    else
+    {
+        ulLower = ( histogramSUB_BUCKETS + ( ulBucket & ( histogramSUB_BUCKETS - 1U ) ) ) *
+                  prvBucketWidth( ulBucket );
+    }
+
+    return ulLower;
+}
+/*-----------------------------------------------------------*/
+
+void HISTOGRAM_Record( Histogram_t * pxHistogram,
+                       uint32_t ulValue )
+{
+    UBaseType_t uxSavedMask = 0;
+
+    histogramENTER( uxSavedMask );
+    histogramINCREMENT( &( pxHistogram->ulCounts[ HISTOGRAM_GetBucketIndex( ulValue ) ] ) );
+    prvRaise( &( pxHistogram->ulMax ), ulValue );
+    prvRaise( &( pxHistogram->ulInvertedMin ), ~ulValue );
+    histogramEXIT( uxSavedMask );
+}
+/*-----------------------------------------------------------*/
+
+void HISTOGRAM_Reset( Histogram_t * pxHistogram )
+{
+    uint32_t ulBucket;
+
+    for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+    {
+        ( void ) histogramEXCHANGE( &( pxHistogram->ulCounts[ ulBucket ] ), 0U );
+    }
+
+    ( void ) histogramEXCHANGE( &( pxHistogram->ulMax ), 0U );
+    ( void ) histogramEXCHANGE( &( pxHistogram->ulInvertedMin ), 0U );
+}
+/*-----------------------------------------------------------*/
+
+void HISTOGRAM_Snapshot( const Histogram_t * pxHistogram,
+                         Histogram_t * pxSnapshot )
+{
+    uint32_t ulBucket;
+
+    for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+    {
+        pxSnapshot->ulCounts[ ulBucket ] = histogramLOAD( &( pxHistogram->ulCounts[ ulBucket ] ) );
+    }
+
+    pxSnapshot->ulMax = histogramLOAD( &( pxHistogram->ulMax ) );
+    pxSnapshot->ulInvertedMin = histogramLOAD( &( pxHistogram->ulInvertedMin ) );
+}
+/*-----------------------------------------------------------*/
+
+void HISTOGRAM_SnapshotAndReset( Histogram_t * pxHistogram,
+                                 Histogram_t * pxSnapshot )
+{
+    uint32_t ulBucket;
+
+    for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+    {
+        pxSnapshot->ulCounts[ ulBucket ] = histogramEXCHANGE( &( pxHistogram->ulCounts[ ulBucket ] ), 0U );
+    }
+
+    pxSnapshot->ulMax = histogramEXCHANGE( &( pxHistogram->ulMax ), 0U );
+    pxSnapshot->ulInvertedMin = histogramEXCHANGE( &( pxHistogram->ulInvertedMin ), 0U );
+}
+/*-----------------------------------------------------------*/
+
+void HISTOGRAM_Merge( Histogram_t * pxDestination,
+                      const Histogram_t * pxSource )
+{
+    uint32_t ulBucket;
+
+    for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+    {
+        pxDestination->ulCounts[ ulBucket ] += histogramLOAD( &( pxSource->ulCounts[ ulBucket ] ) );
+    }
+
+    prvRaise( &( pxDestination->ulMax ), histogramLOAD( &( pxSource->ulMax ) ) );
+    prvRaise( &( pxDestination->ulInvertedMin ), histogramLOAD( &( pxSource->ulInvertedMin ) ) );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetCount( const Histogram_t * pxHistogram )
+{
+    uint32_t ulBucket;
+    uint32_t ulCount = 0U;
+
+    for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+    {
+        ulCount += histogramLOAD( &( pxHistogram->ulCounts[ ulBucket ] ) );
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetMin( const Histogram_t * pxHistogram )
+{
+    uint32_t ulMin = 0U;
+
+    /* The inverse is zero only when nothing was recorded, as recording
+     * UINT32_MAX also counts it in the overflow bucket. */
+    if( HISTOGRAM_GetCount( pxHistogram ) != 0U )
+    {
+        ulMin = ~histogramLOAD( &( pxHistogram->ulInvertedMin ) );
+    }
+
+    return ulMin;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetMax( const Histogram_t * pxHistogram )
+{
+    return histogramLOAD( &( pxHistogram->ulMax ) );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetMean( const Histogram_t * pxHistogram )
+{
+    uint32_t ulBucket;
+    uint32_t ulCount;
+    uint32_t ulMiddle;
+    uint32_t ulTotalCount = 0U;
+    uint64_t ullSum = 0U;
+    uint32_t ulMean = 0U;
+
+    for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+    {
+        ulCount = histogramLOAD( &( pxHistogram->ulCounts[ ulBucket ] ) );
+
+        if( ulCount != 0U )
+        {
+            /* The overflow bucket has no upper end; its values are at least
+             * as large as its lower end and at most the maximum. */
+            if( ulBucket == histogramOVERFLOW_BUCKET )
+            {
+                ulMiddle = histogramLOAD( &( pxHistogram->ulMax ) );
+            }
+            else
+            {
+                ulMiddle = HISTOGRAM_GetBucketLowerBound( ulBucket ) +
+                           ( ( prvBucketWidth( ulBucket ) - 1U ) / 2U );
+            }
+
+            ullSum += ( uint64_t ) ulMiddle * ulCount;
+            ulTotalCount += ulCount;
+        }
+    }
+
+    if( ulTotalCount != 0U )
+    {
+        ulMean = ( uint32_t ) ( ullSum / ulTotalCount );
+    }
+
+    return ulMean;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HISTOGRAM_GetPercentile( const Histogram_t * pxHistogram,
+                                  uint32_t ulPerMille )
+{
+    uint32_t ulBucket;
+    uint32_t ulRank;
+    uint32_t ulSeen = 0U;
+    uint32_t ulResult = 0U;
+    uint32_t ulCount = HISTOGRAM_GetCount( pxHistogram );
+    uint32_t ulMin = HISTOGRAM_GetMin( pxHistogram );
+    uint32_t ulMax = HISTOGRAM_GetMax( pxHistogram );
+
+    if( ulPerMille > 1000U )
+    {
+        ulPerMille = 1000U;
+    }
+
+    if( ulCount != 0U )
+    {
+        /* The rank of the value sought, counting from one. */
+        ulRank = ( uint32_t ) ( ( ( ( uint64_t ) ulCount * ulPerMille ) + 999U ) / 1000U );
+
+        if( ulRank == 0U )
+        {
+            ulRank = 1U;
+        }
+
+        for( ulBucket = 0U; ulBucket < histogramBUCKET_COUNT; ulBucket++ )
+        {
+            ulSeen += histogramLOAD( &( pxHistogram->ulCounts[ ulBucket ] ) );
+
+            if( ulSeen >= ulRank )
+            {
+                break;
+            }
+        }
+
+        if( ulBucket >= histogramOVERFLOW_BUCKET )
+        {
+            ulResult = ulMax;
+        }
+        else
+        {
+            ulResult = HISTOGRAM_GetBucketLowerBound( ulBucket ) + prvBucketWidth( ulBucket ) - 1U;
+
+            /* The bucket ends can be outside the values actually recorded. */
+            if( ulResult > ulMax )
+            {
+                ulResult = ulMax;
+            }
+
+            if( ulResult < ulMin )
+            {
+                ulResult = ulMin;
+            }
+        }
+    }
+
+    return ulResult;
+}
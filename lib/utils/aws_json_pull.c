@@ -0,0 +1,640 @@
+/*
+ * Amazon FreeRTOS JSON Pull Parser
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_json_pull.c
+ * @brief Incremental JSON pull parser with path based key matching.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* JSON pull parser includes. */
+#include "aws_json_pull.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Returns pdTRUE for the whitespace characters allowed between tokens.
+ */
+static BaseType_t prvIsWhitespace( char cChar );
+
+/**
+ * @brief Returns pdTRUE for the characters that end a primitive value.
+ */
+static BaseType_t prvIsDelimiter( char cChar );
+
+/**
+ * @brief Appends characters to the current path.
+ *
+ * The path becomes jsonpullPATH_TOO_LONG if they do not fit, and stays so
+ * until it is cut back to a shorter container path.
+ */
+static void prvAppendPath( JSONPullParser_t * pxParser,
+                           const char * pcText,
+                           size_t xLength );
+
+/**
+ * @brief Sets the current path to the path of the next element of the
+ * innermost array, and counts the element.
+ */
+static void prvSetElementPath( JSONPullParser_t * pxParser );
+
+/**
+ * @brief Copies the part of the current value that is in the current chunk,
+ * up to xEnd, to the scratch buffer.
+ */
+static void prvSaveValue( JSONPullParser_t * pxParser,
+                          size_t xEnd );
+
+/**
+ * @brief Opens an object or array and sets the start event.
+ */
+static JSONPullStatus_t prvOpenContainer( JSONPullParser_t * pxParser,
+                                          BaseType_t xIsArray,
+                                          JSONPullEvent_t * pxEvent );
+
+/**
+ * @brief Closes the innermost container and sets the end event.
+ */
+static JSONPullStatus_t prvCloseContainer( JSONPullParser_t * pxParser,
+                                           JSONPullEvent_t * pxEvent );
+
+/**
+ * @brief Ends the current string or primitive at xEnd and sets its event.
+ */
+static void prvEndValue( JSONPullParser_t * pxParser,
+                         JSONPullEventType_t xType,
+                         size_t xEnd,
+                         JSONPullEvent_t * pxEvent );
+
+/**
+ * @brief Sets the type and path of an event; the value is cleared.
+ */
+static void prvSetEvent( const JSONPullParser_t * pxParser,
+                         JSONPullEventType_t xType,
+                         JSONPullEvent_t * pxEvent );
+
+/**
+ * @brief Returns pdTRUE if the innermost container is an array.
+ */
+#define jsonpullIN_ARRAY( pxParser ) \
+    ( ( ( ( pxParser )->ulArrayMask >> ( ( pxParser )->ucDepth - ( uint8_t ) 1 ) ) & ( uint32_t ) 1 ) != ( uint32_t ) 0 )
+
+/*-----------------------------------------------------------*/
+
+void JSONPULL_Init( JSONPullParser_t * pxParser,
+                    char * pcScratch,
+                    size_t xScratchSize )
+{
+    configASSERT( pxParser != NULL );
+
+    memset( pxParser, 0x00, sizeof( JSONPullParser_t ) );
+    pxParser->xState = eJSONPullStateValue;
+    pxParser->pcScratch = pcScratch;
+    pxParser->xScratchSize = ( pcScratch != NULL ) ? xScratchSize : ( size_t ) 0;
+}
+/*-----------------------------------------------------------*/
+
+void JSONPULL_SetInput( JSONPullParser_t * pxParser,
+                        const char * pcInput,
+                        size_t xInputLength )
+{
+    configASSERT( pxParser != NULL );
+    configASSERT( ( pcInput != NULL ) || ( xInputLength == ( size_t ) 0 ) );
+
+    pxParser->pcInput = pcInput;
+    pxParser->xInputLength = xInputLength;
+    pxParser->xInputIndex = 0;
+
+    /* A value that was cut by the end of the previous chunk continues at the
+     * start of this one. */
+    pxParser->xValueStart = 0;
+}
+/*-----------------------------------------------------------*/
+
+JSONPullStatus_t JSONPULL_Next( JSONPullParser_t * pxParser,
+                                JSONPullEvent_t * pxEvent )
+{
+    JSONPullStatus_t xReturn = eJSONPullNeedInput;
+    BaseType_t xEventFound = pdFALSE;
+    size_t xIndex;
+    char cChar;
+
+    configASSERT( pxParser != NULL );
+    configASSERT( pxEvent != NULL );
+
+    while( ( xEventFound == pdFALSE ) && ( pxParser->xInputIndex < pxParser->xInputLength ) &&
+           ( pxParser->xState != eJSONPullStateComplete ) && ( pxParser->xState != eJSONPullStateInvalid ) )
+    {
+        xIndex = pxParser->xInputIndex;
+        cChar = pxParser->pcInput[ xIndex ];
+
+        /* Most states consume the character; the ones that do not set
+         * xInputIndex back. */
+        pxParser->xInputIndex++;
+
+        switch( pxParser->xState )
+        {
+            case eJSONPullStateValue:
+            case eJSONPullStateValueOrEnd:
+
+                if( prvIsWhitespace( cChar ) == pdTRUE )
+                {
+                    /* Skip. */
+                }
+                else if( ( cChar == ']' ) && ( pxParser->xState == eJSONPullStateValueOrEnd ) )
+                {
+                    xReturn = prvCloseContainer( pxParser, pxEvent );
+                    xEventFound = pdTRUE;
+                }
+                else if( ( cChar == ',' ) || ( cChar == ':' ) || ( cChar == '}' ) || ( cChar == ']' ) ||
+                         ( ( pxParser->ucDepth == ( uint8_t ) 0 ) && ( cChar != '{' ) && ( cChar != '[' ) ) )
+                {
+                    /* Misplaced structural character, or a top-level value
+                     * that is not a container. */
+                    pxParser->xState = eJSONPullStateInvalid;
+                    xReturn = eJSONPullInvalid;
+                }
+                else
+                {
+                    if( ( pxParser->ucDepth > ( uint8_t ) 0 ) && jsonpullIN_ARRAY( pxParser ) )
+                    {
+                        prvSetElementPath( pxParser );
+                    }
+
+                    if( ( cChar == '{' ) || ( cChar == '[' ) )
+                    {
+                        xReturn = prvOpenContainer( pxParser, ( cChar == '[' ) ? pdTRUE : pdFALSE, pxEvent );
+                        xEventFound = pdTRUE;
+                    }
+                    else
+                    {
+                        pxParser->xValueInScratch = pdFALSE;
+                        pxParser->xValueTruncated = pdFALSE;
+                        pxParser->xScratchLength = 0;
+
+                        if( cChar == '"' )
+                        {
+                            pxParser->xValueStart = xIndex + ( size_t ) 1;
+                            pxParser->xEscape = pdFALSE;
+                            pxParser->xState = eJSONPullStateInString;
+                        }
+                        else
+                        {
+                            pxParser->xValueStart = xIndex;
+                            pxParser->xState = eJSONPullStateInPrimitive;
+                        }
+                    }
+                }
+
+                break;
+
+            case eJSONPullStateKeyOrEnd:
+            case eJSONPullStateKey:
+
+                if( prvIsWhitespace( cChar ) == pdTRUE )
+                {
+                    /* Skip. */
+                }
+                else if( ( cChar == '}' ) && ( pxParser->xState == eJSONPullStateKeyOrEnd ) )
+                {
+                    xReturn = prvCloseContainer( pxParser, pxEvent );
+                    xEventFound = pdTRUE;
+                }
+                else if( cChar == '"' )
+                {
+                    /* The key replaces the previous member's key in the path. */
+                    pxParser->usPathLength = pxParser->pusContainerPathLength[ pxParser->ucDepth - ( uint8_t ) 1 ];
+
+                    if( ( pxParser->usPathLength != jsonpullPATH_TOO_LONG ) && ( pxParser->usPathLength > ( uint16_t ) 0 ) )
+                    {
+                        prvAppendPath( pxParser, ".", 1 );
+                    }
+
+                    pxParser->xEscape = pdFALSE;
+                    pxParser->xState = eJSONPullStateInKey;
+                }
+                else
+                {
+                    pxParser->xState = eJSONPullStateInvalid;
+                    xReturn = eJSONPullInvalid;
+                }
+
+                break;
+
+            case eJSONPullStateInKey:
+
+                if( pxParser->xEscape == pdTRUE )
+                {
+                    pxParser->xEscape = pdFALSE;
+                }
+                else if( cChar == '\\' )
+                {
+                    pxParser->xEscape = pdTRUE;
+                }
+                else if( cChar == '"' )
+                {
+                    pxParser->xState = eJSONPullStateColon;
+                }
+                else
+                {
+                    /* Not the end of the key. */
+                }
+
+                if( pxParser->xState == eJSONPullStateInKey )
+                {
+                    prvAppendPath( pxParser, &cChar, 1 );
+                }
+
+                break;
+
+            case eJSONPullStateColon:
+
+                if( cChar == ':' )
+                {
+                    pxParser->xState = eJSONPullStateValue;
+                }
+                else if( prvIsWhitespace( cChar ) == pdFALSE )
+                {
+                    pxParser->xState = eJSONPullStateInvalid;
+                    xReturn = eJSONPullInvalid;
+                }
+                else
+                {
+                    /* Skip. */
+                }
+
+                break;
+
+            case eJSONPullStateInString:
+
+                if( pxParser->xEscape == pdTRUE )
+                {
+                    pxParser->xEscape = pdFALSE;
+                }
+                else if( cChar == '\\' )
+                {
+                    pxParser->xEscape = pdTRUE;
+                }
+                else if( cChar == '"' )
+                {
+                    prvEndValue( pxParser, eJSONPullString, xIndex, pxEvent );
+                    xReturn = eJSONPullEvent;
+                    xEventFound = pdTRUE;
+                }
+                else
+                {
+                    /* Part of the string. */
+                }
+
+                break;
+
+            case eJSONPullStateInPrimitive:
+
+                if( prvIsDelimiter( cChar ) == pdTRUE )
+                {
+                    /* The delimiter is read again in the next state. */
+                    pxParser->xInputIndex = xIndex;
+                    prvEndValue( pxParser, eJSONPullPrimitive, xIndex, pxEvent );
+                    xReturn = eJSONPullEvent;
+                    xEventFound = pdTRUE;
+                }
+                else if( cChar == '"' )
+                {
+                    pxParser->xState = eJSONPullStateInvalid;
+                    xReturn = eJSONPullInvalid;
+                }
+                else
+                {
+                    /* Part of the primitive. */
+                }
+
+                break;
+
+            case eJSONPullStateCommaOrEnd:
+
+                if( prvIsWhitespace( cChar ) == pdTRUE )
+                {
+                    /* Skip. */
+                }
+                else if( cChar == ',' )
+                {
+                    pxParser->xState = jsonpullIN_ARRAY( pxParser ) ? eJSONPullStateValue : eJSONPullStateKey;
+                }
+                else if( ( ( cChar == ']' ) && jsonpullIN_ARRAY( pxParser ) ) ||
+                         ( ( cChar == '}' ) && !jsonpullIN_ARRAY( pxParser ) ) )
+                {
+                    xReturn = prvCloseContainer( pxParser, pxEvent );
+                    xEventFound = pdTRUE;
+                }
+                else
+                {
+                    pxParser->xState = eJSONPullStateInvalid;
+                    xReturn = eJSONPullInvalid;
+                }
+
+                break;
+
+            default:
+                /* Complete and invalid are not entered in this loop. */
+                break;
+        }
+    }
+
+    if( xEventFound == pdFALSE )
+    {
+        if( pxParser->xState == eJSONPullStateComplete )
+        {
+            xReturn = eJSONPullComplete;
+        }
+        else if( pxParser->xState == eJSONPullStateInvalid )
+        {
+            /* Keep eJSONPullTooDeep if that was the reason. */
+            if( xReturn != eJSONPullTooDeep )
+            {
+                xReturn = eJSONPullInvalid;
+            }
+        }
+        else
+        {
+            /* The chunk ended in the middle of a value; keep what was read. */
+            if( ( pxParser->xState == eJSONPullStateInString ) || ( pxParser->xState == eJSONPullStateInPrimitive ) )
+            {
+                prvSaveValue( pxParser, pxParser->xInputLength );
+            }
+
+            xReturn = eJSONPullNeedInput;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t JSONPULL_PathMatch( const JSONPullEvent_t * pxEvent,
+                               const char * pcPattern )
+{
+    BaseType_t xReturn = pdFALSE;
+    size_t xPathIndex = 0, xPatternIndex = 0;
+
+    configASSERT( pcPattern != NULL );
+
+    if( ( pxEvent != NULL ) && ( pxEvent->xPathTooLong == pdFALSE ) )
+    {
+        xReturn = pdTRUE;
+
+        while( ( xReturn == pdTRUE ) && ( pcPattern[ xPatternIndex ] != '\0' ) )
+        {
+            if( ( pcPattern[ xPatternIndex ] == '[' ) && ( pcPattern[ xPatternIndex + ( size_t ) 1 ] == '*' ) &&
+                ( pcPattern[ xPatternIndex + ( size_t ) 2 ] == ']' ) )
+            {
+                /* A wildcard index matches "[" digits "]". */
+                if( ( xPathIndex < pxEvent->xPathLength ) && ( pxEvent->pcPath[ xPathIndex ] == '[' ) )
+                {
+                    xPathIndex++;
+
+                    while( ( xPathIndex < pxEvent->xPathLength ) && ( pxEvent->pcPath[ xPathIndex ] != ']' ) )
+                    {
+                        xPathIndex++;
+                    }
+
+                    xPathIndex++;
+                }
+                else
+                {
+                    xReturn = pdFALSE;
+                }
+
+                xPatternIndex += ( size_t ) 3;
+            }
+            else if( ( xPathIndex < pxEvent->xPathLength ) &&
+                     ( pxEvent->pcPath[ xPathIndex ] == pcPattern[ xPatternIndex ] ) )
+            {
+                xPathIndex++;
+                xPatternIndex++;
+            }
+            else
+            {
+                xReturn = pdFALSE;
+            }
+        }
+
+        /* The whole path must have been matched. */
+        if( xPathIndex != pxEvent->xPathLength )
+        {
+            xReturn = pdFALSE;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsWhitespace( char cChar )
+{
+    return ( ( cChar == ' ' ) || ( cChar == '\t' ) || ( cChar == '\r' ) || ( cChar == '\n' ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsDelimiter( char cChar )
+{
+    return ( ( cChar == ',' ) || ( cChar == '}' ) || ( cChar == ']' ) || ( cChar == ':' ) ||
+             ( prvIsWhitespace( cChar ) == pdTRUE ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAppendPath( JSONPullParser_t * pxParser,
+                           const char * pcText,
+                           size_t xLength )
+{
+    if( pxParser->usPathLength != jsonpullPATH_TOO_LONG )
+    {
+        if( ( ( size_t ) pxParser->usPathLength + xLength ) <= ( size_t ) jsonpullconfigMAX_PATH_LENGTH )
+        {
+            memcpy( &( pxParser->cPath[ pxParser->usPathLength ] ), pcText, xLength );
+            pxParser->usPathLength += ( uint16_t ) xLength;
+        }
+        else
+        {
+            pxParser->usPathLength = jsonpullPATH_TOO_LONG;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetElementPath( JSONPullParser_t * pxParser )
+{
+    const uint8_t ucArray = pxParser->ucDepth - ( uint8_t ) 1;
+    char cIndex[ 12 ];
+    size_t xIndexLength = sizeof( cIndex );
+    uint32_t ulIndex = pxParser->pulElementIndex[ ucArray ];
+
+    /* Write "[index]" from the end of cIndex. */
+    xIndexLength--;
+    cIndex[ xIndexLength ] = ']';
+
+    do
+    {
+        xIndexLength--;
+        cIndex[ xIndexLength ] = ( char ) ( '0' + ( char ) ( ulIndex % ( uint32_t ) 10 ) );
+        ulIndex /= ( uint32_t ) 10;
+    } while( ulIndex > ( uint32_t ) 0 );
+
+    xIndexLength--;
+    cIndex[ xIndexLength ] = '[';
+
+    pxParser->usPathLength = pxParser->pusContainerPathLength[ ucArray ];
+    prvAppendPath( pxParser, &( cIndex[ xIndexLength ] ), sizeof( cIndex ) - xIndexLength );
+    pxParser->pulElementIndex[ ucArray ]++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSaveValue( JSONPullParser_t * pxParser,
+                          size_t xEnd )
+{
+    size_t xLength = xEnd - pxParser->xValueStart;
+
+    if( xLength > ( pxParser->xScratchSize - pxParser->xScratchLength ) )
+    {
+        xLength = pxParser->xScratchSize - pxParser->xScratchLength;
+        pxParser->xValueTruncated = pdTRUE;
+    }
+
+    if( xLength > ( size_t ) 0 )
+    {
+        memcpy( &( pxParser->pcScratch[ pxParser->xScratchLength ] ),
+                &( pxParser->pcInput[ pxParser->xValueStart ] ),
+                xLength );
+        pxParser->xScratchLength += xLength;
+    }
+
+    pxParser->xValueInScratch = pdTRUE;
+    pxParser->xValueStart = xEnd;
+}
+/*-----------------------------------------------------------*/
+
+static JSONPullStatus_t prvOpenContainer( JSONPullParser_t * pxParser,
+                                          BaseType_t xIsArray,
+                                          JSONPullEvent_t * pxEvent )
+{
+    JSONPullStatus_t xReturn = eJSONPullEvent;
+    const uint32_t ulBit = ( uint32_t ) 1 << pxParser->ucDepth;
+
+    if( pxParser->ucDepth >= ( uint8_t ) jsonpullconfigMAX_DEPTH )
+    {
+        pxParser->xState = eJSONPullStateInvalid;
+        xReturn = eJSONPullTooDeep;
+    }
+    else
+    {
+        prvSetEvent( pxParser, ( xIsArray == pdTRUE ) ? eJSONPullArrayStart : eJSONPullObjectStart, pxEvent );
+
+        pxParser->pusContainerPathLength[ pxParser->ucDepth ] = pxParser->usPathLength;
+        pxParser->pulElementIndex[ pxParser->ucDepth ] = 0;
+
+        if( xIsArray == pdTRUE )
+        {
+            pxParser->ulArrayMask |= ulBit;
+            pxParser->xState = eJSONPullStateValueOrEnd;
+        }
+        else
+        {
+            pxParser->ulArrayMask &= ~ulBit;
+            pxParser->xState = eJSONPullStateKeyOrEnd;
+        }
+
+        pxParser->ucDepth++;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static JSONPullStatus_t prvCloseContainer( JSONPullParser_t * pxParser,
+                                           JSONPullEvent_t * pxEvent )
+{
+    const BaseType_t xIsArray = jsonpullIN_ARRAY( pxParser ) ? pdTRUE : pdFALSE;
+
+    pxParser->ucDepth--;
+    pxParser->usPathLength = pxParser->pusContainerPathLength[ pxParser->ucDepth ];
+    prvSetEvent( pxParser, ( xIsArray == pdTRUE ) ? eJSONPullArrayEnd : eJSONPullObjectEnd, pxEvent );
+
+    pxParser->xState = ( pxParser->ucDepth == ( uint8_t ) 0 ) ? eJSONPullStateComplete : eJSONPullStateCommaOrEnd;
+
+    return eJSONPullEvent;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndValue( JSONPullParser_t * pxParser,
+                         JSONPullEventType_t xType,
+                         size_t xEnd,
+                         JSONPullEvent_t * pxEvent )
+{
+    prvSetEvent( pxParser, xType, pxEvent );
+
+    if( pxParser->xValueInScratch == pdTRUE )
+    {
+        prvSaveValue( pxParser, xEnd );
+        pxEvent->pcValue = pxParser->pcScratch;
+        pxEvent->xValueLength = pxParser->xScratchLength;
+        pxEvent->xValueTruncated = pxParser->xValueTruncated;
+    }
+    else
+    {
+        pxEvent->pcValue = &( pxParser->pcInput[ pxParser->xValueStart ] );
+        pxEvent->xValueLength = xEnd - pxParser->xValueStart;
+    }
+
+    pxParser->xState = eJSONPullStateCommaOrEnd;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetEvent( const JSONPullParser_t * pxParser,
+                         JSONPullEventType_t xType,
+                         JSONPullEvent_t * pxEvent )
+{
+    pxEvent->xType = xType;
+    pxEvent->pcPath = pxParser->cPath;
+
+    if( pxParser->usPathLength == jsonpullPATH_TOO_LONG )
+    {
+        pxEvent->xPathLength = 0;
+        pxEvent->xPathTooLong = pdTRUE;
+    }
+    else
+    {
+        pxEvent->xPathLength = ( size_t ) pxParser->usPathLength;
+        pxEvent->xPathTooLong = pdFALSE;
+    }
+
+    pxEvent->pcValue = NULL;
+    pxEvent->xValueLength = 0;
+    pxEvent->xValueTruncated = pdFALSE;
+}
+/*-----------------------------------------------------------*/
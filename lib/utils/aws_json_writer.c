@@ -0,0 +1,549 @@
+/*
+ * Amazon FreeRTOS JSON Writer
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_json_writer.c
+ * @brief Streaming JSON writer without printf and without memory allocation.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* JSON writer includes. */
+#include "aws_json_writer.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Appends one character, keeping the document NUL terminated if there
+ * is room. The length is counted even when the character does not fit.
+ */
+static void prvPutChar( JSONWriter_t * pxWriter,
+                        char cChar );
+
+/**
+ * @brief Appends characters as they are.
+ */
+static void prvPutRaw( JSONWriter_t * pxWriter,
+                       const char * pcText,
+                       size_t xLength );
+
+/**
+ * @brief Appends characters, escaping those that may not appear in a string.
+ */
+static void prvPutEscaped( JSONWriter_t * pxWriter,
+                           const char * pcText,
+                           size_t xLength );
+
+/**
+ * @brief Appends an unsigned integer in decimal.
+ */
+static void prvPutUInt( JSONWriter_t * pxWriter,
+                        uint32_t ulValue );
+
+/**
+ * @brief Writes the comma before a value, if needed, and checks that a value
+ * may be written here.
+ */
+static void prvBeginValue( JSONWriter_t * pxWriter );
+
+/**
+ * @brief Opens an object or an array.
+ */
+static void prvOpen( JSONWriter_t * pxWriter,
+                     BaseType_t xIsArray,
+                     char cOpen );
+
+/**
+ * @brief Closes the innermost object or array.
+ */
+static void prvClose( JSONWriter_t * pxWriter,
+                      BaseType_t xIsArray,
+                      char cClose );
+
+/*-----------------------------------------------------------*/
+
+static void prvPutChar( JSONWriter_t * pxWriter,
+                        char cChar )
+{
+    if( ( pxWriter->xLength + 1U ) < pxWriter->xBufferSize )
+    {
+        pxWriter->pcBuffer[ pxWriter->xLength ] = cChar;
+        pxWriter->pcBuffer[ pxWriter->xLength + 1U ] = '\0';
+    }
+
+    pxWriter->xLength++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutRaw( JSONWriter_t * pxWriter,
+                       const char * pcText,
+                       size_t xLength )
+{
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < xLength; xIndex++ )
+    {
+        prvPutChar( pxWriter, pcText[ xIndex ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutEscaped( JSONWriter_t * pxWriter,
+                           const char * pcText,
+                           size_t xLength )
+{
+    static const char cHexDigits[] = "0123456789abcdef";
+    size_t xIndex;
+    uint8_t ucChar;
+
+    for( xIndex = 0; xIndex < xLength; xIndex++ )
+    {
+        ucChar = ( uint8_t ) pcText[ xIndex ];
+
+        switch( ucChar )
+        {
+            case '"':
+            case '\\':
+                prvPutChar( pxWriter, '\\' );
+                prvPutChar( pxWriter, ( char ) ucChar );
+                break;
+
+            case '\n':
+                prvPutRaw( pxWriter, "\\n", 2U );
+                break;
+
+            case '\r':
+                prvPutRaw( pxWriter, "\\r", 2U );
+                break;
+
+            case '\t':
+                prvPutRaw( pxWriter, "\\t", 2U );
+                break;
+
+            case '\b':
+                prvPutRaw( pxWriter, "\\b", 2U );
+                break;
+
+            case '\f':
+                prvPutRaw( pxWriter, "\\f", 2U );
+                break;
+
+            default:
+
+                if( ucChar < 0x20U )
+                {
+                    prvPutRaw( pxWriter, "\\u00", 4U );
+                    prvPutChar( pxWriter, cHexDigits[ ucChar >> 4 ] );
+                    prvPutChar( pxWriter, cHexDigits[ ucChar & 0x0FU ] );
+                }
+                else
+                {
+                    prvPutChar( pxWriter, ( char ) ucChar );
+                }
+
+                break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutUInt( JSONWriter_t * pxWriter,
+                        uint32_t ulValue )
+{
+    char cDigits[ 10 ];
+    size_t xCount = 0;
+
+    do
+    {
+        cDigits[ xCount ] = ( char ) ( '0' + ( ulValue % 10UL ) );
+        ulValue /= 10UL;
+        xCount++;
+    } while( ulValue != 0UL );
+
+    while( xCount > 0U )
+    {
+        xCount--;
+        prvPutChar( pxWriter, cDigits[ xCount ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvBeginValue( JSONWriter_t * pxWriter )
+{
+    uint32_t ulBit;
+
+    if( pxWriter->xInString == pdTRUE )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else if( pxWriter->xAfterKey == pdTRUE )
+    {
+        /* The value of an object member. */
+        pxWriter->xAfterKey = pdFALSE;
+    }
+    else if( pxWriter->ucDepth == 0U )
+    {
+        /* Only one top-level value. */
+        if( pxWriter->xLength != 0U )
+        {
+            pxWriter->xInvalid = pdTRUE;
+        }
+    }
+    else
+    {
+        ulBit = 1UL << ( pxWriter->ucDepth - 1U );
+
+        if( ( pxWriter->ulIsArray & ulBit ) == 0UL )
+        {
+            /* A member of an object needs a key. */
+            pxWriter->xInvalid = pdTRUE;
+        }
+        else if( ( pxWriter->ulHasMember & ulBit ) != 0UL )
+        {
+            prvPutChar( pxWriter, ',' );
+        }
+        else
+        {
+            pxWriter->ulHasMember |= ulBit;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvOpen( JSONWriter_t * pxWriter,
+                     BaseType_t xIsArray,
+                     char cOpen )
+{
+    uint32_t ulBit;
+
+    prvBeginValue( pxWriter );
+
+    if( pxWriter->ucDepth >= jsonwriteMAX_DEPTH )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        ulBit = 1UL << pxWriter->ucDepth;
+
+        if( xIsArray == pdTRUE )
+        {
+            pxWriter->ulIsArray |= ulBit;
+        }
+        else
+        {
+            pxWriter->ulIsArray &= ~ulBit;
+        }
+
+        pxWriter->ulHasMember &= ~ulBit;
+        pxWriter->ucDepth++;
+        prvPutChar( pxWriter, cOpen );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvClose( JSONWriter_t * pxWriter,
+                      BaseType_t xIsArray,
+                      char cClose )
+{
+    uint32_t ulBit;
+
+    if( ( pxWriter->ucDepth == 0U ) ||
+        ( pxWriter->xAfterKey == pdTRUE ) ||
+        ( pxWriter->xInString == pdTRUE ) )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        ulBit = 1UL << ( pxWriter->ucDepth - 1U );
+
+        if( ( ( pxWriter->ulIsArray & ulBit ) != 0UL ) != ( xIsArray == pdTRUE ) )
+        {
+            pxWriter->xInvalid = pdTRUE;
+        }
+
+        pxWriter->ucDepth--;
+        prvPutChar( pxWriter, cClose );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_Init( JSONWriter_t * pxWriter,
+                     char * pcBuffer,
+                     size_t xBufferSize )
+{
+    configASSERT( pxWriter != NULL );
+    configASSERT( ( pcBuffer != NULL ) || ( xBufferSize == 0U ) );
+
+    pxWriter->pcBuffer = pcBuffer;
+    pxWriter->xBufferSize = xBufferSize;
+    pxWriter->xLength = 0U;
+    pxWriter->ulIsArray = 0UL;
+    pxWriter->ulHasMember = 0UL;
+    pxWriter->ucDepth = 0U;
+    pxWriter->xAfterKey = pdFALSE;
+    pxWriter->xInString = pdFALSE;
+    pxWriter->xInvalid = pdFALSE;
+
+    if( xBufferSize > 0U )
+    {
+        pcBuffer[ 0 ] = '\0';
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_ObjectStart( JSONWriter_t * pxWriter )
+{
+    prvOpen( pxWriter, pdFALSE, '{' );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_ObjectEnd( JSONWriter_t * pxWriter )
+{
+    prvClose( pxWriter, pdFALSE, '}' );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_ArrayStart( JSONWriter_t * pxWriter )
+{
+    prvOpen( pxWriter, pdTRUE, '[' );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_ArrayEnd( JSONWriter_t * pxWriter )
+{
+    prvClose( pxWriter, pdTRUE, ']' );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_Key( JSONWriter_t * pxWriter,
+                    const char * pcKey )
+{
+    uint32_t ulBit;
+
+    configASSERT( pcKey != NULL );
+
+    if( ( pxWriter->ucDepth == 0U ) ||
+        ( pxWriter->xAfterKey == pdTRUE ) ||
+        ( pxWriter->xInString == pdTRUE ) )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        ulBit = 1UL << ( pxWriter->ucDepth - 1U );
+
+        if( ( pxWriter->ulIsArray & ulBit ) != 0UL )
+        {
+            pxWriter->xInvalid = pdTRUE;
+        }
+        else if( ( pxWriter->ulHasMember & ulBit ) != 0UL )
+        {
+            prvPutChar( pxWriter, ',' );
+        }
+        else
+        {
+            pxWriter->ulHasMember |= ulBit;
+        }
+
+        prvPutChar( pxWriter, '"' );
+        prvPutEscaped( pxWriter, pcKey, strlen( pcKey ) );
+        prvPutRaw( pxWriter, "\":", 2U );
+        pxWriter->xAfterKey = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_String( JSONWriter_t * pxWriter,
+                       const char * pcValue,
+                       size_t xLength )
+{
+    JSONWRITE_StringStart( pxWriter );
+    JSONWRITE_StringAppend( pxWriter, pcValue, xLength );
+    JSONWRITE_StringEnd( pxWriter );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_UInt( JSONWriter_t * pxWriter,
+                     uint32_t ulValue )
+{
+    prvBeginValue( pxWriter );
+    prvPutUInt( pxWriter, ulValue );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_Int( JSONWriter_t * pxWriter,
+                    int32_t lValue )
+{
+    prvBeginValue( pxWriter );
+
+    if( lValue < 0L )
+    {
+        prvPutChar( pxWriter, '-' );
+
+        /* Written this way so that INT32_MIN does not overflow. */
+        prvPutUInt( pxWriter, ( uint32_t ) ( -( lValue + 1L ) ) + 1UL );
+    }
+    else
+    {
+        prvPutUInt( pxWriter, ( uint32_t ) lValue );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_Bool( JSONWriter_t * pxWriter,
+                     BaseType_t xValue )
+{
+    prvBeginValue( pxWriter );
+
+    if( xValue != pdFALSE )
+    {
+        prvPutRaw( pxWriter, "true", 4U );
+    }
+    else
+    {
+        prvPutRaw( pxWriter, "false", 5U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_Null( JSONWriter_t * pxWriter )
+{
+    prvBeginValue( pxWriter );
+    prvPutRaw( pxWriter, "null", 4U );
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_StringStart( JSONWriter_t * pxWriter )
+{
+    prvBeginValue( pxWriter );
+    prvPutChar( pxWriter, '"' );
+    pxWriter->xInString = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_StringAppend( JSONWriter_t * pxWriter,
+                             const char * pcText,
+                             size_t xLength )
+{
+    configASSERT( ( pcText != NULL ) || ( xLength == 0U ) );
+
+    if( pxWriter->xInString == pdFALSE )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        prvPutEscaped( pxWriter, pcText, xLength );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_StringAppendUInt( JSONWriter_t * pxWriter,
+                                 uint32_t ulValue )
+{
+    if( pxWriter->xInString == pdFALSE )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        prvPutUInt( pxWriter, ulValue );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_StringAppendHex( JSONWriter_t * pxWriter,
+                                uint32_t ulValue,
+                                uint8_t ucMinDigits )
+{
+    static const char cHexDigits[] = "0123456789abcdef";
+    uint8_t ucDigits = 8U;
+
+    if( pxWriter->xInString == pdFALSE )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        /* Skip the leading zeros that are not needed for the width. */
+        while( ( ucDigits > 1U ) &&
+               ( ucDigits > ucMinDigits ) &&
+               ( ( ulValue >> ( ( ucDigits - 1U ) * 4U ) ) == 0UL ) )
+        {
+            ucDigits--;
+        }
+
+        while( ucDigits > 0U )
+        {
+            ucDigits--;
+            prvPutChar( pxWriter, cHexDigits[ ( ulValue >> ( ucDigits * 4U ) ) & 0x0FUL ] );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void JSONWRITE_StringEnd( JSONWriter_t * pxWriter )
+{
+    if( pxWriter->xInString == pdFALSE )
+    {
+        pxWriter->xInvalid = pdTRUE;
+    }
+    else
+    {
+        prvPutChar( pxWriter, '"' );
+        pxWriter->xInString = pdFALSE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t JSONWRITE_Finish( const JSONWriter_t * pxWriter,
+                             size_t * pxLength )
+{
+    BaseType_t xResult = pdFAIL;
+
+    if( ( pxWriter->xInvalid == pdFALSE ) &&
+        ( pxWriter->ucDepth == 0U ) &&
+        ( pxWriter->xAfterKey == pdFALSE ) &&
+        ( pxWriter->xInString == pdFALSE ) &&
+        ( pxWriter->xLength > 0U ) &&
+        ( pxWriter->xLength < pxWriter->xBufferSize ) )
+    {
+        xResult = pdPASS;
+    }
+
+    if( pxLength != NULL )
+    {
+        *pxLength = ( xResult == pdPASS ) ? pxWriter->xLength : ( pxWriter->xLength + 1U );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
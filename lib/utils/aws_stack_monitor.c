@@ -0,0 +1,238 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "aws_stack_monitor.h"
+#include "aws_stack_monitor_config_defaults.h"
+
+#if ( INCLUDE_uxTaskGetStackHighWaterMark != 1 )
+    #error "The stack monitor requires INCLUDE_uxTaskGetStackHighWaterMark to be set to 1."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The registered tasks. Unused entries have a NULL task handle.
+ */
+static StackMonitorEntry_t xEntries[ stackmonconfigMAX_TASKS ];
+
+/**
+ * @brief Protects xEntries, and keeps a task from being unregistered while its
+ * stack is being measured.
+ */
+static StaticSemaphore_t xEntriesMutexBuffer;
+static SemaphoreHandle_t xEntriesMutex = NULL;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the stack of one registered task.
+ */
+static void prvSampleEntry( StackMonitorEntry_t * pxEntry )
+{
+    uint32_t ulFree = ( uint32_t ) uxTaskGetStackHighWaterMark( pxEntry->xTask );
+    uint32_t ulUsed;
+
+    if( ( pxEntry->ulRecommendedDepth == 0 ) || ( ulFree < pxEntry->ulMinimumFree ) )
+    {
+        pxEntry->ulMinimumFree = ulFree;
+
+        /* The high water mark is measured from the task's actual stack, so it
+         * is only bounded by the registered depth if that depth is right. */
+        if( ulFree < pxEntry->ulStackDepth )
+        {
+            ulUsed = pxEntry->ulStackDepth - ulFree;
+        }
+        else
+        {
+            ulUsed = 0;
+        }
+
+        pxEntry->ulRecommendedDepth = ulUsed + ( ( ulUsed * stackmonconfigMARGIN_PERCENT ) + 99U ) / 100U;
+
+        if( pxEntry->ulRecommendedDepth < configMINIMAL_STACK_SIZE )
+        {
+            pxEntry->ulRecommendedDepth = configMINIMAL_STACK_SIZE;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures one registered task per sample period, in turn.
+ */
+static void prvStackMonitorTask( void * pvParameters )
+{
+    UBaseType_t uxNext = 0;
+    UBaseType_t uxChecked;
+
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        vTaskDelay( pdMS_TO_TICKS( stackmonconfigSAMPLE_PERIOD_MS ) );
+
+        ( void ) xSemaphoreTake( xEntriesMutex, portMAX_DELAY );
+
+        /* Skip unused entries so that each sample measures a task. */
+        for( uxChecked = 0; uxChecked < stackmonconfigMAX_TASKS; uxChecked++ )
+        {
+            StackMonitorEntry_t * pxEntry = &xEntries[ uxNext ];
+
+            uxNext = ( uxNext + 1U ) % stackmonconfigMAX_TASKS;
+
+            if( pxEntry->xTask != NULL )
+            {
+                prvSampleEntry( pxEntry );
+                break;
+            }
+        }
+
+        ( void ) xSemaphoreGive( xEntriesMutex );
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t STACKMON_Init( void )
+{
+    BaseType_t xResult = pdFAIL;
+
+    configASSERT( xEntriesMutex == NULL );
+
+    xEntriesMutex = xSemaphoreCreateMutexStatic( &xEntriesMutexBuffer );
+
+    if( xTaskCreate( prvStackMonitorTask,
+                     "StackMon",
+                     stackmonconfigTASK_STACK_DEPTH,
+                     NULL,
+                     stackmonconfigTASK_PRIORITY,
+                     NULL ) == pdPASS )
+    {
+        xResult = pdPASS;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t STACKMON_Register( TaskHandle_t xTask,
+                              uint32_t ulStackDepth )
+{
+    BaseType_t xResult = pdFAIL;
+    UBaseType_t uxIndex;
+
+    configASSERT( xEntriesMutex != NULL );
+    configASSERT( xTask != NULL );
+
+    ( void ) xSemaphoreTake( xEntriesMutex, portMAX_DELAY );
+
+    for( uxIndex = 0; uxIndex < stackmonconfigMAX_TASKS; uxIndex++ )
+    {
+        if( xEntries[ uxIndex ].xTask == NULL )
+        {
+            xEntries[ uxIndex ].xTask = xTask;
+            xEntries[ uxIndex ].ulStackDepth = ulStackDepth;
+            xEntries[ uxIndex ].ulMinimumFree = ulStackDepth;
+            xEntries[ uxIndex ].ulRecommendedDepth = 0;
+            xResult = pdPASS;
+            break;
+        }
+    }
+
+    ( void ) xSemaphoreGive( xEntriesMutex );
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void STACKMON_Unregister( TaskHandle_t xTask )
+{
+    UBaseType_t uxIndex;
+
+    configASSERT( xEntriesMutex != NULL );
+
+    ( void ) xSemaphoreTake( xEntriesMutex, portMAX_DELAY );
+
+    for( uxIndex = 0; uxIndex < stackmonconfigMAX_TASKS; uxIndex++ )
+    {
+        if( xEntries[ uxIndex ].xTask == xTask )
+        {
+            xEntries[ uxIndex ].xTask = NULL;
+        }
+    }
+
+    ( void ) xSemaphoreGive( xEntriesMutex );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t STACKMON_GetReport( StackMonitorEntry_t * pxEntries,
+                                UBaseType_t uxMaxEntries )
+{
+    UBaseType_t uxCount = 0;
+    UBaseType_t uxIndex;
+
+    configASSERT( xEntriesMutex != NULL );
+
+    ( void ) xSemaphoreTake( xEntriesMutex, portMAX_DELAY );
+
+    for( uxIndex = 0; ( uxIndex < stackmonconfigMAX_TASKS ) && ( uxCount < uxMaxEntries ); uxIndex++ )
+    {
+        if( xEntries[ uxIndex ].xTask != NULL )
+        {
+            pxEntries[ uxCount ] = xEntries[ uxIndex ];
+            uxCount++;
+        }
+    }
+
+    ( void ) xSemaphoreGive( xEntriesMutex );
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+void STACKMON_PrintReport( void )
+{
+    UBaseType_t uxIndex;
+
+    configASSERT( xEntriesMutex != NULL );
+
+    ( void ) xSemaphoreTake( xEntriesMutex, portMAX_DELAY );
+
+    for( uxIndex = 0; uxIndex < stackmonconfigMAX_TASKS; uxIndex++ )
+    {
+        if( xEntries[ uxIndex ].xTask != NULL )
+        {
+            configPRINTF( ( "%s: depth %u, min free %u, recommended %u\r\n",
+                            pcTaskGetName( xEntries[ uxIndex ].xTask ),
+                            ( unsigned ) xEntries[ uxIndex ].ulStackDepth,
+                            ( unsigned ) xEntries[ uxIndex ].ulMinimumFree,
+                            ( unsigned ) xEntries[ uxIndex ].ulRecommendedDepth ) );
+        }
+    }
+
+    ( void ) xSemaphoreGive( xEntriesMutex );
+}
+/*-----------------------------------------------------------*/
@@ -23,6 +23,8 @@
  * http://www.FreeRTOS.org
  */
 #include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
 #include "aws_system_init.h"
 
 /* Library code. */
@@ -32,6 +34,68 @@ extern BaseType_t SOCKETS_Init( void );
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief The table passed to SYSTEM_InitModules().
+ */
+static const SystemInitModule_t * pxModuleTable = NULL;
+
+/**
+ * @brief Bits of the modules that are done, whether they succeeded or not.
+ */
+static EventGroupHandle_t xModulesDone = NULL;
+
+/**
+ * @brief Bits of the modules that failed.
+ */
+static volatile EventBits_t xModulesFailed = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Records that a module is done, and whether it succeeded.
+ */
+static void prvModuleDone( EventBits_t xModule,
+                           BaseType_t xResult )
+{
+    if( xResult != pdPASS )
+    {
+        taskENTER_CRITICAL();
+        xModulesFailed |= xModule;
+        taskEXIT_CRITICAL();
+    }
+
+    ( void ) xEventGroupSetBits( xModulesDone, xModule );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initializes one module once its prerequisites are done.
+ */
+static void prvInitModuleTask( void * pvParameters )
+{
+    const SystemInitModule_t * pxModule = ( const SystemInitModule_t * ) pvParameters;
+    BaseType_t xResult = pdFAIL;
+
+    if( pxModule->xPrerequisites != 0 )
+    {
+        ( void ) xEventGroupWaitBits( xModulesDone,
+                                      pxModule->xPrerequisites,
+                                      pdFALSE,
+                                      pdTRUE,
+                                      portMAX_DELAY );
+    }
+
+    if( ( xModulesFailed & pxModule->xPrerequisites ) == 0 )
+    {
+        xResult = pxModule->xInit();
+    }
+
+    prvModuleDone( systeminitMODULE_BIT( pxModule - pxModuleTable ), xResult );
+
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Initializes Amazon FreeRTOS libraries.
  */
@@ -53,3 +117,73 @@ BaseType_t SYSTEM_Init( void )
 
     return xResult;
 }
+/*-----------------------------------------------------------*/
+
+BaseType_t SYSTEM_InitModules( const SystemInitModule_t * pxModules,
+                               UBaseType_t uxModuleCount )
+{
+    BaseType_t xResult = pdPASS;
+    UBaseType_t uxIndex;
+
+    configASSERT( pxModuleTable == NULL );
+    configASSERT( uxModuleCount <= systeminitMAX_MODULES );
+
+    /* Requiring prerequisites to come first in the table rules out cycles,
+     * which would leave the modules in them waiting forever. */
+    for( uxIndex = 0; uxIndex < uxModuleCount; uxIndex++ )
+    {
+        configASSERT( ( pxModules[ uxIndex ].xPrerequisites & ~( systeminitMODULE_BIT( uxIndex ) - 1U ) ) == 0 );
+    }
+
+    xModulesDone = xEventGroupCreate();
+
+    if( xModulesDone == NULL )
+    {
+        xResult = pdFAIL;
+    }
+    else
+    {
+        pxModuleTable = pxModules;
+
+        for( uxIndex = 0; uxIndex < uxModuleCount; uxIndex++ )
+        {
+            if( xTaskCreate( prvInitModuleTask,
+                             pxModules[ uxIndex ].pcName,
+                             pxModules[ uxIndex ].usStackDepth,
+                             ( void * ) &( pxModules[ uxIndex ] ),
+                             pxModules[ uxIndex ].uxPriority,
+                             NULL ) != pdPASS )
+            {
+                /* Modules that depend on this one fail too, rather than
+                 * waiting forever. */
+                prvModuleDone( systeminitMODULE_BIT( uxIndex ), pdFAIL );
+                xResult = pdFAIL;
+            }
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t SYSTEM_WaitForModules( EventBits_t xModules,
+                                  TickType_t xTicksToWait )
+{
+    BaseType_t xResult = pdFAIL;
+    EventBits_t xDone;
+
+    configASSERT( xModulesDone != NULL );
+
+    xDone = xEventGroupWaitBits( xModulesDone,
+                                 xModules,
+                                 pdFALSE,
+                                 pdTRUE,
+                                 xTicksToWait );
+
+    if( ( ( xDone & xModules ) == xModules ) && ( ( xModulesFailed & xModules ) == 0 ) )
+    {
+        xResult = pdPASS;
+    }
+
+    return xResult;
+}
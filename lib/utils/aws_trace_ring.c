@@ -0,0 +1,400 @@
+/*
+ * Amazon FreeRTOS Trace Ring
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "aws_trace_ring.h"
+
+#if ( ( traceringconfigRECORDS_PER_CORE & ( traceringconfigRECORDS_PER_CORE - 1U ) ) != 0U )
+    #error "traceringconfigRECORDS_PER_CORE must be a power of two."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The most records taken by one name.
+ */
+#define traceringMAX_NAME_RECORDS    ( 8U )
+
+/**
+ * @brief Use the compiler's atomics where they are lock-free on the target.
+ *
+ * Otherwise the interrupt mask keeps interrupts on the same core from
+ * interleaving with a writer, which is all that is needed as every core has
+ * its own ring.
+ */
+#if defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+    #define traceringENTER( uxSavedMask )    ( void ) ( uxSavedMask )
+    #define traceringEXIT( uxSavedMask )     ( void ) ( uxSavedMask )
+    #define traceringCLAIM( pxRing, ulCount ) \
+    __atomic_fetch_add( &( ( pxRing )->ulHead ), ( ulCount ), __ATOMIC_RELAXED )
+    #define traceringLOAD_HEAD( pxRing ) \
+    __atomic_load_n( &( ( pxRing )->ulHead ), __ATOMIC_RELAXED )
+    #define traceringPUBLISH( pxRecord, usValue ) \
+    __atomic_store_n( &( ( pxRecord )->usSequence ), ( usValue ), __ATOMIC_RELEASE )
+    #define traceringLOAD_SEQUENCE( pxRecord ) \
+    __atomic_load_n( &( ( pxRecord )->usSequence ), __ATOMIC_ACQUIRE )
+#else
+    #define traceringENTER( uxSavedMask )    ( uxSavedMask ) = portSET_INTERRUPT_MASK_FROM_ISR()
+    #define traceringEXIT( uxSavedMask )     portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedMask )
+    #define traceringCLAIM( pxRing, ulCount ) \
+    ( ( ( pxRing )->ulHead += ( ulCount ) ) - ( ulCount ) )
+    #define traceringLOAD_HEAD( pxRing )     ( ( pxRing )->ulHead )
+    #define traceringPUBLISH( pxRecord, usValue ) \
+    ( ( pxRecord )->usSequence = ( usValue ) )
+    #define traceringLOAD_SEQUENCE( pxRecord )    ( ( pxRecord )->usSequence )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The ring of one core.
+ *
+ * ulHead counts the records ever claimed, ulTail the records ever read. A
+ * record is complete once its usSequence holds its position plus one, which
+ * lets the reader tell records being written from records already overwritten
+ * without taking a lock.
+ */
+typedef struct TraceRing
+{
+    TraceRingRecord_t xRecords[ traceringconfigRECORDS_PER_CORE ];
+    volatile uint32_t ulHead;
+    uint32_t ulTail;
+} TraceRing_t;
+
+/**
+ * @brief A chunk as sent by the streaming task.
+ */
+typedef struct TraceRingChunk
+{
+    TraceRingChunkHeader_t xHeader;
+    TraceRingRecord_t xRecords[ traceringconfigCHUNK_RECORDS ];
+} TraceRingChunk_t;
+
+/**
+ * @brief The rings. Being zeroed at start up is all the initialization they
+ * need, so records can be written before anything else runs.
+ */
+static TraceRing_t xRings[ configNUM_CORES ];
+
+/**
+ * @brief The send function and context of the streaming task.
+ */
+static TraceRingSendFunction_t xStreamSend = NULL;
+static void * pvStreamContext = NULL;
+
+#if ( traceringconfigMQTT_STREAMING == 1 )
+
+/**
+ * @brief Destination of TRACE_RING_StartMQTTStreaming().
+ */
+    static MQTTAgentHandle_t xStreamMQTTHandle = NULL;
+    static const char * pcStreamTopic = NULL;
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Fills in a claimed record and marks it complete.
+ */
+static void prvWriteRecord( TraceRing_t * pxRing,
+                            uint32_t ulPosition,
+                            uint32_t ulTimestamp,
+                            uint16_t usEventId,
+                            uint32_t ulArg1,
+                            uint32_t ulArg2 )
+{
+    TraceRingRecord_t * pxRecord = &( pxRing->xRecords[ ulPosition & ( traceringconfigRECORDS_PER_CORE - 1U ) ] );
+
+    pxRecord->ulTimestamp = ulTimestamp;
+    pxRecord->usEventId = usEventId;
+    pxRecord->ulArg1 = ulArg1;
+    pxRecord->ulArg2 = ulArg2;
+    traceringPUBLISH( pxRecord, ( uint16_t ) ( ulPosition + 1U ) );
+}
+/*-----------------------------------------------------------*/
+
+void TRACE_RING_Record( uint16_t usEventId,
+                        uint32_t ulArg1,
+                        uint32_t ulArg2 )
+{
+    TraceRing_t * pxRing = &( xRings[ traceringconfigGET_CORE_ID() ] );
+    UBaseType_t uxSavedMask = 0;
+    uint32_t ulPosition;
+
+    traceringENTER( uxSavedMask );
+    ulPosition = traceringCLAIM( pxRing, 1U );
+    prvWriteRecord( pxRing, ulPosition, traceringconfigTIMESTAMP(), usEventId, ulArg1, ulArg2 );
+    traceringEXIT( uxSavedMask );
+}
+/*-----------------------------------------------------------*/
+
+void TRACE_RING_RecordName( uint32_t ulObject,
+                            const char * pcName )
+{
+    TraceRing_t * pxRing = &( xRings[ traceringconfigGET_CORE_ID() ] );
+    UBaseType_t uxSavedMask = 0;
+    uint32_t ulPosition, ulTimestamp, ulCharacters;
+    size_t xLength = strlen( pcName );
+    uint32_t ulCount = ( uint32_t ) ( ( xLength + 3U ) / 4U );
+    uint32_t ulRecord, ulByte;
+
+    if( ulCount == 0U )
+    {
+        ulCount = 1U;
+    }
+    else if( ulCount > traceringMAX_NAME_RECORDS )
+    {
+        ulCount = traceringMAX_NAME_RECORDS;
+        xLength = traceringMAX_NAME_RECORDS * 4U;
+    }
+
+    /* The records of a name are claimed together, so they are consecutive in
+     * the ring even if an interrupt records something meanwhile. */
+    traceringENTER( uxSavedMask );
+    ulPosition = traceringCLAIM( pxRing, ulCount );
+    ulTimestamp = traceringconfigTIMESTAMP();
+
+    for( ulRecord = 0; ulRecord < ulCount; ulRecord++ )
+    {
+        ulCharacters = 0;
+
+        for( ulByte = 0; ( ulByte < 4U ) && ( ( ( ulRecord * 4U ) + ulByte ) < xLength ); ulByte++ )
+        {
+            ulCharacters |= ( uint32_t ) ( uint8_t ) pcName[ ( ulRecord * 4U ) + ulByte ] << ( ulByte * 8U );
+        }
+
+        prvWriteRecord( pxRing, ulPosition + ulRecord, ulTimestamp, traceringEVENT_TASK_NAME, ulObject, ulCharacters );
+    }
+
+    traceringEXIT( uxSavedMask );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t TRACE_RING_Read( UBaseType_t uxCore,
+                             TraceRingRecord_t * pxRecords,
+                             UBaseType_t uxMaxRecords,
+                             uint32_t * pulLost )
+{
+    TraceRing_t * pxRing;
+    TraceRingRecord_t * pxRecord;
+    UBaseType_t uxSavedMask = 0;
+    UBaseType_t uxCount = 0;
+    uint32_t ulHead, ulLost = 0;
+    uint16_t usExpected, usSequence;
+
+    configASSERT( uxCore < ( UBaseType_t ) configNUM_CORES );
+    pxRing = &( xRings[ uxCore ] );
+
+    ulHead = traceringLOAD_HEAD( pxRing );
+
+    while( ( uxCount < uxMaxRecords ) && ( pxRing->ulTail != ulHead ) )
+    {
+        /* Skip what the writers have lapped. */
+        if( ( ulHead - pxRing->ulTail ) > traceringconfigRECORDS_PER_CORE )
+        {
+            ulLost += ( ulHead - pxRing->ulTail ) - traceringconfigRECORDS_PER_CORE;
+            pxRing->ulTail = ulHead - traceringconfigRECORDS_PER_CORE;
+        }
+
+        pxRecord = &( pxRing->xRecords[ pxRing->ulTail & ( traceringconfigRECORDS_PER_CORE - 1U ) ] );
+        usExpected = ( uint16_t ) ( pxRing->ulTail + 1U );
+
+        traceringENTER( uxSavedMask );
+        usSequence = traceringLOAD_SEQUENCE( pxRecord );
+
+        if( usSequence == usExpected )
+        {
+            pxRecords[ uxCount ] = *pxRecord;
+        }
+
+        traceringEXIT( uxSavedMask );
+
+        if( usSequence != usExpected )
+        {
+            if( ( uint16_t ) ( usSequence - usExpected ) >= 0x8000U )
+            {
+                /* Claimed but still being written, it is read next time. */
+                break;
+            }
+
+            /* Overwritten by a later lap since the head was read. */
+            ulLost++;
+        }
+        else if( traceringLOAD_SEQUENCE( pxRecord ) != usExpected )
+        {
+            /* Overwritten while it was copied. */
+            ulLost++;
+        }
+        else
+        {
+            uxCount++;
+        }
+
+        pxRing->ulTail++;
+    }
+
+    *pulLost = ulLost;
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sends the unread records of all the rings, then waits a stream
+ * period for more.
+ */
+static void prvStreamTask( void * pvParameters )
+{
+    static TraceRingChunk_t xChunk;
+    uint32_t ulLost[ configNUM_CORES ] = { 0 };
+    uint32_t ulReadLost;
+    UBaseType_t uxCore, uxRecords;
+    BaseType_t xMore;
+
+    ( void ) pvParameters;
+
+    xChunk.xHeader.ulMagic = traceringCHUNK_MAGIC;
+    xChunk.xHeader.usVersion = traceringCHUNK_VERSION;
+    xChunk.xHeader.ucRecordSize = ( uint8_t ) sizeof( TraceRingRecord_t );
+    xChunk.xHeader.ulTimestampHz = traceringconfigTIMESTAMP_HZ;
+
+    for( ; ; )
+    {
+        xMore = pdFALSE;
+
+        for( uxCore = 0; uxCore < ( UBaseType_t ) configNUM_CORES; uxCore++ )
+        {
+            uxRecords = TRACE_RING_Read( uxCore, xChunk.xRecords, traceringconfigCHUNK_RECORDS, &ulReadLost );
+            ulLost[ uxCore ] += ulReadLost;
+
+            if( uxRecords == traceringconfigCHUNK_RECORDS )
+            {
+                xMore = pdTRUE;
+            }
+
+            if( ( uxRecords > 0U ) || ( ulLost[ uxCore ] > 0U ) )
+            {
+                xChunk.xHeader.ucCore = ( uint8_t ) uxCore;
+                xChunk.xHeader.usRecords = ( uint16_t ) uxRecords;
+                xChunk.xHeader.usLost = ( uint16_t ) ( ( ulLost[ uxCore ] > 0xFFFFU ) ? 0xFFFFU : ulLost[ uxCore ] );
+
+                if( xStreamSend( pvStreamContext,
+                                 &xChunk,
+                                 sizeof( TraceRingChunkHeader_t ) + ( uxRecords * sizeof( TraceRingRecord_t ) ) ) == pdPASS )
+                {
+                    ulLost[ uxCore ] = 0;
+                }
+                else
+                {
+                    ulLost[ uxCore ] += ( uint32_t ) uxRecords;
+                }
+            }
+        }
+
+        if( xMore == pdFALSE )
+        {
+            vTaskDelay( pdMS_TO_TICKS( traceringconfigSTREAM_PERIOD_MS ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t TRACE_RING_StartStreaming( TraceRingSendFunction_t xSend,
+                                      void * pvContext )
+{
+    BaseType_t xResult = pdFAIL;
+
+    configASSERT( xSend != NULL );
+    configASSERT( xStreamSend == NULL );
+
+    xStreamSend = xSend;
+    pvStreamContext = pvContext;
+
+    if( xTaskCreate( prvStreamTask,
+                     "TraceRing",
+                     traceringconfigSTREAM_TASK_STACK_DEPTH,
+                     NULL,
+                     traceringconfigSTREAM_TASK_PRIORITY,
+                     NULL ) == pdPASS )
+    {
+        xResult = pdPASS;
+    }
+    else
+    {
+        xStreamSend = NULL;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+#if ( traceringconfigMQTT_STREAMING == 1 )
+
+/**
+ * @brief Publishes one chunk to the streaming topic.
+ */
+    static BaseType_t prvSendToMQTT( void * pvContext,
+                                     const void * pvData,
+                                     size_t xLength )
+    {
+        MQTTAgentPublishParams_t xPublishParams;
+        BaseType_t xResult = pdFAIL;
+
+        ( void ) pvContext;
+
+        memset( &xPublishParams, 0x00, sizeof( xPublishParams ) );
+        xPublishParams.pucTopic = ( const uint8_t * ) pcStreamTopic;
+        xPublishParams.usTopicLength = ( uint16_t ) strlen( pcStreamTopic );
+        xPublishParams.xQoS = eMQTTQoS0;
+        xPublishParams.pvData = pvData;
+        xPublishParams.ulDataLength = ( uint32_t ) xLength;
+
+        if( MQTT_AGENT_Publish( xStreamMQTTHandle,
+                                &xPublishParams,
+                                pdMS_TO_TICKS( traceringconfigMQTT_PUBLISH_TIMEOUT_MS ) ) == eMQTTAgentSuccess )
+        {
+            xResult = pdPASS;
+        }
+
+        return xResult;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t TRACE_RING_StartMQTTStreaming( MQTTAgentHandle_t xMQTTHandle,
+                                              const char * pcTopic )
+    {
+        configASSERT( xMQTTHandle != NULL );
+        configASSERT( pcTopic != NULL );
+
+        xStreamMQTTHandle = xMQTTHandle;
+        pcStreamTopic = pcTopic;
+
+        return TRACE_RING_StartStreaming( prvSendToMQTT, NULL );
+    }
+#endif /* if ( traceringconfigMQTT_STREAMING == 1 ) */
+/*-----------------------------------------------------------*/
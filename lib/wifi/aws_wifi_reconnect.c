@@ -0,0 +1,334 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_wifi_reconnect.c
+ * @brief Fast reconnection to the last Access Point, built on the WIFI_ API.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Wi-Fi includes. */
+#include "aws_wifi.h"
+#include "aws_wifi_reconnect.h"
+#include "aws_wifi_reconnect_config_defaults.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The Access Point of the last successful connection.
+ */
+static WIFIReconnectCache_t xCache;
+
+/**
+ * @brief The connection metrics.
+ */
+static WIFIReconnectStatistics_t xStatistics;
+
+#if ( wificonfigRECONNECT_MAX_SCAN_RESULTS > 0 )
+
+/**
+ * @brief The results of the last scan. Static to keep them off the stack of
+ * the calling task.
+ */
+    static WIFIScanResult_t xScanResults[ wificonfigRECONNECT_MAX_SCAN_RESULTS ];
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Returns the length of the SSID to join.
+ *
+ * Some applications pass sizeof() of a string literal as the SSID length, so
+ * a NULL termination counted in the length is dropped.
+ */
+static size_t prvSSIDLength( const WIFINetworkParams_t * const pxNetworkParams )
+{
+    size_t xLength = pxNetworkParams->ucSSIDLength;
+
+    while( ( xLength > 0 ) && ( pxNetworkParams->pcSSID[ xLength - 1 ] == '\0' ) )
+    {
+        xLength--;
+    }
+
+    return xLength;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Checks whether an SSID is the one of the network to join.
+ */
+static BaseType_t prvSSIDMatches( const char * pcSSID,
+                                  const WIFINetworkParams_t * const pxNetworkParams )
+{
+    BaseType_t xResult = pdFALSE;
+    size_t xLength = prvSSIDLength( pxNetworkParams );
+
+    if( ( strlen( pcSSID ) == xLength ) &&
+        ( memcmp( pcSSID, pxNetworkParams->pcSSID, xLength ) == 0 ) )
+    {
+        xResult = pdTRUE;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Remembers the Access Point that was joined.
+ *
+ * @param[in] pxNetworkParams The network that was joined.
+ * @param[in] pxAccessPoint The scan result of the Access Point, or NULL if
+ * only the channel is known.
+ * @param[in] cChannel The channel used to join the network.
+ */
+static void prvStoreCache( const WIFINetworkParams_t * const pxNetworkParams,
+                           const WIFIScanResult_t * pxAccessPoint,
+                           int8_t cChannel )
+{
+    WIFIReconnectCache_t xNewCache;
+    size_t xLength = prvSSIDLength( pxNetworkParams );
+
+    /* WIFI_ConnectAP() succeeded, so the SSID length is already valid. */
+    configASSERT( xLength <= wificonfigMAX_SSID_LEN );
+
+    memset( &xNewCache, 0, sizeof( xNewCache ) );
+    memcpy( xNewCache.cSSID, pxNetworkParams->pcSSID, xLength );
+    xNewCache.cChannel = cChannel;
+    xNewCache.ucValid = 1;
+
+    if( pxAccessPoint != NULL )
+    {
+        memcpy( xNewCache.ucBSSID, pxAccessPoint->ucBSSID, sizeof( xNewCache.ucBSSID ) );
+        xNewCache.cRSSI = pxAccessPoint->cRSSI;
+    }
+
+    taskENTER_CRITICAL();
+    {
+        xCache = xNewCache;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#if ( wificonfigRECONNECT_MAX_SCAN_RESULTS > 0 )
+
+/**
+ * @brief Scans for the network and returns its strongest Access Point.
+ *
+ * @return The scan result of the Access Point, or NULL if the network was not
+ * found.
+ */
+    static const WIFIScanResult_t * prvFindStrongestAccessPoint( const WIFINetworkParams_t * const pxNetworkParams )
+    {
+        const WIFIScanResult_t * pxBest = NULL;
+        UBaseType_t uxIndex;
+
+        memset( xScanResults, 0, sizeof( xScanResults ) );
+
+        if( WIFI_Scan( xScanResults, wificonfigRECONNECT_MAX_SCAN_RESULTS ) == eWiFiSuccess )
+        {
+            for( uxIndex = 0; uxIndex < wificonfigRECONNECT_MAX_SCAN_RESULTS; uxIndex++ )
+            {
+                /* Make sure that a result filled up to the last byte is
+                 * terminated. */
+                xScanResults[ uxIndex ].cSSID[ wificonfigMAX_SSID_LEN ] = '\0';
+
+                if( ( xScanResults[ uxIndex ].cChannel != 0 ) &&
+                    ( prvSSIDMatches( xScanResults[ uxIndex ].cSSID, pxNetworkParams ) == pdTRUE ) &&
+                    ( ( pxBest == NULL ) || ( xScanResults[ uxIndex ].cRSSI > pxBest->cRSSI ) ) )
+                {
+                    pxBest = &xScanResults[ uxIndex ];
+                }
+            }
+        }
+
+        return pxBest;
+    }
+
+#endif /* wificonfigRECONNECT_MAX_SCAN_RESULTS */
+/*-----------------------------------------------------------*/
+
+WIFIReturnCode_t WIFI_ReconnectAP( const WIFINetworkParams_t * const pxNetworkParams )
+{
+    WIFIReturnCode_t xResult = eWiFiFailure;
+    WIFINetworkParams_t xParams;
+    WIFIReconnectCache_t xCached;
+    const WIFIScanResult_t * pxAccessPoint = NULL;
+    TickType_t xStartTime = xTaskGetTickCount();
+    TickType_t xElapsed;
+    uint32_t ulHits = 0;
+    uint32_t ulMisses = 0;
+    uint32_t ulScans = 0;
+
+    if( ( pxNetworkParams != NULL ) && ( pxNetworkParams->pcSSID != NULL ) )
+    {
+        xParams = *pxNetworkParams;
+
+        taskENTER_CRITICAL();
+        {
+            xCached = xCache;
+        }
+        taskEXIT_CRITICAL();
+
+        /* Try the cached channel first, unless the caller chose one. */
+        if( ( pxNetworkParams->cChannel == 0 ) &&
+            ( xCached.ucValid != 0 ) &&
+            ( xCached.cChannel != 0 ) &&
+            ( prvSSIDMatches( xCached.cSSID, pxNetworkParams ) == pdTRUE ) )
+        {
+            xParams.cChannel = xCached.cChannel;
+            xResult = WIFI_ConnectAP( &xParams );
+
+            if( xResult == eWiFiSuccess )
+            {
+                ulHits++;
+            }
+            else
+            {
+                ulMisses++;
+                WIFI_ReconnectClearCache();
+            }
+        }
+
+        #if ( wificonfigRECONNECT_MAX_SCAN_RESULTS > 0 )
+            {
+                /* The Access Point may have moved to another channel, or the
+                 * device may have moved closer to another Access Point of the
+                 * same network. */
+                if( ( xResult != eWiFiSuccess ) && ( pxNetworkParams->cChannel == 0 ) )
+                {
+                    ulScans++;
+                    pxAccessPoint = prvFindStrongestAccessPoint( pxNetworkParams );
+
+                    if( pxAccessPoint != NULL )
+                    {
+                        xParams.cChannel = pxAccessPoint->cChannel;
+                        xResult = WIFI_ConnectAP( &xParams );
+
+                        if( xResult == eWiFiSuccess )
+                        {
+                            prvStoreCache( pxNetworkParams, pxAccessPoint, pxAccessPoint->cChannel );
+                        }
+                    }
+                }
+            }
+        #endif /* wificonfigRECONNECT_MAX_SCAN_RESULTS */
+
+        /* Leave the choice of channel to the port if the network was not
+         * found by the scan. */
+        if( ( xResult != eWiFiSuccess ) && ( pxAccessPoint == NULL ) )
+        {
+            xResult = WIFI_ConnectAP( pxNetworkParams );
+
+            if( ( xResult == eWiFiSuccess ) && ( pxNetworkParams->cChannel != 0 ) )
+            {
+                prvStoreCache( pxNetworkParams, NULL, pxNetworkParams->cChannel );
+            }
+        }
+    }
+
+    xElapsed = xTaskGetTickCount() - xStartTime;
+
+    taskENTER_CRITICAL();
+    {
+        xStatistics.ulCacheHits += ulHits;
+        xStatistics.ulCacheMisses += ulMisses;
+        xStatistics.ulScans += ulScans;
+
+        if( xResult == eWiFiSuccess )
+        {
+            xStatistics.ulConnects++;
+            xStatistics.xLastConnectTicks = xElapsed;
+
+            if( xElapsed > xStatistics.xLongestConnectTicks )
+            {
+                xStatistics.xLongestConnectTicks = xElapsed;
+            }
+        }
+        else
+        {
+            xStatistics.ulFailures++;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void WIFI_ReconnectGetCache( WIFIReconnectCache_t * const pxCache )
+{
+    configASSERT( pxCache != NULL );
+
+    taskENTER_CRITICAL();
+    {
+        *pxCache = xCache;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void WIFI_ReconnectSetCache( const WIFIReconnectCache_t * const pxCache )
+{
+    configASSERT( pxCache != NULL );
+
+    taskENTER_CRITICAL();
+    {
+        xCache = *pxCache;
+
+        /* The cache may come from storage, so do not trust its termination. */
+        xCache.cSSID[ wificonfigMAX_SSID_LEN ] = '\0';
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void WIFI_ReconnectClearCache( void )
+{
+    taskENTER_CRITICAL();
+    {
+        memset( &xCache, 0, sizeof( xCache ) );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void WIFI_ReconnectGetStatistics( WIFIReconnectStatistics_t * const pxStatistics )
+{
+    configASSERT( pxStatistics != NULL );
+
+    taskENTER_CRITICAL();
+    {
+        *pxStatistics = xStatistics;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,106 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_wifi_wake.c
+ * @brief Alignment of deferrable network activity with the radio's wake
+ * windows.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Wi-Fi includes. */
+#include "aws_wifi_wake.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The time between two wake windows, 0 when delays are not aligned.
+ */
+static TickType_t xWakePeriod = 0;
+
+/**
+ * @brief The tick count at the start of a wake window. It is moved forward
+ * as time passes so that the tick count wrapping does not shift the phase.
+ */
+static TickType_t xWakeAnchor = 0;
+
+/*-----------------------------------------------------------*/
+
+void WIFI_WakeWindowSet( TickType_t xPeriod )
+{
+    taskENTER_CRITICAL();
+    {
+        xWakePeriod = xPeriod;
+        xWakeAnchor = xTaskGetTickCount();
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void WIFI_WakeWindowSync( void )
+{
+    taskENTER_CRITICAL();
+    {
+        xWakeAnchor = xTaskGetTickCount();
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+TickType_t WIFI_WakeWindowAlign( TickType_t xDelay )
+{
+    TickType_t xElapsed;
+    TickType_t xOffset;
+
+    taskENTER_CRITICAL();
+    {
+        if( ( xWakePeriod != 0 ) &&
+            ( xDelay != 0 ) &&
+            ( xDelay <= ( portMAX_DELAY - xWakePeriod ) ) )
+        {
+            xElapsed = xTaskGetTickCount() - xWakeAnchor;
+
+            /* Keep the anchor within one period of the current time. */
+            xWakeAnchor += ( xElapsed / xWakePeriod ) * xWakePeriod;
+            xElapsed %= xWakePeriod;
+
+            /* Position, within its window, of the moment the activity is
+             * due. */
+            xOffset = ( xElapsed + ( xDelay % xWakePeriod ) ) % xWakePeriod;
+
+            if( xOffset != 0 )
+            {
+                xDelay += xWakePeriod - xOffset;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xDelay;
+}
+/*-----------------------------------------------------------*/
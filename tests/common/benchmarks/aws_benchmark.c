@@ -0,0 +1,169 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_benchmark.c
+ * @brief Harness shared by the on-target benchmarks.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Benchmark includes. */
+#include "aws_benchmark.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The samples of the running benchmark. Benchmarks run one at a time
+ * from the test runner task.
+ */
+static uint32_t ulSampleBuffer[ benchmarkconfigMAX_SAMPLES ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sorts the samples in increasing order.
+ *
+ * An insertion sort is enough for benchmarkconfigMAX_SAMPLES values, and it
+ * does not need any stack or heap.
+ */
+static void prvSortSamples( uint32_t * pulSamples,
+                            uint32_t ulCount )
+{
+    uint32_t ulIndex;
+    uint32_t ulPosition;
+    uint32_t ulValue;
+
+    for( ulIndex = 1; ulIndex < ulCount; ulIndex++ )
+    {
+        ulValue = pulSamples[ ulIndex ];
+
+        for( ulPosition = ulIndex; ( ulPosition > 0 ) && ( pulSamples[ ulPosition - 1 ] > ulValue ); ulPosition-- )
+        {
+            pulSamples[ ulPosition ] = pulSamples[ ulPosition - 1 ];
+        }
+
+        pulSamples[ ulPosition ] = ulValue;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Returns a percentile of sorted samples.
+ */
+static uint32_t prvPercentile( const uint32_t * pulSamples,
+                               uint32_t ulCount,
+                               uint32_t ulPercent )
+{
+    return pulSamples[ ( ( ulCount - 1 ) * ulPercent ) / 100U ];
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t BENCHMARK_Run( const char * pcName,
+                          BenchmarkOperation_t xOperation,
+                          void * pvContext,
+                          uint32_t ulWarmUpCalls,
+                          uint32_t ulSamples,
+                          BenchmarkResult_t * const pxResult )
+{
+    BaseType_t xResult = pdPASS;
+    BenchmarkResult_t xRun = { 0 };
+    uint64_t ullTotal = 0;
+    uint32_t ulStart;
+    uint32_t ulIndex;
+
+    configASSERT( ( ulSamples > 0 ) && ( ulSamples <= benchmarkconfigMAX_SAMPLES ) );
+
+    for( ulIndex = 0; ( ulIndex < ulWarmUpCalls ) && ( xResult == pdPASS ); ulIndex++ )
+    {
+        xResult = xOperation( pvContext );
+    }
+
+    for( ulIndex = 0; ( ulIndex < ulSamples ) && ( xResult == pdPASS ); ulIndex++ )
+    {
+        ulStart = benchmarkconfigGET_COUNTER();
+        xResult = xOperation( pvContext );
+        ulSampleBuffer[ ulIndex ] = benchmarkconfigGET_COUNTER() - ulStart;
+        ullTotal += ulSampleBuffer[ ulIndex ];
+    }
+
+    if( xResult == pdPASS )
+    {
+        prvSortSamples( ulSampleBuffer, ulSamples );
+
+        xRun.ulSamples = ulSamples;
+        xRun.ulMin = ulSampleBuffer[ 0 ];
+        xRun.ulMedian = prvPercentile( ulSampleBuffer, ulSamples, 50 );
+        xRun.ulP90 = prvPercentile( ulSampleBuffer, ulSamples, 90 );
+        xRun.ulP99 = prvPercentile( ulSampleBuffer, ulSamples, 99 );
+        xRun.ulMax = ulSampleBuffer[ ulSamples - 1 ];
+        xRun.ulMean = ( uint32_t ) ( ullTotal / ulSamples );
+
+        benchmarkconfigPRINTF( ( "BENCH,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+                                 pcName,
+                                 ( unsigned long ) xRun.ulSamples,
+                                 ( unsigned long ) benchmarkconfigCOUNTER_HZ,
+                                 ( unsigned long ) xRun.ulMin,
+                                 ( unsigned long ) xRun.ulMedian,
+                                 ( unsigned long ) xRun.ulP90,
+                                 ( unsigned long ) xRun.ulP99,
+                                 ( unsigned long ) xRun.ulMax,
+                                 ( unsigned long ) xRun.ulMean ) );
+
+        if( pxResult != NULL )
+        {
+            *pxResult = xRun;
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void BENCHMARK_ReportRate( const char * pcName,
+                           const char * pcUnit,
+                           uint32_t ulUnitsPerCall,
+                           const BenchmarkResult_t * const pxResult )
+{
+    uint64_t ullRate;
+
+    if( pxResult->ulMedian != 0 )
+    {
+        ullRate = ( ( uint64_t ) ulUnitsPerCall * benchmarkconfigCOUNTER_HZ ) / pxResult->ulMedian;
+
+        benchmarkconfigPRINTF( ( "RATE,%s,%s,%lu\r\n",
+                                 pcName,
+                                 pcUnit,
+                                 ( unsigned long ) ullRate ) );
+    }
+    else
+    {
+        /* The operation is faster than one count. */
+        benchmarkconfigPRINTF( ( "# %s: the counter is too coarse for a rate\r\n", pcName ) );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,133 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_benchmark_freertos_tcp.c
+ * @brief Benchmarks of the FreeRTOS+TCP hot paths that do not need a network.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "list.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+
+/* Benchmark includes. */
+#include "aws_benchmark.h"
+
+/* The number of untimed calls made before measuring. */
+#define benchtcpWARM_UP_CALLS    ( 10 )
+
+/* The number of timed calls. */
+#define benchtcpSAMPLES    ( 200 )
+
+/* The payload of a full size TCP segment on Ethernet. */
+#define benchtcpCHECKSUM_LENGTH    ( 1460 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The data to sum. 32-bit aligned, as network buffers are, and
+ * offset by one byte for the unaligned case.
+ */
+static uint32_t ulChecksumData[ ( benchtcpCHECKSUM_LENGTH / sizeof( uint32_t ) ) + 2 ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sums a full segment.
+ */
+static BaseType_t prvChecksum( void * pvContext )
+{
+    const uint8_t * pucData = ( const uint8_t * ) pvContext;
+    volatile uint16_t usChecksum;
+
+    usChecksum = usGenerateChecksum( 0UL, pucData, benchtcpCHECKSUM_LENGTH );
+    ( void ) usChecksum;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_Benchmark_FreeRTOS_TCP );
+
+TEST_SETUP( Full_Benchmark_FreeRTOS_TCP )
+{
+    uint8_t * pucData = ( uint8_t * ) ulChecksumData;
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < sizeof( ulChecksumData ); xIndex++ )
+    {
+        pucData[ xIndex ] = ( uint8_t ) ( ( xIndex * 7U ) + 3U );
+    }
+}
+
+TEST_TEAR_DOWN( Full_Benchmark_FreeRTOS_TCP )
+{
+}
+
+TEST_GROUP_RUNNER( Full_Benchmark_FreeRTOS_TCP )
+{
+    RUN_TEST_CASE( Full_Benchmark_FreeRTOS_TCP, ChecksumAligned );
+    RUN_TEST_CASE( Full_Benchmark_FreeRTOS_TCP, ChecksumUnaligned );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_FreeRTOS_TCP, ChecksumAligned )
+{
+    BenchmarkResult_t xResult;
+
+    TEST_ASSERT_EQUAL( pdPASS, BENCHMARK_Run( "tcp_checksum_1460_aligned",
+                                              prvChecksum,
+                                              ulChecksumData,
+                                              benchtcpWARM_UP_CALLS,
+                                              benchtcpSAMPLES,
+                                              &xResult ) );
+
+    BENCHMARK_ReportRate( "tcp_checksum_1460_aligned", "bytes", benchtcpCHECKSUM_LENGTH, &xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_FreeRTOS_TCP, ChecksumUnaligned )
+{
+    BenchmarkResult_t xResult;
+
+    TEST_ASSERT_EQUAL( pdPASS, BENCHMARK_Run( "tcp_checksum_1460_unaligned",
+                                              prvChecksum,
+                                              ( ( uint8_t * ) ulChecksumData ) + 1,
+                                              benchtcpWARM_UP_CALLS,
+                                              benchtcpSAMPLES,
+                                              &xResult ) );
+
+    BENCHMARK_ReportRate( "tcp_checksum_1460_unaligned", "bytes", benchtcpCHECKSUM_LENGTH, &xResult );
+}
+/*-----------------------------------------------------------*/
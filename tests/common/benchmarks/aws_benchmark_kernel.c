@@ -0,0 +1,740 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/**
+ * @file aws_benchmark_kernel.c
+ * @brief Benchmarks of the kernel primitives used by every library.
+ *
+ * The benchmark task runs at benchkernelPRIORITY and its helper tasks one
+ * level above, so that the application tasks and the test runner do not
+ * preempt a sample and the same operations run in the same order every time.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+
+/* Benchmark includes. */
+#include "aws_benchmark.h"
+
+/* The number of untimed calls made before measuring. */
+#define benchkernelWARM_UP_CALLS    ( 10 )
+
+/* The number of timed calls. */
+#define benchkernelSAMPLES    ( 200 )
+
+/* The priority of the benchmark task. It stays below the timer task, which
+ * usually has the highest priority. */
+#define benchkernelPRIORITY    ( configMAX_PRIORITIES - 3 )
+
+/* The priority of the tasks the benchmark task hands over to. */
+#define benchkernelHELPER_PRIORITY    ( benchkernelPRIORITY + 1 )
+
+/* The largest queue item and block of the buffer benchmarks. */
+#define benchkernelMAX_ITEM_SIZE    ( 256 )
+
+/* The message size of the stream and message buffer benchmarks. */
+#define benchkernelBUFFER_MESSAGE_SIZE    ( 64 )
+
+/* The most tasks waiting on the event group. */
+#define benchkernelMAX_EVENT_WAITERS    ( 4 )
+
+/* The number of blocks allocated to fragment the heap. */
+#define benchkernelFRAGMENT_BLOCKS    ( 32 )
+
+/* The size of the fragmenting blocks, and of the holes left between them. */
+#define benchkernelFRAGMENT_BLOCK_SIZE    ( 64 )
+
+/* The size of the names built for the sized benchmarks. */
+#define benchkernelNAME_LENGTH    ( 64 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The helper task of the running benchmark, which the benchmark task
+ * exchanges notifications or a semaphore with.
+ */
+static TaskHandle_t xHelperTask = NULL;
+
+/**
+ * @brief The task running the benchmarks.
+ */
+static TaskHandle_t xBenchmarkTask = NULL;
+
+/**
+ * @brief The priority of the test runner, restored after each benchmark.
+ */
+static UBaseType_t uxRunnerPriority;
+
+/**
+ * @brief The tasks waiting on the event group.
+ */
+static TaskHandle_t xEventWaiters[ benchkernelMAX_EVENT_WAITERS ];
+
+/**
+ * @brief The primitive shared with the helper task of a benchmark.
+ */
+static SemaphoreHandle_t xSharedSemaphore = NULL;
+
+/**
+ * @brief The event group of the event group benchmark.
+ */
+static EventGroupHandle_t xEventGroup = NULL;
+
+/**
+ * @brief The items and messages sent and received.
+ */
+static uint8_t ucItem[ benchkernelMAX_ITEM_SIZE ];
+
+/**
+ * @brief The name of the running sized benchmark.
+ */
+static char cName[ benchkernelNAME_LENGTH ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Returns each notification to the benchmark task.
+ */
+static void prvEchoTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        xTaskNotifyGive( xBenchmarkTask );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Takes the shared semaphore whenever it is given, and tells the
+ * benchmark task.
+ */
+static void prvSemaphoreWaiterTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        if( xSemaphoreTake( xSharedSemaphore, portMAX_DELAY ) == pdPASS )
+        {
+            xTaskNotifyGive( xBenchmarkTask );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Takes and gives the shared mutex whenever it is notified, while the
+ * benchmark task holds it.
+ */
+static void prvMutexContenderTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+        if( xSemaphoreTake( xSharedSemaphore, portMAX_DELAY ) == pdPASS )
+        {
+            ( void ) xSemaphoreGive( xSharedSemaphore );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Waits for its own bit of the event group, which is cleared as it
+ * wakes up.
+ */
+static void prvEventWaiterTask( void * pvParameters )
+{
+    const EventBits_t xBit = ( EventBits_t ) 1 << ( ( uint32_t ) ( uintptr_t ) pvParameters );
+
+    for( ; ; )
+    {
+        ( void ) xEventGroupWaitBits( xEventGroup, xBit, pdTRUE, pdFALSE, portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief One round trip with the echo task, which is two context switches.
+ */
+static BaseType_t prvContextSwitch( void * pvContext )
+{
+    ( void ) pvContext;
+
+    xTaskNotifyGive( xHelperTask );
+
+    return ( ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( 1000 ) ) != 0 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Notifies the running task and takes the notification, without a
+ * context switch.
+ */
+static BaseType_t prvNotifyGiveTake( void * pvContext )
+{
+    ( void ) pvContext;
+
+    xTaskNotifyGive( xBenchmarkTask );
+
+    return ( ulTaskNotifyTake( pdTRUE, 0 ) != 0 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sends an item to a queue and receives it back, without blocking.
+ */
+static BaseType_t prvQueueSendReceive( void * pvContext )
+{
+    QueueHandle_t xQueue = ( QueueHandle_t ) pvContext;
+    BaseType_t xResult = pdFAIL;
+
+    if( xQueueSend( xQueue, ucItem, 0 ) == pdPASS )
+    {
+        xResult = xQueueReceive( xQueue, ucItem, 0 );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Takes a semaphore nobody else uses and gives it back.
+ */
+static BaseType_t prvSemaphoreTakeGive( void * pvContext )
+{
+    BaseType_t xResult;
+
+    ( void ) pvContext;
+
+    xResult = xSemaphoreTake( xSharedSemaphore, 0 );
+
+    if( xResult == pdPASS )
+    {
+        xResult = xSemaphoreGive( xSharedSemaphore );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Gives a semaphore a higher priority task is waiting for, which runs
+ * it before the give returns.
+ */
+static BaseType_t prvSemaphoreGiveToWaiter( void * pvContext )
+{
+    ( void ) pvContext;
+
+    ( void ) xSemaphoreGive( xSharedSemaphore );
+
+    return ( ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( 1000 ) ) != 0 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Holds a mutex while a higher priority task blocks on it, which
+ * raises the priority of the benchmark task until it gives the mutex.
+ */
+static BaseType_t prvMutexContended( void * pvContext )
+{
+    BaseType_t xResult;
+
+    ( void ) pvContext;
+
+    xResult = xSemaphoreTake( xSharedSemaphore, 0 );
+
+    if( xResult == pdPASS )
+    {
+        xTaskNotifyGive( xHelperTask );
+        xResult = xSemaphoreGive( xSharedSemaphore );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sets the bits of all the waiters, which run and wait again before
+ * the call returns.
+ */
+static BaseType_t prvEventGroupSetBits( void * pvContext )
+{
+    const EventBits_t xBits = ( EventBits_t ) ( uintptr_t ) pvContext;
+
+    /* Every waiter clears its bit as it wakes up. */
+    return ( ( xEventGroupSetBits( xEventGroup, xBits ) & xBits ) == 0 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sends a block to a stream buffer and receives it back, without
+ * blocking.
+ */
+static BaseType_t prvStreamBufferSendReceive( void * pvContext )
+{
+    StreamBufferHandle_t xStreamBuffer = ( StreamBufferHandle_t ) pvContext;
+    BaseType_t xResult = pdFAIL;
+
+    if( xStreamBufferSend( xStreamBuffer, ucItem, benchkernelBUFFER_MESSAGE_SIZE, 0 ) == benchkernelBUFFER_MESSAGE_SIZE )
+    {
+        if( xStreamBufferReceive( xStreamBuffer, ucItem, benchkernelBUFFER_MESSAGE_SIZE, 0 ) == benchkernelBUFFER_MESSAGE_SIZE )
+        {
+            xResult = pdPASS;
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sends a message to a message buffer and receives it back, without
+ * blocking.
+ */
+static BaseType_t prvMessageBufferSendReceive( void * pvContext )
+{
+    MessageBufferHandle_t xMessageBuffer = ( MessageBufferHandle_t ) pvContext;
+    BaseType_t xResult = pdFAIL;
+
+    if( xMessageBufferSend( xMessageBuffer, ucItem, benchkernelBUFFER_MESSAGE_SIZE, 0 ) == benchkernelBUFFER_MESSAGE_SIZE )
+    {
+        if( xMessageBufferReceive( xMessageBuffer, ucItem, sizeof( ucItem ), 0 ) == benchkernelBUFFER_MESSAGE_SIZE )
+        {
+            xResult = pdPASS;
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Blocks for one tick. Each call starts just after a tick, so the
+ * spread of the samples is the wake-up jitter.
+ */
+static BaseType_t prvDelayOneTick( void * pvContext )
+{
+    ( void ) pvContext;
+
+    vTaskDelay( 1 );
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Allocates a block and frees it.
+ */
+static BaseType_t prvHeapAllocFree( void * pvContext )
+{
+    void * pvBlock = pvPortMalloc( ( size_t ) ( uintptr_t ) pvContext );
+
+    vPortFree( pvBlock );
+
+    return ( pvBlock != NULL ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Creates a helper task one priority above the benchmark task.
+ */
+static void prvCreateHelper( TaskFunction_t pxTask,
+                             void * pvParameters,
+                             TaskHandle_t * pxHandle )
+{
+    BaseType_t xResult;
+
+    xResult = xTaskCreate( pxTask,
+                           "BenchHelp",
+                           configMINIMAL_STACK_SIZE,
+                           pvParameters,
+                           benchkernelHELPER_PRIORITY,
+                           pxHandle );
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Deletes the helper task of a benchmark, if any.
+ */
+static void prvDeleteHelper( TaskHandle_t * pxHandle )
+{
+    if( *pxHandle != NULL )
+    {
+        vTaskDelete( *pxHandle );
+        *pxHandle = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_Benchmark_Kernel );
+
+TEST_SETUP( Full_Benchmark_Kernel )
+{
+    xBenchmarkTask = xTaskGetCurrentTaskHandle();
+    uxRunnerPriority = uxTaskPriorityGet( NULL );
+    vTaskPrioritySet( NULL, benchkernelPRIORITY );
+}
+
+TEST_TEAR_DOWN( Full_Benchmark_Kernel )
+{
+    uint32_t ulWaiter;
+
+    prvDeleteHelper( &xHelperTask );
+
+    for( ulWaiter = 0; ulWaiter < benchkernelMAX_EVENT_WAITERS; ulWaiter++ )
+    {
+        prvDeleteHelper( &xEventWaiters[ ulWaiter ] );
+    }
+
+    if( xSharedSemaphore != NULL )
+    {
+        vSemaphoreDelete( xSharedSemaphore );
+        xSharedSemaphore = NULL;
+    }
+
+    if( xEventGroup != NULL )
+    {
+        vEventGroupDelete( xEventGroup );
+        xEventGroup = NULL;
+    }
+
+    vTaskPrioritySet( NULL, uxRunnerPriority );
+}
+
+TEST_GROUP_RUNNER( Full_Benchmark_Kernel )
+{
+    RUN_TEST_CASE( Full_Benchmark_Kernel, ContextSwitch );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, NotifyGiveTake );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, QueueSendReceive );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, SemaphoreUncontended );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, SemaphoreContended );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, MutexUncontended );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, MutexContended );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, EventGroupSetBits );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, StreamBufferSendReceive );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, MessageBufferSendReceive );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, DelayJitter );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, HeapAllocFree );
+    RUN_TEST_CASE( Full_Benchmark_Kernel, HeapAllocFreeFragmented );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, ContextSwitch )
+{
+    BaseType_t xResult;
+
+    /* A higher priority makes the echo task run as soon as it is notified. */
+    prvCreateHelper( prvEchoTask, NULL, &xHelperTask );
+
+    xResult = BENCHMARK_Run( "kernel_context_switch_round_trip",
+                             prvContextSwitch,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, NotifyGiveTake )
+{
+    BaseType_t xResult;
+
+    xResult = BENCHMARK_Run( "kernel_notify_give_take",
+                             prvNotifyGiveTake,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, QueueSendReceive )
+{
+    static const uint16_t usItemSizes[] = { 4, 16, 64, benchkernelMAX_ITEM_SIZE };
+    QueueHandle_t xQueue;
+    BaseType_t xResult = pdPASS;
+    uint32_t ulSize;
+
+    for( ulSize = 0; ( ulSize < sizeof( usItemSizes ) / sizeof( usItemSizes[ 0 ] ) ) && ( xResult == pdPASS ); ulSize++ )
+    {
+        xQueue = xQueueCreate( 1, usItemSizes[ ulSize ] );
+        TEST_ASSERT_NOT_NULL( xQueue );
+
+        ( void ) snprintf( cName, sizeof( cName ), "kernel_queue_send_receive_%u", ( unsigned ) usItemSizes[ ulSize ] );
+        xResult = BENCHMARK_Run( cName,
+                                 prvQueueSendReceive,
+                                 xQueue,
+                                 benchkernelWARM_UP_CALLS,
+                                 benchkernelSAMPLES,
+                                 NULL );
+
+        vQueueDelete( xQueue );
+    }
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, SemaphoreUncontended )
+{
+    BaseType_t xResult;
+
+    xSharedSemaphore = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL( xSharedSemaphore );
+    ( void ) xSemaphoreGive( xSharedSemaphore );
+
+    xResult = BENCHMARK_Run( "kernel_semaphore_take_give",
+                             prvSemaphoreTakeGive,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, SemaphoreContended )
+{
+    BaseType_t xResult;
+
+    xSharedSemaphore = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL( xSharedSemaphore );
+    prvCreateHelper( prvSemaphoreWaiterTask, NULL, &xHelperTask );
+
+    xResult = BENCHMARK_Run( "kernel_semaphore_give_to_waiter",
+                             prvSemaphoreGiveToWaiter,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, MutexUncontended )
+{
+    BaseType_t xResult;
+
+    xSharedSemaphore = xSemaphoreCreateMutex();
+    TEST_ASSERT_NOT_NULL( xSharedSemaphore );
+
+    xResult = BENCHMARK_Run( "kernel_mutex_take_give",
+                             prvSemaphoreTakeGive,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, MutexContended )
+{
+    BaseType_t xResult;
+
+    xSharedSemaphore = xSemaphoreCreateMutex();
+    TEST_ASSERT_NOT_NULL( xSharedSemaphore );
+    prvCreateHelper( prvMutexContenderTask, NULL, &xHelperTask );
+
+    xResult = BENCHMARK_Run( "kernel_mutex_contended",
+                             prvMutexContended,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, EventGroupSetBits )
+{
+    BaseType_t xResult = pdPASS;
+    uint32_t ulWaiters;
+
+    xEventGroup = xEventGroupCreate();
+    TEST_ASSERT_NOT_NULL( xEventGroup );
+
+    /* Add waiters one at a time, measuring with 1, 2 then 4 of them. */
+    for( ulWaiters = 1; ( ulWaiters <= benchkernelMAX_EVENT_WAITERS ) && ( xResult == pdPASS ); ulWaiters++ )
+    {
+        prvCreateHelper( prvEventWaiterTask, ( void * ) ( uintptr_t ) ( ulWaiters - 1 ), &xEventWaiters[ ulWaiters - 1 ] );
+
+        if( ( ulWaiters & ( ulWaiters - 1 ) ) == 0 )
+        {
+            ( void ) snprintf( cName, sizeof( cName ), "kernel_event_group_set_bits_%lu_waiters", ( unsigned long ) ulWaiters );
+            xResult = BENCHMARK_Run( cName,
+                                     prvEventGroupSetBits,
+                                     ( void * ) ( uintptr_t ) ( ( 1UL << ulWaiters ) - 1UL ),
+                                     benchkernelWARM_UP_CALLS,
+                                     benchkernelSAMPLES,
+                                     NULL );
+        }
+    }
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, StreamBufferSendReceive )
+{
+    StreamBufferHandle_t xStreamBuffer = xStreamBufferCreate( benchkernelMAX_ITEM_SIZE, 1 );
+    BenchmarkResult_t xResult;
+    BaseType_t xStatus;
+
+    TEST_ASSERT_NOT_NULL( xStreamBuffer );
+
+    xStatus = BENCHMARK_Run( "kernel_stream_buffer_send_receive_64",
+                             prvStreamBufferSendReceive,
+                             xStreamBuffer,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             &xResult );
+
+    vStreamBufferDelete( xStreamBuffer );
+
+    TEST_ASSERT_EQUAL( pdPASS, xStatus );
+    BENCHMARK_ReportRate( "kernel_stream_buffer_send_receive_64", "bytes", benchkernelBUFFER_MESSAGE_SIZE, &xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, MessageBufferSendReceive )
+{
+    MessageBufferHandle_t xMessageBuffer = xMessageBufferCreate( benchkernelMAX_ITEM_SIZE );
+    BaseType_t xResult;
+
+    TEST_ASSERT_NOT_NULL( xMessageBuffer );
+
+    xResult = BENCHMARK_Run( "kernel_message_buffer_send_receive_64",
+                             prvMessageBufferSendReceive,
+                             xMessageBuffer,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    vMessageBufferDelete( xMessageBuffer );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, DelayJitter )
+{
+    BaseType_t xResult;
+
+    /* The warm-up calls also align the first sample with a tick. */
+    xResult = BENCHMARK_Run( "kernel_delay_one_tick",
+                             prvDelayOneTick,
+                             NULL,
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, HeapAllocFree )
+{
+    static const uint16_t usBlockSizes[] = { 16, 64, 256, 1024 };
+    BaseType_t xResult = pdPASS;
+    uint32_t ulSize;
+
+    for( ulSize = 0; ( ulSize < sizeof( usBlockSizes ) / sizeof( usBlockSizes[ 0 ] ) ) && ( xResult == pdPASS ); ulSize++ )
+    {
+        ( void ) snprintf( cName, sizeof( cName ), "kernel_%s_alloc_free_%u", benchmarkconfigHEAP_NAME, ( unsigned ) usBlockSizes[ ulSize ] );
+        xResult = BENCHMARK_Run( cName,
+                                 prvHeapAllocFree,
+                                 ( void * ) ( uintptr_t ) usBlockSizes[ ulSize ],
+                                 benchkernelWARM_UP_CALLS,
+                                 benchkernelSAMPLES,
+                                 NULL );
+    }
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Kernel, HeapAllocFreeFragmented )
+{
+    void * pvBlocks[ benchkernelFRAGMENT_BLOCKS ] = { NULL };
+    BaseType_t xResult;
+    uint32_t ulBlock;
+
+    /* Free every other block, so that a block larger than the holes has to
+     * be searched for past them. */
+    for( ulBlock = 0; ulBlock < benchkernelFRAGMENT_BLOCKS; ulBlock++ )
+    {
+        pvBlocks[ ulBlock ] = pvPortMalloc( benchkernelFRAGMENT_BLOCK_SIZE );
+    }
+
+    for( ulBlock = 0; ulBlock < benchkernelFRAGMENT_BLOCKS; ulBlock += 2 )
+    {
+        vPortFree( pvBlocks[ ulBlock ] );
+        pvBlocks[ ulBlock ] = NULL;
+    }
+
+    ( void ) snprintf( cName, sizeof( cName ), "kernel_%s_alloc_free_fragmented", benchmarkconfigHEAP_NAME );
+    xResult = BENCHMARK_Run( cName,
+                             prvHeapAllocFree,
+                             ( void * ) ( uintptr_t ) ( 2 * benchkernelFRAGMENT_BLOCK_SIZE ),
+                             benchkernelWARM_UP_CALLS,
+                             benchkernelSAMPLES,
+                             NULL );
+
+    for( ulBlock = 1; ulBlock < benchkernelFRAGMENT_BLOCKS; ulBlock += 2 )
+    {
+        vPortFree( pvBlocks[ ulBlock ] );
+    }
+
+    TEST_ASSERT_EQUAL( pdPASS, xResult );
+}
+/*-----------------------------------------------------------*/
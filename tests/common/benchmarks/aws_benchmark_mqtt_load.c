@@ -0,0 +1,649 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/**
+ * @file aws_benchmark_mqtt_load.c
+ * @brief Load tests of the MQTT agent and the Shadow client.
+ *
+ * Each test runs benchloadconfigTASKS tasks that together call
+ * MQTT_AGENT_Publish() or SHADOW_Update() benchloadconfigRATE_HZ times a
+ * second for benchloadconfigDURATION_MS, against the broker of
+ * aws_clientcredential.h. The MQTT tests also subscribe to
+ * benchloadconfigSUBSCRIPTIONS topics and publish to each in turn, so every
+ * message comes back through the subscription manager. All the settings can
+ * be overridden in FreeRTOSConfig.h to size a device.
+ *
+ * The latency of the calls, which for QoS1 and Shadow updates includes the
+ * round trip to the broker, and the time from publishing a message to
+ * receiving it back are printed as BENCH lines in ticks (see aws_benchmark.h),
+ * so they can be compared with tools/benchmark/benchmark_compare.py. Two more
+ * lines give the throughput and the resources used:
+ *
+ * @code
+ * LOAD,<name>,<duration ms>,<offered per second>,<completed>,<failed>,<received>,<completed per second>,<payload bytes per second>
+ * RES,<name>,<free heap before>,<free heap after>,<minimum ever free heap>,<buffer pool failed requests>,<buffer pool high water mark>
+ * @endcode
+ *
+ * The buffer pool failures are those that happened during the run and the high
+ * water mark is the most buffers ever in use, summed over the size classes.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* Library includes. */
+#include "aws_mqtt_agent.h"
+#include "aws_shadow.h"
+#include "aws_bufferpool.h"
+#include "aws_histogram.h"
+#include "aws_clientcredential.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+
+/* Test includes. */
+#include "aws_benchmark.h"
+
+/**
+ * @brief How long each load test runs.
+ */
+#ifndef benchloadconfigDURATION_MS
+    #define benchloadconfigDURATION_MS    ( 30000UL )
+#endif
+
+/**
+ * @brief The calls made per second by all the tasks of a test together.
+ */
+#ifndef benchloadconfigRATE_HZ
+    #define benchloadconfigRATE_HZ    ( 20UL )
+#endif
+
+/**
+ * @brief The number of tasks making the calls.
+ *
+ * A QoS1 publish or a Shadow update blocks its task until the broker answers,
+ * so this is also the most operations in flight. It should not exceed
+ * mqttconfigMAX_PARALLEL_OPS or shadowconfigMAX_PENDING_OPERATIONS.
+ */
+#ifndef benchloadconfigTASKS
+    #define benchloadconfigTASKS    ( 2UL )
+#endif
+
+/**
+ * @brief The size of each message, and roughly of each Shadow document.
+ */
+#ifndef benchloadconfigPAYLOAD_SIZE
+    #define benchloadconfigPAYLOAD_SIZE    ( 256UL )
+#endif
+
+/**
+ * @brief The number of topics subscribed to and published to in turn. With 0
+ * the messages are published to a single topic nobody subscribes to.
+ */
+#ifndef benchloadconfigSUBSCRIPTIONS
+    #define benchloadconfigSUBSCRIPTIONS    ( 4UL )
+#endif
+
+/**
+ * @brief The stack of the tasks making the calls, in words.
+ */
+#ifndef benchloadconfigTASK_STACK_SIZE
+    #define benchloadconfigTASK_STACK_SIZE    ( configMINIMAL_STACK_SIZE * 4 )
+#endif
+
+/* The priority of the tasks making the calls. */
+#define benchloadTASK_PRIORITY    ( tskIDLE_PRIORITY + 2 )
+
+/* The time to wait for each network operation. */
+#define benchloadTIMEOUT    pdMS_TO_TICKS( 10000UL )
+
+/* How long the messages still on their way are waited for after a run. */
+#define benchloadDRAIN_TIME    pdMS_TO_TICKS( 2000UL )
+
+/* The prefix of the topics, followed by the Thing name and the topic index. */
+#define benchloadTOPIC_PREFIX    "freertos/benchmarks/load/"
+
+/* The longest topic. */
+#define benchloadTOPIC_LENGTH    ( sizeof( benchloadTOPIC_PREFIX ) + sizeof( clientcredentialIOT_THING_NAME ) + 4 )
+
+/* The bytes at the start of each message holding the tick it was sent at. */
+#define benchloadTIMESTAMP_SIZE    ( sizeof( TickType_t ) )
+
+#if ( benchloadconfigPAYLOAD_SIZE < 64UL )
+    #error "benchloadconfigPAYLOAD_SIZE must be at least 64 to hold a Shadow document."
+#endif
+
+#if ( benchloadconfigTASKS < 1UL )
+    #error "benchloadconfigTASKS must be at least 1."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief One call of a load test, made by task ulTask.
+ *
+ * @param[in] ulTask The index of the task, which owns the buffers of that
+ * index.
+ * @param[in] ulSequence Counts the calls of all the tasks, without repeats.
+ *
+ * @return pdPASS if the call succeeded.
+ */
+typedef BaseType_t ( * LoadOperation_t )( uint32_t ulTask,
+                                          uint32_t ulSequence );
+
+/**
+ * @brief The state shared by the tasks of a load test.
+ */
+typedef struct LoadRun
+{
+    LoadOperation_t xOperation;                        /**< The call made by every task. */
+    TickType_t xStart;                                 /**< When the run started. */
+    TickType_t xDuration;                              /**< How long the run lasts. */
+    TickType_t xPeriod;                                /**< The time between the calls of one task. */
+    SemaphoreHandle_t xDone;                           /**< Given by each task as it ends. */
+    uint32_t ulCompleted[ benchloadconfigTASKS ];      /**< The calls that succeeded, per task. */
+    uint32_t ulFailed[ benchloadconfigTASKS ];         /**< The calls that failed, per task. */
+    Histogram_t xLatency;                              /**< The duration of the calls that succeeded, in ticks. */
+} LoadRun_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The running load test.
+ */
+static LoadRun_t xLoad;
+
+/**
+ * @brief Time from publishing a message to receiving it back, in ticks.
+ */
+static Histogram_t xDeliveryLatency;
+
+/**
+ * @brief The messages received back. Only written by the MQTT task.
+ */
+static volatile uint32_t ulReceived;
+
+/**
+ * @brief The connection of the MQTT tests.
+ */
+static MQTTAgentHandle_t xMQTTHandle = NULL;
+
+/**
+ * @brief The QoS of the running MQTT test.
+ */
+static MQTTQoS_t xPublishQoS;
+
+/**
+ * @brief The Shadow client of the Shadow test.
+ */
+static ShadowClientHandle_t xShadowHandle = NULL;
+
+/**
+ * @brief The topics published to.
+ */
+static char cTopics[ ( benchloadconfigSUBSCRIPTIONS > 0UL ) ? benchloadconfigSUBSCRIPTIONS : 1UL ][ benchloadTOPIC_LENGTH ];
+
+/**
+ * @brief The message or document of each task.
+ */
+static uint8_t ucPayloads[ benchloadconfigTASKS ][ benchloadconfigPAYLOAD_SIZE ];
+
+/**
+ * @brief The name of the running test, with the QoS.
+ */
+static char cName[ 32 ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Makes the calls of one task until the end of the run.
+ *
+ * The tasks start at evenly spaced times so that the calls are spread over
+ * each period. A task that falls behind makes its late calls back to back.
+ */
+static void prvLoadTask( void * pvParameters )
+{
+    const uint32_t ulTask = ( uint32_t ) ( uintptr_t ) pvParameters;
+    uint32_t ulSequence;
+    TickType_t xLastWakeTime;
+    TickType_t xCallStart;
+
+    vTaskDelay( ( xLoad.xPeriod * ulTask ) / benchloadconfigTASKS );
+    xLastWakeTime = xTaskGetTickCount();
+
+    for( ulSequence = ulTask;
+         ( xTaskGetTickCount() - xLoad.xStart ) < xLoad.xDuration;
+         ulSequence += benchloadconfigTASKS )
+    {
+        xCallStart = xTaskGetTickCount();
+
+        if( xLoad.xOperation( ulTask, ulSequence ) == pdPASS )
+        {
+            HISTOGRAM_Record( &xLoad.xLatency, ( uint32_t ) ( xTaskGetTickCount() - xCallStart ) );
+            xLoad.ulCompleted[ ulTask ]++;
+        }
+        else
+        {
+            xLoad.ulFailed[ ulTask ]++;
+        }
+
+        vTaskDelayUntil( &xLastWakeTime, xLoad.xPeriod );
+    }
+
+    ( void ) xSemaphoreGive( xLoad.xDone );
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Prints a histogram of ticks as a BENCH line.
+ */
+static void prvReportLatency( const char * pcName,
+                              const char * pcMeasure,
+                              const Histogram_t * pxHistogram )
+{
+    if( HISTOGRAM_GetCount( pxHistogram ) != 0U )
+    {
+        benchmarkconfigPRINTF( ( "BENCH,%s_%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+                                 pcName,
+                                 pcMeasure,
+                                 ( unsigned long ) HISTOGRAM_GetCount( pxHistogram ),
+                                 ( unsigned long ) configTICK_RATE_HZ,
+                                 ( unsigned long ) HISTOGRAM_GetMin( pxHistogram ),
+                                 ( unsigned long ) HISTOGRAM_GetPercentile( pxHistogram, 500 ),
+                                 ( unsigned long ) HISTOGRAM_GetPercentile( pxHistogram, 900 ),
+                                 ( unsigned long ) HISTOGRAM_GetPercentile( pxHistogram, 990 ),
+                                 ( unsigned long ) HISTOGRAM_GetMax( pxHistogram ),
+                                 ( unsigned long ) HISTOGRAM_GetMean( pxHistogram ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sums the failed requests and high water marks of the buffer pool.
+ */
+static void prvGetBufferPoolUsage( uint32_t * pulFailedRequests,
+                                   uint32_t * pulHighWaterMark )
+{
+    BufferPoolStatistics_t xStatistics;
+    uint32_t ulSizeClass;
+
+    *pulFailedRequests = 0;
+    *pulHighWaterMark = 0;
+
+    for( ulSizeClass = 0; ulSizeClass < bufferpoolNUM_SIZE_CLASSES; ulSizeClass++ )
+    {
+        if( BUFFERPOOL_GetStatistics( ulSizeClass, &xStatistics ) == pdPASS )
+        {
+            *pulFailedRequests += xStatistics.ulFailedRequests;
+            *pulHighWaterMark += xStatistics.ulHighWaterMark;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Runs a load test and prints its results.
+ *
+ * @param[in] pcName The name printed with the results.
+ * @param[in] xOperation The call made by every task.
+ *
+ * @return The number of failed calls, or UINT32_MAX if the tasks could not be
+ * run.
+ */
+static uint32_t prvRunLoad( const char * pcName,
+                            LoadOperation_t xOperation )
+{
+    const size_t xHeapBefore = xPortGetFreeHeapSize();
+    uint32_t ulPoolFailuresBefore;
+    uint32_t ulPoolFailuresAfter;
+    uint32_t ulPoolHighWaterMark;
+    uint32_t ulCompleted = 0;
+    uint32_t ulFailed = 0;
+    uint32_t ulStarted = 0;
+    uint32_t ulEnded = 0;
+    uint32_t ulTask;
+
+    prvGetBufferPoolUsage( &ulPoolFailuresBefore, &ulPoolHighWaterMark );
+
+    memset( &xLoad, 0, sizeof( xLoad ) );
+    HISTOGRAM_Reset( &xDeliveryLatency );
+    ulReceived = 0;
+
+    xLoad.xOperation = xOperation;
+    xLoad.xDuration = pdMS_TO_TICKS( benchloadconfigDURATION_MS );
+    xLoad.xPeriod = pdMS_TO_TICKS( ( 1000UL * benchloadconfigTASKS ) / benchloadconfigRATE_HZ );
+    xLoad.xDone = xSemaphoreCreateCounting( benchloadconfigTASKS, 0 );
+
+    if( xLoad.xPeriod == 0 )
+    {
+        xLoad.xPeriod = 1;
+    }
+
+    if( xLoad.xDone != NULL )
+    {
+        xLoad.xStart = xTaskGetTickCount();
+
+        for( ulTask = 0; ulTask < benchloadconfigTASKS; ulTask++ )
+        {
+            if( xTaskCreate( prvLoadTask,
+                             "BenchLoad",
+                             benchloadconfigTASK_STACK_SIZE,
+                             ( void * ) ( uintptr_t ) ulTask,
+                             benchloadTASK_PRIORITY,
+                             NULL ) == pdPASS )
+            {
+                ulStarted++;
+            }
+        }
+
+        /* Every task ends at most one call after the end of the run. */
+        while( ( ulEnded < ulStarted ) &&
+               ( xSemaphoreTake( xLoad.xDone, xLoad.xDuration + ( 2 * benchloadTIMEOUT ) ) == pdPASS ) )
+        {
+            ulEnded++;
+        }
+
+        /* Leave time for the messages still on their way to come back. */
+        vTaskDelay( benchloadDRAIN_TIME );
+    }
+
+    for( ulTask = 0; ulTask < benchloadconfigTASKS; ulTask++ )
+    {
+        ulCompleted += xLoad.ulCompleted[ ulTask ];
+        ulFailed += xLoad.ulFailed[ ulTask ];
+    }
+
+    prvGetBufferPoolUsage( &ulPoolFailuresAfter, &ulPoolHighWaterMark );
+
+    prvReportLatency( pcName, "call", &xLoad.xLatency );
+    prvReportLatency( pcName, "delivery", &xDeliveryLatency );
+
+    benchmarkconfigPRINTF( ( "LOAD,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+                             pcName,
+                             ( unsigned long ) benchloadconfigDURATION_MS,
+                             ( unsigned long ) benchloadconfigRATE_HZ,
+                             ( unsigned long ) ulCompleted,
+                             ( unsigned long ) ulFailed,
+                             ( unsigned long ) ulReceived,
+                             ( unsigned long ) ( ( ulCompleted * 1000UL ) / benchloadconfigDURATION_MS ),
+                             ( unsigned long ) ( ( ( uint64_t ) ulCompleted * benchloadconfigPAYLOAD_SIZE * 1000UL ) / benchloadconfigDURATION_MS ) ) );
+
+    benchmarkconfigPRINTF( ( "RES,%s,%lu,%lu,%lu,%lu,%lu\r\n",
+                             pcName,
+                             ( unsigned long ) xHeapBefore,
+                             ( unsigned long ) xPortGetFreeHeapSize(),
+                             ( unsigned long ) xPortGetMinimumEverFreeHeapSize(),
+                             ( unsigned long ) ( ulPoolFailuresAfter - ulPoolFailuresBefore ),
+                             ( unsigned long ) ulPoolHighWaterMark ) );
+
+    /* A task still running would use the state of the next test. */
+    configASSERT( ulEnded == ulStarted );
+
+    if( xLoad.xDone != NULL )
+    {
+        vSemaphoreDelete( xLoad.xDone );
+    }
+
+    return ( ulStarted == benchloadconfigTASKS ) ? ulFailed : UINT32_MAX;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Counts a message received back and how long it took.
+ */
+static MQTTBool_t prvLoadCallback( void * pvPublishCallbackContext,
+                                   const MQTTPublishData_t * const pxPublishData )
+{
+    TickType_t xSentAt;
+
+    ( void ) pvPublishCallbackContext;
+
+    if( pxPublishData->ulDataLength >= benchloadTIMESTAMP_SIZE )
+    {
+        memcpy( &xSentAt, pxPublishData->pvData, sizeof( xSentAt ) );
+        HISTOGRAM_Record( &xDeliveryLatency, ( uint32_t ) ( xTaskGetTickCount() - xSentAt ) );
+        ulReceived++;
+    }
+
+    /* The buffer goes back to the MQTT agent. */
+    return eMQTTFalse;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publishes one message, stamped with the tick it is sent at.
+ */
+static BaseType_t prvPublish( uint32_t ulTask,
+                              uint32_t ulSequence )
+{
+    MQTTAgentPublishParams_t xPublishParameters;
+    const char * pcTopic = cTopics[ ( benchloadconfigSUBSCRIPTIONS > 0UL ) ? ( ulSequence % benchloadconfigSUBSCRIPTIONS ) : 0UL ];
+    const TickType_t xNow = xTaskGetTickCount();
+
+    memcpy( ucPayloads[ ulTask ], &xNow, sizeof( xNow ) );
+
+    memset( &xPublishParameters, 0, sizeof( xPublishParameters ) );
+    xPublishParameters.pucTopic = ( const uint8_t * ) pcTopic;
+    xPublishParameters.usTopicLength = ( uint16_t ) strlen( pcTopic );
+    xPublishParameters.xQoS = xPublishQoS;
+    xPublishParameters.pvData = ucPayloads[ ulTask ];
+    xPublishParameters.ulDataLength = benchloadconfigPAYLOAD_SIZE;
+
+    return ( MQTT_AGENT_Publish( xMQTTHandle, &xPublishParameters, benchloadTIMEOUT ) == eMQTTAgentSuccess ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Reports a new value to the Shadow, padded to about
+ * benchloadconfigPAYLOAD_SIZE bytes.
+ */
+static BaseType_t prvShadowUpdate( uint32_t ulTask,
+                                   uint32_t ulSequence )
+{
+    static const char cPadding[] = "0123456789abcdef";
+    ShadowOperationParams_t xUpdateParameters;
+    char * pcDocument = ( char * ) ucPayloads[ ulTask ];
+    int lLength;
+    int lPadding;
+
+    /* The clientToken matches the answer to the update; see SHADOW_Update(). */
+    lLength = snprintf( pcDocument,
+                        benchloadconfigPAYLOAD_SIZE,
+                        "{\"state\":{\"reported\":{\"load\":%lu,\"pad\":\"",
+                        ( unsigned long ) ulSequence );
+
+    for( lPadding = 0; lLength < ( int ) ( benchloadconfigPAYLOAD_SIZE - 40 ); lPadding++ )
+    {
+        pcDocument[ lLength++ ] = cPadding[ lPadding % ( int ) ( sizeof( cPadding ) - 1 ) ];
+    }
+
+    lLength += snprintf( &pcDocument[ lLength ],
+                         benchloadconfigPAYLOAD_SIZE - ( size_t ) lLength,
+                         "\"}},\"clientToken\":\"load-%lu\"}",
+                         ( unsigned long ) ulSequence );
+
+    memset( &xUpdateParameters, 0, sizeof( xUpdateParameters ) );
+    xUpdateParameters.pcThingName = clientcredentialIOT_THING_NAME;
+    xUpdateParameters.pcData = pcDocument;
+    xUpdateParameters.ulDataLength = ( uint32_t ) lLength;
+    xUpdateParameters.xQoS = eMQTTQoS1;
+
+    /* Keeping the subscriptions avoids subscribing again for every update. */
+    xUpdateParameters.ucKeepSubscriptions = pdTRUE;
+
+    return ( SHADOW_Update( xShadowHandle, &xUpdateParameters, benchloadTIMEOUT ) == eShadowSuccess ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Fills in the connection parameters of the broker.
+ */
+static void prvConnectParameters( MQTTAgentConnectParams_t * pxConnectParameters )
+{
+    memset( pxConnectParameters, 0, sizeof( *pxConnectParameters ) );
+    pxConnectParameters->pcURL = clientcredentialMQTT_BROKER_ENDPOINT;
+    pxConnectParameters->xFlags = mqttagentREQUIRE_TLS;
+    pxConnectParameters->usPort = clientcredentialMQTT_BROKER_PORT;
+    pxConnectParameters->pucClientId = ( const uint8_t * ) clientcredentialIOT_THING_NAME;
+    pxConnectParameters->usClientIdLength = ( uint16_t ) strlen( clientcredentialIOT_THING_NAME );
+    pxConnectParameters->xSecuredConnection = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Runs the MQTT load test at one QoS.
+ */
+static void prvMQTTLoad( MQTTQoS_t xQoS )
+{
+    MQTTAgentConnectParams_t xConnectParameters;
+    MQTTAgentSubscribeParams_t xSubscribeParameters;
+    MQTTAgentUnsubscribeParams_t xUnsubscribeParameters;
+    uint32_t ulSubscribed = 0;
+    uint32_t ulFailed = UINT32_MAX;
+    uint32_t ulTopic;
+
+    xPublishQoS = xQoS;
+    ( void ) snprintf( cName, sizeof( cName ), "mqtt_load_qos%d", ( int ) xQoS );
+
+    for( ulTopic = 0; ulTopic < sizeof( cTopics ) / sizeof( cTopics[ 0 ] ); ulTopic++ )
+    {
+        ( void ) snprintf( cTopics[ ulTopic ], sizeof( cTopics[ ulTopic ] ), benchloadTOPIC_PREFIX "%s/%lu",
+                           clientcredentialIOT_THING_NAME, ( unsigned long ) ulTopic );
+    }
+
+    prvConnectParameters( &xConnectParameters );
+
+    TEST_ASSERT_EQUAL( eMQTTAgentSuccess, MQTT_AGENT_Create( &xMQTTHandle ) );
+
+    if( MQTT_AGENT_Connect( xMQTTHandle, &xConnectParameters, benchloadTIMEOUT ) == eMQTTAgentSuccess )
+    {
+        for( ulTopic = 0; ulTopic < benchloadconfigSUBSCRIPTIONS; ulTopic++ )
+        {
+            memset( &xSubscribeParameters, 0, sizeof( xSubscribeParameters ) );
+            xSubscribeParameters.pucTopic = ( const uint8_t * ) cTopics[ ulTopic ];
+            xSubscribeParameters.usTopicLength = ( uint16_t ) strlen( cTopics[ ulTopic ] );
+            xSubscribeParameters.xQoS = eMQTTQoS1;
+            #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+                xSubscribeParameters.pxPublishCallback = prvLoadCallback;
+            #endif
+
+            if( MQTT_AGENT_Subscribe( xMQTTHandle, &xSubscribeParameters, benchloadTIMEOUT ) == eMQTTAgentSuccess )
+            {
+                ulSubscribed++;
+            }
+        }
+
+        if( ulSubscribed == benchloadconfigSUBSCRIPTIONS )
+        {
+            ulFailed = prvRunLoad( cName, prvPublish );
+        }
+
+        for( ulTopic = 0; ulTopic < ulSubscribed; ulTopic++ )
+        {
+            xUnsubscribeParameters.pucTopic = ( const uint8_t * ) cTopics[ ulTopic ];
+            xUnsubscribeParameters.usTopicLength = ( uint16_t ) strlen( cTopics[ ulTopic ] );
+            ( void ) MQTT_AGENT_Unsubscribe( xMQTTHandle, &xUnsubscribeParameters, benchloadTIMEOUT );
+        }
+
+        ( void ) MQTT_AGENT_Disconnect( xMQTTHandle, benchloadTIMEOUT );
+    }
+
+    ( void ) MQTT_AGENT_Delete( xMQTTHandle );
+    xMQTTHandle = NULL;
+
+    TEST_ASSERT_EQUAL( benchloadconfigSUBSCRIPTIONS, ulSubscribed );
+    TEST_ASSERT_EQUAL( 0, ulFailed );
+}
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_Benchmark_MQTT_Load );
+
+TEST_SETUP( Full_Benchmark_MQTT_Load )
+{
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < sizeof( ucPayloads ); xIndex++ )
+    {
+        ( ( uint8_t * ) ucPayloads )[ xIndex ] = ( uint8_t ) xIndex;
+    }
+}
+
+TEST_TEAR_DOWN( Full_Benchmark_MQTT_Load )
+{
+}
+
+TEST_GROUP_RUNNER( Full_Benchmark_MQTT_Load )
+{
+    RUN_TEST_CASE( Full_Benchmark_MQTT_Load, PublishQoS0 );
+    RUN_TEST_CASE( Full_Benchmark_MQTT_Load, PublishQoS1 );
+    RUN_TEST_CASE( Full_Benchmark_MQTT_Load, ShadowUpdate );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_MQTT_Load, PublishQoS0 )
+{
+    prvMQTTLoad( eMQTTQoS0 );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_MQTT_Load, PublishQoS1 )
+{
+    prvMQTTLoad( eMQTTQoS1 );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_MQTT_Load, ShadowUpdate )
+{
+    ShadowCreateParams_t xCreateParameters;
+    MQTTAgentConnectParams_t xConnectParameters;
+    uint32_t ulFailed = UINT32_MAX;
+
+    memset( &xCreateParameters, 0, sizeof( xCreateParameters ) );
+    xCreateParameters.xMQTTClientType = eDedicatedMQTTClient;
+
+    TEST_ASSERT_EQUAL( eShadowSuccess, SHADOW_ClientCreate( &xShadowHandle, &xCreateParameters ) );
+
+    prvConnectParameters( &xConnectParameters );
+
+    if( SHADOW_ClientConnect( xShadowHandle, &xConnectParameters, benchloadTIMEOUT ) == eShadowSuccess )
+    {
+        ulFailed = prvRunLoad( "shadow_load_update", prvShadowUpdate );
+
+        ( void ) SHADOW_ClientDisconnect( xShadowHandle );
+    }
+
+    ( void ) SHADOW_ClientDelete( xShadowHandle );
+    xShadowHandle = NULL;
+
+    TEST_ASSERT_EQUAL( 0, ulFailed );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,358 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_benchmark_network.c
+ * @brief Benchmarks of the network stack, TLS and the MQTT agent.
+ *
+ * The TCP and TLS benchmarks use the echo servers of tools/echo_server,
+ * configured in aws_test_tcp.h, and the MQTT benchmark uses the broker of
+ * aws_clientcredential.h.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "aws_secure_sockets.h"
+#include "aws_mqtt_agent.h"
+#include "aws_clientcredential.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+
+/* Test includes. */
+#include "aws_test_tcp.h"
+#include "aws_benchmark.h"
+
+/* The size of each buffer echoed by the TCP throughput benchmark. */
+#define benchnetTCP_CHUNK_SIZE    ( 1024 )
+
+/* The number of buffers echoed by the TCP throughput benchmark. */
+#define benchnetTCP_SAMPLES    ( 100 )
+
+/* The number of handshakes timed by the TLS benchmark. */
+#define benchnetTLS_SAMPLES    ( 5 )
+
+/* The number of publishes timed by the MQTT benchmark. */
+#define benchnetMQTT_SAMPLES    ( 50 )
+
+/* The payload size of the MQTT benchmark. */
+#define benchnetMQTT_PAYLOAD_SIZE    ( 128 )
+
+/* The topic of the MQTT benchmark. */
+#define benchnetMQTT_TOPIC    "freertos/benchmarks/publish"
+
+/* The time to wait for each network operation. */
+#define benchnetTIMEOUT    pdMS_TO_TICKS( 10000UL )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The buffers of the TCP throughput benchmark.
+ */
+static uint8_t ucTxBuffer[ benchnetTCP_CHUNK_SIZE ];
+static uint8_t ucRxBuffer[ benchnetTCP_CHUNK_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Fills in the address of an echo server.
+ */
+static void prvEchoServerAddress( SocketsSockaddr_t * pxAddress,
+                                  BaseType_t xSecure )
+{
+    memset( pxAddress, 0, sizeof( *pxAddress ) );
+    pxAddress->ucLength = sizeof( SocketsSockaddr_t );
+    pxAddress->ucSocketDomain = SOCKETS_AF_INET;
+
+    if( xSecure == pdTRUE )
+    {
+        pxAddress->ulAddress = SOCKETS_inet_addr_quick( tcptestECHO_SERVER_TLS_ADDR0,
+                                                        tcptestECHO_SERVER_TLS_ADDR1,
+                                                        tcptestECHO_SERVER_TLS_ADDR2,
+                                                        tcptestECHO_SERVER_TLS_ADDR3 );
+        pxAddress->usPort = SOCKETS_htons( tcptestECHO_PORT_TLS );
+    }
+    else
+    {
+        pxAddress->ulAddress = SOCKETS_inet_addr_quick( tcptestECHO_SERVER_ADDR0,
+                                                        tcptestECHO_SERVER_ADDR1,
+                                                        tcptestECHO_SERVER_ADDR2,
+                                                        tcptestECHO_SERVER_ADDR3 );
+        pxAddress->usPort = SOCKETS_htons( tcptestECHO_PORT );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Opens a connection to an echo server.
+ *
+ * @return The connected socket, or SOCKETS_INVALID_SOCKET.
+ */
+static Socket_t prvConnectToEchoServer( BaseType_t xSecure )
+{
+    Socket_t xSocket;
+    SocketsSockaddr_t xAddress;
+    TickType_t xTimeout = benchnetTIMEOUT;
+    int32_t lResult;
+
+    prvEchoServerAddress( &xAddress, xSecure );
+
+    xSocket = SOCKETS_Socket( SOCKETS_AF_INET, SOCKETS_SOCK_STREAM, SOCKETS_IPPROTO_TCP );
+
+    if( xSocket != SOCKETS_INVALID_SOCKET )
+    {
+        lResult = SOCKETS_SetSockOpt( xSocket, 0, SOCKETS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) );
+
+        if( lResult == SOCKETS_ERROR_NONE )
+        {
+            lResult = SOCKETS_SetSockOpt( xSocket, 0, SOCKETS_SO_SNDTIMEO, &xTimeout, sizeof( xTimeout ) );
+        }
+
+        if( ( lResult == SOCKETS_ERROR_NONE ) && ( xSecure == pdTRUE ) )
+        {
+            lResult = SOCKETS_SetSockOpt( xSocket, 0, SOCKETS_SO_REQUIRE_TLS, NULL, 0 );
+
+            if( lResult == SOCKETS_ERROR_NONE )
+            {
+                lResult = SOCKETS_SetSockOpt( xSocket,
+                                              0,
+                                              SOCKETS_SO_TRUSTED_SERVER_CERTIFICATE,
+                                              tcptestECHO_HOST_ROOT_CA,
+                                              sizeof( tcptestECHO_HOST_ROOT_CA ) );
+            }
+        }
+
+        if( lResult == SOCKETS_ERROR_NONE )
+        {
+            lResult = SOCKETS_Connect( xSocket, &xAddress, sizeof( xAddress ) );
+        }
+
+        if( lResult != SOCKETS_ERROR_NONE )
+        {
+            ( void ) SOCKETS_Close( xSocket );
+            xSocket = SOCKETS_INVALID_SOCKET;
+        }
+    }
+
+    return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Closes a connection to an echo server.
+ */
+static void prvDisconnect( Socket_t xSocket )
+{
+    ( void ) SOCKETS_Shutdown( xSocket, SOCKETS_SHUT_RDWR );
+    ( void ) SOCKETS_Close( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sends one buffer to the echo server and receives it back.
+ */
+static BaseType_t prvTCPEcho( void * pvContext )
+{
+    Socket_t xSocket = ( Socket_t ) pvContext;
+    BaseType_t xResult = pdPASS;
+    size_t xSent = 0;
+    size_t xReceived = 0;
+    int32_t lResult;
+
+    while( ( xResult == pdPASS ) && ( xSent < sizeof( ucTxBuffer ) ) )
+    {
+        lResult = SOCKETS_Send( xSocket, &ucTxBuffer[ xSent ], sizeof( ucTxBuffer ) - xSent, 0 );
+
+        if( lResult > 0 )
+        {
+            xSent += ( size_t ) lResult;
+        }
+        else
+        {
+            xResult = pdFAIL;
+        }
+    }
+
+    while( ( xResult == pdPASS ) && ( xReceived < sizeof( ucRxBuffer ) ) )
+    {
+        lResult = SOCKETS_Recv( xSocket, &ucRxBuffer[ xReceived ], sizeof( ucRxBuffer ) - xReceived, 0 );
+
+        if( lResult > 0 )
+        {
+            xReceived += ( size_t ) lResult;
+        }
+        else
+        {
+            xResult = pdFAIL;
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connects to the secure echo server, which includes the TLS
+ * handshake, and disconnects.
+ */
+static BaseType_t prvTLSHandshake( void * pvContext )
+{
+    Socket_t xSocket = prvConnectToEchoServer( pdTRUE );
+    BaseType_t xResult = pdFAIL;
+
+    ( void ) pvContext;
+
+    if( xSocket != SOCKETS_INVALID_SOCKET )
+    {
+        prvDisconnect( xSocket );
+        xResult = pdPASS;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publishes one QoS1 message and waits for its PUBACK.
+ */
+static BaseType_t prvMQTTPublish( void * pvContext )
+{
+    MQTTAgentHandle_t xMQTTHandle = ( MQTTAgentHandle_t ) pvContext;
+    MQTTAgentPublishParams_t xPublishParameters;
+
+    memset( &xPublishParameters, 0, sizeof( xPublishParameters ) );
+    xPublishParameters.pucTopic = ( const uint8_t * ) benchnetMQTT_TOPIC;
+    xPublishParameters.usTopicLength = ( uint16_t ) ( sizeof( benchnetMQTT_TOPIC ) - 1 );
+    xPublishParameters.xQoS = eMQTTQoS1;
+    xPublishParameters.pvData = ucTxBuffer;
+    xPublishParameters.ulDataLength = benchnetMQTT_PAYLOAD_SIZE;
+
+    return ( MQTT_AGENT_Publish( xMQTTHandle, &xPublishParameters, benchnetTIMEOUT ) == eMQTTAgentSuccess ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_Benchmark_Network );
+
+TEST_SETUP( Full_Benchmark_Network )
+{
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < sizeof( ucTxBuffer ); xIndex++ )
+    {
+        ucTxBuffer[ xIndex ] = ( uint8_t ) xIndex;
+    }
+}
+
+TEST_TEAR_DOWN( Full_Benchmark_Network )
+{
+}
+
+TEST_GROUP_RUNNER( Full_Benchmark_Network )
+{
+    RUN_TEST_CASE( Full_Benchmark_Network, TCPThroughput );
+    RUN_TEST_CASE( Full_Benchmark_Network, TLSHandshake );
+    RUN_TEST_CASE( Full_Benchmark_Network, MQTTPublishRate );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Network, TCPThroughput )
+{
+    Socket_t xSocket = prvConnectToEchoServer( pdFALSE );
+    BenchmarkResult_t xResult;
+    BaseType_t xStatus;
+
+    TEST_ASSERT_NOT_EQUAL( SOCKETS_INVALID_SOCKET, xSocket );
+
+    xStatus = BENCHMARK_Run( "net_tcp_echo_1024",
+                             prvTCPEcho,
+                             xSocket,
+                             5,
+                             benchnetTCP_SAMPLES,
+                             &xResult );
+
+    prvDisconnect( xSocket );
+
+    TEST_ASSERT_EQUAL( pdPASS, xStatus );
+    TEST_ASSERT_EQUAL_MEMORY( ucTxBuffer, ucRxBuffer, sizeof( ucTxBuffer ) );
+
+    /* Each call moves the buffer in both directions. */
+    BENCHMARK_ReportRate( "net_tcp_echo_1024", "bytes", 2 * benchnetTCP_CHUNK_SIZE, &xResult );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Network, TLSHandshake )
+{
+    TEST_ASSERT_EQUAL( pdPASS, BENCHMARK_Run( "net_tls_connect",
+                                              prvTLSHandshake,
+                                              NULL,
+                                              1,
+                                              benchnetTLS_SAMPLES,
+                                              NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_Network, MQTTPublishRate )
+{
+    MQTTAgentHandle_t xMQTTHandle = NULL;
+    MQTTAgentConnectParams_t xConnectParameters;
+    BenchmarkResult_t xResult;
+    BaseType_t xStatus = pdFAIL;
+
+    memset( &xConnectParameters, 0, sizeof( xConnectParameters ) );
+    xConnectParameters.pcURL = clientcredentialMQTT_BROKER_ENDPOINT;
+    xConnectParameters.xFlags = mqttagentREQUIRE_TLS;
+    xConnectParameters.usPort = clientcredentialMQTT_BROKER_PORT;
+    xConnectParameters.pucClientId = ( const uint8_t * ) clientcredentialIOT_THING_NAME;
+    xConnectParameters.usClientIdLength = ( uint16_t ) strlen( clientcredentialIOT_THING_NAME );
+    xConnectParameters.xSecuredConnection = pdTRUE;
+
+    TEST_ASSERT_EQUAL( eMQTTAgentSuccess, MQTT_AGENT_Create( &xMQTTHandle ) );
+
+    if( MQTT_AGENT_Connect( xMQTTHandle, &xConnectParameters, benchnetTIMEOUT ) == eMQTTAgentSuccess )
+    {
+        xStatus = BENCHMARK_Run( "mqtt_publish_qos1_128",
+                                 prvMQTTPublish,
+                                 xMQTTHandle,
+                                 5,
+                                 benchnetMQTT_SAMPLES,
+                                 &xResult );
+
+        ( void ) MQTT_AGENT_Disconnect( xMQTTHandle, benchnetTIMEOUT );
+    }
+
+    ( void ) MQTT_AGENT_Delete( xMQTTHandle );
+
+    TEST_ASSERT_EQUAL( pdPASS, xStatus );
+
+    BENCHMARK_ReportRate( "mqtt_publish_qos1_128", "messages", 1, &xResult );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,260 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_benchmark_ota.c
+ * @brief Benchmarks of the CBOR encoding and decoding done by the OTA agent
+ * for every block of a download.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* OTA and CBOR includes. */
+#include "aws_ota_cbor.h"
+#include "aws_ota_cbor_internal.h"
+#include "cbor.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+
+/* Benchmark includes. */
+#include "aws_benchmark.h"
+
+/* The number of untimed calls made before measuring. */
+#define benchotaWARM_UP_CALLS    ( 10 )
+
+/* The number of timed calls. */
+#define benchotaSAMPLES    ( 200 )
+
+/* The block size requested from the OTA service. */
+#define benchotaBLOCK_SIZE    ( 1024 )
+
+/* The size of the buffers that hold the encoded messages. */
+#define benchotaMESSAGE_SIZE    ( benchotaBLOCK_SIZE + 64 )
+
+/* The number of blocks tracked by the request bitmap. */
+#define benchotaBITMAP_SIZE    ( 16 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief An encoded Get Stream response carrying one block.
+ */
+static uint8_t ucResponse[ benchotaMESSAGE_SIZE ];
+static size_t xResponseSize = 0;
+
+/**
+ * @brief The buffer the Get Stream requests are encoded in.
+ */
+static uint8_t ucRequest[ benchotaMESSAGE_SIZE ];
+
+/**
+ * @brief The block payload and request bitmap.
+ */
+static uint8_t ucBlock[ benchotaBLOCK_SIZE ];
+static uint8_t ucBitmap[ benchotaBITMAP_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Encodes a Get Stream response like those sent by the OTA service.
+ */
+static BaseType_t prvEncodeResponse( void )
+{
+    CborEncoder xEncoder;
+    CborEncoder xMapEncoder;
+    CborError xError;
+
+    cbor_encoder_init( &xEncoder, ucResponse, sizeof( ucResponse ), 0 );
+    xError = cbor_encoder_create_map( &xEncoder, &xMapEncoder, 4 );
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_text_stringz( &xMapEncoder, OTA_CBOR_FILEID_KEY );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_int( &xMapEncoder, 0 );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_text_stringz( &xMapEncoder, OTA_CBOR_BLOCKID_KEY );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_int( &xMapEncoder, 7 );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_text_stringz( &xMapEncoder, OTA_CBOR_BLOCKSIZE_KEY );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_int( &xMapEncoder, benchotaBLOCK_SIZE );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_text_stringz( &xMapEncoder, OTA_CBOR_BLOCKPAYLOAD_KEY );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encode_byte_string( &xMapEncoder, ucBlock, sizeof( ucBlock ) );
+    }
+
+    if( xError == CborNoError )
+    {
+        xError = cbor_encoder_close_container_checked( &xEncoder, &xMapEncoder );
+    }
+
+    if( xError == CborNoError )
+    {
+        xResponseSize = cbor_encoder_get_buffer_size( &xEncoder, ucResponse );
+    }
+
+    return ( xError == CborNoError ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Encodes the request for the next blocks.
+ */
+static BaseType_t prvEncodeRequest( void * pvContext )
+{
+    size_t xEncodedSize;
+
+    ( void ) pvContext;
+
+    return OTA_CBOR_Encode_GetStreamRequestMessage( ucRequest,
+                                                    sizeof( ucRequest ),
+                                                    &xEncodedSize,
+                                                    "rdy",
+                                                    0,
+                                                    benchotaBLOCK_SIZE,
+                                                    0,
+                                                    ucBitmap,
+                                                    sizeof( ucBitmap ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Decodes a received block the way the OTA agent ingests it.
+ */
+static BaseType_t prvDecodeResponse( void * pvContext )
+{
+    int32_t lFileId;
+    int32_t lBlockId;
+    int32_t lBlockSize;
+    const uint8_t * pucPayload;
+    size_t xPayloadSize;
+    BaseType_t xResult;
+
+    ( void ) pvContext;
+
+    xResult = OTA_CBOR_Decode_GetStreamResponseMessageInPlace( ucResponse,
+                                                               xResponseSize,
+                                                               &lFileId,
+                                                               &lBlockId,
+                                                               &lBlockSize,
+                                                               &pucPayload,
+                                                               &xPayloadSize );
+
+    if( ( xResult == pdTRUE ) && ( xPayloadSize == benchotaBLOCK_SIZE ) )
+    {
+        xResult = pdPASS;
+    }
+    else
+    {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_Benchmark_OTA );
+
+TEST_SETUP( Full_Benchmark_OTA )
+{
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < sizeof( ucBlock ); xIndex++ )
+    {
+        ucBlock[ xIndex ] = ( uint8_t ) xIndex;
+    }
+
+    memset( ucBitmap, 0xFF, sizeof( ucBitmap ) );
+}
+
+TEST_TEAR_DOWN( Full_Benchmark_OTA )
+{
+}
+
+TEST_GROUP_RUNNER( Full_Benchmark_OTA )
+{
+    RUN_TEST_CASE( Full_Benchmark_OTA, CBOREncodeRequest );
+    RUN_TEST_CASE( Full_Benchmark_OTA, IngestBlock );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_OTA, CBOREncodeRequest )
+{
+    TEST_ASSERT_EQUAL( pdPASS, BENCHMARK_Run( "ota_cbor_encode_request",
+                                              prvEncodeRequest,
+                                              NULL,
+                                              benchotaWARM_UP_CALLS,
+                                              benchotaSAMPLES,
+                                              NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+TEST( Full_Benchmark_OTA, IngestBlock )
+{
+    BenchmarkResult_t xResult;
+
+    TEST_ASSERT_EQUAL( pdPASS, prvEncodeResponse() );
+
+    TEST_ASSERT_EQUAL( pdPASS, BENCHMARK_Run( "ota_ingest_decode_1024",
+                                              prvDecodeResponse,
+                                              NULL,
+                                              benchotaWARM_UP_CALLS,
+                                              benchotaSAMPLES,
+                                              &xResult ) );
+
+    BENCHMARK_ReportRate( "ota_ingest_decode_1024", "bytes", benchotaBLOCK_SIZE, &xResult );
+}
+/*-----------------------------------------------------------*/
@@ -25,12 +25,16 @@
 
 /* Standard includes. */
 #include <stdint.h>
+#include <string.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
+#include "task.h"
 
 /* Crypto includes. */
 #include "aws_crypto.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha1.h"
 
 /* Unity framework includes. */
 #include "unity_fixture.h"
@@ -49,6 +53,8 @@ TEST_TEAR_DOWN( Full_CRYPTO )
 TEST_GROUP_RUNNER( Full_CRYPTO )
 {
     RUN_TEST_CASE( Full_CRYPTO, VerifySignatureTestVectors );
+    RUN_TEST_CASE( Full_CRYPTO, AESGCMAcceleratorFallback );
+    RUN_TEST_CASE( Full_CRYPTO, SHAKnownAnswersAndThroughput );
 }
 
 TEST( Full_CRYPTO, VerifySignatureTestVectors )
@@ -281,3 +287,191 @@ TEST( Full_CRYPTO, VerifySignatureTestVectors )
     TEST_ASSERT_FALSE( xResult );
     /** @}*/
 }
+
+/*-----------------------------------------------------------*/
+
+static uint32_t ulAcceleratorCalls = 0;
+
+static BaseType_t prvDecliningAESGCM( BaseType_t xEncrypt,
+                                      const uint8_t * pucKey,
+                                      size_t xKeyBits,
+                                      const uint8_t * pucIV,
+                                      size_t xIVLength,
+                                      const uint8_t * pucAAD,
+                                      size_t xAADLength,
+                                      const uint8_t * pucInput,
+                                      size_t xLength,
+                                      uint8_t * pucOutput,
+                                      uint8_t * pucTag,
+                                      size_t xTagLength )
+{
+    ( void ) xEncrypt;
+    ( void ) pucKey;
+    ( void ) xKeyBits;
+    ( void ) pucIV;
+    ( void ) xIVLength;
+    ( void ) pucAAD;
+    ( void ) xAADLength;
+    ( void ) pucInput;
+    ( void ) xLength;
+    ( void ) pucOutput;
+    ( void ) pucTag;
+    ( void ) xTagLength;
+
+    /* Behave like a busy engine. */
+    ulAcceleratorCalls++;
+
+    return pdFALSE;
+}
+
+TEST( Full_CRYPTO, AESGCMAcceleratorFallback )
+{
+    static const CryptoAccelerator_t xDecliningAccelerator = { "declining", NULL, prvDecliningAESGCM };
+    uint8_t ucKey[ 16 ] = { 0 };
+    uint8_t ucIV[ 12 ] = { 0 };
+    uint8_t ucPlaintext[ 512 ];
+    uint8_t ucCiphertext[ sizeof( ucPlaintext ) ];
+    uint8_t ucSoftwareCiphertext[ sizeof( ucPlaintext ) ];
+    uint8_t ucDecrypted[ sizeof( ucPlaintext ) ];
+    uint8_t ucTag[ 16 ];
+    uint8_t ucSoftwareTag[ 16 ];
+
+    memset( ucPlaintext, 0x5A, sizeof( ucPlaintext ) );
+
+    /* Reference result without an engine. */
+    CRYPTO_RegisterAccelerator( NULL );
+    TEST_ASSERT_TRUE( CRYPTO_AESGCMEncrypt( ucKey, 128, ucIV, sizeof( ucIV ), NULL, 0,
+                                            ucPlaintext, sizeof( ucPlaintext ),
+                                            ucSoftwareCiphertext, ucSoftwareTag, sizeof( ucSoftwareTag ) ) );
+
+    /* The engine is offered the message and software takes over. */
+    CRYPTO_RegisterAccelerator( &xDecliningAccelerator );
+    CRYPTO_SetAcceleratorThreshold( cryptoACCEL_OPERATION_AES_GCM, sizeof( ucPlaintext ) );
+    ulAcceleratorCalls = 0;
+    TEST_ASSERT_TRUE( CRYPTO_AESGCMEncrypt( ucKey, 128, ucIV, sizeof( ucIV ), NULL, 0,
+                                            ucPlaintext, sizeof( ucPlaintext ),
+                                            ucCiphertext, ucTag, sizeof( ucTag ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 1, ulAcceleratorCalls );
+    TEST_ASSERT_EQUAL_MEMORY( ucSoftwareCiphertext, ucCiphertext, sizeof( ucCiphertext ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucSoftwareTag, ucTag, sizeof( ucTag ) );
+
+    /* Shorter than the threshold: the engine is not offered it. */
+    TEST_ASSERT_TRUE( CRYPTO_AESGCMDecrypt( ucKey, 128, ucIV, sizeof( ucIV ), NULL, 0,
+                                            ucCiphertext, sizeof( ucCiphertext ) - 1U,
+                                            ucDecrypted, ucTag, sizeof( ucTag ) ) == pdFALSE );
+    TEST_ASSERT_EQUAL_UINT32( 1, ulAcceleratorCalls );
+
+    TEST_ASSERT_TRUE( CRYPTO_AESGCMDecrypt( ucKey, 128, ucIV, sizeof( ucIV ), NULL, 0,
+                                            ucCiphertext, sizeof( ucCiphertext ),
+                                            ucDecrypted, ucTag, sizeof( ucTag ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucPlaintext, ucDecrypted, sizeof( ucDecrypted ) );
+
+    CRYPTO_RegisterAccelerator( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/* Bytes hashed, in total, by the throughput measurement. */
+#define cryptotestSHA_THROUGHPUT_BYTES    ( 64 * 1024 )
+
+TEST( Full_CRYPTO, SHAKnownAnswersAndThroughput )
+{
+    /* The FIPS 180-2 examples, of one and two blocks once padded. */
+    static const char cShortMessage[] = "abc";
+    static const char cLongMessage[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    static const uint8_t ucShortSHA256[ cryptoSHA256_DIGEST_BYTES ] =
+    {
+        0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+        0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD
+    };
+    static const uint8_t ucLongSHA256[ cryptoSHA256_DIGEST_BYTES ] =
+    {
+        0x24, 0x8D, 0x6A, 0x61, 0xD2, 0x06, 0x38, 0xB8, 0xE5, 0xC0, 0x26, 0x93, 0x0C, 0x3E, 0x60, 0x39,
+        0xA3, 0x3C, 0xE4, 0x59, 0x64, 0xFF, 0x21, 0x67, 0xF6, 0xEC, 0xED, 0xD4, 0x19, 0xDB, 0x06, 0xC1
+    };
+    static const uint8_t ucShortSHA1[ cryptoSHA1_DIGEST_BYTES ] =
+    {
+        0xA9, 0x99, 0x3E, 0x36, 0x47, 0x06, 0x81, 0x6A, 0xBA, 0x3E,
+        0x25, 0x71, 0x78, 0x50, 0xC2, 0x6C, 0x9C, 0xD0, 0xD8, 0x9D
+    };
+    static const uint8_t ucLongSHA1[ cryptoSHA1_DIGEST_BYTES ] =
+    {
+        0x84, 0x98, 0x3E, 0x44, 0x1C, 0x3B, 0xD2, 0x6E, 0xBA, 0xAE,
+        0x4A, 0xA1, 0xF9, 0x51, 0x29, 0xE5, 0xE5, 0x46, 0x70, 0xF1
+    };
+    uint8_t ucBlock[ 256 ];
+    uint8_t ucHash[ cryptoSHA256_DIGEST_BYTES ];
+    uint8_t ucPiecewiseHash[ cryptoSHA256_DIGEST_BYTES ];
+    mbedtls_sha256_context xSHA256Context;
+    mbedtls_sha1_context xSHA1Context;
+    TickType_t xStart;
+    TickType_t xSHA256Ticks;
+    TickType_t xSHA1Ticks;
+    size_t xOffset;
+    size_t xIndex;
+
+    /* Whichever compression kernel the target uses, through mbedTLS. */
+    TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha256_ret( ( const uint8_t * ) cShortMessage, strlen( cShortMessage ), ucHash, 0 ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucShortSHA256, ucHash, sizeof( ucShortSHA256 ) );
+    TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha256_ret( ( const uint8_t * ) cLongMessage, strlen( cLongMessage ), ucHash, 0 ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucLongSHA256, ucHash, sizeof( ucLongSHA256 ) );
+    TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha1_ret( ( const uint8_t * ) cShortMessage, strlen( cShortMessage ), ucHash ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucShortSHA1, ucHash, sizeof( ucShortSHA1 ) );
+    TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha1_ret( ( const uint8_t * ) cLongMessage, strlen( cLongMessage ), ucHash ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucLongSHA1, ucHash, sizeof( ucLongSHA1 ) );
+
+    /* Unaligned pieces of every length give the same digest as one call. */
+    for( xIndex = 0; xIndex < sizeof( ucBlock ); xIndex++ )
+    {
+        ucBlock[ xIndex ] = ( uint8_t ) ( xIndex * 7U );
+    }
+
+    TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha256_ret( ucBlock, sizeof( ucBlock ), ucHash, 0 ) );
+
+    for( xIndex = 1; xIndex < 70U; xIndex++ )
+    {
+        mbedtls_sha256_init( &xSHA256Context );
+        TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha256_starts_ret( &xSHA256Context, 0 ) );
+
+        for( xOffset = 0; xOffset < sizeof( ucBlock ); xOffset += xIndex )
+        {
+            TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha256_update_ret( &xSHA256Context, &ucBlock[ xOffset ],
+                                                                 ( sizeof( ucBlock ) - xOffset < xIndex ) ? sizeof( ucBlock ) - xOffset : xIndex ) );
+        }
+
+        TEST_ASSERT_EQUAL_INT( 0, mbedtls_sha256_finish_ret( &xSHA256Context, ucPiecewiseHash ) );
+        mbedtls_sha256_free( &xSHA256Context );
+        TEST_ASSERT_EQUAL_MEMORY( ucHash, ucPiecewiseHash, sizeof( ucHash ) );
+    }
+
+    /* Throughput, for comparing kernels. */
+    mbedtls_sha256_init( &xSHA256Context );
+    ( void ) mbedtls_sha256_starts_ret( &xSHA256Context, 0 );
+    xStart = xTaskGetTickCount();
+
+    for( xOffset = 0; xOffset < cryptotestSHA_THROUGHPUT_BYTES; xOffset += sizeof( ucBlock ) )
+    {
+        ( void ) mbedtls_sha256_update_ret( &xSHA256Context, ucBlock, sizeof( ucBlock ) );
+    }
+
+    ( void ) mbedtls_sha256_finish_ret( &xSHA256Context, ucHash );
+    xSHA256Ticks = xTaskGetTickCount() - xStart;
+    mbedtls_sha256_free( &xSHA256Context );
+
+    mbedtls_sha1_init( &xSHA1Context );
+    ( void ) mbedtls_sha1_starts_ret( &xSHA1Context );
+    xStart = xTaskGetTickCount();
+
+    for( xOffset = 0; xOffset < cryptotestSHA_THROUGHPUT_BYTES; xOffset += sizeof( ucBlock ) )
+    {
+        ( void ) mbedtls_sha1_update_ret( &xSHA1Context, ucBlock, sizeof( ucBlock ) );
+    }
+
+    ( void ) mbedtls_sha1_finish_ret( &xSHA1Context, ucHash );
+    xSHA1Ticks = xTaskGetTickCount() - xStart;
+    mbedtls_sha1_free( &xSHA1Context );
+
+    configPRINTF( ( "Hashing %d bytes took %d ms with SHA-256 and %d ms with SHA-1.\r\n",
+                    cryptotestSHA_THROUGHPUT_BYTES,
+                    ( int ) ( xSHA256Ticks * portTICK_PERIOD_MS ),
+                    ( int ) ( xSHA1Ticks * portTICK_PERIOD_MS ) ) );
+}
@@ -63,6 +63,10 @@ TEST_GROUP_RUNNER( Full_FREERTOS_TCP )
     RUN_TEST_CASE( Full_FREERTOS_TCP, prvParseDnsResponse );
     RUN_TEST_CASE( Full_FREERTOS_TCP, ulDNSHandlePacket );
 
+    #if ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 )
+        RUN_TEST_CASE( Full_FREERTOS_TCP, DNSNegativeCache );
+    #endif
+
     /* prvCheckOptions test. */
     RUN_TEST_CASE( Full_FREERTOS_TCP, prvCheckOptions );
 
@@ -302,6 +306,54 @@ TEST( Full_FREERTOS_TCP, ulDNSHandlePacket )
     TEST_ASSERT_EQUAL_UINT32( 0, ulResult );
 }
 
+#if ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 )
+
+TEST( Full_FREERTOS_TCP, DNSNegativeCache )
+{
+    /* An A record for a37bxv1cbda3jg.iot.us-west-2.amazonaws.com. */
+    uint8_t ucPositiveResponse[] =
+    {
+        0xd7, 0x66, 0x81, 0x80, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x61, 0x33, 0x37,
+        0x62, 0x78, 0x76, 0x31, 0x63, 0x62, 0x64, 0x61, 0x33, 0x6a, 0x67, 0x03, 0x69, 0x6f, 0x74, 0x09,
+        0x75, 0x73, 0x2d, 0x77, 0x65, 0x73, 0x74, 0x2d, 0x32, 0x09, 0x61, 0x6d, 0x61, 0x7a, 0x6f, 0x6e,
+        0x61, 0x77, 0x73, 0x03, 0x63, 0x6f, 0x6d, 0x00, 0x00, 0x01, 0x00, 0x01, 0xc0, 0x0c, 0x00, 0x01,
+        0x00, 0x01, 0x00, 0x00, 0x01, 0x2c, 0x00, 0x04, 0x22, 0xd3, 0x41, 0xdb
+    };
+    const char * pcName = "a37bxv1cbda3jg.iot.us-west-2.amazonaws.com";
+    const uint32_t ulExpectedAddress = 0xdb41d322;
+    uint8_t ucNegativeResponse[ 60 ];
+    uint32_t ulAddress = 0;
+
+    /* The same question, answered with NXDOMAIN and no records. */
+    memcpy( ucNegativeResponse, ucPositiveResponse, sizeof( ucNegativeResponse ) );
+    ucNegativeResponse[ 3 ] = 0x83;
+    ucNegativeResponse[ 7 ] = 0x00;
+
+    FreeRTOS_dnsclear();
+
+    ulAddress = TEST_FreeRTOS_TCP_prvParseDNSReply(
+        ucPositiveResponse,
+        sizeof( ucPositiveResponse ),
+        *( uint16_t * ) ucPositiveResponse );
+    TEST_ASSERT_EQUAL_UINT32( ulExpectedAddress, ulAddress );
+    TEST_ASSERT_EQUAL_UINT32( ulExpectedAddress, FreeRTOS_dnslookup( pcName ) );
+
+    /* The negative answer replaces the cached address... */
+    ulAddress = TEST_FreeRTOS_TCP_prvParseDNSReply(
+        ucNegativeResponse,
+        sizeof( ucNegativeResponse ),
+        *( uint16_t * ) ucNegativeResponse );
+    TEST_ASSERT_EQUAL_UINT32( 0, ulAddress );
+    TEST_ASSERT_EQUAL_UINT32( 0, FreeRTOS_dnslookup( pcName ) );
+
+    /* ...and makes the look-up fail without asking the server. */
+    TEST_ASSERT_EQUAL_UINT32( 0, FreeRTOS_gethostbyname( pcName ) );
+
+    FreeRTOS_dnsclear();
+}
+
+#endif /* ipconfigUSE_DNS_CACHE && ipconfigDNS_CACHE_NEGATIVE_TTL */
+
 TEST( Full_FREERTOS_TCP, prvCheckOptions )
 {
     uint8_t ucDivideByZero[] =
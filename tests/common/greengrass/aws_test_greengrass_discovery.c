@@ -92,6 +92,7 @@ TEST_GROUP_RUNNER( Full_GGD )
     RUN_TEST_CASE( Full_GGD, GetCore );
     RUN_TEST_CASE( Full_GGD, prvIsIPvalid );
     RUN_TEST_CASE( Full_GGD, GetGGCIPandCertificate );
+    RUN_TEST_CASE( Full_GGD, GetGGCIPandCertificateStreamed );
 }
 
 TEST( Full_GGD, JSONRequestAbort )
@@ -219,6 +220,65 @@ TEST( Full_GGD, GetGGCIPandCertificate )
 }
 
 
+TEST( Full_GGD, GetGGCIPandCertificateStreamed )
+{
+    BaseType_t i;
+    BaseType_t xStatus;
+    GGD_HostAddressData_t xHostAddressData;
+    uint32_t ulBufferSize = testrunnerBUFFER_SIZE;
+    uint32_t ulNeededSize;
+    uint32_t ulHostEnd;
+
+    if( TEST_PROTECT() )
+    {
+        /** @brief Check function works in ideal scenario.
+         *  @{
+         */
+        for( i = 0; i < ggdTestLOOP_NUMBER; i++ )
+        {
+            xStatus = GGD_GetGGCIPandCertificateStreamed( cBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                                          ulBufferSize,
+                                                          NULL,
+                                                          &xHostAddressData,
+                                                          pdTRUE );
+            TEST_ASSERT_EQUAL_INT32_MESSAGE( pdPASS, xStatus, "GGD_GetGGCIPandCertificateStreamed() failed." );
+        }
+
+        /** @}*/
+
+        /** @brief Check only the selected core and its CA need to fit in the buffer.
+         *  @{
+         */
+        ulNeededSize = ( uint32_t ) ( &xHostAddressData.pcCertificate[ xHostAddressData.ulCertificateSize ] - cBuffer );
+        ulHostEnd = ( uint32_t ) ( &xHostAddressData.pcHostAddress[ strlen( xHostAddressData.pcHostAddress ) + 1 ] - cBuffer );
+
+        if( ulHostEnd > ulNeededSize )
+        {
+            ulNeededSize = ulHostEnd;
+        }
+
+        xStatus = GGD_GetGGCIPandCertificateStreamed( cBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                                      ulNeededSize,
+                                                      NULL,
+                                                      &xHostAddressData,
+                                                      pdTRUE );
+        TEST_ASSERT_EQUAL_INT32_MESSAGE( pdPASS, xStatus, "GGD_GetGGCIPandCertificateStreamed() failed with a buffer holding just the result." );
+
+        xStatus = GGD_GetGGCIPandCertificateStreamed( cBuffer, /*lint !e971 can use char without signed/unsigned. */
+                                                      xHostAddressData.ulCertificateSize - 1,
+                                                      NULL,
+                                                      &xHostAddressData,
+                                                      pdTRUE );
+        TEST_ASSERT_EQUAL_INT32_MESSAGE( pdFAIL, xStatus, "GGD_GetGGCIPandCertificateStreamed() passed when the input buffer was too small." );
+        /** @}*/
+    }
+    else
+    {
+        TEST_FAIL();
+    }
+}
+
+
 TEST( Full_GGD, GetIPandCertificateFromJSON )
 {
     uint32_t ulJSONFileSize = strlen( cJSON_FILE );
@@ -0,0 +1,164 @@
+/*
+ * Amazon FreeRTOS Stack Monitor
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_benchmark.h
+ * @brief Harness shared by the on-target benchmarks.
+ *
+ * BENCHMARK_Run() calls an operation a few times to warm up caches and lazy
+ * initialisation, then times each further call with
+ * benchmarkconfigGET_COUNTER() and prints the distribution of the samples.
+ * Every result is one line, so logs from different boards and releases can be
+ * compared with a script:
+ *
+ * @code
+ * BENCH,<name>,<samples>,<counter Hz>,<min>,<p50>,<p90>,<p99>,<max>,<mean>
+ * RATE,<name>,<unit>,<units per second at the median>
+ * @endcode
+ *
+ * tools/benchmark/benchmark_compare.py compares the BENCH lines of two logs
+ * and fails when one got slower than a threshold, to gate changes in CI.
+ *
+ * All times are in counter units. The default counter is the tick count, which
+ * is too coarse for the kernel benchmarks; boards with a cycle counter should
+ * override it in FreeRTOSConfig.h, for instance on Cortex-M:
+ *
+ * @code
+ * #define benchmarkconfigGET_COUNTER()    ( DWT->CYCCNT )
+ * #define benchmarkconfigCOUNTER_HZ       ( SystemCoreClock )
+ * @endcode
+ *
+ * The same DWT counter serves ARMv8-M mainline cores. On Xtensa the cycle
+ * count is read with xthal_get_ccount().
+ */
+
+#ifndef _AWS_BENCHMARK_H_
+#define _AWS_BENCHMARK_H_
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include aws_benchmark.h"
+#endif
+
+/**
+ * @brief Reads the free running counter used to time the operations.
+ *
+ * It must count up and wrap around at 2^32.
+ */
+#ifndef benchmarkconfigGET_COUNTER
+    #define benchmarkconfigGET_COUNTER()    ( ( uint32_t ) xTaskGetTickCount() )
+#endif
+
+/**
+ * @brief The frequency of benchmarkconfigGET_COUNTER().
+ */
+#ifndef benchmarkconfigCOUNTER_HZ
+    #define benchmarkconfigCOUNTER_HZ    ( ( uint32_t ) configTICK_RATE_HZ )
+#endif
+
+/**
+ * @brief The largest number of samples kept by one BENCHMARK_Run().
+ *
+ * The samples are held in a static array of uint32_t.
+ */
+#ifndef benchmarkconfigMAX_SAMPLES
+    #define benchmarkconfigMAX_SAMPLES    ( 200 )
+#endif
+
+/**
+ * @brief Prints the results. The argument is in the format of configPRINTF().
+ */
+#ifndef benchmarkconfigPRINTF
+    #define benchmarkconfigPRINTF( X )    configPRINTF( X )
+#endif
+
+/**
+ * @brief The name of the heap implementation, printed in the names of the heap
+ * benchmarks so that results of different heaps can be told apart, for
+ * instance "heap_4". heap_1 cannot run the tests, which free what they
+ * allocate.
+ */
+#ifndef benchmarkconfigHEAP_NAME
+    #define benchmarkconfigHEAP_NAME    "heap"
+#endif
+
+/**
+ * @brief The distribution of the samples of one benchmark, in counter units.
+ */
+typedef struct BenchmarkResult
+{
+    uint32_t ulSamples; /**< The number of timed calls. */
+    uint32_t ulMin;     /**< The fastest call. */
+    uint32_t ulMedian;  /**< The 50th percentile. */
+    uint32_t ulP90;     /**< The 90th percentile. */
+    uint32_t ulP99;     /**< The 99th percentile. */
+    uint32_t ulMax;     /**< The slowest call. */
+    uint32_t ulMean;    /**< The average call. */
+} BenchmarkResult_t;
+
+/**
+ * @brief An operation to measure.
+ *
+ * @param[in] pvContext The context passed to BENCHMARK_Run().
+ *
+ * @return pdPASS if the operation succeeded, pdFAIL to stop the benchmark.
+ */
+typedef BaseType_t ( * BenchmarkOperation_t )( void * pvContext );
+
+/**
+ * @brief Measures an operation and prints a BENCH line.
+ *
+ * @param[in] pcName The name printed with the results.
+ * @param[in] xOperation The operation to measure.
+ * @param[in] pvContext Passed to xOperation.
+ * @param[in] ulWarmUpCalls The number of untimed calls made first.
+ * @param[in] ulSamples The number of timed calls, at most
+ * benchmarkconfigMAX_SAMPLES.
+ * @param[out] pxResult The distribution of the samples. Can be NULL.
+ *
+ * @return pdPASS if every call succeeded, pdFAIL otherwise. Nothing is printed
+ * when a call fails.
+ */
+BaseType_t BENCHMARK_Run( const char * pcName,
+                          BenchmarkOperation_t xOperation,
+                          void * pvContext,
+                          uint32_t ulWarmUpCalls,
+                          uint32_t ulSamples,
+                          BenchmarkResult_t * const pxResult );
+
+/**
+ * @brief Prints a RATE line for a benchmark whose operation processes a fixed
+ * amount of work.
+ *
+ * @param[in] pcName The name printed with the rate.
+ * @param[in] pcUnit The unit of the work, for instance "bytes" or "messages".
+ * @param[in] ulUnitsPerCall The work done by one call of the operation.
+ * @param[in] pxResult The result filled in by BENCHMARK_Run().
+ */
+void BENCHMARK_ReportRate( const char * pcName,
+                           const char * pcUnit,
+                           uint32_t ulUnitsPerCall,
+                           const BenchmarkResult_t * const pxResult );
+
+#endif /* _AWS_BENCHMARK_H_ */
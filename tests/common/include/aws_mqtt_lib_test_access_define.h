@@ -59,6 +59,44 @@
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    MQTTBool_t Test_prvStoreSubscription( MQTTContext_t * pxMQTTContext,
+                                          const uint8_t * const pucTopic,
+                                          uint16_t usTopicLength,
+                                          void * pvPublishCallbackContext,
+                                          MQTTPublishCallback_t pxPublishCallback )
+    {
+        return prvStoreSubscription( &( pxMQTTContext->xSubscriptionManager ), pucTopic, usTopicLength, pvPublishCallbackContext, pxPublishCallback );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    void Test_prvRemoveSubscription( MQTTContext_t * pxMQTTContext,
+                                     const uint8_t * const pucTopic,
+                                     uint16_t usTopicLength )
+    {
+        ( void ) prvRemoveSubscription( &( pxMQTTContext->xSubscriptionManager ), pucTopic, usTopicLength );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+
+    uint32_t Test_prvTopicTrieMatch( MQTTContext_t * pxMQTTContext,
+                                     const uint8_t * const pucTopic,
+                                     uint16_t usTopicLength )
+    {
+        return prvTopicTrieMatch( &( pxMQTTContext->xSubscriptionManager ), pucTopic, usTopicLength );
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+/*-----------------------------------------------------------*/
+
 void Test_prvResetMQTTContext( MQTTContext_t * pxMQTTContext )
 {
     prvResetMQTTContext( pxMQTTContext );
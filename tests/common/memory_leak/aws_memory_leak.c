@@ -38,6 +38,13 @@
 #include "unity_fixture.h"
 #include "aws_test_runner.h"
 
+/* The heap profiler is only linked in when its hooks are enabled. */
+#include "aws_heap_profiler_config_defaults.h"
+
+#if ( heapprofconfigENABLE_HOOKS == 1 )
+    #include "aws_heap_profiler.h"
+#endif
+
 #define memoryleakPRINTF( x )    vLoggingPrintf x
 
 TEST_GROUP( Full_MemoryLeak );
@@ -66,6 +73,14 @@ TEST( Full_MemoryLeak, CheckHeap )
                         xHeapAfter,
                         xHeapChange ) );
 
+    #if ( heapprofconfigENABLE_HOOKS == 1 )
+        /* Show which call sites still hold the memory. */
+        if( xHeapChange != 0 )
+        {
+            HEAPPROF_PrintReport();
+        }
+    #endif
+
     TEST_ASSERT_EQUAL_INT32_MESSAGE( 0,
                                      xHeapChange,
                                      "Free heap before and after tests was not the same." );
@@ -70,6 +70,11 @@
  */
 #define testmqttlibOPERATION_TIMEOUT_TICKS    ( 1000 )
 
+/**
+ * @brief Packet ID of the publish message.
+ */
+#define testmqttlibPUBLISH_PACKET_ID          ( 2 )
+
 /**
  * @brief MQTT Control packet types.
  */
@@ -103,6 +108,19 @@ static MQTTContext_t xMQTTContext;
  * @brief Callback counter used by all the tests.
  */
 static CallbackCounter_t xCallbackCounter;
+
+#if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+/**
+ * @brief The Clean Session flag used by prvSendMQTTConnect.
+ */
+    static MQTTBool_t xConnectCleanSession;
+
+/**
+ * @brief The first byte of the last packet sent through prvRecordingSendCallback.
+ */
+    static uint8_t ucLastSentControlByte;
+#endif /* mqttconfigENABLE_PERSISTENT_SESSION */
 /*-----------------------------------------------------------*/
 
 /**
@@ -158,6 +176,26 @@ static uint32_t prvSendFailedCallback( void * pvSendContext,
                                        const uint8_t * const pucData,
                                        uint32_t ulDataLength );
 
+#if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+/**
+ * @brief The send callback registered with the MQTT library to
+ * record the packets sent.
+ *
+ * This one mimics a successful send and stores the first byte of the data
+ * in ucLastSentControlByte.
+ *
+ * @param[in] pvSendContext The send context as supplied in Init parameters.
+ * @param[in] pucData The data to transmit.
+ * @param[in] ulDataLength The length of the data.
+ *
+ * @return The number of bytes actually transmitted.
+ */
+    static uint32_t prvRecordingSendCallback( void * pvSendContext,
+                                              const uint8_t * const pucData,
+                                              uint32_t ulDataLength );
+#endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+
 /**
  * @brief Initializes the global callback counter object.
  */
@@ -249,6 +287,23 @@ static uint32_t prvSendFailedCallback( void * pvSendContext,
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+    static uint32_t prvRecordingSendCallback( void * pvSendContext,
+                                              const uint8_t * const pucData,
+                                              uint32_t ulDataLength )
+    {
+        /* Ensure that the correct context was supplied by the library. */
+        TEST_ASSERT_EQUAL( pvSendContext, testmqttlibSEND_CONTEXT );
+
+        ucLastSentControlByte = pucData[ 0 ];
+
+        /* Mimic that everything was sent successfully. */
+        return ulDataLength;
+    }
+#endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+/*-----------------------------------------------------------*/
+
 static void prvInitializeCallbackCounter( void )
 {
     xCallbackCounter.ulConnACK = 0;
@@ -268,6 +323,7 @@ static MQTTReturnCode_t prvInitializeMQTTContext( void )
     xInitParams.pvCallbackContext = testmqttlibCALLBACK_CONTEXT;
     xInitParams.pvSendContext = testmqttlibSEND_CONTEXT;
     xInitParams.pxMQTTSendFxn = &( prvSendCallback );
+    xInitParams.pxMQTTSendVFxn = NULL;
     xInitParams.pxGetTicksFxn = NULL;
     xInitParams.xBufferPoolInterface.pxGetBufferFxn = BUFFERPOOL_GetFreeBuffer;
     xInitParams.xBufferPoolInterface.pxReturnBufferFxn = BUFFERPOOL_ReturnBuffer;
@@ -295,6 +351,9 @@ static MQTTReturnCode_t prvSendMQTTConnect( void )
     xConnectParams.ulKeepAliveActualIntervalTicks = mqttconfigKEEP_ALIVE_ACTUAL_INTERVAL_TICKS;
     xConnectParams.ulPingRequestTimeoutTicks = mqttconfigKEEP_ALIVE_TIMEOUT_TICKS;
     xConnectParams.ulTimeoutTicks = testmqttlibOPERATION_TIMEOUT_TICKS;
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        xConnectParams.xCleanSession = xConnectCleanSession;
+    #endif
 
     /* Send MQTT Connect. */
     xReturnCode = MQTT_Connect( &( xMQTTContext ), &( xConnectParams ) );
@@ -342,6 +401,11 @@ TEST_SETUP( Full_MQTT )
 
     /* Reset callback counters before each test. */
     prvInitializeCallbackCounter();
+
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        /* Tests connect with a clean session unless they ask otherwise. */
+        xConnectCleanSession = eMQTTTrue;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -351,6 +415,9 @@ TEST_SETUP( Full_MQTT )
 TEST_TEAR_DOWN( Full_MQTT )
 {
     /* Each test leaves the context in fresh state. */
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        xMQTTContext.xCleanSession = eMQTTTrue;
+    #endif
     Test_prvResetMQTTContext( &( xMQTTContext ) );
 }
 /*-----------------------------------------------------------*/
@@ -365,6 +432,7 @@ TEST_GROUP_RUNNER( Full_MQTT )
 
     RUN_TEST_CASE( Full_MQTT, AFQP_prvDoesTopicMatchTopicFilter_MatchCases );
     RUN_TEST_CASE( Full_MQTT, AFQP_prvDoesTopicMatchTopicFilter_NotMatchCases );
+    RUN_TEST_CASE( Full_MQTT, AFQP_prvTopicTrieMatch_SubscribeAndUnsubscribe );
 
     /* MQTT_Init tests. */
     RUN_TEST_CASE( Full_MQTT, AFQP_MQTT_Init_HappyCase );
@@ -381,6 +449,16 @@ TEST_GROUP_RUNNER( Full_MQTT )
     RUN_TEST_CASE( Full_MQTT, AFQP_MQTT_Connect_SecondConnectWhileAlreadyConnected );
     RUN_TEST_CASE( Full_MQTT, AFQP_MQTT_Connect_SecondConnectWhileWaitingForConnACK );
     RUN_TEST_CASE( Full_MQTT, AFQP_MQTT_Connect_NetworkSendFailed );
+
+    #if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+        /* Persistent session tests. */
+        RUN_TEST_CASE( Full_MQTT, AFQP_MQTT_PersistentSession_ResendsPublish );
+    #endif
+
+    #if ( mqttconfigENABLE_PREPARED_TOPICS == 1 )
+        /* Prepared topic tests. */
+        RUN_TEST_CASE( Full_MQTT, AFQP_MQTT_PrepareTopic );
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -698,6 +776,51 @@ TEST( Full_MQTT, AFQP_prvDoesTopicMatchTopicFilter_NotMatchCases )
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Tests that the topic filter trie is kept up to date as subscriptions
+ * are stored and removed.
+ */
+TEST( Full_MQTT, AFQP_prvTopicTrieMatch_SubscribeAndUnsubscribe )
+{
+    const char * const pcTopicFilters[] = { "aws/iot/shadow", "aws/+/shadow", "aws/#", "#", "aws/iot" };
+    uint32_t x;
+
+    for( x = 0; x < sizeof( pcTopicFilters ) / sizeof( pcTopicFilters[ 0 ] ); x++ )
+    {
+        TEST_ASSERT_EQUAL( eMQTTTrue, Test_prvStoreSubscription( &( xMQTTContext ),
+                                                                 ( const uint8_t * ) pcTopicFilters[ x ],
+                                                                 ( uint16_t ) strlen( pcTopicFilters[ x ] ),
+                                                                 NULL,
+                                                                 NULL ) );
+    }
+
+    /* Exact match, '+', '#' and the multi-level wild-card on its own. */
+    TEST_ASSERT_EQUAL_UINT32( 4, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "aws/iot/shadow", ( uint16_t ) strlen( "aws/iot/shadow" ) ) );
+
+    /* "aws/#" includes the parent level. */
+    TEST_ASSERT_EQUAL_UINT32( 2, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "aws", ( uint16_t ) strlen( "aws" ) ) );
+
+    /* Levels shared with other topic filters must not match on their own. */
+    TEST_ASSERT_EQUAL_UINT32( 3, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "aws/iot", ( uint16_t ) strlen( "aws/iot" ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 1, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "iot", ( uint16_t ) strlen( "iot" ) ) );
+
+    /* Removing a topic filter only removes its own matches. The nodes of
+     * "aws/iot/shadow" read their level strings from it, so removing it
+     * first also exercises handing them over to "aws/iot". */
+    Test_prvRemoveSubscription( &( xMQTTContext ), ( const uint8_t * ) "aws/iot/shadow", ( uint16_t ) strlen( "aws/iot/shadow" ) );
+    Test_prvRemoveSubscription( &( xMQTTContext ), ( const uint8_t * ) "aws/#", ( uint16_t ) strlen( "aws/#" ) );
+    TEST_ASSERT_EQUAL_UINT32( 2, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "aws/iot/shadow", ( uint16_t ) strlen( "aws/iot/shadow" ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 2, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "aws/iot", ( uint16_t ) strlen( "aws/iot" ) ) );
+
+    for( x = 0; x < sizeof( pcTopicFilters ) / sizeof( pcTopicFilters[ 0 ] ); x++ )
+    {
+        Test_prvRemoveSubscription( &( xMQTTContext ), ( const uint8_t * ) pcTopicFilters[ x ], ( uint16_t ) strlen( pcTopicFilters[ x ] ) );
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( 0, Test_prvTopicTrieMatch( &( xMQTTContext ), ( const uint8_t * ) "aws/iot/shadow", ( uint16_t ) strlen( "aws/iot/shadow" ) ) );
+}
+/*-----------------------------------------------------------*/
+
 /**
  * @brief MQTT context initialization happy case.
  */
@@ -725,6 +848,7 @@ TEST( Full_MQTT, AFQP_MQTT_Init_NULLParams )
     xInitParams.pvCallbackContext = testmqttlibCALLBACK_CONTEXT;
     xInitParams.pvSendContext = testmqttlibSEND_CONTEXT;
     xInitParams.pxMQTTSendFxn = NULL; /* This is a required callback and setting it to NULL will fire assert. */
+    xInitParams.pxMQTTSendVFxn = NULL;
     xInitParams.pxGetTicksFxn = NULL;
     xInitParams.xBufferPoolInterface.pxGetBufferFxn = BUFFERPOOL_GetFreeBuffer;
     xInitParams.xBufferPoolInterface.pxReturnBufferFxn = BUFFERPOOL_ReturnBuffer;
@@ -1075,3 +1199,87 @@ TEST( Full_MQTT, AFQP_MQTT_Connect_NetworkSendFailed )
     TEST_ASSERT_EQUAL( 0, xCallbackCounter.ulUnidentified );
 }
 /*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_PERSISTENT_SESSION == 1 )
+
+/**
+ * @brief MQTT persistent session - A QoS1 publish waiting for PUBACK is kept
+ * across a disconnect and sent again with the DUP flag after the reconnect.
+ */
+    TEST( Full_MQTT, AFQP_MQTT_PersistentSession_ResendsPublish )
+    {
+        MQTTReturnCode_t xReturnCode;
+        MQTTPublishParams_t xPublishParams;
+        static const uint8_t ucSessionPresentConnACKMessage[] =
+        {
+            mqttCONTROL_CONNACK | mqttFLAGS_CONNACK, /* Fixed header control packet type. */
+            2,                                       /* Fixed header remaining length - always 2 for CONNACK. */
+            1,                                       /* Bit 0 is SP - Session Present. */
+            0,                                       /* Return code. */
+        };
+
+        /* Connect with a persistent session. */
+        xConnectCleanSession = eMQTTFalse;
+        xReturnCode = prvSendMQTTConnect();
+        TEST_ASSERT_EQUAL( eMQTTSuccess, xReturnCode );
+        xReturnCode = prvReceiveMQTTConnACK();
+        TEST_ASSERT_EQUAL( eMQTTSuccess, xReturnCode );
+        TEST_ASSERT_EQUAL( eMQTTConnected, xMQTTContext.xConnectionState );
+
+        /* Publish with QoS1 and do not acknowledge it. */
+        xPublishParams.pucTopic = ( const uint8_t * ) "aws/test";
+        xPublishParams.usTopicLength = ( uint16_t ) strlen( "aws/test" );
+        xPublishParams.xQos = eMQTTQoS1;
+        xPublishParams.pvData = "payload";
+        xPublishParams.ulDataLength = ( uint32_t ) strlen( "payload" );
+        xPublishParams.usPacketIdentifier = ( uint16_t ) testmqttlibPUBLISH_PACKET_ID;
+        xPublishParams.ulTimeoutTicks = testmqttlibOPERATION_TIMEOUT_TICKS;
+        xReturnCode = MQTT_Publish( &( xMQTTContext ), &( xPublishParams ) );
+        TEST_ASSERT_EQUAL( eMQTTSuccess, xReturnCode );
+
+        /* Lose the connection. The publish must be kept. */
+        Test_prvResetMQTTContext( &( xMQTTContext ) );
+        TEST_ASSERT_EQUAL( eMQTTNotConnected, xMQTTContext.xConnectionState );
+        TEST_ASSERT_FALSE( listIS_EMPTY( &( xMQTTContext.xTxBufferListHead ) ) );
+
+        /* Reconnect and resume the session. */
+        xMQTTContext.pxMQTTSendFxn = &( prvRecordingSendCallback );
+        xReturnCode = prvSendMQTTConnect();
+        TEST_ASSERT_EQUAL( eMQTTSuccess, xReturnCode );
+        xReturnCode = MQTT_ParseReceivedData( &( xMQTTContext ), ucSessionPresentConnACKMessage, sizeof( ucSessionPresentConnACKMessage ) );
+        TEST_ASSERT_EQUAL( eMQTTSuccess, xReturnCode );
+        TEST_ASSERT_EQUAL( eMQTTConnected, xMQTTContext.xConnectionState );
+
+        /* The publish must have been sent again as a QoS1 duplicate. */
+        TEST_ASSERT_EQUAL_HEX8( 0x3A, ucLastSentControlByte );
+        TEST_ASSERT_FALSE( listIS_EMPTY( &( xMQTTContext.xTxBufferListHead ) ) );
+
+        /* No other callback must have been invoked. */
+        TEST_ASSERT_EQUAL( 0, xCallbackCounter.ulUnidentified );
+    }
+
+#endif /* mqttconfigENABLE_PERSISTENT_SESSION */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_PREPARED_TOPICS == 1 )
+
+/**
+ * @brief MQTT_PrepareTopic - A valid topic is encoded with its length prefix,
+ * topics with wildcards and empty topics are rejected.
+ */
+    TEST( Full_MQTT, AFQP_MQTT_PrepareTopic )
+    {
+        MQTTPreparedTopic_t xPreparedTopic;
+        static const uint8_t ucEncodedTopic[] = { 0x00, 0x08, 'a', 'w', 's', '/', 't', 'e', 's', 't' };
+
+        TEST_ASSERT_EQUAL( eMQTTSuccess, MQTT_PrepareTopic( &( xPreparedTopic ), ( const uint8_t * ) "aws/test", ( uint16_t ) strlen( "aws/test" ) ) );
+        TEST_ASSERT_EQUAL( sizeof( ucEncodedTopic ), xPreparedTopic.usEncodedTopicLength );
+        TEST_ASSERT_EQUAL_MEMORY( ucEncodedTopic, xPreparedTopic.ucEncodedTopic, sizeof( ucEncodedTopic ) );
+
+        TEST_ASSERT_EQUAL( eMQTTFailure, MQTT_PrepareTopic( &( xPreparedTopic ), ( const uint8_t * ) "aws/+", ( uint16_t ) strlen( "aws/+" ) ) );
+        TEST_ASSERT_EQUAL( eMQTTFailure, MQTT_PrepareTopic( &( xPreparedTopic ), ( const uint8_t * ) "aws/#", ( uint16_t ) strlen( "aws/#" ) ) );
+        TEST_ASSERT_EQUAL( eMQTTFailure, MQTT_PrepareTopic( &( xPreparedTopic ), ( const uint8_t * ) "", 0 ) );
+    }
+
+#endif /* mqttconfigENABLE_PREPARED_TOPICS */
+/*-----------------------------------------------------------*/
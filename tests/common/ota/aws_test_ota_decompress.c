@@ -0,0 +1,221 @@
+/*
+ * Amazon FreeRTOS OTA AFQP V1.1.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* OTA includes. */
+#include "aws_ota_decompress.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+#include "unity.h"
+
+/*-----------------------------------------------------------*/
+
+#define DECOMPRESS_TEST_WINDOW_BITS       8U
+#define DECOMPRESS_TEST_LOOKAHEAD_BITS    4U
+#define DECOMPRESS_TEST_OUTPUT_SIZE       2048U
+#define DECOMPRESS_TEST_STREAM_SIZE       4096U
+#define DECOMPRESS_TEST_BUFFER_SIZE       256U
+
+static uint8_t ucOutput[ DECOMPRESS_TEST_OUTPUT_SIZE ];
+static uint8_t ucExpected[ DECOMPRESS_TEST_OUTPUT_SIZE ];
+static uint8_t ucStream[ DECOMPRESS_TEST_STREAM_SIZE ];
+static uint8_t ucWindow[ 1U << DECOMPRESS_TEST_WINDOW_BITS ];
+static uint8_t ucStaging[ DECOMPRESS_TEST_BUFFER_SIZE ];
+static uint32_t ulStreamBits;
+static uint32_t ulExpectedLength;
+
+/*-----------------------------------------------------------*/
+
+static int32_t prvWriteOutput( void * pvContext,
+                               uint32_t ulOffset,
+                               uint8_t * pucData,
+                               uint32_t ulLength )
+{
+    int32_t lResult = -1;
+
+    ( void ) pvContext;
+
+    if( ( ulOffset + ulLength ) <= sizeof( ucOutput ) )
+    {
+        memcpy( &ucOutput[ ulOffset ], pucData, ulLength );
+        lResult = ( int32_t ) ulLength;
+    }
+
+    return lResult;
+}
+
+static void prvPutBits( uint32_t ulValue,
+                        uint32_t ulCount )
+{
+    while( ulCount > 0U )
+    {
+        ulCount--;
+
+        if( ( ( ulValue >> ulCount ) & 1U ) != 0U )
+        {
+            ucStream[ ulStreamBits / 8U ] |= ( uint8_t ) ( 0x80U >> ( ulStreamBits % 8U ) );
+        }
+
+        ulStreamBits++;
+    }
+}
+
+static void prvPutLiteral( uint8_t ucByte )
+{
+    prvPutBits( 1U, 1U );
+    prvPutBits( ucByte, 8U );
+    ucExpected[ ulExpectedLength ] = ucByte;
+    ulExpectedLength++;
+}
+
+static void prvPutBackref( uint32_t ulOffset,
+                           uint32_t ulCount )
+{
+    prvPutBits( 0U, 1U );
+    prvPutBits( ulOffset - 1U, DECOMPRESS_TEST_WINDOW_BITS );
+    prvPutBits( ulCount - 1U, DECOMPRESS_TEST_LOOKAHEAD_BITS );
+
+    while( ulCount > 0U )
+    {
+        ucExpected[ ulExpectedLength ] = ucExpected[ ulExpectedLength - ulOffset ];
+        ulExpectedLength++;
+        ulCount--;
+    }
+}
+
+/* Build a heatshrink stream of literals, far back references and overlapping ones. */
+static uint32_t prvBuildStream( void )
+{
+    uint32_t i;
+
+    memset( ucStream, 0, sizeof( ucStream ) );
+    memcpy( ucStream, "OTAZ", 4 );
+    ucStream[ 8 ] = DECOMPRESS_TEST_WINDOW_BITS;
+    ucStream[ 9 ] = DECOMPRESS_TEST_LOOKAHEAD_BITS;
+    ulStreamBits = OTA_DECOMPRESS_HEADER_SIZE * 8U;
+    ulExpectedLength = 0;
+
+    for( i = 0; i < 200U; i++ )
+    {
+        prvPutLiteral( ( uint8_t ) ( ( i * 37U ) ^ ( i >> 2 ) ) );
+    }
+
+    for( i = 0; i < 60U; i++ )
+    {
+        prvPutBackref( 1U + ( ( i * 11U ) % 200U ), 1U + ( i % 16U ) );
+        prvPutBackref( 1U + ( i % 3U ), 16U );
+    }
+
+    ucStream[ 4 ] = ( uint8_t ) ulExpectedLength;
+    ucStream[ 5 ] = ( uint8_t ) ( ulExpectedLength >> 8 );
+
+    return ( ulStreamBits + 7U ) / 8U;
+}
+
+/* Feed the stream in pieces of the given size and return the last result. */
+static OTA_DecompressResult_t prvDecompress( const uint8_t * pucStream,
+                                             uint32_t ulPieceSize,
+                                             uint32_t ulLength,
+                                             uint8_t ucMaxWindowBits )
+{
+    OTA_DecompressContext_t xDecompress;
+    OTA_DecompressResult_t xResult = eOTA_Decompress_Continue;
+    uint32_t ulOffset = 0;
+    uint32_t ulPiece;
+
+    memset( ucOutput, 0, sizeof( ucOutput ) );
+    OTA_Decompress_Init( &xDecompress, ucWindow, ucMaxWindowBits, ucStaging, sizeof( ucStaging ), prvWriteOutput, NULL );
+
+    while( ( ulOffset < ulLength ) && ( xResult == eOTA_Decompress_Continue ) )
+    {
+        ulPiece = ( ( ulLength - ulOffset ) < ulPieceSize ) ? ( ulLength - ulOffset ) : ulPieceSize;
+        xResult = OTA_Decompress_Apply( &xDecompress, &pucStream[ ulOffset ], ulPiece );
+        ulOffset += ulPiece;
+    }
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_OTA_Decompress );
+
+TEST_SETUP( Full_OTA_Decompress )
+{
+}
+
+TEST_TEAR_DOWN( Full_OTA_Decompress )
+{
+}
+
+TEST_GROUP_RUNNER( Full_OTA_Decompress )
+{
+    RUN_TEST_CASE( Full_OTA_Decompress, DecompressSplitStream );
+    RUN_TEST_CASE( Full_OTA_Decompress, DecompressRejectBadStream );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_OTA_Decompress, DecompressSplitStream )
+{
+    uint32_t ulLength = prvBuildStream();
+    uint32_t ulPieceSize;
+
+    /* Symbols and the header may be split anywhere. */
+    for( ulPieceSize = 1; ulPieceSize <= ulLength; ulPieceSize = ( ulPieceSize * 3U ) + 1U )
+    {
+        TEST_ASSERT_EQUAL( eOTA_Decompress_Complete, prvDecompress( ucStream, ulPieceSize, ulLength, DECOMPRESS_TEST_WINDOW_BITS ) );
+        TEST_ASSERT_EQUAL_MEMORY( ucExpected, ucOutput, ulExpectedLength );
+    }
+}
+
+TEST( Full_OTA_Decompress, DecompressRejectBadStream )
+{
+    uint32_t ulLength = prvBuildStream();
+
+    /* A truncated stream never completes. */
+    TEST_ASSERT_EQUAL( eOTA_Decompress_Continue, prvDecompress( ucStream, 64, ulLength - 1U, DECOMPRESS_TEST_WINDOW_BITS ) );
+
+    /* Bytes past the end of the output. */
+    TEST_ASSERT_EQUAL( eOTA_Decompress_BadStream, prvDecompress( ucStream, ulLength + 1U, ulLength + 1U, DECOMPRESS_TEST_WINDOW_BITS ) );
+
+    /* A window larger than the one available. */
+    TEST_ASSERT_EQUAL( eOTA_Decompress_BadStream, prvDecompress( ucStream, ulLength, ulLength, DECOMPRESS_TEST_WINDOW_BITS - 1U ) );
+
+    /* A back reference longer than the rest of the output. */
+    ucStream[ 4 ] = 210;
+    ucStream[ 5 ] = 0;
+    TEST_ASSERT_EQUAL( eOTA_Decompress_BadStream, prvDecompress( ucStream, ulLength, ulLength, DECOMPRESS_TEST_WINDOW_BITS ) );
+
+    /* Bad magic. */
+    ucStream[ 0 ] = 'X';
+    TEST_ASSERT_EQUAL( eOTA_Decompress_BadStream, prvDecompress( ucStream, ulLength, ulLength, DECOMPRESS_TEST_WINDOW_BITS ) );
+}
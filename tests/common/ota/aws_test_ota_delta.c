@@ -0,0 +1,250 @@
+/*
+ * Amazon FreeRTOS OTA AFQP V1.1.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* OTA includes. */
+#include "aws_ota_delta.h"
+
+/* Unity framework includes. */
+#include "unity_fixture.h"
+#include "unity.h"
+
+/*-----------------------------------------------------------*/
+
+#define DELTA_TEST_SOURCE_SIZE     3000U
+#define DELTA_TEST_TARGET_SIZE     4096U
+#define DELTA_TEST_PATCH_SIZE      8192U
+#define DELTA_TEST_BUFFER_SIZE     256U
+
+static uint8_t ucSource[ DELTA_TEST_SOURCE_SIZE ];
+static uint8_t ucTarget[ DELTA_TEST_TARGET_SIZE ];
+static uint8_t ucExpected[ DELTA_TEST_TARGET_SIZE ];
+static uint8_t ucPatch[ DELTA_TEST_PATCH_SIZE ];
+static uint8_t ucStaging[ DELTA_TEST_BUFFER_SIZE ];
+static uint32_t ulPatchLength;
+static uint32_t ulExpectedLength;
+static uint32_t ulWriteCount;
+
+/*-----------------------------------------------------------*/
+
+static int32_t prvReadSource( void * pvContext,
+                              uint32_t ulOffset,
+                              uint8_t * pucData,
+                              uint32_t ulLength )
+{
+    int32_t lResult = -1;
+
+    ( void ) pvContext;
+
+    if( ( ulOffset + ulLength ) <= sizeof( ucSource ) )
+    {
+        memcpy( pucData, &ucSource[ ulOffset ], ulLength );
+        lResult = ( int32_t ) ulLength;
+    }
+
+    return lResult;
+}
+
+static int32_t prvWriteTarget( void * pvContext,
+                               uint32_t ulOffset,
+                               uint8_t * pucData,
+                               uint32_t ulLength )
+{
+    int32_t lResult = -1;
+
+    ( void ) pvContext;
+
+    if( ( ulOffset + ulLength ) <= sizeof( ucTarget ) )
+    {
+        memcpy( &ucTarget[ ulOffset ], pucData, ulLength );
+        lResult = ( int32_t ) ulLength;
+        ulWriteCount++;
+    }
+
+    return lResult;
+}
+
+static void prvPatchU32( uint32_t ulValue )
+{
+    ucPatch[ ulPatchLength++ ] = ( uint8_t ) ulValue;
+    ucPatch[ ulPatchLength++ ] = ( uint8_t ) ( ulValue >> 8 );
+    ucPatch[ ulPatchLength++ ] = ( uint8_t ) ( ulValue >> 16 );
+    ucPatch[ ulPatchLength++ ] = ( uint8_t ) ( ulValue >> 24 );
+}
+
+/* Build a patch using every record type, and the image it should produce. */
+static void prvBuildPatch( void )
+{
+    uint32_t i;
+
+    ulPatchLength = 0;
+    ulExpectedLength = 0;
+    memcpy( ucPatch, "OTAD", 4 );
+    ulPatchLength = 8; /* The target size is filled in at the end. */
+
+    ucPatch[ ulPatchLength++ ] = OTA_DELTA_OP_COPY;
+    prvPatchU32( 100 );
+    prvPatchU32( 1500 );
+    memcpy( &ucExpected[ ulExpectedLength ], &ucSource[ 100 ], 1500 );
+    ulExpectedLength += 1500;
+
+    ucPatch[ ulPatchLength++ ] = OTA_DELTA_OP_ADD;
+    prvPatchU32( 2000 );
+    prvPatchU32( 1000 );
+
+    for( i = 0; i < 1000; i++ )
+    {
+        ucPatch[ ulPatchLength ] = ( uint8_t ) ( i * 7 );
+        ucExpected[ ulExpectedLength++ ] = ( uint8_t ) ( ucSource[ 2000 + i ] + ucPatch[ ulPatchLength ] );
+        ulPatchLength++;
+    }
+
+    ucPatch[ ulPatchLength++ ] = OTA_DELTA_OP_INSERT;
+    prvPatchU32( 777 );
+
+    for( i = 0; i < 777; i++ )
+    {
+        ucPatch[ ulPatchLength ] = ( uint8_t ) ( i * 13 );
+        ucExpected[ ulExpectedLength++ ] = ucPatch[ ulPatchLength ];
+        ulPatchLength++;
+    }
+
+    ucPatch[ ulPatchLength++ ] = OTA_DELTA_OP_COPY;
+    prvPatchU32( 0 );
+    prvPatchU32( 5 );
+    memcpy( &ucExpected[ ulExpectedLength ], ucSource, 5 );
+    ulExpectedLength += 5;
+
+    ucPatch[ 4 ] = ( uint8_t ) ulExpectedLength;
+    ucPatch[ 5 ] = ( uint8_t ) ( ulExpectedLength >> 8 );
+    ucPatch[ 6 ] = 0;
+    ucPatch[ 7 ] = 0;
+}
+
+/* Feed the patch in pieces of the given size and return the last result. */
+static OTA_DeltaResult_t prvApplyPatch( uint32_t ulPieceSize,
+                                        uint32_t ulLength )
+{
+    OTA_DeltaContext_t xDelta;
+    OTA_DeltaResult_t xResult = eOTA_Delta_Continue;
+    uint32_t ulOffset = 0;
+    uint32_t ulPiece;
+
+    memset( ucTarget, 0, sizeof( ucTarget ) );
+    ulWriteCount = 0;
+    OTA_Delta_Init( &xDelta, ucStaging, sizeof( ucStaging ), prvReadSource, prvWriteTarget, NULL );
+
+    while( ( ulOffset < ulLength ) && ( xResult == eOTA_Delta_Continue ) )
+    {
+        ulPiece = ( ( ulLength - ulOffset ) < ulPieceSize ) ? ( ulLength - ulOffset ) : ulPieceSize;
+        xResult = OTA_Delta_Apply( &xDelta, &ucPatch[ ulOffset ], ulPiece );
+        ulOffset += ulPiece;
+    }
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_OTA_Delta );
+
+TEST_SETUP( Full_OTA_Delta )
+{
+    uint32_t i;
+
+    for( i = 0; i < DELTA_TEST_SOURCE_SIZE; i++ )
+    {
+        ucSource[ i ] = ( uint8_t ) ( ( i * 31U ) ^ ( i >> 3 ) );
+    }
+
+    prvBuildPatch();
+}
+
+TEST_TEAR_DOWN( Full_OTA_Delta )
+{
+}
+
+TEST_GROUP_RUNNER( Full_OTA_Delta )
+{
+    RUN_TEST_CASE( Full_OTA_Delta, DeltaApplyRecords );
+    RUN_TEST_CASE( Full_OTA_Delta, DeltaApplySplitPatch );
+    RUN_TEST_CASE( Full_OTA_Delta, DeltaRejectBadPatch );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_OTA_Delta, DeltaApplyRecords )
+{
+    TEST_ASSERT_EQUAL( eOTA_Delta_Complete, prvApplyPatch( ulPatchLength, ulPatchLength ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucExpected, ucTarget, ulExpectedLength );
+
+    /* All writes but the last one are of the staging buffer size. */
+    TEST_ASSERT_EQUAL( ( ulExpectedLength + DELTA_TEST_BUFFER_SIZE - 1U ) / DELTA_TEST_BUFFER_SIZE, ulWriteCount );
+}
+
+TEST( Full_OTA_Delta, DeltaApplySplitPatch )
+{
+    uint32_t ulPieceSize;
+
+    /* Records and their header fields may be split anywhere. */
+    for( ulPieceSize = 1; ulPieceSize < ulPatchLength; ulPieceSize = ( ulPieceSize * 3U ) + 1U )
+    {
+        TEST_ASSERT_EQUAL( eOTA_Delta_Complete, prvApplyPatch( ulPieceSize, ulPatchLength ) );
+        TEST_ASSERT_EQUAL_MEMORY( ucExpected, ucTarget, ulExpectedLength );
+    }
+}
+
+TEST( Full_OTA_Delta, DeltaRejectBadPatch )
+{
+    /* A truncated patch never completes. */
+    TEST_ASSERT_EQUAL( eOTA_Delta_Continue, prvApplyPatch( 64, ulPatchLength - 1U ) );
+
+    /* Bytes past the end of the target. */
+    ucPatch[ ulPatchLength ] = OTA_DELTA_OP_COPY;
+    TEST_ASSERT_EQUAL( eOTA_Delta_BadPatch, prvApplyPatch( 64, ulPatchLength + 1U ) );
+
+    /* A record reaching past the end of the source. */
+    ucPatch[ 9 ] = 0xFF;
+    ucPatch[ 10 ] = 0xFF;
+    TEST_ASSERT_EQUAL( eOTA_Delta_ReadFailed, prvApplyPatch( ulPatchLength, ulPatchLength ) );
+    prvBuildPatch();
+
+    /* A record longer than the target. */
+    ucPatch[ 4 ] = 16;
+    ucPatch[ 5 ] = 0;
+    TEST_ASSERT_EQUAL( eOTA_Delta_BadPatch, prvApplyPatch( ulPatchLength, ulPatchLength ) );
+    prvBuildPatch();
+
+    /* Unknown record type and bad magic. */
+    ucPatch[ 8 ] = 0x7F;
+    TEST_ASSERT_EQUAL( eOTA_Delta_BadPatch, prvApplyPatch( ulPatchLength, ulPatchLength ) );
+    ucPatch[ 0 ] = 'X';
+    TEST_ASSERT_EQUAL( eOTA_Delta_BadPatch, prvApplyPatch( ulPatchLength, ulPatchLength ) );
+}
@@ -182,6 +182,10 @@ TEST_GROUP_RUNNER( Full_OTA_PAL )
 
     RUN_TEST_CASE( Full_OTA_PAL, prvPAL_GetPlatformImageState_InvalidImageStateFromFileCloseFailure );
 
+    #if ( otatestpalCHECKPOINT_SUPPORTED == 1 )
+        RUN_TEST_CASE( Full_OTA_PAL, prvPAL_SaveCheckpoint_LoadAndErase );
+    #endif
+
     #if ( otatestpalREAD_AND_ASSUME_CERTIFICATE_SUPPORTED == 1 )
         RUN_TEST_CASE( Full_OTA_PAL, prvPAL_ReadAndAssumeCertificate_ExistingFile );
         #if ( otatestpalUSE_FILE_SYSTEM == 1 )
@@ -618,6 +622,34 @@ TEST( Full_OTA_PAL, prvPAL_WriteBlock_WriteManyBlocks )
     }
 }
 
+/**
+ * @brief Save a checkpoint, read it back, then erase it and verify that it is gone.
+ */
+TEST( Full_OTA_PAL, prvPAL_SaveCheckpoint_LoadAndErase )
+{
+    OTA_Err_t xOtaStatus;
+    int32_t lBytesRead;
+    uint8_t ucCheckpoint[ sizeof( ucDummyData ) ];
+
+    xOtaStatus = prvPAL_SaveCheckpoint( ucDummyData, sizeof( ucDummyData ) );
+    TEST_ASSERT_EQUAL( kOTA_Err_None, xOtaStatus );
+
+    if( TEST_PROTECT() )
+    {
+        memset( ucCheckpoint, 0, sizeof( ucCheckpoint ) );
+        lBytesRead = prvPAL_LoadCheckpoint( ucCheckpoint, sizeof( ucCheckpoint ) );
+        TEST_ASSERT_EQUAL_INT32( sizeof( ucDummyData ), lBytesRead );
+        TEST_ASSERT_EQUAL_UINT8_ARRAY( ucDummyData, ucCheckpoint, sizeof( ucDummyData ) );
+    }
+
+    /* Erase the checkpoint so the next OTA agent start does not find it. */
+    xOtaStatus = prvPAL_SaveCheckpoint( NULL, 0 );
+    TEST_ASSERT_EQUAL( kOTA_Err_None, xOtaStatus );
+
+    lBytesRead = prvPAL_LoadCheckpoint( ucCheckpoint, sizeof( ucCheckpoint ) );
+    TEST_ASSERT_LESS_THAN_INT32( 0, lBytesRead );
+}
+
 /**
  * Call prvPAL_ActivateNewImage() and verify success. This function is expected to
  * reset the device, so this test is only supported on the Windows Simulator environment.
@@ -86,6 +86,7 @@ TEST_GROUP_RUNNER( Full_POSIX_MQUEUE )
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_open_unlink_attr );
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_open_unlink_twice );
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_open_unlink_two_queues );
+    RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_open_unlink_many_queues );
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_open_flags );
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_open_invalid_params );
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_unlink_invalid_params );
@@ -246,6 +247,69 @@ TEST( Full_POSIX_MQUEUE, mq_open_unlink_two_queues )
 
 /*-----------------------------------------------------------*/
 
+TEST( Full_POSIX_MQUEUE, mq_open_unlink_many_queues )
+{
+    int iStatus = 0;
+    size_t xQueue = 0;
+    mqd_t xReopened = posixtestMQ_INVALID_MQD;
+    struct mq_attr xQueueAttr = { 0 };
+    static const char * const pcNames[] =
+    {
+        posixtestMQ_DEFAULT_NAME "0", posixtestMQ_DEFAULT_NAME "1",
+        posixtestMQ_DEFAULT_NAME "2", posixtestMQ_DEFAULT_NAME "3",
+        posixtestMQ_DEFAULT_NAME "4", posixtestMQ_DEFAULT_NAME "5",
+        posixtestMQ_DEFAULT_NAME "6", posixtestMQ_DEFAULT_NAME "7"
+    };
+    volatile mqd_t xMqIds[ sizeof( pcNames ) / sizeof( pcNames[ 0 ] ) ];
+
+    for( xQueue = 0; xQueue < sizeof( pcNames ) / sizeof( pcNames[ 0 ] ); xQueue++ )
+    {
+        xMqIds[ xQueue ] = posixtestMQ_INVALID_MQD;
+    }
+
+    /* Every queue must still be found by name and by descriptor however the
+     * queues are spread across buckets. */
+    if( TEST_PROTECT() )
+    {
+        for( xQueue = 0; xQueue < sizeof( pcNames ) / sizeof( pcNames[ 0 ] ); xQueue++ )
+        {
+            xMqIds[ xQueue ] = mq_open( pcNames[ xQueue ], O_CREAT | O_EXCL, posixtestMQ_DEFAULT_MODE, NULL );
+            TEST_ASSERT_NOT_EQUAL( posixtestMQ_INVALID_MQD, xMqIds[ xQueue ] );
+        }
+
+        for( xQueue = 0; xQueue < sizeof( pcNames ) / sizeof( pcNames[ 0 ] ); xQueue++ )
+        {
+            xReopened = mq_open( pcNames[ xQueue ], 0, posixtestMQ_DEFAULT_MODE, NULL );
+            TEST_ASSERT_EQUAL_PTR( xMqIds[ xQueue ], xReopened );
+
+            iStatus = mq_getattr( xReopened, &xQueueAttr );
+            TEST_ASSERT_EQUAL_INT( 0, iStatus );
+
+            iStatus = mq_close( xReopened );
+            TEST_ASSERT_EQUAL_INT( 0, iStatus );
+        }
+
+        for( xQueue = 0; xQueue < sizeof( pcNames ) / sizeof( pcNames[ 0 ] ); xQueue++ )
+        {
+            iStatus = mq_close( xMqIds[ xQueue ] );
+            TEST_ASSERT_EQUAL_INT( 0, iStatus );
+            xMqIds[ xQueue ] = posixtestMQ_INVALID_MQD;
+
+            iStatus = mq_unlink( pcNames[ xQueue ] );
+            TEST_ASSERT_EQUAL_INT( 0, iStatus );
+        }
+    }
+
+    /* Clean up resources in case any assert was triggered. */
+    for( xQueue = 0; xQueue < sizeof( pcNames ) / sizeof( pcNames[ 0 ] ); xQueue++ )
+    {
+        ( void ) mq_close( xMqIds[ xQueue ] );
+        ( void ) mq_unlink( pcNames[ xQueue ] );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 TEST( Full_POSIX_MQUEUE, mq_open_flags )
 {
     volatile mqd_t xMqId = posixtestMQ_INVALID_MQD,
@@ -77,6 +77,17 @@ static void * prvComputeSquareThread( void * pvArgs )
 
 /*-----------------------------------------------------------*/
 
+static void * prvIncrementThread( void * pvArgs )
+{
+    /* Return rather than call pthread_exit, so the thread's task may be kept
+     * for reuse. */
+    ( *( ( int * ) pvArgs ) )++;
+
+    return pvArgs;
+}
+
+/*-----------------------------------------------------------*/
+
 static void * prvUnlockMutexThread( void * pvArgs )
 {
     pthread_mutex_t * pxMutex = ( pthread_mutex_t * ) pvArgs;
@@ -286,6 +297,7 @@ TEST_TEAR_DOWN( Full_POSIX_PTHREAD )
 TEST_GROUP_RUNNER( Full_POSIX_PTHREAD )
 {
     RUN_TEST_CASE( Full_POSIX_PTHREAD, pthread_create_join );
+    RUN_TEST_CASE( Full_POSIX_PTHREAD, pthread_create_join_repeated );
     RUN_TEST_CASE( Full_POSIX_PTHREAD, pthread_attr_init_destroy );
     RUN_TEST_CASE( Full_POSIX_PTHREAD, pthread_mutex_lock_unlock );
     RUN_TEST_CASE( Full_POSIX_PTHREAD, pthread_mutex_trylock_timedlock );
@@ -364,6 +376,33 @@ TEST( Full_POSIX_PTHREAD, pthread_create_join )
 
 /*-----------------------------------------------------------*/
 
+TEST( Full_POSIX_PTHREAD, pthread_create_join_repeated )
+{
+    int iStatus = 0;
+    int iThread = 0;
+    volatile int iCount = 0;
+    void * pvThreadReturnValue = NULL;
+    pthread_t xNewThread = NULL;
+
+    /* Threads started one after the other, whether on new tasks or on the
+     * task of a thread that has been joined, must each run exactly once. */
+    for( iThread = 0; iThread < 4; iThread++ )
+    {
+        iStatus = pthread_create( &xNewThread, NULL, prvIncrementThread, ( void * ) &iCount );
+        TEST_ASSERT_EQUAL_INT_MESSAGE( 0,
+                                       iStatus,
+                                       "Thread creation failed!" );
+
+        iStatus = pthread_join( xNewThread, &pvThreadReturnValue );
+        TEST_ASSERT_EQUAL_INT( 0, iStatus );
+
+        TEST_ASSERT_EQUAL_INT( iThread + 1, iCount );
+        TEST_ASSERT_EQUAL_PTR( &iCount, pvThreadReturnValue );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 TEST( Full_POSIX_PTHREAD, pthread_attr_init_destroy )
 {
     int iStatus = 0;
@@ -115,6 +115,14 @@ static void RunTests( void )
         RUN_TEST_GROUP( Full_OTA_PAL );
     #endif
 
+    #if ( testrunnerFULL_OTA_DELTA_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_OTA_Delta );
+    #endif
+
+    #if ( testrunnerFULL_OTA_DECOMPRESS_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_OTA_Decompress );
+    #endif
+
     #if ( testrunnerFULL_PKCS11_ENABLED == 1 )
         RUN_TEST_GROUP( Full_PKCS11_CryptoOperation );
         RUN_TEST_GROUP( Full_PKCS11_GeneralPurpose );
@@ -150,6 +158,28 @@ static void RunTests( void )
         RUN_TEST_GROUP( Full_FREERTOS_TCP );
     #endif
 
+    /* The benchmarks run after the tests so that the tests do not depend on
+     * the state they leave behind. */
+    #if ( testrunnerBENCHMARK_KERNEL_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_Benchmark_Kernel );
+    #endif
+
+    #if ( testrunnerBENCHMARK_FREERTOS_TCP_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_Benchmark_FreeRTOS_TCP );
+    #endif
+
+    #if ( testrunnerBENCHMARK_NETWORK_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_Benchmark_Network );
+    #endif
+
+    #if ( testrunnerBENCHMARK_OTA_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_Benchmark_OTA );
+    #endif
+
+    #if ( testrunnerBENCHMARK_MQTT_LOAD_ENABLED == 1 )
+        RUN_TEST_GROUP( Full_Benchmark_MQTT_Load );
+    #endif
+
     #if ( testrunnerOTA_END_TO_END_ENABLED == 1 )
         extern void vStartOTAUpdateDemoTask( void );
         vStartOTAUpdateDemoTask();
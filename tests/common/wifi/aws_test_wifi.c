@@ -39,6 +39,8 @@
 
 /* Wi-Fi include. */
 #include "aws_wifi.h"
+#include "aws_wifi_reconnect.h"
+#include "aws_wifi_wake.h"
 #include "aws_clientcredential.h"
 
 /* Testing variable includes. */
@@ -618,6 +620,8 @@ TEST_GROUP_RUNNER( Full_WiFi )
     RUN_TEST_CASE( Full_WiFi, AFQP_WiFiReset );
     RUN_TEST_CASE( Full_WiFi, AFQP_WiFiPing );
     RUN_TEST_CASE( Full_WiFi, AFQP_WiFiIsConnected );
+    RUN_TEST_CASE( Full_WiFi, AFQP_WiFiReconnectCache );
+    RUN_TEST_CASE( Full_WiFi, AFQP_WiFiWakeWindowAlign );
     RUN_TEST_CASE( Full_WiFi, AFQP_WiFiConnectMultipleAP );
     RUN_TEST_CASE( Full_WiFi,
                    AFQP_WiFiSeperateTasksConnectingAndDisconnectingAtOnce );
@@ -1806,6 +1810,89 @@ TEST( Full_WiFi, AFQP_WiFiIsConnected )
     }
 }
 
+/**
+ * @brief Connect twice with WIFI_ReconnectAP() and verify that the second
+ * connection uses the cached Access Point once one has been learnt.
+ */
+TEST( Full_WiFi, AFQP_WiFiReconnectCache )
+{
+    WIFINetworkParams_t xNetworkParams = { 0 };
+    WIFIReconnectCache_t xCache;
+    WIFIReconnectStatistics_t xBefore;
+    WIFIReconnectStatistics_t xAfter;
+    WIFIReturnCode_t xWiFiStatus;
+
+    prvSetClientNetworkParameters( &xNetworkParams );
+    xNetworkParams.cChannel = 0;
+
+    if( TEST_PROTECT() )
+    {
+        WIFI_ReconnectClearCache();
+
+        xWiFiStatus = WIFI_ReconnectAP( &xNetworkParams );
+        TEST_WIFI_ASSERT_REQUIRED_API( eWiFiSuccess == xWiFiStatus, xWiFiStatus );
+        TEST_ASSERT( prvRoundTripTest() == pdPASS );
+
+        xWiFiStatus = WIFI_Disconnect();
+        TEST_WIFI_ASSERT_REQUIRED_API( eWiFiSuccess == xWiFiStatus, xWiFiStatus );
+        vTaskDelay( testwifiCONNECTION_DELAY );
+
+        WIFI_ReconnectGetStatistics( &xBefore );
+        xWiFiStatus = WIFI_ReconnectAP( &xNetworkParams );
+        TEST_WIFI_ASSERT_REQUIRED_API( eWiFiSuccess == xWiFiStatus, xWiFiStatus );
+        WIFI_ReconnectGetStatistics( &xAfter );
+        TEST_ASSERT( prvRoundTripTest() == pdPASS );
+
+        TEST_ASSERT_EQUAL_UINT32( xBefore.ulConnects + 1, xAfter.ulConnects );
+
+        /* The cache is only filled when the port reports the channel in
+         * WIFI_Scan(). */
+        WIFI_ReconnectGetCache( &xCache );
+
+        if( xCache.ucValid != 0 )
+        {
+            TEST_ASSERT_EQUAL_STRING( clientcredentialWIFI_SSID, xCache.cSSID );
+            TEST_ASSERT_EQUAL_UINT32( xBefore.ulCacheHits + 1, xAfter.ulCacheHits );
+        }
+    }
+    else
+    {
+        TEST_FAIL();
+    }
+}
+
+/**
+ * @brief Verify that WIFI_WakeWindowAlign() extends delays by less than one
+ * period, and leaves them alone when no period is set.
+ */
+TEST( Full_WiFi, AFQP_WiFiWakeWindowAlign )
+{
+    const TickType_t xPeriod = pdMS_TO_TICKS( 500 );
+    TickType_t xDelay;
+
+    if( TEST_PROTECT() )
+    {
+        WIFI_WakeWindowSet( xPeriod );
+
+        xDelay = WIFI_WakeWindowAlign( 1 );
+        TEST_ASSERT( ( xDelay >= 1 ) && ( xDelay <= xPeriod ) );
+
+        xDelay = WIFI_WakeWindowAlign( xPeriod + 1 );
+        TEST_ASSERT( ( xDelay >= ( xPeriod + 1 ) ) && ( xDelay <= ( 2 * xPeriod ) ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 0, WIFI_WakeWindowAlign( 0 ) );
+        TEST_ASSERT_EQUAL_UINT32( portMAX_DELAY, WIFI_WakeWindowAlign( portMAX_DELAY ) );
+
+        WIFI_WakeWindowSet( 0 );
+        TEST_ASSERT_EQUAL_UINT32( 37, WIFI_WakeWindowAlign( 37 ) );
+    }
+    else
+    {
+        WIFI_WakeWindowSet( 0 );
+        TEST_FAIL();
+    }
+}
+
 /**
  * @brief Test WIFI_ConnectAP() with null parameters. It is expected that null
  * parameters will go into an assert or fail.
@@ -64,6 +64,11 @@
  */
 #define otatestpalREAD_CERTIFICATE_FROM_NVM_WITH_PKCS11    1
 
+/**
+ * @brief 1 if prvPAL_SaveCheckpoint() and prvPAL_LoadCheckpoint() are implemented in aws_ota_pal.c.
+ */
+#define otatestpalCHECKPOINT_SUPPORTED                     1
+
 /**
  * @brief Include of signature testing data applicable to this device.
  */
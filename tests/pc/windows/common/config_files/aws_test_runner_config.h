@@ -56,6 +56,10 @@
 #define testrunnerFULL_OTA_CBOR_ENABLED            0
 #define testrunnerFULL_OTA_AGENT_ENABLED           0
 #define testrunnerFULL_OTA_PAL_ENABLED             0
+#define testrunnerBENCHMARK_KERNEL_ENABLED         0
+#define testrunnerBENCHMARK_FREERTOS_TCP_ENABLED   0
+#define testrunnerBENCHMARK_NETWORK_ENABLED        0
+#define testrunnerBENCHMARK_OTA_ENABLED            0
 #define testrunnerOTA_END_TO_END_ENABLED           0
 
 /* On systems using FreeRTOS+TCP (such as this one) the TCP segments must be
@@ -35,4 +35,7 @@
 /* A non-standard version of C_INITIALIZE should be used by this port. */
 /* #define pkcs11configC_INITIALIZE_ALT */
 
+/* The PAL returns the objects where they lie in memory-mapped flash. */
+#define pkcs11configPAL_OBJECTS_MAPPED    1
+
 #endif /* _AWS_PKCS11_CONFIG_H_ include guard. */
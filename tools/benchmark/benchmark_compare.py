@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Compares the BENCH lines of two Amazon FreeRTOS benchmark logs and fails when
+a benchmark got slower than allowed.
+
+The logs are the console output of the test runner with any of the
+Full_Benchmark_* groups enabled. Other output on the same lines or between
+them is ignored. A benchmark found several times in one log, for instance when
+logs of repeated runs are concatenated, is represented by the median of its
+values.
+
+The exit status is 0 when no benchmark regressed, 1 when at least one did and
+2 when the logs could not be read, so the script can gate a CI job:
+
+    benchmark_compare.py baseline.log current.log --metric p50 --threshold 10
+"""
+
+import argparse
+import re
+import statistics
+import sys
+
+METRICS = ['min', 'p50', 'p90', 'p99', 'max', 'mean']
+
+# BENCH,<name>,<samples>,<counter Hz>,<min>,<p50>,<p90>,<p99>,<max>,<mean>
+BENCH_LINE = re.compile(r'BENCH,([^,\s]+),(\d+),(\d+),(\d+),(\d+),(\d+),(\d+),(\d+),(\d+)')
+
+
+def read_log(path):
+    """Returns the values of the benchmarks of a log, in seconds, by name."""
+    runs = {}
+
+    with open(path, errors='replace') as log:
+        for line in log:
+            match = BENCH_LINE.search(line)
+
+            if match is None:
+                continue
+
+            name = match.group(1)
+            hz = int(match.group(3))
+            values = [int(value) for value in match.groups()[3:]]
+
+            if hz == 0:
+                continue
+
+            runs.setdefault(name, []).append([value / hz for value in values])
+
+    results = {}
+
+    for name, samples in runs.items():
+        results[name] = {metric: statistics.median(sample[index] for sample in samples)
+                         for index, metric in enumerate(METRICS)}
+
+    return results
+
+
+def format_time(seconds):
+    """Prints a duration with a unit that keeps a few significant digits."""
+    for unit, scale in (('s', 1.0), ('ms', 1e-3), ('us', 1e-6)):
+        if seconds >= scale:
+            return '%.3g %s' % (seconds / scale, unit)
+
+    return '%.3g ns' % (seconds / 1e-9)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n\n')[0])
+    parser.add_argument('baseline', help='log of the reference run')
+    parser.add_argument('current', help='log of the run to check')
+    parser.add_argument('--metric', choices=METRICS, default='p50',
+                        help='value compared, the median by default')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='largest slowdown allowed, in percent (default 10)')
+    parser.add_argument('--filter', default='',
+                        help='regular expression the compared names must match')
+    parser.add_argument('--fail-on-missing', action='store_true',
+                        help='also fail when a baseline benchmark is not in the current log')
+    args = parser.parse_args()
+
+    try:
+        baseline = read_log(args.baseline)
+        current = read_log(args.current)
+    except OSError as error:
+        sys.stderr.write('%s\n' % error)
+        return 2
+
+    if not baseline:
+        sys.stderr.write('%s: no BENCH lines\n' % args.baseline)
+        return 2
+
+    name_filter = re.compile(args.filter)
+    regressions = 0
+    missing = 0
+
+    print('%-48s %12s %12s %8s' % ('benchmark', 'baseline', 'current', 'change'))
+
+    for name in sorted(baseline):
+        if not name_filter.search(name):
+            continue
+
+        before = baseline[name][args.metric]
+
+        if name not in current:
+            print('%-48s %12s %12s %8s' % (name, format_time(before), '-', 'missing'))
+            missing += 1
+            continue
+
+        after = current[name][args.metric]
+
+        # A benchmark faster than the counter resolution reads as zero; it can
+        # only be compared once it reads a full count.
+        if before == 0:
+            change = 0.0 if after == 0 else float('inf')
+        else:
+            change = (after - before) * 100.0 / before
+
+        verdict = ''
+
+        if change > args.threshold:
+            verdict = '  REGRESSION'
+            regressions += 1
+
+        print('%-48s %12s %12s %+7.1f%%%s' % (name, format_time(before), format_time(after), change, verdict))
+
+    for name in sorted(set(current) - set(baseline)):
+        if name_filter.search(name):
+            print('%-48s %12s %12s %8s' % (name, '-', format_time(current[name][args.metric]), 'new'))
+
+    if regressions or (args.fail_on_missing and missing):
+        print('%d regression(s), %d missing, threshold %.1f%% on %s' %
+              (regressions, missing, args.threshold, args.metric))
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -45,9 +45,38 @@ func main() {
 	}
 	log.Print("UnSecure server Listening to port " + sUnSecureEchoPort)
 
+	// UDP datagrams sent to the same port are echoed as well, for the
+	// UDP flows of the load generator demo.
+	xUdpEchoServer, xStatus := net.ListenPacket("udp", ":"+sUnSecureEchoPort)
+	if xStatus != nil {
+		log.Printf("Error %s while trying to listen for UDP", xStatus)
+	} else {
+		log.Print("UnSecure UDP server Listening to port " + sUnSecureEchoPort)
+		go udpEchoServerThread(xUdpEchoServer)
+	}
+
 	startEchoServer(xUnsecureEchoServer)
 }
 
+func udpEchoServerThread(xConnection net.PacketConn) {
+	defer xConnection.Close()
+
+	xDataBuffer := make([]byte, 65536)
+
+	for {
+		xNbBytes, xAddress, xStatus := xConnection.ReadFrom(xDataBuffer)
+		if xStatus != nil {
+			log.Printf("Error %s while receiving UDP data", xStatus)
+			break
+		}
+
+		_, xStatus = xConnection.WriteTo(xDataBuffer[:xNbBytes], xAddress)
+		if xStatus != nil {
+			log.Printf("Error %s while sending UDP data", xStatus)
+		}
+	}
+}
+
 func startEchoServer(xEchoServer net.Listener) {
 	defer xEchoServer.Close()
 
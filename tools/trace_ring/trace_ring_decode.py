@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+"""
+Converts a stream of Amazon FreeRTOS trace ring chunks to the JSON trace format
+read by chrome://tracing and Perfetto.
+
+The input is the raw byte stream written by the send function given to
+TRACE_RING_StartStreaming(), or the concatenated payloads of the messages
+published by TRACE_RING_StartMQTTStreaming(). Bytes that do not belong to a
+chunk, such as log output sharing the same UART, are skipped.
+
+Each core is shown as a process. Its "CPU" row shows which task was running,
+and every task has its own row with the IP, MQTT and OTA spans and the other
+events recorded while it was running.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+CHUNK_MAGIC = b'TRRG'
+CHUNK_HEADER_SIZE = 16
+RECORD_SIZE = 16
+
+EVENT_TASK_SWITCHED_IN = 0x0001
+EVENT_TASK_SWITCHED_OUT = 0x0002
+EVENT_TASK_CREATE = 0x0003
+EVENT_TASK_DELETE = 0x0004
+EVENT_TASK_NAME = 0x0005
+EVENT_TASK_DELAY = 0x0006
+EVENT_TASK_NOTIFY_WAIT = 0x0007
+EVENT_QUEUE_RECEIVE_BLOCK = 0x0008
+EVENT_QUEUE_SEND_BLOCK = 0x0009
+EVENT_TICK = 0x000A
+EVENT_IP_EVENT_BEGIN = 0x0100
+EVENT_IP_EVENT_END = 0x0101
+EVENT_MQTT_COMMAND_BEGIN = 0x0200
+EVENT_MQTT_COMMAND_END = 0x0201
+EVENT_OTA_EVENTS = 0x0300
+EVENT_OTA_MESSAGE_BEGIN = 0x0301
+EVENT_OTA_MESSAGE_END = 0x0302
+EVENT_USER = 0x8000
+
+INSTANT_NAMES = {
+    EVENT_TASK_CREATE: 'task create',
+    EVENT_TASK_DELETE: 'task delete',
+    EVENT_TASK_DELAY: 'delay',
+    EVENT_TASK_NOTIFY_WAIT: 'notify wait',
+    EVENT_QUEUE_RECEIVE_BLOCK: 'queue receive block',
+    EVENT_QUEUE_SEND_BLOCK: 'queue send block',
+    EVENT_TICK: 'tick',
+    EVENT_OTA_EVENTS: 'OTA events',
+}
+
+IP_EVENT_NAMES = [
+    'eNetworkDownEvent', 'eNetworkRxEvent', 'eARPTimerEvent', 'eStackTxEvent',
+    'eDHCPEvent', 'eTCPTimerEvent', 'eTCPAcceptEvent', 'eTCPNetStat',
+    'eSocketBindEvent', 'eSocketCloseEvent', 'eSocketSelectEvent',
+    'eSocketSignalEvent'
+]
+
+MQTT_COMMAND_NAMES = [
+    'eMQTTServiceSocket', 'eMQTTConnectRequest', 'eMQTTDisconnectRequest',
+    'eMQTTSubscribeRequest', 'eMQTTUnsubscribeRequest', 'eMQTTPublishRequest',
+    'eMQTTAsyncPublishRequest'
+]
+
+OTA_MESSAGE_NAMES = ['eOTA_PubMsgType_Job', 'eOTA_PubMsgType_Stream']
+
+SPAN_EVENTS = {
+    EVENT_IP_EVENT_BEGIN: ('IP', IP_EVENT_NAMES, True),
+    EVENT_IP_EVENT_END: ('IP', IP_EVENT_NAMES, False),
+    EVENT_MQTT_COMMAND_BEGIN: ('MQTT', MQTT_COMMAND_NAMES, True),
+    EVENT_MQTT_COMMAND_END: ('MQTT', MQTT_COMMAND_NAMES, False),
+    EVENT_OTA_MESSAGE_BEGIN: ('OTA', OTA_MESSAGE_NAMES, True),
+    EVENT_OTA_MESSAGE_END: ('OTA', OTA_MESSAGE_NAMES, False),
+}
+
+# The row of each core that shows the running task.
+CPU_TID = 0
+
+# The row used for events recorded before the first context switch.
+UNKNOWN_TID = 1
+
+
+class Core:
+    """ The records and decoding state of one core. """
+
+    def __init__(self):
+        self.records = []
+        self.lost = []
+        self.last_timestamp = None
+        self.wraps = 0
+        self.hz = None
+
+
+def read_chunks(data, cores):
+    """ Split the stream in chunks and append their records to cores. """
+    offset = 0
+    skipped = 0
+
+    while True:
+        start = find_magic(data, offset)
+
+        if start < 0:
+            skipped += len(data) - offset
+            break
+
+        skipped += start - offset
+
+        if start + CHUNK_HEADER_SIZE > len(data):
+            break
+
+        order = '<' if data[start:start + 4] == CHUNK_MAGIC else '>'
+        _, version, core_id, record_size, hz, count, lost = struct.unpack_from(
+            order + 'IHBBIHH', data, start)
+        end = start + CHUNK_HEADER_SIZE + (count * record_size)
+
+        if version != 1 or record_size < RECORD_SIZE or hz == 0 or end > len(data):
+            # Not a chunk, or a chunk cut short. Look for the next magic.
+            skipped += 1
+            offset = start + 1
+            continue
+
+        core = cores.setdefault(core_id, Core())
+        core.hz = hz
+        position = start + CHUNK_HEADER_SIZE
+
+        for _ in range(count):
+            timestamp, event_id, sequence, arg1, arg2 = struct.unpack_from(
+                order + 'IHHII', data, position)
+            core.records.append((unwrap(core, timestamp), len(core.records),
+                                 event_id, sequence, arg1, arg2))
+            position += record_size
+
+        if lost != 0:
+            first = core.records[-count][0] if count != 0 else core.last_timestamp
+            core.lost.append((first if first is not None else 0, lost))
+
+        offset = end
+
+    return skipped
+
+
+def find_magic(data, offset):
+    """ Return the offset of the next chunk magic in either byte order. """
+    little = data.find(CHUNK_MAGIC, offset)
+    big = data.find(CHUNK_MAGIC[::-1], offset)
+
+    if little < 0:
+        return big
+
+    if big < 0:
+        return little
+
+    return min(little, big)
+
+
+def unwrap(core, timestamp):
+    """ Extend the 32-bit device timestamps of a core to a monotonic count. """
+    if core.last_timestamp is not None:
+        previous = core.last_timestamp & 0xFFFFFFFF
+
+        # Records of one core are nearly in order, so a large step back is a
+        # wrap of the timestamp counter.
+        if timestamp < previous and (previous - timestamp) > 0x80000000:
+            core.wraps += 1
+
+    value = (core.wraps << 32) | timestamp
+
+    if core.last_timestamp is None or value > core.last_timestamp:
+        core.last_timestamp = value
+
+    return value
+
+
+def enum_name(names, value):
+    """ Return the name of an enum value, or the value itself. """
+    if value < len(names):
+        return names[value]
+
+    return str(value)
+
+
+def to_us(core, timestamp):
+    """ Convert a device timestamp to microseconds. """
+    return (timestamp * 1000000.0) / core.hz
+
+
+def decode_name(arg):
+    """ Return the up to four characters packed in a task name record. """
+    return bytes(((arg >> (8 * i)) & 0xFF) for i in range(4)).rstrip(b'\0').decode('ascii', 'replace')
+
+
+def convert(cores):
+    """ Return the trace events of all cores. """
+    events = []
+    names = {}
+
+    # Task names are needed for every core, and may be recorded on another
+    # core than the one the task runs on, so collect them first.
+    for core in cores.values():
+        previous = None
+
+        for _, _, event_id, sequence, arg1, arg2 in core.records:
+            if event_id == EVENT_TASK_CREATE:
+                names[arg1] = ''
+            elif event_id == EVENT_TASK_NAME:
+                # The records of one name are consecutive in the ring.
+                if previous is None or previous[0] != EVENT_TASK_NAME or previous[1] != arg1 or \
+                        ((previous[2] + 1) & 0xFFFF) != sequence:
+                    names[arg1] = ''
+
+                names[arg1] = names.get(arg1, '') + decode_name(arg2)
+
+            previous = (event_id, arg1, sequence)
+
+    for core_id, core in sorted(cores.items()):
+        events.extend(convert_core(core_id, core, names))
+
+    return events
+
+
+def convert_core(core_id, core, names):
+    """ Return the trace events of one core. """
+    events = []
+    tids = {}
+    running = None
+    running_since = None
+    open_spans = {}
+
+    def tid_of(task):
+        if task is None:
+            return UNKNOWN_TID
+
+        if task not in tids:
+            tids[task] = len(tids) + UNKNOWN_TID + 1
+            events.append({'ph': 'M', 'name': 'thread_name', 'pid': core_id, 'tid': tids[task],
+                           'args': {'name': names.get(task) or '0x%08x' % task}})
+
+        return tids[task]
+
+    events.append({'ph': 'M', 'name': 'process_name', 'pid': core_id, 'args': {'name': 'Core %d' % core_id}})
+    events.append({'ph': 'M', 'name': 'thread_name', 'pid': core_id, 'tid': CPU_TID, 'args': {'name': 'CPU'}})
+    events.append({'ph': 'M', 'name': 'thread_name', 'pid': core_id, 'tid': UNKNOWN_TID,
+                   'args': {'name': 'before first switch'}})
+
+    # Records are written in order of their position, but a writer can be
+    # interrupted between reading the timestamp and claiming its record.
+    for timestamp, _, event_id, _, arg1, arg2 in sorted(core.records):
+        ts = to_us(core, timestamp)
+
+        if event_id == EVENT_TASK_SWITCHED_IN:
+            running = arg1
+            running_since = ts
+            tid_of(running)
+        elif event_id == EVENT_TASK_SWITCHED_OUT:
+            if running_since is not None and running == arg1:
+                events.append({'ph': 'X', 'name': names.get(arg1) or '0x%08x' % arg1, 'cat': 'sched',
+                               'pid': core_id, 'tid': CPU_TID, 'ts': running_since,
+                               'dur': ts - running_since})
+            running = None
+            running_since = None
+        elif event_id == EVENT_TASK_NAME:
+            pass
+        elif event_id in SPAN_EVENTS:
+            category, enum_names, begin = SPAN_EVENTS[event_id]
+            name = '%s %s' % (category, enum_name(enum_names, arg1))
+            tid = tid_of(running)
+
+            if begin:
+                open_spans.setdefault((tid, category), []).append(ts)
+                events.append({'ph': 'B', 'name': name, 'cat': category, 'pid': core_id, 'tid': tid,
+                               'ts': ts, 'args': {'arg1': arg1, 'arg2': arg2}})
+            elif open_spans.get((tid, category)):
+                # An end without its begin was either lost or recorded before
+                # the trace started, and would unbalance the row.
+                open_spans[(tid, category)].pop()
+                events.append({'ph': 'E', 'name': name, 'cat': category, 'pid': core_id, 'tid': tid,
+                               'ts': ts})
+        else:
+            if event_id in INSTANT_NAMES:
+                name = INSTANT_NAMES[event_id]
+            elif event_id >= EVENT_USER:
+                name = 'user 0x%04x' % (event_id - EVENT_USER)
+            else:
+                name = 'event 0x%04x' % event_id
+
+            args = {'arg1': arg1, 'arg2': arg2}
+
+            if event_id in (EVENT_TASK_CREATE, EVENT_TASK_DELETE):
+                args['task'] = names.get(arg1) or '0x%08x' % arg1
+
+            events.append({'ph': 'i', 's': 't', 'name': name, 'pid': core_id, 'tid': tid_of(running),
+                           'ts': ts, 'args': args})
+
+    for timestamp, lost in core.lost:
+        events.append({'ph': 'i', 's': 'p', 'name': '%d records lost' % lost, 'pid': core_id,
+                       'tid': CPU_TID, 'ts': to_us(core, timestamp)})
+
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n\n')[0])
+    parser.add_argument('input', nargs='?', help='file with the chunk stream, standard input when omitted')
+    parser.add_argument('-o', '--output', help='JSON trace file, standard output when omitted')
+    args = parser.parse_args()
+
+    if args.input is None:
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, 'rb') as stream:
+            data = stream.read()
+
+    cores = {}
+    skipped = read_chunks(data, cores)
+    trace = {'traceEvents': convert(cores), 'displayTimeUnit': 'ms'}
+
+    if args.output is None:
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.output, 'w') as stream:
+            json.dump(trace, stream)
+
+    for core_id, core in sorted(cores.items()):
+        sys.stderr.write('core %d: %d records, %d lost\n' %
+                         (core_id, len(core.records), sum(lost for _, lost in core.lost)))
+
+    if skipped != 0:
+        sys.stderr.write('%d bytes outside chunks skipped\n' % skipped)
+
+
+if __name__ == '__main__':
+    main()